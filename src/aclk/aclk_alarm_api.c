@@ -8,12 +8,14 @@
 
 #include "aclk.h"
 
-void aclk_send_alarm_log_entry(struct alarm_log_entry *log_entry)
+// returns the size of the message sent
+size_t aclk_send_alarm_log_entry(struct alarm_log_entry *log_entry)
 {
     size_t payload_size;
     char *payload = generate_alarm_log_entry(&payload_size, log_entry);
 
     aclk_send_bin_msg(payload, payload_size, ACLK_TOPICID_ALARM_LOG, "AlarmLogEntry");
+    return payload ? payload_size : 0;
 }
 
 void aclk_send_provide_alarm_cfg(struct provide_alarm_configuration *cfg)
@@ -11,6 +11,7 @@ struct pending_req_list {
     uint32_t hash;
 
     int canceled;
+    usec_t deadline_ut;     // monotonic, the time the cloud stops waiting for the response
 
     struct pending_req_list *next;
 };
@@ -28,11 +29,14 @@ bool aclk_query_scope_has(HTTP_ACL acl) {
     return (default_aclk_http_acl & acl) == acl;
 }
 
-static struct pending_req_list *pending_req_list_add(const char *msg_id)
+static struct pending_req_list *pending_req_list_add(aclk_query_t query)
 {
     struct pending_req_list *new = callocz(1, sizeof(struct pending_req_list));
-    new->msg_id = msg_id;
-    new->hash = simple_hash(msg_id);
+    new->msg_id = query->msg_id;
+    new->hash = simple_hash(query->msg_id);
+
+    if (query->timeout > 0)
+        new->deadline_ut = timeval_usec(&query->created_tv) + (usec_t)query->timeout * USEC_PER_MS;
 
     spinlock_lock(&pending_req_list_lock);
     new->next = pending_req_list_head;
@@ -89,7 +93,9 @@ int mark_pending_req_cancelled(const char *msg_id)
 static bool aclk_web_client_interrupt_cb(struct web_client *w __maybe_unused, void *data)
 {
     struct pending_req_list *req = (struct pending_req_list *)data;
-    return req->canceled;
+
+    // stop working on queries the cloud is no longer waiting for
+    return req->canceled || (req->deadline_ut && now_monotonic_high_precision_usec() > req->deadline_ut);
 }
 
 int http_api_v2(mqtt_wss_client client, aclk_query_t query)
@@ -117,7 +123,7 @@ int http_api_v2(mqtt_wss_client client, aclk_query_t query)
     w->timings.tv_in = query->created_tv;
 
     w->interrupt.callback = aclk_web_client_interrupt_cb;
-    w->interrupt.callback_data = pending_req_list_add(query->msg_id);
+    w->interrupt.callback_data = pending_req_list_add(query);
 
     buffer_flush(w->response.data);
     buffer_strcat(w->response.data, query->data.http_api_v2.payload);
@@ -216,6 +222,19 @@ cleanup:
     return retval;
 }
 
+// reply to a query that expired while waiting in the queue, without running it
+int http_api_v2_timeout(mqtt_wss_client client, aclk_query_t query)
+{
+    usec_t waited_ut = now_monotonic_high_precision_usec() - timeval_usec(&query->created_tv);
+
+    nd_log(NDLS_ACCESS, NDLP_ERR,
+           "QUERY CANCELED: QUEUE TIME EXCEEDED %llu ms (LIMIT %d ms)",
+           waited_ut / USEC_PER_MS, query->timeout);
+
+    aclk_http_msg_v2_err(client, query->callback_topic, query->msg_id, HTTP_RESP_SERVICE_UNAVAILABLE, CLOUD_EC_SND_TIMEOUT, CLOUD_EMSG_SND_TIMEOUT, NULL, 0);
+    return 1;
+}
+
 int send_bin_msg(mqtt_wss_client client, aclk_query_t query)
 {
     // this will be simplified when legacy support is removed
@@ -14,6 +14,7 @@ int mark_pending_req_cancelled(const char *msg_id);
 void aclk_execute_query(aclk_query_t query);
 void aclk_query_init(mqtt_wss_client client);
 int http_api_v2(mqtt_wss_client client, aclk_query_t query);
+int http_api_v2_timeout(mqtt_wss_client client, aclk_query_t query);
 int send_bin_msg(mqtt_wss_client client, aclk_query_t query);
 
 #endif //NETDATA_AGENT_CLOUD_LINK_H
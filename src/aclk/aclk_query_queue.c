@@ -27,3 +27,65 @@ void aclk_query_free(aclk_query_t query)
     freez(query->msg_id);
     freez(query);
 }
+
+// queries the cloud sends for analysis, instead of for rendering a dashboard
+static const char *aclk_background_queries[] = {
+    "/api/v1/weights",
+    "/api/v1/metric_correlations",
+    "/api/v2/weights",
+    NULL,
+};
+
+#define ACLK_ACCOUNT_ID_HEADER "X-Netdata-Account-Id:"
+
+static uint64_t aclk_query_requester(const char *payload)
+{
+    const char *s = strcasestr(payload, ACLK_ACCOUNT_ID_HEADER);
+    if (!s)
+        return 0;
+
+    s += sizeof(ACLK_ACCOUNT_ID_HEADER) - 1;
+    while (*s == ' ')
+        s++;
+
+    size_t len = strcspn(s, "\r\n");
+    if (!len)
+        return 0;
+
+    uint64_t hash = XXH3_64bits(s, len);
+    return hash ? hash : 1;
+}
+
+void aclk_query_classify(aclk_query_t query)
+{
+    if (!query->created_tv.tv_sec) {
+        now_monotonic_high_precision_timeval(&query->created_tv);
+        query->created = now_realtime_usec();
+    }
+
+    query->queued_ut = now_monotonic_high_precision_usec();
+    query->priority = ACLK_QUERY_PRIORITY_INTERACTIVE;
+    query->requester = 0;
+
+    if (query->type != HTTP_API_V2 || !query->data.http_api_v2.query)
+        return;
+
+    for (size_t i = 0; aclk_background_queries[i]; i++) {
+        if (strstr(query->data.http_api_v2.query, aclk_background_queries[i])) {
+            query->priority = ACLK_QUERY_PRIORITY_BACKGROUND;
+            break;
+        }
+    }
+
+    if (query->data.http_api_v2.payload)
+        query->requester = aclk_query_requester(query->data.http_api_v2.payload);
+}
+
+// true when the cloud has already given up waiting for the response
+bool aclk_query_expired(aclk_query_t query, usec_t now_monotonic_ut)
+{
+    if (query->type != HTTP_API_V2 || query->timeout <= 0)
+        return false;
+
+    return now_monotonic_ut > timeval_usec(&query->created_tv) + (usec_t)query->timeout * USEC_PER_MS;
+}
@@ -22,6 +22,16 @@ typedef enum {
     ACLK_QUERY_TYPE_COUNT // always keep this as last
 } aclk_query_type_t;
 
+// queries are dispatched to the query threads by priority;
+// background queries (e.g. metric correlations) never occupy all threads
+typedef enum __attribute__((packed)) {
+    ACLK_QUERY_PRIORITY_INTERACTIVE = 0,
+    ACLK_QUERY_PRIORITY_BACKGROUND,
+
+    // terminator
+    ACLK_QUERY_PRIORITY_MAX,
+} ACLK_QUERY_PRIORITY;
+
 struct aclk_query_http_api_v2 {
     char *payload;
     char *query;
@@ -51,6 +61,13 @@ struct aclk_query {
     usec_t created;
     int timeout;
 
+    // set by aclk_query_classify() when the query is queued
+    ACLK_QUERY_PRIORITY priority;
+    uint64_t requester;                 // hash of the cloud account, 0 when not known
+    usec_t queued_ut;
+
+    struct aclk_query *prev, *next;     // the pending queue of its priority
+
     // TODO maybe remove?
     int version;
     union {
@@ -61,6 +78,8 @@ struct aclk_query {
 
 aclk_query_t aclk_query_new(aclk_query_type_t type);
 void aclk_query_free(aclk_query_t query);
+void aclk_query_classify(aclk_query_t query);
+bool aclk_query_expired(aclk_query_t query, usec_t now_monotonic_ut);
 
 void aclk_execute_query(aclk_query_t query);
 
@@ -373,6 +373,30 @@ static size_t get_ws_hdr_size(size_t payload_size)
     return hdr_len;
 }
 
+// copy len bytes of src to dst masking them, src[0] being at byte offset of the payload
+// masks 8 bytes at a time, once dst is at a multiple of 4 bytes of the payload
+static inline void ws_copy_masked(char *dst, const char *src, size_t len, const char *mask, size_t offset)
+{
+    size_t i = 0;
+
+    for (; i < len && ((offset + i) % 4); i++)
+        dst[i] = src[i] ^ mask[(offset + i) % 4];
+
+    uint64_t mask64;
+    memcpy(&mask64, mask, 4);
+    memcpy((char *)&mask64 + 4, mask, 4);
+
+    for (; i + sizeof(mask64) <= len; i += sizeof(mask64)) {
+        uint64_t v;
+        memcpy(&v, &src[i], sizeof(v));
+        v ^= mask64;
+        memcpy(&dst[i], &v, sizeof(v));
+    }
+
+    for (; i < len; i++)
+        dst[i] = src[i] ^ mask[(offset + i) % 4];
+}
+
 #define MAX_POSSIBLE_HDR_LEN 14
 int ws_client_send(const ws_client *client, enum websocket_opcode frame_type, const char *data, size_t size)
 {
@@ -383,7 +407,6 @@ int ws_client_send(const ws_client *client, enum websocket_opcode frame_type, co
     char hdr[MAX_POSSIBLE_HDR_LEN];
     char *ptr = hdr;
     int size_written = 0;
-    size_t j = 0;
 
     size_t w_buff_free = rbuf_bytes_free(client->buf_write);
     size_t hdr_len = get_ws_hdr_size(size);
@@ -431,20 +454,19 @@ int ws_client_send(const ws_client *client, enum websocket_opcode frame_type, co
     if (!size)
         return 0;
 
-    // copy and mask data in the write ringbuffer
+    // copy and mask data in the write ringbuffer, in one pass
     while (size - size_written) {
         size_t writable_bytes;
         char *w_ptr = rbuf_get_linear_insert_range(client->buf_write, &writable_bytes);
         if(!writable_bytes)
             break;
 
-        writable_bytes = (writable_bytes > size) ? (size - size_written) : writable_bytes;
+        if (writable_bytes > size - size_written)
+            writable_bytes = size - size_written;
 
-        memcpy(w_ptr, &data[size_written], writable_bytes);
+        ws_copy_masked(w_ptr, &data[size_written], writable_bytes, mask, size_written);
         rbuf_bump_head(client->buf_write, writable_bytes);
 
-        for (size_t i = 0; i < writable_bytes; i++, j++)
-            w_ptr[i] ^= mask[j % 4];
         size_written += writable_bytes;
     }
     return size_written;
@@ -110,22 +110,172 @@ static inline void cleanup_exited_pids(void) {
     }
 }
 
-static struct target *get_apps_groups_target_for_pid(struct pid_stat *p) {
-    targets_assignment_counter++;
+// ----------------------------------------------------------------------------
+// the apps_groups.conf matches of process names
+//
+// A process gets its apps_groups.conf target once, when it is first seen, by
+// trying all the targets in the order of the configuration. When processes
+// come and go all the time (e.g. on build servers), this is most of the cost
+// of assigning targets. So, the first target matching the name of a process
+// (comm and comm_orig) is cached by name, and per process only the targets
+// matching the command line that come before it in the configuration are tried.
+
+#define APPS_GROUPS_NAME_MATCHES_MAX 65536
+
+struct apps_groups_name_key {
+    STRING *comm;
+    STRING *comm_orig;
+};
+
+struct apps_groups_name_match {
+    struct apps_groups_name_key key;    // references are held on both
+    struct target *w;                   // the first target matching the name, or NULL
+    size_t position;                    // the position of w in apps_groups.conf
+};
+
+#define SIMPLE_HASHTABLE_NAME _APPS_GROUPS_NAME
+#define SIMPLE_HASHTABLE_VALUE_TYPE struct apps_groups_name_match
+#define SIMPLE_HASHTABLE_KEY_TYPE struct apps_groups_name_key
+#define SIMPLE_HASHTABLE_VALUE2KEY_FUNCTION apps_groups_name_match_to_key
+#define SIMPLE_HASHTABLE_COMPARE_KEYS_FUNCTION apps_groups_name_keys_eq
+#define SIMPLE_HASHTABLE_SAMPLE_IMPLEMENTATION 0
+#include "libnetdata/simple_hashtable.h"
+
+static inline struct apps_groups_name_key *apps_groups_name_match_to_key(struct apps_groups_name_match *m) {
+    return &m->key;
+}
+
+static inline bool apps_groups_name_keys_eq(struct apps_groups_name_key *a, struct apps_groups_name_key *b) {
+    return a->comm == b->comm && a->comm_orig == b->comm_orig;
+}
+
+static struct {
+    bool initialized;
+    SIMPLE_HASHTABLE_APPS_GROUPS_NAME ht;
+
+    // the targets matching command lines, in the order of apps_groups.conf
+    struct {
+        size_t used;
+        struct target **targets;
+        size_t *positions;
+    } cmdline;
+} apps_groups_names = { 0 };
+
+static inline bool apps_groups_target_matches_cmdline(struct target *w) {
+    return w->match.starts_with && w->match.ends_with;
+}
+
+static void apps_groups_names_init(void) {
+    size_t targets = 0;
+    for(struct target *w = apps_groups_root_target; w ; w = w->next)
+        if(w->type == TARGET_TYPE_APP_GROUP && apps_groups_target_matches_cmdline(w))
+            targets++;
+
+    apps_groups_names.cmdline.targets = callocz(targets ? targets : 1, sizeof(struct target *));
+    apps_groups_names.cmdline.positions = callocz(targets ? targets : 1, sizeof(size_t));
 
+    size_t position = 0;
     for(struct target *w = apps_groups_root_target; w ; w = w->next) {
         if(w->type != TARGET_TYPE_APP_GROUP) continue;
 
-        if(pid_match_check(p, &w->match)) {
-            if(p->is_manager)
-                return NULL;
+        if(apps_groups_target_matches_cmdline(w)) {
+            apps_groups_names.cmdline.targets[apps_groups_names.cmdline.used] = w;
+            apps_groups_names.cmdline.positions[apps_groups_names.cmdline.used] = position;
+            apps_groups_names.cmdline.used++;
+        }
+
+        position++;
+    }
+
+    simple_hashtable_init_APPS_GROUPS_NAME(&apps_groups_names.ht, 1024);
+    apps_groups_names.initialized = true;
+}
+
+static void apps_groups_names_flush(void) {
+    for(SIMPLE_HASHTABLE_SLOT_APPS_GROUPS_NAME *sl = simple_hashtable_first_read_only_APPS_GROUPS_NAME(&apps_groups_names.ht);
+        sl ;
+        sl = simple_hashtable_next_read_only_APPS_GROUPS_NAME(&apps_groups_names.ht, sl)) {
+        struct apps_groups_name_match *m = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+        if(!m) continue;
+
+        string_freez(m->key.comm);
+        string_freez(m->key.comm_orig);
+        freez(m);
+    }
+
+    simple_hashtable_destroy_APPS_GROUPS_NAME(&apps_groups_names.ht);
+    simple_hashtable_init_APPS_GROUPS_NAME(&apps_groups_names.ht, 1024);
+}
+
+static struct apps_groups_name_match *apps_groups_name_match_get(struct pid_stat *p) {
+    struct apps_groups_name_key key = {
+        .comm = p->comm,
+        .comm_orig = p->comm_orig,
+    };
 
-            p->matched_by_config = true;
-            return w->target ? w->target : w;
+    XXH64_hash_t hash = XXH3_64bits(&key, sizeof(key));
+    SIMPLE_HASHTABLE_SLOT_APPS_GROUPS_NAME *sl =
+        simple_hashtable_get_slot_APPS_GROUPS_NAME(&apps_groups_names.ht, hash, &key, true);
+
+    struct apps_groups_name_match *m = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+    if(likely(m))
+        return m;
+
+    // the names are unbounded in theory, start over when there are too many
+    if(unlikely(apps_groups_names.ht.used >= APPS_GROUPS_NAME_MATCHES_MAX)) {
+        apps_groups_names_flush();
+        sl = simple_hashtable_get_slot_APPS_GROUPS_NAME(&apps_groups_names.ht, hash, &key, true);
+    }
+
+    m = callocz(1, sizeof(*m));
+    m->key.comm = string_dup(p->comm);
+    m->key.comm_orig = string_dup(p->comm_orig);
+    m->w = NULL;
+
+    size_t position = 0;
+    for(struct target *w = apps_groups_root_target; w ; w = w->next) {
+        if(w->type != TARGET_TYPE_APP_GROUP) continue;
+
+        if(!apps_groups_target_matches_cmdline(w) && pid_match_check(p, &w->match)) {
+            m->w = w;
+            break;
+        }
+
+        position++;
+    }
+    m->position = position;
+
+    simple_hashtable_set_slot_APPS_GROUPS_NAME(&apps_groups_names.ht, sl, hash, m);
+    return m;
+}
+
+static struct target *get_apps_groups_target_for_pid(struct pid_stat *p) {
+    targets_assignment_counter++;
+
+    if(unlikely(!apps_groups_names.initialized))
+        apps_groups_names_init();
+
+    struct apps_groups_name_match *m = apps_groups_name_match_get(p);
+    struct target *w = m->w;
+
+    // the command line targets before it in apps_groups.conf come first
+    if(p->cmdline) {
+        for(size_t i = 0; i < apps_groups_names.cmdline.used && apps_groups_names.cmdline.positions[i] < m->position; i++) {
+            if(pid_match_check(p, &apps_groups_names.cmdline.targets[i]->match)) {
+                w = apps_groups_names.cmdline.targets[i];
+                break;
+            }
         }
     }
 
-    return NULL;
+    if(!w)
+        return NULL;
+
+    if(p->is_manager)
+        return NULL;
+
+    p->matched_by_config = true;
+    return w->target ? w->target : w;
 }
 
 static void assign_a_target_to_all_processes(void) {
@@ -11,6 +11,77 @@ bool enable_function_cmdline = false;
 #define PROCESS_FILTER_PID "pid:"
 #define PROCESS_FILTER_UID "uid:"
 #define PROCESS_FILTER_GID "gid:"
+#define PROCESS_FILTER_TOP "top:"
+#define PROCESS_FILTER_SORT "sort:"
+
+// the order used to pick the processes of top:N
+typedef enum {
+    PROCESSES_SORT_CPU = 0,
+    PROCESSES_SORT_MEMORY,
+    PROCESSES_SORT_THREADS,
+    PROCESSES_SORT_UPTIME,
+} PROCESSES_SORT;
+
+static struct {
+    const char *name;
+    PROCESSES_SORT sort;
+} processes_sort_names[] = {
+    { "cpu", PROCESSES_SORT_CPU },
+    { "memory", PROCESSES_SORT_MEMORY },
+    { "threads", PROCESSES_SORT_THREADS },
+    { "uptime", PROCESSES_SORT_UPTIME },
+    { NULL, 0 },
+};
+
+struct processes_selected {
+    kernel_uint_t key;
+    struct pid_stat *p;
+};
+
+static inline kernel_uint_t pid_total_cpu(struct pid_stat *p) {
+    kernel_uint_t total_cpu = p->values[PDF_UTIME] + p->values[PDF_STIME];
+
+#if (PROCESSES_HAVE_CPU_GUEST_TIME)
+    total_cpu += p->values[PDF_GTIME];
+#endif
+#if (PROCESSES_HAVE_CPU_CHILDREN_TIME)
+    total_cpu += p->values[PDF_CUTIME] + p->values[PDF_CSTIME];
+#if (PROCESSES_HAVE_CPU_GUEST_TIME)
+    total_cpu += p->values[PDF_CGTIME];
+#endif
+#endif
+
+    return total_cpu;
+}
+
+static inline kernel_uint_t processes_sort_key(struct pid_stat *p, PROCESSES_SORT sort) {
+    switch(sort) {
+        default:
+        case PROCESSES_SORT_CPU:
+            return pid_total_cpu(p);
+
+        case PROCESSES_SORT_MEMORY:
+            return p->values[PDF_VMRSS];
+
+        case PROCESSES_SORT_THREADS:
+            return p->values[PDF_THREADS];
+
+        case PROCESSES_SORT_UPTIME:
+            return p->values[PDF_UPTIME];
+    }
+}
+
+// the biggest first, and the lowest pid among equals
+static int processes_selected_compar(const void *a, const void *b) {
+    const struct processes_selected *s1 = a, *s2 = b;
+
+    if(s1->key > s2->key) return -1;
+    if(s1->key < s2->key) return 1;
+
+    if(s1->p->pid < s2->p->pid) return -1;
+    if(s1->p->pid > s2->p->pid) return 1;
+    return 0;
+}
 
 static void apps_plugin_function_processes_help(const char *transaction) {
     BUFFER *wb = buffer_create(0, NULL);
@@ -54,6 +125,13 @@ static void apps_plugin_function_processes_help(const char *transaction) {
                    "\n"
 #endif
                    "Filters can be combined. Each filter can be given only one time.\n"
+                   "\n"
+                   "   top:NUMBER\n"
+                   "      Returns only the `NUMBER` processes that use the most of the resource selected by `sort`,\n"
+                   "      among the ones the filters select (the default is all of them)\n"
+                   "\n"
+                   "   sort:cpu|memory|threads|uptime\n"
+                   "      The resource `top` picks the processes by (the default is `cpu`)\n"
     );
 
     wb->response_code = HTTP_RESP_OK;
@@ -94,6 +172,8 @@ void function_processes(const char *transaction, char *function,
     uid_t uid = 0; (void)uid;
     gid_t gid = 0; (void)gid;
     bool info = false;
+    size_t top = 0;
+    PROCESSES_SORT sort = PROCESSES_SORT_CPU;
 
     bool filter_pid = false, filter_uid = false, filter_gid = false;
     (void)filter_uid; (void)filter_gid;
@@ -149,6 +229,26 @@ void function_processes(const char *transaction, char *function,
             filter_gid = true;
         }
 #endif
+        else if(!top && strncmp(keyword, PROCESS_FILTER_TOP, strlen(PROCESS_FILTER_TOP)) == 0) {
+            top = str2u(&keyword[strlen(PROCESS_FILTER_TOP)]);
+        }
+        else if(strncmp(keyword, PROCESS_FILTER_SORT, strlen(PROCESS_FILTER_SORT)) == 0) {
+            const char *name = &keyword[strlen(PROCESS_FILTER_SORT)];
+
+            size_t i;
+            for(i = 0; processes_sort_names[i].name ; i++) {
+                if(strcmp(name, processes_sort_names[i].name) == 0)
+                    break;
+            }
+
+            if(!processes_sort_names[i].name) {
+                pluginsd_function_json_error_to_stdout(transaction, HTTP_RESP_BAD_REQUEST,
+                                                       "Processes can be sorted by cpu, memory, threads or uptime.");
+                return;
+            }
+
+            sort = processes_sort_names[i].sort;
+        }
         else if(strcmp(keyword, "help") == 0) {
             apps_plugin_function_processes_help(transaction);
             return;
@@ -253,7 +353,9 @@ void function_processes(const char *transaction, char *function,
 
     netdata_mutex_lock(&apps_and_stdout_mutex);
 
-    int rows= 0;
+    size_t used = 0;
+    struct processes_selected *selected = mallocz(sizeof(*selected) * (all_pids_count() + 1));
+
     for(p = root_of_pids(); p ; p = p->next) {
         if(!p->updated)
             continue;
@@ -287,6 +389,21 @@ void function_processes(const char *transaction, char *function,
             continue;
 #endif
 
+        selected[used].key = top ? processes_sort_key(p, sort) : 0;
+        selected[used].p = p;
+        used++;
+    }
+
+    // with top:N, only the N processes using the most are sent
+    if(top && used > top) {
+        qsort(selected, used, sizeof(*selected), processes_selected_compar);
+        used = top;
+    }
+
+    int rows= 0;
+    for(size_t s = 0; s < used ; s++) {
+        p = selected[s].p;
+
         rows++;
 
         buffer_json_add_array_item_array(wb); // for each pid
@@ -333,17 +450,7 @@ void function_processes(const char *transaction, char *function,
 #endif
 
         // CPU utilization %
-        kernel_uint_t total_cpu = p->values[PDF_UTIME] + p->values[PDF_STIME];
-
-#if (PROCESSES_HAVE_CPU_GUEST_TIME)
-        total_cpu += p->values[PDF_GTIME];
-#endif
-#if (PROCESSES_HAVE_CPU_CHILDREN_TIME)
-        total_cpu += p->values[PDF_CUTIME] + p->values[PDF_CSTIME];
-#if (PROCESSES_HAVE_CPU_GUEST_TIME)
-        total_cpu += p->values[PDF_CGTIME];
-#endif
-#endif
+        kernel_uint_t total_cpu = pid_total_cpu(p);
         add_value_field_ndd_with_max(wb, CPU, (NETDATA_DOUBLE)(total_cpu) / cpu_divisor);
         add_value_field_ndd_with_max(wb, UserCPU, (NETDATA_DOUBLE)(p->values[PDF_UTIME]) / cpu_divisor);
         add_value_field_ndd_with_max(wb, SysCPU, (NETDATA_DOUBLE)(p->values[PDF_STIME]) / cpu_divisor);
@@ -442,6 +549,8 @@ void function_processes(const char *transaction, char *function,
         buffer_json_array_close(wb); // for each pid
     }
 
+    freez(selected);
+
     buffer_json_array_close(wb); // data
     buffer_json_member_add_object(wb, "columns");
 
@@ -90,6 +90,25 @@ static inline int incrementally_read_pid_io(struct pid_stat *p, void *ptr) {
     return ret ? 1 : 0;
 }
 
+static inline bool incrementally_read_pid_status(struct pid_stat *p, void *ptr) {
+    p->last_status_collected_usec = p->status_collected_usec;
+    p->status_collected_usec = now_monotonic_usec();
+
+    return OS_FUNCTION(apps_os_read_pid_status)(p, ptr);
+}
+
+// Idle processes get their io, status and fds refreshed once every idle_pids_refresh_iterations.
+// Their last values are kept meanwhile, and since all rates are calculated against the time
+// of the last collection of each file, the first refresh reports the average of the whole period.
+static inline bool pid_needs_refresh(struct pid_stat *p) {
+    if(idle_pids_refresh_iterations <= 1 || !p->status_collected_usec || !pid_collection_is_idle(p)) {
+        p->idle_iterations = 0;
+        return true;
+    }
+
+    return (++p->idle_iterations % (uint32_t)idle_pids_refresh_iterations) == 0;
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 int incrementally_collect_data_for_pid_stat(struct pid_stat *p, void *ptr) {
@@ -110,6 +129,11 @@ int incrementally_collect_data_for_pid_stat(struct pid_stat *p, void *ptr) {
     if(unlikely(p->ppid < INIT_PID))
         p->ppid = 0;
 
+    if(!pid_needs_refresh(p)) {
+        pid_collection_keep_previous_values(p);
+        goto done;
+    }
+
     // --------------------------------------------------------------------
     // /proc/<pid>/io
 
@@ -118,7 +142,7 @@ int incrementally_collect_data_for_pid_stat(struct pid_stat *p, void *ptr) {
     // --------------------------------------------------------------------
     // /proc/<pid>/status
 
-    if(unlikely(!managed_log(p, PID_LOG_STATUS, OS_FUNCTION(apps_os_read_pid_status)(p, ptr)))) {
+    if(unlikely(!managed_log(p, PID_LOG_STATUS, incrementally_read_pid_status(p, ptr)))) {
         // there is no reason to proceed if we cannot get its status
         pid_collection_failed(p);
         return 0;
@@ -136,6 +160,8 @@ int incrementally_collect_data_for_pid_stat(struct pid_stat *p, void *ptr) {
     }
 #endif
 
+done:
+
     // --------------------------------------------------------------------
     // done!
 
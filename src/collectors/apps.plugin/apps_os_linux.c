@@ -8,10 +8,75 @@
 #define PROC_PID_LIMITS_MAX_OPEN_FILES_KEY "\nMax open files "
 
 int max_fds_cache_seconds = 60;
+int max_pid_files_kept_open = -1; // -1 = auto, based on RLIMIT_NOFILE
 kernel_uint_t system_uptime_secs;
 
 void apps_os_init_linux(void) {
-    ;
+#if defined(HAVE_BPF_ITER)
+    if(enable_bpf_files && (!enable_file_charts || !apps_os_bpf_files_init_linux()))
+        enable_bpf_files = false;
+#endif
+
+    if(max_pid_files_kept_open < 0) {
+        struct rlimit rl;
+        if(getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+            if(rl.rlim_cur != RLIM_INFINITY && rl.rlim_max != rl.rlim_cur) {
+                rl.rlim_cur = rl.rlim_max;
+                if(setrlimit(RLIMIT_NOFILE, &rl) != 0)
+                    getrlimit(RLIMIT_NOFILE, &rl);
+            }
+
+            // use half of the open files limit for the cache,
+            // the rest is for everything else we open
+            if(rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur / 2 > INT_MAX)
+                max_pid_files_kept_open = INT_MAX;
+            else
+                max_pid_files_kept_open = (int)(rl.rlim_cur / 2);
+        }
+        else
+            max_pid_files_kept_open = 0;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// /proc/pid/stat, /proc/pid/status and /proc/pid/io are kept open across iterations,
+// so that reading them is a single pread() per file, instead of open(), read(), lseek() and close().
+// When a process exits, reading its files fails with ESRCH, so a reused pid never
+// reads the files of the exited process.
+
+static size_t pid_files_kept_open = 0;
+
+static inline void apps_os_pid_file_close_linux(int *fd) {
+    if(*fd != -1) {
+        close(*fd);
+        *fd = -1;
+        pid_files_kept_open--;
+    }
+}
+
+void apps_os_pid_files_close_linux(struct pid_stat *p) {
+    apps_os_pid_file_close_linux(&p->stat_fd);
+    apps_os_pid_file_close_linux(&p->status_fd);
+    apps_os_pid_file_close_linux(&p->io_fd);
+}
+
+static inline bool apps_os_pid_file_read_linux(procfile **ff, int *fd, const char *filename) {
+    if(*fd == -1) {
+        *fd = open(filename, procfile_open_flags, 0666);
+        if(unlikely(*fd == -1))
+            return false;
+
+        pid_files_kept_open++;
+    }
+
+    // on failure, this frees ff and sets it to NULL
+    *ff = procfile_readall_fd(*ff, *fd, NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
+
+    // close it if we cannot read it, or we have too many files open
+    if(unlikely(!*ff || pid_files_kept_open > (size_t)max_pid_files_kept_open))
+        apps_os_pid_file_close_linux(fd);
+
+    return *ff != NULL;
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -24,6 +89,12 @@ struct arl_callback_ptr {
 };
 
 bool apps_os_read_pid_fds_linux(struct pid_stat *p, void *ptr __maybe_unused) {
+#if defined(HAVE_BPF_ITER)
+    // processes not found by the iterator (e.g. started after it ran) are read from /proc
+    if(enable_bpf_files && apps_os_bpf_files_read_pid_fds_linux(p))
+        return true;
+#endif
+
     if(unlikely(!p->fds_dirname)) {
         char dirname[FILENAME_MAX+1];
         snprintfz(dirname, FILENAME_MAX, "%s/proc/%d/fd", netdata_configured_host_prefix, p->pid);
@@ -52,21 +123,7 @@ bool apps_os_read_pid_fds_linux(struct pid_stat *p, void *ptr __maybe_unused) {
         if(unlikely(fdid < 0)) continue;
 
         // check if the fds array is small
-        if(unlikely((size_t)fdid >= p->fds_size)) {
-            // it is small, extend it
-
-            debug_log("extending fd memory slots for %s from %d to %d"
-                      , pid_stat_comm(p)
-                          , p->fds_size
-                      , fdid + MAX_SPARE_FDS
-            );
-
-            p->fds = reallocz(p->fds, (fdid + MAX_SPARE_FDS) * sizeof(struct pid_fd));
-
-            // and initialize it
-            init_pid_fds(p, p->fds_size, (fdid + MAX_SPARE_FDS) - p->fds_size);
-            p->fds_size = (size_t)fdid + MAX_SPARE_FDS;
-        }
+        pid_fds_ensure_slot(p, fdid);
 
         if(unlikely(p->fds[fdid].fd < 0 && de->d_ino != p->fds[fdid].inode)) {
             // inodes do not match, clear the previous entry
@@ -106,28 +163,7 @@ bool apps_os_read_pid_fds_linux(struct pid_stat *p, void *ptr __maybe_unused) {
         else
             linkname[l] = '\0';
 
-        uint32_t link_hash = simple_hash(linkname);
-
-        if(unlikely(p->fds[fdid].fd < 0 && p->fds[fdid].link_hash != link_hash)) {
-            // the link changed
-            links_changed_counter++;
-            file_descriptor_not_used(-p->fds[fdid].fd);
-            clear_pid_fd(&p->fds[fdid]);
-        }
-
-        if(unlikely(p->fds[fdid].fd == 0)) {
-            // we don't know this fd, get it
-
-            // if another process already has this, we will get
-            // the same id
-            p->fds[fdid].fd = (int)file_descriptor_find_or_add(linkname, link_hash);
-            p->fds[fdid].inode = de->d_ino;
-            p->fds[fdid].link_hash = link_hash;
-        }
-        else {
-            // else make it positive again, we need it
-            p->fds[fdid].fd = -p->fds[fdid].fd;
-        }
+        pid_fd_update_link(p, fdid, de->d_ino, linkname);
 
         // caching control
         // without this we read all the files on every iteration
@@ -231,12 +267,11 @@ bool apps_os_read_pid_io_linux(struct pid_stat *p, void *ptr __maybe_unused) {
         p->io_filename = strdupz(filename);
     }
 
-    // open the file
-    ff = procfile_reopen(ff, p->io_filename, NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-    if(unlikely(!ff)) goto cleanup;
+    if(unlikely(!ff))
+        ff = procfile_new(NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
 
-    ff = procfile_readall(ff);
-    if(unlikely(!ff)) goto cleanup;
+    if(unlikely(!apps_os_pid_file_read_linux(&ff, &p->io_fd, p->io_filename)))
+        goto cleanup;
 
     pid_incremental_rate(io, PDF_LREAD,     str2kernel_uint_t(procfile_lineword(ff, 0,  1)));
     pid_incremental_rate(io, PDF_LWRITE,    str2kernel_uint_t(procfile_lineword(ff, 1,  1)));
@@ -462,7 +497,7 @@ void arl_callback_status_voluntary_ctxt_switches(const char *name, uint32_t hash
     if(unlikely(procfile_linewords(aptr->ff, aptr->line) < 2)) return;
 
     struct pid_stat *p = aptr->p;
-    pid_incremental_rate(stat, PDF_VOLCTX, str2kernel_uint_t(procfile_lineword(aptr->ff, aptr->line, 1)));
+    pid_incremental_rate(status, PDF_VOLCTX, str2kernel_uint_t(procfile_lineword(aptr->ff, aptr->line, 1)));
 }
 
 void arl_callback_status_nonvoluntary_ctxt_switches(const char *name, uint32_t hash, const char *value, void *dst) {
@@ -471,7 +506,7 @@ void arl_callback_status_nonvoluntary_ctxt_switches(const char *name, uint32_t h
     if(unlikely(procfile_linewords(aptr->ff, aptr->line) < 2)) return;
 
     struct pid_stat *p = aptr->p;
-    pid_incremental_rate(stat, PDF_NVOLCTX, str2kernel_uint_t(procfile_lineword(aptr->ff, aptr->line, 1)));
+    pid_incremental_rate(status, PDF_NVOLCTX, str2kernel_uint_t(procfile_lineword(aptr->ff, aptr->line, 1)));
 }
 
 bool apps_os_read_pid_status_linux(struct pid_stat *p, void *ptr __maybe_unused) {
@@ -497,11 +532,11 @@ bool apps_os_read_pid_status_linux(struct pid_stat *p, void *ptr __maybe_unused)
         p->status_filename = strdupz(filename);
     }
 
-    ff = procfile_reopen(ff, p->status_filename, (!ff)?" \t:,-()/":NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-    if(unlikely(!ff)) return false;
+    if(unlikely(!ff))
+        ff = procfile_new(" \t:,-()/", PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
 
-    ff = procfile_readall(ff);
-    if(unlikely(!ff)) return false;
+    if(unlikely(!apps_os_pid_file_read_linux(&ff, &p->status_fd, p->status_filename)))
+        return false;
 
     calls_counter++;
 
@@ -619,17 +654,14 @@ bool apps_os_read_pid_stat_linux(struct pid_stat *p, void *ptr __maybe_unused) {
         p->stat_filename = strdupz(filename);
     }
 
-    bool set_quotes = (!ff) ? true : false;
-
-    ff = procfile_reopen(ff, p->stat_filename, NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-    if(unlikely(!ff)) goto cleanup;
-
-    // if(set_quotes) procfile_set_quotes(ff, "()");
-    if(unlikely(set_quotes))
+    if(unlikely(!ff)) {
+        ff = procfile_new(NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
+        // procfile_set_quotes(ff, "()");
         procfile_set_open_close(ff, "(", ")");
+    }
 
-    ff = procfile_readall(ff);
-    if(unlikely(!ff)) goto cleanup;
+    if(unlikely(!apps_os_pid_file_read_linux(&ff, &p->stat_fd, p->stat_filename)))
+        goto cleanup;
 
     // p->pid           = str2pid_t(procfile_lineword(ff, 0, 0));
     char *comm          = procfile_lineword(ff, 0, 1);
@@ -742,6 +774,11 @@ bool apps_os_collect_all_pids_linux(void) {
 
     system_uptime_secs = (kernel_uint_t)(uptime_msec(uptime_filename) / MSEC_PER_SEC);
 
+#if defined(HAVE_BPF_ITER)
+    if(enable_bpf_files)
+        apps_os_bpf_files_collect_linux();
+#endif
+
     char dirname[FILENAME_MAX + 1];
 
     snprintfz(dirname, FILENAME_MAX, "%s/proc", netdata_configured_host_prefix);
@@ -0,0 +1,519 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "apps_plugin.h"
+
+#if defined(OS_LINUX) && defined(HAVE_BPF_ITER)
+
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/btf.h>
+
+// --------------------------------------------------------------------------------------------------------------------
+// BPF task file iterator
+//
+// A tiny BPF program, attached to the bpf_iter_task_file iterator, dumps one
+// record for every open file of every process, in a single read() pass.
+// So, the open files of all processes are collected without opendir() and
+// readlink() on every entry of /proc/PID/fd.
+//
+// The program is assembled here, with the offsets of the kernel structures
+// found in the BTF of the running kernel (/sys/kernel/btf/vmlinux), so that
+// neither libbpf nor a compiled BPF object is needed.
+//
+// Loading it requires CAP_BPF and CAP_PERFMON (or CAP_SYS_ADMIN) and a
+// kernel with BTF (5.8+). When any of these is not available, apps.plugin
+// reads /proc/PID/fd as usual.
+
+bool enable_bpf_files = false;
+
+#define APPS_BPF_FD_NAME_MAX 32
+
+struct apps_bpf_fd {
+    uint32_t tgid;
+    uint32_t fd;
+    uint32_t mode;                  // inode->i_mode
+    uint32_t dev;                   // inode->i_sb->s_dev
+    uint64_t ino;                   // inode->i_ino
+    char name[APPS_BPF_FD_NAME_MAX];// the dentry name, only for anonymous inodes
+};
+
+static struct {
+    int prog_fd;
+    int link_fd;
+
+    struct apps_bpf_fd *fds;
+    size_t used;
+    size_t size;
+} bpf_files = {
+    .prog_fd = -1,
+    .link_fd = -1,
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// vmlinux BTF
+
+struct apps_btf {
+    char *data;
+    size_t size;
+
+    const char *strings;
+    uint32_t strings_len;
+
+    const struct btf_type **types;
+    uint32_t types_count;
+};
+
+static size_t apps_btf_type_size(const struct btf_type *t) {
+    uint16_t vlen = BTF_INFO_VLEN(t->info);
+
+    switch(BTF_INFO_KIND(t->info)) {
+        case BTF_KIND_INT:
+            return sizeof(*t) + sizeof(uint32_t);
+
+        case BTF_KIND_ARRAY:
+            return sizeof(*t) + sizeof(struct btf_array);
+
+        case BTF_KIND_STRUCT:
+        case BTF_KIND_UNION:
+            return sizeof(*t) + vlen * sizeof(struct btf_member);
+
+        case BTF_KIND_ENUM:
+            return sizeof(*t) + vlen * sizeof(struct btf_enum);
+
+        case BTF_KIND_FUNC_PROTO:
+            return sizeof(*t) + vlen * sizeof(struct btf_param);
+
+        case BTF_KIND_VAR:
+            return sizeof(*t) + sizeof(struct btf_var);
+
+        case BTF_KIND_DATASEC:
+            return sizeof(*t) + vlen * sizeof(struct btf_var_secinfo);
+
+        case 17: // BTF_KIND_DECL_TAG
+            return sizeof(*t) + sizeof(int32_t);
+
+        case 19: // BTF_KIND_ENUM64
+            return sizeof(*t) + vlen * 3 * sizeof(uint32_t);
+
+        default:
+            return sizeof(*t);
+    }
+}
+
+static void apps_btf_free(struct apps_btf *btf) {
+    freez(btf->types);
+    freez(btf->data);
+    memset(btf, 0, sizeof(*btf));
+}
+
+static bool apps_btf_load(struct apps_btf *btf) {
+    memset(btf, 0, sizeof(*btf));
+
+    int fd = open("/sys/kernel/btf/vmlinux", O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return false;
+
+    size_t allocated = 8 * 1024 * 1024;
+    btf->data = mallocz(allocated);
+
+    ssize_t r;
+    while((r = read(fd, &btf->data[btf->size], allocated - btf->size)) > 0) {
+        btf->size += r;
+        if(btf->size == allocated) {
+            allocated *= 2;
+            btf->data = reallocz(btf->data, allocated);
+        }
+    }
+    close(fd);
+
+    const struct btf_header *hdr = (const struct btf_header *)btf->data;
+    if(r == -1 || btf->size < sizeof(*hdr) || hdr->magic != BTF_MAGIC ||
+        (size_t)hdr->hdr_len + hdr->type_off + hdr->type_len > btf->size ||
+        (size_t)hdr->hdr_len + hdr->str_off + hdr->str_len > btf->size) {
+        apps_btf_free(btf);
+        return false;
+    }
+
+    btf->strings = &btf->data[hdr->hdr_len + hdr->str_off];
+    btf->strings_len = hdr->str_len;
+
+    const char *s = &btf->data[hdr->hdr_len + hdr->type_off];
+    const char *e = s + hdr->type_len;
+
+    // type ids start at 1
+    uint32_t types_size = 1024;
+    btf->types = mallocz(types_size * sizeof(*btf->types));
+    btf->types[0] = NULL;
+    btf->types_count = 1;
+
+    while(s + sizeof(struct btf_type) <= e) {
+        if(btf->types_count == types_size) {
+            types_size *= 2;
+            btf->types = reallocz(btf->types, types_size * sizeof(*btf->types));
+        }
+
+        const struct btf_type *t = (const struct btf_type *)s;
+        btf->types[btf->types_count++] = t;
+        s += apps_btf_type_size(t);
+    }
+
+    return true;
+}
+
+static inline const char *apps_btf_name(struct apps_btf *btf, uint32_t name_off) {
+    return (name_off < btf->strings_len) ? &btf->strings[name_off] : "";
+}
+
+static uint32_t apps_btf_find(struct apps_btf *btf, const char *name, uint32_t kind) {
+    for(uint32_t id = 1; id < btf->types_count; id++) {
+        const struct btf_type *t = btf->types[id];
+        if(BTF_INFO_KIND(t->info) == kind && strcmp(apps_btf_name(btf, t->name_off), name) == 0)
+            return id;
+    }
+
+    return 0;
+}
+
+static const struct btf_type *apps_btf_resolve(struct apps_btf *btf, uint32_t id) {
+    while(id && id < btf->types_count) {
+        const struct btf_type *t = btf->types[id];
+
+        switch(BTF_INFO_KIND(t->info)) {
+            case BTF_KIND_TYPEDEF:
+            case BTF_KIND_VOLATILE:
+            case BTF_KIND_CONST:
+            case BTF_KIND_RESTRICT:
+            case 18: // BTF_KIND_TYPE_TAG
+                id = t->type;
+                break;
+
+            default:
+                return t;
+        }
+    }
+
+    return NULL;
+}
+
+// the byte offset of a member in a struct, searching also in anonymous structs and unions
+static int apps_btf_member_offset_of_type(struct apps_btf *btf, const struct btf_type *t, const char *member) {
+    if(!t || (BTF_INFO_KIND(t->info) != BTF_KIND_STRUCT && BTF_INFO_KIND(t->info) != BTF_KIND_UNION))
+        return -1;
+
+    const struct btf_member *m = (const struct btf_member *)(t + 1);
+    for(uint16_t i = 0; i < BTF_INFO_VLEN(t->info); i++) {
+        uint32_t bits = BTF_INFO_KFLAG(t->info) ? BTF_MEMBER_BIT_OFFSET(m[i].offset) : m[i].offset;
+
+        if(!m[i].name_off) {
+            int offset = apps_btf_member_offset_of_type(btf, apps_btf_resolve(btf, m[i].type), member);
+            if(offset >= 0)
+                return (int)(bits / 8) + offset;
+
+            continue;
+        }
+
+        if(strcmp(apps_btf_name(btf, m[i].name_off), member) == 0)
+            return (bits % 8) ? -1 : (int)(bits / 8);
+    }
+
+    return -1;
+}
+
+static int apps_btf_member_offset(struct apps_btf *btf, const char *structure, const char *member) {
+    uint32_t id = apps_btf_find(btf, structure, BTF_KIND_STRUCT);
+    if(!id) return -1;
+
+    int offset = apps_btf_member_offset_of_type(btf, btf->types[id], member);
+    if(offset < 0)
+        nd_log(NDLS_COLLECTORS, NDLP_INFO,
+               "BPF: cannot find member '%s' of 'struct %s' in the kernel BTF", member, structure);
+
+    return offset;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// the BPF program
+
+#define BPF_INSN(c, d, s, o, i) ((struct bpf_insn){ .code = (c), .dst_reg = (d), .src_reg = (s), .off = (o), .imm = (i) })
+#define BPF_LDX_MEM(size, dst, src, off) BPF_INSN(BPF_LDX | BPF_MEM | (size), dst, src, off, 0)
+#define BPF_STX_MEM(size, dst, src, off) BPF_INSN(BPF_STX | BPF_MEM | (size), dst, src, off, 0)
+#define BPF_ST_MEM(size, dst, off, imm) BPF_INSN(BPF_ST | BPF_MEM | (size), dst, 0, off, imm)
+#define BPF_MOV64_REG(dst, src) BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0)
+#define BPF_MOV64_IMM(dst, imm) BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm)
+#define BPF_ADD64_IMM(dst, imm) BPF_INSN(BPF_ALU64 | BPF_ADD | BPF_K, dst, 0, 0, imm)
+#define BPF_AND64_IMM(dst, imm) BPF_INSN(BPF_ALU64 | BPF_AND | BPF_K, dst, 0, 0, imm)
+#define BPF_JEQ_IMM(dst, imm, off) BPF_INSN(BPF_JMP | BPF_JEQ | BPF_K, dst, 0, off, imm)
+#define BPF_JNE_IMM(dst, imm, off) BPF_INSN(BPF_JMP | BPF_JNE | BPF_K, dst, 0, off, imm)
+#define BPF_CALL_HELPER(func) BPF_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, func)
+#define BPF_EXIT_INSN() BPF_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+
+static inline int apps_bpf(int cmd, union bpf_attr *attr) {
+    return (int)syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static bool apps_bpf_load_program(void) {
+    struct apps_btf btf;
+    if(!apps_btf_load(&btf)) {
+        nd_log(NDLS_COLLECTORS, NDLP_INFO, "BPF: cannot read the kernel BTF from /sys/kernel/btf/vmlinux");
+        return false;
+    }
+
+    uint32_t iter_btf_id = apps_btf_find(&btf, "bpf_iter_task_file", BTF_KIND_FUNC);
+
+    int task_tgid = apps_btf_member_offset(&btf, "task_struct", "tgid");
+    int file_f_inode = apps_btf_member_offset(&btf, "file", "f_inode");
+    int file_f_path = apps_btf_member_offset(&btf, "file", "f_path");
+    int path_dentry = apps_btf_member_offset(&btf, "path", "dentry");
+    int dentry_d_name = apps_btf_member_offset(&btf, "dentry", "d_name");
+    int qstr_name = apps_btf_member_offset(&btf, "qstr", "name");
+    int inode_i_mode = apps_btf_member_offset(&btf, "inode", "i_mode");
+    int inode_i_ino = apps_btf_member_offset(&btf, "inode", "i_ino");
+    int inode_i_sb = apps_btf_member_offset(&btf, "inode", "i_sb");
+    int super_block_s_dev = apps_btf_member_offset(&btf, "super_block", "s_dev");
+
+    apps_btf_free(&btf);
+
+    if(!iter_btf_id) {
+        nd_log(NDLS_COLLECTORS, NDLP_INFO, "BPF: the kernel does not support task file iterators");
+        return false;
+    }
+
+    if(task_tgid < 0 || file_f_inode < 0 || file_f_path < 0 || path_dentry < 0 || dentry_d_name < 0 ||
+        qstr_name < 0 || inode_i_mode < 0 || inode_i_ino < 0 || inode_i_sb < 0 || super_block_s_dev < 0)
+        return false;
+
+    // the record is built on the stack, below the frame pointer
+    const int16_t R = -(int16_t)sizeof(struct apps_bpf_fd);
+#define RECORD(member) (int16_t)(R + (int16_t)offsetof(struct apps_bpf_fd, member))
+
+    // struct bpf_iter__task_file { meta, task, fd, file }, all 8 bytes each
+    struct bpf_insn prog[] = {
+        /*  0 */ BPF_MOV64_REG(BPF_REG_6, BPF_REG_1),                                   // r6 = ctx
+        /*  1 */ BPF_LDX_MEM(BPF_DW, BPF_REG_7, BPF_REG_6, 8),                          // r7 = ctx->task
+        /*  2 */ BPF_JEQ_IMM(BPF_REG_7, 0, 32),                                         // goto 35
+        /*  3 */ BPF_LDX_MEM(BPF_DW, BPF_REG_8, BPF_REG_6, 24),                         // r8 = ctx->file
+        /*  4 */ BPF_JEQ_IMM(BPF_REG_8, 0, 30),                                         // goto 35
+        /*  5 */ BPF_LDX_MEM(BPF_W, BPF_REG_1, BPF_REG_7, task_tgid),                   // task->tgid
+        /*  6 */ BPF_STX_MEM(BPF_W, BPF_REG_10, BPF_REG_1, RECORD(tgid)),
+        /*  7 */ BPF_LDX_MEM(BPF_W, BPF_REG_1, BPF_REG_6, 16),                          // ctx->fd
+        /*  8 */ BPF_STX_MEM(BPF_W, BPF_REG_10, BPF_REG_1, RECORD(fd)),
+        /*  9 */ BPF_LDX_MEM(BPF_DW, BPF_REG_9, BPF_REG_8, file_f_inode),               // r9 = file->f_inode
+        /* 10 */ BPF_LDX_MEM(BPF_H, BPF_REG_1, BPF_REG_9, inode_i_mode),                // inode->i_mode
+        /* 11 */ BPF_STX_MEM(BPF_W, BPF_REG_10, BPF_REG_1, RECORD(mode)),
+        /* 12 */ BPF_LDX_MEM(BPF_DW, BPF_REG_2, BPF_REG_9, inode_i_sb),                 // inode->i_sb
+        /* 13 */ BPF_LDX_MEM(BPF_W, BPF_REG_2, BPF_REG_2, super_block_s_dev),           // i_sb->s_dev
+        /* 14 */ BPF_STX_MEM(BPF_W, BPF_REG_10, BPF_REG_2, RECORD(dev)),
+        /* 15 */ BPF_LDX_MEM(BPF_DW, BPF_REG_2, BPF_REG_9, inode_i_ino),                // inode->i_ino
+        /* 16 */ BPF_STX_MEM(BPF_DW, BPF_REG_10, BPF_REG_2, RECORD(ino)),
+        /* 17 */ BPF_ST_MEM(BPF_DW, BPF_REG_10, RECORD(name) + 0, 0),
+        /* 18 */ BPF_ST_MEM(BPF_DW, BPF_REG_10, RECORD(name) + 8, 0),
+        /* 19 */ BPF_ST_MEM(BPF_DW, BPF_REG_10, RECORD(name) + 16, 0),
+        /* 20 */ BPF_ST_MEM(BPF_DW, BPF_REG_10, RECORD(name) + 24, 0),
+        /* 21 */ BPF_AND64_IMM(BPF_REG_1, S_IFMT),
+        /* 22 */ BPF_JNE_IMM(BPF_REG_1, 0, 6),                                          // not anonymous, goto 29
+        /* 23 */ BPF_LDX_MEM(BPF_DW, BPF_REG_3, BPF_REG_8, file_f_path + path_dentry),  // file->f_path.dentry
+        /* 24 */ BPF_LDX_MEM(BPF_DW, BPF_REG_3, BPF_REG_3, dentry_d_name + qstr_name),  // dentry->d_name.name
+        /* 25 */ BPF_MOV64_REG(BPF_REG_1, BPF_REG_10),
+        /* 26 */ BPF_ADD64_IMM(BPF_REG_1, RECORD(name)),
+        /* 27 */ BPF_MOV64_IMM(BPF_REG_2, APPS_BPF_FD_NAME_MAX),
+        /* 28 */ BPF_CALL_HELPER(BPF_FUNC_probe_read_kernel_str),
+        /* 29 */ BPF_LDX_MEM(BPF_DW, BPF_REG_1, BPF_REG_6, 0),                          // ctx->meta
+        /* 30 */ BPF_LDX_MEM(BPF_DW, BPF_REG_1, BPF_REG_1, 0),                          // meta->seq
+        /* 31 */ BPF_MOV64_REG(BPF_REG_2, BPF_REG_10),
+        /* 32 */ BPF_ADD64_IMM(BPF_REG_2, R),
+        /* 33 */ BPF_MOV64_IMM(BPF_REG_3, sizeof(struct apps_bpf_fd)),
+        /* 34 */ BPF_CALL_HELPER(BPF_FUNC_seq_write),
+        /* 35 */ BPF_MOV64_IMM(BPF_REG_0, 0),
+        /* 36 */ BPF_EXIT_INSN(),
+    };
+#undef RECORD
+
+    static char log[4096];
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_TRACING;
+    attr.expected_attach_type = BPF_TRACE_ITER;
+    attr.attach_btf_id = iter_btf_id;
+    attr.insns = (uint64_t)(uintptr_t)prog;
+    attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+    attr.license = (uint64_t)(uintptr_t)"GPL";
+    attr.log_buf = (uint64_t)(uintptr_t)log;
+    attr.log_size = sizeof(log);
+    attr.log_level = 1;
+    strncpyz(attr.prog_name, "apps_files", sizeof(attr.prog_name) - 1);
+
+    bpf_files.prog_fd = apps_bpf(BPF_PROG_LOAD, &attr);
+    if(bpf_files.prog_fd == -1) {
+        nd_log(NDLS_COLLECTORS, NDLP_INFO,
+               "BPF: cannot load the task file iterator program (errno %d, %s)%s%s",
+               errno, strerror(errno), *log ? ", verifier says: " : "", log);
+        return false;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = bpf_files.prog_fd;
+    attr.link_create.attach_type = BPF_TRACE_ITER;
+
+    bpf_files.link_fd = apps_bpf(BPF_LINK_CREATE, &attr);
+    if(bpf_files.link_fd == -1) {
+        nd_log(NDLS_COLLECTORS, NDLP_INFO,
+               "BPF: cannot attach the task file iterator program (errno %d, %s)", errno, strerror(errno));
+        close(bpf_files.prog_fd);
+        bpf_files.prog_fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// public API
+
+bool apps_os_bpf_files_init_linux(void) {
+    if(!apps_bpf_load_program())
+        return false;
+
+    nd_log(NDLS_COLLECTORS, NDLP_INFO, "BPF: open files of processes are collected with a task file iterator");
+    return true;
+}
+
+static int apps_bpf_fd_compare(const void *a, const void *b) {
+    const struct apps_bpf_fd *fa = a, *fb = b;
+    if(fa->tgid < fb->tgid) return -1;
+    if(fa->tgid > fb->tgid) return 1;
+    return 0;
+}
+
+bool apps_os_bpf_files_collect_linux(void) {
+    bpf_files.used = 0;
+
+    if(bpf_files.link_fd == -1)
+        return false;
+
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.iter_create.link_fd = bpf_files.link_fd;
+
+    int fd = apps_bpf(BPF_ITER_CREATE, &attr);
+    if(fd == -1)
+        return false;
+
+    bool sorted = true;
+    uint32_t last_tgid = 0;
+    size_t bytes = 0;
+    ssize_t r;
+
+    do {
+        if(bpf_files.used == bpf_files.size) {
+            bpf_files.size = bpf_files.size ? bpf_files.size * 2 : 4096;
+            bpf_files.fds = reallocz(bpf_files.fds, bpf_files.size * sizeof(*bpf_files.fds));
+        }
+
+        // the iterator writes whole records, but a read may return less than we asked for
+        char *dst = (char *)&bpf_files.fds[bpf_files.used] + bytes;
+        r = read(fd, dst, (bpf_files.size - bpf_files.used) * sizeof(*bpf_files.fds) - bytes);
+        if(r > 0) {
+            bytes += r;
+
+            size_t records = bytes / sizeof(*bpf_files.fds);
+            for(size_t i = 0; i < records; i++) {
+                if(bpf_files.fds[bpf_files.used + i].tgid < last_tgid)
+                    sorted = false;
+                last_tgid = bpf_files.fds[bpf_files.used + i].tgid;
+            }
+
+            // a partial record, if any, is already at the beginning of the next slot
+            bpf_files.used += records;
+            bytes -= records * sizeof(*bpf_files.fds);
+        }
+    } while(r > 0);
+
+    close(fd);
+
+    if(r == -1) {
+        bpf_files.used = 0;
+        return false;
+    }
+
+    if(!sorted)
+        qsort(bpf_files.fds, bpf_files.used, sizeof(*bpf_files.fds), apps_bpf_fd_compare);
+
+    return true;
+}
+
+// the records of a process, as collected by apps_os_bpf_files_collect_linux()
+static const struct apps_bpf_fd *apps_bpf_files_of_pid(pid_t pid, size_t *count) {
+    size_t lo = 0, hi = bpf_files.used;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(bpf_files.fds[mid].tgid < (uint32_t)pid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    size_t end = lo;
+    while(end < bpf_files.used && bpf_files.fds[end].tgid == (uint32_t)pid)
+        end++;
+
+    *count = end - lo;
+    return (end > lo) ? &bpf_files.fds[lo] : NULL;
+}
+
+// the same names readlink() returns for /proc/PID/fd/N, except files that get a
+// unique name per device and inode (all of them start with '/', so they are files)
+static inline void apps_bpf_fd_linkname(const struct apps_bpf_fd *r, char *dst, size_t size) {
+    switch(r->mode & S_IFMT) {
+        case S_IFSOCK:
+            snprintfz(dst, size, "socket:[%" PRIu64 "]", r->ino);
+            break;
+
+        case S_IFIFO:
+            snprintfz(dst, size, "pipe:[%" PRIu64 "]", r->ino);
+            break;
+
+        case 0:
+            snprintfz(dst, size, "anon_inode:%.*s", APPS_BPF_FD_NAME_MAX, r->name);
+            break;
+
+        default:
+            snprintfz(dst, size, "/inode/%" PRIu32 "/%" PRIu64, r->dev, r->ino);
+            break;
+    }
+}
+
+bool apps_os_bpf_files_read_pid_fds_linux(struct pid_stat *p) {
+    size_t count;
+    const struct apps_bpf_fd *r = apps_bpf_files_of_pid(p->pid, &count);
+    if(!r)
+        return false;
+
+    char linkname[FILENAME_MAX + 1];
+
+    // we make all pid fds negative, so that
+    // we can detect unused file descriptors
+    // at the end, to free them
+    make_all_pid_fds_negative(p);
+
+    for(const struct apps_bpf_fd *end = &r[count]; r < end; r++) {
+        int fdid = (int)r->fd;
+        if(unlikely(fdid < 0)) continue;
+
+        pid_fds_ensure_slot(p, fdid);
+
+        if(unlikely(p->fds[fdid].fd < 0 && r->ino != p->fds[fdid].inode)) {
+            // inodes do not match, clear the previous entry
+            inodes_changed_counter++;
+            file_descriptor_not_used(-p->fds[fdid].fd);
+            clear_pid_fd(&p->fds[fdid]);
+        }
+
+        apps_bpf_fd_linkname(r, linkname, sizeof(linkname));
+        pid_fd_update_link(p, fdid, r->ino, linkname);
+    }
+
+    return true;
+}
+
+#endif
@@ -86,6 +86,10 @@ struct pid_stat *get_or_allocate_pid_entry(pid_t pid) {
     init_pid_fds(p, 0, p->fds_size);
 #endif
 
+#if defined(OS_LINUX)
+    p->stat_fd = p->status_fd = p->io_fd = -1;
+#endif
+
     p->pid = pid;
     p->values[PDF_PROCESSES] = 1;
 
@@ -121,6 +125,7 @@ void del_pid_entry(pid_t pid) {
     }
 
     arl_free(p->status_arl);
+    apps_os_pid_files_close_linux(p);
 
     freez(p->fds_dirname);
     freez(p->stat_filename);
@@ -162,6 +167,77 @@ void pid_collection_failed(struct pid_stat *p) {
     memcpy(p->values, current_pid_values, sizeof(p->values));
 }
 
+// the CPU of this iteration (the stat file has been read) and the I/O of the previous one
+bool pid_collection_is_idle(struct pid_stat *p) {
+    fatal_assert(current_pid == p->pid);
+
+    if(p->values[PDF_UTIME] || p->values[PDF_STIME])
+        return false;
+
+#if (PROCESSES_HAVE_LOGICAL_IO == 1)
+    if(current_pid_values[PDF_LREAD] || current_pid_values[PDF_LWRITE])
+        return false;
+#endif
+
+#if (PROCESSES_HAVE_PHYSICAL_IO == 1)
+    if(current_pid_values[PDF_PREAD] || current_pid_values[PDF_PWRITE])
+        return false;
+#endif
+
+#if (PROCESSES_HAVE_IO_CALLS == 1)
+    if(current_pid_values[PDF_OREAD] || current_pid_values[PDF_OWRITE])
+        return false;
+#endif
+
+    return true;
+}
+
+// restore the values of the previous iteration, that have not been collected in this iteration
+void pid_collection_keep_previous_values(struct pid_stat *p) {
+    static const PID_FIELD fields[] = {
+        PDF_VMSIZE,
+        PDF_VMRSS,
+#if (PROCESSES_HAVE_VMSHARED == 1)
+        PDF_VMSHARED,
+#endif
+#if (PROCESSES_HAVE_RSSFILE == 1)
+        PDF_RSSFILE,
+#endif
+#if (PROCESSES_HAVE_RSSSHMEM == 1)
+        PDF_RSSSHMEM,
+#endif
+#if (PROCESSES_HAVE_VMSWAP == 1)
+        PDF_VMSWAP,
+#endif
+#if (PROCESSES_HAVE_VOLCTX == 1)
+        PDF_VOLCTX,
+#endif
+#if (PROCESSES_HAVE_NVOLCTX == 1)
+        PDF_NVOLCTX,
+#endif
+#if (PROCESSES_HAVE_LOGICAL_IO == 1)
+        PDF_LREAD,
+        PDF_LWRITE,
+#endif
+#if (PROCESSES_HAVE_PHYSICAL_IO == 1)
+        PDF_PREAD,
+        PDF_PWRITE,
+#endif
+#if (PROCESSES_HAVE_IO_CALLS == 1)
+        PDF_OREAD,
+        PDF_OWRITE,
+#endif
+    };
+
+    fatal_assert(current_pid == p->pid);
+
+    for(size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        // anything the stat file provided on this operating system is fresh
+        if(!p->values[fields[i]])
+            p->values[fields[i]] = current_pid_values[fields[i]];
+    }
+}
+
 void pid_collection_completed(struct pid_stat *p) {
     p->updated = true;
     p->keep = false;
@@ -386,6 +386,52 @@ void clear_pid_fd(struct pid_fd *pfd) {
 #endif
 }
 
+#if defined(OS_LINUX)
+void pid_fds_ensure_slot(struct pid_stat *p, int fdid) {
+    if(unlikely((size_t)fdid >= p->fds_size)) {
+        // it is small, extend it
+
+        debug_log("extending fd memory slots for %s from %d to %d"
+                  , pid_stat_comm(p)
+                      , p->fds_size
+                  , fdid + MAX_SPARE_FDS
+        );
+
+        p->fds = reallocz(p->fds, (fdid + MAX_SPARE_FDS) * sizeof(struct pid_fd));
+
+        // and initialize it
+        init_pid_fds(p, p->fds_size, (fdid + MAX_SPARE_FDS) - p->fds_size);
+        p->fds_size = (size_t)fdid + MAX_SPARE_FDS;
+    }
+}
+
+// the fd is negative when it was known in the previous iteration
+void pid_fd_update_link(struct pid_stat *p, int fdid, ino_t inode, const char *linkname) {
+    uint32_t link_hash = simple_hash(linkname);
+
+    if(unlikely(p->fds[fdid].fd < 0 && p->fds[fdid].link_hash != link_hash)) {
+        // the link changed
+        links_changed_counter++;
+        file_descriptor_not_used(-p->fds[fdid].fd);
+        clear_pid_fd(&p->fds[fdid]);
+    }
+
+    if(unlikely(p->fds[fdid].fd == 0)) {
+        // we don't know this fd, get it
+
+        // if another process already has this, we will get
+        // the same id
+        p->fds[fdid].fd = (int)file_descriptor_find_or_add(linkname, link_hash);
+        p->fds[fdid].inode = inode;
+        p->fds[fdid].link_hash = link_hash;
+    }
+    else {
+        // else make it positive again, we need it
+        p->fds[fdid].fd = -p->fds[fdid].fd;
+    }
+}
+#endif
+
 void make_all_pid_fds_negative(struct pid_stat *p) {
     struct pid_fd *pfd = p->fds, *pfdend = &p->fds[p->fds_size];
     while(pfd < pfdend) {
@@ -40,6 +40,10 @@ bool enable_file_charts = false;
 bool enable_file_charts = true;
 #endif
 
+#if (INCREMENTAL_DATA_COLLECTION == 1)
+int idle_pids_refresh_iterations = 5;   // read io, status and fds of idle processes once every N iterations
+#endif
+
 // ----------------------------------------------------------------------------
 // internal counters
 
@@ -439,6 +443,42 @@ static void parse_args(int argc, char **argv)
             if(max_fds_cache_seconds < 0) max_fds_cache_seconds = 0;
             continue;
         }
+
+#if defined(HAVE_BPF_ITER)
+        if(strcmp("with-bpf-files", argv[i]) == 0) {
+            enable_bpf_files = true;
+            continue;
+        }
+
+        if(strcmp("without-bpf-files", argv[i]) == 0) {
+            enable_bpf_files = false;
+            continue;
+        }
+#endif
+
+        if(strcmp("pid-files-cache", argv[i]) == 0) {
+            if(argc <= i + 1) {
+                fprintf(stderr, "Parameter 'pid-files-cache' requires a number as argument.\n");
+                exit(1);
+            }
+            i++;
+            max_pid_files_kept_open = str2i(argv[i]);
+            if(max_pid_files_kept_open < 0) max_pid_files_kept_open = 0;
+            continue;
+        }
+#endif
+
+#if (INCREMENTAL_DATA_COLLECTION == 1)
+        if(strcmp("idle-refresh", argv[i]) == 0) {
+            if(argc <= i + 1) {
+                fprintf(stderr, "Parameter 'idle-refresh' requires a number as argument.\n");
+                exit(1);
+            }
+            i++;
+            idle_pids_refresh_iterations = str2i(argv[i]);
+            if(idle_pids_refresh_iterations < 1) idle_pids_refresh_iterations = 1;
+            continue;
+        }
 #endif
 
 #if (PROCESSES_HAVE_CPU_CHILDREN_TIME == 1) || (PROCESSES_HAVE_CHILDREN_FLTS == 1)
@@ -558,12 +598,39 @@ static void parse_args(int argc, char **argv)
                     "                        max given)\n"
                     "                        (default is %d seconds)\n"
                     "\n"
+#if defined(HAVE_BPF_ITER)
+                    " with-bpf-files\n"
+                    " without-bpf-files      enable / disable collecting the open files\n"
+                    "                        of all processes with a BPF task file\n"
+                    "                        iterator, instead of /proc/PID/fd\n"
+                    "                        (requires CAP_BPF and CAP_PERFMON and\n"
+                    "                        a kernel with BTF, otherwise /proc is used)\n"
+                    "                        (default is disabled)\n"
+                    "\n"
+#endif
+                    " pid-files-cache N      keep up to N /proc/PID/{stat,status,io}\n"
+                    "                        files open across iterations, to read\n"
+                    "                        them without reopening them\n"
+                    "                        0 disables it\n"
+                    "                        (default is half the open files limit)\n"
+                    "\n"
+#endif
+#if (INCREMENTAL_DATA_COLLECTION == 1)
+                    " idle-refresh N         read the I/O, status and files of idle\n"
+                    "                        processes (no CPU or I/O since the last\n"
+                    "                        iteration) once every N iterations\n"
+                    "                        1 reads them on every iteration\n"
+                    "                        (default is %d iterations)\n"
+                    "\n"
 #endif
                     " version or -v or -V print program version and exit\n"
                     "\n"
                     , NETDATA_VERSION
 #if defined(OS_LINUX)
                     , max_fds_cache_seconds
+#endif
+#if (INCREMENTAL_DATA_COLLECTION == 1)
+                    , idle_pids_refresh_iterations
 #endif
             );
             exit(0);
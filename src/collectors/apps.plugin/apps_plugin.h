@@ -144,6 +144,7 @@ struct pid_info {
 #define OS_FUNCTION(func) OS_FUNC_CONCAT(func, _linux)
 
 extern int max_fds_cache_seconds;
+extern int max_pid_files_kept_open;
 
 #else
 #error "Unsupported operating system"
@@ -162,6 +163,9 @@ extern bool include_exited_childs;
 extern bool enable_function_cmdline;
 extern bool proc_pid_cmdline_is_needed;
 extern bool enable_file_charts;
+#if (INCREMENTAL_DATA_COLLECTION == 1)
+extern int idle_pids_refresh_iterations;
+#endif
 
 extern size_t
     global_iterations_counter,
@@ -526,6 +530,8 @@ struct pid_stat {
 
     uint32_t keeploops;             // increases by 1 every time keep is 1 and updated 0
 
+    uint32_t idle_iterations;       // consecutive iterations without any CPU or I/O activity
+
     PID_LOG log_thrown;
 
     bool read:1;                    // true when we have already read this process for this iteration
@@ -554,6 +560,9 @@ struct pid_stat {
     usec_t last_io_collected_usec;
     usec_t last_limits_collected_usec;
 
+    usec_t status_collected_usec;
+    usec_t last_status_collected_usec;
+
 #if defined(OS_LINUX)
     ARL_BASE *status_arl;
     char *fds_dirname;              // the full directory name in /proc/PID/fd
@@ -562,6 +571,11 @@ struct pid_stat {
     char *io_filename;
     char *cmdline_filename;
     char *limits_filename;
+
+    // kept open across iterations, -1 when not open
+    int stat_fd;
+    int status_fd;
+    int io_fd;
 #endif
 };
 
@@ -651,6 +665,10 @@ void aggregate_pid_fds_on_targets(struct pid_stat *p);
 int read_pid_file_descriptors(struct pid_stat *p, void *ptr);
 void make_all_pid_fds_negative(struct pid_stat *p);
 uint32_t file_descriptor_find_or_add(const char *name, uint32_t hash);
+#if defined(OS_LINUX)
+void pid_fds_ensure_slot(struct pid_stat *p, int fdid);
+void pid_fd_update_link(struct pid_stat *p, int fdid, ino_t inode, const char *linkname);
+#endif
 #endif
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -664,6 +682,8 @@ bool collect_data_for_all_pids(void);
 
 void pid_collection_started(struct pid_stat *p);
 void pid_collection_failed(struct pid_stat *p);
+bool pid_collection_is_idle(struct pid_stat *p);
+void pid_collection_keep_previous_values(struct pid_stat *p);
 void pid_collection_completed(struct pid_stat *p);
 
 #if (INCREMENTAL_DATA_COLLECTION == 1)
@@ -760,4 +780,19 @@ bool OS_FUNCTION(apps_os_read_global_cpu_utilization)(void);
 // return the total physical memory of the system, in bytes
 uint64_t OS_FUNCTION(apps_os_get_total_memory)(void);
 
+#if defined(OS_LINUX)
+// close the files of the process kept open across iterations
+void apps_os_pid_files_close_linux(struct pid_stat *p);
+
+#if defined(HAVE_BPF_ITER)
+// collection of the open files of all processes with a BPF task file iterator
+extern bool enable_bpf_files;
+bool apps_os_bpf_files_init_linux(void);
+bool apps_os_bpf_files_collect_linux(void);
+
+// false when the process is not found in the last collection
+bool apps_os_bpf_files_read_pid_fds_linux(struct pid_stat *p);
+#endif
+#endif
+
 #endif //NETDATA_APPS_PLUGIN_H
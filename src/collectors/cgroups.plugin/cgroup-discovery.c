@@ -2,6 +2,8 @@
 
 #include "cgroup-internals.h"
 
+#include <sys/inotify.h>
+
 // discovery cgroup thread worker jobs
 #define WORKER_DISCOVERY_INIT               0
 #define WORKER_DISCOVERY_FIND               1
@@ -88,6 +90,7 @@ static inline void cgroup_free(struct cgroup *cg) {
     freez(cg->filename_memoryswap_limit);
 
     cgroup_free_network_interfaces(cg);
+    cgroup_files_close(cg);
 
     freez(cg->cpuacct_usage.cpu_percpu);
 
@@ -177,19 +180,29 @@ static inline void discovery_rename_cgroup(struct cgroup *cg) {
     cg->pending_renames--;
 
     netdata_log_debug(D_CGROUP, "looking for the name of cgroup '%s' with chart id '%s'", cg->id, cg->chart_id);
-    netdata_log_debug(D_CGROUP, "executing command %s \"%s\" for cgroup '%s'", cgroups_rename_script, cg->intermediate_id, cg->chart_id);
 
-    POPEN_INSTANCE *instance = spawn_popen_run_variadic(cgroups_rename_script, cg->id, cg->intermediate_id, NULL);
-    if (!instance) {
-        collector_error("CGROUP: cannot popen(%s \"%s\", \"r\").", cgroups_rename_script, cg->intermediate_id);
-        cg->pending_renames = 0;
-        cg->processed = 1;
-        return;
+    char buffer[CGROUP_CHARTID_LINE_MAX + 1];
+    char *new_name;
+    int exit_code;
+
+    if (cgroup_resolve_name(cg->id, buffer, sizeof(buffer))) {
+        new_name = buffer;
+        exit_code = 0;
     }
+    else {
+        netdata_log_debug(D_CGROUP, "executing command %s \"%s\" for cgroup '%s'", cgroups_rename_script, cg->intermediate_id, cg->chart_id);
 
-    char buffer[CGROUP_CHARTID_LINE_MAX + 1];
-    char *new_name = fgets(buffer, CGROUP_CHARTID_LINE_MAX, spawn_popen_stdout(instance));
-    int exit_code = spawn_popen_wait(instance);
+        POPEN_INSTANCE *instance = spawn_popen_run_variadic(cgroups_rename_script, cg->id, cg->intermediate_id, NULL);
+        if (!instance) {
+            collector_error("CGROUP: cannot popen(%s \"%s\", \"r\").", cgroups_rename_script, cg->intermediate_id);
+            cg->pending_renames = 0;
+            cg->processed = 1;
+            return;
+        }
+
+        new_name = fgets(buffer, CGROUP_CHARTID_LINE_MAX, spawn_popen_stdout(instance));
+        exit_code = spawn_popen_wait(instance);
+    }
 
     switch (exit_code) {
         case 0:
@@ -296,6 +309,9 @@ static inline struct cgroup *discovery_cgroup_add(const char *id) {
     cg->id = strdupz(id);
     cg->hash = simple_hash(cg->id);
 
+    for (size_t i = 0; i < CGROUP_FD_MAX; i++)
+        cg->fds[i] = -1;
+
     cg->name = strdupz(id);
 
     cg->intermediate_id = cgroup_chart_id_strdupz(id);
@@ -376,6 +392,62 @@ static inline void discovery_find_cgroup_in_dir(const char *dir) {
     cgroup_root_count++;
 }
 
+// ----------------------------------------------------------------------------
+// inotify
+//
+// Every directory the discovery walks is watched for subdirectories created
+// or removed, so that new and removed cgroups trigger a discovery on the next
+// iteration of the collection thread, instead of waiting for the next
+// periodic check. The kernel removes the watches of removed directories.
+
+static void discovery_inotify_watch(const char *dirpath) {
+    static bool logged = false;
+
+    if (discovery_thread.inotify_fd == -1)
+        return;
+
+    if (inotify_add_watch(discovery_thread.inotify_fd, dirpath, IN_CREATE | IN_DELETE | IN_ONLYDIR | IN_DONT_FOLLOW) == -1 && !logged) {
+        // usually fs.inotify.max_user_watches is reached; the periodic checks will find the rest
+        collector_error("CGROUP: cannot watch '%s' for new cgroups, some cgroups will be found only by the periodic checks.", dirpath);
+        logged = true;
+    }
+}
+
+void cgroup_discovery_inotify_init(void) {
+    discovery_thread.inotify_fd = -1;
+
+    if (!cgroup_use_inotify)
+        return;
+
+    discovery_thread.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (discovery_thread.inotify_fd == -1)
+        collector_error("CGROUP: cannot initialize inotify, cgroups will be found only by the periodic checks.");
+}
+
+// called by the collection thread, returns true when cgroups have been created or removed
+bool cgroup_discovery_inotify_changed(void) {
+    if (discovery_thread.inotify_fd == -1)
+        return false;
+
+    bool changed = false;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    ssize_t bytes;
+    while ((bytes = read(discovery_thread.inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + bytes;) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+
+            // IN_Q_OVERFLOW means events were lost, so a full discovery is needed anyway
+            if (ev->mask & (IN_CREATE | IN_DELETE | IN_Q_OVERFLOW))
+                changed = true;
+
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+
+    return changed;
+}
+
 static inline int discovery_find_walkdir(const char *base, const char *dirpath) {
     if (!dirpath)
         dirpath = base;
@@ -398,6 +470,7 @@ static inline int discovery_find_walkdir(const char *base, const char *dirpath)
     }
     ret = 1;
 
+    discovery_inotify_watch(dirpath);
     discovery_find_cgroup_in_dir(relative_path);
 
     struct dirent *de = NULL;
@@ -1227,10 +1300,16 @@ static inline void discovery_find_all_cgroups() {
         discovery_find_all_cgroups_v2();
     }
 
+    bool pending = false;
     for (struct cgroup *cg = discovered_cgroup_root; cg && service_running(SERVICE_COLLECTORS); cg = cg->discovered_next) {
         worker_is_busy(WORKER_DISCOVERY_PROCESS);
         discovery_process_cgroup(cg);
+
+        // cgroups waiting to be renamed or initialized need more discoveries
+        if (cg->available && !cg->processed)
+            pending = true;
     }
+    __atomic_store_n(&discovery_thread.pending, pending, __ATOMIC_RELAXED);
 
     worker_is_busy(WORKER_DISCOVERY_UPDATE);
     discovery_update_filenames_all_cgroups();
@@ -138,6 +138,32 @@ enum cgroups_container_orchestrator {
 
 
 // *** WARNING *** The fields are not thread safe. Take care of safe usage.
+// the statistics files of a cgroup that are kept open across iterations
+typedef enum {
+    CGROUP_FD_CPUACCT_STAT = 0,     // cpuacct.stat, or cpu.stat on v2
+    CGROUP_FD_CPUACCT_USAGE,
+    CGROUP_FD_CPU_STAT,             // v1 only
+    CGROUP_FD_CPU_SHARES,
+    CGROUP_FD_MEMORY_STAT,
+    CGROUP_FD_MEMORY_USAGE,
+    CGROUP_FD_MEMORY_MSW_USAGE,
+    CGROUP_FD_MEMORY_FAILCNT,
+    CGROUP_FD_IO_SERVICE_BYTES,     // io.stat on v2
+    CGROUP_FD_IO_SERVICED,          // io.stat on v2
+    CGROUP_FD_THROTTLE_IO_SERVICE_BYTES,
+    CGROUP_FD_THROTTLE_IO_SERVICED,
+    CGROUP_FD_IO_MERGED,
+    CGROUP_FD_IO_QUEUED,
+    CGROUP_FD_PIDS_CURRENT,
+    CGROUP_FD_CPU_PRESSURE,
+    CGROUP_FD_IO_PRESSURE,
+    CGROUP_FD_MEMORY_PRESSURE,
+    CGROUP_FD_IRQ_PRESSURE,
+
+    // terminator
+    CGROUP_FD_MAX,
+} CGROUP_FD;
+
 struct cgroup {
     uint32_t options;
 
@@ -167,6 +193,8 @@ struct cgroup {
 
     int container_orchestrator;
 
+    int fds[CGROUP_FD_MAX];     // -1 when not open
+
     struct cpuacct_stat cpuacct_stat;
     struct cpuacct_usage cpuacct_usage;
     struct cpuacct_cpu_throttling cpuacct_cpu_throttling;
@@ -269,6 +297,9 @@ struct discovery_thread {
     uv_mutex_t mutex;
     uv_cond_t cond_var;
     int exited;
+
+    int inotify_fd;     // watches the cgroup directories for creations and removals, -1 when disabled
+    bool pending;       // the last discovery left cgroups waiting to be renamed or initialized
 };
 
 extern struct discovery_thread discovery_thread;
@@ -280,6 +311,13 @@ extern uv_mutex_t cgroup_root_mutex;
 
 void cgroup_discovery_worker(void *ptr);
 
+extern bool cgroup_use_inotify;
+void cgroup_discovery_inotify_init(void);
+bool cgroup_discovery_inotify_changed(void);
+
+extern bool cgroup_use_name_resolvers;
+bool cgroup_resolve_name(const char *id, char *dst, size_t dst_size);
+
 extern bool is_inside_k8s;
 extern long system_page_size;
 
@@ -292,6 +330,9 @@ extern bool cgroup_enable_blkio;
 extern bool cgroup_enable_pressure;
 extern bool cgroup_enable_cpuacct_cpu_shares;
 
+extern bool cgroup_keep_files_open;
+void cgroup_files_close(struct cgroup *cg);
+
 extern int cgroup_check_for_new_every;
 extern int cgroup_update_every;
 
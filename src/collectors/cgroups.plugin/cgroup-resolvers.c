@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "cgroup-internals.h"
+
+// ----------------------------------------------------------------------------
+// in-process cgroup name resolvers
+//
+// Each resolver recognizes the cgroups of one container engine and asks the
+// engine API for the name of the container, without forking the rename
+// script. The result has the same format the script prints ("NAME" or
+// "NAME label1=value1,label2=value2").
+//
+// When no resolver recognizes a cgroup, or the engine is not reachable, the
+// rename script is used, so that everything it supports keeps working.
+
+#define CGROUP_RESOLVER_TIMEOUT_MS 2000
+#define CGROUP_RESOLVER_RESPONSE_MAX (1024 * 1024)
+#define CGROUP_RESOLVER_NAME_MAX 100
+
+bool cgroup_use_name_resolvers = true;
+
+struct cgroup_name_resolver {
+    const char *name;
+    const char *prefix;         // the text preceding the container id in the cgroup path
+    size_t id_length;           // the accepted lengths of the container id (the short one is optional)
+    size_t short_id_length;
+    const char *env;            // the environment variable overriding the socket path
+    const char *socket;         // the default unix socket of the engine API
+};
+
+static struct cgroup_name_resolver cgroup_name_resolvers[] = {
+    // the same engines and cgroup patterns cgroup-name.sh matches for docker and podman
+    { .name = "docker", .prefix = "docker", .id_length = 64, .short_id_length = 12, .env = "DOCKER_HOST", .socket = "/var/run/docker.sock" },
+    { .name = "podman", .prefix = "libpod", .id_length = 64, .short_id_length = 0, .env = "PODMAN_HOST", .socket = "/run/podman/podman.sock" },
+
+    // terminator
+    { .name = NULL },
+};
+
+static inline bool is_cgroup_resolver_separator(char c) {
+    return c == '-' || c == '_' || c == '/' || c == '.';
+}
+
+// find the container id following the resolver prefix in the cgroup id
+static bool cgroup_resolver_container_id(struct cgroup_name_resolver *r, const char *id, char *dst, size_t dst_size) {
+    size_t prefix_len = strlen(r->prefix);
+
+    for(const char *s = strstr(id, r->prefix); s ; s = strstr(s + 1, r->prefix)) {
+        const char *h = &s[prefix_len];
+        if(!is_cgroup_resolver_separator(*h))
+            continue;
+
+        h++;
+        size_t len = 0;
+        while(isxdigit((uint8_t)h[len]))
+            len++;
+
+        if(!len || (h[len] && !is_cgroup_resolver_separator(h[len])))
+            continue;
+
+        if(len != r->id_length && len != r->short_id_length)
+            continue;
+
+        if(len >= dst_size)
+            return false;
+
+        memcpy(dst, h, len);
+        dst[len] = '\0';
+        return true;
+    }
+
+    return false;
+}
+
+static int cgroup_resolver_connect(const char *path) {
+    // a DOCKER_HOST like unix:///var/run/docker.sock
+    if(!strncmp(path, "unix://", 7))
+        path += 7;
+
+    // TCP endpoints are left to the script
+    if(*path != '/')
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd == -1)
+        return -1;
+
+    struct timeval tv = {
+        .tv_sec = CGROUP_RESOLVER_TIMEOUT_MS / 1000,
+        .tv_usec = (CGROUP_RESOLVER_TIMEOUT_MS % 1000) * 1000,
+    };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strncpyz(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// GET the inspect json of a container
+// HTTP/1.0 is used, so that the response is not chunked and ends when the engine closes the connection
+static bool cgroup_resolver_inspect(struct cgroup_name_resolver *r, const char *container_id, BUFFER *wb) {
+    const char *path = getenv(r->env);
+    if(!path || !*path)
+        path = r->socket;
+
+    int fd = cgroup_resolver_connect(path);
+    if(fd == -1)
+        return false;
+
+    char request[256];
+    int len = snprintfz(request, sizeof(request), "GET /containers/%s/json HTTP/1.0\r\nHost: localhost\r\n\r\n", container_id);
+
+    if(write(fd, request, len) != len) {
+        close(fd);
+        return false;
+    }
+
+    buffer_flush(wb);
+    ssize_t bytes;
+    do {
+        buffer_need_bytes(wb, 4096);
+        bytes = read(fd, &wb->buffer[wb->len], wb->size - wb->len - 1);
+        if(bytes > 0)
+            wb->len += bytes;
+    } while(bytes > 0 && wb->len < CGROUP_RESOLVER_RESPONSE_MAX);
+
+    close(fd);
+    buffer_tostring(wb);
+
+    return bytes == 0 && !strncmp(buffer_tostring(wb), "HTTP/1.", 7) && !strncmp(&wb->buffer[8], " 200", 4);
+}
+
+static const char *cgroup_resolver_json_string(struct json_object *obj, const char *key) {
+    struct json_object *member;
+    if(!json_object_object_get_ex(obj, key, &member) || !json_object_is_type(member, json_type_string))
+        return NULL;
+
+    return json_object_get_string(member);
+}
+
+static const char *cgroup_resolver_env(struct json_object *env, const char *key) {
+    size_t key_len = strlen(key);
+    size_t entries = json_object_array_length(env);
+
+    for(size_t i = 0; i < entries ;i++) {
+        const char *s = json_object_get_string(json_object_array_get_idx(env, i));
+        if(s && !strncmp(s, key, key_len) && s[key_len] == '=' && s[key_len + 1])
+            return &s[key_len + 1];
+    }
+
+    return NULL;
+}
+
+// extract the name and the image of the container, the way parse_docker_like_inspect_output() of the script does
+static bool cgroup_resolver_parse_inspect(const char *json, char *dst, size_t dst_size) {
+    CLEAN_JSON_OBJECT *jobj = json_tokener_parse(json);
+    if(!jobj)
+        return false;
+
+    const char *image = NULL;
+    const char *nomad_namespace = NULL, *nomad_job = NULL, *nomad_task = NULL, *nomad_alloc = NULL;
+
+    struct json_object *config;
+    if(json_object_object_get_ex(jobj, "Config", &config)) {
+        image = cgroup_resolver_json_string(config, "Image");
+
+        struct json_object *env;
+        if(json_object_object_get_ex(config, "Env", &env) && json_object_is_type(env, json_type_array)) {
+            nomad_namespace = cgroup_resolver_env(env, "NOMAD_NAMESPACE");
+            nomad_job = cgroup_resolver_env(env, "NOMAD_JOB_NAME");
+            nomad_task = cgroup_resolver_env(env, "NOMAD_TASK_NAME");
+            nomad_alloc = cgroup_resolver_env(env, "NOMAD_SHORT_ALLOC_ID");
+        }
+    }
+
+    char name[CGROUP_RESOLVER_NAME_MAX + 1];
+    if(nomad_namespace && nomad_job && nomad_task && nomad_alloc)
+        snprintfz(name, sizeof(name), "%s-%s-%s-%s", nomad_namespace, nomad_job, nomad_task, nomad_alloc);
+    else {
+        const char *s = cgroup_resolver_json_string(jobj, "Name");
+        if(!s || !*s)
+            return false;
+
+        if(*s == '/')
+            s++;
+
+        strncpyz(name, s, CGROUP_RESOLVER_NAME_MAX);
+    }
+
+    if(!*name)
+        return false;
+
+    for(char *s = name; *s ;s++)
+        if(*s == ' ') *s = '_';
+
+    if(image && *image)
+        snprintfz(dst, dst_size, "%s image=\"%s\"", name, image);
+    else
+        strncpyz(dst, name, dst_size - 1);
+
+    return true;
+}
+
+// returns true when a resolver found the name of the cgroup
+// dst gets the same text the rename script would print
+bool cgroup_resolve_name(const char *id, char *dst, size_t dst_size) {
+    if(!cgroup_use_name_resolvers || strstr(id, "kubepods"))
+        return false;
+
+    for(struct cgroup_name_resolver *r = cgroup_name_resolvers; r->name ; r++) {
+        char container_id[r->id_length + 1];
+        if(!cgroup_resolver_container_id(r, id, container_id, sizeof(container_id)))
+            continue;
+
+        CLEAN_BUFFER *wb = buffer_create(4096, NULL);
+        if(!cgroup_resolver_inspect(r, container_id, wb)) {
+            netdata_log_debug(D_CGROUP, "cannot get %s container '%s' of cgroup '%s' from its API", r->name, container_id, id);
+            return false;
+        }
+
+        const char *body = strstr(buffer_tostring(wb), "\r\n\r\n");
+        if(!body || !cgroup_resolver_parse_inspect(body + 4, dst, dst_size))
+            return false;
+
+        netdata_log_debug(D_CGROUP, "%s container '%s' of cgroup '%s' resolved to '%s'", r->name, container_id, id, dst);
+        return true;
+    }
+
+    return false;
+}
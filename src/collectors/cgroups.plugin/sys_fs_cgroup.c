@@ -23,6 +23,12 @@ bool cgroup_enable_cpuacct = true;
 bool cgroup_enable_cpuacct_cpu_shares = false;
 
 int cgroup_check_for_new_every = 10;
+
+// with inotify, the periodic checks are needed only for cgroups waiting to be renamed,
+// and as a safety net, this often
+#define CGROUP_INOTIFY_CHECK_FOR_NEW_EVERY 60
+bool cgroup_use_inotify = true;
+bool cgroup_keep_files_open = true;
 int cgroup_update_every = 1;
 char *cgroup_cpuacct_base = NULL;
 char *cgroup_cpuset_base = NULL;
@@ -401,6 +407,10 @@ void read_cgroup_plugin_configuration() {
     snprintfz(filename, FILENAME_MAX, "%s/cgroup-name.sh", netdata_configured_primary_plugins_dir);
     cgroups_rename_script = config_get("plugin:cgroups", "script to get cgroup names", filename);
 
+    cgroup_use_name_resolvers = config_get_boolean("plugin:cgroups", "get container names from the engine api", cgroup_use_name_resolvers);
+    cgroup_use_inotify = config_get_boolean("plugin:cgroups", "use inotify to find new cgroups", cgroup_use_inotify);
+    cgroup_keep_files_open = config_get_boolean("plugin:cgroups", "keep cgroup files open", cgroup_keep_files_open);
+
     snprintfz(filename, FILENAME_MAX, "%s/cgroup-network", netdata_configured_primary_plugins_dir);
     cgroups_network_interface_script = config_get("plugin:cgroups", "script to get cgroup network interfaces", filename);
 
@@ -463,19 +473,76 @@ static unsigned long long calc_percentage(unsigned long long value, unsigned lon
 // ----------------------------------------------------------------------------
 // read values from /sys
 
-static inline void cgroup_read_cpuacct_stat(struct cpuacct_stat *cp) {
+// ----------------------------------------------------------------------------
+// cgroup files
+//
+// The statistics files of every cgroup are opened once and read with
+// positional reads on every iteration, into the single procfile buffer each
+// reader keeps, so that the cost of a cgroup is the reads, not opening and
+// closing a dozen files. The files are closed when the cgroup is removed, or
+// when a read fails (e.g. the cgroup was deleted), to be opened again.
+
+static inline void cgroup_file_close(int *fd) {
+    if(*fd != -1) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+void cgroup_files_close(struct cgroup *cg) {
+    for(size_t i = 0; i < CGROUP_FD_MAX ;i++)
+        cgroup_file_close(&cg->fds[i]);
+}
+
+static inline bool cgroup_file_open(int *fd, const char *filename) {
+    if(likely(*fd != -1))
+        return true;
+
+    *fd = open(filename, procfile_open_flags, 0666);
+    return *fd != -1;
+}
+
+// read and parse a statistics file of a cgroup into the reader's procfile
+static inline bool cgroup_procfile_read(procfile **ff, int *fd, const char *filename, const char *separators) {
+    if(unlikely(!cgroup_file_open(fd, filename)))
+        return false;
+
+    // the separators of the reader's procfile are set once, when it is created
+    *ff = procfile_readall_fd(*ff, *fd, (*ff) ? NULL : separators, CGROUP_PROCFILE_FLAG);
+
+    if(unlikely(!*ff || !cgroup_keep_files_open))
+        cgroup_file_close(fd);
+
+    return *ff != NULL;
+}
+
+// like read_single_number_file(), on a file kept open
+static inline int cgroup_read_single_number(int *fd, const char *filename, unsigned long long *result) {
+    char buffer[30 + 1];
+
+    *result = 0;
+
+    if(unlikely(!cgroup_file_open(fd, filename)))
+        return 1;
+
+    ssize_t r = pread(*fd, buffer, 30, 0);
+
+    if(unlikely(r <= 0 || !cgroup_keep_files_open))
+        cgroup_file_close(fd);
+
+    if(unlikely(r <= 0))
+        return 2;
+
+    buffer[r] = '\0';
+    *result = str2ull(buffer, NULL);
+    return 0;
+}
+
+static inline void cgroup_read_cpuacct_stat(struct cpuacct_stat *cp, int *fd) {
     static procfile *ff = NULL;
 
     if(likely(cp->filename)) {
-        ff = procfile_reopen(ff, cp->filename, NULL, CGROUP_PROCFILE_FLAG);
-        if(unlikely(!ff)) {
-            cp->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
-
-        ff = procfile_readall(ff);
-        if(unlikely(!ff)) {
+        if(unlikely(!cgroup_procfile_read(&ff, fd, cp->filename, NULL))) {
             cp->updated = 0;
             cgroups_check = 1;
             return;
@@ -504,21 +571,13 @@ static inline void cgroup_read_cpuacct_stat(struct cpuacct_stat *cp) {
     }
 }
 
-static inline void cgroup_read_cpuacct_cpu_stat(struct cpuacct_cpu_throttling *cp) {
+static inline void cgroup_read_cpuacct_cpu_stat(struct cpuacct_cpu_throttling *cp, int *fd) {
     if (unlikely(!cp->filename)) {
         return;
     }
 
     static procfile *ff = NULL;
-    ff = procfile_reopen(ff, cp->filename, NULL, CGROUP_PROCFILE_FLAG);
-    if (unlikely(!ff)) {
-        cp->updated = 0;
-        cgroups_check = 1;
-        return;
-    }
-
-    ff = procfile_readall(ff);
-    if (unlikely(!ff)) {
+    if (unlikely(!cgroup_procfile_read(&ff, fd, cp->filename, NULL))) {
         cp->updated = 0;
         cgroups_check = 1;
         return;
@@ -552,21 +611,13 @@ static inline void cgroup_read_cpuacct_cpu_stat(struct cpuacct_cpu_throttling *c
     cp->updated = 1;
 }
 
-static inline void cgroup2_read_cpuacct_cpu_stat(struct cpuacct_stat *cp, struct cpuacct_cpu_throttling *cpt) {
+static inline void cgroup2_read_cpuacct_cpu_stat(struct cpuacct_stat *cp, struct cpuacct_cpu_throttling *cpt, int *fd) {
     static procfile *ff = NULL;
     if (unlikely(!cp->filename)) {
         return;
     }
 
-    ff = procfile_reopen(ff, cp->filename, NULL, CGROUP_PROCFILE_FLAG);
-    if (unlikely(!ff)) {
-        cp->updated = 0;
-        cgroups_check = 1;
-        return;
-    }
-
-    ff = procfile_readall(ff);
-    if (unlikely(!ff)) {
+    if (unlikely(!cgroup_procfile_read(&ff, fd, cp->filename, NULL))) {
         cp->updated = 0;
         cgroups_check = 1;
         return;
@@ -606,12 +657,12 @@ static inline void cgroup2_read_cpuacct_cpu_stat(struct cpuacct_stat *cp, struct
     cpt->updated = 1;
 }
 
-static inline void cgroup_read_cpuacct_cpu_shares(struct cpuacct_cpu_shares *cp) {
+static inline void cgroup_read_cpuacct_cpu_shares(struct cpuacct_cpu_shares *cp, int *fd) {
     if (unlikely(!cp->filename)) {
         return;
     }
 
-    if (unlikely(read_single_number_file(cp->filename, &cp->shares))) {
+    if (unlikely(cgroup_read_single_number(fd, cp->filename, &cp->shares))) {
         cp->updated = 0;
         cgroups_check = 1;
         return;
@@ -620,19 +671,11 @@ static inline void cgroup_read_cpuacct_cpu_shares(struct cpuacct_cpu_shares *cp)
     cp->updated = 1;
 }
 
-static inline void cgroup_read_cpuacct_usage(struct cpuacct_usage *ca) {
+static inline void cgroup_read_cpuacct_usage(struct cpuacct_usage *ca, int *fd) {
     static procfile *ff = NULL;
 
     if(likely(ca->filename)) {
-        ff = procfile_reopen(ff, ca->filename, NULL, CGROUP_PROCFILE_FLAG);
-        if(unlikely(!ff)) {
-            ca->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
-
-        ff = procfile_readall(ff);
-        if(unlikely(!ff)) {
+        if(unlikely(!cgroup_procfile_read(&ff, fd, ca->filename, NULL))) {
             ca->updated = 0;
             cgroups_check = 1;
             return;
@@ -674,19 +717,11 @@ static inline void cgroup_read_cpuacct_usage(struct cpuacct_usage *ca) {
     }
 }
 
-static inline void cgroup_read_blkio(struct blkio *io) {
+static inline void cgroup_read_blkio(struct blkio *io, int *fd) {
     if (likely(io->filename)) {
         static procfile *ff = NULL;
 
-        ff = procfile_reopen(ff, io->filename, NULL, CGROUP_PROCFILE_FLAG);
-        if (unlikely(!ff)) {
-            io->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
-
-        ff = procfile_readall(ff);
-        if (unlikely(!ff)) {
+        if (unlikely(!cgroup_procfile_read(&ff, fd, io->filename, NULL))) {
             io->updated = 0;
             cgroups_check = 1;
             return;
@@ -717,19 +752,11 @@ static inline void cgroup_read_blkio(struct blkio *io) {
     }
 }
 
-static inline void cgroup2_read_blkio(struct blkio *io, unsigned int word_offset) {
+static inline void cgroup2_read_blkio(struct blkio *io, unsigned int word_offset, int *fd) {
     if (likely(io->filename)) {
         static procfile *ff = NULL;
 
-        ff = procfile_reopen(ff, io->filename, NULL, CGROUP_PROCFILE_FLAG);
-        if (unlikely(!ff)) {
-            io->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
-
-        ff = procfile_readall(ff);
-        if (unlikely(!ff)) {
+        if (unlikely(!cgroup_procfile_read(&ff, fd, io->filename, NULL))) {
             io->updated = 0;
             cgroups_check = 1;
             return;
@@ -755,19 +782,11 @@ static inline void cgroup2_read_blkio(struct blkio *io, unsigned int word_offset
     }
 }
 
-static inline void cgroup2_read_pressure(struct pressure *res) {
+static inline void cgroup2_read_pressure(struct pressure *res, int *fd) {
     static procfile *ff = NULL;
 
     if (likely(res->filename)) {
-        ff = procfile_reopen(ff, res->filename, " =", CGROUP_PROCFILE_FLAG);
-        if (unlikely(!ff)) {
-            res->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
-
-        ff = procfile_readall(ff);
-        if (unlikely(!ff)) {
+        if (unlikely(!cgroup_procfile_read(&ff, fd, res->filename, " ="))) {
             res->updated = 0;
             cgroups_check = 1;
             return;
@@ -806,19 +825,11 @@ static inline void cgroup2_read_pressure(struct pressure *res) {
     }
 }
 
-static inline void cgroup_read_memory(struct memory *mem, char parent_cg_is_unified) {
+static inline void cgroup_read_memory(struct memory *mem, char parent_cg_is_unified, int *fds) {
     static procfile *ff = NULL;
 
     if(likely(mem->filename_detailed)) {
-        ff = procfile_reopen(ff, mem->filename_detailed, NULL, CGROUP_PROCFILE_FLAG);
-        if(unlikely(!ff)) {
-            mem->updated_detailed = 0;
-            cgroups_check = 1;
-            goto memory_next;
-        }
-
-        ff = procfile_readall(ff);
-        if(unlikely(!ff)) {
+        if(unlikely(!cgroup_procfile_read(&ff, &fds[CGROUP_FD_MEMORY_STAT], mem->filename_detailed, NULL))) {
             mem->updated_detailed = 0;
             cgroups_check = 1;
             goto memory_next;
@@ -885,7 +896,7 @@ static inline void cgroup_read_memory(struct memory *mem, char parent_cg_is_unif
 memory_next:
 
     if (likely(mem->filename_usage_in_bytes)) {
-        mem->updated_usage_in_bytes = !read_single_number_file(mem->filename_usage_in_bytes, &mem->usage_in_bytes);
+        mem->updated_usage_in_bytes = !cgroup_read_single_number(&fds[CGROUP_FD_MEMORY_USAGE], mem->filename_usage_in_bytes, &mem->usage_in_bytes);
     }
 
     if (likely(mem->updated_usage_in_bytes && mem->updated_detailed)) {
@@ -895,49 +906,49 @@ memory_next:
 
     if (likely(mem->filename_msw_usage_in_bytes)) {
         mem->updated_msw_usage_in_bytes =
-            !read_single_number_file(mem->filename_msw_usage_in_bytes, &mem->msw_usage_in_bytes);
+            !cgroup_read_single_number(&fds[CGROUP_FD_MEMORY_MSW_USAGE], mem->filename_msw_usage_in_bytes, &mem->msw_usage_in_bytes);
     }
 
     if (likely(mem->filename_failcnt)) {
-        mem->updated_failcnt = !read_single_number_file(mem->filename_failcnt, &mem->failcnt);
+        mem->updated_failcnt = !cgroup_read_single_number(&fds[CGROUP_FD_MEMORY_FAILCNT], mem->filename_failcnt, &mem->failcnt);
     }
 }
 
-static void cgroup_read_pids_current(struct pids *pids) {
+static void cgroup_read_pids_current(struct pids *pids, int *fd) {
     pids->updated = 0;
 
     if (unlikely(!pids->filename))
         return;
 
-    pids->updated = !read_single_number_file(pids->filename, &pids->pids_current);
+    pids->updated = !cgroup_read_single_number(fd, pids->filename, &pids->pids_current);
 }
 
 static inline void read_cgroup(struct cgroup *cg) {
     netdata_log_debug(D_CGROUP, "reading metrics for cgroups '%s'", cg->id);
     if (!(cg->options & CGROUP_OPTIONS_IS_UNIFIED)) {
-        cgroup_read_cpuacct_stat(&cg->cpuacct_stat);
-        cgroup_read_cpuacct_usage(&cg->cpuacct_usage);
-        cgroup_read_cpuacct_cpu_stat(&cg->cpuacct_cpu_throttling);
-        cgroup_read_cpuacct_cpu_shares(&cg->cpuacct_cpu_shares);
-        cgroup_read_memory(&cg->memory, 0);
-        cgroup_read_blkio(&cg->io_service_bytes);
-        cgroup_read_blkio(&cg->io_serviced);
-        cgroup_read_blkio(&cg->throttle_io_service_bytes);
-        cgroup_read_blkio(&cg->throttle_io_serviced);
-        cgroup_read_blkio(&cg->io_merged);
-        cgroup_read_blkio(&cg->io_queued);
-        cgroup_read_pids_current(&cg->pids_current);
+        cgroup_read_cpuacct_stat(&cg->cpuacct_stat, &cg->fds[CGROUP_FD_CPUACCT_STAT]);
+        cgroup_read_cpuacct_usage(&cg->cpuacct_usage, &cg->fds[CGROUP_FD_CPUACCT_USAGE]);
+        cgroup_read_cpuacct_cpu_stat(&cg->cpuacct_cpu_throttling, &cg->fds[CGROUP_FD_CPU_STAT]);
+        cgroup_read_cpuacct_cpu_shares(&cg->cpuacct_cpu_shares, &cg->fds[CGROUP_FD_CPU_SHARES]);
+        cgroup_read_memory(&cg->memory, 0, cg->fds);
+        cgroup_read_blkio(&cg->io_service_bytes, &cg->fds[CGROUP_FD_IO_SERVICE_BYTES]);
+        cgroup_read_blkio(&cg->io_serviced, &cg->fds[CGROUP_FD_IO_SERVICED]);
+        cgroup_read_blkio(&cg->throttle_io_service_bytes, &cg->fds[CGROUP_FD_THROTTLE_IO_SERVICE_BYTES]);
+        cgroup_read_blkio(&cg->throttle_io_serviced, &cg->fds[CGROUP_FD_THROTTLE_IO_SERVICED]);
+        cgroup_read_blkio(&cg->io_merged, &cg->fds[CGROUP_FD_IO_MERGED]);
+        cgroup_read_blkio(&cg->io_queued, &cg->fds[CGROUP_FD_IO_QUEUED]);
+        cgroup_read_pids_current(&cg->pids_current, &cg->fds[CGROUP_FD_PIDS_CURRENT]);
     } else {
-        cgroup2_read_blkio(&cg->io_service_bytes, 0);
-        cgroup2_read_blkio(&cg->io_serviced, 4);
-        cgroup2_read_cpuacct_cpu_stat(&cg->cpuacct_stat, &cg->cpuacct_cpu_throttling);
-        cgroup_read_cpuacct_cpu_shares(&cg->cpuacct_cpu_shares);
-        cgroup2_read_pressure(&cg->cpu_pressure);
-        cgroup2_read_pressure(&cg->io_pressure);
-        cgroup2_read_pressure(&cg->memory_pressure);
-        cgroup2_read_pressure(&cg->irq_pressure);
-        cgroup_read_memory(&cg->memory, 1);
-        cgroup_read_pids_current(&cg->pids_current);
+        cgroup2_read_blkio(&cg->io_service_bytes, 0, &cg->fds[CGROUP_FD_IO_SERVICE_BYTES]);
+        cgroup2_read_blkio(&cg->io_serviced, 4, &cg->fds[CGROUP_FD_IO_SERVICED]);
+        cgroup2_read_cpuacct_cpu_stat(&cg->cpuacct_stat, &cg->cpuacct_cpu_throttling, &cg->fds[CGROUP_FD_CPUACCT_STAT]);
+        cgroup_read_cpuacct_cpu_shares(&cg->cpuacct_cpu_shares, &cg->fds[CGROUP_FD_CPU_SHARES]);
+        cgroup2_read_pressure(&cg->cpu_pressure, &cg->fds[CGROUP_FD_CPU_PRESSURE]);
+        cgroup2_read_pressure(&cg->io_pressure, &cg->fds[CGROUP_FD_IO_PRESSURE]);
+        cgroup2_read_pressure(&cg->memory_pressure, &cg->fds[CGROUP_FD_MEMORY_PRESSURE]);
+        cgroup2_read_pressure(&cg->irq_pressure, &cg->fds[CGROUP_FD_IRQ_PRESSURE]);
+        cgroup_read_memory(&cg->memory, 1, cg->fds);
+        cgroup_read_pids_current(&cg->pids_current, &cg->fds[CGROUP_FD_PIDS_CURRENT]);
     }
 }
 
@@ -1384,6 +1395,8 @@ void *cgroups_main(void *ptr) {
     }
 
     discovery_thread.exited = 0;
+    discovery_thread.pending = true; // run the first discovery on schedule
+    cgroup_discovery_inotify_init();
 
     if (uv_mutex_init(&discovery_thread.mutex)) {
         collector_error("CGROUP: cannot initialize mutex for discovery thread");
@@ -1418,6 +1431,7 @@ void *cgroups_main(void *ptr) {
     heartbeat_init(&hb);
     usec_t step = cgroup_update_every * USEC_PER_SEC;
     usec_t find_every = cgroup_check_for_new_every * USEC_PER_SEC, find_dt = 0;
+    usec_t inotify_find_every = MAX(cgroup_check_for_new_every, CGROUP_INOTIFY_CHECK_FOR_NEW_EVERY) * USEC_PER_SEC;
 
     while(service_running(SERVICE_COLLECTORS)) {
         worker_is_idle();
@@ -1428,7 +1442,19 @@ void *cgroups_main(void *ptr) {
             break;
 
         find_dt += hb_dt;
-        if (unlikely(find_dt >= find_every || (!is_inside_k8s && cgroups_check))) {
+
+        bool find = false;
+        if (discovery_thread.inotify_fd != -1) {
+            // new and removed cgroups are found immediately,
+            // the periodic checks are needed only for the cgroups still pending
+            find = cgroup_discovery_inotify_changed() ||
+                   (find_dt >= find_every && __atomic_load_n(&discovery_thread.pending, __ATOMIC_RELAXED)) ||
+                   find_dt >= inotify_find_every;
+        }
+        else
+            find = find_dt >= find_every;
+
+        if (unlikely(find || (!is_inside_k8s && cgroups_check))) {
             uv_mutex_lock(&discovery_thread.mutex);
             uv_cond_signal(&discovery_thread.cond_var);
             uv_mutex_unlock(&discovery_thread.mutex);
@@ -44,6 +44,10 @@ struct mount_point_metadata {
     bool shown_error;
     bool updated;
     bool slow;
+    bool stuck;                 // a statvfs() of a previous iteration has not returned yet
+
+    usec_t backoff_ut;          // slow mount points that time out are not queried for this long
+    usec_t backoff_until_ut;
 
     STRING *filesystem;
     STRING *mountroot;
@@ -295,7 +299,306 @@ static void calculate_values_and_show_charts(
         m->collected++;
 }
 
-static inline void do_disk_space_stats(struct mountinfo *mi, int update_every) {
+// ----------------------------------------------------------------------------
+// statvfs() worker pool
+//
+// statvfs() may block for a long time on network or failing filesystems.
+// The collectors queue one job per mount point to a small pool of threads,
+// so that all mount points are queried in parallel, and wait for the results
+// up to a deadline. Jobs not finished by then are abandoned: their mount
+// points are not queried again until their statvfs() returns, and the pool
+// starts more threads to replace the ones that are stuck.
+
+#define DISKSPACE_STATVFS_WORKERS 4
+#define DISKSPACE_STATVFS_WORKERS_MAX 16
+#define DISKSPACE_BACKOFF_MAX_USEC (600 * USEC_PER_SEC)
+
+struct statvfs_batch;
+
+struct statvfs_job {
+    const DICTIONARY_ITEM *item;    // keeps the mount point metadata acquired
+    struct mount_point_metadata *m;
+
+    char *path;                     // owned by the job, the worker may still use it after the collector gave up
+    struct basic_mountinfo bmi;     // borrowed from the collector, only for rendering the charts
+
+    struct statvfs buff_statvfs;
+    int ret;
+    int err;
+    usec_t duration_ut;
+
+    bool running;
+    bool done;
+    bool abandoned;
+
+    struct statvfs_batch *batch;
+    struct statvfs_job *next;       // in the queue, or in the list of abandoned jobs to be freed
+    struct statvfs_job *batch_next;
+};
+
+struct statvfs_batch {
+    struct statvfs_job *jobs;
+    size_t pending;
+};
+
+static struct {
+    netdata_mutex_t mutex;
+    pthread_cond_t queued;
+    pthread_cond_t finished;
+
+    struct statvfs_job *head, *tail;
+    struct statvfs_job *abandoned;  // finished abandoned jobs, freed by the collectors
+
+    size_t workers;
+    size_t stuck;                   // workers running abandoned jobs
+    bool exiting;
+} statvfs_pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .queued = PTHREAD_COND_INITIALIZER,
+    .finished = PTHREAD_COND_INITIALIZER,
+};
+
+static void *diskspace_statvfs_worker(void *ptr __maybe_unused) {
+    netdata_mutex_lock(&statvfs_pool.mutex);
+
+    while(!statvfs_pool.exiting) {
+        struct statvfs_job *j = statvfs_pool.head;
+        if(!j) {
+            pthread_cond_wait(&statvfs_pool.queued, &statvfs_pool.mutex);
+            continue;
+        }
+
+        statvfs_pool.head = j->next;
+        if(!statvfs_pool.head)
+            statvfs_pool.tail = NULL;
+
+        if(j->abandoned) {
+            // the collector gave up before we started it
+            j->next = statvfs_pool.abandoned;
+            statvfs_pool.abandoned = j;
+            continue;
+        }
+
+        j->running = true;
+        netdata_mutex_unlock(&statvfs_pool.mutex);
+
+        usec_t start_ut = now_monotonic_high_precision_usec();
+        int ret = statvfs(j->path, &j->buff_statvfs);
+        int err = errno;
+        usec_t duration_ut = now_monotonic_high_precision_usec() - start_ut;
+
+        netdata_mutex_lock(&statvfs_pool.mutex);
+        j->ret = ret;
+        j->err = err;
+        j->duration_ut = duration_ut;
+        j->running = false;
+        j->done = true;
+
+        if(!j->abandoned) {
+            j->batch->pending--;
+            pthread_cond_broadcast(&statvfs_pool.finished);
+            continue;
+        }
+
+        j->next = statvfs_pool.abandoned;
+        statvfs_pool.abandoned = j;
+        statvfs_pool.stuck--;
+
+        // we were started to replace a stuck worker that is not stuck anymore
+        if(statvfs_pool.workers - statvfs_pool.stuck > DISKSPACE_STATVFS_WORKERS) {
+            statvfs_pool.workers--;
+            break;
+        }
+    }
+
+    netdata_mutex_unlock(&statvfs_pool.mutex);
+    return NULL;
+}
+
+// call with the pool mutex locked
+static void diskspace_statvfs_spawn_worker(void) {
+    statvfs_pool.workers++;
+    nd_thread_create("P[diskspace stat]", NETDATA_THREAD_OPTION_DONT_LOG, diskspace_statvfs_worker, NULL);
+}
+
+static void diskspace_statvfs_pool_init(void) {
+    netdata_mutex_lock(&statvfs_pool.mutex);
+    for(size_t i = 0; i < DISKSPACE_STATVFS_WORKERS ;i++)
+        diskspace_statvfs_spawn_worker();
+    netdata_mutex_unlock(&statvfs_pool.mutex);
+}
+
+static void diskspace_statvfs_pool_stop(void) {
+    // the workers are detached, the ones stuck in statvfs() exit when it returns
+    netdata_mutex_lock(&statvfs_pool.mutex);
+    statvfs_pool.exiting = true;
+    pthread_cond_broadcast(&statvfs_pool.queued);
+    netdata_mutex_unlock(&statvfs_pool.mutex);
+}
+
+static void statvfs_job_free(struct statvfs_job *j) {
+    dictionary_acquired_item_release(dict_mountpoints, j->item);
+    freez(j->path);
+    freez(j);
+}
+
+// free the abandoned jobs that have finished, so that their mount points are queried again
+static void diskspace_statvfs_free_abandoned(void) {
+    netdata_mutex_lock(&statvfs_pool.mutex);
+    struct statvfs_job *j = statvfs_pool.abandoned;
+    statvfs_pool.abandoned = NULL;
+    for(struct statvfs_job *t = j; t ; t = t->next)
+        t->m->stuck = false;
+    netdata_mutex_unlock(&statvfs_pool.mutex);
+
+    while(j) {
+        struct statvfs_job *next = j->next;
+        statvfs_job_free(j);
+        j = next;
+    }
+}
+
+// returns false when the previous statvfs() of this mount point has not returned yet
+static bool diskspace_statvfs_submit(struct statvfs_batch *b, const DICTIONARY_ITEM *item, struct mount_point_metadata *m, const char *path, struct basic_mountinfo *bmi) {
+    netdata_mutex_lock(&statvfs_pool.mutex);
+
+    if(m->stuck) {
+        netdata_mutex_unlock(&statvfs_pool.mutex);
+        return false;
+    }
+
+    struct statvfs_job *j = callocz(1, sizeof(*j));
+    j->item = dictionary_acquired_item_dup(dict_mountpoints, item);
+    j->m = m;
+    j->path = strdupz(path);
+    j->bmi = *bmi;
+    j->bmi.next = NULL;
+
+    j->batch = b;
+    j->batch_next = b->jobs;
+    b->jobs = j;
+    b->pending++;
+
+    if(statvfs_pool.tail)
+        statvfs_pool.tail->next = j;
+    else
+        statvfs_pool.head = j;
+    statvfs_pool.tail = j;
+
+    pthread_cond_signal(&statvfs_pool.queued);
+    netdata_mutex_unlock(&statvfs_pool.mutex);
+    return true;
+}
+
+// call with the pool mutex locked
+static void diskspace_statvfs_timed_out(struct statvfs_job *j, bool slow_worker, int update_every) {
+    struct mount_point_metadata *m = j->m;
+
+    if(j->running) {
+        statvfs_pool.stuck++;
+
+        if(statvfs_pool.workers - statvfs_pool.stuck < DISKSPACE_STATVFS_WORKERS &&
+           statvfs_pool.workers < DISKSPACE_STATVFS_WORKERS_MAX)
+            diskspace_statvfs_spawn_worker();
+    }
+
+    j->abandoned = true;
+    m->stuck = true;
+
+    if(!slow_worker)
+        // let the slow worker collect it from now on
+        m->slow = true;
+    else {
+        // query it less frequently, every time it times out
+        m->backoff_ut = m->backoff_ut ? MIN(m->backoff_ut * 2, DISKSPACE_BACKOFF_MAX_USEC) : (usec_t)update_every * USEC_PER_SEC;
+        m->backoff_until_ut = now_monotonic_usec() + m->backoff_ut;
+    }
+
+    if(!m->shown_error && service_running(SERVICE_COLLECTORS)) {
+        collector_error("DISKSPACE: statvfs() of mount point '%s' (disk '%s', filesystem '%s', root '%s') did not return in time",
+                        j->path,
+                        j->bmi.persistent_id,
+                        j->bmi.filesystem?j->bmi.filesystem:"",
+                        j->bmi.root?j->bmi.root:"");
+        m->shown_error = true;
+    }
+}
+
+// wait for the jobs of the batch to finish, up to timeout_ut, abandoning the ones that did not
+static void diskspace_statvfs_wait(struct statvfs_batch *b, usec_t timeout_ut, bool slow_worker, int update_every) {
+    usec_t deadline_ut = now_monotonic_usec() + timeout_ut;
+
+    netdata_mutex_lock(&statvfs_pool.mutex);
+
+    while(b->pending && now_monotonic_usec() < deadline_ut && service_running(SERVICE_COLLECTORS)) {
+        struct timespec tp;
+        clock_gettime(CLOCK_REALTIME, &tp);
+        tp.tv_nsec += 10 * NSEC_PER_MSEC;
+        if(tp.tv_nsec > (long)(1 * NSEC_PER_SEC)) {
+            tp.tv_sec++;
+            tp.tv_nsec -= 1 * NSEC_PER_SEC;
+        }
+
+        // the mutex is unlocked within pthread_cond_timedwait()
+        pthread_cond_timedwait(&statvfs_pool.finished, &statvfs_pool.mutex, &tp);
+    }
+
+    // keep only the finished jobs in the batch; the abandoned ones
+    // are handed to the workers and may be freed as soon as we unlock
+    struct statvfs_job *done = NULL, *j, *next;
+    for(j = b->jobs; j ; j = next) {
+        next = j->batch_next;
+
+        if(j->done) {
+            j->batch_next = done;
+            done = j;
+        }
+        else
+            diskspace_statvfs_timed_out(j, slow_worker, update_every);
+    }
+    b->jobs = done;
+    b->pending = 0;
+
+    netdata_mutex_unlock(&statvfs_pool.mutex);
+}
+
+// render the charts of the finished jobs of the batch and free them
+static void diskspace_statvfs_collect(struct statvfs_batch *b, int update_every, usec_t slow_timeout) {
+    struct statvfs_job *j, *next;
+    for(j = b->jobs; j ; j = next) {
+        next = j->batch_next;
+        struct mount_point_metadata *m = j->m;
+
+        if(j->ret < 0) {
+            if(!m->shown_error) {
+                errno = j->err;
+                collector_error("DISKSPACE: failed to statvfs() mount point '%s' (disk '%s', filesystem '%s', root '%s')"
+                                , j->path
+                                , j->bmi.persistent_id
+                                , j->bmi.filesystem?j->bmi.filesystem:""
+                                , j->bmi.root?j->bmi.root:""
+                                );
+                m->shown_error = true;
+            }
+        }
+        else {
+            if(slow_timeout && j->duration_ut > slow_timeout)
+                m->slow = true;
+
+            m->shown_error = false;
+            m->backoff_ut = 0;
+            m->backoff_until_ut = 0;
+
+            calculate_values_and_show_charts(&j->bmi, m, &j->buff_statvfs, update_every);
+        }
+
+        statvfs_job_free(j);
+    }
+
+    b->jobs = NULL;
+}
+
+static inline void do_disk_space_stats(struct statvfs_batch *batch, struct mountinfo *mi, int update_every) {
     const char *disk = mi->persistent_id;
 
     static SIMPLE_PATTERN *excluded_mountpoints = NULL;
@@ -451,64 +754,31 @@ static inline void do_disk_space_stats(struct mountinfo *mi, int update_every) {
         goto cleanup;
     }
 
-    usec_t start_time = now_monotonic_high_precision_usec();
-    struct statvfs buff_statvfs;
-
-    if (statvfs(mi->mount_point_stat_path, &buff_statvfs) < 0) {
-        if(!m->shown_error) {
-            collector_error("DISKSPACE: failed to statvfs() mount point '%s' (disk '%s', filesystem '%s', root '%s')"
-                            , mi->mount_point_stat_path
-                            , disk
-                            , mi->filesystem?mi->filesystem:""
-                            , mi->root?mi->root:""
-                            );
-            m->shown_error = true;
-        }
-        goto cleanup;
-    }
-
-    if ((now_monotonic_high_precision_usec() - start_time) > slow_timeout)
-        m->slow = true;
-
-    m->shown_error = false;
-
-    struct basic_mountinfo bmi;
-    bmi.mount_point = mi->mount_point;
-    bmi.persistent_id = mi->persistent_id;
-    bmi.filesystem = mi->filesystem;
-    bmi.root = mi->root;
+    // mountinfo is not reloaded before the batch is collected, so the job can borrow its strings
+    struct basic_mountinfo bmi = {
+        .persistent_id = mi->persistent_id,
+        .root = mi->root,
+        .mount_point_stat_path = mi->mount_point_stat_path,
+        .mount_point = mi->mount_point,
+        .filesystem = mi->filesystem,
+    };
 
-    calculate_values_and_show_charts(&bmi, m, &buff_statvfs, update_every);
+    diskspace_statvfs_submit(batch, item, m, mi->mount_point_stat_path, &bmi);
 
 cleanup:
     dictionary_acquired_item_release(dict_mountpoints, item);
 }
 
-static inline void do_slow_disk_space_stats(struct basic_mountinfo *mi, int update_every) {
+static inline void do_slow_disk_space_stats(struct statvfs_batch *batch, struct basic_mountinfo *mi) {
     const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(dict_mountpoints, mi->mount_point);
     if(!item) return;
 
     struct mount_point_metadata *m = dictionary_acquired_item_value(item);
     m->updated = true;
 
-    struct statvfs buff_statvfs;
-    if (statvfs(mi->mount_point_stat_path, &buff_statvfs) < 0) {
-        if(!m->shown_error) {
-            collector_error("DISKSPACE: failed to statvfs() mount point '%s' (disk '%s', filesystem '%s', root '%s')"
-                            , mi->mount_point_stat_path
-                            , mi->persistent_id
-                            , mi->filesystem?mi->filesystem:""
-                            , mi->root?mi->root:""
-                           );
-            m->shown_error = true;
-        }
-        goto cleanup;
-    }
-    m->shown_error = false;
+    if(m->backoff_until_ut <= now_monotonic_usec())
+        diskspace_statvfs_submit(batch, item, m, mi->mount_point_stat_path, mi);
 
-    calculate_values_and_show_charts(mi, m, &buff_statvfs, update_every);
-
-cleanup:
     dictionary_acquired_item_release(dict_mountpoints, item);
 }
 
@@ -574,12 +844,15 @@ void *diskspace_slow_worker(void *ptr)
         slow_mountinfo_tmp_root = NULL;
         netdata_mutex_unlock(&slow_mountinfo_mutex);
 
+        diskspace_statvfs_free_abandoned();
+
+        struct statvfs_batch batch = { 0 };
         struct basic_mountinfo *bmi;
-        for(bmi = slow_mountinfo_root; bmi; bmi = bmi->next) {
-            do_slow_disk_space_stats(bmi, slow_update_every);
-            
-            if(unlikely(!service_running(SERVICE_COLLECTORS))) break;
-        }
+        for(bmi = slow_mountinfo_root; bmi; bmi = bmi->next)
+            do_slow_disk_space_stats(&batch, bmi);
+
+        diskspace_statvfs_wait(&batch, step / 2, true, slow_update_every);
+        diskspace_statvfs_collect(&batch, slow_update_every, 0);
 
         if(unlikely(!service_running(SERVICE_COLLECTORS))) break;
 
@@ -616,6 +889,8 @@ static void diskspace_main_cleanup(void *pptr) {
     if (diskspace_slow_thread)
         nd_thread_join(diskspace_slow_thread);
 
+    diskspace_statvfs_pool_stop();
+
     free_basic_mountinfo_list(slow_mountinfo_tmp_root);
 
     static_thread->enabled = NETDATA_MAIN_THREAD_EXITED;
@@ -866,6 +1141,7 @@ void *diskspace_main(void *ptr) {
         check_for_new_mountpoints_every = update_every;
 
     netdata_mutex_init(&slow_mountinfo_mutex);
+    diskspace_statvfs_pool_init();
 
     struct slow_worker_data slow_worker_data = { .update_every = update_every };
 
@@ -893,10 +1169,13 @@ void *diskspace_main(void *ptr) {
         // --------------------------------------------------------------------------
         // disk space metrics
 
+        diskspace_statvfs_free_abandoned();
+
         netdata_mutex_lock(&slow_mountinfo_mutex);
         free_basic_mountinfo_list(slow_mountinfo_tmp_root);
         slow_mountinfo_tmp_root = NULL;
 
+        struct statvfs_batch batch = { 0 };
         struct mountinfo *mi;
         for(mi = disk_mountinfo_root; mi; mi = mi->next) {
             if(unlikely(mi->flags & (MOUNTINFO_IS_DUMMY | MOUNTINFO_IS_BIND)))
@@ -908,11 +1187,15 @@ void *diskspace_main(void *ptr) {
                 continue;
 
             worker_is_busy(WORKER_JOB_MOUNTPOINT);
-            do_disk_space_stats(mi, update_every);
+            do_disk_space_stats(&batch, mi, update_every);
             if(unlikely(!service_running(SERVICE_COLLECTORS))) break;
         }
         netdata_mutex_unlock(&slow_mountinfo_mutex);
 
+        // all the mount points are queried in parallel, they have half the interval to respond
+        diskspace_statvfs_wait(&batch, step / 2, false, update_every);
+        diskspace_statvfs_collect(&batch, update_every, MAX_STAT_USEC * update_every);
+
         if(unlikely(!service_running(SERVICE_COLLECTORS))) break;
 
         if(dict_mountpoints) {
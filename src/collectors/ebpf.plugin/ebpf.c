@@ -1465,6 +1465,192 @@ void ebpf_read_global_table_stats(netdata_idx_t *stats,
     }
 }
 
+/*****************************************************************
+ *
+ *  FUNCTIONS TO READ PID HASH TABLES
+ *
+ *****************************************************************/
+
+/**
+ * Map Batch Init
+ *
+ * Allocate the buffers used to read a hash table in batches. Per core tables store one value for every
+ * possible processor, so the buffers are sized with them.
+ *
+ * @param b              the structure to initialize
+ * @param key_size       the size of the table keys
+ * @param value_size     the size of the table values
+ * @param maps_per_core  is the table per core?
+ */
+void ebpf_map_batch_init(ebpf_map_batch_t *b, uint32_t key_size, size_t value_size, int maps_per_core)
+{
+    memset(b, 0, sizeof(*b));
+    b->fd = -1;
+    b->key_size = key_size;
+    b->value_size = value_size;
+    if (maps_per_core) {
+        int cpus = libbpf_num_possible_cpus();
+        b->value_size *= (cpus > ebpf_nprocs) ? cpus : ebpf_nprocs;
+    }
+
+    size_t entries = NETDATA_EBPF_MAP_BATCH_BYTES / b->value_size;
+    if (entries > NETDATA_EBPF_MAP_BATCH_MAX_ENTRIES)
+        entries = NETDATA_EBPF_MAP_BATCH_MAX_ENTRIES;
+    else if (!entries)
+        entries = 1;
+
+    b->entries = (uint32_t)entries;
+    b->keys = mallocz(b->entries * (size_t)b->key_size);
+    b->values = mallocz(b->entries * b->value_size);
+
+    // hash tables keep the position as a bucket index, arrays as a key
+    b->batch = callocz(1, MAX(b->key_size, sizeof(uint64_t)));
+}
+
+/**
+ * Map Batch Free
+ *
+ * @param b the structure with the buffers
+ */
+void ebpf_map_batch_free(ebpf_map_batch_t *b)
+{
+    freez(b->keys);
+    freez(b->values);
+    freez(b->batch);
+    memset(b, 0, sizeof(*b));
+    b->fd = -1;
+}
+
+/**
+ * Map Batch Start
+ *
+ * Start reading a table from its first entry.
+ *
+ * @param b   the structure with the buffers
+ * @param fd  the table
+ */
+void ebpf_map_batch_start(ebpf_map_batch_t *b, int fd)
+{
+    b->fd = fd;
+    b->count = b->position = 0;
+    b->first = true;
+    b->finished = (fd == -1);
+    memset(b->batch, 0, MAX(b->key_size, sizeof(uint64_t)));
+}
+
+/**
+ * Map Batch Fill Key by Key
+ *
+ * Read the next entry of a table on kernels that cannot read it in batches (before 5.6). The next key is
+ * found before the entry is given to the caller, because the caller can remove the entry from the table.
+ *
+ * @param b the structure with the buffers
+ *
+ * @return It returns true when an entry was read, and false at the end of the table.
+ */
+static bool ebpf_map_batch_fill_key_by_key(ebpf_map_batch_t *b)
+{
+    if (b->first) {
+        b->first = false;
+
+        // an empty key, like the previous loops, because kernels before 4.12 cannot start from NULL
+        uint8_t start[b->key_size];
+        memset(start, 0, b->key_size);
+        if (bpf_map_get_next_key(b->fd, start, b->batch)) {
+            b->finished = true;
+            return false;
+        }
+    }
+
+    while (!b->finished) {
+        memcpy(b->keys, b->batch, b->key_size);
+        if (bpf_map_get_next_key(b->fd, b->keys, b->batch))
+            b->finished = true;
+
+        // kernel does not create values for processors that did not store data in the table
+        memset(b->values, 0, b->value_size);
+        if (!bpf_map_lookup_elem(b->fd, b->keys, b->values)) {
+            b->count = 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Map Batch Fill
+ *
+ * Read the next entries of a table.
+ *
+ * @param b the structure with the buffers
+ *
+ * @return It returns true when entries were read, and false at the end of the table.
+ */
+static bool ebpf_map_batch_fill(ebpf_map_batch_t *b)
+{
+    b->count = b->position = 0;
+    if (b->finished)
+        return false;
+
+    if (b->key_by_key)
+        return ebpf_map_batch_fill_key_by_key(b);
+
+    for (;;) {
+        uint32_t count = b->entries;
+        int ret = bpf_map_lookup_batch(b->fd, (b->first) ? NULL : b->batch, b->batch, b->keys, b->values, &count, NULL);
+        if (ret < 0 && errno == ENOSPC && !count) {
+            // a hash bucket has more entries than the buffers
+            b->entries *= 2;
+            b->keys = reallocz(b->keys, b->entries * (size_t)b->key_size);
+            b->values = reallocz(b->values, b->entries * b->value_size);
+            continue;
+        }
+
+        if (ret < 0 && errno != ENOENT) {
+            if (b->first) {
+                b->key_by_key = true;
+                return ebpf_map_batch_fill_key_by_key(b);
+            }
+
+            b->finished = true;
+            return false;
+        }
+
+        // ENOENT is the end of the table, with the last entries
+        b->first = false;
+        b->count = count;
+        if (ret < 0 || !count)
+            b->finished = true;
+
+        return count > 0;
+    }
+}
+
+/**
+ * Map Batch Next
+ *
+ * Give the next entry of the table. The key and the value point inside the buffers, and they are valid
+ * until the next call.
+ *
+ * @param b      the structure with the buffers
+ * @param key    the key of the entry
+ * @param value  the value of the entry, with all processors when the table is per core
+ *
+ * @return It returns true when there is an entry, and false at the end of the table.
+ */
+bool ebpf_map_batch_next(ebpf_map_batch_t *b, void **key, void **value)
+{
+    if (b->position >= b->count && !ebpf_map_batch_fill(b))
+        return false;
+
+    *key = (char *)b->keys + (size_t)b->position * b->key_size;
+    *value = (char *)b->values + (size_t)b->position * b->value_size;
+    b->position++;
+
+    return true;
+}
+
 /*****************************************************************
  *
  *  FUNCTIONS USED WITH SOCKET
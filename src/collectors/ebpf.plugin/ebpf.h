@@ -342,6 +342,35 @@ void ebpf_unload_legacy_code(struct bpf_object *objects, struct bpf_link **probe
 
 void ebpf_read_global_table_stats(netdata_idx_t *stats, netdata_idx_t *values, int map_fd,
                                   int maps_per_core, uint32_t begin, uint32_t end);
+
+// Read hash tables in batches of entries, instead of one lookup per key
+#define NETDATA_EBPF_MAP_BATCH_BYTES (1024 * 1024)
+#define NETDATA_EBPF_MAP_BATCH_MAX_ENTRIES 4096
+
+typedef struct ebpf_map_batch {
+    int fd;
+    uint32_t key_size;
+    size_t value_size;      // the size of one value, with all processors when the table is per core
+
+    uint32_t entries;       // the number of entries the buffers can store
+    uint32_t count;         // the number of entries stored
+    uint32_t position;      // the next entry returned
+
+    void *keys;
+    void *values;
+    void *batch;            // the position inside the table, or the next key when the table is read key by key
+
+    bool first;
+    bool finished;
+    bool key_by_key;        // the kernel cannot read the table in batches
+} ebpf_map_batch_t;
+
+void ebpf_map_batch_init(ebpf_map_batch_t *b, uint32_t key_size, size_t value_size, int maps_per_core);
+void ebpf_map_batch_free(ebpf_map_batch_t *b);
+void ebpf_map_batch_start(ebpf_map_batch_t *b, int fd);
+bool ebpf_map_batch_next(ebpf_map_batch_t *b, void **key, void **value);
+
+extern ebpf_map_batch_t process_stat_batch;
 void **ebpf_judy_insert_unsafe(PPvoid_t arr, Word_t key);
 netdata_ebpf_judy_pid_stats_t *ebpf_get_pid_from_judy_unsafe(PPvoid_t judy_array, uint32_t pid);
 
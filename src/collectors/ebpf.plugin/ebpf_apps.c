@@ -913,17 +913,14 @@ void collect_data_for_all_processes(int tbl_pid_stats_fd, int maps_per_core)
         return;
 
     pids_fd[EBPF_PIDS_PROCESS_IDX] = tbl_pid_stats_fd;
-    size_t length =  sizeof(ebpf_process_stat_t);
-    if (maps_per_core)
-        length *= ebpf_nprocs;
 
     if (tbl_pid_stats_fd != -1) {
+        uint32_t *pkey;
+        ebpf_process_stat_t *process_stat_vector;
 
-        uint32_t key = 0, next_key = 0;
-        while (bpf_map_get_next_key(tbl_pid_stats_fd, &key, &next_key) == 0) {
-            if (bpf_map_lookup_elem(tbl_pid_stats_fd, &key, process_stat_vector)) {
-                goto end_process_loop;
-            }
+        ebpf_map_batch_start(&process_stat_batch, tbl_pid_stats_fd);
+        while (ebpf_map_batch_next(&process_stat_batch, (void **)&pkey, (void **)&process_stat_vector)) {
+            uint32_t key = *pkey;
 
             ebpf_process_apps_accumulator(process_stat_vector, maps_per_core);
 
@@ -949,10 +946,6 @@ void collect_data_for_all_processes(int tbl_pid_stats_fd, int maps_per_core)
                     local_pid->process = NULL;
                 }
             }
-
-end_process_loop:
-            memset(process_stat_vector, 0, length);
-            key = next_key;
         }
     }
 
@@ -507,7 +507,6 @@ void ebpf_process_apps_accumulator(ebpf_process_stat_t *out, int maps_per_core);
 
 // ARAL Sectiion
 void ebpf_aral_init(void);
-extern ebpf_process_stat_t *process_stat_vector;
 
 extern ARAL *ebpf_aral_vfs_pid;
 void ebpf_vfs_aral_init();
@@ -8,7 +8,7 @@ static char *cachestat_counter_dimension_name[NETDATA_CACHESTAT_END] = { "ratio"
 static netdata_syscall_stat_t cachestat_counter_aggregated_data[NETDATA_CACHESTAT_END];
 static netdata_publish_syscall_t cachestat_counter_publish_aggregated[NETDATA_CACHESTAT_END];
 
-netdata_cachestat_pid_t *cachestat_vector = NULL;
+static ebpf_map_batch_t cachestat_batch;
 
 static netdata_idx_t cachestat_hash_values[NETDATA_CACHESTAT_END];
 static netdata_idx_t *cachestat_values = NULL;
@@ -715,17 +715,13 @@ static inline void cachestat_save_pid_values(netdata_publish_cachestat_t *out, n
  */
 static void ebpf_read_cachestat_apps_table(int maps_per_core)
 {
-    netdata_cachestat_pid_t *cv = cachestat_vector;
+    netdata_cachestat_pid_t *cv;
+    uint32_t *pkey;
     int fd = cachestat_maps[NETDATA_CACHESTAT_PID_STATS].map_fd;
-    size_t length = sizeof(netdata_cachestat_pid_t);
-    if (maps_per_core)
-        length *= ebpf_nprocs;
-
-    uint32_t key = 0, next_key = 0;
-    while (bpf_map_get_next_key(fd, &key, &next_key) == 0) {
-        if (bpf_map_lookup_elem(fd, &key, cv)) {
-            goto end_cachestat_loop;
-        }
+
+    ebpf_map_batch_start(&cachestat_batch, fd);
+    while (ebpf_map_batch_next(&cachestat_batch, (void **)&pkey, (void **)&cv)) {
+        uint32_t key = *pkey;
 
         cachestat_apps_accumulator(cv, maps_per_core);
 
@@ -746,11 +742,6 @@ static void ebpf_read_cachestat_apps_table(int maps_per_core)
                 local_pid->cachestat = NULL;
             }
         }
-
-end_cachestat_loop:
-        // We are cleaning to avoid passing data read from one process to other.
-        memset(cv, 0, length);
-        key = next_key;
     }
 }
 
@@ -1506,10 +1497,12 @@ static void ebpf_create_memory_charts(ebpf_module_t *em)
  *
  * We are not testing the return, because callocz does this and shutdown the software
  * case it was not possible to allocate.
+ *
+ * @param maps_per_core do I need to read all cores?
  */
-static void ebpf_cachestat_allocate_global_vectors()
+static void ebpf_cachestat_allocate_global_vectors(int maps_per_core)
 {
-    cachestat_vector = callocz((size_t)ebpf_nprocs, sizeof(netdata_cachestat_pid_t));
+    ebpf_map_batch_init(&cachestat_batch, sizeof(uint32_t), sizeof(netdata_cachestat_pid_t), maps_per_core);
     cachestat_values = callocz((size_t)ebpf_nprocs, sizeof(netdata_idx_t));
 
     memset(cachestat_hash_values, 0, NETDATA_CACHESTAT_END * sizeof(netdata_idx_t));
@@ -1618,7 +1611,7 @@ void *ebpf_cachestat_thread(void *ptr)
         goto endcachestat;
     }
 
-    ebpf_cachestat_allocate_global_vectors();
+    ebpf_cachestat_allocate_global_vectors(em->maps_per_core);
 
     int algorithms[NETDATA_CACHESTAT_END] = {
         NETDATA_EBPF_ABSOLUTE_IDX, NETDATA_EBPF_INCREMENTAL_IDX, NETDATA_EBPF_ABSOLUTE_IDX, NETDATA_EBPF_ABSOLUTE_IDX
@@ -7,7 +7,7 @@ static char *dcstat_counter_dimension_name[NETDATA_DCSTAT_IDX_END] = { "ratio",
 static netdata_syscall_stat_t dcstat_counter_aggregated_data[NETDATA_DCSTAT_IDX_END];
 static netdata_publish_syscall_t dcstat_counter_publish_aggregated[NETDATA_DCSTAT_IDX_END];
 
-netdata_dcstat_pid_t *dcstat_vector = NULL;
+static ebpf_map_batch_t dcstat_batch;
 
 static netdata_idx_t dcstat_hash_values[NETDATA_DCSTAT_IDX_END];
 static netdata_idx_t *dcstat_values = NULL;
@@ -541,17 +541,13 @@ static void ebpf_dcstat_apps_accumulator(netdata_dcstat_pid_t *out, int maps_per
  */
 static void ebpf_read_dc_apps_table(int maps_per_core)
 {
-    netdata_dcstat_pid_t *cv = dcstat_vector;
+    netdata_dcstat_pid_t *cv;
+    uint32_t *pkey;
     int fd = dcstat_maps[NETDATA_DCSTAT_PID_STATS].map_fd;
-    size_t length = sizeof(netdata_dcstat_pid_t);
-    if (maps_per_core)
-        length *= ebpf_nprocs;
-
-    uint32_t key = 0, next_key = 0;
-    while (bpf_map_get_next_key(fd, &key, &next_key) == 0) {
-        if (bpf_map_lookup_elem(fd, &key, cv)) {
-            goto end_dc_loop;
-        }
+
+    ebpf_map_batch_start(&dcstat_batch, fd);
+    while (ebpf_map_batch_next(&dcstat_batch, (void **)&pkey, (void **)&cv)) {
+        uint32_t key = *pkey;
 
         ebpf_dcstat_apps_accumulator(cv, maps_per_core);
 
@@ -576,11 +572,6 @@ static void ebpf_read_dc_apps_table(int maps_per_core)
                 pid_stat->dc = NULL;
             }
         }
-
-end_dc_loop:
-        // We are cleaning to avoid passing data read from one process to other.
-        memset(cv, 0, length);
-        key = next_key;
     }
 }
 
@@ -1350,10 +1341,12 @@ static void ebpf_create_dc_global_charts(int update_every)
  *
  * We are not testing the return, because callocz does this and shutdown the software
  * case it was not possible to allocate.
+ *
+ * @param maps_per_core do I need to read all cores?
  */
-static void ebpf_dcstat_allocate_global_vectors()
+static void ebpf_dcstat_allocate_global_vectors(int maps_per_core)
 {
-    dcstat_vector = callocz((size_t)ebpf_nprocs, sizeof(netdata_dcstat_pid_t));
+    ebpf_map_batch_init(&dcstat_batch, sizeof(uint32_t), sizeof(netdata_dcstat_pid_t), maps_per_core);
     dcstat_values = callocz((size_t)ebpf_nprocs, sizeof(netdata_idx_t));
 
     memset(dcstat_counter_aggregated_data, 0, NETDATA_DCSTAT_IDX_END * sizeof(netdata_syscall_stat_t));
@@ -1430,7 +1423,7 @@ void *ebpf_dcstat_thread(void *ptr)
         goto enddcstat;
     }
 
-    ebpf_dcstat_allocate_global_vectors();
+    ebpf_dcstat_allocate_global_vectors(em->maps_per_core);
 
     int algorithms[NETDATA_DCSTAT_IDX_END] = {
         NETDATA_EBPF_ABSOLUTE_IDX, NETDATA_EBPF_ABSOLUTE_IDX, NETDATA_EBPF_ABSOLUTE_IDX,
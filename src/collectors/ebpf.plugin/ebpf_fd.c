@@ -51,7 +51,7 @@ struct config fd_config = APPCONFIG_INITIALIZER;
 static netdata_idx_t fd_hash_values[NETDATA_FD_COUNTER];
 static netdata_idx_t *fd_values = NULL;
 
-netdata_fd_stat_t *fd_vector = NULL;
+static ebpf_map_batch_t fd_batch;
 
 netdata_ebpf_targets_t fd_targets[] = { {.name = "open", .mode = EBPF_LOAD_TRAMPOLINE},
                                         {.name = "close", .mode = EBPF_LOAD_TRAMPOLINE},
@@ -684,17 +684,13 @@ static void fd_apps_accumulator(netdata_fd_stat_t *out, int maps_per_core)
  */
 static void ebpf_read_fd_apps_table(int maps_per_core)
 {
-    netdata_fd_stat_t *fv = fd_vector;
+    netdata_fd_stat_t *fv;
+    uint32_t *pkey;
     int fd = fd_maps[NETDATA_FD_PID_STATS].map_fd;
-    size_t length = sizeof(netdata_fd_stat_t);
-    if (maps_per_core)
-        length *= ebpf_nprocs;
-
-    uint32_t key = 0, next_key = 0;
-    while (bpf_map_get_next_key(fd, &key, &next_key) == 0) {
-        if (bpf_map_lookup_elem(fd, &key, fv)) {
-            goto end_fd_loop;
-        }
+
+    ebpf_map_batch_start(&fd_batch, fd);
+    while (ebpf_map_batch_next(&fd_batch, (void **)&pkey, (void **)&fv)) {
+        uint32_t key = *pkey;
 
         fd_apps_accumulator(fv, maps_per_core);
 
@@ -720,11 +716,6 @@ static void ebpf_read_fd_apps_table(int maps_per_core)
                 pid_stat->fd = NULL;
             }
         }
-
-end_fd_loop:
-        // We are cleaning to avoid passing data read from one process to other.
-        memset(fv, 0, length);
-        key = next_key;
     }
 }
 
@@ -1401,10 +1392,12 @@ static void ebpf_create_fd_global_charts(ebpf_module_t *em)
  *
  * We are not testing the return, because callocz does this and shutdown the software
  * case it was not possible to allocate.
+ *
+ * @param maps_per_core do I need to read all cores?
  */
-static inline void ebpf_fd_allocate_global_vectors()
+static inline void ebpf_fd_allocate_global_vectors(int maps_per_core)
 {
-    fd_vector = callocz((size_t)ebpf_nprocs, sizeof(netdata_fd_stat_t));
+    ebpf_map_batch_init(&fd_batch, sizeof(uint32_t), sizeof(netdata_fd_stat_t), maps_per_core);
     fd_values = callocz((size_t)ebpf_nprocs, sizeof(netdata_idx_t));
 }
 
@@ -1469,7 +1462,7 @@ void *ebpf_fd_thread(void *ptr)
         goto endfd;
     }
 
-    ebpf_fd_allocate_global_vectors();
+    ebpf_fd_allocate_global_vectors(em->maps_per_core);
 
     int algorithms[NETDATA_FD_SYSCALL_END] = {
         NETDATA_EBPF_INCREMENTAL_IDX, NETDATA_EBPF_INCREMENTAL_IDX
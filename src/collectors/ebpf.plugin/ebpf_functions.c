@@ -441,6 +441,11 @@ static void ebpf_function_socket_manipulation(const char *transaction,
         pthread_mutex_lock(&ebpf_exit_cleanup);
         if (period < 0)
             em->lifetime = (em->enabled != NETDATA_THREAD_EBPF_FUNCTION_RUNNING) ? EBPF_NON_FUNCTION_LIFE_TIME : EBPF_DEFAULT_LIFETIME;
+
+        // the lifetime counts from the last request, so the thread started by the function
+        // is stopped only when nobody has asked for the connections during its lifetime
+        if (em->enabled == NETDATA_THREAD_EBPF_FUNCTION_RUNNING)
+            em->running_time = 0;
     }
     pthread_mutex_unlock(&ebpf_exit_cleanup);
 
@@ -53,7 +53,7 @@ static int was_sched_process_exec_enabled = 0;
 static int was_sched_process_fork_enabled = 0;
 
 static netdata_idx_t *process_hash_values = NULL;
-ebpf_process_stat_t *process_stat_vector = NULL;
+ebpf_map_batch_t process_stat_batch;
 static netdata_syscall_stat_t process_aggregated_data[NETDATA_KEY_PUBLISH_PROCESS_END];
 static netdata_publish_syscall_t process_publish_aggregated[NETDATA_KEY_PUBLISH_PROCESS_END];
 
@@ -721,7 +721,7 @@ static void ebpf_process_exit(void *pptr)
     }
 
     freez(process_hash_values);
-    freez(process_stat_vector);
+    ebpf_map_batch_free(&process_stat_batch);
 
     ebpf_process_disable_tracepoints();
 
@@ -1200,13 +1200,14 @@ static void process_collector(ebpf_module_t *em)
  * case it was not possible to allocate.
  *
  *  @param length is the length for the vectors used inside the collector.
+ *  @param maps_per_core do I need to read all cores?
  */
-static void ebpf_process_allocate_global_vectors(size_t length)
+static void ebpf_process_allocate_global_vectors(size_t length, int maps_per_core)
 {
     memset(process_aggregated_data, 0, length * sizeof(netdata_syscall_stat_t));
     memset(process_publish_aggregated, 0, length * sizeof(netdata_publish_syscall_t));
     process_hash_values = callocz(ebpf_nprocs, sizeof(netdata_idx_t));
-    process_stat_vector = callocz(ebpf_nprocs, sizeof(ebpf_process_stat_t));
+    ebpf_map_batch_init(&process_stat_batch, sizeof(uint32_t), sizeof(ebpf_process_stat_t), maps_per_core);
 }
 
 static void change_syscalls()
@@ -1294,7 +1295,7 @@ void *ebpf_process_thread(void *ptr)
     pthread_mutex_unlock(&ebpf_exit_cleanup);
 
     pthread_mutex_lock(&lock);
-    ebpf_process_allocate_global_vectors(NETDATA_KEY_PUBLISH_PROCESS_END);
+    ebpf_process_allocate_global_vectors(NETDATA_KEY_PUBLISH_PROCESS_END, em->maps_per_core);
 
     ebpf_update_pid_table(&process_maps[0], em);
 
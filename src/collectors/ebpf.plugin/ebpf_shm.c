@@ -8,6 +8,7 @@ static netdata_syscall_stat_t shm_aggregated_data[NETDATA_SHM_END];
 static netdata_publish_syscall_t shm_publish_aggregated[NETDATA_SHM_END];
 
 netdata_ebpf_shm_t *shm_vector = NULL;
+static ebpf_map_batch_t shm_batch;
 
 static netdata_idx_t shm_hash_values[NETDATA_SHM_END];
 static netdata_idx_t *shm_values = NULL;
@@ -568,17 +569,13 @@ static void ebpf_update_shm_cgroup()
  */
 static void ebpf_read_shm_apps_table(int maps_per_core)
 {
-    netdata_ebpf_shm_t *cv = shm_vector;
+    netdata_ebpf_shm_t *cv;
+    uint32_t *pkey;
     int fd = shm_maps[NETDATA_PID_SHM_TABLE].map_fd;
-    size_t length = sizeof(netdata_ebpf_shm_t);
-    if (maps_per_core)
-        length *= ebpf_nprocs;
-
-    uint32_t key = 0, next_key = 0;
-    while (bpf_map_get_next_key(fd, &key, &next_key) == 0) {
-        if (bpf_map_lookup_elem(fd, &key, cv)) {
-            goto end_shm_loop;
-        }
+
+    ebpf_map_batch_start(&shm_batch, fd);
+    while (ebpf_map_batch_next(&shm_batch, (void **)&pkey, (void **)&cv)) {
+        uint32_t key = *pkey;
 
         shm_apps_accumulator(cv, maps_per_core);
 
@@ -600,12 +597,9 @@ static void ebpf_read_shm_apps_table(int maps_per_core)
             }
         }
 
-end_shm_loop:
         // now that we've consumed the value, zero it out in the map.
-        memset(cv, 0, length);
+        memset(cv, 0, shm_batch.value_size);
         bpf_map_update_elem(fd, &key, cv, BPF_EXIST);
-
-        key = next_key;
     }
 }
 
@@ -1244,12 +1238,14 @@ void ebpf_shm_create_apps_charts(struct ebpf_module *em, void *ptr)
  * We are not testing the return, because callocz does this and shutdown the software
  * case it was not possible to allocate.
  *
- * @param apps is apps enabled?
+ * @param apps           is apps enabled?
+ * @param maps_per_core  do I need to read all cores?
  */
-static void ebpf_shm_allocate_global_vectors(int apps)
+static void ebpf_shm_allocate_global_vectors(int apps, int maps_per_core)
 {
     UNUSED(apps);
     shm_vector = callocz((size_t)ebpf_nprocs, sizeof(netdata_publish_shm_t));
+    ebpf_map_batch_init(&shm_batch, sizeof(uint32_t), sizeof(netdata_ebpf_shm_t), maps_per_core);
     shm_values = callocz((size_t)ebpf_nprocs, sizeof(netdata_idx_t));
 
     memset(shm_hash_values, 0, sizeof(shm_hash_values));
@@ -1349,7 +1345,7 @@ void *ebpf_shm_thread(void *ptr)
         goto endshm;
     }
 
-    ebpf_shm_allocate_global_vectors(em->apps_charts);
+    ebpf_shm_allocate_global_vectors(em->apps_charts, em->maps_per_core);
 
     int algorithms[NETDATA_SHM_END] = {
         NETDATA_EBPF_INCREMENTAL_IDX,
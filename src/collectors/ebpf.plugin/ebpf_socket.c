@@ -72,7 +72,7 @@ static netdata_idx_t *socket_hash_values = NULL;
 static netdata_syscall_stat_t socket_aggregated_data[NETDATA_MAX_SOCKET_VECTOR];
 static netdata_publish_syscall_t socket_publish_aggregated[NETDATA_MAX_SOCKET_VECTOR];
 
-netdata_socket_t *socket_values;
+static ebpf_map_batch_t socket_batch;
 
 ebpf_network_viewer_port_list_t *listen_ports = NULL;
 ebpf_addresses_t tcp_v6_connect_address = {.function = "tcp_v6_connect", .hash = 0, .addr = 0, .type = 0};
@@ -1652,32 +1652,18 @@ static void ebpf_socket_translate(netdata_socket_plus_t *dst, netdata_socket_idx
  */
 static void ebpf_update_array_vectors(ebpf_module_t *em)
 {
-    netdata_socket_idx_t key = {};
-    netdata_socket_idx_t next_key = {};
+    netdata_socket_idx_t *pkey;
+    netdata_socket_t *values;
 
     int maps_per_core = em->maps_per_core;
     int fd = em->maps[NETDATA_SOCKET_OPEN_SOCKET].map_fd;
+    int end = (maps_per_core) ? ebpf_nprocs : 1;
 
-    netdata_socket_t *values = socket_values;
-    size_t length = sizeof(netdata_socket_t);
-    int test, end;
-    if (maps_per_core) {
-        length *= ebpf_nprocs;
-        end = ebpf_nprocs;
-    } else
-        end = 1;
-
-    // We need to reset the values when we are working on kernel 4.15 or newer, because kernel does not create
-    // values for specific processor unless it is used to store data. As result of this behavior one the next socket
-    // can have values from the previous one.
-    memset(values, 0, length);
     time_t update_time = time(NULL);
-    while (bpf_map_get_next_key(fd, &key, &next_key) == 0) {
-        test = bpf_map_lookup_elem(fd, &key, values);
+    ebpf_map_batch_start(&socket_batch, fd);
+    while (ebpf_map_batch_next(&socket_batch, (void **)&pkey, (void **)&values)) {
+        netdata_socket_idx_t key = *pkey;
         bool deleted = true;
-        if (test < 0) {
-            goto end_socket_loop;
-        }
 
         if (key.pid > (uint32_t)pid_max) {
             goto end_socket_loop;
@@ -1761,8 +1747,6 @@ end_socket_loop: ; // the empty statement is here to allow code to be compiled b
             ebpf_socket_release_publish(curr);
             local_pid->socket = NULL;
         }
-        memset(values, 0, length);
-        memcpy(&key, &next_key, sizeof(key));
     }
 }
 /**
@@ -2659,6 +2643,10 @@ static void socket_collector(ebpf_module_t *em)
             running_time += update_every;
 
         em->running_time = running_time;
+
+        // the function can change the lifetime of the thread it started
+        if (em->enabled == NETDATA_THREAD_EBPF_FUNCTION_RUNNING)
+            lifetime = em->lifetime;
         pthread_mutex_unlock(&ebpf_exit_cleanup);
     }
 }
@@ -2674,8 +2662,10 @@ static void socket_collector(ebpf_module_t *em)
  *
  * We are not testing the return, because callocz does this and shutdown the software
  * case it was not possible to allocate.
+ *
+ * @param maps_per_core do I need to read all cores?
  */
-static void ebpf_socket_initialize_global_vectors()
+static void ebpf_socket_initialize_global_vectors(int maps_per_core)
 {
     memset(socket_aggregated_data, 0 ,NETDATA_MAX_SOCKET_VECTOR * sizeof(netdata_syscall_stat_t));
     memset(socket_publish_aggregated, 0 ,NETDATA_MAX_SOCKET_VECTOR * sizeof(netdata_publish_syscall_t));
@@ -2684,7 +2674,7 @@ static void ebpf_socket_initialize_global_vectors()
     aral_socket_table = ebpf_allocate_pid_aral(NETDATA_EBPF_SOCKET_ARAL_TABLE_NAME,
                                                sizeof(netdata_socket_plus_t));
 
-    socket_values = callocz((size_t)ebpf_nprocs, sizeof(netdata_socket_t));
+    ebpf_map_batch_init(&socket_batch, sizeof(netdata_socket_idx_t), sizeof(netdata_socket_t), maps_per_core);
 
     ebpf_load_addresses(&tcp_v6_connect_address, -1);
 }
@@ -2867,7 +2857,7 @@ void *ebpf_socket_thread(void *ptr)
 
     parse_table_size_options(&socket_config);
 
-    ebpf_socket_initialize_global_vectors();
+    ebpf_socket_initialize_global_vectors(em->maps_per_core);
 
     if (running_on_kernel < NETDATA_EBPF_KERNEL_5_0)
         em->mode = MODE_ENTRY;
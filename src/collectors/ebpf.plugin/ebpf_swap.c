@@ -10,7 +10,7 @@ static netdata_publish_syscall_t swap_publish_aggregated[NETDATA_SWAP_END];
 static netdata_idx_t swap_hash_values[NETDATA_SWAP_END];
 static netdata_idx_t *swap_values = NULL;
 
-netdata_ebpf_swap_t *swap_vector = NULL;
+static ebpf_map_batch_t swap_batch;
 
 struct config swap_config = APPCONFIG_INITIALIZER;
 
@@ -542,17 +542,13 @@ void ebpf_swap_resume_apps_data() {
  */
 static void ebpf_read_swap_apps_table(int maps_per_core)
 {
-    netdata_ebpf_swap_t *cv = swap_vector;
+    netdata_ebpf_swap_t *cv;
+    uint32_t *pkey;
     int fd = swap_maps[NETDATA_PID_SWAP_TABLE].map_fd;
-    size_t length = sizeof(netdata_ebpf_swap_t);
-    if (maps_per_core)
-        length *= ebpf_nprocs;
-
-    uint32_t key = 0, next_key = 0;
-    while (bpf_map_get_next_key(fd, &key, &next_key) == 0) {
-        if (bpf_map_lookup_elem(fd, &key, cv)) {
-            goto end_swap_loop;
-        }
+
+    ebpf_map_batch_start(&swap_batch, fd);
+    while (ebpf_map_batch_next(&swap_batch, (void **)&pkey, (void **)&cv)) {
+        uint32_t key = *pkey;
 
         swap_apps_accumulator(cv, maps_per_core);
 
@@ -573,11 +569,6 @@ static void ebpf_read_swap_apps_table(int maps_per_core)
                 local_pid->swap = NULL;
             }
         }
-
-        // We are cleaning to avoid passing data read from one process to other.
-end_swap_loop:
-        memset(cv, 0, length);
-        key = next_key;
     }
 }
 
@@ -1029,10 +1020,12 @@ void ebpf_swap_create_apps_charts(struct ebpf_module *em, void *ptr)
  *
  * We are not testing the return, because callocz does this and shutdown the software
  * case it was not possible to allocate.
+ *
+ * @param maps_per_core do I need to read all cores?
  */
-static void ebpf_swap_allocate_global_vectors()
+static void ebpf_swap_allocate_global_vectors(int maps_per_core)
 {
-    swap_vector = callocz((size_t)ebpf_nprocs, sizeof(netdata_ebpf_swap_t));
+    ebpf_map_batch_init(&swap_batch, sizeof(uint32_t), sizeof(netdata_ebpf_swap_t), maps_per_core);
 
     swap_values = callocz((size_t)ebpf_nprocs, sizeof(netdata_idx_t));
 
@@ -1162,7 +1155,7 @@ void *ebpf_swap_thread(void *ptr)
         goto endswap;
     }
 
-    ebpf_swap_allocate_global_vectors();
+    ebpf_swap_allocate_global_vectors(em->maps_per_core);
 
     int algorithms[NETDATA_SWAP_END] = { NETDATA_EBPF_INCREMENTAL_IDX, NETDATA_EBPF_INCREMENTAL_IDX };
     ebpf_global_labels(swap_aggregated_data, swap_publish_aggregated, swap_dimension_name, swap_dimension_name,
@@ -11,7 +11,7 @@ static char *vfs_id_names[NETDATA_KEY_PUBLISH_VFS_END] = { "vfs_unlink", "vfs_re
 static netdata_idx_t *vfs_hash_values = NULL;
 static netdata_syscall_stat_t vfs_aggregated_data[NETDATA_KEY_PUBLISH_VFS_END];
 static netdata_publish_syscall_t vfs_publish_aggregated[NETDATA_KEY_PUBLISH_VFS_END];
-netdata_ebpf_vfs_t *vfs_vector = NULL;
+static ebpf_map_batch_t vfs_batch;
 
 static ebpf_local_maps_t vfs_maps[] = {{.name = "tbl_vfs_pid", .internal_input = ND_EBPF_DEFAULT_PID_SIZE,
                                         .user_input = 0, .type = NETDATA_EBPF_MAP_RESIZABLE | NETDATA_EBPF_MAP_PID,
@@ -1243,17 +1243,13 @@ static void vfs_apps_accumulator(netdata_ebpf_vfs_t *out, int maps_per_core)
  */
 static void ebpf_vfs_read_apps(int maps_per_core, uint32_t max_period)
 {
-    netdata_ebpf_vfs_t *vv = vfs_vector;
+    netdata_ebpf_vfs_t *vv;
+    uint32_t *pkey;
     int fd = vfs_maps[NETDATA_VFS_PID].map_fd;
-    size_t length = sizeof(netdata_ebpf_vfs_t);
-    if (maps_per_core)
-        length *= ebpf_nprocs;
-
-    uint32_t key = 0, next_key = 0;
-    while (bpf_map_get_next_key(fd, &key, &next_key) == 0) {
-        if (bpf_map_lookup_elem(fd, &key, vv)) {
-            goto end_vfs_loop;
-        }
+
+    ebpf_map_batch_start(&vfs_batch, fd);
+    while (ebpf_map_batch_next(&vfs_batch, (void **)&pkey, (void **)&vv)) {
+        uint32_t key = *pkey;
 
         vfs_apps_accumulator(vv, maps_per_core);
 
@@ -1274,11 +1270,6 @@ static void ebpf_vfs_read_apps(int maps_per_core, uint32_t max_period)
                 local_pid->vfs = NULL;
             }
         }
-
-end_vfs_loop:
-        // We are cleaning to avoid passing data read from one process to other.
-        memset(vv, 0, length);
-        key = next_key;
     }
 }
 
@@ -2563,11 +2554,11 @@ void ebpf_vfs_create_apps_charts(struct ebpf_module *em, void *ptr)
  * We are not testing the return, because callocz does this and shutdown the software
  * case it was not possible to allocate.
  *
- *  @param apps is apps enabled?
+ *  @param maps_per_core do I need to read all cores?
  */
-static void ebpf_vfs_allocate_global_vectors()
+static void ebpf_vfs_allocate_global_vectors(int maps_per_core)
 {
-    vfs_vector = callocz(ebpf_nprocs, sizeof(netdata_ebpf_vfs_t));
+    ebpf_map_batch_init(&vfs_batch, sizeof(uint32_t), sizeof(netdata_ebpf_vfs_t), maps_per_core);
 
     memset(vfs_aggregated_data, 0, sizeof(vfs_aggregated_data));
     memset(vfs_publish_aggregated, 0, sizeof(vfs_publish_aggregated));
@@ -2635,7 +2626,7 @@ void *ebpf_vfs_thread(void *ptr)
 
     ebpf_update_pid_table(&vfs_maps[NETDATA_VFS_PID], em);
 
-    ebpf_vfs_allocate_global_vectors();
+    ebpf_vfs_allocate_global_vectors(em->maps_per_core);
 
 #ifdef LIBBPF_MAJOR_VERSION
     ebpf_adjust_thread_load(em, default_btf);
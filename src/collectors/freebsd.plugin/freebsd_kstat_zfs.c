@@ -110,7 +110,16 @@ int do_kstat_zfs_misc_arcstats(int update_every, usec_t dt) {
 
     arcstats.l2exist = -1;
 
-    if(unlikely(sysctlbyname("kstat.zfs.misc.arcstats.l2_size", &l2_size, &uint64_t_size, NULL, 0)))
+    // without zfs the name cannot be resolved, so it is resolved quietly here, once
+    if(unlikely(!mibs.l2_size[0])) {
+        size_t miblen = sizeof(mibs.l2_size) / sizeof(int);
+        if(unlikely(sysctlnametomib("kstat.zfs.misc.arcstats.l2_size", mibs.l2_size, &miblen) == -1)) {
+            mibs.l2_size[0] = 0;
+            return 0;
+        }
+    }
+
+    if(unlikely(sysctl(mibs.l2_size, sizeof(mibs.l2_size) / sizeof(int), &l2_size, &uint64_t_size, NULL, 0)))
         return 0;
 
     if(likely(l2_size))
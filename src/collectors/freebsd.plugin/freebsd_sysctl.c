@@ -580,18 +580,23 @@ int do_hw_intcnt(int update_every, usec_t dt) {
 
             common_interrupts(totalintr, update_every, "hw.intrcnt");
 
-            size_t size;
+            // the size of the names changes only with the number of interrupts
+            static size_t size = 0;
             static int mib_hw_intrnames[2] = {0, 0};
             static char *intrnames = NULL;
+            static RRDDIM **rd_interrupts = NULL;
 
-            if (unlikely(GETSYSCTL_SIZE("hw.intrnames", mib_hw_intrnames, size))) {
+            if (unlikely((nintr != old_nintr || !size) && GETSYSCTL_SIZE("hw.intrnames", mib_hw_intrnames, size))) {
                 collector_error("DISABLED: system.intr chart");
                 collector_error("DISABLED: system.interrupts chart");
                 collector_error("DISABLED: hw.intrcnt module");
                 return 1;
             } else {
-                if (unlikely(nintr != old_nintr))
+                if (unlikely(nintr != old_nintr)) {
                     intrnames = reallocz(intrnames, size);
+                    rd_interrupts = reallocz(rd_interrupts, nintr * sizeof(RRDDIM *));
+                    memset(rd_interrupts, 0, nintr * sizeof(RRDDIM *));
+                }
                 if (unlikely(GETSYSCTL_WSIZE("hw.intrnames", mib_hw_intrnames, intrnames, size))) {
                     collector_error("DISABLED: system.intr chart");
                     collector_error("DISABLED: system.interrupts chart");
@@ -617,17 +622,25 @@ int do_hw_intcnt(int update_every, usec_t dt) {
                         );
                     }
 
+                    // the names have a fixed width
+                    size_t name_width = strlen(intrnames) + 1;
+
                     for (i = 0; i < nintr; i++) {
-                        void *p;
+                        char *p = intrnames + i * name_width;
+
+                        if (unlikely((intrcnt[i] != 0) && (*p != 0))) {
+                            // a slot can get another interrupt, so the name of the dimension is checked
+                            RRDDIM *rd = rd_interrupts[i];
+                            if (unlikely(!rd || strcmp(rrddim_id(rd), p) != 0)) {
+                                rd = rrddim_find_active(st_interrupts, p);
 
-                        p = intrnames + i * (strlen(intrnames) + 1);
-                        if (unlikely((intrcnt[i] != 0) && (*(char *) p != 0))) {
-                            RRDDIM *rd_interrupts = rrddim_find_active(st_interrupts, p);
+                                if (unlikely(!rd))
+                                    rd = rrddim_add(st_interrupts, p, NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
 
-                            if (unlikely(!rd_interrupts))
-                                rd_interrupts = rrddim_add(st_interrupts, p, NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+                                rd_interrupts[i] = rd;
+                            }
 
-                            rrddim_set_by_pointer(st_interrupts, rd_interrupts, intrcnt[i]);
+                            rrddim_set_by_pointer(st_interrupts, rd, intrcnt[i]);
                         }
                     }
                     rrdset_done(st_interrupts);
@@ -296,6 +296,10 @@ void log_job_command_line_help(const char *name) {
     printf("       Show the configuration in YAML format before starting the job.\n");
     printf("       This is also an easy way to convert command line parameters to yaml.\n");
     printf("\n");
+    printf("  --benchmark\n");
+    printf("       Report to stderr, on exit, the number of lines processed and the\n");
+    printf("       throughput of the parser (lines/s and MiB/s).\n");
+    printf("\n");
     printf("The program accepts all parameters as both --option=value and --option value.\n");
     printf("\n");
     printf("The maximum log line length accepted is %d characters.\n", MAX_LINE_LENGTH);
@@ -285,6 +285,22 @@ static inline bool json_parse_string(LOG_JSON_STATE *js) {
     size_t remaining = sizeof(value);
 
     while (*s && *s != '"') {
+        // copy the run of characters that need no unescaping at once
+        size_t run = strcspn(s, "\"\\");
+        if(run) {
+            if(run >= remaining) {
+                snprintf(js->msg, sizeof(js->msg),
+                         "JSON PARSER: truncated string value at position %u", js->pos);
+                return false;
+            }
+
+            memcpy(d, s, run);
+            d += run;
+            s += run;
+            remaining -= run;
+            continue;
+        }
+
         char c;
 
         if (*s == '\\') {
@@ -64,7 +64,24 @@ static inline bool logftm_parse_value(LOGFMT_STATE *lfs) {
     size_t remaining = sizeof(value);
 
     char end_char = (char)(quote == '\0' ? ' ' : quote);
+    const char reject[] = { end_char, '\\', '\0' };
     while (*s && *s != end_char) {
+        // copy the run of characters that need no unescaping at once
+        size_t run = strcspn(s, reject);
+        if(run) {
+            if(run >= remaining) {
+                snprintf(lfs->msg, sizeof(lfs->msg),
+                         "LOGFMT PARSER: truncated string value at position %u", lfs->pos);
+                return false;
+            }
+
+            memcpy(d, s, run);
+            d += run;
+            s += run;
+            remaining -= run;
+            continue;
+        }
+
         char c;
 
         if (*s == '\\') {
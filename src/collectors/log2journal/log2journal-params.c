@@ -309,6 +309,9 @@ bool log_job_command_line_parse_parameters(LOG_JOB *jb, int argc, char **argv) {
         else if (strcmp(arg, "--show-config") == 0) {
             jb->show_config = true;
         }
+        else if (strcmp(arg, "--benchmark") == 0) {
+            jb->benchmark = true;
+        }
         else {
             char buffer[1024];
             char *param = NULL;
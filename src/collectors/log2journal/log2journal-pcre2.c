@@ -96,6 +96,9 @@ PCRE2_STATE *pcre2_parser_create(LOG_JOB *jb) {
         return pcre2;
     }
 
+    // when JIT is not available, pcre2_match() falls back to the interpreter
+    pcre2_jit_compile(pcre2->re, PCRE2_JIT_COMPLETE);
+
     pcre2->match_data = pcre2_match_data_create_from_pattern(pcre2->re, NULL);
 
     return pcre2;
@@ -28,6 +28,7 @@ static REPLACE_NODE *replace_pattern_add_node(REPLACE_NODE **head, bool is_varia
 
     hashed_key_set(&new_node->name, text);
     new_node->is_variable = is_variable;
+    new_node->group = -1;
     new_node->next = NULL;
 
     if (*head == NULL)
@@ -137,13 +137,13 @@ static inline size_t replace_evaluate_to_buffer(LOG_JOB *jb, HASHED_KEY *k __may
 
     for(REPLACE_NODE *node = rp->nodes; node != NULL && remaining > 1; node = node->next) {
         if(node->is_variable) {
-            if(hashed_keys_match(&node->name, &jb->line.key)) {
+            if(node->is_line) {
                 size_t copied = copy_to_buffer(copy_to, remaining, jb->line.trimmed, jb->line.trimmed_len);
                 copy_to += copied;
                 remaining -= copied;
             }
             else {
-                HASHED_KEY *ktmp = get_key_from_hashtable_with_char_ptr(jb, node->name.key);
+                HASHED_KEY *ktmp = get_key_from_hashtable(jb, &node->name);
                 if(ktmp->value.len) {
                     size_t copied = copy_to_buffer(copy_to, remaining, ktmp->value.txt, ktmp->value.len);
                     copy_to += copied;
@@ -169,11 +169,11 @@ static inline void replace_evaluate(LOG_JOB *jb, HASHED_KEY *k, REPLACE_PATTERN
 
     for(REPLACE_NODE *node = rp->nodes; node != NULL; node = node->next) {
         if(node->is_variable) {
-            if(hashed_keys_match(&node->name, &jb->line.key))
+            if(node->is_line)
                 txt_expand_and_append(&ht_key->value, jb->line.trimmed, jb->line.trimmed_len);
 
             else {
-                HASHED_KEY *ktmp = get_key_from_hashtable_with_char_ptr(jb, node->name.key);
+                HASHED_KEY *ktmp = get_key_from_hashtable(jb, &node->name);
                 if(ktmp->value.len)
                     txt_expand_and_append(&ht_key->value, ktmp->value.txt, ktmp->value.len);
             }
@@ -184,6 +184,7 @@ static inline void replace_evaluate(LOG_JOB *jb, HASHED_KEY *k, REPLACE_PATTERN
 }
 
 static inline void replace_evaluate_from_pcre2(LOG_JOB *jb, HASHED_KEY *k, REPLACE_PATTERN *rp, SEARCH_PATTERN *sp) {
+    // the named groups of the nodes have been resolved by log_job_compile()
     assert(k->flags & HK_HASHTABLE_ALLOCATED);
 
     // set the temporary TEXT to zero length
@@ -194,22 +195,19 @@ static inline void replace_evaluate_from_pcre2(LOG_JOB *jb, HASHED_KEY *k, REPLA
     // Iterate through the linked list of replacement nodes
     for(REPLACE_NODE *node = rp->nodes; node != NULL; node = node->next) {
         if(node->is_variable) {
-            int group_number = pcre2_substring_number_from_name(
-                    sp->re, (PCRE2_SPTR) node->name.key);
-
-            if(group_number >= 0) {
-                PCRE2_SIZE start_offset = ovector[2 * group_number];
-                PCRE2_SIZE end_offset = ovector[2 * group_number + 1];
+            if(node->group >= 0) {
+                PCRE2_SIZE start_offset = ovector[2 * node->group];
+                PCRE2_SIZE end_offset = ovector[2 * node->group + 1];
                 PCRE2_SIZE length = end_offset - start_offset;
 
                 txt_expand_and_append(&jb->rewrites.tmp, k->value.txt + start_offset, length);
             }
             else {
-                if(hashed_keys_match(&node->name, &jb->line.key))
+                if(node->is_line)
                     txt_expand_and_append(&jb->rewrites.tmp, jb->line.trimmed, jb->line.trimmed_len);
 
                 else {
-                    HASHED_KEY *ktmp = get_key_from_hashtable_with_char_ptr(jb, node->name.key);
+                    HASHED_KEY *ktmp = get_key_from_hashtable(jb, &node->name);
                     if(ktmp->value.len)
                         txt_expand_and_append(&jb->rewrites.tmp, ktmp->value.txt, ktmp->value.len);
                 }
@@ -248,22 +246,9 @@ static inline bool rewrite_conditions_satisfied(LOG_JOB *jb, HASHED_KEY *k, REWR
 
 // ----------------------------------------------------------------------------
 
-static inline HASHED_KEY *rename_key(LOG_JOB *jb, HASHED_KEY *k) {
-    if(!(k->flags & HK_RENAMES_CHECKED) || k->flags & HK_HAS_RENAMES) {
-        k->flags |= HK_RENAMES_CHECKED;
-
-        for(size_t i = 0; i < jb->renames.used; i++) {
-            RENAME *rn = &jb->renames.array[i];
-
-            if(hashed_keys_match(&rn->old_key, k)) {
-                k->flags |= HK_HAS_RENAMES;
-
-                return get_key_from_hashtable(jb, &rn->new_key);
-            }
-        }
-    }
-
-    return k;
+// the renames have been resolved by log_job_compile()
+static inline HASHED_KEY *rename_key(LOG_JOB *jb __maybe_unused, HASHED_KEY *k) {
+    return (k->flags & HK_HAS_RENAMES) ? k->rename_to : k;
 }
 
 // ----------------------------------------------------------------------------
@@ -355,6 +340,64 @@ static inline void send_all_fields(LOG_JOB *jb) {
     }
 }
 
+// ----------------------------------------------------------------------------
+// compiling the configuration
+
+// Resolve once, before processing any line, all the keys the configuration
+// refers to, to their slots in the hashtable, so that rewrites, renames and
+// injections do not hash or search for keys on every line.
+
+static void replace_pattern_compile(LOG_JOB *jb, REPLACE_PATTERN *rp, SEARCH_PATTERN *sp) {
+    for(REPLACE_NODE *node = rp->nodes; node ; node = node->next) {
+        if(!node->is_variable)
+            continue;
+
+        if(sp && sp->re)
+            node->group = pcre2_substring_number_from_name(sp->re, (PCRE2_SPTR)node->name.key);
+
+        node->is_line = hashed_keys_match(&node->name, &jb->line.key);
+        if(!node->is_line)
+            get_key_from_hashtable(jb, &node->name);
+    }
+}
+
+static void log_job_compile(LOG_JOB *jb) {
+    for(size_t i = 0; i < jb->renames.used; i++) {
+        RENAME *rn = &jb->renames.array[i];
+        HASHED_KEY *old_key = get_key_from_hashtable(jb, &rn->old_key);
+
+        // the first rename of a key wins
+        if(!(old_key->flags & HK_HAS_RENAMES)) {
+            old_key->rename_to = get_key_from_hashtable(jb, &rn->new_key);
+            old_key->flags |= HK_HAS_RENAMES;
+        }
+    }
+
+    for(size_t i = 0; i < jb->rewrites.used ;i++) {
+        REWRITE *rw = &jb->rewrites.array[i];
+        get_key_from_hashtable(jb, &rw->key);
+
+        if(rw->flags & RW_MATCH_PCRE2)
+            replace_pattern_compile(jb, &rw->value, &rw->match_pcre2);
+        else {
+            if(rw->flags & RW_MATCH_NON_EMPTY)
+                replace_pattern_compile(jb, &rw->match_non_empty, NULL);
+
+            replace_pattern_compile(jb, &rw->value, NULL);
+        }
+    }
+
+    for(size_t i = 0; i < jb->injections.used ;i++) {
+        get_key_from_hashtable(jb, &jb->injections.keys[i].key);
+        replace_pattern_compile(jb, &jb->injections.keys[i].value, NULL);
+    }
+
+    for(size_t i = 0; i < jb->unmatched.injections.used ;i++) {
+        get_key_from_hashtable(jb, &jb->unmatched.injections.keys[i].key);
+        replace_pattern_compile(jb, &jb->unmatched.injections.keys[i].value, NULL);
+    }
+}
+
 // ----------------------------------------------------------------------------
 // injection of constant fields
 
@@ -445,13 +488,87 @@ static inline bool jb_send_unmatched_line(LOG_JOB *jb, const char *line) {
 // ----------------------------------------------------------------------------
 // running a job
 
-static char *get_next_line(LOG_JOB *jb __maybe_unused, char *buffer, size_t size, size_t *line_length) {
-    if(!fgets(buffer, (int)size, stdin)) {
+// stdin is read in large blocks and the lines are parsed in place.
+// The output is flushed only when there is no complete line buffered, i.e.
+// right before reading may block, so that the lines of a burst are written
+// together, while the latency stays the same when the input is slow.
+
+#define INPUT_BUFFER_SIZE (4 * MAX_LINE_LENGTH)
+
+static bool input_fill(LOG_JOB *jb) {
+    char *buffer = (char *)jb->line.buffer;
+
+    // move the incomplete line to the beginning
+    if(jb->line.start) {
+        memmove(buffer, &buffer[jb->line.start], jb->line.end - jb->line.start);
+        jb->line.end -= jb->line.start;
+        jb->line.start = 0;
+    }
+
+    fflush(stdout);
+
+    ssize_t bytes;
+    do {
+        bytes = read(STDIN_FILENO, &buffer[jb->line.end], jb->line.size - jb->line.end);
+    } while(bytes < 0 && errno == EINTR);
+
+    if(bytes <= 0) {
+        jb->line.eof = true;
+        return false;
+    }
+
+    jb->line.end += bytes;
+    return true;
+}
+
+// returns the next line in the buffer, null terminated, like fgets() would
+static char *input_next_line(LOG_JOB *jb) {
+    char *buffer = (char *)jb->line.buffer;
+
+    if(jb->line.saved) {
+        // restore the byte we overwrote to terminate a line longer than MAX_LINE_LENGTH
+        buffer[jb->line.start] = jb->line.saved;
+        jb->line.saved = '\0';
+    }
+
+    while(true) {
+        char *s = &buffer[jb->line.start];
+        size_t available = jb->line.end - jb->line.start;
+
+        char *nl = memchr(s, '\n', available < MAX_LINE_LENGTH ? available : MAX_LINE_LENGTH);
+        if(nl) {
+            *nl = '\0';
+            jb->line.start += nl - s + 1;
+            return s;
+        }
+
+        if(available >= MAX_LINE_LENGTH) {
+            // too long, return it in pieces, like fgets() does
+            jb->line.start += MAX_LINE_LENGTH;
+            jb->line.saved = buffer[jb->line.start];
+            buffer[jb->line.start] = '\0';
+            return s;
+        }
+
+        if(jb->line.eof || !input_fill(jb)) {
+            if(!available)
+                return NULL;
+
+            // the last line, without a newline
+            buffer[jb->line.end] = '\0';
+            jb->line.start = jb->line.end;
+            return s;
+        }
+    }
+}
+
+static char *get_next_line(LOG_JOB *jb, size_t *line_length) {
+    char *line = input_next_line(jb);
+    if(!line) {
         *line_length = 0;
         return NULL;
     }
 
-    char *line = buffer;
     size_t len = strlen(line);
 
     // remove trailing newlines and spaces
@@ -470,6 +587,7 @@ static char *get_next_line(LOG_JOB *jb __maybe_unused, char *buffer, size_t size
 
 int log_job_run(LOG_JOB *jb) {
     select_which_injections_should_be_injected_on_unmatched(jb);
+    log_job_compile(jb);
 
     PCRE2_STATE *pcre2 = NULL;
     LOG_JSON_STATE *json = NULL;
@@ -492,15 +610,27 @@ int log_job_run(LOG_JOB *jb) {
         }
     }
 
-    jb->line.buffer = mallocz(MAX_LINE_LENGTH + 1);
-    jb->line.size = MAX_LINE_LENGTH + 1;
+    // one more byte than we read, to always have room for the terminator of the last line
+    jb->line.buffer = mallocz(INPUT_BUFFER_SIZE + 1);
+    jb->line.size = INPUT_BUFFER_SIZE;
+    jb->line.start = 0;
+    jb->line.end = 0;
+    jb->line.saved = '\0';
+    jb->line.eof = false;
     jb->line.trimmed_len = 0;
     jb->line.trimmed = jb->line.buffer;
 
-    while ((jb->line.trimmed = get_next_line(jb, (char *)jb->line.buffer, jb->line.size, &jb->line.trimmed_len))) {
+    size_t lines = 0, unmatched = 0, bytes = 0;
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    while ((jb->line.trimmed = get_next_line(jb, &jb->line.trimmed_len))) {
         const char *line = jb->line.trimmed;
         size_t len = jb->line.trimmed_len;
 
+        lines++;
+        bytes += len;
+
         if(jb_switched_filename(jb, line, len))
             continue;
 
@@ -514,6 +644,8 @@ int log_job_run(LOG_JOB *jb) {
             line_is_matched = pcre2_parse_document(pcre2, line, len);
 
         if(!line_is_matched) {
+            unmatched++;
+
             if(json)
                 log2stderr("%s", json_parser_error(json));
             else if(logfmt)
@@ -532,7 +664,18 @@ int log_job_run(LOG_JOB *jb) {
         log_job_process_rewrites(jb);
         send_all_fields(jb);
         printf("\n");
-        fflush(stdout);
+    }
+
+    fflush(stdout);
+
+    if(jb->benchmark) {
+        clock_gettime(CLOCK_MONOTONIC, &finished);
+        double secs = (double)(finished.tv_sec - started.tv_sec) + (double)(finished.tv_nsec - started.tv_nsec) / 1e9;
+        if(secs <= 0.0) secs = 1e-9;
+
+        log2stderr("benchmark: parser '%s', %zu lines (%zu unmatched), %zu bytes in %.3f secs, %.0f lines/s, %.2f MiB/s",
+                   jb->pattern, lines, unmatched, bytes, secs,
+                   (double)lines / secs, (double)bytes / secs / (1024.0 * 1024.0));
     }
 
     if(json)
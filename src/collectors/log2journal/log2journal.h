@@ -16,6 +16,9 @@
 #include <math.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
 
 // ----------------------------------------------------------------------------
 // compatibility
@@ -252,8 +255,7 @@ typedef enum __attribute__((__packed__)) {
 
     HK_COLLISION_CHECKED    = (1 << 3), // we checked once for collision check of this key
 
-    HK_RENAMES_CHECKED      = (1 << 4), // we checked once if there are renames on this key
-    HK_HAS_RENAMES          = (1 << 5), // and we found there is a rename rule related to it
+    HK_HAS_RENAMES          = (1 << 5), // there is a rename rule for this key, rename_to points to the new key
 
     // ephemeral flags - they are unset at the end of each log line
 
@@ -267,6 +269,7 @@ typedef struct hashed_key {
     uint32_t len;
     HASHED_KEY_FLAGS flags;
     XXH64_hash_t hash;
+    struct hashed_key *rename_to;         // HK_HAS_RENAMES is set
     union {
         struct hashed_key *hashtable_ptr; // HK_HASHTABLE_ALLOCATED is not set
         TEXT value;                       // HK_HASHTABLE_ALLOCATED is set
@@ -332,7 +335,9 @@ static inline bool search_pattern_matches(SEARCH_PATTERN *sp, const char *value,
 typedef struct replacement_node {
     HASHED_KEY name;
     bool is_variable;
+    bool is_line;           // the variable is the whole log line, set by log_job_compile()
     bool logged_error;
+    int group;              // the named group of the rewrite search pattern, or negative, set by log_job_compile()
 
     struct replacement_node *next;
 } REPLACE_NODE;
@@ -394,6 +399,7 @@ void rewrite_cleanup(REWRITE *rw);
 
 typedef struct log_job {
     bool show_config;
+    bool benchmark;
 
     const char *pattern;
     const char *prefix;
@@ -405,6 +411,10 @@ typedef struct log_job {
         const char *trimmed;
         size_t trimmed_len;
         size_t size;
+        size_t start;   // the first byte of the next line in buffer
+        size_t end;     // the bytes read into buffer
+        char saved;     // the byte overwritten to terminate a line that is too long
+        bool eof;
         HASHED_KEY key;
     } line;
 
@@ -34,6 +34,40 @@ static SPAWN_SERVER *spawn_srv = NULL;
 #define SIMPLE_HASHTABLE_NAME _AGGREGATED_SOCKETS
 #include "libnetdata/simple_hashtable.h"
 
+// ----------------------------------------------------------------------------
+// rows sent to clients
+//
+// Every call of the function is a generation. The rows of each view are kept
+// across calls, with the generation they last changed, so that clients
+// refreshing the table can ask for generation:N and get only the rows added
+// or changed after N, with the keys of the rows removed after N.
+
+typedef struct network_viewer_row {
+    XXH64_hash_t key;               // the identity of the row (the socket, or the aggregation key)
+    XXH64_hash_t hash;              // the hash of the json of the row
+    uint64_t generation;            // the generation the row was added or changed
+    uint64_t seen;                  // the last generation the row was found
+    uint64_t removed;               // the generation the row was removed, or zero
+} NETWORK_VIEWER_ROW;
+
+#define SIMPLE_HASHTABLE_VALUE_TYPE NETWORK_VIEWER_ROW
+#define SIMPLE_HASHTABLE_NAME _NETWORK_VIEWER_ROWS
+#include "libnetdata/simple_hashtable.h"
+
+// removed rows are remembered for this many generations
+// clients asking for an older generation get all the rows
+#define NETWORK_VIEWER_KEEP_REMOVED_GENERATIONS 100
+
+typedef struct network_viewer_rows {
+    netdata_mutex_t mutex;
+    SIMPLE_HASHTABLE_NETWORK_VIEWER_ROWS ht;
+    uint64_t generation;            // the generation of the last call
+    uint64_t oldest;                // the oldest generation that can be given as a delta
+} NETWORK_VIEWER_ROWS;
+
+static NETWORK_VIEWER_ROWS detailed_rows = { .mutex = NETDATA_MUTEX_INITIALIZER, };
+static NETWORK_VIEWER_ROWS aggregated_rows = { .mutex = NETDATA_MUTEX_INITIALIZER, };
+
 netdata_mutex_t stdout_mutex = NETDATA_MUTEX_INITIALIZER;
 static bool plugin_should_exit = false;
 static USERNAMES_CACHE *uc;
@@ -73,6 +107,10 @@ ENUM_STR_DEFINE_FUNCTIONS(TCP_STATE, 0, "unknown");
 struct sockets_stats {
     BUFFER *wb;
 
+    NETWORK_VIEWER_ROWS *rows;
+    bool delta;                     // send only the rows changed after the generation of the client
+    uint64_t since;                 // the generation of the client
+
     struct {
         uint32_t tcpi_rtt;
         uint32_t tcpi_rcv_rtt;
@@ -80,7 +118,7 @@ struct sockets_stats {
     } max;
 };
 
-static void local_socket_to_json_array(struct sockets_stats *st, LOCAL_SOCKET *n, uint64_t proc_self_net_ns_inode, bool aggregated) {
+static void local_socket_to_json_array(struct sockets_stats *st, LOCAL_SOCKET *n, XXH64_hash_t key, uint64_t proc_self_net_ns_inode, bool aggregated) {
     if(n->direction == SOCKET_DIRECTION_NONE)
         return;
 
@@ -236,10 +274,121 @@ static void local_socket_to_json_array(struct sockets_stats *st, LOCAL_SOCKET *n
 
         // count
         buffer_json_add_array_item_uint64(wb, n->network_viewer.count);
+
+        // key (a string, since javascript cannot hold 64-bit integers)
+        char key_txt[UINT64_HEX_MAX_LENGTH];
+        snprintfz(key_txt, sizeof(key_txt), "%016"PRIx64, (uint64_t)key);
+        buffer_json_add_array_item_string(wb, key_txt);
     }
     buffer_json_array_close(wb);
 }
 
+// returns true when the row changed after the generation of the client
+static bool network_viewer_row_changed(struct sockets_stats *st, XXH64_hash_t key, XXH64_hash_t hash) {
+    NETWORK_VIEWER_ROWS *rows = st->rows;
+
+    SIMPLE_HASHTABLE_SLOT_NETWORK_VIEWER_ROWS *sl =
+        simple_hashtable_get_slot_NETWORK_VIEWER_ROWS(&rows->ht, key, &key, true);
+    NETWORK_VIEWER_ROW *r = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+    if(!r) {
+        r = callocz(1, sizeof(*r));
+        r->key = key;
+        r->hash = hash;
+        r->generation = rows->generation;
+        simple_hashtable_set_slot_NETWORK_VIEWER_ROWS(&rows->ht, sl, key, r);
+    }
+    else if(r->hash != hash || r->removed) {
+        r->hash = hash;
+        r->generation = rows->generation;
+        r->removed = 0;
+    }
+
+    r->seen = rows->generation;
+    return r->generation > st->since;
+}
+
+static void network_viewer_row_to_json(struct sockets_stats *st, LOCAL_SOCKET *n, XXH64_hash_t key, uint64_t proc_self_net_ns_inode, bool aggregated) {
+    BUFFER *wb = st->wb;
+    size_t len = wb->len;
+    size_t count = wb->json.stack[wb->json.depth].count;
+
+    local_socket_to_json_array(st, n, key, proc_self_net_ns_inode, aggregated);
+    if(wb->len == len)
+        return;
+
+    // the row is compared without the comma separating it from the previous one
+    const char *row = &wb->buffer[len];
+    size_t row_len = wb->len - len;
+    if(*row == ',') {
+        row++;
+        row_len--;
+    }
+
+    if(!network_viewer_row_changed(st, key, XXH3_64bits(row, row_len)) && st->delta) {
+        // the client has this row, remove it from the response
+        wb->len = len;
+        wb->buffer[len] = '\0';
+        wb->json.stack[wb->json.depth].count = count;
+    }
+}
+
+// mark the rows not found in this generation as removed, and send the removed ones the client has
+static void network_viewer_rows_removed_to_json(struct sockets_stats *st) {
+    NETWORK_VIEWER_ROWS *rows = st->rows;
+    BUFFER *wb = st->wb;
+
+    if(st->delta)
+        buffer_json_member_add_array(wb, "removed");
+
+    for(SIMPLE_HASHTABLE_SLOT_NETWORK_VIEWER_ROWS *sl = simple_hashtable_first_read_only_NETWORK_VIEWER_ROWS(&rows->ht);
+         sl;
+         sl = simple_hashtable_next_read_only_NETWORK_VIEWER_ROWS(&rows->ht, sl)) {
+        NETWORK_VIEWER_ROW *r = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+        if(!r) continue;
+
+        if(!r->removed && r->seen != rows->generation)
+            r->removed = rows->generation;
+
+        if(!r->removed)
+            continue;
+
+        if(r->removed + NETWORK_VIEWER_KEEP_REMOVED_GENERATIONS < rows->generation) {
+            if(rows->oldest < r->removed)
+                rows->oldest = r->removed;
+
+            simple_hashtable_del_slot_NETWORK_VIEWER_ROWS(&rows->ht, sl);
+            freez(r);
+            continue;
+        }
+
+        if(st->delta && r->removed > st->since) {
+            char key_txt[UINT64_HEX_MAX_LENGTH];
+            snprintfz(key_txt, sizeof(key_txt), "%016"PRIx64, (uint64_t)r->key);
+            buffer_json_add_array_item_string(wb, key_txt);
+        }
+    }
+
+    if(st->delta)
+        buffer_json_array_close(wb); // removed
+}
+
+static XXH64_hash_t local_socket_key(LOCAL_SOCKET *n) {
+    struct {
+        uint64_t inode;
+        uint64_t net_ns_inode;
+        struct socket_endpoint local;
+        struct socket_endpoint remote;
+    } key;
+
+    memset(&key, 0, sizeof(key));
+    key.inode = n->inode;
+    key.net_ns_inode = n->net_ns_inode;
+    key.local = n->local;
+    key.remote = n->remote;
+
+    return XXH3_64bits(&key, sizeof(key));
+}
+
 static void populate_aggregated_key(LOCAL_SOCKET *n) {
     n->network_viewer.count = 1;
 
@@ -272,7 +421,7 @@ static void populate_aggregated_key(LOCAL_SOCKET *n) {
 static void local_sockets_cb_to_json(LS_STATE *ls, LOCAL_SOCKET *n, void *data) {
     struct sockets_stats *st = data;
     populate_aggregated_key(n);
-    local_socket_to_json_array(st, n, ls->proc_self_net_ns_inode, false);
+    network_viewer_row_to_json(st, n, local_socket_key(n), ls->proc_self_net_ns_inode, false);
 }
 
 #define KEEP_THE_BIGGER(a, b) (a) = ((a) < (b)) ? (b) : (a)
@@ -408,6 +557,8 @@ void network_viewer_function(const char *transaction, char *function __maybe_unu
 
     time_t now_s = now_realtime_sec();
     bool aggregated = false;
+    bool delta = false;
+    uint64_t since = 0;
 
     CLEAN_BUFFER *wb = buffer_create(0, NULL);
     buffer_flush(wb);
@@ -473,6 +624,10 @@ void network_viewer_function(const char *transaction, char *function __maybe_unu
         else if(strcmp(param, "sockets:detailed") == 0) {
             aggregated = false;
         }
+        else if(strncmp(param, "generation:", 11) == 0) {
+            since = str2ull(&param[11], NULL);
+            delta = true;
+        }
         else if(strcmp(param, "info") == 0) {
             goto close_and_send;
         }
@@ -489,6 +644,17 @@ void network_viewer_function(const char *transaction, char *function __maybe_unu
     }
 
     {
+        st.rows = aggregated ? &aggregated_rows : &detailed_rows;
+        netdata_mutex_lock(&st.rows->mutex);
+
+        st.rows->generation++;
+        if(!st.rows->oldest)
+            st.rows->oldest = st.rows->generation;
+
+        // deltas are given only for generations the rows still know about
+        st.delta = delta && since >= st.rows->oldest && since < st.rows->generation;
+        st.since = st.delta ? since : 0;
+
         buffer_json_member_add_array(wb, "data");
 
         LS_STATE ls = {
@@ -547,7 +713,8 @@ void network_viewer_function(const char *transaction, char *function __maybe_unu
             qsort(array, added, sizeof(LOCAL_SOCKET *), local_sockets_compar);
 
             for(size_t i = 0; i < added ;i++) {
-                local_socket_to_json_array(&st, array[i], proc_self_net_ns_inode, true);
+                XXH64_hash_t key = XXH3_64bits(&array[i]->network_viewer.aggregated_key, sizeof(array[i]->network_viewer.aggregated_key));
+                network_viewer_row_to_json(&st, array[i], key, proc_self_net_ns_inode, true);
                 string_freez(array[i]->cmdline);
                 freez(array[i]);
             }
@@ -555,7 +722,12 @@ void network_viewer_function(const char *transaction, char *function __maybe_unu
             simple_hashtable_destroy_AGGREGATED_SOCKETS(&ht);
         }
 
-        buffer_json_array_close(wb);
+        buffer_json_array_close(wb); // data
+
+        network_viewer_rows_removed_to_json(&st);
+        buffer_json_member_add_uint64(wb, "generation", st.rows->generation);
+        buffer_json_member_add_boolean(wb, "delta", st.delta);
+        netdata_mutex_unlock(&st.rows->mutex);
         buffer_json_member_add_object(wb, "columns");
         {
             size_t field_id = 0;
@@ -776,6 +948,14 @@ void network_viewer_function(const char *transaction, char *function __maybe_unu
                                         RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_NONE,
                                         aggregated ? (RRDF_FIELD_OPTS_VISIBLE | RRDF_FIELD_OPTS_STICKY) : RRDF_FIELD_OPTS_NONE,
                                         NULL);
+
+            // Key
+            buffer_rrdf_table_add_field(wb, field_id++, "Key", "The key of the row, for delta updates",
+                                        RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                        0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_NONE,
+                                        RRDF_FIELD_OPTS_UNIQUE_KEY,
+                                        NULL);
         }
 
         buffer_json_object_close(wb); // columns
@@ -56,12 +56,19 @@ static inline struct interrupt *get_interrupts_array(size_t lines, int cpus) {
 int do_proc_interrupts(int update_every, usec_t dt) {
     (void)dt;
     static procfile *ff = NULL;
-    static int cpus = -1, do_per_core = CONFIG_BOOLEAN_INVALID;
+    static int cpus = -1, do_per_core = CONFIG_BOOLEAN_INVALID, per_core_every = 1;
+    static size_t per_core_iteration = 0;
     struct interrupt *irrs = NULL;
 
-    if(unlikely(do_per_core == CONFIG_BOOLEAN_INVALID))
+    if(unlikely(do_per_core == CONFIG_BOOLEAN_INVALID)) {
         do_per_core = config_get_boolean_ondemand(CONFIG_SECTION_PLUGIN_PROC_INTERRUPTS, "interrupts per core", CONFIG_BOOLEAN_NO);
 
+        // the per core charts have a dimension per interrupt on each core, so they can be updated less frequently
+        int per_core_update_every = (int)config_get_duration_seconds(CONFIG_SECTION_PLUGIN_PROC_INTERRUPTS, "interrupts per core update every", update_every);
+        if(per_core_update_every > update_every)
+            per_core_every = per_core_update_every / update_every;
+    }
+
     if(unlikely(!ff)) {
         char filename[FILENAME_MAX + 1];
         snprintfz(filename, FILENAME_MAX, "%s%s", netdata_configured_host_prefix, "/proc/interrupts");
@@ -186,7 +193,7 @@ int do_proc_interrupts(int update_every, usec_t dt) {
 
     rrdset_done(st_system_interrupts);
 
-    if(likely(do_per_core != CONFIG_BOOLEAN_NO)) {
+    if(likely(do_per_core != CONFIG_BOOLEAN_NO) && (per_core_iteration++ % per_core_every) == 0) {
         static RRDSET **core_st = NULL;
         static int old_cpus = 0;
 
@@ -216,7 +223,7 @@ int do_proc_interrupts(int update_every, usec_t dt) {
                         , PLUGIN_PROC_NAME
                         , PLUGIN_PROC_MODULE_INTERRUPTS_NAME
                         , NETDATA_CHART_PRIO_INTERRUPTS_PER_CORE + c
-                        , update_every
+                        , update_every * per_core_every
                         , RRDSET_TYPE_STACKED
                 );
 
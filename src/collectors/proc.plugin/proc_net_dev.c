@@ -3,6 +3,12 @@
 #include "plugin_proc.h"
 #include "proc_net_dev_renames.h"
 
+#ifdef HAVE_LIBMNL
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <libmnl/libmnl.h>
+#endif
+
 #define PLUGIN_PROC_MODULE_NETDEV_NAME "/proc/net/dev"
 #define CONFIG_SECTION_PLUGIN_PROC_NETDEV "plugin:" PLUGIN_PROC_CONFIG_NAME ":" PLUGIN_PROC_MODULE_NETDEV_NAME
 
@@ -874,10 +880,235 @@ static bool is_iface_double_linked(struct netdev *d) {
     return iflink != ifindex;
 }
 
+// ----------------------------------------------------------------------------
+// the sources of interface statistics
+//
+// The interfaces are collected either from /proc/net/dev (with their state
+// in /sys/class/net), or with a single RTNETLINK RTM_GETLINK dump, which
+// gives the IFLA_STATS64 counters together with the operstate, the carrier,
+// the mtu and the link of all the interfaces, without parsing text and
+// without opening any file per interface.
+
+typedef enum {
+    NETDEV_SOURCE_AUTO = 0,
+    NETDEV_SOURCE_PROCFILE,
+    NETDEV_SOURCE_NETLINK,
+} NETDEV_SOURCE;
+
+struct netdev_row {
+    char name[IF_NAMESIZE + 1];
+
+    kernel_uint_t rbytes;
+    kernel_uint_t rpackets;
+    kernel_uint_t rerrors;
+    kernel_uint_t rdrops;
+    kernel_uint_t rfifo;
+    kernel_uint_t rframe;
+    kernel_uint_t rcompressed;
+    kernel_uint_t rmulticast;
+
+    kernel_uint_t tbytes;
+    kernel_uint_t tpackets;
+    kernel_uint_t terrors;
+    kernel_uint_t tdrops;
+    kernel_uint_t tfifo;
+    kernel_uint_t tcollisions;
+    kernel_uint_t tcarrier;
+    kernel_uint_t tcompressed;
+
+    // the following are set only by netlink
+    bool link_info;
+    kernel_uint_t operstate;
+    unsigned long long carrier;
+    unsigned long long mtu;
+    bool double_linked;
+};
+
+static struct {
+    struct netdev_row *rows;
+    size_t used;
+    size_t size;
+} netdev_rows = { 0 };
+
+static struct netdev_row *netdev_row_add(const char *name) {
+    if(unlikely(netdev_rows.used == netdev_rows.size)) {
+        netdev_rows.size = (netdev_rows.size) ? netdev_rows.size * 2 : 64;
+        netdev_rows.rows = reallocz(netdev_rows.rows, netdev_rows.size * sizeof(struct netdev_row));
+    }
+
+    struct netdev_row *r = &netdev_rows.rows[netdev_rows.used++];
+    memset(r, 0, sizeof(*r));
+    strncpyz(r->name, name, IF_NAMESIZE);
+    return r;
+}
+
+// returns false when the file cannot be read
+// sets *disable when it cannot be opened at all
+static bool netdev_rows_read_procfile(const char *filename, bool *disable) {
+    static procfile *ff = NULL;
+
+    if(unlikely(!ff)) {
+        ff = procfile_open(filename, " \t,|", PROCFILE_FLAG_DEFAULT);
+        if(unlikely(!ff)) {
+            *disable = true;
+            return false;
+        }
+    }
+
+    ff = procfile_readall(ff);
+    if(unlikely(!ff)) return false; // we will retry to open it next time
+
+    size_t lines = procfile_lines(ff), l;
+    for(l = 2; l < lines ;l++) {
+        // require 17 words on each line
+        if(unlikely(procfile_linewords(ff, l) < 17)) continue;
+
+        char *name = procfile_lineword(ff, l, 0);
+        size_t len = strlen(name);
+        if(name[len - 1] == ':') name[len - 1] = '\0';
+
+        struct netdev_row *r = netdev_row_add(name);
+
+        r->rbytes      = str2kernel_uint_t(procfile_lineword(ff, l, 1));
+        r->rpackets    = str2kernel_uint_t(procfile_lineword(ff, l, 2));
+        r->rerrors     = str2kernel_uint_t(procfile_lineword(ff, l, 3));
+        r->rdrops      = str2kernel_uint_t(procfile_lineword(ff, l, 4));
+        r->rfifo       = str2kernel_uint_t(procfile_lineword(ff, l, 5));
+        r->rframe      = str2kernel_uint_t(procfile_lineword(ff, l, 6));
+        r->rcompressed = str2kernel_uint_t(procfile_lineword(ff, l, 7));
+        r->rmulticast  = str2kernel_uint_t(procfile_lineword(ff, l, 8));
+
+        r->tbytes      = str2kernel_uint_t(procfile_lineword(ff, l, 9));
+        r->tpackets    = str2kernel_uint_t(procfile_lineword(ff, l, 10));
+        r->terrors     = str2kernel_uint_t(procfile_lineword(ff, l, 11));
+        r->tdrops      = str2kernel_uint_t(procfile_lineword(ff, l, 12));
+        r->tfifo       = str2kernel_uint_t(procfile_lineword(ff, l, 13));
+        r->tcollisions = str2kernel_uint_t(procfile_lineword(ff, l, 14));
+        r->tcarrier    = str2kernel_uint_t(procfile_lineword(ff, l, 15));
+        r->tcompressed = str2kernel_uint_t(procfile_lineword(ff, l, 16));
+    }
+
+    return true;
+}
+
+#ifdef HAVE_LIBMNL
+static struct mnl_socket *netdev_nl = NULL;
+
+static int netdev_netlink_attr_cb(const struct nlattr *attr, void *data) {
+    const struct nlattr **tb = data;
+
+    // skip attributes we do not know
+    if(mnl_attr_type_valid(attr, IFLA_MAX) < 0)
+        return MNL_CB_OK;
+
+    tb[mnl_attr_get_type(attr)] = attr;
+    return MNL_CB_OK;
+}
+
+static int netdev_netlink_link_cb(const struct nlmsghdr *nlh, void *data __maybe_unused) {
+    struct ifinfomsg *ifm = mnl_nlmsg_get_payload(nlh);
+    const struct nlattr *tb[IFLA_MAX + 1] = { NULL };
+
+    mnl_attr_parse(nlh, sizeof(*ifm), netdev_netlink_attr_cb, tb);
+    if(unlikely(!tb[IFLA_IFNAME] || !tb[IFLA_STATS64]))
+        return MNL_CB_OK;
+
+    // older and newer kernels may have a different size of this structure
+    struct rtnl_link_stats64 s = { 0 };
+    uint16_t len = mnl_attr_get_payload_len(tb[IFLA_STATS64]);
+    memcpy(&s, mnl_attr_get_payload(tb[IFLA_STATS64]), MIN(len, sizeof(s)));
+
+    struct netdev_row *r = netdev_row_add(mnl_attr_get_str(tb[IFLA_IFNAME]));
+
+    // the same sums the kernel does for /proc/net/dev
+    r->rbytes      = s.rx_bytes;
+    r->rpackets    = s.rx_packets;
+    r->rerrors     = s.rx_errors;
+    r->rdrops      = s.rx_dropped + s.rx_missed_errors;
+    r->rfifo       = s.rx_fifo_errors;
+    r->rframe      = s.rx_length_errors + s.rx_over_errors + s.rx_crc_errors + s.rx_frame_errors;
+    r->rcompressed = s.rx_compressed;
+    r->rmulticast  = s.multicast;
+
+    r->tbytes      = s.tx_bytes;
+    r->tpackets    = s.tx_packets;
+    r->terrors     = s.tx_errors;
+    r->tdrops      = s.tx_dropped;
+    r->tfifo       = s.tx_fifo_errors;
+    r->tcollisions = s.collisions;
+    r->tcarrier    = s.tx_carrier_errors + s.tx_aborted_errors + s.tx_window_errors + s.tx_heartbeat_errors;
+    r->tcompressed = s.tx_compressed;
+
+    r->link_info = true;
+    r->operstate = tb[IFLA_OPERSTATE] ? mnl_attr_get_u8(tb[IFLA_OPERSTATE]) : NETDEV_OPERSTATE_UNKNOWN;
+    r->carrier = tb[IFLA_CARRIER] ? mnl_attr_get_u8(tb[IFLA_CARRIER]) : 0;
+    r->mtu = tb[IFLA_MTU] ? mnl_attr_get_u32(tb[IFLA_MTU]) : 0;
+    r->double_linked = tb[IFLA_LINK] && (int)mnl_attr_get_u32(tb[IFLA_LINK]) != ifm->ifi_index;
+
+    return MNL_CB_OK;
+}
+
+static void netdev_netlink_close(void) {
+    if(netdev_nl) {
+        mnl_socket_close(netdev_nl);
+        netdev_nl = NULL;
+    }
+}
+
+static bool netdev_rows_read_netlink(void) {
+    static char buf[MNL_SOCKET_BUFFER_SIZE * 4];
+    static unsigned int seq = 0;
+
+    if(unlikely(!netdev_nl)) {
+        netdev_nl = mnl_socket_open(NETLINK_ROUTE);
+        if(!netdev_nl) {
+            collector_error("Cannot open RTNETLINK socket.");
+            return false;
+        }
+
+        if(mnl_socket_bind(netdev_nl, 0, MNL_SOCKET_AUTOPID) < 0) {
+            collector_error("Cannot bind RTNETLINK socket.");
+            netdev_netlink_close();
+            return false;
+        }
+    }
+
+    struct nlmsghdr *nlh = mnl_nlmsg_put_header(buf);
+    nlh->nlmsg_type = RTM_GETLINK;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    nlh->nlmsg_seq = ++seq;
+
+    struct ifinfomsg *ifm = mnl_nlmsg_put_extra_header(nlh, sizeof(*ifm));
+    ifm->ifi_family = AF_UNSPEC;
+
+    if(mnl_socket_sendto(netdev_nl, nlh, nlh->nlmsg_len) < 0) {
+        collector_error("Cannot send RTM_GETLINK request.");
+        netdev_netlink_close();
+        return false;
+    }
+
+    unsigned int portid = mnl_socket_get_portid(netdev_nl);
+    ssize_t ret;
+    while((ret = mnl_socket_recvfrom(netdev_nl, buf, sizeof(buf))) > 0) {
+        ret = mnl_cb_run(buf, ret, seq, portid, netdev_netlink_link_cb, NULL);
+        if(ret <= MNL_CB_STOP)
+            break;
+    }
+
+    if(ret == -1) {
+        collector_error("Cannot receive the RTM_GETLINK dump.");
+        netdev_netlink_close();
+        return false;
+    }
+
+    return true;
+}
+#endif
+
 int do_proc_net_dev(int update_every, usec_t dt) {
     (void)dt;
     static SIMPLE_PATTERN *disabled_list = NULL;
-    static procfile *ff = NULL;
+    static NETDEV_SOURCE source = NETDEV_SOURCE_AUTO;
     static int enable_new_interfaces = -1;
     static int do_bandwidth = -1, do_packets = -1, do_errors = -1, do_drops = -1, do_fifo = -1, do_compressed = -1,
                do_events = -1, do_speed = -1, do_duplex = -1, do_operstate = -1, do_carrier = -1, do_mtu = -1;
@@ -924,30 +1155,53 @@ int do_proc_net_dev(int update_every, usec_t dt) {
                 config_get(CONFIG_SECTION_PLUGIN_PROC_NETDEV, "disable by default interfaces matching",
                            "lo fireqos* *-ifb fwpr* fwbr* fwln*"), NULL, SIMPLE_PATTERN_EXACT, true);
 
+        // netlink sees the network namespace of netdata, so when netdata runs
+        // in a container monitoring its host, /proc/1/net/dev is used by default
+        const char *s = config_get(CONFIG_SECTION_PLUGIN_PROC_NETDEV, "collection method", "auto");
+        if(!strcmp(s, "netlink"))
+            source = NETDEV_SOURCE_NETLINK;
+        else if(!strcmp(s, "procfile"))
+            source = NETDEV_SOURCE_PROCFILE;
+        else
+            source = (*netdata_configured_host_prefix) ? NETDEV_SOURCE_PROCFILE : NETDEV_SOURCE_NETLINK;
+
+#ifndef HAVE_LIBMNL
+        if(source == NETDEV_SOURCE_NETLINK) {
+            if(!strcmp(s, "netlink"))
+                collector_error("netdata has been compiled without libmnl, using '%s' to collect network interfaces.", proc_net_dev_filename);
+
+            source = NETDEV_SOURCE_PROCFILE;
+        }
+#endif
+
         netdev_renames_init();
     }
 
-    if(unlikely(!ff)) {
-        ff = procfile_open(proc_net_dev_filename, " \t,|", PROCFILE_FLAG_DEFAULT);
-        if(unlikely(!ff)) return 1;
+    netdev_rows.used = 0;
+
+#ifdef HAVE_LIBMNL
+    if(source == NETDEV_SOURCE_NETLINK && !netdev_rows_read_netlink()) {
+        collector_error("Cannot collect network interfaces with netlink, falling back to '%s'.", proc_net_dev_filename);
+        netdev_netlink_close();
+        netdev_rows.used = 0;
+        source = NETDEV_SOURCE_PROCFILE;
     }
+#endif
 
-    ff = procfile_readall(ff);
-    if(unlikely(!ff)) return 0; // we return 0, so that we will retry to open it next time
+    if(source == NETDEV_SOURCE_PROCFILE) {
+        bool disable = false;
+        if(unlikely(!netdev_rows_read_procfile(proc_net_dev_filename, &disable)))
+            return (disable) ? 1 : 0; // we return 0, so that we will retry to open it next time
+    }
 
     kernel_uint_t system_rbytes = 0;
     kernel_uint_t system_tbytes = 0;
 
     time_t now = now_realtime_sec();
 
-    size_t lines = procfile_lines(ff), l;
-    for(l = 2; l < lines ;l++) {
-        // require 17 words on each line
-        if(unlikely(procfile_linewords(ff, l) < 17)) continue;
-
-        char *name = procfile_lineword(ff, l, 0);
-        size_t len = strlen(name);
-        if(name[len - 1] == ':') name[len - 1] = '\0';
+    for(size_t i = 0; i < netdev_rows.used ;i++) {
+        struct netdev_row *r = &netdev_rows.rows[i];
+        const char *name = r->name;
 
         struct netdev *d = get_netdev(name);
         d->updated = true;
@@ -1009,7 +1263,7 @@ int do_proc_net_dev(int update_every, usec_t dt) {
             if(d->enabled == CONFIG_BOOLEAN_NO)
                 continue;
 
-            d->double_linked = is_iface_double_linked(d);
+            d->double_linked = (r->link_info) ? r->double_linked : is_iface_double_linked(d);
 
             d->do_bandwidth = do_bandwidth;
             d->do_packets = do_packets;
@@ -1064,8 +1318,8 @@ int do_proc_net_dev(int update_every, usec_t dt) {
             continue;
 
         if(likely(d->do_bandwidth != CONFIG_BOOLEAN_NO || !d->virtual)) {
-            d->rbytes      = str2kernel_uint_t(procfile_lineword(ff, l, 1));
-            d->tbytes      = str2kernel_uint_t(procfile_lineword(ff, l, 9));
+            d->rbytes      = r->rbytes;
+            d->tbytes      = r->tbytes;
 
             if(likely(!d->virtual)) {
                 system_rbytes += d->rbytes;
@@ -1074,38 +1328,44 @@ int do_proc_net_dev(int update_every, usec_t dt) {
         }
 
         if(likely(d->do_packets != CONFIG_BOOLEAN_NO)) {
-            d->rpackets    = str2kernel_uint_t(procfile_lineword(ff, l, 2));
-            d->rmulticast  = str2kernel_uint_t(procfile_lineword(ff, l, 8));
-            d->tpackets    = str2kernel_uint_t(procfile_lineword(ff, l, 10));
+            d->rpackets    = r->rpackets;
+            d->rmulticast  = r->rmulticast;
+            d->tpackets    = r->tpackets;
         }
 
         if(likely(d->do_errors != CONFIG_BOOLEAN_NO)) {
-            d->rerrors     = str2kernel_uint_t(procfile_lineword(ff, l, 3));
-            d->terrors     = str2kernel_uint_t(procfile_lineword(ff, l, 11));
+            d->rerrors     = r->rerrors;
+            d->terrors     = r->terrors;
         }
 
         if(likely(d->do_drops != CONFIG_BOOLEAN_NO)) {
-            d->rdrops      = str2kernel_uint_t(procfile_lineword(ff, l, 4));
-            d->tdrops      = str2kernel_uint_t(procfile_lineword(ff, l, 12));
+            d->rdrops      = r->rdrops;
+            d->tdrops      = r->tdrops;
         }
 
         if(likely(d->do_fifo != CONFIG_BOOLEAN_NO)) {
-            d->rfifo       = str2kernel_uint_t(procfile_lineword(ff, l, 5));
-            d->tfifo       = str2kernel_uint_t(procfile_lineword(ff, l, 13));
+            d->rfifo       = r->rfifo;
+            d->tfifo       = r->tfifo;
         }
 
         if(likely(d->do_compressed != CONFIG_BOOLEAN_NO)) {
-            d->rcompressed = str2kernel_uint_t(procfile_lineword(ff, l, 7));
-            d->tcompressed = str2kernel_uint_t(procfile_lineword(ff, l, 16));
+            d->rcompressed = r->rcompressed;
+            d->tcompressed = r->tcompressed;
         }
 
         if(likely(d->do_events != CONFIG_BOOLEAN_NO)) {
-            d->rframe      = str2kernel_uint_t(procfile_lineword(ff, l, 6));
-            d->tcollisions = str2kernel_uint_t(procfile_lineword(ff, l, 14));
-            d->tcarrier    = str2kernel_uint_t(procfile_lineword(ff, l, 15));
+            d->rframe      = r->rframe;
+            d->tcollisions = r->tcollisions;
+            d->tcarrier    = r->tcarrier;
         }
 
-        if ((d->do_carrier != CONFIG_BOOLEAN_NO ||
+        if (r->link_info) {
+            // netlink gives the carrier of all interfaces, even when they are down
+            d->carrier = r->carrier;
+            d->carrier_file_exists = 1;
+            d->carrier_file_lost_time = 0;
+        }
+        else if ((d->do_carrier != CONFIG_BOOLEAN_NO ||
              d->do_duplex != CONFIG_BOOLEAN_NO ||
              d->do_speed != CONFIG_BOOLEAN_NO) &&
              d->filename_carrier &&
@@ -1154,7 +1414,9 @@ int do_proc_net_dev(int update_every, usec_t dt) {
             d->duplex = NETDEV_DUPLEX_UNKNOWN;
         }
 
-        if(d->do_operstate != CONFIG_BOOLEAN_NO && d->filename_operstate) {
+        if(d->do_operstate != CONFIG_BOOLEAN_NO && d->filename_operstate && r->link_info)
+            d->operstate = r->operstate;
+        else if(d->do_operstate != CONFIG_BOOLEAN_NO && d->filename_operstate) {
             char buffer[STATE_LENGTH_MAX + 1], *trimmed_buffer;
 
             if (read_txt_file(d->filename_operstate, buffer, sizeof(buffer))) {
@@ -1169,7 +1431,9 @@ int do_proc_net_dev(int update_every, usec_t dt) {
             }
         }
 
-        if (d->do_mtu != CONFIG_BOOLEAN_NO && d->filename_mtu) {
+        if (d->do_mtu != CONFIG_BOOLEAN_NO && d->filename_mtu && r->link_info)
+            d->mtu = r->mtu;
+        else if (d->do_mtu != CONFIG_BOOLEAN_NO && d->filename_mtu) {
             if (read_single_number_file(d->filename_mtu, &d->mtu)) {
                 collector_error(
                     "Cannot refresh mtu for interface %s by reading '%s'. Stop updating it.", d->name, d->filename_mtu);
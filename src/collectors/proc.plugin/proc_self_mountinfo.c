@@ -242,6 +242,11 @@ struct mountinfo *mountinfo_read(int do_statvfs) {
             DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_NAME_LINK_DONT_CLONE,
             &dictionary_stats_category_collectors, 0);
 
+    // the mount that represents each device, so that binds and duplicates
+    // are found without comparing every mount with all the previous ones
+    Pvoid_t devices_JudyL = NULL;
+    Pvoid_t st_devs_JudyL = NULL;
+
     unsigned long l, lines = procfile_lines(ff);
     for(l = 0; l < lines ;l++) {
         if(unlikely(procfile_linewords(ff, l) < 5))
@@ -364,15 +369,17 @@ struct mountinfo *mountinfo_read(int do_statvfs) {
                 else {
                     mi->st_dev = buf.st_dev;
 
-                    struct mountinfo *mt;
-                    for(mt = root; mt; mt = mt->next) {
-                        if(unlikely(mt->st_dev == mi->st_dev && !(mt->flags & MOUNTINFO_IS_SAME_DEV))) {
-                            if(strlen(mi->mount_point) < strlen(mt->mount_point))
-                                mt->flags |= MOUNTINFO_IS_SAME_DEV;
-                            else
-                                mi->flags |= MOUNTINFO_IS_SAME_DEV;
-                        }
+                    // within the same st_dev, the shorter mount point is the one kept
+                    Pvoid_t *PValue = JudyLIns(&st_devs_JudyL, (Word_t)mi->st_dev, PJE0);
+                    struct mountinfo *mt = *PValue;
+                    if(!mt)
+                        *PValue = mi;
+                    else if(strlen(mi->mount_point) < strlen(mt->mount_point)) {
+                        mt->flags |= MOUNTINFO_IS_SAME_DEV;
+                        *PValue = mi;
                     }
+                    else
+                        mi->flags |= MOUNTINFO_IS_SAME_DEV;
                 }
             }
             else {
@@ -381,15 +388,16 @@ struct mountinfo *mountinfo_read(int do_statvfs) {
 
             //try to detect devices with same minor and major modes. Within these,
             //the larger mount point is considered a bind.
-            struct mountinfo *mt;
-            for(mt = root; mt; mt = mt->next) {
-                if(unlikely(mt->major == mi->major && mt->minor == mi->minor && !(mi->flags & MOUNTINFO_IS_BIND))) {
-                    if(strlen(mi->root) < strlen(mt->root))
-                        mt->flags |= MOUNTINFO_IS_BIND;
-                    else
-                        mi->flags |= MOUNTINFO_IS_BIND;
-                }
+            Pvoid_t *PValue = JudyLIns(&devices_JudyL, (Word_t)makedev(mi->major, mi->minor), PJE0);
+            struct mountinfo *mt = *PValue;
+            if(!mt)
+                *PValue = mi;
+            else if(strlen(mi->root) < strlen(mt->root)) {
+                mt->flags |= MOUNTINFO_IS_BIND;
+                *PValue = mi;
             }
+            else
+                mi->flags |= MOUNTINFO_IS_BIND;
         }
         else {
             mi->filesystem = NULL;
@@ -483,6 +491,8 @@ struct mountinfo *mountinfo_read(int do_statvfs) {
     }
 */
 
+    JudyLFreeArray(&devices_JudyL, PJE0);
+    JudyLFreeArray(&st_devs_JudyL, PJE0);
     dictionary_destroy(dict);
     procfile_close(ff);
     return root;
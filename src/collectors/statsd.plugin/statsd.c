@@ -20,12 +20,13 @@
 
 // --------------------------------------------------------------------------------------
 
-// DO NOT ENABLE MULTITHREADING - IT IS NOT WELL TESTED
-// #define STATSD_MULTITHREADED 1
-
 #define STATSD_DICTIONARY_OPTIONS (DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_ADD_IN_FRONT)
 #define STATSD_DECIMAL_DETAIL 1000 // floating point values get multiplied by this, with the same divisor
 
+#define STATSD_OVERFLOW_METRIC "__overflow__" // metrics beyond the cardinality limits are collapsed into this
+#define STATSD_NO_PREFIX "."                  // the prefix of metrics without a dot in their names
+#define STATSD_METRIC_OVERFLOW_NAME_MAX 256
+
 // --------------------------------------------------------------------------------------------------------------------
 // data specific to each metric type
 
@@ -37,13 +38,20 @@ typedef struct statsd_metric_counter { // counter and meter
     collected_number value;
 } STATSD_METRIC_COUNTER;
 
+#define STATSD_HISTOGRAM_PERCENTILES_MAX 16
+
+typedef struct statsd_histogram_percentile {
+    NETDATA_DOUBLE percentile;
+    collected_number last;
+    RRDDIM *rd;
+} STATSD_HISTOGRAM_PERCENTILE;
+
 typedef struct statsd_histogram_extensions {
     netdata_mutex_t mutex;
 
     // average is stored in metric->last
     collected_number last_min;
     collected_number last_max;
-    collected_number last_percentile;
     collected_number last_median;
     collected_number last_stddev;
     collected_number last_sum;
@@ -52,14 +60,15 @@ typedef struct statsd_histogram_extensions {
 
     RRDDIM *rd_min;
     RRDDIM *rd_max;
-    RRDDIM *rd_percentile;
     RRDDIM *rd_median;
     RRDDIM *rd_stddev;
     //RRDDIM *rd_sum;
 
-    uint32_t size;
-    uint32_t used;
-    NETDATA_DOUBLE *values;   // dynamic array of values collected
+    // the global percentiles first, then the ones requested by apps for this metric
+    uint32_t percentiles_count;
+    STATSD_HISTOGRAM_PERCENTILE percentiles[STATSD_HISTOGRAM_PERCENTILES_MAX];
+
+    QUANTILE_SKETCH sketch;   // the values collected since the last flush
 } STATSD_METRIC_HISTOGRAM_EXTENSIONS;
 
 typedef struct statsd_metric_histogram { // histogram and timer
@@ -108,6 +117,15 @@ typedef enum __attribute__((packed)) statsd_metric_type {
     STATSD_METRIC_TYPE_DICTIONARY
 } STATSD_METRIC_TYPE;
 
+#define STATSD_METRIC_TYPES (STATSD_METRIC_TYPE_DICTIONARY + 1)
+
+
+// the metrics sharing the same prefix, i.e. the name up to the first dot
+typedef struct statsd_prefix {
+    uint32_t metrics;               // the number of metrics with this prefix
+    SPINLOCK spinlock;
+    HYPERLOGLOG *overflowed;        // the distinct names collapsed into the overflow metric, allocated on first use
+} STATSD_PREFIX;
 
 typedef struct statsd_metric {
     const char *name;               // the name of the metric - linked to dictionary name
@@ -133,9 +151,12 @@ typedef struct statsd_metric {
     char *dimname;
     char *family;
 
+    STATSD_PREFIX *prefix;          // set when there is a cardinality limit per prefix
+
     // chart related members
     STATS_METRIC_OPTIONS options;   // STATSD_METRIC_OPTION_* (bitfield)
     char reset;                     // set to 1 by the charting thread to instruct the collector thread(s) to reset this metric
+    SPINLOCK spinlock;              // serializes the collector threads updating this metric, when there are many
     collected_number last;          // the last value sent to netdata
     RRDSET *st;                     // the private chart of this metric
     RRDDIM *rd_value;               // the dimension of this metric value
@@ -151,13 +172,13 @@ typedef struct statsd_metric {
 
 typedef struct statsd_index {
     char *name;                     // the name of the index of metrics
-    uint32_t events;                // the number of events processed for this index
     uint32_t metrics;               // the number of metrics in this index
     uint32_t useful;                // the number of useful metrics in this index
 
     STATS_METRIC_OPTIONS default_options;  // default options for all metrics in this index
     STATSD_METRIC_TYPE type;        // the type of index
     DICTIONARY *dict;
+    struct dictionary_stats *dict_stats; // the memory accounting of the index and the dictionaries of its metrics
 
     STATSD_METRIC *first_useful;    // the linked list of useful metrics (new metrics are added in front)
 } STATSD_INDEX;
@@ -189,6 +210,7 @@ typedef struct statsd_app_chart_dimension {
     RRD_ALGORITHM algorithm;        // the algorithm of this dimension
 
     STATSD_APP_CHART_DIM_VALUE_TYPE value_type; // which value to use of the source metric
+    NETDATA_DOUBLE percentile;      // the percentile, for value type percentile, or 0 for the global one
 
     SIMPLE_PATTERN *metric_pattern; // set when the 'metric' is a simple pattern
 
@@ -224,6 +246,11 @@ typedef struct statsd_app {
     int32_t rrd_history_entries;
     DICTIONARY *dict;
 
+    uint32_t cardinality_limit;     // the max number of metrics matching this app, 0 = unlimited
+    uint32_t cardinality;           // the number of metrics matching this app, when limited
+    SPINLOCK spinlock;
+    HYPERLOGLOG *overflowed;        // the distinct names collapsed into the overflow metric, allocated on first use
+
     const char *source;
     STATSD_APP_CHART *charts;
     struct statsd_app *next;
@@ -232,14 +259,37 @@ typedef struct statsd_app {
 // --------------------------------------------------------------------------------------------------------------------
 // global statsd data
 
+// each collection thread updates only its own statistics,
+// and the charting thread sums them up
+struct statsd_thread_stats {
+    size_t events[STATSD_METRIC_TYPES];
+    size_t unknown_types;
+    size_t socket_errors;
+    size_t tcp_socket_connects;
+    size_t tcp_socket_disconnects;
+    size_t tcp_socket_connected;
+    size_t tcp_socket_reads;
+    size_t tcp_packets_received;
+    size_t tcp_bytes_read;
+    size_t udp_socket_reads;
+    size_t udp_packets_received;
+    size_t udp_bytes_read;
+    size_t overflow_events;
+};
+
 struct collection_thread_status {
     SPINLOCK spinlock;
     bool running;
     uint32_t max_sockets;
 
+    LISTEN_SOCKETS *sockets;        // the statsd sockets, or this thread's clone of them
+    struct statsd_thread_stats stats;
+
     ND_THREAD *thread;
 };
 
+static __thread struct statsd_thread_stats *statsd_stats = NULL;
+
 static struct statsd {
     STATSD_INDEX gauges;
     STATSD_INDEX counters;
@@ -249,18 +299,6 @@ static struct statsd {
     STATSD_INDEX sets;
     STATSD_INDEX dictionaries;
 
-    size_t unknown_types;
-    size_t socket_errors;
-    size_t tcp_socket_connects;
-    size_t tcp_socket_disconnects;
-    size_t tcp_socket_connected;
-    size_t tcp_socket_reads;
-    size_t tcp_packets_received;
-    size_t tcp_bytes_read;
-    size_t udp_socket_reads;
-    size_t udp_packets_received;
-    size_t udp_bytes_read;
-
     int32_t update_every;
     bool enabled;
     bool private_charts_hidden;
@@ -272,12 +310,20 @@ static struct statsd {
     uint32_t max_private_charts_hard;
     uint32_t set_obsolete_after;
 
+    uint32_t cardinality_limit_per_prefix;  // 0 = unlimited
+    bool apps_cardinality_limits;           // at least one app has a cardinality limit
+    DICTIONARY *prefixes;
+
     STATSD_APP *apps;
     uint32_t recvmmsg_size;
-    uint32_t histogram_increase_step;
     uint32_t dictionary_max_unique;
     double histogram_percentile;
     char *histogram_percentile_str;
+    uint32_t histogram_percentiles_count;
+    NETDATA_DOUBLE histogram_percentiles[STATSD_HISTOGRAM_PERCENTILES_MAX];
+    char *histogram_percentiles_str[STATSD_HISTOGRAM_PERCENTILES_MAX];
+    NETDATA_DOUBLE histogram_relative_accuracy;
+    uint32_t histogram_max_buckets;
 
     int threads;
     struct collection_thread_status *collection_threads_status;
@@ -292,7 +338,6 @@ static struct statsd {
 
         .gauges     = {
                 .name = "gauge",
-                .events = 0,
                 .metrics = 0,
                 .dict = NULL,
                 .type = STATSD_METRIC_TYPE_GAUGE,
@@ -300,7 +345,6 @@ static struct statsd {
         },
         .counters   = {
                 .name = "counter",
-                .events = 0,
                 .metrics = 0,
                 .dict = NULL,
                 .type = STATSD_METRIC_TYPE_COUNTER,
@@ -308,7 +352,6 @@ static struct statsd {
         },
         .timers     = {
                 .name = "timer",
-                .events = 0,
                 .metrics = 0,
                 .dict = NULL,
                 .type = STATSD_METRIC_TYPE_TIMER,
@@ -316,7 +359,6 @@ static struct statsd {
         },
         .histograms = {
                 .name = "histogram",
-                .events = 0,
                 .metrics = 0,
                 .dict = NULL,
                 .type = STATSD_METRIC_TYPE_HISTOGRAM,
@@ -324,7 +366,6 @@ static struct statsd {
         },
         .meters     = {
                 .name = "meter",
-                .events = 0,
                 .metrics = 0,
                 .dict = NULL,
                 .type = STATSD_METRIC_TYPE_METER,
@@ -332,7 +373,6 @@ static struct statsd {
         },
         .sets       = {
                 .name = "set",
-                .events = 0,
                 .metrics = 0,
                 .dict = NULL,
                 .type = STATSD_METRIC_TYPE_SET,
@@ -340,7 +380,6 @@ static struct statsd {
         },
         .dictionaries = {
                 .name = "dictionary",
-                .events = 0,
                 .metrics = 0,
                 .dict = NULL,
                 .type = STATSD_METRIC_TYPE_DICTIONARY,
@@ -348,10 +387,12 @@ static struct statsd {
         },
 
         .tcp_idle_timeout = 600,
+        .cardinality_limit_per_prefix = 10000,
 
         .apps = NULL,
         .histogram_percentile = 95.0,
-        .histogram_increase_step = 10,
+        .histogram_relative_accuracy = 1.0,
+        .histogram_max_buckets = 2048,
         .dictionary_max_unique = 200,
         .threads = 0,
         .collection_threads_status = NULL,
@@ -368,6 +409,141 @@ static struct statsd {
 // --------------------------------------------------------------------------------------------------------------------
 // statsd index management - add/find metrics
 
+// ----------------------------------------------------------------------------
+// cardinality limits
+//
+// A new metric is admitted only while its prefix and the apps it matches have room for it.
+// When they don't, its values are collapsed into the overflow metric of its prefix (or app),
+// which always exists, and the distinct names collapsed are estimated with a HyperLogLog.
+
+static inline bool statsd_cardinality_limits_enabled(void) {
+    return statsd.cardinality_limit_per_prefix || statsd.apps_cardinality_limits;
+}
+
+static inline size_t statsd_metric_prefix_length(const char *name) {
+    const char *dot = strchr(name, '.');
+    return dot ? (size_t)(dot - name) : 0;
+}
+
+static STATSD_PREFIX *statsd_prefix_get(const char *name) {
+    size_t len = statsd_metric_prefix_length(name);
+    if(!len)
+        return dictionary_set(statsd.prefixes, STATSD_NO_PREFIX, NULL, sizeof(STATSD_PREFIX));
+
+    char prefix[len + 1];
+    memcpy(prefix, name, len);
+    prefix[len] = '\0';
+    return dictionary_set(statsd.prefixes, prefix, NULL, sizeof(STATSD_PREFIX));
+}
+
+static void statsd_overflowed_add(SPINLOCK *spinlock, HYPERLOGLOG **hll, const char *name, const char *limited, uint32_t limit) {
+    if(unlikely(!__atomic_load_n(hll, __ATOMIC_ACQUIRE))) {
+        spinlock_lock(spinlock);
+        if(!*hll) {
+            collector_error("STATSD: '%s' reached its cardinality limit of %u metrics. "
+                            "Metric '%s' and all the new ones are collapsed into its " STATSD_OVERFLOW_METRIC " metric.",
+                            limited, limit, name);
+            __atomic_store_n(hll, callocz(1, sizeof(HYPERLOGLOG)), __ATOMIC_RELEASE);
+        }
+        spinlock_unlock(spinlock);
+    }
+
+    hyperloglog_add(*hll, XXH3_64bits(name, strlen(name)));
+}
+
+// returns the name the new metric should be added with
+static const char *statsd_cardinality_admit(const char *name, char *dst, size_t dst_size) {
+    size_t len = statsd_metric_prefix_length(name);
+    const char *suffix = len ? &name[len + 1] : name;
+    if(unlikely(!strcmp(suffix, STATSD_OVERFLOW_METRIC)))
+        return name;
+
+    if(statsd.cardinality_limit_per_prefix) {
+        STATSD_PREFIX *prefix = statsd_prefix_get(name);
+        if(unlikely(__atomic_load_n(&prefix->metrics, __ATOMIC_RELAXED) >= statsd.cardinality_limit_per_prefix)) {
+            char limited[len + 1];
+            memcpy(limited, name, len);
+            limited[len] = '\0';
+
+            statsd_overflowed_add(&prefix->spinlock, &prefix->overflowed, name, len ? limited : STATSD_NO_PREFIX, statsd.cardinality_limit_per_prefix);
+            statsd_stats->overflow_events++;
+
+            if(len)
+                snprintfz(dst, dst_size - 1, "%s." STATSD_OVERFLOW_METRIC, limited);
+            else
+                snprintfz(dst, dst_size - 1, STATSD_OVERFLOW_METRIC);
+
+            return dst;
+        }
+    }
+
+    if(statsd.apps_cardinality_limits) {
+        STATSD_APP *app;
+        for(app = statsd.apps; app ;app = app->next) {
+            if(!app->cardinality_limit ||
+                __atomic_load_n(&app->cardinality, __ATOMIC_RELAXED) < app->cardinality_limit ||
+                !simple_pattern_matches(app->metrics, name))
+                continue;
+
+            statsd_overflowed_add(&app->spinlock, &app->overflowed, name, app->name, app->cardinality_limit);
+            statsd_stats->overflow_events++;
+
+            snprintfz(dst, dst_size - 1, "%s." STATSD_OVERFLOW_METRIC, app->name);
+            return dst;
+        }
+    }
+
+    return name;
+}
+
+// keep track of the metrics counted towards the limits
+static void statsd_cardinality_account(STATSD_METRIC *m, int32_t delta) {
+    if(statsd.cardinality_limit_per_prefix) {
+        if(!m->prefix)
+            m->prefix = statsd_prefix_get(m->name);
+
+        __atomic_add_fetch(&m->prefix->metrics, delta, __ATOMIC_RELAXED);
+    }
+
+    if(statsd.apps_cardinality_limits) {
+        STATSD_APP *app;
+        for(app = statsd.apps; app ;app = app->next) {
+            if(app->cardinality_limit && simple_pattern_matches(app->metrics, m->name))
+                __atomic_add_fetch(&app->cardinality, delta, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static size_t statsd_cardinality_overflowed_estimate(void) {
+    NETDATA_DOUBLE estimate = 0.0;
+
+    if(statsd.prefixes) {
+        STATSD_PREFIX *prefix;
+        dfe_start_read(statsd.prefixes, prefix) {
+            HYPERLOGLOG *hll = __atomic_load_n(&prefix->overflowed, __ATOMIC_ACQUIRE);
+            if(hll)
+                estimate += hyperloglog_estimate(hll);
+        }
+        dfe_done(prefix);
+    }
+
+    STATSD_APP *app;
+    for(app = statsd.apps; app ;app = app->next) {
+        HYPERLOGLOG *hll = __atomic_load_n(&app->overflowed, __ATOMIC_ACQUIRE);
+        if(hll)
+            estimate += hyperloglog_estimate(hll);
+    }
+
+    return (size_t)roundndd(estimate);
+}
+
+static void dictionary_prefix_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused) {
+    STATSD_PREFIX *prefix = (STATSD_PREFIX *)value;
+    freez(prefix->overflowed);
+}
+
+// ----------------------------------------------------------------------------
+
 static void dictionary_metric_insert_callback(const DICTIONARY_ITEM *item, void *value, void *data) {
     STATSD_INDEX *index = (STATSD_INDEX *)data;
     STATSD_METRIC *m = (STATSD_METRIC *)value;
@@ -379,12 +555,21 @@ static void dictionary_metric_insert_callback(const DICTIONARY_ITEM *item, void
     m->hash = simple_hash(name);
     m->type = index->type;
     m->options = index->default_options;
+    spinlock_init(&m->spinlock);
 
     if (m->type == STATSD_METRIC_TYPE_HISTOGRAM || m->type == STATSD_METRIC_TYPE_TIMER) {
         m->histogram.ext = callocz(1,sizeof(STATSD_METRIC_HISTOGRAM_EXTENSIONS));
         netdata_mutex_init(&m->histogram.ext->mutex);
+        quantile_sketch_init(&m->histogram.ext->sketch, statsd.histogram_relative_accuracy / 100.0, statsd.histogram_max_buckets);
+
+        m->histogram.ext->percentiles_count = statsd.histogram_percentiles_count;
+        for(uint32_t i = 0; i < statsd.histogram_percentiles_count ;i++)
+            m->histogram.ext->percentiles[i].percentile = statsd.histogram_percentiles[i];
     }
 
+    if(statsd_cardinality_limits_enabled())
+        statsd_cardinality_account(m, 1);
+
     __atomic_fetch_add(&index->metrics, 1, __ATOMIC_RELAXED);
 }
 
@@ -393,7 +578,11 @@ static void dictionary_metric_delete_callback(const DICTIONARY_ITEM *item, void
     (void)item;
     STATSD_METRIC *m = (STATSD_METRIC *)value;
 
+    if(statsd_cardinality_limits_enabled())
+        statsd_cardinality_account(m, -1);
+
     if(m->type == STATSD_METRIC_TYPE_HISTOGRAM || m->type == STATSD_METRIC_TYPE_TIMER) {
+        quantile_sketch_free(&m->histogram.ext->sketch);
         freez(m->histogram.ext);
         m->histogram.ext = NULL;
     }
@@ -406,19 +595,27 @@ static void dictionary_metric_delete_callback(const DICTIONARY_ITEM *item, void
 static inline STATSD_METRIC *statsd_find_or_add_metric(STATSD_INDEX *index, const char *name) {
     netdata_log_debug(D_STATSD, "searching for metric '%s' under '%s'", name, index->name);
 
-#ifdef STATSD_MULTITHREADED
-    // avoid the write lock of dictionary_set() for existing metrics
-    STATSD_METRIC *m = dictionary_get(index->dict, name);
-    if(!m) m = dictionary_set(index->dict, name, NULL, sizeof(STATSD_METRIC));
-#else
-    // no locks here, go faster
-    // this will call the dictionary_metric_insert_callback() if an item
-    // is inserted, otherwise it will return the existing one.
-    // We used the flag DICT_OPTION_DONT_OVERWRITE_VALUE to support this.
-    STATSD_METRIC *m = dictionary_set(index->dict, name, NULL, sizeof(STATSD_METRIC));
-#endif
+    STATSD_METRIC *m;
+    if(statsd.threads > 1 || statsd_cardinality_limits_enabled()) {
+        // avoid the write lock of dictionary_set() for existing metrics,
+        // so that the collection threads do not serialize on the index
+        m = dictionary_get(index->dict, name);
+        if(!m) {
+            char overflow[STATSD_METRIC_OVERFLOW_NAME_MAX + 1];
+            if(statsd_cardinality_limits_enabled())
+                name = statsd_cardinality_admit(name, overflow, sizeof(overflow));
+
+            m = dictionary_set(index->dict, name, NULL, sizeof(STATSD_METRIC));
+        }
+    }
+    else {
+        // this will call the dictionary_metric_insert_callback() if an item
+        // is inserted, otherwise it will return the existing one.
+        // We used the flag DICT_OPTION_DONT_OVERWRITE_VALUE to support this.
+        m = dictionary_set(index->dict, name, NULL, sizeof(STATSD_METRIC));
+    }
 
-    index->events++;
+    statsd_stats->events[index->type]++;
     return m;
 }
 
@@ -467,6 +664,30 @@ static inline long long statsd_parse_int(const char *v, long long def) {
 // --------------------------------------------------------------------------------------------------------------------
 // statsd processors per metric type
 
+// with a single collection thread, nothing else updates the metrics
+static inline void statsd_metric_lock(STATSD_METRIC *m) {
+    if(unlikely(statsd.threads > 1))
+        spinlock_lock(&m->spinlock);
+}
+
+static inline void statsd_metric_unlock(STATSD_METRIC *m) {
+    if(unlikely(statsd.threads > 1))
+        spinlock_unlock(&m->spinlock);
+}
+
+static inline STATSD_INDEX *statsd_index_of_type(STATSD_METRIC_TYPE type) {
+    switch(type) {
+        case STATSD_METRIC_TYPE_GAUGE: return &statsd.gauges;
+        case STATSD_METRIC_TYPE_COUNTER: return &statsd.counters;
+        case STATSD_METRIC_TYPE_METER: return &statsd.meters;
+        case STATSD_METRIC_TYPE_TIMER: return &statsd.timers;
+        case STATSD_METRIC_TYPE_HISTOGRAM: return &statsd.histograms;
+        case STATSD_METRIC_TYPE_SET: return &statsd.sets;
+        default:
+        case STATSD_METRIC_TYPE_DICTIONARY: return &statsd.dictionaries;
+    }
+}
+
 static inline void statsd_reset_metric(STATSD_METRIC *m) {
     m->reset = 0;
     m->count = 0;
@@ -497,6 +718,8 @@ static inline void statsd_process_gauge(STATSD_METRIC *m, const char *value, con
         return;
     }
 
+    statsd_metric_lock(m);
+
     if(unlikely(m->reset)) {
         // no need to reset anything specific for gauges
         statsd_reset_metric(m);
@@ -513,6 +736,8 @@ static inline void statsd_process_gauge(STATSD_METRIC *m, const char *value, con
 
         metric_update_counters_and_obsoletion(m);
     }
+
+    statsd_metric_unlock(m);
 }
 
 static inline void statsd_process_counter_or_meter(STATSD_METRIC *m, const char *value, const char *sampling) {
@@ -520,6 +745,8 @@ static inline void statsd_process_counter_or_meter(STATSD_METRIC *m, const char
 
     // we accept empty values for counters
 
+    statsd_metric_lock(m);
+
     if(unlikely(m->reset)) statsd_reset_metric(m);
 
     if(unlikely(value_is_zinit(value))) {
@@ -530,6 +757,8 @@ static inline void statsd_process_counter_or_meter(STATSD_METRIC *m, const char
 
         metric_update_counters_and_obsoletion(m);
     }
+
+    statsd_metric_unlock(m);
 }
 
 #define statsd_process_counter(m, value, sampling) statsd_process_counter_or_meter(m, value, sampling)
@@ -543,8 +772,12 @@ static inline void statsd_process_histogram_or_timer(STATSD_METRIC *m, const cha
         return;
     }
 
+    statsd_metric_lock(m);
+
     if(unlikely(m->reset)) {
-        m->histogram.ext->used = 0;
+        netdata_mutex_lock(&m->histogram.ext->mutex);
+        quantile_sketch_reset(&m->histogram.ext->sketch);
+        netdata_mutex_unlock(&m->histogram.ext->mutex);
         statsd_reset_metric(m);
     }
 
@@ -558,20 +791,16 @@ static inline void statsd_process_histogram_or_timer(STATSD_METRIC *m, const cha
         if(unlikely(isgreater(sampling_rate, 1.0))) sampling_rate = 1.0;
 
         long long samples = llrintndd(1.0 / sampling_rate);
-        while(samples-- > 0) {
-
-            if(unlikely(m->histogram.ext->used == m->histogram.ext->size)) {
-                netdata_mutex_lock(&m->histogram.ext->mutex);
-                m->histogram.ext->size += statsd.histogram_increase_step;
-                m->histogram.ext->values = reallocz(m->histogram.ext->values, sizeof(NETDATA_DOUBLE) * m->histogram.ext->size);
-                netdata_mutex_unlock(&m->histogram.ext->mutex);
-            }
-
-            m->histogram.ext->values[m->histogram.ext->used++] = v;
+        if(samples > 0) {
+            netdata_mutex_lock(&m->histogram.ext->mutex);
+            quantile_sketch_add(&m->histogram.ext->sketch, v, (uint64_t)samples);
+            netdata_mutex_unlock(&m->histogram.ext->mutex);
         }
 
         metric_update_counters_and_obsoletion(m);
     }
+
+    statsd_metric_unlock(m);
 }
 
 #define statsd_process_timer(m, value, sampling) statsd_process_histogram_or_timer(m, value, sampling, "timer")
@@ -585,6 +814,8 @@ static inline void statsd_process_set(STATSD_METRIC *m, const char *value) {
         return;
     }
 
+    statsd_metric_lock(m);
+
     if(unlikely(m->reset)) {
         if(likely(m->set.dict)) {
             dictionary_destroy(m->set.dict);
@@ -594,21 +825,17 @@ static inline void statsd_process_set(STATSD_METRIC *m, const char *value) {
     }
 
     if (unlikely(!m->set.dict))
-        m->set.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
+        m->set.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, statsd.sets.dict_stats, 0);
 
     if(unlikely(value_is_zinit(value))) {
         // magic loading of metric, without affecting anything
     }
     else {
-#ifdef STATSD_MULTITHREADED
-        // avoid the write lock to check if something is already there
-        if(!dictionary_get(m->set.dict, value))
-            dictionary_set(m->set.dict, value, NULL, 0);
-#else
         dictionary_set(m->set.dict, value, NULL, 0);
-#endif
         metric_update_counters_and_obsoletion(m);
     }
+
+    statsd_metric_unlock(m);
 }
 
 static inline void statsd_process_dictionary(STATSD_METRIC *m, const char *value) {
@@ -619,11 +846,13 @@ static inline void statsd_process_dictionary(STATSD_METRIC *m, const char *value
         return;
     }
 
+    statsd_metric_lock(m);
+
     if(unlikely(m->reset))
         statsd_reset_metric(m);
 
     if (unlikely(!m->dictionary.dict))
-        m->dictionary.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
+        m->dictionary.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, statsd.dictionaries.dict_stats, 0);
 
     if(unlikely(value_is_zinit(value))) {
         // magic loading of metric, without affecting anything
@@ -641,6 +870,8 @@ static inline void statsd_process_dictionary(STATSD_METRIC *m, const char *value
         t->count++;
         metric_update_counters_and_obsoletion(m);
     }
+
+    statsd_metric_unlock(m);
 }
 
 
@@ -727,11 +958,13 @@ static void statsd_process_metric(const char *name, const char *value, const cha
             value, sampling);
     }
     else {
-        statsd.unknown_types++;
+        statsd_stats->unknown_types++;
         netdata_log_error("STATSD: metric '%s' with value '%s' is sent with unknown metric type '%s'", name, value?value:"", type);
     }
 
     if(m && tags && *tags) {
+        statsd_metric_lock(m);
+
         const char *s = tags;
         while(*s) {
             const char *tagkey = NULL, *tagvalue = NULL;
@@ -771,6 +1004,8 @@ static void statsd_process_metric(const char *name, const char *value, const cha
                 }
             }
         }
+
+        statsd_metric_unlock(m);
     }
 }
 
@@ -883,8 +1118,8 @@ static void *statsd_add_callback(POLLINFO *pi, short int *events, void *data) {
     struct statsd_tcp *t = (struct statsd_tcp *)callocz(sizeof(struct statsd_tcp) + STATSD_TCP_BUFFER_SIZE, 1);
     t->type = STATSD_SOCKET_DATA_TYPE_TCP;
     t->size = STATSD_TCP_BUFFER_SIZE - 1;
-    statsd.tcp_socket_connects++;
-    statsd.tcp_socket_connected++;
+    statsd_stats->tcp_socket_connects++;
+    statsd_stats->tcp_socket_connected++;
 
     worker_is_idle();
     return t;
@@ -899,12 +1134,12 @@ static void statsd_del_callback(POLLINFO *pi) {
     if(likely(t)) {
         if(t->type == STATSD_SOCKET_DATA_TYPE_TCP) {
             if(t->len != 0) {
-                statsd.socket_errors++;
+                statsd_stats->socket_errors++;
                 netdata_log_error("STATSD: client is probably sending unterminated metrics. Closed socket left with '%s'. Trying to process it.", t->buffer);
                 statsd_process(t->buffer, t->len, 0);
             }
-            statsd.tcp_socket_disconnects++;
-            statsd.tcp_socket_connected--;
+            statsd_stats->tcp_socket_disconnects++;
+            statsd_stats->tcp_socket_connected--;
         }
         else
             netdata_log_error("STATSD: internal error: received socket data type is %d, but expected %d", (int)t->type, (int)STATSD_SOCKET_DATA_TYPE_TCP);
@@ -929,7 +1164,7 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
             struct statsd_tcp *d = (struct statsd_tcp *)pi->data;
             if(unlikely(!d)) {
                 netdata_log_error("STATSD: internal error: expected TCP data pointer is NULL");
-                statsd.socket_errors++;
+                statsd_stats->socket_errors++;
                 retval = -1;
                 goto cleanup;
             }
@@ -937,7 +1172,7 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
 #ifdef NETDATA_INTERNAL_CHECKS
             if(unlikely(d->type != STATSD_SOCKET_DATA_TYPE_TCP)) {
                 netdata_log_error("STATSD: internal error: socket data type should be %d, but it is %d", (int)STATSD_SOCKET_DATA_TYPE_TCP, (int)d->type);
-                statsd.socket_errors++;
+                statsd_stats->socket_errors++;
                 retval = -1;
                 goto cleanup;
             }
@@ -951,7 +1186,7 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
                     // read failed
                     if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
                         netdata_log_error("STATSD: recv() on TCP socket %d failed.", fd);
-                        statsd.socket_errors++;
+                        statsd_stats->socket_errors++;
                         ret = -1;
                     }
                 }
@@ -963,12 +1198,12 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
                 else {
                     // data received
                     d->len += rc;
-                    statsd.tcp_socket_reads++;
-                    statsd.tcp_bytes_read += rc;
+                    statsd_stats->tcp_socket_reads++;
+                    statsd_stats->tcp_bytes_read += rc;
                 }
 
                 if(likely(d->len > 0)) {
-                    statsd.tcp_packets_received++;
+                    statsd_stats->tcp_packets_received++;
                     d->len = statsd_process(d->buffer, d->len, 1);
                 }
 
@@ -985,7 +1220,7 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
             struct statsd_udp *d = (struct statsd_udp *)pi->data;
             if(unlikely(!d)) {
                 netdata_log_error("STATSD: internal error: expected UDP data pointer is NULL");
-                statsd.socket_errors++;
+                statsd_stats->socket_errors++;
                 retval = -1;
                 goto cleanup;
             }
@@ -993,7 +1228,7 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
 #ifdef NETDATA_INTERNAL_CHECKS
             if(unlikely(d->type != STATSD_SOCKET_DATA_TYPE_UDP)) {
                 netdata_log_error("STATSD: internal error: socket data should be %d, but it is %d", (int)d->type, (int)STATSD_SOCKET_DATA_TYPE_UDP);
-                statsd.socket_errors++;
+                statsd_stats->socket_errors++;
                 retval = -1;
                 goto cleanup;
             }
@@ -1007,19 +1242,19 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
                     // read failed
                     if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
                         netdata_log_error("STATSD: recvmmsg() on UDP socket %d failed.", fd);
-                        statsd.socket_errors++;
+                        statsd_stats->socket_errors++;
                         retval = -1;
                         goto cleanup;
                     }
                 } else if (rc) {
                     // data received
-                    statsd.udp_socket_reads++;
-                    statsd.udp_packets_received += rc;
+                    statsd_stats->udp_socket_reads++;
+                    statsd_stats->udp_packets_received += rc;
 
                     size_t i;
                     for (i = 0; i < (size_t)rc; ++i) {
                         size_t len = (size_t)d->msgs[i].msg_len;
-                        statsd.udp_bytes_read += len;
+                        statsd_stats->udp_bytes_read += len;
                         statsd_process(d->msgs[i].msg_hdr.msg_iov->iov_base, len, 0);
                     }
                 }
@@ -1033,15 +1268,15 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
                     // read failed
                     if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
                         netdata_log_error("STATSD: recv() on UDP socket %d failed.", fd);
-                        statsd.socket_errors++;
+                        statsd_stats->socket_errors++;
                         retval = -1;
                         goto cleanup;
                     }
                 } else if (rc) {
                     // data received
-                    statsd.udp_socket_reads++;
-                    statsd.udp_packets_received++;
-                    statsd.udp_bytes_read += rc;
+                    statsd_stats->udp_socket_reads++;
+                    statsd_stats->udp_packets_received++;
+                    statsd_stats->udp_bytes_read += rc;
                     statsd_process(d->buffer, (size_t) rc, 0);
                 }
             } while (rc != -1);
@@ -1052,7 +1287,7 @@ static int statsd_rcv_callback(POLLINFO *pi, short int *events) {
 
         default: {
             netdata_log_error("STATSD: internal error: unknown socktype %d on socket %d", pi->socktype, fd);
-            statsd.socket_errors++;
+            statsd_stats->socket_errors++;
             retval = -1;
             goto cleanup;
         }
@@ -1119,6 +1354,8 @@ void *statsd_collector_thread(void *ptr) {
 
     collector_info("STATSD collector thread started with taskid %d", gettid_cached());
 
+    statsd_stats = &status->stats;
+
     struct statsd_udp *d = callocz(sizeof(struct statsd_udp), 1);
     d->status = status;
 
@@ -1139,7 +1376,7 @@ void *statsd_collector_thread(void *ptr) {
     }
 #endif
 
-    poll_events(&statsd.sockets
+    poll_events(status->sockets
             , statsd_add_callback
             , statsd_del_callback
             , statsd_rcv_callback
@@ -1165,9 +1402,11 @@ void *statsd_collector_thread(void *ptr) {
 
 #define STATSD_CONF_LINE_MAX 8192
 
-static STATSD_APP_CHART_DIM_VALUE_TYPE string2valuetype(const char *type, size_t line, const char *filename) {
+static STATSD_APP_CHART_DIM_VALUE_TYPE string2valuetype(const char *type, NETDATA_DOUBLE *percentile, size_t line, const char *filename) {
     if(!type || !*type) type = "last";
 
+    *percentile = 0.0;
+
     if(!strcmp(type, "events")) return STATSD_APP_CHART_DIM_VALUE_TYPE_EVENTS;
     else if(!strcmp(type, "last")) return STATSD_APP_CHART_DIM_VALUE_TYPE_LAST;
     else if(!strcmp(type, "min")) return STATSD_APP_CHART_DIM_VALUE_TYPE_MIN;
@@ -1177,6 +1416,15 @@ static STATSD_APP_CHART_DIM_VALUE_TYPE string2valuetype(const char *type, size_t
     else if(!strcmp(type, "median")) return STATSD_APP_CHART_DIM_VALUE_TYPE_MEDIAN;
     else if(!strcmp(type, "stddev")) return STATSD_APP_CHART_DIM_VALUE_TYPE_STDDEV;
     else if(!strcmp(type, "percentile")) return STATSD_APP_CHART_DIM_VALUE_TYPE_PERCENTILE;
+    else if(!strncmp(type, "percentile", 10)) {
+        // percentileNN, a percentile for this dimension only, like percentile99 or percentile99.9
+        char *end = NULL;
+        NETDATA_DOUBLE p = strtondd(&type[10], &end);
+        if(end && !*end && isgreater(p, 0) && isless(p, 100)) {
+            *percentile = p;
+            return STATSD_APP_CHART_DIM_VALUE_TYPE_PERCENTILE;
+        }
+    }
 
     netdata_log_error("STATSD: invalid type '%s' at line %zu of file '%s'. Using 'last'.", type, line, filename);
     return STATSD_APP_CHART_DIM_VALUE_TYPE_LAST;
@@ -1307,6 +1555,7 @@ static int statsd_readfile(const char *filename, STATSD_APP *app, STATSD_APP_CHA
                 app->name = strdupz("unnamed");
                 app->rrd_memory_mode = localhost->rrd_memory_mode;
                 app->rrd_history_entries = localhost->rrd_history_entries;
+                spinlock_init(&app->spinlock);
 
                 app->next = statsd.apps;
                 statsd.apps = app;
@@ -1426,6 +1675,11 @@ static int statsd_readfile(const char *filename, STATSD_APP *app, STATSD_APP_CHA
                 if (app->rrd_history_entries < 5)
                     app->rrd_history_entries = 5;
             }
+            else if (!strcmp(name, "cardinality limit")) {
+                app->cardinality_limit = str2u(value);
+                if(app->cardinality_limit)
+                    statsd.apps_cardinality_limits = true;
+            }
             else {
                 netdata_log_error("STATSD: ignoring line %zu ('%s') of file '%s'. Unknown keyword for the [app] section.", line, name, filename);
                 continue;
@@ -1505,6 +1759,7 @@ static int statsd_readfile(const char *filename, STATSD_APP *app, STATSD_APP_CHA
                         dim_name = metric_name;
                 }
 
+                NETDATA_DOUBLE percentile;
                 STATSD_APP_CHART_DIM *dim = add_dimension_to_app_chart(
                         app
                         , chart
@@ -1514,8 +1769,9 @@ static int statsd_readfile(const char *filename, STATSD_APP *app, STATSD_APP_CHA
                         , (divisor && *divisor)?str2l(divisor):1
                         , flags
                         ,
-                    options, string2valuetype(type, line, filename)
+                    options, string2valuetype(type, &percentile, line, filename)
                 );
+                dim->percentile = percentile;
 
                 if(pattern)
                     dim->metric_pattern = simple_pattern_create(dim->metric, NULL, SIMPLE_PATTERN_EXACT, true);
@@ -1839,7 +2095,8 @@ static inline void statsd_private_chart_timer_or_histogram(STATSD_METRIC *m, con
         m->histogram.ext->rd_min = rrddim_add(m->st, "min", NULL, 1, statsd.decimal_detail, RRD_ALGORITHM_ABSOLUTE);
         m->histogram.ext->rd_max = rrddim_add(m->st, "max", NULL, 1, statsd.decimal_detail, RRD_ALGORITHM_ABSOLUTE);
         m->rd_value              = rrddim_add(m->st, "average", NULL, 1, statsd.decimal_detail, RRD_ALGORITHM_ABSOLUTE);
-        m->histogram.ext->rd_percentile = rrddim_add(m->st, statsd.histogram_percentile_str, NULL, 1, statsd.decimal_detail, RRD_ALGORITHM_ABSOLUTE);
+        for(uint32_t i = 0; i < statsd.histogram_percentiles_count ;i++)
+            m->histogram.ext->percentiles[i].rd = rrddim_add(m->st, statsd.histogram_percentiles_str[i], NULL, 1, statsd.decimal_detail, RRD_ALGORITHM_ABSOLUTE);
         m->histogram.ext->rd_median = rrddim_add(m->st, "median", NULL, 1, statsd.decimal_detail, RRD_ALGORITHM_ABSOLUTE);
         m->histogram.ext->rd_stddev = rrddim_add(m->st, "stddev", NULL, 1, statsd.decimal_detail, RRD_ALGORITHM_ABSOLUTE);
         //m->histogram.ext->rd_sum = rrddim_add(m->st, "sum", NULL, 1, statsd.decimal_detail, RRD_ALGORITHM_ABSOLUTE);
@@ -1850,7 +2107,8 @@ static inline void statsd_private_chart_timer_or_histogram(STATSD_METRIC *m, con
 
     rrddim_set_by_pointer(m->st, m->histogram.ext->rd_min, m->histogram.ext->last_min);
     rrddim_set_by_pointer(m->st, m->histogram.ext->rd_max, m->histogram.ext->last_max);
-    rrddim_set_by_pointer(m->st, m->histogram.ext->rd_percentile, m->histogram.ext->last_percentile);
+    for(uint32_t i = 0; i < statsd.histogram_percentiles_count ;i++)
+        rrddim_set_by_pointer(m->st, m->histogram.ext->percentiles[i].rd, m->histogram.ext->percentiles[i].last);
     rrddim_set_by_pointer(m->st, m->histogram.ext->rd_median, m->histogram.ext->last_median);
     rrddim_set_by_pointer(m->st, m->histogram.ext->rd_stddev, m->histogram.ext->last_stddev);
     //rrddim_set_by_pointer(m->st, m->histogram.ext->rd_sum, m->histogram.ext->last_sum);
@@ -1971,30 +2229,27 @@ static inline void statsd_flush_timer_or_histogram(STATSD_METRIC *m, const char
     netdata_log_debug(D_STATSD, "flushing %s metric '%s'", dim, m->name);
 
     int updated = 0;
-    if(unlikely(!m->reset && m->count && m->histogram.ext->used > 0)) {
+    if(unlikely(!m->reset && m->count && m->histogram.ext->sketch.count > 0)) {
         netdata_mutex_lock(&m->histogram.ext->mutex);
 
-        size_t len = m->histogram.ext->used;
-        NETDATA_DOUBLE *series = m->histogram.ext->values;
-        sort_series(series, len);
+        QUANTILE_SKETCH *qs = &m->histogram.ext->sketch;
 
-        m->histogram.ext->last_min = (collected_number)roundndd(series[0] * statsd.decimal_detail);
-        m->histogram.ext->last_max = (collected_number)roundndd(series[len - 1] * statsd.decimal_detail);
-        m->last = (collected_number)roundndd(average(series, len) * statsd.decimal_detail);
-        m->histogram.ext->last_median = (collected_number)roundndd(median_on_sorted_series(series, len) * statsd.decimal_detail);
-        m->histogram.ext->last_stddev = (collected_number)roundndd(standard_deviation(series, len) * statsd.decimal_detail);
-        m->histogram.ext->last_sum = (collected_number)roundndd(sum(series, len) * statsd.decimal_detail);
+        m->histogram.ext->last_min = (collected_number)roundndd(qs->min * statsd.decimal_detail);
+        m->histogram.ext->last_max = (collected_number)roundndd(qs->max * statsd.decimal_detail);
+        m->last = (collected_number)roundndd(qs->mean * statsd.decimal_detail);
+        m->histogram.ext->last_median = (collected_number)roundndd(quantile_sketch_quantile(qs, 0.5) * statsd.decimal_detail);
+        m->histogram.ext->last_stddev = (collected_number)roundndd(quantile_sketch_stddev(qs) * statsd.decimal_detail);
+        m->histogram.ext->last_sum = (collected_number)roundndd(qs->sum * statsd.decimal_detail);
 
-        size_t pct_len = (size_t)floor((double)len * statsd.histogram_percentile / 100.0);
-        if(pct_len < 1)
-            m->histogram.ext->last_percentile = (collected_number)(series[0] * statsd.decimal_detail);
-        else
-            m->histogram.ext->last_percentile = (collected_number)roundndd(series[pct_len - 1] * statsd.decimal_detail);
+        for(uint32_t i = 0; i < m->histogram.ext->percentiles_count ;i++) {
+            STATSD_HISTOGRAM_PERCENTILE *pct = &m->histogram.ext->percentiles[i];
+            pct->last = (collected_number)roundndd(quantile_sketch_quantile(qs, pct->percentile / 100.0) * statsd.decimal_detail);
+        }
 
         netdata_mutex_unlock(&m->histogram.ext->mutex);
 
         netdata_log_debug(D_STATSD, "STATSD %s metric %s: min " COLLECTED_NUMBER_FORMAT ", max " COLLECTED_NUMBER_FORMAT ", last " COLLECTED_NUMBER_FORMAT ", pcent " COLLECTED_NUMBER_FORMAT ", median " COLLECTED_NUMBER_FORMAT ", stddev " COLLECTED_NUMBER_FORMAT ", sum " COLLECTED_NUMBER_FORMAT,
-              dim, m->name, m->histogram.ext->last_min, m->histogram.ext->last_max, m->last, m->histogram.ext->last_percentile, m->histogram.ext->last_median, m->histogram.ext->last_stddev, m->histogram.ext->last_sum);
+              dim, m->name, m->histogram.ext->last_min, m->histogram.ext->last_max, m->last, m->histogram.ext->percentiles[0].last, m->histogram.ext->last_median, m->histogram.ext->last_stddev, m->histogram.ext->last_sum);
 
         m->histogram.ext->zeroed = 0;
         m->reset = 1;
@@ -2011,7 +2266,9 @@ static inline void statsd_flush_timer_or_histogram(STATSD_METRIC *m, const char
         m->histogram.ext->last_median = 0;
         m->histogram.ext->last_stddev = 0;
         m->histogram.ext->last_sum = 0;
-        m->histogram.ext->last_percentile = 0;
+
+        for(uint32_t i = 0; i < m->histogram.ext->percentiles_count ;i++)
+            m->histogram.ext->percentiles[i].last = 0;
 
         m->histogram.ext->zeroed = 1;
     }
@@ -2046,6 +2303,38 @@ static inline RRD_ALGORITHM statsd_algorithm_for_metric(STATSD_METRIC *m) {
     }
 }
 
+// find or add a percentile for a metric, returning where its value is stored
+static collected_number *statsd_histogram_percentile_ptr(STATSD_METRIC *m, NETDATA_DOUBLE percentile) {
+    STATSD_METRIC_HISTOGRAM_EXTENSIONS *ext = m->histogram.ext;
+
+    if(percentile == 0.0)
+        return &ext->percentiles[0].last;
+
+    netdata_mutex_lock(&ext->mutex);
+
+    uint32_t i;
+    for(i = 0; i < ext->percentiles_count ;i++)
+        if(ext->percentiles[i].percentile == percentile)
+            break;
+
+    if(i == ext->percentiles_count) {
+        if(ext->percentiles_count < STATSD_HISTOGRAM_PERCENTILES_MAX) {
+            ext->percentiles[i].percentile = percentile;
+            ext->percentiles[i].last = 0;
+            ext->percentiles_count++;
+        }
+        else {
+            collector_error("STATSD: metric '%s' has too many percentiles, using the %0.1f%% percentile instead of %0.1f%%",
+                            m->name, (double)ext->percentiles[0].percentile, (double)percentile);
+            i = 0;
+        }
+    }
+
+    netdata_mutex_unlock(&ext->mutex);
+
+    return &ext->percentiles[i].last;
+}
+
 static inline void link_metric_to_app_dimension(STATSD_APP *app, STATSD_METRIC *m, STATSD_APP_CHART *chart, STATSD_APP_CHART_DIM *dim) {
     if(dim->value_type == STATSD_APP_CHART_DIM_VALUE_TYPE_EVENTS) {
         dim->value_ptr = &m->events;
@@ -2082,7 +2371,7 @@ static inline void link_metric_to_app_dimension(STATSD_APP *app, STATSD_METRIC *
                 break;
 
             case STATSD_APP_CHART_DIM_VALUE_TYPE_PERCENTILE:
-                dim->value_ptr = &m->histogram.ext->last_percentile;
+                dim->value_ptr = statsd_histogram_percentile_ptr(m, dim->percentile);
                 break;
 
             case STATSD_APP_CHART_DIM_VALUE_TYPE_STDDEV:
@@ -2390,10 +2679,33 @@ static inline void statsd_flush_index_metrics(STATSD_INDEX *index, void (*flush_
 // --------------------------------------------------------------------------------------
 // statsd main thread
 
+static void statsd_index_create(STATSD_INDEX *index, struct dictionary_stats *stats) {
+    index->dict_stats = stats;
+    index->dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, stats, 0);
+    dictionary_register_insert_callback(index->dict, dictionary_metric_insert_callback, index);
+    dictionary_register_delete_callback(index->dict, dictionary_metric_delete_callback, index);
+}
+
+// stats, when given, is an array with a dictionary_stats for each metric type
+static void statsd_indexes_create(struct dictionary_stats *stats) {
+    for(STATSD_METRIC_TYPE type = 0; type < STATSD_METRIC_TYPES ;type++)
+        statsd_index_create(statsd_index_of_type(type), stats ? &stats[type] : &dictionary_stats_category_collectors);
+
+    statsd.prefixes = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
+    dictionary_register_delete_callback(statsd.prefixes, dictionary_prefix_delete_callback, NULL);
+}
+
 static int statsd_listen_sockets_setup(void) {
     return listen_sockets_setup(&statsd.sockets);
 }
 
+#define statsd_threads_stats_sum(member) ({             \
+    size_t _sum = 0;                                    \
+    for(int _i = 0; _i < statsd.threads ;_i++)          \
+        _sum += statsd.collection_threads_status[_i].stats.member; \
+    _sum;                                               \
+})
+
 static void statsd_main_cleanup(void *pptr) {
     struct netdata_static_thread *static_thread = CLEANUP_FUNCTION_GET_PTR(pptr);
     if(!static_thread) return;
@@ -2418,6 +2730,16 @@ static void statsd_main_cleanup(void *pptr) {
     }
 
     collector_info("STATSD: closing sockets...");
+    if (statsd.collection_threads_status) {
+        int i;
+        for (i = 0; i < statsd.threads; i++) {
+            LISTEN_SOCKETS *sockets = statsd.collection_threads_status[i].sockets;
+            if(sockets && sockets != &statsd.sockets) {
+                listen_sockets_close(sockets);
+                freez(sockets);
+            }
+        }
+    }
     listen_sockets_close(&statsd.sockets);
 
     // destroy the dictionaries
@@ -2429,6 +2751,9 @@ static void statsd_main_cleanup(void *pptr) {
     dictionary_destroy(statsd.sets.dict);
     dictionary_destroy(statsd.timers.dict);
 
+    // the metrics reference their prefixes
+    dictionary_destroy(statsd.prefixes);
+
     collector_info("STATSD: cleanup completed.");
     static_thread->enabled = NETDATA_MAIN_THREAD_EXITED;
 
@@ -2461,29 +2786,7 @@ void *statsd_main(void *ptr) {
     worker_register_job_name(WORKER_STATSD_FLUSH_DICTIONARIES, "dictionaries");
     worker_register_job_name(WORKER_STATSD_FLUSH_STATS, "statistics");
 
-    statsd.gauges.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
-    statsd.meters.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
-    statsd.counters.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
-    statsd.histograms.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
-    statsd.dictionaries.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
-    statsd.sets.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
-    statsd.timers.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
-
-    dictionary_register_insert_callback(statsd.gauges.dict, dictionary_metric_insert_callback, &statsd.gauges);
-    dictionary_register_insert_callback(statsd.meters.dict, dictionary_metric_insert_callback, &statsd.meters);
-    dictionary_register_insert_callback(statsd.counters.dict, dictionary_metric_insert_callback, &statsd.counters);
-    dictionary_register_insert_callback(statsd.histograms.dict, dictionary_metric_insert_callback, &statsd.histograms);
-    dictionary_register_insert_callback(statsd.dictionaries.dict, dictionary_metric_insert_callback, &statsd.dictionaries);
-    dictionary_register_insert_callback(statsd.sets.dict, dictionary_metric_insert_callback, &statsd.sets);
-    dictionary_register_insert_callback(statsd.timers.dict, dictionary_metric_insert_callback, &statsd.timers);
-
-    dictionary_register_delete_callback(statsd.gauges.dict, dictionary_metric_delete_callback, &statsd.gauges);
-    dictionary_register_delete_callback(statsd.meters.dict, dictionary_metric_delete_callback, &statsd.meters);
-    dictionary_register_delete_callback(statsd.counters.dict, dictionary_metric_delete_callback, &statsd.counters);
-    dictionary_register_delete_callback(statsd.histograms.dict, dictionary_metric_delete_callback, &statsd.histograms);
-    dictionary_register_delete_callback(statsd.dictionaries.dict, dictionary_metric_delete_callback, &statsd.dictionaries);
-    dictionary_register_delete_callback(statsd.sets.dict, dictionary_metric_delete_callback, &statsd.sets);
-    dictionary_register_delete_callback(statsd.timers.dict, dictionary_metric_delete_callback, &statsd.timers);
+    statsd_indexes_create(NULL);
 
     // ----------------------------------------------------------------------------------------------------------------
     // statsd configuration
@@ -2509,6 +2812,9 @@ void *statsd_main(void *ptr) {
     statsd.max_private_charts_hard =
         (size_t)config_get_number(CONFIG_SECTION_STATSD, "max private charts hard limit", (long long)statsd.max_private_charts_hard);
 
+    statsd.cardinality_limit_per_prefix =
+        (uint32_t)config_get_number(CONFIG_SECTION_STATSD, "cardinality limit per prefix", (long long)statsd.cardinality_limit_per_prefix);
+
     statsd.set_obsolete_after =
         (size_t)config_get_duration_seconds(CONFIG_SECTION_STATSD, "set charts as obsolete after", (long long)statsd.set_obsolete_after);
 
@@ -2533,8 +2839,48 @@ void *statsd_main(void *ptr) {
         char buffer[314 + 1];
         snprintfz(buffer, sizeof(buffer) - 1, "%0.1f%%", statsd.histogram_percentile);
         statsd.histogram_percentile_str = strdupz(buffer);
+
+        statsd.histogram_percentiles[0] = statsd.histogram_percentile;
+        statsd.histogram_percentiles_str[0] = statsd.histogram_percentile_str;
+        statsd.histogram_percentiles_count = 1;
+
+        // the private charts of histograms and timers get a dimension for each of them
+        char *s = strdupz(config_get(CONFIG_SECTION_STATSD, "histograms and timers additional percentiles", ""));
+        char *words = s, *word;
+        while((word = strsep_skip_consecutive_separators(&words, " ,"))) {
+            if(!*word) continue;
+
+            NETDATA_DOUBLE p = str2ndd(word, NULL);
+            if(!isgreater(p, 0) || !isless(p, 100)) {
+                collector_error("STATSD: invalid histograms and timers additional percentile '%s' given", word);
+                continue;
+            }
+
+            if(statsd.histogram_percentiles_count >= STATSD_HISTOGRAM_PERCENTILES_MAX / 2) {
+                collector_error("STATSD: too many histograms and timers additional percentiles, ignoring '%s'", word);
+                continue;
+            }
+
+            snprintfz(buffer, sizeof(buffer) - 1, "%0.1f%%", (double)p);
+            statsd.histogram_percentiles[statsd.histogram_percentiles_count] = p;
+            statsd.histogram_percentiles_str[statsd.histogram_percentiles_count] = strdupz(buffer);
+            statsd.histogram_percentiles_count++;
+        }
+        freez(s);
     }
 
+    statsd.histogram_relative_accuracy =
+        (NETDATA_DOUBLE)config_get_double(
+        CONFIG_SECTION_STATSD, "histograms and timers relative accuracy %", (double)statsd.histogram_relative_accuracy);
+
+    if(!isgreater(statsd.histogram_relative_accuracy, 0) || !isless(statsd.histogram_relative_accuracy, 50)) {
+        collector_error("STATSD: invalid histograms and timers relative accuracy %0.5f given", (double)statsd.histogram_relative_accuracy);
+        statsd.histogram_relative_accuracy = 1.0;
+    }
+
+    statsd.histogram_max_buckets =
+        (uint32_t)config_get_number(CONFIG_SECTION_STATSD, "histograms and timers max buckets", statsd.histogram_max_buckets);
+
     statsd.dictionary_max_unique =
         config_get_number(CONFIG_SECTION_STATSD, "dictionaries max unique dimensions", statsd.dictionary_max_unique);
 
@@ -2571,16 +2917,19 @@ void *statsd_main(void *ptr) {
 
     size_t max_sockets = (size_t)config_get_number(CONFIG_SECTION_STATSD, "statsd server max TCP sockets", (long long int)(rlimit_nofile.rlim_cur / 4));
 
-#ifdef STATSD_MULTITHREADED
-    statsd.threads = (int)config_get_number(CONFIG_SECTION_STATSD, "threads", processors);
-    if(statsd.threads < 1) {
-        collector_error("STATSD: Invalid number of threads %d, using %d", statsd.threads, processors);
-        statsd.threads = processors;
-        config_set_number(CONFIG_SECTION_STATSD, "collector threads", statsd.threads);
+    int max_threads = (int)os_get_system_cpus() * 2;
+    statsd.threads = (int)config_get_number(CONFIG_SECTION_STATSD, "threads", 1);
+    if(statsd.threads < 1 || statsd.threads > max_threads) {
+        int threads = MIN(MAX(statsd.threads, 1), max_threads);
+        collector_error("STATSD: Invalid number of threads %d, using %d", statsd.threads, threads);
+        statsd.threads = threads;
+        config_set_number(CONFIG_SECTION_STATSD, "threads", statsd.threads);
     }
-#else
-    statsd.threads = 1;
-#endif
+
+    // with SO_REUSEPORT, each collection thread gets its own UDP and TCP listening sockets,
+    // so that the kernel distributes the packets to them, instead of waking up all of them
+    statsd.sockets.reuse_port = statsd.threads > 1 &&
+        config_get_boolean(CONFIG_SECTION_STATSD, "listen sockets per thread", CONFIG_BOOLEAN_YES);
 
     // read custom application definitions
     statsd_readdir(netdata_configured_user_config_dir, netdata_configured_stock_config_dir, "statsd.d");
@@ -2601,6 +2950,14 @@ void *statsd_main(void *ptr) {
     int i;
     for(i = 0; i < statsd.threads ;i++) {
         statsd.collection_threads_status[i].max_sockets = max_sockets / statsd.threads;
+
+        if(i == 0 || !statsd.sockets.reuse_port)
+            statsd.collection_threads_status[i].sockets = &statsd.sockets;
+        else {
+            statsd.collection_threads_status[i].sockets = callocz(1, sizeof(LISTEN_SOCKETS));
+            listen_sockets_clone(&statsd.sockets, statsd.collection_threads_status[i].sockets);
+        }
+
         char tag[NETDATA_THREAD_TAG_MAX + 1];
         snprintfz(tag, NETDATA_THREAD_TAG_MAX, "STATSD_IN[%d]", i + 1);
         spinlock_init(&statsd.collection_threads_status[i].spinlock);
@@ -2654,6 +3011,10 @@ void *statsd_main(void *ptr) {
     RRDSET *st_pcharts = NULL;
     RRDDIM *rd_pcharts = NULL;
 
+    RRDSET *st_overflow = NULL;
+    RRDDIM *rd_overflow_events = NULL;
+    RRDDIM *rd_overflow_metrics = NULL;
+
     if(global_statistics_enabled) {
         st_metrics = rrdset_create_localhost(
             "netdata",
@@ -2813,6 +3174,24 @@ void *statsd_main(void *ptr) {
             statsd.update_every,
             RRDSET_TYPE_AREA);
         rd_pcharts = rrddim_add(st_pcharts, "charts", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+        if(statsd_cardinality_limits_enabled()) {
+            st_overflow = rrdset_create_localhost(
+                "netdata",
+                "statsd_overflow",
+                NULL,
+                "statsd",
+                NULL,
+                "Metrics collapsed by the netdata statsd server cardinality limits",
+                "metrics",
+                PLUGIN_STATSD_NAME,
+                "stats",
+                132021,
+                statsd.update_every,
+                RRDSET_TYPE_LINE);
+            rd_overflow_events = rrddim_add(st_overflow, "events", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_overflow_metrics = rrddim_add(st_overflow, "metrics", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+        }
     }
 
     // ----------------------------------------------------------------------------------------------------------------
@@ -2871,41 +3250,329 @@ void *statsd_main(void *ptr) {
             rrddim_set_by_pointer(st_useful_metrics, rd_useful_metrics_dictionary,   (collected_number)statsd.dictionaries.useful);
             rrdset_done(st_useful_metrics);
 
-            rrddim_set_by_pointer(st_events,  rd_events_gauge,         (collected_number)statsd.gauges.events);
-            rrddim_set_by_pointer(st_events,  rd_events_counter,       (collected_number)statsd.counters.events);
-            rrddim_set_by_pointer(st_events,  rd_events_timer,         (collected_number)statsd.timers.events);
-            rrddim_set_by_pointer(st_events,  rd_events_meter,         (collected_number)statsd.meters.events);
-            rrddim_set_by_pointer(st_events,  rd_events_histogram,     (collected_number)statsd.histograms.events);
-            rrddim_set_by_pointer(st_events,  rd_events_set,           (collected_number)statsd.sets.events);
-            rrddim_set_by_pointer(st_events,  rd_events_dictionary,    (collected_number)statsd.dictionaries.events);
-            rrddim_set_by_pointer(st_events,  rd_events_unknown,       (collected_number)statsd.unknown_types);
-            rrddim_set_by_pointer(st_events,  rd_events_errors,        (collected_number)statsd.socket_errors);
+            rrddim_set_by_pointer(st_events,  rd_events_gauge,         (collected_number)statsd_threads_stats_sum(events[statsd.gauges.type]));
+            rrddim_set_by_pointer(st_events,  rd_events_counter,       (collected_number)statsd_threads_stats_sum(events[statsd.counters.type]));
+            rrddim_set_by_pointer(st_events,  rd_events_timer,         (collected_number)statsd_threads_stats_sum(events[statsd.timers.type]));
+            rrddim_set_by_pointer(st_events,  rd_events_meter,         (collected_number)statsd_threads_stats_sum(events[statsd.meters.type]));
+            rrddim_set_by_pointer(st_events,  rd_events_histogram,     (collected_number)statsd_threads_stats_sum(events[statsd.histograms.type]));
+            rrddim_set_by_pointer(st_events,  rd_events_set,           (collected_number)statsd_threads_stats_sum(events[statsd.sets.type]));
+            rrddim_set_by_pointer(st_events,  rd_events_dictionary,    (collected_number)statsd_threads_stats_sum(events[statsd.dictionaries.type]));
+            rrddim_set_by_pointer(st_events,  rd_events_unknown,       (collected_number)statsd_threads_stats_sum(unknown_types));
+            rrddim_set_by_pointer(st_events,  rd_events_errors,        (collected_number)statsd_threads_stats_sum(socket_errors));
             rrdset_done(st_events);
 
-            rrddim_set_by_pointer(st_reads,   rd_reads_tcp,            (collected_number)statsd.tcp_socket_reads);
-            rrddim_set_by_pointer(st_reads,   rd_reads_udp,            (collected_number)statsd.udp_socket_reads);
+            rrddim_set_by_pointer(st_reads,   rd_reads_tcp,            (collected_number)statsd_threads_stats_sum(tcp_socket_reads));
+            rrddim_set_by_pointer(st_reads,   rd_reads_udp,            (collected_number)statsd_threads_stats_sum(udp_socket_reads));
             rrdset_done(st_reads);
 
-            rrddim_set_by_pointer(st_bytes,   rd_bytes_tcp,            (collected_number)statsd.tcp_bytes_read);
-            rrddim_set_by_pointer(st_bytes,   rd_bytes_udp,            (collected_number)statsd.udp_bytes_read);
+            rrddim_set_by_pointer(st_bytes,   rd_bytes_tcp,            (collected_number)statsd_threads_stats_sum(tcp_bytes_read));
+            rrddim_set_by_pointer(st_bytes,   rd_bytes_udp,            (collected_number)statsd_threads_stats_sum(udp_bytes_read));
             rrdset_done(st_bytes);
 
-            rrddim_set_by_pointer(st_packets, rd_packets_tcp,          (collected_number)statsd.tcp_packets_received);
-            rrddim_set_by_pointer(st_packets, rd_packets_udp,          (collected_number)statsd.udp_packets_received);
+            rrddim_set_by_pointer(st_packets, rd_packets_tcp,          (collected_number)statsd_threads_stats_sum(tcp_packets_received));
+            rrddim_set_by_pointer(st_packets, rd_packets_udp,          (collected_number)statsd_threads_stats_sum(udp_packets_received));
             rrdset_done(st_packets);
 
-            rrddim_set_by_pointer(st_tcp_connects, rd_tcp_connects,    (collected_number)statsd.tcp_socket_connects);
-            rrddim_set_by_pointer(st_tcp_connects, rd_tcp_disconnects, (collected_number)statsd.tcp_socket_disconnects);
+            rrddim_set_by_pointer(st_tcp_connects, rd_tcp_connects,    (collected_number)statsd_threads_stats_sum(tcp_socket_connects));
+            rrddim_set_by_pointer(st_tcp_connects, rd_tcp_disconnects, (collected_number)statsd_threads_stats_sum(tcp_socket_disconnects));
             rrdset_done(st_tcp_connects);
 
-            rrddim_set_by_pointer(st_tcp_connected, rd_tcp_connected,  (collected_number)statsd.tcp_socket_connected);
+            rrddim_set_by_pointer(st_tcp_connected, rd_tcp_connected,  (collected_number)statsd_threads_stats_sum(tcp_socket_connected));
             rrdset_done(st_tcp_connected);
 
             rrddim_set_by_pointer(st_pcharts, rd_pcharts,              (collected_number)statsd.private_charts);
             rrdset_done(st_pcharts);
+
+            if(st_overflow) {
+                rrddim_set_by_pointer(st_overflow, rd_overflow_events,  (collected_number)statsd_threads_stats_sum(overflow_events));
+                rrddim_set_by_pointer(st_overflow, rd_overflow_metrics, (collected_number)statsd_cardinality_overflowed_estimate());
+                rrdset_done(st_overflow);
+            }
         }
     }
 
 cleanup: ; // added semi-colon to prevent older gcc error: label at end of compound statement
     return NULL;
 }
+
+// --------------------------------------------------------------------------------------------------------------------
+// statsd benchmark
+//
+// netdata -W statsdtest[=SECONDS[,RATE[,FILE]]]
+//
+// Replays a mix of packets to the statsd parser, in-process, for SECONDS (default 5), at RATE packets/s
+// (default 0, as fast as possible), flushing the metrics every second. The packets are read from FILE, one
+// packet per line, or generated with a fixed seed, so that the runs can be compared. It reports the packets
+// and metrics parsed per second, the flush latency and the memory used per metric type.
+
+#define STATSD_BENCHMARK_PACKETS 100000
+#define STATSD_BENCHMARK_METRICS_PER_TYPE 1000
+
+static uint64_t statsd_benchmark_random(uint64_t *state) {
+    // xorshift64*, to get the same packets on every run
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static size_t statsd_benchmark_generate(char **packets, size_t *lengths, size_t count, size_t *metrics) {
+    static const char *types[] = { "g", "c", "m", "ms", "h", "s", "d", NULL };
+    static const STATSD_METRIC_TYPE types_ids[] = {
+        STATSD_METRIC_TYPE_GAUGE, STATSD_METRIC_TYPE_COUNTER, STATSD_METRIC_TYPE_METER, STATSD_METRIC_TYPE_TIMER,
+        STATSD_METRIC_TYPE_HISTOGRAM, STATSD_METRIC_TYPE_SET, STATSD_METRIC_TYPE_DICTIONARY };
+
+    uint64_t state = 0x853c49e6748fea9bULL;
+    bool seen[STATSD_METRIC_TYPES][STATSD_BENCHMARK_METRICS_PER_TYPE] = { 0 };
+    size_t lines = 0;
+
+    BUFFER *wb = buffer_create(1024, NULL);
+    for(size_t i = 0; i < count ;i++) {
+        buffer_flush(wb);
+
+        // like most clients, pack a few metrics in each packet
+        size_t n = 1 + statsd_benchmark_random(&state) % 5;
+        for(size_t j = 0; j < n ;j++) {
+            size_t t = statsd_benchmark_random(&state) % 7;
+            size_t id = statsd_benchmark_random(&state) % STATSD_BENCHMARK_METRICS_PER_TYPE;
+            uint64_t r = statsd_benchmark_random(&state);
+
+            if(!seen[types_ids[t]][id]) {
+                seen[types_ids[t]][id] = true;
+                metrics[types_ids[t]]++;
+            }
+
+            buffer_sprintf(wb, "benchmark.%s.metric%zu:", types[t], id);
+
+            switch(types_ids[t]) {
+                case STATSD_METRIC_TYPE_GAUGE:
+                    buffer_sprintf(wb, "%s%u", (r & 1) ? "+" : "", (unsigned)(r % 1000));
+                    break;
+
+                case STATSD_METRIC_TYPE_SET:
+                    buffer_sprintf(wb, "user%u", (unsigned)(r % 100));
+                    break;
+
+                case STATSD_METRIC_TYPE_DICTIONARY:
+                    buffer_sprintf(wb, "value%u", (unsigned)(r % 20));
+                    break;
+
+                default:
+                    buffer_sprintf(wb, "%u.%03u", (unsigned)(r % 500), (unsigned)((r >> 16) % 1000));
+                    break;
+            }
+
+            buffer_sprintf(wb, "|%s", types[t]);
+
+            if((r >> 32) % 10 == 0)
+                buffer_strcat(wb, "|@0.5");
+
+            if((r >> 40) % 5 == 0)
+                buffer_strcat(wb, "|#units:ms,family:benchmark");
+
+            buffer_strcat(wb, "\n");
+            lines++;
+        }
+
+        packets[i] = strdupz(buffer_tostring(wb));
+        lengths[i] = buffer_strlen(wb);
+    }
+    buffer_free(wb);
+
+    return lines;
+}
+
+static size_t statsd_benchmark_load(const char *filename, char ***packets, size_t **lengths, size_t *lines) {
+    FILE *fp = fopen(filename, "r");
+    if(!fp) {
+        fprintf(stderr, "STATSD BENCHMARK: cannot open file '%s'\n", filename);
+        return 0;
+    }
+
+    size_t count = 0, size = 0;
+    char line[STATSD_UDP_BUFFER_SIZE];
+    while(fgets(line, sizeof(line), fp)) {
+        if(!*line || *line == '#' || *line == '\n')
+            continue;
+
+        if(count == size) {
+            size = size ? size * 2 : 1024;
+            *packets = reallocz(*packets, size * sizeof(char *));
+            *lengths = reallocz(*lengths, size * sizeof(size_t));
+        }
+
+        (*packets)[count] = strdupz(line);
+        (*lengths)[count] = strlen(line);
+        (*lines)++;
+        count++;
+    }
+    fclose(fp);
+
+    return count;
+}
+
+static size_t statsd_benchmark_memory(STATSD_INDEX *index) {
+    size_t memory = (size_t)(index->dict_stats->memory.dict + index->dict_stats->memory.values + index->dict_stats->memory.index);
+
+    if(index->type == STATSD_METRIC_TYPE_TIMER || index->type == STATSD_METRIC_TYPE_HISTOGRAM) {
+        STATSD_METRIC *m;
+        dfe_start_read(index->dict, m) {
+            memory += sizeof(STATSD_METRIC_HISTOGRAM_EXTENSIONS) +
+                      (m->histogram.ext->sketch.positive.capacity + m->histogram.ext->sketch.negative.capacity) * sizeof(uint64_t);
+        }
+        dfe_done(m);
+    }
+
+    return memory;
+}
+
+static void statsd_benchmark_flush(void) {
+    statsd_flush_index_metrics(&statsd.gauges,     statsd_flush_gauge);
+    statsd_flush_index_metrics(&statsd.counters,   statsd_flush_counter);
+    statsd_flush_index_metrics(&statsd.meters,     statsd_flush_meter);
+    statsd_flush_index_metrics(&statsd.timers,     statsd_flush_timer);
+    statsd_flush_index_metrics(&statsd.histograms, statsd_flush_histogram);
+    statsd_flush_index_metrics(&statsd.sets,       statsd_flush_set);
+    statsd_flush_index_metrics(&statsd.dictionaries,statsd_flush_dictionary);
+    statsd_update_all_app_charts();
+}
+
+int statsd_unittest(const char *args) {
+    size_t seconds = 5, rate = 0;
+    const char *filename = NULL;
+
+    char *s = strdupz(args ? args : ""), *words = s, *word;
+    if((word = strsep(&words, ",")) && *word) seconds = str2u(word);
+    if((word = strsep(&words, ",")) && *word) rate = str2u(word);
+    if((word = strsep(&words, ",")) && *word) filename = word;
+    if(!seconds) seconds = 5;
+
+    // the same defaults statsd_main() uses
+    static struct dictionary_stats stats[STATSD_METRIC_TYPES] = { 0 };
+    for(STATSD_METRIC_TYPE type = 0; type < STATSD_METRIC_TYPES ;type++)
+        stats[type].name = statsd_index_of_type(type)->name;
+
+    statsd.update_every = 1;
+    statsd.charts_for = simple_pattern_create("*", NULL, SIMPLE_PATTERN_EXACT, true);
+    statsd.histogram_percentile_str = "95.0%";
+    statsd.histogram_percentiles[0] = statsd.histogram_percentile;
+    statsd.histogram_percentiles_str[0] = statsd.histogram_percentile_str;
+    statsd.histogram_percentiles_count = 1;
+    statsd.threads = 1;
+    statsd.collection_threads_status = callocz(1, sizeof(struct collection_thread_status));
+    statsd_stats = &statsd.collection_threads_status[0].stats;
+    statsd_indexes_create(stats);
+
+    char **packets = NULL;
+    size_t *lengths = NULL, count, lines = 0;
+    size_t expected_metrics[STATSD_METRIC_TYPES] = { 0 };
+
+    if(filename)
+        count = statsd_benchmark_load(filename, &packets, &lengths, &lines);
+    else {
+        packets = mallocz(STATSD_BENCHMARK_PACKETS * sizeof(char *));
+        lengths = mallocz(STATSD_BENCHMARK_PACKETS * sizeof(size_t));
+        count = STATSD_BENCHMARK_PACKETS;
+        lines = statsd_benchmark_generate(packets, lengths, count, expected_metrics);
+    }
+
+    if(!count) {
+        fprintf(stderr, "STATSD BENCHMARK: no packets to replay\n");
+        freez(s);
+        return 1;
+    }
+
+    fprintf(stderr, "STATSD BENCHMARK: replaying %zu packets (%zu metric lines) %s, for %zu seconds, at %s%zu packets/s\n",
+            count, lines, filename ? filename : "generated", seconds, rate ? "" : "unlimited ", rate);
+
+    char buffer[STATSD_UDP_BUFFER_SIZE];
+    size_t packets_done = 0, lines_done = 0, flushes = 0;
+    usec_t flush_ut_total = 0, flush_ut_max = 0, flush_ut_min = 0;
+
+    usec_t started_ut = now_monotonic_usec();
+    usec_t ends_ut = started_ut + seconds * USEC_PER_SEC;
+    usec_t next_flush_ut = started_ut + USEC_PER_SEC;
+    usec_t now_ut = started_ut;
+
+    while(now_ut < ends_ut) {
+        for(size_t i = 0; i < 1024 ;i++) {
+            size_t p = packets_done++ % count;
+            size_t len = MIN(lengths[p], sizeof(buffer) - 1);
+            memcpy(buffer, packets[p], len);
+            statsd_process(buffer, len, 0);
+        }
+        now_ut = now_monotonic_usec();
+
+        if(rate) {
+            usec_t scheduled_ut = started_ut + (usec_t)((NETDATA_DOUBLE)packets_done * USEC_PER_SEC / (NETDATA_DOUBLE)rate);
+            if(scheduled_ut > now_ut) {
+                sleep_usec(scheduled_ut - now_ut);
+                now_ut = now_monotonic_usec();
+            }
+        }
+
+        if(now_ut >= next_flush_ut) {
+            statsd_benchmark_flush();
+            usec_t flushed_ut = now_monotonic_usec();
+
+            usec_t dt = flushed_ut - now_ut;
+            flush_ut_total += dt;
+            if(!flushes || dt < flush_ut_min) flush_ut_min = dt;
+            if(dt > flush_ut_max) flush_ut_max = dt;
+            flushes++;
+
+            next_flush_ut += USEC_PER_SEC;
+            now_ut = flushed_ut;
+        }
+    }
+
+    usec_t ended_ut = now_monotonic_usec();
+    NETDATA_DOUBLE secs = (NETDATA_DOUBLE)(ended_ut - started_ut) / USEC_PER_SEC;
+
+    // complete cycles through the packets have the same number of lines each
+    lines_done = (packets_done / count) * lines;
+    for(size_t i = 0; i < packets_done % count ;i++) {
+        for(const char *c = packets[i]; *c ;c++)
+            if(*c == '\n') lines_done++;
+    }
+
+    fprintf(stderr, "STATSD BENCHMARK: %0.0f packets/s, %0.0f metric lines/s\n",
+            (NETDATA_DOUBLE)packets_done / secs, (NETDATA_DOUBLE)lines_done / secs);
+
+    fprintf(stderr, "STATSD BENCHMARK: %zu flushes, latency min %0.3f ms, average %0.3f ms, max %0.3f ms\n",
+            flushes,
+            (NETDATA_DOUBLE)flush_ut_min / USEC_PER_MS,
+            flushes ? (NETDATA_DOUBLE)flush_ut_total / (NETDATA_DOUBLE)flushes / USEC_PER_MS : 0.0,
+            (NETDATA_DOUBLE)flush_ut_max / USEC_PER_MS);
+
+    int errors = 0;
+    for(STATSD_METRIC_TYPE type = 0; type < STATSD_METRIC_TYPES ;type++) {
+        STATSD_INDEX *index = statsd_index_of_type(type);
+        size_t metrics = dictionary_entries(index->dict);
+        size_t memory = statsd_benchmark_memory(index);
+
+        fprintf(stderr, "STATSD BENCHMARK: %-10s %6zu metrics, %10zu bytes, %6zu bytes/metric\n",
+                index->name, metrics, memory, metrics ? memory / metrics : 0);
+
+        // the generated packets have a known number of metrics per type
+        if(!filename && metrics != expected_metrics[type]) {
+            fprintf(stderr, "STATSD BENCHMARK: ERROR: expected %zu %s metrics, found %zu\n",
+                    expected_metrics[type], index->name, metrics);
+            errors++;
+        }
+    }
+
+    size_t unknown = statsd_stats->unknown_types;
+    if(!filename && unknown) {
+        fprintf(stderr, "STATSD BENCHMARK: ERROR: %zu metrics with unknown types\n", unknown);
+        errors++;
+    }
+
+    for(size_t i = 0; i < count ;i++)
+        freez(packets[i]);
+    freez(packets);
+    freez(lengths);
+    freez(s);
+
+    return errors ? 1 : 0;
+}
@@ -51,25 +51,28 @@ static int systemd_journal_directories_dyncfg_update(BUFFER *result, BUFFER *pay
     if(!payload || !buffer_strlen(payload))
         return dyncfg_default_response(result, HTTP_RESP_BAD_REQUEST, "empty payload received");
 
-    CLEAN_JSON_OBJECT *jobj = json_tokener_parse(buffer_tostring(payload));
-    if(!jobj)
+    CLEAN_JSON_STREAM js = { 0 };
+    JSON_STREAM_VALUE root;
+    if(!json_stream_init(&js, buffer_tostring(payload), buffer_strlen(payload), &root))
         return dyncfg_default_response(result, HTTP_RESP_BAD_REQUEST, "cannot parse json payload");
 
-    struct json_object *journalDirectories;
-    json_object_object_get_ex(jobj, JOURNAL_DIRECTORIES_JSON_NODE, &journalDirectories);
-
-    if (json_object_get_type(journalDirectories) != json_type_array)
+    JSON_STREAM_VALUE journalDirectories;
+    if (!json_stream_object_get(&js, &root, JOURNAL_DIRECTORIES_JSON_NODE, &journalDirectories) ||
+        journalDirectories.type != JSON_ARRAY)
         return dyncfg_default_response(result, HTTP_RESP_BAD_REQUEST,
                                        "member " JOURNAL_DIRECTORIES_JSON_NODE " is not an array");
 
-    size_t n_directories = json_object_array_length(journalDirectories);
+    size_t n_directories = json_stream_array_length(&js, &journalDirectories);
     if(n_directories > MAX_JOURNAL_DIRECTORIES)
         return dyncfg_default_response(result, HTTP_RESP_BAD_REQUEST, "too many directories configured");
 
+    JSON_STREAM_ITERATOR it;
+    JSON_STREAM_VALUE dir;
+
     // validate the directories
-    for(size_t i = 0; i < n_directories; i++) {
-        struct json_object *dir = json_object_array_get_idx(journalDirectories, i);
-        const char *s = json_object_get_string(dir);
+    json_stream_iterator_init(&js, &journalDirectories, &it);
+    while(json_stream_array_next(&js, &it, &dir)) {
+        const char *s = json_stream_string(&js, &dir);
         if(s && *s) {
             const char *msg = is_valid_dir(s);
             if(msg)
@@ -78,9 +81,9 @@ static int systemd_journal_directories_dyncfg_update(BUFFER *result, BUFFER *pay
     }
 
     size_t added = 0, not_found = 0;
-    for(size_t i = 0; i < n_directories; i++) {
-        struct json_object *dir = json_object_array_get_idx(journalDirectories, i);
-        const char *s = json_object_get_string(dir);
+    json_stream_iterator_init(&js, &journalDirectories, &it);
+    while(json_stream_array_next(&js, &it, &dir)) {
+        const char *s = json_stream_string(&js, &dir);
         if(s && *s) {
             string_freez(journal_directories[added].path);
             journal_directories[added++].path = string_strdupz(s);
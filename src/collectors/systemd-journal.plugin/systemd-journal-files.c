@@ -210,10 +210,141 @@ static void journal_file_get_boot_id_annotations(sd_journal *j __maybe_unused, s
 #endif
 }
 
+// ----------------------------------------------------------------------------
+// persisted summaries of the journal files
+//
+// The time-frame and the sequence numbers found in the header of each journal
+// file are saved in the cache directory, so that after a restart the files that
+// have not been modified are not opened again to find which queries they can
+// contribute to. On a central log server this is most of the files.
+
+#define JOURNAL_FILES_SUMMARIES_FILENAME "systemd-journal-files.summaries"
+
+struct journal_file_summary {
+    usec_t file_last_modified_ut;
+    size_t size;
+    usec_t msg_first_ut;
+    usec_t msg_last_ut;
+    uint64_t first_seqnum;
+    uint64_t last_seqnum;
+    sd_id128_t first_writer_id;
+    sd_id128_t last_writer_id;
+    uint64_t messages_in_file;
+};
+
+static char journal_files_summaries_filename[FILENAME_MAX + 1] = "";
+static DICTIONARY *journal_files_summaries = NULL;
+static size_t journal_files_headers_read = 0;
+
+static void journal_files_summaries_load(void) {
+    const char *cache_dir = getenv("NETDATA_CACHE_DIR");
+    if(!cache_dir || !*cache_dir)
+        return;
+
+    snprintfz(journal_files_summaries_filename, FILENAME_MAX, "%s/%s", cache_dir, JOURNAL_FILES_SUMMARIES_FILENAME);
+
+    journal_files_summaries = dictionary_create_advanced(
+            DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE,
+            NULL, sizeof(struct journal_file_summary));
+
+    FILE *fp = fopen(journal_files_summaries_filename, "r");
+    if(!fp)
+        return;
+
+    char line[FILENAME_MAX + 512];
+    while(fgets(line, sizeof(line), fp)) {
+        struct journal_file_summary s;
+        unsigned long long size;
+        int pos = 0;
+
+        if(sscanf(line, "%"SCNx64" %llx %"SCNx64" %"SCNx64" %"SCNx64" %"SCNx64" %"SCNx64" %"SCNx64" %"SCNx64" %"SCNx64" %"SCNx64" %n",
+                  &s.file_last_modified_ut, &size, &s.msg_first_ut, &s.msg_last_ut,
+                  &s.first_seqnum, &s.last_seqnum,
+                  &s.first_writer_id.qwords[0], &s.first_writer_id.qwords[1],
+                  &s.last_writer_id.qwords[0], &s.last_writer_id.qwords[1],
+                  &s.messages_in_file, &pos) != 11 || !pos)
+            continue;
+
+        char *filename = &line[pos];
+        char *nl = strchr(filename, '\n');
+        if(!nl || *filename != '/')
+            continue;
+        *nl = '\0';
+
+        s.size = size;
+        dictionary_set(journal_files_summaries, filename, &s, sizeof(s));
+    }
+    fclose(fp);
+
+    nd_log(NDLS_COLLECTORS, NDLP_DEBUG,
+           "JOURNAL: loaded the summaries of %zu journal files from '%s'",
+           dictionary_entries(journal_files_summaries), journal_files_summaries_filename);
+}
+
+static void journal_files_summaries_save(void) {
+    if(!journal_files_summaries)
+        return;
+
+    char tmp[FILENAME_MAX + 1];
+    snprintfz(tmp, FILENAME_MAX, "%s.new", journal_files_summaries_filename);
+
+    FILE *fp = fopen(tmp, "w");
+    if(!fp) {
+        nd_log(NDLS_COLLECTORS, NDLP_ERR, "JOURNAL: cannot create file '%s'", tmp);
+        return;
+    }
+
+    struct journal_file *jf;
+    dfe_start_read(journal_files_registry, jf) {
+        // only the files with a parsed header
+        if(jf->last_scan_header_vs_last_modified_ut != jf->file_last_modified_ut || !jf->msg_first_ut)
+            continue;
+
+        fprintf(fp, "%"PRIx64" %llx %"PRIx64" %"PRIx64" %"PRIx64" %"PRIx64" %"PRIx64" %"PRIx64" %"PRIx64" %"PRIx64" %"PRIx64" %s\n",
+                jf->file_last_modified_ut, (unsigned long long)jf->size, jf->msg_first_ut, jf->msg_last_ut,
+                jf->first_seqnum, jf->last_seqnum,
+                (uint64_t)jf->first_writer_id.qwords[0], (uint64_t)jf->first_writer_id.qwords[1],
+                (uint64_t)jf->last_writer_id.qwords[0], (uint64_t)jf->last_writer_id.qwords[1],
+                jf->messages_in_file, jf_dfe.name);
+    }
+    dfe_done(jf);
+
+    if(fclose(fp) != 0 || rename(tmp, journal_files_summaries_filename) != 0) {
+        nd_log(NDLS_COLLECTORS, NDLP_ERR, "JOURNAL: cannot save file '%s'", journal_files_summaries_filename);
+        unlink(tmp);
+    }
+}
+
+// when the file has not been modified since its summary was saved, use it instead of opening the file
+static bool journal_file_header_from_summary(const char *filename, struct journal_file *jf) {
+    if(!journal_files_summaries)
+        return false;
+
+    struct journal_file_summary *s = dictionary_get(journal_files_summaries, filename);
+    if(!s || s->file_last_modified_ut != jf->file_last_modified_ut || s->size != jf->size)
+        return false;
+
+    jf->first_seqnum = s->first_seqnum;
+    jf->last_seqnum = s->last_seqnum;
+    jf->first_writer_id = s->first_writer_id;
+    jf->last_writer_id = s->last_writer_id;
+    jf->msg_first_ut = s->msg_first_ut;
+    jf->msg_last_ut = s->msg_last_ut;
+    jf->messages_in_file = s->messages_in_file;
+    jf->last_scan_header_vs_last_modified_ut = jf->file_last_modified_ut;
+
+    return true;
+}
+
 void journal_file_update_header(const char *filename, struct journal_file *jf) {
     if(jf->last_scan_header_vs_last_modified_ut == jf->file_last_modified_ut)
         return;
 
+    if(journal_file_header_from_summary(filename, jf))
+        return;
+
+    __atomic_add_fetch(&journal_files_headers_read, 1, __ATOMIC_RELAXED);
+
     fstat_cache_enable_on_thread();
 
     const char *files[2] = {
@@ -674,6 +805,40 @@ int filenames_compar(const void *a, const void *b) {
     return -strcmp(p1, p2);
 }
 
+// the headers of the journal files are read in parallel, since each one needs the file to be opened
+#define JOURNAL_FILES_HEADER_SCAN_THREADS_MAX 8
+
+struct journal_files_header_scan {
+    const char **array;
+    size_t used;
+    size_t next;
+    usec_t scan_monotonic_ut;
+};
+
+static void *journal_files_header_scan_thread(void *ptr) {
+    struct journal_files_header_scan *hs = ptr;
+
+    size_t i;
+    while((i = __atomic_fetch_add(&hs->next, 1, __ATOMIC_RELAXED)) < hs->used) {
+        const char *full_path = hs->array[i];
+
+        struct stat info;
+        if (stat(full_path, &info) == -1)
+            continue;
+
+        struct journal_file t = {
+                .file_last_modified_ut = info.st_mtim.tv_sec * USEC_PER_SEC + info.st_mtim.tv_nsec / NSEC_PER_USEC,
+                .last_scan_monotonic_ut = hs->scan_monotonic_ut,
+                .size = info.st_size,
+                .max_journal_vs_realtime_delta_ut = JOURNAL_VS_REALTIME_DELTA_DEFAULT_UT,
+        };
+        struct journal_file *jf = dictionary_set(journal_files_registry, full_path, &t, sizeof(t));
+        journal_file_update_header(jf->filename, jf);
+    }
+
+    return NULL;
+}
+
 void journal_files_registry_update(void) {
     static SPINLOCK spinlock = NETDATA_SPINLOCK_INITIALIZER;
 
@@ -700,22 +865,28 @@ void journal_files_registry_update(void) {
 
         qsort(array, used, sizeof(const char *), filenames_compar);
 
-        for(size_t i = 0; i < used ;i++) {
-            const char *full_path = array[i];
+        struct journal_files_header_scan hs = {
+            .array = array,
+            .used = used,
+            .next = 0,
+            .scan_monotonic_ut = scan_monotonic_ut,
+        };
 
-            struct stat info;
-            if (stat(full_path, &info) == -1)
-                continue;
+        size_t threads = MIN((size_t)os_get_system_cpus(), JOURNAL_FILES_HEADER_SCAN_THREADS_MAX);
+        threads = MIN(threads, used / 2);
+
+        ND_THREAD *scanners[JOURNAL_FILES_HEADER_SCAN_THREADS_MAX] = { 0 };
+        for(size_t t = 1; t < threads ;t++)
+            scanners[t] = nd_thread_create("SDJ-HDR", NETDATA_THREAD_OPTION_JOINABLE | NETDATA_THREAD_OPTION_DONT_LOG,
+                                           journal_files_header_scan_thread, &hs);
+
+        // this thread works too
+        journal_files_header_scan_thread(&hs);
+
+        for(size_t t = 1; t < threads ;t++)
+            if(scanners[t])
+                nd_thread_join(scanners[t]);
 
-            struct journal_file t = {
-                    .file_last_modified_ut = info.st_mtim.tv_sec * USEC_PER_SEC + info.st_mtim.tv_nsec / NSEC_PER_USEC,
-                    .last_scan_monotonic_ut = scan_monotonic_ut,
-                    .size = info.st_size,
-                    .max_journal_vs_realtime_delta_ut = JOURNAL_VS_REALTIME_DELTA_DEFAULT_UT,
-            };
-            struct journal_file *jf = dictionary_set(journal_files_registry, full_path, &t, sizeof(t));
-            journal_file_update_header(jf->filename, jf);
-        }
         freez(array);
         dictionary_destroy(files);
         dictionary_destroy(dirs);
@@ -728,6 +899,15 @@ void journal_files_registry_update(void) {
         dfe_done(jf);
         dictionary_garbage_collect(journal_files_registry);
 
+        static size_t saved_headers_read = 0, saved_entries = 0;
+        size_t headers_read = __atomic_load_n(&journal_files_headers_read, __ATOMIC_RELAXED);
+        size_t entries = dictionary_entries(journal_files_registry);
+        if(headers_read != saved_headers_read || entries != saved_entries) {
+            journal_files_summaries_save();
+            saved_headers_read = headers_read;
+            saved_entries = entries;
+        }
+
         journal_files_scans++;
         spinlock_unlock(&spinlock);
 
@@ -819,6 +999,8 @@ void journal_init_files_and_directories(void) {
     dictionary_register_delete_callback(journal_files_registry, files_registry_delete_cb, NULL);
     dictionary_register_conflict_callback(journal_files_registry, files_registry_conflict_cb, NULL);
 
+    journal_files_summaries_load();
+
     boot_ids_to_first_ut = dictionary_create_advanced(
             DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE,
             NULL, sizeof(usec_t));
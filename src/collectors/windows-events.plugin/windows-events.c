@@ -480,6 +480,9 @@ static inline size_t wevt_process_event(WEVT_LOG *log, FACETS *facets, LOGS_QUER
 }
 
 static void send_progress_update(LOGS_QUERY_STATUS *lqs, size_t current_row_counter, bool flush_current_file) {
+    if(lqs->c.helper)
+        return;
+
     usec_t now_ut = now_monotonic_usec();
 
     if(current_row_counter > lqs->c.progress.entries.current_query_total) {
@@ -773,6 +776,182 @@ static bool source_is_mine(LOGS_QUERY_SOURCE *src, LOGS_QUERY_STATUS *lqs) {
     return false;
 }
 
+// ----------------------------------------------------------------------------
+// querying channels in parallel
+//
+// The channels of a query are picked by the calling thread and up to
+// WINDOWS_EVENTS_QUERY_THREADS - 1 query threads. Each query thread has its own
+// log and facets, set up from the same request, which are merged into the facets
+// of the query when it finishes.
+
+struct wevt_channel_query {
+    const DICTIONARY_ITEM *item;
+    bool queried;
+    WEVT_QUERY_STATUS status;
+
+    usec_t started_ut;
+    usec_t ended_ut;
+    size_t rows_read;
+    size_t rows_useful;
+    size_t bytes_read;
+    usec_t matches_setup_ut;
+};
+
+struct wevt_channels_plan {
+    struct wevt_channel_query *channels;
+    size_t used;
+
+    size_t next;                    // the next channel to be queried, by any thread
+    bool stop;                      // cancelled or timed out, no more channels are queried
+    usec_t max_duration_ut;         // the slowest channel so far
+};
+
+struct wevt_query_thread {
+    struct wevt_channels_plan *plan;
+    LOGS_QUERY_STATUS *lqs;
+    WEVT_LOG *log;
+
+    LOGS_QUERY_STATUS helper_lqs;   // the status of a query thread
+    ND_THREAD *thread;
+};
+
+static FACETS *wevt_facets_create(void) {
+    return lqs_facets_create(
+            LQS_DEFAULT_ITEMS_PER_QUERY,
+            FACETS_OPTION_ALL_KEYS_FTS | FACETS_OPTION_HASH_IDS,
+            WEVT_ALWAYS_VISIBLE_KEYS,
+            WEVT_KEYS_INCLUDED_IN_FACETS,
+            WEVT_KEYS_EXCLUDED_FROM_FACETS,
+            LQS_DEFAULT_SLICE_MODE);
+}
+
+static void wevt_query_channels(struct wevt_query_thread *qt) {
+    struct wevt_channels_plan *plan = qt->plan;
+    LOGS_QUERY_STATUS *lqs = qt->lqs;
+
+    size_t f;
+    while(!__atomic_load_n(&plan->stop, __ATOMIC_RELAXED) &&
+          (f = __atomic_fetch_add(&plan->next, 1, __ATOMIC_RELAXED)) < plan->used) {
+        struct wevt_channel_query *cq = &plan->channels[f];
+        LOGS_QUERY_SOURCE *src = dictionary_acquired_item_value(cq->item);
+
+        if(!source_is_mine(src, lqs))
+            continue;
+
+        cq->started_ut = now_monotonic_usec();
+
+        // do not even try to do the query if we expect it to pass the timeout
+        if(cq->started_ut + __atomic_load_n(&plan->max_duration_ut, __ATOMIC_RELAXED) * 3 >= *lqs->stop_monotonic_ut) {
+            cq->status = WEVT_TIMED_OUT;
+            __atomic_store_n(&plan->stop, true, __ATOMIC_RELAXED);
+            break;
+        }
+
+        lqs->c.file_working++;
+
+        size_t rows_useful = lqs->c.rows_useful;
+        size_t rows_read = lqs->c.rows_read;
+        size_t bytes_read = lqs->c.bytes_read;
+        size_t matches_setup_ut = lqs->c.matches_setup_ut;
+
+        // sampling_file_init(lqs, src);
+
+        lqs->c.progress.entries.current_query_total = src->entries;
+        cq->status = wevt_query_one_channel(qt->log, NULL, lqs->facets, src, lqs);
+        cq->queried = true;
+
+        cq->rows_useful = lqs->c.rows_useful - rows_useful;
+        cq->rows_read = lqs->c.rows_read - rows_read;
+        cq->bytes_read = lqs->c.bytes_read - bytes_read;
+        cq->matches_setup_ut = lqs->c.matches_setup_ut - matches_setup_ut;
+
+        cq->ended_ut = now_monotonic_usec();
+        usec_t duration_ut = cq->ended_ut - cq->started_ut;
+
+        usec_t max_duration_ut = __atomic_load_n(&plan->max_duration_ut, __ATOMIC_RELAXED);
+        while(duration_ut > max_duration_ut &&
+              !__atomic_compare_exchange_n(&plan->max_duration_ut, &max_duration_ut, duration_ut,
+                                           false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+        if(cq->status == WEVT_CANCELLED || cq->status == WEVT_TIMED_OUT)
+            __atomic_store_n(&plan->stop, true, __ATOMIC_RELAXED);
+    }
+}
+
+static void *wevt_query_thread_main(void *ptr) {
+    wevt_query_channels(ptr);
+    return NULL;
+}
+
+// set up a query thread, with its own facets for the same request and its own log
+static bool wevt_query_thread_init(struct wevt_query_thread *qt, struct wevt_channels_plan *plan, LOGS_QUERY_STATUS *lqs) {
+    LOGS_QUERY_STATUS tmp = {
+            .facets = wevt_facets_create(),
+            .rq = LOGS_QUERY_REQUEST_DEFAULTS(lqs->rq.transaction, LQS_DEFAULT_SLICE_MODE, FACETS_ANCHOR_DIRECTION_BACKWARD),
+            .cancelled = lqs->cancelled,
+            .stop_monotonic_ut = lqs->stop_monotonic_ut,
+    };
+
+    CLEAN_BUFFER *tmp_wb = lqs_create_output_buffer();
+    if(!lqs_request_parse_and_validate(&tmp, tmp_wb, lqs->c.function, lqs->c.payload, LQS_DEFAULT_SLICE_MODE, WEVT_FIELD_LEVEL)) {
+        lqs_cleanup(&tmp);
+        return false;
+    }
+    wevt_register_fields(&tmp);
+
+    WEVT_LOG *log = wevt_openlog6();
+    if(!log) {
+        lqs_cleanup(&tmp);
+        return false;
+    }
+
+    // the same request, anchor, timeframe and query, with its own facets and counters
+    qt->helper_lqs = *lqs;
+    qt->helper_lqs.facets = tmp.facets;
+    qt->helper_lqs.last_modified = 0;
+    qt->helper_lqs.c.helper = true;
+    qt->helper_lqs.c.file_working = 0;
+    qt->helper_lqs.c.rows_useful = 0;
+    qt->helper_lqs.c.rows_read = 0;
+    qt->helper_lqs.c.bytes_read = 0;
+    qt->helper_lqs.c.matches_setup_ut = 0;
+
+    qt->plan = plan;
+    qt->lqs = &qt->helper_lqs;
+    qt->log = log;
+
+    // the log has to stay open until the rows have been rendered
+    lqs->c.helper_logs[lqs->c.helper_logs_used++] = log;
+
+    tmp.facets = NULL;
+    lqs_cleanup(&tmp);
+    return true;
+}
+
+static void wevt_query_thread_merge(struct wevt_query_thread *qt, LOGS_QUERY_STATUS *lqs) {
+    LOGS_QUERY_STATUS *h = &qt->helper_lqs;
+
+    facets_merge(lqs->facets, h->facets);
+    facets_destroy(h->facets);
+    h->facets = NULL;
+
+    lqs->c.file_working += h->c.file_working;
+    lqs->c.rows_useful += h->c.rows_useful;
+    lqs->c.rows_read += h->c.rows_read;
+    lqs->c.bytes_read += h->c.bytes_read;
+    lqs->c.matches_setup_ut += h->c.matches_setup_ut;
+
+    if(h->last_modified > lqs->last_modified)
+        lqs->last_modified = h->last_modified;
+}
+
+static void wevt_query_threads_cleanup(LOGS_QUERY_STATUS *lqs) {
+    for(size_t i = 0; i < lqs->c.helper_logs_used ;i++)
+        wevt_closelog6(lqs->c.helper_logs[i]);
+
+    lqs->c.helper_logs_used = 0;
+}
+
 static int wevt_master_query(BUFFER *wb __maybe_unused, LOGS_QUERY_STATUS *lqs __maybe_unused) {
     // make sure the sources list is updated
     wevt_sources_scan();
@@ -832,10 +1011,6 @@ static int wevt_master_query(BUFFER *wb __maybe_unused, LOGS_QUERY_STATUS *lqs _
     }
 
     bool partial = false;
-    usec_t query_started_ut = now_monotonic_usec();
-    usec_t started_ut = query_started_ut;
-    usec_t ended_ut = started_ut;
-    usec_t duration_ut, max_duration_ut = 0;
 
     WEVT_LOG *log = wevt_openlog6();
     if(!log) {
@@ -849,45 +1024,61 @@ static int wevt_master_query(BUFFER *wb __maybe_unused, LOGS_QUERY_STATUS *lqs _
 
     // sampling_query_init(lqs, facets);
 
-    buffer_json_member_add_array(wb, "_channels");
-    for(size_t f = 0; f < files_used ;f++) {
-        const char *fullname = dictionary_acquired_item_name(file_items[f]);
-        src = dictionary_acquired_item_value(file_items[f]);
+    struct wevt_channel_query channels[files_used + 1];
+    for(size_t f = 0; f < files_used ;f++)
+        channels[f] = (struct wevt_channel_query) { .item = file_items[f], .status = WEVT_NO_CHANNEL_MATCHED, };
 
-        if(!source_is_mine(src, lqs))
-            continue;
+    struct wevt_channels_plan plan = {
+            .channels = channels,
+            .used = files_used,
+    };
 
-        started_ut = ended_ut;
+    // the calling thread queries channels too
+    size_t threads = MIN(files_used, WINDOWS_EVENTS_QUERY_THREADS);
+    struct wevt_query_thread qts[threads + 1];
+    qts[0] = (struct wevt_query_thread) { .plan = &plan, .lqs = lqs, .log = log, };
 
-        // do not even try to do the query if we expect it to pass the timeout
-        if(ended_ut + max_duration_ut * 3 >= *lqs->stop_monotonic_ut) {
-            partial = true;
-            status = WEVT_TIMED_OUT;
+    size_t helpers = 0;
+    for(size_t t = 1; t < threads ;t++) {
+        struct wevt_query_thread *qt = &qts[helpers + 1];
+        memset(qt, 0, sizeof(*qt));
+
+        if(!wevt_query_thread_init(qt, &plan, lqs))
             break;
-        }
 
-        lqs->c.file_working++;
+        // a thread that could not be started has not queried anything, but its facets are still cleaned up below
+        qt->thread = nd_thread_create("WEVT_QUERY", NETDATA_THREAD_OPTION_JOINABLE, wevt_query_thread_main, qt);
+        helpers++;
 
-        size_t rows_useful = lqs->c.rows_useful;
-        size_t rows_read = lqs->c.rows_read;
-        size_t bytes_read = lqs->c.bytes_read;
-        size_t matches_setup_ut = lqs->c.matches_setup_ut;
+        if(!qt->thread)
+            break;
+    }
 
-        // sampling_file_init(lqs, src);
+    wevt_query_channels(&qts[0]);
 
-        lqs->c.progress.entries.current_query_total = src->entries;
-        WEVT_QUERY_STATUS tmp_status = wevt_query_one_channel(log, wb, facets, src, lqs);
+    for(size_t t = 1; t <= helpers ;t++) {
+        if(qts[t].thread)
+            nd_thread_join(qts[t].thread);
 
-        rows_useful = lqs->c.rows_useful - rows_useful;
-        rows_read = lqs->c.rows_read - rows_read;
-        bytes_read = lqs->c.bytes_read - bytes_read;
-        matches_setup_ut = lqs->c.matches_setup_ut - matches_setup_ut;
+        wevt_query_thread_merge(&qts[t], lqs);
+    }
 
-        ended_ut = now_monotonic_usec();
-        duration_ut = ended_ut - started_ut;
+    WEVT_QUERY_STATUS stop_status = WEVT_OK;
+    buffer_json_member_add_array(wb, "_channels");
+    for(size_t f = 0; f < files_used ;f++) {
+        struct wevt_channel_query *cq = &channels[f];
 
-        if(duration_ut > max_duration_ut)
-            max_duration_ut = duration_ut;
+        if(!cq->queried) {
+            if(cq->status == WEVT_TIMED_OUT) {
+                partial = true;
+                stop_status = WEVT_TIMED_OUT;
+            }
+            continue;
+        }
+
+        const char *fullname = dictionary_acquired_item_name(cq->item);
+        src = dictionary_acquired_item_value(cq->item);
+        usec_t duration_ut = cq->ended_ut - cq->started_ut;
 
         buffer_json_add_array_item_object(wb); // channel source
         {
@@ -899,13 +1090,13 @@ static int wevt_master_query(BUFFER *wb __maybe_unused, LOGS_QUERY_STATUS *lqs _
             buffer_json_member_add_uint64(wb, "_msg_last_ut", src->msg_last_ut);
 
             // information about the current use of the file
-            buffer_json_member_add_uint64(wb, "duration_ut", ended_ut - started_ut);
-            buffer_json_member_add_uint64(wb, "rows_read", rows_read);
-            buffer_json_member_add_uint64(wb, "rows_useful", rows_useful);
-            buffer_json_member_add_double(wb, "rows_per_second", (double) rows_read / (double) duration_ut * (double) USEC_PER_SEC);
-            buffer_json_member_add_uint64(wb, "bytes_read", bytes_read);
-            buffer_json_member_add_double(wb, "bytes_per_second", (double) bytes_read / (double) duration_ut * (double) USEC_PER_SEC);
-            buffer_json_member_add_uint64(wb, "duration_matches_ut", matches_setup_ut);
+            buffer_json_member_add_uint64(wb, "duration_ut", duration_ut);
+            buffer_json_member_add_uint64(wb, "rows_read", cq->rows_read);
+            buffer_json_member_add_uint64(wb, "rows_useful", cq->rows_useful);
+            buffer_json_member_add_double(wb, "rows_per_second", (double) cq->rows_read / (double) duration_ut * (double) USEC_PER_SEC);
+            buffer_json_member_add_uint64(wb, "bytes_read", cq->bytes_read);
+            buffer_json_member_add_double(wb, "bytes_per_second", (double) cq->bytes_read / (double) duration_ut * (double) USEC_PER_SEC);
+            buffer_json_member_add_uint64(wb, "duration_matches_ut", cq->matches_setup_ut);
 
             // if(lqs->rq.sampling) {
             //     buffer_json_member_add_object(wb, "_sampling");
@@ -919,37 +1110,36 @@ static int wevt_master_query(BUFFER *wb __maybe_unused, LOGS_QUERY_STATUS *lqs _
         }
         buffer_json_object_close(wb); // channel source
 
-        bool stop = false;
-        switch(tmp_status) {
+        switch(cq->status) {
             case WEVT_OK:
             case WEVT_NO_CHANNEL_MATCHED:
-                status = (status == WEVT_OK) ? WEVT_OK : tmp_status;
+                status = (status == WEVT_OK) ? WEVT_OK : cq->status;
                 break;
 
             case WEVT_FAILED_TO_OPEN:
             case WEVT_FAILED_TO_SEEK:
                 partial = true;
                 if(status == WEVT_NO_CHANNEL_MATCHED)
-                    status = tmp_status;
+                    status = cq->status;
                 break;
 
             case WEVT_CANCELLED:
             case WEVT_TIMED_OUT:
                 partial = true;
-                stop = true;
-                status = tmp_status;
+                stop_status = cq->status;
                 break;
 
             case WEVT_NOT_MODIFIED:
                 internal_fatal(true, "this should never be returned here");
                 break;
         }
-
-        if(stop)
-            break;
     }
     buffer_json_array_close(wb); // _channels
 
+    // the channels that were queried are reported, but the query was stopped
+    if(stop_status != WEVT_OK)
+        status = stop_status;
+
     // release the files
     for(size_t f = 0; f < files_used ;f++)
         dictionary_acquired_item_release(wevt_sources, file_items[f]);
@@ -1079,18 +1269,17 @@ void function_windows_events(const char *transaction, char *function, usec_t *st
     bool have_slice = LQS_DEFAULT_SLICE_MODE;
 
     LOGS_QUERY_STATUS tmp_fqs = {
-            .facets = lqs_facets_create(
-                    LQS_DEFAULT_ITEMS_PER_QUERY,
-                    FACETS_OPTION_ALL_KEYS_FTS | FACETS_OPTION_HASH_IDS,
-                    WEVT_ALWAYS_VISIBLE_KEYS,
-                    WEVT_KEYS_INCLUDED_IN_FACETS,
-                    WEVT_KEYS_EXCLUDED_FROM_FACETS,
-                    have_slice),
+            .facets = wevt_facets_create(),
 
             .rq = LOGS_QUERY_REQUEST_DEFAULTS(transaction, have_slice, FACETS_ANCHOR_DIRECTION_BACKWARD),
 
             .cancelled = cancelled,
             .stop_monotonic_ut = stop_monotonic_ut,
+
+            .c = {
+                    .function = function,
+                    .payload = payload,
+            },
     };
     LOGS_QUERY_STATUS *lqs = &tmp_fqs;
 
@@ -1123,6 +1312,7 @@ void function_windows_events(const char *transaction, char *function, usec_t *st
     pluginsd_function_result_to_stdout(transaction, wb);
     netdata_mutex_unlock(&stdout_mutex);
 
+    wevt_query_threads_cleanup(lqs);
     lqs_cleanup(lqs);
 }
 
@@ -136,6 +136,7 @@ typedef enum {
 #define WEVT_FUNCTION_NAME           "windows-events"
 
 #define WINDOWS_EVENTS_WORKER_THREADS 5
+#define WINDOWS_EVENTS_QUERY_THREADS 4
 #define WINDOWS_EVENTS_DEFAULT_TIMEOUT 600
 #define WINDOWS_EVENTS_SCAN_EVERY_USEC (5 * 60 * USEC_PER_SEC)
 #define WINDOWS_EVENTS_PROGRESS_EVERY_UT (250 * USEC_PER_MS)
@@ -166,6 +167,15 @@ typedef enum {
 struct lqs_extension {
     wchar_t *query;
 
+    // the request, to set up the facets of the threads that query channels in parallel
+    char *function;
+    BUFFER *payload;
+
+    // the logs of the query threads, the events of their rows are rendered from them
+    WEVT_LOG *helper_logs[WINDOWS_EVENTS_QUERY_THREADS];
+    size_t helper_logs_used;
+    bool helper;            // a query thread, the progress is reported by the main one
+
     struct {
         struct {
             size_t completed;
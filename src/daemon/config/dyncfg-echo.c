@@ -96,6 +96,7 @@ void dyncfg_echo(const DICTIONARY_ITEM *item, DYNCFG *df, const char *id __maybe
         dyncfg_echo_cb, e,
         NULL, NULL,
         NULL, NULL,
+        NULL, NULL,
         NULL, string2str(df->dyncfg.source), false);
 }
 
@@ -129,6 +130,7 @@ void dyncfg_echo_update(const DICTIONARY_ITEM *item, DYNCFG *df, const char *id)
         dyncfg_echo_cb, e,
         NULL, NULL,
         NULL, NULL,
+        NULL, NULL,
         df->dyncfg.payload, string2str(df->dyncfg.source), false);
 }
 
@@ -164,6 +166,7 @@ static void dyncfg_echo_payload_add(const DICTIONARY_ITEM *item_template __maybe
         dyncfg_echo_cb, e,
         NULL, NULL,
         NULL, NULL,
+        NULL, NULL,
         df_job->dyncfg.payload, string2str(df_job->dyncfg.source), false);
 }
 
@@ -424,6 +424,23 @@ static void sched_setscheduler_set(void) {
 }
 #endif /* HAVE_SCHED_SETSCHEDULER */
 
+#define CONFIG_SECTION_THREAD_CPUS "thread cpu affinity"
+#define CONFIG_SECTION_THREAD_NICE "thread nice level"
+
+static bool thread_cpus_config_cb(void *data __maybe_unused, const char *name, const char *value) {
+    return nd_thread_policy_cpus_add(name, value);
+}
+
+static bool thread_nice_config_cb(void *data __maybe_unused, const char *name, const char *value) {
+    return nd_thread_policy_nice_add(name, str2i(value));
+}
+
+// the cpus and the nice level of the threads, by their tags
+static void thread_policies_set(void) {
+    appconfig_foreach_value_in_section(&netdata_config, CONFIG_SECTION_THREAD_CPUS, thread_cpus_config_cb, NULL);
+    appconfig_foreach_value_in_section(&netdata_config, CONFIG_SECTION_THREAD_NICE, thread_nice_config_cb, NULL);
+}
+
 int become_daemon(int dont_fork, const char *user)
 {
     if(!dont_fork) {
@@ -479,6 +496,7 @@ int become_daemon(int dont_fork, const char *user)
 
     // never become a problem
     sched_setscheduler_set();
+    thread_policies_set();
 
     if(user && *user) {
         if(become_user(user, pidfd) != 0) {
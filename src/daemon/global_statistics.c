@@ -14,9 +14,10 @@
 #define WORKER_JOB_DICTIONARIES       7
 #define WORKER_JOB_MALLOC_TRACE       8
 #define WORKER_JOB_SQLITE3            9
+#define WORKER_JOB_ACLK_QUERIES      10
 
-#if WORKER_UTILIZATION_MAX_JOB_TYPES < 10
-#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 10
+#if WORKER_UTILIZATION_MAX_JOB_TYPES < 11
+#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 11
 #endif
 
 bool global_statistics_enabled = true;
@@ -26,7 +27,7 @@ struct netdata_buffers_statistics netdata_buffers_statistics = {};
 static size_t dbengine_total_memory = 0;
 size_t rrddim_db_memory_size = 0;
 
-static struct global_statistics {
+struct global_statistics {
     uint16_t connected_clients;
 
     uint64_t web_requests;
@@ -72,94 +73,206 @@ static struct global_statistics {
     uint64_t tier0_disk_uncompressed_bytes;
 
     uint64_t db_points_stored_per_tier[RRD_STORAGE_TIERS];
+};
 
-} global_statistics = {
-        .connected_clients = 0,
-        .web_requests = 0,
-        .web_usec = 0,
-        .bytes_received = 0,
-        .bytes_sent = 0,
-        .content_size = 0,
-        .compressed_content_size = 0,
-        .web_client_count = 1,
-
-        .api_data_queries_made = 0,
-        .api_data_db_points_read = 0,
-        .api_data_result_points_generated = 0,
-
-        .tier0_hot_gorilla_buffers = 0,
-        .tier0_disk_compressed_bytes = 0,
-        .tier0_disk_uncompressed_bytes = 0,
+// ----------------------------------------------------------------------------
+// per thread counters
+//
+// Every thread records its statistics in its own block of counters, so that
+// threads running on different CPUs do not fight for the same cache lines.
+// Only the owner thread writes to its block (so no atomic read-modify-write
+// is needed), and the global statistics thread aggregates all blocks when it
+// collects. When a thread exits, its counters are added to the 'exited' block.
+
+struct global_statistics_thread {
+    struct global_statistics stats;
+    struct global_statistics_thread *prev, *next;
 };
 
+static struct {
+    SPINLOCK spinlock;
+    struct global_statistics_thread *list;
+    struct global_statistics exited;
+
+    // this is an id generator, it has to be global
+    uint64_t web_client_count;
+} gs_threads = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .list = NULL,
+    .web_client_count = 1,
+};
+
+static __thread struct global_statistics_thread *gs_thread = NULL;
+
+static inline struct global_statistics *global_statistics_thread_get(void) {
+    if(unlikely(!gs_thread)) {
+        struct global_statistics_thread *t = callocz(1, sizeof(*t));
+
+        spinlock_lock(&gs_threads.spinlock);
+        DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(gs_threads.list, t, prev, next);
+        spinlock_unlock(&gs_threads.spinlock);
+
+        gs_thread = t;
+    }
+
+    return &gs_thread->stats;
+}
+
+// only the owner thread writes, the aggregator just needs to see whole values
+#define gs_thread_add(gs, member, value) __atomic_store_n(&(gs)->member, (gs)->member + (value), __ATOMIC_RELAXED)
+
+static inline void global_statistics_aggregate(struct global_statistics *dst, struct global_statistics *src, bool reset_web_usec_max) {
+    dst->connected_clients                   += __atomic_load_n(&src->connected_clients, __ATOMIC_RELAXED);
+    dst->web_requests                        += __atomic_load_n(&src->web_requests, __ATOMIC_RELAXED);
+    dst->web_usec                            += __atomic_load_n(&src->web_usec, __ATOMIC_RELAXED);
+    dst->bytes_received                      += __atomic_load_n(&src->bytes_received, __ATOMIC_RELAXED);
+    dst->bytes_sent                          += __atomic_load_n(&src->bytes_sent, __ATOMIC_RELAXED);
+    dst->content_size                        += __atomic_load_n(&src->content_size, __ATOMIC_RELAXED);
+    dst->compressed_content_size             += __atomic_load_n(&src->compressed_content_size, __ATOMIC_RELAXED);
+
+    uint64_t web_usec_max = reset_web_usec_max ?
+        __atomic_exchange_n(&src->web_usec_max, 0, __ATOMIC_RELAXED) :
+        __atomic_load_n(&src->web_usec_max, __ATOMIC_RELAXED);
+    if(web_usec_max > dst->web_usec_max)
+        dst->web_usec_max = web_usec_max;
+
+    dst->api_data_queries_made               += __atomic_load_n(&src->api_data_queries_made, __ATOMIC_RELAXED);
+    dst->api_data_db_points_read             += __atomic_load_n(&src->api_data_db_points_read, __ATOMIC_RELAXED);
+    dst->api_data_result_points_generated    += __atomic_load_n(&src->api_data_result_points_generated, __ATOMIC_RELAXED);
+
+    dst->api_weights_queries_made            += __atomic_load_n(&src->api_weights_queries_made, __ATOMIC_RELAXED);
+    dst->api_weights_db_points_read          += __atomic_load_n(&src->api_weights_db_points_read, __ATOMIC_RELAXED);
+    dst->api_weights_result_points_generated += __atomic_load_n(&src->api_weights_result_points_generated, __ATOMIC_RELAXED);
+
+    dst->api_badges_queries_made             += __atomic_load_n(&src->api_badges_queries_made, __ATOMIC_RELAXED);
+    dst->api_badges_db_points_read           += __atomic_load_n(&src->api_badges_db_points_read, __ATOMIC_RELAXED);
+    dst->api_badges_result_points_generated  += __atomic_load_n(&src->api_badges_result_points_generated, __ATOMIC_RELAXED);
+
+    dst->health_queries_made                 += __atomic_load_n(&src->health_queries_made, __ATOMIC_RELAXED);
+    dst->health_db_points_read               += __atomic_load_n(&src->health_db_points_read, __ATOMIC_RELAXED);
+    dst->health_result_points_generated      += __atomic_load_n(&src->health_result_points_generated, __ATOMIC_RELAXED);
+
+    dst->ml_queries_made                     += __atomic_load_n(&src->ml_queries_made, __ATOMIC_RELAXED);
+    dst->ml_db_points_read                   += __atomic_load_n(&src->ml_db_points_read, __ATOMIC_RELAXED);
+    dst->ml_result_points_generated          += __atomic_load_n(&src->ml_result_points_generated, __ATOMIC_RELAXED);
+    dst->ml_models_consulted                 += __atomic_load_n(&src->ml_models_consulted, __ATOMIC_RELAXED);
+
+    dst->exporters_queries_made              += __atomic_load_n(&src->exporters_queries_made, __ATOMIC_RELAXED);
+    dst->exporters_db_points_read            += __atomic_load_n(&src->exporters_db_points_read, __ATOMIC_RELAXED);
+    dst->backfill_queries_made               += __atomic_load_n(&src->backfill_queries_made, __ATOMIC_RELAXED);
+    dst->backfill_db_points_read             += __atomic_load_n(&src->backfill_db_points_read, __ATOMIC_RELAXED);
+
+    dst->tier0_hot_gorilla_buffers           += __atomic_load_n(&src->tier0_hot_gorilla_buffers, __ATOMIC_RELAXED);
+
+    dst->tier0_disk_compressed_bytes         += __atomic_load_n(&src->tier0_disk_compressed_bytes, __ATOMIC_RELAXED);
+    dst->tier0_disk_uncompressed_bytes       += __atomic_load_n(&src->tier0_disk_uncompressed_bytes, __ATOMIC_RELAXED);
+
+    for(size_t tier = 0; tier < storage_tiers ;tier++)
+        dst->db_points_stored_per_tier[tier] += __atomic_load_n(&src->db_points_stored_per_tier[tier], __ATOMIC_RELAXED);
+}
+
+// called by nd_thread_exit()
+void global_statistics_thread_exit(void) {
+    struct global_statistics_thread *t = gs_thread;
+    if(!t) return;
+
+    gs_thread = NULL;
+
+    spinlock_lock(&gs_threads.spinlock);
+    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(gs_threads.list, t, prev, next);
+    global_statistics_aggregate(&gs_threads.exited, &t->stats, false);
+    spinlock_unlock(&gs_threads.spinlock);
+
+    freez(t);
+}
+
+// ----------------------------------------------------------------------------
+// recording API
+
 void global_statistics_rrdset_done_chart_collection_completed(size_t *points_read_per_tier_array) {
+    struct global_statistics *gs = global_statistics_thread_get();
+
     for(size_t tier = 0; tier < storage_tiers ;tier++) {
-        __atomic_fetch_add(&global_statistics.db_points_stored_per_tier[tier], points_read_per_tier_array[tier], __ATOMIC_RELAXED);
+        gs_thread_add(gs, db_points_stored_per_tier[tier], points_read_per_tier_array[tier]);
         points_read_per_tier_array[tier] = 0;
     }
 }
 
 void global_statistics_ml_query_completed(size_t points_read) {
-    __atomic_fetch_add(&global_statistics.ml_queries_made, 1, __ATOMIC_RELAXED);
-    __atomic_fetch_add(&global_statistics.ml_db_points_read, points_read, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, ml_queries_made, 1);
+    gs_thread_add(gs, ml_db_points_read, points_read);
 }
 
 void global_statistics_ml_models_consulted(size_t models_consulted) {
-    __atomic_fetch_add(&global_statistics.ml_models_consulted, models_consulted, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, ml_models_consulted, models_consulted);
 }
 
 void global_statistics_exporters_query_completed(size_t points_read) {
-    __atomic_fetch_add(&global_statistics.exporters_queries_made, 1, __ATOMIC_RELAXED);
-    __atomic_fetch_add(&global_statistics.exporters_db_points_read, points_read, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, exporters_queries_made, 1);
+    gs_thread_add(gs, exporters_db_points_read, points_read);
 }
 
 void global_statistics_backfill_query_completed(size_t points_read) {
-    __atomic_fetch_add(&global_statistics.backfill_queries_made, 1, __ATOMIC_RELAXED);
-    __atomic_fetch_add(&global_statistics.backfill_db_points_read, points_read, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, backfill_queries_made, 1);
+    gs_thread_add(gs, backfill_db_points_read, points_read);
 }
 
 void global_statistics_gorilla_buffer_add_hot() {
-    __atomic_fetch_add(&global_statistics.tier0_hot_gorilla_buffers, 1, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, tier0_hot_gorilla_buffers, 1);
 }
 
 void global_statistics_tier0_disk_compressed_bytes(uint32_t size) {
-    __atomic_fetch_add(&global_statistics.tier0_disk_compressed_bytes, size, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, tier0_disk_compressed_bytes, size);
 }
 
 void global_statistics_tier0_disk_uncompressed_bytes(uint32_t size) {
-    __atomic_fetch_add(&global_statistics.tier0_disk_uncompressed_bytes, size, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, tier0_disk_uncompressed_bytes, size);
 }
 
 void global_statistics_rrdr_query_completed(size_t queries, uint64_t db_points_read, uint64_t result_points_generated, QUERY_SOURCE query_source) {
+    struct global_statistics *gs;
+
     switch(query_source) {
         case QUERY_SOURCE_API_DATA:
-            __atomic_fetch_add(&global_statistics.api_data_queries_made, queries, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.api_data_db_points_read, db_points_read, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.api_data_result_points_generated, result_points_generated, __ATOMIC_RELAXED);
+            gs = global_statistics_thread_get();
+            gs_thread_add(gs, api_data_queries_made, queries);
+            gs_thread_add(gs, api_data_db_points_read, db_points_read);
+            gs_thread_add(gs, api_data_result_points_generated, result_points_generated);
             break;
 
         case QUERY_SOURCE_ML:
-            __atomic_fetch_add(&global_statistics.ml_queries_made, queries, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.ml_db_points_read, db_points_read, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.ml_result_points_generated, result_points_generated, __ATOMIC_RELAXED);
+            gs = global_statistics_thread_get();
+            gs_thread_add(gs, ml_queries_made, queries);
+            gs_thread_add(gs, ml_db_points_read, db_points_read);
+            gs_thread_add(gs, ml_result_points_generated, result_points_generated);
             break;
 
         case QUERY_SOURCE_API_WEIGHTS:
-            __atomic_fetch_add(&global_statistics.api_weights_queries_made, queries, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.api_weights_db_points_read, db_points_read, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.api_weights_result_points_generated, result_points_generated, __ATOMIC_RELAXED);
+            gs = global_statistics_thread_get();
+            gs_thread_add(gs, api_weights_queries_made, queries);
+            gs_thread_add(gs, api_weights_db_points_read, db_points_read);
+            gs_thread_add(gs, api_weights_result_points_generated, result_points_generated);
             break;
 
         case QUERY_SOURCE_API_BADGE:
-            __atomic_fetch_add(&global_statistics.api_badges_queries_made, queries, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.api_badges_db_points_read, db_points_read, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.api_badges_result_points_generated, result_points_generated, __ATOMIC_RELAXED);
+            gs = global_statistics_thread_get();
+            gs_thread_add(gs, api_badges_queries_made, queries);
+            gs_thread_add(gs, api_badges_db_points_read, db_points_read);
+            gs_thread_add(gs, api_badges_result_points_generated, result_points_generated);
             break;
 
         case QUERY_SOURCE_HEALTH:
-            __atomic_fetch_add(&global_statistics.health_queries_made, queries, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.health_db_points_read, db_points_read, __ATOMIC_RELAXED);
-            __atomic_fetch_add(&global_statistics.health_result_points_generated, result_points_generated, __ATOMIC_RELAXED);
+            gs = global_statistics_thread_get();
+            gs_thread_add(gs, health_queries_made, queries);
+            gs_thread_add(gs, health_db_points_read, db_points_read);
+            gs_thread_add(gs, health_result_points_generated, result_points_generated);
             break;
 
         default:
@@ -174,76 +287,49 @@ void global_statistics_web_request_completed(uint64_t dt,
                                              uint64_t bytes_sent,
                                              uint64_t content_size,
                                              uint64_t compressed_content_size) {
-    uint64_t old_web_usec_max = global_statistics.web_usec_max;
-    while(dt > old_web_usec_max)
-        __atomic_compare_exchange(&global_statistics.web_usec_max, &old_web_usec_max, &dt, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
-
-    __atomic_fetch_add(&global_statistics.web_requests, 1, __ATOMIC_RELAXED);
-    __atomic_fetch_add(&global_statistics.web_usec, dt, __ATOMIC_RELAXED);
-    __atomic_fetch_add(&global_statistics.bytes_received, bytes_received, __ATOMIC_RELAXED);
-    __atomic_fetch_add(&global_statistics.bytes_sent, bytes_sent, __ATOMIC_RELAXED);
-    __atomic_fetch_add(&global_statistics.content_size, content_size, __ATOMIC_RELAXED);
-    __atomic_fetch_add(&global_statistics.compressed_content_size, compressed_content_size, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+
+    // the aggregator may reset it concurrently, losing one max sample is fine
+    if(dt > __atomic_load_n(&gs->web_usec_max, __ATOMIC_RELAXED))
+        __atomic_store_n(&gs->web_usec_max, dt, __ATOMIC_RELAXED);
+
+    gs_thread_add(gs, web_requests, 1);
+    gs_thread_add(gs, web_usec, dt);
+    gs_thread_add(gs, bytes_received, bytes_received);
+    gs_thread_add(gs, bytes_sent, bytes_sent);
+    gs_thread_add(gs, content_size, content_size);
+    gs_thread_add(gs, compressed_content_size, compressed_content_size);
 }
 
 uint64_t global_statistics_web_client_connected(void) {
-    __atomic_fetch_add(&global_statistics.connected_clients, 1, __ATOMIC_RELAXED);
-    return __atomic_fetch_add(&global_statistics.web_client_count, 1, __ATOMIC_RELAXED);
+    // a client may disconnect on another thread - the per thread values
+    // wrap around, but their sum is always right
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, connected_clients, 1);
+
+    return __atomic_fetch_add(&gs_threads.web_client_count, 1, __ATOMIC_RELAXED);
 }
 
 void global_statistics_web_client_disconnected(void) {
-    __atomic_fetch_sub(&global_statistics.connected_clients, 1, __ATOMIC_RELAXED);
+    struct global_statistics *gs = global_statistics_thread_get();
+    gs_thread_add(gs, connected_clients, -1);
 }
 
 static inline void global_statistics_copy(struct global_statistics *gs, uint8_t options) {
-    gs->connected_clients            = __atomic_load_n(&global_statistics.connected_clients, __ATOMIC_RELAXED);
-    gs->web_requests                 = __atomic_load_n(&global_statistics.web_requests, __ATOMIC_RELAXED);
-    gs->web_usec                     = __atomic_load_n(&global_statistics.web_usec, __ATOMIC_RELAXED);
-    gs->web_usec_max                 = __atomic_load_n(&global_statistics.web_usec_max, __ATOMIC_RELAXED);
-    gs->bytes_received               = __atomic_load_n(&global_statistics.bytes_received, __ATOMIC_RELAXED);
-    gs->bytes_sent                   = __atomic_load_n(&global_statistics.bytes_sent, __ATOMIC_RELAXED);
-    gs->content_size                 = __atomic_load_n(&global_statistics.content_size, __ATOMIC_RELAXED);
-    gs->compressed_content_size      = __atomic_load_n(&global_statistics.compressed_content_size, __ATOMIC_RELAXED);
-    gs->web_client_count             = __atomic_load_n(&global_statistics.web_client_count, __ATOMIC_RELAXED);
-
-    gs->api_data_queries_made            = __atomic_load_n(&global_statistics.api_data_queries_made, __ATOMIC_RELAXED);
-    gs->api_data_db_points_read          = __atomic_load_n(&global_statistics.api_data_db_points_read, __ATOMIC_RELAXED);
-    gs->api_data_result_points_generated = __atomic_load_n(&global_statistics.api_data_result_points_generated, __ATOMIC_RELAXED);
-
-    gs->api_weights_queries_made            = __atomic_load_n(&global_statistics.api_weights_queries_made, __ATOMIC_RELAXED);
-    gs->api_weights_db_points_read          = __atomic_load_n(&global_statistics.api_weights_db_points_read, __ATOMIC_RELAXED);
-    gs->api_weights_result_points_generated = __atomic_load_n(&global_statistics.api_weights_result_points_generated, __ATOMIC_RELAXED);
-
-    gs->api_badges_queries_made            = __atomic_load_n(&global_statistics.api_badges_queries_made, __ATOMIC_RELAXED);
-    gs->api_badges_db_points_read          = __atomic_load_n(&global_statistics.api_badges_db_points_read, __ATOMIC_RELAXED);
-    gs->api_badges_result_points_generated = __atomic_load_n(&global_statistics.api_badges_result_points_generated, __ATOMIC_RELAXED);
-
-    gs->health_queries_made            = __atomic_load_n(&global_statistics.health_queries_made, __ATOMIC_RELAXED);
-    gs->health_db_points_read          = __atomic_load_n(&global_statistics.health_db_points_read, __ATOMIC_RELAXED);
-    gs->health_result_points_generated = __atomic_load_n(&global_statistics.health_result_points_generated, __ATOMIC_RELAXED);
-
-    gs->ml_queries_made              = __atomic_load_n(&global_statistics.ml_queries_made, __ATOMIC_RELAXED);
-    gs->ml_db_points_read            = __atomic_load_n(&global_statistics.ml_db_points_read, __ATOMIC_RELAXED);
-    gs->ml_result_points_generated   = __atomic_load_n(&global_statistics.ml_result_points_generated, __ATOMIC_RELAXED);
-    gs->ml_models_consulted          = __atomic_load_n(&global_statistics.ml_models_consulted, __ATOMIC_RELAXED);
-
-    gs->exporters_queries_made       = __atomic_load_n(&global_statistics.exporters_queries_made, __ATOMIC_RELAXED);
-    gs->exporters_db_points_read     = __atomic_load_n(&global_statistics.exporters_db_points_read, __ATOMIC_RELAXED);
-    gs->backfill_queries_made       = __atomic_load_n(&global_statistics.backfill_queries_made, __ATOMIC_RELAXED);
-    gs->backfill_db_points_read     = __atomic_load_n(&global_statistics.backfill_db_points_read, __ATOMIC_RELAXED);
-
-    gs->tier0_hot_gorilla_buffers     = __atomic_load_n(&global_statistics.tier0_hot_gorilla_buffers, __ATOMIC_RELAXED);
-
-    gs->tier0_disk_compressed_bytes = __atomic_load_n(&global_statistics.tier0_disk_compressed_bytes, __ATOMIC_RELAXED);
-    gs->tier0_disk_uncompressed_bytes = __atomic_load_n(&global_statistics.tier0_disk_uncompressed_bytes, __ATOMIC_RELAXED);
+    bool reset_web_usec_max = (options & GLOBAL_STATS_RESET_WEB_USEC_MAX);
 
-    for(size_t tier = 0; tier < storage_tiers ;tier++)
-        gs->db_points_stored_per_tier[tier] = __atomic_load_n(&global_statistics.db_points_stored_per_tier[tier], __ATOMIC_RELAXED);
+    memset(gs, 0, sizeof(*gs));
 
-    if(options & GLOBAL_STATS_RESET_WEB_USEC_MAX) {
-        uint64_t n = 0;
-        __atomic_compare_exchange(&global_statistics.web_usec_max, (uint64_t *) &gs->web_usec_max, &n, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
-    }
+    spinlock_lock(&gs_threads.spinlock);
+
+    global_statistics_aggregate(gs, &gs_threads.exited, reset_web_usec_max);
+
+    for(struct global_statistics_thread *t = gs_threads.list; t ; t = t->next)
+        global_statistics_aggregate(gs, &t->stats, reset_web_usec_max);
+
+    spinlock_unlock(&gs_threads.spinlock);
+
+    gs->web_client_count = __atomic_load_n(&gs_threads.web_client_count, __ATOMIC_RELAXED);
 }
 
 #define dictionary_stats_memory_total(stats) \
@@ -459,7 +545,138 @@ static void global_statistics_charts(void) {
 
         rrddim_set_by_pointer(st_duration, rd_max, ((gs.web_usec_max)?(collected_number)gs.web_usec_max:average_response_time));
         rrdset_done(st_duration);
-    }    
+    }
+
+    // ----------------------------------------------------------------
+
+    {
+        static RRDSET *st_spawn = NULL, *st_spawn_latency = NULL;
+        static RRDDIM *rd_started = NULL, *rd_failed = NULL;
+        static RRDDIM *rd_average = NULL, *rd_max = NULL;
+        static size_t old_requests = 0;
+        static usec_t old_latency_ut = 0;
+
+        SPAWN_POPEN_STATISTICS ss;
+        spawn_popen_statistics(&ss);
+
+        if (unlikely(!st_spawn)) {
+            st_spawn = rrdset_create_localhost(
+                    "netdata"
+                    , "spawn_requests"
+                    , NULL
+                    , "spawn"
+                    , NULL
+                    , "Netdata Spawn Server Requests"
+                    , "requests/s"
+                    , "netdata"
+                    , "stats"
+                    , 130510
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_STACKED
+            );
+
+            rd_started = rrddim_add(st_spawn, "started", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_failed = rrddim_add(st_spawn, "failed", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+
+            st_spawn_latency = rrdset_create_localhost(
+                    "netdata"
+                    , "spawn_latency"
+                    , NULL
+                    , "spawn"
+                    , NULL
+                    , "Netdata Spawn Server Latency"
+                    , "milliseconds/request"
+                    , "netdata"
+                    , "stats"
+                    , 130511
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_LINE
+            );
+
+            rd_average = rrddim_add(st_spawn_latency, "average", NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+            rd_max = rrddim_add(st_spawn_latency, "max", NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+        }
+
+        rrddim_set_by_pointer(st_spawn, rd_started, (collected_number)ss.started);
+        rrddim_set_by_pointer(st_spawn, rd_failed, (collected_number)ss.failed);
+        rrdset_done(st_spawn);
+
+        size_t requests = ss.started + ss.failed;
+        size_t dr = requests - old_requests;
+        usec_t dl = ss.latency_ut - old_latency_ut;
+        old_requests = requests;
+        old_latency_ut = ss.latency_ut;
+
+        rrddim_set_by_pointer(st_spawn_latency, rd_average, dr ? (collected_number)(dl / dr) : 0);
+        rrddim_set_by_pointer(st_spawn_latency, rd_max, (collected_number)ss.latency_max_ut);
+        rrdset_done(st_spawn_latency);
+    }
+
+    // ----------------------------------------------------------------
+
+    HEALTH_NOTIFICATIONS_STATISTICS hs;
+    if(health_notifications_statistics(&hs)) {
+        static RRDSET *st_notifications = NULL, *st_notifications_latency = NULL;
+        static RRDDIM *rd_queued = NULL, *rd_coalesced = NULL, *rd_delivered = NULL, *rd_batches = NULL;
+        static RRDDIM *rd_average = NULL, *rd_max = NULL;
+        static size_t old_delivered = 0;
+        static usec_t old_latency_ut = 0;
+
+        if (unlikely(!st_notifications)) {
+            st_notifications = rrdset_create_localhost(
+                    "netdata"
+                    , "health_notifications"
+                    , NULL
+                    , "health"
+                    , NULL
+                    , "Netdata Batched Alert Notifications"
+                    , "notifications/s"
+                    , "netdata"
+                    , "stats"
+                    , 130520
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_LINE
+            );
+
+            rd_queued = rrddim_add(st_notifications, "queued", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_coalesced = rrddim_add(st_notifications, "coalesced", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_delivered = rrddim_add(st_notifications, "delivered", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_batches = rrddim_add(st_notifications, "batches", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+
+            st_notifications_latency = rrdset_create_localhost(
+                    "netdata"
+                    , "health_notifications_latency"
+                    , NULL
+                    , "health"
+                    , NULL
+                    , "Netdata Alert Notifications Queue Latency"
+                    , "milliseconds/notification"
+                    , "netdata"
+                    , "stats"
+                    , 130521
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_LINE
+            );
+
+            rd_average = rrddim_add(st_notifications_latency, "average", NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+            rd_max = rrddim_add(st_notifications_latency, "max", NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+        }
+
+        rrddim_set_by_pointer(st_notifications, rd_queued, (collected_number)hs.queued);
+        rrddim_set_by_pointer(st_notifications, rd_coalesced, (collected_number)hs.coalesced);
+        rrddim_set_by_pointer(st_notifications, rd_delivered, (collected_number)hs.delivered);
+        rrddim_set_by_pointer(st_notifications, rd_batches, (collected_number)hs.batches);
+        rrdset_done(st_notifications);
+
+        size_t dd = hs.delivered - old_delivered;
+        usec_t dl = hs.latency_ut - old_latency_ut;
+        old_delivered = hs.delivered;
+        old_latency_ut = hs.latency_ut;
+
+        rrddim_set_by_pointer(st_notifications_latency, rd_average, dd ? (collected_number)(dl / dd) : 0);
+        rrddim_set_by_pointer(st_notifications_latency, rd_max, (collected_number)hs.latency_max_ut);
+        rrdset_done(st_notifications_latency);
+    }
 }
 
 static void global_statistics_extended_charts(void) {
@@ -627,6 +844,44 @@ static void global_statistics_extended_charts(void) {
         rrdset_done(st_memory_buffers);
     }
 
+    if(malloc_sampling_enabled()) {
+        static RRDSET *st_memory_sampled = NULL;
+        static RRDDIM *rd_sampler = NULL;
+        static RRDDIM *rd_subsystems[MALLOC_SAMPLING_MAX_SUBSYSTEMS] = { NULL };
+
+        if (unlikely(!st_memory_sampled)) {
+            st_memory_sampled = rrdset_create_localhost(
+                "netdata",
+                "memory_allocations_sampled",
+                NULL,
+                "netdata",
+                NULL,
+                "Netdata Allocated Memory per Subsystem (sampled)",
+                "bytes",
+                "netdata",
+                "stats",
+                130102,
+                localhost->rrd_update_every,
+                RRDSET_TYPE_STACKED);
+
+            rd_sampler = rrddim_add(st_memory_sampled, "sampler overhead", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+        }
+
+        // the subsystems are the thread tags that allocated memory, they are discovered at runtime
+        MALLOC_SAMPLING_SUBSYSTEM_STATS stats[MALLOC_SAMPLING_MAX_SUBSYSTEMS];
+        size_t subsystems = malloc_sampling_subsystems(stats, MALLOC_SAMPLING_MAX_SUBSYSTEMS);
+        for(size_t i = 0; i < subsystems ; i++) {
+            if(unlikely(!rd_subsystems[i]))
+                rd_subsystems[i] = rrddim_add(st_memory_sampled, stats[i].name, NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+            rrddim_set_by_pointer(st_memory_sampled, rd_subsystems[i], (collected_number)stats[i].live_bytes);
+        }
+
+        rrddim_set_by_pointer(st_memory_sampled, rd_sampler, (collected_number)malloc_sampling_memory());
+
+        rrdset_done(st_memory_sampled);
+    }
+
 
     {
         static RRDSET *st_compression = NULL;
@@ -848,7 +1103,11 @@ static void global_statistics_extended_charts(void) {
     }
 
 #ifdef ENABLE_DBENGINE
-    if (tier_page_type[0] == RRDENG_PAGE_TYPE_GORILLA_32BIT)
+    bool tier0_gorilla_pages = tier_page_type[0] == RRDENG_PAGE_TYPE_GORILLA_32BIT ||
+                               tier_page_type[0] == RRDENG_PAGE_TYPE_GORILLA_64BIT ||
+                               tier0_double_precision_contexts;
+
+    if (tier0_gorilla_pages)
     {
         static RRDSET *st_tier0_gorilla_pages = NULL;
         static RRDDIM *rd_num_gorilla_pages = NULL;
@@ -877,7 +1136,7 @@ static void global_statistics_extended_charts(void) {
         rrdset_done(st_tier0_gorilla_pages);
     }
 
-    if (tier_page_type[0] == RRDENG_PAGE_TYPE_GORILLA_32BIT)
+    if (tier0_gorilla_pages)
     {
         static RRDSET *st_tier0_compression_info = NULL;
 
@@ -1218,6 +1477,175 @@ static void sqlite3_statistics_charts(void) {
     // ----------------------------------------------------------------
 }
 
+// ----------------------------------------------------------------------------
+// ACLK query queue statistics
+
+struct aclk_query_statistics {
+    uint64_t pending_interactive;
+    uint64_t pending_background;
+    uint64_t running;
+    uint64_t dispatched_interactive;
+    uint64_t dispatched_background;
+    uint64_t wait_ut_interactive;
+    uint64_t wait_ut_background;
+    uint64_t expired;
+} aclk_query_statistics = { };
+
+void global_statistics_aclk_queries_pending(size_t interactive, size_t background, size_t running) {
+    __atomic_store_n(&aclk_query_statistics.pending_interactive, interactive, __ATOMIC_RELAXED);
+    __atomic_store_n(&aclk_query_statistics.pending_background, background, __ATOMIC_RELAXED);
+    __atomic_store_n(&aclk_query_statistics.running, running, __ATOMIC_RELAXED);
+}
+
+void global_statistics_aclk_query_dispatched(bool background, usec_t wait_ut) {
+    if(background) {
+        __atomic_fetch_add(&aclk_query_statistics.dispatched_background, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&aclk_query_statistics.wait_ut_background, wait_ut, __ATOMIC_RELAXED);
+    }
+    else {
+        __atomic_fetch_add(&aclk_query_statistics.dispatched_interactive, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&aclk_query_statistics.wait_ut_interactive, wait_ut, __ATOMIC_RELAXED);
+    }
+}
+
+void global_statistics_aclk_query_expired(void) {
+    __atomic_fetch_add(&aclk_query_statistics.expired, 1, __ATOMIC_RELAXED);
+}
+
+static inline void aclk_query_statistics_copy(struct aclk_query_statistics *gs) {
+    gs->pending_interactive    = __atomic_load_n(&aclk_query_statistics.pending_interactive, __ATOMIC_RELAXED);
+    gs->pending_background     = __atomic_load_n(&aclk_query_statistics.pending_background, __ATOMIC_RELAXED);
+    gs->running                = __atomic_load_n(&aclk_query_statistics.running, __ATOMIC_RELAXED);
+    gs->dispatched_interactive = __atomic_load_n(&aclk_query_statistics.dispatched_interactive, __ATOMIC_RELAXED);
+    gs->dispatched_background  = __atomic_load_n(&aclk_query_statistics.dispatched_background, __ATOMIC_RELAXED);
+    gs->wait_ut_interactive    = __atomic_load_n(&aclk_query_statistics.wait_ut_interactive, __ATOMIC_RELAXED);
+    gs->wait_ut_background     = __atomic_load_n(&aclk_query_statistics.wait_ut_background, __ATOMIC_RELAXED);
+    gs->expired                = __atomic_load_n(&aclk_query_statistics.expired, __ATOMIC_RELAXED);
+}
+
+static collected_number aclk_query_average_wait(uint64_t wait_ut, uint64_t *old_wait_ut, uint64_t queries, uint64_t *old_queries) {
+    uint64_t dt_ut = (wait_ut >= *old_wait_ut) ? wait_ut - *old_wait_ut : 0;
+    uint64_t dq = (queries >= *old_queries) ? queries - *old_queries : 0;
+
+    *old_wait_ut = wait_ut;
+    *old_queries = queries;
+
+    return dq ? (collected_number)(dt_ut / dq) : 0;
+}
+
+static void aclk_query_statistics_charts(void) {
+    struct aclk_query_statistics gs;
+    aclk_query_statistics_copy(&gs);
+
+    if(!gs.dispatched_interactive && !gs.dispatched_background && !gs.expired)
+        return;
+
+    {
+        static RRDSET *st_queue = NULL;
+        static RRDDIM *rd_interactive = NULL, *rd_background = NULL, *rd_running = NULL;
+
+        if (unlikely(!st_queue)) {
+            st_queue = rrdset_create_localhost(
+                "netdata"
+                , "aclk_query_queue"
+                , NULL
+                , "aclk"
+                , NULL
+                , "Netdata ACLK Queries Queue"
+                , "queries"
+                , "netdata"
+                , "stats"
+                , 131200
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+            );
+
+            rd_interactive = rrddim_add(st_queue, "interactive", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            rd_background  = rrddim_add(st_queue, "background",  NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            rd_running     = rrddim_add(st_queue, "running",     NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+        }
+
+        rrddim_set_by_pointer(st_queue, rd_interactive, (collected_number)gs.pending_interactive);
+        rrddim_set_by_pointer(st_queue, rd_background,  (collected_number)gs.pending_background);
+        rrddim_set_by_pointer(st_queue, rd_running,     (collected_number)gs.running);
+
+        rrdset_done(st_queue);
+    }
+
+    // ----------------------------------------------------------------
+
+    {
+        static RRDSET *st_queries = NULL;
+        static RRDDIM *rd_interactive = NULL, *rd_background = NULL, *rd_expired = NULL;
+
+        if (unlikely(!st_queries)) {
+            st_queries = rrdset_create_localhost(
+                "netdata"
+                , "aclk_queries_dispatched"
+                , NULL
+                , "aclk"
+                , NULL
+                , "Netdata ACLK Queries Dispatched"
+                , "queries/s"
+                , "netdata"
+                , "stats"
+                , 131201
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+            );
+
+            rd_interactive = rrddim_add(st_queries, "interactive", NULL,  1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_background  = rrddim_add(st_queries, "background",  NULL,  1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_expired     = rrddim_add(st_queries, "expired",     NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
+        }
+
+        rrddim_set_by_pointer(st_queries, rd_interactive, (collected_number)gs.dispatched_interactive);
+        rrddim_set_by_pointer(st_queries, rd_background,  (collected_number)gs.dispatched_background);
+        rrddim_set_by_pointer(st_queries, rd_expired,     (collected_number)gs.expired);
+
+        rrdset_done(st_queries);
+    }
+
+    // ----------------------------------------------------------------
+
+    {
+        static uint64_t old_wait_ut_interactive = 0, old_dispatched_interactive = 0;
+        static uint64_t old_wait_ut_background = 0, old_dispatched_background = 0;
+
+        static RRDSET *st_wait = NULL;
+        static RRDDIM *rd_interactive = NULL, *rd_background = NULL;
+
+        if (unlikely(!st_wait)) {
+            st_wait = rrdset_create_localhost(
+                "netdata"
+                , "aclk_query_wait_time"
+                , NULL
+                , "aclk"
+                , NULL
+                , "Netdata ACLK Queries Average Wait Time in Queue"
+                , "milliseconds/query"
+                , "netdata"
+                , "stats"
+                , 131202
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+            );
+
+            rd_interactive = rrddim_add(st_wait, "interactive", NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+            rd_background  = rrddim_add(st_wait, "background",  NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+        }
+
+        rrddim_set_by_pointer(st_wait, rd_interactive,
+                              aclk_query_average_wait(gs.wait_ut_interactive, &old_wait_ut_interactive,
+                                                      gs.dispatched_interactive, &old_dispatched_interactive));
+        rrddim_set_by_pointer(st_wait, rd_background,
+                              aclk_query_average_wait(gs.wait_ut_background, &old_wait_ut_background,
+                                                      gs.dispatched_background, &old_dispatched_background));
+
+        rrdset_done(st_wait);
+    }
+}
+
 #ifdef ENABLE_DBENGINE
 
 struct dbengine2_cache_pointers {
@@ -1235,6 +1663,8 @@ struct dbengine2_cache_pointers {
     RRDDIM *rd_acquires;
     RRDDIM *rd_releases;
     RRDDIM *rd_acquires_for_deletion;
+    RRDDIM *rd_promotions;
+    RRDDIM *rd_evictions_from_probation;
 
     RRDSET *st_pgc_memory;
     RRDDIM *rd_pgc_memory_free;
@@ -1321,6 +1751,10 @@ static void dbengine2_cache_statistics_charts(struct dbengine2_cache_pointers *p
                     localhost->rrd_update_every,
                     RRDSET_TYPE_LINE);
 
+            // the policy label allows comparing the hit ratio of different eviction policies
+            rrdlabels_add(ptrs->st_cache_hit_ratio->rrdlabels, "eviction_policy",
+                          pgc_eviction_policy_name(pgc_stats->eviction_policy), RRDLABEL_SRC_AUTO);
+
             ptrs->rd_hit_ratio_closest = rrddim_add(ptrs->st_cache_hit_ratio, "closest", NULL, 1, 10000, RRD_ALGORITHM_ABSOLUTE);
             ptrs->rd_hit_ratio_exact = rrddim_add(ptrs->st_cache_hit_ratio, "exact", NULL, 1, 10000, RRD_ALGORITHM_ABSOLUTE);
 
@@ -1378,6 +1812,8 @@ static void dbengine2_cache_statistics_charts(struct dbengine2_cache_pointers *p
             ptrs->rd_acquires           = rrddim_add(ptrs->st_operations, "acquires", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
             ptrs->rd_releases           = rrddim_add(ptrs->st_operations, "releases", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
             ptrs->rd_acquires_for_deletion = rrddim_add(ptrs->st_operations, "del acquires", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            ptrs->rd_promotions         = rrddim_add(ptrs->st_operations, "promotions", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            ptrs->rd_evictions_from_probation = rrddim_add(ptrs->st_operations, "probation evictions", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
 
             buffer_free(id);
             buffer_free(family);
@@ -1394,6 +1830,8 @@ static void dbengine2_cache_statistics_charts(struct dbengine2_cache_pointers *p
         rrddim_set_by_pointer(ptrs->st_operations, ptrs->rd_acquires, (collected_number)pgc_stats->acquires);
         rrddim_set_by_pointer(ptrs->st_operations, ptrs->rd_releases, (collected_number)pgc_stats->releases);
         rrddim_set_by_pointer(ptrs->st_operations, ptrs->rd_acquires_for_deletion, (collected_number)pgc_stats->acquires_for_deletion);
+        rrddim_set_by_pointer(ptrs->st_operations, ptrs->rd_promotions, (collected_number)pgc_stats->evict_promotions);
+        rrddim_set_by_pointer(ptrs->st_operations, ptrs->rd_evictions_from_probation, (collected_number)pgc_stats->evict_from_probation);
 
         rrdset_done(ptrs->st_operations);
     }
@@ -1854,6 +2292,37 @@ static void dbengine2_statistics_charts(void) {
         rrdset_done(st_pgc_memory);
     }
 
+    if(dbengine_use_huge_pages) {
+        static RRDSET *st_pgc_huge_pages = NULL;
+        static RRDDIM *rd_pgc_huge_pages_pgc = NULL;
+        static RRDDIM *rd_pgc_huge_pages_mrg = NULL;
+
+        if (unlikely(!st_pgc_huge_pages)) {
+            st_pgc_huge_pages = rrdset_create_localhost(
+                    "netdata",
+                    "dbengine_huge_pages",
+                    NULL,
+                    "dbengine memory",
+                    NULL,
+                    "Netdata DB Huge Pages",
+                    "bytes",
+                    "netdata",
+                    "stats",
+                    priority,
+                    localhost->rrd_update_every,
+                    RRDSET_TYPE_STACKED);
+
+            rd_pgc_huge_pages_pgc = rrddim_add(st_pgc_huge_pages, "pgc", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            rd_pgc_huge_pages_mrg = rrddim_add(st_pgc_huge_pages, "mrg", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+        }
+        priority++;
+
+        rrddim_set_by_pointer(st_pgc_huge_pages, rd_pgc_huge_pages_pgc, (collected_number)pgc_aral_huge_pages());
+        rrddim_set_by_pointer(st_pgc_huge_pages, rd_pgc_huge_pages_mrg, (collected_number)mrg_aral_huge_pages());
+
+        rrdset_done(st_pgc_huge_pages);
+    }
+
     {
         static RRDSET *st_pgc_buffers = NULL;
         static RRDDIM *rd_pgc_buffers_pgc = NULL;
@@ -3502,6 +3971,8 @@ static struct worker_utilization all_workers_utilization[] = {
     { .name = "DBENGINE",    .family = "workers dbengine instances",      .priority = 1000000 },
     { .name = "LIBUV",       .family = "workers libuv threadpool",        .priority = 1000000 },
     { .name = "WEB",         .family = "workers web server",              .priority = 1000000 },
+    { .name = "QUERY",       .family = "workers query threads",           .priority = 1000000 },
+    { .name = "WEBOFFLOAD",  .family = "workers web offload threads",     .priority = 1000000 },
     { .name = "ACLKSYNC",    .family = "workers aclk sync",               .priority = 1000000 },
     { .name = "METASYNC",    .family = "workers metadata sync",           .priority = 1000000 },
     { .name = "PLUGINSD",    .family = "workers plugins.d",               .priority = 1000000 },
@@ -3520,8 +3991,10 @@ static struct worker_utilization all_workers_utilization[] = {
     { .name = "IDLEJITTER",  .family = "workers plugin idlejitter",       .priority = 1000000 },
     { .name = "LOGSMANAGPLG",.family = "workers plugin logs management",  .priority = 1000000 },
     { .name = "RRDCONTEXT",  .family = "workers contexts",                .priority = 1000000 },
+    { .name = "VIEWS",       .family = "workers materialized views",      .priority = 1000000 },
     { .name = "REPLICATION", .family = "workers replication sender",      .priority = 1000000 },
     { .name = "SERVICE",     .family = "workers service",                 .priority = 1000000 },
+    { .name = "EXECUTOR",    .family = "workers executor",                .priority = 1000000 },
     { .name = "PROFILER",    .family = "workers profile",                 .priority = 1000000 },
 
     // has to be terminated with a NULL
@@ -4199,6 +4672,7 @@ static void global_statistics_register_workers(void) {
     worker_register_job_name(WORKER_JOB_MALLOC_TRACE, "malloc_trace");
     worker_register_job_name(WORKER_JOB_WORKERS, "workers");
     worker_register_job_name(WORKER_JOB_SQLITE3, "sqlite3");
+    worker_register_job_name(WORKER_JOB_ACLK_QUERIES, "aclk_queries");
 }
 
 static void global_statistics_cleanup(void *pptr)
@@ -4333,6 +4807,9 @@ void *global_statistics_extended_main(void *ptr)
 
         worker_is_busy(WORKER_JOB_SQLITE3);
         sqlite3_statistics_charts();
+
+        worker_is_busy(WORKER_JOB_ACLK_QUERIES);
+        aclk_query_statistics_charts();
     }
 
     return NULL;
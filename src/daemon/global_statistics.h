@@ -43,6 +43,9 @@ void global_statistics_backfill_query_completed(size_t points_read);
 void global_statistics_rrdr_query_completed(size_t queries, uint64_t db_points_read, uint64_t result_points_generated, QUERY_SOURCE query_source);
 void global_statistics_sqlite3_query_completed(bool success, bool busy, bool locked);
 void global_statistics_sqlite3_row_completed(void);
+void global_statistics_aclk_queries_pending(size_t interactive, size_t background, size_t running);
+void global_statistics_aclk_query_dispatched(bool background, usec_t wait_ut);
+void global_statistics_aclk_query_expired(void);
 void global_statistics_rrdset_done_chart_collection_completed(size_t *points_read_per_tier_array);
 
 void global_statistics_gorilla_buffer_add_hot();
@@ -59,6 +62,8 @@ void global_statistics_web_request_completed(uint64_t dt,
 uint64_t global_statistics_web_client_connected(void);
 void global_statistics_web_client_disconnected(void);
 
+void global_statistics_thread_exit(void);
+
 extern bool global_statistics_enabled;
 
 #endif /* NETDATA_GLOBAL_STATISTICS_H */
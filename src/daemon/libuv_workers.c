@@ -41,6 +41,11 @@ void register_libuv_worker_jobs() {
     worker_register_job_name(UV_EVENT_DBENGINE_FIND_ROTATED_METRICS, "find rotated metrics");
     worker_register_job_name(UV_EVENT_DBENGINE_FIND_REMAINING_RETENTION, "find remaining retention");
     worker_register_job_name(UV_EVENT_DBENGINE_POPULATE_MRG, "update retention");
+    worker_register_job_name(UV_EVENT_DBENGINE_DATAFILE_ARCHIVE, "datafile archive");
+
+    // compaction related
+    worker_register_job_name(UV_EVENT_DBENGINE_COMPACTION, "datafile compaction");
+    worker_register_job_name(UV_EVENT_DBENGINE_COMPACTION_SWAP, "datafile compaction swap");
 
     // other dbengine events
     worker_register_job_name(UV_EVENT_DBENGINE_EVICT_MAIN_CACHE, "evict main");
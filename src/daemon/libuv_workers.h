@@ -33,6 +33,11 @@ enum event_loop_job {
     UV_EVENT_DBENGINE_FIND_ROTATED_METRICS, // find the metrics that are rotated
     UV_EVENT_DBENGINE_FIND_REMAINING_RETENTION, // find their remaining retention
     UV_EVENT_DBENGINE_POPULATE_MRG, // update mrg
+    UV_EVENT_DBENGINE_DATAFILE_ARCHIVE, // upload the datafile to the object storage
+
+    // compaction related
+    UV_EVENT_DBENGINE_COMPACTION,
+    UV_EVENT_DBENGINE_COMPACTION_SWAP,
 
     // other dbengine events
     UV_EVENT_DBENGINE_EVICT_MAIN_CACHE,
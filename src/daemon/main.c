@@ -6,6 +6,13 @@
 #include "static_threads.h"
 
 #include "database/engine/page_test.h"
+#include "database/engine/dbengine-compression.h"
+#include "database/engine/dbengine-uring.h"
+#include "database/engine/metric-directory.h"
+#include "database/engine/dbengine-compaction.h"
+#include "database/engine/dbengine-archive.h"
+#include "web/api/queries/query_cache.h"
+#include "web/api/queries/query_threads.h"
 #include <curl/curl.h>
 
 #ifdef OS_WINDOWS
@@ -383,6 +390,7 @@ void netdata_cleanup_and_exit(int ret, const char *action, const char *action_re
     service_wait_exit(SERVICE_ACLK, 3 * USEC_PER_SEC);
     watcher_step_complete(WATCHER_STEP_ID_STOP_ACLK_THREADS);
 
+    nd_executor_shutdown();
     service_wait_exit(~0, 10 * USEC_PER_SEC);
     watcher_step_complete(WATCHER_STEP_ID_STOP_ALL_REMAINING_WORKER_THREADS);
 
@@ -447,8 +455,7 @@ void netdata_cleanup_and_exit(int ret, const char *action, const char *action_re
             }
             watcher_step_complete(WATCHER_STEP_ID_WAIT_FOR_DBENGINE_MAIN_CACHE_TO_FINISH_FLUSHING);
 
-            for (size_t tier = 0; tier < storage_tiers; tier++)
-                rrdeng_exit(multidb_ctx[tier]);
+            rrdeng_exit_all_tiers();
             rrdeng_enq_cmd(NULL, RRDENG_OPCODE_SHUTDOWN_EVLOOP, NULL, NULL, STORAGE_PRIORITY_BEST_EFFORT, NULL, NULL);
             watcher_step_complete(WATCHER_STEP_ID_STOP_DBENGINE_TIERS);
         } else {
@@ -490,6 +497,8 @@ void netdata_cleanup_and_exit(int ret, const char *action, const char *action_re
     watcher_thread_stop();
     curl_global_cleanup();
 
+    nd_log_async_stop();
+
 #ifdef OS_WINDOWS
     return;
 #endif
@@ -615,6 +624,33 @@ void web_server_config_options(void)
         netdata_log_error("Invalid compression level %d. Valid levels are 1 (fastest) to 9 (best ratio). Proceeding with level 9 (best compression).", web_gzip_level);
         web_gzip_level = 9;
     }
+
+    query_cache_init((size_t)config_get_number(CONFIG_SECTION_WEB, "query cache entries", 256));
+
+    long long stream_chunk_size = config_get_number(CONFIG_SECTION_WEB, "response streaming chunk size", (long long)web_response_stream_chunk_size);
+    web_response_stream_chunk_size = (stream_chunk_size > 0) ? (size_t)stream_chunk_size : 0;
+
+    web_static_files_cache = config_get_boolean(CONFIG_SECTION_WEB, "cache static files", web_static_files_cache);
+    web_static_files_brotli_quality = (int)config_get_number(CONFIG_SECTION_WEB, "static files brotli quality", web_static_files_brotli_quality);
+    if(web_static_files_brotli_quality < 0 || web_static_files_brotli_quality > 11) {
+        netdata_log_error("Invalid static files brotli quality %d. Valid qualities are 0 (fastest) to 11 (best ratio). Proceeding with 9.", web_static_files_brotli_quality);
+        web_static_files_brotli_quality = 9;
+    }
+
+    weights_baseline_cache_ttl_s = config_get_number(CONFIG_SECTION_WEB, "correlations baseline cache seconds", weights_baseline_cache_ttl_s);
+    if(weights_baseline_cache_ttl_s < 0)
+        weights_baseline_cache_ttl_s = 0;
+
+    long long baseline_cache_mib = config_get_number(CONFIG_SECTION_WEB, "correlations baseline cache size MiB", (long long)(weights_baseline_cache_max_size / 1024 / 1024));
+    weights_baseline_cache_max_size = (baseline_cache_mib > 0) ? (size_t)baseline_cache_mib * 1024 * 1024 : 0;
+
+    long long query_threads = (long long)get_netdata_cpus() / 2;
+    if(query_threads > 8)
+        query_threads = 8;
+
+    query_threads = config_get_number(CONFIG_SECTION_WEB, "query threads", query_threads);
+    if(query_threads > 0)
+        query_threads_init((size_t)query_threads);
 }
 
 static void set_nofile_limit(struct rlimit *rl) {
@@ -779,6 +815,8 @@ int help(int exitcode) {
             "  -W stacksize=N           Set the stacksize (in bytes).\n\n"
             "  -W debug_flags=N         Set runtime tracing to debug.log.\n\n"
             "  -W unittest              Run internal unittests and exit.\n\n"
+            "  -W statsdtest[=S,R,FILE] Replay statsd packets for S seconds, at R packets/s,\n"
+            "                           to benchmark the statsd server and exit.\n\n"
             "  -W sqlite-meta-recover   Run recovery on the metadata database and exit.\n\n"
             "  -W sqlite-compact        Reclaim metadata database unused space and exit.\n\n"
             "  -W sqlite-analyze        Run update statistics and exit.\n\n"
@@ -791,7 +829,20 @@ int help(int exitcode) {
             "                           time of D seconds for writers, a page cache\n"
             "                           size of E MiB, an optional disk space limit\n"
             "                           of F MiB, G libuv workers (default 16) and exit.\n\n"
+            "  -W dbengine-benchmark[=M,P,Q,W,C,FILE]\n"
+            "                           Run the DB engine benchmark scenarios (ingestion,\n"
+            "                           flush, cold and warm queries, startup) with M metrics\n"
+            "                           of P points each, Q queries, W writer threads and a\n"
+            "                           page cache of C MiB, write the results as JSON to\n"
+            "                           FILE (default stdout) and exit.\n\n"
 #endif
+            "  -W microbenchmarks[=R,PATTERN,FILE]\n"
+            "                           Run the micro-benchmarks of the core structures\n"
+            "                           (STRING, DICTIONARY, ARAL, storage_number, gorilla,\n"
+            "                           BUFFER JSON, procfile, ARL, eval, page cache) matching\n"
+            "                           PATTERN (names separated by |) for R repetitions each,\n"
+            "                           write the results as JSON to FILE (default stdout)\n"
+            "                           and exit.\n\n"
             "  -W set section option value\n"
             "                           set netdata.conf option from the command line.\n\n"
             "  -W buildinfo             Print the version, the configure options,\n"
@@ -828,6 +879,7 @@ static void security_init(){
 
     tls_version    = config_get(CONFIG_SECTION_WEB, "tls version",  "1.3");
     tls_ciphers    = config_get(CONFIG_SECTION_WEB, "tls ciphers",  "none");
+    netdata_ssl_kernel_offload = config_get_boolean(CONFIG_SECTION_WEB, "tls kernel offload", netdata_ssl_kernel_offload);
 
     netdata_ssl_initialize_openssl();
 }
@@ -841,6 +893,9 @@ static void log_init(void) {
     logs = (unsigned long)config_get_number(CONFIG_SECTION_LOGS, "logs to trigger flood protection", (long long int)logs);
     nd_log_set_flood_protection(logs, period);
 
+    logs = (unsigned long)config_get_number(CONFIG_SECTION_LOGS, "logs per call site to trigger flood protection", ND_LOG_DEFAULT_CALL_SITE_THROTTLE_LOGS);
+    nd_log_set_call_site_flood_protection(logs);
+
     const char *netdata_log_level = getenv("NETDATA_LOG_LEVEL");
     netdata_log_level = netdata_log_level ? nd_log_id2priority(nd_log_priority2id(netdata_log_level)) : NDLP_INFO_STR;
 
@@ -1246,6 +1301,8 @@ static void get_netdata_configured_variables()
     const char *page_type = config_get(CONFIG_SECTION_DB, "dbengine page type", "gorilla");
     if (strcmp(page_type, "gorilla") == 0)
         tier_page_type[0] = RRDENG_PAGE_TYPE_GORILLA_32BIT;
+    else if (strcmp(page_type, "gorilla double") == 0)
+        tier_page_type[0] = RRDENG_PAGE_TYPE_GORILLA_64BIT;
     else if (strcmp(page_type, "raw") == 0)
         tier_page_type[0] = RRDENG_PAGE_TYPE_ARRAY_32BIT;
     else {
@@ -1253,6 +1310,51 @@ static void get_netdata_configured_variables()
         netdata_log_error("Invalid dbengine page type ''%s' given. Defaulting to 'raw'.", page_type);
     }
 
+    const char *contexts = config_get(CONFIG_SECTION_DB, "dbengine double precision contexts", "");
+    if (*contexts && tier_page_type[0] != RRDENG_PAGE_TYPE_GORILLA_64BIT)
+        tier0_double_precision_contexts = simple_pattern_create(contexts, NULL, SIMPLE_PATTERN_EXACT, true);
+
+    page_type = config_get(CONFIG_SECTION_DB, "dbengine higher tiers page type", "raw");
+    uint8_t higher_tiers_page_type = RRDENG_PAGE_TYPE_ARRAY_TIER1;
+    if (strcmp(page_type, "gorilla") == 0)
+        higher_tiers_page_type = RRDENG_PAGE_TYPE_GORILLA_TIER1;
+    else if (strcmp(page_type, "raw") != 0)
+        netdata_log_error("Invalid dbengine higher tiers page type ''%s' given. Defaulting to 'raw'.", page_type);
+
+    for (size_t tier = 1; tier < RRD_STORAGE_TIERS; tier++)
+        tier_page_type[tier] = higher_tiers_page_type;
+
+    dbengine_use_compression_dictionaries = config_get_boolean(CONFIG_SECTION_DB, "dbengine compression dictionaries", dbengine_use_compression_dictionaries);
+
+#ifdef ENABLE_LIBURING
+    dbengine_use_io_uring = config_get_boolean(CONFIG_SECTION_DB, "dbengine use io_uring", dbengine_use_io_uring);
+#endif
+
+    dbengine_use_metric_directory = config_get_boolean(CONFIG_SECTION_DB, "dbengine metric directory", dbengine_use_metric_directory);
+
+    dbengine_use_compaction = config_get_boolean(CONFIG_SECTION_DB, "dbengine compaction", dbengine_use_compaction);
+    dbengine_compaction_compression_level = (int)config_get_number(CONFIG_SECTION_DB, "dbengine compaction compression level", dbengine_compaction_compression_level);
+    if(dbengine_compaction_compression_level < 1)
+        dbengine_compaction_compression_level = 1;
+    else if(dbengine_compaction_compression_level > 22)
+        dbengine_compaction_compression_level = 22;
+
+    long long compaction_io_budget_mb = config_get_number(CONFIG_SECTION_DB, "dbengine compaction io budget MiB per second", (long long)dbengine_compaction_io_budget_mb);
+    dbengine_compaction_io_budget_mb = compaction_io_budget_mb > 0 ? (size_t)compaction_io_budget_mb : 0;
+
+    dbengine_use_crc32c = config_get_boolean(CONFIG_SECTION_DB, "dbengine crc32c checksums", dbengine_use_crc32c);
+
+    dbengine_archive_url = config_get(CONFIG_SECTION_DB, "dbengine archive url", "");
+    dbengine_archive_region = config_get(CONFIG_SECTION_DB, "dbengine archive region", dbengine_archive_region);
+    dbengine_archive_access_key = config_get(CONFIG_SECTION_DB, "dbengine archive access key id", "");
+    dbengine_archive_secret_key = config_get(CONFIG_SECTION_DB, "dbengine archive secret access key", "");
+    dbengine_archive_retention_s = (time_t)config_get_duration_days(CONFIG_SECTION_DB, "dbengine archive retention time", 0) * 86400;
+    dbengine_archive_cache_size = config_get_size_bytes(CONFIG_SECTION_DB, "dbengine archive cache size", dbengine_archive_cache_size);
+
+    query_prefetch_timeout_ms = (time_t)config_get_number(CONFIG_SECTION_DB, "dbengine query prefetch timeout ms", query_prefetch_timeout_ms);
+    if(query_prefetch_timeout_ms < 0)
+        query_prefetch_timeout_ms = 0;
+
     // ------------------------------------------------------------------------
     // get default Database Engine page cache size in MiB
 
@@ -1265,6 +1367,8 @@ static void get_netdata_configured_variables()
         config_set_size_mb(CONFIG_SECTION_DB, "dbengine extent cache size", default_rrdeng_extent_cache_mb);
     }
 
+    rrdeng_extent_read_coalesce_gap_bytes = config_get_size_bytes(CONFIG_SECTION_DB, "dbengine extent read coalescing gap", rrdeng_extent_read_coalesce_gap_bytes);
+
     if(default_rrdeng_page_cache_mb < RRDENG_MIN_PAGE_CACHE_SIZE_MB) {
         netdata_log_error("Invalid page cache size %d given. Defaulting to %d.", default_rrdeng_page_cache_mb, RRDENG_MIN_PAGE_CACHE_SIZE_MB);
         default_rrdeng_page_cache_mb = RRDENG_MIN_PAGE_CACHE_SIZE_MB;
@@ -1454,10 +1558,15 @@ int pgc_unittest(void);
 int mrg_unittest(void);
 int julytest(void);
 int pluginsd_parser_unittest(void);
+int pluginsd_shm_unittest(void);
+int shm_ring_pipe_unittest(void);
+int statsd_unittest(const char *args);
 void replication_initialize(void);
 void bearer_tokens_init(void);
 int unittest_rrdpush_compressions(void);
 int uuid_unittest(void);
+int json_stream_unittest(void);
+int ddsketch_unittest(void);
 int progress_unittest(void);
 int dyncfg_unittest(void);
 bool netdata_random_session_id_generate(void);
@@ -1639,7 +1748,11 @@ int netdata_main(int argc, char **argv) {
                             if (aral_unittest(10000)) return 1;
                             if (rrdlabels_unittest()) return 1;
                             if (ctx_unittest()) return 1;
+                            if (pluginsd_shm_unittest()) return 1;
+                            if (shm_ring_pipe_unittest()) return 1;
                             if (uuid_unittest()) return 1;
+                            if (json_stream_unittest()) return 1;
+                            if (ddsketch_unittest()) return 1;
                             if (dyncfg_unittest()) return 1;
                             sqlite_library_shutdown();
                             fprintf(stderr, "\n\nALL TESTS PASSED\n\n");
@@ -1656,6 +1769,10 @@ int netdata_main(int argc, char **argv) {
                             unittest_running = true;
                             return aral_unittest(10000);
                         }
+                        else if(strcmp(optarg, "executortest") == 0) {
+                            unittest_running = true;
+                            return nd_executor_unittest();
+                        }
                         else if(strcmp(optarg, "stringtest") == 0)  {
                             unittest_running = true;
                             return string_unittest(10000);
@@ -1668,10 +1785,21 @@ int netdata_main(int argc, char **argv) {
                             unittest_running = true;
                             return buffer_unittest();
                         }
+                        else if(strcmp(optarg, "microbenchmarks") == 0 || strncmp(optarg, "microbenchmarks=", 16) == 0) {
+                            return microbenchmarks_run(optarg[15] == '=' ? &optarg[16] : NULL);
+                        }
                         else if(strcmp(optarg, "uuidtest") == 0) {
                             unittest_running = true;
                             return uuid_unittest();
                         }
+                        else if(strcmp(optarg, "jsonstreamtest") == 0) {
+                            unittest_running = true;
+                            return json_stream_unittest();
+                        }
+                        else if(strcmp(optarg, "ddsketchtest") == 0) {
+                            unittest_running = true;
+                            return ddsketch_unittest();
+                        }
 #ifdef OS_WINDOWS
                         else if(strcmp(optarg, "perflibdump") == 0) {
                             return windows_perflib_dump(optind + 1 > argc ? NULL : argv[optind]);
@@ -1690,6 +1818,9 @@ int netdata_main(int argc, char **argv) {
                             unittest_running = true;
                             return metadata_unittest();
                         }
+                        else if(strcmp(optarg, "dbengine-benchmark") == 0 || strncmp(optarg, "dbengine-benchmark=", 19) == 0) {
+                            return dbengine_benchmark(optarg[18] == '=' ? &optarg[19] : NULL);
+                        }
                         else if(strcmp(optarg, "pgctest") == 0) {
                             unittest_running = true;
                             return pgc_unittest();
@@ -1706,6 +1837,20 @@ int netdata_main(int argc, char **argv) {
                             unittest_running = true;
                             return pluginsd_parser_unittest();
                         }
+                        else if(strcmp(optarg, "shmringtest") == 0) {
+                            unittest_running = true;
+                            if(unittest_prepare_rrd(&user))
+                                return 1;
+                            if(pluginsd_shm_unittest())
+                                return 1;
+                            return shm_ring_pipe_unittest();
+                        }
+                        else if(strcmp(optarg, "statsdtest") == 0 || strncmp(optarg, "statsdtest=", 11) == 0) {
+                            unittest_running = true;
+                            if(unittest_prepare_rrd(&user))
+                                return 1;
+                            return statsd_unittest(optarg[10] == '=' ? &optarg[11] : NULL);
+                        }
                         else if(strcmp(optarg, "rrdpush_compressions_test") == 0) {
                             unittest_running = true;
                             return unittest_rrdpush_compressions();
@@ -1998,6 +2143,9 @@ int netdata_main(int argc, char **argv) {
 #endif
 #endif
 
+        // 0 = disabled, otherwise sample on average one allocation every so many bytes
+        malloc_sampling_enable((size_t)config_get_size_bytes(CONFIG_SECTION_GLOBAL, "memory allocations sampling interval", 0));
+
         // set libuv worker threads
         libuv_worker_threads = (int)get_netdata_cpus() * 6;
 
@@ -2218,6 +2366,7 @@ int netdata_main(int argc, char **argv) {
     delta_startup_time("initialize threads after fork");
 
     netdata_threads_init_after_fork((size_t)config_get_size_bytes(CONFIG_SECTION_GLOBAL, "pthread stack size", default_stacksize));
+    heartbeat_align_all(config_get_boolean(CONFIG_SECTION_GLOBAL, "align heartbeats", CONFIG_BOOLEAN_NO));
 
     // initialize internal registry
     delta_startup_time("initialize registry");
@@ -2275,6 +2424,10 @@ int netdata_main(int argc, char **argv) {
 
     nd_log_limits_reset();
 
+    // write the logs from a dedicated thread
+    if(config_get_boolean(CONFIG_SECTION_LOGS, "asynchronous", CONFIG_BOOLEAN_YES))
+        nd_log_async_start();
+
     // Load host labels
     delta_startup_time("collect host labels");
     reload_host_labels();
@@ -0,0 +1,1247 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "common.h"
+#include "registry/registry_internals.h"
+
+// ----------------------------------------------------------------------------
+// micro-benchmarks of the core libnetdata structures
+//
+// Each benchmark prepares its data once, then its run() function does a fixed
+// number of operations. The runner calls run() a few times to warm up the
+// caches and the allocators, then times it for the given repetitions, and
+// reports the nanoseconds per operation (min, average, percentiles, max) and
+// the operations per second of the median repetition, as JSON, so that
+// versions can be compared on the same hardware.
+//
+// netdata -W microbenchmarks[=REPETITIONS,PATTERN,FILE]
+//
+// PATTERN is a simple pattern of benchmark names, separated by '|'.
+
+#define MICROBENCHMARK_WARMUP 2
+#define MICROBENCHMARK_REPETITIONS 10
+
+typedef struct microbenchmark {
+    const char *name;
+    const char *description;
+    size_t operations;                      // the operations of each run()
+    void *(*setup)(size_t operations);
+    void (*run)(void *data, size_t operations);
+    void (*cleanup)(void *data);
+} MICROBENCHMARK;
+
+static inline uint64_t microbenchmark_random(uint64_t *state) {
+    // splitmix64 - deterministic, independent of the libc random()
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// the compiler cannot remove the work of the benchmarks that update it
+static volatile uint64_t microbenchmark_sink = 0;
+
+// ----------------------------------------------------------------------------
+// names, shared by the STRING and DICTIONARY benchmarks
+
+struct microbenchmark_names {
+    char **names;
+    STRING **strings;
+    DICTIONARY *dict;
+};
+
+static void *microbenchmark_names_setup(size_t operations) {
+    struct microbenchmark_names *n = callocz(1, sizeof(*n));
+    n->names = callocz(operations + 1, sizeof(char *));      // NULL terminated, for the cleanup
+    n->strings = callocz(operations, sizeof(STRING *));
+
+    char buf[100];
+    for(size_t i = 0; i < operations ; i++) {
+        snprintfz(buf, sizeof(buf), "microbenchmark.name.%zu", i);
+        n->names[i] = strdupz(buf);
+    }
+
+    return n;
+}
+
+static void *microbenchmark_names_interned_setup(size_t operations) {
+    struct microbenchmark_names *n = microbenchmark_names_setup(operations);
+
+    for(size_t i = 0; i < operations ; i++)
+        n->strings[i] = string_strdupz(n->names[i]);
+
+    return n;
+}
+
+static void *microbenchmark_names_dictionary_setup(size_t operations) {
+    struct microbenchmark_names *n = microbenchmark_names_setup(operations);
+
+    n->dict = dictionary_create(DICT_OPTION_NONE);
+    for(size_t i = 0; i < operations ; i++)
+        dictionary_set(n->dict, n->names[i], &i, sizeof(i));
+
+    return n;
+}
+
+static void microbenchmark_names_cleanup(void *data) {
+    struct microbenchmark_names *n = data;
+
+    dictionary_destroy(n->dict);
+
+    for(size_t i = 0; n->names[i] ; i++) {
+        string_freez(n->strings[i]);
+        freez(n->names[i]);
+    }
+
+    freez(n->strings);
+    freez(n->names);
+    freez(n);
+}
+
+static void microbenchmark_string_unique_run(void *data, size_t operations) {
+    struct microbenchmark_names *n = data;
+
+    for(size_t i = 0; i < operations ; i++)
+        n->strings[i] = string_strdupz(n->names[i]);
+
+    for(size_t i = 0; i < operations ; i++) {
+        string_freez(n->strings[i]);
+        n->strings[i] = NULL;
+    }
+}
+
+static void microbenchmark_string_existing_run(void *data, size_t operations) {
+    struct microbenchmark_names *n = data;
+
+    for(size_t i = 0; i < operations ; i++)
+        string_freez(string_strdupz(n->names[i]));
+}
+
+static void microbenchmark_dictionary_set_run(void *data, size_t operations) {
+    struct microbenchmark_names *n = data;
+
+    DICTIONARY *dict = dictionary_create(DICT_OPTION_NONE);
+    for(size_t i = 0; i < operations ; i++)
+        dictionary_set(dict, n->names[i], &i, sizeof(i));
+
+    dictionary_destroy(dict);
+}
+
+static void microbenchmark_dictionary_get_run(void *data, size_t operations) {
+    struct microbenchmark_names *n = data;
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < operations ; i++) {
+        size_t *v = dictionary_get(n->dict, n->names[i]);
+        sum += v ? *v : 0;
+    }
+    microbenchmark_sink += sum;
+}
+
+// ----------------------------------------------------------------------------
+// ARAL, against mallocz()
+
+struct microbenchmark_allocations {
+    ARAL *ar;
+    void **ptrs;
+};
+
+static void *microbenchmark_allocations_setup(size_t operations) {
+    struct microbenchmark_allocations *a = callocz(1, sizeof(*a));
+    a->ar = aral_create("microbenchmark", 64, 0, 0, NULL, NULL, NULL, false, false);
+    a->ptrs = mallocz(operations * sizeof(void *));
+    return a;
+}
+
+static void microbenchmark_allocations_cleanup(void *data) {
+    struct microbenchmark_allocations *a = data;
+    aral_destroy(a->ar);
+    freez(a->ptrs);
+    freez(a);
+}
+
+static void microbenchmark_aral_run(void *data, size_t operations) {
+    struct microbenchmark_allocations *a = data;
+
+    for(size_t i = 0; i < operations ; i++)
+        a->ptrs[i] = aral_mallocz(a->ar);
+
+    for(size_t i = 0; i < operations ; i++)
+        aral_freez(a->ar, a->ptrs[i]);
+}
+
+static void microbenchmark_mallocz_run(void *data, size_t operations) {
+    struct microbenchmark_allocations *a = data;
+
+    for(size_t i = 0; i < operations ; i++)
+        a->ptrs[i] = mallocz(64);
+
+    for(size_t i = 0; i < operations ; i++)
+        freez(a->ptrs[i]);
+}
+
+// ----------------------------------------------------------------------------
+// storage_number and gorilla, on slowly changing values, like collected metrics
+
+struct microbenchmark_values {
+    NETDATA_DOUBLE *values;
+    storage_number *packed;
+    gorilla_buffer_t *gbuf;
+    uint32_t gorilla_entries;
+};
+
+static void *microbenchmark_values_setup(size_t operations) {
+    struct microbenchmark_values *v = callocz(1, sizeof(*v));
+    v->values = mallocz(operations * sizeof(NETDATA_DOUBLE));
+    v->packed = mallocz(operations * sizeof(storage_number));
+
+    uint64_t seed = 0x6e65746461746121ULL;
+    NETDATA_DOUBLE value = 1000.0;
+    for(size_t i = 0; i < operations ; i++) {
+        if(i % 16 == 0)
+            value += (NETDATA_DOUBLE)(microbenchmark_random(&seed) % 2001) / 100.0 - 10.0;
+
+        v->values[i] = value;
+        v->packed[i] = pack_storage_number(value, SN_DEFAULT_FLAGS);
+    }
+
+    // a full gorilla buffer of the packed values, for the reader
+    v->gbuf = callocz(1, RRDENG_GORILLA_32BIT_BUFFER_SIZE);
+    gorilla_writer_t gw = gorilla_writer_init(v->gbuf, RRDENG_GORILLA_32BIT_BUFFER_SLOTS);
+    for(size_t i = 0; i < operations && gorilla_writer_write(&gw, v->packed[i]) ; i++) ;
+    v->gorilla_entries = gorilla_writer_entries(&gw);
+
+    return v;
+}
+
+static void microbenchmark_values_cleanup(void *data) {
+    struct microbenchmark_values *v = data;
+    freez(v->values);
+    freez(v->packed);
+    freez(v->gbuf);
+    freez(v);
+}
+
+static void microbenchmark_storage_number_pack_run(void *data, size_t operations) {
+    struct microbenchmark_values *v = data;
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < operations ; i++)
+        sum += pack_storage_number(v->values[i], SN_DEFAULT_FLAGS);
+    microbenchmark_sink += sum;
+}
+
+static void microbenchmark_storage_number_unpack_run(void *data, size_t operations) {
+    struct microbenchmark_values *v = data;
+
+    NETDATA_DOUBLE sum = 0.0;
+    for(size_t i = 0; i < operations ; i++)
+        sum += unpack_storage_number(v->packed[i]);
+    microbenchmark_sink += (uint64_t)sum;
+}
+
+static void microbenchmark_gorilla_write_run(void *data, size_t operations) {
+    struct microbenchmark_values *v = data;
+
+    // a new page every time a buffer is full, like dbengine does
+    uint32_t buffer[RRDENG_GORILLA_32BIT_BUFFER_SLOTS] = { 0 };
+    gorilla_writer_t gw = gorilla_writer_init((gorilla_buffer_t *)buffer, RRDENG_GORILLA_32BIT_BUFFER_SLOTS);
+
+    for(size_t i = 0; i < operations ; i++) {
+        if(unlikely(!gorilla_writer_write(&gw, v->packed[i]))) {
+            memset(buffer, 0, sizeof(buffer));
+            gw = gorilla_writer_init((gorilla_buffer_t *)buffer, RRDENG_GORILLA_32BIT_BUFFER_SLOTS);
+            gorilla_writer_write(&gw, v->packed[i]);
+        }
+    }
+
+    microbenchmark_sink += gorilla_writer_entries(&gw);
+}
+
+static void microbenchmark_gorilla_read_run(void *data, size_t operations) {
+    struct microbenchmark_values *v = data;
+
+    uint64_t sum = 0;
+    size_t done = 0;
+    while(done < operations) {
+        gorilla_reader_t gr = gorilla_reader_init(v->gbuf);
+
+        uint32_t n;
+        for(uint32_t i = 0; i < v->gorilla_entries && done < operations && gorilla_reader_read(&gr, &n) ; i++, done++)
+            sum += n;
+    }
+    microbenchmark_sink += sum;
+}
+
+// ----------------------------------------------------------------------------
+// the JSON writer of BUFFER, as used by the APIs
+
+static void *microbenchmark_buffer_json_setup(size_t operations __maybe_unused) {
+    return buffer_create(0, NULL);
+}
+
+static void microbenchmark_buffer_json_cleanup(void *data) {
+    buffer_free(data);
+}
+
+static void microbenchmark_buffer_json_run(void *data, size_t operations) {
+    BUFFER *wb = data;
+
+    // every operation is an object with a string, an integer and a double
+    buffer_flush(wb);
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_MINIFY);
+    buffer_json_member_add_array(wb, "items");
+    for(size_t i = 0; i < operations ; i++) {
+        buffer_json_add_array_item_object(wb);
+        buffer_json_member_add_string(wb, "name", "microbenchmark");
+        buffer_json_member_add_uint64(wb, "id", i);
+        buffer_json_member_add_double(wb, "value", (NETDATA_DOUBLE)i / 3.0);
+        buffer_json_object_close(wb);
+    }
+    buffer_json_array_close(wb);
+    buffer_json_finalize(wb);
+
+    microbenchmark_sink += buffer_strlen(wb);
+}
+
+// ----------------------------------------------------------------------------
+// collecting a /proc/meminfo like file, with procfile and ARL
+
+#define MICROBENCHMARK_MEMINFO_LINES 50
+
+struct microbenchmark_meminfo {
+    char filename[FILENAME_MAX + 1];
+    procfile *ff;
+    ARL_BASE *arl;
+    char keys[MICROBENCHMARK_MEMINFO_LINES][30];
+    char values[MICROBENCHMARK_MEMINFO_LINES][30];
+    unsigned long long collected[MICROBENCHMARK_MEMINFO_LINES];
+};
+
+static void *microbenchmark_meminfo_setup(size_t operations __maybe_unused) {
+    struct microbenchmark_meminfo *m = callocz(1, sizeof(*m));
+
+    uint64_t seed = 0x6e65746461746121ULL;
+    for(size_t i = 0; i < MICROBENCHMARK_MEMINFO_LINES ; i++) {
+        snprintfz(m->keys[i], sizeof(m->keys[i]), "MemoryField%zu", i);
+        snprintfz(m->values[i], sizeof(m->values[i]), "%"PRIu64, microbenchmark_random(&seed) % 100000000);
+    }
+
+    // like most collectors, only some of the keywords are needed
+    m->arl = arl_create("microbenchmark", NULL, 60);
+    for(size_t i = 0; i < MICROBENCHMARK_MEMINFO_LINES ; i += 5)
+        arl_expect(m->arl, m->keys[i], &m->collected[i]);
+
+    const char *tmp = getenv("TMPDIR");
+    snprintfz(m->filename, FILENAME_MAX, "%s/netdata-microbenchmark-XXXXXX", (tmp && *tmp) ? tmp : "/tmp");
+    int fd = mkstemp(m->filename);
+    if(fd != -1) {
+        FILE *fp = fdopen(fd, "w");
+        if(fp) {
+            for(size_t i = 0; i < MICROBENCHMARK_MEMINFO_LINES ; i++)
+                fprintf(fp, "%s:%*s%s kB\n", m->keys[i], 20, "", m->values[i]);
+            fclose(fp);
+            m->ff = procfile_open(m->filename, " \t:", PROCFILE_FLAG_DEFAULT);
+        }
+        else
+            close(fd);
+    }
+
+    if(!m->ff)
+        fprintf(stderr, "MICROBENCHMARKS: cannot create the temporary file '%s'\n", m->filename);
+
+    return m;
+}
+
+static void microbenchmark_meminfo_cleanup(void *data) {
+    struct microbenchmark_meminfo *m = data;
+    procfile_close(m->ff);
+    unlink(m->filename);
+    arl_free(m->arl);
+    freez(m);
+}
+
+static void microbenchmark_procfile_run(void *data, size_t operations) {
+    struct microbenchmark_meminfo *m = data;
+    if(unlikely(!m->ff))
+        return;
+
+    for(size_t i = 0; i < operations ; i++) {
+        m->ff = procfile_readall(m->ff);
+        if(unlikely(!m->ff))
+            return;
+    }
+
+    microbenchmark_sink += procfile_lines(m->ff);
+}
+
+static void microbenchmark_arl_run(void *data, size_t operations) {
+    struct microbenchmark_meminfo *m = data;
+
+    // every operation is a keyword checked
+    for(size_t i = 0; i < operations ; ) {
+        arl_begin(m->arl);
+        for(size_t l = 0; l < MICROBENCHMARK_MEMINFO_LINES && i < operations ; l++) {
+            i++;
+            if(unlikely(arl_check(m->arl, m->keys[l], m->values[l])))
+                break;
+        }
+    }
+
+    microbenchmark_sink += m->collected[0];
+}
+
+// ----------------------------------------------------------------------------
+// real /proc files, with the vectorized procfile parser and with the byte loop
+
+static struct {
+    const char *filename;
+    const char *separators;
+} microbenchmark_proc_files[] = {
+    { "/proc/self/status", " \t:,-()/" },
+    { "/proc/meminfo",     " \t:" },
+    { "/proc/net/dev",     " \t,|" },
+    { "/proc/stat",        " \t" },
+    { "/proc/diskstats",   " \t" },
+};
+
+#define MICROBENCHMARK_PROC_FILES (sizeof(microbenchmark_proc_files) / sizeof(microbenchmark_proc_files[0]))
+
+struct microbenchmark_proc {
+    procfile *ff[MICROBENCHMARK_PROC_FILES];
+};
+
+static struct microbenchmark_proc *microbenchmark_proc_open(void) {
+    struct microbenchmark_proc *p = callocz(1, sizeof(*p));
+
+    // the files that do not exist on this system are skipped
+    for(size_t i = 0; i < MICROBENCHMARK_PROC_FILES ; i++)
+        p->ff[i] = procfile_open(microbenchmark_proc_files[i].filename, microbenchmark_proc_files[i].separators,
+                                 PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
+
+    return p;
+}
+
+static void *microbenchmark_proc_setup(size_t operations __maybe_unused) {
+    return microbenchmark_proc_open();
+}
+
+static void *microbenchmark_proc_bytes_setup(size_t operations __maybe_unused) {
+    struct microbenchmark_proc *p = microbenchmark_proc_open();
+
+    for(size_t i = 0; i < MICROBENCHMARK_PROC_FILES ; i++)
+        if(p->ff[i])
+            p->ff[i]->fast_separators_count = PROCFILE_FAST_PARSER_DISABLED;
+
+    return p;
+}
+
+static void microbenchmark_proc_cleanup(void *data) {
+    struct microbenchmark_proc *p = data;
+
+    for(size_t i = 0; i < MICROBENCHMARK_PROC_FILES ; i++)
+        procfile_close(p->ff[i]);
+
+    freez(p);
+}
+
+static void microbenchmark_proc_run(void *data, size_t operations) {
+    struct microbenchmark_proc *p = data;
+
+    // every operation is a procfile_readall() of all the files
+    size_t words = 0;
+    for(size_t i = 0; i < operations ; i++) {
+        for(size_t f = 0; f < MICROBENCHMARK_PROC_FILES ; f++) {
+            if(unlikely(!p->ff[f]))
+                continue;
+
+            p->ff[f] = procfile_readall(p->ff[f]);
+            if(likely(p->ff[f]))
+                words += p->ff[f]->words->len;
+        }
+    }
+    microbenchmark_sink += words;
+}
+
+// ----------------------------------------------------------------------------
+// SET and SET2 lines of the plugins.d and streaming protocols
+//
+// The lines are split into words and their decimal numbers are parsed 8 bytes
+// at a time (when NETDATA_SWAR_PARSING is defined), like the plugins.d parser
+// does, and one byte at a time, like it did before. Without NETDATA_SWAR_PARSING
+// both are the byte loop.
+
+#define MICROBENCHMARK_LINE_MAX 100
+
+struct microbenchmark_lines {
+    char *lines;
+};
+
+static void *microbenchmark_lines_setup(size_t operations) {
+    struct microbenchmark_lines *l = callocz(1, sizeof(*l));
+    l->lines = callocz(operations, MICROBENCHMARK_LINE_MAX);
+
+    const char *dimensions[] = { "user", "system", "nice", "iowait", "softirq", "received", "sent", "dropped" };
+
+    // random values, so that the lengths of the words vary like they do on a real stream
+    uint64_t seed = 0x6e65746461746121ULL;
+    for(size_t i = 0; i < operations ; i++) {
+        const char *dimension = dimensions[microbenchmark_random(&seed) % 8];
+        uint64_t collected = microbenchmark_random(&seed) >> (microbenchmark_random(&seed) % 64);
+        NETDATA_DOUBLE value = (NETDATA_DOUBLE)collected / 3.0;
+
+        uint64_t value_hex;
+        memcpy(&value_hex, &value, sizeof(value_hex));
+
+        // half of the lines are SET lines of external plugins, the other half SET2 lines of children
+        char *line = &l->lines[i * MICROBENCHMARK_LINE_MAX];
+        if(i % 2)
+            snprintfz(line, MICROBENCHMARK_LINE_MAX - 1, "SET2 '%s' 0x%"PRIX64" %%%"PRIX64" ''",
+                      dimension, collected, value_hex);
+        else
+            snprintfz(line, MICROBENCHMARK_LINE_MAX - 1, "SET '%s' = %"PRIu64, dimension, collected);
+    }
+
+    return l;
+}
+
+static void microbenchmark_lines_cleanup(void *data) {
+    struct microbenchmark_lines *l = data;
+    freez(l->lines);
+    freez(l);
+}
+
+static inline void microbenchmark_pluginsd_lines(struct microbenchmark_lines *l, size_t operations, bool swar) {
+    char line[MICROBENCHMARK_LINE_MAX];
+    char *words[PLUGINSD_MAX_WORDS];
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < operations ; i++) {
+        // the splitter modifies the line
+        memcpy(line, &l->lines[i * MICROBENCHMARK_LINE_MAX], MICROBENCHMARK_LINE_MAX);
+
+        size_t num_words = swar ? quoted_strings_splitter_pluginsd(line, words, PLUGINSD_MAX_WORDS)
+                                : quoted_strings_splitter(line, words, PLUGINSD_MAX_WORDS, isspace_map_pluginsd);
+        if(unlikely(num_words < 3))
+            continue;
+
+        if(words[0][3] == '2') {
+            // SET2 'dimension' COLLECTED VALUE FLAGS - hex numbers, parsed the same way by both
+            sum += (uint64_t)str2ll_encoded(words[2]);
+            if(num_words > 3)
+                sum += (uint64_t)str2ndd_encoded(words[3], NULL);
+        }
+        else
+            // SET 'dimension' = COLLECTED
+            sum += swar ? (uint64_t)str2ll_encoded(words[2]) : str2uint64_t_bytes(words[2], NULL);
+    }
+    microbenchmark_sink += sum;
+}
+
+static void microbenchmark_pluginsd_lines_run(void *data, size_t operations) {
+    microbenchmark_pluginsd_lines(data, operations, true);
+}
+
+static void microbenchmark_pluginsd_lines_bytes_run(void *data, size_t operations) {
+    microbenchmark_pluginsd_lines(data, operations, false);
+}
+
+// ----------------------------------------------------------------------------
+// decimal numbers of all lengths
+
+struct microbenchmark_numbers {
+    char (*numbers)[UINT64_MAX_LENGTH];
+};
+
+static void *microbenchmark_numbers_setup(size_t operations) {
+    struct microbenchmark_numbers *n = callocz(1, sizeof(*n));
+    n->numbers = callocz(operations, UINT64_MAX_LENGTH);
+
+    uint64_t seed = 0x6e65746461746121ULL;
+    for(size_t i = 0; i < operations ; i++) {
+        uint64_t v = microbenchmark_random(&seed) >> (microbenchmark_random(&seed) % 64);
+        snprintfz(n->numbers[i], UINT64_MAX_LENGTH - 1, "%"PRIu64, v);
+
+        if(str2uint64_t(n->numbers[i], NULL) != v || str2uint64_t_bytes(n->numbers[i], NULL) != v)
+            fprintf(stderr, "MICROBENCHMARKS: number '%s' is not parsed as %"PRIu64"\n", n->numbers[i], v);
+    }
+
+    return n;
+}
+
+static void microbenchmark_numbers_cleanup(void *data) {
+    struct microbenchmark_numbers *n = data;
+    freez(n->numbers);
+    freez(n);
+}
+
+static void microbenchmark_str2uint64_run(void *data, size_t operations) {
+    struct microbenchmark_numbers *n = data;
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < operations ; i++)
+        sum += str2uint64_t(n->numbers[i], NULL);
+    microbenchmark_sink += sum;
+}
+
+static void microbenchmark_str2uint64_bytes_run(void *data, size_t operations) {
+    struct microbenchmark_numbers *n = data;
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < operations ; i++)
+        sum += str2uint64_t_bytes(n->numbers[i], NULL);
+    microbenchmark_sink += sum;
+}
+
+// ----------------------------------------------------------------------------
+// the registry, in a temporary directory
+//
+// Every operation is a person: the setup creates as many persons as the
+// operations, accessing 1 in 5 of them machines, and saves the db.
+
+struct microbenchmark_registry {
+    char pathname[FILENAME_MAX + 1];
+    size_t persons, machines;
+    char (*person_guids)[UUID_STR_LEN];
+    char (*machine_guids)[UUID_STR_LEN];
+    char (*urls)[50];
+    uint64_t seed;
+};
+
+static struct microbenchmark_registry *microbenchmark_registry_create(size_t operations, bool binary) {
+    struct microbenchmark_registry *r = callocz(1, sizeof(*r));
+    r->persons = operations;
+    r->machines = operations / 5 + 1;
+    r->seed = 0x6e65746461746121ULL;
+
+    const char *tmp = getenv("TMPDIR");
+    snprintfz(r->pathname, FILENAME_MAX, "%s/netdata-microbenchmark-XXXXXX", (tmp && *tmp) ? tmp : "/tmp");
+    if(!mkdtemp(r->pathname)) {
+        fprintf(stderr, "MICROBENCHMARKS: cannot create the temporary directory '%s'\n", r->pathname);
+        freez(r);
+        return NULL;
+    }
+
+    // all the filenames, since registry_init() keeps the ones of the first setup otherwise
+    char filename[FILENAME_MAX + 1];
+    config_set(CONFIG_SECTION_DIRECTORIES, "registry", r->pathname);
+    snprintfz(filename, FILENAME_MAX, "%s/netdata.public.unique.id", r->pathname);
+    config_set(CONFIG_SECTION_REGISTRY, "netdata unique id file", filename);
+    snprintfz(filename, FILENAME_MAX, "%s/registry.db", r->pathname);
+    config_set(CONFIG_SECTION_REGISTRY, "registry db file", filename);
+    snprintfz(filename, FILENAME_MAX, "%s/registry-log.db", r->pathname);
+    config_set(CONFIG_SECTION_REGISTRY, "registry log file", filename);
+
+    config_set_boolean(CONFIG_SECTION_REGISTRY, "enabled", 1);
+    config_set_boolean(CONFIG_SECTION_REGISTRY, "registry db binary format", binary ? 1 : 0);
+    config_set(CONFIG_SECTION_REGISTRY, "registry hostname", "microbenchmark");
+
+    // the db is saved by the benchmarks, not while it is populated
+    config_set_number(CONFIG_SECTION_REGISTRY, "registry save db every new entries", LLONG_MAX);
+
+    registry_init();
+    if(!registry.enabled) {
+        fprintf(stderr, "MICROBENCHMARKS: the registry cannot be enabled\n");
+        rmdir(r->pathname);
+        freez(r);
+        return NULL;
+    }
+
+    r->person_guids = callocz(r->persons, UUID_STR_LEN);
+    r->machine_guids = callocz(r->machines, UUID_STR_LEN);
+    r->urls = callocz(r->machines, sizeof(*r->urls));
+
+    for(size_t m = 0; m < r->machines ; m++) {
+        nd_uuid_t uuid;
+        uint64_t random[2] = { microbenchmark_random(&r->seed), microbenchmark_random(&r->seed) };
+        memcpy(uuid, random, sizeof(nd_uuid_t));
+        uuid_unparse_lower(uuid, r->machine_guids[m]);
+        snprintfz(r->urls[m], sizeof(r->urls[m]) - 1, "http://%zu.netdata.rocks:19999/", m + 1);
+    }
+
+    char name[] = "microbenchmark";
+    time_t now = now_realtime_sec();
+    for(size_t p = 0; p < r->persons ; p++) {
+        size_t m = p % r->machines;
+        REGISTRY_PERSON *person = registry_request_access(NULL, r->machine_guids[m], r->urls[m], name, now);
+        if(person)
+            strncpyz(r->person_guids[p], person->guid, UUID_STR_LEN - 1);
+    }
+
+    registry.log_count = registry.save_registry_every_entries + 1;
+    registry_db_save();
+
+    return r;
+}
+
+static void *microbenchmark_registry_setup(size_t operations) {
+    return microbenchmark_registry_create(operations, true);
+}
+
+static void *microbenchmark_registry_text_setup(size_t operations) {
+    return microbenchmark_registry_create(operations, false);
+}
+
+static void microbenchmark_registry_cleanup(void *data) {
+    struct microbenchmark_registry *r = data;
+    if(!r)
+        return;
+
+    registry_log_close();
+    registry_free();
+
+    const char *files[] = { "registry.db", "registry.db.old", "registry.db.tmp", "registry-log.db", "netdata.public.unique.id" };
+    char filename[FILENAME_MAX + 1];
+    for(size_t i = 0; i < sizeof(files) / sizeof(files[0]) ; i++) {
+        snprintfz(filename, FILENAME_MAX, "%s/%s", r->pathname, files[i]);
+        unlink(filename);
+    }
+    rmdir(r->pathname);
+
+    freez(r->person_guids);
+    freez(r->machine_guids);
+    freez(r->urls);
+    freez(r);
+}
+
+static void microbenchmark_registry_access_run(void *data, size_t operations) {
+    struct microbenchmark_registry *r = data;
+    if(unlikely(!r))
+        return;
+
+    // existing persons accessing random machines
+    char name[] = "microbenchmark";
+    time_t now = now_realtime_sec();
+    size_t found = 0;
+    for(size_t i = 0; i < operations ; i++) {
+        size_t p = microbenchmark_random(&r->seed) % r->persons;
+        size_t m = microbenchmark_random(&r->seed) % r->machines;
+
+        REGISTRY_PERSON *person = registry_request_access(r->person_guids[p], r->machine_guids[m], r->urls[m], name, now);
+        if(likely(person))
+            found++;
+    }
+    microbenchmark_sink += found;
+}
+
+static void microbenchmark_registry_save_run(void *data, size_t operations __maybe_unused) {
+    struct microbenchmark_registry *r = data;
+    if(unlikely(!r))
+        return;
+
+    registry.log_count = registry.save_registry_every_entries + 1;
+    registry_db_save();
+}
+
+static void microbenchmark_registry_load_run(void *data, size_t operations __maybe_unused) {
+    struct microbenchmark_registry *r = data;
+    if(unlikely(!r))
+        return;
+
+    registry_log_close();
+    registry_free();
+    registry_init();
+
+    microbenchmark_sink += registry.persons_count;
+}
+
+// ----------------------------------------------------------------------------
+// health expressions
+
+static bool microbenchmark_eval_variable_lookup(STRING *variable __maybe_unused, void *data __maybe_unused, NETDATA_DOUBLE *result) {
+    *result = 42.0;
+    return true;
+}
+
+static void *microbenchmark_eval_setup(size_t operations __maybe_unused) {
+    const char *failed_at = NULL;
+    int error = 0;
+
+    EVAL_EXPRESSION *exp = expression_parse("($this > (($status >= $WARNING) ? ($warn_limit - 5) : $warn_limit)) ? 1 : 0", &failed_at, &error);
+    if(!exp) {
+        fprintf(stderr, "MICROBENCHMARKS: cannot parse the expression: %s\n", expression_strerror(error));
+        return NULL;
+    }
+
+    expression_set_variable_lookup_callback(exp, microbenchmark_eval_variable_lookup, NULL);
+    return exp;
+}
+
+static void microbenchmark_eval_cleanup(void *data) {
+    expression_free(data);
+}
+
+static void microbenchmark_eval_run(void *data, size_t operations) {
+    EVAL_EXPRESSION *exp = data;
+    if(unlikely(!exp))
+        return;
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < operations ; i++)
+        sum += expression_evaluate(exp);
+    microbenchmark_sink += sum;
+}
+
+// ----------------------------------------------------------------------------
+// the dbengine page cache
+
+#ifdef ENABLE_DBENGINE
+#define MICROBENCHMARK_PGC_PAGE_SIZE 4096
+
+static void microbenchmark_pgc_free_clean_page(PGC *cache __maybe_unused, PGC_ENTRY entry __maybe_unused) {
+    ;
+}
+
+static void microbenchmark_pgc_save_dirty_page(PGC *cache __maybe_unused, PGC_ENTRY *entries_array __maybe_unused, PGC_PAGE **pages_array __maybe_unused, size_t entries __maybe_unused) {
+    ;
+}
+
+static void *microbenchmark_pgc_setup(size_t operations) {
+    // large enough for all the pages, so that nothing is evicted
+    PGC *cache = pgc_create("microbenchmark",
+                            operations * MICROBENCHMARK_PGC_PAGE_SIZE * 2, microbenchmark_pgc_free_clean_page,
+                            64, NULL, microbenchmark_pgc_save_dirty_page,
+                            10, 10, 1000, 10,
+                            PGC_OPTIONS_DEFAULT, 1, 0);
+
+    // 100 metrics, with consecutive pages each
+    for(size_t i = 0; i < operations ; i++) {
+        PGC_PAGE *page = pgc_page_add_and_acquire(cache, (PGC_ENTRY){
+                .section = 1,
+                .metric_id = i % 100,
+                .start_time_s = (time_t)(i / 100) * 1000 + 1,
+                .end_time_s = (time_t)(i / 100) * 1000 + 1000,
+                .update_every_s = 1,
+                .size = MICROBENCHMARK_PGC_PAGE_SIZE,
+                .data = NULL,
+                .hot = false,
+        }, NULL);
+        pgc_page_release(cache, page);
+    }
+
+    return cache;
+}
+
+static void microbenchmark_pgc_cleanup(void *data) {
+    pgc_destroy(data);
+}
+
+static void microbenchmark_pgc_get_run(void *data, size_t operations) {
+    PGC *cache = data;
+
+    // lookups in the middle of the pages, like queries do
+    size_t found = 0;
+    for(size_t i = 0; i < operations ; i++) {
+        PGC_PAGE *page = pgc_page_get_and_acquire(cache, 1, i % 100, (time_t)(i / 100) * 1000 + 500, PGC_SEARCH_CLOSEST);
+        if(likely(page)) {
+            found++;
+            pgc_page_release(cache, page);
+        }
+    }
+    microbenchmark_sink += found;
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// UUIDs
+
+struct microbenchmark_uuids {
+    nd_uuid_t *uuids;
+    char (*strings)[UUID_STR_LEN];
+};
+
+static void *microbenchmark_uuids_setup(size_t operations) {
+    struct microbenchmark_uuids *u = callocz(1, sizeof(*u));
+    u->uuids = mallocz(operations * sizeof(nd_uuid_t));
+    u->strings = mallocz(operations * UUID_STR_LEN);
+
+    uint64_t state = 1;
+    for(size_t i = 0; i < operations ; i++) {
+        uint64_t r[2] = { microbenchmark_random(&state), microbenchmark_random(&state) };
+        memcpy(u->uuids[i], r, sizeof(nd_uuid_t));
+        uuid_unparse_lower(u->uuids[i], u->strings[i]);
+    }
+
+    return u;
+}
+
+static void microbenchmark_uuids_cleanup(void *data) {
+    struct microbenchmark_uuids *u = data;
+    freez(u->uuids);
+    freez(u->strings);
+    freez(u);
+}
+
+static void microbenchmark_uuid_unparse_run(void *data, size_t operations) {
+    struct microbenchmark_uuids *u = data;
+    char buf[UUID_STR_LEN];
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < operations ; i++) {
+        uuid_unparse_lower(u->uuids[i], buf);
+        sum += (uint8_t)buf[i % 36];
+    }
+    microbenchmark_sink += sum;
+}
+
+static void microbenchmark_uuid_parse_run(void *data, size_t operations) {
+    struct microbenchmark_uuids *u = data;
+    nd_uuid_t uuid;
+
+    uint64_t sum = 0;
+    for(size_t i = 0; i < operations ; i++) {
+        if(likely(uuid_parse(u->strings[i], uuid) == 0))
+            sum += uuid[i % 16];
+    }
+    microbenchmark_sink += sum;
+}
+
+// ----------------------------------------------------------------------------
+
+static MICROBENCHMARK microbenchmarks[] = {
+    {
+        .name = "string_unique",
+        .description = "string_strdupz() and string_freez() of unique strings",
+        .operations = 100000,
+        .setup = microbenchmark_names_setup,
+        .run = microbenchmark_string_unique_run,
+        .cleanup = microbenchmark_names_cleanup,
+    },
+    {
+        .name = "string_existing",
+        .description = "string_strdupz() and string_freez() of strings already interned",
+        .operations = 100000,
+        .setup = microbenchmark_names_interned_setup,
+        .run = microbenchmark_string_existing_run,
+        .cleanup = microbenchmark_names_cleanup,
+    },
+    {
+        .name = "dictionary_set",
+        .description = "dictionary_set() of new items, in a new dictionary destroyed at the end",
+        .operations = 100000,
+        .setup = microbenchmark_names_setup,
+        .run = microbenchmark_dictionary_set_run,
+        .cleanup = microbenchmark_names_cleanup,
+    },
+    {
+        .name = "dictionary_get",
+        .description = "dictionary_get() of existing items",
+        .operations = 100000,
+        .setup = microbenchmark_names_dictionary_setup,
+        .run = microbenchmark_dictionary_get_run,
+        .cleanup = microbenchmark_names_cleanup,
+    },
+    {
+        .name = "aral",
+        .description = "aral_mallocz() and aral_freez() of 64 byte elements",
+        .operations = 100000,
+        .setup = microbenchmark_allocations_setup,
+        .run = microbenchmark_aral_run,
+        .cleanup = microbenchmark_allocations_cleanup,
+    },
+    {
+        .name = "mallocz",
+        .description = "mallocz() and freez() of 64 bytes, to compare with aral",
+        .operations = 100000,
+        .setup = microbenchmark_allocations_setup,
+        .run = microbenchmark_mallocz_run,
+        .cleanup = microbenchmark_allocations_cleanup,
+    },
+    {
+        .name = "storage_number_pack",
+        .description = "pack_storage_number() of collected values",
+        .operations = 1000000,
+        .setup = microbenchmark_values_setup,
+        .run = microbenchmark_storage_number_pack_run,
+        .cleanup = microbenchmark_values_cleanup,
+    },
+    {
+        .name = "storage_number_unpack",
+        .description = "unpack_storage_number() of stored values",
+        .operations = 1000000,
+        .setup = microbenchmark_values_setup,
+        .run = microbenchmark_storage_number_unpack_run,
+        .cleanup = microbenchmark_values_cleanup,
+    },
+    {
+        .name = "gorilla_write",
+        .description = "gorilla_writer_write() of stored values, in pages of 128 slots",
+        .operations = 1000000,
+        .setup = microbenchmark_values_setup,
+        .run = microbenchmark_gorilla_write_run,
+        .cleanup = microbenchmark_values_cleanup,
+    },
+    {
+        .name = "gorilla_read",
+        .description = "gorilla_reader_read() of stored values, in pages of 128 slots",
+        .operations = 1000000,
+        .setup = microbenchmark_values_setup,
+        .run = microbenchmark_gorilla_read_run,
+        .cleanup = microbenchmark_values_cleanup,
+    },
+    {
+        .name = "buffer_json",
+        .description = "JSON objects with a string, an integer and a double, written to a BUFFER",
+        .operations = 100000,
+        .setup = microbenchmark_buffer_json_setup,
+        .run = microbenchmark_buffer_json_run,
+        .cleanup = microbenchmark_buffer_json_cleanup,
+    },
+    {
+        .name = "procfile",
+        .description = "procfile_readall() of a 50 lines /proc/meminfo like file",
+        .operations = 10000,
+        .setup = microbenchmark_meminfo_setup,
+        .run = microbenchmark_procfile_run,
+        .cleanup = microbenchmark_meminfo_cleanup,
+    },
+    {
+        .name = "arl",
+        .description = "arl_check() of /proc/meminfo like keywords, 1 in 5 of them collected",
+        .operations = 1000000,
+        .setup = microbenchmark_meminfo_setup,
+        .run = microbenchmark_arl_run,
+        .cleanup = microbenchmark_meminfo_cleanup,
+    },
+    {
+        .name = "procfile_proc",
+        .description = "procfile_readall() of /proc/self/status, meminfo, net/dev, stat and diskstats",
+        .operations = 1000,
+        .setup = microbenchmark_proc_setup,
+        .run = microbenchmark_proc_run,
+        .cleanup = microbenchmark_proc_cleanup,
+    },
+    {
+        .name = "procfile_proc_bytes",
+        .description = "procfile_readall() of the same /proc files, with the byte loop parser",
+        .operations = 1000,
+        .setup = microbenchmark_proc_bytes_setup,
+        .run = microbenchmark_proc_run,
+        .cleanup = microbenchmark_proc_cleanup,
+    },
+    {
+        .name = "pluginsd_lines",
+        .description = "SET and SET2 lines split into words and their numbers parsed, like plugins.d does",
+        .operations = 100000,
+        .setup = microbenchmark_lines_setup,
+        .run = microbenchmark_pluginsd_lines_run,
+        .cleanup = microbenchmark_lines_cleanup,
+    },
+    {
+        .name = "pluginsd_lines_bytes",
+        .description = "the same SET and SET2 lines, split and parsed one byte at a time",
+        .operations = 100000,
+        .setup = microbenchmark_lines_setup,
+        .run = microbenchmark_pluginsd_lines_bytes_run,
+        .cleanup = microbenchmark_lines_cleanup,
+    },
+    {
+        .name = "str2uint64",
+        .description = "str2uint64_t() of decimal numbers of all lengths",
+        .operations = 1000000,
+        .setup = microbenchmark_numbers_setup,
+        .run = microbenchmark_str2uint64_run,
+        .cleanup = microbenchmark_numbers_cleanup,
+    },
+    {
+        .name = "str2uint64_bytes",
+        .description = "str2uint64_t_bytes() of the same decimal numbers",
+        .operations = 1000000,
+        .setup = microbenchmark_numbers_setup,
+        .run = microbenchmark_str2uint64_bytes_run,
+        .cleanup = microbenchmark_numbers_cleanup,
+    },
+    {
+        .name = "registry_access",
+        .description = "registry_request_access() of existing persons to random machines",
+        .operations = 100000,
+        .setup = microbenchmark_registry_setup,
+        .run = microbenchmark_registry_access_run,
+        .cleanup = microbenchmark_registry_cleanup,
+    },
+    {
+        .name = "registry_save",
+        .description = "registry_db_save() of the binary db, per person",
+        .operations = 100000,
+        .setup = microbenchmark_registry_setup,
+        .run = microbenchmark_registry_save_run,
+        .cleanup = microbenchmark_registry_cleanup,
+    },
+    {
+        .name = "registry_save_text",
+        .description = "registry_db_save() of the text db, per person",
+        .operations = 100000,
+        .setup = microbenchmark_registry_text_setup,
+        .run = microbenchmark_registry_save_run,
+        .cleanup = microbenchmark_registry_cleanup,
+    },
+    {
+        .name = "registry_load",
+        .description = "registry_init() loading the binary db with mmap(), per person",
+        .operations = 100000,
+        .setup = microbenchmark_registry_setup,
+        .run = microbenchmark_registry_load_run,
+        .cleanup = microbenchmark_registry_cleanup,
+    },
+    {
+        .name = "registry_load_text",
+        .description = "registry_init() loading the text db, per person",
+        .operations = 100000,
+        .setup = microbenchmark_registry_text_setup,
+        .run = microbenchmark_registry_load_run,
+        .cleanup = microbenchmark_registry_cleanup,
+    },
+    {
+        .name = "uuid_unparse",
+        .description = "uuid_unparse_lower() of random UUIDs",
+        .operations = 1000000,
+        .setup = microbenchmark_uuids_setup,
+        .run = microbenchmark_uuid_unparse_run,
+        .cleanup = microbenchmark_uuids_cleanup,
+    },
+    {
+        .name = "uuid_parse",
+        .description = "uuid_parse() of random UUIDs, with hyphens",
+        .operations = 1000000,
+        .setup = microbenchmark_uuids_setup,
+        .run = microbenchmark_uuid_parse_run,
+        .cleanup = microbenchmark_uuids_cleanup,
+    },
+    {
+        .name = "eval",
+        .description = "expression_evaluate() of a health alert expression with variables",
+        .operations = 100000,
+        .setup = microbenchmark_eval_setup,
+        .run = microbenchmark_eval_run,
+        .cleanup = microbenchmark_eval_cleanup,
+    },
+#ifdef ENABLE_DBENGINE
+    {
+        .name = "pgc_get",
+        .description = "pgc_page_get_and_acquire() and pgc_page_release() of cached pages",
+        .operations = 100000,
+        .setup = microbenchmark_pgc_setup,
+        .run = microbenchmark_pgc_get_run,
+        .cleanup = microbenchmark_pgc_cleanup,
+    },
+#endif
+
+    // terminator
+    {
+        .name = NULL,
+    },
+};
+
+static int microbenchmark_compar(const void *a, const void *b) {
+    NETDATA_DOUBLE x = *(const NETDATA_DOUBLE *)a, y = *(const NETDATA_DOUBLE *)b;
+    return (x > y) - (x < y);
+}
+
+static NETDATA_DOUBLE microbenchmark_percentile(NETDATA_DOUBLE *sorted, size_t entries, NETDATA_DOUBLE percentile) {
+    size_t slot = (size_t)(percentile * (NETDATA_DOUBLE)entries / 100.0);
+    if(slot >= entries) slot = entries - 1;
+    return sorted[slot];
+}
+
+static void microbenchmark_run(BUFFER *wb, MICROBENCHMARK *mb, size_t repetitions) {
+    size_t operations = mb->operations;
+    void *data = mb->setup ? mb->setup(operations) : NULL;
+
+    for(size_t i = 0; i < MICROBENCHMARK_WARMUP ; i++)
+        mb->run(data, operations);
+
+    NETDATA_DOUBLE ns_per_op[repetitions];
+    NETDATA_DOUBLE total = 0.0;
+    for(size_t r = 0; r < repetitions ; r++) {
+        usec_t started_ut = now_monotonic_high_precision_usec();
+        mb->run(data, operations);
+        usec_t ut = now_monotonic_high_precision_usec() - started_ut;
+
+        ns_per_op[r] = (NETDATA_DOUBLE)ut * 1000.0 / (NETDATA_DOUBLE)operations;
+        total += ns_per_op[r];
+    }
+
+    if(mb->cleanup)
+        mb->cleanup(data);
+
+    qsort(ns_per_op, repetitions, sizeof(NETDATA_DOUBLE), microbenchmark_compar);
+
+    NETDATA_DOUBLE p50 = microbenchmark_percentile(ns_per_op, repetitions, 50.0);
+
+    buffer_json_add_array_item_object(wb);
+    {
+        buffer_json_member_add_string(wb, "name", mb->name);
+        buffer_json_member_add_string(wb, "description", mb->description);
+        buffer_json_member_add_uint64(wb, "operations", operations);
+        buffer_json_member_add_double(wb, "ns_per_op_min", ns_per_op[0]);
+        buffer_json_member_add_double(wb, "ns_per_op_avg", total / (NETDATA_DOUBLE)repetitions);
+        buffer_json_member_add_double(wb, "ns_per_op_p50", p50);
+        buffer_json_member_add_double(wb, "ns_per_op_p90", microbenchmark_percentile(ns_per_op, repetitions, 90.0));
+        buffer_json_member_add_double(wb, "ns_per_op_p99", microbenchmark_percentile(ns_per_op, repetitions, 99.0));
+        buffer_json_member_add_double(wb, "ns_per_op_max", ns_per_op[repetitions - 1]);
+        buffer_json_member_add_uint64(wb, "ops_per_sec", p50 > 0.0 ? (uint64_t)(1000000000.0 / p50) : 0);
+    }
+    buffer_json_object_close(wb);
+
+    fprintf(stderr, "MICROBENCHMARKS: %-25s %12.2f ns/op (p50), %12.2f ns/op (min)\n", mb->name, p50, ns_per_op[0]);
+}
+
+int microbenchmarks_run(const char *args) {
+    size_t repetitions = MICROBENCHMARK_REPETITIONS;
+    const char *pattern = NULL;
+    const char *filename = NULL;
+
+    char *s = strdupz(args ? args : ""), *words = s, *word;
+    if((word = strsep(&words, ",")) && *word) repetitions = str2u(word);
+    if((word = strsep(&words, ",")) && *word) pattern = word;
+    if((word = strsep(&words, ",")) && *word) filename = word;
+
+    if(!repetitions) repetitions = 1;
+
+    SIMPLE_PATTERN *sp = pattern ? simple_pattern_create(pattern, "|", SIMPLE_PATTERN_EXACT, true) : NULL;
+
+    nd_log_limits_unlimited();
+
+    CLEAN_BUFFER *wb = buffer_create(0, NULL);
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_DEFAULT);
+    buffer_json_member_add_string(wb, "benchmark", "microbenchmarks");
+    buffer_json_member_add_string(wb, "version", NETDATA_VERSION);
+    buffer_json_member_add_uint64(wb, "cpus", (uint64_t)os_get_system_cpus());
+    buffer_json_member_add_uint64(wb, "warmup", MICROBENCHMARK_WARMUP);
+    buffer_json_member_add_uint64(wb, "repetitions", repetitions);
+
+    size_t executed = 0;
+    buffer_json_member_add_array(wb, "results");
+    for(size_t i = 0; microbenchmarks[i].name ; i++) {
+        if(sp && !simple_pattern_matches(sp, microbenchmarks[i].name))
+            continue;
+
+        microbenchmark_run(wb, &microbenchmarks[i], repetitions);
+        executed++;
+    }
+    buffer_json_array_close(wb);
+    buffer_json_finalize(wb);
+
+    simple_pattern_free(sp);
+
+    int ret = 0;
+    if(!executed) {
+        fprintf(stderr, "MICROBENCHMARKS: no benchmark matches '%s'\n", pattern);
+        ret = 1;
+    }
+    else if(filename) {
+        FILE *fp = fopen(filename, "w");
+        if(fp) {
+            fprintf(fp, "%s\n", buffer_tostring(wb));
+            fclose(fp);
+        }
+        else {
+            fprintf(stderr, "MICROBENCHMARKS: cannot write the results to '%s'\n", filename);
+            ret = 1;
+        }
+    }
+    else
+        fprintf(stdout, "%s\n", buffer_tostring(wb));
+
+    freez(s);
+    return ret;
+}
@@ -13,6 +13,7 @@ void *service_main(void *ptr);
 void *statsd_main(void *ptr);
 void *profile_main(void *ptr);
 void *replication_thread_main(void *ptr);
+void *rrdviews_main(void *ptr);
 
 extern bool global_statistics_enabled;
 
@@ -162,6 +163,15 @@ const struct netdata_static_thread static_threads_common[] = {
         .init_routine = NULL,
         .start_routine = replication_thread_main
     },
+    {
+        .name = "VIEWS",
+        .config_section = NULL,
+        .config_name = NULL,
+        .enabled = 1,
+        .thread = NULL,
+        .init_routine = NULL,
+        .start_routine = rrdviews_main
+    },
     {
         .name = "P[PROFILE]",
         .config_section = CONFIG_SECTION_PLUGINS,
@@ -13,11 +13,13 @@ int unit_test_buffer(void);
 int unit_test_static_threads(void);
 int test_sqlite(void);
 int unit_test_bitmaps(void);
+int microbenchmarks_run(const char *args);
 #ifdef ENABLE_DBENGINE
 int test_dbengine(void);
 void generate_dbengine_dataset(unsigned history_seconds);
 void dbengine_stress_test(unsigned TEST_DURATION_SEC, unsigned DSET_CHARTS, unsigned QUERY_THREADS,
                                  unsigned RAMP_UP_SECONDS, unsigned PAGE_CACHE_MB, unsigned DISK_SPACE_MB);
+int dbengine_benchmark(const char *args);
 
 #endif
 
@@ -63,12 +63,43 @@ struct context_v2_entry {
     time_t last_time_s;
     RRD_FLAGS flags;
     FTS_MATCH match;
+    uint64_t version;
 };
 
+#define FTS_STRING_MATCHED     1
+#define FTS_STRING_NOT_MATCHED 2
+
 static inline bool full_text_search_string(FTS_INDEX *fts, SIMPLE_PATTERN *q, STRING *ptr) {
     fts->searches++;
+
+    if(unlikely(!ptr))
+        return false;
+
+    Pvoid_t *PValue = JudyLIns(&fts->JudyL, (Word_t)ptr, PJE0);
+    if(unlikely(!PValue || PValue == PJERR))
+        fatal("FTS: corrupted JudyL array");
+
+    if(likely(*PValue)) {
+        fts->cached_searches++;
+        return (Word_t)*PValue == FTS_STRING_MATCHED;
+    }
+
     fts->string_searches++;
-    return simple_pattern_matches_string(q, ptr);
+    bool matched = simple_pattern_matches_string(q, ptr);
+
+    // keep the string, so that its pointer cannot be reused until we are done
+    string_dup(ptr);
+    *PValue = (void *)(Word_t)(matched ? FTS_STRING_MATCHED : FTS_STRING_NOT_MATCHED);
+
+    return matched;
+}
+
+static void full_text_search_cleanup(FTS_INDEX *fts) {
+    Word_t idx = 0;
+    for(Pvoid_t *PValue = JudyLFirst(fts->JudyL, &idx, PJE0); PValue; PValue = JudyLNext(fts->JudyL, &idx, PJE0))
+        string_freez((STRING *)idx);
+
+    JudyLFreeArray(&fts->JudyL, PJE0);
 }
 
 static inline bool full_text_search_char(FTS_INDEX *fts, SIMPLE_PATTERN *q, char *ptr) {
@@ -168,6 +199,10 @@ static ssize_t rrdcontext_to_json_v2_add_context(void *data, RRDCONTEXT_ACQUIRED
             return 0; // continue to next context
     }
 
+    if(ctl->delta.enabled && rrd_flag_is_deleted(rc))
+        // the clients of deltas get it in the removed contexts
+        return 0; // continue to next context
+
     if(ctl->contexts.dict) {
         struct context_v2_entry t = {
                 .count = 1,
@@ -178,6 +213,7 @@ static ssize_t rrdcontext_to_json_v2_add_context(void *data, RRDCONTEXT_ACQUIRED
                 .last_time_s = rc->last_time_s,
                 .flags = rc->flags,
                 .match = match,
+                .version = rc->api.version,
         };
 
         dictionary_set(ctl->contexts.dict, string2str(rc->id), &t, sizeof(struct context_v2_entry));
@@ -426,6 +462,7 @@ static void rrdcontext_to_json_v2_rrdhost(BUFFER *wb, RRDHOST *host, struct rrdc
             rrdhost_health_to_json_v2(wb, "health", &s);
             agent_capabilities_to_json(wb, host, "capabilities");
             rrdhost_stream_path_to_json(wb, host, STREAM_PATH_JSON_MEMBER, false);
+            rrdhost_stream_path_owner_to_json(wb, host, "owner");
         }
 
         if (ctl->mode & (CONTEXTS_V2_NODE_INSTANCES)) {
@@ -496,6 +533,10 @@ static ssize_t rrdcontext_to_json_v2_add_host(void *data, RRDHOST *host, bool qu
         // timed out
         return -2; // stop the query
 
+    uint64_t host_version = __atomic_load_n(&host->rrdctx.api_version, __ATOMIC_RELAXED);
+    if(host_version > ctl->delta.max_host_version)
+        ctl->delta.max_host_version = host_version;
+
     if(ctl->request->interrupt_callback && ctl->request->interrupt_callback(ctl->request->interrupt_callback_data))
         // interrupted
         return -1; // stop the query
@@ -526,7 +567,7 @@ static ssize_t rrdcontext_to_json_v2_add_host(void *data, RRDHOST *host, bool qu
         ssize_t added = query_scope_foreach_context(
                 host, ctl->request->scope_contexts,
                 ctl->contexts.scope_pattern, ctl->contexts.pattern,
-                rrdcontext_to_json_v2_add_context, queryable_host, ctl);
+                rrdcontext_to_json_v2_add_context, queryable_host, ctl, NULL);
 
         // restore it
         ctl->q.pattern = old_q;
@@ -705,6 +746,7 @@ static bool contexts_conflict_callback(const DICTIONARY_ITEM *item __maybe_unuse
 
     o->flags |= n->flags;
     o->match = MIN(o->match, n->match);
+    o->version = MAX(o->version, n->version);
 
     string_freez(n->family);
 
@@ -716,6 +758,96 @@ static void contexts_delete_callback(const DICTIONARY_ITEM *item __maybe_unused,
     string_freez(z->family);
 }
 
+// ----------------------------------------------------------------------------
+// delta responses and ETags
+//
+// The contexts and the hosts get a version on every change of the fields
+// returned here (see rrdcontext_api_check_for_changes_unsafe()), so that
+// clients giving the version of their last response (since=) get only the
+// contexts and nodes changed, and the ones removed, since then.
+//
+// Fields depending only on the time of the request (now, the last entry of
+// collected contexts, the timings) do not make a change.
+
+static bool contexts_v2_delta_supported(struct rrdcontext_to_json_v2_data *ctl) {
+    return ctl->request->since &&
+           (ctl->mode & (CONTEXTS_V2_CONTEXTS | CONTEXTS_V2_NODES)) &&
+           !(ctl->mode & (CONTEXTS_V2_SEARCH | CONTEXTS_V2_FUNCTIONS | CONTEXTS_V2_NODE_INSTANCES | CONTEXTS_V2_ALERTS | CONTEXTS_V2_ALERT_TRANSITIONS)) &&
+           !ctl->window.enabled;
+}
+
+static bool contexts_v2_etag_supported(struct rrdcontext_to_json_v2_data *ctl) {
+    return !(ctl->mode & (CONTEXTS_V2_SEARCH | CONTEXTS_V2_FUNCTIONS | CONTEXTS_V2_NODES_INFO | CONTEXTS_V2_NODE_INSTANCES |
+                          CONTEXTS_V2_AGENTS_INFO | CONTEXTS_V2_ALERTS | CONTEXTS_V2_ALERT_TRANSITIONS)) &&
+           !ctl->window.relative &&
+           !(ctl->options & CONTEXTS_OPTION_DEBUG);
+}
+
+static inline uint32_t contexts_v2_etag_hash(uint32_t hash, const char *s) {
+    return hash * 31 + simple_hash(s ? s : "");
+}
+
+static void contexts_v2_etag(struct rrdcontext_to_json_v2_data *ctl) {
+    struct api_v2_contexts_request *req = ctl->request;
+
+    uint32_t hash = ctl->mode;
+    hash = contexts_v2_etag_hash(hash, req->scope_nodes);
+    hash = contexts_v2_etag_hash(hash, req->nodes);
+    hash = contexts_v2_etag_hash(hash, req->scope_contexts);
+    hash = contexts_v2_etag_hash(hash, req->contexts);
+    hash = hash * 31 + (uint32_t)req->options;
+    hash = hash * 31 + (uint32_t)req->after;
+    hash = hash * 31 + (uint32_t)req->before;
+
+    snprintfz(req->etag, sizeof(req->etag) - 1, "\"%" PRIx64 "-%" PRIx64 "-%" PRIx64 "-%" PRIx64 "-%x\"",
+              ctl->delta.max_host_version,
+              rrdcontext_api_tombstones_latest(),
+              ctl->versions.contexts_hard_hash + ctl->versions.contexts_soft_hash +
+                  ctl->versions.alerts_hard_hash + ctl->versions.alerts_soft_hash,
+              req->since,
+              hash);
+}
+
+static bool contexts_v2_etag_matches(const char *etag, const char *if_none_match) {
+    if(!etag || !*etag || !if_none_match)
+        return false;
+
+    while(isspace((uint8_t)*if_none_match))
+        if_none_match++;
+
+    return *if_none_match == '*' || strstr(if_none_match, etag);
+}
+
+static void contexts_v2_delta_tombstone_cb(void *data, const char *machine_guid, STRING *id) {
+    struct rrdcontext_to_json_v2_data *ctl = data;
+
+    if(id) {
+        if(!ctl->contexts.dict)
+            return;
+
+        struct context_v2_entry *z = dictionary_get(ctl->contexts.dict, string2str(id));
+        if(z)
+            // the context is still available on other nodes
+            z->version = UINT64_MAX;
+        else
+            dictionary_set(ctl->delta.removed_contexts, string2str(id), NULL, 0);
+    }
+    else if(!dictionary_get(ctl->nodes.dict, machine_guid))
+        dictionary_set(ctl->delta.removed_nodes, machine_guid, NULL, 0);
+}
+
+static void contexts_v2_delta_removed_to_json(BUFFER *wb, const char *key, DICTIONARY *dict) {
+    buffer_json_member_add_array(wb, key);
+    {
+        void *t;
+        dfe_start_read(dict, t) {
+            buffer_json_add_array_item_string(wb, t_dfe.name);
+        }
+        dfe_done(t);
+    }
+    buffer_json_array_close(wb);
+}
+
 int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTEXTS_V2_MODE mode) {
     int resp = HTTP_RESP_OK;
     bool run = true;
@@ -808,6 +940,21 @@ int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTE
     else
         ctl.now = now_realtime_sec();
 
+    if(contexts_v2_delta_supported(&ctl)) {
+        ctl.delta.enabled = true;
+        ctl.delta.since = req->since;
+
+        ctl.delta.removed_nodes = dictionary_create_advanced(
+            DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_VALUE_LINK_DONT_CLONE, NULL, 0);
+
+        if(mode & CONTEXTS_V2_CONTEXTS)
+            ctl.delta.removed_contexts = dictionary_create_advanced(
+                DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_VALUE_LINK_DONT_CLONE, NULL, 0);
+    }
+
+    // changes made while this query runs are given again to the client
+    ctl.delta.version = rrdcontext_api_version_get();
+
     buffer_json_initialize(wb, "\"", "\"", 0, true,
                            ((req->options & CONTEXTS_OPTION_MINIFY) && !(req->options & CONTEXTS_OPTION_DEBUG)) ? BUFFER_JSON_OPTIONS_MINIFY : BUFFER_JSON_OPTIONS_DEFAULT);
 
@@ -898,6 +1045,21 @@ int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTE
 
     ctl.timings.executed_ut = now_monotonic_usec();
 
+    if(contexts_v2_etag_supported(&ctl)) {
+        contexts_v2_etag(&ctl);
+
+        if(contexts_v2_etag_matches(req->etag, req->if_none_match)) {
+            buffer_flush(wb);
+            resp = HTTP_RESP_NOT_MODIFIED;
+            goto cleanup;
+        }
+    }
+
+    if(ctl.delta.enabled)
+        ctl.delta.full = !rrdcontext_api_tombstones_foreach(ctl.delta.since, contexts_v2_delta_tombstone_cb, &ctl);
+
+    bool only_changes = ctl.delta.enabled && !ctl.delta.full;
+
     if(mode & CONTEXTS_V2_ALERT_TRANSITIONS) {
         contexts_v2_alert_transitions_to_json(wb, &ctl, debug);
     }
@@ -906,10 +1068,16 @@ int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTE
             buffer_json_member_add_array(wb, "nodes");
             struct contexts_v2_node *t;
             dfe_start_read(ctl.nodes.dict, t) {
+                if(only_changes && __atomic_load_n(&t->host->rrdctx.api_version, __ATOMIC_RELAXED) <= ctl.delta.since)
+                    continue;
+
                 rrdcontext_to_json_v2_rrdhost(wb, t->host, &ctl, t->ni);
             }
             dfe_done(t);
             buffer_json_array_close(wb);
+
+            if(only_changes)
+                contexts_v2_delta_removed_to_json(wb, "removed_nodes", ctl.delta.removed_nodes);
         }
 
         if (mode & CONTEXTS_V2_FUNCTIONS) {
@@ -943,6 +1111,9 @@ int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTE
             {
                 struct context_v2_entry *z;
                 dfe_start_read(ctl.contexts.dict, z) {
+                    if(only_changes && z->version <= ctl.delta.since)
+                        continue;
+
                     bool collected = z->flags & RRD_FLAG_COLLECTED;
 
                     buffer_json_member_add_object(wb, string2str(z->id));
@@ -960,6 +1131,9 @@ int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTE
                 dfe_done(z);
             }
             buffer_json_object_close(wb); // contexts
+
+            if(only_changes)
+                contexts_v2_delta_removed_to_json(wb, "removed_contexts", ctl.delta.removed_contexts);
         }
 
         if (mode & CONTEXTS_V2_ALERTS)
@@ -970,6 +1144,7 @@ int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTE
             {
                 buffer_json_member_add_uint64(wb, "strings", ctl.q.fts.string_searches);
                 buffer_json_member_add_uint64(wb, "char", ctl.q.fts.char_searches);
+                buffer_json_member_add_uint64(wb, "cached", ctl.q.fts.cached_searches);
                 buffer_json_member_add_uint64(wb, "total", ctl.q.fts.searches);
             }
             buffer_json_object_close(wb);
@@ -980,6 +1155,16 @@ int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTE
 
         if (mode & CONTEXTS_V2_AGENTS)
             buffer_json_agents_v2(wb, &ctl.timings, ctl.now, mode & (CONTEXTS_V2_AGENTS_INFO), true);
+
+        if (mode & (CONTEXTS_V2_CONTEXTS | CONTEXTS_V2_NODES)) {
+            buffer_json_member_add_object(wb, "delta");
+            {
+                buffer_json_member_add_uint64(wb, "since", ctl.delta.since);
+                buffer_json_member_add_uint64(wb, "version", ctl.delta.version);
+                buffer_json_member_add_boolean(wb, "full", !only_changes);
+            }
+            buffer_json_object_close(wb);
+        }
     }
 
     buffer_json_cloud_timings(wb, "timings", &ctl.timings);
@@ -990,12 +1175,15 @@ cleanup:
     dictionary_destroy(ctl.nodes.dict);
     dictionary_destroy(ctl.contexts.dict);
     dictionary_destroy(ctl.functions.dict);
+    dictionary_destroy(ctl.delta.removed_nodes);
+    dictionary_destroy(ctl.delta.removed_contexts);
     rrdcontexts_v2_alerts_cleanup(&ctl);
     simple_pattern_free(ctl.nodes.scope_pattern);
     simple_pattern_free(ctl.nodes.pattern);
     simple_pattern_free(ctl.contexts.pattern);
     simple_pattern_free(ctl.contexts.scope_pattern);
     simple_pattern_free(ctl.q.pattern);
+    full_text_search_cleanup(&ctl.q.fts);
     simple_pattern_free(ctl.alerts.alert_name_pattern);
 
     return resp;
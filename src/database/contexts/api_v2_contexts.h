@@ -23,6 +23,11 @@ typedef struct full_text_search_index {
     size_t searches;
     size_t string_searches;
     size_t char_searches;
+    size_t cached_searches;
+
+    // the results of the STRINGs already searched, by STRING pointer
+    // (the same dimension, label and alert strings repeat in many instances)
+    Pvoid_t JudyL;
 } FTS_INDEX;
 
 struct contexts_v2_node {
@@ -88,6 +93,16 @@ struct rrdcontext_to_json_v2_data {
         time_t before;
     } window;
 
+    struct {
+        bool enabled;
+        bool full;                  // the changes since the version of the client are not available
+        uint64_t since;
+        uint64_t version;           // the version of this response
+        uint64_t max_host_version;  // the last change of the hosts matched
+        DICTIONARY *removed_contexts;
+        DICTIONARY *removed_nodes;
+    } delta;
+
     struct query_timings timings;
 };
 
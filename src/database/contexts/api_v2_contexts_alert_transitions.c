@@ -314,16 +314,25 @@ void contexts_v2_alert_transitions_to_json(BUFFER *wb, struct rrdcontext_to_json
             data.facets[i].pattern = simple_pattern_create(ctl->request->alerts.facets[i], ",|", SIMPLE_PATTERN_EXACT, false);
     }
 
-    sql_alert_transitions(
-        ctl->nodes.dict,
-        ctl->window.after,
-        ctl->window.before,
-        ctl->request->contexts,
-        ctl->request->alerts.alert,
-        ctl->request->alerts.transition,
-        contexts_v2_alert_transition_callback,
-        &data,
-        debug);
+    if(!health_transitions_log_query(
+            ctl->nodes.dict,
+            ctl->window.after,
+            ctl->window.before,
+            ctl->request->contexts,
+            ctl->request->alerts.alert,
+            ctl->request->alerts.transition,
+            contexts_v2_alert_transition_callback,
+            &data))
+        sql_alert_transitions(
+            ctl->nodes.dict,
+            ctl->window.after,
+            ctl->window.before,
+            ctl->request->contexts,
+            ctl->request->alerts.alert,
+            ctl->request->alerts.transition,
+            contexts_v2_alert_transition_callback,
+            &data,
+            debug);
 
     buffer_json_member_add_array(wb, "facets");
     for (size_t i = 0; i < ATF_TOTAL_ENTRIES; i++) {
@@ -20,6 +20,7 @@ static void rrdcontext_freez(RRDCONTEXT *rc) {
     string_freez(rc->title);
     string_freez(rc->units);
     string_freez(rc->family);
+    string_freez(rc->api.family);
 }
 
 static void rrdcontext_insert_callback(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *rrdhost) {
@@ -90,6 +91,10 @@ static void rrdcontext_delete_callback(const DICTIONARY_ITEM *item __maybe_unuse
 
     RRDCONTEXT *rc = (RRDCONTEXT *)value;
 
+    // when the host is destroyed, its own tombstone removes all its contexts
+    if(!rc->api.deleted && rc->rrdhost->rrdctx.contexts)
+        rrdcontext_api_tombstone_add(rc->rrdhost, rc->id);
+
     rrdinstances_destroy_from_rrdcontext(rc);
     rrdcontext_freez(rc);
 }
@@ -303,12 +308,17 @@ void rrdhost_create_rrdcontexts(RRDHOST *host) {
     dictionary_register_insert_callback(host->rrdctx.pp_queue, rrdcontext_post_processing_queue_insert_callback, NULL);
     dictionary_register_delete_callback(host->rrdctx.pp_queue, rrdcontext_post_processing_queue_delete_callback, NULL);
     dictionary_register_conflict_callback(host->rrdctx.pp_queue, rrdcontext_post_processing_queue_conflict_callback, NULL);
+
+    rrdcontext_api_host_changed(host);
 }
 
 void rrdhost_destroy_rrdcontexts(RRDHOST *host) {
     if(unlikely(!host)) return;
     if(unlikely(!host->rrdctx.contexts)) return;
 
+    // the clients of the delta API have to remove the node
+    rrdcontext_api_tombstone_add(host, NULL);
+
     DICTIONARY *old;
 
     if(host->rrdctx.hub_queue) {
@@ -340,3 +350,148 @@ void rrdhost_destroy_rrdcontexts(RRDHOST *host) {
     dictionary_destroy(old);
 }
 
+
+// ----------------------------------------------------------------------------
+// changes tracking, for the delta responses of the API
+//
+// Every change of the fields the API returns for a context gets a new version
+// from a global counter, and the host of the context gets the same version.
+// The counter starts from the wall clock time in microseconds, so that the
+// versions given to the clients keep growing across restarts.
+//
+// Contexts and hosts removed are kept in a ring of tombstones, so that the
+// clients can be told to remove them too. When a tombstone newer than the
+// version of a client is overwritten, that client gets a complete response.
+
+#define RRDCONTEXT_API_TOMBSTONES 16384
+
+struct rrdcontext_api_tombstone {
+    uint64_t version;
+    STRING *id;                         // the context removed, or NULL when the host is removed
+    char machine_guid[GUID_LEN + 1];
+};
+
+static struct {
+    uint64_t version;
+    SPINLOCK spinlock;
+
+    uint64_t floor;                     // deltas since older versions cannot be computed
+    size_t added;
+    struct rrdcontext_api_tombstone *ring;
+} rrdcontext_api = {
+    .version = 0,
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .floor = 0,
+    .added = 0,
+    .ring = NULL,
+};
+
+uint64_t rrdcontext_api_version_get(void) {
+    uint64_t version = __atomic_load_n(&rrdcontext_api.version, __ATOMIC_RELAXED);
+    if(unlikely(!version)) {
+        uint64_t expected = 0;
+        version = now_realtime_usec();
+        if(!__atomic_compare_exchange_n(&rrdcontext_api.version, &expected, version, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            version = expected;
+    }
+
+    return version;
+}
+
+static uint64_t rrdcontext_api_version_next(void) {
+    rrdcontext_api_version_get();
+    return __atomic_add_fetch(&rrdcontext_api.version, 1, __ATOMIC_RELAXED);
+}
+
+void rrdcontext_api_host_changed(RRDHOST *host) {
+    __atomic_store_n(&host->rrdctx.api_version, rrdcontext_api_version_next(), __ATOMIC_RELAXED);
+}
+
+void rrdcontext_api_check_for_changes_unsafe(RRDCONTEXT *rc) {
+    bool deleted = rrd_flag_is_deleted(rc);
+    time_t last_time_s = rrd_flag_is_collected(rc) ? 0 : rc->last_time_s;
+
+    if(rc->api.version &&
+       rc->api.family == rc->family &&
+       rc->api.priority == rc->priority &&
+       rc->api.first_time_s == rc->first_time_s &&
+       rc->api.last_time_s == last_time_s &&
+       rc->api.deleted == deleted)
+        return;
+
+    if(deleted && !rc->api.deleted && rc->api.version)
+        rrdcontext_api_tombstone_add(rc->rrdhost, rc->id);
+
+    string_freez(rc->api.family);
+    rc->api.family = string_dup(rc->family);
+    rc->api.priority = rc->priority;
+    rc->api.first_time_s = rc->first_time_s;
+    rc->api.last_time_s = last_time_s;
+    rc->api.deleted = deleted;
+    rc->api.version = rrdcontext_api_version_next();
+
+    __atomic_store_n(&rc->rrdhost->rrdctx.api_version, rc->api.version, __ATOMIC_RELAXED);
+}
+
+void rrdcontext_api_tombstone_add(RRDHOST *host, STRING *id) {
+    spinlock_lock(&rrdcontext_api.spinlock);
+
+    if(unlikely(!rrdcontext_api.ring)) {
+        rrdcontext_api.ring = callocz(RRDCONTEXT_API_TOMBSTONES, sizeof(*rrdcontext_api.ring));
+        rrdcontext_api.floor = rrdcontext_api_version_get();
+    }
+
+    struct rrdcontext_api_tombstone *t = &rrdcontext_api.ring[rrdcontext_api.added++ % RRDCONTEXT_API_TOMBSTONES];
+    if(t->version) {
+        rrdcontext_api.floor = t->version;
+        string_freez(t->id);
+    }
+
+    t->version = rrdcontext_api_version_next();
+    t->id = string_dup(id);
+    strncpyz(t->machine_guid, host->machine_guid, sizeof(t->machine_guid) - 1);
+
+    spinlock_unlock(&rrdcontext_api.spinlock);
+
+    if(id)
+        __atomic_store_n(&host->rrdctx.api_version, t->version, __ATOMIC_RELAXED);
+}
+
+// the version of the last tombstone added
+uint64_t rrdcontext_api_tombstones_latest(void) {
+    uint64_t version = 0;
+
+    spinlock_lock(&rrdcontext_api.spinlock);
+    if(rrdcontext_api.added)
+        version = rrdcontext_api.ring[(rrdcontext_api.added - 1) % RRDCONTEXT_API_TOMBSTONES].version;
+    spinlock_unlock(&rrdcontext_api.spinlock);
+
+    return version;
+}
+
+// calls cb for all the tombstones added after since
+// returns false when some of them have been overwritten already
+bool rrdcontext_api_tombstones_foreach(uint64_t since, rrdcontext_api_tombstone_cb_t cb, void *data) {
+    bool complete = true;
+
+    spinlock_lock(&rrdcontext_api.spinlock);
+
+    if(rrdcontext_api.ring) {
+        if(since < rrdcontext_api.floor)
+            complete = false;
+        else {
+            size_t entries = MIN(rrdcontext_api.added, RRDCONTEXT_API_TOMBSTONES);
+            for(size_t i = 0; i < entries; i++) {
+                struct rrdcontext_api_tombstone *t = &rrdcontext_api.ring[(rrdcontext_api.added - 1 - i) % RRDCONTEXT_API_TOMBSTONES];
+                if(t->version <= since)
+                    break;
+
+                cb(data, t->machine_guid, t->id);
+            }
+        }
+    }
+
+    spinlock_unlock(&rrdcontext_api.spinlock);
+
+    return complete;
+}
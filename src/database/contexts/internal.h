@@ -11,12 +11,17 @@
 #include "../storage_engine.h"
 
 #define MESSAGES_PER_BUNDLE_TO_SEND_TO_HUB_PER_HOST         5000
+#define BYTES_PER_BUNDLE_TO_SEND_TO_HUB_PER_HOST            (512 * 1024)
+#define MESSAGES_PER_ITERATION_TO_SEND_TO_HUB_PER_HOST      (4 * MESSAGES_PER_BUNDLE_TO_SEND_TO_HUB_PER_HOST)
 #define FULL_RETENTION_SCAN_DELAY_AFTER_DB_ROTATION_SECS    120
 #define RRDCONTEXT_WORKER_THREAD_HEARTBEAT_USEC             (1000 * USEC_PER_MS)
 #define RRDCONTEXT_MINIMUM_ALLOWED_PRIORITY                 10
 
 #define LOG_TRANSITIONS false
 
+time_t rrdcontext_snapshot_every_s(void);
+void rrdcontext_snapshot_save(RRDHOST *host);
+
 #define WORKER_JOB_HOSTS            1
 #define WORKER_JOB_CHECK            2
 #define WORKER_JOB_SEND             3
@@ -30,6 +35,7 @@
 #define WORKER_JOB_PP_CONTEXT      11 // post-processing contexts
 #define WORKER_JOB_HUB_QUEUE_SIZE  12
 #define WORKER_JOB_PP_QUEUE_SIZE   13
+#define WORKER_JOB_SNAPSHOT        14
 
 
 typedef enum __attribute__ ((__packed__)) {
@@ -282,6 +288,15 @@ typedef struct rrdcontext {
     struct {
         uint32_t metrics;               // the number of metrics in this context
     } stats;
+
+    struct {
+        uint64_t version;               // the last change of the fields below, for the delta responses of the API
+        STRING *family;
+        uint32_t priority;
+        time_t first_time_s;
+        time_t last_time_s;             // zero while collected
+        bool deleted;
+    } api;
 } RRDCONTEXT;
 
 
@@ -385,4 +400,14 @@ void rrdcontext_message_send_unsafe(RRDCONTEXT *rc, bool snapshot __maybe_unused
 
 void rrdcontext_update_from_collected_rrdinstance(RRDINSTANCE *ri);
 
+// changes tracking, for the delta responses of the API
+uint64_t rrdcontext_api_version_get(void);
+void rrdcontext_api_host_changed(RRDHOST *host);
+void rrdcontext_api_check_for_changes_unsafe(RRDCONTEXT *rc);
+void rrdcontext_api_tombstone_add(RRDHOST *host, STRING *id);
+uint64_t rrdcontext_api_tombstones_latest(void);
+
+typedef void (*rrdcontext_api_tombstone_cb_t)(void *data, const char *machine_guid, STRING *id);
+bool rrdcontext_api_tombstones_foreach(uint64_t since, rrdcontext_api_tombstone_cb_t cb, void *data);
+
 #endif //NETDATA_RRDCONTEXT_INTERNAL_H
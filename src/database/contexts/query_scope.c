@@ -72,8 +72,58 @@ ssize_t query_scope_foreach_host(SIMPLE_PATTERN *scope_hosts_sp, SIMPLE_PATTERN
     return added;
 }
 
+typedef enum __attribute__((packed)) {
+    QUERY_SCOPE_CONTEXT_EVALUATED       = (1 << 0),
+    QUERY_SCOPE_CONTEXT_IN_SCOPE        = (1 << 1),
+    QUERY_SCOPE_CONTEXT_MATCHED         = (1 << 2),
+} QUERY_SCOPE_CONTEXT_MATCH;
+
+static QUERY_SCOPE_CONTEXT_MATCH query_scope_context_match(QUERY_SCOPE_CONTEXTS_CACHE *cache, STRING *id,
+                                                           SIMPLE_PATTERN *scope_contexts_sp, SIMPLE_PATTERN *contexts_sp) {
+    Pvoid_t *PValue = NULL;
+    if(cache) {
+        PValue = JudyLIns(&cache->JudyL, (Word_t)id, PJE0);
+        if (!PValue || PValue == PJERR)
+            fatal("QUERY SCOPE: corrupted contexts cache JudyL array");
+
+        if(*PValue)
+            return (QUERY_SCOPE_CONTEXT_MATCH)(Word_t)*PValue;
+
+        // the cache holds a reference, so that the pointer cannot be reused
+        // by another string while the query runs
+        string_dup(id);
+    }
+
+    QUERY_SCOPE_CONTEXT_MATCH match = QUERY_SCOPE_CONTEXT_EVALUATED;
+
+    if(!scope_contexts_sp || simple_pattern_matches_string(scope_contexts_sp, id))
+        match |= QUERY_SCOPE_CONTEXT_IN_SCOPE;
+
+    if(!contexts_sp || simple_pattern_matches_string(contexts_sp, id))
+        match |= QUERY_SCOPE_CONTEXT_MATCHED;
+
+    if(PValue)
+        *PValue = (void *)(Word_t)match;
+
+    return match;
+}
+
+void query_scope_contexts_cache_cleanup(QUERY_SCOPE_CONTEXTS_CACHE *cache) {
+    if(!cache || !cache->JudyL)
+        return;
+
+    bool first = true;
+    Word_t idx = 0;
+    while(JudyLFirstThenNext(cache->JudyL, &idx, &first))
+        string_freez((STRING *)idx);
+
+    JudyLFreeArray(&cache->JudyL, PJE0);
+    cache->JudyL = NULL;
+}
+
 ssize_t query_scope_foreach_context(RRDHOST *host, const char *scope_contexts, SIMPLE_PATTERN *scope_contexts_sp,
-                                   SIMPLE_PATTERN *contexts_sp, foreach_context_cb_t cb, bool queryable_host, void *data) {
+                                   SIMPLE_PATTERN *contexts_sp, foreach_context_cb_t cb, bool queryable_host, void *data,
+                                   QUERY_SCOPE_CONTEXTS_CACHE *cache) {
     if(unlikely(!host->rrdctx.contexts))
         return 0;
 
@@ -89,7 +139,8 @@ ssize_t query_scope_foreach_context(RRDHOST *host, const char *scope_contexts, S
 
         bool queryable_context = queryable_host;
         RRDCONTEXT *rc = rrdcontext_acquired_value(rca);
-        if(queryable_context && contexts_sp && !simple_pattern_matches_string(contexts_sp, rc->id))
+        if(queryable_context && contexts_sp &&
+            !(query_scope_context_match(cache, rc->id, NULL, contexts_sp) & QUERY_SCOPE_CONTEXT_MATCHED))
             queryable_context = false;
 
         added = cb(data, rca, queryable_context);
@@ -100,13 +151,14 @@ ssize_t query_scope_foreach_context(RRDHOST *host, const char *scope_contexts, S
         // Probably it is a pattern, we need to search for it...
         RRDCONTEXT *rc;
         dfe_start_read(host->rrdctx.contexts, rc) {
-            if(scope_contexts_sp && !simple_pattern_matches_string(scope_contexts_sp, rc->id))
+            QUERY_SCOPE_CONTEXT_MATCH match = query_scope_context_match(cache, rc->id, scope_contexts_sp, contexts_sp);
+            if(!(match & QUERY_SCOPE_CONTEXT_IN_SCOPE))
                 continue;
 
             dfe_unlock(rc);
 
             bool queryable_context = queryable_host;
-            if(queryable_context && contexts_sp && !simple_pattern_matches_string(contexts_sp, rc->id))
+            if(queryable_context && !(match & QUERY_SCOPE_CONTEXT_MATCHED))
                 queryable_context = false;
 
             ssize_t ret = cb(data, (RRDCONTEXT_ACQUIRED *)rc_dfe.item, queryable_context);
@@ -124,3 +176,93 @@ ssize_t query_scope_foreach_context(RRDHOST *host, const char *scope_contexts, S
     return added;
 }
 
+
+// ----------------------------------------------------------------------------
+// the hosts of a scope, resolved once for many queries
+
+static ssize_t query_scope_nodes_add(void *data, RRDHOST *host, bool queryable) {
+    QUERY_SCOPE_NODES *sn = data;
+
+    RRDHOST_ACQUIRED *rha = rrdhost_find_and_acquire(host->machine_guid);
+    if(!rha)
+        return 0;
+
+    if(sn->used == sn->size) {
+        sn->size = sn->size ? sn->size * 2 : 16;
+        sn->array = reallocz(sn->array, sn->size * sizeof(*sn->array));
+    }
+
+    sn->array[sn->used++] = (struct query_scope_node) {
+        .rha = rha,
+        .queryable = queryable,
+    };
+
+    return 1;
+}
+
+void query_scope_nodes_resolve(QUERY_SCOPE_NODES *sn, const char *scope_nodes, const char *nodes) {
+    memset(sn, 0, sizeof(*sn));
+
+    if(nodes && !scope_nodes)
+        scope_nodes = nodes;
+
+    SIMPLE_PATTERN *scope_nodes_sp = string_to_simple_pattern(scope_nodes);
+    SIMPLE_PATTERN *nodes_sp = string_to_simple_pattern(nodes);
+
+    query_scope_foreach_host(scope_nodes_sp, nodes_sp, query_scope_nodes_add, sn, NULL, NULL);
+
+    simple_pattern_free(scope_nodes_sp);
+    simple_pattern_free(nodes_sp);
+}
+
+void query_scope_nodes_release(QUERY_SCOPE_NODES *sn) {
+    for(size_t i = 0; i < sn->used ; i++)
+        rrdhost_acquired_release(sn->array[i].rha);
+
+    freez(sn->array);
+    memset(sn, 0, sizeof(*sn));
+}
+
+// like query_scope_foreach_host(), for the hosts already resolved
+ssize_t query_scope_nodes_foreach(QUERY_SCOPE_NODES *sn, foreach_host_cb_t cb, void *data,
+                                  struct query_versions *versions,
+                                  char *host_node_id_str) {
+    char uuid[UUID_STR_LEN];
+    if(!host_node_id_str) host_node_id_str = uuid;
+    host_node_id_str[0] = '\0';
+
+    ssize_t added = 0;
+    uint64_t v_hash = 0;
+    uint64_t h_hash = 0;
+    uint64_t a_hash = 0;
+    uint64_t t_hash = 0;
+
+    for(size_t i = 0; i < sn->used ; i++) {
+        RRDHOST *host = rrdhost_acquired_to_rrdhost(sn->array[i].rha);
+
+        if(!UUIDiszero(host->node_id))
+            uuid_unparse_lower(host->node_id.uuid, host_node_id_str);
+        else
+            host_node_id_str[0] = '\0';
+
+        v_hash += dictionary_version(host->rrdctx.contexts);
+        h_hash += dictionary_version(host->rrdctx.hub_queue);
+        a_hash += dictionary_version(host->rrdcalc_root_index);
+        t_hash += __atomic_load_n(&host->health_transitions, __ATOMIC_RELAXED);
+        ssize_t ret = cb(data, host, sn->array[i].queryable);
+        if(ret < 0) {
+            added = ret;
+            break;
+        }
+        added += ret;
+    }
+
+    if(versions) {
+        versions->contexts_hard_hash = v_hash;
+        versions->contexts_soft_hash = h_hash;
+        versions->alerts_hard_hash = a_hash;
+        versions->alerts_soft_hash = t_hash;
+    }
+
+    return added;
+}
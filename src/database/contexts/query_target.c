@@ -208,6 +208,9 @@ typedef struct query_target_locals {
 
     char host_node_id_str[UUID_STR_LEN];
     QUERY_NODE *qn; // temp to pass on callbacks, ignore otherwise - no need to free
+
+    struct pattern_array *labels_pa;    // the labels pattern, parsed once for all instances
+    QUERY_SCOPE_CONTEXTS_CACHE contexts_cache;
 } QUERY_TARGET_LOCALS;
 
 struct storage_engine *query_metric_storage_engine(QUERY_TARGET *qt, QUERY_METRIC *qm, size_t tier) {
@@ -729,18 +732,14 @@ static inline SIMPLE_PATTERN_RESULT query_instance_matches(QUERY_INSTANCE *qi,
 static inline bool query_instance_matches_labels(
     RRDINSTANCE *ri,
     SIMPLE_PATTERN *chart_label_key_sp,
-    SIMPLE_PATTERN *labels_sp)
+    struct pattern_array *labels_pa)
 {
 
     if (chart_label_key_sp && rrdlabels_match_simple_pattern_parsed(ri->rrdlabels, chart_label_key_sp, '\0', NULL) != SP_MATCHED_POSITIVE)
         return false;
 
-    if (labels_sp) {
-        struct pattern_array *pa = pattern_array_add_simple_pattern(NULL, labels_sp, ':');
-        bool found = pattern_array_label_match(pa, ri->rrdlabels, ':', NULL);
-        pattern_array_free(pa);
-        return found;
-    }
+    if (labels_pa)
+        return pattern_array_label_match(labels_pa, ri->rrdlabels, ':', NULL);
 
     return true;
 }
@@ -765,7 +764,7 @@ static bool query_instance_add(QUERY_TARGET_LOCALS *qtl, QUERY_NODE *qn, QUERY_C
         queryable_instance = query_instance_matches_labels(
             ri,
             qt->instances.chart_label_key_pattern,
-            qt->instances.labels_pattern);
+            qtl->labels_pa);
 
     if(queryable_instance) {
         if(qt->instances.alerts_pattern && !query_target_match_alert_pattern(ria, qt->instances.alerts_pattern))
@@ -939,7 +938,7 @@ static ssize_t query_node_add(void *data, RRDHOST *host, bool queryable_host) {
         added = query_scope_foreach_context(
                 host, qtl->scope_contexts,
                 qt->contexts.scope_pattern, qt->contexts.pattern,
-                query_context_add, queryable_host, qtl);
+                query_context_add, queryable_host, qtl, &qtl->contexts_cache);
 
         if(added < 0)
             added = 0;
@@ -1100,6 +1099,9 @@ QUERY_TARGET *query_target_create(QUERY_TARGET_REQUEST *qtr) {
     qt->instances.labels_pattern = string_to_simple_pattern(qtl.labels);
     qt->instances.alerts_pattern = string_to_simple_pattern(qtl.alerts);
 
+    if(qt->instances.labels_pattern)
+        qtl.labels_pa = pattern_array_add_simple_pattern(NULL, qt->instances.labels_pattern, ':');
+
     qtl.match_ids = qt->request.options & RRDR_OPTION_MATCH_IDS;
     qtl.match_names = qt->request.options & RRDR_OPTION_MATCH_NAMES;
     if(likely(!qtl.match_ids && !qtl.match_names))
@@ -1133,12 +1135,20 @@ QUERY_TARGET *query_target_create(QUERY_TARGET_REQUEST *qtr) {
         query_node_add(&qtl, host, true);
         qtl.nodes = rrdhost_hostname(host);
     }
+    else if(qt->request.scope_resolved)
+        query_scope_nodes_foreach(qt->request.scope_resolved,
+                                  query_node_add, &qtl,
+                                  &qt->versions,
+                                  qtl.host_node_id_str);
     else
         query_scope_foreach_host(qt->nodes.scope_pattern, qt->nodes.pattern,
                                  query_node_add, &qtl,
                                  &qt->versions,
                                  qtl.host_node_id_str);
 
+    pattern_array_free(qtl.labels_pa);
+    query_scope_contexts_cache_cleanup(&qtl.contexts_cache);
+
     // we need the available db retention for this call
     // so it has to be done last
     query_target_calculate_window(qt);
@@ -1165,6 +1175,8 @@ ssize_t weights_foreach_rrdmetric_in_context(RRDCONTEXT_ACQUIRED *rca,
 
     char host_node_id_str[UUID_STR_LEN] = "";
 
+    struct pattern_array *labels_pa = labels_sp ? pattern_array_add_simple_pattern(NULL, labels_sp, ':') : NULL;
+
     bool proceed = true;
 
     ssize_t count = 0;
@@ -1185,7 +1197,7 @@ ssize_t weights_foreach_rrdmetric_in_context(RRDCONTEXT_ACQUIRED *rca,
                         continue;
                 }
 
-                if(!query_instance_matches_labels(ri, chart_label_key_sp, labels_sp))
+                if(!query_instance_matches_labels(ri, chart_label_key_sp, labels_pa))
                     continue;
 
                 if(alerts_sp && !query_target_match_alert_pattern(ria, alerts_sp))
@@ -1229,5 +1241,7 @@ ssize_t weights_foreach_rrdmetric_in_context(RRDCONTEXT_ACQUIRED *rca,
                     break;
             }
     dfe_done(ri);
+
+    pattern_array_free(labels_pa);
     return count;
 }
@@ -56,6 +56,7 @@ RRDSET_TYPE rrdcontext_acquired_chart_type(RRDCONTEXT_ACQUIRED *rca);
 // public API for rrdhost
 
 void rrdhost_load_rrdcontext_data(RRDHOST *host);
+bool rrdhost_load_rrdcontext_snapshot(RRDHOST *host);
 void rrdhost_create_rrdcontexts(RRDHOST *host);
 void rrdhost_destroy_rrdcontexts(RRDHOST *host);
 
@@ -246,6 +247,7 @@ typedef struct _query_metric {
 #define MAX_QUERY_GROUP_BY_PASSES 2
 
 typedef bool (*qt_interrupt_callback_t)(void *data);
+typedef bool (*qt_flush_callback_t)(BUFFER *wb, void *data);
 
 struct group_by_pass {
     RRDR_GROUP_BY group_by;
@@ -261,6 +263,7 @@ typedef struct query_target_request {
 
     // selecting / filtering metrics to be queried
     RRDHOST *host;                      // the host to be queried (can be NULL, hosts will be used)
+    struct query_scope_nodes *scope_resolved; // the hosts of scope_nodes and nodes, resolved by the caller (can be NULL)
     RRDCONTEXT_ACQUIRED *rca;           // the context to be queried (can be NULL)
     RRDINSTANCE_ACQUIRED *ria;          // the instance to be queried (can be NULL)
     RRDMETRIC_ACQUIRED *rma;            // the metric to be queried (can be NULL)
@@ -300,6 +303,12 @@ typedef struct query_target_request {
     qt_interrupt_callback_t interrupt_callback;
     void *interrupt_callback_data;
 
+    // when set, the formatters give the output generated so far to this callback,
+    // every time it exceeds flush_size bytes, so that responses are streamed
+    qt_flush_callback_t flush_callback;
+    void *flush_callback_data;
+    size_t flush_size;
+
     nd_uuid_t *transaction;
 } QUERY_TARGET_REQUEST;
 
@@ -639,6 +648,10 @@ struct api_v2_contexts_request {
     time_t before;
     time_t timeout_ms;
 
+    uint64_t since;                     // the version of a previous response, to get only the changes since then
+    const char *if_none_match;          // the ETags the client has
+    char etag[80];                      // output: the ETag of the response, or empty
+
     qt_interrupt_callback_t interrupt_callback;
     void *interrupt_callback_data;
 };
@@ -674,8 +687,32 @@ ssize_t query_scope_foreach_host(SIMPLE_PATTERN *scope_hosts_sp, SIMPLE_PATTERN
                                   struct query_versions *versions,
                                   char *host_node_id_str);
 
+// the hosts of a scope, resolved once for many queries of the same scope
+typedef struct query_scope_nodes {
+    size_t used;
+    size_t size;
+    struct query_scope_node {
+        RRDHOST_ACQUIRED *rha;
+        bool queryable;
+    } *array;
+} QUERY_SCOPE_NODES;
+
+void query_scope_nodes_resolve(QUERY_SCOPE_NODES *sn, const char *scope_nodes, const char *nodes);
+void query_scope_nodes_release(QUERY_SCOPE_NODES *sn);
+ssize_t query_scope_nodes_foreach(QUERY_SCOPE_NODES *sn, foreach_host_cb_t cb, void *data,
+                                  struct query_versions *versions,
+                                  char *host_node_id_str);
+
+// context ids are shared by all hosts, so a query spanning many hosts
+// can match each context id against its patterns only once
+typedef struct query_scope_contexts_cache {
+    Pvoid_t JudyL;                  // STRING * of the context id -> QUERY_SCOPE_CONTEXT_MATCH
+} QUERY_SCOPE_CONTEXTS_CACHE;
+
+void query_scope_contexts_cache_cleanup(QUERY_SCOPE_CONTEXTS_CACHE *cache);
+
 typedef ssize_t (*foreach_context_cb_t)(void *data, RRDCONTEXT_ACQUIRED *rca, bool queryable_context);
-ssize_t query_scope_foreach_context(RRDHOST *host, const char *scope_contexts, SIMPLE_PATTERN *scope_contexts_sp, SIMPLE_PATTERN *contexts_sp, foreach_context_cb_t cb, bool queryable_host, void *data);
+ssize_t query_scope_foreach_context(RRDHOST *host, const char *scope_contexts, SIMPLE_PATTERN *scope_contexts_sp, SIMPLE_PATTERN *contexts_sp, foreach_context_cb_t cb, bool queryable_host, void *data, QUERY_SCOPE_CONTEXTS_CACHE *cache);
 
 // ----------------------------------------------------------------------------
 // public API for weights
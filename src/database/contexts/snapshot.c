@@ -0,0 +1,514 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "internal.h"
+
+// ----------------------------------------------------------------------------
+// context snapshots
+//
+// The contexts, instances and metrics of each host, together with their
+// retention and the versions the hub knows, are periodically saved in the
+// cache directory of the host.
+//
+// When netdata starts, the snapshot of each archived host is mmapped and loaded
+// in a single pass, so that its contexts are queryable immediately. The full
+// load from SQL still runs in the background and merges into the same objects.
+//
+// All strings are stored inline, as a 16-bit length followed by the string and
+// its terminating NULL, so that they can be used directly from the mapping.
+
+#define RRDCONTEXT_SNAPSHOT_MAGIC "NDCTXSN\x01"
+#define RRDCONTEXT_SNAPSHOT_VERSION 1
+#define RRDCONTEXT_SNAPSHOT_FILENAME "context-snapshot.db"
+
+struct rrdcontext_snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    nd_uuid_t host_id;
+    uint64_t saved_s;
+    uint64_t contexts;
+} __attribute__((packed));
+
+struct rrdcontext_snapshot_context {
+    uint64_t hub_version;
+    uint64_t hub_priority;
+    uint64_t hub_first_time_s;
+    uint64_t hub_last_time_s;
+    uint8_t hub_deleted;
+    uint32_t instances;
+    // followed by the strings: id, hub title, hub units, hub family, hub chart type
+    // and then by the instances
+} __attribute__((packed));
+
+struct rrdcontext_snapshot_instance {
+    nd_uuid_t uuid;
+    uint32_t priority;
+    uint32_t update_every_s;
+    uint8_t chart_type;
+    uint32_t labels;
+    uint32_t metrics;
+    // followed by the strings: id, name, title, units, family
+    // and then by the labels and the metrics
+} __attribute__((packed));
+
+struct rrdcontext_snapshot_label {
+    uint32_t source;
+    // followed by the strings: key, value
+} __attribute__((packed));
+
+struct rrdcontext_snapshot_metric {
+    nd_uuid_t uuid;
+    int64_t first_time_s;
+    int64_t last_time_s;
+    uint8_t hidden;
+    // followed by the strings: id, name
+} __attribute__((packed));
+
+time_t rrdcontext_snapshot_every_s(void) {
+    static time_t every_s = -1;
+
+    if(unlikely(every_s < 0)) {
+        time_t t = config_get_duration_seconds(CONFIG_SECTION_DB, "context snapshot every", 3600);
+        if(t < 0) t = 0;
+        every_s = t;
+    }
+
+    return every_s;
+}
+
+static void rrdcontext_snapshot_filename(RRDHOST *host, char *filename, size_t size) {
+    snprintfz(filename, size, "%s/" RRDCONTEXT_SNAPSHOT_FILENAME, host->cache_dir);
+}
+
+// ----------------------------------------------------------------------------
+// saving
+
+static void rrdcontext_snapshot_write_string(FILE *fp, const char *s) {
+    size_t len = s ? strlen(s) : 0;
+    if(len > UINT16_MAX)
+        len = UINT16_MAX;
+
+    uint16_t len16 = (uint16_t)len;
+    fwrite(&len16, sizeof(len16), 1, fp);
+    if(len)
+        fwrite(s, len, 1, fp);
+    fputc('\0', fp);
+}
+
+// the counts of the children of a record are known after they are written
+static void rrdcontext_snapshot_patch_count(FILE *fp, long pos, uint32_t count) {
+    long end = ftell(fp);
+    if(pos < 0 || end < 0)
+        return;
+
+    fseek(fp, pos, SEEK_SET);
+    fwrite(&count, sizeof(count), 1, fp);
+    fseek(fp, end, SEEK_SET);
+}
+
+struct rrdcontext_snapshot_labels {
+    FILE *fp;
+    uint32_t count;
+};
+
+static int rrdcontext_snapshot_write_label(const char *name, const char *value, RRDLABEL_SRC ls, void *data) {
+    struct rrdcontext_snapshot_labels *t = data;
+
+    struct rrdcontext_snapshot_label l = {
+        .source = (uint32_t)ls,
+    };
+    fwrite(&l, sizeof(l), 1, t->fp);
+    rrdcontext_snapshot_write_string(t->fp, name);
+    rrdcontext_snapshot_write_string(t->fp, value);
+    t->count++;
+
+    return 1;
+}
+
+static void rrdcontext_snapshot_write_instance(FILE *fp, RRDINSTANCE *ri) {
+    long pos = ftell(fp);
+
+    struct rrdcontext_snapshot_instance i = {
+        .priority = ri->priority,
+        .update_every_s = (uint32_t)ri->update_every_s,
+        .chart_type = (uint8_t)ri->chart_type,
+    };
+    uuid_copy(i.uuid, ri->uuid);
+    fwrite(&i, sizeof(i), 1, fp);
+
+    rrdcontext_snapshot_write_string(fp, string2str(ri->id));
+    rrdcontext_snapshot_write_string(fp, string2str(ri->name));
+    rrdcontext_snapshot_write_string(fp, string2str(ri->title));
+    rrdcontext_snapshot_write_string(fp, string2str(ri->units));
+    rrdcontext_snapshot_write_string(fp, string2str(ri->family));
+
+    struct rrdcontext_snapshot_labels t = { .fp = fp, };
+    rrdlabels_walkthrough_read(ri->rrdlabels, rrdcontext_snapshot_write_label, &t);
+
+    uint32_t metrics = 0;
+    RRDMETRIC *rm;
+    dfe_start_read(ri->rrdmetrics, rm) {
+        if(rrd_flag_is_deleted(rm))
+            continue;
+
+        struct rrdcontext_snapshot_metric m = {
+            .first_time_s = rm->first_time_s,
+            .last_time_s = rm->last_time_s,
+            .hidden = rrd_flag_check(rm, RRD_FLAG_HIDDEN) ? 1 : 0,
+        };
+        uuid_copy(m.uuid, rm->uuid);
+        fwrite(&m, sizeof(m), 1, fp);
+
+        rrdcontext_snapshot_write_string(fp, string2str(rm->id));
+        rrdcontext_snapshot_write_string(fp, string2str(rm->name));
+        metrics++;
+    }
+    dfe_done(rm);
+
+    if(pos >= 0) {
+        rrdcontext_snapshot_patch_count(fp, pos + (long)offsetof(struct rrdcontext_snapshot_instance, labels), t.count);
+        rrdcontext_snapshot_patch_count(fp, pos + (long)offsetof(struct rrdcontext_snapshot_instance, metrics), metrics);
+    }
+}
+
+static void rrdcontext_snapshot_write_context(FILE *fp, RRDCONTEXT *rc) {
+    long pos = ftell(fp);
+
+    rrdcontext_lock(rc);
+
+    struct rrdcontext_snapshot_context c = {
+        .hub_version = rc->hub.version,
+        .hub_priority = rc->hub.priority,
+        .hub_first_time_s = rc->hub.first_time_s,
+        .hub_last_time_s = rc->hub.last_time_s,
+        .hub_deleted = rc->hub.deleted ? 1 : 0,
+    };
+    fwrite(&c, sizeof(c), 1, fp);
+
+    rrdcontext_snapshot_write_string(fp, string2str(rc->id));
+    rrdcontext_snapshot_write_string(fp, rc->hub.version ? rc->hub.title : NULL);
+    rrdcontext_snapshot_write_string(fp, rc->hub.version ? rc->hub.units : NULL);
+    rrdcontext_snapshot_write_string(fp, rc->hub.version ? rc->hub.family : NULL);
+    rrdcontext_snapshot_write_string(fp, rc->hub.version ? rc->hub.chart_type : NULL);
+
+    rrdcontext_unlock(rc);
+
+    uint32_t instances = 0;
+    RRDINSTANCE *ri;
+    dfe_start_read(rc->rrdinstances, ri) {
+        if(rrd_flag_is_deleted(ri))
+            continue;
+
+        rrdcontext_snapshot_write_instance(fp, ri);
+        instances++;
+    }
+    dfe_done(ri);
+
+    if(pos >= 0)
+        rrdcontext_snapshot_patch_count(fp, pos + (long)offsetof(struct rrdcontext_snapshot_context, instances), instances);
+}
+
+void rrdcontext_snapshot_save(RRDHOST *host) {
+    if(!host->rrdctx.contexts || !host->cache_dir || !*host->cache_dir)
+        return;
+
+    char filename[FILENAME_MAX + 1], tmp_filename[FILENAME_MAX + 1];
+    rrdcontext_snapshot_filename(host, filename, sizeof(filename));
+    snprintfz(tmp_filename, FILENAME_MAX, "%s.new", filename);
+
+    FILE *fp = fopen(tmp_filename, "w");
+    if(!fp) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "RRDCONTEXT: cannot create the context snapshot '%s' of host '%s'",
+               tmp_filename, rrdhost_hostname(host));
+        return;
+    }
+
+    usec_t started_ut = now_monotonic_usec();
+
+    struct rrdcontext_snapshot_header h = {
+        .version = RRDCONTEXT_SNAPSHOT_VERSION,
+        .saved_s = (uint64_t)now_realtime_sec(),
+    };
+    memcpy(h.magic, RRDCONTEXT_SNAPSHOT_MAGIC, sizeof(h.magic));
+    uuid_copy(h.host_id, host->host_id.uuid);
+    fwrite(&h, sizeof(h), 1, fp);
+
+    RRDCONTEXT *rc;
+    dfe_start_read(host->rrdctx.contexts, rc) {
+        if(rrd_flag_is_deleted(rc))
+            continue;
+
+        rrdcontext_snapshot_write_context(fp, rc);
+        h.contexts++;
+    }
+    dfe_done(rc);
+
+    // rewrite the header with the number of contexts
+    fseek(fp, 0, SEEK_SET);
+    fwrite(&h, sizeof(h), 1, fp);
+
+    bool ok = !ferror(fp);
+    if(fclose(fp) != 0)
+        ok = false;
+
+    if(!ok || rename(tmp_filename, filename) != 0) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "RRDCONTEXT: cannot save the context snapshot '%s' of host '%s'",
+               filename, rrdhost_hostname(host));
+        unlink(tmp_filename);
+        return;
+    }
+
+    nd_log(NDLS_DAEMON, NDLP_DEBUG,
+           "RRDCONTEXT: saved the snapshot of %"PRIu64" contexts of host '%s' in %0.2f ms",
+           h.contexts, rrdhost_hostname(host), (double)(now_monotonic_usec() - started_ut) / USEC_PER_MS);
+}
+
+// ----------------------------------------------------------------------------
+// loading
+
+struct rrdcontext_snapshot_reader {
+    const uint8_t *pos;
+    const uint8_t *end;
+    bool failed;
+};
+
+static const void *rrdcontext_snapshot_read(struct rrdcontext_snapshot_reader *r, size_t bytes) {
+    if(r->failed || (size_t)(r->end - r->pos) < bytes) {
+        r->failed = true;
+        return NULL;
+    }
+
+    const void *ret = r->pos;
+    r->pos += bytes;
+    return ret;
+}
+
+static const char *rrdcontext_snapshot_read_string(struct rrdcontext_snapshot_reader *r) {
+    const uint16_t *len = rrdcontext_snapshot_read(r, sizeof(*len));
+    if(!len)
+        return "";
+
+    uint16_t l;
+    memcpy(&l, len, sizeof(l));
+
+    const char *s = rrdcontext_snapshot_read(r, (size_t)l + 1);
+    if(!s || s[l] != '\0') {
+        r->failed = true;
+        return "";
+    }
+
+    return s;
+}
+
+static void rrdcontext_snapshot_load_instance(RRDHOST *host, const char *context, struct rrdcontext_snapshot_reader *r) {
+    struct rrdcontext_snapshot_instance i;
+    const void *p = rrdcontext_snapshot_read(r, sizeof(i));
+    if(!p) return;
+    memcpy(&i, p, sizeof(i));
+
+    const char *id = rrdcontext_snapshot_read_string(r);
+    const char *name = rrdcontext_snapshot_read_string(r);
+    const char *title = rrdcontext_snapshot_read_string(r);
+    const char *units = rrdcontext_snapshot_read_string(r);
+    const char *family = rrdcontext_snapshot_read_string(r);
+    if(r->failed || !*id) {
+        r->failed = true;
+        return;
+    }
+
+    STRING *title_s = string_strdupz(title);
+    STRING *units_s = string_strdupz(units);
+    STRING *family_s = string_strdupz(family);
+
+    RRDCONTEXT tc = {
+            .id = string_strdupz(context),
+            .title = string_dup(title_s),
+            .units = string_dup(units_s),
+            .family = string_dup(family_s),
+            .priority = i.priority,
+            .chart_type = (RRDSET_TYPE)i.chart_type,
+            .flags = RRD_FLAG_ARCHIVED | RRD_FLAG_UPDATE_REASON_LOAD_SQL, // no need for atomics
+            .rrdhost = host,
+    };
+
+    RRDCONTEXT_ACQUIRED *rca = (RRDCONTEXT_ACQUIRED *)dictionary_set_and_acquire_item(host->rrdctx.contexts, string2str(tc.id), &tc, sizeof(tc));
+    RRDCONTEXT *rc = rrdcontext_acquired_value(rca);
+
+    RRDINSTANCE tri = {
+            .id = string_strdupz(id),
+            .name = string_strdupz(name),
+            .title = title_s,
+            .units = units_s,
+            .family = family_s,
+            .chart_type = (RRDSET_TYPE)i.chart_type,
+            .priority = i.priority,
+            .update_every_s = (time_t)i.update_every_s,
+            .flags = RRD_FLAG_ARCHIVED | RRD_FLAG_UPDATE_REASON_LOAD_SQL, // no need for atomics
+    };
+    uuid_copy(tri.uuid, i.uuid);
+
+    RRDINSTANCE_ACQUIRED *ria = (RRDINSTANCE_ACQUIRED *)dictionary_set_and_acquire_item(rc->rrdinstances, id, &tri, sizeof(tri));
+    RRDINSTANCE *ri = rrdinstance_acquired_value(ria);
+
+    for(uint32_t l = 0; l < i.labels && !r->failed ;l++) {
+        struct rrdcontext_snapshot_label label;
+        p = rrdcontext_snapshot_read(r, sizeof(label));
+        if(!p) break;
+        memcpy(&label, p, sizeof(label));
+
+        const char *key = rrdcontext_snapshot_read_string(r);
+        const char *value = rrdcontext_snapshot_read_string(r);
+        if(!r->failed && *key)
+            rrdlabels_add(ri->rrdlabels, key, value, (RRDLABEL_SRC)label.source);
+    }
+
+    for(uint32_t m = 0; m < i.metrics && !r->failed ;m++) {
+        struct rrdcontext_snapshot_metric metric;
+        p = rrdcontext_snapshot_read(r, sizeof(metric));
+        if(!p) break;
+        memcpy(&metric, p, sizeof(metric));
+
+        const char *metric_id = rrdcontext_snapshot_read_string(r);
+        const char *metric_name = rrdcontext_snapshot_read_string(r);
+        if(r->failed || !*metric_id)
+            break;
+
+        RRDMETRIC trm = {
+                .id = string_strdupz(metric_id),
+                .name = string_strdupz(metric_name),
+                .first_time_s = (time_t)metric.first_time_s,
+                .last_time_s = (time_t)metric.last_time_s,
+                .flags = RRD_FLAG_ARCHIVED | RRD_FLAG_UPDATE_REASON_LOAD_SQL, // no need for atomic
+        };
+        if(metric.hidden) trm.flags |= RRD_FLAG_HIDDEN;
+
+        uuid_copy(trm.uuid, metric.uuid);
+
+        dictionary_set(ri->rrdmetrics, string2str(trm.id), &trm, sizeof(trm));
+    }
+
+    rrdinstance_trigger_updates(ri, __FUNCTION__ );
+    rrdinstance_release(ria);
+    rrdcontext_release(rca);
+}
+
+static void rrdcontext_snapshot_load_context(RRDHOST *host, struct rrdcontext_snapshot_reader *r) {
+    struct rrdcontext_snapshot_context c;
+    const void *p = rrdcontext_snapshot_read(r, sizeof(c));
+    if(!p) return;
+    memcpy(&c, p, sizeof(c));
+
+    const char *id = rrdcontext_snapshot_read_string(r);
+    const char *title = rrdcontext_snapshot_read_string(r);
+    const char *units = rrdcontext_snapshot_read_string(r);
+    const char *family = rrdcontext_snapshot_read_string(r);
+    const char *chart_type = rrdcontext_snapshot_read_string(r);
+    if(r->failed || !*id) {
+        r->failed = true;
+        return;
+    }
+
+    if(c.hub_version) {
+        // the same the SQL load does with the versioned contexts
+        RRDCONTEXT trc = {
+                .id = string_strdupz(id),
+                .flags = RRD_FLAG_ARCHIVED | RRD_FLAG_UPDATE_REASON_LOAD_SQL, // no need for atomics
+
+                .hub = {
+                        .version = c.hub_version,
+                        .id = id,
+                        .title = title,
+                        .chart_type = chart_type,
+                        .units = units,
+                        .family = family,
+                        .priority = c.hub_priority,
+                        .first_time_s = c.hub_first_time_s,
+                        .last_time_s = c.hub_last_time_s,
+                        .deleted = c.hub_deleted ? true : false,
+                },
+        };
+        dictionary_set(host->rrdctx.contexts, string2str(trc.id), &trc, sizeof(trc));
+    }
+
+    for(uint32_t i = 0; i < c.instances && !r->failed ;i++)
+        rrdcontext_snapshot_load_instance(host, id, r);
+}
+
+bool rrdhost_load_rrdcontext_snapshot(RRDHOST *host) {
+    if(!rrdcontext_snapshot_every_s() || host->rrdctx.contexts || !host->cache_dir || !*host->cache_dir)
+        return false;
+
+    char filename[FILENAME_MAX + 1];
+    rrdcontext_snapshot_filename(host, filename, sizeof(filename));
+
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct rrdcontext_snapshot_header)) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    uint8_t *mem = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(mem == MAP_FAILED) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "RRDCONTEXT: cannot mmap() the context snapshot '%s'", filename);
+        return false;
+    }
+    madvise_sequential(mem, size);
+
+    usec_t started_ut = now_monotonic_usec();
+
+    struct rrdcontext_snapshot_reader r = {
+        .pos = mem,
+        .end = mem + size,
+    };
+
+    struct rrdcontext_snapshot_header h;
+    memcpy(&h, rrdcontext_snapshot_read(&r, sizeof(h)), sizeof(h));
+
+    if(memcmp(h.magic, RRDCONTEXT_SNAPSHOT_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != RRDCONTEXT_SNAPSHOT_VERSION ||
+        !nd_uuid_eq(h.host_id, host->host_id.uuid)) {
+        nd_log(NDLS_DAEMON, NDLP_WARNING,
+               "RRDCONTEXT: ignoring the context snapshot '%s' of host '%s', it is not valid",
+               filename, rrdhost_hostname(host));
+        munmap(mem, size);
+        return false;
+    }
+
+    rrdhost_create_rrdcontexts(host);
+
+    for(uint64_t c = 0; c < h.contexts && !r.failed ;c++)
+        rrdcontext_snapshot_load_context(host, &r);
+
+    munmap(mem, size);
+
+    if(r.failed)
+        nd_log(NDLS_DAEMON, NDLP_WARNING,
+               "RRDCONTEXT: the context snapshot '%s' of host '%s' is truncated, loaded what was valid",
+               filename, rrdhost_hostname(host));
+
+    RRDCONTEXT *rc;
+    dfe_start_read(host->rrdctx.contexts, rc) {
+        rrdcontext_trigger_updates(rc, __FUNCTION__ );
+    }
+    dfe_done(rc);
+
+    // the full load from SQL has still to be done
+    __atomic_store_n(&host->rrdctx.snapshot_loaded, true, __ATOMIC_RELEASE);
+
+    nd_log(NDLS_DAEMON, NDLP_DEBUG,
+           "RRDCONTEXT: loaded the snapshot of %zu contexts of host '%s' saved %"PRIu64" seconds ago, in %0.2f ms",
+           dictionary_entries(host->rrdctx.contexts), rrdhost_hostname(host),
+           (uint64_t)now_realtime_sec() - h.saved_s,
+           (double)(now_monotonic_usec() - started_ut) / USEC_PER_MS);
+
+    return true;
+}
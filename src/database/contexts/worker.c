@@ -12,7 +12,7 @@ static void rrdcontext_dequeue_from_post_processing(RRDCONTEXT *rc);
 static void rrdcontext_post_process_updates(RRDCONTEXT *rc, bool force, RRD_FLAGS reason, bool worker_jobs);
 
 static void rrdcontext_garbage_collect_single_host(RRDHOST *host, bool worker_jobs);
-static void rrdcontext_garbage_collect_for_all_hosts(void);
+static inline bool rrdcontext_host_is_ours(RRDHOST *host, size_t worker);
 
 extern usec_t rrdcontext_next_db_rotation_ut;
 
@@ -96,7 +96,9 @@ static void rrdcontext_load_context_callback(VERSIONED_CONTEXT_DATA *ctx_data, v
 }
 
 void rrdhost_load_rrdcontext_data(RRDHOST *host) {
-    if(host->rrdctx.contexts) return;
+    // contexts loaded from their snapshot still need the full load from SQL
+    if(host->rrdctx.contexts && !__atomic_exchange_n(&host->rrdctx.snapshot_loaded, false, __ATOMIC_ACQ_REL))
+        return;
 
     rrdhost_create_rrdcontexts(host);
     ctx_get_context_list(&host->host_id.uuid, rrdcontext_load_context_callback, host);
@@ -220,10 +222,12 @@ void rrdcontext_recalculate_host_retention(RRDHOST *host, RRD_FLAGS reason, bool
     rrdhost_update_cached_retention(host, first_time_s, last_time_s, true);
 }
 
-static void rrdcontext_recalculate_retention_all_hosts(void) {
-    rrdcontext_next_db_rotation_ut = 0;
+static void rrdcontext_recalculate_retention_of_worker_hosts(size_t worker) {
     RRDHOST *host;
     dfe_start_reentrant(rrdhost_root_index, host) {
+        if(!rrdcontext_host_is_ours(host, worker))
+            continue;
+
         worker_is_busy(WORKER_JOB_RETENTION);
         rrdcontext_recalculate_host_retention(host, RRD_FLAG_UPDATE_REASON_DB_ROTATION, true);
     }
@@ -259,6 +263,17 @@ bool rrdmetric_update_retention(RRDMETRIC *rm) {
     if((min_first_time_t == LONG_MAX || min_first_time_t == 0) && max_last_time_t == 0)
         return false;
 
+#ifdef ENABLE_DBENGINE
+    // while higher tiers are still loading, retention can only be expanded
+    if(!rm->rrddim && dbengine_enabled && !rrdeng_all_tiers_ready()) {
+        if(rm->first_time_s && rm->first_time_s < min_first_time_t)
+            min_first_time_t = rm->first_time_s;
+
+        if(rm->last_time_s > max_last_time_t)
+            max_last_time_t = rm->last_time_s;
+    }
+#endif
+
     if(min_first_time_t == LONG_MAX)
         min_first_time_t = 0;
 
@@ -299,6 +314,12 @@ static inline bool rrdmetric_should_be_deleted(RRDMETRIC *rm) {
     if(likely(rm->rrddim))
         return false;
 
+#ifdef ENABLE_DBENGINE
+    // the retention of the tiers still loading is not known yet
+    if(dbengine_enabled && !rrdeng_all_tiers_ready())
+        return false;
+#endif
+
     rrdmetric_update_retention(rm);
     if(rm->first_time_s || rm->last_time_s)
         return false;
@@ -441,9 +462,12 @@ static void rrdcontext_garbage_collect_single_host(RRDHOST *host, bool worker_jo
     dfe_done(rc);
 }
 
-static void rrdcontext_garbage_collect_for_all_hosts(void) {
+static void rrdcontext_garbage_collect_worker_hosts(size_t worker) {
     RRDHOST *host;
     dfe_start_reentrant(rrdhost_root_index, host) {
+        if(!rrdcontext_host_is_ours(host, worker))
+            continue;
+
         rrdcontext_garbage_collect_single_host(host, true);
     }
     dfe_done(host);
@@ -745,6 +769,8 @@ static void rrdcontext_post_process_updates(RRDCONTEXT *rc, bool force, RRD_FLAG
         }
     }
 
+    rrdcontext_api_check_for_changes_unsafe(rc);
+
     if(unlikely(rrd_flag_is_updated(rc) && rc->rrdhost->rrdctx.hub_queue)) {
         if(check_if_cloud_version_changed_unsafe(rc, false)) {
             rc->version = rrdcontext_get_next_version(rc);
@@ -787,17 +813,24 @@ static void rrdcontext_dequeue_from_post_processing(RRDCONTEXT *rc) {
     dictionary_del(rc->rrdhost->rrdctx.pp_queue, string2str(rc->id));
 }
 
-static void rrdcontext_post_process_queued_contexts(RRDHOST *host) {
-    if(unlikely(!host->rrdctx.pp_queue)) return;
+static size_t rrdcontext_post_process_queued_contexts(RRDHOST *host) {
+    if(unlikely(!host->rrdctx.pp_queue)) return 0;
+
+    size_t processed = 0;
 
+    // the queue is indexed by context id, so all the events of a context
+    // since the last iteration are coalesced into one post-processing
     RRDCONTEXT *rc;
     dfe_start_reentrant(host->rrdctx.pp_queue, rc) {
                 if(unlikely(!service_running(SERVICE_CONTEXT))) break;
 
                 rrdcontext_dequeue_from_post_processing(rc);
                 rrdcontext_post_process_updates(rc, false, RRD_FLAG_NONE, true);
+                processed++;
             }
     dfe_done(rc);
+
+    return processed;
 }
 
 // ----------------------------------------------------------------------------
@@ -813,17 +846,24 @@ static uint64_t rrdcontext_get_next_version(RRDCONTEXT *rc) {
 
 void rrdcontext_message_send_unsafe(RRDCONTEXT *rc, bool snapshot __maybe_unused, void *bundle __maybe_unused) {
 
-    // save it, so that we know the last version we sent to hub
-    rc->version = rc->hub.version = rrdcontext_get_next_version(rc);
-    rc->hub.id = string2str(rc->id);
-    rc->hub.title = string2str(rc->title);
-    rc->hub.units = string2str(rc->units);
-    rc->hub.family = string2str(rc->family);
-    rc->hub.chart_type = rrdset_type_name(rc->chart_type);
-    rc->hub.priority = rc->priority;
-    rc->hub.first_time_s = rc->first_time_s;
-    rc->hub.last_time_s = rrd_flag_is_collected(rc) ? 0 : rc->last_time_s;
-    rc->hub.deleted = rrd_flag_is_deleted(rc) ? true : false;
+    // snapshots include all the contexts, but only the ones that changed since the
+    // last time they were sent to hub need a new version and an update in SQL
+    bool changed = !snapshot || !rc->hub.version || rrd_flag_is_deleted(rc) ||
+                   check_if_cloud_version_changed_unsafe(rc, true);
+
+    if(changed) {
+        // save it, so that we know the last version we sent to hub
+        rc->version = rc->hub.version = rrdcontext_get_next_version(rc);
+        rc->hub.id = string2str(rc->id);
+        rc->hub.title = string2str(rc->title);
+        rc->hub.units = string2str(rc->units);
+        rc->hub.family = string2str(rc->family);
+        rc->hub.chart_type = rrdset_type_name(rc->chart_type);
+        rc->hub.priority = rc->priority;
+        rc->hub.first_time_s = rc->first_time_s;
+        rc->hub.last_time_s = rrd_flag_is_collected(rc) ? 0 : rc->last_time_s;
+        rc->hub.deleted = rrd_flag_is_deleted(rc) ? true : false;
+    }
 
     struct context_updated message = {
             .id = rc->hub.id,
@@ -847,6 +887,9 @@ void rrdcontext_message_send_unsafe(RRDCONTEXT *rc, bool snapshot __maybe_unused
             contexts_updated_add_ctx_update(bundle, &message);
     }
 
+    if(!changed)
+        return;
+
     // store it to SQL
 
     if(rrd_flag_is_deleted(rc))
@@ -958,6 +1001,19 @@ static void rrdcontext_dequeue_from_hub_queue(RRDCONTEXT *rc) {
     dictionary_del(rc->rrdhost->rrdctx.hub_queue, string2str(rc->id));
 }
 
+// approximate size of the message of a context in a bundle, used to split bundles by size
+static inline size_t rrdcontext_message_size_estimate(RRDCONTEXT *rc) {
+    return string_strlen(rc->id) + string_strlen(rc->title) + string_strlen(rc->units) + string_strlen(rc->family) + 64;
+}
+
+static void rrdcontext_send_bundle_to_hub(RRDHOST *host, contexts_updated_t bundle) {
+    // update the version hash
+    contexts_updated_update_version_hash(bundle, rrdcontext_version_hash(host));
+
+    // send it
+    aclk_send_contexts_updated(bundle);
+}
+
 static void rrdcontext_dispatch_queued_contexts_to_hub(RRDHOST *host, usec_t now_ut) {
 
     // check if we have received a streaming command for this host
@@ -968,19 +1024,19 @@ static void rrdcontext_dispatch_queued_contexts_to_hub(RRDHOST *host, usec_t now
     if(!dictionary_entries(host->rrdctx.hub_queue))
         return;
 
-    size_t messages_added = 0;
+    size_t messages_added = 0, bundle_messages = 0, bundle_bytes = 0;
     contexts_updated_t bundle = NULL;
+    CLAIM_ID claim_id = claim_id_get();
 
     RRDCONTEXT *rc;
     dfe_start_reentrant(host->rrdctx.hub_queue, rc) {
                 if(unlikely(!service_running(SERVICE_CONTEXT))) break;
 
-                if(unlikely(messages_added >= MESSAGES_PER_BUNDLE_TO_SEND_TO_HUB_PER_HOST))
+                if(unlikely(messages_added >= MESSAGES_PER_ITERATION_TO_SEND_TO_HUB_PER_HOST))
                     break;
 
                 worker_is_busy(WORKER_JOB_QUEUED);
                 usec_t dispatch_ut = rrdcontext_calculate_queued_dispatch_time_ut(rc, now_ut);
-                CLAIM_ID claim_id = claim_id_get();
 
                 if(unlikely(now_ut >= dispatch_ut) && claim_id_is_set(claim_id)) {
                     worker_is_busy(WORKER_JOB_CHECK);
@@ -990,6 +1046,14 @@ static void rrdcontext_dispatch_queued_contexts_to_hub(RRDHOST *host, usec_t now
                     if(check_if_cloud_version_changed_unsafe(rc, true)) {
                         worker_is_busy(WORKER_JOB_SEND);
 
+                        if(bundle && (bundle_messages >= MESSAGES_PER_BUNDLE_TO_SEND_TO_HUB_PER_HOST ||
+                                      bundle_bytes >= BYTES_PER_BUNDLE_TO_SEND_TO_HUB_PER_HOST)) {
+                            // the bundle is full, send it and start another one
+                            rrdcontext_send_bundle_to_hub(host, bundle);
+                            bundle = NULL;
+                            bundle_messages = bundle_bytes = 0;
+                        }
+
                         if(!bundle) {
                             // prepare the bundle to send the messages
                             char uuid_str[UUID_STR_LEN];
@@ -1001,6 +1065,8 @@ static void rrdcontext_dispatch_queued_contexts_to_hub(RRDHOST *host, usec_t now
                         // and save an update to SQL
                         rrdcontext_message_send_unsafe(rc, false, bundle);
                         messages_added++;
+                        bundle_messages++;
+                        bundle_bytes += rrdcontext_message_size_estimate(rc);
 
                         rc->queue.dispatches++;
                         rc->queue.dequeued_ut = now_ut;
@@ -1038,12 +1104,7 @@ static void rrdcontext_dispatch_queued_contexts_to_hub(RRDHOST *host, usec_t now
 
     if(service_running(SERVICE_CONTEXT) && bundle) {
         // we have a bundle to send messages
-
-        // update the version hash
-        contexts_updated_update_version_hash(bundle, rrdcontext_version_hash(host));
-
-        // send it
-        aclk_send_contexts_updated(bundle);
+        rrdcontext_send_bundle_to_hub(host, bundle);
     }
     else if(bundle)
         contexts_updated_delete(bundle);
@@ -1051,23 +1112,31 @@ static void rrdcontext_dispatch_queued_contexts_to_hub(RRDHOST *host, usec_t now
 }
 
 // ----------------------------------------------------------------------------
-// worker thread
-
-static void rrdcontext_main_cleanup(void *pptr) {
-    struct netdata_static_thread *static_thread = CLEANUP_FUNCTION_GET_PTR(pptr);
-    if(!static_thread) return;
-
-    static_thread->enabled = NETDATA_MAIN_THREAD_EXITING;
-
-    // custom code
-    worker_unregister();
+// worker threads
+//
+// The hosts are partitioned among the workers by their machine guid, so that
+// each host is always processed by the same worker, and the queues of a host
+// are never processed by two workers concurrently. The main thread is worker 0
+// and watches for database rotations on behalf of all of them.
+
+#define RRDCONTEXT_WORKERS_MAX 16
+
+static struct {
+    size_t workers;                 // including the main thread
+    ND_THREAD **threads;            // the workers beyond the main thread
+    uint32_t db_rotations;          // incremented by the main thread on database rotations
+} rrdcontext_workers = {
+    .workers = 1,
+};
+
+static inline bool rrdcontext_host_is_ours(RRDHOST *host, size_t worker) {
+    if(rrdcontext_workers.workers <= 1)
+        return true;
 
-    static_thread->enabled = NETDATA_MAIN_THREAD_EXITED;
+    return simple_hash(host->machine_guid) % rrdcontext_workers.workers == worker;
 }
 
-void *rrdcontext_main(void *ptr) {
-    CLEANUP_FUNCTION_REGISTER(rrdcontext_main_cleanup) cleanup_ptr = ptr;
-
+static void rrdcontext_worker_register(void) {
     worker_register("RRDCONTEXT");
     worker_register_job_name(WORKER_JOB_HOSTS, "hosts");
     worker_register_job_name(WORKER_JOB_CHECK, "dedup checks");
@@ -1080,9 +1149,66 @@ void *rrdcontext_main(void *ptr) {
     worker_register_job_name(WORKER_JOB_PP_METRIC, "check metrics");
     worker_register_job_name(WORKER_JOB_PP_INSTANCE, "check instances");
     worker_register_job_name(WORKER_JOB_PP_CONTEXT, "check contexts");
+    worker_register_job_name(WORKER_JOB_SNAPSHOT, "snapshots");
 
     worker_register_job_custom_metric(WORKER_JOB_HUB_QUEUE_SIZE, "hub queue size", "contexts", WORKER_METRIC_ABSOLUTE);
     worker_register_job_custom_metric(WORKER_JOB_PP_QUEUE_SIZE, "post processing queue size", "contexts", WORKER_METRIC_ABSOLUTE);
+}
+
+static void rrdcontext_worker_host(RRDHOST *host, usec_t now_ut, size_t *hub_queued, size_t *pp_queued) {
+    worker_is_busy(WORKER_JOB_HOSTS);
+
+    size_t processed = 0;
+    if(host->rrdctx.pp_queue) {
+        *pp_queued += dictionary_entries(host->rrdctx.pp_queue);
+        processed = rrdcontext_post_process_queued_contexts(host);
+        dictionary_garbage_collect(host->rrdctx.pp_queue);
+    }
+
+    if(host->rrdctx.hub_queue) {
+        *hub_queued += dictionary_entries(host->rrdctx.hub_queue);
+        rrdcontext_dispatch_queued_contexts_to_hub(host, now_ut);
+        dictionary_garbage_collect(host->rrdctx.hub_queue);
+    }
+
+    if (!host->rrdctx.contexts)
+        return;
+
+    dictionary_garbage_collect(host->rrdctx.contexts);
+
+    time_t snapshot_every_s = rrdcontext_snapshot_every_s();
+    if(snapshot_every_s && !rrdhost_flag_check(host, RRDHOST_FLAG_PENDING_CONTEXT_LOAD)) {
+        time_t now_s = (time_t)(now_ut / USEC_PER_SEC);
+        if(!host->rrdctx.snapshot_next_s)
+            host->rrdctx.snapshot_next_s = now_s + snapshot_every_s;
+        else if(now_s >= host->rrdctx.snapshot_next_s) {
+            worker_is_busy(WORKER_JOB_SNAPSHOT);
+            rrdcontext_snapshot_save(host);
+            host->rrdctx.snapshot_next_s = now_s + snapshot_every_s;
+        }
+    }
+
+    // the number of metrics and instances of the host change only when
+    // contexts are post-processed, added or deleted
+    size_t version = dictionary_version(host->rrdctx.contexts);
+    if(!processed && version == host->rrdctx.contexts_version)
+        return;
+
+    // calculate the number of metrics and instances in the host
+    RRDCONTEXT *rc;
+    uint32_t metrics = 0, instances = 0;
+    dfe_start_read(host->rrdctx.contexts, rc) {
+        metrics += rc->stats.metrics;
+        instances += dictionary_entries(rc->rrdinstances);
+    }
+    dfe_done(rc);
+    host->rrdctx.metrics = metrics;
+    host->rrdctx.instances = instances;
+    host->rrdctx.contexts_version = version;
+}
+
+static void rrdcontext_worker_loop(size_t worker) {
+    uint32_t db_rotations = __atomic_load_n(&rrdcontext_workers.db_rotations, __ATOMIC_RELAXED);
 
     heartbeat_t hb;
     heartbeat_init(&hb);
@@ -1096,10 +1222,16 @@ void *rrdcontext_main(void *ptr) {
 
         usec_t now_ut = now_realtime_usec();
 
-        if(rrdcontext_next_db_rotation_ut && now_ut > rrdcontext_next_db_rotation_ut) {
-            rrdcontext_recalculate_retention_all_hosts();
-            rrdcontext_garbage_collect_for_all_hosts();
+        if(worker == 0 && rrdcontext_next_db_rotation_ut && now_ut > rrdcontext_next_db_rotation_ut) {
             rrdcontext_next_db_rotation_ut = 0;
+            __atomic_add_fetch(&rrdcontext_workers.db_rotations, 1, __ATOMIC_RELAXED);
+        }
+
+        uint32_t rotations = __atomic_load_n(&rrdcontext_workers.db_rotations, __ATOMIC_RELAXED);
+        if(rotations != db_rotations) {
+            db_rotations = rotations;
+            rrdcontext_recalculate_retention_of_worker_hosts(worker);
+            rrdcontext_garbage_collect_worker_hosts(worker);
         }
 
         size_t hub_queued_contexts_for_all_hosts = 0;
@@ -1109,39 +1241,70 @@ void *rrdcontext_main(void *ptr) {
         dfe_start_reentrant(rrdhost_root_index, host) {
             if(unlikely(!service_running(SERVICE_CONTEXT))) break;
 
-            worker_is_busy(WORKER_JOB_HOSTS);
-
-            if(host->rrdctx.pp_queue) {
-                pp_queued_contexts_for_all_hosts += dictionary_entries(host->rrdctx.pp_queue);
-                rrdcontext_post_process_queued_contexts(host);
-                dictionary_garbage_collect(host->rrdctx.pp_queue);
-            }
-
-            if(host->rrdctx.hub_queue) {
-                hub_queued_contexts_for_all_hosts += dictionary_entries(host->rrdctx.hub_queue);
-                rrdcontext_dispatch_queued_contexts_to_hub(host, now_ut);
-                dictionary_garbage_collect(host->rrdctx.hub_queue);
-            }
-
-            if (host->rrdctx.contexts)
-                dictionary_garbage_collect(host->rrdctx.contexts);
+            if(!rrdcontext_host_is_ours(host, worker))
+                continue;
 
-            // calculate the number of metrics and instances in the host
-            RRDCONTEXT *rc;
-            uint32_t metrics = 0, instances = 0;
-            dfe_start_read(host->rrdctx.contexts, rc) {
-                metrics += rc->stats.metrics;
-                instances += dictionary_entries(rc->rrdinstances);
-            }
-            dfe_done(rc);
-            host->rrdctx.metrics = metrics;
-            host->rrdctx.instances = instances;
+            rrdcontext_worker_host(host, now_ut, &hub_queued_contexts_for_all_hosts, &pp_queued_contexts_for_all_hosts);
         }
         dfe_done(host);
 
         worker_set_metric(WORKER_JOB_HUB_QUEUE_SIZE, (NETDATA_DOUBLE)hub_queued_contexts_for_all_hosts);
         worker_set_metric(WORKER_JOB_PP_QUEUE_SIZE, (NETDATA_DOUBLE)pp_queued_contexts_for_all_hosts);
     }
+}
+
+static void *rrdcontext_worker_thread(void *ptr) {
+    rrdcontext_worker_register();
+    rrdcontext_worker_loop((size_t)(uintptr_t)ptr);
+    worker_unregister();
+    return NULL;
+}
+
+static void rrdcontext_main_cleanup(void *pptr) {
+    struct netdata_static_thread *static_thread = CLEANUP_FUNCTION_GET_PTR(pptr);
+    if(!static_thread) return;
+
+    static_thread->enabled = NETDATA_MAIN_THREAD_EXITING;
+
+    // custom code
+    for(size_t i = 1; i < rrdcontext_workers.workers ; i++)
+        nd_thread_join(rrdcontext_workers.threads[i - 1]);
+
+    freez(rrdcontext_workers.threads);
+    rrdcontext_workers.threads = NULL;
+
+    worker_unregister();
+
+    static_thread->enabled = NETDATA_MAIN_THREAD_EXITED;
+}
+
+void *rrdcontext_main(void *ptr) {
+    long workers = (long)get_netdata_cpus() / 4;
+    if(workers < 1) workers = 1;
+    if(workers > RRDCONTEXT_WORKERS_MAX) workers = RRDCONTEXT_WORKERS_MAX;
+
+    workers = config_get_number(CONFIG_SECTION_DB, "context worker threads", workers);
+    if(workers < 1 || workers > RRDCONTEXT_WORKERS_MAX) {
+        netdata_log_error("RRDCONTEXT: context worker threads given %ld is invalid, resetting to 1", workers);
+        workers = 1;
+    }
+
+    rrdcontext_workers.workers = (size_t)workers;
+    if(rrdcontext_workers.workers > 1) {
+        rrdcontext_workers.threads = callocz(rrdcontext_workers.workers - 1, sizeof(ND_THREAD *));
+
+        for(size_t i = 1; i < rrdcontext_workers.workers ; i++) {
+            char tag[NETDATA_THREAD_TAG_MAX + 1];
+            snprintfz(tag, NETDATA_THREAD_TAG_MAX, "RRDCTX[%zu]", i + 1);
+            rrdcontext_workers.threads[i - 1] = nd_thread_create(tag, NETDATA_THREAD_OPTION_JOINABLE,
+                                                                 rrdcontext_worker_thread, (void *)(uintptr_t)i);
+        }
+    }
+
+    CLEANUP_FUNCTION_REGISTER(rrdcontext_main_cleanup) cleanup_ptr = ptr;
+
+    rrdcontext_worker_register();
+    rrdcontext_worker_loop(0);
 
     return NULL;
 }
@@ -20,6 +20,10 @@ typedef int32_t REFCOUNT;
 // to use ARAL uncomment the following line:
 #define PGC_WITH_ARAL 1
 
+// with the 2Q eviction policy, the probation queue is evicted first
+// while it is above this percentage of the clean pages of its partition
+#define PGC_2Q_PROBATION_PER100 25
+
 typedef enum __attribute__ ((__packed__)) {
     // mutually exclusive flags
     PGC_PAGE_CLEAN                       = (1 << 0), // none of the following
@@ -31,6 +35,7 @@ typedef enum __attribute__ ((__packed__)) {
     PGC_PAGE_IS_BEING_MIGRATED_TO_V2     = (1 << 4),
     PGC_PAGE_HAS_NO_DATA_IGNORE_ACCESSES = (1 << 5),
     PGC_PAGE_HAS_BEEN_ACCESSED           = (1 << 6),
+    PGC_PAGE_IN_PROBATION                = (1 << 7), // a clean page in the probation queue of the 2Q eviction policy
 } PGC_PAGE_FLAGS;
 
 #define page_flag_check(page, flag) (__atomic_load_n(&((page)->flags), __ATOMIC_ACQUIRE) & (flag))
@@ -74,6 +79,12 @@ struct pgc_linked_list {
         PGC_PAGE *base;
         Pvoid_t sections_judy;
     };
+
+    // clean queues only - everything below is protected by the spinlock
+    PGC_PAGE *probation;            // pages that have not been accessed since they became clean (2Q policy)
+    size_t probation_size;          // the size of the pages in the probation queue
+    size_t size;                    // the size of all the pages in this queue
+
     PGC_PAGE_FLAGS flags;
     size_t version;
     size_t last_version_checked;
@@ -88,6 +99,7 @@ struct pgc {
         size_t partitions;
         size_t clean_size;
         size_t max_dirty_pages_per_call;
+        size_t max_dirty_size;          // above this, incomplete sets of dirty pages are flushed too (0 = unbounded)
         size_t max_pages_per_inline_eviction;
         size_t max_skip_pages_per_inline_eviction;
         size_t max_flushes_inline;
@@ -97,6 +109,7 @@ struct pgc {
         save_dirty_page_callback pgc_save_dirty_cb;
         save_dirty_init_callback pgc_save_init_cb;
         PGC_OPTIONS options;
+        PGC_EVICTION_POLICY eviction_policy;
 
         size_t severe_pressure_per1000;
         size_t aggressive_evict_per1000;
@@ -116,6 +129,9 @@ struct pgc {
         RW_SPINLOCK rw_spinlock;
         Pvoid_t sections_judy;
         PGC_CACHE_LINE_PADDING(0);
+
+        struct pgc_linked_list clean;   // LRU is applied here to free memory from the cache (one per partition)
+        PGC_CACHE_LINE_PADDING(1);
     } *index;
 
     PGC_CACHE_LINE_PADDING(1);
@@ -127,7 +143,9 @@ struct pgc {
 
     PGC_CACHE_LINE_PADDING(2);
 
-    struct pgc_linked_list clean;       // LRU is applied here to free memory from the cache
+    struct {
+        size_t next;                    // the partition the next eviction round will start from
+    } evict;
 
     PGC_CACHE_LINE_PADDING(3);
 
@@ -212,17 +230,25 @@ static inline void pointer_del(PGC *cache __maybe_unused, PGC_PAGE *page __maybe
 
 static inline size_t pgc_indexing_partition(PGC *cache, Word_t metric_id) {
     static __thread Word_t last_metric_id = 0;
+    static __thread size_t last_partitions = 0;
     static __thread size_t last_partition = 0;
 
-    if(metric_id == last_metric_id || cache->config.partitions == 1)
+    if(unlikely(cache->config.partitions == 1))
+        return 0;
+
+    if(metric_id == last_metric_id && cache->config.partitions == last_partitions)
         return last_partition;
 
     last_metric_id = metric_id;
+    last_partitions = cache->config.partitions;
     last_partition = indexing_partition(metric_id, cache->config.partitions);
 
     return last_partition;
 }
 
+// the clean queue of the partition the page is indexed at
+#define pgc_clean_ll(cache, page) (&(cache)->index[pgc_indexing_partition(cache, (page)->metric_id)].clean)
+
 static inline void pgc_index_read_lock(PGC *cache, size_t partition) {
     rw_spinlock_read_lock(&cache->index[partition].rw_spinlock);
 }
@@ -297,11 +323,12 @@ static inline size_t cache_usage_per1000(PGC *cache, size_t *size_to_evict) {
                 wanted_cache_size = wanted_cache_size_cb;
         }
 
-        if (wanted_cache_size < hot + dirty + cache->config.clean_size)
-            wanted_cache_size = hot + dirty + cache->config.clean_size;
+        size_t clean_size = __atomic_load_n(&cache->config.clean_size, __ATOMIC_RELAXED);
+        if (wanted_cache_size < hot + dirty + clean_size)
+            wanted_cache_size = hot + dirty + clean_size;
     }
     else
-        wanted_cache_size = hot + dirty + cache->config.clean_size;
+        wanted_cache_size = hot + dirty + __atomic_load_n(&cache->config.clean_size, __ATOMIC_RELAXED);
 
     // protection again huge queries
     // if huge queries are running, or huge amounts need to be saved
@@ -381,6 +408,14 @@ static inline bool flushing_critical(PGC *cache) {
     return false;
 }
 
+// when the dirty pages exceed their bound, we do not wait for each section
+// to collect a full set of pages - we flush whatever it has, so that the
+// work left for shutdown stays bounded
+static inline bool dirty_above_bound(PGC *cache) {
+    size_t max_dirty_size = __atomic_load_n(&cache->config.max_dirty_size, __ATOMIC_RELAXED);
+    return max_dirty_size && __atomic_load_n(&cache->dirty.stats->size, __ATOMIC_RELAXED) > max_dirty_size;
+}
+
 // ----------------------------------------------------------------------------
 // helpers
 
@@ -495,14 +530,24 @@ static void pgc_ll_add(PGC *cache __maybe_unused, struct pgc_linked_list *ll, PG
         // CLEAN pages end up here.
         // - New pages created as CLEAN, always have 1 access.
         // - DIRTY pages made CLEAN, depending on their accesses may be appended (accesses > 0) or prepended (accesses = 0).
-
-        if(page->accesses || page_flag_check(page, PGC_PAGE_HAS_BEEN_ACCESSED | PGC_PAGE_HAS_NO_DATA_IGNORE_ACCESSES) == PGC_PAGE_HAS_BEEN_ACCESSED) {
+        // - With the 2Q policy, pages with up to 1 access enter the probation queue, so that
+        //   big queries reading old data once, do not push the working set out of the cache.
+
+        if(cache->config.eviction_policy == PGC_EVICTION_2Q &&
+            page->accesses <= 1 &&
+            !page_flag_check(page, PGC_PAGE_HAS_BEEN_ACCESSED)) {
+            DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(ll->probation, page, link.prev, link.next);
+            ll->probation_size += page->assumed_size;
+            page_flag_set(page, PGC_PAGE_IN_PROBATION);
+        }
+        else if(page->accesses || page_flag_check(page, PGC_PAGE_HAS_BEEN_ACCESSED | PGC_PAGE_HAS_NO_DATA_IGNORE_ACCESSES) == PGC_PAGE_HAS_BEEN_ACCESSED) {
             DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(ll->base, page, link.prev, link.next);
             page_flag_clear(page, PGC_PAGE_HAS_BEEN_ACCESSED);
         }
         else
             DOUBLE_LINKED_LIST_PREPEND_ITEM_UNSAFE(ll->base, page, link.prev, link.next);
 
+        ll->size += page->assumed_size;
         ll->version++;
     }
 
@@ -562,7 +607,15 @@ static void pgc_ll_del(PGC *cache __maybe_unused, struct pgc_linked_list *ll, PG
         }
     }
     else {
-        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(ll->base, page, link.prev, link.next);
+        if(page_flag_check(page, PGC_PAGE_IN_PROBATION)) {
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(ll->probation, page, link.prev, link.next);
+            ll->probation_size -= page->assumed_size;
+            page_flag_clear(page, PGC_PAGE_IN_PROBATION);
+        }
+        else
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(ll->base, page, link.prev, link.next);
+
+        ll->size -= page->assumed_size;
         ll->version++;
     }
 
@@ -577,11 +630,22 @@ static inline void page_has_been_accessed(PGC *cache, PGC_PAGE *page) {
         __atomic_add_fetch(&page->accesses, 1, __ATOMIC_RELAXED);
 
         if (flags & PGC_PAGE_CLEAN) {
-            if(pgc_ll_trylock(cache, &cache->clean)) {
-                DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(cache->clean.base, page, link.prev, link.next);
-                DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(cache->clean.base, page, link.prev, link.next);
-                pgc_ll_unlock(cache, &cache->clean);
-                page_flag_clear(page, PGC_PAGE_HAS_BEEN_ACCESSED);
+            struct pgc_linked_list *clean = pgc_clean_ll(cache, page);
+
+            if(page_flag_check(page, PGC_PAGE_IN_PROBATION))
+                // pages in probation are promoted lazily, by the evictor
+                page_flag_set(page, PGC_PAGE_HAS_BEEN_ACCESSED);
+
+            else if(pgc_ll_trylock(cache, clean)) {
+                if(page_flag_check(page, PGC_PAGE_CLEAN | PGC_PAGE_IN_PROBATION) == PGC_PAGE_CLEAN) {
+                    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(clean->base, page, link.prev, link.next);
+                    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(clean->base, page, link.prev, link.next);
+                    page_flag_clear(page, PGC_PAGE_HAS_BEEN_ACCESSED);
+                }
+                else
+                    page_flag_set(page, PGC_PAGE_HAS_BEEN_ACCESSED);
+
+                pgc_ll_unlock(cache, clean);
             }
             else
                 page_flag_set(page, PGC_PAGE_HAS_BEEN_ACCESSED);
@@ -612,7 +676,7 @@ static inline void page_set_clean(PGC *cache, PGC_PAGE *page, bool having_transi
         pgc_ll_del(cache, &cache->dirty, page, false);
 
     // first add to linked list, the set the flag (required for move_page_last())
-    pgc_ll_add(cache, &cache->clean, page, having_clean_lock);
+    pgc_ll_add(cache, pgc_clean_ll(cache, page), page, having_clean_lock);
 
     if(!having_transition_lock)
         page_transition_unlock(cache, page);
@@ -649,7 +713,7 @@ static inline void page_set_dirty(PGC *cache, PGC_PAGE *page, bool having_hot_lo
         pgc_ll_unlock(cache, &cache->hot);
 
     if(unlikely(flags & PGC_PAGE_CLEAN))
-        pgc_ll_del(cache, &cache->clean, page, false);
+        pgc_ll_del(cache, pgc_clean_ll(cache, page), page, false);
 
     // first add to linked list, the set the flag (required for move_page_last())
     pgc_ll_add(cache, &cache->dirty, page, false);
@@ -674,7 +738,7 @@ static inline void page_set_hot(PGC *cache, PGC_PAGE *page) {
         pgc_ll_del(cache, &cache->dirty, page, false);
 
     if(flags & PGC_PAGE_CLEAN)
-        pgc_ll_del(cache, &cache->clean, page, false);
+        pgc_ll_del(cache, pgc_clean_ll(cache, page), page, false);
 
     // first add to linked list, the set the flag (required for move_page_last())
     pgc_ll_add(cache, &cache->hot, page, false);
@@ -947,21 +1011,23 @@ static inline void remove_and_free_page_not_in_any_queue_and_acquired_for_deleti
 static inline bool make_acquired_page_clean_and_evict_or_page_release(PGC *cache, PGC_PAGE *page) {
     pointer_check(cache, page);
 
+    struct pgc_linked_list *clean = pgc_clean_ll(cache, page);
+
     page_transition_lock(cache, page);
-    pgc_ll_lock(cache, &cache->clean);
+    pgc_ll_lock(cache, clean);
 
     // make it clean - it does not have any accesses, so it will be prepended
     page_set_clean(cache, page, true, true);
 
     if(!acquired_page_get_for_deletion_or_release_it(cache, page)) {
-        pgc_ll_unlock(cache, &cache->clean);
+        pgc_ll_unlock(cache, clean);
         page_transition_unlock(cache, page);
         return false;
     }
 
     // remove it from the linked list
-    pgc_ll_del(cache, &cache->clean, page, true);
-    pgc_ll_unlock(cache, &cache->clean);
+    pgc_ll_del(cache, clean, page, true);
+    pgc_ll_unlock(cache, clean);
     page_transition_unlock(cache, page);
 
     remove_and_free_page_not_in_any_queue_and_acquired_for_deletion(cache, page);
@@ -983,7 +1049,7 @@ static bool evict_pages_with_filter(PGC *cache, size_t max_skip, size_t max_evic
         return false;
     }
 
-    internal_fatal(cache->clean.linked_list_in_sections_judy,
+    internal_fatal(cache->index[0].clean.linked_list_in_sections_judy,
                    "wrong clean pages configuration - clean pages need to have a linked list, not a judy array");
 
     if(unlikely(!max_skip))
@@ -1001,6 +1067,12 @@ static bool evict_pages_with_filter(PGC *cache, size_t max_skip, size_t max_evic
     bool stopped_before_finishing = false;
     size_t spins = 0;
 
+    // each partition has its own clean queue, so concurrent evictors
+    // start from different partitions and do not contend on the same lock
+    size_t partitions = cache->config.partitions;
+    size_t partition = __atomic_fetch_add(&cache->evict.next, 1, __ATOMIC_RELAXED) % partitions;
+    size_t partitions_without_pages = 0;
+
     do {
         if(++spins > 1)
             __atomic_add_fetch(&cache->stats.evict_spins, 1, __ATOMIC_RELAXED);
@@ -1029,133 +1101,136 @@ static bool evict_pages_with_filter(PGC *cache, size_t max_skip, size_t max_evic
             break;
         }
 
+        size_t this_partition = partition;
+        struct pgc_linked_list *clean = &cache->index[this_partition].clean;
+        partition = (partition + 1) % partitions;
+
         if(!all_of_them && !wait) {
-            if(!pgc_ll_trylock(cache, &cache->clean)) {
-                stopped_before_finishing = true;
-                goto premature_exit;
+            if(!pgc_ll_trylock(cache, clean)) {
+                // another thread is working on this partition, try the next one
+                if(++partitions_without_pages >= partitions) {
+                    stopped_before_finishing = true;
+                    goto premature_exit;
+                }
+
+                continue;
             }
 
             // at this point we have the clean lock
         }
         else
-            pgc_ll_lock(cache, &cache->clean);
+            pgc_ll_lock(cache, clean);
+
+        // decide the order the queues of this partition will be checked:
+        // with 2Q, the probation queue is evicted first, while it is above its target size
+        PGC_PAGE **queues[2];
+        size_t queues_count = 0;
+        if(clean->probation && (!clean->base || clean->probation_size * 100 >= clean->size * PGC_2Q_PROBATION_PER100)) {
+            queues[queues_count++] = &clean->probation;
+            queues[queues_count++] = &clean->base;
+        }
+        else {
+            queues[queues_count++] = &clean->base;
+            if(clean->probation)
+                queues[queues_count++] = &clean->probation;
+        }
 
         // find a page to evict
         PGC_PAGE *pages_to_evict = NULL;
         size_t pages_to_evict_size = 0;
-        for(PGC_PAGE *page = cache->clean.base, *next = NULL, *first_page_we_relocated = NULL; page ; page = next) {
-            next = page->link.next;
+        for(size_t q = 0; q < queues_count && !stopped_before_finishing ; q++) {
+            PGC_PAGE **queue = queues[q];
+            bool probation = (queue == &clean->probation);
 
-            if(unlikely(page == first_page_we_relocated))
-                // we did a complete loop on all pages
+            if(pages_to_evict && !all_of_them && (!batch || pages_to_evict_size >= max_size_to_evict))
                 break;
 
-            if(unlikely(page_flag_check(page, PGC_PAGE_HAS_BEEN_ACCESSED | PGC_PAGE_HAS_NO_DATA_IGNORE_ACCESSES) == PGC_PAGE_HAS_BEEN_ACCESSED)) {
-                DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(cache->clean.base, page, link.prev, link.next);
-                DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(cache->clean.base, page, link.prev, link.next);
-                page_flag_clear(page, PGC_PAGE_HAS_BEEN_ACCESSED);
-                continue;
-            }
+            for(PGC_PAGE *page = *queue, *next = NULL, *first_page_we_relocated = NULL; page ; page = next) {
+                next = page->link.next;
 
-            if(unlikely(filter && !filter(page, data)))
-                continue;
-
-            if(non_acquired_page_get_for_deletion___while_having_clean_locked(cache, page)) {
-                // we can delete this page
-
-                // remove it from the clean list
-                pgc_ll_del(cache, &cache->clean, page, true);
-
-                __atomic_add_fetch(&cache->stats.evicting_entries, 1, __ATOMIC_RELAXED);
-                __atomic_add_fetch(&cache->stats.evicting_size, page->assumed_size, __ATOMIC_RELAXED);
+                if(unlikely(page == first_page_we_relocated))
+                    // we did a complete loop on all pages
+                    break;
 
-                DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(pages_to_evict, page, link.prev, link.next);
+                if(unlikely(page_flag_check(page, PGC_PAGE_HAS_BEEN_ACCESSED | PGC_PAGE_HAS_NO_DATA_IGNORE_ACCESSES) == PGC_PAGE_HAS_BEEN_ACCESSED)) {
+                    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*queue, page, link.prev, link.next);
 
-                pages_to_evict_size += page->assumed_size;
+                    if(probation) {
+                        // it has been accessed while in probation, promote it
+                        clean->probation_size -= page->assumed_size;
+                        page_flag_clear(page, PGC_PAGE_IN_PROBATION);
+                        __atomic_add_fetch(&cache->stats.evict_promotions, 1, __ATOMIC_RELAXED);
+                    }
 
-                if(unlikely(all_of_them || (batch && pages_to_evict_size < max_size_to_evict)))
-                    // get more pages
-                    ;
-                else
-                    // one page at a time
-                    break;
-            }
-            else {
-                // we can't delete this page
+                    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(clean->base, page, link.prev, link.next);
+                    page_flag_clear(page, PGC_PAGE_HAS_BEEN_ACCESSED);
+                    continue;
+                }
 
-                if(!first_page_we_relocated)
-                    first_page_we_relocated = page;
+                if(unlikely(filter && !filter(page, data)))
+                    continue;
 
-                DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(cache->clean.base, page, link.prev, link.next);
-                DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(cache->clean.base, page, link.prev, link.next);
+                if(non_acquired_page_get_for_deletion___while_having_clean_locked(cache, page)) {
+                    // we can delete this page
 
-                // check if we have to stop
-                if(unlikely(++total_pages_skipped >= max_skip && !all_of_them)) {
-                    stopped_before_finishing = true;
-                    break;
-                }
-            }
-        }
-        pgc_ll_unlock(cache, &cache->clean);
+                    // remove it from the clean list
+                    pgc_ll_del(cache, clean, page, true);
 
-        if(likely(pages_to_evict)) {
-            // remove them from the index
+                    __atomic_add_fetch(&cache->stats.evicting_entries, 1, __ATOMIC_RELAXED);
+                    __atomic_add_fetch(&cache->stats.evicting_size, page->assumed_size, __ATOMIC_RELAXED);
 
-            if(unlikely(pages_to_evict->link.next)) {
-                // we have many pages, let's minimize the index locks we are going to get
+                    if(probation)
+                        __atomic_add_fetch(&cache->stats.evict_from_probation, 1, __ATOMIC_RELAXED);
 
-                PGC_PAGE *pages_per_partition[cache->config.partitions];
-                memset(pages_per_partition, 0, sizeof(PGC_PAGE *) * cache->config.partitions);
+                    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(pages_to_evict, page, link.prev, link.next);
 
-                // sort them by partition
-                for (PGC_PAGE *page = pages_to_evict, *next = NULL; page; page = next) {
-                    next = page->link.next;
+                    pages_to_evict_size += page->assumed_size;
 
-                    size_t partition = pgc_indexing_partition(cache, page->metric_id);
-                    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(pages_to_evict, page, link.prev, link.next);
-                    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(pages_per_partition[partition], page, link.prev, link.next);
+                    if(unlikely(all_of_them || (batch && pages_to_evict_size < max_size_to_evict)))
+                        // get more pages
+                        ;
+                    else
+                        // one page at a time
+                        break;
                 }
+                else {
+                    // we can't delete this page
 
-                // remove them from the index
-                for (size_t partition = 0; partition < cache->config.partitions; partition++) {
-                    if (!pages_per_partition[partition]) continue;
-
-                    pgc_index_write_lock(cache, partition);
+                    if(!first_page_we_relocated)
+                        first_page_we_relocated = page;
 
-                    for (PGC_PAGE *page = pages_per_partition[partition]; page; page = page->link.next)
-                        remove_this_page_from_index_unsafe(cache, page, partition);
+                    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*queue, page, link.prev, link.next);
+                    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(*queue, page, link.prev, link.next);
 
-                    pgc_index_write_unlock(cache, partition);
+                    // check if we have to stop
+                    if(unlikely(++total_pages_skipped >= max_skip && !all_of_them)) {
+                        stopped_before_finishing = true;
+                        break;
+                    }
                 }
+            }
+        }
+        pgc_ll_unlock(cache, clean);
 
-                // free them
-                for (size_t partition = 0; partition < cache->config.partitions; partition++) {
-                    if (!pages_per_partition[partition]) continue;
+        if(likely(pages_to_evict)) {
+            partitions_without_pages = 0;
 
-                    for (PGC_PAGE *page = pages_per_partition[partition], *next = NULL; page; page = next) {
-                        next = page->link.next;
+            // all the pages of a clean queue belong to the same index partition,
+            // so a single index lock is enough to remove all of them
 
-                        size_t page_size = page->assumed_size;
-                        free_this_page(cache, page, partition);
+            pgc_index_write_lock(cache, this_partition);
 
-                        __atomic_sub_fetch(&cache->stats.evicting_entries, 1, __ATOMIC_RELAXED);
-                        __atomic_sub_fetch(&cache->stats.evicting_size, page_size, __ATOMIC_RELAXED);
+            for (PGC_PAGE *page = pages_to_evict; page; page = page->link.next)
+                remove_this_page_from_index_unsafe(cache, page, this_partition);
 
-                        total_pages_evicted++;
-                    }
-                }
-            }
-            else {
-                // just one page to be evicted
-                PGC_PAGE *page = pages_to_evict;
+            pgc_index_write_unlock(cache, this_partition);
 
-                size_t page_size = page->assumed_size;
+            // free them
+            for (PGC_PAGE *page = pages_to_evict, *next = NULL; page; page = next) {
+                next = page->link.next;
 
-                size_t partition = pgc_indexing_partition(cache, page->metric_id);
-                pgc_index_write_lock(cache, partition);
-                remove_this_page_from_index_unsafe(cache, page, partition);
-                pgc_index_write_unlock(cache, partition);
-                free_this_page(cache, page, partition);
+                size_t page_size = page->assumed_size;
+                free_this_page(cache, page, this_partition);
 
                 __atomic_sub_fetch(&cache->stats.evicting_entries, 1, __ATOMIC_RELAXED);
                 __atomic_sub_fetch(&cache->stats.evicting_size, page_size, __ATOMIC_RELAXED);
@@ -1163,20 +1238,20 @@ static bool evict_pages_with_filter(PGC *cache, size_t max_skip, size_t max_evic
                 total_pages_evicted++;
             }
         }
-        else
+        else if(++partitions_without_pages >= partitions)
+            // we checked all partitions and found nothing to evict
             break;
 
     } while(all_of_them || (total_pages_evicted < max_evict && total_pages_skipped < max_skip));
 
     if(all_of_them && !filter) {
-        pgc_ll_lock(cache, &cache->clean);
-        if(cache->clean.stats->entries) {
+        size_t entries = __atomic_load_n(&cache->stats.queues.clean.entries, __ATOMIC_RELAXED);
+        if(entries) {
             nd_log_limit_static_global_var(erl, 1, 0);
             nd_log_limit(&erl, NDLS_DAEMON, NDLP_NOTICE,
                          "DBENGINE CACHE: cannot free all clean pages, %zu are still in the clean queue",
-                         cache->clean.stats->entries);
+                         entries);
         }
-        pgc_ll_unlock(cache, &cache->clean);
     }
 
 premature_exit:
@@ -1324,31 +1399,8 @@ static PGC_PAGE *page_add(PGC *cache, PGC_ENTRY *entry, bool *added) {
     return page;
 }
 
-static PGC_PAGE *page_find_and_acquire_once(PGC *cache, Word_t section, Word_t metric_id, time_t start_time_s, PGC_SEARCH method, bool *retry) {
-    *retry = false;
-
+static PGC_PAGE *page_search_in_metric_pages(Pvoid_t *pages_judy_pptr, time_t start_time_s, PGC_SEARCH method) {
     PGC_PAGE *page = NULL;
-    size_t partition = pgc_indexing_partition(cache, metric_id);
-
-    pgc_index_read_lock(cache, partition);
-
-    Pvoid_t *metrics_judy_pptr = JudyLGet(cache->index[partition].sections_judy, section, PJE0);
-    if(unlikely(metrics_judy_pptr == PJERR))
-        fatal("DBENGINE CACHE: corrupted sections judy array");
-
-    if(unlikely(!metrics_judy_pptr)) {
-        // section does not exist
-        goto cleanup;
-    }
-
-    Pvoid_t *pages_judy_pptr = JudyLGet(*metrics_judy_pptr, metric_id, PJE0);
-    if(unlikely(pages_judy_pptr == PJERR))
-        fatal("DBENGINE CACHE: corrupted pages judy array");
-
-    if(unlikely(!pages_judy_pptr)) {
-        // metric does not exist
-        goto cleanup;
-    }
 
     switch(method) {
         default:
@@ -1443,6 +1495,41 @@ static PGC_PAGE *page_find_and_acquire_once(PGC *cache, Word_t section, Word_t m
         break;
     }
 
+    return page;
+}
+
+// the caller has to hold the index lock of the partition
+static Pvoid_t *metric_pages_judy_get_unsafe(PGC *cache, size_t partition, Word_t section, Word_t metric_id) {
+    Pvoid_t *metrics_judy_pptr = JudyLGet(cache->index[partition].sections_judy, section, PJE0);
+    if(unlikely(metrics_judy_pptr == PJERR))
+        fatal("DBENGINE CACHE: corrupted sections judy array");
+
+    if(unlikely(!metrics_judy_pptr))
+        // section does not exist
+        return NULL;
+
+    Pvoid_t *pages_judy_pptr = JudyLGet(*metrics_judy_pptr, metric_id, PJE0);
+    if(unlikely(pages_judy_pptr == PJERR))
+        fatal("DBENGINE CACHE: corrupted pages judy array");
+
+    // NULL when the metric does not exist
+    return pages_judy_pptr;
+}
+
+static PGC_PAGE *page_find_and_acquire_once(PGC *cache, Word_t section, Word_t metric_id, time_t start_time_s, PGC_SEARCH method, bool *retry) {
+    *retry = false;
+
+    PGC_PAGE *page = NULL;
+    size_t partition = pgc_indexing_partition(cache, metric_id);
+
+    pgc_index_read_lock(cache, partition);
+
+    Pvoid_t *pages_judy_pptr = metric_pages_judy_get_unsafe(cache, partition, section, metric_id);
+    if(unlikely(!pages_judy_pptr))
+        goto cleanup;
+
+    page = page_search_in_metric_pages(pages_judy_pptr, start_time_s, method);
+
     if(page) {
         pointer_check(cache, page);
 
@@ -1507,7 +1594,8 @@ static bool flush_pages(PGC *cache, size_t max_flushes, Word_t section, bool wai
 
     size_t optimal_flush_size = cache->config.max_dirty_pages_per_call;
     size_t dirty_version_at_entry = cache->dirty.version;
-    if(!all_of_them && (cache->dirty.stats->entries < optimal_flush_size || cache->dirty.last_version_checked == dirty_version_at_entry)) {
+    if(!all_of_them && !dirty_above_bound(cache) &&
+        (cache->dirty.stats->entries < optimal_flush_size || cache->dirty.last_version_checked == dirty_version_at_entry)) {
         pgc_ll_unlock(cache, &cache->dirty);
         return false;
     }
@@ -1531,7 +1619,8 @@ static bool flush_pages(PGC *cache, size_t max_flushes, Word_t section, bool wai
             break;
 
         struct section_pages *sp = *section_pages_pptr;
-        if(!all_of_them && sp->entries < optimal_flush_size)
+        bool incomplete_ok = all_of_them || dirty_above_bound(cache);
+        if(!incomplete_ok && sp->entries < optimal_flush_size)
             continue;
 
         if(!all_of_them && flushes_so_far > max_flushes) {
@@ -1590,7 +1679,7 @@ static bool flush_pages(PGC *cache, size_t max_flushes, Word_t section, bool wai
         }
 
         // do we have enough to save?
-        if(all_of_them || pages_added == optimal_flush_size) {
+        if(all_of_them || pages_added == optimal_flush_size || (incomplete_ok && pages_added)) {
             // we should do it
 
             for (size_t i = 0; i < pages_added; i++) {
@@ -1755,12 +1844,17 @@ PGC *pgc_create(const char *name,
 
     cache->index = callocz(cache->config.partitions, sizeof(struct pgc_index));
 
-    for(size_t part = 0; part < cache->config.partitions ; part++)
+    for(size_t part = 0; part < cache->config.partitions ; part++) {
         rw_spinlock_init(&cache->index[part].rw_spinlock);
 
+        spinlock_init(&cache->index[part].clean.spinlock);
+        cache->index[part].clean.flags = PGC_PAGE_CLEAN;
+        cache->index[part].clean.linked_list_in_sections_judy = false;
+        cache->index[part].clean.stats = &cache->stats.queues.clean;
+    }
+
     spinlock_init(&cache->hot.spinlock);
     spinlock_init(&cache->dirty.spinlock);
-    spinlock_init(&cache->clean.spinlock);
 
     cache->hot.flags = PGC_PAGE_HOT;
     cache->hot.linked_list_in_sections_judy = true;
@@ -1770,10 +1864,6 @@ PGC *pgc_create(const char *name,
     cache->dirty.linked_list_in_sections_judy = true;
     cache->dirty.stats = &cache->stats.queues.dirty;
 
-    cache->clean.flags = PGC_PAGE_CLEAN;
-    cache->clean.linked_list_in_sections_judy = false;
-    cache->clean.stats = &cache->stats.queues.clean;
-
     pgc_section_pages_static_aral_init();
 
 #ifdef PGC_WITH_ARAL
@@ -1788,6 +1878,10 @@ PGC *pgc_create(const char *name,
                 16384,
                 aral_statistics(pgc_section_pages_aral),
                 NULL, NULL, false, false);
+        aral_magazines_enable(cache->aral[part]);
+
+        if(cache->config.options & PGC_OPTIONS_HUGE_PAGES)
+            aral_huge_pages_enable(cache->aral[part]);
     }
 #endif
 
@@ -1796,6 +1890,38 @@ PGC *pgc_create(const char *name,
     return cache;
 }
 
+void pgc_set_dirty_max_size(PGC *cache, size_t max_dirty_size) {
+    __atomic_store_n(&cache->config.max_dirty_size, max_dirty_size, __ATOMIC_RELAXED);
+}
+
+void pgc_set_eviction_policy(PGC *cache, PGC_EVICTION_POLICY policy) {
+    // the probation queues are evicted with all policies,
+    // so changing the policy at runtime is safe
+    cache->config.eviction_policy = policy;
+}
+
+PGC_EVICTION_POLICY pgc_eviction_policy(PGC *cache) {
+    return cache->config.eviction_policy;
+}
+
+PGC_EVICTION_POLICY pgc_eviction_policy_id(const char *name) {
+    if(name && strcmp(name, "2q") == 0)
+        return PGC_EVICTION_2Q;
+
+    return PGC_EVICTION_LRU;
+}
+
+const char *pgc_eviction_policy_name(PGC_EVICTION_POLICY policy) {
+    switch(policy) {
+        case PGC_EVICTION_2Q:
+            return "2q";
+
+        default:
+        case PGC_EVICTION_LRU:
+            return "lru";
+    }
+}
+
 struct aral_statistics *pgc_aral_statistics(void) {
     return aral_statistics(pgc_section_pages_aral);
 }
@@ -1808,6 +1934,10 @@ size_t pgc_aral_overhead(void) {
     return aral_overhead(pgc_section_pages_aral);
 }
 
+size_t pgc_aral_huge_pages(void) {
+    return aral_huge_pages_from_stats(aral_statistics(pgc_section_pages_aral));
+}
+
 void pgc_flush_all_hot_and_dirty_pages(PGC *cache, Word_t section) {
     all_hot_pages_to_dirty(cache, section);
 
@@ -1979,6 +2109,18 @@ void pgc_reset_hot_max(PGC *cache) {
     evict_pages(cache, 0, 0, true, false);
 }
 
+// the evictions that follow a smaller clean size are left to the next eviction run
+void pgc_set_clean_size(PGC *cache, size_t clean_size) {
+    if(clean_size < 1 * 1024 * 1024)
+        clean_size = 1 * 1024 * 1024;
+
+    __atomic_store_n(&cache->config.clean_size, clean_size, __ATOMIC_RELAXED);
+}
+
+size_t pgc_get_clean_size(PGC *cache) {
+    return __atomic_load_n(&cache->config.clean_size, __ATOMIC_RELAXED);
+}
+
 void pgc_set_dynamic_target_cache_size_callback(PGC *cache, dynamic_target_cache_size_callback callback) {
     cache->config.dynamic_target_size_cb = callback;
 
@@ -2065,9 +2207,102 @@ PGC_PAGE *pgc_page_get_and_acquire(PGC *cache, Word_t section, Word_t metric_id,
     return page;
 }
 
+static size_t pages_find_and_acquire_range_once(PGC *cache, Word_t section, Word_t metric_id, time_t start_time_s, time_t end_time_s, PGC_SEARCH method, PGC_PAGE **pages, size_t max, bool *retry) {
+    *retry = false;
+
+    size_t used = 0;
+    size_t partition = pgc_indexing_partition(cache, metric_id);
+
+    pgc_index_read_lock(cache, partition);
+
+    Pvoid_t *pages_judy_pptr = metric_pages_judy_get_unsafe(cache, partition, section, metric_id);
+    if(unlikely(!pages_judy_pptr))
+        goto cleanup;
+
+    // the first page is returned as the single page searches return it,
+    // even if it is outside the window
+    PGC_PAGE *page = page_search_in_metric_pages(pages_judy_pptr, start_time_s, method);
+
+    while(page && used < max) {
+        pointer_check(cache, page);
+
+        if(!page_acquire(cache, page)) {
+            // this page is not good to use - stop here, the caller will search again
+            *retry = (used == 0);
+            break;
+        }
+
+        pages[used++] = page;
+
+        Word_t time = page->start_time_s;
+        Pvoid_t *page_ptr = JudyLNext(*pages_judy_pptr, &time, PJE0);
+        if(unlikely(page_ptr == PJERR))
+            fatal("DBENGINE CACHE: corrupted page in pages judy array");
+
+        page = page_ptr ? *page_ptr : NULL;
+        if(page && page->start_time_s > end_time_s)
+            page = NULL;
+    }
+
+cleanup:
+    pgc_index_read_unlock(cache, partition);
+    return used;
+}
+
+size_t pgc_pages_get_and_acquire_range(PGC *cache, Word_t section, Word_t metric_id, time_t start_time_s, time_t end_time_s, PGC_SEARCH method, PGC_PAGE **pages, size_t max) {
+    if(unlikely(!max))
+        return 0;
+
+    __atomic_add_fetch(&cache->stats.workers_search, 1, __ATOMIC_RELAXED);
+
+    size_t *stats_hit_ptr, *stats_miss_ptr;
+
+    if(method == PGC_SEARCH_CLOSEST) {
+        __atomic_add_fetch(&cache->stats.searches_closest, 1, __ATOMIC_RELAXED);
+        stats_hit_ptr = &cache->stats.searches_closest_hits;
+        stats_miss_ptr = &cache->stats.searches_closest_misses;
+    }
+    else {
+        __atomic_add_fetch(&cache->stats.searches_exact, 1, __ATOMIC_RELAXED);
+        stats_hit_ptr = &cache->stats.searches_exact_hits;
+        stats_miss_ptr = &cache->stats.searches_exact_misses;
+    }
+
+    size_t used;
+    while(1) {
+        bool retry = false;
+
+        used = pages_find_and_acquire_range_once(cache, section, metric_id, start_time_s, end_time_s, method, pages, max, &retry);
+
+        if(used || !retry)
+            break;
+
+        tinysleep();
+    }
+
+    if(used) {
+        // account them as the single page searches they replace
+        if(used > 1)
+            __atomic_add_fetch(method == PGC_SEARCH_CLOSEST ? &cache->stats.searches_closest : &cache->stats.searches_exact, used - 1, __ATOMIC_RELAXED);
+
+        __atomic_add_fetch(stats_hit_ptr, used, __ATOMIC_RELAXED);
+
+        for(size_t i = 0; i < used ; i++)
+            page_has_been_accessed(cache, pages[i]);
+    }
+    else
+        __atomic_add_fetch(stats_miss_ptr, 1, __ATOMIC_RELAXED);
+
+    __atomic_sub_fetch(&cache->stats.workers_search, 1, __ATOMIC_RELAXED);
+
+    return used;
+}
+
 struct pgc_statistics pgc_get_statistics(PGC *cache) {
     // FIXME - get the statistics atomically
-    return cache->stats;
+    struct pgc_statistics stats = cache->stats;
+    stats.eviction_policy = cache->config.eviction_policy;
+    return stats;
 }
 
 size_t pgc_hot_and_dirty_entries(PGC *cache) {
@@ -2275,13 +2510,35 @@ void pgc_open_evict_clean_pages_of_datafile(PGC *cache, struct rrdengine_datafil
     evict_pages_with_filter(cache, 0, 0, true, true, match_page_data, datafile);
 }
 
+struct section_and_metric {
+    Word_t section;
+    Word_t metric_id;
+};
+
+static bool match_page_section_and_metric(PGC_PAGE *page, void *data) {
+    struct section_and_metric *sm = data;
+    return (page->section == sm->section && page->metric_id == sm->metric_id);
+}
+
+void pgc_evict_clean_pages_of_metric(PGC *cache, Word_t section, Word_t metric_id) {
+    struct section_and_metric sm = {
+        .section = section,
+        .metric_id = metric_id,
+    };
+    evict_pages_with_filter(cache, 0, 0, true, true, match_page_section_and_metric, &sm);
+}
+
 size_t pgc_count_clean_pages_having_data_ptr(PGC *cache, Word_t section, void *ptr) {
     size_t found = 0;
 
-    pgc_ll_lock(cache, &cache->clean);
-    for(PGC_PAGE *page = cache->clean.base; page ;page = page->link.next)
-        found += (page->data == ptr && page->section == section) ? 1 : 0;
-    pgc_ll_unlock(cache, &cache->clean);
+    for(size_t partition = 0; partition < cache->config.partitions ; partition++) {
+        struct pgc_linked_list *clean = &cache->index[partition].clean;
+
+        pgc_ll_lock(cache, clean);
+        for(PGC_PAGE *page = clean->base; page ;page = page->link.next)
+            found += (page->data == ptr && page->section == section) ? 1 : 0;
+        pgc_ll_unlock(cache, clean);
+    }
 
     return found;
 }
@@ -2594,9 +2851,9 @@ void unittest_stress_test(void) {
         stats.dirty_added   = __atomic_load_n(&pgc_uts.cache->dirty.stats->added_entries, __ATOMIC_RELAXED);
         stats.dirty_deleted = __atomic_load_n(&pgc_uts.cache->dirty.stats->removed_entries, __ATOMIC_RELAXED);
 
-        stats.clean_entries = __atomic_load_n(&pgc_uts.cache->clean.stats->entries, __ATOMIC_RELAXED);
-        stats.clean_added   = __atomic_load_n(&pgc_uts.cache->clean.stats->added_entries, __ATOMIC_RELAXED);
-        stats.clean_deleted = __atomic_load_n(&pgc_uts.cache->clean.stats->removed_entries, __ATOMIC_RELAXED);
+        stats.clean_entries = __atomic_load_n(&pgc_uts.cache->stats.queues.clean.entries, __ATOMIC_RELAXED);
+        stats.clean_added   = __atomic_load_n(&pgc_uts.cache->stats.queues.clean.added_entries, __ATOMIC_RELAXED);
+        stats.clean_deleted = __atomic_load_n(&pgc_uts.cache->stats.queues.clean.removed_entries, __ATOMIC_RELAXED);
 
         stats.searches_exact = __atomic_load_n(&pgc_uts.cache->stats.searches_exact, __ATOMIC_RELAXED);
         stats.searches_exact_hits = __atomic_load_n(&pgc_uts.cache->stats.searches_exact_hits, __ATOMIC_RELAXED);
@@ -2742,6 +2999,32 @@ int pgc_unittest(void) {
     pgc_page_hot_set_end_time_s(cache, page3, 2001);
     pgc_page_hot_to_dirty_and_release(cache, page3, false);
 
+    // range searches
+    for(time_t t = 100; t < 500 ; t += 100) {
+        PGC_PAGE *page = pgc_page_add_and_acquire(cache, (PGC_ENTRY){
+                .section = 4,
+                .metric_id = 20,
+                .start_time_s = t,
+                .end_time_s = t + 99,
+                .size = 4096,
+                .data = NULL,
+                .hot = false,
+        }, NULL);
+        pgc_page_release(cache, page);
+    }
+
+    PGC_PAGE *range[10];
+    size_t found = pgc_pages_get_and_acquire_range(cache, 4, 20, 150, 250, PGC_SEARCH_CLOSEST, range, 10);
+    if(found != 2 || pgc_page_start_time_s(range[0]) != 100 || pgc_page_start_time_s(range[1]) != 200)
+        fatal("range search does not work");
+    for(size_t i = 0; i < found ; i++)
+        pgc_page_release(cache, range[i]);
+
+    found = pgc_pages_get_and_acquire_range(cache, 4, 20, 200, 1000, PGC_SEARCH_NEXT, range, 1);
+    if(found != 1 || pgc_page_start_time_s(range[0]) != 300)
+        fatal("range search does not stop at max pages");
+    pgc_page_release(cache, range[0]);
+
     pgc_destroy(cache);
 
 #ifdef PGC_STRESS_TEST
@@ -17,10 +17,16 @@ typedef enum __attribute__ ((__packed__)) {
     PGC_OPTIONS_EVICT_PAGES_INLINE = (1 << 0),
     PGC_OPTIONS_FLUSH_PAGES_INLINE = (1 << 1),
     PGC_OPTIONS_AUTOSCALE          = (1 << 2),
+    PGC_OPTIONS_HUGE_PAGES         = (1 << 3),  // allocate the pages from 2MiB huge pages
 } PGC_OPTIONS;
 
 #define PGC_OPTIONS_DEFAULT (PGC_OPTIONS_EVICT_PAGES_INLINE | PGC_OPTIONS_FLUSH_PAGES_INLINE | PGC_OPTIONS_AUTOSCALE)
 
+typedef enum __attribute__ ((__packed__)) {
+    PGC_EVICTION_LRU = 0,       // clean pages are evicted in least recently used order
+    PGC_EVICTION_2Q,            // pages accessed only once are evicted first (scan resistant)
+} PGC_EVICTION_POLICY;
+
 typedef struct pgc_entry {
     Word_t section;             // the section this belongs to
     Word_t metric_id;           // the metric this belongs to
@@ -58,6 +64,8 @@ struct pgc_queue_statistics {
 };
 
 struct pgc_statistics {
+    PGC_EVICTION_POLICY eviction_policy;    // the policy these statistics refer to
+
     size_t wanted_cache_size;
     size_t current_cache_size;
 
@@ -140,6 +148,8 @@ struct pgc_statistics {
     size_t workers_hot2dirty;
 
     size_t evict_skipped;
+    size_t evict_promotions;        // pages moved from the probation to the main clean queue (2Q)
+    size_t evict_from_probation;    // pages evicted from the probation clean queue (2Q)
     size_t hot_empty_pages_evicted_immediately;
     size_t hot_empty_pages_evicted_later;
 
@@ -206,6 +216,11 @@ typedef enum {
 
 PGC_PAGE *pgc_page_get_and_acquire(PGC *cache, Word_t section, Word_t metric_id, time_t start_time_s, PGC_SEARCH method);
 
+// acquire, with one index search, the page pgc_page_get_and_acquire() would return
+// and the pages following it that start up to end_time_s, up to max pages.
+// Returns the number of pages acquired into the array.
+size_t pgc_pages_get_and_acquire_range(PGC *cache, Word_t section, Word_t metric_id, time_t start_time_s, time_t end_time_s, PGC_SEARCH method, PGC_PAGE **pages, size_t max);
+
 // get information from an acquired page
 Word_t pgc_page_section(PGC_PAGE *page);
 Word_t pgc_page_metric(PGC_PAGE *page);
@@ -231,12 +246,25 @@ bool pgc_page_to_clean_evict_or_release(PGC *cache, PGC_PAGE *page);
 typedef void (*migrate_to_v2_callback)(Word_t section, unsigned datafile_fileno, uint8_t type, Pvoid_t JudyL_metrics, Pvoid_t JudyL_extents_pos, size_t count_of_unique_extents, size_t count_of_unique_metrics, size_t count_of_unique_pages, void *data);
 void pgc_open_cache_to_journal_v2(PGC *cache, Word_t section, unsigned datafile_fileno, uint8_t type, migrate_to_v2_callback cb, void *data);
 void pgc_open_evict_clean_pages_of_datafile(PGC *cache, struct rrdengine_datafile *datafile);
+void pgc_evict_clean_pages_of_metric(PGC *cache, Word_t section, Word_t metric_id);
 size_t pgc_count_clean_pages_having_data_ptr(PGC *cache, Word_t section, void *ptr);
 size_t pgc_count_hot_pages_having_data_ptr(PGC *cache, Word_t section, void *ptr);
 
 typedef size_t (*dynamic_target_cache_size_callback)(void);
 void pgc_set_dynamic_target_cache_size_callback(PGC *cache, dynamic_target_cache_size_callback callback);
 
+// the size of clean pages the cache keeps, on top of its hot and dirty pages
+void pgc_set_clean_size(PGC *cache, size_t clean_size);
+size_t pgc_get_clean_size(PGC *cache);
+
+// bound the dirty pages, by flushing incomplete extents when they are exceeded (0 = unbounded)
+void pgc_set_dirty_max_size(PGC *cache, size_t max_dirty_size);
+
+void pgc_set_eviction_policy(PGC *cache, PGC_EVICTION_POLICY policy);
+PGC_EVICTION_POLICY pgc_eviction_policy(PGC *cache);
+PGC_EVICTION_POLICY pgc_eviction_policy_id(const char *name);
+const char *pgc_eviction_policy_name(PGC_EVICTION_POLICY policy);
+
 // return true when there is more work to do
 bool pgc_evict_pages(PGC *cache, size_t max_skip, size_t max_evict);
 bool pgc_flush_pages(PGC *cache, size_t max_flushes);
@@ -247,5 +275,6 @@ size_t pgc_hot_and_dirty_entries(PGC *cache);
 struct aral_statistics *pgc_aral_statistics(void);
 size_t pgc_aral_structures(void);
 size_t pgc_aral_overhead(void);
+size_t pgc_aral_huge_pages(void);
 
 #endif // DBENGINE_CACHE_H
@@ -18,7 +18,7 @@ void datafile_list_delete_unsafe(struct rrdengine_instance *ctx, struct rrdengin
 }
 
 
-static struct rrdengine_datafile *datafile_alloc_and_init(struct rrdengine_instance *ctx, unsigned tier, unsigned fileno)
+struct rrdengine_datafile *datafile_alloc_and_init(struct rrdengine_instance *ctx, unsigned tier, unsigned fileno)
 {
     fatal_assert(tier == 1);
 
@@ -159,10 +159,21 @@ bool datafile_acquire_for_deletion(struct rrdengine_datafile *df, bool is_shutdo
     return can_be_deleted;
 }
 
+const char *datafile_directory(struct rrdengine_datafile *datafile)
+{
+    struct rrdengine_instance *ctx = datafile->ctx;
+
+    if(datafile->stripe && datafile->stripe <= ctx->config.stripes.count)
+        return ctx->config.stripes.paths[datafile->stripe - 1];
+
+    return ctx->config.dbfiles_path;
+}
+
 void generate_datafilepath(struct rrdengine_datafile *datafile, char *str, size_t maxlen)
 {
-    (void) snprintfz(str, maxlen - 1, "%s/" DATAFILE_PREFIX RRDENG_FILE_NUMBER_PRINT_TMPL DATAFILE_EXTENSION,
-                    datafile->ctx->config.dbfiles_path, datafile->tier, datafile->fileno);
+    (void) snprintfz(str, maxlen - 1, "%s/%s" DATAFILE_PREFIX RRDENG_FILE_NUMBER_PRINT_TMPL DATAFILE_EXTENSION,
+                    datafile_directory(datafile), datafile->compacting ? DATAFILE_COMPACTION_PREFIX : "",
+                    datafile->tier, datafile->fileno);
 }
 
 int close_data_file(struct rrdengine_datafile *datafile)
@@ -265,8 +276,12 @@ int create_data_file(struct rrdengine_datafile *datafile)
     }
     memset(superblock, 0, sizeof(*superblock));
     (void) strncpy(superblock->magic_number, RRDENG_DF_MAGIC, RRDENG_MAGIC_SZ);
-    (void) strncpy(superblock->version, RRDENG_DF_VER, RRDENG_VER_SZ);
+    datafile->checksum = dbengine_use_crc32c ? RRDENG_CHECKSUM_CRC32C : RRDENG_CHECKSUM_CRC32;
+    (void) strncpy(superblock->version,
+                   datafile->checksum == RRDENG_CHECKSUM_CRC32C ? RRDENG_DF_VER_CRC32C : RRDENG_DF_VER,
+                   RRDENG_VER_SZ);
     superblock->tier = 1;
+    superblock->compacted = datafile->compacted ? 1 : 0;
 
     iov = uv_buf_init((void *)superblock, sizeof(*superblock));
 
@@ -289,7 +304,71 @@ int create_data_file(struct rrdengine_datafile *datafile)
     return 0;
 }
 
-static int check_data_file_superblock(uv_file file)
+// the datafile has been uploaded to the object storage: its superblock is rewritten
+// as archived (keeping the size of the extents) and the rest of the file is truncated
+// the superblock is synced before truncating, so that a crash in between leaves a
+// datafile that is either complete or archived
+int datafile_mark_archived(struct rrdengine_datafile *datafile)
+{
+    struct rrdengine_instance *ctx = datafile->ctx;
+    struct rrdeng_df_sb *superblock = NULL;
+    uv_buf_t iov;
+    uv_fs_t req;
+    int ret;
+
+    ret = posix_memalign((void *)&superblock, RRDFILE_ALIGNMENT, sizeof(*superblock));
+    if (unlikely(ret)) {
+        fatal("DBENGINE: posix_memalign:%s", strerror(ret));
+    }
+    memset(superblock, 0, sizeof(*superblock));
+    (void) strncpy(superblock->magic_number, RRDENG_DF_MAGIC, RRDENG_MAGIC_SZ);
+    (void) strncpy(superblock->version,
+                   datafile->checksum == RRDENG_CHECKSUM_CRC32C ? RRDENG_DF_VER_CRC32C : RRDENG_DF_VER,
+                   RRDENG_VER_SZ);
+    superblock->tier = 1;
+    superblock->compacted = datafile->compacted ? 1 : 0;
+    superblock->archived = 1;
+    superblock->archived_size = datafile->pos;
+
+    iov = uv_buf_init((void *)superblock, sizeof(*superblock));
+
+    ret = uv_fs_write(NULL, &req, datafile->file, &iov, 1, 0, NULL);
+    uv_fs_req_cleanup(&req);
+    posix_memfree(superblock);
+    if (ret < 0) {
+        netdata_log_error("DBENGINE: uv_fs_write: %s", uv_strerror(ret));
+        ctx_io_error(ctx);
+        return ret;
+    }
+    ctx_io_write_op_bytes(ctx, sizeof(*superblock));
+
+    ret = uv_fs_fsync(NULL, &req, datafile->file, NULL);
+    uv_fs_req_cleanup(&req);
+    if (ret < 0) {
+        netdata_log_error("DBENGINE: uv_fs_fsync: %s", uv_strerror(ret));
+        ctx_fs_error(ctx);
+        return ret;
+    }
+
+    // wait for the local reads in flight, the next ones will go to the object storage
+    uv_rwlock_wrlock(&datafile->extent_rwlock);
+    __atomic_store_n(&datafile->archived, true, __ATOMIC_RELEASE);
+    uv_rwlock_wrunlock(&datafile->extent_rwlock);
+
+    ret = uv_fs_ftruncate(NULL, &req, datafile->file, sizeof(*superblock), NULL);
+    uv_fs_req_cleanup(&req);
+    if (ret < 0) {
+        // the extents are still there, we just do not reclaim the space
+        netdata_log_error("DBENGINE: uv_fs_ftruncate: %s", uv_strerror(ret));
+        ctx_fs_error(ctx);
+        return 0;
+    }
+
+    ctx_current_disk_space_decrease(ctx, datafile->pos - sizeof(*superblock));
+    return 0;
+}
+
+static int check_data_file_superblock(uv_file file, struct rrdengine_datafile *datafile, uint64_t *archived_size)
 {
     int ret;
     struct rrdeng_df_sb *superblock = NULL;
@@ -311,12 +390,19 @@ static int check_data_file_superblock(uv_file file)
     fatal_assert(req.result >= 0);
     uv_fs_req_cleanup(&req);
 
+    bool ver_crc32 = !strncmp(superblock->version, RRDENG_DF_VER, RRDENG_VER_SZ);
+    bool ver_crc32c = !strncmp(superblock->version, RRDENG_DF_VER_CRC32C, RRDENG_VER_SZ);
+
     if (strncmp(superblock->magic_number, RRDENG_DF_MAGIC, RRDENG_MAGIC_SZ) ||
-        strncmp(superblock->version, RRDENG_DF_VER, RRDENG_VER_SZ) ||
+        (!ver_crc32 && !ver_crc32c) ||
         superblock->tier != 1) {
         netdata_log_error("DBENGINE: file has invalid superblock.");
         ret = UV_EINVAL;
     } else {
+        datafile->compacted = superblock->compacted ? true : false;
+        datafile->checksum = ver_crc32c ? RRDENG_CHECKSUM_CRC32C : RRDENG_CHECKSUM_CRC32;
+        datafile->archived = superblock->archived ? true : false;
+        *archived_size = superblock->archived_size;
         ret = 0;
     }
     error:
@@ -347,12 +433,28 @@ static int load_data_file(struct rrdengine_datafile *datafile)
         goto error;
     file_size = ALIGN_BYTES_CEILING(file_size);
 
-    ret = check_data_file_superblock(file);
+    uint64_t archived_size = 0;
+    ret = check_data_file_superblock(file, datafile, &archived_size);
     if (ret)
         goto error;
 
     ctx_io_read_op_bytes(ctx, sizeof(struct rrdeng_df_sb));
 
+    if (datafile->archived) {
+        // we keep it, so that enabling the archive again makes it queryable again
+        if (!ctx->archive)
+            nd_log_daemon(NDLP_WARNING, "DBENGINE: data file \"%s\" is archived, but the archive of tier %d is not enabled - "
+                                        "its data cannot be queried.", path, ctx->config.tier);
+
+        // we may have crashed before truncating it
+        if (file_size > sizeof(struct rrdeng_df_sb)) {
+            (void) uv_fs_ftruncate(NULL, &req, file, sizeof(struct rrdeng_df_sb), NULL);
+            uv_fs_req_cleanup(&req);
+        }
+
+        file_size = archived_size;
+    }
+
     datafile->file = file;
     datafile->pos = file_size;
 
@@ -374,45 +476,85 @@ static int load_data_file(struct rrdengine_datafile *datafile)
 static int scan_data_files_cmp(const void *a, const void *b)
 {
     struct rrdengine_datafile *file1, *file2;
-    char path1[RRDENG_PATH_MAX], path2[RRDENG_PATH_MAX];
 
+    // the files may be in different directories, so we sort them by number
     file1 = *(struct rrdengine_datafile **)a;
     file2 = *(struct rrdengine_datafile **)b;
-    generate_datafilepath(file1, path1, sizeof(path1));
-    generate_datafilepath(file2, path2, sizeof(path2));
-    return strcmp(path1, path2);
+
+    if(file1->tier != file2->tier)
+        return (file1->tier < file2->tier) ? -1 : 1;
+
+    if(file1->fileno != file2->fileno)
+        return (file1->fileno < file2->fileno) ? -1 : 1;
+
+    return 0;
 }
 
-/* Returns number of datafiles that were loaded or < 0 on error */
-static int scan_data_files(struct rrdengine_instance *ctx)
+/* Appends the datafiles found in the directory of the stripe to the array.
+ * Returns the new number of datafiles in the array or < 0 on error */
+static int scan_data_files_in_stripe(struct rrdengine_instance *ctx, uint8_t stripe, struct rrdengine_datafile ***datafiles, int matched_files)
 {
-    int ret, matched_files, failed_to_load, i;
+    int ret;
     unsigned tier, no;
     uv_fs_t req;
     uv_dirent_t dent;
-    struct rrdengine_datafile **datafiles, *datafile;
-    struct rrdengine_journalfile *journalfile;
+    const char *path = stripe ? ctx->config.stripes.paths[stripe - 1] : ctx->config.dbfiles_path;
 
-    ret = uv_fs_scandir(NULL, &req, ctx->config.dbfiles_path, 0, NULL);
+    ret = uv_fs_scandir(NULL, &req, path, 0, NULL);
     if (ret < 0) {
         fatal_assert(req.result < 0);
         uv_fs_req_cleanup(&req);
-        netdata_log_error("DBENGINE: uv_fs_scandir(%s): %s", ctx->config.dbfiles_path, uv_strerror(ret));
+        netdata_log_error("DBENGINE: uv_fs_scandir(%s): %s", path, uv_strerror(ret));
         ctx_fs_error(ctx);
         return ret;
     }
-    netdata_log_info("DBENGINE: found %d files in path %s", ret, ctx->config.dbfiles_path);
+    netdata_log_info("DBENGINE: found %d files in path %s", ret, path);
+
+    if (ret > 0)
+        *datafiles = reallocz(*datafiles, MIN(matched_files + ret, MAX_DATAFILES) * sizeof(**datafiles));
+
+    while (UV_EOF != uv_fs_scandir_next(&req, &dent) && matched_files < MAX_DATAFILES) {
+        if (!strncmp(dent.name, DATAFILE_COMPACTION_PREFIX, sizeof(DATAFILE_COMPACTION_PREFIX) - 1)) {
+            // left behind by a compaction that did not complete, the original files are still there
+            char filename[RRDENG_PATH_MAX];
+            snprintfz(filename, sizeof(filename) - 1, "%s/%s", path, dent.name);
+            if (unlink(filename) == 0)
+                netdata_log_info("DBENGINE: deleted incomplete compaction file \"%s\".", filename);
+            continue;
+        }
 
-    datafiles = callocz(MIN(ret, MAX_DATAFILES), sizeof(*datafiles));
-    for (matched_files = 0 ; UV_EOF != uv_fs_scandir_next(&req, &dent) && matched_files < MAX_DATAFILES ; ) {
         ret = sscanf(dent.name, DATAFILE_PREFIX RRDENG_FILE_NUMBER_SCAN_TMPL DATAFILE_EXTENSION, &tier, &no);
         if (2 == ret) {
-            datafile = datafile_alloc_and_init(ctx, tier, no);
-            datafiles[matched_files++] = datafile;
+            struct rrdengine_datafile *datafile = datafile_alloc_and_init(ctx, tier, no);
+            datafile->stripe = stripe;
+            (*datafiles)[matched_files++] = datafile;
         }
     }
     uv_fs_req_cleanup(&req);
 
+    return matched_files;
+}
+
+/* Returns number of datafiles that were loaded or < 0 on error */
+static int scan_data_files(struct rrdengine_instance *ctx)
+{
+    int ret, matched_files, failed_to_load, i;
+    struct rrdengine_datafile **datafiles = NULL, *datafile;
+    struct rrdengine_journalfile *journalfile;
+
+    for (matched_files = 0, i = 0 ; i <= ctx->config.stripes.count ; i++) {
+        ret = scan_data_files_in_stripe(ctx, (uint8_t)i, &datafiles, matched_files);
+        if (ret < 0) {
+            // the primary directory is required, the stripes are scanned as they are
+            if (i == 0) {
+                freez(datafiles);
+                return ret;
+            }
+            continue;
+        }
+        matched_files = ret;
+    }
+
     if (0 == matched_files) {
         freez(datafiles);
         return 0;
@@ -423,6 +565,21 @@ static int scan_data_files(struct rrdengine_instance *ctx)
 
     qsort(datafiles, matched_files, sizeof(*datafiles), scan_data_files_cmp);
 
+    // the same file number in two directories - we can only load one of them
+    for (i = 1 ; i < matched_files ; ) {
+        if (scan_data_files_cmp(&datafiles[i - 1], &datafiles[i]) == 0) {
+            char path[RRDENG_PATH_MAX];
+            generate_datafilepath(datafiles[i], path, sizeof(path));
+            netdata_log_error("DBENGINE: ignoring data file \"%s\", its number is already used in another directory.", path);
+
+            freez(datafiles[i]);
+            memmove(&datafiles[i], &datafiles[i + 1], (matched_files - i - 1) * sizeof(*datafiles));
+            matched_files--;
+        }
+        else
+            i++;
+    }
+
     ctx->atomic.last_fileno = datafiles[matched_files - 1]->fileno;
 
     netdata_log_info("DBENGINE: loading %d data/journal of tier %d...", matched_files, ctx->config.tier);
@@ -462,7 +619,7 @@ static int scan_data_files(struct rrdengine_instance *ctx)
             continue;
         }
 
-        ctx_current_disk_space_increase(ctx, datafile->pos + journalfile->unsafe.pos);
+        ctx_current_disk_space_increase(ctx, datafile_local_size(datafile) + journalfile->unsafe.pos);
         datafile_list_insert(ctx, datafile, false);
     }
 
@@ -483,11 +640,15 @@ int create_new_datafile_pair(struct rrdengine_instance *ctx, bool having_lock)
     int ret;
     char path[RRDENG_PATH_MAX];
 
+    datafile = datafile_alloc_and_init(ctx, 1, fileno);
+
+    // rotate the new files across the directories of the tier
+    datafile->stripe = (uint8_t)(fileno % (ctx->config.stripes.count + 1));
+
     nd_log(NDLS_DAEMON, NDLP_DEBUG,
            "DBENGINE: creating new data and journal files in path %s",
-           ctx->config.dbfiles_path);
+           datafile_directory(datafile));
 
-    datafile = datafile_alloc_and_init(ctx, 1, fileno);
     ret = create_data_file(datafile);
     if(ret)
         goto error_after_datafile;
@@ -544,8 +705,8 @@ int init_data_files(struct rrdengine_instance *ctx)
         if (ctx->loading.create_new_datafile_pair)
             create_new_datafile_pair(ctx, false);
 
-        while(rrdeng_ctx_tier_cap_exceeded(ctx))
-            datafile_delete(ctx, ctx->datafiles.first, false, false);
+        while(rrdeng_ctx_tier_cap_exceeded(ctx) && datafile_rotate(ctx, false, false))
+            ;
     }
 
     pgc_reset_hot_max(open_cache);
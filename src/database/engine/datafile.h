@@ -13,6 +13,9 @@ struct rrdengine_instance;
 #define DATAFILE_PREFIX "datafile-"
 #define DATAFILE_EXTENSION ".ndf"
 
+// the files of a datafile being rewritten by compaction have this prefix, until they replace the original ones
+#define DATAFILE_COMPACTION_PREFIX "compacting-"
+
 #ifndef MAX_DATAFILE_SIZE
 #define MAX_DATAFILE_SIZE   (512LU * 1024LU * 1024LU)
 #endif
@@ -42,6 +45,11 @@ typedef enum __attribute__ ((__packed__)) {
 struct rrdengine_datafile {
     unsigned tier;
     unsigned fileno;
+    uint8_t stripe;                 // 0 = in dbfiles_path, N = in the stripe directory N - 1
+    bool compacted;                 // it has been rewritten by compaction (persisted in its superblock)
+    bool compacting;                // it is being built by compaction, its files have DATAFILE_COMPACTION_PREFIX
+    RRDENG_CHECKSUM_TYPE checksum;  // of its extents, selected by the version of its superblock
+    bool archived;                  // its extents are in the object storage, the local file is just its superblock
     uv_file file;
     uint64_t pos;
     uv_rwlock_t extent_rwlock;
@@ -75,17 +83,25 @@ struct rrdengine_datafile {
     } extent_queries;
 };
 
+struct rrdengine_datafile *datafile_alloc_and_init(struct rrdengine_instance *ctx, unsigned tier, unsigned fileno);
 bool datafile_acquire(struct rrdengine_datafile *df, DATAFILE_ACQUIRE_REASONS reason);
 void datafile_release(struct rrdengine_datafile *df, DATAFILE_ACQUIRE_REASONS reason);
 bool datafile_acquire_for_deletion(struct rrdengine_datafile *df, bool is_shutdown);
 
 void datafile_list_insert(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile, bool having_lock);
 void datafile_list_delete_unsafe(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile);
+const char *datafile_directory(struct rrdengine_datafile *datafile);
 void generate_datafilepath(struct rrdengine_datafile *datafile, char *str, size_t maxlen);
+
+// the bytes the datafile occupies on the local disk (->pos remains the size of its extents)
+static inline uint64_t datafile_local_size(struct rrdengine_datafile *datafile) {
+    return datafile->archived ? sizeof(struct rrdeng_df_sb) : datafile->pos;
+}
 int close_data_file(struct rrdengine_datafile *datafile);
 int unlink_data_file(struct rrdengine_datafile *datafile);
 int destroy_data_file_unsafe(struct rrdengine_datafile *datafile);
 int create_data_file(struct rrdengine_datafile *datafile);
+int datafile_mark_archived(struct rrdengine_datafile *datafile);
 int create_new_datafile_pair(struct rrdengine_instance *ctx, bool having_lock);
 int init_data_files(struct rrdengine_instance *ctx);
 void finalize_data_files(struct rrdengine_instance *ctx);
@@ -0,0 +1,530 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrdengine.h"
+#include "dbengine-archive.h"
+#include "registry/registry.h"
+
+#ifdef HAVE_LIBCURL
+#include <curl/curl.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// archive of rotated datafiles to S3 compatible object storage
+//
+// When a tier has an archive, rotation does not delete its oldest datafile.
+// The datafile and its journal v2 index are uploaded to the object storage,
+// and the local datafile is truncated to its superblock, which is marked as
+// archived and remembers the original size. The datafile stays in the list
+// of the tier and its journal files stay on the local disk, so the MRG
+// retention and the query planning do not change: only the extent reads of
+// archived datafiles become ranged GETs of the object.
+//
+// Extents are fetched in chunks of ARCHIVE_CHUNK_SIZE bytes, kept in a local
+// disk cache in front of the object storage (the extents of a query are
+// usually next to each other). The cache is rebuilt empty on every start.
+//
+// Archived datafiles are deleted (locally and remotely) by rotation, when
+// their data is older than the retention of the archive.
+
+#define ARCHIVE_CHUNK_SIZE (1 * 1024 * 1024)
+#define ARCHIVE_CACHE_DIRECTORY "archive-cache"
+#define ARCHIVE_HTTP_TIMEOUT_S (600)
+
+// curl can sign requests with AWS SigV4 since 7.75.0
+#if defined(HAVE_LIBCURL) && defined(LIBCURL_VERSION_NUM) && LIBCURL_VERSION_NUM >= 0x074b00
+#define ARCHIVE_HAVE_SIGV4 1
+#endif
+
+bool dbengine_archive_tier[RRD_STORAGE_TIERS] = { 0 };
+const char *dbengine_archive_url = NULL;
+const char *dbengine_archive_region = "us-east-1";
+const char *dbengine_archive_access_key = NULL;
+const char *dbengine_archive_secret_key = NULL;
+time_t dbengine_archive_retention_s = 0;
+uint64_t dbengine_archive_cache_size = 1024ULL * 1024 * 1024;
+
+struct archive_cached_chunk {
+    time_t last_access_s;
+    uint32_t size;
+};
+
+struct dbengine_archive {
+    SPINLOCK spinlock;
+    Pvoid_t chunks_judyL;           // (fileno << 32 | chunk) -> struct archive_cached_chunk
+    uint64_t cached_bytes;
+    char cache_path[FILENAME_MAX + 1];
+};
+
+static inline Word_t archive_chunk_key(unsigned fileno, uint64_t chunk) {
+    return ((Word_t)fileno << 32) | (Word_t)(uint32_t)chunk;
+}
+
+static void archive_chunk_path(struct dbengine_archive *archive, unsigned fileno, uint64_t chunk, char *path, size_t len) {
+    snprintfz(path, len, "%s/chunk-%u-%" PRIu64, archive->cache_path, fileno, chunk);
+}
+
+// the object name of a local file, e.g. <machine guid>/tier1/datafile-1-0000000001.ndf
+static void archive_object_url(struct rrdengine_instance *ctx, const char *local_path, char *url, size_t len) {
+    const char *filename = strrchr(local_path, '/');
+    filename = filename ? filename + 1 : local_path;
+
+    size_t base_len = strlen(dbengine_archive_url);
+    while(base_len && dbengine_archive_url[base_len - 1] == '/')
+        base_len--;
+
+    snprintfz(url, len, "%.*s/%s/tier%d/%s",
+              (int)base_len, dbengine_archive_url, registry_get_this_machine_guid(), ctx->config.tier, filename);
+}
+
+// ----------------------------------------------------------------------------
+// object storage requests
+
+#ifdef ARCHIVE_HAVE_SIGV4
+
+struct archive_download {
+    uint8_t *buf;
+    size_t size;
+    size_t used;
+};
+
+static size_t archive_download_cb(char *ptr, size_t size, size_t nmemb, void *userdata) {
+    struct archive_download *d = userdata;
+    size_t bytes = size * nmemb;
+
+    // anything above the range we asked for is an error of the server
+    if(d->used + bytes > d->size)
+        return 0;
+
+    memcpy(d->buf + d->used, ptr, bytes);
+    d->used += bytes;
+    return bytes;
+}
+
+static size_t archive_discard_cb(char *ptr __maybe_unused, size_t size, size_t nmemb, void *userdata __maybe_unused) {
+    return size * nmemb;
+}
+
+static CURL *archive_curl_init(const char *url, struct curl_slist **headers) {
+    CURL *curl = curl_easy_init();
+    if(!curl)
+        return NULL;
+
+    char sigv4[256];
+    snprintfz(sigv4, sizeof(sigv4), "aws:amz:%s:s3", dbengine_archive_region);
+
+    char userpwd[512];
+    snprintfz(userpwd, sizeof(userpwd), "%s:%s",
+              dbengine_archive_access_key ? dbengine_archive_access_key : "",
+              dbengine_archive_secret_key ? dbengine_archive_secret_key : "");
+
+    // we do not hash the payload of uploads, they are as big as a datafile
+    *headers = curl_slist_append(NULL, "x-amz-content-sha256: UNSIGNED-PAYLOAD");
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_AWS_SIGV4, sigv4);
+    curl_easy_setopt(curl, CURLOPT_USERPWD, userpwd);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, *headers);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, (long)ARCHIVE_HTTP_TIMEOUT_S);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, archive_discard_cb);
+
+    return curl;
+}
+
+static bool archive_curl_perform(CURL *curl, struct curl_slist *headers, const char *method, const char *url, long *http_code) {
+    CURLcode rc = curl_easy_perform(curl);
+    *http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, http_code);
+
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+
+    if(rc != CURLE_OK) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE ARCHIVE: %s '%s' failed: %s", method, url, curl_easy_strerror(rc));
+        return false;
+    }
+
+    if(*http_code < 200 || *http_code >= 300) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE ARCHIVE: %s '%s' failed with HTTP code %ld", method, url, *http_code);
+        return false;
+    }
+
+    return true;
+}
+
+static bool archive_object_upload(const char *url, const char *local_path, uint64_t size) {
+    FILE *fp = fopen(local_path, "rb");
+    if(!fp) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE ARCHIVE: cannot open '%s' for uploading it", local_path);
+        return false;
+    }
+
+    struct curl_slist *headers = NULL;
+    CURL *curl = archive_curl_init(url, &headers);
+    if(!curl) {
+        fclose(fp);
+        return false;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+    curl_easy_setopt(curl, CURLOPT_READDATA, fp);
+    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)size);
+
+    long http_code;
+    bool ok = archive_curl_perform(curl, headers, "PUT", url, &http_code);
+    fclose(fp);
+    return ok;
+}
+
+static bool archive_object_read(const char *url, void *buf, uint64_t pos, size_t size) {
+    struct curl_slist *headers = NULL;
+    CURL *curl = archive_curl_init(url, &headers);
+    if(!curl)
+        return false;
+
+    char range[64];
+    snprintfz(range, sizeof(range), "%" PRIu64 "-%" PRIu64, pos, pos + size - 1);
+
+    struct archive_download d = { .buf = buf, .size = size, .used = 0, };
+    curl_easy_setopt(curl, CURLOPT_RANGE, range);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, archive_download_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &d);
+
+    long http_code;
+    if(!archive_curl_perform(curl, headers, "GET", url, &http_code))
+        return false;
+
+    // servers may ignore a range that covers the whole object
+    if((http_code != 206 && !(http_code == 200 && pos == 0)) || d.used != size) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE ARCHIVE: GET '%s' range %s returned %zu bytes (HTTP code %ld), expected %zu",
+               url, range, d.used, http_code, size);
+        return false;
+    }
+
+    return true;
+}
+
+static void archive_object_delete(const char *url) {
+    struct curl_slist *headers = NULL;
+    CURL *curl = archive_curl_init(url, &headers);
+    if(!curl)
+        return;
+
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+
+    long http_code;
+    (void)archive_curl_perform(curl, headers, "DELETE", url, &http_code);
+}
+
+#else // !ARCHIVE_HAVE_SIGV4
+
+static bool archive_object_upload(const char *url __maybe_unused, const char *local_path __maybe_unused, uint64_t size __maybe_unused) {
+    return false;
+}
+
+static bool archive_object_read(const char *url __maybe_unused, void *buf __maybe_unused, uint64_t pos __maybe_unused, size_t size __maybe_unused) {
+    return false;
+}
+
+static void archive_object_delete(const char *url __maybe_unused) {
+    ;
+}
+
+#endif // ARCHIVE_HAVE_SIGV4
+
+// ----------------------------------------------------------------------------
+// local disk cache of archived chunks
+
+static void archive_cache_wipe(struct dbengine_archive *archive) {
+    DIR *dir = opendir(archive->cache_path);
+    if(!dir)
+        return;
+
+    struct dirent *de;
+    char path[FILENAME_MAX + 1];
+    while((de = readdir(dir))) {
+        if(strncmp(de->d_name, "chunk-", 6) != 0)
+            continue;
+
+        snprintfz(path, sizeof(path), "%s/%s", archive->cache_path, de->d_name);
+        (void)unlink(path);
+    }
+
+    closedir(dir);
+}
+
+// evicts the least recently used chunks, until the cache fits its size
+static void archive_cache_evict(struct dbengine_archive *archive) {
+    char path[FILENAME_MAX + 1];
+
+    spinlock_lock(&archive->spinlock);
+    while(archive->cached_bytes > dbengine_archive_cache_size) {
+        Word_t oldest_key = 0;
+        time_t oldest_s = LONG_MAX;
+
+        Word_t key = 0;
+        Pvoid_t *PValue;
+        bool first = true;
+        while((PValue = JudyLFirstThenNext(archive->chunks_judyL, &key, &first))) {
+            struct archive_cached_chunk *c = *PValue;
+            if(c->last_access_s < oldest_s) {
+                oldest_s = c->last_access_s;
+                oldest_key = key;
+            }
+        }
+
+        if(oldest_s == LONG_MAX)
+            break;
+
+        PValue = JudyLGet(archive->chunks_judyL, oldest_key, PJE0);
+        struct archive_cached_chunk *c = *PValue;
+        archive->cached_bytes -= c->size;
+        freez(c);
+        (void)JudyLDel(&archive->chunks_judyL, oldest_key, PJE0);
+
+        archive_chunk_path(archive, (unsigned)(oldest_key >> 32), (uint32_t)oldest_key, path, sizeof(path));
+        (void)unlink(path);
+    }
+    spinlock_unlock(&archive->spinlock);
+}
+
+static bool archive_cache_get(struct dbengine_archive *archive, unsigned fileno, uint64_t chunk, void *buf, size_t size) {
+    spinlock_lock(&archive->spinlock);
+    Pvoid_t *PValue = JudyLGet(archive->chunks_judyL, archive_chunk_key(fileno, chunk), PJE0);
+    bool cached = PValue && ((struct archive_cached_chunk *)*PValue)->size == size;
+    if(cached)
+        ((struct archive_cached_chunk *)*PValue)->last_access_s = now_monotonic_sec();
+    spinlock_unlock(&archive->spinlock);
+
+    if(!cached)
+        return false;
+
+    char path[FILENAME_MAX + 1];
+    archive_chunk_path(archive, fileno, chunk, path, sizeof(path));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return false;
+
+    ssize_t bytes = pread(fd, buf, size, 0);
+    close(fd);
+
+    return bytes == (ssize_t)size;
+}
+
+static void archive_cache_add(struct dbengine_archive *archive, unsigned fileno, uint64_t chunk, void *buf, size_t size) {
+    if(!dbengine_archive_cache_size)
+        return;
+
+    char path[FILENAME_MAX + 1], tmp_path[FILENAME_MAX + 1];
+    archive_chunk_path(archive, fileno, chunk, path, sizeof(path));
+    snprintfz(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, gettid_cached());
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0664);
+    if(fd == -1)
+        return;
+
+    ssize_t bytes = write(fd, buf, size);
+    close(fd);
+
+    // the rename is atomic, concurrent readers of the same chunk see either file complete
+    if(bytes != (ssize_t)size || rename(tmp_path, path) != 0) {
+        (void)unlink(tmp_path);
+        return;
+    }
+
+    spinlock_lock(&archive->spinlock);
+    Pvoid_t *PValue = JudyLIns(&archive->chunks_judyL, archive_chunk_key(fileno, chunk), PJE0);
+    if(!*PValue) {
+        struct archive_cached_chunk *c = callocz(1, sizeof(*c));
+        c->size = size;
+        *PValue = c;
+        archive->cached_bytes += size;
+    }
+    ((struct archive_cached_chunk *)*PValue)->last_access_s = now_monotonic_sec();
+    spinlock_unlock(&archive->spinlock);
+
+    if(archive->cached_bytes > dbengine_archive_cache_size)
+        archive_cache_evict(archive);
+}
+
+static void archive_cache_delete_datafile(struct dbengine_archive *archive, unsigned fileno) {
+    char path[FILENAME_MAX + 1];
+
+    spinlock_lock(&archive->spinlock);
+    Word_t key = archive_chunk_key(fileno, 0);
+    Pvoid_t *PValue;
+    while((PValue = JudyLFirst(archive->chunks_judyL, &key, PJE0)) && (unsigned)(key >> 32) == fileno) {
+        struct archive_cached_chunk *c = *PValue;
+        archive->cached_bytes -= c->size;
+        freez(c);
+        (void)JudyLDel(&archive->chunks_judyL, key, PJE0);
+
+        archive_chunk_path(archive, fileno, (uint32_t)key, path, sizeof(path));
+        (void)unlink(path);
+    }
+    spinlock_unlock(&archive->spinlock);
+}
+
+// ----------------------------------------------------------------------------
+// public API
+
+void dbengine_archive_init(struct rrdengine_instance *ctx) {
+    if(ctx->archive || ctx->config.tier < 0 || ctx->config.tier >= RRD_STORAGE_TIERS || !dbengine_archive_tier[ctx->config.tier])
+        return;
+
+    if(!dbengine_archive_url || !*dbengine_archive_url) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE ARCHIVE: tier %d should be archived, but no archive url is configured - not archiving it",
+               ctx->config.tier);
+        return;
+    }
+
+#ifndef ARCHIVE_HAVE_SIGV4
+    nd_log(NDLS_DAEMON, NDLP_ERR,
+           "DBENGINE ARCHIVE: tier %d should be archived, but this netdata is built without libcurl 7.75+ "
+           "(for AWS SigV4) - not archiving it",
+           ctx->config.tier);
+    return;
+#endif
+
+    struct dbengine_archive *archive = callocz(1, sizeof(*archive));
+    spinlock_init(&archive->spinlock);
+    snprintfz(archive->cache_path, sizeof(archive->cache_path), "%s/" ARCHIVE_CACHE_DIRECTORY, ctx->config.dbfiles_path);
+
+    if(mkdir(archive->cache_path, 0775) != 0 && errno != EEXIST) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE ARCHIVE: cannot create the cache directory '%s' of tier %d - not archiving it",
+               archive->cache_path, ctx->config.tier);
+        freez(archive);
+        return;
+    }
+
+    // we do not know what the chunks of a previous run are, start empty
+    archive_cache_wipe(archive);
+
+    nd_log(NDLS_DAEMON, NDLP_INFO,
+           "DBENGINE ARCHIVE: tier %d archives its rotated datafiles to '%s', caching up to %" PRIu64 " bytes in '%s'",
+           ctx->config.tier, dbengine_archive_url, dbengine_archive_cache_size, archive->cache_path);
+
+    ctx->archive = archive;
+}
+
+void dbengine_archive_cleanup(struct rrdengine_instance *ctx) {
+    struct dbengine_archive *archive = ctx->archive;
+    if(!archive)
+        return;
+
+    Word_t key = 0;
+    Pvoid_t *PValue;
+    bool first = true;
+    while((PValue = JudyLFirstThenNext(archive->chunks_judyL, &key, &first)))
+        freez(*PValue);
+
+    JudyLFreeArray(&archive->chunks_judyL, PJE0);
+    freez(archive);
+    ctx->archive = NULL;
+}
+
+bool dbengine_archive_datafile(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile) {
+    if(!ctx->archive || datafile->archived)
+        return false;
+
+    // after archiving, the journal v2 index is the only way queries find the extents
+    if(!journalfile_v2_data_available(datafile->journalfile)) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE ARCHIVE: datafile %u of tier %d has no journal v2 index, it cannot be archived",
+               datafile->fileno, ctx->config.tier);
+        return false;
+    }
+
+    char path[RRDENG_PATH_MAX], url[FILENAME_MAX + 1];
+    usec_t started_ut = now_monotonic_usec();
+    uint64_t datafile_size = datafile->pos;
+
+    journalfile_v2_generate_path(datafile, path, sizeof(path));
+    archive_object_url(ctx, path, url, sizeof(url));
+    if(!archive_object_upload(url, path, journalfile_v2_data_size_get(datafile->journalfile)))
+        return false;
+
+    generate_datafilepath(datafile, path, sizeof(path));
+    archive_object_url(ctx, path, url, sizeof(url));
+    if(!archive_object_upload(url, path, datafile_size))
+        return false;
+
+    // from now on, the extents of the datafile are read from the object storage
+    if(datafile_mark_archived(datafile) != 0)
+        return false;
+
+    nd_log(NDLS_DAEMON, NDLP_INFO,
+           "DBENGINE ARCHIVE: archived datafile %u of tier %d (%" PRIu64 " bytes) to '%s' in %" PRIu64 " ms",
+           datafile->fileno, ctx->config.tier, datafile_size, url, (uint64_t)((now_monotonic_usec() - started_ut) / USEC_PER_MS));
+
+    return true;
+}
+
+bool dbengine_archive_read(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile, void *buf, uint64_t pos, size_t size) {
+    struct dbengine_archive *archive = ctx->archive;
+    if(!archive || pos + size > datafile->pos)
+        return false;
+
+    char path[RRDENG_PATH_MAX], url[FILENAME_MAX + 1];
+    generate_datafilepath(datafile, path, sizeof(path));
+    archive_object_url(ctx, path, url, sizeof(url));
+
+    uint8_t *chunk_buf = mallocz(ARCHIVE_CHUNK_SIZE);
+    uint64_t end = pos + size;
+    bool ok = true;
+
+    for(uint64_t chunk = pos / ARCHIVE_CHUNK_SIZE; ok && chunk * ARCHIVE_CHUNK_SIZE < end ; chunk++) {
+        uint64_t chunk_start = chunk * ARCHIVE_CHUNK_SIZE;
+        size_t chunk_size = (size_t)MIN((uint64_t)ARCHIVE_CHUNK_SIZE, datafile->pos - chunk_start);
+
+        if(!archive_cache_get(archive, datafile->fileno, chunk, chunk_buf, chunk_size)) {
+            ok = archive_object_read(url, chunk_buf, chunk_start, chunk_size);
+            if(!ok)
+                break;
+
+            ctx_io_read_op_bytes(ctx, chunk_size);
+            archive_cache_add(archive, datafile->fileno, chunk, chunk_buf, chunk_size);
+        }
+
+        uint64_t from = MAX(pos, chunk_start);
+        uint64_t to = MIN(end, chunk_start + chunk_size);
+        memcpy((uint8_t *)buf + (from - pos), chunk_buf + (from - chunk_start), to - from);
+    }
+
+    freez(chunk_buf);
+    return ok;
+}
+
+void dbengine_archive_datafile_deleted(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile) {
+    if(!ctx->archive || !datafile->archived)
+        return;
+
+    archive_cache_delete_datafile(ctx->archive, datafile->fileno);
+
+    char path[RRDENG_PATH_MAX], url[FILENAME_MAX + 1];
+
+    generate_datafilepath(datafile, path, sizeof(path));
+    archive_object_url(ctx, path, url, sizeof(url));
+    archive_object_delete(url);
+
+    journalfile_v2_generate_path(datafile, path, sizeof(path));
+    archive_object_url(ctx, path, url, sizeof(url));
+    archive_object_delete(url);
+}
+
+bool dbengine_archive_datafile_expired(struct rrdengine_instance *ctx __maybe_unused, struct rrdengine_datafile *datafile) {
+    if(!datafile->archived || !dbengine_archive_retention_s)
+        return false;
+
+    time_t last_time_s = datafile->journalfile->v2.last_time_s;
+    if(!last_time_s)
+        last_time_s = datafile->journalfile->v2.first_time_s;
+
+    return last_time_s && now_realtime_sec() - last_time_s > dbengine_archive_retention_s;
+}
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_DBENGINE_ARCHIVE_H
+#define NETDATA_DBENGINE_ARCHIVE_H
+
+struct rrdengine_instance;
+struct rrdengine_datafile;
+
+extern bool dbengine_archive_tier[];                // the tiers that archive their rotated datafiles
+extern const char *dbengine_archive_url;            // S3 compatible, path style: https://endpoint/bucket[/prefix]
+extern const char *dbengine_archive_region;
+extern const char *dbengine_archive_access_key;
+extern const char *dbengine_archive_secret_key;
+extern time_t dbengine_archive_retention_s;         // 0 = archived datafiles are kept forever
+extern uint64_t dbengine_archive_cache_size;        // per tier, the local disk cache of archived extents
+
+// prepares the archive of the tier - it has to be called before its datafiles are loaded
+void dbengine_archive_init(struct rrdengine_instance *ctx);
+void dbengine_archive_cleanup(struct rrdengine_instance *ctx);
+
+// uploads a datafile and its journal v2 index to the object storage
+// and reclaims the local disk space of the datafile - true on success
+bool dbengine_archive_datafile(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile);
+
+// reads a range of an archived datafile, from the local disk cache or the object storage
+bool dbengine_archive_read(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile, void *buf, uint64_t pos, size_t size);
+
+// the archived datafile is deleted - removes its objects and its cached chunks
+void dbengine_archive_datafile_deleted(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile);
+
+// the archived datafile has been kept longer than the retention of the archive
+bool dbengine_archive_datafile_expired(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile);
+
+#endif //NETDATA_DBENGINE_ARCHIVE_H
@@ -0,0 +1,453 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrdengine.h"
+
+// ----------------------------------------------------------------------------
+// dbengine benchmark
+//
+// A fixed set of scenarios, run on a private tier 0 instance in a temporary
+// directory, reporting standardized numbers as JSON, so that versions can be
+// compared on the same hardware:
+//
+//  - ingestion     points/sec stored by the writers, for all the metrics
+//  - flush         the time and the throughput of saving everything collected
+//  - query_cold    query latency percentiles, with the dbengine caches dropped
+//  - query_warm    the same queries again, with the pages in the caches
+//  - startup       the time to load the datafiles and journals written
+//
+// The data and the queries are generated deterministically, so that two runs
+// with the same parameters do exactly the same work. The OS page cache is not
+// dropped for the cold queries.
+//
+// netdata -W dbengine-benchmark[=METRICS,POINTS,QUERIES,WRITERS,CACHE_MB,FILE]
+
+#define BENCHMARK_QUERY_WINDOW_S 3600
+#define BENCHMARK_BATCH_POINTS 64
+
+struct benchmark_metric {
+    nd_uuid_t uuid;
+    METRIC *metric;
+};
+
+struct benchmark_writer {
+    ND_THREAD *thread;
+    struct benchmark_metric *metrics;
+    size_t first, last;                 // the metrics of this writer: [first, last)
+    size_t points;
+    time_t start_time_s;
+    STORAGE_METRICS_GROUP *smg;
+    STORAGE_COLLECT_HANDLE **sch;
+    size_t stored;
+};
+
+struct benchmark_query {
+    size_t metric;
+    time_t after;
+    time_t before;
+};
+
+struct benchmark_query_results {
+    size_t queries;
+    size_t points;
+    usec_t *latencies_ut;
+    struct rrdeng_cache_efficiency_stats before, after;
+};
+
+static inline uint64_t benchmark_random(uint64_t *state) {
+    // splitmix64 - deterministic, independent of the libc random()
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline NETDATA_DOUBLE benchmark_value(size_t metric, size_t point) {
+    // slowly changing values, like most collected metrics
+    return (NETDATA_DOUBLE)((metric * 7 + point / 16 + (point % 5)) % 1000);
+}
+
+static METRIC *benchmark_metric_create(struct rrdengine_instance *ctx, nd_uuid_t *uuid) {
+    MRG_ENTRY entry = {
+            .uuid = uuid,
+            .section = (Word_t)ctx,
+            .first_time_s = 0,
+            .last_time_s = 0,
+            .latest_update_every_s = 0,
+    };
+
+    bool added;
+    METRIC *metric = mrg_metric_add_and_acquire(main_mrg, entry, &added);
+    if (added)
+        __atomic_add_fetch(&ctx->atomic.metrics, 1, __ATOMIC_RELAXED);
+
+    return metric;
+}
+
+static size_t benchmark_datafiles(struct rrdengine_instance *ctx) {
+    size_t count = 0;
+
+    uv_rwlock_rdlock(&ctx->datafiles.rwlock);
+    for(struct rrdengine_datafile *df = ctx->datafiles.first; df ; df = df->next)
+        count++;
+    uv_rwlock_rdunlock(&ctx->datafiles.rwlock);
+
+    return count;
+}
+
+static void benchmark_drop_caches(struct rrdengine_instance *ctx, METRIC *metric) {
+    pgc_evict_clean_pages_of_metric(main_cache, (Word_t)ctx, mrg_metric_id(main_mrg, metric));
+
+    uv_rwlock_rdlock(&ctx->datafiles.rwlock);
+    for(struct rrdengine_datafile *df = ctx->datafiles.first; df ; df = df->next)
+        pgc_evict_clean_pages_of_metric(extent_cache, (Word_t)ctx, (Word_t)df->fileno);
+    uv_rwlock_rdunlock(&ctx->datafiles.rwlock);
+}
+
+static void benchmark_remove_directory(const char *path) {
+    DIR *dir = opendir(path);
+    if(dir) {
+        struct dirent *de;
+        char filename[FILENAME_MAX + 1];
+
+        while((de = readdir(dir))) {
+            if(!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+                continue;
+
+            snprintfz(filename, FILENAME_MAX, "%s/%s", path, de->d_name);
+            if(unlink(filename) != 0)
+                fprintf(stderr, "DBENGINE BENCHMARK: cannot delete '%s'\n", filename);
+        }
+        closedir(dir);
+    }
+
+    if(rmdir(path) != 0)
+        fprintf(stderr, "DBENGINE BENCHMARK: cannot delete directory '%s'\n", path);
+}
+
+// ----------------------------------------------------------------------------
+// ingestion
+
+static void *benchmark_writer_thread(void *ptr) {
+    struct benchmark_writer *w = ptr;
+
+    // like the collectors do, all the metrics of a writer get a point, then the next point
+    for(size_t p = 0; p < w->points ; p++) {
+        usec_t point_in_time_ut = (usec_t)(w->start_time_s + (time_t)p) * USEC_PER_SEC;
+
+        for(size_t m = w->first; m < w->last ; m++) {
+            NETDATA_DOUBLE n = benchmark_value(m, p);
+            rrdeng_store_metric_next(w->sch[m - w->first], point_in_time_ut, n, n, n, 1, 0, SN_DEFAULT_FLAGS);
+        }
+    }
+
+    w->stored = w->points * (w->last - w->first);
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// queries
+
+static int benchmark_usec_compar(const void *a, const void *b) {
+    usec_t ua = *(const usec_t *)a, ub = *(const usec_t *)b;
+    return (ua > ub) - (ua < ub);
+}
+
+static void benchmark_run_queries(struct rrdengine_instance *ctx, struct benchmark_metric *metrics,
+                                  struct benchmark_query *queries, size_t count, bool cold,
+                                  struct benchmark_query_results *r) {
+    STORAGE_POINT sps[BENCHMARK_BATCH_POINTS];
+
+    r->queries = count;
+    r->points = 0;
+    r->latencies_ut = mallocz(count * sizeof(usec_t));
+    r->before = rrdeng_get_cache_efficiency_stats();
+
+    for(size_t q = 0; q < count ; q++) {
+        struct benchmark_metric *bm = &metrics[queries[q].metric];
+
+        if(cold)
+            benchmark_drop_caches(ctx, bm->metric);
+
+        struct storage_engine_query_handle seqh = { 0 };
+        usec_t started_ut = now_monotonic_high_precision_usec();
+
+        rrdeng_load_metric_init((STORAGE_METRIC_HANDLE *)bm->metric, &seqh, queries[q].after, queries[q].before, STORAGE_PRIORITY_HIGH);
+        while(!rrdeng_load_metric_is_finished(&seqh)) {
+            size_t points = rrdeng_load_metric_next_batch(&seqh, sps, BENCHMARK_BATCH_POINTS);
+            if(!points)
+                break;
+
+            r->points += points;
+        }
+        rrdeng_load_metric_finalize(&seqh);
+
+        r->latencies_ut[q] = now_monotonic_high_precision_usec() - started_ut;
+    }
+
+    r->after = rrdeng_get_cache_efficiency_stats();
+    qsort(r->latencies_ut, count, sizeof(usec_t), benchmark_usec_compar);
+}
+
+static inline usec_t benchmark_percentile(struct benchmark_query_results *r, double pct) {
+    if(!r->queries)
+        return 0;
+
+    size_t slot = (size_t)(pct * (double)(r->queries - 1) / 100.0 + 0.5);
+    return r->latencies_ut[MIN(slot, r->queries - 1)];
+}
+
+static void benchmark_query_results_json(BUFFER *wb, const char *key, struct benchmark_query_results *r) {
+    usec_t total_ut = 0;
+    for(size_t q = 0; q < r->queries ; q++)
+        total_ut += r->latencies_ut[q];
+
+    size_t main_cache = r->after.pages_data_source_main_cache - r->before.pages_data_source_main_cache;
+    size_t extent_cache = r->after.pages_data_source_extent_cache - r->before.pages_data_source_extent_cache;
+    size_t disk = r->after.pages_data_source_disk - r->before.pages_data_source_disk;
+    size_t pages = main_cache + extent_cache + disk;
+
+    buffer_json_member_add_object(wb, key);
+    {
+        buffer_json_member_add_uint64(wb, "queries", r->queries);
+        buffer_json_member_add_uint64(wb, "points", r->points);
+        buffer_json_member_add_uint64(wb, "latency_avg_us", r->queries ? total_ut / r->queries : 0);
+        buffer_json_member_add_uint64(wb, "latency_p50_us", benchmark_percentile(r, 50.0));
+        buffer_json_member_add_uint64(wb, "latency_p90_us", benchmark_percentile(r, 90.0));
+        buffer_json_member_add_uint64(wb, "latency_p99_us", benchmark_percentile(r, 99.0));
+        buffer_json_member_add_uint64(wb, "latency_max_us", benchmark_percentile(r, 100.0));
+        buffer_json_member_add_uint64(wb, "pages", pages);
+        buffer_json_member_add_double(wb, "main_cache_hit_ratio", pages ? (NETDATA_DOUBLE)main_cache / (NETDATA_DOUBLE)pages : 0.0);
+        buffer_json_member_add_double(wb, "extent_cache_hit_ratio", pages ? (NETDATA_DOUBLE)extent_cache / (NETDATA_DOUBLE)pages : 0.0);
+        buffer_json_member_add_double(wb, "disk_ratio", pages ? (NETDATA_DOUBLE)disk / (NETDATA_DOUBLE)pages : 0.0);
+    }
+    buffer_json_object_close(wb);
+}
+
+// ----------------------------------------------------------------------------
+
+int dbengine_benchmark(const char *args) {
+    size_t metrics_count = 10000, points = 7200, queries_count = 1000, writers = 4, cache_mb = 256;
+    const char *filename = NULL;
+
+    char *s = strdupz(args ? args : ""), *words = s, *word;
+    if((word = strsep(&words, ",")) && *word) metrics_count = str2u(word);
+    if((word = strsep(&words, ",")) && *word) points = str2u(word);
+    if((word = strsep(&words, ",")) && *word) queries_count = str2u(word);
+    if((word = strsep(&words, ",")) && *word) writers = str2u(word);
+    if((word = strsep(&words, ",")) && *word) cache_mb = str2u(word);
+    if((word = strsep(&words, ",")) && *word) filename = word;
+
+    if(!metrics_count) metrics_count = 1;
+    if(!points) points = 1;
+    if(!writers) writers = 1;
+    if(writers > metrics_count) writers = metrics_count;
+    if(cache_mb < RRDENG_MIN_PAGE_CACHE_SIZE_MB) cache_mb = RRDENG_MIN_PAGE_CACHE_SIZE_MB;
+
+    nd_log_limits_unlimited();
+    default_rrdeng_page_cache_mb = (int)cache_mb;
+
+    const char *tmp = getenv("TMPDIR");
+    char path[FILENAME_MAX + 1];
+    snprintfz(path, FILENAME_MAX, "%s/netdata-dbengine-benchmark-XXXXXX", (tmp && *tmp) ? tmp : "/tmp");
+    if(!mkdtemp(path)) {
+        fprintf(stderr, "DBENGINE BENCHMARK: cannot create a temporary directory at '%s'\n", path);
+        freez(s);
+        return 1;
+    }
+
+    struct rrdengine_instance *ctx = NULL;
+    if(rrdeng_init(&ctx, path, NULL, 0, 0, 0) != 0 || !ctx) {
+        fprintf(stderr, "DBENGINE BENCHMARK: cannot initialize dbengine at '%s'\n", path);
+        benchmark_remove_directory(path);
+        freez(s);
+        return 1;
+    }
+    rrdeng_readiness_wait(ctx);
+
+    fprintf(stderr, "DBENGINE BENCHMARK: %zu metrics, %zu points each, %zu queries, %zu writers, %zu MiB page cache, at '%s'\n",
+            metrics_count, points, queries_count, writers, cache_mb, path);
+
+    struct benchmark_metric *metrics = callocz(metrics_count, sizeof(*metrics));
+    for(size_t m = 0; m < metrics_count ; m++) {
+        char id[100];
+        size_t len = snprintfz(id, sizeof(id), "dbengine-benchmark.metric%zu", m);
+        ND_UUID uuid = UUID_generate_from_hash(id, len);
+        uuid_copy(metrics[m].uuid, uuid.uuid);
+        metrics[m].metric = benchmark_metric_create(ctx, &metrics[m].uuid);
+    }
+
+    CLEAN_BUFFER *wb = buffer_create(0, NULL);
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_DEFAULT);
+    buffer_json_member_add_string(wb, "benchmark", "dbengine");
+    buffer_json_member_add_string(wb, "version", NETDATA_VERSION);
+    buffer_json_member_add_uint64(wb, "cpus", (uint64_t)os_get_system_cpus());
+
+    buffer_json_member_add_object(wb, "parameters");
+    {
+        buffer_json_member_add_uint64(wb, "metrics", metrics_count);
+        buffer_json_member_add_uint64(wb, "points_per_metric", points);
+        buffer_json_member_add_uint64(wb, "queries", queries_count);
+        buffer_json_member_add_uint64(wb, "writers", writers);
+        buffer_json_member_add_uint64(wb, "page_cache_mb", cache_mb);
+        buffer_json_member_add_uint64(wb, "query_window_s", MIN(points, BENCHMARK_QUERY_WINDOW_S));
+    }
+    buffer_json_object_close(wb);
+
+    // ------------------------------------------------------------------------
+    // ingestion
+
+    // the points are in the past, so that none of them is rejected as coming from the future
+    time_t start_time_s = now_realtime_sec() - (time_t)points - 60;
+
+    struct benchmark_writer *w = callocz(writers, sizeof(*w));
+    for(size_t i = 0; i < writers ; i++) {
+        w[i].metrics = metrics;
+        w[i].first = metrics_count * i / writers;
+        w[i].last = metrics_count * (i + 1) / writers;
+        w[i].points = points;
+        w[i].start_time_s = start_time_s;
+        w[i].smg = rrdeng_metrics_group_get((STORAGE_INSTANCE *)ctx, NULL);
+        w[i].sch = mallocz((w[i].last - w[i].first) * sizeof(STORAGE_COLLECT_HANDLE *));
+        for(size_t m = w[i].first; m < w[i].last ; m++)
+            w[i].sch[m - w[i].first] = rrdeng_store_metric_init((STORAGE_METRIC_HANDLE *)metrics[m].metric, 1, w[i].smg);
+    }
+
+    usec_t ingest_started_ut = now_monotonic_high_precision_usec();
+    for(size_t i = 0; i < writers ; i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, sizeof(tag), "DBENCHW[%zu]", i);
+        w[i].thread = nd_thread_create(tag, NETDATA_THREAD_OPTION_JOINABLE | NETDATA_THREAD_OPTION_DONT_LOG,
+                                       benchmark_writer_thread, &w[i]);
+    }
+
+    size_t stored = 0;
+    for(size_t i = 0; i < writers ; i++) {
+        nd_thread_join(w[i].thread);
+        stored += w[i].stored;
+    }
+    usec_t ingest_ut = now_monotonic_high_precision_usec() - ingest_started_ut;
+    if(!ingest_ut) ingest_ut = 1;
+
+    buffer_json_member_add_object(wb, "ingestion");
+    {
+        buffer_json_member_add_uint64(wb, "points", stored);
+        buffer_json_member_add_uint64(wb, "duration_ms", ingest_ut / USEC_PER_MS);
+        buffer_json_member_add_uint64(wb, "points_per_sec", (uint64_t)((NETDATA_DOUBLE)stored * USEC_PER_SEC / (NETDATA_DOUBLE)ingest_ut));
+    }
+    buffer_json_object_close(wb);
+    fprintf(stderr, "DBENGINE BENCHMARK: ingestion of %zu points completed in %"PRIu64" ms\n", stored, (uint64_t)(ingest_ut / USEC_PER_MS));
+
+    // ------------------------------------------------------------------------
+    // flush
+
+    size_t written_before = __atomic_load_n(&ctx->stats.io_write_bytes, __ATOMIC_RELAXED);
+    usec_t flush_started_ut = now_monotonic_high_precision_usec();
+
+    for(size_t i = 0; i < writers ; i++) {
+        for(size_t m = w[i].first; m < w[i].last ; m++)
+            rrdeng_store_metric_finalize(w[i].sch[m - w[i].first]);
+
+        rrdeng_metrics_group_release((STORAGE_INSTANCE *)ctx, w[i].smg);
+        freez(w[i].sch);
+    }
+    freez(w);
+
+    pgc_flush_all_hot_and_dirty_pages(main_cache, (Word_t)ctx);
+    while(__atomic_load_n(&ctx->atomic.extents_currently_being_flushed, __ATOMIC_RELAXED))
+        sleep_usec(USEC_PER_MS);
+
+    usec_t flush_ut = now_monotonic_high_precision_usec() - flush_started_ut;
+    if(!flush_ut) flush_ut = 1;
+    size_t written = __atomic_load_n(&ctx->stats.io_write_bytes, __ATOMIC_RELAXED) - written_before;
+
+    buffer_json_member_add_object(wb, "flush");
+    {
+        buffer_json_member_add_uint64(wb, "bytes", written);
+        buffer_json_member_add_uint64(wb, "duration_ms", flush_ut / USEC_PER_MS);
+        buffer_json_member_add_double(wb, "mib_per_sec", (NETDATA_DOUBLE)written * USEC_PER_SEC / (NETDATA_DOUBLE)flush_ut / 1048576.0);
+        buffer_json_member_add_uint64(wb, "disk_space_bytes", ctx_current_disk_space_get(ctx));
+    }
+    buffer_json_object_close(wb);
+    fprintf(stderr, "DBENGINE BENCHMARK: flushing %zu bytes completed in %"PRIu64" ms\n", written, (uint64_t)(flush_ut / USEC_PER_MS));
+
+    // ------------------------------------------------------------------------
+    // queries
+
+    time_t window_s = (time_t)MIN(points, BENCHMARK_QUERY_WINDOW_S);
+    struct benchmark_query *queries = mallocz(MAX(queries_count, 1) * sizeof(*queries));
+    uint64_t seed = 0x6e65746461746121ULL;
+    for(size_t q = 0; q < queries_count ; q++) {
+        queries[q].metric = benchmark_random(&seed) % metrics_count;
+        queries[q].after = start_time_s + (time_t)(benchmark_random(&seed) % (points - (size_t)window_s + 1));
+        queries[q].before = queries[q].after + window_s - 1;
+    }
+
+    struct benchmark_query_results cold = { 0 }, warm = { 0 };
+    benchmark_run_queries(ctx, metrics, queries, queries_count, true, &cold);
+    benchmark_query_results_json(wb, "query_cold", &cold);
+    fprintf(stderr, "DBENGINE BENCHMARK: %zu cold queries completed, p50 %"PRIu64" us\n", cold.queries, (uint64_t)benchmark_percentile(&cold, 50.0));
+
+    benchmark_run_queries(ctx, metrics, queries, queries_count, false, &warm);
+    benchmark_query_results_json(wb, "query_warm", &warm);
+    fprintf(stderr, "DBENGINE BENCHMARK: %zu warm queries completed, p50 %"PRIu64" us\n", warm.queries, (uint64_t)benchmark_percentile(&warm, 50.0));
+
+    freez(cold.latencies_ut);
+    freez(warm.latencies_ut);
+    freez(queries);
+
+    // ------------------------------------------------------------------------
+    // startup
+
+    for(size_t m = 0; m < metrics_count ; m++)
+        mrg_metric_release(main_mrg, metrics[m].metric);
+    freez(metrics);
+
+    size_t datafiles = benchmark_datafiles(ctx);
+    rrdeng_prepare_exit(ctx);
+    rrdeng_exit(ctx);
+
+    // the old instance is not freed, so the new one cannot get its address,
+    // and the metrics the MRG still has for the old one do not mix with the new ones
+    usec_t startup_started_ut = now_monotonic_high_precision_usec();
+    int rc = rrdeng_init(&ctx, path, NULL, 0, 0, 0);
+    if(rc == 0)
+        rrdeng_readiness_wait(ctx);
+    usec_t startup_ut = now_monotonic_high_precision_usec() - startup_started_ut;
+
+    buffer_json_member_add_object(wb, "startup");
+    {
+        buffer_json_member_add_boolean(wb, "success", rc == 0);
+        buffer_json_member_add_uint64(wb, "datafiles", datafiles);
+        buffer_json_member_add_uint64(wb, "metrics", rc == 0 ? __atomic_load_n(&ctx->atomic.metrics, __ATOMIC_RELAXED) : 0);
+        buffer_json_member_add_uint64(wb, "duration_ms", startup_ut / USEC_PER_MS);
+    }
+    buffer_json_object_close(wb);
+    fprintf(stderr, "DBENGINE BENCHMARK: loading %zu datafiles completed in %"PRIu64" ms\n", datafiles, (uint64_t)(startup_ut / USEC_PER_MS));
+
+    if(rc == 0) {
+        rrdeng_prepare_exit(ctx);
+        rrdeng_exit(ctx);
+    }
+    rrdeng_enq_cmd(NULL, RRDENG_OPCODE_SHUTDOWN_EVLOOP, NULL, NULL, STORAGE_PRIORITY_BEST_EFFORT, NULL, NULL);
+
+    buffer_json_finalize(wb);
+
+    int ret = 0;
+    if(filename) {
+        FILE *fp = fopen(filename, "w");
+        if(fp) {
+            fprintf(fp, "%s\n", buffer_tostring(wb));
+            fclose(fp);
+        }
+        else {
+            fprintf(stderr, "DBENGINE BENCHMARK: cannot write the results to '%s'\n", filename);
+            ret = 1;
+        }
+    }
+    else
+        fprintf(stdout, "%s\n", buffer_tostring(wb));
+
+    benchmark_remove_directory(path);
+    freez(s);
+    return (ret || rc) ? 1 : 0;
+}
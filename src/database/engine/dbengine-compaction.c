@@ -0,0 +1,798 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrdengine.h"
+#include "dbengine-compaction.h"
+
+// ----------------------------------------------------------------------------
+// datafile compaction
+//
+// Datafiles are written once and deleted whole by rotation. Over time, the
+// older ones are full of pages nobody can query anymore (metrics that have
+// been deleted from the MRG, or pages before the retention of their metric),
+// and their extents are compressed with the fast settings the flushers use.
+//
+// Compaction takes the oldest group of consecutive datafiles that have not
+// been compacted yet (skipping the first one, which is the next to be rotated,
+// and the ones still being written or indexed), so that their data fit in one
+// datafile of the target size, and rewrites them into a single datafile:
+//
+//   - pages of metrics not in the MRG, invalid pages and pages earlier than
+//     the first time of their metric are dropped,
+//   - the remaining pages are packed into full extents and re-compressed at
+//     the compaction level,
+//   - a journal v1 and a journal v2 are written for the new datafile.
+//
+// The new files are written with the DATAFILE_COMPACTION_PREFIX, using the
+// file number of the first datafile of the group (so that the order of the
+// datafiles does not change). Then the first datafile of the group is taken
+// out of queries, its files are replaced by the new ones using renames, the
+// new datafile takes its place in the list, and the rest of the group is
+// deleted.
+//
+// The renames are not atomic as a whole. The journal v2 of the old datafile is
+// deleted first, so that the journal v2 is rebuilt from the journal v1 at the
+// next startup, and any files left with the prefix are deleted at startup.
+// A crash between the renames of the datafile and its journal v1 leaves a
+// datafile with a journal that does not describe it: its extents will fail
+// their checksums and the pages of the first datafile of the group will be
+// lost. The rest of the group is deleted only after the swap, so in every
+// other case the worst is finding the same pages in two datafiles.
+//
+// Compaction runs in a libuv worker, is mutually exclusive with rotation, and
+// its disk I/O is limited to dbengine_compaction_io_budget_mb per second.
+
+bool dbengine_use_compaction = false;
+int dbengine_compaction_compression_level = 9;
+size_t dbengine_compaction_io_budget_mb = 10;
+
+#define COMPACTION_MAX_DATAFILES (16)
+#define COMPACTION_MAX_EXTENT_PAYLOAD (MAX_PAGES_PER_EXTENT * RRDENG_BLOCK_SIZE)
+
+struct compaction_metric {
+    struct jv2_metrics_info mi;     // must be first, the journal v2 builder gets pointers to it
+    METRIC *metric;                 // acquired until the compaction finishes
+    time_t mrg_first_time_s;
+    uint32_t update_every_s;
+};
+
+struct compaction_state {
+    struct rrdengine_instance *ctx;
+    struct rrdengine_datafile *df;  // the datafile being built
+
+    Pvoid_t JudyL_metrics;
+    Pvoid_t JudyL_extents_pos;
+    size_t extents;
+    size_t metrics;
+    size_t pages;
+
+    struct {
+        struct rrdeng_extent_page_descr descr[MAX_PAGES_PER_EXTENT];
+        struct jv2_page_info *pi[MAX_PAGES_PER_EXTENT];
+        uint8_t *payload;
+        size_t payload_length;
+        unsigned count;
+    } out;
+
+    struct {
+        usec_t started_ut;
+        size_t bytes;
+    } io;
+
+    bool write_failed;
+
+    struct {
+        size_t pages_dropped;
+        size_t bytes_read;
+        size_t bytes_written;
+    } stats;
+};
+
+// ----------------------------------------------------------------------------
+// I/O
+
+static void compaction_io_throttle(struct compaction_state *cs, size_t bytes) {
+    cs->io.bytes += bytes;
+
+    if(!dbengine_compaction_io_budget_mb)
+        return;
+
+    // the time the bytes done so far should have taken
+    usec_t budget_per_sec = dbengine_compaction_io_budget_mb * 1024 * 1024;
+    usec_t expected_ut = cs->io.bytes * USEC_PER_SEC / budget_per_sec;
+    usec_t spent_ut = now_monotonic_usec() - cs->io.started_ut;
+
+    if(expected_ut > spent_ut)
+        sleep_usec(expected_ut - spent_ut);
+}
+
+static bool compaction_read(struct rrdengine_instance *ctx, uv_file file, void *buf, size_t size, uint64_t pos) {
+    uv_fs_t req;
+    uv_buf_t iov = uv_buf_init(buf, size);
+
+    int ret = uv_fs_read(NULL, &req, file, &iov, 1, (int64_t)pos, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if(ret < 0 || (size_t)ret != size) {
+        ctx_io_error(ctx);
+        return false;
+    }
+
+    ctx_io_read_op_bytes(ctx, size);
+    return true;
+}
+
+static bool compaction_write(struct rrdengine_instance *ctx, uv_file file, void *buf, size_t size, uint64_t pos) {
+    uv_fs_t req;
+    uv_buf_t iov = uv_buf_init(buf, size);
+
+    int ret = uv_fs_write(NULL, &req, file, &iov, 1, (int64_t)pos, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if(ret < 0 || (size_t)ret != size) {
+        netdata_log_error("DBENGINE: compaction failed to write %zu bytes: %s", size, ret < 0 ? uv_strerror(ret) : "short write");
+        ctx_io_error(ctx);
+        return false;
+    }
+
+    ctx_io_write_op_bytes(ctx, size);
+    return true;
+}
+
+static bool compaction_fsync(struct rrdengine_instance *ctx, uv_file file) {
+    uv_fs_t req;
+    int ret = uv_fs_fsync(NULL, &req, file, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if(ret < 0) {
+        netdata_log_error("DBENGINE: compaction failed to fsync: %s", uv_strerror(ret));
+        ctx_fs_error(ctx);
+        return false;
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// writing the new datafile
+
+static bool compaction_journal_v1_write(struct compaction_state *cs, struct rrdeng_df_extent_header *header, uint64_t extent_pos, uint32_t extent_size) {
+    struct rrdengine_instance *ctx = cs->ctx;
+    struct rrdengine_journalfile *journalfile = cs->df->journalfile;
+    struct rrdeng_jf_transaction_header *jf_header;
+    struct rrdeng_jf_store_data *jf_metric_data;
+    struct rrdeng_jf_transaction_trailer *jf_trailer;
+    uLong crc;
+
+    unsigned count = header->number_of_pages;
+    unsigned descr_size = sizeof(*jf_metric_data->descr) * count;
+    unsigned payload_length = sizeof(*jf_metric_data) + descr_size;
+    unsigned size_bytes = sizeof(*jf_header) + payload_length + sizeof(*jf_trailer);
+    size_t buf_size = ALIGN_BYTES_CEILING(size_bytes);
+
+    void *buf = NULL;
+    int ret = posix_memalign(&buf, RRDFILE_ALIGNMENT, buf_size);
+    if (unlikely(ret))
+        fatal("DBENGINE: posix_memalign:%s", strerror(ret));
+
+    // the rest of the block is zeros, an empty transaction (STORE_PADDING)
+    memset(buf, 0, buf_size);
+
+    jf_header = buf;
+    jf_header->type = STORE_DATA;
+    jf_header->reserved = 0;
+    jf_header->id = __atomic_fetch_add(&ctx->atomic.transaction_id, 1, __ATOMIC_RELAXED);
+    jf_header->payload_length = payload_length;
+
+    jf_metric_data = buf + sizeof(*jf_header);
+    jf_metric_data->extent_offset = extent_pos;
+    jf_metric_data->extent_size = extent_size;
+    jf_metric_data->number_of_pages = count;
+    memcpy(jf_metric_data->descr, header->descr, descr_size);
+
+    jf_trailer = buf + sizeof(*jf_header) + payload_length;
+    crc = rrdeng_checksum(journalfile->checksum, buf, sizeof(*jf_header) + payload_length);
+    crc32set(jf_trailer->checksum, crc);
+
+    bool ok = compaction_write(ctx, journalfile->file, buf, buf_size, journalfile->unsafe.pos);
+    posix_memfree(buf);
+
+    if(ok) {
+        journalfile->unsafe.pos += buf_size;
+        cs->stats.bytes_written += buf_size;
+        compaction_io_throttle(cs, buf_size);
+    }
+
+    return ok;
+}
+
+static bool compaction_extent_flush(struct compaction_state *cs) {
+    if(!cs->out.count)
+        return true;
+
+    struct rrdengine_instance *ctx = cs->ctx;
+    struct rrdengine_datafile *df = cs->df;
+    struct rrdeng_df_extent_header *header;
+    struct rrdeng_df_extent_trailer *trailer;
+    uint8_t compression_algorithm = dbengine_compression_algorithm(ctx);
+    unsigned count = cs->out.count;
+    uLong crc;
+
+    size_t uncompressed_payload_length = cs->out.payload_length;
+    size_t payload_offset = sizeof(*header) + count * sizeof(header->descr[0]);
+    size_t max_compressed_size = dbengine_max_compressed_size(uncompressed_payload_length, compression_algorithm);
+    size_t size_bytes = payload_offset + MAX(uncompressed_payload_length, max_compressed_size) + sizeof(*trailer);
+
+    void *buf = NULL;
+    int ret = posix_memalign(&buf, RRDFILE_ALIGNMENT, ALIGN_BYTES_CEILING(size_bytes));
+    if (unlikely(ret))
+        fatal("DBENGINE: posix_memalign:%s", strerror(ret));
+    memset(buf, 0, ALIGN_BYTES_CEILING(size_bytes));
+
+    header = buf;
+    header->number_of_pages = count;
+    memcpy(header->descr, cs->out.descr, count * sizeof(header->descr[0]));
+    memcpy(buf + payload_offset, cs->out.payload, uncompressed_payload_length);
+
+    size_t compressed_size =
+        dbengine_compress_with_level(ctx, buf + payload_offset, uncompressed_payload_length,
+                                     compression_algorithm, dbengine_compaction_compression_level);
+
+    if(compressed_size) {
+        header->compression_algorithm = compression_algorithm;
+        header->payload_length = compressed_size;
+    }
+    else {
+        header->compression_algorithm = RRDENG_COMPRESSION_NONE;
+        header->payload_length = compressed_size = uncompressed_payload_length;
+    }
+
+    size_bytes = payload_offset + compressed_size + sizeof(*trailer);
+
+    if(compression_algorithm != RRDENG_COMPRESSION_NONE) {
+        __atomic_add_fetch(&ctx->stats.before_compress_bytes, uncompressed_payload_length, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ctx->stats.after_compress_bytes, compressed_size, __ATOMIC_RELAXED);
+    }
+
+    trailer = buf + size_bytes - sizeof(*trailer);
+    crc = rrdeng_checksum(df->checksum, buf, size_bytes - sizeof(*trailer));
+    crc32set(trailer->checksum, crc);
+
+    size_t real_io_size = ALIGN_BYTES_CEILING(size_bytes);
+    uint64_t pos = df->pos;
+
+    bool ok = compaction_write(ctx, df->file, buf, real_io_size, pos);
+    if(ok) {
+        df->pos += real_io_size;
+        cs->stats.bytes_written += real_io_size;
+        compaction_io_throttle(cs, real_io_size);
+
+        ok = compaction_journal_v1_write(cs, header, pos, size_bytes);
+    }
+
+    posix_memfree(buf);
+
+    if(!ok) {
+        cs->write_failed = true;
+        return false;
+    }
+
+    struct jv2_extents_info *ei = callocz(1, sizeof(*ei));
+    ei->index = cs->extents++;
+    ei->pos = pos;
+    ei->bytes = size_bytes;
+    ei->number_of_pages = count;
+
+    Pvoid_t *PValue = JudyLIns(&cs->JudyL_extents_pos, (Word_t)pos, PJE0);
+    internal_fatal(!PValue || PValue == PJERR, "DBENGINE: corrupted compaction extents judy array");
+    *PValue = ei;
+
+    for(unsigned i = 0; i < count; i++)
+        cs->out.pi[i]->extent_index = ei->index;
+
+    cs->out.count = 0;
+    cs->out.payload_length = 0;
+
+    return true;
+}
+
+// returns true when the page has been kept
+static bool compaction_page_add(struct compaction_state *cs, struct rrdeng_extent_page_descr *descr, void *page_data, time_t now_s, bool have_read_error) {
+    time_t start_time_s = (time_t)(descr->start_time_ut / USEC_PER_SEC);
+
+    if(have_read_error || !descr->page_length || !start_time_s)
+        return false;
+
+    METRIC *metric = mrg_metric_get_and_acquire(main_mrg, (nd_uuid_t *)descr->uuid, (Word_t)cs->ctx);
+    if(!metric)
+        // the metric has been deleted, nobody can query this page
+        return false;
+
+    Pvoid_t *PValue = JudyLGet(cs->JudyL_metrics, (Word_t)metric, PJE0);
+    struct compaction_metric *cm = PValue ? *PValue : NULL;
+
+    time_t mrg_first_time_s = cm ? cm->mrg_first_time_s : mrg_metric_get_first_time_s(main_mrg, metric);
+    uint32_t update_every_s = cm ? cm->update_every_s : mrg_metric_get_update_every_s(main_mrg, metric);
+
+    VALIDATED_PAGE_DESCRIPTOR vd = validate_extent_page_descr(descr, now_s, update_every_s, false);
+
+    if(!vd.is_valid || vd.page_length != descr->page_length ||
+        // before the retention of the metric
+        (mrg_first_time_s && vd.end_time_s < mrg_first_time_s) ||
+        // we already have a page for this time, from a previous datafile
+        (cm && JudyLGet(cm->mi.JudyL_pages_by_start_time, (Word_t)vd.start_time_s, PJE0))) {
+        mrg_metric_release(main_mrg, metric);
+        return false;
+    }
+
+    if(cs->out.count >= rrdeng_pages_per_extent ||
+        cs->out.payload_length + vd.page_length > COMPACTION_MAX_EXTENT_PAYLOAD) {
+        if(!compaction_extent_flush(cs)) {
+            mrg_metric_release(main_mrg, metric);
+            return false;
+        }
+    }
+
+    if(!cm) {
+        cm = callocz(1, sizeof(*cm));
+        cm->metric = metric;
+        cm->mi.uuid = mrg_metric_uuid(main_mrg, metric);
+        cm->mi.first_time_s = vd.start_time_s;
+        cm->mi.last_time_s = vd.end_time_s;
+        cm->mrg_first_time_s = mrg_first_time_s;
+        cm->update_every_s = update_every_s;
+
+        PValue = JudyLIns(&cs->JudyL_metrics, (Word_t)metric, PJE0);
+        internal_fatal(!PValue || PValue == PJERR, "DBENGINE: corrupted compaction metrics judy array");
+        *PValue = cm;
+        cs->metrics++;
+    }
+    else
+        // we keep one reference per metric
+        mrg_metric_release(main_mrg, metric);
+
+    struct jv2_page_info *pi = callocz(1, sizeof(*pi));
+    pi->start_time_s = vd.start_time_s;
+    pi->end_time_s = vd.end_time_s;
+    pi->update_every_s = vd.update_every_s;
+    pi->page_length = vd.page_length;
+
+    PValue = JudyLIns(&cm->mi.JudyL_pages_by_start_time, (Word_t)vd.start_time_s, PJE0);
+    internal_fatal(!PValue || PValue == PJERR, "DBENGINE: corrupted compaction pages judy array");
+    *PValue = pi;
+
+    cm->mi.number_of_pages++;
+    cm->mi.first_time_s = MIN(cm->mi.first_time_s, vd.start_time_s);
+    cm->mi.last_time_s = MAX(cm->mi.last_time_s, vd.end_time_s);
+    cs->pages++;
+
+    cs->out.descr[cs->out.count] = *descr;
+    cs->out.pi[cs->out.count] = pi;
+    cs->out.count++;
+    memcpy(cs->out.payload + cs->out.payload_length, page_data, vd.page_length);
+    cs->out.payload_length += vd.page_length;
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// reading the old datafiles
+
+// returns false only when writing failed
+static bool compaction_extent_copy(struct compaction_state *cs, struct rrdengine_datafile *datafile, uint64_t extent_pos, uint32_t extent_size) {
+    struct rrdengine_instance *ctx = cs->ctx;
+    struct rrdeng_df_extent_header *header;
+    struct rrdeng_df_extent_trailer *trailer;
+    struct extent_buffer *eb = NULL;
+    bool have_read_error = false;
+    uLong crc;
+
+    if(extent_size < sizeof(*header) + sizeof(header->descr[0]) + sizeof(*trailer))
+        return true;
+
+    size_t real_io_size = ALIGN_BYTES_CEILING(extent_size);
+    void *data = NULL;
+    int ret = posix_memalign(&data, RRDFILE_ALIGNMENT, real_io_size);
+    if (unlikely(ret))
+        fatal("DBENGINE: posix_memalign:%s", strerror(ret));
+
+    if(!compaction_read(ctx, datafile->file, data, real_io_size, extent_pos)) {
+        // we do not fail, the pages of this extent cannot be read by queries either
+        posix_memfree(data);
+        return true;
+    }
+
+    cs->stats.bytes_read += real_io_size;
+    compaction_io_throttle(cs, real_io_size);
+
+    header = data;
+    uint32_t payload_length = header->payload_length;
+    unsigned count = header->number_of_pages;
+    uint32_t payload_offset = sizeof(*header) + sizeof(header->descr[0]) * count;
+    uint32_t trailer_offset = extent_size - sizeof(*trailer);
+    trailer = data + trailer_offset;
+
+    if(count < 1 ||
+        count > MAX_PAGES_PER_EXTENT ||
+        !dbengine_valid_compression_algorithm(header->compression_algorithm) ||
+        payload_offset > trailer_offset ||
+        (payload_length != trailer_offset - payload_offset)) {
+        posix_memfree(data);
+        return true;
+    }
+
+    crc = rrdeng_checksum(datafile->checksum, data, extent_size - sizeof(*trailer));
+    if (unlikely(crc32cmp(trailer->checksum, crc))) {
+        ctx_io_error(ctx);
+        have_read_error = true;
+    }
+
+    void *payload = data + payload_offset;
+    uint32_t uncompressed_payload_length = 0;
+    for (unsigned i = 0; i < count; ++i)
+        uncompressed_payload_length += header->descr[i].page_length;
+
+    if(uncompressed_payload_length > COMPACTION_MAX_EXTENT_PAYLOAD)
+        have_read_error = true;
+
+    if (!have_read_error && RRDENG_COMPRESSION_NONE != header->compression_algorithm) {
+        eb = extent_buffer_get(uncompressed_payload_length);
+
+        size_t bytes = dbengine_decompress(ctx, eb->data, payload,
+                                           uncompressed_payload_length, payload_length,
+                                           header->compression_algorithm);
+        if(bytes != uncompressed_payload_length)
+            have_read_error = true;
+        else {
+            __atomic_add_fetch(&ctx->stats.before_decompress_bytes, payload_length, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&ctx->stats.after_decompress_bytes, bytes, __ATOMIC_RELAXED);
+        }
+
+        payload = eb->data;
+    }
+    else if(!have_read_error && uncompressed_payload_length != payload_length)
+        have_read_error = true;
+
+    time_t now_s = max_acceptable_collected_time();
+    uint32_t page_offset = 0;
+    for (unsigned i = 0; i < count && !cs->write_failed; page_offset += header->descr[i].page_length, i++) {
+        if(!compaction_page_add(cs, &header->descr[i], payload + page_offset, now_s, have_read_error))
+            cs->stats.pages_dropped++;
+    }
+
+    if(eb)
+        extent_buffer_release(eb);
+
+    posix_memfree(data);
+    return !cs->write_failed;
+}
+
+static bool compaction_datafile_copy(struct compaction_state *cs, struct rrdengine_datafile *datafile) {
+    size_t data_size = 0;
+    struct journal_v2_header *j2_header = journalfile_v2_data_acquire(datafile->journalfile, &data_size, 0, 0);
+    if(!j2_header)
+        return false;
+
+    bool ok = true;
+    struct journal_extent_list *extent_list = (void *)((uint8_t *)j2_header + j2_header->extent_offset);
+    for(uint32_t i = 0; ok && i < j2_header->extent_count; i++) {
+        if(!ctx_is_available_for_queries(cs->ctx)) {
+            ok = false;
+            break;
+        }
+
+        ok = compaction_extent_copy(cs, datafile, extent_list[i].datafile_offset, extent_list[i].datafile_size);
+    }
+
+    journalfile_v2_data_release(datafile->journalfile);
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// cleanup
+
+static void compaction_state_cleanup(struct compaction_state *cs) {
+    Pvoid_t *PValue;
+    Word_t Index = 0;
+    bool first_then_next = true;
+    while((PValue = JudyLFirstThenNext(cs->JudyL_metrics, &Index, &first_then_next))) {
+        struct compaction_metric *cm = *PValue;
+
+        Word_t start_time = 0;
+        bool pages_first_then_next = true;
+        Pvoid_t *PValue2;
+        while((PValue2 = JudyLFirstThenNext(cm->mi.JudyL_pages_by_start_time, &start_time, &pages_first_then_next)))
+            freez(*PValue2);
+        JudyLFreeArray(&cm->mi.JudyL_pages_by_start_time, PJE0);
+
+        mrg_metric_release(main_mrg, cm->metric);
+        freez(cm);
+    }
+    JudyLFreeArray(&cs->JudyL_metrics, PJE0);
+
+    Index = 0;
+    first_then_next = true;
+    while((PValue = JudyLFirstThenNext(cs->JudyL_extents_pos, &Index, &first_then_next)))
+        freez(*PValue);
+    JudyLFreeArray(&cs->JudyL_extents_pos, PJE0);
+
+    freez(cs->out.payload);
+    cs->out.payload = NULL;
+}
+
+static void compaction_files_destroy(struct rrdengine_datafile *df) {
+    char path[RRDENG_PATH_MAX];
+
+    if(df->journalfile) {
+        // there is no journal v2 activated on it, this only deletes the files
+        journalfile_destroy_unsafe(df->journalfile, df);
+        freez(df->journalfile);
+        df->journalfile = NULL;
+    }
+
+    destroy_data_file_unsafe(df);
+    generate_datafilepath(df, path, sizeof(path));
+    netdata_log_info("DBENGINE: deleted incomplete compaction file \"%s\".", path);
+}
+
+// ----------------------------------------------------------------------------
+// swapping the new datafile in
+
+typedef void (*compaction_path_generator_t)(struct rrdengine_datafile *datafile, char *str, size_t maxlen);
+
+static bool compaction_file_rename(struct rrdengine_datafile *df, compaction_path_generator_t generate_path) {
+    char from[RRDENG_PATH_MAX];
+    char to[RRDENG_PATH_MAX];
+
+    df->compacting = true;
+    generate_path(df, from, sizeof(from));
+    df->compacting = false;
+    generate_path(df, to, sizeof(to));
+    df->compacting = true;
+
+    if(rename(from, to) != 0) {
+        netdata_log_error("DBENGINE: compaction failed to rename \"%s\" to \"%s\": %s", from, to, strerror(errno));
+        ctx_fs_error(df->ctx);
+        return false;
+    }
+
+    return true;
+}
+
+static void compaction_directory_fsync(struct rrdengine_datafile *df) {
+    int fd = open(datafile_directory(df), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd == -1)
+        return;
+
+    (void)fsync(fd);
+    close(fd);
+}
+
+static bool compaction_swap(struct rrdengine_instance *ctx, struct rrdengine_datafile **group, size_t count, struct rrdengine_datafile *df) {
+    struct rrdengine_datafile *old = group[0];
+    char path[RRDENG_PATH_MAX];
+
+    worker_is_busy(UV_EVENT_DBENGINE_COMPACTION_SWAP);
+
+    // take the whole group out of queries, so that the pages are not found twice
+    for(size_t i = 0; i < count; i++) {
+        while(!datafile_acquire_for_deletion(group[i], !ctx_is_available_for_queries(ctx)))
+            sleep_usec(1 * USEC_PER_SEC);
+    }
+
+    size_t old_v2_size = journalfile_v2_data_size_get(old->journalfile);
+    uint64_t old_bytes = old->pos + journalfile_current_size(old->journalfile) + old_v2_size;
+
+    // the journal v2 of the old datafile goes first, so that a crash before the
+    // rename of the journal v2 will make it rebuilt from the journal v1
+    journalfile_v2_generate_path(old, path, sizeof(path));
+    if(unlink(path) != 0 && errno != ENOENT) {
+        netdata_log_error("DBENGINE: compaction failed to delete \"%s\": %s", path, strerror(errno));
+        ctx_fs_error(ctx);
+        goto cancel;
+    }
+
+    // the old datafile and its journal v1 are intact until the datafile is renamed
+    // (its journal v2 is still mapped, so queries can continue using it)
+    if(!compaction_file_rename(df, generate_datafilepath))
+        goto cancel;
+
+    if(!compaction_file_rename(df, journalfile_v1_generate_path) ||
+        !compaction_file_rename(df, journalfile_v2_generate_path)) {
+        // we cannot go back, the old datafile has been replaced
+        netdata_log_error("DBENGINE: compaction of datafile %u of tier %d failed while renaming files, "
+                          "the datafile will be checked at the next restart", old->fileno, ctx->config.tier);
+    }
+    df->compacting = false;
+    compaction_directory_fsync(df);
+
+    // close the old datafile
+    journalfile_close(old->journalfile, old);
+    if(old->journalfile->file) {
+        uv_fs_t req;
+        (void)uv_fs_close(NULL, &req, old->journalfile->file, NULL);
+        uv_fs_req_cleanup(&req);
+    }
+    close_data_file(old);
+
+    // the extent cache is indexed by the file number, which is now reused
+    pgc_evict_clean_pages_of_metric(extent_cache, (Word_t)ctx, old->fileno);
+
+    uv_rwlock_wrlock(&ctx->datafiles.rwlock);
+    DOUBLE_LINKED_LIST_INSERT_ITEM_BEFORE_UNSAFE(ctx->datafiles.first, old, df, prev, next);
+    datafile_list_delete_unsafe(ctx, old);
+    uv_rwlock_wrunlock(&ctx->datafiles.rwlock);
+
+    spinlock_lock(&df->populate_mrg.spinlock);
+    df->populate_mrg.populated = true;
+    spinlock_unlock(&df->populate_mrg.spinlock);
+
+    ctx_current_disk_space_decrease(ctx, old_bytes);
+    ctx_current_disk_space_increase(ctx, df->pos + journalfile_current_size(df->journalfile));
+
+    if(journalfile_v2_load(ctx, df->journalfile, df) != 0) {
+        journalfile_v2_generate_path(df, path, sizeof(path));
+        netdata_log_error("DBENGINE: failed to load journal file \"%s\" written by compaction, "
+                          "its data will be available after the next restart", path);
+    }
+
+    freez(old->journalfile);
+    freez(old);
+
+    // the rest of the group is now in the new datafile
+    for(size_t i = 1; i < count; i++)
+        datafile_delete(ctx, group[i], false, true);
+
+    return true;
+
+cancel:
+    for(size_t i = 0; i < count; i++) {
+        spinlock_lock(&group[i]->users.spinlock);
+        group[i]->users.available = true;
+        spinlock_unlock(&group[i]->users.spinlock);
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+static size_t compaction_group_select(struct rrdengine_instance *ctx, struct rrdengine_datafile **group) {
+    uint64_t target_size = rrdeng_target_data_file_size(ctx);
+    unsigned last_fileno = ctx_last_fileno_get(ctx);
+    unsigned last_flush_fileno = ctx_last_flush_fileno_get(ctx);
+    uint64_t group_size = 0;
+    size_t count = 0;
+
+    uv_rwlock_rdlock(&ctx->datafiles.rwlock);
+
+    // the first datafile is the next to be rotated, there is no point compacting it
+    struct rrdengine_datafile *df = ctx->datafiles.first ? ctx->datafiles.first->next : NULL;
+    for(; df && count < COMPACTION_MAX_DATAFILES ; df = df->next) {
+        spinlock_lock(&df->writers.spinlock);
+        bool has_writers = df->writers.running || df->writers.flushed_to_open_running;
+        spinlock_unlock(&df->writers.spinlock);
+
+        spinlock_lock(&df->users.spinlock);
+        bool available = df->users.available;
+        spinlock_unlock(&df->users.spinlock);
+
+        bool eligible = df->fileno != last_fileno &&
+                        df->fileno != last_flush_fileno &&
+                        !df->compacted &&
+                        !df->archived &&
+                        !df->compacting &&
+                        !has_writers &&
+                        available &&
+                        journalfile_v2_data_available(df->journalfile);
+
+        if(!eligible || group_size + df->pos > target_size) {
+            if(count)
+                break;
+
+            if(!eligible)
+                continue;
+        }
+
+        group[count++] = df;
+        group_size += df->pos;
+    }
+
+    uv_rwlock_rdunlock(&ctx->datafiles.rwlock);
+
+    return count;
+}
+
+void datafiles_compact(struct rrdengine_instance *ctx) {
+    struct rrdengine_datafile *group[COMPACTION_MAX_DATAFILES];
+    char path[RRDENG_PATH_MAX];
+
+    size_t count = compaction_group_select(ctx, group);
+    if(!count)
+        return;
+
+    struct compaction_state cs = {
+        .ctx = ctx,
+        .io.started_ut = now_monotonic_usec(),
+    };
+    cs.out.payload = mallocz(COMPACTION_MAX_EXTENT_PAYLOAD);
+
+    struct rrdengine_datafile *df = datafile_alloc_and_init(ctx, 1, group[0]->fileno);
+    df->stripe = group[0]->stripe;
+    df->compacting = true;
+    df->compacted = true;
+    cs.df = df;
+
+    if(create_data_file(df) != 0) {
+        cs.df = NULL;
+        freez(df);
+        compaction_state_cleanup(&cs);
+        return;
+    }
+
+    if(journalfile_create(journalfile_alloc_and_init(df), df) != 0) {
+        // journalfile_create() has deleted it already
+        freez(df->journalfile);
+        df->journalfile = NULL;
+        goto failed;
+    }
+
+    generate_datafilepath(df, path, sizeof(path));
+    netdata_log_info("DBENGINE: compacting %zu datafiles of tier %d, starting from %u, into \"%s\"",
+                     count, ctx->config.tier, group[0]->fileno, path);
+
+    for(size_t i = 0; i < count; i++) {
+        if(!compaction_datafile_copy(&cs, group[i]))
+            goto failed;
+    }
+
+    if(!compaction_extent_flush(&cs) ||
+        !compaction_fsync(ctx, df->file) ||
+        !compaction_fsync(ctx, df->journalfile->file))
+        goto failed;
+
+    if(!cs.pages) {
+        // none of the pages are needed anymore
+        compaction_files_destroy(df);
+        freez(df);
+        compaction_state_cleanup(&cs);
+
+        for(size_t i = 0; i < count; i++)
+            datafile_delete(ctx, group[i], false, true);
+
+        return;
+    }
+
+    journalfile_migrate_to_v2_callback((Word_t)ctx, df->fileno, ctx->config.page_type,
+                                       cs.JudyL_metrics, cs.JudyL_extents_pos,
+                                       cs.extents, cs.metrics, cs.pages, df->journalfile);
+
+    // the journal v2 builder sets the size when it has written the file
+    bool indexed = df->journalfile->mmap.size != 0;
+    df->journalfile->mmap.size = 0;
+
+    if(!indexed || !ctx_is_available_for_queries(ctx))
+        goto failed;
+
+    compaction_state_cleanup(&cs);
+
+    if(!compaction_swap(ctx, group, count, df)) {
+        compaction_files_destroy(df);
+        freez(df);
+        return;
+    }
+
+    netdata_log_info("DBENGINE: compacted %zu datafiles of tier %d into datafile %u, "
+                     "pages kept %zu, dropped %zu, read %0.2f MiB, written %0.2f MiB",
+                     count, ctx->config.tier, df->fileno,
+                     cs.pages, cs.stats.pages_dropped,
+                     (double)cs.stats.bytes_read / 1024.0 / 1024.0,
+                     (double)cs.stats.bytes_written / 1024.0 / 1024.0);
+
+    return;
+
+failed:
+    generate_datafilepath(df, path, sizeof(path));
+    netdata_log_error("DBENGINE: compaction into \"%s\" failed or was interrupted, the original datafiles are kept", path);
+    compaction_files_destroy(df);
+    freez(df);
+    compaction_state_cleanup(&cs);
+}
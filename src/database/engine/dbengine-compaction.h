@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_DBENGINE_COMPACTION_H
+#define NETDATA_DBENGINE_COMPACTION_H
+
+struct rrdengine_instance;
+
+extern bool dbengine_use_compaction;
+extern int dbengine_compaction_compression_level;
+extern size_t dbengine_compaction_io_budget_mb;     // MiB per second read and written, 0 = unlimited
+
+// rewrites the oldest group of consecutive datafiles not compacted yet into one,
+// dropping the pages that are not needed anymore and re-compressing the rest
+// runs in a libuv worker, mutually exclusive with the rotation of the tier
+void datafiles_compact(struct rrdengine_instance *ctx);
+
+#endif //NETDATA_DBENGINE_COMPACTION_H
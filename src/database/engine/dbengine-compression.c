@@ -9,9 +9,302 @@
 
 #ifdef ENABLE_ZSTD
 #include <zstd.h>
+#include <zdict.h>
 #define DBENGINE_ZSTD_DEFAULT_COMPRESSION_LEVEL 3
 #endif
 
+bool dbengine_use_compression_dictionaries = false;
+
+// ----------------------------------------------------------------------------
+// ZSTD dictionaries, trained per tier from the payload of the extents flushed
+
+#define DBENGINE_DICTIONARY_PREFIX "extent-dictionary-"
+#define DBENGINE_DICTIONARY_EXTENSION ".zdict"
+#define DBENGINE_DICTIONARIES_MAX 16
+#define DBENGINE_DICTIONARY_SIZE (32 * 1024)
+#define DBENGINE_DICTIONARY_SAMPLE_SIZE RRDENG_BLOCK_SIZE
+#define DBENGINE_DICTIONARY_TRAINING_BYTES (100 * DBENGINE_DICTIONARY_SIZE)
+#define DBENGINE_DICTIONARY_TRAINING_SAMPLES (2 * DBENGINE_DICTIONARY_TRAINING_BYTES / DBENGINE_DICTIONARY_SAMPLE_SIZE)
+
+#ifdef ENABLE_ZSTD
+struct dbengine_dictionary {
+    unsigned id;                    // the ZSTD dictionary id, as found in the compressed frames
+    unsigned version;               // the version of the file it was loaded from
+    ZSTD_CDict *cdict;
+    ZSTD_DDict *ddict;
+};
+
+struct dbengine_compression_dictionaries {
+    // dictionaries are only appended, so that readers can use them without locks
+    size_t used;
+    struct dbengine_dictionary array[DBENGINE_DICTIONARIES_MAX];
+
+    struct {
+        SPINLOCK spinlock;
+        bool running;
+        size_t samples;
+        size_t bytes;
+        uint8_t *buffer;
+        size_t *sizes;
+    } training;
+};
+
+static __thread ZSTD_CCtx *zstd_cctx = NULL;
+static __thread ZSTD_DCtx *zstd_dctx = NULL;
+
+static void dictionary_filepath(struct rrdengine_instance *ctx, unsigned version, char *str, size_t maxlen) {
+    (void) snprintfz(str, maxlen - 1, "%s/" DBENGINE_DICTIONARY_PREFIX "%05u" DBENGINE_DICTIONARY_EXTENSION,
+                     ctx->config.dbfiles_path, version);
+}
+
+static struct dbengine_dictionary *dictionary_latest(struct dbengine_compression_dictionaries *dicts) {
+    size_t used = __atomic_load_n(&dicts->used, __ATOMIC_ACQUIRE);
+    return used ? &dicts->array[used - 1] : NULL;
+}
+
+static struct dbengine_dictionary *dictionary_find(struct dbengine_compression_dictionaries *dicts, unsigned id) {
+    size_t used = __atomic_load_n(&dicts->used, __ATOMIC_ACQUIRE);
+    for(size_t i = 0; i < used ; i++) {
+        if(dicts->array[i].id == id)
+            return &dicts->array[i];
+    }
+
+    return NULL;
+}
+
+static bool dictionary_add(struct rrdengine_instance *ctx, struct dbengine_compression_dictionaries *dicts, unsigned version, const void *data, size_t size) {
+    unsigned id = ZDICT_getDictID(data, size);
+    if(!id) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE: tier %d compression dictionary version %u is not valid, ignoring it",
+               ctx->config.tier, version);
+        return false;
+    }
+
+    size_t used = __atomic_load_n(&dicts->used, __ATOMIC_RELAXED);
+    if(used >= DBENGINE_DICTIONARIES_MAX) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE: tier %d has too many compression dictionaries, ignoring version %u",
+               ctx->config.tier, version);
+        return false;
+    }
+
+    struct dbengine_dictionary *d = &dicts->array[used];
+    d->id = id;
+    d->version = version;
+    d->cdict = ZSTD_createCDict(data, size, DBENGINE_ZSTD_DEFAULT_COMPRESSION_LEVEL);
+    d->ddict = ZSTD_createDDict(data, size);
+
+    if(!d->cdict || !d->ddict) {
+        ZSTD_freeCDict(d->cdict);
+        ZSTD_freeDDict(d->ddict);
+        memset(d, 0, sizeof(*d));
+        return false;
+    }
+
+    __atomic_store_n(&dicts->used, used + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static int dictionary_version_cmp(const void *a, const void *b) {
+    unsigned va = *(const unsigned *)a, vb = *(const unsigned *)b;
+    return (va > vb) - (va < vb);
+}
+
+static void dictionaries_load(struct rrdengine_instance *ctx, struct dbengine_compression_dictionaries *dicts) {
+    uv_fs_t req;
+    uv_dirent_t dent;
+
+    int ret = uv_fs_scandir(NULL, &req, ctx->config.dbfiles_path, 0, NULL);
+    if (ret < 0) {
+        uv_fs_req_cleanup(&req);
+        return;
+    }
+
+    unsigned versions[DBENGINE_DICTIONARIES_MAX];
+    size_t found = 0;
+    while(UV_EOF != uv_fs_scandir_next(&req, &dent) && found < DBENGINE_DICTIONARIES_MAX) {
+        unsigned version;
+        if(sscanf(dent.name, DBENGINE_DICTIONARY_PREFIX "%u" DBENGINE_DICTIONARY_EXTENSION, &version) == 1)
+            versions[found++] = version;
+    }
+    uv_fs_req_cleanup(&req);
+
+    qsort(versions, found, sizeof(*versions), dictionary_version_cmp);
+
+    for(size_t i = 0; i < found ; i++) {
+        char path[RRDENG_PATH_MAX];
+        dictionary_filepath(ctx, versions[i], path, sizeof(path));
+
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if(fd == -1) {
+            nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE: cannot open compression dictionary '%s'", path);
+            continue;
+        }
+
+        void *data = mallocz(DBENGINE_DICTIONARY_SIZE);
+        ssize_t size = read(fd, data, DBENGINE_DICTIONARY_SIZE);
+        close(fd);
+
+        if(size > 0 && dictionary_add(ctx, dicts, versions[i], data, (size_t)size))
+            nd_log(NDLS_DAEMON, NDLP_INFO,
+                   "DBENGINE: tier %d loaded compression dictionary '%s' (%zd bytes)",
+                   ctx->config.tier, path, size);
+
+        freez(data);
+    }
+}
+
+static bool dictionary_save(struct rrdengine_instance *ctx, unsigned version, const void *data, size_t size) {
+    char path[RRDENG_PATH_MAX], tmp[RRDENG_PATH_MAX];
+    dictionary_filepath(ctx, version, path, sizeof(path));
+    snprintfz(tmp, sizeof(tmp) - 1, "%s.tmp", path);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0664);
+    if(fd == -1) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE: cannot create compression dictionary '%s'", tmp);
+        return false;
+    }
+
+    bool ok = write(fd, data, size) == (ssize_t)size && fsync(fd) == 0;
+    close(fd);
+
+    if(!ok || rename(tmp, path) != 0) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE: cannot save compression dictionary '%s'", path);
+        unlink(tmp);
+        return false;
+    }
+
+    return true;
+}
+
+static void dictionary_train(struct rrdengine_instance *ctx, struct dbengine_compression_dictionaries *dicts) {
+    usec_t started_ut = now_monotonic_usec();
+
+    void *data = mallocz(DBENGINE_DICTIONARY_SIZE);
+    size_t size = ZDICT_trainFromBuffer(data, DBENGINE_DICTIONARY_SIZE,
+                                        dicts->training.buffer, dicts->training.sizes,
+                                        (unsigned)dicts->training.samples);
+
+    struct dbengine_dictionary *latest = dictionary_latest(dicts);
+    unsigned version = latest ? latest->version + 1 : 1;
+
+    if(ZDICT_isError(size))
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "DBENGINE: tier %d failed to train a compression dictionary from %zu samples: %s",
+               ctx->config.tier, dicts->training.samples, ZDICT_getErrorName(size));
+
+    else if(dictionary_save(ctx, version, data, size) && dictionary_add(ctx, dicts, version, data, size))
+        nd_log(NDLS_DAEMON, NDLP_INFO,
+               "DBENGINE: tier %d trained compression dictionary version %u (%zu bytes) from %zu samples in %llu ms",
+               ctx->config.tier, version, size, dicts->training.samples,
+               (unsigned long long)((now_monotonic_usec() - started_ut) / USEC_PER_MS));
+
+    freez(data);
+}
+
+static void dictionary_sample(struct rrdengine_instance *ctx, const uint8_t *payload, size_t size) {
+    struct dbengine_compression_dictionaries *dicts = ctx->compression_dictionaries;
+
+    if(!dicts || dictionary_latest(dicts) || __atomic_load_n(&dicts->training.running, __ATOMIC_RELAXED))
+        return;
+
+    bool train = false;
+
+    spinlock_lock(&dicts->training.spinlock);
+    if(!dicts->training.running) {
+        if(!dicts->training.buffer) {
+            dicts->training.buffer = mallocz(DBENGINE_DICTIONARY_TRAINING_BYTES);
+            dicts->training.sizes = mallocz(sizeof(size_t) * DBENGINE_DICTIONARY_TRAINING_SAMPLES);
+        }
+
+        // every block of the extent (usually a page) is a sample
+        for(size_t pos = 0;
+             pos < size &&
+             dicts->training.bytes < DBENGINE_DICTIONARY_TRAINING_BYTES &&
+             dicts->training.samples < DBENGINE_DICTIONARY_TRAINING_SAMPLES ;
+             pos += DBENGINE_DICTIONARY_SAMPLE_SIZE) {
+            size_t bytes = MIN(size - pos, DBENGINE_DICTIONARY_SAMPLE_SIZE);
+            bytes = MIN(bytes, DBENGINE_DICTIONARY_TRAINING_BYTES - dicts->training.bytes);
+
+            memcpy(&dicts->training.buffer[dicts->training.bytes], &payload[pos], bytes);
+            dicts->training.sizes[dicts->training.samples++] = bytes;
+            dicts->training.bytes += bytes;
+        }
+
+        if(dicts->training.bytes >= DBENGINE_DICTIONARY_TRAINING_BYTES ||
+            dicts->training.samples >= DBENGINE_DICTIONARY_TRAINING_SAMPLES)
+            train = dicts->training.running = true;
+    }
+    spinlock_unlock(&dicts->training.spinlock);
+
+    if(!train)
+        return;
+
+    // we are the only ones using the training buffers now
+    dictionary_train(ctx, dicts);
+
+    // training runs once - on failure we keep compressing without a dictionary
+    spinlock_lock(&dicts->training.spinlock);
+    freez(dicts->training.buffer);
+    freez(dicts->training.sizes);
+    dicts->training.buffer = NULL;
+    dicts->training.sizes = NULL;
+    dicts->training.samples = 0;
+    dicts->training.bytes = 0;
+    spinlock_unlock(&dicts->training.spinlock);
+}
+#endif
+
+void dbengine_compression_dictionaries_init(struct rrdengine_instance *ctx) {
+    ctx->compression_dictionaries = NULL;
+
+#ifdef ENABLE_ZSTD
+    struct dbengine_compression_dictionaries *dicts = callocz(1, sizeof(*dicts));
+    spinlock_init(&dicts->training.spinlock);
+
+    // dictionaries found on disk are always loaded, to read the extents compressed with them
+    dictionaries_load(ctx, dicts);
+
+    // training happens only when enabled and ZSTD is the wanted compression
+    if(!dicts->used && (!dbengine_use_compression_dictionaries || ctx->config.global_compress_alg != RRDENG_COMPRESSION_ZSTD))
+        __atomic_store_n(&dicts->training.running, true, __ATOMIC_RELAXED);
+
+    ctx->compression_dictionaries = dicts;
+#endif
+}
+
+void dbengine_compression_dictionaries_destroy(struct rrdengine_instance *ctx) {
+#ifdef ENABLE_ZSTD
+    struct dbengine_compression_dictionaries *dicts = ctx->compression_dictionaries;
+    if(!dicts)
+        return;
+
+    for(size_t i = 0; i < dicts->used ; i++) {
+        ZSTD_freeCDict(dicts->array[i].cdict);
+        ZSTD_freeDDict(dicts->array[i].ddict);
+    }
+
+    freez(dicts->training.buffer);
+    freez(dicts->training.sizes);
+    freez(dicts);
+#endif
+
+    ctx->compression_dictionaries = NULL;
+}
+
+uint8_t dbengine_compression_algorithm(struct rrdengine_instance *ctx) {
+#ifdef ENABLE_ZSTD
+    if(ctx->config.global_compress_alg == RRDENG_COMPRESSION_ZSTD &&
+        dbengine_use_compression_dictionaries &&
+        ctx->compression_dictionaries &&
+        dictionary_latest(ctx->compression_dictionaries))
+        return RRDENG_COMPRESSION_ZSTD_DICT;
+#endif
+
+    return ctx->config.global_compress_alg;
+}
+
 uint8_t dbengine_default_compression(void) {
 
 #ifdef ENABLE_ZSTD
@@ -35,6 +328,7 @@ bool dbengine_valid_compression_algorithm(uint8_t algorithm) {
 
 #ifdef ENABLE_ZSTD
         case RRDENG_COMPRESSION_ZSTD:
+        case RRDENG_COMPRESSION_ZSTD_DICT:
 #endif
 
             return true;
@@ -54,6 +348,7 @@ size_t dbengine_max_compressed_size(size_t uncompressed_size, uint8_t algorithm)
 
 #ifdef ENABLE_ZSTD
         case RRDENG_COMPRESSION_ZSTD:
+        case RRDENG_COMPRESSION_ZSTD_DICT:
             return ZSTD_compressBound(uncompressed_size);
 #endif
 
@@ -68,7 +363,18 @@ size_t dbengine_max_compressed_size(size_t uncompressed_size, uint8_t algorithm)
     }
 }
 
-size_t dbengine_compress(void *payload, size_t uncompressed_size, uint8_t algorithm) {
+size_t dbengine_compress(struct rrdengine_instance *ctx __maybe_unused, void *payload, size_t uncompressed_size, uint8_t algorithm) {
+#ifdef ENABLE_ZSTD
+    if(algorithm == RRDENG_COMPRESSION_ZSTD)
+        dictionary_sample(ctx, payload, uncompressed_size);
+
+    return dbengine_compress_with_level(ctx, payload, uncompressed_size, algorithm, DBENGINE_ZSTD_DEFAULT_COMPRESSION_LEVEL);
+#else
+    return dbengine_compress_with_level(ctx, payload, uncompressed_size, algorithm, 0);
+#endif
+}
+
+size_t dbengine_compress_with_level(struct rrdengine_instance *ctx __maybe_unused, void *payload, size_t uncompressed_size, uint8_t algorithm, int level __maybe_unused) {
     // the result should be stored in the payload
     // the caller must have called dbengine_max_compressed_size() to make sure the
     // payload is big enough to fit the max size needed.
@@ -99,8 +405,37 @@ size_t dbengine_compress(void *payload, size_t uncompressed_size, uint8_t algori
             struct extent_buffer *eb = extent_buffer_get(max_compressed_size);
             void *compressed_buf = eb->data;
 
-            size_t compressed_size = ZSTD_compress(compressed_buf, max_compressed_size, payload, uncompressed_size,
-                                                   DBENGINE_ZSTD_DEFAULT_COMPRESSION_LEVEL);
+            size_t compressed_size = ZSTD_compress(compressed_buf, max_compressed_size, payload, uncompressed_size, level);
+
+            if (ZSTD_isError(compressed_size)) {
+                internal_fatal(true, "DBENGINE: ZSTD compression error %s", ZSTD_getErrorName(compressed_size));
+                compressed_size = 0;
+            }
+
+            if(compressed_size > 0 && compressed_size < uncompressed_size)
+                memcpy(payload, compressed_buf, compressed_size);
+            else
+                compressed_size = 0;
+
+            extent_buffer_release(eb);
+            return compressed_size;
+        }
+
+        case RRDENG_COMPRESSION_ZSTD_DICT: {
+            struct dbengine_dictionary *d = dictionary_latest(ctx->compression_dictionaries);
+            internal_fatal(!d, "DBENGINE: ZSTD dictionary compression requested without a dictionary");
+            if(!d)
+                return 0;
+
+            if(unlikely(!zstd_cctx))
+                zstd_cctx = ZSTD_createCCtx();
+
+            size_t max_compressed_size = dbengine_max_compressed_size(uncompressed_size, algorithm);
+            struct extent_buffer *eb = extent_buffer_get(max_compressed_size);
+            void *compressed_buf = eb->data;
+
+            size_t compressed_size = ZSTD_compress_usingCDict(zstd_cctx, compressed_buf, max_compressed_size,
+                                                              payload, uncompressed_size, d->cdict);
 
             if (ZSTD_isError(compressed_size)) {
                 internal_fatal(true, "DBENGINE: ZSTD compression error %s", ZSTD_getErrorName(compressed_size));
@@ -128,7 +463,7 @@ size_t dbengine_compress(void *payload, size_t uncompressed_size, uint8_t algori
     }
 }
 
-size_t dbengine_decompress(void *dst, void *src, size_t dst_size, size_t src_size, uint8_t algorithm) {
+size_t dbengine_decompress(struct rrdengine_instance *ctx __maybe_unused, void *dst, void *src, size_t dst_size, size_t src_size, uint8_t algorithm) {
     switch(algorithm) {
 
 #ifdef ENABLE_LZ4
@@ -156,6 +491,32 @@ size_t dbengine_decompress(void *dst, void *src, size_t dst_size, size_t src_siz
 
             return decompressed_size;
         }
+
+        case RRDENG_COMPRESSION_ZSTD_DICT: {
+            unsigned id = ZSTD_getDictID_fromFrame(src, src_size);
+            struct dbengine_dictionary *d = ctx->compression_dictionaries ? dictionary_find(ctx->compression_dictionaries, id) : NULL;
+            if(!d) {
+                nd_log_limit_static_global_var(erl, 60, 0);
+                nd_log_limit(&erl, NDLS_DAEMON, NDLP_ERR,
+                             "DBENGINE: tier %d extent is compressed with ZSTD dictionary %u, which is not available",
+                             ctx->config.tier, id);
+                return 0;
+            }
+
+            if(unlikely(!zstd_dctx))
+                zstd_dctx = ZSTD_createDCtx();
+
+            size_t decompressed_size = ZSTD_decompress_usingDDict(zstd_dctx, dst, dst_size, src, src_size, d->ddict);
+
+            if (ZSTD_isError(decompressed_size)) {
+                nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE: ZSTD decompression error %s",
+                       ZSTD_getErrorName(decompressed_size));
+
+                decompressed_size = 0;
+            }
+
+            return decompressed_size;
+        }
 #endif
 
         case RRDENG_COMPRESSION_NONE:
@@ -3,13 +3,24 @@
 #ifndef NETDATA_DBENGINE_COMPRESSION_H
 #define NETDATA_DBENGINE_COMPRESSION_H
 
+struct rrdengine_instance;
+
+extern bool dbengine_use_compression_dictionaries;
+
 uint8_t dbengine_default_compression(void);
 
 bool dbengine_valid_compression_algorithm(uint8_t algorithm);
 
 size_t dbengine_max_compressed_size(size_t uncompressed_size, uint8_t algorithm);
-size_t dbengine_compress(void *payload, size_t uncompressed_size, uint8_t algorithm);
+size_t dbengine_compress(struct rrdengine_instance *ctx, void *payload, size_t uncompressed_size, uint8_t algorithm);
+
+// like dbengine_compress(), but ZSTD compresses at the given level (the level of dictionaries is fixed)
+size_t dbengine_compress_with_level(struct rrdengine_instance *ctx, void *payload, size_t uncompressed_size, uint8_t algorithm, int level);
+
+size_t dbengine_decompress(struct rrdengine_instance *ctx, void *dst, void *src, size_t dst_size, size_t src_size, uint8_t algorithm);
 
-size_t dbengine_decompress(void *dst, void *src, size_t dst_size, size_t src_size, uint8_t algorithm);
+void dbengine_compression_dictionaries_init(struct rrdengine_instance *ctx);
+void dbengine_compression_dictionaries_destroy(struct rrdengine_instance *ctx);
+uint8_t dbengine_compression_algorithm(struct rrdengine_instance *ctx);
 
 #endif //NETDATA_DBENGINE_COMPRESSION_H
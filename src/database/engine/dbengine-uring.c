@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrdengine.h"
+#include "dbengine-uring.h"
+
+#ifdef ENABLE_LIBURING
+#include <liburing.h>
+#endif
+
+bool dbengine_use_io_uring = false;
+
+#ifdef ENABLE_LIBURING
+
+// ----------------------------------------------------------------------------
+// io_uring extent reads
+//
+// Every thread reading extents gets its own ring and a single aligned buffer
+// registered with it, so that reads are READ_FIXED into memory the kernel has
+// already pinned. The datafiles are opened with O_DIRECT, so the data go from
+// the disk straight into this buffer. Extents larger than the buffer, or
+// threads that fail to set up a ring, use the libuv path.
+
+#define DBENGINE_URING_QUEUE_DEPTH 4
+#define DBENGINE_URING_BUFFER_SIZE (1024 * 1024)
+
+typedef enum {
+    DBENGINE_URING_UNINITIALIZED = 0,
+    DBENGINE_URING_READY,
+    DBENGINE_URING_FAILED,
+} DBENGINE_URING_STATE;
+
+static __thread DBENGINE_URING_STATE uring_state = DBENGINE_URING_UNINITIALIZED;
+static __thread struct io_uring uring_ring;
+static __thread void *uring_buffer = NULL;
+
+static bool dbengine_uring_thread_init(void) {
+    if(likely(uring_state == DBENGINE_URING_READY))
+        return true;
+
+    if(uring_state == DBENGINE_URING_FAILED)
+        return false;
+
+    int ret = io_uring_queue_init(DBENGINE_URING_QUEUE_DEPTH, &uring_ring, 0);
+    if(ret < 0) {
+        nd_log_limit_static_global_var(erl, 60, 0);
+        nd_log_limit(&erl, NDLS_DAEMON, NDLP_ERR,
+                     "DBENGINE: io_uring_queue_init() failed: %s - using libuv for extent reads on this thread",
+                     strerror(-ret));
+        uring_state = DBENGINE_URING_FAILED;
+        return false;
+    }
+
+    ret = posix_memalign(&uring_buffer, RRDFILE_ALIGNMENT, DBENGINE_URING_BUFFER_SIZE);
+    if (unlikely(ret))
+        fatal("DBENGINE: posix_memalign(): %s", strerror(ret));
+
+    struct iovec iov = {
+            .iov_base = uring_buffer,
+            .iov_len = DBENGINE_URING_BUFFER_SIZE,
+    };
+
+    ret = io_uring_register_buffers(&uring_ring, &iov, 1);
+    if(ret < 0) {
+        nd_log_limit_static_global_var(erl, 60, 0);
+        nd_log_limit(&erl, NDLS_DAEMON, NDLP_ERR,
+                     "DBENGINE: io_uring_register_buffers() failed: %s - using libuv for extent reads on this thread",
+                     strerror(-ret));
+        io_uring_queue_exit(&uring_ring);
+        posix_memfree(uring_buffer);
+        uring_buffer = NULL;
+        uring_state = DBENGINE_URING_FAILED;
+        return false;
+    }
+
+    uring_state = DBENGINE_URING_READY;
+    return true;
+}
+
+void *dbengine_uring_read(uv_file file, uint64_t pos, size_t size_bytes, bool *io_error) {
+    *io_error = false;
+
+    if(!dbengine_use_io_uring || size_bytes > DBENGINE_URING_BUFFER_SIZE || !dbengine_uring_thread_init())
+        return NULL;
+
+    size_t done = 0;
+    while(done < size_bytes) {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&uring_ring);
+        if(unlikely(!sqe))
+            return NULL;
+
+        io_uring_prep_read_fixed(sqe, file, (char *)uring_buffer + done,
+                                 (unsigned)(size_bytes - done), pos + done, 0);
+
+        int ret = io_uring_submit_and_wait(&uring_ring, 1);
+        if(unlikely(ret < 0))
+            return NULL;
+
+        struct io_uring_cqe *cqe = NULL;
+        ret = io_uring_wait_cqe(&uring_ring, &cqe);
+        if(unlikely(ret < 0))
+            return NULL;
+
+        int res = cqe->res;
+        io_uring_cqe_seen(&uring_ring, cqe);
+
+        if(unlikely(res == -EINTR || res == -EAGAIN))
+            continue;
+
+        if(unlikely(res <= 0)) {
+            // a short read at the end of the file is fine, a failure is not
+            if(res < 0 || !done)
+                *io_error = true;
+            break;
+        }
+
+        done += (size_t)res;
+    }
+
+    return *io_error ? NULL : uring_buffer;
+}
+
+#else // !ENABLE_LIBURING
+
+void *dbengine_uring_read(uv_file file __maybe_unused, uint64_t pos __maybe_unused, size_t size_bytes __maybe_unused, bool *io_error) {
+    *io_error = false;
+    return NULL;
+}
+
+#endif // ENABLE_LIBURING
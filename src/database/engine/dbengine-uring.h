@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_DBENGINE_URING_H
+#define NETDATA_DBENGINE_URING_H
+
+extern bool dbengine_use_io_uring;
+
+// reads size_bytes (a multiple of RRDENG_BLOCK_SIZE) at pos into a buffer
+// owned by the calling thread; the buffer is valid until the next call
+// returns NULL when io_uring cannot serve the request - the caller should
+// then use the libuv path; sets *io_error when the read itself failed
+void *dbengine_uring_read(uv_file file, uint64_t pos, size_t size_bytes, bool *io_error);
+
+#endif //NETDATA_DBENGINE_URING_H
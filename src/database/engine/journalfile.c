@@ -62,14 +62,16 @@ void journalfile_v1_extent_write(struct rrdengine_instance *ctx, struct rrdengin
 
 void journalfile_v2_generate_path(struct rrdengine_datafile *datafile, char *str, size_t maxlen)
 {
-    (void) snprintfz(str, maxlen, "%s/" WALFILE_PREFIX RRDENG_FILE_NUMBER_PRINT_TMPL WALFILE_EXTENSION_V2,
-                    datafile->ctx->config.dbfiles_path, datafile->tier, datafile->fileno);
+    (void) snprintfz(str, maxlen, "%s/%s" WALFILE_PREFIX RRDENG_FILE_NUMBER_PRINT_TMPL WALFILE_EXTENSION_V2,
+                    datafile_directory(datafile), datafile->compacting ? DATAFILE_COMPACTION_PREFIX : "",
+                    datafile->tier, datafile->fileno);
 }
 
 void journalfile_v1_generate_path(struct rrdengine_datafile *datafile, char *str, size_t maxlen)
 {
-    (void) snprintfz(str, maxlen - 1, "%s/" WALFILE_PREFIX RRDENG_FILE_NUMBER_PRINT_TMPL WALFILE_EXTENSION,
-                    datafile->ctx->config.dbfiles_path, datafile->tier, datafile->fileno);
+    (void) snprintfz(str, maxlen - 1, "%s/%s" WALFILE_PREFIX RRDENG_FILE_NUMBER_PRINT_TMPL WALFILE_EXTENSION,
+                    datafile_directory(datafile), datafile->compacting ? DATAFILE_COMPACTION_PREFIX : "",
+                    datafile->tier, datafile->fileno);
 }
 
 // ----------------------------------------------------------------------------
@@ -592,7 +594,11 @@ int journalfile_create(struct rrdengine_journalfile *journalfile, struct rrdengi
     }
     memset(superblock, 0, sizeof(*superblock));
     (void) strncpy(superblock->magic_number, RRDENG_JF_MAGIC, RRDENG_MAGIC_SZ);
-    (void) strncpy(superblock->version, RRDENG_JF_VER, RRDENG_VER_SZ);
+    // the pair is created together, the journal follows the checksum of its datafile
+    journalfile->checksum = datafile->checksum;
+    (void) strncpy(superblock->version,
+                   journalfile->checksum == RRDENG_CHECKSUM_CRC32C ? RRDENG_JF_VER_CRC32C : RRDENG_JF_VER,
+                   RRDENG_VER_SZ);
 
     iov = uv_buf_init((void *)superblock, sizeof(*superblock));
 
@@ -616,7 +622,7 @@ int journalfile_create(struct rrdengine_journalfile *journalfile, struct rrdengi
     return 0;
 }
 
-static int journalfile_check_superblock(uv_file file)
+static int journalfile_check_superblock(uv_file file, RRDENG_CHECKSUM_TYPE *checksum)
 {
     int ret;
     struct rrdeng_jf_sb *superblock = NULL;
@@ -641,11 +647,15 @@ static int journalfile_check_superblock(uv_file file)
 
     char jf_magic[RRDENG_MAGIC_SZ] = RRDENG_JF_MAGIC;
     char jf_ver[RRDENG_VER_SZ] = RRDENG_JF_VER;
+    char jf_ver_crc32c[RRDENG_VER_SZ] = RRDENG_JF_VER_CRC32C;
+    bool ver_crc32 = strncmp(superblock->version, jf_ver, RRDENG_VER_SZ) == 0;
+    bool ver_crc32c = strncmp(superblock->version, jf_ver_crc32c, RRDENG_VER_SZ) == 0;
     if (strncmp(superblock->magic_number, jf_magic, RRDENG_MAGIC_SZ) != 0 ||
-        strncmp(superblock->version, jf_ver, RRDENG_VER_SZ) != 0) {
+        (!ver_crc32 && !ver_crc32c)) {
         nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE: File has invalid superblock.");
         ret = UV_EINVAL;
     } else {
+        *checksum = ver_crc32c ? RRDENG_CHECKSUM_CRC32C : RRDENG_CHECKSUM_CRC32;
         ret = 0;
     }
     error:
@@ -776,12 +786,13 @@ static unsigned journalfile_replay_transaction(struct rrdengine_instance *ctx, s
         return 0;
     }
     jf_trailer = buf + sizeof(*jf_header) + payload_length;
-    crc = crc32(0L, Z_NULL, 0);
-    crc = crc32(crc, buf, sizeof(*jf_header) + payload_length);
+    crc = rrdeng_checksum(journalfile->checksum, buf, sizeof(*jf_header) + payload_length);
     ret = crc32cmp(jf_trailer->checksum, crc);
-    netdata_log_debug(D_RRDENGINE, "Transaction %"PRIu64" was read from disk. CRC32 check: %s", *id, ret ? "FAILED" : "SUCCEEDED");
+    netdata_log_debug(D_RRDENGINE, "Transaction %"PRIu64" was read from disk. %s check: %s", *id,
+                      rrdeng_checksum_name(journalfile->checksum), ret ? "FAILED" : "SUCCEEDED");
     if (unlikely(ret)) {
-        netdata_log_error("DBENGINE: transaction %"PRIu64" was read from disk. CRC32 check: FAILED", *id);
+        netdata_log_error("DBENGINE: transaction %"PRIu64" was read from disk. %s check: FAILED", *id,
+                          rrdeng_checksum_name(journalfile->checksum));
         return size_bytes;
     }
     switch (jf_header->type) {
@@ -1281,6 +1292,128 @@ static void *journalfile_v2_write_descriptors(struct journal_v2_header *j2_heade
     return data_page;
 }
 
+// ----------------------------------------------------------------------------
+// writing the metrics and their pages of a v2 journal file in parallel
+
+#define JOURNAL_V2_METRICS_PER_WRITER 10000
+#define JOURNAL_V2_MAX_WRITERS 4
+
+struct journal_v2_metrics_writer {
+    struct journal_v2_header *j2_header;
+    uint8_t *data_start;
+    uint32_t metrics_offset;
+    struct journal_metric_list_to_sort *uuid_list;
+    uint32_t *pages_offsets;        // the offset of the pages of each metric, with one more for the end
+    size_t from;
+    size_t to;
+    bool ok;
+};
+
+static bool journalfile_v2_write_metrics_range(struct journal_v2_metrics_writer *w) {
+    uint8_t *data_start = w->data_start;
+
+    for (size_t i = w->from; i < w->to; i++) {
+        struct jv2_metrics_info *metric_info = w->uuid_list[i].metric_info;
+        uint32_t pages_offset = w->pages_offsets[i];
+
+        uint8_t *data = data_start + w->metrics_offset + i * sizeof(struct journal_metric_list);
+
+        // Calculate current UUID offset from start of file. We will store this in the data page header
+        uint32_t uuid_offset = data - data_start;
+
+        struct journal_metric_list *current_metric = (void *) data;
+        // Write the UUID we are processing
+        if (unlikely(!journalfile_v2_write_metric_page(w->j2_header, data, metric_info, pages_offset)))
+            return false;
+
+        // Next we will write
+        //   Header
+        //   Detailed entries (descr @ time)
+        //   Trailer (checksum)
+
+        // Keep the page_list_header, to be used for migration when where agent is running
+        metric_info->page_list_header = pages_offset;
+        // Write page header
+        void *metric_page = journalfile_v2_write_data_page_header(w->j2_header, data_start + pages_offset, metric_info,
+                                                                  uuid_offset);
+
+        // Start writing descr @ time
+        void *page_trailer = journalfile_v2_write_descriptors(w->j2_header, metric_page, metric_info, current_metric);
+        if (unlikely(!page_trailer))
+            return false;
+
+        // Trailer (checksum)
+        uint8_t *next_page_address = journalfile_v2_write_data_page_trailer(w->j2_header, page_trailer,
+                                                                            data_start + pages_offset);
+
+        // Verify we are at the right location
+        if (w->pages_offsets[i + 1] != (uint32_t)(next_page_address - data_start))
+            return false;
+    }
+
+    return true;
+}
+
+static void *journalfile_v2_metrics_writer_thread(void *ptr) {
+    struct journal_v2_metrics_writer *w = ptr;
+    w->ok = journalfile_v2_write_metrics_range(w);
+    return NULL;
+}
+
+// The sections of the metrics do not overlap, so big files are split into
+// ranges of metrics written by parallel threads; the calling thread writes
+// the first range itself.
+static bool journalfile_v2_write_metrics(struct journal_v2_header *j2_header, uint8_t *data_start, uint32_t metrics_offset,
+                                         struct journal_metric_list_to_sort *uuid_list, uint32_t *pages_offsets,
+                                         size_t number_of_metrics) {
+    size_t writers = number_of_metrics / JOURNAL_V2_METRICS_PER_WRITER;
+    if (writers > JOURNAL_V2_MAX_WRITERS)
+        writers = JOURNAL_V2_MAX_WRITERS;
+    if (writers < 1)
+        writers = 1;
+
+    struct journal_v2_metrics_writer w[JOURNAL_V2_MAX_WRITERS];
+    ND_THREAD *threads[JOURNAL_V2_MAX_WRITERS] = { NULL };
+    size_t per_writer = (number_of_metrics + writers - 1) / writers;
+
+    for (size_t t = 0; t < writers; t++) {
+        w[t] = (struct journal_v2_metrics_writer) {
+            .j2_header = j2_header,
+            .data_start = data_start,
+            .metrics_offset = metrics_offset,
+            .uuid_list = uuid_list,
+            .pages_offsets = pages_offsets,
+            .from = MIN(t * per_writer, number_of_metrics),
+            .to = MIN((t + 1) * per_writer, number_of_metrics),
+            .ok = false,
+        };
+
+        if (t) {
+            char tag[15 + 1];
+            snprintfz(tag, sizeof(tag) - 1, "JV2WR[%zu]", t);
+            threads[t] = nd_thread_create(tag, NETDATA_THREAD_OPTION_JOINABLE | NETDATA_THREAD_OPTION_DONT_LOG,
+                                          journalfile_v2_metrics_writer_thread, &w[t]);
+        }
+    }
+
+    w[0].ok = journalfile_v2_write_metrics_range(&w[0]);
+
+    bool ok = true;
+    for (size_t t = 0; t < writers; t++) {
+        if (t) {
+            if (threads[t])
+                nd_thread_join(threads[t]);
+            else
+                // the thread could not be created, write its range here
+                w[t].ok = journalfile_v2_write_metrics_range(&w[t]);
+        }
+
+        ok = ok && w[t].ok;
+    }
+
+    return ok;
+}
+
 // Migrate the journalfile pointed by datafile
 // activate : make the new file active immediately
 //            journafile data will be set and descriptors (if deleted) will be repopulated as needed
@@ -1408,47 +1541,22 @@ void journalfile_migrate_to_v2_callback(Word_t section, unsigned datafile_fileno
 
     uint32_t resize_file_to = total_file_size;
 
-    for (Index = 0; Index < number_of_metrics; Index++) {
-        metric_info = uuid_list[Index].metric_info;
-
-        // Calculate current UUID offset from start of file. We will store this in the data page header
-        uint32_t uuid_offset = data - data_start;
-
-        struct journal_metric_list *current_metric = (void *) data;
-        // Write the UUID we are processing
-        data  = (void *) journalfile_v2_write_metric_page(&j2_header, data, metric_info, pages_offset);
-        if (unlikely(!data))
-            break;
-
-        // Next we will write
-        //   Header
-        //   Detailed entries (descr @ time)
-        //   Trailer (checksum)
-
-        // Keep the page_list_header, to be used for migration when where agent is running
-        metric_info->page_list_header = pages_offset;
-        // Write page header
-        void *metric_page = journalfile_v2_write_data_page_header(&j2_header, data_start + pages_offset, metric_info,
-                                                                  uuid_offset);
-
-        // Start writing descr @ time
-        void *page_trailer = journalfile_v2_write_descriptors(&j2_header, metric_page, metric_info, current_metric);
-        if (unlikely(!page_trailer))
-            break;
-
-        // Trailer (checksum)
-        uint8_t *next_page_address = journalfile_v2_write_data_page_trailer(&j2_header, page_trailer,
-                                                                            data_start + pages_offset);
+    // the metrics are written by a few threads in parallel, each in its own range,
+    // so the position of each metric and its pages has to be known in advance
+    uint32_t *metric_pages_offsets = mallocz((number_of_metrics + 1) * sizeof(uint32_t));
+    metric_pages_offsets[0] = pages_offset;
+    for (Index = 0; Index < number_of_metrics; Index++)
+        metric_pages_offsets[Index + 1] = metric_pages_offsets[Index] +
+            uuid_list[Index].metric_info->number_of_pages * sizeof(struct journal_page_list) +
+            sizeof(struct journal_page_header) + sizeof(struct journal_v2_block_trailer);
+
+    if (journalfile_v2_write_metrics(&j2_header, data_start, metrics_offset, uuid_list, metric_pages_offsets, number_of_metrics))
+        data = data_start + metric_offset_trailer;
+    else
+        // make sure checks fail so that we abort
+        data = data_start;
 
-        // Calculate start of the pages start for next descriptor
-        pages_offset += (metric_info->number_of_pages * (sizeof(struct journal_page_list)) + sizeof(struct journal_page_header) + sizeof(struct journal_v2_block_trailer));
-        // Verify we are at the right location
-        if (pages_offset != (uint32_t)(next_page_address - data_start)) {
-            // make sure checks fail so that we abort
-            data = data_start;
-            break;
-        }
-    }
+    freez(metric_pages_offsets);
 
     if (data == data_start + metric_offset_trailer) {
         internal_error(true, "DBENGINE: WRITE METRICS AND PAGES  %llu", (now_monotonic_usec() - start_loading) / USEC_PER_MS);
@@ -1475,6 +1583,17 @@ void journalfile_migrate_to_v2_callback(Word_t section, unsigned datafile_fileno
 
         netdata_log_info("DBENGINE: migrated journal file '%s', file size %zu", path, total_file_size);
 
+        if(datafile->compacting) {
+            // compaction activates the index after renaming it to its final name,
+            // it only needs to know the index has been written
+            msync(data_start, total_file_size, MS_SYNC);
+            netdata_munmap(data_start, total_file_size);
+            close(fd_v2);
+            journalfile->mmap.size = total_file_size;
+            freez(uuid_list);
+            return;
+        }
+
         // msync(data_start, total_file_size, MS_SYNC);
         journalfile_v2_data_set(journalfile, fd_v2, data_start, total_file_size);
 
@@ -1499,11 +1618,12 @@ void journalfile_migrate_to_v2_callback(Word_t section, unsigned datafile_fileno
 
     int ret = truncate(path, (long) resize_file_to);
     if (ret < 0) {
-        ctx_current_disk_space_increase(ctx, total_file_size);
+        if(!datafile->compacting)
+            ctx_current_disk_space_increase(ctx, total_file_size);
         ctx_fs_error(ctx);
         netdata_log_error("DBENGINE: failed to resize file '%s'", path);
     }
-    else
+    else if(!datafile->compacting)
         ctx_current_disk_space_increase(ctx, resize_file_to);
 }
 
@@ -1549,7 +1669,7 @@ int journalfile_load(struct rrdengine_instance *ctx, struct rrdengine_journalfil
     journalfile->unsafe.pos = file_size;
     journalfile->file = file;
 
-    ret = journalfile_check_superblock(file);
+    ret = journalfile_check_superblock(file, &journalfile->checksum);
     if (ret) {
         netdata_log_info("DBENGINE: invalid journal file '%s' ; superblock check failed.", path);
         error = ret;
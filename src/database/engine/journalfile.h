@@ -52,6 +52,7 @@ struct rrdengine_journalfile {
     } unsafe;
 
     uv_file file;
+    RRDENG_CHECKSUM_TYPE checksum;  // of its v1 transactions, selected by the version of its superblock
     struct rrdengine_datafile *datafile;
 };
 
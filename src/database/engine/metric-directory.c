@@ -0,0 +1,340 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrdengine.h"
+#include "metric-directory.h"
+
+// ----------------------------------------------------------------------------
+// metric directory
+//
+// At startup the MRG is populated by walking the metrics list of every
+// journal v2 file. Each metric appears in most of these files, so the work
+// grows with the number of datafiles, not the number of metrics. On large
+// parents this is the bulk of the startup time.
+//
+// At shutdown we save, per tier, the merged retention of all the metrics found
+// in journal v2 files, together with the list of datafiles (and the size of
+// their journal v2 files) this retention was computed from. At the next
+// startup, if all these datafiles are still there with the same journal v2
+// files, the directory is mmapped and the MRG is populated from it in a single
+// sequential pass. Only datafiles not covered by the directory (i.e. indexed
+// after it was saved) are populated from their journals.
+//
+// The directory is consumed (deleted) at startup, so a crash cannot leave a
+// stale one behind.
+
+bool dbengine_use_metric_directory = false;
+
+#define METRIC_DIRECTORY_FILENAME "metric-directory.ndmd"
+#define METRIC_DIRECTORY_MAGIC (0x0d1e0317)
+#define METRIC_DIRECTORY_VERSION (1)
+
+struct metric_directory_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tier;
+    uint32_t datafiles;
+    uint64_t metrics;
+    int64_t first_time_s;       // the min start time of all the journal v2 files covered
+    uint32_t crc;               // of everything following the header
+    uint32_t reserved;
+};
+
+struct metric_directory_datafile {
+    uint32_t fileno;
+    uint32_t journal_v2_file_size;
+};
+
+struct metric_directory_entry {
+    nd_uuid_t uuid;
+    int64_t first_time_s;
+    int64_t last_time_s;
+    uint32_t update_every_s;
+    uint32_t reserved;
+};
+
+static void metric_directory_filepath(struct rrdengine_instance *ctx, char *path, size_t size) {
+    snprintfz(path, size - 1, "%s/" METRIC_DIRECTORY_FILENAME, ctx->config.dbfiles_path);
+}
+
+// ----------------------------------------------------------------------------
+// loading
+
+size_t metric_directory_load(struct rrdengine_instance *ctx) {
+    char path[RRDENG_PATH_MAX];
+    metric_directory_filepath(ctx, path, sizeof(path));
+
+    if(!dbengine_use_metric_directory) {
+        unlink(path);
+        return 0;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return 0;
+
+    usec_t started_ut = now_monotonic_usec();
+
+    struct stat statbuf;
+    if(fstat(fd, &statbuf) != 0 || (size_t)statbuf.st_size < sizeof(struct metric_directory_header)) {
+        close(fd);
+        unlink(path);
+        return 0;
+    }
+
+    size_t file_size = (size_t)statbuf.st_size;
+    uint8_t *data = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE: cannot mmap() metric directory '%s'", path);
+        unlink(path);
+        return 0;
+    }
+
+    // we are going to read it once, from start to end
+    madvise_sequential(data, file_size);
+    madvise_willneed(data, file_size);
+
+    size_t covered = 0;
+    Pvoid_t datafiles_judyL = NULL;
+    const char *reason = NULL;
+
+    struct metric_directory_header *header = (struct metric_directory_header *)data;
+    struct metric_directory_datafile *datafiles = (struct metric_directory_datafile *)(data + sizeof(*header));
+    struct metric_directory_entry *entries = (struct metric_directory_entry *)&datafiles[header->datafiles];
+
+    if(header->magic != METRIC_DIRECTORY_MAGIC || header->version != METRIC_DIRECTORY_VERSION) {
+        reason = "invalid header";
+        goto cleanup;
+    }
+
+    if(header->tier != (uint32_t)ctx->config.tier) {
+        reason = "it belongs to another tier";
+        goto cleanup;
+    }
+
+    if(sizeof(*header) + header->datafiles * sizeof(*datafiles) + header->metrics * sizeof(*entries) != file_size) {
+        reason = "invalid size";
+        goto cleanup;
+    }
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, data + sizeof(*header), file_size - sizeof(*header));
+    if(crc != header->crc) {
+        reason = "invalid checksum";
+        goto cleanup;
+    }
+
+    // all the datafiles the directory was computed from must be here, unchanged
+
+    uv_rwlock_rdlock(&ctx->datafiles.rwlock);
+    for(struct rrdengine_datafile *df = ctx->datafiles.first; df ; df = df->next) {
+        Pvoid_t *PValue = JudyLIns(&datafiles_judyL, df->fileno, PJE0);
+        if(PValue && PValue != PJERR)
+            *PValue = df;
+    }
+    uv_rwlock_rdunlock(&ctx->datafiles.rwlock);
+
+    for(uint32_t i = 0; i < header->datafiles ; i++) {
+        Pvoid_t *PValue = JudyLGet(datafiles_judyL, datafiles[i].fileno, PJE0);
+        struct rrdengine_datafile *df = PValue ? *PValue : NULL;
+
+        if(!df ||
+            !(df->journalfile->v2.flags & JOURNALFILE_FLAG_IS_AVAILABLE) ||
+            df->journalfile->mmap.size != datafiles[i].journal_v2_file_size) {
+            reason = "it does not match the datafiles on disk";
+            goto cleanup;
+        }
+    }
+
+    time_t now_s = max_acceptable_collected_time();
+    for(uint64_t i = 0; i < header->metrics ; i++) {
+        mrg_update_metric_retention_and_granularity_by_uuid(
+                main_mrg, (Word_t)ctx, &entries[i].uuid,
+                (time_t)entries[i].first_time_s, (time_t)entries[i].last_time_s,
+                entries[i].update_every_s, now_s);
+    }
+
+    for(uint32_t i = 0; i < header->datafiles ; i++) {
+        Pvoid_t *PValue = JudyLGet(datafiles_judyL, datafiles[i].fileno, PJE0);
+        struct rrdengine_datafile *df = *PValue;
+
+        spinlock_lock(&df->populate_mrg.spinlock);
+        df->populate_mrg.populated = true;
+        spinlock_unlock(&df->populate_mrg.spinlock);
+    }
+    covered = header->datafiles;
+
+    time_t global_first_time_s = (time_t)header->first_time_s;
+    time_t old = __atomic_load_n(&ctx->atomic.first_time_s, __ATOMIC_RELAXED);
+    do {
+        if(old <= global_first_time_s)
+            break;
+    } while(!__atomic_compare_exchange_n(&ctx->atomic.first_time_s, &old, global_first_time_s, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    nd_log(NDLS_DAEMON, NDLP_INFO,
+           "DBENGINE: tier %d populated retention of %"PRIu64" metrics from the metric directory, "
+           "covering %u datafiles, in %0.2f ms",
+           ctx->config.tier, header->metrics, header->datafiles,
+           (double)(now_monotonic_usec() - started_ut) / USEC_PER_MS);
+
+cleanup:
+    if(reason)
+        nd_log(NDLS_DAEMON, NDLP_NOTICE,
+               "DBENGINE: ignoring metric directory '%s' of tier %d, because %s",
+               path, ctx->config.tier, reason);
+
+    JudyLFreeArray(&datafiles_judyL, PJE0);
+    netdata_munmap(data, file_size);
+    unlink(path);
+
+    return covered;
+}
+
+// ----------------------------------------------------------------------------
+// saving
+
+static bool metric_directory_write(int fd, const void *data, size_t size) {
+    const uint8_t *p = data;
+    while(size) {
+        ssize_t ret = write(fd, p, size);
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        p += ret;
+        size -= (size_t)ret;
+    }
+    return true;
+}
+
+void metric_directory_save(struct rrdengine_instance *ctx) {
+    if(!dbengine_use_metric_directory)
+        return;
+
+    usec_t started_ut = now_monotonic_usec();
+
+    size_t datafiles_size = 64, datafiles_used = 0;
+    struct metric_directory_datafile *datafiles = mallocz(datafiles_size * sizeof(*datafiles));
+
+    size_t entries_size = 1024, entries_used = 0;
+    struct metric_directory_entry *entries = mallocz(entries_size * sizeof(*entries));
+
+    Pvoid_t uuids_judyHS = NULL;
+    time_t global_first_time_s = LONG_MAX;
+
+    uv_rwlock_rdlock(&ctx->datafiles.rwlock);
+    for(struct rrdengine_datafile *df = ctx->datafiles.first; df ; df = df->next) {
+        struct rrdengine_journalfile *journalfile = df->journalfile;
+        if(!(journalfile->v2.flags & JOURNALFILE_FLAG_IS_AVAILABLE))
+            continue;
+
+        size_t data_size = 0;
+        struct journal_v2_header *j2_header = journalfile_v2_data_acquire(journalfile, &data_size, 0, 0);
+        if(!j2_header)
+            continue;
+
+        if(datafiles_used == datafiles_size) {
+            datafiles_size *= 2;
+            datafiles = reallocz(datafiles, datafiles_size * sizeof(*datafiles));
+        }
+        datafiles[datafiles_used++] = (struct metric_directory_datafile) {
+                .fileno = df->fileno,
+                .journal_v2_file_size = journalfile->mmap.size,
+        };
+
+        time_t header_start_time_s = (time_t)(j2_header->start_time_ut / USEC_PER_SEC);
+        if(header_start_time_s < global_first_time_s)
+            global_first_time_s = header_start_time_s;
+
+        struct journal_metric_list *metric = (struct journal_metric_list *)((uint8_t *)j2_header + j2_header->metric_offset);
+        for(uint32_t i = 0; i < j2_header->metric_count ; i++, metric++) {
+            Pvoid_t *PValue = JudyHSIns(&uuids_judyHS, &metric->uuid, sizeof(nd_uuid_t), PJE0);
+            if(unlikely(!PValue || PValue == PJERR))
+                fatal("DBENGINE: corrupted metric directory JudyHS array");
+
+            if(*PValue)
+                continue;
+
+            *PValue = (void *)1;
+
+            METRIC *m = mrg_metric_get_and_acquire(main_mrg, &metric->uuid, (Word_t)ctx);
+            if(!m)
+                continue;
+
+            time_t first_time_s = mrg_metric_get_first_time_s(main_mrg, m);
+            time_t last_time_s = mrg_metric_get_latest_clean_time_s(main_mrg, m);
+            uint32_t update_every_s = mrg_metric_get_update_every_s(main_mrg, m);
+            mrg_metric_release(main_mrg, m);
+
+            if(!first_time_s || !last_time_s)
+                continue;
+
+            if(entries_used == entries_size) {
+                entries_size *= 2;
+                entries = reallocz(entries, entries_size * sizeof(*entries));
+            }
+
+            struct metric_directory_entry *e = &entries[entries_used++];
+            uuid_copy(e->uuid, metric->uuid);
+            e->first_time_s = first_time_s;
+            e->last_time_s = last_time_s;
+            e->update_every_s = update_every_s;
+            e->reserved = 0;
+        }
+
+        journalfile_v2_data_release(journalfile);
+    }
+    uv_rwlock_rdunlock(&ctx->datafiles.rwlock);
+
+    JudyHSFreeArray(&uuids_judyHS, PJE0);
+
+    if(!datafiles_used)
+        goto cleanup;
+
+    struct metric_directory_header header = {
+            .magic = METRIC_DIRECTORY_MAGIC,
+            .version = METRIC_DIRECTORY_VERSION,
+            .tier = (uint32_t)ctx->config.tier,
+            .datafiles = (uint32_t)datafiles_used,
+            .metrics = entries_used,
+            .first_time_s = global_first_time_s,
+    };
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, (void *)datafiles, datafiles_used * sizeof(*datafiles));
+    crc = crc32(crc, (void *)entries, entries_used * sizeof(*entries));
+    header.crc = (uint32_t)crc;
+
+    char path[RRDENG_PATH_MAX], tmp[RRDENG_PATH_MAX];
+    metric_directory_filepath(ctx, path, sizeof(path));
+    snprintfz(tmp, sizeof(tmp) - 1, "%s.tmp", path);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0664);
+    if(fd == -1) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE: cannot create metric directory '%s'", tmp);
+        goto cleanup;
+    }
+
+    bool ok = metric_directory_write(fd, &header, sizeof(header)) &&
+              metric_directory_write(fd, datafiles, datafiles_used * sizeof(*datafiles)) &&
+              metric_directory_write(fd, entries, entries_used * sizeof(*entries)) &&
+              fsync(fd) == 0;
+    close(fd);
+
+    if(!ok || rename(tmp, path) != 0) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "DBENGINE: cannot save metric directory '%s'", path);
+        unlink(tmp);
+        goto cleanup;
+    }
+
+    nd_log(NDLS_DAEMON, NDLP_INFO,
+           "DBENGINE: tier %d saved the retention of %zu metrics of %zu datafiles to the metric directory, in %0.2f ms",
+           ctx->config.tier, entries_used, datafiles_used,
+           (double)(now_monotonic_usec() - started_ut) / USEC_PER_MS);
+
+cleanup:
+    freez(datafiles);
+    freez(entries);
+}
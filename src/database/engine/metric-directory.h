@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_DBENGINE_METRIC_DIRECTORY_H
+#define NETDATA_DBENGINE_METRIC_DIRECTORY_H
+
+struct rrdengine_instance;
+
+extern bool dbengine_use_metric_directory;
+
+// populates the MRG from the metric directory saved at the last shutdown
+// and marks the datafiles it covers as populated
+// returns the number of datafiles covered (0 when there is no valid directory)
+size_t metric_directory_load(struct rrdengine_instance *ctx);
+
+// saves the retention of all metrics found in journal v2 files
+// to be called at shutdown, after the main cache has been flushed
+void metric_directory_save(struct rrdengine_instance *ctx);
+
+#endif //NETDATA_DBENGINE_METRIC_DIRECTORY_H
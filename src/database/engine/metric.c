@@ -8,7 +8,6 @@ typedef int32_t REFCOUNT;
 #define REFCOUNT_DELETING (-100)
 
 struct metric {
-    nd_uuid_t uuid;                    // never changes
     Word_t section;                 // never changes
 
     time_t first_time_s;            // the timestamp of the oldest point in the database
@@ -16,8 +15,9 @@ struct metric {
     time_t latest_time_s_hot;       // the timestamp of the latest point that has been collected (not yet stored)
     uint32_t latest_update_every_s; // the latest data collection frequency
     pid_t writer;
-    uint8_t partition;
     REFCOUNT refcount;
+    UUIDMAP_ID uuid_id;             // never changes - the UUID is shared by all tiers
+    uint8_t partition;
 
     // THIS IS allocated with malloc()
     // YOU HAVE TO INITIALIZE IT YOURSELF !
@@ -44,14 +44,256 @@ struct metric {
 
 static struct aral_statistics mrg_aral_statistics;
 
+// ----------------------------------------------------------------------------
+// lock-free lookups
+//
+// Each partition indexes its metrics in an open addressing hash table with
+// linear probing. Writers are serialized by the partition spinlock. Readers
+// take no locks: they load the current table and probe it, so that a lookup
+// writes nothing shared, apart from the refcount of the metric found.
+//
+// Slots go from empty to a metric and from a metric to deleted, never back to
+// empty, so probe chains stay intact while readers walk them. Tables are only
+// rebuilt (to grow, or to drop the deleted slots) into a new table, which is
+// then published atomically.
+//
+// Metrics deleted and tables replaced are retired, and freed when all readers
+// that may have seen them have finished (epoch based reclamation).
+
+#define MRG_HASHTABLE_MIN_SIZE 64
+#define MRG_HASHTABLE_DELETED ((METRIC *)1)
+
+struct mrg_hashtable {
+    size_t size;                    // always a power of 2
+    size_t used;                    // slots with a metric
+    size_t deleted;                 // slots marked deleted
+    METRIC *slots[];
+};
+
+static inline size_t mrg_hashtable_bytes(size_t size) {
+    return sizeof(struct mrg_hashtable) + size * sizeof(METRIC *);
+}
+
+static inline uint64_t metric_hash(nd_uuid_t *uuid, Word_t section) {
+    // the partition is selected by the last bytes of the UUID, we hash the first ones
+    uint64_t h;
+    memcpy(&h, uuid, sizeof(h));
+    h ^= (uint64_t)section * 0x9E3779B97F4A7C15ULL;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+static inline METRIC *mrg_hashtable_find(struct mrg_hashtable *ht, nd_uuid_t *uuid, Word_t section) {
+    if(unlikely(!ht))
+        return NULL;
+
+    size_t mask = ht->size - 1;
+    size_t slot = metric_hash(uuid, section) & mask;
+
+    for(size_t i = 0; i < ht->size ; i++, slot = (slot + 1) & mask) {
+        METRIC *metric = __atomic_load_n(&ht->slots[slot], __ATOMIC_ACQUIRE);
+
+        if(!metric)
+            return NULL;
+
+        if(metric == MRG_HASHTABLE_DELETED)
+            continue;
+
+        if(metric->section == section && uuid_eq(*uuidmap_uuid_ptr(metric->uuid_id), *uuid))
+            return metric;
+    }
+
+    return NULL;
+}
+
+// the caller must have checked the metric is not already in the table
+static inline void mrg_hashtable_insert_unsafe(struct mrg_hashtable *ht, METRIC *metric) {
+    size_t mask = ht->size - 1;
+    size_t slot = metric_hash(uuidmap_uuid_ptr(metric->uuid_id), metric->section) & mask;
+
+    while(1) {
+        METRIC *m = ht->slots[slot];
+
+        if(!m || m == MRG_HASHTABLE_DELETED) {
+            if(m == MRG_HASHTABLE_DELETED)
+                ht->deleted--;
+
+            ht->used++;
+            __atomic_store_n(&ht->slots[slot], metric, __ATOMIC_RELEASE);
+            return;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+}
+
+static inline bool mrg_hashtable_delete_unsafe(struct mrg_hashtable *ht, METRIC *metric) {
+    if(unlikely(!ht))
+        return false;
+
+    size_t mask = ht->size - 1;
+    size_t slot = metric_hash(uuidmap_uuid_ptr(metric->uuid_id), metric->section) & mask;
+
+    for(size_t i = 0; i < ht->size ; i++, slot = (slot + 1) & mask) {
+        METRIC *m = ht->slots[slot];
+
+        if(!m)
+            return false;
+
+        if(m == metric) {
+            __atomic_store_n(&ht->slots[slot], MRG_HASHTABLE_DELETED, __ATOMIC_RELEASE);
+            ht->used--;
+            ht->deleted++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// epoch based reclamation
+
+struct mrg_epoch_reader {
+    uint64_t epoch;                 // the global epoch when the reader entered, 0 when outside
+    struct mrg_epoch_reader *next;
+    uint8_t padding[64 - sizeof(uint64_t) - sizeof(void *)]; // one cache line per reader
+};
+
+struct mrg_retired {
+    uint64_t epoch;
+    void *ptr;
+    ARAL *aral;                     // NULL when ptr is to be freed with freez()
+    UUIDMAP_ID uuid_id;             // the UUID of a retired metric, released with it
+    struct mrg_retired *next;
+};
+
+#define MRG_EPOCH_RECLAIM_EVERY 128
+
+static struct {
+    uint64_t epoch;
+    MRG_CACHE_LINE_PADDING(0);
+
+    SPINLOCK spinlock;              // protects everything below
+    struct mrg_epoch_reader *readers;
+    struct mrg_retired *retired;
+    size_t retired_count;
+} mrg_epoch = {
+        .epoch = 1,
+        .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+};
+
+static __thread struct mrg_epoch_reader *mrg_epoch_reader_self = NULL;
+
+static struct mrg_epoch_reader *mrg_epoch_reader_register(void) {
+    struct mrg_epoch_reader *r = NULL;
+    if(posix_memalign((void **)&r, 64, sizeof(*r)) != 0 || !r)
+        fatal("DBENGINE METRIC: cannot allocate an epoch reader");
+
+    memset(r, 0, sizeof(*r));
+
+    // readers are never removed - the threads doing lookups are long-lived
+    spinlock_lock(&mrg_epoch.spinlock);
+    r->next = mrg_epoch.readers;
+    mrg_epoch.readers = r;
+    spinlock_unlock(&mrg_epoch.spinlock);
+
+    mrg_epoch_reader_self = r;
+    return r;
+}
+
+static inline struct mrg_epoch_reader *mrg_epoch_enter(void) {
+    struct mrg_epoch_reader *r = mrg_epoch_reader_self;
+    if(unlikely(!r))
+        r = mrg_epoch_reader_register();
+
+    __atomic_store_n(&r->epoch, __atomic_load_n(&mrg_epoch.epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return r;
+}
+
+static inline void mrg_epoch_exit(struct mrg_epoch_reader *r) {
+    __atomic_store_n(&r->epoch, 0, __ATOMIC_RELEASE);
+}
+
+static void mrg_epoch_reclaim_unsafe(void) {
+    __atomic_add_fetch(&mrg_epoch.epoch, 1, __ATOMIC_SEQ_CST);
+
+    uint64_t min_active = UINT64_MAX;
+    for(struct mrg_epoch_reader *r = mrg_epoch.readers; r ; r = r->next) {
+        uint64_t e = __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST);
+        if(e && e < min_active)
+            min_active = e;
+    }
+
+    struct mrg_retired **pp = &mrg_epoch.retired;
+    while(*pp) {
+        struct mrg_retired *t = *pp;
+
+        // readers that entered after it was retired cannot see it
+        if(t->epoch < min_active) {
+            *pp = t->next;
+
+            if(t->aral)
+                aral_freez(t->aral, t->ptr);
+            else
+                freez(t->ptr);
+
+            uuidmap_free(t->uuid_id);
+
+            freez(t);
+            mrg_epoch.retired_count--;
+        }
+        else
+            pp = &t->next;
+    }
+}
+
+static void mrg_epoch_reclaim(void) {
+    if(!__atomic_load_n(&mrg_epoch.retired_count, __ATOMIC_RELAXED))
+        return;
+
+    spinlock_lock(&mrg_epoch.spinlock);
+    mrg_epoch_reclaim_unsafe();
+    spinlock_unlock(&mrg_epoch.spinlock);
+}
+
+// to be called after ptr has been unlinked from everything readers can reach
+static void mrg_epoch_retire(void *ptr, ARAL *aral, UUIDMAP_ID uuid_id) {
+    struct mrg_retired *t = mallocz(sizeof(*t));
+    t->ptr = ptr;
+    t->aral = aral;
+    t->uuid_id = uuid_id;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    t->epoch = __atomic_load_n(&mrg_epoch.epoch, __ATOMIC_SEQ_CST);
+
+    spinlock_lock(&mrg_epoch.spinlock);
+    t->next = mrg_epoch.retired;
+    mrg_epoch.retired = t;
+
+    if(++mrg_epoch.retired_count % MRG_EPOCH_RECLAIM_EVERY == 0)
+        mrg_epoch_reclaim_unsafe();
+
+    spinlock_unlock(&mrg_epoch.spinlock);
+}
+
+// ----------------------------------------------------------------------------
+
 struct mrg {
     size_t partitions;
 
     struct mrg_partition {
         ARAL *aral;                 // not protected by our spinlock - it has its own
 
-        RW_SPINLOCK rw_spinlock;
-        Pvoid_t uuid_judy;          // JudyHS: each UUID has a JudyL of sections (tiers)
+        SPINLOCK spinlock;          // serializes the writers - readers do not lock
+        struct mrg_hashtable *hashtable;
 
         struct mrg_statistics stats;
     } index[];
@@ -73,36 +315,79 @@ static inline void MRG_STATS_DELETED_METRIC(MRG *mrg, size_t partition) {
     mrg->index[partition].stats.deletions++;
 }
 
+// search statistics are accumulated per thread, to keep lookups free of shared writes
+#define MRG_STATS_SEARCH_FLUSH_EVERY 256
+static __thread struct {
+    size_t hits;
+    size_t misses;
+} mrg_search_stats = { 0 };
+
+static inline void MRG_STATS_SEARCH_FLUSH(MRG *mrg, size_t partition) {
+    if(likely(mrg_search_stats.hits + mrg_search_stats.misses < MRG_STATS_SEARCH_FLUSH_EVERY))
+        return;
+
+    __atomic_add_fetch(&mrg->index[partition].stats.search_hits, mrg_search_stats.hits, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&mrg->index[partition].stats.search_misses, mrg_search_stats.misses, __ATOMIC_RELAXED);
+    mrg_search_stats.hits = 0;
+    mrg_search_stats.misses = 0;
+}
+
 static inline void MRG_STATS_SEARCH_HIT(MRG *mrg, size_t partition) {
-    __atomic_add_fetch(&mrg->index[partition].stats.search_hits, 1, __ATOMIC_RELAXED);
+    mrg_search_stats.hits++;
+    MRG_STATS_SEARCH_FLUSH(mrg, partition);
 }
 
 static inline void MRG_STATS_SEARCH_MISS(MRG *mrg, size_t partition) {
-    __atomic_add_fetch(&mrg->index[partition].stats.search_misses, 1, __ATOMIC_RELAXED);
+    mrg_search_stats.misses++;
+    MRG_STATS_SEARCH_FLUSH(mrg, partition);
 }
 
 static inline void MRG_STATS_DELETE_MISS(MRG *mrg, size_t partition) {
     mrg->index[partition].stats.delete_misses++;
 }
 
-#define mrg_index_read_lock(mrg, partition) rw_spinlock_read_lock(&(mrg)->index[partition].rw_spinlock)
-#define mrg_index_read_unlock(mrg, partition) rw_spinlock_read_unlock(&(mrg)->index[partition].rw_spinlock)
-#define mrg_index_write_lock(mrg, partition) rw_spinlock_write_lock(&(mrg)->index[partition].rw_spinlock)
-#define mrg_index_write_unlock(mrg, partition) rw_spinlock_write_unlock(&(mrg)->index[partition].rw_spinlock)
+#define mrg_index_write_lock(mrg, partition) spinlock_lock(&(mrg)->index[partition].spinlock)
+#define mrg_index_write_unlock(mrg, partition) spinlock_unlock(&(mrg)->index[partition].spinlock)
 
-static inline void mrg_stats_size_judyl_change(MRG *mrg, size_t mem_before_judyl, size_t mem_after_judyl, size_t partition) {
-    if(mem_after_judyl > mem_before_judyl)
-        __atomic_add_fetch(&mrg->index[partition].stats.size, mem_after_judyl - mem_before_judyl, __ATOMIC_RELAXED);
-    else if(mem_after_judyl < mem_before_judyl)
-        __atomic_sub_fetch(&mrg->index[partition].stats.size, mem_before_judyl - mem_after_judyl, __ATOMIC_RELAXED);
+static inline void mrg_stats_size_hashtable_change(MRG *mrg, size_t old_bytes, size_t new_bytes, size_t partition) {
+    if(new_bytes > old_bytes)
+        __atomic_add_fetch(&mrg->index[partition].stats.size, new_bytes - old_bytes, __ATOMIC_RELAXED);
+    else if(new_bytes < old_bytes)
+        __atomic_sub_fetch(&mrg->index[partition].stats.size, old_bytes - new_bytes, __ATOMIC_RELAXED);
 }
 
-static inline void mrg_stats_size_judyhs_added_uuid(MRG *mrg, size_t partition) {
-    __atomic_add_fetch(&mrg->index[partition].stats.size, JUDYHS_INDEX_SIZE_ESTIMATE(sizeof(nd_uuid_t)), __ATOMIC_RELAXED);
-}
+// makes room for one more metric, rebuilding the table when needed - under the write lock
+static inline struct mrg_hashtable *mrg_hashtable_reserve_unsafe(MRG *mrg, size_t partition) {
+    struct mrg_hashtable *ht = mrg->index[partition].hashtable;
+
+    // keep the load factor (including the deleted slots) at or below 1/2
+    if(likely(ht && (ht->used + ht->deleted + 1) * 2 <= ht->size))
+        return ht;
+
+    size_t used = ht ? ht->used : 0;
+    size_t size = MRG_HASHTABLE_MIN_SIZE;
+    while(size < (used + 1) * 4)
+        size <<= 1;
+
+    struct mrg_hashtable *nht = callocz(1, mrg_hashtable_bytes(size));
+    nht->size = size;
+
+    if(ht) {
+        for(size_t i = 0; i < ht->size ; i++) {
+            METRIC *m = ht->slots[i];
+            if(m && m != MRG_HASHTABLE_DELETED)
+                mrg_hashtable_insert_unsafe(nht, m);
+        }
+    }
+
+    __atomic_store_n(&mrg->index[partition].hashtable, nht, __ATOMIC_RELEASE);
 
-static inline void mrg_stats_size_judyhs_removed_uuid(MRG *mrg, size_t partition) {
-    __atomic_sub_fetch(&mrg->index[partition].stats.size, JUDYHS_INDEX_SIZE_ESTIMATE(sizeof(nd_uuid_t)), __ATOMIC_RELAXED);
+    mrg_stats_size_hashtable_change(mrg, ht ? mrg_hashtable_bytes(ht->size) : 0, mrg_hashtable_bytes(size), partition);
+
+    if(ht)
+        mrg_epoch_retire(ht, NULL, 0);
+
+    return nht;
 }
 
 static inline size_t uuid_partition(MRG *mrg __maybe_unused, nd_uuid_t *uuid) {
@@ -135,7 +420,7 @@ static void metric_log(MRG *mrg __maybe_unused, METRIC *metric, const char *msg)
     struct rrdengine_instance *ctx = (struct rrdengine_instance *)metric->section;
 
     char uuid[UUID_STR_LEN];
-    uuid_unparse_lower(metric->uuid, uuid);
+    uuid_unparse_lower(*uuidmap_uuid_ptr(metric->uuid_id), uuid);
     nd_log(NDLS_DAEMON, NDLP_ERR,
            "METRIC: %s on %s at tier %d, refcount %d, partition %u, "
            "retention [%ld - %ld (hot), %ld (clean)], update every %"PRIu32", "
@@ -163,40 +448,20 @@ static inline bool acquired_metric_has_retention(MRG *mrg, METRIC *metric) {
 static inline void acquired_for_deletion_metric_delete(MRG *mrg, METRIC *metric) {
     size_t partition = metric->partition;
 
-    size_t mem_before_judyl, mem_after_judyl;
-
     mrg_index_write_lock(mrg, partition);
 
-    Pvoid_t *sections_judy_pptr = JudyHSGet(mrg->index[partition].uuid_judy, &metric->uuid, sizeof(nd_uuid_t));
-    if(unlikely(!sections_judy_pptr || !*sections_judy_pptr)) {
-        MRG_STATS_DELETE_MISS(mrg, partition);
-        mrg_index_write_unlock(mrg, partition);
-        return;
-    }
-
-    mem_before_judyl = JudyLMemUsed(*sections_judy_pptr);
-    int rc = JudyLDel(sections_judy_pptr, metric->section, PJE0);
-    mem_after_judyl = JudyLMemUsed(*sections_judy_pptr);
-    mrg_stats_size_judyl_change(mrg, mem_before_judyl, mem_after_judyl, partition);
-
-    if(unlikely(!rc)) {
+    if(unlikely(!mrg_hashtable_delete_unsafe(mrg->index[partition].hashtable, metric))) {
         MRG_STATS_DELETE_MISS(mrg, partition);
         mrg_index_write_unlock(mrg, partition);
         return;
     }
 
-    if(!*sections_judy_pptr) {
-        rc = JudyHSDel(&mrg->index[partition].uuid_judy, &metric->uuid, sizeof(nd_uuid_t), PJE0);
-        if(unlikely(!rc))
-            fatal("DBENGINE METRIC: cannot delete UUID from JudyHS");
-        mrg_stats_size_judyhs_removed_uuid(mrg, partition);
-    }
-
     MRG_STATS_DELETED_METRIC(mrg, partition);
 
     mrg_index_write_unlock(mrg, partition);
 
-    aral_freez(mrg->index[partition].aral, metric);
+    // lock-free readers may still be looking at it, and at its UUID
+    mrg_epoch_retire(metric, mrg->index[partition].aral, metric->uuid_id);
 }
 
 static inline bool metric_acquire(MRG *mrg, METRIC *metric) {
@@ -257,32 +522,14 @@ static inline METRIC *metric_add_and_acquire(MRG *mrg, MRG_ENTRY *entry, bool *r
     size_t partition = uuid_partition(mrg, entry->uuid);
 
     METRIC *allocation = aral_mallocz(mrg->index[partition].aral);
-    Pvoid_t *PValue;
 
     while(1) {
         mrg_index_write_lock(mrg, partition);
 
-        size_t mem_before_judyl, mem_after_judyl;
-
-        Pvoid_t *sections_judy_pptr = JudyHSIns(&mrg->index[partition].uuid_judy, entry->uuid, sizeof(nd_uuid_t), PJE0);
-        if (unlikely(!sections_judy_pptr || sections_judy_pptr == PJERR))
-            fatal("DBENGINE METRIC: corrupted UUIDs JudyHS array");
-
-        if (unlikely(!*sections_judy_pptr))
-            mrg_stats_size_judyhs_added_uuid(mrg, partition);
-
-        mem_before_judyl = JudyLMemUsed(*sections_judy_pptr);
-        PValue = JudyLIns(sections_judy_pptr, entry->section, PJE0);
-        mem_after_judyl = JudyLMemUsed(*sections_judy_pptr);
-        mrg_stats_size_judyl_change(mrg, mem_before_judyl, mem_after_judyl, partition);
-
-        if (unlikely(!PValue || PValue == PJERR))
-            fatal("DBENGINE METRIC: corrupted section JudyL array");
-
-        if (unlikely(*PValue != NULL)) {
-            METRIC *metric = *PValue;
-
+        METRIC *metric = mrg_hashtable_find(mrg->index[partition].hashtable, entry->uuid, entry->section);
+        if (unlikely(metric)) {
             if(!metric_acquire(mrg, metric)) {
+                // it is being deleted
                 mrg_index_write_unlock(mrg, partition);
                 continue;
             }
@@ -302,7 +549,7 @@ static inline METRIC *metric_add_and_acquire(MRG *mrg, MRG_ENTRY *entry, bool *r
     }
 
     METRIC *metric = allocation;
-    uuid_copy(metric->uuid, *entry->uuid);
+    metric->uuid_id = uuidmap_create(*entry->uuid);
     metric->section = entry->section;
     metric->first_time_s = MAX(0, entry->first_time_s);
     metric->latest_time_s_clean = MAX(0, entry->last_time_s);
@@ -311,7 +558,9 @@ static inline METRIC *metric_add_and_acquire(MRG *mrg, MRG_ENTRY *entry, bool *r
     metric->writer = 0;
     metric->refcount = 1;
     metric->partition = partition;
-    *PValue = metric;
+
+    // publishes the metric with release semantics
+    mrg_hashtable_insert_unsafe(mrg_hashtable_reserve_unsafe(mrg, partition), metric);
 
     MRG_STATS_ADDED_METRIC(mrg, partition);
 
@@ -326,35 +575,23 @@ static inline METRIC *metric_add_and_acquire(MRG *mrg, MRG_ENTRY *entry, bool *r
 static inline METRIC *metric_get_and_acquire(MRG *mrg, nd_uuid_t *uuid, Word_t section) {
     size_t partition = uuid_partition(mrg, uuid);
 
-    while(1) {
-        mrg_index_read_lock(mrg, partition);
+    struct mrg_epoch_reader *r = mrg_epoch_enter();
 
-        Pvoid_t *sections_judy_pptr = JudyHSGet(mrg->index[partition].uuid_judy, uuid, sizeof(nd_uuid_t));
-        if (unlikely(!sections_judy_pptr)) {
-            mrg_index_read_unlock(mrg, partition);
-            MRG_STATS_SEARCH_MISS(mrg, partition);
-            return NULL;
-        }
+    struct mrg_hashtable *ht = __atomic_load_n(&mrg->index[partition].hashtable, __ATOMIC_ACQUIRE);
+    METRIC *metric = mrg_hashtable_find(ht, uuid, section);
 
-        Pvoid_t *PValue = JudyLGet(*sections_judy_pptr, section, PJE0);
-        if (unlikely(!PValue)) {
-            mrg_index_read_unlock(mrg, partition);
-            MRG_STATS_SEARCH_MISS(mrg, partition);
-            return NULL;
-        }
-
-        METRIC *metric = *PValue;
+    // a metric that is being deleted is not found
+    if(metric && !metric_acquire(mrg, metric))
+        metric = NULL;
 
-        if(metric && !metric_acquire(mrg, metric))
-            metric = NULL;
+    mrg_epoch_exit(r);
 
-        mrg_index_read_unlock(mrg, partition);
+    if(metric)
+        MRG_STATS_SEARCH_HIT(mrg, partition);
+    else
+        MRG_STATS_SEARCH_MISS(mrg, partition);
 
-        if(metric) {
-            MRG_STATS_SEARCH_HIT(mrg, partition);
-            return metric;
-        }
-    }
+    return metric;
 }
 
 // ----------------------------------------------------------------------------
@@ -368,12 +605,15 @@ inline MRG *mrg_create(ssize_t partitions) {
     mrg->partitions = partitions;
 
     for(size_t i = 0; i < mrg->partitions ; i++) {
-        rw_spinlock_init(&mrg->index[i].rw_spinlock);
+        spinlock_init(&mrg->index[i].spinlock);
 
         char buf[ARAL_MAX_NAME + 1];
         snprintfz(buf, ARAL_MAX_NAME, "mrg[%zu]", i);
 
         mrg->index[i].aral = aral_create(buf, sizeof(METRIC), 0, 16384, &mrg_aral_statistics, NULL, NULL, false, false);
+
+        if(dbengine_use_huge_pages)
+            aral_huge_pages_enable(mrg->index[i].aral);
     }
 
     return mrg;
@@ -387,6 +627,10 @@ inline size_t mrg_aral_overhead(void) {
     return aral_overhead_from_stats(&mrg_aral_statistics);
 }
 
+inline size_t mrg_aral_huge_pages(void) {
+    return aral_huge_pages_from_stats(&mrg_aral_statistics);
+}
+
 inline void mrg_destroy(MRG *mrg __maybe_unused) {
     // no destruction possible
     // we can't traverse the metrics list
@@ -426,7 +670,7 @@ inline Word_t mrg_metric_id(MRG *mrg __maybe_unused, METRIC *metric) {
 }
 
 inline nd_uuid_t *mrg_metric_uuid(MRG *mrg __maybe_unused, METRIC *metric) {
-    return &metric->uuid;
+    return uuidmap_uuid_ptr(metric->uuid_id);
 }
 
 inline Word_t mrg_metric_section(MRG *mrg __maybe_unused, METRIC *metric) {
@@ -711,6 +955,9 @@ inline void mrg_update_metric_retention_and_granularity_by_uuid(
 }
 
 inline void mrg_get_statistics(MRG *mrg, struct mrg_statistics *s) {
+    // free whatever the readers no longer use
+    mrg_epoch_reclaim();
+
     memset(s, 0, sizeof(struct mrg_statistics));
 
     for(size_t i = 0; i < mrg->partitions ;i++) {
@@ -730,6 +977,9 @@ inline void mrg_get_statistics(MRG *mrg, struct mrg_statistics *s) {
     }
 
     s->size += sizeof(MRG) + sizeof(struct mrg_partition) * mrg->partitions;
+
+    // the UUIDs of the metrics are kept once for all tiers, in the UUID map
+    s->size += uuidmap_memory();
 }
 
 // ----------------------------------------------------------------------------
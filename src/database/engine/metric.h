@@ -85,6 +85,7 @@ bool mrg_metric_clear_writer(MRG *mrg, METRIC *metric);
 void mrg_get_statistics(MRG *mrg, struct mrg_statistics *s);
 size_t mrg_aral_structures(void);
 size_t mrg_aral_overhead(void);
+size_t mrg_aral_huge_pages(void);
 
 
 void mrg_update_metric_retention_and_granularity_by_uuid(
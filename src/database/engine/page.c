@@ -23,10 +23,24 @@ typedef struct {
 
 typedef struct {
     size_t num_buffers;
-    gorilla_writer_t *writer;
+    union {
+        gorilla_writer_t *writer;       // RRDENG_PAGE_TYPE_GORILLA_32BIT
+        gorilla64_writer_t *writer64;   // RRDENG_PAGE_TYPE_GORILLA_64BIT
+    };
     int aral_index;
 } page_gorilla_t;
 
+typedef struct {
+    // collected pages: the storage_number_tier1_t array (same as page_raw_t)
+    // pages loaded from disk: the encoded page, as stored on disk
+    uint8_t *data;
+    uint32_t size;
+
+    // collected pages: the encoded page, while it is being flushed
+    uint8_t *encoded;
+    uint32_t encoded_size;
+} page_columns_t;
+
 struct pgd {
     // the page type
     uint8_t type;
@@ -45,6 +59,7 @@ struct pgd {
     union {
         page_raw_t raw;
         page_gorilla_t gorilla;
+        page_columns_t columns;
     };
 };
 
@@ -56,6 +71,7 @@ struct {
     ARAL *aral_data[RRD_STORAGE_TIERS];
     ARAL *aral_gorilla_buffer[4];
     ARAL *aral_gorilla_writer[4];
+    ARAL *aral_gorilla64_writer[4];
 } pgd_alloc_globals = {};
 
 static ARAL *pgd_aral_data_lookup(size_t size)
@@ -100,6 +116,9 @@ void pgd_init_arals(void)
                     512 * (tier_page_size[tier]),
                     pgc_aral_statistics(),
                     NULL, NULL, false, false);
+
+            if(dbengine_use_huge_pages)
+                aral_huge_pages_enable(pgd_alloc_globals.aral_data[tier]);
         }
     }
 
@@ -116,6 +135,9 @@ void pgd_init_arals(void)
                 512 * RRDENG_GORILLA_32BIT_BUFFER_SIZE,
                 pgc_aral_statistics(),
                 NULL, NULL, false, false);
+
+        if(dbengine_use_huge_pages)
+            aral_huge_pages_enable(pgd_alloc_globals.aral_gorilla_buffer[i]);
     }
 
     // gorilla writers aral
@@ -132,6 +154,20 @@ void pgd_init_arals(void)
                 pgc_aral_statistics(),
                 NULL, NULL, false, false);
     }
+
+    // gorilla 64-bit writers aral
+    for (size_t i = 0; i != 4; i++) {
+        char buf[20 + 1];
+        snprintfz(buf, sizeof(buf) - 1, "gwriter64-%zu", i);
+
+        pgd_alloc_globals.aral_gorilla64_writer[i] = aral_create(
+                buf,
+                sizeof(gorilla64_writer_t),
+                64,
+                512 * sizeof(gorilla64_writer_t),
+                pgc_aral_statistics(),
+                NULL, NULL, false, false);
+    }
 }
 
 static void *pgd_data_aral_alloc(size_t size)
@@ -152,6 +188,216 @@ static void pgd_data_aral_free(void *page, size_t size)
         aral_freez(ar, page);
 }
 
+// ----------------------------------------------------------------------------
+// gorilla pages
+
+static gorilla_buffer_t *pgd_gorilla_buffer_alloc(PGD *pg)
+{
+    gorilla_buffer_t *gbuf = aral_mallocz(pgd_alloc_globals.aral_gorilla_buffer[pg->gorilla.aral_index]);
+    memset(gbuf, 0, RRDENG_GORILLA_32BIT_BUFFER_SIZE);
+    global_statistics_gorilla_buffer_add_hot();
+    return gbuf;
+}
+
+// ----------------------------------------------------------------------------
+// tier0 double precision points
+
+static inline uint64_t pgd_double_pack(NETDATA_DOUBLE n, SN_FLAGS flags)
+{
+    double d = (double) n;
+
+    // infinite values would become NaN with the flags, so they are stored as empty points
+    if (unlikely(!isfinite(d)))
+        d = NAN;
+
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    u &= ~(uint64_t) RRDENG_GORILLA_64BIT_FLAGS;
+
+    if (unlikely(isnan(d)))
+        return u;
+
+    if (!(flags & SN_FLAG_NOT_ANOMALOUS))
+        u |= RRDENG_GORILLA_64BIT_FLAG_ANOMALOUS;
+
+    if (flags & SN_FLAG_RESET)
+        u |= RRDENG_GORILLA_64BIT_FLAG_RESET;
+
+    return u;
+}
+
+static inline void storage_point_from_double_bits(STORAGE_POINT *sp, uint64_t u)
+{
+    uint64_t bits = u & ~(uint64_t) RRDENG_GORILLA_64BIT_FLAGS;
+
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+
+    sp->min = sp->max = sp->sum = (NETDATA_DOUBLE) d;
+    sp->count = 1;
+
+    if (unlikely(isnan(d))) {
+        sp->flags = SN_FLAG_NONE;
+        sp->anomaly_count = 0;
+        return;
+    }
+
+    sp->flags = (u & RRDENG_GORILLA_64BIT_FLAG_ANOMALOUS) ? SN_FLAG_NONE : SN_FLAG_NOT_ANOMALOUS;
+    if (u & RRDENG_GORILLA_64BIT_FLAG_RESET)
+        sp->flags |= SN_FLAG_RESET;
+
+    sp->anomaly_count = (u & RRDENG_GORILLA_64BIT_FLAG_ANOMALOUS) ? 1 : 0;
+}
+
+// ----------------------------------------------------------------------------
+// tier1 columns encoding
+
+#define PAGE_COLUMNS_ALIGN(x) (((x) + 7) & ~((uint32_t) 7))
+
+static inline uint32_t float_bits(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float bits_float(uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static uint32_t pgd_columns_encode_column(uint8_t *dst, uint32_t slots, const storage_number_tier1_t *array, uint32_t entries, size_t offset)
+{
+    gorilla_buffer_t *gbuf = (gorilla_buffer_t *) dst;
+    gorilla_writer_t gw = gorilla_writer_init(gbuf, slots);
+
+    for (uint32_t i = 0; i < entries; i++) {
+        float f;
+        memcpy(&f, (const uint8_t *) &array[i] + offset, sizeof(f));
+
+        bool ok = gorilla_writer_write(&gw, float_bits(f));
+        UNUSED(ok);
+        internal_fatal(!ok, "DBENGINE: gorilla column buffer is too small");
+    }
+
+    return PAGE_COLUMNS_ALIGN(sizeof(gorilla_header_t) + (gbuf->header.nbits + (CHAR_BIT - 1)) / CHAR_BIT);
+}
+
+// encode the points collected on the page, into the layout stored on disk
+static void pgd_columns_encode(PGD *pg)
+{
+    const storage_number_tier1_t *array = (const storage_number_tier1_t *) pg->columns.data;
+    uint32_t entries = pg->used;
+
+    struct rrdeng_page_columns_header hdr = {
+            .entries = entries,
+    };
+
+    // the worst case for gorilla is 39 bits per value
+    uint32_t column_slots = (sizeof(gorilla_header_t) * CHAR_BIT + 39 * entries + 31) / 32 + 1;
+    uint32_t column_size = PAGE_COLUMNS_ALIGN(column_slots * sizeof(uint32_t));
+    uint32_t raw_size = sizeof(hdr) + entries * sizeof(storage_number_tier1_t);
+    uint32_t size = sizeof(hdr) + 3 * column_size + entries * sizeof(struct rrdeng_page_columns_run);
+    if (size < raw_size)
+        size = raw_size;
+
+    uint8_t *buf = callocz(1, size);
+    uint32_t pos = sizeof(hdr);
+
+    hdr.sum_size = pgd_columns_encode_column(&buf[pos], column_slots, array, entries, offsetof(storage_number_tier1_t, sum_value));
+    pos += hdr.sum_size;
+
+    hdr.min_size = pgd_columns_encode_column(&buf[pos], column_slots, array, entries, offsetof(storage_number_tier1_t, min_value));
+    pos += hdr.min_size;
+
+    hdr.max_size = pgd_columns_encode_column(&buf[pos], column_slots, array, entries, offsetof(storage_number_tier1_t, max_value));
+    pos += hdr.max_size;
+
+    struct rrdeng_page_columns_run *runs = (struct rrdeng_page_columns_run *) &buf[pos];
+    for (uint32_t i = 0; i < entries; i++) {
+        if (hdr.runs &&
+            runs[hdr.runs - 1].count == array[i].count &&
+            runs[hdr.runs - 1].anomaly_count == array[i].anomaly_count &&
+            runs[hdr.runs - 1].length < UINT16_MAX) {
+            runs[hdr.runs - 1].length++;
+            continue;
+        }
+
+        runs[hdr.runs++] = (struct rrdeng_page_columns_run) {
+                .length = 1,
+                .count = array[i].count,
+                .anomaly_count = array[i].anomaly_count,
+        };
+    }
+    pos += hdr.runs * sizeof(struct rrdeng_page_columns_run);
+
+    if (pos >= raw_size) {
+        // the data did not compress, store them as-is
+        memset(buf, 0, size);
+        hdr = (struct rrdeng_page_columns_header) {
+                .entries = entries,
+                .options = RRDENG_PAGE_COLUMNS_RAW,
+        };
+        memcpy(&buf[sizeof(hdr)], array, entries * sizeof(storage_number_tier1_t));
+        pos = raw_size;
+    }
+
+    memcpy(buf, &hdr, sizeof(hdr));
+
+    pg->columns.encoded = reallocz(buf, pos);
+    pg->columns.encoded_size = pos;
+}
+
+static bool pgd_columns_gorilla_is_valid(const uint8_t *column, uint32_t size, uint32_t entries)
+{
+    if (size < sizeof(gorilla_header_t) || size % sizeof(uint32_t))
+        return false;
+
+    const gorilla_header_t *gh = (const gorilla_header_t *) column;
+    return gh->entries == entries && gh->nbits <= (size - sizeof(gorilla_header_t)) * CHAR_BIT;
+}
+
+static bool pgd_columns_is_valid(const uint8_t *data, uint32_t size)
+{
+    struct rrdeng_page_columns_header hdr;
+
+    if (size < sizeof(hdr))
+        return false;
+
+    memcpy(&hdr, data, sizeof(hdr));
+
+    if (!hdr.entries)
+        return false;
+
+    if (hdr.options & RRDENG_PAGE_COLUMNS_RAW)
+        return size == sizeof(hdr) + hdr.entries * sizeof(storage_number_tier1_t);
+
+    uint64_t expected = (uint64_t) sizeof(hdr) + hdr.sum_size + hdr.min_size + hdr.max_size +
+                        hdr.runs * sizeof(struct rrdeng_page_columns_run);
+
+    if (expected != size ||
+        hdr.sum_size % 8 || hdr.min_size % 8 || hdr.max_size % 8 ||
+        !pgd_columns_gorilla_is_valid(&data[sizeof(hdr)], hdr.sum_size, hdr.entries) ||
+        !pgd_columns_gorilla_is_valid(&data[sizeof(hdr) + hdr.sum_size], hdr.min_size, hdr.entries) ||
+        !pgd_columns_gorilla_is_valid(&data[sizeof(hdr) + hdr.sum_size + hdr.min_size], hdr.max_size, hdr.entries))
+        return false;
+
+    const struct rrdeng_page_columns_run *runs =
+            (const struct rrdeng_page_columns_run *) &data[sizeof(hdr) + hdr.sum_size + hdr.min_size + hdr.max_size];
+
+    uint64_t points = 0;
+    for (uint16_t i = 0; i < hdr.runs; i++) {
+        if (!runs[i].length)
+            return false;
+
+        points += runs[i].length;
+    }
+
+    return points == hdr.entries;
+}
+
 // ----------------------------------------------------------------------------
 // management api
 
@@ -176,6 +422,18 @@ PGD *pgd_create(uint8_t type, uint32_t slots)
             pg->raw.data = pgd_data_aral_alloc(size);
             break;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1: {
+            uint32_t size = slots * page_type_size[type];
+
+            internal_fatal(!size || slots == 1,
+                      "DBENGINE: invalid number of slots (%u) or page type (%u)", slots, type);
+
+            pg->columns.size = size;
+            pg->columns.data = pgd_data_aral_alloc(size);
+            pg->columns.encoded = NULL;
+            pg->columns.encoded_size = 0;
+            break;
+        }
         case RRDENG_PAGE_TYPE_GORILLA_32BIT: {
             internal_fatal(slots == 1,
                       "DBENGINE: invalid number of slots (%u) or page type (%u)", slots, type);
@@ -196,6 +454,22 @@ PGD *pgd_create(uint8_t type, uint32_t slots)
 
             break;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            internal_fatal(slots == 1,
+                      "DBENGINE: invalid number of slots (%u) or page type (%u)", slots, type);
+
+            // the tier 0 page size, in 8-byte points
+            pg->slots = 4 * RRDENG_GORILLA_32BIT_BUFFER_SLOTS;
+
+            pg->gorilla.aral_index = gettid_cached() % 4;
+            pg->gorilla.writer64 = aral_mallocz(pgd_alloc_globals.aral_gorilla64_writer[pg->gorilla.aral_index]);
+
+            gorilla_buffer_t *gbuf = pgd_gorilla_buffer_alloc(pg);
+            *pg->gorilla.writer64 = gorilla64_writer_init(gbuf, RRDENG_GORILLA_32BIT_BUFFER_SLOTS);
+            pg->gorilla.num_buffers = 1;
+
+            break;
+        }
         default:
             netdata_log_error("%s() - Unknown page type: %uc", __FUNCTION__, type);
             aral_freez(pgd_alloc_globals.aral_pgd, pg);
@@ -232,6 +506,7 @@ PGD *pgd_create_from_disk_data(uint8_t type, void *base, uint32_t size)
             memcpy(pg->raw.data, base, size);
             break;
         case RRDENG_PAGE_TYPE_GORILLA_32BIT:
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT:
             internal_fatal(size == 0, "Asked to create page with 0 data!!!");
             internal_fatal(size % sizeof(uint32_t), "Unaligned gorilla buffer size");
             internal_fatal(size % RRDENG_GORILLA_32BIT_BUFFER_SIZE, "Expected size to be a multiple of %zu-bytes",
@@ -249,6 +524,34 @@ PGD *pgd_create_from_disk_data(uint8_t type, void *base, uint32_t size)
             pg->used = total_entries;
             pg->slots = pg->used;
             break;
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1: {
+            if (!pgd_columns_is_valid(base, size)) {
+                aral_freez(pgd_alloc_globals.aral_pgd, pg);
+                pg = PGD_EMPTY;
+                break;
+            }
+
+            pg->columns.data = mallocz(size);
+            pg->columns.size = size;
+            pg->columns.encoded = NULL;
+            pg->columns.encoded_size = 0;
+            memcpy(pg->columns.data, base, size);
+
+            struct rrdeng_page_columns_header *hdr = (struct rrdeng_page_columns_header *) pg->columns.data;
+            if (!(hdr->options & RRDENG_PAGE_COLUMNS_RAW)) {
+                // each column is a single gorilla buffer
+                uint8_t *column = &pg->columns.data[sizeof(*hdr)];
+                ((gorilla_buffer_t *) column)->header.next = NULL;
+                column += hdr->sum_size;
+                ((gorilla_buffer_t *) column)->header.next = NULL;
+                column += hdr->min_size;
+                ((gorilla_buffer_t *) column)->header.next = NULL;
+            }
+
+            pg->used = hdr->entries;
+            pg->slots = pg->used;
+            break;
+        }
         default:
             netdata_log_error("%s() - Unknown page type: %uc", __FUNCTION__, type);
             aral_freez(pgd_alloc_globals.aral_pgd, pg);
@@ -312,6 +615,40 @@ void pgd_free(PGD *pg)
 
             break;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            if (pg->states & PGD_STATE_CREATED_FROM_DISK) {
+                internal_fatal(pg->raw.data == NULL, "Tried to free gorilla PGD loaded from disk with NULL data");
+                freez(pg->raw.data);
+                pg->raw.data = NULL;
+                break;
+            }
+
+            internal_fatal(pg->gorilla.writer64 == NULL,
+                           "PGD does not have an active gorilla writer");
+
+            while (true) {
+                gorilla_buffer_t *gbuf = gorilla64_writer_drop_head_buffer(pg->gorilla.writer64);
+                if (!gbuf)
+                    break;
+                aral_freez(pgd_alloc_globals.aral_gorilla_buffer[pg->gorilla.aral_index], gbuf);
+                pg->gorilla.num_buffers -= 1;
+            }
+
+            internal_fatal(pg->gorilla.num_buffers != 0,
+                           "Could not free all gorilla writer buffers");
+
+            aral_freez(pgd_alloc_globals.aral_gorilla64_writer[pg->gorilla.aral_index], pg->gorilla.writer64);
+            pg->gorilla.writer64 = NULL;
+            break;
+        }
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+            if (pg->states & PGD_STATE_CREATED_FROM_DISK)
+                freez(pg->columns.data);
+            else {
+                pgd_data_aral_free(pg->columns.data, pg->columns.size);
+                freez(pg->columns.encoded);
+            }
+            break;
         default:
             netdata_log_error("%s() - Unknown page type: %uc", __FUNCTION__, pg->type);
             break;
@@ -378,6 +715,17 @@ uint32_t pgd_memory_footprint(PGD *pg)
 
             break;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            if (pg->states & PGD_STATE_CREATED_FROM_DISK)
+                footprint = sizeof(PGD) + pg->raw.size;
+            else
+                footprint = sizeof(PGD) + sizeof(gorilla64_writer_t) + (pg->gorilla.num_buffers * RRDENG_GORILLA_32BIT_BUFFER_SIZE);
+
+            break;
+        }
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+            footprint = sizeof(PGD) + pg->columns.size + pg->columns.encoded_size;
+            break;
         default:
             netdata_log_error("%s() - Unknown page type: %uc", __FUNCTION__, pg->type);
             break;
@@ -427,6 +775,36 @@ uint32_t pgd_disk_footprint(PGD *pg)
 
             break;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            if (pg->states & PGD_STATE_CREATED_FROM_DISK) {
+                size = pg->raw.size;
+                break;
+            }
+
+            internal_fatal(!pg->gorilla.writer64,
+                           "pgd_disk_footprint() not implemented for NULL gorilla writers");
+
+            size = pg->gorilla.num_buffers * RRDENG_GORILLA_32BIT_BUFFER_SIZE;
+
+            if (pg->states & PGD_STATE_CREATED_FROM_COLLECTOR) {
+                global_statistics_tier0_disk_compressed_bytes(gorilla64_writer_nbytes(pg->gorilla.writer64));
+                global_statistics_tier0_disk_uncompressed_bytes(gorilla64_writer_entries(pg->gorilla.writer64) * sizeof(uint64_t));
+            }
+
+            break;
+        }
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1: {
+            if (pg->states & PGD_STATE_CREATED_FROM_DISK)
+                size = pg->columns.size;
+            else {
+                if (!pg->columns.encoded)
+                    pgd_columns_encode(pg);
+
+                size = pg->columns.encoded_size;
+            }
+
+            break;
+        }
         default:
             netdata_log_error("%s() - Unknown page type: %uc", __FUNCTION__, pg->type);
             break;
@@ -465,6 +843,29 @@ void pgd_copy_to_extent(PGD *pg, uint8_t *dst, uint32_t dst_size)
                            pg, pg->gorilla.writer, dst_size, pg->gorilla.num_buffers);
             break;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            if ((pg->states & PGD_STATE_SCHEDULED_FOR_FLUSHING) == 0)
+                fatal("Copying to extent is supported only for PGDs that are scheduled for flushing.");
+
+            internal_fatal(!pg->gorilla.writer64,
+                           "pgd_copy_to_extent() not implemented for NULL gorilla writers");
+
+            bool ok = gorilla64_writer_serialize(pg->gorilla.writer64, dst, dst_size);
+            UNUSED(ok);
+            internal_fatal(!ok,
+                           "pgd_copy_to_extent() tried to serialize pg=%p, gw=%p (with dst_size=%u bytes, num_buffers=%zu)",
+                           pg, pg->gorilla.writer64, dst_size, pg->gorilla.num_buffers);
+            break;
+        }
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+            internal_fatal(!pg->columns.encoded, "pgd_copy_to_extent() called on a page that has not been encoded");
+            memcpy(dst, pg->columns.encoded, dst_size);
+
+            // queries use the collected array, the encoded page is not needed anymore
+            freez(pg->columns.encoded);
+            pg->columns.encoded = NULL;
+            pg->columns.encoded_size = 0;
+            break;
         default:
             netdata_log_error("%s() - Unknown page type: %uc", __FUNCTION__, pg->type);
             break;
@@ -511,7 +912,8 @@ void pgd_append_point(PGD *pg,
 
             break;
         }
-        case RRDENG_PAGE_TYPE_ARRAY_TIER1: {
+        case RRDENG_PAGE_TYPE_ARRAY_TIER1:
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1: {
             storage_number_tier1_t *tier12_metric_data = (storage_number_tier1_t *)pg->raw.data;
             storage_number_tier1_t t;
             t.sum_value = (float) n;
@@ -547,6 +949,24 @@ void pgd_append_point(PGD *pg,
             }
             break;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            pg->used++;
+            uint64_t t = pgd_double_pack(n, flags);
+
+            if ((pg->options & PAGE_OPTION_ALL_VALUES_EMPTY) && isfinite((double) n))
+                pg->options &= ~PAGE_OPTION_ALL_VALUES_EMPTY;
+
+            if (!gorilla64_writer_write(pg->gorilla.writer64, t)) {
+                gorilla_buffer_t *new_buffer = pgd_gorilla_buffer_alloc(pg);
+                gorilla64_writer_add_buffer(pg->gorilla.writer64, new_buffer, RRDENG_GORILLA_32BIT_BUFFER_SLOTS);
+                pg->gorilla.num_buffers += 1;
+
+                bool ok = gorilla64_writer_write(pg->gorilla.writer64, t);
+                UNUSED(ok);
+                internal_fatal(ok == false, "Failed to writer value in newly allocated gorilla buffer.");
+            }
+            break;
+        }
         default:
             netdata_log_error("%s() - Unknown page type: %uc", __FUNCTION__, pg->type);
             break;
@@ -556,6 +976,78 @@ void pgd_append_point(PGD *pg,
 // ----------------------------------------------------------------------------
 // querying with cursor
 
+#define PGDC_GORILLA_BATCH 128
+
+static inline bool pgdc_columns_next_encoded(PGDC *pgdc, STORAGE_POINT *sp)
+{
+    uint32_t sum, min, max;
+
+    if (!gorilla_reader_read(&pgdc->gr, &sum) ||
+        !gorilla_reader_read(&pgdc->columns.min, &min) ||
+        !gorilla_reader_read(&pgdc->columns.max, &max))
+        return false;
+
+    const struct rrdeng_page_columns_run *runs = pgdc->columns.runs;
+    while (!pgdc->columns.run_left)
+        pgdc->columns.run_left = runs[++pgdc->columns.run].length;
+
+    const struct rrdeng_page_columns_run *run = &runs[pgdc->columns.run];
+    pgdc->columns.run_left--;
+
+    sp->flags = run->anomaly_count ? SN_FLAG_NONE : SN_FLAG_NOT_ANOMALOUS;
+    sp->count = run->count;
+    sp->anomaly_count = run->anomaly_count;
+    sp->min = bits_float(min);
+    sp->max = bits_float(max);
+    sp->sum = bits_float(sum);
+
+    return true;
+}
+
+static void pgdc_columns_seek(PGDC *pgdc, uint32_t position)
+{
+    PGD *pg = pgdc->pgd;
+
+    pgdc->slots = pg->used;
+    pgdc->columns.runs = NULL;
+
+    if (!(pg->states & PGD_STATE_CREATED_FROM_DISK)) {
+        pgdc->columns.array = pg->columns.data;
+        return;
+    }
+
+    struct rrdeng_page_columns_header *hdr = (struct rrdeng_page_columns_header *) pg->columns.data;
+    uint8_t *column = &pg->columns.data[sizeof(*hdr)];
+
+    if (hdr->options & RRDENG_PAGE_COLUMNS_RAW) {
+        pgdc->columns.array = column;
+        return;
+    }
+
+    pgdc->columns.array = NULL;
+
+    pgdc->gr = gorilla_reader_init((gorilla_buffer_t *) column);
+    column += hdr->sum_size;
+    pgdc->columns.min = gorilla_reader_init((gorilla_buffer_t *) column);
+    column += hdr->min_size;
+    pgdc->columns.max = gorilla_reader_init((gorilla_buffer_t *) column);
+    column += hdr->max_size;
+
+    const struct rrdeng_page_columns_run *runs = (const struct rrdeng_page_columns_run *) column;
+    pgdc->columns.runs = runs;
+    pgdc->columns.run = 0;
+    pgdc->columns.run_left = runs[0].length;
+
+    if (position > pgdc->slots)
+        position = pgdc->slots;
+
+    STORAGE_POINT sp;
+    for (uint32_t i = 0; i != position; i++) {
+        if (!pgdc_columns_next_encoded(pgdc, &sp))
+            break;
+    }
+}
+
 static void pgdc_seek(PGDC *pgdc, uint32_t position)
 {
     PGD *pg = pgdc->pgd;
@@ -598,6 +1090,35 @@ static void pgdc_seek(PGDC *pgdc, uint32_t position)
 
             break;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+            pgdc_columns_seek(pgdc, position);
+            break;
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            if (pg->states & PGD_STATE_CREATED_FROM_DISK) {
+                pgdc->slots = pgdc->pgd->slots;
+                pgdc->gr64 = gorilla64_reader_init((void *) pg->raw.data);
+            } else {
+                pgdc->slots = gorilla64_writer_entries(pg->gorilla.writer64);
+                pgdc->gr64 = gorilla64_writer_get_reader(pg->gorilla.writer64);
+            }
+
+            if (position > pgdc->slots)
+                position = pgdc->slots;
+
+            uint64_t values[PGDC_GORILLA_BATCH];
+            while (position) {
+                size_t wanted = position > PGDC_GORILLA_BATCH ? PGDC_GORILLA_BATCH : position;
+                size_t got = gorilla64_reader_read_batch(&pgdc->gr64, values, wanted);
+
+                // this is fine, the reader will return empty points
+                if (!got)
+                    break;
+
+                position -= got;
+            }
+
+            break;
+        }
         default:
             netdata_log_error("%s() - Unknown page type: %uc", __FUNCTION__, pg->type);
             break;
@@ -675,6 +1196,39 @@ bool pgdc_get_next_point(PGDC *pgdc, uint32_t expected_position __maybe_unused,
 
             return ok;
         }
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1: {
+            uint32_t position = pgdc->position++;
+
+            if (pgdc->columns.array) {
+                const storage_number_tier1_t *n = &((const storage_number_tier1_t *) pgdc->columns.array)[position];
+
+                sp->flags = n->anomaly_count ? SN_FLAG_NONE : SN_FLAG_NOT_ANOMALOUS;
+                sp->count = n->count;
+                sp->anomaly_count = n->anomaly_count;
+                sp->min = n->min_value;
+                sp->max = n->max_value;
+                sp->sum = n->sum_value;
+                return true;
+            }
+
+            if (pgdc_columns_next_encoded(pgdc, sp))
+                return true;
+
+            storage_point_empty(*sp, sp->start_time_s, sp->end_time_s);
+            return false;
+        }
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            pgdc->position++;
+
+            uint64_t n;
+            if (gorilla64_reader_read(&pgdc->gr64, &n)) {
+                storage_point_from_double_bits(sp, n);
+                return true;
+            }
+
+            storage_point_empty(*sp, sp->start_time_s, sp->end_time_s);
+            return false;
+        }
         default: {
             static bool logged = false;
             if (!logged)
@@ -689,3 +1243,110 @@ bool pgdc_get_next_point(PGDC *pgdc, uint32_t expected_position __maybe_unused,
         }
     }
 }
+
+static inline void storage_point_from_storage_number(STORAGE_POINT *sp, storage_number n)
+{
+    sp->min = sp->max = sp->sum = unpack_storage_number(n);
+    sp->flags = (SN_FLAGS)(n & SN_USER_FLAGS);
+    sp->count = 1;
+    sp->anomaly_count = is_storage_number_anomalous(n) ? 1 : 0;
+}
+
+// decode up to max consecutive points of the page, starting at the cursor position
+// only the values are filled - the caller is responsible for the timestamps of the points
+// returns the number of points decoded; the cursor is advanced by the same number
+// when it returns 0, pgdc_get_next_point() should be used to get the (empty) next point
+uint32_t pgdc_get_next_points(PGDC *pgdc, uint32_t expected_position __maybe_unused, STORAGE_POINT *sps, uint32_t max)
+{
+    if (!pgdc->pgd || pgdc->pgd == PGD_EMPTY || pgdc->position >= pgdc->slots || !max)
+        return 0;
+
+    internal_fatal(pgdc->position != expected_position, "Wrong expected cursor position");
+
+    if (max > pgdc->slots - pgdc->position)
+        max = pgdc->slots - pgdc->position;
+
+    switch (pgdc->pgd->type)
+    {
+        case RRDENG_PAGE_TYPE_ARRAY_32BIT: {
+            storage_number *array = &((storage_number *) pgdc->pgd->raw.data)[pgdc->position];
+
+            for (uint32_t i = 0; i < max; i++)
+                storage_point_from_storage_number(&sps[i], array[i]);
+
+            pgdc->position += max;
+            return max;
+        }
+        case RRDENG_PAGE_TYPE_ARRAY_TIER1:
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1: {
+            if (pgdc->pgd->type == RRDENG_PAGE_TYPE_GORILLA_TIER1 && !pgdc->columns.array) {
+                uint32_t decoded = 0;
+                while (decoded < max && pgdc_columns_next_encoded(pgdc, &sps[decoded]))
+                    decoded++;
+
+                pgdc->position += decoded;
+                return decoded;
+            }
+
+            const storage_number_tier1_t *array = (pgdc->pgd->type == RRDENG_PAGE_TYPE_GORILLA_TIER1) ?
+                    &((const storage_number_tier1_t *) pgdc->columns.array)[pgdc->position] :
+                    &((const storage_number_tier1_t *) pgdc->pgd->raw.data)[pgdc->position];
+
+            for (uint32_t i = 0; i < max; i++) {
+                sps[i].flags = array[i].anomaly_count ? SN_FLAG_NONE : SN_FLAG_NOT_ANOMALOUS;
+                sps[i].count = array[i].count;
+                sps[i].anomaly_count = array[i].anomaly_count;
+                sps[i].min = array[i].min_value;
+                sps[i].max = array[i].max_value;
+                sps[i].sum = array[i].sum_value;
+            }
+
+            pgdc->position += max;
+            return max;
+        }
+        case RRDENG_PAGE_TYPE_GORILLA_32BIT: {
+            uint32_t numbers[PGDC_GORILLA_BATCH];
+            uint32_t decoded = 0;
+
+            while (decoded < max) {
+                uint32_t wanted = max - decoded;
+                if (wanted > PGDC_GORILLA_BATCH)
+                    wanted = PGDC_GORILLA_BATCH;
+
+                uint32_t got = (uint32_t) gorilla_reader_read_batch(&pgdc->gr, numbers, wanted);
+                for (uint32_t i = 0; i < got; i++)
+                    storage_point_from_storage_number(&sps[decoded + i], numbers[i]);
+
+                decoded += got;
+                if (got < wanted)
+                    break;
+            }
+
+            pgdc->position += decoded;
+            return decoded;
+        }
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT: {
+            uint64_t numbers[PGDC_GORILLA_BATCH];
+            uint32_t decoded = 0;
+
+            while (decoded < max) {
+                uint32_t wanted = max - decoded;
+                if (wanted > PGDC_GORILLA_BATCH)
+                    wanted = PGDC_GORILLA_BATCH;
+
+                uint32_t got = (uint32_t) gorilla64_reader_read_batch(&pgdc->gr64, numbers, wanted);
+                for (uint32_t i = 0; i < got; i++)
+                    storage_point_from_double_bits(&sps[decoded + i], numbers[i]);
+
+                decoded += got;
+                if (got < wanted)
+                    break;
+            }
+
+            pgdc->position += decoded;
+            return decoded;
+        }
+        default:
+            return 0;
+    }
+}
@@ -15,6 +15,19 @@ typedef struct pgd_cursor {
     uint32_t slots;
 
     gorilla_reader_t gr;
+
+    // RRDENG_PAGE_TYPE_GORILLA_64BIT
+    gorilla64_reader_t gr64;
+
+    // RRDENG_PAGE_TYPE_GORILLA_TIER1
+    struct {
+        const void *array;          // not encoded pages - points to the storage_number_tier1_t array
+        const void *runs;           // encoded pages - count and anomaly_count runs
+        gorilla_reader_t min;       // encoded pages - the sum is read with gr
+        gorilla_reader_t max;
+        uint16_t run;
+        uint16_t run_left;
+    } columns;
 } PGDC;
 
 #include "rrdengine.h"
@@ -50,6 +63,7 @@ void pgd_append_point(PGD *pg,
 
 void pgdc_reset(PGDC *pgdc, PGD *pgd, uint32_t position);
 bool pgdc_get_next_point(PGDC *pgdc, uint32_t expected_position, STORAGE_POINT *sp);
+uint32_t pgdc_get_next_points(PGDC *pgdc, uint32_t expected_position, STORAGE_POINT *sps, uint32_t max);
 
 #ifdef __cplusplus
 }
@@ -4,8 +4,10 @@
 #ifdef HAVE_GTEST
 
 #include <gtest/gtest.h>
+#include <cmath>
 #include <limits>
 #include <random>
+#include <vector>
 
 bool operator==(const STORAGE_POINT lhs, const STORAGE_POINT rhs) {
     if (lhs.min != rhs.min)
@@ -194,6 +196,46 @@ TEST(PGD, CursorHalfPage) {
     pgd_free(pg);
 }
 
+TEST(PGD, CursorBatch) {
+    size_t slots = slots_for_page(1024 * 1024);
+    PGD *pg = pgd_create(page_type, slots);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> value(0, 1000);
+    std::uniform_int_distribution<uint32_t> batch(1, 300);
+
+    for (size_t slot = 0; slot != slots; slot++)
+        pgd_append_point(pg, slot, value(gen), 0, 0, 1, 0, SN_DEFAULT_FLAGS, slot);
+
+    PGDC cursor_single;
+    PGDC cursor_batch;
+    pgdc_reset(&cursor_single, pg, 0);
+    pgdc_reset(&cursor_batch, pg, 0);
+
+    std::vector<STORAGE_POINT> sps(300);
+    size_t slot = 0;
+    while (slot != slots) {
+        uint32_t n = pgdc_get_next_points(&cursor_batch, slot, sps.data(), batch(gen));
+        ASSERT_NE(n, 0u);
+
+        for (uint32_t i = 0; i != n; i++) {
+            STORAGE_POINT sp;
+            EXPECT_TRUE(pgdc_get_next_point(&cursor_single, slot + i, &sp));
+
+            sps[i].start_time_s = sp.start_time_s;
+            sps[i].end_time_s = sp.end_time_s;
+            EXPECT_EQ(sp, sps[i]);
+            EXPECT_EQ(sp.anomaly_count, sps[i].anomaly_count);
+        }
+
+        slot += n;
+    }
+
+    EXPECT_EQ(pgdc_get_next_points(&cursor_batch, slots, sps.data(), sps.size()), 0);
+
+    pgd_free(pg);
+}
+
 TEST(PGD, MemoryFootprint) {
     size_t slots = slots_for_page(1024 * 1024);
     PGD *pg = pgd_create(page_type, slots);
@@ -377,6 +419,134 @@ TEST(PGD, Roundtrip) {
     pgd_free(pg_collector);
 }
 
+TEST(PGD, Tier1ColumnsRoundtrip) {
+    size_t slots = 128;
+    PGD *pg_collector = pgd_create(RRDENG_PAGE_TYPE_GORILLA_TIER1, slots);
+
+    for (size_t i = 0; i != slots; i++) {
+        NETDATA_DOUBLE v = (i % 10) ? 1000.0 + (NETDATA_DOUBLE) (i % 7) : NAN;
+        pgd_append_point(pg_collector, i, v * 60, v - 1, v + 1, 60, (i % 32) ? 0 : 3, SN_DEFAULT_FLAGS, i);
+    }
+
+    uint32_t size_in_bytes = pgd_disk_footprint(pg_collector);
+    EXPECT_LT(size_in_bytes, slots * sizeof(storage_number_tier1_t));
+
+    std::vector<uint8_t> disk_buffer(size_in_bytes, 0xFF);
+    pgd_copy_to_extent(pg_collector, disk_buffer.data(), size_in_bytes);
+
+    PGD *pg_disk = pgd_create_from_disk_data(RRDENG_PAGE_TYPE_GORILLA_TIER1, disk_buffer.data(), size_in_bytes);
+    ASSERT_NE(pg_disk, PGD_EMPTY);
+    EXPECT_EQ(pgd_slots_used(pg_disk), slots);
+    EXPECT_NEAR(pgd_memory_footprint(pg_disk), size_in_bytes, 128);
+
+    for (uint32_t position : {0u, 1u, 63u, 127u}) {
+        PGDC cursor_collector;
+        PGDC cursor_disk;
+
+        pgdc_reset(&cursor_collector, pg_collector, position);
+        pgdc_reset(&cursor_disk, pg_disk, position);
+
+        STORAGE_POINT sp_collector = {};
+        STORAGE_POINT sp_disk = {};
+
+        for (size_t slot = position; slot != slots; slot++) {
+            EXPECT_TRUE(pgdc_get_next_point(&cursor_collector, slot, &sp_collector));
+            EXPECT_TRUE(pgdc_get_next_point(&cursor_disk, slot, &sp_disk));
+
+            EXPECT_EQ(std::isnan(sp_collector.sum), std::isnan(sp_disk.sum));
+            if (!std::isnan(sp_collector.sum))
+                EXPECT_EQ(sp_collector, sp_disk);
+
+            EXPECT_EQ(sp_collector.anomaly_count, sp_disk.anomaly_count);
+        }
+
+        EXPECT_FALSE(pgdc_get_next_point(&cursor_collector, slots, &sp_collector));
+        EXPECT_FALSE(pgdc_get_next_point(&cursor_disk, slots, &sp_disk));
+    }
+
+    // corrupted pages are rejected
+    disk_buffer[0] ^= 0xFF;
+    EXPECT_EQ(pgd_create_from_disk_data(RRDENG_PAGE_TYPE_GORILLA_TIER1, disk_buffer.data(), size_in_bytes), PGD_EMPTY);
+
+    pgd_free(pg_disk);
+    pgd_free(pg_collector);
+}
+
+TEST(PGD, Gorilla64Roundtrip) {
+    PGD *pg_collector = pgd_create(RRDENG_PAGE_TYPE_GORILLA_64BIT, RRDENG_GORILLA_32BIT_BUFFER_SLOTS);
+    uint32_t slots = 500;
+
+    // a big counter, increasing slowly, with a few gaps, anomalies and resets
+    std::vector<NETDATA_DOUBLE> values(slots);
+    for (uint32_t i = 0; i != slots; i++) {
+        values[i] = (i % 100 == 99) ? NAN : 123456789012.0 + (NETDATA_DOUBLE) (i / 10) * 4;
+
+        SN_FLAGS flags = SN_DEFAULT_FLAGS;
+        if (i % 50 == 7)
+            flags = SN_FLAG_NONE;
+        if (i % 100 == 13)
+            flags = (SN_FLAGS) (flags | SN_FLAG_RESET);
+
+        pgd_append_point(pg_collector, i, values[i], 0, 0, 1, 0, flags, i);
+    }
+
+    uint32_t size_in_bytes = pgd_disk_footprint(pg_collector);
+    EXPECT_LT(size_in_bytes, slots * sizeof(storage_number));
+    EXPECT_EQ(size_in_bytes % RRDENG_GORILLA_32BIT_BUFFER_SIZE, 0);
+
+    std::vector<uint8_t> disk_buffer(size_in_bytes, 0);
+    pgd_copy_to_extent(pg_collector, disk_buffer.data(), size_in_bytes);
+
+    PGD *pg_disk = pgd_create_from_disk_data(RRDENG_PAGE_TYPE_GORILLA_64BIT, disk_buffer.data(), size_in_bytes);
+    ASSERT_NE(pg_disk, PGD_EMPTY);
+    EXPECT_EQ(pgd_slots_used(pg_disk), slots);
+
+    for (PGD *pg : {pg_collector, pg_disk}) {
+        for (uint32_t position : {0u, 1u, 199u, 499u}) {
+            PGDC cursor;
+            pgdc_reset(&cursor, pg, position);
+
+            STORAGE_POINT sp = {};
+            for (uint32_t slot = position; slot != slots; slot++) {
+                EXPECT_TRUE(pgdc_get_next_point(&cursor, slot, &sp));
+
+                if (std::isnan(values[slot])) {
+                    EXPECT_TRUE(std::isnan(sp.sum));
+                    continue;
+                }
+
+                // the values keep their precision, unlike storage_number
+                EXPECT_EQ(sp.sum, values[slot]);
+                EXPECT_EQ(sp.anomaly_count, (slot % 50 == 7) ? 1 : 0);
+                EXPECT_EQ((bool) (sp.flags & SN_FLAG_RESET), slot % 100 == 13);
+            }
+
+            EXPECT_FALSE(pgdc_get_next_point(&cursor, slots, &sp));
+        }
+
+        // the batch decoder returns the same points
+        PGDC cursor_point, cursor_batch;
+        pgdc_reset(&cursor_point, pg, 3);
+        pgdc_reset(&cursor_batch, pg, 3);
+
+        std::vector<STORAGE_POINT> sps(slots);
+        EXPECT_EQ(pgdc_get_next_points(&cursor_batch, 3, sps.data(), slots), slots - 3);
+
+        for (uint32_t slot = 3; slot != slots; slot++) {
+            STORAGE_POINT sp = {};
+            EXPECT_TRUE(pgdc_get_next_point(&cursor_point, slot, &sp));
+
+            sps[slot - 3].start_time_s = sp.start_time_s;
+            sps[slot - 3].end_time_s = sp.end_time_s;
+            if (!std::isnan(sp.sum))
+                EXPECT_EQ(sps[slot - 3], sp);
+        }
+    }
+
+    pgd_free(pg_disk);
+    pgd_free(pg_collector);
+}
+
 int pgd_test(int argc, char *argv[])
 {
     // Dummy/necessary initialization stuff
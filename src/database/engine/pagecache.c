@@ -213,6 +213,8 @@ static inline struct page_details *pdc_find_page_for_time(
     return NULL;
 }
 
+#define PAGE_LIST_FROM_PGC_BATCH 32
+
 static size_t get_page_list_from_pgc(PGC *cache, METRIC *metric, struct rrdengine_instance *ctx,
         time_t wanted_start_time_s, time_t wanted_end_time_s,
         Pvoid_t *JudyL_page_array, size_t *cache_gaps,
@@ -230,10 +232,20 @@ static size_t get_page_list_from_pgc(PGC *cache, METRIC *metric, struct rrdengin
     time_t previous_page_end_time_s = now_s - dt_s;
     bool first = true;
 
+    // the pages are acquired in batches, with one cache index search per batch
+    PGC_PAGE *pages[PAGE_LIST_FROM_PGC_BATCH];
+    size_t pages_used = 0, pages_pos = 0;
+
     do {
-        PGC_PAGE *page = pgc_page_get_and_acquire(
-                cache, (Word_t)ctx, (Word_t)metric_id, now_s,
-                (first) ? PGC_SEARCH_CLOSEST : PGC_SEARCH_NEXT);
+        if(pages_pos == pages_used) {
+            pages_used = pgc_pages_get_and_acquire_range(
+                    cache, (Word_t)ctx, (Word_t)metric_id, now_s, wanted_end_time_s,
+                    (first) ? PGC_SEARCH_CLOSEST : PGC_SEARCH_NEXT,
+                    pages, PAGE_LIST_FROM_PGC_BATCH);
+            pages_pos = 0;
+        }
+
+        PGC_PAGE *page = (pages_pos < pages_used) ? pages[pages_pos++] : NULL;
 
         first = false;
 
@@ -256,6 +268,10 @@ static size_t get_page_list_from_pgc(PGC *cache, METRIC *metric, struct rrdengin
             pgc_page_release(cache, page);
             page = NULL;
 
+            // release the rest of the batch too
+            while(pages_pos < pages_used)
+                pgc_page_release(cache, pages[pages_pos++]);
+
             if(previous_page_end_time_s < wanted_end_time_s)
                 (*cache_gaps)++;
 
@@ -327,6 +343,9 @@ static size_t get_page_list_from_pgc(PGC *cache, METRIC *metric, struct rrdengin
 
     } while(now_s <= wanted_end_time_s);
 
+    while(pages_pos < pages_used)
+        pgc_page_release(cache, pages[pages_pos++]);
+
     return pages_found_in_cache;
 }
 
@@ -1049,6 +1068,163 @@ size_t dynamic_extent_cache_size(void) {
     return target_size;
 }
 
+// ----------------------------------------------------------------------------
+// memory pressure control of the main cache
+//
+// Once per second, the dbengine timer checks the memory of the agent's cgroup
+// (memory.max and memory.current), or of the system when there is no limit,
+// together with the memory pressure stall information of the kernel.
+// Under pressure, the clean size of the main cache is lowered, and the next
+// eviction run frees the clean pages above it, before the kernel has to
+// reclaim memory. When memory is idle, it grows back, up to a maximum.
+
+#define MEMORY_PRESSURE_SHRINK_PSI          10.0    // % of time some tasks stalled on memory (avg10)
+#define MEMORY_PRESSURE_GROW_PSI             1.0
+#define MEMORY_PRESSURE_SHRINK_FREE_PERCENT  5ULL   // % of the memory limit still available
+#define MEMORY_PRESSURE_GROW_FREE_PERCENT   25ULL
+
+static struct {
+    bool enabled;
+    size_t min_size;
+    size_t max_size;
+    size_t step;
+
+    char memory_max_filename[FILENAME_MAX + 1];
+    char memory_current_filename[FILENAME_MAX + 1];
+    char memory_pressure_filename[FILENAME_MAX + 1];
+
+    // the decisions, for the worker metrics
+    NETDATA_DOUBLE pressure;
+    size_t shrinks;
+    size_t grows;
+} main_cache_memory = { 0 };
+
+static void main_cache_memory_pressure_init(size_t main_cache_size) {
+    main_cache_memory.enabled = config_get_boolean(CONFIG_SECTION_DB, "dbengine page cache memory pressure control", CONFIG_BOOLEAN_NO);
+    if(!main_cache_memory.enabled)
+        return;
+
+    // 0 = automatic, twice the main cache
+    size_t max_size = (size_t)config_get_size_mb(CONFIG_SECTION_DB, "dbengine page cache max size", 0) * 1024ULL * 1024ULL;
+    if(!max_size)
+        max_size = main_cache_size * 2;
+    if(max_size < main_cache_size)
+        max_size = main_cache_size;
+
+    main_cache_memory.max_size = max_size;
+    main_cache_memory.min_size = MAX(main_cache_size / 4, (size_t)RRDENG_MIN_PAGE_CACHE_SIZE_MB * 1024ULL * 1024ULL);
+    main_cache_memory.step = MAX(main_cache_size / 10, 1ULL * 1024 * 1024);
+
+    // the cgroup v2 of the agent, when there is one
+    char cgroup[FILENAME_MAX + 1] = "";
+    char buffer[4096];
+    if(read_txt_file("/proc/self/cgroup", buffer, sizeof(buffer)) == 0) {
+        char *s = strstr(buffer, "0::");
+        if(s && (s == buffer || s[-1] == '\n')) {
+            s += 3;
+            char *e = strchr(s, '\n');
+            if(e) *e = '\0';
+            if(strcmp(s, "/") != 0)
+                strncpyz(cgroup, s, sizeof(cgroup) - 1);
+        }
+    }
+
+    snprintfz(main_cache_memory.memory_max_filename, FILENAME_MAX, "/sys/fs/cgroup%s/memory.max", cgroup);
+    snprintfz(main_cache_memory.memory_current_filename, FILENAME_MAX, "/sys/fs/cgroup%s/memory.current", cgroup);
+    snprintfz(main_cache_memory.memory_pressure_filename, FILENAME_MAX, "/sys/fs/cgroup%s/memory.pressure", cgroup);
+
+    if(access(main_cache_memory.memory_pressure_filename, R_OK) != 0)
+        strncpyz(main_cache_memory.memory_pressure_filename, "/proc/pressure/memory", FILENAME_MAX);
+}
+
+static bool main_cache_memory_get(uint64_t *limit, uint64_t *used) {
+    unsigned long long max = 0, current = 0;
+    if(read_single_number_file(main_cache_memory.memory_max_filename, &max) == 0 && max &&
+        read_single_number_file(main_cache_memory.memory_current_filename, &current) == 0) {
+        // memory.max is "max" when the cgroup has no limit, which parses to zero
+        *limit = max;
+        *used = current;
+        return true;
+    }
+
+    char buffer[4096];
+    if(read_txt_file("/proc/meminfo", buffer, sizeof(buffer)) != 0)
+        return false;
+
+    char *total = strstr(buffer, "MemTotal:");
+    char *available = strstr(buffer, "MemAvailable:");
+    if(!total || !available)
+        return false;
+
+    uint64_t total_kb = str2ull(total + sizeof("MemTotal:") - 1, NULL);
+    uint64_t available_kb = str2ull(available + sizeof("MemAvailable:") - 1, NULL);
+    if(!total_kb || available_kb > total_kb)
+        return false;
+
+    *limit = total_kb * 1024;
+    *used = (total_kb - available_kb) * 1024;
+    return true;
+}
+
+static NETDATA_DOUBLE main_cache_memory_pressure_get(void) {
+    char buffer[1024];
+    if(read_txt_file(main_cache_memory.memory_pressure_filename, buffer, sizeof(buffer)) != 0)
+        return 0.0;
+
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    char *s = strstr(buffer, "some avg10=");
+    if(!s)
+        return 0.0;
+
+    return str2ndd(s + sizeof("some avg10=") - 1, NULL);
+}
+
+void main_cache_memory_pressure_control(void) {
+    if(!main_cache_memory.enabled || !main_cache)
+        return;
+
+    uint64_t limit, used;
+    if(!main_cache_memory_get(&limit, &used) || !limit)
+        return;
+
+    uint64_t available = (used < limit) ? limit - used : 0;
+    NETDATA_DOUBLE pressure = main_cache_memory_pressure_get();
+    main_cache_memory.pressure = pressure;
+
+    size_t clean_size = pgc_get_clean_size(main_cache);
+    size_t wanted = clean_size;
+
+    if(pressure >= MEMORY_PRESSURE_SHRINK_PSI || available < limit * MEMORY_PRESSURE_SHRINK_FREE_PERCENT / 100ULL) {
+        wanted = (clean_size > main_cache_memory.min_size + main_cache_memory.step) ? clean_size - main_cache_memory.step : main_cache_memory.min_size;
+        if(wanted < clean_size)
+            main_cache_memory.shrinks++;
+    }
+    else if(pressure < MEMORY_PRESSURE_GROW_PSI && available > limit * MEMORY_PRESSURE_GROW_FREE_PERCENT / 100ULL) {
+        wanted = MIN(clean_size + main_cache_memory.step, main_cache_memory.max_size);
+        if(wanted > clean_size)
+            main_cache_memory.grows++;
+    }
+
+    if(wanted != clean_size)
+        pgc_set_clean_size(main_cache, wanted);
+}
+
+bool main_cache_memory_pressure_statistics(NETDATA_DOUBLE *pressure, size_t *clean_size, size_t *shrinks, size_t *grows) {
+    if(!main_cache_memory.enabled)
+        return false;
+
+    *pressure = main_cache_memory.pressure;
+    *clean_size = main_cache ? pgc_get_clean_size(main_cache) : 0;
+    *shrinks = main_cache_memory.shrinks;
+    *grows = main_cache_memory.grows;
+    return true;
+}
+
+static PGC_EVICTION_POLICY pgc_eviction_policy_from_config(const char *option) {
+    return pgc_eviction_policy_id(
+        config_get(CONFIG_SECTION_DB, option, pgc_eviction_policy_name(PGC_EVICTION_LRU)));
+}
+
 void pgc_and_mrg_initialize(void)
 {
     main_mrg = mrg_create(0);
@@ -1076,10 +1252,21 @@ void pgc_and_mrg_initialize(void)
             10240,                                      // if there are that many threads, evict so many at once!
             1000,                           //
             5,                                          // don't delay too much other threads
-            PGC_OPTIONS_AUTOSCALE,                               // AUTOSCALE = 2x max hot pages
+            PGC_OPTIONS_AUTOSCALE |                              // AUTOSCALE = 2x max hot pages
+                (dbengine_use_huge_pages ? PGC_OPTIONS_HUGE_PAGES : PGC_OPTIONS_NONE),
             0,                                                 // 0 = as many as the system cpus
             0
     );
+    pgc_set_eviction_policy(main_cache, pgc_eviction_policy_from_config("dbengine page cache eviction policy"));
+
+    // the dirty pages are what shutdown has to save, so we keep them bounded
+    // 0 = automatic, a quarter of the main cache
+    size_t dirty_max_size = (size_t)config_get_size_mb(CONFIG_SECTION_DB, "dbengine dirty pages max size", 0) * 1024ULL * 1024ULL;
+    if(!dirty_max_size)
+        dirty_max_size = main_cache_size / 4;
+    pgc_set_dirty_max_size(main_cache, dirty_max_size);
+
+    main_cache_memory_pressure_init(main_cache_size);
 
     open_cache = pgc_create(
             "open_cache",
@@ -1097,6 +1284,7 @@ void pgc_and_mrg_initialize(void)
             sizeof(struct extent_io_data)
     );
     pgc_set_dynamic_target_cache_size_callback(open_cache, dynamic_open_cache_size);
+    pgc_set_eviction_policy(open_cache, pgc_eviction_policy_from_config("dbengine open cache eviction policy"));
 
     extent_cache = pgc_create(
             "extent_cache",
@@ -1114,4 +1302,5 @@ void pgc_and_mrg_initialize(void)
             0
     );
     pgc_set_dynamic_target_cache_size_callback(extent_cache, dynamic_extent_cache_size);
+    pgc_set_eviction_policy(extent_cache, pgc_eviction_policy_from_config("dbengine extent cache eviction policy"));
 }
@@ -2,6 +2,8 @@
 #define NETDATA_RRD_INTERNALS
 #include "pdc.h"
 #include "dbengine-compression.h"
+#include "dbengine-uring.h"
+#include "dbengine-archive.h"
 
 struct extent_page_details_list {
     uv_file file;
@@ -19,8 +21,18 @@ struct extent_page_details_list {
         struct extent_page_details_list *prev;
         struct extent_page_details_list *next;
     } query;
+
+    struct {
+        struct extent_page_details_list *next;      // the next extent of the same datafile, read together with this one
+        execute_extent_page_details_list_t exec;    // dispatches the next extents once they have been read
+        PGC_PAGE *extent_cache_page;                // the extent, already acquired in the extent cache
+        bool extent_read_from_disk;                 // extent_cache_page has been read by the coalesced read
+    } coalesced;
 };
 
+// the max size of a coalesced read
+#define EPDL_COALESCED_READ_MAX_BYTES (4 * 1024 * 1024)
+
 typedef struct datafile_extent_offset_list {
     uv_file file;
     unsigned fileno;
@@ -57,6 +69,7 @@ void pdc_init(void) {
             NULL,
             NULL, NULL, false, false
             );
+    aral_magazines_enable(pdc_globals.pdc.ar);
 }
 
 PDC *pdc_get(void) {
@@ -85,6 +98,7 @@ void page_details_init(void) {
             NULL,
             NULL, NULL, false, false
     );
+    aral_magazines_enable(pdc_globals.pd.ar);
 }
 
 struct page_details *page_details_get(void) {
@@ -113,6 +127,7 @@ void epdl_init(void) {
             NULL,
             NULL, NULL, false, false
     );
+    aral_magazines_enable(pdc_globals.epdl.ar);
 }
 
 static EPDL *epdl_get(void) {
@@ -141,6 +156,7 @@ void deol_init(void) {
             NULL,
             NULL, NULL, false, false
     );
+    aral_magazines_enable(pdc_globals.deol.ar);
 }
 
 static DEOL *deol_get(void) {
@@ -495,6 +511,26 @@ static void epdl_pending_del(EPDL *epdl) {
     spinlock_unlock(&epdl->datafile->extent_queries.spinlock);
 }
 
+static inline bool epdl_can_be_coalesced(EPDL *head, EPDL *tail, EPDL *epdl) {
+    uint64_t tail_end = tail->extent_offset + ALIGN_BYTES_CEILING(tail->extent_size);
+    uint64_t epdl_end = epdl->extent_offset + ALIGN_BYTES_CEILING(epdl->extent_size);
+
+    return epdl->file == head->file &&
+           epdl->extent_offset >= tail_end &&
+           epdl->extent_offset - tail_end <= rrdeng_extent_read_coalesce_gap_bytes &&
+           epdl_end - head->extent_offset <= EPDL_COALESCED_READ_MAX_BYTES;
+}
+
+static void epdl_dispatch(struct rrdengine_instance *ctx, EPDL *epdl, size_t extent_list_no, execute_extent_page_details_list_t exec_first_extent_list, execute_extent_page_details_list_t exec_rest_extent_list) {
+    // the worker of the first extent dispatches the rest of a coalesced read
+    epdl->coalesced.exec = exec_rest_extent_list;
+
+    if (extent_list_no == 0)
+        exec_first_extent_list(ctx, epdl, epdl->pdc->priority);
+    else
+        exec_rest_extent_list(ctx, epdl, epdl->pdc->priority);
+}
+
 void pdc_to_epdl_router(struct rrdengine_instance *ctx, PDC *pdc, execute_extent_page_details_list_t exec_first_extent_list, execute_extent_page_details_list_t exec_rest_extent_list)
 {
     Pvoid_t *PValue;
@@ -569,6 +605,7 @@ void pdc_to_epdl_router(struct rrdengine_instance *ctx, PDC *pdc, execute_extent
         while((PValue = PDCJudyLFirstThenNext(JudyL_datafile_list, &datafile_no, &first_then_next))) {
             deol = *PValue;
 
+            EPDL *read_head = NULL, *read_tail = NULL;
             bool first_then_next_extent = true;
             Word_t pos = 0;
             while ((PValue = PDCJudyLFirstThenNext(deol->extent_pd_list_by_extent_offset_JudyL, &pos, &first_then_next_extent))) {
@@ -582,13 +619,25 @@ void pdc_to_epdl_router(struct rrdengine_instance *ctx, PDC *pdc, execute_extent
                 pdc_acquire(pdc); // we do this for the next worker: do_read_extent_work()
                 epdl->pdc = pdc;
 
-                if(epdl_pending_add(epdl)) {
-                    if (extent_list_no++ == 0)
-                        exec_first_extent_list(ctx, epdl, pdc->priority);
-                    else
-                        exec_rest_extent_list(ctx, epdl, pdc->priority);
+                if(!epdl_pending_add(epdl))
+                    continue;
+
+                // the extents are in offset order, so neighboring extents are read together
+                if(read_head && epdl_can_be_coalesced(read_head, read_tail, epdl)) {
+                    read_tail->coalesced.next = epdl;
+                    read_tail = epdl;
+                    continue;
                 }
+
+                if(read_head)
+                    epdl_dispatch(ctx, read_head, extent_list_no++, exec_first_extent_list, exec_rest_extent_list);
+
+                read_head = read_tail = epdl;
             }
+
+            if(read_head)
+                epdl_dispatch(ctx, read_head, extent_list_no++, exec_first_extent_list, exec_rest_extent_list);
+
             PDCJudyLFreeArray(&deol->extent_pd_list_by_extent_offset_JudyL, PJE0);
             deol_release(deol);
         }
@@ -629,6 +678,21 @@ void collect_page_flags_to_buffer(BUFFER *wb, RRDENG_COLLECT_PAGE_FLAGS flags) {
         buffer_strcat(wb, "STEP_UNALIGNED");
 }
 
+// the number of gorilla buffers a page may need beyond RRDENG_BLOCK_SIZE, when its data do not compress
+static inline size_t gorilla_page_max_extra_buffers(uint8_t page_type) {
+    switch (page_type) {
+        case RRDENG_PAGE_TYPE_GORILLA_32BIT:
+            return 1;
+
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT:
+            // up to 72 bits per point, for 512 points
+            return 2;
+
+        default:
+            return 0;
+    }
+}
+
 inline VALIDATED_PAGE_DESCRIPTOR validate_extent_page_descr(const struct rrdeng_extent_page_descr *descr, time_t now_s, uint32_t overwrite_zero_update_every_s, bool have_read_error) {
     time_t start_time_s = (time_t) (descr->start_time_ut / USEC_PER_SEC);
 
@@ -642,6 +706,8 @@ inline VALIDATED_PAGE_DESCRIPTOR validate_extent_page_descr(const struct rrdeng_
             entries = 0;
             break;
         case RRDENG_PAGE_TYPE_GORILLA_32BIT:
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT:
             end_time_s = start_time_s + descr->gorilla.delta_time_s;
             entries = descr->gorilla.entries;
             break;
@@ -700,6 +766,8 @@ VALIDATED_PAGE_DESCRIPTOR validate_page(
                 entries = vd.entries;
             break;
         case RRDENG_PAGE_TYPE_GORILLA_32BIT:
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT:
             internal_fatal(entries == 0, "0 number of entries found on gorilla page");
             vd.entries = entries;
             break;
@@ -726,7 +794,7 @@ VALIDATED_PAGE_DESCRIPTOR validate_page(
     // If gorilla can not compress the data we might end up needing slightly more
     // than 4KiB. However, gorilla pages extend the page length by increments of
     // 512 bytes.
-    max_page_length += ((page_type == RRDENG_PAGE_TYPE_GORILLA_32BIT) * RRDENG_GORILLA_32BIT_BUFFER_SIZE);
+    max_page_length += gorilla_page_max_extra_buffers(page_type) * RRDENG_GORILLA_32BIT_BUFFER_SIZE;
 
     if (!known_page_type                                        ||
         have_read_error                                         ||
@@ -852,7 +920,7 @@ static inline struct page_details *epdl_get_pd_load_link_list_from_metric_start_
                 internal_fatal(metric_id != pd->metric_id, "DBENGINE: metric ids do not match");
 
                 if(likely(!pd->page)) {
-                    if (unlikely(__atomic_load_n(&ep->pdc->workers_should_stop, __ATOMIC_RELAXED)))
+                    if (unlikely(pdc_workers_should_stop(ep->pdc)))
                         pdc_page_status_set(pd, PDC_PAGE_FAILED | PDC_PAGE_CANCELLED);
                     else
                         DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(pd_list, pd, load.prev, load.next);
@@ -879,6 +947,8 @@ static void epdl_extent_loading_error_log(struct rrdengine_instance *ctx, EPDL *
                 end_time_s = (time_t)(descr->end_time_ut / USEC_PER_SEC);
                 break;
             case RRDENG_PAGE_TYPE_GORILLA_32BIT:
+            case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+            case RRDENG_PAGE_TYPE_GORILLA_64BIT:
                 end_time_s = (time_t) start_time_s + (descr->gorilla.delta_time_s);
                 break;
         }
@@ -983,12 +1053,13 @@ static bool epdl_populate_pages_from_extent_data(
         return false;
     }
 
-    crc = crc32(0L, Z_NULL, 0);
-    crc = crc32(crc, data, epdl->extent_size - sizeof(*trailer));
+    crc = rrdeng_checksum(epdl->datafile->checksum, data, epdl->extent_size - sizeof(*trailer));
     if (unlikely(crc32cmp(trailer->checksum, crc))) {
         ctx_io_error(ctx);
         have_read_error = true;
-        epdl_extent_loading_error_log(ctx, epdl, NULL, "CRC32 checksum FAILED");
+        epdl_extent_loading_error_log(ctx, epdl, NULL,
+                                      epdl->datafile->checksum == RRDENG_CHECKSUM_CRC32C ?
+                                          "CRC32C checksum FAILED" : "CRC32 checksum FAILED");
     }
 
     if(worker)
@@ -1000,9 +1071,8 @@ static bool epdl_populate_pages_from_extent_data(
         for (i = 0; i < count; ++i) {
             size_t page_length = header->descr[i].page_length;
             if (page_length > RRDENG_BLOCK_SIZE &&
-                (header->descr[i].type != RRDENG_PAGE_TYPE_GORILLA_32BIT ||
-                 (header->descr[i].type == RRDENG_PAGE_TYPE_GORILLA_32BIT &&
-                  (page_length - RRDENG_BLOCK_SIZE) % RRDENG_GORILLA_32BIT_BUFFER_SIZE))) {
+                (page_length > RRDENG_BLOCK_SIZE + gorilla_page_max_extra_buffers(header->descr[i].type) * RRDENG_GORILLA_32BIT_BUFFER_SIZE ||
+                 (page_length - RRDENG_BLOCK_SIZE) % RRDENG_GORILLA_32BIT_BUFFER_SIZE)) {
                 have_read_error = true;
                 break;
             }
@@ -1017,7 +1087,7 @@ static bool epdl_populate_pages_from_extent_data(
             eb = extent_buffer_get(uncompressed_payload_length);
             uncompressed_buf = eb->data;
 
-            size_t bytes = dbengine_decompress(uncompressed_buf, data + payload_offset,
+            size_t bytes = dbengine_decompress(ctx, uncompressed_buf, data + payload_offset,
                                                uncompressed_payload_length, payload_length,
                                                header->compression_algorithm);
 
@@ -1177,32 +1247,205 @@ static bool epdl_populate_pages_from_extent_data(
     return true;
 }
 
-static inline void *datafile_extent_read(struct rrdengine_instance *ctx, uv_file file, unsigned pos, unsigned size_bytes)
+static inline void *datafile_extent_read_local(struct rrdengine_instance *ctx, uv_file file, unsigned pos, unsigned size_bytes)
 {
     void *buffer = NULL;
     uv_fs_t request;
 
     unsigned real_io_size = ALIGN_BYTES_CEILING(size_bytes);
+
+    bool io_error = false;
+    void *uring_buffer = dbengine_uring_read(file, pos, real_io_size, &io_error);
+    if(uring_buffer) {
+        ctx_io_read_op_bytes(ctx, real_io_size);
+        buffer = dbengine_extent_alloc(size_bytes);
+        memcpy(buffer, uring_buffer, size_bytes);
+        return buffer;
+    }
+    else if(unlikely(io_error)) {
+        ctx_io_error(ctx);
+        return NULL;
+    }
+
     int ret = posix_memalign(&buffer, RRDFILE_ALIGNMENT, real_io_size);
     if (unlikely(ret))
         fatal("DBENGINE: posix_memalign(): %s", strerror(ret));
 
     uv_buf_t iov = uv_buf_init(buffer, real_io_size);
     ret = uv_fs_read(NULL, &request, file, &iov, 1, pos, NULL);
+    uv_fs_req_cleanup(&request);
+
     if (unlikely(-1 == ret)) {
         ctx_io_error(ctx);
         posix_memfree(buffer);
-        buffer = NULL;
+        return NULL;
     }
-    else
+
+    ctx_io_read_op_bytes(ctx, real_io_size);
+
+    void *extent_data = dbengine_extent_alloc(size_bytes);
+    memcpy(extent_data, buffer, size_bytes);
+    posix_memfree(buffer);
+
+    return extent_data;
+}
+
+static void *datafile_extents_span_read_local(struct rrdengine_instance *ctx, uv_file file, uint64_t pos, size_t real_io_size)
+{
+    void *buffer = NULL;
+    uv_fs_t request;
+
+    int ret = posix_memalign(&buffer, RRDFILE_ALIGNMENT, real_io_size);
+    if (unlikely(ret))
+        fatal("DBENGINE: posix_memalign(): %s", strerror(ret));
+
+    bool io_error = false;
+    void *uring_buffer = dbengine_uring_read(file, pos, real_io_size, &io_error);
+    if(uring_buffer) {
         ctx_io_read_op_bytes(ctx, real_io_size);
+        memcpy(buffer, uring_buffer, real_io_size);
+        return buffer;
+    }
+    else if(unlikely(io_error)) {
+        ctx_io_error(ctx);
+        posix_memfree(buffer);
+        return NULL;
+    }
 
+    uv_buf_t iov = uv_buf_init(buffer, real_io_size);
+    ret = uv_fs_read(NULL, &request, file, &iov, 1, (int64_t)pos, NULL);
     uv_fs_req_cleanup(&request);
 
+    if (unlikely(-1 == ret)) {
+        ctx_io_error(ctx);
+        posix_memfree(buffer);
+        return NULL;
+    }
+
+    ctx_io_read_op_bytes(ctx, real_io_size);
     return buffer;
 }
 
-static inline void datafile_extent_read_free(void *buffer) {
+// archived datafiles are read from the object storage - a datafile becomes archived
+// under the write lock of its extent_rwlock, so local reads hold its read lock
+static inline bool datafile_is_archived_or_lock(struct rrdengine_datafile *datafile) {
+    if(unlikely(__atomic_load_n(&datafile->archived, __ATOMIC_ACQUIRE)))
+        return true;
+
+    uv_rwlock_rdlock(&datafile->extent_rwlock);
+    if(unlikely(datafile->archived)) {
+        uv_rwlock_rdunlock(&datafile->extent_rwlock);
+        return true;
+    }
+
+    return false;
+}
+
+static void *datafile_extent_read(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile, uv_file file, unsigned pos, unsigned size_bytes)
+{
+    if(!datafile_is_archived_or_lock(datafile)) {
+        void *extent_data = datafile_extent_read_local(ctx, file, pos, size_bytes);
+        uv_rwlock_rdunlock(&datafile->extent_rwlock);
+        return extent_data;
+    }
+
+    void *extent_data = dbengine_extent_alloc(size_bytes);
+    if(unlikely(!dbengine_archive_read(ctx, datafile, extent_data, pos, size_bytes))) {
+        ctx_io_error(ctx);
+        dbengine_extent_free(extent_data, size_bytes);
+        return NULL;
+    }
+
+    return extent_data;
+}
+
+static void *datafile_extents_span_read(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile, uv_file file, uint64_t pos, size_t real_io_size)
+{
+    if(!datafile_is_archived_or_lock(datafile)) {
+        void *buffer = datafile_extents_span_read_local(ctx, file, pos, real_io_size);
+        uv_rwlock_rdunlock(&datafile->extent_rwlock);
+        return buffer;
+    }
+
+    // the object has no padding after its last extent
+    real_io_size = MIN(real_io_size, datafile->pos - pos);
+
+    void *buffer = NULL;
+    int ret = posix_memalign(&buffer, RRDFILE_ALIGNMENT, ALIGN_BYTES_CEILING(real_io_size));
+    if (unlikely(ret))
+        fatal("DBENGINE: posix_memalign(): %s", strerror(ret));
+
+    if(unlikely(!dbengine_archive_read(ctx, datafile, buffer, pos, real_io_size))) {
+        ctx_io_error(ctx);
+        posix_memfree(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+// reads with one I/O the extents of a coalesced read that are not in the extent cache,
+// leaving each of them acquired in the extent cache, for the worker that will process it
+static void epdl_coalesced_extents_read(struct rrdengine_instance *ctx, EPDL *epdl) {
+    EPDL *first = NULL, *last = NULL;
+    size_t missing = 0;
+
+    for(EPDL *ep = epdl; ep ; ep = ep->coalesced.next) {
+        ep->coalesced.extent_cache_page = pgc_page_get_and_acquire(
+                extent_cache, (Word_t)ctx,
+                (Word_t)ep->datafile->fileno, (time_t)ep->extent_offset,
+                PGC_SEARCH_EXACT);
+
+        if(!ep->coalesced.extent_cache_page) {
+            if(!first)
+                first = ep;
+
+            last = ep;
+            missing++;
+        }
+    }
+
+    // a single extent is read by its worker, as usual
+    if(missing < 2)
+        return;
+
+    uint64_t pos = first->extent_offset;
+    size_t real_io_size = last->extent_offset + ALIGN_BYTES_CEILING(last->extent_size) - pos;
+
+    void *buffer = datafile_extents_span_read(ctx, first->datafile, first->file, pos, real_io_size);
+    if(!buffer)
+        // each worker will try on its own
+        return;
+
+    __atomic_add_fetch(&rrdeng_cache_efficiency_stats.extent_reads_coalesced, missing - 1, __ATOMIC_RELAXED);
+
+    for(EPDL *ep = first; ep ; ep = ep->coalesced.next) {
+        if(!ep->coalesced.extent_cache_page) {
+            void *extent_data = dbengine_extent_alloc(ep->extent_size);
+            memcpy(extent_data, buffer + (ep->extent_offset - pos), ep->extent_size);
+
+            bool added = false;
+            ep->coalesced.extent_cache_page = pgc_page_add_and_acquire(extent_cache, (PGC_ENTRY) {
+                    .hot = false,
+                    .section = (Word_t) ctx,
+                    .metric_id = (Word_t) ep->datafile->fileno,
+                    .start_time_s = (time_t) ep->extent_offset,
+                    .size = ep->extent_size,
+                    .end_time_s = 0,
+                    .update_every_s = 0,
+                    .data = extent_data,
+            }, &added);
+
+            if (!added)
+                dbengine_extent_free(extent_data, ep->extent_size);
+
+            ep->coalesced.extent_read_from_disk = true;
+        }
+
+        if(ep == last)
+            break;
+    }
+
     posix_memfree(buffer);
 }
 
@@ -1213,20 +1456,47 @@ void epdl_find_extent_and_populate_pages(struct rrdengine_instance *ctx, EPDL *e
     size_t *statistics_counter = NULL;
     PDC_PAGE_STATUS not_loaded_pages_tag = 0, loaded_pages_tag = 0;
 
-    bool should_stop = __atomic_load_n(&epdl->pdc->workers_should_stop, __ATOMIC_RELAXED);
+    bool should_stop = pdc_workers_should_stop(epdl->pdc);
     for(EPDL *ep = epdl->query.next; ep ;ep = ep->query.next) {
         internal_fatal(ep->datafile != epdl->datafile, "DBENGINE: datafiles do not match");
         internal_fatal(ep->extent_offset != epdl->extent_offset, "DBENGINE: extent offsets do not match");
         internal_fatal(ep->extent_size != epdl->extent_size, "DBENGINE: extent sizes do not match");
         internal_fatal(ep->file != epdl->file, "DBENGINE: files do not match");
 
-        if(!__atomic_load_n(&ep->pdc->workers_should_stop, __ATOMIC_RELAXED)) {
+        if(!pdc_workers_should_stop(ep->pdc)) {
             should_stop = false;
             break;
         }
     }
 
+    EPDL *coalesced = epdl->coalesced.next;
+    if(coalesced) {
+        if(!should_stop) {
+            if(worker)
+                worker_is_busy(UV_EVENT_DBENGINE_EXTENT_MMAP);
+
+            epdl_coalesced_extents_read(ctx, epdl);
+        }
+
+        // the rest of the extents are decompressed and processed in parallel, by other workers
+        epdl->coalesced.next = NULL;
+        for(EPDL *ep = coalesced, *next = NULL; ep ; ep = next) {
+            next = ep->coalesced.next;
+            ep->coalesced.next = NULL;
+            epdl->coalesced.exec(ctx, ep, ep->pdc->priority);
+        }
+
+        if(worker)
+            worker_is_busy(UV_EVENT_DBENGINE_EXTENT_CACHE_LOOKUP);
+    }
+
+    PGC_PAGE *extent_cache_page = epdl->coalesced.extent_cache_page;
+    epdl->coalesced.extent_cache_page = NULL;
+
     if(unlikely(should_stop)) {
+        if(extent_cache_page)
+            pgc_page_release(extent_cache, extent_cache_page);
+
         statistics_counter = &rrdeng_cache_efficiency_stats.pages_load_fail_cancelled;
         not_loaded_pages_tag = PDC_PAGE_CANCELLED;
         goto cleanup;
@@ -1235,30 +1505,33 @@ void epdl_find_extent_and_populate_pages(struct rrdengine_instance *ctx, EPDL *e
     bool extent_found_in_cache = false;
 
     void *extent_compressed_data = NULL;
-    PGC_PAGE *extent_cache_page = pgc_page_get_and_acquire(
-            extent_cache, (Word_t)ctx,
-            (Word_t)epdl->datafile->fileno, (time_t)epdl->extent_offset,
-            PGC_SEARCH_EXACT);
+    if(!extent_cache_page)
+        extent_cache_page = pgc_page_get_and_acquire(
+                extent_cache, (Word_t)ctx,
+                (Word_t)epdl->datafile->fileno, (time_t)epdl->extent_offset,
+                PGC_SEARCH_EXACT);
 
     if(extent_cache_page) {
         extent_compressed_data = pgc_page_data(extent_cache_page);
         internal_fatal(epdl->extent_size != pgc_page_data_size(extent_cache, extent_cache_page),
                        "DBENGINE: cache size does not match the expected size");
 
-        loaded_pages_tag |= PDC_PAGE_EXTENT_FROM_CACHE;
-        not_loaded_pages_tag |= PDC_PAGE_EXTENT_FROM_CACHE;
-        extent_found_in_cache = true;
+        if(epdl->coalesced.extent_read_from_disk) {
+            loaded_pages_tag |= PDC_PAGE_EXTENT_FROM_DISK;
+            not_loaded_pages_tag |= PDC_PAGE_EXTENT_FROM_DISK;
+        }
+        else {
+            loaded_pages_tag |= PDC_PAGE_EXTENT_FROM_CACHE;
+            not_loaded_pages_tag |= PDC_PAGE_EXTENT_FROM_CACHE;
+            extent_found_in_cache = true;
+        }
     }
     else {
         if(worker)
             worker_is_busy(UV_EVENT_DBENGINE_EXTENT_MMAP);
 
-        void *extent_data = datafile_extent_read(ctx, epdl->file, epdl->extent_offset, epdl->extent_size);
-        if(extent_data != NULL) {
-
-            void *copied_extent_compressed_data = dbengine_extent_alloc(epdl->extent_size);
-            memcpy(copied_extent_compressed_data, extent_data, epdl->extent_size);
-            datafile_extent_read_free(extent_data);
+        void *copied_extent_compressed_data = datafile_extent_read(ctx, epdl->datafile, epdl->file, epdl->extent_offset, epdl->extent_size);
+        if(copied_extent_compressed_data != NULL) {
 
             if(worker)
                 worker_is_busy(UV_EVENT_DBENGINE_EXTENT_CACHE_LOOKUP);
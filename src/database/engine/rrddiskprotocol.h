@@ -15,15 +15,18 @@
 #define RRDENG_VER_SZ (16)
 #define RRDENG_DF_VER "1.0"
 #define RRDENG_JF_VER "1.0"
+#define RRDENG_DF_VER_CRC32C "1.1"     /* same layout, extents checksummed with CRC32C */
+#define RRDENG_JF_VER_CRC32C "1.1"     /* same layout, transactions checksummed with CRC32C */
 
 #define UUID_SZ (16)
-#define CHECKSUM_SZ (4) /* CRC32 */
+#define CHECKSUM_SZ (4) /* CRC32 or CRC32C */
 
 #define RRDENG_COMPRESSION_NONE (0)
 #define RRDENG_COMPRESSION_LZ4  (1)
 #define RRDENG_COMPRESSION_ZSTD (2)
+#define RRDENG_COMPRESSION_ZSTD_DICT (3) // ZSTD with a dictionary of the tier, identified by the frame dictionary id
 
-#define RRDENG_DF_SB_PADDING_SZ (RRDENG_BLOCK_SIZE - (RRDENG_MAGIC_SZ + RRDENG_VER_SZ + sizeof(uint8_t)))
+#define RRDENG_DF_SB_PADDING_SZ (RRDENG_BLOCK_SIZE - (RRDENG_MAGIC_SZ + RRDENG_VER_SZ + 3 * sizeof(uint8_t) + sizeof(uint64_t)))
 
 /*
  * Data file persistent super-block
@@ -33,6 +36,9 @@ struct rrdeng_df_sb {
     char magic_number[RRDENG_MAGIC_SZ];
     char version[RRDENG_VER_SZ];
     uint8_t tier;
+    uint8_t compacted;      /* non-zero when the datafile has been rewritten by compaction - used to be padding */
+    uint8_t archived;       /* non-zero when the extents are in the object storage and the file is just this superblock */
+    uint64_t archived_size; /* the size of the datafile before it was archived */
     uint8_t padding[RRDENG_DF_SB_PADDING_SZ];
 } __attribute__ ((packed));
 
@@ -43,7 +49,51 @@ struct rrdeng_df_sb {
 #define RRDENG_PAGE_TYPE_ARRAY_32BIT    (0)
 #define RRDENG_PAGE_TYPE_ARRAY_TIER1    (1)
 #define RRDENG_PAGE_TYPE_GORILLA_32BIT  (2)
-#define RRDENG_PAGE_TYPE_MAX            (2) // Maximum page type (inclusive)
+#define RRDENG_PAGE_TYPE_GORILLA_TIER1  (3)
+#define RRDENG_PAGE_TYPE_GORILLA_64BIT  (4)
+#define RRDENG_PAGE_TYPE_MAX            (4) // Maximum page type (inclusive)
+
+/*
+ * RRDENG_PAGE_TYPE_GORILLA_TIER1 page layout
+ *
+ * The page starts with a rrdeng_page_columns_header, followed by:
+ *  - 3 gorilla buffers (sum, min, max - the bits of the floats), of sum_size, min_size and max_size bytes
+ *  - runs x rrdeng_page_columns_run, the run-length encoded count and anomaly_count of the points
+ *
+ * When RRDENG_PAGE_COLUMNS_RAW is set, the header is followed by an array
+ * of entries x storage_number_tier1_t instead (the data did not compress).
+ */
+#define RRDENG_PAGE_COLUMNS_RAW         (1 << 0)
+
+struct rrdeng_page_columns_header {
+    uint32_t entries;
+    uint16_t options;
+    uint16_t runs;
+    uint32_t sum_size;
+    uint32_t min_size;
+    uint32_t max_size;
+    uint32_t reserved;
+} __attribute__ ((packed));
+
+struct rrdeng_page_columns_run {
+    uint16_t length;
+    uint16_t count;
+    uint16_t anomaly_count;
+} __attribute__ ((packed));
+
+/*
+ * RRDENG_PAGE_TYPE_GORILLA_64BIT page layout
+ *
+ * Like RRDENG_PAGE_TYPE_GORILLA_32BIT pages, a list of gorilla buffers of
+ * RRDENG_GORILLA_32BIT_BUFFER_SIZE bytes each, encoding 64-bit words instead.
+ *
+ * Each word has the bits of the collected value as a double, with the 2 least
+ * significant bits of the mantissa replaced by the flags below. Empty points
+ * are NaN, without any flags.
+ */
+#define RRDENG_GORILLA_64BIT_FLAG_ANOMALOUS (1 << 0)
+#define RRDENG_GORILLA_64BIT_FLAG_RESET     (1 << 1)
+#define RRDENG_GORILLA_64BIT_FLAGS          (RRDENG_GORILLA_64BIT_FLAG_ANOMALOUS | RRDENG_GORILLA_64BIT_FLAG_RESET)
 
 /*
  * Data file page descriptor
@@ -55,6 +105,7 @@ struct rrdeng_extent_page_descr {
     uint32_t page_length;
     uint64_t start_time_ut;
     union {
+        // used by RRDENG_PAGE_TYPE_GORILLA_32BIT, RRDENG_PAGE_TYPE_GORILLA_TIER1 and RRDENG_PAGE_TYPE_GORILLA_64BIT
         struct {
             uint32_t entries;
             uint32_t delta_time_s;
@@ -4,6 +4,8 @@
 #include "rrdengine.h"
 #include "pdc.h"
 #include "dbengine-compression.h"
+#include "dbengine-compaction.h"
+#include "dbengine-archive.h"
 
 rrdeng_stats_t global_io_errors = 0;
 rrdeng_stats_t global_fs_errors = 0;
@@ -108,6 +110,8 @@ static void sanity_check(void)
     /* Version strings must fit in the super-blocks */
     BUILD_BUG_ON(strlen(RRDENG_DF_VER) > RRDENG_VER_SZ);
     BUILD_BUG_ON(strlen(RRDENG_JF_VER) > RRDENG_VER_SZ);
+    BUILD_BUG_ON(strlen(RRDENG_DF_VER_CRC32C) > RRDENG_VER_SZ);
+    BUILD_BUG_ON(strlen(RRDENG_JF_VER_CRC32C) > RRDENG_VER_SZ);
 
     /* Data file super-block cannot be larger than RRDENG_BLOCK_SIZE */
     BUILD_BUG_ON(RRDENG_DF_SB_PADDING_SZ < 0);
@@ -615,8 +619,7 @@ static void journalfile_extent_build(struct rrdengine_instance *ctx, struct exte
     memcpy(jf_metric_data->descr, df_header->descr, descr_size);
 
     jf_trailer = buf + sizeof(*jf_header) + payload_length;
-    crc = crc32(0L, Z_NULL, 0);
-    crc = crc32(crc, buf, sizeof(*jf_header) + payload_length);
+    crc = rrdeng_checksum(xt_io_descr->datafile->journalfile->checksum, buf, sizeof(*jf_header) + payload_length);
     crc32set(jf_trailer->checksum, crc);
 }
 
@@ -773,7 +776,7 @@ static struct extent_io_descriptor *datafile_extent_build(struct rrdengine_insta
     struct page_descr_with_data *descr, *eligible_pages[MAX_PAGES_PER_EXTENT];
     struct extent_io_descriptor *xt_io_descr;
     Word_t Index;
-    uint8_t compression_algorithm = ctx->config.global_compress_alg;
+    uint8_t compression_algorithm = dbengine_compression_algorithm(ctx);
     struct rrdengine_datafile *datafile;
     /* persistent structures */
     struct rrdeng_df_extent_header *header;
@@ -829,6 +832,8 @@ static struct extent_io_descriptor *datafile_extent_build(struct rrdengine_insta
                 header->descr[i].end_time_ut = descr->end_time_ut;
                 break;
             case RRDENG_PAGE_TYPE_GORILLA_32BIT:
+            case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+            case RRDENG_PAGE_TYPE_GORILLA_64BIT:
                 header->descr[i].gorilla.delta_time_s = (uint32_t) ((descr->end_time_ut - descr->start_time_ut) / USEC_PER_SEC);
                 header->descr[i].gorilla.entries = pgd_slots_used(descr->pgd);
                 break;
@@ -848,7 +853,7 @@ static struct extent_io_descriptor *datafile_extent_build(struct rrdengine_insta
 
     // compress the payload
     size_t compressed_size =
-        (int)dbengine_compress(xt_io_descr->buf + payload_offset,
+        (int)dbengine_compress(ctx, xt_io_descr->buf + payload_offset,
                                uncompressed_payload_length,
                                compression_algorithm);
 
@@ -888,8 +893,7 @@ static struct extent_io_descriptor *datafile_extent_build(struct rrdengine_insta
     xt_io_descr->completion = completion;
 
     trailer = xt_io_descr->buf + size_bytes - sizeof(*trailer);
-    crc = crc32(0L, Z_NULL, 0);
-    crc = crc32(crc, xt_io_descr->buf, size_bytes - sizeof(*trailer));
+    crc = rrdeng_checksum(datafile->checksum, xt_io_descr->buf, size_bytes - sizeof(*trailer));
     crc32set(trailer->checksum, crc);
 
     xt_io_descr->iov = uv_buf_init((void *)xt_io_descr->buf, real_io_size);
@@ -1260,7 +1264,7 @@ void datafile_delete(struct rrdengine_instance *ctx, struct rrdengine_datafile *
     uv_rwlock_wrunlock(&ctx->datafiles.rwlock);
 
     journal_file = datafile->journalfile;
-    datafile_bytes = datafile->pos;
+    datafile_bytes = datafile_local_size(datafile);
     journal_file_bytes = journalfile_current_size(journal_file);
     deleted_bytes = journalfile_v2_data_size_get(journal_file);
 
@@ -1279,6 +1283,7 @@ void datafile_delete(struct rrdengine_instance *ctx, struct rrdengine_datafile *
         netdata_log_info("DBENGINE: deleted data file \"%s\".", path);
         deleted_bytes += datafile_bytes;
     }
+    dbengine_archive_datafile_deleted(ctx, datafile);
     freez(journal_file);
     freez(datafile);
 
@@ -1286,10 +1291,46 @@ void datafile_delete(struct rrdengine_instance *ctx, struct rrdengine_datafile *
     netdata_log_info("DBENGINE: reclaimed %u bytes of disk space.", deleted_bytes);
 }
 
+// the oldest datafile that is still on the local disk
+static struct rrdengine_datafile *datafile_oldest_local(struct rrdengine_instance *ctx) {
+    uv_rwlock_rdlock(&ctx->datafiles.rwlock);
+    struct rrdengine_datafile *datafile = ctx->datafiles.first;
+    while(datafile && datafile->archived)
+        datafile = datafile->next;
+    uv_rwlock_rdunlock(&ctx->datafiles.rwlock);
+
+    return datafile;
+}
+
+// rotates one datafile out of the tier: without an archive the oldest datafile is deleted,
+// with an archive the expired archived datafiles are deleted first, and then the oldest
+// local datafile is archived - returns false when nothing could be rotated
+bool datafile_rotate(struct rrdengine_instance *ctx, bool update_retention, bool worker) {
+    struct rrdengine_datafile *datafile = ctx->datafiles.first;
+    if(!datafile)
+        return false;
+
+    if(!ctx->archive || dbengine_archive_datafile_expired(ctx, datafile)) {
+        datafile_delete(ctx, datafile, update_retention, worker);
+        return true;
+    }
+
+    datafile = datafile_oldest_local(ctx);
+    if(!datafile || !datafile->next)
+        return false;
+
+    if(worker)
+        worker_is_busy(UV_EVENT_DBENGINE_DATAFILE_ARCHIVE);
+
+    // the data remains queryable, the retention of the metrics does not change
+    return dbengine_archive_datafile(ctx, datafile);
+}
+
 static void *database_rotate_tp_worker(struct rrdengine_instance *ctx __maybe_unused, void *data __maybe_unused, struct completion *completion __maybe_unused, uv_work_t *uv_work_req __maybe_unused) {
-    datafile_delete(ctx, ctx->datafiles.first, ctx_is_available_for_queries(ctx), true);
+    bool rotated = datafile_rotate(ctx, ctx_is_available_for_queries(ctx), true);
 
-    if (rrdeng_ctx_tier_cap_exceeded(ctx))
+    // when archiving fails, we retry with the next retention check
+    if (rotated && rrdeng_ctx_tier_cap_exceeded(ctx))
         rrdeng_enq_cmd(ctx, RRDENG_OPCODE_DATABASE_ROTATE, NULL, NULL, STORAGE_PRIORITY_INTERNAL_DBENGINE, NULL, NULL);
 
     rrdcontext_db_rotation();
@@ -1297,6 +1338,20 @@ static void *database_rotate_tp_worker(struct rrdengine_instance *ctx __maybe_un
     return data;
 }
 
+static void after_database_compact(struct rrdengine_instance *ctx __maybe_unused, void *data __maybe_unused, struct completion *completion __maybe_unused, uv_work_t* req __maybe_unused, int status __maybe_unused) {
+    __atomic_store_n(&ctx->atomic.now_compacting_files, false, __ATOMIC_RELAXED);
+
+    // rotation may have been postponed while we were compacting
+    rrdeng_enq_cmd(ctx, RRDENG_OPCODE_DATABASE_ROTATE, NULL, NULL, STORAGE_PRIORITY_INTERNAL_DBENGINE, NULL, NULL);
+}
+
+static void *database_compact_tp_worker(struct rrdengine_instance *ctx __maybe_unused, void *data __maybe_unused, struct completion *completion __maybe_unused, uv_work_t *uv_work_req __maybe_unused) {
+    worker_is_busy(UV_EVENT_DBENGINE_COMPACTION);
+    datafiles_compact(ctx);
+    worker_is_idle();
+    return data;
+}
+
 static void after_flush_all_hot_and_dirty_pages_of_section(struct rrdengine_instance *ctx __maybe_unused, void *data __maybe_unused, struct completion *completion __maybe_unused, uv_work_t* req __maybe_unused, int status __maybe_unused) {
     ;
 }
@@ -1341,6 +1396,8 @@ static void *populate_mrg_tp_worker(struct rrdengine_instance *ctx __maybe_unuse
         datafile->populate_mrg.populated = true;
         spinlock_unlock(&datafile->populate_mrg.spinlock);
 
+        query_progress_done_step(&ctx->loading.populate_mrg.transaction, 1);
+
     } while(1);
 
     completion_mark_complete(completion);
@@ -1357,7 +1414,8 @@ static void *ctx_shutdown_tp_worker(struct rrdengine_instance *ctx __maybe_unuse
 
     bool logged = false;
     while(__atomic_load_n(&ctx->atomic.extents_currently_being_flushed, __ATOMIC_RELAXED) ||
-            __atomic_load_n(&ctx->atomic.inflight_queries, __ATOMIC_RELAXED)) {
+            __atomic_load_n(&ctx->atomic.inflight_queries, __ATOMIC_RELAXED) ||
+            __atomic_load_n(&ctx->atomic.now_compacting_files, __ATOMIC_RELAXED)) {
         if(!logged) {
             logged = true;
             netdata_log_info("DBENGINE: waiting for %zu inflight queries to finish to shutdown tier %d...",
@@ -1411,6 +1469,10 @@ time_t get_datafile_end_time(struct rrdengine_instance *ctx)
     uv_rwlock_rdlock(&ctx->datafiles.rwlock);
     struct rrdengine_datafile *datafile = ctx->datafiles.first;
 
+    // the retention of the local disk, archived datafiles have their own
+    while (datafile && datafile->archived)
+        datafile = datafile->next;
+
     if (datafile) {
         last_time_s = datafile->journalfile->v2.last_time_s;
         if (!last_time_s)
@@ -1626,8 +1688,12 @@ bool rrdeng_ctx_tier_cap_exceeded(struct rrdengine_instance *ctx)
         // no datafiles available
         return false;
 
-    if(!ctx->datafiles.first->next)
-        // only 1 datafile available
+    if(ctx->archive && dbengine_archive_datafile_expired(ctx, ctx->datafiles.first))
+        return true;
+
+    struct rrdengine_datafile *datafile = ctx->archive ? datafile_oldest_local(ctx) : ctx->datafiles.first;
+    if(!datafile || !datafile->next)
+        // only 1 (local) datafile available
         return false;
 
     uint64_t estimated_disk_space = get_used_disk_space(ctx);
@@ -1658,6 +1724,8 @@ void retention_timer_cb(uv_timer_t *handle)
         bool cleanup = rrdeng_ctx_tier_cap_exceeded(multidb_ctx[tier]);
         if (cleanup)
             rrdeng_enq_cmd(multidb_ctx[tier], RRDENG_OPCODE_DATABASE_ROTATE, NULL, NULL, STORAGE_PRIORITY_INTERNAL_DBENGINE, NULL, NULL);
+        else if (dbengine_use_compaction)
+            rrdeng_enq_cmd(multidb_ctx[tier], RRDENG_OPCODE_DATABASE_COMPACT, NULL, NULL, STORAGE_PRIORITY_BEST_EFFORT, NULL, NULL);
     }
 
     worker_is_idle();
@@ -1672,6 +1740,17 @@ void timer_cb(uv_timer_t* handle) {
     worker_set_metric(RRDENG_WORKS_DISPATCHED, (NETDATA_DOUBLE)__atomic_load_n(&rrdeng_main.work_cmd.atomics.dispatched, __ATOMIC_RELAXED));
     worker_set_metric(RRDENG_WORKS_EXECUTING, (NETDATA_DOUBLE)__atomic_load_n(&rrdeng_main.work_cmd.atomics.executing, __ATOMIC_RELAXED));
 
+    main_cache_memory_pressure_control();
+
+    NETDATA_DOUBLE pressure;
+    size_t clean_size, shrinks, grows;
+    if(main_cache_memory_pressure_statistics(&pressure, &clean_size, &shrinks, &grows)) {
+        worker_set_metric(RRDENG_MEMORY_PRESSURE, pressure);
+        worker_set_metric(RRDENG_MAIN_CACHE_CLEAN_SIZE, (NETDATA_DOUBLE)clean_size / 1024.0 / 1024.0);
+        worker_set_metric(RRDENG_MAIN_CACHE_SHRINKS, (NETDATA_DOUBLE)shrinks);
+        worker_set_metric(RRDENG_MAIN_CACHE_GROWS, (NETDATA_DOUBLE)grows);
+    }
+
     rrdeng_enq_cmd(NULL, RRDENG_OPCODE_FLUSH_INIT, NULL, NULL, STORAGE_PRIORITY_INTERNAL_DBENGINE, NULL, NULL);
     rrdeng_enq_cmd(NULL, RRDENG_OPCODE_EVICT_INIT, NULL, NULL, STORAGE_PRIORITY_INTERNAL_DBENGINE, NULL, NULL);
     rrdeng_enq_cmd(NULL, RRDENG_OPCODE_CLEANUP, NULL, NULL, STORAGE_PRIORITY_INTERNAL_DBENGINE, NULL, NULL);
@@ -1771,9 +1850,27 @@ static inline void worker_dispatch_query_prep(struct rrdeng_cmd cmd, bool from_w
 uint64_t get_directory_free_bytes_space(struct rrdengine_instance *ctx)
 {
     uint64_t free_bytes = 0;
-    struct statvfs buff_statvfs;
-    if (statvfs(ctx->config.dbfiles_path, &buff_statvfs) == 0)
-        free_bytes = buff_statvfs.f_bavail * buff_statvfs.f_bsize;
+    unsigned long fsids[RRDENG_MAX_STRIPES + 1];
+    size_t fsids_used = 0;
+
+    // the stripes of the tier may be on different filesystems
+    for (size_t stripe = 0; stripe <= ctx->config.stripes.count; stripe++) {
+        const char *path = stripe ? ctx->config.stripes.paths[stripe - 1] : ctx->config.dbfiles_path;
+
+        struct statvfs buff_statvfs;
+        if (statvfs(path, &buff_statvfs) != 0)
+            continue;
+
+        bool counted = false;
+        for (size_t i = 0; i < fsids_used && !counted; i++)
+            counted = (fsids[i] == buff_statvfs.f_fsid);
+
+        if (counted)
+            continue;
+
+        fsids[fsids_used++] = buff_statvfs.f_fsid;
+        free_bytes += buff_statvfs.f_bavail * buff_statvfs.f_bsize;
+    }
 
     return (free_bytes - (free_bytes * 5 / 100));
 }
@@ -1899,6 +1996,7 @@ void dbengine_event_loop(void* arg) {
     worker_register_job_name(RRDENG_OPCODE_EXTENT_READ,                              "extent read");
     worker_register_job_name(RRDENG_OPCODE_FLUSHED_TO_OPEN,                          "flushed to open");
     worker_register_job_name(RRDENG_OPCODE_DATABASE_ROTATE,                          "db rotate");
+    worker_register_job_name(RRDENG_OPCODE_DATABASE_COMPACT,                         "db compact");
     worker_register_job_name(RRDENG_OPCODE_JOURNAL_INDEX,                            "journal index");
     worker_register_job_name(RRDENG_OPCODE_FLUSH_INIT,                               "flush init");
     worker_register_job_name(RRDENG_OPCODE_EVICT_INIT,                               "evict init");
@@ -1913,6 +2011,7 @@ void dbengine_event_loop(void* arg) {
     worker_register_job_name(RRDENG_OPCODE_MAX + RRDENG_OPCODE_EXTENT_READ,          "extent read cb");
     worker_register_job_name(RRDENG_OPCODE_MAX + RRDENG_OPCODE_FLUSHED_TO_OPEN,      "flushed to open cb");
     worker_register_job_name(RRDENG_OPCODE_MAX + RRDENG_OPCODE_DATABASE_ROTATE,      "db rotate cb");
+    worker_register_job_name(RRDENG_OPCODE_MAX + RRDENG_OPCODE_DATABASE_COMPACT,     "db compact cb");
     worker_register_job_name(RRDENG_OPCODE_MAX + RRDENG_OPCODE_JOURNAL_INDEX,        "journal index cb");
     worker_register_job_name(RRDENG_OPCODE_MAX + RRDENG_OPCODE_FLUSH_INIT,           "flush init cb");
     worker_register_job_name(RRDENG_OPCODE_MAX + RRDENG_OPCODE_EVICT_INIT,           "evict init cb");
@@ -1927,6 +2026,15 @@ void dbengine_event_loop(void* arg) {
     worker_register_job_custom_metric(RRDENG_WORKS_DISPATCHED, "works dispatched", "works",   WORKER_METRIC_ABSOLUTE);
     worker_register_job_custom_metric(RRDENG_WORKS_EXECUTING,  "works executing",  "works",   WORKER_METRIC_ABSOLUTE);
 
+    NETDATA_DOUBLE pressure;
+    size_t clean_size, shrinks, grows;
+    if(main_cache_memory_pressure_statistics(&pressure, &clean_size, &shrinks, &grows)) {
+        worker_register_job_custom_metric(RRDENG_MEMORY_PRESSURE,       "memory pressure",        "%",         WORKER_METRIC_ABSOLUTE);
+        worker_register_job_custom_metric(RRDENG_MAIN_CACHE_CLEAN_SIZE, "main cache clean size",  "MiB",       WORKER_METRIC_ABSOLUTE);
+        worker_register_job_custom_metric(RRDENG_MAIN_CACHE_SHRINKS,    "main cache shrinks",     "shrinks/s", WORKER_METRIC_INCREMENTAL_TOTAL);
+        worker_register_job_custom_metric(RRDENG_MAIN_CACHE_GROWS,      "main cache grows",       "grows/s",   WORKER_METRIC_INCREMENTAL_TOTAL);
+    }
+
     struct rrdeng_main *main = arg;
     enum rrdeng_opcode opcode;
     struct rrdeng_cmd cmd;
@@ -2012,6 +2120,8 @@ void dbengine_event_loop(void* arg) {
                 case RRDENG_OPCODE_DATABASE_ROTATE: {
                     struct rrdengine_instance *ctx = cmd.ctx;
                     if (!__atomic_load_n(&ctx->atomic.now_deleting_files, __ATOMIC_RELAXED) &&
+                        !__atomic_load_n(&ctx->atomic.now_compacting_files, __ATOMIC_RELAXED) &&
+                        !__atomic_load_n(&ctx->loading.populate_mrg.size, __ATOMIC_ACQUIRE) &&
                          ctx->datafiles.first->next != NULL &&
                          ctx->datafiles.first->next->next != NULL &&
                         rrdeng_ctx_tier_cap_exceeded(ctx)) {
@@ -2022,6 +2132,20 @@ void dbengine_event_loop(void* arg) {
                     break;
                 }
 
+                case RRDENG_OPCODE_DATABASE_COMPACT: {
+                    struct rrdengine_instance *ctx = cmd.ctx;
+                    if (!__atomic_load_n(&ctx->atomic.now_deleting_files, __ATOMIC_RELAXED) &&
+                        !__atomic_load_n(&ctx->atomic.now_compacting_files, __ATOMIC_RELAXED) &&
+                        !__atomic_load_n(&ctx->loading.populate_mrg.size, __ATOMIC_ACQUIRE) &&
+                        ctx_is_available_for_queries(ctx) &&
+                        !rrdeng_ctx_tier_cap_exceeded(ctx)) {
+
+                        __atomic_store_n(&ctx->atomic.now_compacting_files, true, __ATOMIC_RELAXED);
+                        work_dispatch(ctx, NULL, NULL, opcode, database_compact_tp_worker, after_database_compact);
+                    }
+                    break;
+                }
+
                 case RRDENG_OPCODE_CTX_POPULATE_MRG: {
                     struct rrdengine_instance *ctx = cmd.ctx;
                     struct completion *completion = cmd.completion;
@@ -89,6 +89,7 @@ typedef struct page_details_control {
     Pvoid_t page_list_JudyL;        // the list of page details
     unsigned completed_jobs;        // the number of jobs completed last time the query thread checked
     bool workers_should_stop;       // true when the query thread left and the workers should stop
+    usec_t workers_deadline_ut;     // when set, the workers should stop after this time (prefetches)
     bool prep_done;
 
     PDC_PAGE_STATUS common_status;
@@ -107,6 +108,14 @@ typedef struct page_details_control {
 
 PDC *pdc_get(void);
 
+static inline bool pdc_workers_should_stop(PDC *pdc) {
+    if(__atomic_load_n(&pdc->workers_should_stop, __ATOMIC_RELAXED))
+        return true;
+
+    usec_t deadline_ut = __atomic_load_n(&pdc->workers_deadline_ut, __ATOMIC_RELAXED);
+    return deadline_ut && now_monotonic_usec() > deadline_ut;
+}
+
 struct page_details {
     struct {
         struct rrdengine_datafile *ptr;
@@ -193,6 +202,7 @@ struct rrdeng_collect_handle {
     RRDENG_COLLECT_PAGE_FLAGS page_flags;
     RRDENG_COLLECT_HANDLE_OPTIONS options;
     uint8_t type;
+    uint8_t page_type;                        // the type of the pages of the metric, usually the one of its tier
 
     struct rrdengine_instance *ctx;
     struct metric *metric;
@@ -253,6 +263,7 @@ enum rrdeng_opcode {
     RRDENG_OPCODE_CTX_POPULATE_MRG,
     RRDENG_OPCODE_SHUTDOWN_EVLOOP,
     RRDENG_OPCODE_CLEANUP,
+    RRDENG_OPCODE_DATABASE_COMPACT,
 
     RRDENG_OPCODE_MAX
 };
@@ -266,6 +277,10 @@ enum rrdeng_opcode {
 #define RRDENG_OPCODES_WAITING             (RRDENG_TIMER_CB + 2)
 #define RRDENG_WORKS_DISPATCHED            (RRDENG_TIMER_CB + 3)
 #define RRDENG_WORKS_EXECUTING             (RRDENG_TIMER_CB + 4)
+#define RRDENG_MEMORY_PRESSURE             (RRDENG_TIMER_CB + 5)
+#define RRDENG_MAIN_CACHE_CLEAN_SIZE       (RRDENG_TIMER_CB + 6)
+#define RRDENG_MAIN_CACHE_SHRINKS          (RRDENG_TIMER_CB + 7)
+#define RRDENG_MAIN_CACHE_GROWS            (RRDENG_TIMER_CB + 8)
 
 struct extent_io_data {
     unsigned fileno;
@@ -352,6 +367,9 @@ extern rrdeng_stats_t rrdeng_reserved_file_descriptors;
 extern rrdeng_stats_t global_pg_cache_over_half_dirty_events;
 extern rrdeng_stats_t global_flushing_pressure_page_deletions; /* number of deleted pages */
 
+// the max number of extra directories a tier can stripe its datafiles to
+#define RRDENG_MAX_STRIPES 8
+
 typedef struct tier_config_prototype {
     int tier;                                   // the tier of this ctx
     uint8_t page_type;                          // default page type for this context
@@ -361,6 +379,11 @@ typedef struct tier_config_prototype {
     uint8_t global_compress_alg;                // the wanted compression algorithm
     char dbfiles_path[FILENAME_MAX + 1];
 
+    struct {
+        uint8_t count;                          // extra directories the datafiles are striped to (0 = none)
+        char *paths[RRDENG_MAX_STRIPES];
+    } stripes;
+
     struct {
         uint32_t uses;
         bool enabled;
@@ -395,6 +418,7 @@ struct rrdengine_instance {
 
         bool migration_to_v2_running;
         bool now_deleting_files;
+        bool now_compacting_files;                  // rotation and compaction are mutually exclusive
         unsigned extents_currently_being_flushed;   // non-zero until we commit data to disk (both datafile and journal file)
 
         time_t first_time_s;
@@ -410,13 +434,19 @@ struct rrdengine_instance {
 
     struct {
         struct {
-            size_t size;
+            SPINLOCK spinlock;                      // serializes readiness waiters
+            size_t size;                            // the number of workers still populating, or 0 when ready
             struct completion *array;
+            nd_uuid_t transaction;                  // reported via /api/v2/progress
+            usec_t started_ut;
         } populate_mrg;
 
         bool create_new_datafile_pair;
     } loading;
 
+    struct dbengine_compression_dictionaries *compression_dictionaries;
+    struct dbengine_archive *archive;               // non-NULL when the rotated datafiles of the tier are archived
+
     struct rrdengine_statistics stats;
 };
 
@@ -537,6 +567,7 @@ static inline time_t max_acceptable_collected_time(void) {
 }
 
 void datafile_delete(struct rrdengine_instance *ctx, struct rrdengine_datafile *datafile, bool update_retention, bool worker);
+bool datafile_rotate(struct rrdengine_instance *ctx, bool update_retention, bool worker);
 
 // --------------------------------------------------------------------------------------------------------------------
 // the following functions are used to sort UUIDs in the journal files
@@ -3,6 +3,8 @@
 #include "database/engine/rrddiskprotocol.h"
 #include "rrdengine.h"
 #include "dbengine-compression.h"
+#include "metric-directory.h"
+#include "dbengine-archive.h"
 
 /* Default global database instance */
 struct rrdengine_instance multidb_ctx_storage_tier0 = { 0 };
@@ -24,6 +26,9 @@ uint8_t tier_page_type[RRD_STORAGE_TIERS] = {
     RRDENG_PAGE_TYPE_ARRAY_TIER1,
     RRDENG_PAGE_TYPE_ARRAY_TIER1};
 
+// the tier 0 metrics of these contexts use RRDENG_PAGE_TYPE_GORILLA_64BIT pages
+SIMPLE_PATTERN *tier0_double_precision_contexts = NULL;
+
 #if defined(ENV32BIT)
 size_t tier_page_size[RRD_STORAGE_TIERS] = {2048, 1024, 192, 192, 192};
 size_t tier_quota_mb[RRD_STORAGE_TIERS] = {512, 512, 512, 0, 0};
@@ -32,14 +37,16 @@ size_t tier_page_size[RRD_STORAGE_TIERS] = {4096, 2048, 384, 384, 384};
 size_t tier_quota_mb[RRD_STORAGE_TIERS] = {1024, 1024, 1024, 128, 64};
 #endif
 
-#if RRDENG_PAGE_TYPE_MAX != 2
-#error PAGE_TYPE_MAX is not 2 - you need to add allocations here
+#if RRDENG_PAGE_TYPE_MAX != 4
+#error PAGE_TYPE_MAX is not 4 - you need to add allocations here
 #endif
 
 size_t page_type_size[256] = {
         [RRDENG_PAGE_TYPE_ARRAY_32BIT] = sizeof(storage_number),
         [RRDENG_PAGE_TYPE_ARRAY_TIER1] = sizeof(storage_number_tier1_t),
-        [RRDENG_PAGE_TYPE_GORILLA_32BIT] = sizeof(storage_number)
+        [RRDENG_PAGE_TYPE_GORILLA_32BIT] = sizeof(storage_number),
+        [RRDENG_PAGE_TYPE_GORILLA_TIER1] = sizeof(storage_number_tier1_t),
+        [RRDENG_PAGE_TYPE_GORILLA_64BIT] = sizeof(uint64_t)
 };
 
 static inline void initialize_single_ctx(struct rrdengine_instance *ctx) {
@@ -74,6 +81,9 @@ int default_rrdeng_page_cache_mb = 32;
 int default_rrdeng_extent_cache_mb = 0;
 #endif
 
+// extents of the same datafile closer than this are read by queries with a single I/O
+uint64_t rrdeng_extent_read_coalesce_gap_bytes = 128 * 1024;
+
 // ----------------------------------------------------------------------------
 // metrics groups
 
@@ -220,13 +230,11 @@ static inline bool check_completed_page_consistency(struct rrdeng_collect_handle
     if (unlikely(!handle->pgc_page || !handle->page_entries_max || !handle->page_position || !handle->page_end_time_ut))
         return false;
 
-    struct rrdengine_instance *ctx = mrg_metric_ctx(handle->metric);
-
     nd_uuid_t *uuid = mrg_metric_uuid(main_mrg, handle->metric);
     time_t start_time_s = pgc_page_start_time_s(handle->pgc_page);
     time_t end_time_s = pgc_page_end_time_s(handle->pgc_page);
     uint32_t update_every_s = pgc_page_update_every_s(handle->pgc_page);
-    size_t page_length = handle->page_position * CTX_POINT_SIZE_BYTES(ctx);
+    size_t page_length = handle->page_position * page_type_size[handle->page_type];
     size_t entries = handle->page_position;
     time_t overwrite_zero_update_every_s = (time_t)(handle->update_every_ut / USEC_PER_SEC);
 
@@ -239,7 +247,7 @@ static inline bool check_completed_page_consistency(struct rrdeng_collect_handle
             end_time_s,
             update_every_s,
             page_length,
-            ctx->config.page_type,
+            handle->page_type,
             entries,
             0, // do not check for future timestamps - we inherit the timestamps of the children
             overwrite_zero_update_every_s,
@@ -276,6 +284,7 @@ STORAGE_COLLECT_HANDLE *rrdeng_store_metric_init(STORAGE_METRIC_HANDLE *smh, uin
     handle = callocz(1, sizeof(struct rrdeng_collect_handle));
     handle->common.seb = STORAGE_ENGINE_BACKEND_DBENGINE;
     handle->metric = metric;
+    handle->page_type = ctx->config.page_type;
     
     handle->pgc_page = NULL;
     handle->page_data = NULL;
@@ -405,7 +414,7 @@ static void rrdeng_store_metric_create_new_page(struct rrdeng_collect_handle *ha
         pgc_page = pgc_page_add_and_acquire(main_cache, page_entry, &added);
     }
 
-    handle->page_entries_max = data_size / CTX_POINT_SIZE_BYTES(ctx);
+    handle->page_entries_max = data_size / page_type_size[handle->page_type];
     handle->page_start_time_ut = point_in_time_ut;
     handle->page_end_time_ut = point_in_time_ut;
     handle->page_position = 1; // zero is already in our data
@@ -442,7 +451,8 @@ static PGD *rrdeng_alloc_new_page_data(struct rrdeng_collect_handle *handle, siz
     PGD *d = NULL;
     
     size_t max_size = tier_page_size[ctx->config.tier];
-    size_t max_slots = max_size / CTX_POINT_SIZE_BYTES(ctx);
+    size_t point_size = page_type_size[handle->page_type];
+    size_t max_slots = max_size / point_size;
 
     size_t slots = aligned_allocation_entries(
             max_slots,
@@ -456,27 +466,29 @@ static PGD *rrdeng_alloc_new_page_data(struct rrdeng_collect_handle *handle, siz
     if(slots < 3)
         slots = 3;
 
-    size_t size = slots * CTX_POINT_SIZE_BYTES(ctx);
+    size_t size = slots * point_size;
 
     // internal_error(true, "PAGE ALLOC %zu bytes (%zu max)", size, max_size);
 
     internal_fatal(slots < 3 || slots > max_slots, "ooops! wrong distribution of metrics across time");
-    internal_fatal(size > tier_page_size[ctx->config.tier] || size < CTX_POINT_SIZE_BYTES(ctx) * 2, "ooops! wrong page size");
+    internal_fatal(size > tier_page_size[ctx->config.tier] || size < point_size * 2, "ooops! wrong page size");
 
     *data_size = size;
 
-    switch (ctx->config.page_type) {
+    switch (handle->page_type) {
         case RRDENG_PAGE_TYPE_ARRAY_32BIT:
         case RRDENG_PAGE_TYPE_ARRAY_TIER1:
-            d = pgd_create(ctx->config.page_type, slots);
+        case RRDENG_PAGE_TYPE_GORILLA_TIER1:
+            d = pgd_create(handle->page_type, slots);
             break;
         case RRDENG_PAGE_TYPE_GORILLA_32BIT:
+        case RRDENG_PAGE_TYPE_GORILLA_64BIT:
             // ignore slots, and use the fixed number of slots per gorilla buffer.
             // gorilla will automatically add more buffers if needed.
-            d = pgd_create(ctx->config.page_type, RRDENG_GORILLA_32BIT_BUFFER_SLOTS);
+            d = pgd_create(handle->page_type, RRDENG_GORILLA_32BIT_BUFFER_SLOTS);
             break;
         default:
-            fatal("Unknown page type: %uc\n", ctx->config.page_type);
+            fatal("Unknown page type: %uc\n", handle->page_type);
     }
 
     timing_step(TIMING_STEP_DBENGINE_PAGE_ALLOC);
@@ -694,6 +706,29 @@ void rrdeng_store_metric_change_collection_frequency(STORAGE_COLLECT_HANDLE *sch
     handle->update_every_ut = update_every_ut;
 }
 
+static inline bool is_tier0_page_type(uint8_t page_type) {
+    return page_type == RRDENG_PAGE_TYPE_ARRAY_32BIT ||
+           page_type == RRDENG_PAGE_TYPE_GORILLA_32BIT ||
+           page_type == RRDENG_PAGE_TYPE_GORILLA_64BIT;
+}
+
+// the pages of a tier 0 metric can be of any tier 0 page type,
+// since each page on disk has its own type
+void rrdeng_store_metric_change_page_type(STORAGE_COLLECT_HANDLE *sch, uint8_t page_type) {
+    struct rrdeng_collect_handle *handle = (struct rrdeng_collect_handle *)sch;
+
+    if(page_type == handle->page_type)
+        return;
+
+    if(!is_tier0_page_type(page_type) || !is_tier0_page_type(handle->page_type)) {
+        internal_error(true, "DBENGINE: cannot change page type %u to %u", handle->page_type, page_type);
+        return;
+    }
+
+    rrdeng_store_metric_flush_current_page(sch);
+    handle->page_type = page_type;
+}
+
 // ----------------------------------------------------------------------------
 // query ops
 
@@ -900,6 +935,59 @@ prepare_for_next_iteration:
     return sp;
 }
 
+// Fills up to max consecutive points, exactly as max calls to rrdeng_load_metric_next() would do,
+// stopping early when the query is finished or at the end of the current page.
+// Returns the number of points filled.
+size_t rrdeng_load_metric_next_batch(struct storage_engine_query_handle *seqh, STORAGE_POINT *sps, size_t max) {
+    struct rrdeng_query_handle *handle = (struct rrdeng_query_handle *)seqh->handle;
+    size_t filled = 0;
+
+    while(filled < max && handle->now_s <= seqh->end_time_s) {
+        if (unlikely(!handle->page || handle->position >= handle->entries)) {
+            // We need to get a new page
+            // but do not load it before the caller consumes what we already have
+            if(filled)
+                break;
+
+            if (!rrdeng_load_page_next(seqh, false)) {
+                handle->now_s = seqh->end_time_s;
+                storage_point_empty(sps[filled], handle->now_s - handle->dt_s, handle->now_s);
+                handle->now_s += handle->dt_s;
+                handle->position++;
+                filled++;
+                break;
+            }
+        }
+
+        size_t wanted = MIN(max - filled, handle->entries - handle->position);
+        if(likely(handle->dt_s))
+            wanted = MIN(wanted, (size_t)((seqh->end_time_s - handle->now_s) / handle->dt_s) + 1);
+
+        STORAGE_POINT *sp = &sps[filled];
+        size_t got = pgdc_get_next_points(&handle->pgdc, handle->position, sp, wanted);
+        if(unlikely(!got)) {
+            // let the single point decoder handle whatever is left on this page
+            sp->start_time_s = handle->now_s - handle->dt_s;
+            sp->end_time_s = handle->now_s;
+            pgdc_get_next_point(&handle->pgdc, handle->position, sp);
+            got = 1;
+        }
+
+        for(size_t i = 0; i < got; i++) {
+            sp[i].start_time_s = handle->now_s - handle->dt_s;
+            sp[i].end_time_s = handle->now_s;
+            handle->now_s += handle->dt_s;
+        }
+
+        internal_fatal(sp->end_time_s < seqh->start_time_s, "DBENGINE: this point is too old for this query");
+
+        handle->position += got;
+        filled += got;
+    }
+
+    return filled;
+}
+
 int rrdeng_load_metric_is_finished(struct storage_engine_query_handle *seqh) {
     struct rrdeng_query_handle *handle = (struct rrdeng_query_handle *)seqh->handle;
     return (handle->now_s > seqh->end_time_s);
@@ -925,6 +1013,25 @@ void rrdeng_load_metric_finalize(struct storage_engine_query_handle *seqh)
     seqh->handle = NULL;
 }
 
+// starts loading the pages of a time-frame into the main cache, without waiting for them
+// the extents not loaded within timeout_ut are not loaded at all
+void rrdeng_load_metric_prefetch(STORAGE_METRIC_HANDLE *smh, time_t start_time_s, time_t end_time_s, usec_t timeout_ut) {
+    struct storage_engine_query_handle seqh;
+    rrdeng_load_metric_init(smh, &seqh, start_time_s, end_time_s, STORAGE_PRIORITY_BEST_EFFORT);
+
+    struct rrdeng_query_handle *handle = (struct rrdeng_query_handle *)seqh.handle;
+
+    if(handle->pdc) {
+        __atomic_store_n(&handle->pdc->workers_deadline_ut, now_monotonic_usec() + timeout_ut, __ATOMIC_RELAXED);
+
+        // leave the workers running - they release the pdc when they finish
+        pdc_release_and_destroy_if_unreferenced(handle->pdc, false, false);
+    }
+
+    unregister_query_handle(handle);
+    rrdeng_query_handle_release(handle);
+}
+
 time_t rrdeng_load_align_to_optimal_before(struct storage_engine_query_handle *seqh) {
     struct rrdeng_query_handle *handle = (struct rrdeng_query_handle *)seqh->handle;
 
@@ -1084,7 +1191,23 @@ static void rrdeng_populate_mrg(struct rrdengine_instance *ctx) {
     if(cpus < 1)
         cpus = 1;
 
-    netdata_log_info("DBENGINE: populating retention to MRG from %zu journal files of tier %d, using %zd threads...", datafiles, ctx->config.tier, cpus);
+    // report the progress of the population via /api/v2/progress
+    char query[100];
+    snprintfz(query, sizeof(query) - 1, "DBENGINE tier %d: populating metrics registry", ctx->config.tier);
+    ctx->loading.populate_mrg.started_ut = now_realtime_usec();
+    uuid_generate_random(ctx->loading.populate_mrg.transaction);
+    query_progress_start_or_update(&ctx->loading.populate_mrg.transaction, ctx->loading.populate_mrg.started_ut,
+                                   HTTP_REQUEST_MODE_GET, HTTP_ACL_NONE, query, NULL, "dbengine");
+    query_progress_set_finish_line(&ctx->loading.populate_mrg.transaction, datafiles);
+
+    size_t covered = metric_directory_load(ctx);
+    if(covered)
+        query_progress_done_step(&ctx->loading.populate_mrg.transaction, covered);
+
+    char transaction[UUID_STR_LEN];
+    uuid_unparse_lower(ctx->loading.populate_mrg.transaction, transaction);
+    netdata_log_info("DBENGINE: populating retention to MRG from %zu journal files of tier %d (%zu covered by the metric directory), using %zd threads, progress transaction %s...",
+                     datafiles, ctx->config.tier, covered, cpus, transaction);
 
     if(datafiles > 2) {
         struct rrdengine_datafile *datafile;
@@ -1093,20 +1216,22 @@ static void rrdeng_populate_mrg(struct rrdengine_instance *ctx) {
         if(!(datafile->journalfile->v2.flags & JOURNALFILE_FLAG_IS_AVAILABLE))
             datafile = datafile->prev;
 
-        if(datafile->journalfile->v2.flags & JOURNALFILE_FLAG_IS_AVAILABLE) {
+        if(!datafile->populate_mrg.populated && (datafile->journalfile->v2.flags & JOURNALFILE_FLAG_IS_AVAILABLE)) {
             journalfile_v2_populate_retention_to_mrg(ctx, datafile->journalfile);
             datafile->populate_mrg.populated = true;
+            query_progress_done_step(&ctx->loading.populate_mrg.transaction, 1);
         }
 
         datafile = ctx->datafiles.first;
-        if(datafile->journalfile->v2.flags & JOURNALFILE_FLAG_IS_AVAILABLE) {
+        if(!datafile->populate_mrg.populated && (datafile->journalfile->v2.flags & JOURNALFILE_FLAG_IS_AVAILABLE)) {
             journalfile_v2_populate_retention_to_mrg(ctx, datafile->journalfile);
             datafile->populate_mrg.populated = true;
+            query_progress_done_step(&ctx->loading.populate_mrg.transaction, 1);
         }
     }
 
-    ctx->loading.populate_mrg.size = cpus;
-    ctx->loading.populate_mrg.array = callocz(ctx->loading.populate_mrg.size, sizeof(struct completion));
+    ctx->loading.populate_mrg.array = callocz(cpus, sizeof(struct completion));
+    __atomic_store_n(&ctx->loading.populate_mrg.size, cpus, __ATOMIC_RELEASE);
 
     for (size_t i = 0; i < ctx->loading.populate_mrg.size; i++) {
         completion_init(&ctx->loading.populate_mrg.array[i]);
@@ -1115,7 +1240,28 @@ static void rrdeng_populate_mrg(struct rrdengine_instance *ctx) {
     }
 }
 
+bool rrdeng_is_ready(struct rrdengine_instance *ctx) {
+    return __atomic_load_n(&ctx->loading.populate_mrg.size, __ATOMIC_ACQUIRE) == 0;
+}
+
+bool rrdeng_all_tiers_ready(void) {
+    for(size_t tier = 0; tier < storage_tiers ;tier++) {
+        if(multidb_ctx[tier] && !rrdeng_is_ready(multidb_ctx[tier]))
+            return false;
+    }
+
+    return true;
+}
+
 void rrdeng_readiness_wait(struct rrdengine_instance *ctx) {
+    // it may be called concurrently, by the background readiness thread and at exit
+    spinlock_lock(&ctx->loading.populate_mrg.spinlock);
+
+    if(rrdeng_is_ready(ctx)) {
+        spinlock_unlock(&ctx->loading.populate_mrg.spinlock);
+        return;
+    }
+
     for (size_t i = 0; i < ctx->loading.populate_mrg.size; i++) {
         completion_wait_for(&ctx->loading.populate_mrg.array[i]);
         completion_destroy(&ctx->loading.populate_mrg.array[i]);
@@ -1123,20 +1269,65 @@ void rrdeng_readiness_wait(struct rrdengine_instance *ctx) {
 
     freez(ctx->loading.populate_mrg.array);
     ctx->loading.populate_mrg.array = NULL;
-    ctx->loading.populate_mrg.size = 0;
+    __atomic_store_n(&ctx->loading.populate_mrg.size, 0, __ATOMIC_RELEASE);
+
+    usec_t finished_ut = now_realtime_usec();
+    query_progress_finished(&ctx->loading.populate_mrg.transaction, finished_ut, HTTP_RESP_OK,
+                            finished_ut - ctx->loading.populate_mrg.started_ut, 0, 0);
 
-    netdata_log_info("DBENGINE: tier %d is ready for data collection and queries", ctx->config.tier);
+    spinlock_unlock(&ctx->loading.populate_mrg.spinlock);
+
+    netdata_log_info("DBENGINE: tier %d is ready for data collection and queries, in %0.2f secs",
+                     ctx->config.tier, (double)(finished_ut - ctx->loading.populate_mrg.started_ut) / USEC_PER_SEC);
 }
 
 void rrdeng_exit_mode(struct rrdengine_instance *ctx) {
     __atomic_store_n(&ctx->quiesce.exit_mode, true, __ATOMIC_RELAXED);
 }
+// the stripes are extra directories (space separated) the datafiles of the tier are rotated to,
+// so that its I/O is spread across devices - everything else stays in dbfiles_path
+static void rrdeng_stripes_set(struct rrdengine_instance *ctx, const char *stripes_paths) {
+    for (size_t i = 0; i < ctx->config.stripes.count; i++)
+        freez(ctx->config.stripes.paths[i]);
+
+    ctx->config.stripes.count = 0;
+
+    if (!stripes_paths || !*stripes_paths)
+        return;
+
+    char *buf = strdupz(stripes_paths);
+    char *s = buf, *path;
+    while ((path = strsep_skip_consecutive_separators(&s, " \t"))) {
+        if (!*path)
+            continue;
+
+        if (ctx->config.stripes.count >= RRDENG_MAX_STRIPES) {
+            nd_log(NDLS_DAEMON, NDLP_ERR,
+                   "DBENGINE: tier %d can have up to %d stripe directories, ignoring '%s'",
+                   ctx->config.tier, RRDENG_MAX_STRIPES, path);
+            continue;
+        }
+
+        if (mkdir(path, 0775) != 0 && errno != EEXIST) {
+            nd_log(NDLS_DAEMON, NDLP_ERR,
+                   "DBENGINE: cannot create stripe directory '%s' of tier %d, ignoring it",
+                   path, ctx->config.tier);
+            continue;
+        }
+
+        ctx->config.stripes.paths[ctx->config.stripes.count++] = strdupz(path);
+    }
+
+    freez(buf);
+}
+
 /*
  * Returns 0 on success, negative on error
  */
 int rrdeng_init(
     struct rrdengine_instance **ctxp,
     const char *dbfiles_path,
+    const char *stripes_paths,
     unsigned disk_space_mb,
     size_t tier,
     time_t max_retention_s)
@@ -1173,6 +1364,8 @@ int rrdeng_init(
     strncpyz(ctx->config.dbfiles_path, dbfiles_path, sizeof(ctx->config.dbfiles_path) - 1);
     ctx->config.dbfiles_path[sizeof(ctx->config.dbfiles_path) - 1] = '\0';
 
+    rrdeng_stripes_set(ctx, stripes_paths);
+
     if (disk_space_mb && disk_space_mb < RRDENG_MIN_DISK_SPACE_MB)
         disk_space_mb = RRDENG_MIN_DISK_SPACE_MB;
 
@@ -1187,12 +1380,20 @@ int rrdeng_init(
     ctx->atomic.metrics = 0;
     ctx->atomic.samples = 0;
 
+    dbengine_compression_dictionaries_init(ctx);
+
+    // before loading the datafiles, some of them may be archived
+    dbengine_archive_init(ctx);
+
     if (rrdeng_dbengine_spawn(ctx) && !init_rrd_files(ctx)) {
         // success - we run this ctx too
         rrdeng_populate_mrg(ctx);
         return 0;
     }
 
+    dbengine_archive_cleanup(ctx);
+    dbengine_compression_dictionaries_destroy(ctx);
+
     if (unittest_running) {
         freez(ctx);
         if (ctxp)
@@ -1220,6 +1421,9 @@ int rrdeng_exit(struct rrdengine_instance *ctx) {
     // 3. flush this section of the main cache
     // 4. then wait for completion
 
+    // the population of the MRG may still be running in the background
+    rrdeng_readiness_wait(ctx);
+
     bool logged = false;
     size_t count = 10;
     while(__atomic_load_n(&ctx->atomic.collectors_running, __ATOMIC_RELAXED) && count && !unittest_running) {
@@ -1241,15 +1445,51 @@ int rrdeng_exit(struct rrdengine_instance *ctx) {
     completion_wait_for(&completion);
     completion_destroy(&completion);
 
+    metric_directory_save(ctx);
     finalize_rrd_files(ctx);
+    dbengine_archive_cleanup(ctx);
+    dbengine_compression_dictionaries_destroy(ctx);
 
-    if (unittest_running) //(ctx->config.unittest)
+    if (unittest_running) { //(ctx->config.unittest)
+        rrdeng_stripes_set(ctx, NULL);
         freez(ctx);
+    }
 
     rrd_stat_atomic_add(&rrdeng_reserved_file_descriptors, -RRDENG_FD_BUDGET_PER_INSTANCE);
     return 0;
 }
 
+static void *rrdeng_exit_tier_thread(void *ptr) {
+    rrdeng_exit((struct rrdengine_instance *)ptr);
+    return NULL;
+}
+
+// shutdown all tiers in parallel - each one flushes its own section of the
+// main cache and saves its own files, so they do not depend on each other
+void rrdeng_exit_all_tiers(void) {
+    ND_THREAD *threads[RRD_STORAGE_TIERS] = { 0 };
+
+    for (size_t tier = 0; tier < storage_tiers; tier++) {
+        if (!multidb_ctx[tier])
+            continue;
+
+#ifdef OS_WINDOWS
+        rrdeng_exit(multidb_ctx[tier]);
+#else
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, sizeof(tag), "DBENGEXIT%zu", tier);
+        threads[tier] = nd_thread_create(tag, NETDATA_THREAD_OPTION_JOINABLE, rrdeng_exit_tier_thread, multidb_ctx[tier]);
+        if (!threads[tier])
+            rrdeng_exit(multidb_ctx[tier]);
+#endif
+    }
+
+    for (size_t tier = 0; tier < storage_tiers; tier++) {
+        if (threads[tier])
+            nd_thread_join(threads[tier]);
+    }
+}
+
 void rrdeng_prepare_exit(struct rrdengine_instance *ctx) {
     if (NULL == ctx)
         return;
@@ -15,6 +15,7 @@
 
 extern int default_rrdeng_page_cache_mb;
 extern int default_rrdeng_extent_cache_mb;
+extern uint64_t rrdeng_extent_read_coalesce_gap_bytes;
 extern int db_engine_journal_check;
 extern int default_rrdeng_disk_quota_mb;
 extern int default_multidb_disk_quota_mb;
@@ -27,6 +28,7 @@ extern size_t page_type_size[];
 extern size_t tier_page_size[];
 extern size_t tier_quota_mb[];
 extern uint8_t tier_page_type[];
+extern SIMPLE_PATTERN *tier0_double_precision_contexts;
 
 #define CTX_POINT_SIZE_BYTES(ctx) page_type_size[(ctx)->config.page_type]
 
@@ -38,6 +40,7 @@ STORAGE_METRIC_HANDLE *rrdeng_metric_dup(STORAGE_METRIC_HANDLE *smh);
 STORAGE_COLLECT_HANDLE *rrdeng_store_metric_init(STORAGE_METRIC_HANDLE *smh, uint32_t update_every, STORAGE_METRICS_GROUP *smg);
 void rrdeng_store_metric_flush_current_page(STORAGE_COLLECT_HANDLE *sch);
 void rrdeng_store_metric_change_collection_frequency(STORAGE_COLLECT_HANDLE *sch, int update_every);
+void rrdeng_store_metric_change_page_type(STORAGE_COLLECT_HANDLE *sch, uint8_t page_type);
 void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *sch, usec_t point_in_time_ut, NETDATA_DOUBLE n,
                                      NETDATA_DOUBLE min_value,
                                      NETDATA_DOUBLE max_value,
@@ -49,10 +52,12 @@ int rrdeng_store_metric_finalize(STORAGE_COLLECT_HANDLE *sch);
 void rrdeng_load_metric_init(STORAGE_METRIC_HANDLE *smh, struct storage_engine_query_handle *seqh,
                                     time_t start_time_s, time_t end_time_s, STORAGE_PRIORITY priority);
 STORAGE_POINT rrdeng_load_metric_next(struct storage_engine_query_handle *seqh);
+size_t rrdeng_load_metric_next_batch(struct storage_engine_query_handle *seqh, STORAGE_POINT *sps, size_t max);
 
 
 int rrdeng_load_metric_is_finished(struct storage_engine_query_handle *seqh);
 void rrdeng_load_metric_finalize(struct storage_engine_query_handle *seqh);
+void rrdeng_load_metric_prefetch(STORAGE_METRIC_HANDLE *smh, time_t start_time_s, time_t end_time_s, usec_t timeout_ut);
 time_t rrdeng_metric_latest_time(STORAGE_METRIC_HANDLE *smh);
 time_t rrdeng_metric_oldest_time(STORAGE_METRIC_HANDLE *smh);
 time_t rrdeng_load_align_to_optimal_before(struct storage_engine_query_handle *seqh);
@@ -63,14 +68,18 @@ void rrdeng_get_37_statistics(struct rrdengine_instance *ctx, unsigned long long
 int rrdeng_init(
     struct rrdengine_instance **ctxp,
     const char *dbfiles_path,
+    const char *stripes_paths,
     unsigned disk_space_mb,
     size_t tier,
     time_t max_retention_s);
 
 void rrdeng_readiness_wait(struct rrdengine_instance *ctx);
+bool rrdeng_is_ready(struct rrdengine_instance *ctx);
+bool rrdeng_all_tiers_ready(void);
 void rrdeng_exit_mode(struct rrdengine_instance *ctx);
 
 int rrdeng_exit(struct rrdengine_instance *ctx);
+void rrdeng_exit_all_tiers(void);
 void rrdeng_prepare_exit(struct rrdengine_instance *ctx);
 bool rrdeng_metric_retention_by_uuid(STORAGE_INSTANCE *si, nd_uuid_t *dim_uuid, time_t *first_entry_s, time_t *last_entry_s);
 
@@ -162,6 +171,7 @@ struct rrdeng_cache_efficiency_stats {
 
     // loading
     size_t pages_load_extent_merged;
+    size_t extent_reads_coalesced;                      // extent reads saved by reading neighboring extents together
     size_t pages_load_ok_uncompressed;
     size_t pages_load_ok_compressed;
     size_t pages_load_fail_invalid_page_in_extent;
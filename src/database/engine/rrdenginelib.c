@@ -1,6 +1,112 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "rrdengine.h"
 
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// CRC32C (Castagnoli, reflected polynomial 0x82F63B78)
+
+bool dbengine_use_crc32c = false;
+
+typedef uint32_t (*crc32c_function_t)(uint32_t crc, const uint8_t *p, size_t len);
+
+static uint32_t crc32c_table[256];
+
+static void crc32c_table_init(void) {
+    for(uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for(int k = 0; k < 8; k++)
+            c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : (c >> 1);
+        crc32c_table[i] = c;
+    }
+}
+
+static uint32_t crc32c_software(uint32_t crc, const uint8_t *p, size_t len) {
+    while(len--)
+        crc = crc32c_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+    return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const uint8_t *p, size_t len) {
+    while(len && ((uintptr_t)p & 7)) {
+        crc = __builtin_ia32_crc32qi(crc, *p++);
+        len--;
+    }
+
+    uint64_t c = crc;
+    while(len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        c = __builtin_ia32_crc32di(c, v);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)c;
+
+    while(len--)
+        crc = __builtin_ia32_crc32qi(crc, *p++);
+
+    return crc;
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+static uint32_t crc32c_armv8(uint32_t crc, const uint8_t *p, size_t len) {
+    while(len && ((uintptr_t)p & 7)) {
+        crc = __crc32cb(crc, *p++);
+        len--;
+    }
+
+    while(len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        crc = __crc32cd(crc, v);
+        p += 8;
+        len -= 8;
+    }
+
+    while(len--)
+        crc = __crc32cb(crc, *p++);
+
+    return crc;
+}
+#endif
+
+static crc32c_function_t crc32c_function_select(void) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.2"))
+        return crc32c_sse42;
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    return crc32c_armv8;
+#endif
+
+    crc32c_table_init();
+    return crc32c_software;
+}
+
+uint32_t rrdeng_crc32c(uint32_t crc, const void *data, size_t len) {
+    static crc32c_function_t crc32c_function = NULL;
+
+    // selecting twice is harmless, all threads end up with the same function
+    crc32c_function_t f = __atomic_load_n(&crc32c_function, __ATOMIC_ACQUIRE);
+    if(unlikely(!f)) {
+        f = crc32c_function_select();
+        __atomic_store_n(&crc32c_function, f, __ATOMIC_RELEASE);
+    }
+
+    return ~f(~crc, data, len);
+}
+
+// ----------------------------------------------------------------------------
+
 int check_file_properties(uv_file file, uint64_t *file_size, size_t min_size)
 {
     int ret;
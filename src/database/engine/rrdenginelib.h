@@ -78,6 +78,33 @@ static inline void crc32set(void *crcp, uLong crc)
     memcpy(crcp, &store_crc, sizeof(store_crc));
 }
 
+// the checksum of the extents and the journal v1 transactions of a datafile pair
+// selected by the version of the superblocks: "1.0" files use CRC32, "1.1" files CRC32C
+typedef enum __attribute__ ((__packed__)) {
+    RRDENG_CHECKSUM_CRC32 = 0,
+    RRDENG_CHECKSUM_CRC32C,
+} RRDENG_CHECKSUM_TYPE;
+
+extern bool dbengine_use_crc32c;
+
+// CRC32C (Castagnoli), with SSE4.2 or ARMv8 CRC instructions when available
+// like zlib crc32(), it starts with crc = 0 and can be chained
+uint32_t rrdeng_crc32c(uint32_t crc, const void *data, size_t len);
+
+static inline uLong rrdeng_checksum(RRDENG_CHECKSUM_TYPE type, const void *data, size_t len)
+{
+    if(type == RRDENG_CHECKSUM_CRC32C)
+        return rrdeng_crc32c(0, data, len);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    return crc32(crc, data, len);
+}
+
+static inline const char *rrdeng_checksum_name(RRDENG_CHECKSUM_TYPE type)
+{
+    return type == RRDENG_CHECKSUM_CRC32C ? "CRC32C" : "CRC32";
+}
+
 int check_file_properties(uv_file file, uint64_t *file_size, size_t min_size);
 int open_file_for_io(char *path, int flags, uv_file *file, int direct);
 static inline int open_file_direct_io(char *path, int flags, uv_file *file)
@@ -24,6 +24,11 @@ void rrddim_metrics_group_release(STORAGE_INSTANCE *si __maybe_unused, STORAGE_M
 struct mem_metric_handle {
     RRDDIM *rd;
 
+    // the collector is the only writer of the position of the ring below;
+    // it makes this odd while updating it, so that queries can copy it
+    // without locking, retrying when they overlap with an update
+    uint32_t seq;
+
     size_t counter;
     size_t entries;
     size_t current_entry;
@@ -33,6 +38,15 @@ struct mem_metric_handle {
     int32_t refcount;
 };
 
+// get the total duration in seconds of the round-robin database
+#define metric_duration(mh) (( (time_t)(mh)->counter >= (time_t)(mh)->entries ? (time_t)(mh)->entries : (time_t)(mh)->counter ) * (time_t)(mh)->update_every_s)
+
+// get the last slot updated in the round-robin database
+#define rrddim_last_slot(mh) ((size_t)(((mh)->current_entry == 0) ? (mh)->entries - 1 : (mh)->current_entry - 1))
+
+// return the slot that has the oldest value
+#define rrddim_first_slot(mh) ((size_t)((mh)->counter >= (size_t)(mh)->entries ? (mh)->current_entry : 0))
+
 static void update_metric_handle_from_rrddim(struct mem_metric_handle *mh, RRDDIM *rd) {
     mh->counter        = rd->rrdset->counter;
     mh->entries        = rd->rrdset->db.entries;
@@ -41,6 +55,36 @@ static void update_metric_handle_from_rrddim(struct mem_metric_handle *mh, RRDDI
     mh->update_every_s = rd->rrdset->update_every;
 }
 
+static inline void metric_handle_write_begin(struct mem_metric_handle *mh) {
+    __atomic_store_n(&mh->seq, mh->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void metric_handle_write_end(struct mem_metric_handle *mh) {
+    __atomic_store_n(&mh->seq, mh->seq + 1, __ATOMIC_RELEASE);
+}
+
+// copy the position of the ring, consistent with a single collection
+static inline void metric_handle_snapshot(struct mem_metric_handle *mh, struct mem_metric_handle *snap) {
+    uint32_t seq;
+
+    do {
+        while((seq = __atomic_load_n(&mh->seq, __ATOMIC_ACQUIRE)) & 1)
+            tinysleep();
+
+        snap->rd             = mh->rd;
+        snap->counter        = __atomic_load_n(&mh->counter, __ATOMIC_RELAXED);
+        snap->entries        = __atomic_load_n(&mh->entries, __ATOMIC_RELAXED);
+        snap->current_entry  = __atomic_load_n(&mh->current_entry, __ATOMIC_RELAXED);
+        snap->last_updated_s = __atomic_load_n(&mh->last_updated_s, __ATOMIC_RELAXED);
+        snap->update_every_s = __atomic_load_n(&mh->update_every_s, __ATOMIC_RELAXED);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while(seq != __atomic_load_n(&mh->seq, __ATOMIC_RELAXED));
+
+    snap->seq = seq;
+}
+
 static void check_metric_handle_from_rrddim(struct mem_metric_handle *mh) {
     RRDDIM *rd = mh->rd; (void)rd;
     internal_fatal(mh->entries != (size_t)rd->rrdset->db.entries, "RRDDIM: entries do not match");
@@ -121,25 +165,24 @@ bool rrddim_metric_retention_by_uuid(STORAGE_INSTANCE *si __maybe_unused, nd_uui
     if(!smh)
         return false;
 
-    *first_entry_s = rrddim_query_oldest_time_s(smh);
-    *last_entry_s = rrddim_query_latest_time_s(smh);
+    struct mem_metric_handle snap;
+    metric_handle_snapshot((struct mem_metric_handle *)smh, &snap);
+    rrddim_metric_release(smh);
 
-    return true;
-}
-
-void rrddim_store_metric_change_collection_frequency(STORAGE_COLLECT_HANDLE *sch, int update_every) {
-    struct mem_collect_handle *ch = (struct mem_collect_handle *)sch;
-    struct mem_metric_handle *mh = (struct mem_metric_handle *)ch->smh;
+    *first_entry_s = (time_t)(snap.last_updated_s - metric_duration(&snap));
+    *last_entry_s = snap.last_updated_s;
 
-    rrddim_store_metric_flush(sch);
-    mh->update_every_s = update_every;
+    return true;
 }
 
 STORAGE_COLLECT_HANDLE *rrddim_collect_init(STORAGE_METRIC_HANDLE *smh, uint32_t update_every __maybe_unused, STORAGE_METRICS_GROUP *smg __maybe_unused) {
     struct mem_metric_handle *mh = (struct mem_metric_handle *)smh;
     RRDDIM *rd = mh->rd;
 
+    metric_handle_write_begin(mh);
     update_metric_handle_from_rrddim(mh, rd);
+    metric_handle_write_end(mh);
+
     internal_fatal((uint32_t)mh->update_every_s != update_every, "RRDDIM: update requested does not match the dimension");
 
     struct mem_collect_handle *ch = callocz(1, sizeof(struct mem_collect_handle));
@@ -152,10 +195,8 @@ STORAGE_COLLECT_HANDLE *rrddim_collect_init(STORAGE_METRIC_HANDLE *smh, uint32_t
     return (STORAGE_COLLECT_HANDLE *)ch;
 }
 
-void rrddim_store_metric_flush(STORAGE_COLLECT_HANDLE *sch) {
-    struct mem_collect_handle *ch = (struct mem_collect_handle *)sch;
-    struct mem_metric_handle *mh = (struct mem_metric_handle *)ch->smh;
-
+// the caller has to be in a write section of the metric handle
+static void metric_handle_reset(struct mem_metric_handle *mh) {
     RRDDIM *rd = mh->rd;
     size_t entries = mh->entries;
     storage_number empty = pack_storage_number(NAN, SN_FLAG_NONE);
@@ -168,6 +209,26 @@ void rrddim_store_metric_flush(STORAGE_COLLECT_HANDLE *sch) {
     mh->current_entry = 0;
 }
 
+void rrddim_store_metric_flush(STORAGE_COLLECT_HANDLE *sch) {
+    struct mem_collect_handle *ch = (struct mem_collect_handle *)sch;
+    struct mem_metric_handle *mh = (struct mem_metric_handle *)ch->smh;
+
+    metric_handle_write_begin(mh);
+    metric_handle_reset(mh);
+    metric_handle_write_end(mh);
+}
+
+void rrddim_store_metric_change_collection_frequency(STORAGE_COLLECT_HANDLE *sch, int update_every) {
+    struct mem_collect_handle *ch = (struct mem_collect_handle *)sch;
+    struct mem_metric_handle *mh = (struct mem_metric_handle *)ch->smh;
+
+    metric_handle_write_begin(mh);
+    metric_handle_reset(mh);
+    mh->update_every_s = update_every;
+    metric_handle_write_end(mh);
+}
+
+// the caller has to be in a write section of the metric handle
 static inline void rrddim_fill_the_gap(STORAGE_COLLECT_HANDLE *sch, time_t now_collect_s) {
     struct mem_collect_handle *ch = (struct mem_collect_handle *)sch;
     struct mem_metric_handle *mh = (struct mem_metric_handle *)ch->smh;
@@ -182,7 +243,7 @@ static inline void rrddim_fill_the_gap(STORAGE_COLLECT_HANDLE *sch, time_t now_c
     time_t last_stored_s = mh->last_updated_s;
     size_t gap_entries = (now_collect_s - last_stored_s) / update_every_s;
     if(gap_entries >= entries)
-        rrddim_store_metric_flush(sch);
+        metric_handle_reset(mh);
 
     else {
         storage_number empty = pack_storage_number(NAN, SN_FLAG_NONE);
@@ -224,6 +285,8 @@ void rrddim_collect_store_metric(STORAGE_COLLECT_HANDLE *sch,
     if(unlikely(point_in_time_s <= mh->last_updated_s))
         return;
 
+    metric_handle_write_begin(mh);
+
     if(unlikely(mh->last_updated_s && point_in_time_s - mh->update_every_s > mh->last_updated_s))
         rrddim_fill_the_gap(sch, point_in_time_s);
 
@@ -231,6 +294,8 @@ void rrddim_collect_store_metric(STORAGE_COLLECT_HANDLE *sch,
     mh->counter++;
     mh->current_entry = (mh->current_entry + 1) >= mh->entries ? 0 : mh->current_entry + 1;
     mh->last_updated_s = point_in_time_s;
+
+    metric_handle_write_end(mh);
 }
 
 int rrddim_collect_finalize(STORAGE_COLLECT_HANDLE *sch) {
@@ -241,25 +306,15 @@ int rrddim_collect_finalize(STORAGE_COLLECT_HANDLE *sch) {
 
 // ----------------------------------------------------------------------------
 
-// get the total duration in seconds of the round-robin database
-#define metric_duration(mh) (( (time_t)(mh)->counter >= (time_t)(mh)->entries ? (time_t)(mh)->entries : (time_t)(mh)->counter ) * (time_t)(mh)->update_every_s)
-
-// get the last slot updated in the round-robin database
-#define rrddim_last_slot(mh) ((size_t)(((mh)->current_entry == 0) ? (mh)->entries - 1 : (mh)->current_entry - 1))
-
-// return the slot that has the oldest value
-#define rrddim_first_slot(mh) ((size_t)((mh)->counter >= (size_t)(mh)->entries ? (mh)->current_entry : 0))
-
 // get the slot of the round-robin database, for the given timestamp (t)
 // it always returns a valid slot, although it may not be for the time requested if the time is outside the round-robin database
 // only valid when not using dbengine
-static inline size_t rrddim_time2slot(STORAGE_METRIC_HANDLE *smh, time_t t) {
-    struct mem_metric_handle *mh = (struct mem_metric_handle *)smh;
+static inline size_t rrddim_time2slot(struct mem_metric_handle *mh, time_t t) {
     RRDDIM *rd = mh->rd;
 
     size_t ret = 0;
-    time_t last_entry_s  = rrddim_query_latest_time_s(smh);
-    time_t first_entry_s = rrddim_query_oldest_time_s(smh);
+    time_t last_entry_s  = mh->last_updated_s;
+    time_t first_entry_s = (time_t)(mh->last_updated_s - metric_duration(mh));
     size_t entries       = mh->entries;
     size_t first_slot    = rrddim_first_slot(mh);
     size_t last_slot     = rrddim_last_slot(mh);
@@ -292,13 +347,12 @@ static inline size_t rrddim_time2slot(STORAGE_METRIC_HANDLE *smh, time_t t) {
 
 // get the timestamp of a specific slot in the round-robin database
 // only valid when not using dbengine
-static inline time_t rrddim_slot2time(STORAGE_METRIC_HANDLE *smh, size_t slot) {
-    struct mem_metric_handle *mh = (struct mem_metric_handle *)smh;
+static inline time_t rrddim_slot2time(struct mem_metric_handle *mh, size_t slot) {
     RRDDIM *rd = mh->rd;
 
     time_t ret;
-    time_t last_entry_s  = rrddim_query_latest_time_s(smh);
-    time_t first_entry_s = rrddim_query_oldest_time_s(smh);
+    time_t last_entry_s  = mh->last_updated_s;
+    time_t first_entry_s = (time_t)(mh->last_updated_s - metric_duration(mh));
     size_t entries       = mh->entries;
     size_t last_slot     = rrddim_last_slot(mh);
     size_t update_every  = mh->update_every_s;
@@ -338,6 +392,11 @@ void rrddim_query_init(STORAGE_METRIC_HANDLE *smh, struct storage_engine_query_h
 
     check_metric_handle_from_rrddim(mh);
 
+    // the position of the ring when the query starts;
+    // the collector keeps writing while the query runs
+    struct mem_metric_handle snap;
+    metric_handle_snapshot(mh, &snap);
+
     seqh->start_time_s = start_time_s;
     seqh->end_time_s = end_time_s;
     seqh->priority = priority;
@@ -345,13 +404,13 @@ void rrddim_query_init(STORAGE_METRIC_HANDLE *smh, struct storage_engine_query_h
     struct mem_query_handle* h = mallocz(sizeof(struct mem_query_handle));
     h->smh = smh;
 
-    h->slot           = rrddim_time2slot(smh, start_time_s);
-    h->last_slot      = rrddim_time2slot(smh, end_time_s);
-    h->dt             = mh->update_every_s;
+    h->slot           = rrddim_time2slot(&snap, start_time_s);
+    h->last_slot      = rrddim_time2slot(&snap, end_time_s);
+    h->dt             = snap.update_every_s;
 
     h->next_timestamp = start_time_s;
-    h->slot_timestamp = rrddim_slot2time(smh, h->slot);
-    h->last_timestamp = rrddim_slot2time(smh, h->last_slot);
+    h->slot_timestamp = rrddim_slot2time(&snap, h->slot);
+    h->last_timestamp = rrddim_slot2time(&snap, h->last_slot);
 
     // netdata_log_info("RRDDIM QUERY INIT: start %ld, end %ld, next %ld, first %ld, last %ld, dt %ld", start_time, end_time, h->next_timestamp, h->slot_timestamp, h->last_timestamp, h->dt);
 
@@ -403,6 +462,51 @@ STORAGE_POINT rrddim_query_next_metric(struct storage_engine_query_handle *seqh)
     return sp;
 }
 
+// Fills up to max points, exactly as max calls to rrddim_query_next_metric() would do,
+// stopping early when the query is finished. Returns the number of points filled.
+size_t rrddim_query_next_metric_batch(struct storage_engine_query_handle *seqh, STORAGE_POINT *sps, size_t max) {
+    struct mem_query_handle* h = (struct mem_query_handle*)seqh->handle;
+    struct mem_metric_handle *mh = (struct mem_metric_handle *)h->smh;
+    storage_number *data = mh->rd->db.data;
+
+    size_t entries = mh->entries;
+    size_t slot = h->slot;
+    time_t dt = h->dt;
+    time_t next_timestamp = h->next_timestamp;
+    time_t slot_timestamp = h->slot_timestamp;
+    time_t last_timestamp = h->last_timestamp;
+
+    size_t filled = 0;
+    for(; filled < max && next_timestamp <= seqh->end_time_s ; filled++) {
+        STORAGE_POINT *sp = &sps[filled];
+
+        time_t this_timestamp = next_timestamp;
+        next_timestamp += dt;
+
+        if(unlikely(this_timestamp < slot_timestamp || this_timestamp > last_timestamp)) {
+            storage_point_empty(*sp, this_timestamp - dt, this_timestamp);
+            continue;
+        }
+
+        storage_number n = data[slot++];
+        if(unlikely(slot >= entries)) slot = 0;
+        slot_timestamp += dt;
+
+        sp->start_time_s = this_timestamp - dt;
+        sp->end_time_s = this_timestamp;
+        sp->count = 1;
+        sp->anomaly_count = is_storage_number_anomalous(n) ? 1 : 0;
+        sp->flags = (n & SN_USER_FLAGS);
+        sp->min = sp->max = sp->sum = unpack_storage_number(n);
+    }
+
+    h->slot = slot;
+    h->next_timestamp = next_timestamp;
+    h->slot_timestamp = slot_timestamp;
+
+    return filled;
+}
+
 int rrddim_query_is_finished(struct storage_engine_query_handle *seqh) {
     struct mem_query_handle *h = (struct mem_query_handle*)seqh->handle;
     return (h->next_timestamp > seqh->end_time_s);
@@ -428,10 +532,11 @@ time_t rrddim_query_align_to_optimal_before(struct storage_engine_query_handle *
 
 time_t rrddim_query_latest_time_s(STORAGE_METRIC_HANDLE *smh) {
     struct mem_metric_handle *mh = (struct mem_metric_handle *)smh;
-    return mh->last_updated_s;
+    return __atomic_load_n(&mh->last_updated_s, __ATOMIC_RELAXED);
 }
 
 time_t rrddim_query_oldest_time_s(STORAGE_METRIC_HANDLE *smh) {
-    struct mem_metric_handle *mh = (struct mem_metric_handle *)smh;
-    return (time_t)(mh->last_updated_s - metric_duration(mh));
+    struct mem_metric_handle snap;
+    metric_handle_snapshot((struct mem_metric_handle *)smh, &snap);
+    return (time_t)(snap.last_updated_s - metric_duration(&snap));
 }
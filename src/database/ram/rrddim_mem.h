@@ -45,6 +45,7 @@ int rrddim_collect_finalize(STORAGE_COLLECT_HANDLE *sch);
 
 void rrddim_query_init(STORAGE_METRIC_HANDLE *smh, struct storage_engine_query_handle *seqh, time_t start_time_s, time_t end_time_s, STORAGE_PRIORITY priority);
 STORAGE_POINT rrddim_query_next_metric(struct storage_engine_query_handle *seqh);
+size_t rrddim_query_next_metric_batch(struct storage_engine_query_handle *seqh, STORAGE_POINT *sps, size_t max);
 int rrddim_query_is_finished(struct storage_engine_query_handle *seqh);
 void rrddim_query_finalize(struct storage_engine_query_handle *seqh);
 time_t rrddim_query_latest_time_s(STORAGE_METRIC_HANDLE *smh);
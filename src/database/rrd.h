@@ -149,8 +149,12 @@ const char *rrdset_type_name(RRDSET_TYPE chart_type);
 extern bool dbengine_enabled;
 extern size_t storage_tiers;
 extern bool use_direct_io;
+extern bool dbengine_use_huge_pages;
 extern size_t storage_tiers_grouping_iterations[RRD_STORAGE_TIERS];
 
+// the contexts not to be stored in each tier (NULL = all are stored)
+extern SIMPLE_PATTERN *storage_tiers_exclude_contexts[RRD_STORAGE_TIERS];
+
 typedef enum __attribute__ ((__packed__)) {
     RRD_BACKFILL_NONE = 0,
     RRD_BACKFILL_FULL,
@@ -266,6 +270,24 @@ struct rrddim_tier {
 
 void rrdr_fill_tier_gap_from_smaller_tiers(RRDDIM *rd, size_t tier, time_t now_s);
 
+// the state of the backfilling of the higher tiers of a dimension
+typedef enum __attribute__ ((__packed__)) {
+    RRDDIM_BACKFILL_NONE = 0,                       // not checked yet
+    RRDDIM_BACKFILL_QUEUED,                         // waiting for the backfill job of its chart
+    RRDDIM_BACKFILL_RUNNING,                        // the backfill job is filling its higher tiers
+    RRDDIM_BACKFILL_DONE,                           // the job finished, the collector has to fill the last few points
+} RRDDIM_BACKFILL;
+
+extern size_t rrd_backfill_jobs;
+void rrd_backfill_init(void);
+bool rrddim_backfill_higher_tiers(RRDDIM *rd, time_t now_s);
+void rrdset_backfill_submit(RRDSET *st);
+void rrdhost_backfill_wait(RRDHOST *host);
+
+// live data subscriptions - see web/api/v3/api_v3_live.c
+void rrdset_live_collected(RRDSET *st);
+void rrdset_live_free(RRDSET *st);
+
 // ----------------------------------------------------------------------------
 // RRD DIMENSION - this is a metric
 
@@ -285,6 +307,8 @@ struct rrddim {
     int32_t multiplier;                             // the multiplier of the collected values
     int32_t divisor;                                // the divider of the collected values
 
+    uint32_t metadata_saved_hash;                   // the hash of the definition last stored to sqlite (0 = never)
+
     // ------------------------------------------------------------------------
     // operational state members
 
@@ -322,11 +346,22 @@ struct rrddim {
         } sender;
     } rrdpush;
 
+    // ------------------------------------------------------------------------
+    // prometheus exposition cache (maintained by the prometheus exporter)
+
+    struct {
+        uint32_t version;                           // the rrdset version the names were made for
+        bool names;                                 // made from the name (true) or the id (false)
+        STRING *label;                              // the dimension, sanitized as a label value
+        STRING *metric;                             // the dimension, sanitized as a metric name
+    } prometheus;
+
     // ------------------------------------------------------------------------
     // data collection members
 
     struct {
         RRDDIM_OPTIONS options;                         // permanent configuration options
+        RRDDIM_BACKFILL backfill;                       // the backfilling of the higher tiers, accessed atomically
 
         uint32_t counter;                               // the number of times we added values to this rrddim
 
@@ -594,6 +629,18 @@ static inline STORAGE_POINT storage_engine_query_next_metric(struct storage_engi
     return rrddim_query_next_metric(seqh);
 }
 
+size_t rrdeng_load_metric_next_batch(struct storage_engine_query_handle *seqh, STORAGE_POINT *sps, size_t max);
+size_t rrddim_query_next_metric_batch(struct storage_engine_query_handle *seqh, STORAGE_POINT *sps, size_t max);
+static inline size_t storage_engine_query_next_metric_batch(struct storage_engine_query_handle *seqh, STORAGE_POINT *sps, size_t max) {
+    internal_fatal(!is_valid_backend(seqh->seb), "STORAGE: invalid backend");
+
+#ifdef ENABLE_DBENGINE
+    if(likely(seqh->seb == STORAGE_ENGINE_BACKEND_DBENGINE))
+        return rrdeng_load_metric_next_batch(seqh, sps, max);
+#endif
+    return rrddim_query_next_metric_batch(seqh, sps, max);
+}
+
 int rrdeng_load_metric_is_finished(struct storage_engine_query_handle *seqh);
 int rrddim_query_is_finished(struct storage_engine_query_handle *seqh);
 static inline int storage_engine_query_is_finished(struct storage_engine_query_handle *seqh) {
@@ -619,6 +666,20 @@ static inline void storage_engine_query_finalize(struct storage_engine_query_han
         rrddim_query_finalize(seqh);
 }
 
+void rrdeng_load_metric_prefetch(STORAGE_METRIC_HANDLE *smh, time_t start_time_s, time_t end_time_s, usec_t timeout_ut);
+static inline void storage_engine_query_prefetch(
+        STORAGE_ENGINE_BACKEND seb __maybe_unused,
+        STORAGE_METRIC_HANDLE *smh __maybe_unused,
+        time_t start_time_s __maybe_unused, time_t end_time_s __maybe_unused, usec_t timeout_ut __maybe_unused) {
+    internal_fatal(!is_valid_backend(seb), "STORAGE: invalid backend");
+
+#ifdef ENABLE_DBENGINE
+    // only dbengine reads from disk - the other backends have nothing to prefetch
+    if(likely(seb == STORAGE_ENGINE_BACKEND_DBENGINE))
+        rrdeng_load_metric_prefetch(smh, start_time_s, end_time_s, timeout_ut);
+#endif
+}
+
 time_t rrdeng_load_align_to_optimal_before(struct storage_engine_query_handle *seqh);
 time_t rrddim_query_align_to_optimal_before(struct storage_engine_query_handle *seqh);
 static inline time_t storage_engine_align_to_optimal_before(struct storage_engine_query_handle *seqh) {
@@ -778,6 +839,8 @@ struct rrdset {
 
     uint32_t counter;                               // the number of times we added values to this database
     uint32_t counter_done;                          // the number of times rrdset_done() has been called
+    bool backfill_pending;                          // dimensions have been queued for backfilling, the job is not submitted yet
+    struct rrdset_live *live;                       // the live data subscribers of this chart, allocated on the first one
 
     time_t last_accessed_time_s;                    // the last time this RRDSET has been accessed
     usec_t usec_since_last_update;                  // the time in microseconds since the last collection of data
@@ -786,6 +849,7 @@ struct rrdset {
     struct timeval last_collected_time;             // when did this data set last collected values
 
     size_t rrdlabels_last_saved_version;
+    uint32_t metadata_last_saved_version;           // the metadata version last stored to sqlite
 
     DICTIONARY *functions_view;                     // collector functions this rrdset supports, can be NULL
 
@@ -799,7 +863,12 @@ struct rrdset {
             uint32_t dim_last_slot_used;
 
             time_t resync_time_s;                   // the timestamp up to which we should resync clock upstream
+            uint64_t definition_digest;             // the digest of the chart definition last sent upstream
         } sender;
+
+        struct {
+            uint64_t definition_digest;             // the digest of the chart definition received from the child
+        } receiver;
     } rrdpush;
 
     // ------------------------------------------------------------------------
@@ -820,6 +889,16 @@ struct rrdset {
 
     RRDSET_FLAGS *exporting_flags;                  // array of flags for exporting connector instances
 
+    struct {
+        uint32_t version;                           // the rrdset version the names were made for
+        size_t labels_version;                      // the rrdlabels version the labels were formatted for
+        bool names;                                 // made from the name (true) or the id (false)
+        STRING *chart;                              // the chart, sanitized as a label value
+        STRING *family;                             // the family, sanitized as a label value
+        STRING *context;                            // the context, sanitized as a metric name
+        STRING *labels;                             // the chart labels, formatted as ,key="value",...
+    } prometheus;
+
     // ------------------------------------------------------------------------
     // health monitoring members
     // TODO - they should be managed by health
@@ -1103,6 +1182,7 @@ typedef struct alarm_log {
 
 typedef struct health {
     time_t health_delay_up_to;                     // a timestamp to delay alarms processing up to
+    time_t next_run;                               // when the health threads have to examine the alerts of this host again
     STRING *health_default_exec;                   // the full path of the alarms notifications program
     STRING *health_default_recipient;              // the default recipient for all alarms
     unsigned int health_enabled;                   // 1 when this host has health enabled
@@ -1304,6 +1384,10 @@ struct rrdhost {
         DICTIONARY *pp_queue;
         uint32_t metrics;
         uint32_t instances;
+        size_t contexts_version;                    // the version of contexts, when metrics and instances were counted
+        uint64_t api_version;                       // the last change of its contexts, for the delta responses of the API
+        time_t snapshot_next_s;                     // the next time the snapshot of the contexts will be saved
+        bool snapshot_loaded;                       // the contexts are loaded from the snapshot, SQL not loaded yet
     } rrdctx;
 
     struct {
@@ -1312,6 +1396,8 @@ struct rrdhost {
         time_t last_time_s;
     } retention;
 
+    uint32_t backfill_jobs;                         // the backfill jobs of its charts, queued or running
+
     ND_UUID host_id;                                // Global GUID for this host
     ND_UUID node_id;                                // Cloud node_id
 
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrd.h"
+
+// ----------------------------------------------------------------------------
+// backfilling the higher tiers of the dimensions from their lower tiers
+//
+// When a dimension starts being collected, its higher tiers may have a gap
+// (e.g. after an outage) that can be filled from its lower tiers. On parents
+// this happens for millions of dimensions at once, when the children reconnect,
+// so the collectors do not fill the gaps themselves: they mark the dimensions
+// as queued and, when the chart iteration completes, they submit one job per
+// chart to the executor, at low priority.
+//
+// The job fills the dimensions of the chart in batches. The queries of a batch
+// are started together, before any of them is consumed, so that dbengine loads
+// the extents the dimensions of the chart share only once, for all of them.
+//
+// While a dimension is being backfilled, the collector stores only its tier 0.
+// When the job is done, the collector fills the few points skipped in the
+// meantime (they are still in the cache) and resumes storing all its tiers.
+
+size_t rrd_backfill_jobs = 2;   // the max concurrent backfill jobs, 0 = backfill synchronously
+
+#define BACKFILL_BATCH_DIMENSIONS 64
+#define BACKFILL_BATCH_POINTS 32
+
+void store_metric_at_tier(RRDDIM *rd, size_t tier, struct rrddim_tier *t, STORAGE_POINT sp, usec_t now_ut);
+
+static ND_EXECUTOR_SUBSYSTEM *backfill_ss = NULL;
+
+struct backfill_dimension {
+    RRDDIM_ACQUIRED *rda;
+    RRDDIM *rd;
+    time_t latest_time_s;               // the last point of the tier being filled
+    bool fill;                          // the tier being filled has a gap
+    bool query;                         // the lower tier being read has data for the gap
+    struct storage_engine_query_handle seqh;
+};
+
+struct backfill_job {
+    RRDHOST *host;
+    RRDSET_ACQUIRED *rsa;
+    struct backfill_dimension dims[BACKFILL_BATCH_DIMENSIONS];
+};
+
+void rrd_backfill_init(void) {
+#ifdef ENABLE_DBENGINE
+    if(!rrd_backfill_jobs || storage_tiers < 2 || default_backfill == RRD_BACKFILL_NONE)
+        return;
+
+    backfill_ss = nd_executor_subsystem_create("backfill", ND_EXECUTOR_PRIORITY_LOW, rrd_backfill_jobs);
+#endif
+}
+
+static inline bool backfill_host_gone(RRDHOST *host) {
+    return netdata_exit || rrdhost_flag_check(host, RRDHOST_FLAG_ORPHAN | RRDHOST_FLAG_ARCHIVED);
+}
+
+static void backfill_tier_of_dimensions(struct backfill_dimension *dims, size_t used, size_t tier, time_t now_s) {
+    size_t to_fill = 0;
+
+    for(size_t i = 0; i < used ; i++) {
+        struct backfill_dimension *d = &dims[i];
+        struct rrddim_tier *t = &d->rd->tiers[tier];
+        d->fill = false;
+
+        if(unlikely(!t->smh || !t->sch))
+            continue;
+
+        d->latest_time_s = storage_engine_latest_time_s(t->seb, t->smh);
+        time_t granularity = (time_t)t->tier_grouping * (time_t)d->rd->rrdset->update_every;
+
+#ifdef ENABLE_DBENGINE
+        // if the user wants only NEW backfilling, and we don't have any data
+        if(default_backfill == RRD_BACKFILL_NEW && d->latest_time_s <= 0)
+            continue;
+#endif
+
+        // there is really nothing we can do
+        if(now_s <= d->latest_time_s || now_s - d->latest_time_s < granularity)
+            continue;
+
+        d->fill = true;
+        to_fill++;
+    }
+
+    // for each lower tier
+    for(int read_tier = (int)tier - 1; to_fill && read_tier >= 0 ; read_tier--) {
+
+        // start the queries of all the dimensions, so that their extents are loaded together
+        for(size_t i = 0; i < used ; i++) {
+            struct backfill_dimension *d = &dims[i];
+            d->query = false;
+
+            if(!d->fill)
+                continue;
+
+            struct rrddim_tier *tmp = &d->rd->tiers[read_tier];
+            if(unlikely(!tmp->smh))
+                continue;
+
+            time_t smaller_tier_first_time = storage_engine_oldest_time_s(tmp->seb, tmp->smh);
+            time_t smaller_tier_last_time = storage_engine_latest_time_s(tmp->seb, tmp->smh);
+            if(smaller_tier_last_time <= d->latest_time_s) continue;  // it is as bad as we are
+
+            time_t after_wanted = (d->latest_time_s < smaller_tier_first_time) ? smaller_tier_first_time : d->latest_time_s;
+            time_t before_wanted = smaller_tier_last_time;
+
+            storage_engine_query_init(tmp->seb, tmp->smh, &d->seqh, after_wanted, before_wanted, STORAGE_PRIORITY_LOW);
+            d->query = true;
+        }
+
+        // consume them, one by one
+        for(size_t i = 0; i < used ; i++) {
+            struct backfill_dimension *d = &dims[i];
+            if(!d->query)
+                continue;
+
+            struct rrddim_tier *t = &d->rd->tiers[tier];
+            size_t points_read = 0;
+            STORAGE_POINT sps[BACKFILL_BATCH_POINTS];
+
+            while(!storage_engine_query_is_finished(&d->seqh)) {
+                size_t points = storage_engine_query_next_metric_batch(&d->seqh, sps, BACKFILL_BATCH_POINTS);
+                if(unlikely(!points))
+                    break;
+
+                points_read += points;
+
+                // the collection of the dimension may be finalized while we fill it
+                spinlock_lock(&t->spinlock);
+                if(likely(t->sch)) {
+                    for(size_t p = 0; p < points; p++) {
+                        if(sps[p].end_time_s > d->latest_time_s) {
+                            d->latest_time_s = sps[p].end_time_s;
+                            store_metric_at_tier(d->rd, tier, t, sps[p], sps[p].end_time_s * USEC_PER_SEC);
+                        }
+                    }
+                }
+                spinlock_unlock(&t->spinlock);
+            }
+
+            storage_engine_query_finalize(&d->seqh);
+            d->query = false;
+
+            store_metric_collection_completed();
+            global_statistics_backfill_query_completed(points_read);
+        }
+    }
+}
+
+static void backfill_dimensions(struct backfill_job *job, size_t used) {
+    time_t now_s = now_realtime_sec();
+
+    // the tiers are filled in order, so that each one can be filled from the one just below it
+    for(size_t tier = 1; tier < storage_tiers && !backfill_host_gone(job->host) ; tier++)
+        backfill_tier_of_dimensions(job->dims, used, tier, now_s);
+
+    for(size_t i = 0; i < used ; i++) {
+        // the collector fills the points it has skipped while we were running
+        __atomic_store_n(&job->dims[i].rd->collector.backfill, RRDDIM_BACKFILL_DONE, __ATOMIC_RELEASE);
+        rrddim_acquired_release(job->dims[i].rda);
+        job->dims[i].rda = NULL;
+        job->dims[i].rd = NULL;
+    }
+}
+
+static void backfill_job_cb(void *data) {
+    struct backfill_job *job = data;
+    RRDSET *st = rrdset_acquired_to_rrdset(job->rsa);
+    size_t used = 0;
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st) {
+        RRDDIM_BACKFILL expected = RRDDIM_BACKFILL_QUEUED;
+
+        if(backfill_host_gone(job->host)) {
+            // the collector will queue it again, if it comes back
+            __atomic_compare_exchange_n(&rd->collector.backfill, &expected, RRDDIM_BACKFILL_NONE,
+                                        false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        // another job of the same chart may have picked it already
+        if(!__atomic_compare_exchange_n(&rd->collector.backfill, &expected, RRDDIM_BACKFILL_RUNNING,
+                                        false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            continue;
+
+        job->dims[used].rda = (RRDDIM_ACQUIRED *)dictionary_acquired_item_dup(st->rrddim_root_index, rd_dfe.item);
+        job->dims[used].rd = rd;
+        used++;
+
+        if(used == BACKFILL_BATCH_DIMENSIONS) {
+            backfill_dimensions(job, used);
+            used = 0;
+        }
+    }
+    rrddim_foreach_done(rd);
+
+    if(used)
+        backfill_dimensions(job, used);
+
+    RRDHOST *host = job->host;
+    rrdset_acquired_release(job->rsa);
+    freez(job);
+
+    __atomic_sub_fetch(&host->backfill_jobs, 1, __ATOMIC_RELEASE);
+}
+
+// called by the collector, when a dimension has not stored its higher tiers yet
+// returns true when the collector can store the higher tiers of the dimension
+bool rrddim_backfill_higher_tiers(RRDDIM *rd, time_t now_s) {
+    switch(__atomic_load_n(&rd->collector.backfill, __ATOMIC_ACQUIRE)) {
+        case RRDDIM_BACKFILL_NONE:
+            if(backfill_ss && rd->rrd_memory_mode == RRD_MEMORY_MODE_DBENGINE) {
+                __atomic_store_n(&rd->collector.backfill, RRDDIM_BACKFILL_QUEUED, __ATOMIC_RELAXED);
+                rd->rrdset->backfill_pending = true;
+                return false;
+            }
+            break;
+
+        case RRDDIM_BACKFILL_QUEUED:
+        case RRDDIM_BACKFILL_RUNNING:
+            return false;
+
+        default:
+        case RRDDIM_BACKFILL_DONE:
+            break;
+    }
+
+    // fill synchronously what is missing - after a backfill job, only the last few points
+    for(size_t tier = 1; tier < storage_tiers ; tier++)
+        rrdr_fill_tier_gap_from_smaller_tiers(rd, tier, now_s);
+
+    rrddim_option_set(rd, RRDDIM_OPTION_BACKFILLED_HIGH_TIERS);
+    return true;
+}
+
+// called by the collector, when the iteration of a chart that has queued dimensions completes
+void rrdset_backfill_submit(RRDSET *st) {
+    st->backfill_pending = false;
+
+    RRDSET_ACQUIRED *rsa = rrdset_find_and_acquire(st->rrdhost, rrdset_id(st));
+    if(unlikely(!rsa))
+        return;
+
+    struct backfill_job *job = callocz(1, sizeof(*job));
+    job->host = st->rrdhost;
+    job->rsa = rsa;
+
+    __atomic_add_fetch(&st->rrdhost->backfill_jobs, 1, __ATOMIC_RELAXED);
+    nd_executor_submit(backfill_ss, backfill_job_cb, job);
+}
+
+// the host is going to be freed - its jobs have to finish first
+// (they give up as soon as they see it orphan or archived)
+void rrdhost_backfill_wait(RRDHOST *host) {
+    // at exit the executor stops, and the jobs still queued never run
+    while(__atomic_load_n(&host->backfill_jobs, __ATOMIC_ACQUIRE) && !netdata_exit)
+        sleep_usec(10 * USEC_PER_MS);
+}
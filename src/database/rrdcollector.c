@@ -94,6 +94,19 @@ void rrd_collector_finished(void) {
     thread_rrd_collector = NULL;
 }
 
+// threads serving many collectors (e.g. the streaming receivers pool)
+// switch to the collector of each of them before working on it.
+// It returns the collector the thread had before.
+struct rrd_collector *rrd_collector_switch(struct rrd_collector *rdc) {
+    struct rrd_collector *old = thread_rrd_collector;
+    thread_rrd_collector = rdc;
+
+    if(rdc)
+        rdc->tid = gettid_cached();
+
+    return old;
+}
+
 bool rrd_collector_acquire(struct rrd_collector *rdc) {
 
     int32_t expected = __atomic_load_n(&rdc->refcount, __ATOMIC_RELAXED), wanted = 0;
@@ -11,4 +11,7 @@
 void rrd_collector_started(void);
 void rrd_collector_finished(void);
 
+struct rrd_collector;
+struct rrd_collector *rrd_collector_switch(struct rrd_collector *rdc);
+
 #endif //NETDATA_RRDCOLLECTOR_H
@@ -35,6 +35,22 @@ static void *rrddim_alloc_db(size_t entries) {
     return callocz(entries, sizeof(storage_number));
 }
 
+static inline bool rrddim_tier_excludes_context(size_t tier, RRDSET *st) {
+    SIMPLE_PATTERN *exclude = storage_tiers_exclude_contexts[tier];
+    return tier && exclude && simple_pattern_matches_string(exclude, st->context);
+}
+
+static inline void rrddim_store_init_tier0_page_type(RRDDIM *rd) {
+#ifdef ENABLE_DBENGINE
+    SIMPLE_PATTERN *contexts = tier0_double_precision_contexts;
+    if(contexts && rd->tiers[0].sch && rd->tiers[0].seb == STORAGE_ENGINE_BACKEND_DBENGINE &&
+        simple_pattern_matches_string(contexts, rd->rrdset->context))
+        rrdeng_store_metric_change_page_type(rd->tiers[0].sch, RRDENG_PAGE_TYPE_GORILLA_64BIT);
+#else
+    UNUSED(rd);
+#endif
+}
+
 static void rrddim_insert_callback(const DICTIONARY_ITEM *item __maybe_unused, void *rrddim, void *constructor_data) {
     struct rrddim_constructor *ctr = constructor_data;
     RRDDIM *rd = rrddim;
@@ -94,9 +110,16 @@ static void rrddim_insert_callback(const DICTIONARY_ITEM *item __maybe_unused, v
             STORAGE_ENGINE *eng = host->db[tier].eng;
             rd->tiers[tier].seb = eng->seb;
             rd->tiers[tier].tier_grouping = host->db[tier].tier_grouping;
-            rd->tiers[tier].smh = eng->api.metric_get_or_create(rd, host->db[tier].si);
             spinlock_init(&rd->tiers[tier].spinlock);
             storage_point_unset(rd->tiers[tier].virtual_point);
+
+            if(unlikely(rrddim_tier_excludes_context(tier, st))) {
+                // this tier does not store this context
+                rd->tiers[tier].smh = NULL;
+                continue;
+            }
+
+            rd->tiers[tier].smh = eng->api.metric_get_or_create(rd, host->db[tier].si);
             initialized++;
 
             // internal_error(true, "TIER GROUPING of chart '%s', dimension '%s' for tier %d is set to %d", rd->rrdset->name, rd->name, tier, rd->tiers[tier]->tier_grouping);
@@ -122,6 +145,8 @@ static void rrddim_insert_callback(const DICTIONARY_ITEM *item __maybe_unused, v
 
         if(!initialized)
             netdata_log_error("Failed to initialize data collection for all db tiers for chart '%s', dimension '%s", rrdset_name(st), rrddim_name(rd));
+
+        rrddim_store_init_tier0_page_type(rd);
     }
 
     if(rrdset_number_of_dimensions(st) != 0) {
@@ -233,6 +258,8 @@ static void rrddim_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, v
 
     string_freez(rd->id);
     string_freez(rd->name);
+    string_freez(rd->prometheus.label);
+    string_freez(rd->prometheus.metric);
 }
 
 static bool rrddim_conflict_callback(const DICTIONARY_ITEM *item __maybe_unused, void *rrddim, void *new_rrddim, void *constructor_data) {
@@ -250,9 +277,13 @@ static bool rrddim_conflict_callback(const DICTIONARY_ITEM *item __maybe_unused,
     rc += rrddim_set_divisor(st, rd, ctr->divisor);
 
     for(size_t tier = 0; tier < storage_tiers ;tier++) {
-        if (!rd->tiers[tier].sch)
+        if (!rd->tiers[tier].sch && rd->tiers[tier].smh) {
             rd->tiers[tier].sch =
                     storage_metric_store_init(rd->tiers[tier].seb, rd->tiers[tier].smh, st->rrdhost->db[tier].tier_grouping * st->update_every, rd->rrdset->smg[tier]);
+
+            if(!tier)
+                rrddim_store_init_tier0_page_type(rd);
+        }
     }
 
     if(rrddim_flag_check(rd, RRDDIM_FLAG_ARCHIVED))
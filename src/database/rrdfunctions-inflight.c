@@ -40,6 +40,13 @@ struct rrd_function_inflight {
         void *data;
     } result;
 
+    struct {
+        // in async mode,
+        // the function to call to forward partial results
+        rrd_function_result_callback_t cb;
+        void *data;
+    } partial;
+
     struct {
         // to be called in sync mode
         // while the function is running
@@ -208,6 +215,10 @@ static inline int rrd_call_function_async_and_dont_wait(struct rrd_function_infl
             .cb = rrd_inflight_async_function_nowait_finished,
             .data = r,
         },
+        .partial = {
+            .cb = r->partial.cb,
+            .data = r->partial.data,
+        },
         .progress = {
             .cb = r->progress.cb,
             .data = r->progress.data,
@@ -262,6 +273,8 @@ static int rrd_call_function_async_and_wait(struct rrd_function_inflight *r) {
             .cb = rrd_async_function_signal_when_ready,
             .data = tmp,
         },
+        // no partial results here, we accumulate them into temp_wb,
+        // because the caller may give up waiting and vanish
         .progress = {
             .cb = r->progress.cb,
             .data = r->progress.data,
@@ -396,6 +409,7 @@ int rrd_function_run(RRDHOST *host, BUFFER *result_wb, int timeout_s,
                      HTTP_ACCESS user_access, const char *cmd,
                      bool wait, const char *transaction,
                      rrd_function_result_callback_t result_cb, void *result_cb_data,
+                     rrd_function_result_callback_t partial_cb, void *partial_cb_data,
                      rrd_function_progress_cb_t progress_cb, void *progress_cb_data,
                      rrd_function_is_cancelled_cb_t is_cancelled_cb, void *is_cancelled_cb_data,
                      BUFFER *payload, const char *source, bool hidden) {
@@ -529,6 +543,10 @@ int rrd_function_run(RRDHOST *host, BUFFER *result_wb, int timeout_s,
             .cb = result_cb,
             .data = result_cb_data,
         },
+        .partial = {
+            .cb = partial_cb,
+            .data = partial_cb_data,
+        },
         .is_cancelled = {
             .cb = is_cancelled_cb,
             .data = is_cancelled_cb_data,
@@ -35,6 +35,14 @@ struct rrd_function_execute {
         void *data;
     } result;
 
+    struct {
+        // when set, partial results are given to this callback as they arrive,
+        // instead of being accumulated into result.wb - the final result.cb
+        // gets only what is left after the last partial result
+        rrd_function_result_callback_t cb;
+        void *data;
+    } partial;
+
     struct {
         rrd_function_progress_cb_t cb;
         void *data;
@@ -78,6 +86,7 @@ int rrd_function_run(RRDHOST *host, BUFFER *result_wb, int timeout_s,
                      HTTP_ACCESS user_access, const char *cmd,
                      bool wait, const char *transaction,
                      rrd_function_result_callback_t result_cb, void *result_cb_data,
+                     rrd_function_result_callback_t partial_cb, void *partial_cb_data,
                      rrd_function_progress_cb_t progress_cb, void *progress_cb_data,
                      rrd_function_is_cancelled_cb_t is_cancelled_cb, void *is_cancelled_cb_data,
                      BUFFER *payload, const char *source, bool hidden);
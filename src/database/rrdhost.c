@@ -3,6 +3,10 @@
 #define NETDATA_RRD_INTERNALS
 #include "rrd.h"
 
+#ifdef ENABLE_DBENGINE
+#include "engine/dbengine-archive.h"
+#endif
+
 #if RRD_STORAGE_TIERS != 5
 #error RRD_STORAGE_TIERS is not 5 - you need to update the grouping iterations per tier
 #endif
@@ -12,9 +16,11 @@ static void rrdhost_streaming_sender_structures_init(RRDHOST *host);
 bool dbengine_enabled = false; // will become true if and when dbengine is initialized
 size_t storage_tiers = 3;
 bool use_direct_io = true;
+bool dbengine_use_huge_pages = false;
 size_t storage_tiers_grouping_iterations[RRD_STORAGE_TIERS] = {1, 60, 60, 60, 60};
 size_t storage_tiers_collection_per_sec[RRD_STORAGE_TIERS] = {1, 60, 3600, 8 * 3600, 24 * 3600};
 double storage_tiers_retention_days[RRD_STORAGE_TIERS] = {14, 90, 2 * 365, 2 * 365, 2 * 365};
+SIMPLE_PATTERN *storage_tiers_exclude_contexts[RRD_STORAGE_TIERS] = { 0 };
 
 size_t get_tier_grouping(size_t tier) {
     if(unlikely(tier >= storage_tiers)) tier = storage_tiers - 1;
@@ -297,6 +303,7 @@ static RRDHOST *prepare_host_for_unittest(RRDHOST *host)
             ret = rrdeng_init(
                 (struct rrdengine_instance **)&host->db[0].si,
                 dbenginepath,
+                NULL,
                 default_rrdeng_disk_quota_mb,
                 0,
                 0); // may fail here for legacy dbengine initialization
@@ -545,8 +552,11 @@ static RRDHOST *rrdhost_create(
         rrdhost_load_rrdcontext_data(host);
 //        rrdhost_flag_set(host, RRDHOST_FLAG_METADATA_INFO | RRDHOST_FLAG_METADATA_UPDATE);
         ml_host_new(host);
-    } else
+    } else {
+        // make its contexts queryable until they are loaded from SQL
+        rrdhost_load_rrdcontext_snapshot(host);
         rrdhost_flag_set(host, RRDHOST_FLAG_PENDING_CONTEXT_LOAD | RRDHOST_FLAG_ARCHIVED | RRDHOST_FLAG_ORPHAN);
+    }
 
     return host;
 }
@@ -812,6 +822,7 @@ inline int rrdhost_should_be_removed(RRDHOST *host, RRDHOST *protected_host, tim
 struct dbengine_initialization {
     ND_THREAD *thread;
     char path[FILENAME_MAX + 1];
+    const char *stripes;
     int disk_space_mb;
     size_t retention_seconds;
     size_t tier;
@@ -833,10 +844,20 @@ typedef struct rrd_alert_prototype {
 
 void *dbengine_tier_init(void *ptr) {
     struct dbengine_initialization *dbi = ptr;
-    dbi->ret = rrdeng_init(NULL, dbi->path, dbi->disk_space_mb, dbi->tier, dbi->retention_seconds);
+    dbi->ret = rrdeng_init(NULL, dbi->path, dbi->stripes, dbi->disk_space_mb, dbi->tier, dbi->retention_seconds);
     return ptr;
 }
 
+static void *dbengine_tiers_readiness_wait(void *ptr __maybe_unused) {
+    for(size_t tier = 1; tier < storage_tiers ;tier++)
+        rrdeng_readiness_wait(multidb_ctx[tier]);
+
+    // let the contexts pick up the retention of the higher tiers
+    rrdcontext_db_rotation();
+
+    return NULL;
+}
+
 RRD_BACKFILL get_dbengine_backfill(RRD_BACKFILL backfill)
 {
     const char *bf = config_get(
@@ -866,6 +887,7 @@ static void dbengine_init(const char *hostname) {
 #ifdef ENABLE_DBENGINE
 
     use_direct_io = config_get_boolean(CONFIG_SECTION_DB, "dbengine use direct io", use_direct_io);
+    dbengine_use_huge_pages = config_get_boolean(CONFIG_SECTION_DB, "dbengine use huge pages", dbengine_use_huge_pages);
 
     unsigned read_num = (unsigned)config_get_number(CONFIG_SECTION_DB, "dbengine pages per extent", DEFAULT_PAGES_PER_EXTENT);
     if (read_num > 0 && read_num <= DEFAULT_PAGES_PER_EXTENT)
@@ -906,6 +928,7 @@ static void dbengine_init(const char *hostname) {
          !config_exists(CONFIG_SECTION_DB, "dbengine tier 4 retention size"));
 
     default_backfill = get_dbengine_backfill(RRD_BACKFILL_NEW);
+    rrd_backfill_jobs = (size_t)config_get_number(CONFIG_SECTION_DB, "dbengine tier backfill jobs", (long long)rrd_backfill_jobs);
     char dbengineconfig[200 + 1];
 
     size_t grouping_iterations = default_rrd_update_every;
@@ -966,6 +989,21 @@ static void dbengine_init(const char *hostname) {
         storage_tiers_retention_days[tier] = config_get_duration_days(
             CONFIG_SECTION_DB, dbengineconfig, new_dbengine_defaults ? storage_tiers_retention_days[tier] : 0);
 
+        snprintfz(dbengineconfig, sizeof(dbengineconfig) - 1, "dbengine tier %zu stripe directories", tier);
+        tiers_init[tier].stripes = config_get(CONFIG_SECTION_DB, dbengineconfig, "");
+
+        snprintfz(dbengineconfig, sizeof(dbengineconfig) - 1, "dbengine tier %zu archive", tier);
+        dbengine_archive_tier[tier] = config_get_boolean(CONFIG_SECTION_DB, dbengineconfig, CONFIG_BOOLEAN_NO);
+
+        if(tier) {
+            // high churn metrics (e.g. of short lived containers) can be kept only in the lower tiers,
+            // leaving the disk space of the higher tiers to the metrics that need long history
+            snprintfz(dbengineconfig, sizeof(dbengineconfig) - 1, "dbengine tier %zu exclude contexts", tier);
+            const char *exclude = config_get(CONFIG_SECTION_DB, dbengineconfig, "");
+            if(exclude && *exclude)
+                storage_tiers_exclude_contexts[tier] = simple_pattern_create(exclude, NULL, SIMPLE_PATTERN_EXACT, true);
+        }
+
         tiers_init[tier].disk_space_mb = (int) disk_space_mb;
         tiers_init[tier].tier = tier;
         tiers_init[tier].retention_seconds = (size_t) (86400.0 * storage_tiers_retention_days[tier]);
@@ -1004,8 +1042,13 @@ static void dbengine_init(const char *hostname) {
     else if(!created_tiers)
         fatal("DBENGINE on '%s', failed to initialize databases at '%s'.", hostname, netdata_configured_cache_dir);
 
-    for(size_t tier = 0; tier < storage_tiers ;tier++)
-        rrdeng_readiness_wait(multidb_ctx[tier]);
+    rrd_backfill_init();
+
+    // tier 0 is needed for data collection and queries right away,
+    // the higher tiers may finish populating their metrics in the background
+    rrdeng_readiness_wait(multidb_ctx[0]);
+    if(storage_tiers > 1)
+        nd_thread_create("DBENGREADY", NETDATA_THREAD_OPTION_DEFAULT, dbengine_tiers_readiness_wait, NULL);
 
     calculate_tier_disk_space_percentage();
 
@@ -1026,9 +1069,18 @@ static void dbengine_init(const char *hostname) {
 
 void api_v1_management_init(void);
 
-int rrd_init(const char *hostname, struct rrdhost_system_info *system_info, bool unittest) {
-    rrdhost_init();
+// ----------------------------------------------------------------------------
+// the stages of rrd_init() that do not depend on each other run in parallel:
+// SQLite and health configuration loading, while dbengine initializes its tiers
 
+struct rrd_init_stage {
+    const char *name;
+    ND_THREAD *thread;
+    void (*cb)(struct rrdhost_system_info *system_info);
+    struct rrdhost_system_info *system_info;
+};
+
+static void rrd_init_sqlite(struct rrdhost_system_info *system_info) {
     if (unlikely(sql_init_meta_database(DB_CHECK_NONE, system_info ? 0 : 1))) {
         if (default_rrd_memory_mode == RRD_MEMORY_MODE_DBENGINE) {
             set_late_analytics_variables(system_info);
@@ -1042,11 +1094,67 @@ int rrd_init(const char *hostname, struct rrdhost_system_info *system_info, bool
     if (unlikely(sql_init_context_database(system_info ? 0 : 1))) {
         error_report("Failed to initialize context metadata database");
     }
+}
+
+static void rrd_init_health(struct rrdhost_system_info *system_info __maybe_unused) {
+    health_plugin_load();
+}
+
+static void *rrd_init_stage_run(void *ptr) {
+    struct rrd_init_stage *stage = ptr;
+
+    usec_t started_ut = now_monotonic_usec();
+    stage->cb(stage->system_info);
+
+    nd_log(NDLS_DAEMON, NDLP_INFO,
+           "NETDATA STARTUP: in %7llu ms, %s (in parallel)",
+           (unsigned long long)((now_monotonic_usec() - started_ut) / USEC_PER_MS), stage->name);
+
+    return NULL;
+}
+
+static void rrd_init_stage_start(struct rrd_init_stage *stage, const char *tag) {
+#ifdef OS_WINDOWS
+    // like in dbengine_init(), joining the initialization threads fails on Windows
+    (void)tag;
+    rrd_init_stage_run(stage);
+#else
+    stage->thread = nd_thread_create(tag, NETDATA_THREAD_OPTION_JOINABLE, rrd_init_stage_run, stage);
+    if(!stage->thread)
+        rrd_init_stage_run(stage);
+#endif
+}
+
+static void rrd_init_stage_wait(struct rrd_init_stage *stage) {
+    if(stage->thread) {
+        nd_thread_join(stage->thread);
+        stage->thread = NULL;
+    }
+}
+
+int rrd_init(const char *hostname, struct rrdhost_system_info *system_info, bool unittest) {
+    rrdhost_init();
+
+    struct rrd_init_stage sqlite_stage = {
+        .name = "initialize SQLite",
+        .cb = rrd_init_sqlite,
+        .system_info = system_info,
+    };
+
+    struct rrd_init_stage health_stage = {
+        .name = "load health configuration",
+        .cb = rrd_init_health,
+        .system_info = system_info,
+    };
 
     if (unlikely(unittest)) {
+        rrd_init_sqlite(system_info);
         dbengine_enabled = true;
     }
     else {
+        rrd_init_stage_start(&sqlite_stage, "INIT[SQLITE]");
+        rrd_init_stage_start(&health_stage, "INIT[HEALTH]");
+
         rrdpush_init();
 
         if (default_rrd_memory_mode == RRD_MEMORY_MODE_DBENGINE || rrdpush_receiver_needs_dbengine()) {
@@ -1077,6 +1185,10 @@ int rrd_init(const char *hostname, struct rrdhost_system_info *system_info, bool
         }
     }
 
+    // metadata sync needs SQLite, and localhost needs the health configuration
+    rrd_init_stage_wait(&sqlite_stage);
+    rrd_init_stage_wait(&health_stage);
+
     if(!unittest)
         metadata_sync_init();
 
@@ -1187,6 +1299,9 @@ static void rrdhost_streaming_sender_structures_init(RRDHOST *host)
     if(!default_rrdpush_compression_enabled)
         host->sender->disabled_capabilities |= STREAM_CAP_COMPRESSIONS_AVAILABLE;
 
+    if(!default_rrdpush_compression_dictionary)
+        host->sender->disabled_capabilities |= STREAM_CAP_DICTIONARY;
+
     spinlock_init(&host->sender->spinlock);
     replication_init_sender(host->sender);
 }
@@ -1254,6 +1369,9 @@ void rrdhost_free___while_having_rrd_wrlock(RRDHOST *host, bool force) {
 
     rrdcalc_delete_all(host);
 
+    // the backfill jobs of its charts have to finish first
+    rrdhost_backfill_wait(host);
+
     // delete all the RRDSETs of the host
     rrdset_index_destroy(host);
     rrdcalc_rrdhost_index_destroy(host);
@@ -1739,6 +1857,7 @@ void rrdhost_status(RRDHOST *host, time_t now, RRDHOST_STATUS *s) {
         s->ingest.capabilities = host->receiver->capabilities;
         s->ingest.peers = socket_peers(host->receiver->fd);
         s->ingest.ssl = SSL_connection(&host->receiver->ssl);
+        s->ingest.throttled = __atomic_load_n(&host->receiver->admission.throttled, __ATOMIC_RELAXED);
     }
     spinlock_unlock(&host->receiver_lock);
 
@@ -28,21 +28,84 @@ typedef struct labels_registry_idx_entry {
     size_t refcount;
 } RRDLABEL_IDX;
 
+// a query matches all its instances with the same few patterns
+#define RRDLABELS_SET_MATCH_CACHE 4
+
+typedef struct rrdlabels_set_entry {
+    RRDLABEL *label;
+    RRDLABEL_SRC ls;
+} RRDLABELS_SET_ENTRY;
+
+// An interned, immutable set of labels, shared by all RRDLABELS having exactly these labels.
+// The entries are sorted by label (the labels are interned too, so their pointers identify them),
+// which makes the array itself the key of the set in global_label_sets.
+typedef struct rrdlabels_set {
+    size_t refcount;                        // protected by global_label_sets.spinlock
+
+    // the results of the last simple patterns matched against this set
+    struct {
+        SPINLOCK spinlock;
+        uint32_t next;
+        struct {
+            uint64_t pattern_id;
+            char equal;
+            SIMPLE_PATTERN_RESULT result;
+        } cache[RRDLABELS_SET_MATCH_CACHE];
+    } match;
+
+    size_t entries;
+    RRDLABELS_SET_ENTRY array[];
+} RRDLABELS_SET;
+
+struct {
+    Pvoid_t JudyHS;
+    SPINLOCK spinlock;
+} global_label_sets = {
+    .JudyHS = (Pvoid_t) NULL,
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER
+};
+
+// RRDLABELS have either private labels in the JudyL, or a shared set (and an empty JudyL).
+// They get a shared set when they are replaced at once (rrdlabels_migrate_to_these(), rrdlabels_copy()),
+// and get back private labels (copy on write) the next time they are modified.
 typedef struct rrdlabels {
     SPINLOCK spinlock;
     size_t version;
     Pvoid_t JudyL;
+    RRDLABELS_SET *set;
 } RRDLABELS;
 
+static inline bool rrdlabels_next_unsafe(RRDLABELS *labels, size_t *pos, Word_t *index, bool *first_then_next, RRDLABEL **label, RRDLABEL_SRC *ls) {
+    if(labels->set) {
+        if(*pos >= labels->set->entries)
+            return false;
+
+        *label = labels->set->array[*pos].label;
+        *ls = labels->set->array[*pos].ls;
+        (*pos)++;
+        return true;
+    }
+
+    Pvoid_t *PValue = JudyLFirstThenNext(labels->JudyL, index, first_then_next);
+    if(!PValue)
+        return false;
+
+    *label = (RRDLABEL *)*index;
+    *ls = *(RRDLABEL_SRC *)PValue;
+    return true;
+}
+
 #define lfe_start_nolock(label_list, label, ls)                                                                        \
     do {                                                                                                               \
         bool _first_then_next = true;                                                                                  \
-        Pvoid_t *_PValue;                                                                                              \
         Word_t _Index = 0;                                                                                             \
-        while ((_PValue = JudyLFirstThenNext((label_list)->JudyL, &_Index, &_first_then_next))) {                      \
-            (ls) = *(RRDLABEL_SRC *)_PValue;                                                                           \
+        size_t _pos = 0;                                                                                               \
+        RRDLABEL *_label;                                                                                              \
+        RRDLABEL_SRC _ls;                                                                                              \
+        while (rrdlabels_next_unsafe((label_list), &_pos, &_Index, &_first_then_next, &_label, &_ls)) {                \
+            (ls) = _ls;                                                                                                \
             (void)(ls);                                                                                                \
-            (label) = (void *)_Index;
+            (label) = (void *)_label;
 
 #define lfe_done_nolock()                                                                                              \
         }                                                                                                              \
@@ -53,12 +116,14 @@ typedef struct rrdlabels {
     do {                                                                                                               \
         spinlock_lock(&(label_list)->spinlock);                                                                        \
         bool _first_then_next = true;                                                                                  \
-        Pvoid_t *_PValue;                                                                                              \
         Word_t _Index = 0;                                                                                             \
-        while ((_PValue = JudyLFirstThenNext((label_list)->JudyL, &_Index, &_first_then_next))) {                      \
-            (ls) = *(RRDLABEL_SRC *)_PValue;                                                                           \
+        size_t _pos = 0;                                                                                               \
+        RRDLABEL *_label;                                                                                              \
+        RRDLABEL_SRC _ls;                                                                                              \
+        while (rrdlabels_next_unsafe((label_list), &_pos, &_Index, &_first_then_next, &_label, &_ls)) {                \
+            (ls) = _ls;                                                                                                \
             (void)(ls);                                                                                                \
-            (label) = (void *)_Index;
+            (label) = (void *)_label;
 
 #define lfe_done(label_list)                                                                                           \
         }                                                                                                              \
@@ -174,6 +239,113 @@ static void delete_label(RRDLABEL *label)
     spinlock_unlock(&global_labels.spinlock);
 }
 
+// ----------------------------------------------------------------------------
+// shared label sets
+
+static void rrdlabels_set_release(RRDLABELS_SET *set)
+{
+    size_t key_size = set->entries * sizeof(RRDLABELS_SET_ENTRY);
+
+    spinlock_lock(&global_label_sets.spinlock);
+    bool last = (--set->refcount == 0);
+    if (last) {
+        int ret = JudyHSDel(&global_label_sets.JudyHS, (void *)set->array, key_size, PJE0);
+        if (unlikely(ret == JERR))
+            fatal("RRDLABELS: corrupted label sets judyHS array");
+    }
+    spinlock_unlock(&global_label_sets.spinlock);
+
+    if (!last)
+        return;
+
+    // the set holds a reference to each of its labels
+    for (size_t i = 0; i < set->entries; i++)
+        delete_label(set->array[i].label);
+
+    STATS_MINUS_MEMORY(&dictionary_stats_category_rrdlabels, key_size, sizeof(RRDLABELS_SET) + key_size, 0);
+    freez(set);
+}
+
+// replace the private labels with the shared set having the same labels
+static void rrdlabels_share_unsafe(RRDLABELS *labels)
+{
+    if (labels->set || !labels->JudyL)
+        return;
+
+    size_t entries = JudyLCount(labels->JudyL, 0, -1, PJE0);
+    size_t key_size = entries * sizeof(RRDLABELS_SET_ENTRY);
+
+    // zeroed, so that the padding of the entries is the same in all keys
+    RRDLABELS_SET *set = callocz(1, sizeof(RRDLABELS_SET) + key_size);
+    spinlock_init(&set->match.spinlock);
+    set->entries = entries;
+
+    size_t i = 0;
+    Pvoid_t *PValue;
+    Word_t Index = 0;
+    bool first_then_next = true;
+    while ((PValue = JudyLFirstThenNext(labels->JudyL, &Index, &first_then_next)) && i < entries) {
+        set->array[i].label = (RRDLABEL *)Index;
+        set->array[i].ls = *((RRDLABEL_SRC *)PValue);
+        i++;
+    }
+
+    spinlock_lock(&global_label_sets.spinlock);
+
+    PValue = JudyHSIns(&global_label_sets.JudyHS, (void *)set->array, key_size, PJE0);
+    if (unlikely(!PValue || PValue == PJERR))
+        fatal("RRDLABELS: corrupted label sets judyHS array");
+
+    bool existing = (*PValue != NULL);
+    if (existing) {
+        freez(set);
+        set = *PValue;
+    }
+    else {
+        *PValue = set;
+        STATS_PLUS_MEMORY(&dictionary_stats_category_rrdlabels, key_size, sizeof(RRDLABELS_SET) + key_size, 0);
+    }
+    set->refcount++;
+
+    spinlock_unlock(&global_label_sets.spinlock);
+
+    // a new set takes over our references to the labels, an existing one has its own
+    first_then_next = true;
+    Index = 0;
+    while (existing && (PValue = JudyLFirstThenNext(labels->JudyL, &Index, &first_then_next)))
+        delete_label((RRDLABEL *)Index);
+
+    size_t memory_freed = JudyLFreeArray(&labels->JudyL, PJE0);
+    STATS_MINUS_MEMORY(&dictionary_stats_category_rrdlabels, 0, memory_freed, 0);
+
+    labels->set = set;
+}
+
+// copy on write - get private labels from the shared set, to modify them
+static void rrdlabels_make_private_unsafe(RRDLABELS *labels)
+{
+    RRDLABELS_SET *set = labels->set;
+    if (!set)
+        return;
+
+    size_t mem_before_judyl = JudyLMemUsed(labels->JudyL);
+
+    for (size_t i = 0; i < set->entries; i++) {
+        Pvoid_t *PValue = JudyLIns(&labels->JudyL, (Word_t)set->array[i].label, PJE0);
+        if (unlikely(!PValue || PValue == PJERR))
+            fatal("RRDLABELS: corrupted labels JudyL array");
+
+        *((RRDLABEL_SRC *)PValue) = set->array[i].ls;
+        dup_label(set->array[i].label);
+    }
+
+    size_t mem_after_judyl = JudyLMemUsed(labels->JudyL);
+    STATS_PLUS_MEMORY(&dictionary_stats_category_rrdlabels, 0, mem_after_judyl - mem_before_judyl, 0);
+
+    labels->set = NULL;
+    rrdlabels_set_release(set);
+}
+
 // ----------------------------------------------------------------------------
 // rrdlabels_destroy()
 
@@ -184,6 +356,11 @@ void rrdlabels_destroy(RRDLABELS *labels)
 
     spinlock_lock(&labels->spinlock);
 
+    if (labels->set) {
+        rrdlabels_set_release(labels->set);
+        labels->set = NULL;
+    }
+
     Pvoid_t *PValue;
     Word_t Index = 0;
     bool first_then_next = true;
@@ -205,17 +382,16 @@ static RRDLABEL *rrdlabels_find_label_with_key_unsafe(RRDLABELS *labels, RRDLABE
     if (unlikely(!labels))
         return NULL;
 
-    Pvoid_t *PValue;
-    Word_t Index = 0;
-    bool first_then_next = true;
-    RRDLABEL *found = NULL;
-    while ((PValue = JudyLFirstThenNext(labels->JudyL, &Index, &first_then_next))) {
-        RRDLABEL *lb = (RRDLABEL *)Index;
+    RRDLABEL *lb, *found = NULL;
+    RRDLABEL_SRC ls;
+    lfe_start_nolock(labels, lb, ls)
+    {
         if (lb->index.key == label->index.key && ((lb == label) == same_value)) {
-            found = (RRDLABEL *)Index;
+            found = lb;
             break;
         }
     }
+    lfe_done_nolock();
     return found;
 }
 
@@ -228,6 +404,8 @@ static void labels_add_already_sanitized(RRDLABELS *labels, const char *key, con
 
     spinlock_lock(&labels->spinlock);
 
+    rrdlabels_make_private_unsafe(labels);
+
     RRDLABEL_SRC new_ls = (ls & ~(RRDLABEL_FLAG_NEW | RRDLABEL_FLAG_OLD));
 
     size_t mem_before_judyl = JudyLMemUsed(labels->JudyL);
@@ -453,6 +631,8 @@ void rrdlabels_get_value_to_buffer_or_unset(RRDLABELS *labels, BUFFER *wb, const
 
 static void rrdlabels_unmark_all_unsafe(RRDLABELS *labels)
 {
+    rrdlabels_make_private_unsafe(labels);
+
     Pvoid_t *PValue;
     Word_t Index = 0;
     bool first_then_next = true;
@@ -471,6 +651,8 @@ void rrdlabels_unmark_all(RRDLABELS *labels)
 
 static void rrdlabels_remove_all_unmarked_unsafe(RRDLABELS *labels)
 {
+    rrdlabels_make_private_unsafe(labels);
+
     Pvoid_t *PValue;
     Word_t Index = 0;
     bool first_then_next = true;
@@ -522,7 +704,7 @@ int rrdlabels_walkthrough_read(RRDLABELS *labels, int (*callback)(const char *na
     return ret;
 }
 
-static SIMPLE_PATTERN_RESULT rrdlabels_walkthrough_read_sp(RRDLABELS *labels, SIMPLE_PATTERN_RESULT (*callback)(const char *name, const char *value, RRDLABEL_SRC ls, void *data), void *data)
+static SIMPLE_PATTERN_RESULT rrdlabels_walkthrough_read_sp_unsafe(RRDLABELS *labels, SIMPLE_PATTERN_RESULT (*callback)(const char *name, const char *value, RRDLABEL_SRC ls, void *data), void *data)
 {
     SIMPLE_PATTERN_RESULT ret = SP_NOT_MATCHED;
 
@@ -530,13 +712,13 @@ static SIMPLE_PATTERN_RESULT rrdlabels_walkthrough_read_sp(RRDLABELS *labels, SI
 
     RRDLABEL *lb;
     RRDLABEL_SRC ls;
-    lfe_start_read(labels, lb, ls)
+    lfe_start_nolock(labels, lb, ls)
     {
         ret = callback(string2str(lb->index.key), string2str(lb->index.value), ls, data);
         if (ret != SP_NOT_MATCHED)
             break;
     }
-    lfe_done(labels);
+    lfe_done_nolock();
 
     return ret;
 }
@@ -580,6 +762,7 @@ void rrdlabels_migrate_to_these(RRDLABELS *dst, RRDLABELS *src) {
     lfe_done_nolock();
 
     rrdlabels_remove_all_unmarked_unsafe(dst);
+    rrdlabels_share_unsafe(dst);
     dst->version = src->version;
 
     spinlock_unlock(&src->spinlock);
@@ -630,6 +813,22 @@ void rrdlabels_copy(RRDLABELS *dst, RRDLABELS *src)
     spinlock_lock(&dst->spinlock);
     spinlock_lock(&src->spinlock);
 
+    if (!dst->set && !dst->JudyL && src->set) {
+        // dst is empty, it can have the same set
+        spinlock_lock(&global_label_sets.spinlock);
+        src->set->refcount++;
+        spinlock_unlock(&global_label_sets.spinlock);
+
+        dst->set = src->set;
+        dst->version++;
+
+        spinlock_unlock(&src->spinlock);
+        spinlock_unlock(&dst->spinlock);
+        return;
+    }
+
+    rrdlabels_make_private_unsafe(dst);
+
     size_t mem_before_judyl = JudyLMemUsed(dst->JudyL);
     bool update_statistics = false;
     lfe_start_nolock(src, label, ls)
@@ -660,6 +859,8 @@ void rrdlabels_copy(RRDLABELS *dst, RRDLABELS *src)
         STATS_PLUS_MEMORY(&dictionary_stats_category_rrdlabels, 0, mem_after_judyl - mem_before_judyl, 0);
     }
 
+    rrdlabels_share_unsafe(dst);
+
     spinlock_unlock(&src->spinlock);
     spinlock_unlock(&dst->spinlock);
 }
@@ -723,7 +924,40 @@ SIMPLE_PATTERN_RESULT rrdlabels_match_simple_pattern_parsed(RRDLABELS *labels, S
         .equal = equal
     };
 
-    SIMPLE_PATTERN_RESULT ret = rrdlabels_walkthrough_read_sp(labels, equal?simple_pattern_match_name_and_value_callback:simple_pattern_match_name_only_callback, &t);
+    SIMPLE_PATTERN_RESULT ret = SP_NOT_MATCHED;
+    bool cached = false;
+    uint64_t pattern_id = simple_pattern_id(pattern);
+
+    spinlock_lock(&labels->spinlock);
+
+    // shared sets are immutable, so the result of a pattern is the same for all the labels having them
+    RRDLABELS_SET *set = labels->set;
+    if (set && pattern_id) {
+        spinlock_lock(&set->match.spinlock);
+        for (size_t i = 0; i < RRDLABELS_SET_MATCH_CACHE; i++) {
+            if (set->match.cache[i].pattern_id == pattern_id && set->match.cache[i].equal == equal) {
+                ret = set->match.cache[i].result;
+                cached = true;
+                break;
+            }
+        }
+        spinlock_unlock(&set->match.spinlock);
+    }
+
+    if (!cached) {
+        ret = rrdlabels_walkthrough_read_sp_unsafe(labels, equal?simple_pattern_match_name_and_value_callback:simple_pattern_match_name_only_callback, &t);
+
+        if (set && pattern_id) {
+            spinlock_lock(&set->match.spinlock);
+            uint32_t slot = set->match.next++ % RRDLABELS_SET_MATCH_CACHE;
+            set->match.cache[slot].pattern_id = pattern_id;
+            set->match.cache[slot].equal = equal;
+            set->match.cache[slot].result = ret;
+            spinlock_unlock(&set->match.spinlock);
+        }
+    }
+
+    spinlock_unlock(&labels->spinlock);
 
     if(searches)
         *searches = t.searches;
@@ -876,7 +1110,7 @@ size_t rrdlabels_entries(RRDLABELS *labels __maybe_unused)
 
     size_t count;
     spinlock_lock(&labels->spinlock);
-    count = JudyLCount(labels->JudyL, 0, -1, PJE0);
+    count = labels->set ? labels->set->entries : JudyLCount(labels->JudyL, 0, -1, PJE0);
     spinlock_unlock(&labels->spinlock);
     return count;
 }
@@ -1545,6 +1779,46 @@ int rrdlabels_unittest_sanitization() {
     return errors;
 }
 
+static int rrdlabels_unittest_shared_sets()
+{
+    fprintf(stderr, "\n%s() tests\n", __FUNCTION__);
+    int rc = 0;
+
+    RRDLABELS *src = rrdlabels_create();
+    rrdlabels_add(src, "key1", "value1", RRDLABEL_SRC_CONFIG);
+    rrdlabels_add(src, "key2", "value2", RRDLABEL_SRC_CONFIG);
+
+    RRDLABELS *labels1 = rrdlabels_create();
+    RRDLABELS *labels2 = rrdlabels_create();
+    rrdlabels_migrate_to_these(labels1, src);
+    rrdlabels_copy(labels2, labels1);
+
+    // both have the same labels, so they should share the same set
+    if (!labels1->set || labels1->set != labels2->set)
+        rc++;
+
+    SIMPLE_PATTERN *sp = simple_pattern_create("key1=value1", SIMPLE_PATTERN_DEFAULT_WEB_SEPARATORS, SIMPLE_PATTERN_EXACT, true);
+    if (rrdlabels_match_simple_pattern_parsed(labels1, sp, '=', NULL) != SP_MATCHED_POSITIVE)
+        rc++;
+
+    // modifying one of them should not affect the other
+    rrdlabels_add(labels2, "key1", "other", RRDLABEL_SRC_CONFIG);
+    if (labels2->set || rrdlabels_unittest_expect_value(labels1, "key1", "value1", RRDLABEL_FLAG_NEW | RRDLABEL_SRC_CONFIG))
+        rc++;
+
+    if (rrdlabels_match_simple_pattern_parsed(labels1, sp, '=', NULL) != SP_MATCHED_POSITIVE ||
+        rrdlabels_match_simple_pattern_parsed(labels2, sp, '=', NULL) == SP_MATCHED_POSITIVE)
+        rc++;
+
+    simple_pattern_free(sp);
+    rrdlabels_destroy(src);
+    rrdlabels_destroy(labels1);
+    rrdlabels_destroy(labels2);
+
+    fprintf(stderr, "%s() tests %s\n", __FUNCTION__, rc ? "failed" : "passed");
+    return rc;
+}
+
 int rrdlabels_unittest(void) {
     int errors = 0;
 
@@ -1555,6 +1829,7 @@ int rrdlabels_unittest(void) {
     errors += rrdlabels_unittest_double_check();
     errors += rrdlabels_unittest_migrate_check();
     errors += rrdlabels_unittest_pattern_check();
+    errors += rrdlabels_unittest_shared_sets();
 
     fprintf(stderr, "%d errors found\n", errors);
     return errors;
@@ -368,6 +368,9 @@ static void rrdset_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, v
     // 5. destroy the ml handle
     ml_chart_delete(st);
 
+    // 6. the live subscribers have released it already
+    rrdset_live_free(st);
+
     // ------------------------------------------------------------------------
     // free it
 
@@ -384,6 +387,11 @@ static void rrdset_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, v
     string_freez(st->module_name);
 
     freez(st->exporting_flags);
+
+    string_freez(st->prometheus.chart);
+    string_freez(st->prometheus.family);
+    string_freez(st->prometheus.context);
+    string_freez(st->prometheus.labels);
 }
 
 // the item to be inserted, is already in the dictionary
@@ -749,6 +757,8 @@ inline void rrdset_is_obsolete___safe_from_collector_thread(RRDSET *st) {
         // so, we have to push its definition now
         rrdset_push_chart_definition_now(st);
         rrdcontext_updated_rrdset_flags(st);
+
+        ml_chart_obsolete(st);
     }
 }
 
@@ -1271,18 +1281,15 @@ void rrddim_store_metric(RRDDIM *rd, usec_t point_end_time_ut, NETDATA_DOUBLE n,
         .flags = flags
     };
 
-    for(size_t tier = 1; tier < storage_tiers ;tier++) {
+    // we have not collected the higher tiers before - their gaps have to be filled first,
+    // and while they are being backfilled, only tier 0 is stored
+    bool higher_tiers = likely(rrddim_option_check(rd, RRDDIM_OPTION_BACKFILLED_HIGH_TIERS)) ||
+                        rrddim_backfill_higher_tiers(rd, now_s);
+
+    for(size_t tier = 1; higher_tiers && tier < storage_tiers ;tier++) {
         if(unlikely(!rd->tiers[tier].smh)) continue;
 
         struct rrddim_tier *t = &rd->tiers[tier];
-
-        if(!rrddim_option_check(rd, RRDDIM_OPTION_BACKFILLED_HIGH_TIERS)) {
-            // we have not collected this tier before
-            // let's fill any gap that may exist
-            rrdr_fill_tier_gap_from_smaller_tiers(rd, tier, now_s);
-            rrddim_option_set(rd, RRDDIM_OPTION_BACKFILLED_HIGH_TIERS);
-        }
-
         store_metric_at_tier(rd, tier, t, sp, point_end_time_ut);
     }
 
@@ -1294,44 +1301,184 @@ void store_metric_collection_completed() {
     global_statistics_rrdset_done_chart_collection_completed(rrdset_done_statistics_points_stored_per_tier);
 }
 
-// caching of dimensions rrdset_done() and rrdset_done_interpolate() loop through
-struct rda_item {
-    const DICTIONARY_ITEM *item;
-    RRDDIM *rd;
-    bool reset_or_overflow;
+// ----------------------------------------------------------------------------
+// the working set of rrdset_done() and rrdset_done_interpolate()
+//
+// It is a structure of arrays, indexed by the position of the dimension in
+// the chart. The hot data collection fields of all the dimensions are copied
+// here once, so that the calculation and interpolation loops run over
+// contiguous arrays, instead of walking the big RRDDIM structures again and
+// again. RRDDIM is touched again only to store the points and, at the end,
+// to write back the results.
+
+struct rda {
+    size_t entries;                         // the capacity of the arrays
+
+    const DICTIONARY_ITEM **item;
+    RRDDIM **rd;                            // NULL for the dimensions to be skipped
+
+    collected_number *collected_value;
+    collected_number *last_collected_value;
+    NETDATA_DOUBLE *calculated_value;
+    NETDATA_DOUBLE *last_calculated_value;
+    NETDATA_DOUBLE *multiplier;
+    NETDATA_DOUBLE *divisor;
+    NETDATA_DOUBLE *store_value;            // the point to be stored, at each interpolation point
+
+    uint32_t *counter;
+    SN_FLAGS *store_flags;
+    RRD_ALGORITHM *algorithm;
+    bool *updated;
+    bool *reset_or_overflow;
 };
 
-static __thread struct rda_item *thread_rda = NULL;
-static __thread size_t thread_rda_entries = 0;
+static __thread struct rda thread_rda = { 0 };
 
-struct rda_item *rrdset_thread_rda_get(size_t *dimensions) {
+static inline size_t rda_entry_size(void) {
+    return 2 * sizeof(void *) + 2 * sizeof(collected_number) + 5 * sizeof(NETDATA_DOUBLE) +
+           sizeof(uint32_t) + sizeof(SN_FLAGS) + sizeof(RRD_ALGORITHM) + 2 * sizeof(bool);
+}
 
-    if(unlikely(!thread_rda || (*dimensions) > thread_rda_entries)) {
-        size_t old_mem = thread_rda_entries * sizeof(struct rda_item);
-        freez(thread_rda);
-        thread_rda_entries = *dimensions;
-        size_t new_mem = thread_rda_entries * sizeof(struct rda_item);
-        thread_rda = mallocz(new_mem);
+static struct rda *rrdset_thread_rda_get(size_t dimensions) {
+
+    if(unlikely(!thread_rda.item || dimensions > thread_rda.entries)) {
+        size_t old_mem = thread_rda.entries * rda_entry_size();
+        freez(thread_rda.item);
+
+        size_t n = thread_rda.entries = dimensions;
+        size_t new_mem = n * rda_entry_size();
+
+        // one allocation, with the arrays of bigger members first, so that all are aligned
+        char *mem = mallocz(new_mem);
+        thread_rda.item = (const DICTIONARY_ITEM **)mem;                mem += n * sizeof(void *);
+        thread_rda.rd = (RRDDIM **)mem;                                 mem += n * sizeof(void *);
+        thread_rda.collected_value = (collected_number *)mem;           mem += n * sizeof(collected_number);
+        thread_rda.last_collected_value = (collected_number *)mem;      mem += n * sizeof(collected_number);
+        thread_rda.calculated_value = (NETDATA_DOUBLE *)mem;            mem += n * sizeof(NETDATA_DOUBLE);
+        thread_rda.last_calculated_value = (NETDATA_DOUBLE *)mem;       mem += n * sizeof(NETDATA_DOUBLE);
+        thread_rda.multiplier = (NETDATA_DOUBLE *)mem;                  mem += n * sizeof(NETDATA_DOUBLE);
+        thread_rda.divisor = (NETDATA_DOUBLE *)mem;                     mem += n * sizeof(NETDATA_DOUBLE);
+        thread_rda.store_value = (NETDATA_DOUBLE *)mem;                 mem += n * sizeof(NETDATA_DOUBLE);
+        thread_rda.counter = (uint32_t *)mem;                           mem += n * sizeof(uint32_t);
+        thread_rda.store_flags = (SN_FLAGS *)mem;                       mem += n * sizeof(SN_FLAGS);
+        thread_rda.algorithm = (RRD_ALGORITHM *)mem;                    mem += n * sizeof(RRD_ALGORITHM);
+        thread_rda.updated = (bool *)mem;                               mem += n * sizeof(bool);
+        thread_rda.reset_or_overflow = (bool *)mem;
 
         __atomic_add_fetch(&netdata_buffers_statistics.rrdset_done_rda_size, new_mem - old_mem, __ATOMIC_RELAXED);
     }
 
-    *dimensions = thread_rda_entries;
-    return thread_rda;
+    return &thread_rda;
 }
 
 void rrdset_thread_rda_free(void) {
-    __atomic_sub_fetch(&netdata_buffers_statistics.rrdset_done_rda_size, thread_rda_entries * sizeof(struct rda_item), __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&netdata_buffers_statistics.rrdset_done_rda_size, thread_rda.entries * rda_entry_size(), __ATOMIC_RELAXED);
 
-    freez(thread_rda);
-    thread_rda = NULL;
-    thread_rda_entries = 0;
+    freez(thread_rda.item);
+    memset(&thread_rda, 0, sizeof(thread_rda));
+}
+
+// copy the hot fields of a dimension to the working set
+static inline void rda_load(struct rda *rda, size_t i, RRDDIM *rd) {
+    rda->collected_value[i] = rd->collector.collected_value;
+    rda->last_collected_value[i] = rd->collector.last_collected_value;
+    rda->calculated_value[i] = rd->collector.calculated_value;
+    rda->last_calculated_value[i] = rd->collector.last_calculated_value;
+    rda->multiplier[i] = (NETDATA_DOUBLE)rd->multiplier;
+    rda->divisor[i] = (NETDATA_DOUBLE)rd->divisor;
+    rda->counter[i] = rd->collector.counter;
+    rda->algorithm[i] = rd->algorithm;
+    rda->updated[i] = rrddim_check_updated(rd) ? true : false;
+    rda->reset_or_overflow[i] = false;
+}
+
+// stores the points of all the dimensions of a chart for the same time, to all the tiers
+// it does what rrddim_store_metric() does, but tier by tier, so that each tier
+// and the metrics group of the chart in it are visited once per interpolation point
+static void rrdset_store_metrics(struct rda *rda, size_t rda_slots, usec_t point_end_time_ut) {
+    RRDDIM *rd;
+    size_t dim_id;
+
+#ifdef NETDATA_LOG_COLLECTION_ERRORS
+    for(dim_id = 0; dim_id < rda_slots ; ++dim_id) {
+        rd = rda->rd[dim_id];
+        if(unlikely(!rd)) continue;
+
+        rrddim_store_metric(rd, point_end_time_ut, rda->store_value[dim_id], rda->store_flags[dim_id]);
+    }
+#else // !NETDATA_LOG_COLLECTION_ERRORS
+    static __thread struct log_stack_entry lgs[] = {
+            [0] = ND_LOG_FIELD_STR(NDF_NIDL_DIMENSION, NULL),
+            [1] = ND_LOG_FIELD_END(),
+    };
+    lgs[0].str = NULL;
+    log_stack_push(lgs);
+
+    time_t now_s = (time_t)(point_end_time_ut / USEC_PER_SEC);
+    size_t stored = 0;
+
+    // tier 0
+    for(dim_id = 0; dim_id < rda_slots ; ++dim_id) {
+        rd = rda->rd[dim_id];
+        if(unlikely(!rd)) continue;
+
+        lgs[0].str = rd->id;
+        storage_engine_store_metric(rd->tiers[0].sch, point_end_time_ut,
+                                    rda->store_value[dim_id], 0, 0,
+                                    1, 0, rda->store_flags[dim_id]);
+        stored++;
+    }
+    rrdset_done_statistics_points_stored_per_tier[0] += stored;
+
+    // the higher tiers
+    for(size_t tier = 1; tier < storage_tiers ;tier++) {
+        for(dim_id = 0; dim_id < rda_slots ; ++dim_id) {
+            rd = rda->rd[dim_id];
+            if(unlikely(!rd)) continue;
+
+            // we have not collected the higher tiers before - their gaps have to be filled first,
+            // and while they are being backfilled, only tier 0 is stored
+            if(unlikely(!rrddim_option_check(rd, RRDDIM_OPTION_BACKFILLED_HIGH_TIERS)) &&
+               (tier > 1 || !rrddim_backfill_higher_tiers(rd, now_s)))
+                continue;
+
+            if(unlikely(!rd->tiers[tier].smh)) continue;
+
+            lgs[0].str = rd->id;
+            struct rrddim_tier *t = &rd->tiers[tier];
+
+            NETDATA_DOUBLE n = rda->store_value[dim_id];
+            SN_FLAGS flags = rda->store_flags[dim_id];
+            STORAGE_POINT sp = {
+                .start_time_s = now_s - rd->rrdset->update_every,
+                .end_time_s = now_s,
+                .min = n,
+                .max = n,
+                .sum = n,
+                .count = 1,
+                .anomaly_count = (flags & SN_FLAG_NOT_ANOMALOUS) ? 0 : 1,
+                .flags = flags
+            };
+
+            store_metric_at_tier(rd, tier, t, sp, point_end_time_ut);
+        }
+    }
+
+    for(dim_id = 0; dim_id < rda_slots ; ++dim_id) {
+        rd = rda->rd[dim_id];
+        if(unlikely(!rd)) continue;
+
+        rrdcontext_collected_rrddim(rd);
+    }
+
+    log_stack_pop(&lgs);
+#endif // !NETDATA_LOG_COLLECTION_ERRORS
 }
 
 static inline size_t rrdset_done_interpolate(
         RRDSET_STREAM_BUFFER *rsb
         , RRDSET *st
-        , struct rda_item *rda_base
+        , struct rda *rda
         , size_t rda_slots
         , usec_t update_every_ut
         , usec_t last_stored_ut
@@ -1372,23 +1519,21 @@ static inline size_t rrdset_done_interpolate(
 
         ml_chart_update_begin(st);
 
-        struct rda_item *rda;
-        size_t dim_id;
-        for(dim_id = 0, rda = rda_base ; dim_id < rda_slots ; ++dim_id, ++rda) {
-            rd = rda->rd;
+        for(size_t dim_id = 0; dim_id < rda_slots ; ++dim_id) {
+            rd = rda->rd[dim_id];
             if(unlikely(!rd)) continue;
 
             SN_FLAGS storage_flags = SN_DEFAULT_FLAGS;
 
-            if (rda->reset_or_overflow)
+            if (rda->reset_or_overflow[dim_id])
                 storage_flags |= SN_FLAG_RESET;
 
             NETDATA_DOUBLE new_value;
 
-            switch(rd->algorithm) {
+            switch(rda->algorithm[dim_id]) {
                 case RRD_ALGORITHM_INCREMENTAL:
                     new_value = (NETDATA_DOUBLE)
-                            (      rd->collector.calculated_value
+                            (      rda->calculated_value[dim_id]
                                    * (NETDATA_DOUBLE)(next_store_ut - last_collect_ut)
                                    / (NETDATA_DOUBLE)(now_collect_ut - last_collect_ut)
                             );
@@ -1399,14 +1544,14 @@ static inline size_t rrdset_done_interpolate(
                                 " / (%"PRIu64" - %"PRIu64""
                               , rrddim_name(rd)
                               , new_value
-                              , rd->collector.calculated_value
+                              , rda->calculated_value[dim_id]
                               , next_store_ut, last_collect_ut
                               , now_collect_ut, last_collect_ut
                     );
 
-                    rd->collector.calculated_value -= new_value;
-                    new_value += rd->collector.last_calculated_value;
-                    rd->collector.last_calculated_value = 0;
+                    rda->calculated_value[dim_id] -= new_value;
+                    new_value += rda->last_calculated_value[dim_id];
+                    rda->last_calculated_value[dim_id] = 0;
                     new_value /= (NETDATA_DOUBLE)st->update_every;
 
                     if(unlikely(next_store_ut - last_stored_ut < update_every_ut)) {
@@ -1429,18 +1574,18 @@ static inline size_t rrdset_done_interpolate(
                         // do not interpolate
                         // just show the calculated value
 
-                        new_value = rd->collector.calculated_value;
+                        new_value = rda->calculated_value[dim_id];
                     }
                     else {
                         // we have missed an update
                         // interpolate in the middle values
 
                         new_value = (NETDATA_DOUBLE)
-                                (   (     (rd->collector.calculated_value - rd->collector.last_calculated_value)
+                                (   (     (rda->calculated_value[dim_id] - rda->last_calculated_value[dim_id])
                                           * (NETDATA_DOUBLE)(next_store_ut - last_collect_ut)
                                           / (NETDATA_DOUBLE)(now_collect_ut - last_collect_ut)
                                     )
-                                    +  rd->collector.last_calculated_value
+                                    +  rda->last_calculated_value[dim_id]
                                 );
 
                         rrdset_debug(st, "%s: CALC2 DEF " NETDATA_DOUBLE_FORMAT " = ((("
@@ -1448,9 +1593,9 @@ static inline size_t rrdset_done_interpolate(
                                             " * %"PRIu64""
                                             " / %"PRIu64") + " NETDATA_DOUBLE_FORMAT, rrddim_name(rd)
                                   , new_value
-                                  , rd->collector.calculated_value, rd->collector.last_calculated_value
+                                  , rda->calculated_value[dim_id], rda->last_calculated_value[dim_id]
                                   , (next_store_ut - first_ut)
-                                  , (now_collect_ut - first_ut), rd->collector.last_calculated_value
+                                  , (now_collect_ut - first_ut), rda->last_calculated_value[dim_id]
                         );
                     }
                     break;
@@ -1464,11 +1609,12 @@ static inline size_t rrdset_done_interpolate(
                 if(rsb->wb && rsb->v2)
                     rrddim_push_metrics_v2(rsb, rd, next_store_ut, NAN, SN_FLAG_NONE);
 
-                rrddim_store_metric(rd, next_store_ut, NAN, SN_FLAG_NONE);
+                rda->store_value[dim_id] = NAN;
+                rda->store_flags[dim_id] = SN_FLAG_NONE;
                 continue;
             }
 
-            if(likely(rrddim_check_updated(rd) && rd->collector.counter > 1 && iterations < gap_when_lost_iterations_above)) {
+            if(likely(rda->updated[dim_id] && rda->counter[dim_id] > 1 && iterations < gap_when_lost_iterations_above)) {
                 uint32_t dim_storage_flags = storage_flags;
 
                 if (ml_dimension_is_anomalous(rd, current_time_s, new_value, true)) {
@@ -1479,7 +1625,8 @@ static inline size_t rrdset_done_interpolate(
                 if(rsb->wb && rsb->v2)
                     rrddim_push_metrics_v2(rsb, rd, next_store_ut, new_value, dim_storage_flags);
 
-                rrddim_store_metric(rd, next_store_ut, new_value, dim_storage_flags);
+                rda->store_value[dim_id] = new_value;
+                rda->store_flags[dim_id] = dim_storage_flags;
                 rd->collector.last_stored_value = new_value;
             }
             else {
@@ -1490,13 +1637,16 @@ static inline size_t rrdset_done_interpolate(
                 if(rsb->wb && rsb->v2)
                     rrddim_push_metrics_v2(rsb, rd, next_store_ut, NAN, SN_FLAG_NONE);
 
-                rrddim_store_metric(rd, next_store_ut, NAN, SN_FLAG_NONE);
+                rda->store_value[dim_id] = NAN;
+                rda->store_flags[dim_id] = SN_FLAG_NONE;
                 rd->collector.last_stored_value = NAN;
             }
 
             stored_entries++;
         }
 
+        rrdset_store_metrics(rda, rda_slots, next_store_ut);
+
         ml_chart_update_end(st);
 
         st->counter = ++counter;
@@ -1660,52 +1810,50 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
     if(stream_buffer.wb && !stream_buffer.v2)
         rrdset_push_metrics_v1(&stream_buffer, st);
 
-    size_t rda_slots = dictionary_entries(st->rrddim_root_index);
-    struct rda_item *rda_base = rrdset_thread_rda_get(&rda_slots);
+    struct rda *rda = rrdset_thread_rda_get(dictionary_entries(st->rrddim_root_index));
+    size_t rda_slots = rda->entries;
 
     size_t dim_id;
     size_t dimensions = 0;
-    struct rda_item *rda = rda_base;
     total_number collected_total = 0;
     total_number last_collected_total = 0;
     rrddim_foreach_read(rd, st) {
         if(rd_dfe.counter >= rda_slots)
             break;
 
-        rda = &rda_base[dimensions++];
+        dim_id = dimensions++;
 
         if(rrddim_flag_check(rd, RRDDIM_FLAG_ARCHIVED)) {
-            rda->item = NULL;
-            rda->rd = NULL;
-            rda->reset_or_overflow = false;
+            rda->item[dim_id] = NULL;
+            rda->rd[dim_id] = NULL;
             continue;
         }
 
         // store the dimension in the array
-        rda->item = dictionary_acquired_item_dup(st->rrddim_root_index, rd_dfe.item);
-        rda->rd = dictionary_acquired_item_value(rda->item);
-        rda->reset_or_overflow = false;
+        rda->item[dim_id] = dictionary_acquired_item_dup(st->rrddim_root_index, rd_dfe.item);
+        rda->rd[dim_id] = dictionary_acquired_item_value(rda->item[dim_id]);
+        rda_load(rda, dim_id, rd);
 
         // calculate totals
-        if(likely(rrddim_check_updated(rd))) {
+        if(likely(rda->updated[dim_id])) {
             // if the new is smaller than the old (an overflow, or reset), set the old equal to the new
             // to reset the calculation (it will give zero as the calculation for this second)
-            if(unlikely(rd->algorithm == RRD_ALGORITHM_PCENT_OVER_DIFF_TOTAL && rd->collector.last_collected_value > rd->collector.collected_value)) {
+            if(unlikely(rda->algorithm[dim_id] == RRD_ALGORITHM_PCENT_OVER_DIFF_TOTAL && rda->last_collected_value[dim_id] > rda->collected_value[dim_id])) {
                 netdata_log_debug(D_RRD_STATS, "'%s' / '%s': RESET or OVERFLOW. Last collected value = " COLLECTED_NUMBER_FORMAT ", current = " COLLECTED_NUMBER_FORMAT
                 , rrdset_id(st)
                 , rrddim_name(rd)
-                , rd->collector.last_collected_value
-                , rd->collector.collected_value
+                , rda->last_collected_value[dim_id]
+                , rda->collected_value[dim_id]
                 );
 
                 if(!(rrddim_option_check(rd, RRDDIM_OPTION_DONT_DETECT_RESETS_OR_OVERFLOWS)))
-                    rda->reset_or_overflow = true;
+                    rda->reset_or_overflow[dim_id] = true;
 
-                rd->collector.last_collected_value = rd->collector.collected_value;
+                rda->last_collected_value[dim_id] = rda->collected_value[dim_id];
             }
 
-            last_collected_total += rd->collector.last_collected_value;
-            collected_total += rd->collector.collected_value;
+            last_collected_total += rda->last_collected_value[dim_id];
+            collected_total += rda->collected_value[dim_id];
 
             if(unlikely(rrddim_flag_check(rd, RRDDIM_FLAG_OBSOLETE))) {
                 netdata_log_error("Dimension %s in chart '%s' has the OBSOLETE flag set, but it is collected.", rrddim_name(rd), rrdset_id(st));
@@ -1724,12 +1872,12 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
     // process all dimensions to calculate their values
     // based on the collected figures only
     // at this stage we do not interpolate anything
-    for(dim_id = 0, rda = rda_base ; dim_id < rda_slots ; ++dim_id, ++rda) {
-        rd = rda->rd;
+    for(dim_id = 0; dim_id < rda_slots ; ++dim_id) {
+        rd = rda->rd[dim_id];
         if(unlikely(!rd)) continue;
 
-        if(unlikely(!rrddim_check_updated(rd))) {
-            rd->collector.calculated_value = 0;
+        if(unlikely(!rda->updated[dim_id])) {
+            rda->calculated_value[dim_id] = 0;
             continue;
         }
 
@@ -1739,54 +1887,54 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
                 " last_calculated_value = " NETDATA_DOUBLE_FORMAT
                 " calculated_value = " NETDATA_DOUBLE_FORMAT
                      , rrddim_name(rd)
-                     , rd->collector.last_collected_value
-                     , rd->collector.collected_value
-                     , rd->collector.last_calculated_value
-                     , rd->collector.calculated_value
+                     , rda->last_collected_value[dim_id]
+                     , rda->collected_value[dim_id]
+                     , rda->last_calculated_value[dim_id]
+                     , rda->calculated_value[dim_id]
         );
 
-        switch(rd->algorithm) {
+        switch(rda->algorithm[dim_id]) {
             case RRD_ALGORITHM_ABSOLUTE:
-                rd->collector.calculated_value = (NETDATA_DOUBLE)rd->collector.collected_value
-                                                 * (NETDATA_DOUBLE)rd->multiplier
-                                                 / (NETDATA_DOUBLE)rd->divisor;
+                rda->calculated_value[dim_id] = (NETDATA_DOUBLE)rda->collected_value[dim_id]
+                                                 * rda->multiplier[dim_id]
+                                                 / rda->divisor[dim_id];
 
                 rrdset_debug(st, "%s: CALC ABS/ABS-NO-IN " NETDATA_DOUBLE_FORMAT " = "
                             COLLECTED_NUMBER_FORMAT
                             " * " NETDATA_DOUBLE_FORMAT
                             " / " NETDATA_DOUBLE_FORMAT
                           , rrddim_name(rd)
-                          , rd->collector.calculated_value
-                          , rd->collector.collected_value
-                          , (NETDATA_DOUBLE)rd->multiplier
-                          , (NETDATA_DOUBLE)rd->divisor
+                          , rda->calculated_value[dim_id]
+                          , rda->collected_value[dim_id]
+                          , rda->multiplier[dim_id]
+                          , rda->divisor[dim_id]
                 );
                 break;
 
             case RRD_ALGORITHM_PCENT_OVER_ROW_TOTAL:
                 if(unlikely(!collected_total))
-                    rd->collector.calculated_value = 0;
+                    rda->calculated_value[dim_id] = 0;
                 else
                     // the percentage of the current value
                     // over the total of all dimensions
-                    rd->collector.calculated_value =
+                    rda->calculated_value[dim_id] =
                             (NETDATA_DOUBLE)100
-                            * (NETDATA_DOUBLE)rd->collector.collected_value
+                            * (NETDATA_DOUBLE)rda->collected_value[dim_id]
                             / (NETDATA_DOUBLE)collected_total;
 
                 rrdset_debug(st, "%s: CALC PCENT-ROW " NETDATA_DOUBLE_FORMAT " = 100"
                             " * " COLLECTED_NUMBER_FORMAT
                             " / " COLLECTED_NUMBER_FORMAT
                           , rrddim_name(rd)
-                          , rd->collector.calculated_value
-                          , rd->collector.collected_value
+                          , rda->calculated_value[dim_id]
+                          , rda->collected_value[dim_id]
                           , collected_total
                 );
                 break;
 
             case RRD_ALGORITHM_INCREMENTAL:
-                if(unlikely(rd->collector.counter <= 1)) {
-                    rd->collector.calculated_value = 0;
+                if(unlikely(rda->counter[dim_id] <= 1)) {
+                    rda->calculated_value[dim_id] = 0;
                     continue;
                 }
 
@@ -1794,18 +1942,18 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
                 // to reset the calculation (it will give zero as the calculation for this second).
                 // It is imperative to set the comparison to uint64_t since type collected_number is signed and
                 // produces wrong results as far as incremental counters are concerned.
-                if(unlikely((uint64_t)rd->collector.last_collected_value > (uint64_t)rd->collector.collected_value)) {
+                if(unlikely((uint64_t)rda->last_collected_value[dim_id] > (uint64_t)rda->collected_value[dim_id])) {
                     netdata_log_debug(D_RRD_STATS, "'%s' / '%s': RESET or OVERFLOW. Last collected value = " COLLECTED_NUMBER_FORMAT ", current = " COLLECTED_NUMBER_FORMAT
                           , rrdset_id(st)
                           , rrddim_name(rd)
-                          , rd->collector.last_collected_value
-                          , rd->collector.collected_value);
+                          , rda->last_collected_value[dim_id]
+                          , rda->collected_value[dim_id]);
 
                     if(!(rrddim_option_check(rd, RRDDIM_OPTION_DONT_DETECT_RESETS_OR_OVERFLOWS)))
-                        rda->reset_or_overflow = true;
+                        rda->reset_or_overflow[dim_id] = true;
 
-                    uint64_t last = (uint64_t)rd->collector.last_collected_value;
-                    uint64_t new = (uint64_t)rd->collector.collected_value;
+                    uint64_t last = (uint64_t)rda->last_collected_value[dim_id];
+                    uint64_t new = (uint64_t)rda->collected_value[dim_id];
                     uint64_t max = (uint64_t)rd->collector.collected_value_max;
                     uint64_t cap = 0;
 
@@ -1823,21 +1971,21 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
                     // overflow.
                     // TODO: remember recent history of rates and compare with current rate to reduce this chance.
                     if (delta < max_acceptable_rate) {
-                        rd->collector.calculated_value +=
+                        rda->calculated_value[dim_id] +=
                                 (NETDATA_DOUBLE) delta
-                                * (NETDATA_DOUBLE) rd->multiplier
-                                / (NETDATA_DOUBLE) rd->divisor;
+                                * rda->multiplier[dim_id]
+                                / rda->divisor[dim_id];
                     } else {
                         // This is a reset. Any overflow with a rate greater than MAX_INCREMENTAL_PERCENT_RATE will also
                         // be detected as a reset instead.
-                        rd->collector.calculated_value += (NETDATA_DOUBLE)0;
+                        rda->calculated_value[dim_id] += (NETDATA_DOUBLE)0;
                     }
                 }
                 else {
-                    rd->collector.calculated_value +=
-                            (NETDATA_DOUBLE) (rd->collector.collected_value - rd->collector.last_collected_value)
-                            * (NETDATA_DOUBLE) rd->multiplier
-                            / (NETDATA_DOUBLE) rd->divisor;
+                    rda->calculated_value[dim_id] +=
+                            (NETDATA_DOUBLE) (rda->collected_value[dim_id] - rda->last_collected_value[dim_id])
+                            * rda->multiplier[dim_id]
+                            / rda->divisor[dim_id];
                 }
 
                 rrdset_debug(st, "%s: CALC INC PRE " NETDATA_DOUBLE_FORMAT " = ("
@@ -1846,35 +1994,35 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
                                     " * " NETDATA_DOUBLE_FORMAT
                             " / " NETDATA_DOUBLE_FORMAT
                           , rrddim_name(rd)
-                          , rd->collector.calculated_value
-                          , rd->collector.collected_value, rd->collector.last_collected_value
-                          , (NETDATA_DOUBLE)rd->multiplier
-                          , (NETDATA_DOUBLE)rd->divisor
+                          , rda->calculated_value[dim_id]
+                          , rda->collected_value[dim_id], rda->last_collected_value[dim_id]
+                          , rda->multiplier[dim_id]
+                          , rda->divisor[dim_id]
                 );
                 break;
 
             case RRD_ALGORITHM_PCENT_OVER_DIFF_TOTAL:
-                if(unlikely(rd->collector.counter <= 1)) {
-                    rd->collector.calculated_value = 0;
+                if(unlikely(rda->counter[dim_id] <= 1)) {
+                    rda->calculated_value[dim_id] = 0;
                     continue;
                 }
 
                 // the percentage of the current increment
                 // over the increment of all dimensions together
                 if(unlikely(collected_total == last_collected_total))
-                    rd->collector.calculated_value = 0;
+                    rda->calculated_value[dim_id] = 0;
                 else
-                    rd->collector.calculated_value =
+                    rda->calculated_value[dim_id] =
                             (NETDATA_DOUBLE)100
-                            * (NETDATA_DOUBLE)(rd->collector.collected_value - rd->collector.last_collected_value)
+                            * (NETDATA_DOUBLE)(rda->collected_value[dim_id] - rda->last_collected_value[dim_id])
                             / (NETDATA_DOUBLE)(collected_total - last_collected_total);
 
                 rrdset_debug(st, "%s: CALC PCENT-DIFF " NETDATA_DOUBLE_FORMAT " = 100"
                             " * (" COLLECTED_NUMBER_FORMAT " - " COLLECTED_NUMBER_FORMAT ")"
                             " / (" COLLECTED_NUMBER_FORMAT " - " COLLECTED_NUMBER_FORMAT ")"
                           , rrddim_name(rd)
-                          , rd->collector.calculated_value
-                          , rd->collector.collected_value, rd->collector.last_collected_value
+                          , rda->calculated_value[dim_id]
+                          , rda->collected_value[dim_id], rda->last_collected_value[dim_id]
                           , collected_total, last_collected_total
                 );
                 break;
@@ -1882,11 +2030,11 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
             default:
                 // make the default zero, to make sure
                 // it gets noticed when we add new types
-                rd->collector.calculated_value = 0;
+                rda->calculated_value[dim_id] = 0;
 
                 rrdset_debug(st, "%s: CALC " NETDATA_DOUBLE_FORMAT " = 0"
                           , rrddim_name(rd)
-                          , rd->collector.calculated_value
+                          , rda->calculated_value[dim_id]
                 );
                 break;
         }
@@ -1897,10 +2045,10 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
                     " last_calculated_value = " NETDATA_DOUBLE_FORMAT
                     " calculated_value = " NETDATA_DOUBLE_FORMAT
                     , rrddim_name(rd)
-                    , rd->collector.last_collected_value
-                    , rd->collector.collected_value
-                    , rd->collector.last_calculated_value
-                    , rd->collector.calculated_value
+                    , rda->last_collected_value[dim_id]
+                    , rda->collected_value[dim_id]
+                    , rda->last_calculated_value[dim_id]
+                    , rda->calculated_value[dim_id]
         );
     }
 
@@ -1918,7 +2066,7 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
     rrdset_done_interpolate(
             &stream_buffer
             , st
-            , rda_base
+            , rda
             , rda_slots
             , update_every_ut
             , last_stored_ut
@@ -1928,27 +2076,31 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
             , store_this_entry
     );
 
-    for(dim_id = 0, rda = rda_base ; dim_id < rda_slots ; ++dim_id, ++rda) {
-        rd = rda->rd;
+    // write back the working set to the dimensions
+    for(dim_id = 0; dim_id < rda_slots ; ++dim_id) {
+        rd = rda->rd[dim_id];
         if(unlikely(!rd)) continue;
 
-        if(unlikely(!rrddim_check_updated(rd)))
+        if(unlikely(!rda->updated[dim_id])) {
+            rd->collector.calculated_value = rda->calculated_value[dim_id];
+            rd->collector.last_calculated_value = rda->last_calculated_value[dim_id];
             continue;
+        }
 
         rrdset_debug(st, "%s: setting last_collected_value (old: " COLLECTED_NUMBER_FORMAT ") to last_collected_value (new: " COLLECTED_NUMBER_FORMAT ")", rrddim_name(rd), rd->collector.last_collected_value, rd->collector.collected_value);
 
-        rd->collector.last_collected_value = rd->collector.collected_value;
+        rd->collector.last_collected_value = rda->collected_value[dim_id];
 
-        switch(rd->algorithm) {
+        switch(rda->algorithm[dim_id]) {
             case RRD_ALGORITHM_INCREMENTAL:
                 if(unlikely(!first_entry)) {
                     rrdset_debug(st, "%s: setting last_calculated_value (old: " NETDATA_DOUBLE_FORMAT ") to "
                                      "last_calculated_value (new: " NETDATA_DOUBLE_FORMAT ")"
                         , rrddim_name(rd)
-                        , rd->collector.last_calculated_value + rd->collector.calculated_value
-                        , rd->collector.calculated_value);
+                        , rda->last_calculated_value[dim_id] + rda->calculated_value[dim_id]
+                        , rda->calculated_value[dim_id]);
 
-                    rd->collector.last_calculated_value += rd->collector.calculated_value;
+                    rda->last_calculated_value[dim_id] += rda->calculated_value[dim_id];
                 }
                 else {
                     rrdset_debug(st, "THIS IS THE FIRST POINT");
@@ -1961,13 +2113,14 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
                 rrdset_debug(st, "%s: setting last_calculated_value (old: " NETDATA_DOUBLE_FORMAT ") to "
                                  "last_calculated_value (new: " NETDATA_DOUBLE_FORMAT ")"
                     , rrddim_name(rd)
-                    , rd->collector.last_calculated_value
-                    , rd->collector.calculated_value);
+                    , rda->last_calculated_value[dim_id]
+                    , rda->calculated_value[dim_id]);
 
-                rd->collector.last_calculated_value = rd->collector.calculated_value;
+                rda->last_calculated_value[dim_id] = rda->calculated_value[dim_id];
                 break;
         }
 
+        rd->collector.last_calculated_value = rda->last_calculated_value[dim_id];
         rd->collector.calculated_value = 0;
         rd->collector.collected_value = 0;
         rrddim_clear_updated(rd);
@@ -1991,18 +2144,23 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
     // ALL DONE ABOUT THE DATA UPDATE
     // --------------------------------------------------------------------
 
-    for(dim_id = 0, rda = rda_base; dim_id < rda_slots ; ++dim_id, ++rda) {
-        rd = rda->rd;
-        if(unlikely(!rd)) continue;
+    for(dim_id = 0; dim_id < rda_slots ; ++dim_id) {
+        if(unlikely(!rda->rd[dim_id])) continue;
 
-        dictionary_acquired_item_release(st->rrddim_root_index, rda->item);
-        rda->item = NULL;
-        rda->rd = NULL;
+        dictionary_acquired_item_release(st->rrddim_root_index, rda->item[dim_id]);
+        rda->item[dim_id] = NULL;
+        rda->rd[dim_id] = NULL;
     }
 
     rrdcontext_collected_rrdset(st);
 
     store_metric_collection_completed();
+
+    if(unlikely(st->backfill_pending))
+        rrdset_backfill_submit(st);
+
+    if(unlikely(st->live))
+        rrdset_live_collected(st);
 }
 
 time_t rrdset_set_update_every_s(RRDSET *st, time_t update_every_s) {
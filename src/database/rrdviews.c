@@ -0,0 +1,292 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrd.h"
+#include "daemon/main.h"
+
+// ----------------------------------------------------------------------------
+// materialized views
+//
+// A view aggregates the latest collected values of all the charts of a
+// context, across all hosts, grouped by the value of a chart label, into a
+// chart of localhost. The view chart is stored like any other chart, so
+// dashboards can query a single chart with one dimension per label value,
+// instead of grouping thousands of dimensions at query time.
+//
+// Views are configured in netdata.conf, one per line:
+//
+//  [materialized views]
+//      NAME = CONTEXT LABEL_KEY [AGGREGATION]
+//
+// AGGREGATION is one of average (the default), sum, min, max.
+
+#define CONFIG_SECTION_MATERIALIZED_VIEWS "materialized views"
+
+#define RRDVIEWS_PRECISION 1000
+#define RRDVIEWS_MAX_LABEL_VALUE 200
+#define RRDVIEWS_UNSET_LABEL_VALUE "[unset]"
+
+#define WORKER_JOB_VIEWS_COLLECT 0
+#define WORKER_JOB_VIEWS_UPDATE 1
+
+struct rrdview_group {
+    RRDDIM *rd;
+    NETDATA_DOUBLE value;
+    size_t count;
+};
+
+typedef struct rrdview {
+    char *name;
+    STRING *context;
+    char *label_key;
+    RRDR_GROUP_BY_FUNCTION aggregation;
+
+    STRING *title;                  // the title of the first chart found
+    STRING *units;                  // the units of the first chart found
+
+    RRDSET *st;
+    DICTIONARY *groups;             // label value -> struct rrdview_group
+
+    struct rrdview *prev, *next;
+} RRDVIEW;
+
+static RRDVIEW *rrdviews = NULL;
+
+static bool rrdviews_config_cb(void *data __maybe_unused, const char *name, const char *value) {
+    char buf[CONFIG_MAX_VALUE + 1];
+    strncpyz(buf, value, CONFIG_MAX_VALUE);
+
+    char *words[3] = { NULL, NULL, NULL };
+    size_t num_words = quoted_strings_splitter_whitespace(buf, words, 3);
+    if(num_words < 2 || !words[0] || !*words[0] || !words[1] || !*words[1]) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "VIEWS: materialized view '%s' has invalid definition '%s' - expected 'CONTEXT LABEL_KEY [AGGREGATION]'",
+               name, value);
+        return false;
+    }
+
+    RRDR_GROUP_BY_FUNCTION aggregation = RRDR_GROUP_BY_FUNCTION_AVERAGE;
+    if(num_words > 2 && words[2] && *words[2]) {
+        aggregation = group_by_aggregate_function_parse(words[2]);
+        if(aggregation == RRDR_GROUP_BY_FUNCTION_PERCENTAGE) {
+            nd_log(NDLS_DAEMON, NDLP_ERR,
+                   "VIEWS: materialized view '%s' cannot use aggregation '%s' - using average",
+                   name, words[2]);
+            aggregation = RRDR_GROUP_BY_FUNCTION_AVERAGE;
+        }
+    }
+
+    RRDVIEW *v = callocz(1, sizeof(RRDVIEW));
+    v->name = strdupz(name);
+    v->context = string_strdupz(words[0]);
+    v->label_key = strdupz(words[1]);
+    v->aggregation = aggregation;
+    v->groups = dictionary_create_advanced(
+            DICT_OPTION_SINGLE_THREADED | DICT_OPTION_FIXED_SIZE | DICT_OPTION_DONT_OVERWRITE_VALUE,
+            NULL, sizeof(struct rrdview_group));
+
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(rrdviews, v, prev, next);
+
+    nd_log(NDLS_DAEMON, NDLP_INFO,
+           "VIEWS: materialized view '%s' aggregates context '%s' by label '%s', using %s",
+           v->name, string2str(v->context), v->label_key, group_by_aggregate_function_to_string(v->aggregation));
+
+    return true;
+}
+
+static void rrdviews_free_all(void) {
+    while(rrdviews) {
+        RRDVIEW *v = rrdviews;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(rrdviews, v, prev, next);
+
+        dictionary_destroy(v->groups);
+        string_freez(v->title);
+        string_freez(v->units);
+        string_freez(v->context);
+        freez(v->label_key);
+        freez(v->name);
+        freez(v);
+    }
+}
+
+static void rrdview_create_chart(RRDVIEW *v, int update_every) {
+    char context[RRD_ID_LENGTH_MAX + 1];
+    snprintfz(context, RRD_ID_LENGTH_MAX, "views.%s", v->name);
+
+    char title[RRD_ID_LENGTH_MAX + 1];
+    snprintfz(title, RRD_ID_LENGTH_MAX, "%s of %s by %s",
+              group_by_aggregate_function_to_string(v->aggregation), string2str(v->title), v->label_key);
+
+    v->st = rrdset_create_localhost(
+            "views"
+            , v->name
+            , NULL
+            , string2str(v->context)
+            , context
+            , title
+            , string2str(v->units)
+            , "netdata"
+            , "views"
+            , 150000
+            , update_every
+            , RRDSET_TYPE_LINE);
+
+    rrdlabels_add(v->st->rrdlabels, "_view_of", string2str(v->context), RRDLABEL_SRC_AUTO);
+}
+
+static inline void rrdview_add_value(RRDVIEW *v, const char *label_value, NETDATA_DOUBLE value) {
+    struct rrdview_group *g = dictionary_set(v->groups, label_value, NULL, sizeof(*g));
+
+    if(!g->count)
+        g->value = value;
+    else {
+        switch(v->aggregation) {
+            default:
+            case RRDR_GROUP_BY_FUNCTION_AVERAGE:
+            case RRDR_GROUP_BY_FUNCTION_SUM:
+                g->value += value;
+                break;
+
+            case RRDR_GROUP_BY_FUNCTION_MIN:
+                if(value < g->value)
+                    g->value = value;
+                break;
+
+            case RRDR_GROUP_BY_FUNCTION_MAX:
+                if(value > g->value)
+                    g->value = value;
+                break;
+        }
+    }
+
+    g->count++;
+}
+
+static void rrdview_collect_chart(RRDVIEW *v, RRDSET *st, time_t now_s) {
+    if(rrdset_flag_check(st, RRDSET_FLAG_OBSOLETE))
+        return;
+
+    if(!v->units) {
+        v->title = string_dup(st->title);
+        v->units = string_dup(st->units);
+    }
+
+    char label_value[RRDVIEWS_MAX_LABEL_VALUE + 1];
+    label_value[0] = '\0';
+    rrdlabels_get_value_strcpyz(st->rrdlabels, label_value, RRDVIEWS_MAX_LABEL_VALUE, v->label_key);
+    if(!*label_value)
+        strncpyz(label_value, RRDVIEWS_UNSET_LABEL_VALUE, RRDVIEWS_MAX_LABEL_VALUE);
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st) {
+        if(rrddim_flag_check(rd, RRDDIM_FLAG_OBSOLETE) || rrddim_option_check(rd, RRDDIM_OPTION_HIDDEN))
+            continue;
+
+        // skip dimensions not collected recently
+        if(rd->collector.last_collected_time.tv_sec < now_s - 2 * st->update_every)
+            continue;
+
+        NETDATA_DOUBLE value = rd->collector.last_stored_value;
+        if(!netdata_double_isnumber(value))
+            continue;
+
+        rrdview_add_value(v, label_value, value);
+    }
+    rrddim_foreach_done(rd);
+}
+
+static void rrdviews_collect(time_t now_s) {
+    rrd_rdlock();
+
+    RRDHOST *host;
+    rrdhost_foreach_read(host) {
+        if(rrdhost_flag_check(host, RRDHOST_FLAG_ARCHIVED))
+            continue;
+
+        RRDSET *st;
+        rrdset_foreach_read(st, host) {
+            for(RRDVIEW *v = rrdviews; v ; v = v->next) {
+                // contexts are interned strings, so pointer equality is enough
+                if(st->context == v->context && st != v->st)
+                    rrdview_collect_chart(v, st, now_s);
+            }
+        }
+        rrdset_foreach_done(st);
+    }
+
+    rrd_rdunlock();
+}
+
+// charts and dimensions are created here, outside the locks of the hosts and charts we aggregate
+static void rrdviews_update_charts(int update_every) {
+    for(RRDVIEW *v = rrdviews; v ; v = v->next) {
+        if(!dictionary_entries(v->groups))
+            continue;
+
+        if(!v->st)
+            rrdview_create_chart(v, update_every);
+
+        struct rrdview_group *g;
+        dfe_start_read(v->groups, g) {
+            if(!g->rd)
+                g->rd = rrddim_add(v->st, g_dfe.name, NULL, 1, RRDVIEWS_PRECISION, RRD_ALGORITHM_ABSOLUTE);
+
+            if(g->count) {
+                NETDATA_DOUBLE value = g->value;
+                if(v->aggregation == RRDR_GROUP_BY_FUNCTION_AVERAGE)
+                    value /= (NETDATA_DOUBLE)g->count;
+
+                rrddim_set_by_pointer(v->st, g->rd, (collected_number)(value * RRDVIEWS_PRECISION));
+            }
+
+            g->count = 0;
+        }
+        dfe_done(g);
+
+        rrdset_done(v->st);
+    }
+}
+
+static void rrdviews_cleanup(void *pptr) {
+    struct netdata_static_thread *static_thread = CLEANUP_FUNCTION_GET_PTR(pptr);
+    if(!static_thread) return;
+
+    static_thread->enabled = NETDATA_MAIN_THREAD_EXITING;
+
+    worker_unregister();
+    rrdviews_free_all();
+    netdata_log_info("cleaning up...");
+
+    static_thread->enabled = NETDATA_MAIN_THREAD_EXITED;
+}
+
+void *rrdviews_main(void *ptr) {
+    CLEANUP_FUNCTION_REGISTER(rrdviews_cleanup) cleanup_ptr = ptr;
+
+    appconfig_foreach_value_in_section(&netdata_config, CONFIG_SECTION_MATERIALIZED_VIEWS, rrdviews_config_cb, NULL);
+    if(!rrdviews)
+        return NULL;
+
+    worker_register("VIEWS");
+    worker_register_job_name(WORKER_JOB_VIEWS_COLLECT, "collect");
+    worker_register_job_name(WORKER_JOB_VIEWS_UPDATE, "update");
+
+    int update_every = localhost->rrd_update_every;
+    heartbeat_t hb;
+    heartbeat_init(&hb);
+
+    while(service_running(SERVICE_COLLECTORS)) {
+        worker_is_idle();
+        heartbeat_next(&hb, update_every * USEC_PER_SEC);
+
+        if(!service_running(SERVICE_COLLECTORS))
+            break;
+
+        worker_is_busy(WORKER_JOB_VIEWS_COLLECT);
+        rrdviews_collect(now_realtime_sec());
+
+        worker_is_busy(WORKER_JOB_VIEWS_UPDATE);
+        rrdviews_update_charts(update_every);
+    }
+
+    return NULL;
+}
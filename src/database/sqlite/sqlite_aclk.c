@@ -20,6 +20,19 @@ struct aclk_sync_config_s {
     bool initialized;
     mqtt_wss_client client;
     int aclk_queries_running;
+    int aclk_queries_running_per_priority[ACLK_QUERY_PRIORITY_MAX];
+    int query_thread_count;
+    int max_background_queries;
+    int max_queries_per_requester;
+    Pvoid_t requesters_JudyL;               // requester -> running queries
+
+    // the queries waiting for a query thread, by priority
+    // accessed only by the event loop thread
+    struct {
+        aclk_query_t base;
+        size_t count;
+    } pending[ACLK_QUERY_PRIORITY_MAX];
+
     SPINLOCK cmd_queue_lock;
     struct aclk_database_cmd *cmd_base;
 } aclk_sync_config = { 0 };
@@ -304,15 +317,84 @@ struct aclk_query_payload {
     uv_work_t request;
     void *data;
     struct aclk_sync_config_s *config;
+    ACLK_QUERY_PRIORITY priority;
+    uint64_t requester;
 };
 
+static int aclk_requester_running(struct aclk_sync_config_s *config, uint64_t requester)
+{
+    if (!requester)
+        return 0;
+
+    Pvoid_t *PValue = JudyLGet(config->requesters_JudyL, (Word_t)requester, PJE0);
+    return PValue ? (int)(intptr_t)*PValue : 0;
+}
+
+static void aclk_requester_running_add(struct aclk_sync_config_s *config, uint64_t requester, int delta)
+{
+    if (!requester)
+        return;
+
+    Pvoid_t *PValue = JudyLIns(&config->requesters_JudyL, (Word_t)requester, PJE0);
+    intptr_t running = (intptr_t)*PValue + delta;
+    if (running > 0)
+        *PValue = (void *)running;
+    else
+        (void)JudyLDel(&config->requesters_JudyL, (Word_t)requester, PJE0);
+}
+
+static void aclk_query_enqueue(struct aclk_sync_config_s *config, aclk_query_t query)
+{
+    aclk_query_classify(query);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(config->pending[query->priority].base, query, prev, next);
+    config->pending[query->priority].count++;
+}
+
+// the oldest query of this priority whose requester has not reached its limit
+// queries the cloud is no longer waiting for are answered with a timeout, without running them
+static aclk_query_t aclk_query_dequeue(struct aclk_sync_config_s *config, ACLK_QUERY_PRIORITY priority, usec_t now_ut)
+{
+    aclk_query_t query = config->pending[priority].base;
+    while (query) {
+        aclk_query_t next = query->next;
+
+        bool expired = aclk_query_expired(query, now_ut);
+        if (expired || !config->max_queries_per_requester ||
+            aclk_requester_running(config, query->requester) < config->max_queries_per_requester) {
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(config->pending[priority].base, query, prev, next);
+            config->pending[priority].count--;
+
+            if (!expired)
+                return query;
+
+            http_api_v2_timeout(config->client, query);
+            aclk_query_free(query);
+            global_statistics_aclk_query_expired();
+        }
+
+        query = next;
+    }
+
+    return NULL;
+}
+
+static void aclk_query_finished(struct aclk_sync_config_s *config, struct aclk_query_payload *payload)
+{
+    config->aclk_queries_running--;
+    config->aclk_queries_running_per_priority[payload->priority]--;
+    aclk_requester_running_add(config, payload->requester, -1);
+    freez(payload);
+}
+
+static void aclk_query_dispatch(struct aclk_sync_config_s *config);
+
 static void after_aclk_run_query_job(uv_work_t *req, int status __maybe_unused)
 {
     worker_is_busy(ACLK_QUERY_EXECUTE);
     struct aclk_query_payload *payload = req->data;
     struct aclk_sync_config_s *config = payload->config;
-    config->aclk_queries_running--;
-    freez(payload);
+    aclk_query_finished(config, payload);
+    aclk_query_dispatch(config);
 }
 
 static void aclk_run_query(struct aclk_sync_config_s *config, aclk_query_t query)
@@ -339,6 +421,68 @@ static void aclk_run_query_job(uv_work_t *req)
     aclk_run_query(config, query);
 }
 
+static void aclk_query_start(struct aclk_sync_config_s *config, aclk_query_t query, usec_t now_ut)
+{
+    global_statistics_aclk_query_dispatched(
+        query->priority == ACLK_QUERY_PRIORITY_BACKGROUND, now_ut > query->queued_ut ? now_ut - query->queued_ut : 0);
+
+    struct aclk_query_payload *payload = mallocz(sizeof(*payload));
+    payload->request.data = payload;
+    payload->config = config;
+    payload->data = query;
+    payload->priority = query->priority;
+    payload->requester = query->requester;
+
+    config->aclk_queries_running++;
+    config->aclk_queries_running_per_priority[payload->priority]++;
+    aclk_requester_running_add(config, payload->requester, 1);
+
+    if (uv_queue_work(&config->loop, &payload->request, aclk_run_query_job, after_aclk_run_query_job)) {
+        worker_is_busy(ACLK_QUERY_EXECUTE_SYNC);
+        aclk_run_query(config, query);
+        aclk_query_finished(config, payload);
+    }
+}
+
+// start pending queries while there are free query threads
+// interactive queries go first; background queries are limited, so that
+// there is always a thread available for interactive queries
+static void aclk_query_dispatch(struct aclk_sync_config_s *config)
+{
+    usec_t now_ut = now_monotonic_high_precision_usec();
+
+    while (config->aclk_queries_running < config->query_thread_count) {
+        aclk_query_t query = aclk_query_dequeue(config, ACLK_QUERY_PRIORITY_INTERACTIVE, now_ut);
+
+        if (!query && config->aclk_queries_running_per_priority[ACLK_QUERY_PRIORITY_BACKGROUND] < config->max_background_queries)
+            query = aclk_query_dequeue(config, ACLK_QUERY_PRIORITY_BACKGROUND, now_ut);
+
+        if (!query)
+            break;
+
+        aclk_query_start(config, query, now_ut);
+    }
+
+    global_statistics_aclk_queries_pending(
+        config->pending[ACLK_QUERY_PRIORITY_INTERACTIVE].count,
+        config->pending[ACLK_QUERY_PRIORITY_BACKGROUND].count,
+        config->aclk_queries_running);
+}
+
+static void aclk_query_pending_cleanup(struct aclk_sync_config_s *config)
+{
+    for (size_t priority = 0; priority < ACLK_QUERY_PRIORITY_MAX; priority++) {
+        while (config->pending[priority].base) {
+            aclk_query_t query = config->pending[priority].base;
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(config->pending[priority].base, query, prev, next);
+            aclk_query_free(query);
+        }
+        config->pending[priority].count = 0;
+    }
+
+    JudyLFreeArray(&config->requesters_JudyL, PJE0);
+}
+
 static int read_query_thread_count()
 {
     int threads = MIN(get_netdata_cpus()/2, 6);
@@ -387,8 +531,18 @@ static void aclk_synchronization(void *arg)
 
     sql_delete_aclk_table_list();
 
-    int query_thread_count = read_query_thread_count();
-    netdata_log_info("Starting ACLK synchronization thread with %d parallel query threads", query_thread_count);
+    config->query_thread_count = read_query_thread_count();
+    config->max_background_queries = MAX(config->query_thread_count - 1, 1);
+    config->max_queries_per_requester = (int)config_get_number(
+        CONFIG_SECTION_CLOUD, "query threads per account", MAX(config->query_thread_count / 2, 1));
+    if (config->max_queries_per_requester < 0)
+        config->max_queries_per_requester = 0;
+
+    netdata_log_info(
+        "Starting ACLK synchronization thread with %d parallel query threads (%d for background queries, %d per account)",
+        config->query_thread_count,
+        config->max_background_queries,
+        config->max_queries_per_requester);
 
     while (likely(service_running(SERVICE_ACLK))) {
         enum aclk_database_opcode opcode;
@@ -435,26 +589,9 @@ static void aclk_synchronization(void *arg)
                     config->client = (mqtt_wss_client) cmd.param[0];
                     break;
 
-                case ACLK_QUERY_EXECUTE:;
-                    aclk_query_t query = (aclk_query_t)cmd.param[0];
-
-                    struct aclk_query_payload *payload = NULL;
-                    config->aclk_queries_running++;
-                    bool execute_now = (config->aclk_queries_running > query_thread_count);
-                    if (!execute_now) {
-                        payload = mallocz(sizeof(*payload));
-                        payload->request.data = payload;
-                        payload->config = config;
-                        payload->data = query;
-                        execute_now = uv_queue_work(loop, &payload->request, aclk_run_query_job, after_aclk_run_query_job);
-                    }
-
-                    if (execute_now) {
-                        worker_is_busy(ACLK_QUERY_EXECUTE_SYNC);
-                        aclk_run_query(config, query);
-                        freez(payload);
-                        config->aclk_queries_running--;
-                    }
+                case ACLK_QUERY_EXECUTE:
+                    aclk_query_enqueue(config, (aclk_query_t)cmd.param[0]);
+                    aclk_query_dispatch(config);
                     break;
 
                 default:
@@ -469,6 +606,8 @@ static void aclk_synchronization(void *arg)
     uv_close((uv_handle_t *)&config->async, NULL);
     (void) uv_loop_close(loop);
 
+    aclk_query_pending_cleanup(config);
+
     worker_unregister();
     service_exits();
     netdata_log_info("ACLK SYNC: Shutting down ACLK synchronization event loop");
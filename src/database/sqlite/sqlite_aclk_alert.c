@@ -421,17 +421,20 @@ void health_alarm_log_populate(
     " AND hl.host_id = @host_id AND aq.host_id = hl.host_id AND hl.health_log_id = hld.health_log_id"                  \
     " ORDER BY aq.sequence_id ASC LIMIT "ACLK_MAX_ALERT_UPDATES
 
-static void aclk_push_alert_event(RRDHOST *host __maybe_unused)
+// send the next ACLK_MAX_ALERT_UPDATES queued alerts of the host
+// returns the number of alerts sent, and adds the bytes sent to *bytes
+static size_t aclk_push_alert_event_batch(RRDHOST *host, size_t *bytes)
 {
+    size_t sent = 0;
     CLAIM_ID claim_id = claim_id_get();
 
     if (!claim_id_is_set(claim_id) || UUIDiszero(host->node_id))
-        return;
+        return 0;
 
     sqlite3_stmt *res = NULL;
 
     if (!PREPARE_STATEMENT(db_meta, SQL_SELECT_ALERT_TO_PUSH, &res))
-        return;
+        return 0;
 
     int param = 0;
     SQLITE_BIND_FAIL(done, sqlite3_bind_blob(res, ++param, &host->host_id.uuid, sizeof(host->host_id.uuid), SQLITE_STATIC));
@@ -451,8 +454,9 @@ static void aclk_push_alert_event(RRDHOST *host __maybe_unused)
     struct aclk_sync_cfg_t *wc = host->aclk_config;
     while (sqlite3_step_monitored(res) == SQLITE_ROW) {
         health_alarm_log_populate(&alarm_log, res, host, &status);
-        aclk_send_alarm_log_entry(&alarm_log);
+        *bytes += aclk_send_alarm_log_entry(&alarm_log);
         wc->alert_count++;
+        sent++;
 
         last_id = alarm_log.sequence_id;
         if (first_id == 0)
@@ -481,6 +485,24 @@ static void aclk_push_alert_event(RRDHOST *host __maybe_unused)
 done:
     REPORT_BIND_FAIL(res, param);
     SQLITE_FINALIZE(res);
+    return sent;
+}
+
+// a pending backlog of alerts (e.g. after a restart) is sent in batches,
+// until the queue is empty, or the bytes or the time allowed per push are exhausted
+#define ACLK_MAX_ALERT_BYTES_PER_PUSH (256 * 1024)
+#define ACLK_MAX_ALERT_TIME_PER_PUSH_UT (100 * USEC_PER_MS)
+
+static void aclk_push_alert_event(RRDHOST *host)
+{
+    size_t bytes = 0;
+    usec_t stop_ut = now_monotonic_usec() + ACLK_MAX_ALERT_TIME_PER_PUSH_UT;
+
+    while (aclk_push_alert_event_batch(host, &bytes) &&
+           bytes < ACLK_MAX_ALERT_BYTES_PER_PUSH &&
+           now_monotonic_usec() < stop_ut &&
+           service_running(SERVICE_ACLK))
+        ;
 }
 
 #define SQL_DELETE_PROCESSED_ROWS "DELETE FROM alert_queue WHERE host_id = @host_id AND rowid = @row"
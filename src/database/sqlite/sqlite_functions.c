@@ -86,6 +86,7 @@ int configure_sqlite_database(sqlite3 *database, int target_version, const char
     const char *def_temp_store = "MEMORY";
     long long def_journal_size_limit = 16777216;
     long long def_cache_size = -2000;
+    long long def_mmap_size = 0;
 
     // https://www.sqlite.org/pragma.html#pragma_auto_vacuum
     // PRAGMA schema.auto_vacuum = 0 | NONE | 1 | FULL | 2 | INCREMENTAL;
@@ -136,6 +137,14 @@ int configure_sqlite_database(sqlite3 *database, int target_version, const char
     if (init_database_batch(database, list, description))
         return 1;
 
+    // https://www.sqlite.org/pragma.html#pragma_mmap_size
+    // PRAGMA schema.mmap_size = N ;
+    snprintfz(buf, sizeof(buf) - 1, "PRAGMA mmap_size=%lld", def_mmap_size);
+    if (config_exists(CONFIG_SECTION_SQLITE, "mmap size"))
+        snprintfz(buf, sizeof(buf) - 1, "PRAGMA mmap_size=%lld", config_get_number(CONFIG_SECTION_SQLITE, "mmap size", def_mmap_size));
+    if (init_database_batch(database, list, description))
+        return 1;
+
     snprintfz(buf, sizeof(buf) - 1, "PRAGMA user_version=%d", target_version);
     if (init_database_batch(database, list, description))
         return 1;
@@ -147,12 +147,17 @@ sqlite3 *db_meta = NULL;
     "plugin=excluded.plugin, module=excluded.module, priority=excluded.priority, update_every=excluded.update_every, " \
     "chart_type=excluded.chart_type, memory_mode = excluded.memory_mode, history_entries = excluded.history_entries"
 
-#define SQL_STORE_DIMENSION                                                                                            \
-    "INSERT INTO dimension (dim_id, chart_id, id, name, multiplier, divisor , algorithm, options) "                    \
-    "VALUES (@dim_id, @chart_id, @id, @name, @multiplier, @divisor, @algorithm, @options) "                            \
-    "ON CONFLICT(dim_id) DO UPDATE SET id=excluded.id, name=excluded.name, multiplier=excluded.multiplier, "           \
+#define SQL_STORE_DIMENSION_PREFIX                                                                                     \
+    "INSERT INTO dimension (dim_id, chart_id, id, name, multiplier, divisor , algorithm, options) VALUES "
+
+#define SQL_STORE_DIMENSION_ROW "(?, ?, ?, ?, ?, ?, ?, ?)"
+
+#define SQL_STORE_DIMENSION_ON_CONFLICT                                                                                \
+    " ON CONFLICT(dim_id) DO UPDATE SET id=excluded.id, name=excluded.name, multiplier=excluded.multiplier, "          \
     "divisor=excluded.divisor, algorithm=excluded.algorithm, options=excluded.options"
 
+#define SQL_STORE_DIMENSION SQL_STORE_DIMENSION_PREFIX SQL_STORE_DIMENSION_ROW SQL_STORE_DIMENSION_ON_CONFLICT
+
 #define SELECT_DIMENSION_LIST "SELECT dim_id, rowid FROM dimension WHERE rowid > @row_id"
 #define SELECT_CHART_LIST "SELECT chart_id, rowid FROM chart WHERE rowid > @row_id"
 #define SELECT_CHART_LABEL_LIST "SELECT chart_id, rowid FROM chart_label WHERE rowid > @row_id"
@@ -177,6 +182,9 @@ sqlite3 *db_meta = NULL;
 #define METADATA_HOST_CHECK_IMMEDIATE (5)           // Repeat immediate run because we have more metadata to write
 #define MAX_METADATA_CLEANUP (500)                  // Maximum metadata write operations (e.g  deletes before retrying)
 #define METADATA_MAX_BATCH_SIZE (512)               // Maximum commands to execute before running the event loop
+#define METADATA_DIMENSION_BATCH_SIZE (64)          // Dimensions stored with one statement (8 parameters each)
+#define METADATA_MAX_TRANSACTION_SIZE (10000)       // Statements to execute before committing the metadata transaction
+#define METADATA_WAL_CHECKPOINT_IDLE (2)            // Seconds without metadata writes before checkpointing the WAL
 
 #define DATABASE_FREE_PAGES_THRESHOLD_PC (5)        // Percentage of free pages to trigger vacuum
 #define DATABASE_FREE_PAGES_VACUUM_PC (10)          // Percentage of free pages to vacuum
@@ -191,6 +199,7 @@ enum metadata_opcode {
     METADATA_LOAD_HOST_CONTEXT,
     METADATA_DELETE_HOST_CHART_LABELS,
     METADATA_MAINTENANCE,
+    METADATA_WAL_CHECKPOINT,
     METADATA_SYNC_SHUTDOWN,
     METADATA_UNITTEST,
     // leave this last
@@ -207,8 +216,9 @@ struct metadata_cmd {
 };
 
 typedef enum {
-    METADATA_FLAG_PROCESSING    = (1 << 0), // store or cleanup
-    METADATA_FLAG_SHUTDOWN      = (1 << 1), // Shutting down
+    METADATA_FLAG_PROCESSING        = (1 << 0), // store or cleanup
+    METADATA_FLAG_SHUTDOWN          = (1 << 1), // Shutting down
+    METADATA_FLAG_WAL_CHECKPOINT    = (1 << 2), // Metadata was written, checkpoint the WAL when idle
 } METADATA_FLAG;
 
 struct metadata_wc {
@@ -217,6 +227,7 @@ struct metadata_wc {
     uv_async_t async;
     uv_timer_t timer_req;
     time_t metadata_check_after;
+    time_t wal_checkpoint_after;
     METADATA_FLAG flags;
     struct completion start_stop_complete;
     struct completion *scan_complete;
@@ -1093,34 +1104,83 @@ bind_fail:
 }
 
 /*
- * Store a dimension
+ * Store dimensions
+ *
+ * The dimensions of a host scan are queued and stored with multi-row upserts of
+ * METADATA_DIMENSION_BATCH_SIZE rows. The rows left when the scan ends use the
+ * single row statement.
  */
-static int store_dimension_metadata(RRDDIM *rd)
+
+struct dimension_metadata_row {
+    nd_uuid_t dim_id;
+    nd_uuid_t chart_id;
+    STRING *id;
+    STRING *name;
+    int32_t multiplier;
+    int32_t divisor;
+    RRD_ALGORITHM algorithm;
+    bool hidden;
+};
+
+struct dimension_metadata_batch {
+    size_t used;
+    size_t failed;
+    struct dimension_metadata_row rows[METADATA_DIMENSION_BATCH_SIZE];
+};
+
+// the hash of everything we store for a dimension, never zero
+static uint32_t dimension_metadata_hash(RRDDIM *rd)
 {
-    static __thread sqlite3_stmt *res = NULL;
-    int rc, param = 0;
+    int64_t values[] = {
+        rd->multiplier,
+        rd->divisor,
+        rd->algorithm,
+        rrddim_option_check(rd, RRDDIM_OPTION_HIDDEN) ? 1 : 0,
+    };
 
-    if (!PREPARE_COMPILED_STATEMENT(db_meta, SQL_STORE_DIMENSION, &res))
-        return 1;
+    XXH64_hash_t hash = XXH3_64bits(values, sizeof(values));
+    hash = XXH3_64bits_withSeed(string2str(rd->id), string_strlen(rd->id), hash);
+    hash = XXH3_64bits_withSeed(string2str(rd->name), string_strlen(rd->name), hash);
 
-    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_blob(res, ++param, &rd->metric_uuid, sizeof(rd->metric_uuid), SQLITE_STATIC));
-    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_blob(res, ++param, &rd->rrdset->chart_uuid, sizeof(rd->rrdset->chart_uuid), SQLITE_STATIC));
-    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_text(res, ++param, string2str(rd->id), -1, SQLITE_STATIC));
-    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_text(res, ++param, string2str(rd->name), -1, SQLITE_STATIC));
-    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_int(res, ++param, (int) rd->multiplier));
-    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_int(res, ++param, (int ) rd->divisor));
-    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_int(res, ++param, rd->algorithm));
-    if (rrddim_option_check(rd, RRDDIM_OPTION_HIDDEN))
-        SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_text(res, ++param, "hidden", -1, SQLITE_STATIC));
+    return (uint32_t)hash | 1;
+}
+
+static int bind_dimension_metadata(sqlite3_stmt *res, int *param, struct dimension_metadata_row *row)
+{
+    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_blob(res, ++(*param), &row->dim_id, sizeof(row->dim_id), SQLITE_STATIC));
+    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_blob(res, ++(*param), &row->chart_id, sizeof(row->chart_id), SQLITE_STATIC));
+    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_text(res, ++(*param), string2str(row->id), -1, SQLITE_STATIC));
+    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_text(res, ++(*param), string2str(row->name), -1, SQLITE_STATIC));
+    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_int(res, ++(*param), (int) row->multiplier));
+    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_int(res, ++(*param), (int) row->divisor));
+    SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_int(res, ++(*param), row->algorithm));
+    if (row->hidden)
+        SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_text(res, ++(*param), "hidden", -1, SQLITE_STATIC));
     else
-        SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_null(res, ++param));
+        SQLITE_BIND_FAIL(bind_fail, sqlite3_bind_null(res, ++(*param)));
 
-    rc = execute_insert(res);
+    return 0;
+
+bind_fail:
+    return 1;
+}
+
+// execute the statement with rows [first, first + count) of the batch bound to it
+static int store_dimension_metadata_rows(sqlite3_stmt *res, struct dimension_metadata_batch *batch, size_t first, size_t count)
+{
+    int param = 0;
+
+    for (size_t i = first; i < first + count; i++) {
+        if (bind_dimension_metadata(res, &param, &batch->rows[i]))
+            goto bind_fail;
+    }
+
+    int rc = execute_insert(res);
     if (unlikely(rc != SQLITE_DONE))
-        error_report("Failed to store dimension, rc = %d", rc);
+        error_report("Failed to store %zu dimension(s), rc = %d", count, rc);
 
     SQLITE_RESET(res);
-    return 0;
+    return rc != SQLITE_DONE;
 
 bind_fail:
     REPORT_BIND_FAIL(res, param);
@@ -1128,10 +1188,90 @@ bind_fail:
     return 1;
 }
 
+static sqlite3_stmt *dimension_metadata_multirow_statement(void)
+{
+    static __thread sqlite3_stmt *res = NULL;
+
+    if (likely(res))
+        return res;
+
+    CLEAN_BUFFER *wb = buffer_create(1024, NULL);
+    buffer_strcat(wb, SQL_STORE_DIMENSION_PREFIX);
+    for (size_t i = 0; i < METADATA_DIMENSION_BATCH_SIZE; i++) {
+        if (i)
+            buffer_strcat(wb, ", ");
+        buffer_strcat(wb, SQL_STORE_DIMENSION_ROW);
+    }
+    buffer_strcat(wb, SQL_STORE_DIMENSION_ON_CONFLICT);
+
+    if (!PREPARE_COMPILED_STATEMENT(db_meta, buffer_tostring(wb), &res))
+        return NULL;
+
+    return res;
+}
+
+static void dimension_metadata_batch_flush(struct dimension_metadata_batch *batch)
+{
+    static __thread sqlite3_stmt *single_res = NULL;
+
+    if (!batch->used)
+        return;
+
+    size_t first = 0;
+    if (batch->used == METADATA_DIMENSION_BATCH_SIZE) {
+        sqlite3_stmt *res = dimension_metadata_multirow_statement();
+        if (likely(res) && !store_dimension_metadata_rows(res, batch, 0, batch->used))
+            first = batch->used;
+    }
+
+    if (first < batch->used && PREPARE_COMPILED_STATEMENT(db_meta, SQL_STORE_DIMENSION, &single_res)) {
+        for (size_t i = first; i < batch->used; i++)
+            batch->failed += store_dimension_metadata_rows(single_res, batch, i, 1);
+    }
+    else if (first < batch->used)
+        batch->failed += batch->used - first;
+
+    for (size_t i = 0; i < batch->used; i++) {
+        string_freez(batch->rows[i].id);
+        string_freez(batch->rows[i].name);
+    }
+
+    batch->used = 0;
+}
+
+// queue a dimension to be stored, unless what we last stored for it is unchanged
+static bool store_dimension_metadata(struct dimension_metadata_batch *batch, RRDDIM *rd)
+{
+    uint32_t hash = dimension_metadata_hash(rd);
+    if (hash == rd->metadata_saved_hash)
+        return false;
+
+    struct dimension_metadata_row *row = &batch->rows[batch->used++];
+    uuid_copy(row->dim_id, rd->metric_uuid);
+    uuid_copy(row->chart_id, rd->rrdset->chart_uuid);
+    row->id = string_dup(rd->id);
+    row->name = string_dup(rd->name);
+    row->multiplier = rd->multiplier;
+    row->divisor = rd->divisor;
+    row->algorithm = rd->algorithm;
+    row->hidden = rrddim_option_check(rd, RRDDIM_OPTION_HIDDEN);
+
+    rd->metadata_saved_hash = hash;
+
+    if (batch->used == METADATA_DIMENSION_BATCH_SIZE)
+        dimension_metadata_batch_flush(batch);
+
+    return true;
+}
+
 static bool dimension_can_be_deleted(nd_uuid_t *dim_uuid __maybe_unused, sqlite3_stmt **res __maybe_unused, bool flag __maybe_unused)
 {
 #ifdef ENABLE_DBENGINE
     if(dbengine_enabled) {
+        // the retention of the tiers still loading is not known yet
+        if(!rrdeng_all_tiers_ready())
+            return false;
+
         bool no_retention = true;
         for (size_t tier = 0; tier < storage_tiers; tier++) {
             if (!multidb_ctx[tier])
@@ -1553,10 +1693,18 @@ static void timer_cb(uv_timer_t* handle)
    struct metadata_cmd cmd;
    memset(&cmd, 0, sizeof(cmd));
 
-   if (wc->metadata_check_after <  now_realtime_sec()) {
+   time_t now_s = now_realtime_sec();
+
+   if (wc->metadata_check_after <  now_s) {
        cmd.opcode = METADATA_SCAN_HOSTS;
        metadata_enq_cmd(wc, &cmd);
    }
+   else if (metadata_flag_check(wc, METADATA_FLAG_WAL_CHECKPOINT) &&
+            !metadata_flag_check(wc, METADATA_FLAG_PROCESSING) && wc->wal_checkpoint_after < now_s) {
+       metadata_flag_clear(wc, METADATA_FLAG_WAL_CHECKPOINT);
+       cmd.opcode = METADATA_WAL_CHECKPOINT;
+       metadata_enq_cmd(wc, &cmd);
+   }
 }
 
 void vacuum_database(sqlite3 *database, const char *db_alias, int threshold, int vacuum_pc)
@@ -1596,6 +1744,7 @@ void run_metadata_cleanup(struct metadata_wc *wc)
 
     vacuum_database(db_meta, "METADATA", DATABASE_FREE_PAGES_THRESHOLD_PC, DATABASE_FREE_PAGES_VACUUM_PC);
 
+    metadata_flag_clear(wc, METADATA_FLAG_WAL_CHECKPOINT);
     (void) sqlite3_wal_checkpoint(db_meta, NULL);
 }
 
@@ -1757,7 +1906,30 @@ static void after_metadata_hosts(uv_work_t *req, int status __maybe_unused)
     freez(data);
 }
 
-static bool metadata_scan_host(RRDHOST *host, uint32_t max_count, bool use_transaction, BUFFER *work_buffer, size_t *query_counter) {
+// the dimensions of a chart waiting for their ML models, loaded with one query
+struct ml_models_load_batch {
+    size_t used;
+    RRDDIM_ACQUIRED *rda[ML_MODELS_LOAD_BATCH_SIZE];
+};
+
+static void ml_models_load_batch_flush(struct ml_models_load_batch *batch, sqlite3_stmt **stmt)
+{
+    if (!batch->used)
+        return;
+
+    RRDDIM *rds[ML_MODELS_LOAD_BATCH_SIZE];
+    for (size_t i = 0; i < batch->used; i++)
+        rds[i] = rrddim_acquired_to_rrddim(batch->rda[i]);
+
+    (void) ml_dimensions_load_models(rds, batch->used, stmt);
+
+    for (size_t i = 0; i < batch->used; i++)
+        rrddim_acquired_release(batch->rda[i]);
+
+    batch->used = 0;
+}
+
+static bool metadata_scan_host(RRDHOST *host, uint32_t max_count, BUFFER *work_buffer, size_t *query_counter) {
     RRDSET *st;
     int rc;
 
@@ -1768,8 +1940,8 @@ static bool metadata_scan_host(RRDHOST *host, uint32_t max_count, bool use_trans
 
     bool load_ml_models = max_count;
 
-    if (use_transaction)
-        (void)db_execute(db_meta, "BEGIN TRANSACTION");
+    struct dimension_metadata_batch dimensions = { .used = 0, .failed = 0 };
+    struct ml_models_load_batch ml_models = { .used = 0 };
 
     rrdset_foreach_reentrant(st, host) {
         if (scan_count == max_count) {
@@ -1789,9 +1961,15 @@ static bool metadata_scan_host(RRDHOST *host, uint32_t max_count, bool use_trans
             else
                 (*query_counter)++;
 
-            rc = store_chart_metadata(st);
-            if (unlikely(rc))
-               error_report("METADATA: 'host:%s': Failed to store metadata for chart %s", rrdhost_hostname(host), rrdset_name(st));
+            // the chart is stored only when its metadata version changed since we last stored it
+            uint32_t version = rrdset_metadata_version(st);
+            if (version != st->metadata_last_saved_version) {
+                rc = store_chart_metadata(st);
+                if (unlikely(rc))
+                    error_report("METADATA: 'host:%s': Failed to store metadata for chart %s", rrdhost_hostname(host), rrdset_name(st));
+                else
+                    st->metadata_last_saved_version = version;
+            }
         }
 
         RRDDIM *rd;
@@ -1806,27 +1984,32 @@ static bool metadata_scan_host(RRDHOST *host, uint32_t max_count, bool use_trans
                 else
                     rrddim_flag_clear(rd, RRDDIM_FLAG_META_HIDDEN);
 
-                rc = store_dimension_metadata(rd);
-                if (unlikely(rc))
-                    error_report("METADATA: 'host:%s': Failed to dimension metadata for chart %s. dimension %s",
-                                 rrdhost_hostname(host), rrdset_name(st),
-                                 rrddim_name(rd));
+                (void) store_dimension_metadata(&dimensions, rd);
             }
 
             if(rrddim_flag_check(rd, RRDDIM_FLAG_ML_MODEL_LOAD)) {
                 rrddim_flag_clear(rd, RRDDIM_FLAG_ML_MODEL_LOAD);
-                if (likely(load_ml_models))
-                    (void) ml_dimension_load_models(rd, &ml_load_stmt);
+                if (likely(load_ml_models)) {
+                    ml_models.rda[ml_models.used++] =
+                        (RRDDIM_ACQUIRED *)dictionary_acquired_item_dup(st->rrddim_root_index, rd_dfe.item);
+
+                    if (ml_models.used == ML_MODELS_LOAD_BATCH_SIZE)
+                        ml_models_load_batch_flush(&ml_models, &ml_load_stmt);
+                }
             }
 
             worker_is_idle();
         }
         rrddim_foreach_done(rd);
+
+        // the dimensions are acquired, but not past the chart they belong to
+        ml_models_load_batch_flush(&ml_models, &ml_load_stmt);
     }
     rrdset_foreach_done(st);
 
-    if (use_transaction)
-        (void)db_execute(db_meta, "COMMIT TRANSACTION");
+    dimension_metadata_batch_flush(&dimensions);
+    if (unlikely(dimensions.failed))
+        error_report("METADATA: 'host:%s': Failed to store the metadata of %zu dimensions", rrdhost_hostname(host), dimensions.failed);
 
     SQLITE_FINALIZE(ml_load_stmt);
     ml_load_stmt = NULL;
@@ -1905,8 +2088,10 @@ static void start_metadata_hosts(uv_work_t *req __maybe_unused)
     bool run_again = false;
     worker_is_busy(UV_EVENT_METADATA_STORE);
 
-    if (!data->max_count)
-        transaction_started = !db_execute(db_meta, "BEGIN TRANSACTION");
+    // all hosts are stored in large transactions, committed every METADATA_MAX_TRANSACTION_SIZE
+    // statements, so that other database work does not wait for long
+    size_t transaction_queries = 0;
+    transaction_started = !db_execute(db_meta, "BEGIN TRANSACTION");
 
     dfe_start_reentrant(rrdhost_root_index, host) {
         if (rrdhost_flag_check(host, RRDHOST_FLAG_ARCHIVED) || !rrdhost_flag_check(host, RRDHOST_FLAG_METADATA_UPDATE))
@@ -1961,12 +2146,17 @@ static void start_metadata_hosts(uv_work_t *req __maybe_unused)
             store_host_and_system_info(host, &query_counter);
         }
 
-        // For clarity
-        bool use_transaction = data->max_count;
-        if (unlikely(metadata_scan_host(host, data->max_count, use_transaction, work_buffer, &query_counter))) {
+        if (unlikely(metadata_scan_host(host, data->max_count, work_buffer, &query_counter))) {
             run_again = true;
             rrdhost_flag_set(host,RRDHOST_FLAG_METADATA_UPDATE);
         }
+
+        transaction_queries += query_counter;
+        if (transaction_started && transaction_queries >= METADATA_MAX_TRANSACTION_SIZE) {
+            (void) db_execute(db_meta, "COMMIT TRANSACTION");
+            transaction_started = !db_execute(db_meta, "BEGIN TRANSACTION");
+            transaction_queries = 0;
+        }
         usec_t ended_ut = now_monotonic_usec(); (void)ended_ut;
         nd_log(
             NDLS_DAEMON,
@@ -1978,7 +2168,7 @@ static void start_metadata_hosts(uv_work_t *req __maybe_unused)
     }
     dfe_done(host);
 
-    if (!data->max_count && transaction_started)
+    if (transaction_started)
         transaction_started = db_execute(db_meta, "COMMIT TRANSACTION");
 
     usec_t all_ended_ut = now_monotonic_usec(); (void)all_ended_ut;
@@ -1988,8 +2178,13 @@ static void start_metadata_hosts(uv_work_t *req __maybe_unused)
         "Checking all hosts completed in %0.2f ms",
         (double)(all_ended_ut - all_started_ut) / USEC_PER_MS);
 
-    if (unlikely(run_again))
+    if (unlikely(run_again)) {
         wc->metadata_check_after = now_realtime_sec() + METADATA_HOST_CHECK_IMMEDIATE;
+
+        // checkpoint between the runs, while the database is idle
+        wc->wal_checkpoint_after = now_realtime_sec() + METADATA_WAL_CHECKPOINT_IDLE;
+        metadata_flag_set(wc, METADATA_FLAG_WAL_CHECKPOINT);
+    }
     else {
         wc->metadata_check_after = now_realtime_sec() + METADATA_HOST_CHECK_INTERVAL;
         run_metadata_cleanup(wc);
@@ -2006,6 +2201,7 @@ static void metadata_event_loop(void *arg)
     worker_register_job_name(METADATA_STORE_CLAIM_ID,       "add claim id");
     worker_register_job_name(METADATA_ADD_HOST_INFO,        "add host info");
     worker_register_job_name(METADATA_MAINTENANCE,          "maintenance");
+    worker_register_job_name(METADATA_WAL_CHECKPOINT,       "wal checkpoint");
 
     int ret;
     uv_loop_t *loop;
@@ -2151,6 +2347,11 @@ static void metadata_event_loop(void *arg)
                         *PValue = (void *) cmd.param[0];
 
                     break;
+                case METADATA_WAL_CHECKPOINT:
+                    // a passive checkpoint does not wait for readers or writers
+                    if (likely(!metadata_flag_check(wc, METADATA_FLAG_PROCESSING)))
+                        (void) sqlite3_wal_checkpoint_v2(db_meta, NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL);
+                    break;
                 case METADATA_UNITTEST:;
                     struct thread_unittest *tu = (struct thread_unittest *) cmd.param[0];
                     sleep_usec(1000); // processing takes 1ms
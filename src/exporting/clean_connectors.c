@@ -67,6 +67,8 @@ void simple_connector_cleanup(struct instance *instance)
         freez(current_buffer);
     }
 
+    simple_connector_spill_cleanup(instance);
+
     netdata_ssl_close(&simple_connector_data->ssl);
 
     freez(simple_connector_data);
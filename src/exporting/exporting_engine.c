@@ -68,6 +68,9 @@ void analytics_exporting_connectors(BUFFER *b)
                 buffer_strcat(b, "MongoDB");
 #endif
                 break;
+            case EXPORTING_CONNECTOR_TYPE_OTLP:
+                buffer_strcat(b, "OTLP");
+                break;
             default:
                 buffer_strcat(b, "Unknown");
         }
@@ -58,6 +58,7 @@ typedef enum exporting_connector_types {
     EXPORTING_CONNECTOR_TYPE_KINESIS,                 // Send message to AWS Kinesis
     EXPORTING_CONNECTOR_TYPE_PUBSUB,                  // Send message to Google Cloud Pub/Sub
     EXPORTING_CONNECTOR_TYPE_MONGODB,                 // Send data to MongoDB collection
+    EXPORTING_CONNECTOR_TYPE_OTLP,                    // Send data using OpenTelemetry OTLP/HTTP protobuf
     EXPORTING_CONNECTOR_TYPE_NUM                      // Number of exporting connector types
 } EXPORTING_CONNECTOR_TYPE;
 
@@ -77,6 +78,8 @@ struct instance_config {
 
     int update_every;
     int buffer_on_failures;
+    long spill_on_failures_mb;
+    long backfill_on_failures;
     long timeoutms;
 
     EXPORTING_OPTIONS options;
@@ -99,6 +102,10 @@ struct simple_connector_buffer {
     size_t buffered_metrics;
     size_t buffered_bytes;
 
+    // the timeframe of the batch
+    time_t after;
+    time_t before;
+
     int used;
 
     struct simple_connector_buffer *next;
@@ -124,11 +131,29 @@ struct simple_connector_data {
     struct simple_connector_buffer *first_buffer;
     struct simple_connector_buffer *last_buffer;
 
+    // buffers that did not fit in the ring, while the destination was not reachable
+    struct {
+        char *filename;
+        int fd;
+        size_t max_bytes;
+        off_t read_offset;
+        off_t write_offset;
+        size_t loaded_size;
+    } spill;
+
     NETDATA_SSL ssl;
 };
 
 struct prometheus_remote_write_specific_config {
     char *remote_write_path;
+    int protocol_version;
+};
+
+struct otlp_specific_config {
+    struct simple_connector_config simple;      // the simple connector worker expects it first
+    char *url_path;
+    int compression;
+    int compression_level;
 };
 
 struct aws_kinesis_specific_config {
@@ -166,6 +191,7 @@ struct stats {
     collected_number reconnects;
     collected_number transmission_failures;
     collected_number receptions;
+    collected_number transmission_latency_ut;   // reported by the connectors that measure it
 
     int initialized;
 
@@ -190,6 +216,9 @@ struct stats {
     RRDSET *st_rusage;
     RRDDIM *rd_user;
     RRDDIM *rd_system;
+
+    RRDSET *st_latency;
+    RRDDIM *rd_latency;
 };
 
 struct instance {
@@ -208,6 +237,14 @@ struct instance {
     time_t after;
     time_t before;
 
+    // the timeframe of the batches that have been lost, to be queried again from the database
+    struct {
+        time_t after;
+        time_t before;
+        time_t live_after;              // the after of the live batches, while a backfill batch is prepared
+        int running;
+    } backfill;
+
     uv_thread_t thread;
     uv_mutex_t mutex;
     uv_cond_t cond_var;
@@ -260,6 +297,7 @@ int init_connectors(struct engine *engine);
 void simple_connector_init(struct instance *instance);
 
 int mark_scheduled_instances(struct engine *engine);
+bool exporting_backfill_schedule(struct instance *instance);
 void prepare_buffers(struct engine *engine);
 
 size_t exporting_name_copy(char *dst, const char *src, size_t max_len);
@@ -292,6 +330,13 @@ void simple_connector_send_buffer(
     int *sock, int *failures, struct instance *instance, BUFFER *header, BUFFER *buffer, size_t buffered_metrics);
 void simple_connector_worker(void *instance_p);
 
+void simple_connector_spill_init(struct instance *instance);
+bool simple_connector_spill_buffer(struct instance *instance, BUFFER *header, BUFFER *buffer, size_t buffered_metrics);
+bool simple_connector_spill_pending(struct instance *instance);
+bool simple_connector_spill_load(struct instance *instance, BUFFER *header, BUFFER *buffer, size_t *buffered_metrics);
+void simple_connector_spill_sent(struct instance *instance);
+void simple_connector_spill_cleanup(struct instance *instance);
+
 void create_main_rusage_chart(RRDSET **st_rusage, RRDDIM **rd_user, RRDDIM **rd_system);
 void send_main_rusage(RRDSET *st_rusage, RRDDIM *rd_user, RRDDIM *rd_system);
 void send_internal_metrics(struct instance *instance);
@@ -309,6 +354,7 @@ static inline void disable_instance(struct instance *instance)
 
 #include "exporting/prometheus/prometheus.h"
 #include "exporting/opentsdb/opentsdb.h"
+#include "exporting/otlp/otlp.h"
 #ifdef ENABLE_PROMETHEUS_REMOTE_WRITE
 #include "exporting/prometheus/remote_write/remote_write.h"
 #endif
@@ -84,6 +84,10 @@ int init_connectors(struct engine *engine)
                     return 1;
 #endif
                 break;
+            case EXPORTING_CONNECTOR_TYPE_OTLP:
+                if (init_otlp_instance(instance) != 0)
+                    return 1;
+                break;
             default:
                 netdata_log_error("EXPORTING: unknown exporting connector type");
                 return 1;
@@ -192,6 +196,8 @@ void simple_connector_init(struct instance *instance)
     first_buffer->next = connector_specific_data->first_buffer;
     connector_specific_data->last_buffer = connector_specific_data->first_buffer;
 
+    simple_connector_spill_init(instance);
+
     if (*instance->config.username || *instance->config.password) {
         BUFFER *auth_string = buffer_create(0, &netdata_buffers_statistics.buffers_exporters);
 
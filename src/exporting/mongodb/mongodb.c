@@ -53,6 +53,10 @@ int mongodb_init(struct instance *instance)
     connector_specific_data->collection = mongoc_client_get_collection(
         connector_specific_data->client, connector_specific_config->database, connector_specific_config->collection);
 
+    // the documents are independent, so the server does not have to stop at the first failed one,
+    // and it can apply the rest of them in any order
+    connector_specific_data->insert_opts = BCON_NEW("ordered", BCON_BOOL(false));
+
     mongoc_uri_destroy(uri);
 
     // create a ring buffer
@@ -138,19 +142,97 @@ int init_mongodb_instance(struct instance *instance)
 }
 
 /**
- * Free an array of BSON structures
+ * Destroy the documents of a BSON buffer, keeping its arrays
  *
- * @param insert an array of documents.
- * @param documents_inserted the number of documents inserted.
+ * @param bson_buffer a BSON buffer.
  */
-void free_bson(bson_t **insert, size_t documents_inserted)
+static void bson_buffer_destroy_documents(struct bson_buffer *bson_buffer)
 {
-    size_t i;
+    for (size_t i = 0; i < bson_buffer->documents_inserted; i++)
+        bson_destroy(&bson_buffer->documents[i]);
 
-    for (i = 0; i < documents_inserted; i++)
-        bson_destroy(insert[i]);
+    bson_buffer->documents_inserted = 0;
+}
 
-    freez(insert);
+/**
+ * Free the documents and the arrays of a BSON buffer
+ *
+ * @param bson_buffer a BSON buffer.
+ */
+static void bson_buffer_free(struct bson_buffer *bson_buffer)
+{
+    bson_buffer_destroy_documents(bson_buffer);
+
+    freez(bson_buffer->documents);
+    freez(bson_buffer->insert);
+    bson_buffer->documents = NULL;
+    bson_buffer->insert = NULL;
+    bson_buffer->size = 0;
+}
+
+/**
+ * Move the arrays of a BSON buffer to another one
+ *
+ * @param dst the BSON buffer to get the arrays, it has to have none.
+ * @param src the BSON buffer to give its arrays.
+ */
+static void bson_buffer_move(struct bson_buffer *dst, struct bson_buffer *src)
+{
+    dst->documents = src->documents;
+    dst->insert = src->insert;
+    dst->size = src->size;
+
+    src->documents = NULL;
+    src->insert = NULL;
+    src->size = 0;
+}
+
+/**
+ * Recycle a BSON buffer that has been sent or dropped
+ *
+ * Its documents are destroyed, and the bigger arrays are kept as the spare ones of the instance,
+ * so that the next batches do not allocate them again. Has to be called with the instance mutex locked.
+ *
+ * @param connector_specific_data the MongoDB connector specific data.
+ * @param bson_buffer a BSON buffer.
+ */
+static void bson_buffer_recycle(struct mongodb_specific_data *connector_specific_data, struct bson_buffer *bson_buffer)
+{
+    bson_buffer_destroy_documents(bson_buffer);
+
+    if (bson_buffer->size > connector_specific_data->spare.size) {
+        bson_buffer_free(&connector_specific_data->spare);
+        bson_buffer_move(&connector_specific_data->spare, bson_buffer);
+    }
+    else
+        bson_buffer_free(bson_buffer);
+}
+
+/**
+ * Make room in an empty BSON buffer for a number of documents
+ *
+ * @param connector_specific_data the MongoDB connector specific data.
+ * @param bson_buffer an empty BSON buffer.
+ * @param documents the number of documents.
+ */
+static void bson_buffer_reserve(
+    struct mongodb_specific_data *connector_specific_data,
+    struct bson_buffer *bson_buffer,
+    size_t documents)
+{
+    if (bson_buffer->size >= documents)
+        return;
+
+    bson_buffer_free(bson_buffer);
+
+    if (connector_specific_data->spare.size >= documents) {
+        bson_buffer_move(bson_buffer, &connector_specific_data->spare);
+        return;
+    }
+
+    bson_buffer->documents = mallocz(documents * sizeof(bson_t));
+    bson_buffer->insert = mallocz(documents * sizeof(bson_t *));
+    bson_buffer->size = documents;
 }
 
 /**
@@ -165,16 +247,15 @@ int format_batch_mongodb(struct instance *instance)
         (struct mongodb_specific_data *)instance->connector_specific_data;
     struct stats *stats = &instance->stats;
 
-    bson_t **insert = connector_specific_data->last_buffer->insert;
-    if (insert) {
+    struct bson_buffer *bson_buffer = connector_specific_data->last_buffer;
+    if (bson_buffer->insert) {
         // ring buffer is full, reuse the oldest element
         connector_specific_data->first_buffer = connector_specific_data->first_buffer->next;
-        free_bson(insert, connector_specific_data->last_buffer->documents_inserted);
-        connector_specific_data->total_documents_inserted -= connector_specific_data->last_buffer->documents_inserted;
-        stats->buffered_bytes -= connector_specific_data->last_buffer->buffered_bytes;
+        connector_specific_data->total_documents_inserted -= bson_buffer->documents_inserted;
+        stats->buffered_bytes -= bson_buffer->buffered_bytes;
+        bson_buffer_recycle(connector_specific_data, bson_buffer);
     }
-    insert = callocz((size_t)stats->buffered_metrics, sizeof(bson_t *));
-    connector_specific_data->last_buffer->insert = insert;
+    bson_buffer_reserve(connector_specific_data, bson_buffer, (size_t)stats->buffered_metrics + 1);
 
     BUFFER *buffer = (BUFFER *)instance->buffer;
     char *start = (char *)buffer_tostring(buffer);
@@ -182,7 +263,7 @@ int format_batch_mongodb(struct instance *instance)
 
     size_t documents_inserted = 0;
 
-    while (*end && documents_inserted <= (size_t)stats->buffered_metrics) {
+    while (*end && documents_inserted < bson_buffer->size) {
         while (*end && *end != '\n')
             end++;
 
@@ -194,14 +275,14 @@ int format_batch_mongodb(struct instance *instance)
         }
 
         bson_error_t bson_error;
-        insert[documents_inserted] = bson_new_from_json((const uint8_t *)start, -1, &bson_error);
-
-        if (unlikely(!insert[documents_inserted])) {
+        if (unlikely(!bson_init_from_json(&bson_buffer->documents[documents_inserted], start, -1, &bson_error))) {
             netdata_log_error(
                 "EXPORTING: Failed creating a BSON document from a JSON string \"%s\" : %s", start, bson_error.message);
-            free_bson(insert, documents_inserted);
+            bson_buffer->documents_inserted = documents_inserted;
+            bson_buffer_recycle(connector_specific_data, bson_buffer);
             return 1;
         }
+        bson_buffer->insert[documents_inserted] = &bson_buffer->documents[documents_inserted];
 
         start = end;
 
@@ -218,8 +299,8 @@ int format_batch_mongodb(struct instance *instance)
     stats->buffered_metrics = 0;
     connector_specific_data->total_documents_inserted += documents_inserted;
 
-    connector_specific_data->last_buffer->documents_inserted = documents_inserted;
-    connector_specific_data->last_buffer = connector_specific_data->last_buffer->next;
+    bson_buffer->documents_inserted = documents_inserted;
+    connector_specific_data->last_buffer = bson_buffer->next;
 
     return 0;
 }
@@ -236,6 +317,7 @@ void mongodb_cleanup(struct instance *instance)
     struct mongodb_specific_data *connector_specific_data =
         (struct mongodb_specific_data *)instance->connector_specific_data;
 
+    bson_destroy(connector_specific_data->insert_opts);
     mongoc_collection_destroy(connector_specific_data->collection);
     mongoc_client_destroy(connector_specific_data->client);
     if (instance->engine->mongoc_initialized) {
@@ -250,10 +332,10 @@ void mongodb_cleanup(struct instance *instance)
         struct bson_buffer *current_buffer = next_buffer;
         next_buffer = next_buffer->next;
 
-        if (current_buffer->insert)
-            free_bson(current_buffer->insert, current_buffer->documents_inserted);
+        bson_buffer_free(current_buffer);
         freez(current_buffer);
     }
+    bson_buffer_free(&connector_specific_data->spare);
 
     freez(connector_specific_data);
 
@@ -315,13 +397,15 @@ void mongodb_connector_worker(void *instance_p)
         stats->transmission_failures =
         stats->data_lost_events =
         stats->lost_bytes =
-        stats->reconnects = 0;
+        stats->reconnects =
+        stats->transmission_latency_ut = 0;
 
-        bson_t **insert = connector_specific_data->first_buffer->insert;
-        size_t documents_inserted = connector_specific_data->first_buffer->documents_inserted;
+        // take the batch out of the ring buffer, so that it can be filled again while we send it
+        struct bson_buffer sending = { 0 };
+        bson_buffer_move(&sending, connector_specific_data->first_buffer);
+        size_t documents_inserted = sending.documents_inserted = connector_specific_data->first_buffer->documents_inserted;
         size_t buffered_bytes = connector_specific_data->first_buffer->buffered_bytes;
 
-        connector_specific_data->first_buffer->insert = NULL;
         connector_specific_data->first_buffer->documents_inserted = 0;
         connector_specific_data->first_buffer->buffered_bytes = 0;
         connector_specific_data->first_buffer = connector_specific_data->first_buffer->next;
@@ -330,7 +414,7 @@ void mongodb_connector_worker(void *instance_p)
 
         size_t data_size = 0;
         for (size_t i = 0; i < documents_inserted; i++) {
-            data_size += insert[i]->len;
+            data_size += sending.documents[i].len;
         }
 
         netdata_log_debug(
@@ -343,13 +427,17 @@ void mongodb_connector_worker(void *instance_p)
 
         if (likely(documents_inserted != 0)) {
             bson_error_t bson_error;
-            if (likely(mongoc_collection_insert_many(
-                    connector_specific_data->collection,
-                    (const bson_t **)insert,
-                    documents_inserted,
-                    NULL,
-                    NULL,
-                    &bson_error))) {
+            usec_t started_ut = now_monotonic_usec();
+            bool inserted = mongoc_collection_insert_many(
+                connector_specific_data->collection,
+                (const bson_t **)sending.insert,
+                documents_inserted,
+                connector_specific_data->insert_opts,
+                NULL,
+                &bson_error);
+            stats->transmission_latency_ut = (collected_number)(now_monotonic_usec() - started_ut);
+
+            if (likely(inserted)) {
                 stats->sent_metrics = documents_inserted;
                 stats->sent_bytes += data_size;
                 stats->transmission_successes++;
@@ -369,13 +457,15 @@ void mongodb_connector_worker(void *instance_p)
             }
         }
 
-        free_bson(insert, documents_inserted);
-
-        if (unlikely(instance->engine->exit))
+        if (unlikely(instance->engine->exit)) {
+            bson_buffer_free(&sending);
             break;
+        }
 
         uv_mutex_lock(&instance->mutex);
 
+        bson_buffer_recycle(connector_specific_data, &sending);
+
         stats->buffered_metrics = connector_specific_data->total_documents_inserted;
 
         send_internal_metrics(instance);
@@ -8,7 +8,9 @@
 #include <mongoc.h>
 
 struct bson_buffer {
-    bson_t **insert;
+    bson_t *documents;      // the documents of a batch, parsed from its JSON lines
+    bson_t **insert;        // pointers to the documents, as the inserts need them
+    size_t size;            // the number of documents the arrays can hold
     size_t documents_inserted;
     size_t buffered_bytes;
 
@@ -18,11 +20,15 @@ struct bson_buffer {
 struct mongodb_specific_data {
     mongoc_client_t *client;
     mongoc_collection_t *collection;
+    bson_t *insert_opts;
 
     size_t total_documents_inserted;
 
     struct bson_buffer *first_buffer;
     struct bson_buffer *last_buffer;
+
+    // the arrays of the last batch sent, to be reused by the next batch
+    struct bson_buffer spare;
 };
 
 int mongodb_init(struct instance *instance);
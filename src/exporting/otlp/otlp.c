@@ -0,0 +1,444 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "otlp.h"
+
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// OTLP/HTTP protobuf encoding of opentelemetry.proto.collector.metrics.v1.ExportMetricsServiceRequest
+//
+// Every host is a ResourceMetrics with one ScopeMetrics, every chart is a Metric (a Gauge, or a cumulative
+// monotonic Sum when all its dimensions are incremental and the data are sent as collected) and every
+// dimension is a NumberDataPoint of its chart.
+
+#define OTLP_DEFAULT_PORT 4318
+
+#define OTLP_AGGREGATION_TEMPORALITY_CUMULATIVE 2
+
+static inline size_t otlp_varint_len(uint64_t v)
+{
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Add a KeyValue with a string AnyValue
+ *
+ * @param wb the buffer of the message the attribute belongs to.
+ * @param field the field of the attribute in the message.
+ * @param key the key of the attribute.
+ * @param value the value of the attribute.
+ */
+static void otlp_attribute(BUFFER *wb, uint32_t field, const char *key, const char *value)
+{
+    size_t key_len = strlen(key);
+    size_t value_len = strlen(value);
+
+    size_t any_value_len = 1 + otlp_varint_len(value_len) + value_len;
+    size_t key_value_len = 1 + otlp_varint_len(key_len) + key_len + 1 + otlp_varint_len(any_value_len) + any_value_len;
+
+    buffer_protobuf_tag(wb, field, BUFFER_PROTOBUF_WIRE_BYTES);
+    buffer_protobuf_varint(wb, key_value_len);
+    buffer_protobuf_bytes(wb, 1, key, key_len);
+
+    buffer_protobuf_tag(wb, 2, BUFFER_PROTOBUF_WIRE_BYTES);
+    buffer_protobuf_varint(wb, any_value_len);
+    buffer_protobuf_bytes(wb, 1, value, value_len);
+}
+
+static inline void otlp_message(BUFFER *wb, uint32_t field, BUFFER *message)
+{
+    buffer_protobuf_bytes(wb, field, buffer_tostring(message), buffer_strlen(message));
+}
+
+/**
+ * Initialize OTLP connector instance
+ *
+ * @param instance an instance data structure.
+ * @return Returns 0 on success, 1 on failure.
+ */
+int init_otlp_instance(struct instance *instance)
+{
+    instance->worker = simple_connector_worker;
+
+    struct otlp_specific_config *connector_specific_config = instance->config.connector_specific_config;
+    connector_specific_config->simple.default_port = OTLP_DEFAULT_PORT;
+
+    struct simple_connector_data *simple_connector_data = callocz(1, sizeof(struct simple_connector_data));
+    instance->connector_specific_data = simple_connector_data;
+
+    simple_connector_data->ssl = NETDATA_SSL_UNSET_CONNECTION;
+    if (instance->config.options & EXPORTING_OPTION_USE_TLS) {
+        netdata_ssl_initialize_ctx(NETDATA_SSL_EXPORTING_CTX);
+    }
+
+    struct otlp_specific_data *connector_specific_data = callocz(1, sizeof(struct otlp_specific_data));
+    simple_connector_data->connector_specific_data = (void *)connector_specific_data;
+
+    connector_specific_data->resource = buffer_create(0, &netdata_buffers_statistics.buffers_exporters);
+    connector_specific_data->metrics = buffer_create(0, &netdata_buffers_statistics.buffers_exporters);
+    connector_specific_data->points = buffer_create(0, &netdata_buffers_statistics.buffers_exporters);
+    connector_specific_data->tmp = buffer_create(0, &netdata_buffers_statistics.buffers_exporters);
+    connector_specific_data->tmp2 = buffer_create(0, &netdata_buffers_statistics.buffers_exporters);
+
+    instance->start_batch_formatting = NULL;
+    instance->start_host_formatting = format_host_otlp;
+    instance->start_chart_formatting = format_chart_otlp;
+    instance->metric_formatting = format_dimension_otlp;
+    instance->end_chart_formatting = format_chart_end_otlp;
+    instance->variables_formatting = NULL;
+    instance->end_host_formatting = format_host_end_otlp;
+    instance->end_batch_formatting = format_batch_otlp;
+
+    instance->prepare_header = otlp_prepare_header;
+    instance->check_response = process_otlp_response;
+
+    instance->buffer = (void *)buffer_create(0, &netdata_buffers_statistics.buffers_exporters);
+
+    simple_connector_init(instance);
+
+    if (uv_mutex_init(&instance->mutex))
+        return 1;
+    if (uv_cond_init(&instance->cond_var))
+        return 1;
+
+    return 0;
+}
+
+/**
+ * Release specific data allocated.
+ *
+ * @param instance an instance data structure.
+ */
+void clean_otlp_instance(struct instance *instance)
+{
+    struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+    struct otlp_specific_data *connector_specific_data = simple_connector_data->connector_specific_data;
+
+    buffer_free(connector_specific_data->resource);
+    buffer_free(connector_specific_data->metrics);
+    buffer_free(connector_specific_data->points);
+    buffer_free(connector_specific_data->tmp);
+    buffer_free(connector_specific_data->tmp2);
+    freez(connector_specific_data);
+
+    struct otlp_specific_config *connector_specific_config = instance->config.connector_specific_config;
+    freez(connector_specific_config->url_path);
+}
+
+static int format_otlp_label_callback(const char *name, const char *value, RRDLABEL_SRC ls, void *data)
+{
+    struct instance *instance = (struct instance *)data;
+    struct otlp_specific_data *connector_specific_data =
+        ((struct simple_connector_data *)instance->connector_specific_data)->connector_specific_data;
+
+    if (!should_send_label(instance, ls))
+        return 0;
+
+    otlp_attribute(connector_specific_data->resource, 1, name, value);
+    return 1;
+}
+
+/**
+ * Format host data for OTLP connector
+ *
+ * @param instance an instance data structure.
+ * @param host a data collecting host.
+ * @return Always returns 0.
+ */
+int format_host_otlp(struct instance *instance, RRDHOST *host)
+{
+    struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+    struct otlp_specific_data *connector_specific_data = simple_connector_data->connector_specific_data;
+
+    buffer_flush(connector_specific_data->resource);
+    buffer_flush(connector_specific_data->metrics);
+
+    otlp_attribute(connector_specific_data->resource, 1, "service.name", rrdhost_program_name(host));
+    otlp_attribute(connector_specific_data->resource, 1, "service.version", rrdhost_program_version(host));
+    otlp_attribute(
+        connector_specific_data->resource, 1, "host.name",
+        (host == localhost) ? instance->config.hostname : rrdhost_hostname(host));
+    otlp_attribute(connector_specific_data->resource, 1, "host.id", host->machine_guid);
+
+    if (unlikely(sending_labels_configured(instance)))
+        rrdlabels_walkthrough_read(host->rrdlabels, format_otlp_label_callback, instance);
+
+    return 0;
+}
+
+/**
+ * Format chart data for OTLP connector
+ *
+ * @param instance an instance data structure.
+ * @param st a chart.
+ * @return Always returns 0.
+ */
+int format_chart_otlp(struct instance *instance, RRDSET *st)
+{
+    struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+    struct otlp_specific_data *connector_specific_data = simple_connector_data->connector_specific_data;
+
+    buffer_flush(connector_specific_data->points);
+    connector_specific_data->points_count = 0;
+    connector_specific_data->monotonic_sum = false;
+
+    if (EXPORTING_OPTIONS_DATA_SOURCE(instance->config.options) == EXPORTING_SOURCE_DATA_AS_COLLECTED) {
+        bool incremental = true;
+        size_t dimensions = 0;
+
+        RRDDIM *rd;
+        rrddim_foreach_read(rd, st) {
+            dimensions++;
+            if (rd->algorithm != RRD_ALGORITHM_INCREMENTAL) {
+                incremental = false;
+                break;
+            }
+        }
+        rrddim_foreach_done(rd);
+
+        connector_specific_data->monotonic_sum = incremental && dimensions;
+    }
+
+    return 0;
+}
+
+/**
+ * Format dimension data for OTLP connector
+ *
+ * @param instance an instance data structure.
+ * @param rd a dimension.
+ * @return Always returns 0.
+ */
+int format_dimension_otlp(struct instance *instance, RRDDIM *rd)
+{
+    struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+    struct otlp_specific_data *connector_specific_data = simple_connector_data->connector_specific_data;
+    RRDSET *st = rd->rrdset;
+    BUFFER *point = connector_specific_data->tmp;
+
+    buffer_flush(point);
+
+    bool send_names = instance->config.options & EXPORTING_OPTION_SEND_NAMES;
+    otlp_attribute(point, 7, "chart", (send_names && st->name) ? rrdset_name(st) : rrdset_id(st));
+    otlp_attribute(point, 7, "family", rrdset_family(st));
+    otlp_attribute(point, 7, "dimension", (send_names && rd->name) ? rrddim_name(rd) : rrddim_id(rd));
+
+    if (EXPORTING_OPTIONS_DATA_SOURCE(instance->config.options) == EXPORTING_SOURCE_DATA_AS_COLLECTED) {
+        if (unlikely(!rd->collector.counter || rd->collector.last_collected_time.tv_sec < instance->after))
+            return 0;
+
+        buffer_protobuf_fixed64(
+            point, 3,
+            (uint64_t)rd->collector.last_collected_time.tv_sec * NSEC_PER_SEC +
+                (uint64_t)rd->collector.last_collected_time.tv_usec * NSEC_PER_USEC);
+        buffer_protobuf_fixed64(point, 6, (uint64_t)(int64_t)rd->collector.last_collected_value);
+    }
+    else {
+        time_t last_t;
+        NETDATA_DOUBLE value = exporting_calculate_value_from_stored_data(instance, rd, &last_t);
+
+        if (isnan(value) || isinf(value))
+            return 0;
+
+        buffer_protobuf_fixed64(point, 3, (uint64_t)last_t * NSEC_PER_SEC);
+        buffer_protobuf_double(point, 4, (double)value);
+    }
+
+    otlp_message(connector_specific_data->points, 1, point);
+    connector_specific_data->points_count++;
+
+    return 0;
+}
+
+/**
+ * Close the Metric of a chart for OTLP connector
+ *
+ * @param instance an instance data structure.
+ * @param st a chart.
+ * @return Always returns 0.
+ */
+int format_chart_end_otlp(struct instance *instance, RRDSET *st)
+{
+    struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+    struct otlp_specific_data *connector_specific_data = simple_connector_data->connector_specific_data;
+
+    if (!connector_specific_data->points_count)
+        return 0;
+
+    BUFFER *points = connector_specific_data->points;
+    BUFFER *name = connector_specific_data->tmp;
+    BUFFER *metric = connector_specific_data->tmp2;
+
+    buffer_flush(name);
+    buffer_sprintf(name, "%s.%s", instance->config.prefix, rrdset_context(st));
+
+    buffer_flush(metric);
+    buffer_protobuf_bytes(metric, 1, buffer_tostring(name), buffer_strlen(name));
+    buffer_protobuf_string(metric, 2, rrdset_title(st));
+    buffer_protobuf_string(metric, 3, rrdset_units(st));
+
+    if (connector_specific_data->monotonic_sum) {
+        buffer_protobuf_tag(points, 2, BUFFER_PROTOBUF_WIRE_VARINT);
+        buffer_protobuf_varint(points, OTLP_AGGREGATION_TEMPORALITY_CUMULATIVE);
+        buffer_protobuf_tag(points, 3, BUFFER_PROTOBUF_WIRE_VARINT);
+        buffer_protobuf_varint(points, 1);
+        otlp_message(metric, 7, points);
+    }
+    else
+        otlp_message(metric, 5, points);
+
+    otlp_message(connector_specific_data->metrics, 2, metric);
+
+    buffer_flush(points);
+    connector_specific_data->points_count = 0;
+
+    return 0;
+}
+
+/**
+ * Close the ResourceMetrics of a host for OTLP connector
+ *
+ * @param instance an instance data structure.
+ * @param host a data collecting host.
+ * @return Always returns 0.
+ */
+int format_host_end_otlp(struct instance *instance, RRDHOST *host __maybe_unused)
+{
+    struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+    struct otlp_specific_data *connector_specific_data = simple_connector_data->connector_specific_data;
+
+    if (!buffer_strlen(connector_specific_data->metrics))
+        return 0;
+
+    BUFFER *scope = connector_specific_data->tmp;
+    BUFFER *scope_metrics = connector_specific_data->tmp2;
+
+    // InstrumentationScope
+    buffer_flush(scope);
+    buffer_protobuf_string(scope, 1, "netdata");
+    buffer_protobuf_string(scope, 2, NETDATA_VERSION);
+
+    // ScopeMetrics
+    buffer_flush(scope_metrics);
+    otlp_message(scope_metrics, 1, scope);
+    buffer_memcat(
+        scope_metrics, buffer_tostring(connector_specific_data->metrics), buffer_strlen(connector_specific_data->metrics));
+
+    // ResourceMetrics
+    BUFFER *resource_metrics = scope;
+    buffer_flush(resource_metrics);
+    otlp_message(resource_metrics, 1, connector_specific_data->resource);
+    otlp_message(resource_metrics, 2, scope_metrics);
+
+    otlp_message(instance->buffer, 1, resource_metrics);
+
+    buffer_flush(connector_specific_data->metrics);
+
+    return 0;
+}
+
+/**
+ * Compress a batch for OTLP connector
+ *
+ * @param instance an instance data structure.
+ * @return Returns 0 on success, 1 on failure.
+ */
+int format_batch_otlp(struct instance *instance)
+{
+#ifdef ENABLE_ZSTD
+    struct otlp_specific_config *connector_specific_config = instance->config.connector_specific_config;
+    BUFFER *buffer = instance->buffer;
+
+    if (connector_specific_config->compression && buffer_strlen(buffer)) {
+        struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+        struct otlp_specific_data *connector_specific_data = simple_connector_data->connector_specific_data;
+        BUFFER *compressed = connector_specific_data->tmp;
+
+        size_t bound = ZSTD_compressBound(buffer_strlen(buffer));
+        buffer_flush(compressed);
+        buffer_need_bytes(compressed, bound);
+
+        size_t size = ZSTD_compress(
+            compressed->buffer, bound, buffer_tostring(buffer), buffer_strlen(buffer),
+            connector_specific_config->compression_level);
+
+        if (ZSTD_isError(size)) {
+            netdata_log_error(
+                "EXPORTING: cannot compress OTLP batch for instance %s: %s",
+                instance->config.name, ZSTD_getErrorName(size));
+            return 1;
+        }
+
+        compressed->len = size;
+        buffer_contents_replace(buffer, buffer_tostring(compressed), buffer_strlen(compressed));
+    }
+#endif
+
+    simple_connector_end_batch(instance);
+
+    return 0;
+}
+
+/**
+ * Prepare HTTP header
+ *
+ * @param instance an instance data structure.
+ */
+void otlp_prepare_header(struct instance *instance)
+{
+    struct otlp_specific_config *connector_specific_config = instance->config.connector_specific_config;
+    struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+
+    buffer_sprintf(
+        simple_connector_data->last_buffer->header,
+        "POST %s HTTP/1.1\r\n"
+        "Host: %s\r\n"
+        "Accept: */*\r\n"
+        "%s"
+        "%s"
+        "Content-Type: application/x-protobuf\r\n"
+        "Content-Length: %zu\r\n"
+        "\r\n",
+        connector_specific_config->url_path,
+        simple_connector_data->connected_to,
+        simple_connector_data->auth_string ? simple_connector_data->auth_string : "",
+        connector_specific_config->compression ? "Content-Encoding: zstd\r\n" : "",
+        buffer_strlen(simple_connector_data->last_buffer->buffer));
+}
+
+/**
+ * Process a response received after OTLP connector had sent data
+ *
+ * @param buffer a response from a remote service.
+ * @param instance an instance data structure.
+ * @return Returns 0 on success, 1 on failure.
+ */
+int process_otlp_response(BUFFER *buffer, struct instance *instance)
+{
+    if (unlikely(!buffer))
+        return 1;
+
+    const char *s = buffer_tostring(buffer);
+    int len = buffer_strlen(buffer);
+
+    // do nothing with HTTP responses 2xx
+
+    while (!isspace(*s) && len) {
+        s++;
+        len--;
+    }
+    s++;
+    len--;
+
+    if (likely(len > 4 && s[0] == '2' && isdigit(s[1]) && isdigit(s[2]) && s[3] == ' '))
+        return 0;
+    else
+        return exporting_discard_response(buffer, instance);
+}
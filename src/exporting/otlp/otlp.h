@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_EXPORTING_OTLP_H
+#define NETDATA_EXPORTING_OTLP_H
+
+#include "exporting/exporting_engine.h"
+
+struct otlp_specific_data {
+    BUFFER *resource;           // the Resource of the current host
+    BUFFER *metrics;            // the Metric messages of the current host
+    BUFFER *points;             // the data points of the current chart
+    BUFFER *tmp;
+    BUFFER *tmp2;
+
+    bool monotonic_sum;         // the current chart is sent as a cumulative monotonic sum
+    size_t points_count;
+};
+
+int init_otlp_instance(struct instance *instance);
+void clean_otlp_instance(struct instance *instance);
+
+int format_host_otlp(struct instance *instance, RRDHOST *host);
+int format_chart_otlp(struct instance *instance, RRDSET *st);
+int format_dimension_otlp(struct instance *instance, RRDDIM *rd);
+int format_chart_end_otlp(struct instance *instance, RRDSET *st);
+int format_host_end_otlp(struct instance *instance, RRDHOST *host);
+int format_batch_otlp(struct instance *instance);
+
+void otlp_prepare_header(struct instance *instance);
+int process_otlp_response(BUFFER *buffer, struct instance *instance);
+
+#endif //NETDATA_EXPORTING_OTLP_H
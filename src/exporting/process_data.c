@@ -49,32 +49,130 @@ int mark_scheduled_instances(struct engine *engine)
             instances_were_scheduled = 1;
             instance->before = engine->now;
         }
+        else if (!instance->disabled && exporting_backfill_schedule(instance))
+            instances_were_scheduled = 1;
     }
 
     return instances_were_scheduled;
 }
 
 /**
- * Calculate the SUM or AVERAGE of a dimension, for any timeframe
+ * Check if an instance can backfill lost data
  *
- * May return NAN if the database does not have any value in the give timeframe.
+ * Only the simple connectors sending averages or sums can query the lost timeframes again.
+ *
+ * @param instance an instance data structure.
+ * @return Returns true if backfilling is enabled for the instance.
+ */
+static inline bool exporting_backfill_enabled(struct instance *instance)
+{
+    return instance->config.backfill_on_failures > 0 &&
+           instance->worker == simple_connector_worker &&
+           EXPORTING_OPTIONS_DATA_SOURCE(instance->config.options) != EXPORTING_SOURCE_DATA_AS_COLLECTED;
+}
+
+/**
+ * Record the timeframe of a lost batch, to backfill it later
+ *
+ * The timeframe to backfill is limited to the last "backfill on failures" seconds.
+ *
+ * @param instance an instance data structure.
+ * @param after the start of the timeframe of the lost batch.
+ * @param before the end of the timeframe of the lost batch.
+ */
+static void exporting_backfill_lost(struct instance *instance, time_t after, time_t before)
+{
+    if (!exporting_backfill_enabled(instance) || after >= before)
+        return;
+
+    if (instance->backfill.after >= instance->backfill.before) {
+        instance->backfill.after = after;
+        instance->backfill.before = before;
+    }
+    else {
+        if (after < instance->backfill.after)
+            instance->backfill.after = after;
+        if (before > instance->backfill.before)
+            instance->backfill.before = before;
+    }
+
+    if (instance->backfill.before - instance->backfill.after > instance->config.backfill_on_failures)
+        instance->backfill.after = instance->backfill.before - instance->config.backfill_on_failures;
+}
+
+/**
+ * Schedule a backfill batch
+ *
+ * Backfill batches are prepared at the iterations the instance is not scheduled for live data, one interval of
+ * "update every" seconds per iteration, and only while the ring buffer of the instance is empty, i.e. the
+ * destination receives the live batches. So, backfilling never delays the live data.
  *
  * @param instance an instance data structure.
+ * @return Returns true if the instance has been scheduled.
+ */
+bool exporting_backfill_schedule(struct instance *instance)
+{
+    if (instance->backfill.after >= instance->backfill.before || !exporting_backfill_enabled(instance))
+        return false;
+
+    struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+
+    uv_mutex_lock(&instance->mutex);
+    bool idle = !simple_connector_data->first_buffer->used && !simple_connector_spill_pending(instance);
+    uv_mutex_unlock(&instance->mutex);
+
+    if (!idle)
+        return false;
+
+    instance->backfill.live_after = instance->after;
+    instance->backfill.running = 1;
+
+    instance->after = instance->backfill.after;
+    instance->before = instance->after + instance->config.update_every;
+    if (instance->before > instance->backfill.before)
+        instance->before = instance->backfill.before;
+
+    instance->scheduled = 1;
+    return true;
+}
+
+// the values of the metric being formatted, shared by all the instances
+// with the same timeframe, so that the database is queried once for them
+#define EXPORTING_METRIC_SNAPSHOT_TIMEFRAMES 4
+
+struct exporting_metric_snapshot {
+    RRDDIM *rd;
+    size_t used;
+
+    struct {
+        time_t after;                   // the timeframe of the instances
+        time_t before;
+
+        time_t last_timestamp;          // zero when the timeframe is outside the database
+        NETDATA_DOUBLE sum;
+        size_t count;
+    } timeframes[EXPORTING_METRIC_SNAPSHOT_TIMEFRAMES];
+};
+
+// set only by the exporting thread, while it formats a metric for all instances
+static __thread struct exporting_metric_snapshot *exporting_metric_snapshot = NULL;
+
+/**
+ * Query the database for the SUM and COUNT of a dimension
+ *
  * @param rd a dimension(metric) in the Netdata database.
- * @param last_timestamp the timestamp that should be reported to the exporting connector instance.
- * @return Returns the value, calculated over the given period.
+ * @param after the start of the timeframe of the instance.
+ * @param before the end of the timeframe of the instance.
+ * @param sum the sum of the values found.
+ * @param count the number of values found.
+ * @return Returns the timestamp that should be reported, or 0 when the timeframe is outside the database.
  */
-NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
-    struct instance *instance,
-    RRDDIM *rd,
-    time_t *last_timestamp)
+static time_t exporting_query_stored_data(RRDDIM *rd, time_t after, time_t before, NETDATA_DOUBLE *sum, size_t *count)
 {
     RRDSET *st = rd->rrdset;
 #ifdef NETDATA_INTERNAL_CHECKS
     RRDHOST *host = st->rrdhost;
 #endif
-    time_t after = instance->after;
-    time_t before = instance->before;
 
     // find the edges of the rrd database for this chart
     time_t first_t = storage_engine_oldest_time_s(rd->tiers[0].seb, rd->tiers[0].smh);
@@ -105,6 +203,9 @@ NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
     if (unlikely(before > last_t))
         before = last_t;
 
+    *sum = 0;
+    *count = 0;
+
     if (unlikely(before < first_t || after > last_t)) {
         // the chart has not been updated in the wanted timeframe
         netdata_log_debug(
@@ -117,14 +218,10 @@ NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
             (unsigned long)before,
             (unsigned long)first_t,
             (unsigned long)last_t);
-        return NAN;
+        return 0;
     }
 
-    *last_timestamp = before;
-
     size_t points_read = 0;
-    size_t counter = 0;
-    NETDATA_DOUBLE sum = 0;
 
     for (storage_engine_query_init(rd->tiers[0].seb, rd->tiers[0].smh, &handle, after, before, STORAGE_PRIORITY_SYNCHRONOUS); !storage_engine_query_is_finished(&handle);) {
         STORAGE_POINT sp = storage_engine_query_next_metric(&handle);
@@ -135,13 +232,13 @@ NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
             continue;
         }
 
-        sum += sp.sum;
-        counter += sp.count;
+        *sum += sp.sum;
+        *count += sp.count;
     }
     storage_engine_query_finalize(&handle);
     global_statistics_exporters_query_completed(points_read);
 
-    if (unlikely(!counter)) {
+    if (unlikely(!*count)) {
         netdata_log_debug(
             D_EXPORTING,
             "EXPORTING: %s.%s.%s: no values stored in database for range %lu to %lu",
@@ -150,13 +247,69 @@ NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
             rrddim_id(rd),
             (unsigned long)after,
             (unsigned long)before);
-        return NAN;
     }
 
+    return before;
+}
+
+/**
+ * Calculate the SUM or AVERAGE of a dimension, for any timeframe
+ *
+ * May return NAN if the database does not have any value in the give timeframe.
+ *
+ * @param instance an instance data structure.
+ * @param rd a dimension(metric) in the Netdata database.
+ * @param last_timestamp the timestamp that should be reported to the exporting connector instance.
+ * @return Returns the value, calculated over the given period.
+ */
+NETDATA_DOUBLE exporting_calculate_value_from_stored_data(
+    struct instance *instance,
+    RRDDIM *rd,
+    time_t *last_timestamp)
+{
+    time_t timestamp = 0;
+    NETDATA_DOUBLE sum = 0;
+    size_t count = 0;
+    bool found = false;
+
+    struct exporting_metric_snapshot *snapshot = exporting_metric_snapshot;
+    if (snapshot && snapshot->rd == rd) {
+        for (size_t i = 0; i < snapshot->used; i++) {
+            if (snapshot->timeframes[i].after == instance->after && snapshot->timeframes[i].before == instance->before) {
+                timestamp = snapshot->timeframes[i].last_timestamp;
+                sum = snapshot->timeframes[i].sum;
+                count = snapshot->timeframes[i].count;
+                found = true;
+                break;
+            }
+        }
+    }
+
+    if (!found) {
+        timestamp = exporting_query_stored_data(rd, instance->after, instance->before, &sum, &count);
+
+        if (snapshot && snapshot->rd == rd && snapshot->used < EXPORTING_METRIC_SNAPSHOT_TIMEFRAMES) {
+            snapshot->timeframes[snapshot->used].after = instance->after;
+            snapshot->timeframes[snapshot->used].before = instance->before;
+            snapshot->timeframes[snapshot->used].last_timestamp = timestamp;
+            snapshot->timeframes[snapshot->used].sum = sum;
+            snapshot->timeframes[snapshot->used].count = count;
+            snapshot->used++;
+        }
+    }
+
+    if (unlikely(!timestamp))
+        return NAN;
+
+    *last_timestamp = timestamp;
+
+    if (unlikely(!count))
+        return NAN;
+
     if (unlikely(EXPORTING_OPTIONS_DATA_SOURCE(instance->config.options) == EXPORTING_SOURCE_DATA_SUM))
         return sum;
 
-    return sum / (NETDATA_DOUBLE)counter;
+    return sum / (NETDATA_DOUBLE)count;
 }
 
 /**
@@ -229,6 +382,9 @@ void start_chart_formatting(struct engine *engine, RRDSET *st)
  */
 void metric_formatting(struct engine *engine, RRDDIM *rd)
 {
+    struct exporting_metric_snapshot snapshot = { .rd = rd };
+    exporting_metric_snapshot = &snapshot;
+
     for (struct instance *instance = engine->instance_root; instance; instance = instance->next) {
         if (instance->scheduled && !instance->skip_host && !instance->skip_chart) {
             if (instance->metric_formatting && instance->metric_formatting(instance, rd) != 0) {
@@ -239,6 +395,8 @@ void metric_formatting(struct engine *engine, RRDDIM *rd)
             instance->stats.buffered_metrics++;
         }
     }
+
+    exporting_metric_snapshot = NULL;
 }
 
 /**
@@ -321,7 +479,14 @@ void end_batch_formatting(struct engine *engine)
             uv_cond_signal(&instance->cond_var);
 
             instance->scheduled = 0;
-            instance->after = instance->before;
+
+            if (instance->backfill.running) {
+                instance->backfill.running = 0;
+                instance->backfill.after = instance->before;
+                instance->after = instance->backfill.live_after;
+            }
+            else
+                instance->after = instance->before;
         }
     }
 }
@@ -402,9 +567,15 @@ int simple_connector_end_batch(struct instance *instance)
         // ring buffer is full, reuse the oldest element
         simple_connector_data->first_buffer = simple_connector_data->first_buffer->next;
 
-        stats->data_lost_events++;
-        stats->lost_metrics += last_buffer->buffered_metrics;
-        stats->lost_bytes += last_buffer->buffered_bytes;
+        // keep it on disk, if we are allowed to
+        if (!simple_connector_spill_buffer(
+                instance, last_buffer->header, last_buffer->buffer, last_buffer->buffered_metrics)) {
+            stats->data_lost_events++;
+            stats->lost_metrics += last_buffer->buffered_metrics;
+            stats->lost_bytes += last_buffer->buffered_bytes;
+
+            exporting_backfill_lost(instance, last_buffer->after, last_buffer->before);
+        }
     }
 
     // swap buffers
@@ -432,6 +603,8 @@ int simple_connector_end_batch(struct instance *instance)
 
     last_buffer->buffered_metrics = buffered_metrics;
     last_buffer->buffered_bytes = buffered_bytes;
+    last_buffer->after = instance->after;
+    last_buffer->before = instance->before;
     last_buffer->used++;
 
     simple_connector_data->total_buffered_metrics += buffered_metrics;
@@ -350,6 +350,76 @@ static int format_prometheus_chart_label_callback(const char *name, const char *
     return 1;
 }
 
+/**
+ * Update the prometheus cache of a chart
+ *
+ * The sanitized names and the formatted labels of charts and dimensions are kept
+ * in them, and they are made again only when their metadata change.
+ *
+ * @param st the chart.
+ * @param names set to true to use the names instead of the ids.
+ */
+static void prometheus_rrdset_cache_update(RRDSET *st, bool names) {
+    uint32_t version = __atomic_load_n(&st->version, __ATOMIC_RELAXED);
+
+    if (unlikely(!st->prometheus.chart || st->prometheus.version != version || st->prometheus.names != names)) {
+        char buf[PROMETHEUS_ELEMENT_MAX + 1];
+
+        prometheus_label_copy(buf, (names && st->name) ? rrdset_name(st) : rrdset_id(st), PROMETHEUS_ELEMENT_MAX);
+        string_freez(st->prometheus.chart);
+        st->prometheus.chart = string_strdupz(buf);
+
+        prometheus_label_copy(buf, rrdset_family(st), PROMETHEUS_ELEMENT_MAX);
+        string_freez(st->prometheus.family);
+        st->prometheus.family = string_strdupz(buf);
+
+        prometheus_name_copy(buf, rrdset_context(st), PROMETHEUS_ELEMENT_MAX);
+        string_freez(st->prometheus.context);
+        st->prometheus.context = string_strdupz(buf);
+
+        st->prometheus.version = version;
+        st->prometheus.names = names;
+    }
+
+    size_t labels_version = rrdlabels_version(st->rrdlabels);
+    if (unlikely(!st->prometheus.labels || st->prometheus.labels_version != labels_version)) {
+        BUFFER *wb = buffer_create(0, NULL);
+        rrdlabels_walkthrough_read(st->rrdlabels, format_prometheus_chart_label_callback, wb);
+
+        string_freez(st->prometheus.labels);
+        st->prometheus.labels = string_strdupz(buffer_tostring(wb));
+        st->prometheus.labels_version = labels_version;
+
+        buffer_free(wb);
+    }
+}
+
+/**
+ * Update the prometheus cache of a dimension
+ *
+ * @param rd the dimension.
+ * @param version the version of its chart.
+ * @param names set to true to use the names instead of the ids.
+ */
+static inline void prometheus_rrddim_cache_update(RRDDIM *rd, uint32_t version, bool names) {
+    if (likely(rd->prometheus.label && rd->prometheus.version == version && rd->prometheus.names == names))
+        return;
+
+    char buf[PROMETHEUS_ELEMENT_MAX + 1];
+    const char *s = (names && rd->name) ? rrddim_name(rd) : rrddim_id(rd);
+
+    prometheus_label_copy(buf, s, PROMETHEUS_ELEMENT_MAX);
+    string_freez(rd->prometheus.label);
+    rd->prometheus.label = string_strdupz(buf);
+
+    prometheus_name_copy(buf, s, PROMETHEUS_ELEMENT_MAX);
+    string_freez(rd->prometheus.metric);
+    rd->prometheus.metric = string_strdupz(buf);
+
+    rd->prometheus.version = version;
+    rd->prometheus.names = names;
+}
+
 struct host_variables_callback_options {
     RRDHOST *host;
     BUFFER *wb;
@@ -424,13 +494,13 @@ static int print_host_variables_callback(const DICTIONARY_ITEM *item __maybe_unu
 struct gen_parameters {
     const char *prefix;
     const char *labels_prefix;
-    char *context;
-    char *suffix;
+    const char *context;
+    const char *suffix;
 
-    char *chart;
-    char *dimension;
-    char *family;
-    char *labels;
+    const char *chart;
+    const char *dimension;
+    const char *family;
+    const char *labels;
 
     PROMETHEUS_OUTPUT_OPTIONS output_options;
     RRDSET *st;
@@ -448,9 +518,9 @@ struct gen_parameters {
  */
 static inline void generate_as_collected_prom_help(BUFFER *wb,
                                                    const char *prefix,
-                                                   char *context,
-                                                   char *units,
-                                                   char *suffix,
+                                                   const char *context,
+                                                   const char *units,
+                                                   const char *suffix,
                                                    RRDSET *st)
 {
     buffer_sprintf(wb, "# HELP %s_%s%s%s %s\n", prefix, context, units, suffix, rrdset_title(st));
@@ -464,9 +534,9 @@ static inline void generate_as_collected_prom_help(BUFFER *wb,
  */
 static inline void generate_as_collected_prom_type(BUFFER *wb,
                                                    const char *prefix,
-                                                   char *context,
-                                                   char *units,
-                                                   char *suffix,
+                                                   const char *context,
+                                                   const char *units,
+                                                   const char *suffix,
                                                    const char *type)
 {
     buffer_sprintf(wb, "# TYPE %s_%s%s%s %s\n", prefix, context, units, suffix, type);
@@ -479,13 +549,13 @@ static inline void generate_as_collected_prom_type(BUFFER *wb,
  * @param p parameters for generating the metric string.
  * @param homogeneous a flag for homogeneous charts.
  * @param prometheus_collector a flag for metrics from prometheus collector.
- * @param chart_labels the dictionary with chart labels
+ * @param chart_labels the chart labels, formatted
  */
 static void generate_as_collected_from_metric(BUFFER *wb,
                                               struct gen_parameters *p,
                                               int homogeneous,
                                               int prometheus_collector,
-                                              RRDLABELS *chart_labels)
+                                              const char *chart_labels)
 {
     buffer_sprintf(wb, "%s_%s", p->prefix, p->context);
 
@@ -499,7 +569,7 @@ static void generate_as_collected_from_metric(BUFFER *wb,
 
     buffer_sprintf(wb, ",%sfamily=\"%s\"", p->labels_prefix, p->family);
 
-    rrdlabels_walkthrough_read(chart_labels, format_prometheus_chart_label_callback, wb);
+    buffer_strcat(wb, chart_labels);
 
     buffer_sprintf(wb, "%s} ", p->labels);
 
@@ -623,16 +693,15 @@ static int prometheus_rrdset_to_json(RRDSET *st, void *data)
 
         STRING *prometheus = opts->prometheus;
 
-        char chart[PROMETHEUS_ELEMENT_MAX + 1];
-        char context[PROMETHEUS_ELEMENT_MAX + 1];
-        char family[PROMETHEUS_ELEMENT_MAX + 1];
-        char units[PROMETHEUS_ELEMENT_MAX + 1] = "";
+        bool names = (output_options & PROMETHEUS_OUTPUT_NAMES);
+        prometheus_rrdset_cache_update(st, names);
 
-        prometheus_label_copy(chart,
-                              (output_options & PROMETHEUS_OUTPUT_NAMES && st->name) ?
-                               rrdset_name(st) : rrdset_id(st), PROMETHEUS_ELEMENT_MAX);
-        prometheus_label_copy(family, rrdset_family(st), PROMETHEUS_ELEMENT_MAX);
-        prometheus_name_copy(context, rrdset_context(st), PROMETHEUS_ELEMENT_MAX);
+        const char *chart = string2str(st->prometheus.chart);
+        const char *context = string2str(st->prometheus.context);
+        const char *family = string2str(st->prometheus.family);
+        const char *chart_labels = string2str(st->prometheus.labels);
+        uint32_t version = st->prometheus.version;
+        char units[PROMETHEUS_ELEMENT_MAX + 1] = "";
 
         int as_collected = (EXPORTING_OPTIONS_DATA_SOURCE(opts->exporting_options)
                             == EXPORTING_SOURCE_DATA_AS_COLLECTED);
@@ -663,8 +732,10 @@ static int prometheus_rrdset_to_json(RRDSET *st, void *data)
         rrddim_foreach_read(rd, st) {
 
             if (rd->collector.counter && !rrddim_flag_check(rd, RRDDIM_FLAG_OBSOLETE)) {
-                char dimension[PROMETHEUS_ELEMENT_MAX + 1];
-                char *suffix = "";
+                prometheus_rrddim_cache_update(rd, version, names);
+
+                const char *dimension = string2str(rd->prometheus.label);
+                const char *suffix = "";
 
                 struct gen_parameters p;
                 p.prefix = prefix;
@@ -674,7 +745,7 @@ static int prometheus_rrdset_to_json(RRDSET *st, void *data)
                 p.chart = chart;
                 p.dimension = dimension;
                 p.family = family;
-                p.labels = (char *)opts->labels;
+                p.labels = opts->labels;
                 p.output_options = output_options;
                 p.st = st;
                 p.rd = rd;
@@ -701,25 +772,12 @@ static int prometheus_rrdset_to_json(RRDSET *st, void *data)
                         opts->output_options &= ~PROMETHEUS_OUTPUT_HELP_TYPE;
                     }
 
-                    if (homogeneous) {
-                        // all the dimensions of the chart, has the same algorithm, multiplier and divisor
-                        // we add all dimensions as labels
+                    // when all the dimensions of the chart have the same algorithm, multiplier and divisor,
+                    // we add all dimensions as labels - otherwise we create a metric per dimension
+                    if (!homogeneous)
+                        p.dimension = string2str(rd->prometheus.metric);
 
-                        prometheus_label_copy(
-                            dimension,
-                            (output_options & PROMETHEUS_OUTPUT_NAMES && rd->name) ? rrddim_name(rd) : rrddim_id(rd),
-                            PROMETHEUS_ELEMENT_MAX);
-                    }
-                    else {
-                        // the dimensions of the chart, do not have the same algorithm, multiplier or divisor
-                        // we create a metric per dimension
-
-                        prometheus_name_copy(
-                            dimension,
-                            (output_options & PROMETHEUS_OUTPUT_NAMES && rd->name) ? rrddim_name(rd) : rrddim_id(rd),
-                            PROMETHEUS_ELEMENT_MAX);
-                    }
-                    generate_as_collected_from_metric(wb, &p, homogeneous, prometheus_collector, st->rrdlabels);
+                    generate_as_collected_from_metric(wb, &p, homogeneous, prometheus_collector, chart_labels);
                 }
                 else {
                     // we need average or sum of the data
@@ -735,11 +793,6 @@ static int prometheus_rrdset_to_json(RRDSET *st, void *data)
                                  == EXPORTING_SOURCE_DATA_SUM)
                             suffix = "_sum";
 
-                        prometheus_label_copy(
-                            dimension,
-                            (output_options & PROMETHEUS_OUTPUT_NAMES && rd->name) ? rrddim_name(rd) : rrddim_id(rd),
-                            PROMETHEUS_ELEMENT_MAX);
-
                         if (opts->output_options & PROMETHEUS_OUTPUT_HELP_TYPE) {
                             generate_as_collected_prom_help(wb, prefix, context, units, suffix, st);
                             generate_as_collected_prom_type(wb, prefix, context, units, p.suffix, "gauge");
@@ -753,9 +806,7 @@ static int prometheus_rrdset_to_json(RRDSET *st, void *data)
                                        chart,
                                        dimension,
                                        family);
-                        rrdlabels_walkthrough_read(st->rrdlabels,
-                                                   format_prometheus_chart_label_callback,
-                                                   plabels_buffer);
+                        buffer_strcat(plabels_buffer, chart_labels);
 
                         if (output_options & PROMETHEUS_OUTPUT_TIMESTAMPS)
                             buffer_sprintf(wb,
@@ -943,8 +994,309 @@ static inline time_t prometheus_preparation(
     return after;
 }
 
+// ----------------------------------------------------------------------------
+// protobuf exposition
+//
+// The text exposition is transcoded to length-delimited io.prometheus.client.MetricFamily
+// messages. Consecutive samples with the same name are one family, getting the
+// HELP and TYPE given for their name.
+
+// MetricType and the Metric field of its value
+static struct {
+    const char *name;
+    uint64_t type;
+    uint32_t value_field;
+} prometheus_protobuf_types[] = {
+    { "counter", 0, 3 },
+    { "gauge",   1, 2 },
+    { "untyped", 3, 5 },
+    { NULL,      3, 5 },
+};
+
+struct prometheus_protobuf {
+    BUFFER *out;
+    BUFFER *family;
+    BUFFER *metric;
+    BUFFER *tmp;
+
+    const char *name;           // the name of the current family
+    size_t name_len;
+
+    const char *help;           // the last HELP line
+    size_t help_len;
+    const char *help_name;
+    size_t help_name_len;
+
+    const char *type;           // the last TYPE line
+    size_t type_len;
+    const char *type_name;
+    size_t type_name_len;
+
+    uint32_t value_field;
+};
+
+static void prometheus_protobuf_family_end(struct prometheus_protobuf *pb) {
+    if (!pb->name)
+        return;
+
+    buffer_protobuf_varint(pb->out, buffer_strlen(pb->family));
+    buffer_memcat(pb->out, pb->family->buffer, buffer_strlen(pb->family));
+
+    buffer_flush(pb->family);
+    pb->name = NULL;
+}
+
+static void prometheus_protobuf_family_start(struct prometheus_protobuf *pb, const char *name, size_t len) {
+    pb->name = name;
+    pb->name_len = len;
+    buffer_protobuf_bytes(pb->family, 1, name, len);
+
+    if (pb->help && pb->help_name_len == len && !memcmp(pb->help_name, name, len))
+        buffer_protobuf_bytes(pb->family, 2, pb->help, pb->help_len);
+
+    size_t t = 0;
+    if (pb->type && pb->type_name_len == len && !memcmp(pb->type_name, name, len)) {
+        for (; prometheus_protobuf_types[t].name; t++) {
+            if (strlen(prometheus_protobuf_types[t].name) == pb->type_len &&
+                !memcmp(prometheus_protobuf_types[t].name, pb->type, pb->type_len))
+                break;
+        }
+    }
+    else
+        t = 2; // untyped
+
+    buffer_protobuf_tag(pb->family, 3, BUFFER_PROTOBUF_WIRE_VARINT);
+    buffer_protobuf_varint(pb->family, prometheus_protobuf_types[t].type);
+    pb->value_field = prometheus_protobuf_types[t].value_field;
+}
+
+static inline const char *prometheus_text_token(const char *s, const char *e, const char **token, size_t *len) {
+    while (s < e && *s == ' ')
+        s++;
+
+    *token = s;
+    while (s < e && *s != ' ' && *s != '\n')
+        s++;
+
+    *len = s - *token;
+    return s;
+}
+
+static const char *prometheus_text_comment(struct prometheus_protobuf *pb, const char *s, const char *e) {
+    const char *keyword, *name;
+    size_t keyword_len, name_len;
+
+    s = prometheus_text_token(s + 1, e, &keyword, &keyword_len);
+    s = prometheus_text_token(s, e, &name, &name_len);
+
+    while (s < e && *s == ' ')
+        s++;
+
+    const char *text = s;
+    while (s < e && *s != '\n')
+        s++;
+
+    if (keyword_len == 4 && !memcmp(keyword, "HELP", 4)) {
+        pb->help_name = name;
+        pb->help_name_len = name_len;
+        pb->help = text;
+        pb->help_len = s - text;
+    }
+    else if (keyword_len == 4 && !memcmp(keyword, "TYPE", 4)) {
+        pb->type_name = name;
+        pb->type_name_len = name_len;
+        pb->type = text;
+        pb->type_len = s - text;
+    }
+
+    return s;
+}
+
+static const char *prometheus_text_sample(struct prometheus_protobuf *pb, const char *s, const char *e) {
+    const char *name = s;
+    while (s < e && *s != '{' && *s != ' ' && *s != '\n')
+        s++;
+    size_t name_len = s - name;
+
+    if (!pb->name || pb->name_len != name_len || memcmp(pb->name, name, name_len)) {
+        prometheus_protobuf_family_end(pb);
+        prometheus_protobuf_family_start(pb, name, name_len);
+    }
+
+    buffer_flush(pb->metric);
+
+    if (s < e && *s == '{') {
+        s++;
+        while (s < e && *s != '}') {
+            if (*s == ',' || *s == ' ') {
+                s++;
+                continue;
+            }
+
+            const char *key = s;
+            while (s < e && *s != '=')
+                s++;
+            size_t key_len = s - key;
+
+            // the value, unescaped - escaping applies to any character, even new lines
+            char value[PROMETHEUS_LABELS_MAX + 1];
+            size_t value_len = 0;
+            if (s + 1 < e && s[1] == '"') {
+                for (s += 2; s < e && *s != '"'; s++) {
+                    if (*s == '\\' && s + 1 < e) {
+                        s++;
+                        if (*s == 'n')
+                            value[value_len] = '\n';
+                        else
+                            value[value_len] = *s;
+                    }
+                    else
+                        value[value_len] = *s;
+
+                    if (value_len < PROMETHEUS_LABELS_MAX)
+                        value_len++;
+                }
+                s++;
+            }
+
+            buffer_flush(pb->tmp);
+            buffer_protobuf_bytes(pb->tmp, 1, key, key_len);
+            buffer_protobuf_bytes(pb->tmp, 2, value, value_len);
+            buffer_protobuf_bytes(pb->metric, 1, pb->tmp->buffer, buffer_strlen(pb->tmp));
+        }
+        s++;
+    }
+
+    const char *token;
+    size_t len;
+    char number[64];
+
+    s = prometheus_text_token(s, e, &token, &len);
+    snprintfz(number, sizeof(number) - 1, "%.*s", (int)len, token);
+
+    buffer_flush(pb->tmp);
+    buffer_protobuf_double(pb->tmp, 1, str2ndd(number, NULL));
+    buffer_protobuf_bytes(pb->metric, pb->value_field, pb->tmp->buffer, buffer_strlen(pb->tmp));
+
+    s = prometheus_text_token(s, e, &token, &len);
+    if (len) {
+        snprintfz(number, sizeof(number) - 1, "%.*s", (int)len, token);
+        buffer_protobuf_tag(pb->metric, 6, BUFFER_PROTOBUF_WIRE_VARINT);
+        buffer_protobuf_varint(pb->metric, (uint64_t)str2ll(number, NULL));
+    }
+
+    buffer_protobuf_bytes(pb->family, 4, pb->metric->buffer, buffer_strlen(pb->metric));
+
+    while (s < e && *s != '\n')
+        s++;
+
+    return s;
+}
+
 /**
- * Write metrics and auxiliary information for one host to a buffer.
+ * Transcode the text exposition to the protobuf exposition.
+ *
+ * @param text the text exposition.
+ * @param len its length.
+ * @param out the buffer to append the protobuf messages to.
+ */
+static void prometheus_text_to_protobuf(const char *text, size_t len, BUFFER *out) {
+    struct prometheus_protobuf pb = {
+        .out = out,
+        .family = buffer_create(4096, NULL),
+        .metric = buffer_create(1024, NULL),
+        .tmp = buffer_create(1024, NULL),
+    };
+
+    const char *s = text;
+    const char *e = &text[len];
+
+    while (s < e) {
+        if (*s == '\n' || *s == ' ')
+            s++;
+        else if (*s == '#')
+            s = prometheus_text_comment(&pb, s, e);
+        else
+            s = prometheus_text_sample(&pb, s, e);
+    }
+
+    prometheus_protobuf_family_end(&pb);
+
+    buffer_free(pb.family);
+    buffer_free(pb.metric);
+    buffer_free(pb.tmp);
+}
+
+// ----------------------------------------------------------------------------
+// sharing responses
+//
+// Scrapers asking the same thing in the same second share the response,
+// rendered once. Rendering is serialized, since it uses the time-frame of the
+// prometheus exporter instance, so scrapers arriving while a response is
+// rendered wait for it, and get it when it matches their request.
+
+#define PROMETHEUS_SHARED_RESPONSES 4
+#define PROMETHEUS_SHARED_RESPONSE_MAX_AGE_S 10
+
+struct prometheus_shared_response {
+    time_t before;
+    time_t after;
+    char *server;
+    char *key;
+    BUFFER *wb;
+};
+
+static struct {
+    netdata_mutex_t mutex;
+    struct prometheus_shared_response responses[PROMETHEUS_SHARED_RESPONSES];
+} prometheus_shared = {
+    .mutex = NETDATA_MUTEX_INITIALIZER,
+};
+
+static void prometheus_shared_response_free(struct prometheus_shared_response *r) {
+    freez(r->server);
+    freez(r->key);
+    buffer_free(r->wb);
+    memset(r, 0, sizeof(*r));
+}
+
+static struct prometheus_shared_response *prometheus_shared_response_find(const char *key, const char *server, time_t before, time_t after) {
+    for (size_t i = 0; i < PROMETHEUS_SHARED_RESPONSES; i++) {
+        struct prometheus_shared_response *r = &prometheus_shared.responses[i];
+
+        if (r->key && r->before == before && !strcmp(r->key, key) &&
+            ((server && !strcmp(r->server, server)) || (!server && r->after == after)))
+            return r;
+    }
+
+    return NULL;
+}
+
+static void prometheus_shared_response_add(const char *key, const char *server, time_t before, time_t after, const char *body, size_t len) {
+    struct prometheus_shared_response *r = NULL;
+
+    for (size_t i = 0; i < PROMETHEUS_SHARED_RESPONSES; i++) {
+        struct prometheus_shared_response *t = &prometheus_shared.responses[i];
+        if (!t->key) {
+            r = t;
+            break;
+        }
+
+        if (!r || t->before < r->before)
+            r = t;
+    }
+
+    prometheus_shared_response_free(r);
+    r->before = before;
+    r->after = after;
+    r->server = strdupz(server);
+    r->key = strdupz(key);
+    r->wb = buffer_create(len + 1, NULL);
+    buffer_memcat(r->wb, body, len);
+}
+
+/**
+ * Write metrics and auxiliary information to a buffer, sharing the responses.
  *
  * @param host a data collecting host.
  * @param filter_string a simple pattern filter.
@@ -953,30 +1305,108 @@ static inline time_t prometheus_preparation(
  * @param prefix a prefix for every metric.
  * @param exporting_options options to configure what data is exported.
  * @param output_options options to configure the format of the output.
+ * @param allhosts set to true to write the metrics of all hosts.
  */
-void rrd_stats_api_v1_charts_allmetrics_prometheus_single_host(
+static void prometheus_allmetrics(
     RRDHOST *host,
     const char *filter_string,
     BUFFER *wb,
     const char *server,
     const char *prefix,
     EXPORTING_OPTIONS exporting_options,
-    PROMETHEUS_OUTPUT_OPTIONS output_options)
+    PROMETHEUS_OUTPUT_OPTIONS output_options,
+    bool allhosts)
 {
     if (unlikely(!prometheus_exporter_instance || !prometheus_exporter_instance->config.initialized))
         return;
 
-    prometheus_exporter_instance->before = now_realtime_sec();
+    if (!server || !*server)
+        server = "default";
+
+    // the time the scraper asked, before waiting for other scrapers
+    time_t now = now_realtime_sec();
+
+    char key[PROMETHEUS_LABELS_MAX + 1];
+    snprintfz(key, PROMETHEUS_LABELS_MAX, "%s|%d|%u|%u|%s|%s",
+              rrdhost_hostname(host), allhosts ? 1 : 0,
+              (unsigned)exporting_options, (unsigned)output_options,
+              prefix ? prefix : "", filter_string ? filter_string : "");
+
+    netdata_mutex_lock(&prometheus_shared.mutex);
+
+    for (size_t i = 0; i < PROMETHEUS_SHARED_RESPONSES; i++) {
+        struct prometheus_shared_response *r = &prometheus_shared.responses[i];
+        if (r->key && r->before + PROMETHEUS_SHARED_RESPONSE_MAX_AGE_S < now)
+            prometheus_shared_response_free(r);
+    }
+
+    // the same server asking again, or another server asking for the same time-frame
+    time_t after = 0;
+    struct prometheus_shared_response *r = prometheus_shared_response_find(key, server, now, 0);
+    if (!r) {
+        // we start at the point we had stopped before
+        after = prometheus_preparation(prometheus_exporter_instance, host, server, now);
+        r = prometheus_shared_response_find(key, NULL, now, after);
+    }
+
+    if (r) {
+        buffer_memcat(wb, buffer_tostring(r->wb), buffer_strlen(r->wb));
+        netdata_mutex_unlock(&prometheus_shared.mutex);
+        return;
+    }
+
+    prometheus_exporter_instance->before = now;
+    prometheus_exporter_instance->after = after;
 
-    // we start at the point we had stopped before
-    prometheus_exporter_instance->after = prometheus_preparation(
-        prometheus_exporter_instance,
-        host,
-        server,
-        prometheus_exporter_instance->before);
+    size_t start = buffer_strlen(wb);
+
+    if (allhosts) {
+        dfe_start_reentrant(rrdhost_root_index, host)
+        {
+            rrd_stats_api_v1_charts_allmetrics_prometheus(
+                prometheus_exporter_instance, host, filter_string, wb, prefix, exporting_options, 1, output_options);
+        }
+        dfe_done(host);
+    }
+    else
+        rrd_stats_api_v1_charts_allmetrics_prometheus(
+            prometheus_exporter_instance, host, filter_string, wb, prefix, exporting_options, 0, output_options);
 
-    rrd_stats_api_v1_charts_allmetrics_prometheus(
-        prometheus_exporter_instance, host, filter_string, wb, prefix, exporting_options, 0, output_options);
+    if (output_options & PROMETHEUS_OUTPUT_PROTOBUF) {
+        BUFFER *pb = buffer_create(buffer_strlen(wb) - start + 1, NULL);
+        prometheus_text_to_protobuf(&wb->buffer[start], buffer_strlen(wb) - start, pb);
+
+        wb->len = start;
+        buffer_memcat(wb, buffer_tostring(pb), buffer_strlen(pb));
+        buffer_free(pb);
+    }
+
+    prometheus_shared_response_add(key, server, now, after, &wb->buffer[start], buffer_strlen(wb) - start);
+
+    netdata_mutex_unlock(&prometheus_shared.mutex);
+}
+
+/**
+ * Write metrics and auxiliary information for one host to a buffer.
+ *
+ * @param host a data collecting host.
+ * @param filter_string a simple pattern filter.
+ * @param wb the buffer to write to.
+ * @param server the name of a Prometheus server.
+ * @param prefix a prefix for every metric.
+ * @param exporting_options options to configure what data is exported.
+ * @param output_options options to configure the format of the output.
+ */
+void rrd_stats_api_v1_charts_allmetrics_prometheus_single_host(
+    RRDHOST *host,
+    const char *filter_string,
+    BUFFER *wb,
+    const char *server,
+    const char *prefix,
+    EXPORTING_OPTIONS exporting_options,
+    PROMETHEUS_OUTPUT_OPTIONS output_options)
+{
+    prometheus_allmetrics(host, filter_string, wb, server, prefix, exporting_options, output_options, false);
 }
 
 /**
@@ -999,22 +1429,5 @@ void rrd_stats_api_v1_charts_allmetrics_prometheus_all_hosts(
     EXPORTING_OPTIONS exporting_options,
     PROMETHEUS_OUTPUT_OPTIONS output_options)
 {
-    if (unlikely(!prometheus_exporter_instance || !prometheus_exporter_instance->config.initialized))
-        return;
-
-    prometheus_exporter_instance->before = now_realtime_sec();
-
-    // we start at the point we had stopped before
-    prometheus_exporter_instance->after = prometheus_preparation(
-        prometheus_exporter_instance,
-        host,
-        server,
-        prometheus_exporter_instance->before);
-
-    dfe_start_reentrant(rrdhost_root_index, host)
-    {
-        rrd_stats_api_v1_charts_allmetrics_prometheus(
-            prometheus_exporter_instance, host, filter_string, wb, prefix, exporting_options, 1, output_options);
-    }
-    dfe_done(host);
+    prometheus_allmetrics(host, filter_string, wb, server, prefix, exporting_options, output_options, true);
 }
@@ -19,6 +19,7 @@ void prometheus_remote_write_prepare_header(struct instance *instance)
     struct prometheus_remote_write_specific_config *connector_specific_config =
         instance->config.connector_specific_config;
     struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
+    bool v2 = connector_specific_config->protocol_version == 2;
 
     buffer_sprintf(
         simple_connector_data->last_buffer->header,
@@ -27,13 +28,15 @@ void prometheus_remote_write_prepare_header(struct instance *instance)
         "Accept: */*\r\n"
         "%s"
         "Content-Encoding: snappy\r\n"
-        "Content-Type: application/x-protobuf\r\n"
-        "X-Prometheus-Remote-Write-Version: 0.1.0\r\n"
+        "Content-Type: %s\r\n"
+        "X-Prometheus-Remote-Write-Version: %s\r\n"
         "Content-Length: %zu\r\n"
         "\r\n",
         connector_specific_config->remote_write_path,
         simple_connector_data->connected_to,
         simple_connector_data->auth_string ? simple_connector_data->auth_string : "",
+        v2 ? "application/x-protobuf;proto=io.prometheus.write.v2.Request" : "application/x-protobuf",
+        v2 ? "2.0.0" : "0.1.0",
         buffer_strlen(simple_connector_data->last_buffer->buffer));
 }
 
@@ -75,7 +78,11 @@ int process_prometheus_remote_write_response(BUFFER *buffer, struct instance *in
 void clean_prometheus_remote_write(struct instance *instance)
 {
     struct simple_connector_data *simple_connector_data = instance->connector_specific_data;
-    freez(simple_connector_data->connector_specific_data);
+    struct prometheus_remote_write_specific_data *connector_specific_data =
+        simple_connector_data->connector_specific_data;
+
+    free_write_request(connector_specific_data->write_request);
+    freez(connector_specific_data);
 
     struct prometheus_remote_write_specific_config *connector_specific_config =
         instance->config.connector_specific_config;
@@ -125,7 +132,9 @@ int init_prometheus_remote_write_instance(struct instance *instance)
 
     simple_connector_init(instance);
 
-    connector_specific_data->write_request = init_write_request();
+    struct prometheus_remote_write_specific_config *connector_specific_config =
+        instance->config.connector_specific_config;
+    connector_specific_data->write_request = init_write_request(connector_specific_config->protocol_version);
 
     instance->engine->protocol_buffers_initialized = 1;
 
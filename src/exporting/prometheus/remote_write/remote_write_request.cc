@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include <snappy.h>
+#include <string>
+#include <unordered_map>
 #include "remote_write.pb.h"
 #include "remote_write_request.h"
 
@@ -8,18 +10,103 @@ using namespace prometheus;
 
 google::protobuf::Arena arena;
 
+// The messages are created once per instance and they are cleared after every batch, so the memory of the
+// repeated fields, and the string used for serializing them, is reused by the next batches.
+struct write_request {
+    int protocol_version;
+
+    WriteRequest *v1;
+
+    WriteRequestV2 *v2;
+    std::unordered_map<std::string, uint32_t> symbols;
+
+    std::string uncompressed;
+};
+
+static void reset_symbols(struct write_request *write_request)
+{
+    write_request->symbols.clear();
+    write_request->v2->clear_symbols();
+
+    // the first symbol is always the empty string
+    write_request->symbols.emplace("", 0);
+    write_request->v2->add_symbols("");
+}
+
+static uint32_t symbol_ref(struct write_request *write_request, const char *s)
+{
+    auto ret = write_request->symbols.emplace(s, (uint32_t)write_request->symbols.size());
+    if (ret.second)
+        write_request->v2->add_symbols(s);
+
+    return ret.first->second;
+}
+
+static void add_label_v2(struct write_request *write_request, TimeSeriesV2 *timeseries, const char *name, const char *value)
+{
+    timeseries->add_labels_refs(symbol_ref(write_request, name));
+    timeseries->add_labels_refs(symbol_ref(write_request, value));
+}
+
+static TimeSeries *add_timeseries_v1(struct write_request *write_request, const char *name)
+{
+    TimeSeries *timeseries = write_request->v1->add_timeseries();
+
+    Label *label = timeseries->add_labels();
+    label->set_name("__name__");
+    label->set_value(name);
+
+    return timeseries;
+}
+
+static void add_label_v1(TimeSeries *timeseries, const char *name, const char *value)
+{
+    Label *label = timeseries->add_labels();
+    label->set_name(name);
+    label->set_value(value);
+}
+
 /**
  * Initialize a write request
  *
+ * @param protocol_version the version of the remote write protocol, 1 or 2
  * @return Returns a new write request
  */
-void *init_write_request()
+void *init_write_request(int protocol_version)
 {
     GOOGLE_PROTOBUF_VERIFY_VERSION;
-    WriteRequest *write_request = google::protobuf::Arena::CreateMessage<WriteRequest>(&arena);
+    struct write_request *write_request = new struct write_request;
+
+    write_request->protocol_version = (protocol_version == 2) ? 2 : 1;
+    write_request->v1 = nullptr;
+    write_request->v2 = nullptr;
+
+    if (write_request->protocol_version == 2) {
+        write_request->v2 = google::protobuf::Arena::CreateMessage<WriteRequestV2>(&arena);
+        reset_symbols(write_request);
+    }
+    else
+        write_request->v1 = google::protobuf::Arena::CreateMessage<WriteRequest>(&arena);
+
     return (void *)write_request;
 }
 
+/**
+ * Release a write request
+ *
+ * @param write_request_p the write request
+ */
+void free_write_request(void *write_request_p)
+{
+    struct write_request *write_request = (struct write_request *)write_request_p;
+
+    if (!write_request)
+        return;
+
+    // the messages are owned by the arena
+    delete write_request;
+}
+
 /**
  * Adds information about a host to a write request
  *
@@ -34,34 +121,33 @@ void add_host_info(
     void *write_request_p,
     const char *name, const char *instance, const char *application, const char *version, const int64_t timestamp)
 {
-    WriteRequest *write_request = (WriteRequest *)write_request_p;
-    TimeSeries *timeseries;
+    struct write_request *write_request = (struct write_request *)write_request_p;
     Sample *sample;
-    Label *label;
 
-    timeseries = write_request->add_timeseries();
+    if (write_request->protocol_version == 2) {
+        TimeSeriesV2 *timeseries = write_request->v2->add_timeseries();
 
-    label = timeseries->add_labels();
-    label->set_name("__name__");
-    label->set_value(name);
+        add_label_v2(write_request, timeseries, "__name__", name);
+        if (application)
+            add_label_v2(write_request, timeseries, "application", application);
+        add_label_v2(write_request, timeseries, "instance", instance);
+        if (version)
+            add_label_v2(write_request, timeseries, "version", version);
 
-    if (application) {
-        label = timeseries->add_labels();
-        label->set_name("application");
-        label->set_value(application);
+        sample = timeseries->add_samples();
     }
+    else {
+        TimeSeries *timeseries = add_timeseries_v1(write_request, name);
 
-    label = timeseries->add_labels();
-    label->set_name("instance");
-    label->set_value(instance);
+        if (application)
+            add_label_v1(timeseries, "application", application);
+        add_label_v1(timeseries, "instance", instance);
+        if (version)
+            add_label_v1(timeseries, "version", version);
 
-    if (version) {
-        label = timeseries->add_labels();
-        label->set_name("version");
-        label->set_value(version);
+        sample = timeseries->add_samples();
     }
 
-    sample = timeseries->add_samples();
     sample->set_value(1);
     sample->set_timestamp(timestamp);
 }
@@ -75,15 +161,18 @@ void add_host_info(
  */
 void add_label(void *write_request_p, char *key, char *value)
 {
-    WriteRequest *write_request = (WriteRequest *)write_request_p;
-    TimeSeries *timeseries;
-    Label *label;
+    struct write_request *write_request = (struct write_request *)write_request_p;
 
-    timeseries = write_request->mutable_timeseries(write_request->timeseries_size() - 1);
-
-    label = timeseries->add_labels();
-    label->set_name(key);
-    label->set_value(value);
+    if (write_request->protocol_version == 2) {
+        TimeSeriesV2 *timeseries =
+            write_request->v2->mutable_timeseries(write_request->v2->timeseries_size() - 1);
+        add_label_v2(write_request, timeseries, key, value);
+    }
+    else {
+        TimeSeries *timeseries =
+            write_request->v1->mutable_timeseries(write_request->v1->timeseries_size() - 1);
+        add_label_v1(timeseries, key, value);
+    }
 }
 
 /**
@@ -103,36 +192,33 @@ void add_metric(
     const char *name, const char *chart, const char *family, const char *dimension, const char *instance,
     const double value, const int64_t timestamp)
 {
-    WriteRequest *write_request = (WriteRequest *)write_request_p;
-    TimeSeries *timeseries;
+    struct write_request *write_request = (struct write_request *)write_request_p;
     Sample *sample;
-    Label *label;
-
-    timeseries = write_request->add_timeseries();
 
-    label = timeseries->add_labels();
-    label->set_name("__name__");
-    label->set_value(name);
+    if (write_request->protocol_version == 2) {
+        TimeSeriesV2 *timeseries = write_request->v2->add_timeseries();
 
-    label = timeseries->add_labels();
-    label->set_name("chart");
-    label->set_value(chart);
+        add_label_v2(write_request, timeseries, "__name__", name);
+        add_label_v2(write_request, timeseries, "chart", chart);
+        if (dimension)
+            add_label_v2(write_request, timeseries, "dimension", dimension);
+        add_label_v2(write_request, timeseries, "family", family);
+        add_label_v2(write_request, timeseries, "instance", instance);
 
-    if (dimension) {
-        label = timeseries->add_labels();
-        label->set_name("dimension");
-        label->set_value(dimension);
+        sample = timeseries->add_samples();
     }
+    else {
+        TimeSeries *timeseries = add_timeseries_v1(write_request, name);
 
-    label = timeseries->add_labels();
-    label->set_name("family");
-    label->set_value(family);
+        add_label_v1(timeseries, "chart", chart);
+        if (dimension)
+            add_label_v1(timeseries, "dimension", dimension);
+        add_label_v1(timeseries, "family", family);
+        add_label_v1(timeseries, "instance", instance);
 
-    label = timeseries->add_labels();
-    label->set_name("instance");
-    label->set_value(instance);
+        sample = timeseries->add_samples();
+    }
 
-    sample = timeseries->add_samples();
     sample->set_value(value);
     sample->set_timestamp(timestamp);
 }
@@ -149,22 +235,25 @@ void add_metric(
 void add_variable(
     void *write_request_p, const char *name, const char *instance, const double value, const int64_t timestamp)
 {
-    WriteRequest *write_request = (WriteRequest *)write_request_p;
-    TimeSeries *timeseries;
+    struct write_request *write_request = (struct write_request *)write_request_p;
     Sample *sample;
-    Label *label;
 
-    timeseries = write_request->add_timeseries();
+    if (write_request->protocol_version == 2) {
+        TimeSeriesV2 *timeseries = write_request->v2->add_timeseries();
 
-    label = timeseries->add_labels();
-    label->set_name("__name__");
-    label->set_value(name);
+        add_label_v2(write_request, timeseries, "__name__", name);
+        add_label_v2(write_request, timeseries, "instance", instance);
 
-    label = timeseries->add_labels();
-    label->set_name("instance");
-    label->set_value(instance);
+        sample = timeseries->add_samples();
+    }
+    else {
+        TimeSeries *timeseries = add_timeseries_v1(write_request, name);
+
+        add_label_v1(timeseries, "instance", instance);
+
+        sample = timeseries->add_samples();
+    }
 
-    sample = timeseries->add_samples();
     sample->set_value(value);
     sample->set_timestamp(timestamp);
 }
@@ -177,12 +266,18 @@ void add_variable(
  */
 size_t get_write_request_size(void *write_request_p)
 {
-    WriteRequest *write_request = (WriteRequest *)write_request_p;
+    struct write_request *write_request = (struct write_request *)write_request_p;
+    google::protobuf::Message *message;
+
+    if (write_request->protocol_version == 2)
+        message = write_request->v2;
+    else
+        message = write_request->v1;
 
 #if GOOGLE_PROTOBUF_VERSION < 3001000
-    size_t size = (size_t)snappy::MaxCompressedLength(write_request->ByteSize());
+    size_t size = (size_t)snappy::MaxCompressedLength(message->ByteSize());
 #else
-    size_t size = (size_t)snappy::MaxCompressedLength(write_request->ByteSizeLong());
+    size_t size = (size_t)snappy::MaxCompressedLength(message->ByteSizeLong());
 #endif
 
     return (size < INT_MAX) ? size : 0;
@@ -198,12 +293,21 @@ size_t get_write_request_size(void *write_request_p)
  */
 int pack_and_clear_write_request(void *write_request_p, char *buffer, size_t *size)
 {
-    WriteRequest *write_request = (WriteRequest *)write_request_p;
-    std::string uncompressed_write_request;
+    struct write_request *write_request = (struct write_request *)write_request_p;
+    std::string &uncompressed_write_request = write_request->uncompressed;
+
+    if (write_request->protocol_version == 2) {
+        if (write_request->v2->SerializeToString(&uncompressed_write_request) == false)
+            return 1;
+        write_request->v2->clear_timeseries();
+        reset_symbols(write_request);
+    }
+    else {
+        if (write_request->v1->SerializeToString(&uncompressed_write_request) == false)
+            return 1;
+        write_request->v1->clear_timeseries();
+    }
 
-    if (write_request->SerializeToString(&uncompressed_write_request) == false)
-        return 1;
-    write_request->clear_timeseries();
     snappy::RawCompress(uncompressed_write_request.data(), uncompressed_write_request.size(), buffer, size);
 
     return 0;
@@ -7,7 +7,8 @@
 extern "C" {
 #endif
 
-void *init_write_request();
+void *init_write_request(int protocol_version);
+void free_write_request(void *write_request_p);
 
 void add_host_info(
     void *write_request_p,
@@ -153,8 +153,10 @@ EXPORTING_CONNECTOR_TYPE exporting_select_type(const char *type)
         return EXPORTING_CONNECTOR_TYPE_KINESIS;
     } else if (!strcmp(type, "pubsub") || !strcmp(type, "pubsub:plaintext")) {
         return EXPORTING_CONNECTOR_TYPE_PUBSUB;
-    } else if (!strcmp(type, "mongodb") || !strcmp(type, "mongodb:plaintext"))
+    } else if (!strcmp(type, "mongodb") || !strcmp(type, "mongodb:plaintext")) {
         return EXPORTING_CONNECTOR_TYPE_MONGODB;
+    } else if (!strcmp(type, "otlp") || !strcmp(type, "otlp:http") || !strcmp(type, "otlp:https"))
+        return EXPORTING_CONNECTOR_TYPE_OTLP;
 
     return EXPORTING_CONNECTOR_TYPE_UNKNOWN;
 }
@@ -364,6 +366,10 @@ struct engine *read_exporting_config()
 
         tmp_instance->config.buffer_on_failures = exporter_get_number(instance_name, "buffer on failures", 10);
 
+        tmp_instance->config.spill_on_failures_mb = exporter_get_number(instance_name, "spill on failures MB", 0);
+
+        tmp_instance->config.backfill_on_failures = exporter_get_number(instance_name, "backfill on failures", 0);
+
         tmp_instance->config.timeoutms = exporter_get_number(instance_name, "timeout ms", 10000);
 
         tmp_instance->config.charts_pattern =
@@ -412,6 +418,43 @@ struct engine *read_exporting_config()
 
             connector_specific_config->remote_write_path =
                 strdupz(exporter_get(instance_name, "remote write URL path", "/receive"));
+
+            connector_specific_config->protocol_version =
+                (int)exporter_get_number(instance_name, "remote write protocol version", 1);
+            if (connector_specific_config->protocol_version != 1 && connector_specific_config->protocol_version != 2) {
+                netdata_log_error(
+                    "EXPORTING: invalid remote write protocol version %d for instance %s, using 1",
+                    connector_specific_config->protocol_version,
+                    instance_name);
+                connector_specific_config->protocol_version = 1;
+            }
+        }
+
+        if (tmp_instance->config.type == EXPORTING_CONNECTOR_TYPE_OTLP) {
+            struct otlp_specific_config *connector_specific_config =
+                callocz(1, sizeof(struct otlp_specific_config));
+
+            tmp_instance->config.connector_specific_config = connector_specific_config;
+
+            connector_specific_config->url_path = strdupz(exporter_get(instance_name, "otlp URL path", "/v1/metrics"));
+
+            const char *compression = exporter_get(instance_name, "compression", "none");
+            if (!strcmp(compression, "zstd")) {
+#ifdef ENABLE_ZSTD
+                connector_specific_config->compression = 1;
+#else
+                netdata_log_error(
+                    "EXPORTING: zstd compression is not available for instance %s, sending uncompressed data",
+                    instance_name);
+#endif
+            }
+            else if (strcmp(compression, "none") != 0)
+                netdata_log_error(
+                    "EXPORTING: unknown compression '%s' for instance %s, sending uncompressed data",
+                    compression, instance_name);
+
+            connector_specific_config->compression_level =
+                (int)exporter_get_number(instance_name, "compression level", 3);
         }
 
         if (tmp_instance->config.type == EXPORTING_CONNECTOR_TYPE_KINESIS) {
@@ -468,6 +511,7 @@ struct engine *read_exporting_config()
 #define STR_JSON_HTTPS "json:https"
 #define STR_OPENTSDB_HTTPS "opentsdb:https"
 #define STR_PROMETHEUS_REMOTE_WRITE_HTTPS "prometheus_remote_write:https"
+#define STR_OTLP_HTTPS "otlp:https"
 
         if ((tmp_instance->config.type == EXPORTING_CONNECTOR_TYPE_GRAPHITE_HTTP &&
              !strncmp(tmp_ci_list->local_ci.connector_name, STR_GRAPHITE_HTTPS, strlen(STR_GRAPHITE_HTTPS))) ||
@@ -478,7 +522,9 @@ struct engine *read_exporting_config()
             (tmp_instance->config.type == EXPORTING_CONNECTOR_TYPE_PROMETHEUS_REMOTE_WRITE &&
              !strncmp(
                  tmp_ci_list->local_ci.connector_name, STR_PROMETHEUS_REMOTE_WRITE_HTTPS,
-                 strlen(STR_PROMETHEUS_REMOTE_WRITE_HTTPS)))) {
+                 strlen(STR_PROMETHEUS_REMOTE_WRITE_HTTPS))) ||
+            (tmp_instance->config.type == EXPORTING_CONNECTOR_TYPE_OTLP &&
+             !strncmp(tmp_ci_list->local_ci.connector_name, STR_OTLP_HTTPS, strlen(STR_OTLP_HTTPS)))) {
             tmp_instance->config.options |= EXPORTING_OPTION_USE_TLS;
         }
 
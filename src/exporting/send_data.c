@@ -15,7 +15,8 @@ static int exporting_tls_is_enabled(EXPORTING_CONNECTOR_TYPE type __maybe_unused
     return (type == EXPORTING_CONNECTOR_TYPE_GRAPHITE_HTTP ||
             type == EXPORTING_CONNECTOR_TYPE_JSON_HTTP ||
             type == EXPORTING_CONNECTOR_TYPE_OPENTSDB_HTTP ||
-            type == EXPORTING_CONNECTOR_TYPE_PROMETHEUS_REMOTE_WRITE) &&
+            type == EXPORTING_CONNECTOR_TYPE_PROMETHEUS_REMOTE_WRITE ||
+            type == EXPORTING_CONNECTOR_TYPE_OTLP) &&
            options & EXPORTING_OPTION_USE_TLS;
 }
 
@@ -189,6 +190,234 @@ void simple_connector_send_buffer(
     }
 }
 
+/**
+ * Simple connector spill file
+ *
+ * When the ring buffer is full, because the destination is not reachable, the oldest buffer is appended to a
+ * spill file in the cache directory, instead of being dropped. The spill file is bounded by
+ * "spill on failures MB", and it is replayed, oldest first, when the ring is empty and the destination is
+ * accepting data again. It is not kept across restarts.
+ */
+
+#define EXPORTING_SPILL_MAGIC 0x4e445350 // NDSP
+
+struct exporting_spill_record {
+    uint32_t magic;
+    uint32_t header_len;
+    uint32_t buffer_len;
+    uint32_t reserved;
+    uint64_t buffered_metrics;
+};
+
+/**
+ * Initialize the spill file of an instance
+ *
+ * @param instance an instance data structure.
+ */
+void simple_connector_spill_init(struct instance *instance)
+{
+    struct simple_connector_data *connector_specific_data = instance->connector_specific_data;
+
+    connector_specific_data->spill.fd = -1;
+
+    if (instance->config.spill_on_failures_mb <= 0)
+        return;
+
+    char name[RRD_ID_LENGTH_MAX + 1];
+    exporting_name_copy(name, instance->config.name, RRD_ID_LENGTH_MAX);
+
+    char filename[FILENAME_MAX + 1];
+    snprintfz(filename, FILENAME_MAX, "%s/exporting-%s.spill", netdata_configured_cache_dir, name);
+
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        netdata_log_error("EXPORTING: cannot create spill file '%s' for instance %s", filename, instance->config.name);
+        return;
+    }
+
+    connector_specific_data->spill.filename = strdupz(filename);
+    connector_specific_data->spill.fd = fd;
+    connector_specific_data->spill.max_bytes = (size_t)instance->config.spill_on_failures_mb * 1024 * 1024;
+    connector_specific_data->spill.read_offset = 0;
+    connector_specific_data->spill.write_offset = 0;
+    connector_specific_data->spill.loaded_size = 0;
+}
+
+static void simple_connector_spill_reset(struct simple_connector_data *connector_specific_data)
+{
+    connector_specific_data->spill.read_offset = 0;
+    connector_specific_data->spill.write_offset = 0;
+    connector_specific_data->spill.loaded_size = 0;
+
+    if (ftruncate(connector_specific_data->spill.fd, 0) != 0)
+        netdata_log_error("EXPORTING: cannot truncate spill file '%s'", connector_specific_data->spill.filename);
+}
+
+/**
+ * Append a buffer to the spill file
+ *
+ * Should be called with the instance mutex locked.
+ *
+ * @param instance an instance data structure.
+ * @param header the header of the buffer.
+ * @param buffer the data to be spilled.
+ * @param buffered_metrics the number of metrics in the buffer.
+ * @return Returns true if the buffer has been written to the spill file.
+ */
+bool simple_connector_spill_buffer(struct instance *instance, BUFFER *header, BUFFER *buffer, size_t buffered_metrics)
+{
+    struct simple_connector_data *connector_specific_data = instance->connector_specific_data;
+
+    if (!connector_specific_data->spill.filename || !buffer || !buffer_strlen(buffer))
+        return false;
+
+    struct exporting_spill_record rec = {
+        .magic = EXPORTING_SPILL_MAGIC,
+        .header_len = header ? (uint32_t)buffer_strlen(header) : 0,
+        .buffer_len = (uint32_t)buffer_strlen(buffer),
+        .reserved = 0,
+        .buffered_metrics = buffered_metrics,
+    };
+
+    size_t size = sizeof(rec) + rec.header_len + rec.buffer_len;
+    size_t queued = (size_t)(connector_specific_data->spill.write_offset - connector_specific_data->spill.read_offset);
+    if (queued + size > connector_specific_data->spill.max_bytes)
+        return false;
+
+    struct iovec iov[3] = {
+        { .iov_base = &rec, .iov_len = sizeof(rec) },
+        { .iov_base = header ? (void *)buffer_tostring(header) : NULL, .iov_len = rec.header_len },
+        { .iov_base = (void *)buffer_tostring(buffer), .iov_len = rec.buffer_len },
+    };
+
+    ssize_t written = pwritev(connector_specific_data->spill.fd, iov, 3, connector_specific_data->spill.write_offset);
+    if (written != (ssize_t)size) {
+        netdata_log_error(
+            "EXPORTING: cannot write %zu bytes to spill file '%s'", size, connector_specific_data->spill.filename);
+        return false;
+    }
+
+    connector_specific_data->spill.write_offset += (off_t)size;
+    return true;
+}
+
+/**
+ * Check if there are spilled buffers to be sent
+ *
+ * @param instance an instance data structure.
+ * @return Returns true if the spill file has buffers not sent yet.
+ */
+bool simple_connector_spill_pending(struct instance *instance)
+{
+    struct simple_connector_data *connector_specific_data = instance->connector_specific_data;
+
+    return connector_specific_data->spill.filename &&
+           connector_specific_data->spill.read_offset < connector_specific_data->spill.write_offset;
+}
+
+/**
+ * Load the oldest spilled buffer
+ *
+ * The buffer stays in the spill file, until simple_connector_spill_sent() is called.
+ *
+ * @param instance an instance data structure.
+ * @param header a buffer for the header.
+ * @param buffer a buffer for the data.
+ * @param buffered_metrics returns the number of metrics in the buffer.
+ * @return Returns true if a buffer has been loaded.
+ */
+bool simple_connector_spill_load(struct instance *instance, BUFFER *header, BUFFER *buffer, size_t *buffered_metrics)
+{
+    struct simple_connector_data *connector_specific_data = instance->connector_specific_data;
+
+    if (!simple_connector_spill_pending(instance))
+        return false;
+
+    struct exporting_spill_record rec;
+    off_t offset = connector_specific_data->spill.read_offset;
+
+    if (pread(connector_specific_data->spill.fd, &rec, sizeof(rec), offset) != (ssize_t)sizeof(rec) ||
+        rec.magic != EXPORTING_SPILL_MAGIC ||
+        offset + (off_t)(sizeof(rec) + rec.header_len + rec.buffer_len) > connector_specific_data->spill.write_offset)
+        goto corrupted;
+
+    offset += (off_t)sizeof(rec);
+
+    buffer_flush(header);
+    buffer_need_bytes(header, rec.header_len + 1);
+    if (rec.header_len && pread(connector_specific_data->spill.fd, header->buffer, rec.header_len, offset) !=
+                              (ssize_t)rec.header_len)
+        goto corrupted;
+    header->len = rec.header_len;
+    buffer_need_bytes(header, 1);
+    header->buffer[header->len] = '\0';
+    offset += (off_t)rec.header_len;
+
+    buffer_flush(buffer);
+    buffer_need_bytes(buffer, rec.buffer_len + 1);
+    if (pread(connector_specific_data->spill.fd, buffer->buffer, rec.buffer_len, offset) != (ssize_t)rec.buffer_len)
+        goto corrupted;
+    buffer->len = rec.buffer_len;
+    buffer_need_bytes(buffer, 1);
+    buffer->buffer[buffer->len] = '\0';
+
+    *buffered_metrics = (size_t)rec.buffered_metrics;
+    connector_specific_data->spill.loaded_size = sizeof(rec) + rec.header_len + rec.buffer_len;
+    return true;
+
+corrupted:
+    netdata_log_error(
+        "EXPORTING: spill file '%s' is corrupted at offset %lld, discarding it",
+        connector_specific_data->spill.filename,
+        (long long)connector_specific_data->spill.read_offset);
+
+    buffer_flush(header);
+    buffer_flush(buffer);
+    simple_connector_spill_reset(connector_specific_data);
+    return false;
+}
+
+/**
+ * Remove the buffer loaded by simple_connector_spill_load() from the spill file
+ *
+ * Should be called with the instance mutex locked.
+ *
+ * @param instance an instance data structure.
+ */
+void simple_connector_spill_sent(struct instance *instance)
+{
+    struct simple_connector_data *connector_specific_data = instance->connector_specific_data;
+
+    if (!connector_specific_data->spill.filename)
+        return;
+
+    connector_specific_data->spill.read_offset += (off_t)connector_specific_data->spill.loaded_size;
+    connector_specific_data->spill.loaded_size = 0;
+
+    if (connector_specific_data->spill.read_offset >= connector_specific_data->spill.write_offset)
+        simple_connector_spill_reset(connector_specific_data);
+}
+
+/**
+ * Close and delete the spill file of an instance
+ *
+ * @param instance an instance data structure.
+ */
+void simple_connector_spill_cleanup(struct instance *instance)
+{
+    struct simple_connector_data *connector_specific_data = instance->connector_specific_data;
+
+    if (!connector_specific_data->spill.filename)
+        return;
+
+    close(connector_specific_data->spill.fd);
+    unlink(connector_specific_data->spill.filename);
+    freez(connector_specific_data->spill.filename);
+
+    connector_specific_data->spill.filename = NULL;
+    connector_specific_data->spill.fd = -1;
+}
+
 /**
  * Simple connector worker
  *
@@ -225,7 +454,12 @@ void simple_connector_worker(void *instance_p)
             send_stats = 1;
 
         uv_mutex_lock(&instance->mutex);
-        if (!connector_specific_data->first_buffer->used || failures) {
+
+        // when the ring is empty and the destination is accepting data, send the spilled buffers
+        bool replay = !failures && !connector_specific_data->first_buffer->used &&
+                      simple_connector_spill_pending(instance);
+
+        if (!replay && (!connector_specific_data->first_buffer->used || failures)) {
             while (!instance->data_is_ready)
                 uv_cond_wait(&instance->cond_var, &instance->mutex);
             instance->data_is_ready = 0;
@@ -240,9 +474,15 @@ void simple_connector_worker(void *instance_p)
         // ------------------------------------------------------------------------
         // detach buffer
 
-        size_t buffered_metrics;
+        size_t buffered_metrics = 0;
 
-        if (!connector_specific_data->previous_buffer ||
+        if (replay) {
+            if (!simple_connector_spill_load(
+                    instance, connector_specific_data->header, connector_specific_data->buffer, &buffered_metrics)) {
+                uv_mutex_unlock(&instance->mutex);
+                continue;
+            }
+        } else if (!connector_specific_data->previous_buffer ||
             (connector_specific_data->previous_buffer == connector_specific_data->first_buffer &&
              connector_specific_data->first_buffer->used == 1)) {
             BUFFER *header, *buffer;
@@ -337,7 +577,13 @@ void simple_connector_worker(void *instance_p)
             failures++;
         }
 
-        if (!failures) {
+        if (replay) {
+            if (!failures) {
+                uv_mutex_lock(&instance->mutex);
+                simple_connector_spill_sent(instance);
+                uv_mutex_unlock(&instance->mutex);
+            }
+        } else if (!failures) {
             connector_specific_data->first_buffer->buffered_metrics =
                 connector_specific_data->first_buffer->buffered_bytes = connector_specific_data->first_buffer->used = 0;
             connector_specific_data->first_buffer = connector_specific_data->first_buffer->next;
@@ -382,5 +628,8 @@ void simple_connector_worker(void *instance_p)
         clean_prometheus_remote_write(instance);
 #endif
 
+    if (instance->config.type == EXPORTING_CONNECTOR_TYPE_OTLP)
+        clean_otlp_instance(instance);
+
     simple_connector_cleanup(instance);
 }
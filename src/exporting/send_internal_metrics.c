@@ -170,6 +170,29 @@ void send_internal_metrics(struct instance *instance)
         stats->initialized = 1;
     }
 
+    // the latency chart is created when the connector reports it for the first time
+    if (unlikely(stats->transmission_latency_ut && !stats->st_latency)) {
+        char id[RRD_ID_LENGTH_MAX + 1];
+        snprintf(id, RRD_ID_LENGTH_MAX, "exporting_%s_latency", instance->config.name);
+        netdata_fix_chart_id(id);
+
+        stats->st_latency = rrdset_create_localhost(
+            "netdata",
+            id,
+            NULL,
+            "exporting",
+            "netdata.exporting_latency",
+            "Netdata Exporting Write Latency",
+            "milliseconds",
+            "exporting",
+            NULL,
+            130635,
+            instance->config.update_every,
+            RRDSET_TYPE_LINE);
+
+        stats->rd_latency = rrddim_add(stats->st_latency, "write", NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+    }
+
     // ------------------------------------------------------------------------
     // update the monitoring charts
 
@@ -191,6 +214,11 @@ void send_internal_metrics(struct instance *instance)
     rrddim_set_by_pointer(stats->st_ops, stats->rd_receptions,             stats->receptions);
     rrdset_done(stats->st_ops);
 
+    if (stats->st_latency) {
+        rrddim_set_by_pointer(stats->st_latency, stats->rd_latency, stats->transmission_latency_ut);
+        rrdset_done(stats->st_latency);
+    }
+
     struct rusage thread;
     getrusage(RUSAGE_THREAD, &thread);
 
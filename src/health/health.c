@@ -6,6 +6,7 @@
 struct health_plugin_globals health_globals = {
     .initialization = {
         .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+        .loaded = false,
         .done = false,
     },
     .config = {
@@ -21,6 +22,9 @@ struct health_plugin_globals health_globals = {
 
         .run_at_least_every_seconds = 10,
         .postpone_alarms_during_hibernation_for_seconds = 60,
+
+        .threads = 1,
+        .incremental_lookups = true,
     },
     .prototypes = {
         .dict = NULL,
@@ -71,6 +75,12 @@ static void health_load_config_defaults(void) {
     health_globals.config.default_exec =
         string_strdupz(config_get(CONFIG_SECTION_HEALTH, "script to execute on alarm", filename));
 
+    health_globals.config.notifications_batch_window_s =
+        (uint32_t)config_get_duration_seconds(CONFIG_SECTION_HEALTH, "notifications batch window", 0);
+
+    if(health_globals.config.notifications_batch_window_s)
+        health_globals.config.batch_exec = string_strdupz(filename);
+
     health_globals.config.enabled_alerts =
         simple_pattern_create(config_get(CONFIG_SECTION_HEALTH, "enabled alarms", "*"),
                               NULL, SIMPLE_PATTERN_EXACT, true);
@@ -84,6 +94,12 @@ static void health_load_config_defaults(void) {
                                     "postpone alarms during hibernation for",
                                     health_globals.config.postpone_alarms_during_hibernation_for_seconds);
 
+    health_globals.config.threads = (size_t)config_get_number(CONFIG_SECTION_HEALTH, "threads",
+                                                              MIN(MAX(os_get_system_cpus() / 4, 1), 4));
+
+    health_globals.config.incremental_lookups =
+        config_get_boolean(CONFIG_SECTION_HEALTH, "incremental lookups", health_globals.config.incremental_lookups);
+
     health_globals.config.default_recipient =
         string_strdupz("root");
 
@@ -93,6 +109,9 @@ static void health_load_config_defaults(void) {
     if(health_globals.config.run_at_least_every_seconds < 1)
         health_globals.config.run_at_least_every_seconds = 1;
 
+    if(health_globals.config.threads < 1 || health_globals.config.threads > 256)
+        health_globals.config.threads = 1;
+
     if(health_globals.config.health_log_entries_max < HEALTH_LOG_ENTRIES_MIN) {
         nd_log(NDLS_DAEMON, NDLP_WARNING,
                "Health configuration has invalid max log entries %u, using minimum of %u",
@@ -140,6 +159,30 @@ inline const char *health_stock_config_dir(void) {
     return config_get(CONFIG_SECTION_DIRECTORIES, "stock health config", buffer);
 }
 
+static void health_plugin_load_unsafe(void) {
+    if(health_globals.initialization.loaded)
+        return;
+
+    health_globals.initialization.loaded = true;
+
+    health_init_prototypes();
+    health_load_config_defaults();
+
+    if(!health_plugin_enabled())
+        return;
+
+    health_load_prototypes();
+    health_silencers_init();
+    health_transitions_log_init();
+}
+
+// everything that does not need localhost - it may be called before health_plugin_init()
+void health_plugin_load(void) {
+    spinlock_lock(&health_globals.initialization.spinlock);
+    health_plugin_load_unsafe();
+    spinlock_unlock(&health_globals.initialization.spinlock);
+}
+
 void health_plugin_init(void) {
     spinlock_lock(&health_globals.initialization.spinlock);
 
@@ -148,21 +191,17 @@ void health_plugin_init(void) {
 
     health_globals.initialization.done = true;
 
-    health_init_prototypes();
-    health_load_config_defaults();
-
-    if(!health_plugin_enabled())
-        goto cleanup;
+    health_plugin_load_unsafe();
 
-    health_reload_prototypes();
-    health_silencers_init();
+    if(health_plugin_enabled())
+        health_dyncfg_register_all_prototypes();
 
 cleanup:
     spinlock_unlock(&health_globals.initialization.spinlock);
 }
 
 void health_plugin_destroy(void) {
-    ;
+    health_transitions_log_destroy();
 }
 
 void health_plugin_reload(void) {
@@ -44,11 +44,23 @@ void health_entry_flags_to_json_array(BUFFER *wb, const char *key, HEALTH_ENTRY_
 
 #define HEALTH_SILENCERS_MAX_FILE_LEN 10000
 
+void health_plugin_load(void);
 void health_plugin_init(void);
 void health_plugin_destroy(void);
 
 void health_plugin_reload(void);
 
+typedef struct health_notifications_statistics {
+    size_t queued;              // notifications queued for batched delivery
+    size_t coalesced;           // queued notifications superseded by a newer transition of the same alert
+    size_t delivered;           // notifications handed to the notification script
+    size_t batches;             // executions of the notification script
+    usec_t latency_ut;          // the total time the delivered notifications waited in the queue
+    usec_t latency_max_ut;      // the max time a notification waited in the queue, since the last call
+} HEALTH_NOTIFICATIONS_STATISTICS;
+
+bool health_notifications_statistics(HEALTH_NOTIFICATIONS_STATISTICS *stats);
+
 void health_aggregate_alarms(RRDHOST *host, BUFFER *wb, BUFFER* context, RRDCALC_STATUS status);
 void health_alarms2json(RRDHOST *host, BUFFER *wb, int all);
 void health_alert2json_conf(RRDHOST *host, BUFFER *wb, CONTEXTS_OPTIONS all);
@@ -95,6 +107,7 @@ int alert_variable_lookup_trace(RRDHOST *host, RRDSET *st, const char *variable,
 
 #include "health_prototypes.h"
 #include "health_silencers.h"
+#include "health_transitions_log.h"
 
 typedef void (*prototype_metadata_cb_t)(void *data, STRING *type, STRING *component, STRING *classification, STRING *recipient);
 void health_prototype_metadata_foreach(void *data, prototype_metadata_cb_t cb);
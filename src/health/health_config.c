@@ -256,6 +256,7 @@ static inline int health_parse_db_lookup(size_t line, const char *filename, char
             break;
 
         case RRDR_GROUPING_PERCENTILE:
+        case RRDR_GROUPING_PERCENTILE_APPROX:
             if(isnan(ac->time_group_value))
                 ac->time_group_value = 95;
             break;
@@ -53,138 +53,139 @@ static void data_source_to_rrdr_options(RRD_ALERT_PROTOTYPE *ap) {
     }
 }
 
-static bool parse_match(json_object *jobj, const char *path, struct rrd_alert_match *match, BUFFER *error, bool strict) {
+static bool parse_match(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, struct rrd_alert_match *match, BUFFER *error, bool strict) {
     STRING *on = NULL;
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "on", on, error, strict);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "on", on, error, strict);
     if(match->is_template)
         match->on.context = on;
     else
         match->on.chart = on;
 
-    JSONC_PARSE_TXT2PATTERN_OR_ERROR_AND_RETURN(jobj, path, "host_labels", match->host_labels, error, strict);
-    JSONC_PARSE_TXT2PATTERN_OR_ERROR_AND_RETURN(jobj, path, "instance_labels", match->chart_labels, error, strict);
+    JSONS_PARSE_TXT2PATTERN_OR_ERROR_AND_RETURN(js, jobj, path, "host_labels", match->host_labels, error, strict);
+    JSONS_PARSE_TXT2PATTERN_OR_ERROR_AND_RETURN(js, jobj, path, "instance_labels", match->chart_labels, error, strict);
 
     return true;
 }
 
-static bool parse_config_value_database_lookup(json_object *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, "after", config->after, error, strict);
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, "before", config->before, error, strict);
-    JSONC_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(jobj, path, "time_group", time_grouping_txt2id, config->time_group, error, strict);
-    JSONC_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(jobj, path, "dims_group", alerts_dims_grouping2id, config->dims_group, error, strict);
-    JSONC_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(jobj, path, "data_source", alerts_data_sources2id, config->data_source, error, strict);
+static bool parse_config_value_database_lookup(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, jobj, path, "after", config->after, error, strict);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, jobj, path, "before", config->before, error, strict);
+    JSONS_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(js, jobj, path, "time_group", time_grouping_txt2id, config->time_group, error, strict);
+    JSONS_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(js, jobj, path, "dims_group", alerts_dims_grouping2id, config->dims_group, error, strict);
+    JSONS_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(js, jobj, path, "data_source", alerts_data_sources2id, config->data_source, error, strict);
 
     switch(config->time_group) {
         default:
             break;
 
         case RRDR_GROUPING_COUNTIF:
-            JSONC_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(jobj, path, "time_group_condition", alerts_group_condition2id, config->time_group_condition, error, strict);
+            JSONS_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(js, jobj, path, "time_group_condition", alerts_group_condition2id, config->time_group_condition, error, strict);
             // fall through
 
         case RRDR_GROUPING_TRIMMED_MEAN:
         case RRDR_GROUPING_TRIMMED_MEDIAN:
         case RRDR_GROUPING_PERCENTILE:
-            JSONC_PARSE_DOUBLE_OR_ERROR_AND_RETURN(jobj, path, "time_group_value", config->time_group_value, error, strict);
+        case RRDR_GROUPING_PERCENTILE_APPROX:
+            JSONS_PARSE_DOUBLE_OR_ERROR_AND_RETURN(js, jobj, path, "time_group_value", config->time_group_value, error, strict);
             break;
     }
 
-    JSONC_PARSE_ARRAY_OF_TXT2BITMAP_OR_ERROR_AND_RETURN(jobj, path, "options", rrdr_options_parse_one, config->options, error, strict);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "dimensions", config->dimensions, error, strict);
+    JSONS_PARSE_ARRAY_OF_TXT2BITMAP_OR_ERROR_AND_RETURN(js, jobj, path, "options", rrdr_options_parse_one, config->options, error, strict);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "dimensions", config->dimensions, error, strict);
     return true;
 }
 
-static bool parse_config_value(json_object *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
-    JSONC_PARSE_SUBOBJECT(jobj, path, "database_lookup", config, parse_config_value_database_lookup, error, strict);
-    JSONC_PARSE_TXT2EXPRESSION_OR_ERROR_AND_RETURN(jobj, path, "calculation", config->calculation, error, false);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "units", config->units, error, false);
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, "update_every", config->update_every, error, strict);
+static bool parse_config_value(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
+    JSONS_PARSE_SUBOBJECT(js, jobj, path, "database_lookup", config, parse_config_value_database_lookup, error, strict);
+    JSONS_PARSE_TXT2EXPRESSION_OR_ERROR_AND_RETURN(js, jobj, path, "calculation", config->calculation, error, false);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "units", config->units, error, false);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, jobj, path, "update_every", config->update_every, error, strict);
     return true;
 }
 
-static bool parse_config_conditions(json_object *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
-    JSONC_PARSE_TXT2EXPRESSION_OR_ERROR_AND_RETURN(jobj, path, "warning_condition", config->warning, error, strict);
-    JSONC_PARSE_TXT2EXPRESSION_OR_ERROR_AND_RETURN(jobj, path, "critical_condition", config->critical, error, strict);
+static bool parse_config_conditions(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
+    JSONS_PARSE_TXT2EXPRESSION_OR_ERROR_AND_RETURN(js, jobj, path, "warning_condition", config->warning, error, strict);
+    JSONS_PARSE_TXT2EXPRESSION_OR_ERROR_AND_RETURN(js, jobj, path, "critical_condition", config->critical, error, strict);
     return true;
 }
 
-static bool parse_config_action_delay(json_object *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, "up", config->delay_up_duration, error, strict);
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, "down", config->delay_down_duration, error, strict);
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, "max", config->delay_max_duration, error, strict);
-    JSONC_PARSE_DOUBLE_OR_ERROR_AND_RETURN(jobj, path, "multiplier", config->delay_multiplier, error, strict);
+static bool parse_config_action_delay(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, jobj, path, "up", config->delay_up_duration, error, strict);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, jobj, path, "down", config->delay_down_duration, error, strict);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, jobj, path, "max", config->delay_max_duration, error, strict);
+    JSONS_PARSE_DOUBLE_OR_ERROR_AND_RETURN(js, jobj, path, "multiplier", config->delay_multiplier, error, strict);
     return true;
 }
 
-static bool parse_config_action_repeat(json_object *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
-    JSONC_PARSE_BOOL_OR_ERROR_AND_RETURN(jobj, path, "enabled", config->has_custom_repeat_config, error, strict);
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, "warning", config->warn_repeat_every, error, strict);
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, "critical", config->crit_repeat_every, error, strict);
+static bool parse_config_action_repeat(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
+    JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, jobj, path, "enabled", config->has_custom_repeat_config, error, strict);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, jobj, path, "warning", config->warn_repeat_every, error, strict);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, jobj, path, "critical", config->crit_repeat_every, error, strict);
     return true;
 }
 
-static bool parse_config_action(json_object *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
-    JSONC_PARSE_ARRAY_OF_TXT2BITMAP_OR_ERROR_AND_RETURN(jobj, path, "options", alert_action_options_parse_one, config->alert_action_options, error, strict);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "execute", config->exec, error, strict);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "recipient", config->recipient, error, strict);
-    JSONC_PARSE_SUBOBJECT(jobj, path, "delay", config, parse_config_action_delay, error, strict);
-    JSONC_PARSE_SUBOBJECT(jobj, path, "repeat", config, parse_config_action_repeat, error, strict);
+static bool parse_config_action(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, struct rrd_alert_config *config, BUFFER *error, bool strict) {
+    JSONS_PARSE_ARRAY_OF_TXT2BITMAP_OR_ERROR_AND_RETURN(js, jobj, path, "options", alert_action_options_parse_one, config->alert_action_options, error, strict);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "execute", config->exec, error, strict);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "recipient", config->recipient, error, strict);
+    JSONS_PARSE_SUBOBJECT(js, jobj, path, "delay", config, parse_config_action_delay, error, strict);
+    JSONS_PARSE_SUBOBJECT(js, jobj, path, "repeat", config, parse_config_action_repeat, error, strict);
     return true;
 }
 
-static bool parse_config(json_object *jobj, const char *path, RRD_ALERT_PROTOTYPE *ap, BUFFER *error, bool strict) {
+static bool parse_config(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, RRD_ALERT_PROTOTYPE *ap, BUFFER *error, bool strict) {
     // we shouldn't parse these from the payload - they are given to us via the function call
-    // JSONC_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(jobj, path, "source_type", dyncfg_source_type2id, ap->config.source_type, error, strict);
-    // JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "source", ap->config.source, error, strict);
+    // JSONS_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(js, jobj, path, "source_type", dyncfg_source_type2id, ap->config.source_type, error, strict);
+    // JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "source", ap->config.source, error, strict);
 
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "summary", ap->config.summary, error, false);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "info", ap->config.info, error, false);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "type", ap->config.type, error, false);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "component", ap->config.component, error, false);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "classification", ap->config.classification, error, false);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "summary", ap->config.summary, error, false);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "info", ap->config.info, error, false);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "type", ap->config.type, error, false);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "component", ap->config.component, error, false);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "classification", ap->config.classification, error, false);
 
-    JSONC_PARSE_SUBOBJECT(jobj, path, "value", &ap->config, parse_config_value, error, strict);
-    JSONC_PARSE_SUBOBJECT(jobj, path, "conditions", &ap->config, parse_config_conditions, error, false);
-    JSONC_PARSE_SUBOBJECT(jobj, path, "action", &ap->config, parse_config_action, error, false);
-    JSONC_PARSE_SUBOBJECT(jobj, path, "match", &ap->match, parse_match, error, strict);
+    JSONS_PARSE_SUBOBJECT(js, jobj, path, "value", &ap->config, parse_config_value, error, strict);
+    JSONS_PARSE_SUBOBJECT(js, jobj, path, "conditions", &ap->config, parse_config_conditions, error, false);
+    JSONS_PARSE_SUBOBJECT(js, jobj, path, "action", &ap->config, parse_config_action, error, false);
+    JSONS_PARSE_SUBOBJECT(js, jobj, path, "match", &ap->match, parse_match, error, strict);
 
     return true;
 }
 
-static bool parse_prototype(json_object *jobj, const char *path, RRD_ALERT_PROTOTYPE *base, BUFFER *error, const char *name, bool strict) {
+static bool parse_prototype(JSON_STREAM *js, JSON_STREAM_VALUE *jobj, const char *path, RRD_ALERT_PROTOTYPE *base, BUFFER *error, const char *name, bool strict) {
     int64_t version = 0;
-    JSONC_PARSE_UINT64_OR_ERROR_AND_RETURN(jobj, path, "format_version", version, error, strict);
+    JSONS_PARSE_UINT64_OR_ERROR_AND_RETURN(js, jobj, path, "format_version", version, error, strict);
 
     if(version != 1) {
         buffer_sprintf(error, "unsupported document version");
         return false;
     }
 
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "name", base->config.name, error, !name && !*name && strict);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, jobj, path, "name", base->config.name, error, !name && !*name && strict);
 
-    json_object *rules;
-    if (json_object_object_get_ex(jobj, "rules", &rules)) {
-        if (json_object_get_type(rules) != json_type_array) {
+    JSON_STREAM_VALUE rules;
+    if (json_stream_object_get(js, jobj, "rules", &rules)) {
+        if (rules.type != JSON_ARRAY) {
             buffer_sprintf(error, "member 'rules' is not an array");
             return false;
         }
 
-        size_t rules_len = json_object_array_length(rules);
+        JSON_STREAM_ITERATOR it;
+        JSON_STREAM_VALUE rule;
+        json_stream_iterator_init(js, &rules, &it);
 
         RRD_ALERT_PROTOTYPE *ap = base; // fill the first entry
-        for (size_t i = 0; i < rules_len; i++) {
+        while (json_stream_array_next(js, &it, &rule)) {
             if(!ap) {
                 ap = callocz(1, sizeof(*base));
                 ap->config.name = string_dup(base->config.name);
                 DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(base->_internal.next, ap, _internal.prev, _internal.next);
             }
 
-            json_object *rule = json_object_array_get_idx(rules, i);
-
-            JSONC_PARSE_BOOL_OR_ERROR_AND_RETURN(rule, path, "enabled", ap->match.enabled, error, strict);
+            JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, &rule, path, "enabled", ap->match.enabled, error, strict);
 
             STRING *type = NULL;
-            JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(rule, path, "type", type, error, strict);
+            JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, &rule, path, "type", type, error, strict);
             if(string_strcmp(type, "template") == 0)
                 ap->match.is_template = true;
             else if(string_strcmp(type, "instance") == 0)
@@ -194,7 +195,7 @@ static bool parse_prototype(json_object *jobj, const char *path, RRD_ALERT_PROTO
                 return false;
             }
 
-            JSONC_PARSE_SUBOBJECT(rule, path, "config", ap, parse_config, error, strict);
+            JSONS_PARSE_SUBOBJECT(js, &rule, path, "config", ap, parse_config, error, strict);
 
             ap = NULL; // so that we will create another one, if available
         }
@@ -209,24 +210,15 @@ static bool parse_prototype(json_object *jobj, const char *path, RRD_ALERT_PROTO
 
 static RRD_ALERT_PROTOTYPE *health_prototype_payload_parse(const char *payload, size_t payload_len, BUFFER *error, const char *name, bool strict) {
     RRD_ALERT_PROTOTYPE *base = callocz(1, sizeof(*base));
-    CLEAN_JSON_OBJECT *jobj = NULL;
-
-    struct json_tokener *tokener = json_tokener_new();
-    if (!tokener) {
-        buffer_sprintf(error, "failed to allocate memory for json tokener");
-        goto cleanup;
-    }
+    CLEAN_JSON_STREAM js = { 0 };
+    JSON_STREAM_VALUE root;
 
-    jobj = json_tokener_parse_ex(tokener, payload, (int)payload_len);
-    if (json_tokener_get_error(tokener) != json_tokener_success) {
-        const char *error_msg = json_tokener_error_desc(json_tokener_get_error(tokener));
-        buffer_sprintf(error, "failed to parse json payload: %s", error_msg);
-        json_tokener_free(tokener);
+    if(!json_stream_init(&js, payload, payload_len, &root)) {
+        buffer_sprintf(error, "failed to parse json payload: %s at position %zu", js.error, js.error_pos);
         goto cleanup;
     }
-    json_tokener_free(tokener);
 
-    if(!parse_prototype(jobj, "", base, error, name, strict))
+    if(!parse_prototype(&js, &root, "", base, error, name, strict))
         goto cleanup;
 
     if(!base->config.name && name)
@@ -422,6 +414,7 @@ int dyncfg_health_prototype_to_conf(BUFFER *wb, RRD_ALERT_PROTOTYPE *ap, const c
             buffer_sprintf(wb, "%13s: %s", "lookup", time_grouping_tostring(nap->config.time_group));
             switch(nap->config.time_group) {
                 case RRDR_GROUPING_PERCENTILE:
+                case RRDR_GROUPING_PERCENTILE_APPROX:
                 case RRDR_GROUPING_TRIMMED_MEAN:
                 case RRDR_GROUPING_TRIMMED_MEDIAN:
                     buffer_sprintf(wb, "(%0.2f)", nap->config.time_group_value);
@@ -86,6 +86,53 @@ static inline int rrdcalc_isrunnable(RRDCALC *rc, time_t now, time_t *next_run)
     return 1;
 }
 
+// ----------------------------------------------------------------------------
+// shared lookups
+//
+// Alerts on the same chart usually run the same lookup, so while examining the
+// alerts of a host we run each distinct lookup once, and give its result to
+// all the alerts asking for it.
+
+struct health_lookup_result {
+    int ret;
+    int value_is_null;
+    NETDATA_DOUBLE value;
+    time_t db_after;
+    time_t db_before;
+};
+
+static void health_lookup(DICTIONARY *lookups, RRDCALC *rc, const char *group_options, int *value_is_null) {
+    const char *dimensions = rrdcalc_dimensions(rc);
+    char key[100 + strlen(dimensions) + (group_options ? strlen(group_options) : 0)];
+    snprintfz(key, sizeof(key), "%p|%d|%d|%u|%s|%"PRIx64"|%s",
+              rc->rrdset, rc->config.after, rc->config.before, (unsigned)rc->config.time_group,
+              group_options ? group_options : "", (uint64_t)rc->config.options, dimensions);
+
+    struct health_lookup_result *r = dictionary_get(lookups, key);
+    if(!r) {
+        struct health_lookup_result t = {
+            .value_is_null = 0,
+        };
+
+        t.ret = rrdset2value_api_v1(rc->rrdset, NULL, &t.value, dimensions, 1,
+                                    rc->config.after, rc->config.before, rc->config.time_group, group_options,
+                                    0, rc->config.options | RRDR_OPTION_SELECTED_TIER,
+                                    &t.db_after, &t.db_before,
+                                    NULL, NULL, NULL,
+                                    &t.value_is_null, NULL, 0, 0,
+                                    QUERY_SOURCE_HEALTH, STORAGE_PRIORITY_SYNCHRONOUS);
+
+        r = dictionary_set(lookups, key, &t, sizeof(t));
+    }
+
+    rc->value = r->value;
+    rc->db_after = r->db_after;
+    rc->db_before = r->db_before;
+    *value_is_null = r->value_is_null;
+
+    rc->run_flags = (r->ret != 200) ? (rc->run_flags | RRDCALC_FLAG_DB_ERROR) : (rc->run_flags & ~RRDCALC_FLAG_DB_ERROR);
+}
+
 static void health_sleep(time_t next_run, unsigned int loop __maybe_unused) {
     time_t now = now_realtime_sec();
     if(now < next_run) {
@@ -144,7 +191,7 @@ static void health_initialize_rrdhost(RRDHOST *host) {
 }
 
 static inline int check_if_resumed_from_suspension(void) {
-    static usec_t last_realtime = 0, last_monotonic = 0;
+    static __thread usec_t last_realtime = 0, last_monotonic = 0;
     usec_t realtime = now_realtime_usec(), monotonic = now_monotonic_usec();
     int ret = 0;
 
@@ -204,7 +251,15 @@ static void do_eval_expression(
         *result = expression_result(expression);
 }
 
-static void health_event_loop(void) {
+// each health thread examines the hosts of its partition
+static inline bool health_thread_owns_host(RRDHOST *host, size_t thread_id, size_t threads) {
+    if(threads < 2)
+        return true;
+
+    return simple_hash(host->machine_guid) % threads == thread_id;
+}
+
+static void health_event_loop(size_t thread_id, size_t threads) {
     bool health_running_logged = false;
 
     unsigned int loop = 0;
@@ -214,7 +269,7 @@ static void health_event_loop(void) {
         netdata_log_debug(D_HEALTH, "Health monitoring iteration no %u started", loop);
 
         time_t now = now_realtime_sec();
-        int runnable = 0, apply_hibernation_delay = 0;
+        int runnable, apply_hibernation_delay = 0;
         time_t next_run = now + health_globals.config.run_at_least_every_seconds;
         RRDCALC *rc;
         RRDHOST *host;
@@ -247,6 +302,9 @@ static void health_event_loop(void) {
             if (unlikely(!host->health.health_enabled))
                 continue;
 
+            if (!health_thread_owns_host(host, thread_id, threads))
+                continue;
+
             if (unlikely(!rrdhost_flag_check(host, RRDHOST_FLAG_INITIALIZED_HEALTH)))
                 health_initialize_rrdhost(host);
 
@@ -301,137 +359,147 @@ static void health_event_loop(void) {
                     continue;
             }
 
-            // the first loop is to lookup values from the db
-            foreach_rrdcalc_in_rrdhost_read(host, rc) {
+            // hosts keep the time their next alert is due, so that we examine
+            // their alerts only when there is something to run
+            runnable = 0;
+            time_t host_next_run = __atomic_load_n(&host->health.next_run, __ATOMIC_RELAXED);
+            bool host_is_due = apply_hibernation_delay || host_next_run <= now;
+            if(host_is_due)
+                host_next_run = now + health_globals.config.run_at_least_every_seconds;
 
-                if(unlikely(!service_running(SERVICE_HEALTH)))
-                    break;
+            // the first loop is to lookup values from the db
+            if(host_is_due) {
+                DICTIONARY *lookups = dictionary_create_advanced(
+                    DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE,
+                    NULL, sizeof(struct health_lookup_result));
 
-                rrdcalc_update_info_using_rrdset_labels(rc);
+                foreach_rrdcalc_in_rrdhost_read(host, rc) {
 
-                if (health_silencers_update_disabled_silenced(host, rc))
-                    continue;
+                    if(unlikely(!service_running(SERVICE_HEALTH)))
+                        break;
 
-                // create an alert removed event if the chart is obsolete and
-                // has stopped being collected for 60 seconds
-                if (unlikely(rc->rrdset && rc->status != RRDCALC_STATUS_REMOVED &&
-                             rrdset_flag_check(rc->rrdset, RRDSET_FLAG_OBSOLETE) &&
-                             now > (rc->rrdset->last_collected_time.tv_sec + 60))) {
+                    rrdcalc_update_info_using_rrdset_labels(rc);
 
-                    if (!rrdcalc_isrepeating(rc)) {
-                        worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_ENTRY);
-                        time_t now_tmp = now_realtime_sec();
+                    if (health_silencers_update_disabled_silenced(host, rc))
+                        continue;
 
-                        ALARM_ENTRY *ae =
-                            health_create_alarm_entry(
-                                host,
-                                rc,
-                                now_tmp,
-                                now_tmp - rc->last_status_change,
-                                rc->value,
-                                NAN,
-                                rc->status,
-                                RRDCALC_STATUS_REMOVED,
-                                0,
-                                rrdcalc_isrepeating(rc)?HEALTH_ENTRY_FLAG_IS_REPEATING:0);
-
-                        if (ae) {
-                            health_log_alert(host, ae);
-                            health_alarm_log_add_entry(host, ae);
-                            rc->old_status = rc->status;
-                            rc->status = RRDCALC_STATUS_REMOVED;
-                            rc->last_status_change = now_tmp;
-                            rc->last_status_change_value = rc->value;
-                            rc->last_updated = now_tmp;
-                            rc->value = NAN;
+                    // create an alert removed event if the chart is obsolete and
+                    // has stopped being collected for 60 seconds
+                    if (unlikely(rc->rrdset && rc->status != RRDCALC_STATUS_REMOVED &&
+                                 rrdset_flag_check(rc->rrdset, RRDSET_FLAG_OBSOLETE) &&
+                                 now > (rc->rrdset->last_collected_time.tv_sec + 60))) {
+
+                        if (!rrdcalc_isrepeating(rc)) {
+                            worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_ENTRY);
+                            time_t now_tmp = now_realtime_sec();
+
+                            ALARM_ENTRY *ae =
+                                health_create_alarm_entry(
+                                    host,
+                                    rc,
+                                    now_tmp,
+                                    now_tmp - rc->last_status_change,
+                                    rc->value,
+                                    NAN,
+                                    rc->status,
+                                    RRDCALC_STATUS_REMOVED,
+                                    0,
+                                    rrdcalc_isrepeating(rc)?HEALTH_ENTRY_FLAG_IS_REPEATING:0);
+
+                            if (ae) {
+                                health_log_alert(host, ae);
+                                health_alarm_log_add_entry(host, ae);
+                                rc->old_status = rc->status;
+                                rc->status = RRDCALC_STATUS_REMOVED;
+                                rc->last_status_change = now_tmp;
+                                rc->last_status_change_value = rc->value;
+                                rc->last_updated = now_tmp;
+                                rc->value = NAN;
+                            }
                         }
                     }
-                }
-
-                if (unlikely(!rrdcalc_isrunnable(rc, now, &next_run))) {
-                    if (unlikely(rc->run_flags & RRDCALC_FLAG_RUNNABLE))
-                        rc->run_flags &= ~RRDCALC_FLAG_RUNNABLE;
-                    continue;
-                }
 
-                runnable++;
-                rc->old_value = rc->value;
-                rc->run_flags |= RRDCALC_FLAG_RUNNABLE;
+                    if (unlikely(!rrdcalc_isrunnable(rc, now, &host_next_run))) {
+                        if (unlikely(rc->run_flags & RRDCALC_FLAG_RUNNABLE))
+                            rc->run_flags &= ~RRDCALC_FLAG_RUNNABLE;
+                        continue;
+                    }
 
-                // ------------------------------------------------------------
-                // if there is database lookup, do it
+                    runnable++;
+                    rc->old_value = rc->value;
+                    rc->run_flags |= RRDCALC_FLAG_RUNNABLE;
+
+                    // ------------------------------------------------------------
+                    // if there is database lookup, do it
+
+                    if (unlikely(RRDCALC_HAS_DB_LOOKUP(rc))) {
+                        worker_is_busy(WORKER_HEALTH_JOB_DB_QUERY);
+
+                        /* time_t old_db_timestamp = rc->db_before; */
+                        int value_is_null = 0;
+
+                        char group_options_buf[100];
+                        const char *group_options = group_options_buf;
+                        switch(rc->config.time_group) {
+                            default:
+                                group_options = NULL;
+                                break;
+
+                            case RRDR_GROUPING_PERCENTILE:
+                            case RRDR_GROUPING_PERCENTILE_APPROX:
+                            case RRDR_GROUPING_TRIMMED_MEAN:
+                            case RRDR_GROUPING_TRIMMED_MEDIAN:
+                                snprintfz(group_options_buf, sizeof(group_options_buf),
+                                          NETDATA_DOUBLE_FORMAT_AUTO,
+                                          rc->config.time_group_value);
+                                break;
+
+                            case RRDR_GROUPING_COUNTIF:
+                                snprintfz(group_options_buf, sizeof(group_options_buf),
+                                          "%s" NETDATA_DOUBLE_FORMAT_AUTO,
+                                          alerts_group_conditions_id2txt(rc->config.time_group_condition),
+                                          rc->config.time_group_value);
+                                break;
+                        }
 
-                if (unlikely(RRDCALC_HAS_DB_LOOKUP(rc))) {
-                    worker_is_busy(WORKER_HEALTH_JOB_DB_QUERY);
+                        if(!health_window_lookup(rc, now, &value_is_null))
+                            health_lookup(lookups, rc, group_options, &value_is_null);
 
-                    /* time_t old_db_timestamp = rc->db_before; */
-                    int value_is_null = 0;
+                        if (unlikely(rc->run_flags & RRDCALC_FLAG_DB_ERROR)) {
+                            // database lookup failed
+                            rc->value = NAN;
 
-                    char group_options_buf[100];
-                    const char *group_options = group_options_buf;
-                    switch(rc->config.time_group) {
-                        default:
-                            group_options = NULL;
-                            break;
+                            netdata_log_debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database lookup returned error",
+                                              rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc)
+                            );
+                        }
 
-                        case RRDR_GROUPING_PERCENTILE:
-                        case RRDR_GROUPING_TRIMMED_MEAN:
-                        case RRDR_GROUPING_TRIMMED_MEDIAN:
-                            snprintfz(group_options_buf, sizeof(group_options_buf),
-                                      NETDATA_DOUBLE_FORMAT_AUTO,
-                                      rc->config.time_group_value);
-                            break;
+                        if (unlikely(value_is_null)) {
+                            // collected value is null
+                            rc->value = NAN;
+                            rc->run_flags |= RRDCALC_FLAG_DB_NAN;
 
-                        case RRDR_GROUPING_COUNTIF:
-                            snprintfz(group_options_buf, sizeof(group_options_buf),
-                                      "%s" NETDATA_DOUBLE_FORMAT_AUTO,
-                                      alerts_group_conditions_id2txt(rc->config.time_group_condition),
-                                      rc->config.time_group_value);
-                            break;
-                    }
+                            netdata_log_debug(D_HEALTH,
+                                              "Health on host '%s', alarm '%s.%s': database lookup returned empty value (possibly value is not collected yet)",
+                                              rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc)
+                            );
+                        } else
+                            rc->run_flags &= ~RRDCALC_FLAG_DB_NAN;
 
-                    int ret = rrdset2value_api_v1(rc->rrdset, NULL, &rc->value, rrdcalc_dimensions(rc), 1,
-                                                  rc->config.after, rc->config.before, rc->config.time_group, group_options,
-                                                  0, rc->config.options | RRDR_OPTION_SELECTED_TIER,
-                                                  &rc->db_after,&rc->db_before,
-                                                  NULL, NULL, NULL,
-                                                  &value_is_null, NULL, 0, 0,
-                                                  QUERY_SOURCE_HEALTH, STORAGE_PRIORITY_SYNCHRONOUS);
-
-                    if (unlikely(ret != 200)) {
-                        // database lookup failed
-                        rc->value = NAN;
-                        rc->run_flags |= RRDCALC_FLAG_DB_ERROR;
-
-                        netdata_log_debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database lookup returned error %d",
-                                          rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc), ret
+                        netdata_log_debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database lookup gave value " NETDATA_DOUBLE_FORMAT,
+                                          rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc), rc->value
                         );
-                    } else
-                        rc->run_flags &= ~RRDCALC_FLAG_DB_ERROR;
-
-                    if (unlikely(value_is_null)) {
-                        // collected value is null
-                        rc->value = NAN;
-                        rc->run_flags |= RRDCALC_FLAG_DB_NAN;
+                    }
 
-                        netdata_log_debug(D_HEALTH,
-                                          "Health on host '%s', alarm '%s.%s': database lookup returned empty value (possibly value is not collected yet)",
-                                          rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc)
-                        );
-                    } else
-                        rc->run_flags &= ~RRDCALC_FLAG_DB_NAN;
+                    // ------------------------------------------------------------
+                    // if there is calculation expression, run it
 
-                    netdata_log_debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database lookup gave value " NETDATA_DOUBLE_FORMAT,
-                                      rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc), rc->value
-                    );
+                    do_eval_expression(rc, rc->config.calculation, "calculation", WORKER_HEALTH_JOB_CALC_EVAL, RRDCALC_FLAG_CALC_ERROR, NULL, &rc->value);
                 }
+                foreach_rrdcalc_in_rrdhost_done(rc);
 
-                // ------------------------------------------------------------
-                // if there is calculation expression, run it
-
-                do_eval_expression(rc, rc->config.calculation, "calculation", WORKER_HEALTH_JOB_CALC_EVAL, RRDCALC_FLAG_CALC_ERROR, NULL, &rc->value);
+                dictionary_destroy(lookups);
             }
-            foreach_rrdcalc_in_rrdhost_done(rc);
 
             struct health_raised_summary *hrm = alerts_raised_summary_create(host);
 
@@ -562,8 +630,8 @@ static void health_event_loop(void) {
                     rc->last_updated = now;
                     rc->next_update = now + rc->config.update_every;
 
-                    if (next_run > rc->next_update)
-                        next_run = rc->next_update;
+                    if (host_next_run > rc->next_update)
+                        host_next_run = rc->next_update;
                 }
                 foreach_rrdcalc_in_rrdhost_done(rc);
 
@@ -630,6 +698,10 @@ static void health_event_loop(void) {
                 foreach_rrdcalc_in_rrdhost_done(rc);
             }
 
+            __atomic_store_n(&host->health.next_run, host_next_run, __ATOMIC_RELAXED);
+            if(next_run > host_next_run)
+                next_run = host_next_run;
+
             if (unlikely(!service_running(SERVICE_HEALTH)))
                 break;
 
@@ -641,6 +713,9 @@ static void health_event_loop(void) {
             alerts_raised_summary_free(hrm);
 
             if (unlikely(!service_running(SERVICE_HEALTH))) {
+                // the queued notifications are dropped
+                health_notifications_batch_dispatch(true);
+
                 // wait for all notifications to finish before allowing health to be cleaned up
                 wait_for_all_notifications_to_finish_before_allowing_health_to_be_cleaned_up();
                 break;
@@ -657,6 +732,9 @@ static void health_event_loop(void) {
 
         dfe_done(host);
 
+        // deliver the batch of the queued notifications, when its window has passed
+        health_notifications_batch_dispatch(false);
+
         // wait for all notifications to finish before allowing health to be cleaned up
         wait_for_all_notifications_to_finish_before_allowing_health_to_be_cleaned_up();
 
@@ -681,8 +759,8 @@ static void health_main_cleanup(void *pptr) {
     nd_log(NDLS_DAEMON, NDLP_DEBUG, "Health thread ended.");
 }
 
-void *health_main(void *ptr) {
-    worker_register("HEALTH");
+static void health_worker_register(const char *name) {
+    worker_register(name);
     worker_register_job_name(WORKER_HEALTH_JOB_RRD_LOCK, "rrd lock");
     worker_register_job_name(WORKER_HEALTH_JOB_HOST_LOCK, "host lock");
     worker_register_job_name(WORKER_HEALTH_JOB_DB_QUERY, "db lookup");
@@ -693,8 +771,51 @@ void *health_main(void *ptr) {
     worker_register_job_name(WORKER_HEALTH_JOB_ALARM_LOG_PROCESS, "alarm log process");
     worker_register_job_name(WORKER_HEALTH_JOB_DELAYED_INIT_RRDSET, "rrdset init");
     worker_register_job_name(WORKER_HEALTH_JOB_DELAYED_INIT_RRDDIM, "rrddim init");
+}
+
+struct health_thread {
+    ND_THREAD *thread;
+    size_t id;
+    size_t threads;
+};
+
+static void *health_partition_main(void *ptr) {
+    struct health_thread *ht = ptr;
+
+    char tag[NETDATA_THREAD_TAG_MAX + 1];
+    snprintfz(tag, sizeof(tag), "HEALTH[%zu]", ht->id);
+    health_worker_register(tag);
+
+    health_event_loop(ht->id, ht->threads);
+
+    worker_unregister();
+    return NULL;
+}
+
+void *health_main(void *ptr) {
+    health_worker_register("HEALTH");
 
     CLEANUP_FUNCTION_REGISTER(health_main_cleanup) cleanup_ptr = ptr;
-    health_event_loop();
+
+    // the hosts are partitioned between the health threads,
+    // this thread runs the first partition
+    size_t threads = health_globals.config.threads;
+    struct health_thread *ht = callocz(threads, sizeof(*ht));
+    for(size_t i = 1; i < threads ; i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, sizeof(tag), "HEALTH[%zu]", i);
+
+        ht[i].id = i;
+        ht[i].threads = threads;
+        ht[i].thread = nd_thread_create(tag, NETDATA_THREAD_OPTION_DEFAULT, health_partition_main, &ht[i]);
+    }
+
+    health_event_loop(0, threads);
+
+    for(size_t i = 1; i < threads ; i++)
+        if(ht[i].thread)
+            nd_thread_join(ht[i].thread);
+
+    freez(ht);
     return NULL;
 }
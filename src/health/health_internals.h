@@ -67,6 +67,7 @@ void health_prototype_free(RRD_ALERT_PROTOTYPE *ap);
 struct health_plugin_globals {
     struct {
         SPINLOCK spinlock;
+        bool loaded;                // the configuration and the prototypes have been loaded
         bool done;
     } initialization;
 
@@ -89,10 +90,23 @@ struct health_plugin_globals {
 
         int32_t run_at_least_every_seconds;
         int32_t postpone_alarms_during_hibernation_for_seconds;
+
+        size_t threads;                         // the health threads, each examining a partition of the hosts
+        bool incremental_lookups;               // calculate the lookups that support it incrementally
+
+        uint32_t notifications_batch_window_s;  // queue the notifications of the stock script for this long, 0 = disabled
+        STRING *batch_exec;                     // the stock script, the only one that can receive batches
     } config;
 
     struct {
         DICTIONARY *dict;
+        size_t version;                         // incremented every time prototypes are added or deleted
+
+        struct {
+            RW_SPINLOCK spinlock;
+            size_t version;                     // the version of the prototypes the index has been built for
+            DICTIONARY *dict;                   // context, chart id or name -> the prototypes that may match it
+        } index;
     } prototypes;
 };
 
@@ -103,6 +117,7 @@ void unlink_alarm_notify_in_progress(ALARM_ENTRY *ae);
 void wait_for_all_notifications_to_finish_before_allowing_health_to_be_cleaned_up(void);
 
 void health_alarm_wait_for_execution(ALARM_ENTRY *ae);
+void health_notifications_batch_dispatch(bool force);
 
 bool rrdcalc_add_from_prototype(RRDHOST *host, RRDSET *st, RRD_ALERT_PROTOTYPE *ap);
 
@@ -116,6 +131,9 @@ void health_prototype_to_json(BUFFER *wb, RRD_ALERT_PROTOTYPE *ap, bool for_hash
 
 bool alert_variable_lookup(STRING *variable, void *data, NETDATA_DOUBLE *result);
 
+bool health_window_lookup(RRDCALC *rc, time_t now, int *value_is_null);
+void health_window_free(RRDCALC *rc);
+
 struct health_raised_summary;
 struct health_raised_summary *alerts_raised_summary_create(RRDHOST *host);
 void alerts_raised_summary_populate(struct health_raised_summary *hrm);
@@ -6,6 +6,10 @@
 
 inline void health_alarm_log_save(RRDHOST *host, ALARM_ENTRY *ae)
 {
+    // the transitions log is append-only, it gets each transition once, when it is first saved
+    if (!(ae->flags & HEALTH_ENTRY_FLAG_SAVED))
+        health_transitions_log_append(host, ae);
+
     sql_health_alarm_log_save(host, ae);
 }
 
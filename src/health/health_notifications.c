@@ -2,8 +2,9 @@
 
 #include "health_internals.h"
 
-// the queue of executed alarm notifications that haven't been waited for yet
-static struct {
+// the queue of executed alarm notifications that haven't been waited for yet,
+// one per health thread
+static __thread struct {
     ALARM_ENTRY *head; // oldest
     ALARM_ENTRY *tail; // latest
 } alarm_notifications_in_progress = {NULL, NULL};
@@ -132,11 +133,14 @@ static bool prepare_command(BUFFER *wb,
     char buf[8192];
     size_t n = sizeof(buf) - 1;
 
-    buffer_strcat(wb, "exec");
+    // without exec, only the arguments are prepared
+    if(exec) {
+        buffer_strcat(wb, "exec");
 
-    if (!sanitize_command_argument_string(buf, exec, n))
-        return false;
-    buffer_sprintf(wb, " '%s'", buf);
+        if (!sanitize_command_argument_string(buf, exec, n))
+            return false;
+        buffer_sprintf(wb, " '%s'", buf);
+    }
 
     if (!sanitize_command_argument_string(buf, recipient, n))
         return false;
@@ -350,6 +354,217 @@ static const char *health_raised_summary_my_expression_error(struct health_raise
     return "";
 }
 
+// ----------------------------------------------------------------------------
+// batched notifications
+// when a batch window is configured, the notifications of the stock script are queued
+// and delivered with a single execution of it, at most once per window
+
+typedef struct health_notification_queued {
+    char machine_guid[GUID_LEN + 1];
+    uint32_t alarm_id;
+    uint32_t unique_id;
+    usec_t queued_ut;
+    int exec_code;
+    bool exec_code_reported;
+    char *record;                   // the arguments of the script, quoted for the shell
+} HEALTH_NOTIFICATION_QUEUED;
+
+// the queue of notifications waiting for their batch, one per health thread
+static __thread struct {
+    size_t size;
+    size_t used;
+    HEALTH_NOTIFICATION_QUEUED *array; // oldest first
+} health_notifications_queue = { 0, 0, NULL };
+
+static HEALTH_NOTIFICATIONS_STATISTICS health_notifications_stats = { 0 };
+
+bool health_notifications_statistics(HEALTH_NOTIFICATIONS_STATISTICS *stats) {
+    if(!health_globals.config.notifications_batch_window_s)
+        return false;
+
+    stats->queued = __atomic_load_n(&health_notifications_stats.queued, __ATOMIC_RELAXED);
+    stats->coalesced = __atomic_load_n(&health_notifications_stats.coalesced, __ATOMIC_RELAXED);
+    stats->delivered = __atomic_load_n(&health_notifications_stats.delivered, __ATOMIC_RELAXED);
+    stats->batches = __atomic_load_n(&health_notifications_stats.batches, __ATOMIC_RELAXED);
+    stats->latency_ut = __atomic_load_n(&health_notifications_stats.latency_ut, __ATOMIC_RELAXED);
+    stats->latency_max_ut = __atomic_exchange_n(&health_notifications_stats.latency_max_ut, 0, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void health_notifications_statistics_latency(usec_t dt) {
+    __atomic_add_fetch(&health_notifications_stats.delivered, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&health_notifications_stats.latency_ut, dt, __ATOMIC_RELAXED);
+
+    usec_t old_max = __atomic_load_n(&health_notifications_stats.latency_max_ut, __ATOMIC_RELAXED);
+    while(dt > old_max &&
+           !__atomic_compare_exchange_n(&health_notifications_stats.latency_max_ut, &old_max, dt, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static inline bool health_notification_can_be_batched(ALARM_ENTRY *ae, const char *exec) {
+    // repeating alerts are waited for and freed as soon as they are sent
+    return health_globals.config.notifications_batch_window_s &&
+           !(ae->flags & HEALTH_ENTRY_FLAG_IS_REPEATING) &&
+           strcmp(exec, string2str(health_globals.config.batch_exec)) == 0;
+}
+
+static ALARM_ENTRY *health_alarm_log_find_unique_id(RRDHOST *host, uint32_t unique_id) {
+    for(ALARM_ENTRY *ae = host->health_log.alarms; ae ; ae = ae->next)
+        if(ae->unique_id == unique_id)
+            return ae;
+
+    return NULL;
+}
+
+static void health_notifications_queue_del(size_t slot) {
+    freez(health_notifications_queue.array[slot].record);
+
+    memmove(&health_notifications_queue.array[slot], &health_notifications_queue.array[slot + 1],
+            (health_notifications_queue.used - slot - 1) * sizeof(HEALTH_NOTIFICATION_QUEUED));
+
+    health_notifications_queue.used--;
+}
+
+static void health_notifications_queue_add(RRDHOST *host, ALARM_ENTRY *ae, const char *record) {
+    if(health_notifications_queue.used >= health_notifications_queue.size) {
+        health_notifications_queue.size = health_notifications_queue.size ? health_notifications_queue.size * 2 : 16;
+        health_notifications_queue.array = reallocz(health_notifications_queue.array,
+                                                    health_notifications_queue.size * sizeof(HEALTH_NOTIFICATION_QUEUED));
+    }
+
+    // the queue outlives the host locks, so it keeps the ids of the alert, not pointers to it
+    HEALTH_NOTIFICATION_QUEUED *q = &health_notifications_queue.array[health_notifications_queue.used++];
+    strncpyz(q->machine_guid, host->machine_guid, GUID_LEN);
+    q->alarm_id = ae->alarm_id;
+    q->unique_id = ae->unique_id;
+    q->queued_ut = now_monotonic_usec();
+    q->exec_code = 0;
+    q->exec_code_reported = false;
+    q->record = strdupz(record);
+
+    __atomic_add_fetch(&health_notifications_stats.queued, 1, __ATOMIC_RELAXED);
+}
+
+// a new transition of an alert supersedes its queued notification, which is never delivered,
+// so a flapping alert sends only its latest status, and one that recovers within the window
+// sends nothing at all (its clear notification is suppressed, as for any alert never notified)
+static void health_notifications_queue_coalesce(RRDHOST *host, ALARM_ENTRY *ae) {
+    for(size_t i = 0; i < health_notifications_queue.used ; i++) {
+        HEALTH_NOTIFICATION_QUEUED *q = &health_notifications_queue.array[i];
+        if(q->alarm_id != ae->alarm_id || strcmp(q->machine_guid, host->machine_guid) != 0)
+            continue;
+
+        ALARM_ENTRY *old = health_alarm_log_find_unique_id(host, q->unique_id);
+        if(old) {
+            old->flags &= ~(HEALTH_ENTRY_FLAG_EXEC_RUN | HEALTH_ENTRY_FLAG_EXEC_IN_PROGRESS);
+            health_alarm_log_save(host, old);
+        }
+
+        health_notifications_queue_del(i);
+        __atomic_add_fetch(&health_notifications_stats.coalesced, 1, __ATOMIC_RELAXED);
+        break;
+    }
+}
+
+static void health_notifications_batch_completed(HEALTH_NOTIFICATION_QUEUED *q, bool spawned, int code) {
+    RRDHOST *host = rrdhost_find_by_guid(q->machine_guid);
+    if(!host)
+        return;
+
+    rw_spinlock_read_lock(&host->health_log.spinlock);
+
+    ALARM_ENTRY *ae = health_alarm_log_find_unique_id(host, q->unique_id);
+    if(ae) {
+        ae->flags &= ~HEALTH_ENTRY_FLAG_EXEC_IN_PROGRESS;
+        ae->exec_code = q->exec_code_reported ? q->exec_code : code;
+
+        if(!spawned || ae->exec_code != 0)
+            ae->flags |= HEALTH_ENTRY_FLAG_EXEC_FAILED;
+
+        health_alarm_log_save(host, ae);
+    }
+
+    rw_spinlock_read_unlock(&host->health_log.spinlock);
+}
+
+void health_notifications_batch_dispatch(bool force) {
+    size_t entries = health_notifications_queue.used;
+    if(!entries)
+        return;
+
+    usec_t now_ut = now_monotonic_usec();
+    if(!force && health_notifications_queue.array[0].queued_ut + health_globals.config.notifications_batch_window_s * USEC_PER_SEC > now_ut)
+        return;
+
+    if(unlikely(!service_running(SERVICE_HEALTH)))
+        goto cleanup;
+
+    char filename[FILENAME_MAX + 1];
+    snprintfz(filename, FILENAME_MAX, "%s/health-notifications-XXXXXX", netdata_configured_cache_dir);
+
+    int fd = mkstemp(filename);
+    FILE *fp = (fd != -1) ? fdopen(fd, "w") : NULL;
+    if(!fp) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "HEALTH: cannot create the batch file '%s' for %zu notifications", filename, entries);
+        if(fd != -1) {
+            close(fd);
+            unlink(filename);
+        }
+
+        for(size_t i = 0; i < entries ; i++)
+            health_notifications_batch_completed(&health_notifications_queue.array[i], false, 128);
+
+        goto cleanup;
+    }
+
+    for(size_t i = 0; i < entries ; i++) {
+        fprintf(fp, "%s\n", health_notifications_queue.array[i].record);
+        health_notifications_statistics_latency(now_ut - health_notifications_queue.array[i].queued_ut);
+    }
+
+    bool ok = (fclose(fp) == 0);
+    int code = 128;
+    POPEN_INSTANCE *pi = NULL;
+
+    if(ok) {
+        netdata_log_debug(D_HEALTH, "executing '%s batch %s' for %zu notifications",
+                          string2str(health_globals.config.batch_exec), filename, entries);
+
+        pi = spawn_popen_run_variadic(string2str(health_globals.config.batch_exec), "batch", filename, NULL);
+    }
+
+    if(pi) {
+        __atomic_add_fetch(&health_notifications_stats.batches, 1, __ATOMIC_RELAXED);
+
+        // the script reports the exit code of each notification, as "line code"
+        FILE *out = spawn_popen_stdout(pi);
+        char line[100];
+        while(out && fgets(line, sizeof(line), out)) {
+            size_t slot;
+            int rc;
+            if(sscanf(line, "%zu %d", &slot, &rc) == 2 && slot >= 1 && slot <= entries) {
+                health_notifications_queue.array[slot - 1].exec_code = rc;
+                health_notifications_queue.array[slot - 1].exec_code_reported = true;
+            }
+        }
+
+        code = spawn_popen_wait(pi);
+    }
+    else
+        nd_log(NDLS_DAEMON, NDLP_ERR, "HEALTH: failed to execute the batch of %zu alert notifications", entries);
+
+    for(size_t i = 0; i < entries ; i++)
+        health_notifications_batch_completed(&health_notifications_queue.array[i], pi != NULL, code);
+
+    unlink(filename);
+
+cleanup:
+    for(size_t i = 0; i < entries ; i++)
+        freez(health_notifications_queue.array[i].record);
+
+    health_notifications_queue.used = 0;
+}
+
 void health_send_notification(RRDHOST *host, ALARM_ENTRY *ae, struct health_raised_summary *hrm) {
     netdata_log_debug(D_HEALTH, "Health alarm '%s.%s' = " NETDATA_DOUBLE_FORMAT_AUTO " - changed status from %s to %s",
                       ae->chart?ae_chart_id(ae):"NOCHART", ae_name(ae),
@@ -360,6 +575,9 @@ void health_send_notification(RRDHOST *host, ALARM_ENTRY *ae, struct health_rais
 
     ae->flags |= HEALTH_ENTRY_FLAG_PROCESSED;
 
+    if(unlikely(health_notifications_queue.used))
+        health_notifications_queue_coalesce(host, ae);
+
     if(unlikely(ae->new_status < RRDCALC_STATUS_CLEAR)) {
         // do not send notifications for internal statuses
         netdata_log_debug(D_HEALTH, "Health not sending notification for alarm '%s.%s' status %s (internal statuses)", ae_chart_id(ae), ae_name(ae), rrdcalc_status2string(ae->new_status));
@@ -432,9 +650,11 @@ void health_send_notification(RRDHOST *host, ALARM_ENTRY *ae, struct health_rais
     size_t n_warn = health_raised_summary_entries(hrm, warn_alarms, ae, RRDCALC_STATUS_WARNING);
     size_t n_crit = health_raised_summary_entries(hrm, crit_alarms, ae, RRDCALC_STATUS_CRITICAL);
 
+    bool batched = health_notification_can_be_batched(ae, exec);
+
     BUFFER *wb = buffer_create(8192, &netdata_buffers_statistics.buffers_health);
     bool ok = prepare_command(wb,
-                              exec,
+                              batched ? NULL : exec,
                               recipient,
                               rrdhost_registry_hostname(host),
                               ae->unique_id,
@@ -471,7 +691,15 @@ void health_send_notification(RRDHOST *host, ALARM_ENTRY *ae, struct health_rais
     );
 
     const char *command_to_run = buffer_tostring(wb);
-    if (ok) {
+    if (ok && batched) {
+        ae->flags |= HEALTH_ENTRY_FLAG_EXEC_RUN | HEALTH_ENTRY_FLAG_EXEC_IN_PROGRESS;
+        ae->exec_run_timestamp = now_realtime_sec();
+
+        netdata_log_debug(D_HEALTH, "queueing notification '%s'", command_to_run);
+        health_notifications_queue_add(host, ae, command_to_run);
+        health_alarm_log_save(host, ae);
+    }
+    else if (ok) {
         ae->flags |= HEALTH_ENTRY_FLAG_EXEC_RUN;
         ae->exec_run_timestamp = now_realtime_sec(); /* will be updated by real time after spawning */
 
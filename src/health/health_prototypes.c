@@ -281,6 +281,7 @@ bool health_prototype_conflict_cb(const DICTIONARY_ITEM *item __maybe_unused, vo
 void health_prototype_delete_cb(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused) {
     RRD_ALERT_PROTOTYPE *ap = value;
     health_prototype_cleanup(ap);
+    __atomic_add_fetch(&health_globals.prototypes.version, 1, __ATOMIC_RELAXED);
 }
 
 void health_init_prototypes(void) {
@@ -292,6 +293,8 @@ void health_init_prototypes(void) {
     dictionary_register_conflict_callback(health_globals.prototypes.dict, health_prototype_conflict_cb, NULL);
     dictionary_register_delete_callback(health_globals.prototypes.dict, health_prototype_delete_cb, NULL);
 
+    rw_spinlock_init(&health_globals.prototypes.index.spinlock);
+
     alert_action_options_init();
 }
 
@@ -474,15 +477,16 @@ bool health_prototype_add(RRD_ALERT_PROTOTYPE *ap, char **msg) {
                             ap, sizeof(*ap),
                             NULL);
 
+    __atomic_add_fetch(&health_globals.prototypes.version, 1, __ATOMIC_RELAXED);
+
     return true;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 
-void health_reload_prototypes(void) {
-    // remove all dyncfg related to prototypes
-    health_dyncfg_unregister_all_prototypes();
-
+// parsing the prototypes does not need localhost,
+// so it can run in parallel with the initialization of the databases
+void health_load_prototypes(void) {
     // clear old prototypes from memory
     dictionary_flush(health_globals.prototypes.dict);
 
@@ -493,6 +497,13 @@ void health_reload_prototypes(void) {
         NULL,
         health_readfile,
         NULL, 0);
+}
+
+void health_reload_prototypes(void) {
+    // remove all dyncfg related to prototypes
+    health_dyncfg_unregister_all_prototypes();
+
+    health_load_prototypes();
 
     // register all loaded prototypes
     health_dyncfg_register_all_prototypes();
@@ -623,12 +634,125 @@ static void health_prototype_apply_to_rrdset(RRDSET *st, RRD_ALERT_PROTOTYPE *ap
     spinlock_unlock(&ap->_internal.spinlock);
 }
 
-void health_prototype_alerts_for_rrdset_incrementally(RRDSET *st) {
+// ---------------------------------------------------------------------------------------------------------------------
+// prototypes index
+//
+// A new chart can only match the templates of its context and the alarms of its id or name,
+// so instead of checking it against all the prototypes, we index the names of the prototypes
+// by these keys. The index is rebuilt lazily, when the prototypes have changed.
+// The index may return more prototypes than the ones matching (e.g. a context and a chart id
+// may be the same string), so health_prototype_apply_to_rrdset() still does the full check.
+
+struct prototypes_index_entry {
+    uint32_t used;
+    uint32_t size;
+    STRING **names;
+};
+
+static void prototypes_index_entry_delete_cb(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused) {
+    struct prototypes_index_entry *pie = value;
+
+    for(uint32_t i = 0; i < pie->used ; i++)
+        string_freez(pie->names[i]);
+
+    freez(pie->names);
+}
+
+static void prototypes_index_add(DICTIONARY *dict, STRING *key, STRING *name) {
+    if(!key) return;
+
+    struct prototypes_index_entry *pie = dictionary_get(dict, string2str(key));
+    if(!pie) {
+        struct prototypes_index_entry tmp = { 0 };
+        pie = dictionary_set(dict, string2str(key), &tmp, sizeof(tmp));
+    }
+
+    for(uint32_t i = 0; i < pie->used ; i++)
+        if(pie->names[i] == name)
+            return;
+
+    if(pie->used == pie->size) {
+        pie->size = pie->size ? pie->size * 2 : 2;
+        pie->names = reallocz(pie->names, pie->size * sizeof(*pie->names));
+    }
+
+    pie->names[pie->used++] = string_dup(name);
+}
+
+static void prototypes_index_check(void) {
+    size_t version = __atomic_load_n(&health_globals.prototypes.version, __ATOMIC_RELAXED);
+
+    rw_spinlock_read_lock(&health_globals.prototypes.index.spinlock);
+    bool ok = health_globals.prototypes.index.dict && health_globals.prototypes.index.version == version;
+    rw_spinlock_read_unlock(&health_globals.prototypes.index.spinlock);
+
+    if(ok)
+        return;
+
+    DICTIONARY *dict = dictionary_create(DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE);
+    dictionary_register_delete_callback(dict, prototypes_index_entry_delete_cb, NULL);
+
     RRD_ALERT_PROTOTYPE *ap;
     dfe_start_read(health_globals.prototypes.dict, ap) {
-        health_prototype_apply_to_rrdset(st, ap);
+        spinlock_lock(&ap->_internal.spinlock);
+        for(RRD_ALERT_PROTOTYPE *t = ap; t ; t = t->_internal.next) {
+            if(t->match.is_template)
+                prototypes_index_add(dict, t->match.on.context, ap->config.name);
+            else
+                prototypes_index_add(dict, t->match.on.chart, ap->config.name);
+        }
+        spinlock_unlock(&ap->_internal.spinlock);
     }
     dfe_done(ap);
+
+    rw_spinlock_write_lock(&health_globals.prototypes.index.spinlock);
+    SWAP(dict, health_globals.prototypes.index.dict);
+    health_globals.prototypes.index.version = version;
+    rw_spinlock_write_unlock(&health_globals.prototypes.index.spinlock);
+
+    dictionary_destroy(dict);
+}
+
+static void prototypes_index_apply(RRDSET *st, STRING *key, STRING **applied, size_t *applied_used, size_t applied_size) {
+    if(!key) return;
+
+    struct prototypes_index_entry *pie = dictionary_get(health_globals.prototypes.index.dict, string2str(key));
+    if(!pie) return;
+
+    for(uint32_t i = 0; i < pie->used ; i++) {
+        STRING *name = pie->names[i];
+
+        // a prototype may be indexed under more than one of the keys of the chart
+        bool done = false;
+        for(size_t j = 0; j < *applied_used && !done ; j++)
+            done = applied[j] == name;
+
+        if(done)
+            continue;
+
+        if(*applied_used < applied_size)
+            applied[(*applied_used)++] = name;
+
+        const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(health_globals.prototypes.dict, string2str(name));
+        if(item) {
+            health_prototype_apply_to_rrdset(st, dictionary_acquired_item_value(item));
+            dictionary_acquired_item_release(health_globals.prototypes.dict, item);
+        }
+    }
+}
+
+void health_prototype_alerts_for_rrdset_incrementally(RRDSET *st) {
+    prototypes_index_check();
+
+    STRING *applied[128];
+    size_t applied_used = 0;
+
+    rw_spinlock_read_lock(&health_globals.prototypes.index.spinlock);
+    prototypes_index_apply(st, st->context, applied, &applied_used, sizeof(applied) / sizeof(applied[0]));
+    prototypes_index_apply(st, st->id, applied, &applied_used, sizeof(applied) / sizeof(applied[0]));
+    if(st->name != st->id)
+        prototypes_index_apply(st, st->name, applied, &applied_used, sizeof(applied) / sizeof(applied[0]));
+    rw_spinlock_read_unlock(&health_globals.prototypes.index.spinlock);
 }
 
 void health_prototype_reset_alerts_for_rrdset(RRDSET *st) {
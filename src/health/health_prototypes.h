@@ -123,6 +123,7 @@ void health_init_prototypes(void);
 bool health_plugin_enabled(void);
 void health_plugin_disable(void);
 
+void health_load_prototypes(void);
 void health_reload_prototypes(void);
 void health_apply_prototypes_to_host(RRDHOST *host);
 void health_apply_prototypes_to_all_hosts(void);
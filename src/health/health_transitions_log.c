@@ -0,0 +1,647 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "health_internals.h"
+
+// ----------------------------------------------------------------------------
+// alert transitions log
+//
+// An optional, append-only store of the alert transitions, to serve
+// /api/v2/alert_transitions without querying sqlite.
+//
+// The log is split in time partitions, one file each. A file is a sequence of
+// 8-byte aligned records: a fixed size header, followed by the NUL terminated
+// strings of the transition. Files are never updated in place, so queries
+// mmap() them and retention deletes whole partitions.
+//
+// Every partition keeps in memory a compact index of its records (time,
+// offset and the hashes of the host, the alert name, the context and the
+// transition id), so that queries touch only the records that match.
+
+#define HTL_RECORD_MAGIC            0x4C544801      // "\1HTL"
+#define HTL_PARTITION_DURATION_UT   (3600 * USEC_PER_SEC)
+#define HTL_PARTITION_MAX_SIZE      (256 * 1024 * 1024)
+#define HTL_FILENAME_PREFIX         "transitions-"
+#define HTL_FILENAME_SUFFIX         ".log"
+
+typedef enum {
+    HTL_STR_NAME = 0,
+    HTL_STR_CHART,
+    HTL_STR_CHART_NAME,
+    HTL_STR_CHART_CONTEXT,
+    HTL_STR_RECIPIENT,
+    HTL_STR_UNITS,
+    HTL_STR_EXEC,
+    HTL_STR_INFO,
+    HTL_STR_SUMMARY,
+    HTL_STR_CLASSIFICATION,
+    HTL_STR_TYPE,
+    HTL_STR_COMPONENT,
+
+    // terminator
+    HTL_STR_MAX,
+} HTL_STRING;
+
+struct htl_record {
+    uint32_t magic;
+    uint32_t size;                          // the size of the record, including its strings and padding
+
+    usec_t global_id;
+    nd_uuid_t host_id;
+    nd_uuid_t transition_id;
+    nd_uuid_t config_hash_id;
+
+    int64_t when_key;
+    int64_t duration;
+    int64_t non_clear_duration;
+    int64_t delay_up_to_timestamp;
+    int64_t exec_run_timestamp;
+    int64_t last_repeat;
+
+    double new_value;
+    double old_value;
+
+    uint32_t alarm_id;
+    uint32_t flags;
+    int32_t exec_code;
+    int32_t new_status;
+    int32_t old_status;
+    int32_t delay;
+
+    uint16_t strings_len[HTL_STR_MAX];      // the lengths of the strings following, without their terminators
+};
+
+struct htl_index_entry {
+    usec_t global_id;
+    uint64_t host_hash;
+    uint64_t name_hash;
+    uint64_t context_hash;
+    uint64_t transition_hash;
+    uint32_t offset;
+    bool raised;                            // the old or the new status is above RAISED
+};
+
+typedef struct htl_partition {
+    char filename[FILENAME_MAX + 1];
+    int fd;                                 // the file descriptor we append to, -1 when read-only
+
+    usec_t first_ut;
+    usec_t last_ut;
+    size_t size;
+
+    size_t entries;
+    size_t size_entries;
+    struct htl_index_entry *index;
+
+    struct htl_partition *prev, *next;
+} HTL_PARTITION;
+
+static struct {
+    bool enabled;
+    char path[FILENAME_MAX + 1];
+
+    netdata_rwlock_t rwlock;
+    HTL_PARTITION *partitions;              // ordered by time, the last one is the one we append to
+} htl = {
+    .enabled = false,
+    .partitions = NULL,
+};
+
+static inline uint64_t htl_hash(const void *s, size_t len) {
+    return XXH3_64bits(s, len);
+}
+
+// ----------------------------------------------------------------------------
+// records
+
+static inline size_t htl_record_size(const uint16_t strings_len[HTL_STR_MAX]) {
+    size_t size = sizeof(struct htl_record);
+    for(size_t i = 0; i < HTL_STR_MAX; i++)
+        size += strings_len[i] + 1;
+
+    return (size + 7) & ~((size_t)7);
+}
+
+// returns false when the record is corrupted
+static bool htl_record_strings(const struct htl_record *rec, const char *strings[HTL_STR_MAX]) {
+    const char *s = (const char *)rec + sizeof(*rec);
+    const char *end = (const char *)rec + rec->size;
+
+    for(size_t i = 0; i < HTL_STR_MAX; i++) {
+        if(s + rec->strings_len[i] >= end || s[rec->strings_len[i]] != '\0')
+            return false;
+
+        strings[i] = s;
+        s += rec->strings_len[i] + 1;
+    }
+
+    return true;
+}
+
+static void htl_partition_index_record(HTL_PARTITION *p, const struct htl_record *rec, const char *strings[HTL_STR_MAX], size_t offset) {
+    if(p->entries == p->size_entries) {
+        p->size_entries = p->size_entries ? p->size_entries * 2 : 1024;
+        p->index = reallocz(p->index, p->size_entries * sizeof(*p->index));
+    }
+
+    struct htl_index_entry *e = &p->index[p->entries++];
+    e->global_id = rec->global_id;
+    e->host_hash = htl_hash(&rec->host_id, sizeof(rec->host_id));
+    e->name_hash = htl_hash(strings[HTL_STR_NAME], rec->strings_len[HTL_STR_NAME]);
+    e->context_hash = htl_hash(strings[HTL_STR_CHART_CONTEXT], rec->strings_len[HTL_STR_CHART_CONTEXT]);
+    e->transition_hash = htl_hash(&rec->transition_id, sizeof(rec->transition_id));
+    e->offset = (uint32_t)offset;
+    e->raised = rec->new_status > RRDCALC_STATUS_RAISED || rec->old_status > RRDCALC_STATUS_RAISED;
+
+    if(!p->first_ut || rec->global_id < p->first_ut)
+        p->first_ut = rec->global_id;
+
+    if(rec->global_id > p->last_ut)
+        p->last_ut = rec->global_id;
+}
+
+// ----------------------------------------------------------------------------
+// partitions
+
+static void htl_partition_free(HTL_PARTITION *p) {
+    if(p->fd != -1)
+        close(p->fd);
+
+    freez(p->index);
+    freez(p);
+}
+
+static HTL_PARTITION *htl_partition_create(usec_t now_ut) {
+    HTL_PARTITION *p = callocz(1, sizeof(*p));
+    snprintfz(p->filename, FILENAME_MAX, "%s/" HTL_FILENAME_PREFIX "%"PRIu64 HTL_FILENAME_SUFFIX, htl.path, (uint64_t)now_ut);
+
+    p->fd = open(p->filename, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0664);
+    if(p->fd == -1) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "HEALTH: cannot create alert transitions log file '%s'", p->filename);
+        freez(p);
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(p->fd, &st) == 0)
+        p->size = st.st_size;
+
+    return p;
+}
+
+// index the records of an existing partition file
+static HTL_PARTITION *htl_partition_load(const char *filename) {
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return NULL;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(struct htl_record)) {
+        close(fd);
+        unlink(filename);
+        return NULL;
+    }
+
+    size_t file_size = st.st_size;
+    void *map = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED)
+        return NULL;
+
+    HTL_PARTITION *p = callocz(1, sizeof(*p));
+    strncpyz(p->filename, filename, FILENAME_MAX);
+    p->fd = -1;
+
+    size_t offset = 0;
+    while(offset + sizeof(struct htl_record) <= file_size) {
+        const struct htl_record *rec = (const struct htl_record *)((const char *)map + offset);
+        const char *strings[HTL_STR_MAX];
+
+        if(rec->magic != HTL_RECORD_MAGIC || rec->size < sizeof(*rec) || (rec->size & 7) ||
+           offset + rec->size > file_size || !htl_record_strings(rec, strings))
+            break;
+
+        htl_partition_index_record(p, rec, strings, offset);
+        offset += rec->size;
+    }
+    munmap(map, file_size);
+
+    p->size = offset;
+
+    if(offset < file_size) {
+        // the tail of the file was not written completely, probably because we crashed
+        nd_log(NDLS_DAEMON, NDLP_WARNING,
+               "HEALTH: alert transitions log file '%s' has %zu invalid bytes at its end, truncating it",
+               filename, file_size - offset);
+
+        if(truncate(filename, (off_t)offset) != 0)
+            nd_log(NDLS_DAEMON, NDLP_ERR, "HEALTH: cannot truncate alert transitions log file '%s'", filename);
+    }
+
+    if(!p->entries) {
+        unlink(filename);
+        htl_partition_free(p);
+        return NULL;
+    }
+
+    return p;
+}
+
+static void htl_partition_insert_ordered(HTL_PARTITION *p) {
+    HTL_PARTITION *t;
+    for(t = htl.partitions; t ; t = t->next) {
+        if(t->first_ut > p->first_ut)
+            break;
+    }
+
+    if(!t)
+        DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(htl.partitions, p, prev, next);
+    else if(t == htl.partitions)
+        DOUBLE_LINKED_LIST_PREPEND_ITEM_UNSAFE(htl.partitions, p, prev, next);
+    else {
+        p->prev = t->prev;
+        p->next = t;
+        t->prev->next = p;
+        t->prev = p;
+    }
+}
+
+// delete the partitions that are completely out of the health log retention
+// must be called with the write lock
+static void htl_retention_cleanup(usec_t now_ut) {
+    usec_t retention_ut = (usec_t)health_globals.config.health_log_retention_s * USEC_PER_SEC;
+    if(now_ut <= retention_ut)
+        return;
+
+    HTL_PARTITION *last = htl.partitions ? htl.partitions->prev : NULL;
+
+    HTL_PARTITION *p = htl.partitions;
+    while(p && p != last && p->last_ut < now_ut - retention_ut) {
+        HTL_PARTITION *next = p->next;
+
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(htl.partitions, p, prev, next);
+        unlink(p->filename);
+        htl_partition_free(p);
+
+        p = next;
+    }
+}
+
+// the partition to append to, rotating it when it is too old or too big
+// must be called with the write lock
+static HTL_PARTITION *htl_partition_for_append(usec_t now_ut, size_t record_size) {
+    HTL_PARTITION *p = htl.partitions ? htl.partitions->prev : NULL;
+
+    if(p && p->fd != -1 && p->size + record_size <= HTL_PARTITION_MAX_SIZE &&
+       (!p->entries || now_ut < p->first_ut + HTL_PARTITION_DURATION_UT))
+        return p;
+
+    if(p && p->fd != -1) {
+        close(p->fd);
+        p->fd = -1;
+    }
+
+    p = htl_partition_create(now_ut);
+    if(!p)
+        return NULL;
+
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(htl.partitions, p, prev, next);
+    htl_retention_cleanup(now_ut);
+
+    return p;
+}
+
+// ----------------------------------------------------------------------------
+// appending transitions
+
+static inline uint16_t htl_string_len(const char *s) {
+    size_t len = strlen(s);
+    return (uint16_t)(len > UINT16_MAX ? UINT16_MAX : len);
+}
+
+void health_transitions_log_append(RRDHOST *host, ALARM_ENTRY *ae) {
+    if(!htl.enabled)
+        return;
+
+    const char *strings[HTL_STR_MAX] = {
+        [HTL_STR_NAME] = ae_name(ae),
+        [HTL_STR_CHART] = ae_chart_id(ae),
+        [HTL_STR_CHART_NAME] = ae_chart_name(ae),
+        [HTL_STR_CHART_CONTEXT] = ae_chart_context(ae),
+        [HTL_STR_RECIPIENT] = ae_recipient(ae),
+        [HTL_STR_UNITS] = ae_units(ae),
+        [HTL_STR_EXEC] = ae_exec(ae),
+        [HTL_STR_INFO] = ae_info(ae),
+        [HTL_STR_SUMMARY] = ae_summary(ae),
+        [HTL_STR_CLASSIFICATION] = ae_classification(ae),
+        [HTL_STR_TYPE] = string2str(ae->type),
+        [HTL_STR_COMPONENT] = string2str(ae->component),
+    };
+
+    struct htl_record rec = {
+        .magic = HTL_RECORD_MAGIC,
+        .global_id = ae->global_id,
+        .when_key = ae->when,
+        .duration = ae->duration,
+        .non_clear_duration = ae->non_clear_duration,
+        .delay_up_to_timestamp = ae->delay_up_to_timestamp,
+        .exec_run_timestamp = ae->exec_run_timestamp,
+        .last_repeat = ae->last_repeat,
+        .new_value = (double)ae->new_value,
+        .old_value = (double)ae->old_value,
+        .alarm_id = ae->alarm_id,
+        .flags = ae->flags,
+        .exec_code = ae->exec_code,
+        .new_status = ae->new_status,
+        .old_status = ae->old_status,
+        .delay = ae->delay,
+    };
+    uuid_copy(rec.host_id, host->host_id.uuid);
+    uuid_copy(rec.transition_id, ae->transition_id);
+    uuid_copy(rec.config_hash_id, ae->config_hash_id);
+
+    for(size_t i = 0; i < HTL_STR_MAX; i++)
+        rec.strings_len[i] = htl_string_len(strings[i]);
+
+    rec.size = htl_record_size(rec.strings_len);
+
+    CLEAN_BUFFER *wb = buffer_create(rec.size, NULL);
+    buffer_need_bytes(wb, rec.size);
+    memset(wb->buffer, 0, rec.size);
+    memcpy(wb->buffer, &rec, sizeof(rec));
+
+    char *s = &wb->buffer[sizeof(rec)];
+    for(size_t i = 0; i < HTL_STR_MAX; i++) {
+        memcpy(s, strings[i], rec.strings_len[i]);
+        s += rec.strings_len[i] + 1;
+    }
+
+    netdata_rwlock_wrlock(&htl.rwlock);
+
+    HTL_PARTITION *p = htl.enabled ? htl_partition_for_append(now_realtime_usec(), rec.size) : NULL;
+    if(p) {
+        ssize_t written = write(p->fd, wb->buffer, rec.size);
+        if(written == (ssize_t)rec.size) {
+            const char *indexed[HTL_STR_MAX];
+            const struct htl_record *r = (const struct htl_record *)wb->buffer;
+            if(htl_record_strings(r, indexed))
+                htl_partition_index_record(p, r, indexed, p->size);
+
+            p->size += rec.size;
+        }
+        else {
+            nd_log_limit_static_global_var(erl, 60, 0);
+            nd_log_limit(&erl, NDLS_DAEMON, NDLP_ERR,
+                         "HEALTH: cannot append to alert transitions log file '%s'", p->filename);
+
+            // the next append will start a new partition
+            if(written > 0) {
+                close(p->fd);
+                p->fd = -1;
+            }
+        }
+    }
+
+    netdata_rwlock_wrunlock(&htl.rwlock);
+}
+
+// ----------------------------------------------------------------------------
+// querying transitions
+
+static void htl_record_to_transition(const struct htl_record *rec, const char *strings[HTL_STR_MAX], struct sql_alert_transition_data *atd) {
+    atd->host_id = (nd_uuid_t *)&rec->host_id;
+    atd->alarm_id = rec->alarm_id;
+    atd->config_hash_id = (nd_uuid_t *)&rec->config_hash_id;
+    atd->alert_name = strings[HTL_STR_NAME];
+    atd->chart = strings[HTL_STR_CHART];
+    atd->chart_name = strings[HTL_STR_CHART_NAME];
+    atd->family = NULL;
+    atd->recipient = strings[HTL_STR_RECIPIENT];
+    atd->units = strings[HTL_STR_UNITS];
+    atd->exec = strings[HTL_STR_EXEC];
+    atd->chart_context = strings[HTL_STR_CHART_CONTEXT];
+    atd->when_key = (time_t)rec->when_key;
+    atd->duration = (time_t)rec->duration;
+    atd->non_clear_duration = (time_t)rec->non_clear_duration;
+    atd->flags = rec->flags;
+    atd->delay_up_to_timestamp = (time_t)rec->delay_up_to_timestamp;
+    atd->info = strings[HTL_STR_INFO];
+    atd->exec_code = rec->exec_code;
+    atd->new_status = rec->new_status;
+    atd->old_status = rec->old_status;
+    atd->delay = rec->delay;
+    atd->new_value = (NETDATA_DOUBLE)rec->new_value;
+    atd->old_value = (NETDATA_DOUBLE)rec->old_value;
+    atd->last_repeat = (time_t)rec->last_repeat;
+    atd->transition_id = (nd_uuid_t *)&rec->transition_id;
+    atd->global_id = rec->global_id;
+    atd->classification = strings[HTL_STR_CLASSIFICATION];
+    atd->type = strings[HTL_STR_TYPE];
+    atd->component = strings[HTL_STR_COMPONENT];
+    atd->exec_run_timestamp = (time_t)rec->exec_run_timestamp;
+    atd->summary = strings[HTL_STR_SUMMARY];
+}
+
+bool health_transitions_log_query(
+    DICTIONARY *nodes,
+    time_t after,
+    time_t before,
+    const char *context,
+    const char *alert_name,
+    const char *transition,
+    void (*cb)(struct sql_alert_transition_data *, void *),
+    void *data)
+{
+    if(!htl.enabled)
+        return false;
+
+    if(unlikely(!nodes))
+        return true;
+
+    nd_uuid_t transition_uuid;
+    uint64_t transition_hash = 0;
+    if(transition) {
+        if(uuid_parse(transition, transition_uuid)) {
+            nd_log(NDLS_DAEMON, NDLP_ERR, "HEALTH: invalid transition given %s", transition);
+            return true;
+        }
+        transition_hash = htl_hash(&transition_uuid, sizeof(transition_uuid));
+    }
+
+    // the hosts to query, by the hash of their uuid
+    size_t hosts_count = 0;
+    nd_uuid_t *hosts = mallocz(MAX(dictionary_entries(nodes), 1) * sizeof(nd_uuid_t));
+    Pvoid_t hosts_JudyL = NULL;
+
+    void *t;
+    dfe_start_read(nodes, t) {
+        if(hosts_count >= dictionary_entries(nodes) || uuid_parse(t_dfe.name, hosts[hosts_count]))
+            continue;
+
+        Pvoid_t *PValue = JudyLIns(&hosts_JudyL, (Word_t)htl_hash(&hosts[hosts_count], sizeof(nd_uuid_t)), PJE0);
+        if(PValue && !*PValue)
+            *PValue = &hosts[hosts_count];
+
+        hosts_count++;
+    }
+    dfe_done(t);
+
+    uint64_t context_hash = context ? htl_hash(context, strlen(context)) : 0;
+    uint64_t name_hash = alert_name ? htl_hash(alert_name, strlen(alert_name)) : 0;
+    usec_t after_ut = (usec_t)after * USEC_PER_SEC;
+    usec_t before_ut = (usec_t)before * USEC_PER_SEC;
+
+    struct sql_alert_transition_data atd = { 0 };
+    bool found = false;
+
+    netdata_rwlock_rdlock(&htl.rwlock);
+
+    // the newest partitions first
+    for(HTL_PARTITION *p = htl.partitions ? htl.partitions->prev : NULL; p && !found ; p = (p == htl.partitions) ? NULL : p->prev) {
+        if(!p->entries || !p->size)
+            continue;
+
+        if(!transition && (p->last_ut < after_ut || p->first_ut > before_ut))
+            continue;
+
+        int fd = open(p->filename, O_RDONLY | O_CLOEXEC);
+        if(fd == -1)
+            continue;
+
+        void *map = mmap(NULL, p->size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if(map == MAP_FAILED)
+            continue;
+
+        for(size_t i = p->entries; i > 0 ; i--) {
+            struct htl_index_entry *e = &p->index[i - 1];
+
+            if(transition) {
+                if(e->transition_hash != transition_hash)
+                    continue;
+            }
+            else {
+                if(!e->raised || e->global_id < after_ut || e->global_id > before_ut)
+                    continue;
+
+                if(context && e->context_hash != context_hash)
+                    continue;
+
+                if(alert_name && e->name_hash != name_hash)
+                    continue;
+            }
+
+            const struct htl_record *rec = (const struct htl_record *)((const char *)map + e->offset);
+            const char *strings[HTL_STR_MAX];
+            if(!htl_record_strings(rec, strings))
+                continue;
+
+            if(transition) {
+                if(uuid_compare(rec->transition_id, transition_uuid) != 0)
+                    continue;
+
+                found = true;
+            }
+            else {
+                Pvoid_t *PValue = JudyLGet(hosts_JudyL, (Word_t)e->host_hash, PJE0);
+                if(!PValue || uuid_compare(*(nd_uuid_t *)*PValue, rec->host_id) != 0)
+                    continue;
+
+                if(context && strcmp(strings[HTL_STR_CHART_CONTEXT], context) != 0)
+                    continue;
+
+                if(alert_name && strcmp(strings[HTL_STR_NAME], alert_name) != 0)
+                    continue;
+            }
+
+            htl_record_to_transition(rec, strings, &atd);
+            cb(&atd, data);
+
+            if(found)
+                break;
+        }
+
+        munmap(map, p->size);
+    }
+
+    netdata_rwlock_rdunlock(&htl.rwlock);
+
+    JudyLFreeArray(&hosts_JudyL, PJE0);
+    freez(hosts);
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// initialization
+
+void health_transitions_log_init(void) {
+    htl.enabled = config_get_boolean(CONFIG_SECTION_HEALTH, "alert transitions log", htl.enabled);
+    if(!htl.enabled)
+        return;
+
+    netdata_rwlock_init(&htl.rwlock);
+
+    snprintfz(htl.path, FILENAME_MAX, "%s/alert-transitions", netdata_configured_cache_dir);
+    if(mkdir(htl.path, 0775) == -1 && errno != EEXIST) {
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "HEALTH: cannot create directory '%s', the alert transitions log is disabled", htl.path);
+        htl.enabled = false;
+        return;
+    }
+
+    DIR *dir = opendir(htl.path);
+    if(dir) {
+        struct dirent *de;
+        size_t prefix_len = strlen(HTL_FILENAME_PREFIX);
+        size_t suffix_len = strlen(HTL_FILENAME_SUFFIX);
+
+        while((de = readdir(dir))) {
+            size_t len = strlen(de->d_name);
+            if(len <= prefix_len + suffix_len ||
+               strncmp(de->d_name, HTL_FILENAME_PREFIX, prefix_len) != 0 ||
+               strcmp(&de->d_name[len - suffix_len], HTL_FILENAME_SUFFIX) != 0)
+                continue;
+
+            char filename[FILENAME_MAX + 1];
+            snprintfz(filename, FILENAME_MAX, "%s/%s", htl.path, de->d_name);
+
+            HTL_PARTITION *p = htl_partition_load(filename);
+            if(p)
+                htl_partition_insert_ordered(p);
+        }
+
+        closedir(dir);
+    }
+
+    netdata_rwlock_wrlock(&htl.rwlock);
+    htl_retention_cleanup(now_realtime_usec());
+    netdata_rwlock_wrunlock(&htl.rwlock);
+
+    size_t partitions = 0, entries = 0;
+    for(HTL_PARTITION *p = htl.partitions; p ; p = p->next) {
+        partitions++;
+        entries += p->entries;
+    }
+
+    nd_log(NDLS_DAEMON, NDLP_INFO,
+           "HEALTH: alert transitions log loaded %zu transitions from %zu partitions in '%s'",
+           entries, partitions, htl.path);
+}
+
+void health_transitions_log_destroy(void) {
+    if(!htl.enabled)
+        return;
+
+    netdata_rwlock_wrlock(&htl.rwlock);
+    htl.enabled = false;
+
+    while(htl.partitions) {
+        HTL_PARTITION *p = htl.partitions;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(htl.partitions, p, prev, next);
+        htl_partition_free(p);
+    }
+
+    netdata_rwlock_wrunlock(&htl.rwlock);
+}
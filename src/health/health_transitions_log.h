@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_HEALTH_TRANSITIONS_LOG_H
+#define NETDATA_HEALTH_TRANSITIONS_LOG_H
+
+#include "health.h"
+
+struct sql_alert_transition_data;
+
+void health_transitions_log_init(void);
+void health_transitions_log_destroy(void);
+
+void health_transitions_log_append(RRDHOST *host, ALARM_ENTRY *ae);
+
+// returns false when the log is not enabled, so that the caller can query sqlite
+bool health_transitions_log_query(
+    DICTIONARY *nodes,
+    time_t after,
+    time_t before,
+    const char *context,
+    const char *alert_name,
+    const char *transition,
+    void (*cb)(struct sql_alert_transition_data *, void *),
+    void *data);
+
+#endif //NETDATA_HEALTH_TRANSITIONS_LOG_H
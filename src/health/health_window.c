@@ -0,0 +1,425 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "health_internals.h"
+
+// ----------------------------------------------------------------------------
+// incremental lookups
+//
+// Alerts evaluate their lookup every few seconds, but the lookup window moves
+// only by the time passed since the previous evaluation. So, for the lookups
+// that can be calculated incrementally (average, sum, min and max of the tier 0
+// points of a chart, ending now), we keep the points of the window aggregated
+// in chunks, read only the points stored since the previous evaluation, and
+// drop the chunks that leave the window.
+//
+// The window is split in up to HEALTH_WINDOW_CHUNKS chunks, aligned to
+// multiples of their duration. When a chunk is one point, the window is exact.
+// Otherwise, the oldest chunk is kept while any part of it is in the window,
+// so the window may include up to one chunk of older points.
+
+#define HEALTH_WINDOW_CHUNKS 60
+
+struct health_window_chunk {
+    time_t id;                          // the chunk covers ((id - 1) * duration, id * duration]
+    NETDATA_DOUBLE sum;
+    NETDATA_DOUBLE min;
+    NETDATA_DOUBLE max;
+    uint32_t count;
+};
+
+// a monotonic deque of chunks, with the min or the max of the window at its head
+struct health_window_deque_entry {
+    time_t id;
+    NETDATA_DOUBLE value;
+};
+
+struct health_window_deque {
+    uint32_t head;
+    uint32_t len;
+    struct health_window_deque_entry *entries;
+};
+
+struct health_window_dimension {
+    RRDDIM *rd;                         // only compared, never dereferenced
+    time_t last_point_s;                // the end time of the last point added
+
+    NETDATA_DOUBLE sum;                 // the running sum and count of the chunks in the ring
+    uint64_t count;
+    uint32_t expired;                   // chunks expired since the sum was last calculated from scratch
+
+    uint32_t head;                      // the position of the oldest chunk in the ring
+    uint32_t len;
+    struct health_window_chunk *chunks;
+
+    struct health_window_deque min;
+    struct health_window_deque max;
+};
+
+struct health_window {
+    RRDSET *st;                         // only compared, never dereferenced
+    size_t dimensions_version;
+    time_t duration;                    // the duration of each chunk
+    uint32_t slots;                     // the size of the rings
+
+    uint32_t used;
+    uint32_t size;
+    struct health_window_dimension *dims;
+};
+
+static void health_window_dimension_cleanup(struct health_window_dimension *d) {
+    freez(d->chunks);
+    freez(d->min.entries);
+    freez(d->max.entries);
+}
+
+static void health_window_reset(struct health_window *w) {
+    for(uint32_t i = 0; i < w->used ; i++)
+        health_window_dimension_cleanup(&w->dims[i]);
+
+    w->used = 0;
+}
+
+void health_window_free(RRDCALC *rc) {
+    struct health_window *w = rc->window;
+    if(!w) return;
+
+    health_window_reset(w);
+    freez(w->dims);
+    freez(w);
+    rc->window = NULL;
+}
+
+// ----------------------------------------------------------------------------
+// the chunks of a dimension
+
+static inline struct health_window_chunk *hwd_chunk(struct health_window *w, struct health_window_dimension *d, uint32_t pos) {
+    return &d->chunks[(d->head + pos) % w->slots];
+}
+
+static inline struct health_window_deque_entry *hwdq_entry(struct health_window *w, struct health_window_deque *q, uint32_t pos) {
+    return &q->entries[(q->head + pos) % w->slots];
+}
+
+// the value of the newest chunk has just been set, keep the deque monotonic
+static void hwdq_update(struct health_window *w, struct health_window_deque *q, time_t id, NETDATA_DOUBLE value, bool min) {
+    while(q->len) {
+        struct health_window_deque_entry *b = hwdq_entry(w, q, q->len - 1);
+        if(b->id != id && (min ? b->value < value : b->value > value))
+            break;
+
+        q->len--;
+    }
+
+    *hwdq_entry(w, q, q->len++) = (struct health_window_deque_entry){
+        .id = id,
+        .value = value,
+    };
+}
+
+static void hwdq_expire(struct health_window *w, struct health_window_deque *q, time_t oldest_id) {
+    while(q->len && hwdq_entry(w, q, 0)->id < oldest_id) {
+        q->head = (q->head + 1) % w->slots;
+        q->len--;
+    }
+}
+
+static inline void hwd_expire_oldest_chunk(struct health_window *w, struct health_window_dimension *d) {
+    struct health_window_chunk *c = hwd_chunk(w, d, 0);
+    d->sum -= c->sum;
+    d->count -= c->count;
+    d->head = (d->head + 1) % w->slots;
+    d->len--;
+    d->expired++;
+}
+
+static void hwd_add_point(struct health_window *w, struct health_window_dimension *d, time_t end_time_s, NETDATA_DOUBLE value) {
+    time_t id = (end_time_s + w->duration - 1) / w->duration;
+
+    struct health_window_chunk *c = NULL;
+    if(d->len) {
+        c = hwd_chunk(w, d, d->len - 1);
+        if(c->id != id)
+            c = NULL;
+    }
+
+    if(!c) {
+        // a new chunk - the window is expired before adding points, so there is always space for it
+        if(unlikely(d->len == w->slots)) {
+            hwd_expire_oldest_chunk(w, d);
+            hwdq_expire(w, &d->min, hwd_chunk(w, d, 0)->id);
+            hwdq_expire(w, &d->max, hwd_chunk(w, d, 0)->id);
+        }
+
+        c = hwd_chunk(w, d, d->len++);
+        *c = (struct health_window_chunk){
+            .id = id,
+            .sum = 0.0,
+            .min = value,
+            .max = value,
+            .count = 0,
+        };
+    }
+
+    c->sum += value;
+    c->count++;
+    d->sum += value;
+    d->count++;
+
+    if(c->count == 1 || value < c->min) {
+        c->min = value;
+        hwdq_update(w, &d->min, id, value, true);
+    }
+
+    if(c->count == 1 || value > c->max) {
+        c->max = value;
+        hwdq_update(w, &d->max, id, value, false);
+    }
+}
+
+static void hwd_expire(struct health_window *w, struct health_window_dimension *d, time_t oldest_id) {
+    while(d->len && hwd_chunk(w, d, 0)->id < oldest_id)
+        hwd_expire_oldest_chunk(w, d);
+
+    if(d->expired >= w->slots) {
+        // recalculate the sum from the chunks, to drop the rounding errors of the subtractions
+        d->sum = 0.0;
+        d->count = 0;
+        for(uint32_t i = 0; i < d->len ; i++) {
+            d->sum += hwd_chunk(w, d, i)->sum;
+            d->count += hwd_chunk(w, d, i)->count;
+        }
+        d->expired = 0;
+    }
+
+    hwdq_expire(w, &d->min, oldest_id);
+    hwdq_expire(w, &d->max, oldest_id);
+}
+
+static NETDATA_DOUBLE hwd_value(struct health_window *w, struct health_window_dimension *d, RRDR_TIME_GROUPING method) {
+    switch(method) {
+        case RRDR_GROUPING_SUM:
+            return d->sum;
+
+        case RRDR_GROUPING_MIN:
+            return hwdq_entry(w, &d->min, 0)->value;
+
+        case RRDR_GROUPING_MAX:
+            return hwdq_entry(w, &d->max, 0)->value;
+
+        default:
+        case RRDR_GROUPING_AVERAGE:
+            return d->sum / (NETDATA_DOUBLE)d->count;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// the lookup
+
+#define HEALTH_WINDOW_SUPPORTED_OPTIONS (RRDR_OPTION_ABSOLUTE | RRDR_OPTION_NULL2ZERO | RRDR_OPTION_NOT_ALIGNED | \
+    RRDR_OPTION_DIMS_MIN2MAX | RRDR_OPTION_DIMS_AVERAGE | RRDR_OPTION_DIMS_MIN | RRDR_OPTION_DIMS_MAX |         \
+    RRDR_OPTION_MATCH_IDS | RRDR_OPTION_MATCH_NAMES)
+
+static bool health_window_supported(RRDCALC *rc) {
+    if(!health_globals.config.incremental_lookups)
+        return false;
+
+    switch(rc->config.time_group) {
+        case RRDR_GROUPING_AVERAGE:
+        case RRDR_GROUPING_SUM:
+        case RRDR_GROUPING_MIN:
+        case RRDR_GROUPING_MAX:
+            break;
+
+        default:
+            return false;
+    }
+
+    return rc->config.before == 0 && rc->config.after < 0 &&
+           !(rc->config.options & ~HEALTH_WINDOW_SUPPORTED_OPTIONS) &&
+           rc->rrdset && rc->rrdset->update_every > 0;
+}
+
+static bool health_window_dimension_selected(RRDCALC *rc, RRDDIM *rd, SIMPLE_PATTERN *pattern) {
+    // like the query engine does
+    if(!pattern)
+        return !rrddim_option_check(rd, RRDDIM_OPTION_HIDDEN);
+
+    bool match_ids = rc->config.options & RRDR_OPTION_MATCH_IDS;
+    bool match_names = rc->config.options & RRDR_OPTION_MATCH_NAMES;
+    if(!match_ids && !match_names)
+        match_ids = match_names = true;
+
+    SIMPLE_PATTERN_RESULT ret = SP_NOT_MATCHED;
+
+    if(match_ids)
+        ret = simple_pattern_matches_string_extract(pattern, rd->id, NULL, 0);
+
+    if(ret == SP_NOT_MATCHED && match_names && (rd->name != rd->id || !match_ids))
+        ret = simple_pattern_matches_string_extract(pattern, rd->name, NULL, 0);
+
+    return ret == SP_MATCHED_POSITIVE;
+}
+
+static struct health_window_dimension *health_window_dimension_get(struct health_window *w, RRDDIM *rd, uint32_t *hint) {
+    // the dimensions are found in the same order every time
+    if(*hint < w->used && w->dims[*hint].rd == rd)
+        return &w->dims[(*hint)++];
+
+    for(uint32_t i = 0; i < w->used ; i++) {
+        if(w->dims[i].rd == rd) {
+            *hint = i + 1;
+            return &w->dims[i];
+        }
+    }
+
+    if(w->used == w->size) {
+        w->size = w->size ? w->size * 2 : 4;
+        w->dims = reallocz(w->dims, w->size * sizeof(*w->dims));
+    }
+
+    struct health_window_dimension *d = &w->dims[w->used++];
+    *d = (struct health_window_dimension){
+        .rd = rd,
+        .last_point_s = 0,
+        .chunks = callocz(w->slots, sizeof(struct health_window_chunk)),
+        .min.entries = callocz(w->slots, sizeof(struct health_window_deque_entry)),
+        .max.entries = callocz(w->slots, sizeof(struct health_window_deque_entry)),
+    };
+
+    *hint = w->used;
+    return d;
+}
+
+static void health_window_dimension_read(struct health_window *w, struct health_window_dimension *d, RRDDIM *rd, time_t after_s, time_t before_s, bool absolute) {
+    // skip the points that have been added, or are older than the window
+    if(d->last_point_s < after_s)
+        d->last_point_s = after_s;
+
+    if(d->last_point_s >= before_s || !rd->tiers[0].smh)
+        return;
+
+    struct storage_engine_query_handle handle;
+    storage_engine_query_init(rd->tiers[0].seb, rd->tiers[0].smh, &handle,
+                              d->last_point_s + 1, before_s, STORAGE_PRIORITY_SYNCHRONOUS);
+
+    while(!storage_engine_query_is_finished(&handle)) {
+        STORAGE_POINT sp = storage_engine_query_next_metric(&handle);
+
+        if(sp.end_time_s <= d->last_point_s || sp.end_time_s > before_s)
+            continue;
+
+        d->last_point_s = sp.end_time_s;
+
+        if(storage_point_is_gap(sp) || !sp.count)
+            continue;
+
+        NETDATA_DOUBLE value = sp.sum / (NETDATA_DOUBLE)sp.count;
+        if(absolute && value < 0)
+            value = -value;
+
+        hwd_add_point(w, d, sp.end_time_s, value);
+    }
+
+    storage_engine_query_finalize(&handle);
+}
+
+bool health_window_lookup(RRDCALC *rc, time_t now, int *value_is_null) {
+    if(!health_window_supported(rc)) {
+        health_window_free(rc);
+        return false;
+    }
+
+    RRDSET *st = rc->rrdset;
+    time_t window = -rc->config.after;
+    time_t update_every = st->update_every;
+
+    // the duration of the chunks, a multiple of the update every of the chart
+    time_t duration = (window / HEALTH_WINDOW_CHUNKS + update_every - 1) / update_every * update_every;
+    if(duration < update_every)
+        duration = update_every;
+
+    uint32_t slots = (uint32_t)(window / duration + 2);
+
+    struct health_window *w = rc->window;
+    if(!w)
+        w = rc->window = callocz(1, sizeof(*w));
+
+    size_t dimensions_version = dictionary_version(st->rrddim_root_index);
+    if(w->st != st || w->dimensions_version != dimensions_version || w->duration != duration || w->slots != slots) {
+        // the chart, its dimensions, or the window have changed - start over
+        health_window_reset(w);
+        w->st = st;
+        w->dimensions_version = dimensions_version;
+        w->duration = duration;
+        w->slots = slots;
+    }
+
+    // the oldest chunk with points in the window, and the time it starts
+    time_t window_start_s = now - window;
+    time_t oldest_id = (window_start_s + duration) / duration;
+    time_t oldest_chunk_start_s = (oldest_id - 1) * duration;
+    bool absolute = rc->config.options & RRDR_OPTION_ABSOLUTE;
+    SIMPLE_PATTERN *pattern = string_to_simple_pattern(rrdcalc_dimensions(rc));
+
+    NETDATA_DOUBLE sum = 0.0, min = NAN, max = NAN;
+    size_t dims = 0;
+    uint32_t hint = 0;
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st) {
+        if(!health_window_dimension_selected(rc, rd, pattern))
+            continue;
+
+        struct health_window_dimension *d = health_window_dimension_get(w, rd, &hint);
+        hwd_expire(w, d, oldest_id);
+        health_window_dimension_read(w, d, rd, oldest_chunk_start_s, now, absolute);
+
+        if(!d->count)
+            continue;
+
+        NETDATA_DOUBLE n = hwd_value(w, d, rc->config.time_group);
+
+        if(!dims)
+            min = max = n;
+
+        sum += n;
+        if(n < min) min = n;
+        if(n > max) max = n;
+        dims++;
+    }
+    rrddim_foreach_done(rd);
+
+    simple_pattern_free(pattern);
+
+    rc->db_after = window_start_s;
+    rc->db_before = now;
+    rc->run_flags &= ~RRDCALC_FLAG_DB_ERROR;
+
+    // combine the dimensions, like rrdr2value() does
+    RRDR_OPTIONS options = rc->config.options;
+    NETDATA_DOUBLE v;
+
+    if(!dims) {
+        *value_is_null = 1;
+        rc->value = (options & RRDR_OPTION_NULL2ZERO) ? 0 : NAN;
+        return true;
+    }
+
+    if(options & RRDR_OPTION_DIMS_MIN2MAX)
+        v = max - min;
+    else if(options & RRDR_OPTION_DIMS_AVERAGE)
+        v = sum / (NETDATA_DOUBLE)dims;
+    else if(options & RRDR_OPTION_DIMS_MIN)
+        v = min;
+    else if(options & RRDR_OPTION_DIMS_MAX)
+        v = max;
+    else
+        v = sum;
+
+    if((options & RRDR_OPTION_NULL2ZERO) && (isnan(v) || isinf(v)))
+        v = 0;
+
+    *value_is_null = 0;
+    rc->value = v;
+    return true;
+}
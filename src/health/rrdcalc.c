@@ -313,6 +313,9 @@ static void rrdcalc_rrdhost_insert_callback(const DICTIONARY_ITEM *item __maybe_
 
     rc->key = string_strdupz(dictionary_acquired_item_name(item));
     rc->rrdset = st;
+
+    // have the health threads examine this host on their next loop
+    __atomic_store_n(&host->health.next_run, 0, __ATOMIC_RELAXED);
     rc->chart = string_dup(st->id);
 
     health_prototype_copy_config(&rc->config, &ap->config);
@@ -378,6 +381,8 @@ static void rrdcalc_free_internals(RRDCALC *rc) {
 
     string_freez(rc->info);
     string_freez(rc->summary);
+
+    health_window_free(rc);
 }
 
 static void rrdcalc_rrdhost_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, void *rrdcalc, void *rrdhost __maybe_unused) {
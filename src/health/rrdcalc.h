@@ -76,6 +76,8 @@ struct rrdcalc {
     time_t db_after;                // the first timestamp evaluated by the db lookup
     time_t db_before;               // the last timestamp evaluated by the db lookup
 
+    struct health_window *window;   // the state of incremental db lookups
+
     time_t delay_up_to_timestamp;   // the timestamp up to which we should delay notifications
     int delay_up_current;           // the current up notification delay duration
     int delay_down_current;         // the current down notification delay duration
@@ -19,6 +19,17 @@
 // ideal to have the same overhead as libc is 4k
 #define ARAL_MAX_PAGE_SIZE_MALLOC (65*1024)
 
+// magazines are small per-thread caches of free elements
+// each thread is mapped to one of them by its tid, so that
+// threads allocating and freeing on the same ARAL do not
+// bounce the locks of the pages list
+#define ARAL_MAGAZINES 16
+#define ARAL_MAGAZINE_SIZE 32
+
+// huge pages are anonymous mmaps of 2MiB multiples, aligned to 2MiB,
+// so that the kernel can back them with transparent huge pages
+#define ARAL_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
 typedef struct aral_free {
     size_t size;
     struct aral_free *next;
@@ -47,10 +58,25 @@ typedef struct aral_page {
 
 } ARAL_PAGE;
 
+// each magazine is on its own cache lines, so that the threads using
+// different magazines do not invalidate each other's caches
+typedef struct aral_magazine {
+    SPINLOCK spinlock;
+    uint32_t used;
+
+    // statistics, updated under the spinlock
+    size_t hits;                        // allocations served by this magazine
+    size_t misses;                      // allocations that found this magazine empty
+    size_t returns;                     // elements given back from this magazine to the pages
+
+    void *elements[ARAL_MAGAZINE_SIZE];
+} __attribute__((aligned(64))) ARAL_MAGAZINE;
+
 typedef enum {
     ARAL_LOCKLESS = (1 << 0),
     ARAL_DEFRAGMENT = (1 << 1),
     ARAL_ALLOCATED_STATS = (1 << 2),
+    ARAL_HUGE_PAGES = (1 << 3),
 } ARAL_OPTIONS;
 
 struct aral {
@@ -97,6 +123,15 @@ struct aral {
         size_t allocators;              // the number of threads currently trying to allocate memory
     } atomic;
 
+    ARAL_MAGAZINE *magazines;           // NULL when magazines are not enabled
+    bool magazines_flushing;            // atomic - true while a thread gives the magazines back to the pages
+
+    struct {
+        SPINLOCK spinlock;
+        uint8_t *spare;                 // one released huge page, kept mapped after MADV_DONTNEED
+        size_t spare_size;
+    } huge_pages;
+
     struct aral_statistics *stats;
 };
 
@@ -106,7 +141,13 @@ size_t aral_structures_from_stats(struct aral_statistics *stats) {
 
 size_t aral_overhead_from_stats(struct aral_statistics *stats) {
     return __atomic_load_n(&stats->malloc.allocated_bytes, __ATOMIC_RELAXED) -
-           __atomic_load_n(&stats->malloc.used_bytes, __ATOMIC_RELAXED);
+           __atomic_load_n(&stats->malloc.used_bytes, __ATOMIC_RELAXED) +
+           __atomic_load_n(&stats->huge_pages.allocated_bytes, __ATOMIC_RELAXED) -
+           __atomic_load_n(&stats->huge_pages.used_bytes, __ATOMIC_RELAXED);
+}
+
+size_t aral_huge_pages_from_stats(struct aral_statistics *stats) {
+    return __atomic_load_n(&stats->huge_pages.allocated_bytes, __ATOMIC_RELAXED);
 }
 
 size_t aral_overhead(ARAL *ar) {
@@ -271,6 +312,74 @@ size_t aral_next_allocation_size___adders_lock_needed(ARAL *ar) {
     return size;
 }
 
+// ----------------------------------------------------------------------------
+// huge pages
+
+// pages are sized to fit whole elements, so their mappings are rounded up
+static inline size_t aral_huge_page_mapping_size(size_t size) {
+    return natural_alignment(size, ARAL_HUGE_PAGE_SIZE);
+}
+
+static void *aral_huge_page_mmap(ARAL *ar, size_t size) {
+    size = aral_huge_page_mapping_size(size);
+
+    // over-allocate by one huge page, to be able to align the start to 2MiB
+    size_t mapped = size + ARAL_HUGE_PAGE_SIZE;
+    uint8_t *mem = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(unlikely(mem == MAP_FAILED))
+        fatal("ARAL: '%s' cannot mmap() %zu bytes for huge pages", ar->config.name, mapped);
+
+    uint8_t *aligned = (uint8_t *)(((uintptr_t)mem + ARAL_HUGE_PAGE_SIZE - 1) & ~((uintptr_t)ARAL_HUGE_PAGE_SIZE - 1));
+
+    size_t head = aligned - mem;
+    if(head)
+        munmap(mem, head);
+
+    size_t tail = mapped - head - size;
+    if(tail)
+        munmap(aligned + size, tail);
+
+    madvise_hugepage(aligned, size);
+    madvise_dontfork(aligned, size);
+    return aligned;
+}
+
+static void *aral_huge_page_get(ARAL *ar, size_t size) {
+    uint8_t *mem = NULL;
+
+    spinlock_lock(&ar->huge_pages.spinlock);
+    if(ar->huge_pages.spare && ar->huge_pages.spare_size == size) {
+        mem = ar->huge_pages.spare;
+        ar->huge_pages.spare = NULL;
+        ar->huge_pages.spare_size = 0;
+    }
+    spinlock_unlock(&ar->huge_pages.spinlock);
+
+    if(!mem)
+        mem = aral_huge_page_mmap(ar, size);
+
+    return mem;
+}
+
+static void aral_huge_page_put(ARAL *ar, void *mem, size_t size, bool destroying) {
+    if(!destroying) {
+        // keep one released page mapped, and give its memory back
+        // to the kernel with MADV_DONTNEED, so that the next page
+        // does not have to go through mmap() and alignment again
+        spinlock_lock(&ar->huge_pages.spinlock);
+        if(!ar->huge_pages.spare) {
+            madvise_dontneed(mem, aral_huge_page_mapping_size(size));
+            ar->huge_pages.spare = mem;
+            ar->huge_pages.spare_size = size;
+            mem = NULL;
+        }
+        spinlock_unlock(&ar->huge_pages.spinlock);
+    }
+
+    if(mem)
+        munmap(mem, aral_huge_page_mapping_size(size));
+}
+
 static ARAL_PAGE *aral_create_page___no_lock_needed(ARAL *ar, size_t size TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
     ARAL_PAGE *page = callocz(1, sizeof(ARAL_PAGE));
     spinlock_init(&page->free.spinlock);
@@ -296,6 +405,11 @@ static ARAL_PAGE *aral_create_page___no_lock_needed(ARAL *ar, size_t size TRACE_
         __atomic_add_fetch(&ar->stats->mmap.allocations, 1, __ATOMIC_RELAXED);
         __atomic_add_fetch(&ar->stats->mmap.allocated_bytes, page->size, __ATOMIC_RELAXED);
     }
+    else if(ar->config.options & ARAL_HUGE_PAGES) {
+        page->data = aral_huge_page_get(ar, page->size);
+        __atomic_add_fetch(&ar->stats->huge_pages.allocations, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ar->stats->huge_pages.allocated_bytes, page->size, __ATOMIC_RELAXED);
+    }
     else {
 #ifdef NETDATA_TRACE_ALLOCATIONS
         page->data = mallocz_int(page->size TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
@@ -331,6 +445,11 @@ void aral_del_page___no_lock_needed(ARAL *ar, ARAL_PAGE *page TRACE_ALLOCATIONS_
         __atomic_sub_fetch(&ar->stats->mmap.allocations, 1, __ATOMIC_RELAXED);
         __atomic_sub_fetch(&ar->stats->mmap.allocated_bytes, page->size, __ATOMIC_RELAXED);
     }
+    else if(ar->config.options & ARAL_HUGE_PAGES) {
+        aral_huge_page_put(ar, page->data, page->size, false);
+        __atomic_sub_fetch(&ar->stats->huge_pages.allocations, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&ar->stats->huge_pages.allocated_bytes, page->size, __ATOMIC_RELAXED);
+    }
     else {
 #ifdef NETDATA_TRACE_ALLOCATIONS
         freez_int(page->data TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
@@ -470,11 +589,57 @@ void *aral_callocz_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAM
     return r;
 }
 
+static inline void aral_used_bytes_add(ARAL *ar) {
+    if(unlikely(ar->config.mmap.enabled))
+        __atomic_add_fetch(&ar->stats->mmap.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
+    else if(unlikely(ar->config.options & ARAL_HUGE_PAGES))
+        __atomic_add_fetch(&ar->stats->huge_pages.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
+    else
+        __atomic_add_fetch(&ar->stats->malloc.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
+}
+
+static inline void aral_used_bytes_sub(ARAL *ar) {
+    if(unlikely(ar->config.mmap.enabled))
+        __atomic_sub_fetch(&ar->stats->mmap.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
+    else if(unlikely(ar->config.options & ARAL_HUGE_PAGES))
+        __atomic_sub_fetch(&ar->stats->huge_pages.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
+    else
+        __atomic_sub_fetch(&ar->stats->malloc.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
+}
+
+static inline ARAL_MAGAZINE *aral_thread_magazine(ARAL *ar) {
+    return &ar->magazines[(size_t)gettid_cached() % ARAL_MAGAZINES];
+}
+
+static inline void *aral_magazine_get(ARAL *ar) {
+    ARAL_MAGAZINE *m = aral_thread_magazine(ar);
+    void *ptr = NULL;
+
+    spinlock_lock(&m->spinlock);
+    if(m->used) {
+        ptr = m->elements[--m->used];
+        m->hits++;
+    }
+    else
+        m->misses++;
+    spinlock_unlock(&m->spinlock);
+
+    return ptr;
+}
+
 void *aral_mallocz_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
 #ifdef FSANITIZE_ADDRESS
     return mallocz(ar->config.requested_element_size);
 #endif
 
+    if(ar->magazines) {
+        void *ptr = aral_magazine_get(ar);
+        if(ptr) {
+            aral_used_bytes_add(ar);
+            return ptr;
+        }
+    }
+
     ARAL_PAGE *page = aral_acquire_a_free_slot(ar TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
 
     aral_page_free_lock(ar, page);
@@ -515,10 +680,7 @@ void *aral_mallocz_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAM
     ARAL_PAGE **page_ptr = (ARAL_PAGE **)&data[ar->config.page_ptr_offset];
     *page_ptr = page;
 
-    if(unlikely(ar->config.mmap.enabled))
-        __atomic_add_fetch(&ar->stats->mmap.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
-    else
-        __atomic_add_fetch(&ar->stats->malloc.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
+    aral_used_bytes_add(ar);
 
     return (void *)found_fr;
 }
@@ -622,22 +784,12 @@ static inline void aral_move_page_with_free_list___aral_lock_needed(ARAL *ar, AR
         aral_defrag_sorted_page_position___aral_lock_needed(ar, page);
 }
 
-void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
-#ifdef FSANITIZE_ADDRESS
-    freez(ptr);
-    return;
-#endif
-
-    if(unlikely(!ptr)) return;
+static void aral_magazines_flush(ARAL *ar);
 
+static void aral_release_to_page(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
     // get the page pointer
     ARAL_PAGE *page = aral_ptr_to_page___must_NOT_have_aral_lock(ar, ptr);
 
-    if(unlikely(ar->config.mmap.enabled))
-        __atomic_sub_fetch(&ar->stats->mmap.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
-    else
-        __atomic_sub_fetch(&ar->stats->malloc.used_bytes, ar->config.element_size, __ATOMIC_RELAXED);
-
     // make this element available
     ARAL_FREE *fr = (ARAL_FREE *)ptr;
     fr->size = ar->config.element_size;
@@ -678,8 +830,13 @@ void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITI
 
         aral_unlock(ar);
 
-        if(!is_this_page_the_last_one)
+        if(!is_this_page_the_last_one) {
             aral_del_page___no_lock_needed(ar, page TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+
+            // the ARAL shrinks, and the elements cached in the magazines
+            // may be all that keeps some of the other pages allocated
+            aral_magazines_flush(ar);
+        }
     }
     else {
         aral_move_page_with_free_list___aral_lock_needed(ar, page);
@@ -687,6 +844,97 @@ void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITI
     }
 }
 
+static void aral_magazine_put(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    ARAL_MAGAZINE *m = aral_thread_magazine(ar);
+    void *batch[ARAL_MAGAZINE_SIZE / 2];
+    size_t batch_size = 0;
+
+    spinlock_lock(&m->spinlock);
+
+    if(m->used == ARAL_MAGAZINE_SIZE) {
+        // the magazine is full, give half of it back to the pages
+        batch_size = ARAL_MAGAZINE_SIZE / 2;
+        m->used -= batch_size;
+        m->returns += batch_size;
+        memcpy(batch, &m->elements[m->used], batch_size * sizeof(void *));
+    }
+
+    m->elements[m->used++] = ptr;
+
+    spinlock_unlock(&m->spinlock);
+
+    for(size_t i = 0; i < batch_size ; i++)
+        aral_release_to_page(ar, batch[i] TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+}
+
+// give all elements cached in the magazines back to their pages
+// it is called every time a page is released, so that the magazines
+// do not keep the pages of an ARAL that is no longer used
+static void aral_magazines_flush(ARAL *ar) {
+    if(!ar->magazines)
+        return;
+
+    // one thread at a time - the pages released by the flush call it again
+    if(__atomic_exchange_n(&ar->magazines_flushing, true, __ATOMIC_ACQUIRE))
+        return;
+
+#ifdef NETDATA_TRACE_ALLOCATIONS
+    const char *file = __FILE__, *function = __FUNCTION__;
+    size_t line = __LINE__;
+#endif
+
+    void *batch[ARAL_MAGAZINE_SIZE];
+    for(size_t i = 0; i < ARAL_MAGAZINES ; i++) {
+        ARAL_MAGAZINE *m = &ar->magazines[i];
+
+        spinlock_lock(&m->spinlock);
+        size_t batch_size = m->used;
+        memcpy(batch, m->elements, batch_size * sizeof(void *));
+        m->returns += batch_size;
+        m->used = 0;
+        spinlock_unlock(&m->spinlock);
+
+        for(size_t e = 0; e < batch_size ; e++)
+            aral_release_to_page(ar, batch[e] TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+    }
+
+    __atomic_store_n(&ar->magazines_flushing, false, __ATOMIC_RELEASE);
+}
+
+struct aral_magazines_statistics aral_magazines_statistics(ARAL *ar) {
+    struct aral_magazines_statistics stats = { 0 };
+    if(!ar->magazines)
+        return stats;
+
+    for(size_t i = 0; i < ARAL_MAGAZINES ; i++) {
+        ARAL_MAGAZINE *m = &ar->magazines[i];
+
+        spinlock_lock(&m->spinlock);
+        stats.hits += m->hits;
+        stats.misses += m->misses;
+        stats.returns += m->returns;
+        spinlock_unlock(&m->spinlock);
+    }
+
+    return stats;
+}
+
+void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+#ifdef FSANITIZE_ADDRESS
+    freez(ptr);
+    return;
+#endif
+
+    if(unlikely(!ptr)) return;
+
+    aral_used_bytes_sub(ar);
+
+    if(ar->magazines)
+        aral_magazine_put(ar, ptr TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+    else
+        aral_release_to_page(ar, ptr TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+}
+
 void aral_destroy_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
     aral_lock(ar);
 
@@ -698,12 +946,56 @@ void aral_destroy_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS
 
     aral_unlock(ar);
 
+    if(ar->huge_pages.spare)
+        aral_huge_page_put(ar, ar->huge_pages.spare, ar->huge_pages.spare_size, true);
+
+    if(ar->magazines) {
+        // the elements in the magazines were on the pages we just deleted
+        __atomic_sub_fetch(&ar->stats->structures.allocated_bytes, ARAL_MAGAZINES * sizeof(ARAL_MAGAZINE), __ATOMIC_RELAXED);
+        free(ar->magazines);
+    }
+
     if(ar->config.options & ARAL_ALLOCATED_STATS)
         freez(ar->stats);
 
     freez(ar);
 }
 
+// enable the per-thread magazines of an ARAL
+// it has to be called before the ARAL is used
+void aral_magazines_enable(ARAL *ar) {
+    if(ar->magazines || (ar->config.options & ARAL_LOCKLESS))
+        return;
+
+    // aligned, so that every magazine starts on a cache line
+    void *magazines = NULL;
+    int rc = posix_memalign(&magazines, 64, ARAL_MAGAZINES * sizeof(ARAL_MAGAZINE));
+    if(rc != 0)
+        fatal("ARAL: '%s' cannot allocate the magazines: %s", ar->config.name, strerror(rc));
+
+    memset(magazines, 0, ARAL_MAGAZINES * sizeof(ARAL_MAGAZINE));
+    ar->magazines = magazines;
+    for(size_t i = 0; i < ARAL_MAGAZINES ; i++)
+        spinlock_init(&ar->magazines[i].spinlock);
+
+    __atomic_add_fetch(&ar->stats->structures.allocated_bytes, ARAL_MAGAZINES * sizeof(ARAL_MAGAZINE), __ATOMIC_RELAXED);
+}
+
+// allocate the pages of an ARAL from 2MiB aligned anonymous mmaps,
+// advised with MADV_HUGEPAGE, instead of malloc()
+// it has to be called before the ARAL is used
+void aral_huge_pages_enable(ARAL *ar) {
+    if((ar->config.options & ARAL_HUGE_PAGES) || ar->config.mmap.enabled || ar->aral_lock.pages)
+        return;
+
+    size_t size = aral_align_alloc_size(ar, natural_alignment(ar->config.max_allocation_size, ARAL_HUGE_PAGE_SIZE));
+
+    // all pages are full huge pages, even the first one
+    ar->config.max_allocation_size = size;
+    ar->adders.allocation_size = size;
+    ar->config.options |= ARAL_HUGE_PAGES;
+}
+
 size_t aral_element_size(ARAL *ar) {
     return ar->config.requested_element_size;
 }
@@ -721,6 +1013,7 @@ ARAL *aral_create(const char *name, size_t element_size, size_t initial_page_ele
     strncpyz(ar->config.name, name, ARAL_MAX_NAME);
     spinlock_init(&ar->aral_lock.spinlock);
     spinlock_init(&ar->adders.spinlock);
+    spinlock_init(&ar->huge_pages.spinlock);
 
     if(stats) {
         ar->stats = stats;
@@ -1006,9 +1299,9 @@ static void *aral_test_thread(void *ptr) {
     return ptr;
 }
 
-int aral_stress_test(size_t threads, size_t elements, size_t seconds) {
-    fprintf(stderr, "Running stress test of %zu threads, with %zu elements each, for %zu seconds...\n",
-            threads, elements, seconds);
+int aral_stress_test(size_t threads, size_t elements, size_t seconds, bool magazines) {
+    fprintf(stderr, "Running stress test of %zu threads, with %zu elements each, for %zu seconds%s...\n",
+            threads, elements, seconds, magazines ? ", with magazines" : "");
 
     struct aral_unittest_config auc = {
             .single_threaded = false,
@@ -1018,6 +1311,9 @@ int aral_stress_test(size_t threads, size_t elements, size_t seconds) {
             .errors = 0,
     };
 
+    if(magazines)
+        aral_magazines_enable(auc.ar);
+
     usec_t started_ut = now_monotonic_usec();
     ND_THREAD *thread_ptrs[threads];
 
@@ -1033,6 +1329,7 @@ int aral_stress_test(size_t threads, size_t elements, size_t seconds) {
 
     size_t malloc_done = 0;
     size_t free_done = 0;
+    size_t hits_done = 0;
     size_t countdown = seconds;
     while(countdown-- > 0) {
         sleep_usec(1 * USEC_PER_SEC);
@@ -1040,10 +1337,13 @@ int aral_stress_test(size_t threads, size_t elements, size_t seconds) {
         size_t m = auc.ar->aral_lock.user_malloc_operations;
         size_t f = auc.ar->aral_lock.user_free_operations;
         aral_unlock(auc.ar);
-        fprintf(stderr, "ARAL executes %0.2f M malloc and %0.2f M free operations/s\n",
-                (double)(m - malloc_done) / 1000000.0, (double)(f - free_done) / 1000000.0);
+        size_t h = aral_magazines_statistics(auc.ar).hits;
+        fprintf(stderr, "ARAL executes %0.2f M malloc and %0.2f M free operations/s, %0.2f M magazine hits/s\n",
+                (double)(m - malloc_done) / 1000000.0, (double)(f - free_done) / 1000000.0,
+                (double)(h - hits_done) / 1000000.0);
         malloc_done = m;
         free_done = f;
+        hits_done = h;
     }
 
     __atomic_store_n(&auc.stop, true, __ATOMIC_RELAXED);
@@ -1060,6 +1360,8 @@ int aral_stress_test(size_t threads, size_t elements, size_t seconds) {
 
     usec_t ended_ut = now_monotonic_usec();
 
+    aral_magazines_flush(auc.ar);
+
     if (auc.ar->aral_lock.pages && auc.ar->aral_lock.pages->aral_lock.used_elements) {
         fprintf(stderr, "\n\nARAL leftovers detected (3)\n\n");
         __atomic_add_fetch(&auc.errors, 1, __ATOMIC_RELAXED);
@@ -1092,7 +1394,8 @@ int aral_unittest(size_t elements) {
 
     aral_destroy(auc.ar);
 
-    int errors = aral_stress_test(2, elements, 5);
+    int errors = aral_stress_test(2, elements, 5, false);
+    errors += aral_stress_test(2, elements, 5, true);
 
     return auc.errors + errors;
 }
@@ -25,16 +25,32 @@ struct aral_statistics {
         size_t allocated_bytes;
         size_t used_bytes;
     } mmap;
+
+    struct {
+        size_t allocations;
+        size_t allocated_bytes;
+        size_t used_bytes;
+    } huge_pages;
+};
+
+struct aral_magazines_statistics {
+    size_t hits;                    // allocations served by the magazines, without touching the pages
+    size_t misses;                  // allocations that found the magazine empty
+    size_t returns;                 // elements given back from the magazines to their pages
 };
 
 ARAL *aral_create(const char *name, size_t element_size, size_t initial_page_elements, size_t max_page_size,
                   struct aral_statistics *stats, const char *filename, const char **cache_dir, bool mmap, bool lockless);
+void aral_magazines_enable(ARAL *ar);
+struct aral_magazines_statistics aral_magazines_statistics(ARAL *ar);
+void aral_huge_pages_enable(ARAL *ar);
 size_t aral_element_size(ARAL *ar);
 size_t aral_overhead(ARAL *ar);
 size_t aral_structures(ARAL *ar);
 struct aral_statistics *aral_statistics(ARAL *ar);
 size_t aral_structures_from_stats(struct aral_statistics *stats);
 size_t aral_overhead_from_stats(struct aral_statistics *stats);
+size_t aral_huge_pages_from_stats(struct aral_statistics *stats);
 
 ARAL *aral_by_size_acquire(size_t size);
 void aral_by_size_release(ARAL *ar);
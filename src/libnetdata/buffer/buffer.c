@@ -287,6 +287,8 @@ void buffer_json_initialize(BUFFER *wb, const char *key_quote, const char *value
                        bool add_anonymous_object, BUFFER_JSON_OPTIONS options) {
     strncpyz(wb->json.key_quote, key_quote, BUFFER_QUOTE_MAX_SIZE);
     strncpyz(wb->json.value_quote,  value_quote, BUFFER_QUOTE_MAX_SIZE);
+    wb->json.key_quote_len = (uint8_t)strlen(wb->json.key_quote);
+    wb->json.value_quote_len = (uint8_t)strlen(wb->json.value_quote);
 
     wb->json.depth = (int8_t)(depth - 1);
     _buffer_json_depth_push(wb, BUFFER_JSON_OBJECT);
@@ -435,6 +437,10 @@ int buffer_unittest(void) {
     buffer_uint64_roundtrip(wb, NUMBER_ENCODING_HEX, 18446744073709551615ULL, "0xFFFFFFFFFFFFFFFF");
     buffer_uint64_roundtrip(wb, NUMBER_ENCODING_BASE64, 18446744073709551615ULL, "#P//////////");
 
+    // decimal numbers of all lengths, parsed 8 digits at a time when possible
+    for(uint64_t v = 1, digits = 1; digits <= 20 ; v = v * 10 + (digits % 10), digits++)
+        errors += buffer_uint64_roundtrip(wb, NUMBER_ENCODING_DECIMAL, v, NULL);
+
     buffer_int64_roundtrip(wb, NUMBER_ENCODING_DECIMAL, 0, "0");
     buffer_int64_roundtrip(wb, NUMBER_ENCODING_HEX, 0, "0x0");
     buffer_int64_roundtrip(wb, NUMBER_ENCODING_BASE64, 0, "#A");
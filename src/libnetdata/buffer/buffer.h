@@ -52,6 +52,8 @@ typedef struct web_buffer {
     struct {
         char key_quote[BUFFER_QUOTE_MAX_SIZE + 1];
         char value_quote[BUFFER_QUOTE_MAX_SIZE + 1];
+        uint8_t key_quote_len;
+        uint8_t value_quote_len;
         int8_t depth;
         BUFFER_JSON_OPTIONS options;
         BUFFER_JSON_NODE stack[BUFFER_JSON_MAX_DEPTH];
@@ -611,6 +613,7 @@ static inline void buffer_print_int64_base64(BUFFER *wb, int64_t value) {
 }
 
 #define DOUBLE_MAX_LENGTH (512) // 318 should be enough, including null
+#define DOUBLE_INTEGRAL_FAST_MAX (NETDATA_DOUBLE)(1ULL << 53)
 static inline void buffer_print_netdata_double(BUFFER *wb, NETDATA_DOUBLE value) {
     buffer_need_bytes(wb, DOUBLE_MAX_LENGTH);
 
@@ -618,6 +621,9 @@ static inline void buffer_print_netdata_double(BUFFER *wb, NETDATA_DOUBLE value)
         buffer_fast_strcat(wb, "null", 4);
         return;
     }
+    else if(value > -DOUBLE_INTEGRAL_FAST_MAX && value < DOUBLE_INTEGRAL_FAST_MAX && value == (NETDATA_DOUBLE)(int64_t)value)
+        // integral values (zeros, counters, etc) print the same as integers
+        wb->len += print_int64(&wb->buffer[wb->len], (int64_t)value);
     else
         wb->len += print_netdata_double(&wb->buffer[wb->len], value);
 
@@ -729,17 +735,61 @@ static inline void buffer_print_json_comma_newline_spacing(BUFFER *wb) {
     buffer_print_spaces(wb, wb->json.depth + 1);
 }
 
+static inline void buffer_print_json_quote(BUFFER *wb, const char *quote, size_t len) {
+    buffer_need_bytes(wb, len + 1);
+
+    for(size_t i = 0; i < len ; i++)
+        wb->buffer[wb->len++] = quote[i];
+
+    wb->buffer[wb->len] = '\0';
+}
+
+static inline bool buffer_json_char_needs_escaping(unsigned char c) {
+#ifdef BUFFER_JSON_ESCAPE_UTF
+    if(c & 0x80)
+        return true;
+#endif
+
+    return c < ' ' || c == '"' || c == '\\';
+}
+
+// copies the part of txt that does not need escaping (for keys,
+// normally all of it), and returns the rest
+static inline const char *buffer_json_strcat_unescaped(BUFFER *wb, const char *txt) {
+    const char *t = txt;
+    while(*t && !buffer_json_char_needs_escaping((unsigned char)*t))
+        t++;
+
+    size_t len = t - txt;
+    if(len) {
+        buffer_need_bytes(wb, len + 1);
+        memcpy(&wb->buffer[wb->len], txt, len);
+        wb->len += len;
+        wb->buffer[wb->len] = '\0';
+    }
+
+    return t;
+}
+
 static inline void buffer_print_json_key(BUFFER *wb, const char *key) {
-    buffer_strcat(wb, wb->json.key_quote);
-    buffer_json_strcat(wb, key);
-    buffer_strcat(wb, wb->json.key_quote);
+    buffer_print_json_quote(wb, wb->json.key_quote, wb->json.key_quote_len);
+
+    if(likely(key)) {
+        key = buffer_json_strcat_unescaped(wb, key);
+        if(unlikely(*key))
+            buffer_json_strcat(wb, key);
+    }
+
+    buffer_print_json_quote(wb, wb->json.key_quote, wb->json.key_quote_len);
 }
 
 static inline void buffer_json_add_string_value(BUFFER *wb, const char *value) {
     if(value) {
-        buffer_strcat(wb, wb->json.value_quote);
-        buffer_json_strcat(wb, value);
-        buffer_strcat(wb, wb->json.value_quote);
+        buffer_print_json_quote(wb, wb->json.value_quote, wb->json.value_quote_len);
+        value = buffer_json_strcat_unescaped(wb, value);
+        if(*value)
+            buffer_json_strcat(wb, value);
+        buffer_print_json_quote(wb, wb->json.value_quote, wb->json.value_quote_len);
     }
     else
         buffer_fast_strcat(wb, "null", 4);
@@ -747,14 +797,21 @@ static inline void buffer_json_add_string_value(BUFFER *wb, const char *value) {
 
 static inline void buffer_json_add_quoted_string_value(BUFFER *wb, const char *value) {
     if(value) {
-        buffer_strcat(wb, wb->json.value_quote);
+        buffer_print_json_quote(wb, wb->json.value_quote, wb->json.value_quote_len);
         buffer_json_quoted_strcat(wb, value);
-        buffer_strcat(wb, wb->json.value_quote);
+        buffer_print_json_quote(wb, wb->json.value_quote, wb->json.value_quote_len);
     }
     else
         buffer_fast_strcat(wb, "null", 4);
 }
 
+// make room for the items of an array at once, so that adding
+// them does not grow the buffer many times
+static inline void buffer_json_array_reserve(BUFFER *wb, size_t items, size_t bytes_per_item) {
+    size_t spacing = (wb->json.options & BUFFER_JSON_OPTIONS_MINIFY) ? 0 : (size_t)(wb->json.depth + 1) * 4 + 1;
+    buffer_need_bytes(wb, items * (bytes_per_item + spacing + 1));
+}
+
 static inline void buffer_json_member_add_object(BUFFER *wb, const char *key) {
     buffer_print_json_comma_newline_spacing(wb);
     buffer_print_json_key(wb, key);
@@ -1289,4 +1346,53 @@ static inline BUFFER *buffer_dup(BUFFER *src) {
     return dst;
 }
 
+// ----------------------------------------------------------------------------
+// protobuf encoding
+
+#define BUFFER_PROTOBUF_WIRE_VARINT 0
+#define BUFFER_PROTOBUF_WIRE_FIXED64 1
+#define BUFFER_PROTOBUF_WIRE_BYTES 2
+
+static inline void buffer_protobuf_varint(BUFFER *wb, uint64_t v) {
+    uint8_t b[10];
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        b[n++] = (uint8_t)((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    b[n++] = (uint8_t)v;
+
+    buffer_memcat(wb, b, n);
+}
+
+static inline void buffer_protobuf_tag(BUFFER *wb, uint32_t field, uint32_t wire) {
+    buffer_protobuf_varint(wb, (field << 3) | wire);
+}
+
+static inline void buffer_protobuf_bytes(BUFFER *wb, uint32_t field, const void *data, size_t len) {
+    buffer_protobuf_tag(wb, field, BUFFER_PROTOBUF_WIRE_BYTES);
+    buffer_protobuf_varint(wb, len);
+    buffer_memcat(wb, data, len);
+}
+
+static inline void buffer_protobuf_string(BUFFER *wb, uint32_t field, const char *s) {
+    buffer_protobuf_bytes(wb, field, s, strlen(s));
+}
+
+static inline void buffer_protobuf_fixed64(BUFFER *wb, uint32_t field, uint64_t v) {
+    uint8_t b[8];
+    for (size_t i = 0; i < 8; i++)
+        b[i] = (uint8_t)(v >> (i * 8));
+
+    buffer_protobuf_tag(wb, field, BUFFER_PROTOBUF_WIRE_FIXED64);
+    buffer_memcat(wb, b, sizeof(b));
+}
+
+static inline void buffer_protobuf_double(BUFFER *wb, uint32_t field, double value) {
+    uint64_t v;
+    memcpy(&v, &value, sizeof(v));
+    buffer_protobuf_fixed64(wb, field, v);
+}
+
 #endif /* NETDATA_WEB_BUFFER_H */
@@ -8,6 +8,11 @@
 struct buffered_reader {
     ssize_t read_len;
     ssize_t pos;
+
+    // the byte after the last line given in place, replaced by its terminator
+    char *terminated_at;
+    char terminated_byte;
+
     char read_buffer[PLUGINSD_LINE_MAX + 1];
 };
 
@@ -15,6 +20,16 @@ static inline void buffered_reader_init(struct buffered_reader *reader) {
     reader->read_buffer[0] = '\0';
     reader->read_len = 0;
     reader->pos = 0;
+    reader->terminated_at = NULL;
+    reader->terminated_byte = '\0';
+}
+
+// put back the byte that was replaced to terminate the last line given in place
+static inline void buffered_reader_unterminate(struct buffered_reader *reader) {
+    if(reader->terminated_at) {
+        *reader->terminated_at = reader->terminated_byte;
+        reader->terminated_at = NULL;
+    }
 }
 
 typedef enum {
@@ -31,6 +46,8 @@ typedef enum {
 
 
 static inline buffered_reader_ret_t buffered_reader_read(struct buffered_reader *reader, int fd) {
+    buffered_reader_unterminate(reader);
+
 #ifdef NETDATA_INTERNAL_CHECKS
     if(reader->read_buffer[reader->read_len] != '\0')
         fatal("read_buffer does not start with zero");
@@ -98,6 +115,7 @@ static inline buffered_reader_ret_t buffered_reader_read_timeout(struct buffered
  * When we hit the end of the buffer with a partial line move it to the beginning for the next fill.
  */
 static inline bool buffered_reader_next_line(struct buffered_reader *reader, BUFFER *dst) {
+    buffered_reader_unterminate(reader);
     buffer_need_bytes(dst, reader->read_len - reader->pos + 2);
 
     size_t start = reader->pos;
@@ -115,29 +133,65 @@ static inline bool buffered_reader_next_line(struct buffered_reader *reader, BUF
         return false;
     }
 
-    // copy all bytes to buffer
-    while(ss < se && ds < de && *ss != '\n') {
-        *ds++ = *ss++;
-        dst->len++;
-    }
+    // copy all bytes up to the newline (or the end of the data) to the buffer
+    char *nl = memchr(ss, '\n', se - ss);
+    size_t len = (nl ? (size_t)(nl - ss) + 1 : (size_t)(se - ss)); // with the newline
+    if(len > (size_t)(de - ds))
+        len = de - ds;
+
+    memcpy(ds, ss, len);
+    ds += len;
+    ss += len;
+    dst->len += len;
 
     // if we have a newline, return the buffer
-    if(ss < se && ds < de && *ss == '\n') {
+    if(nl && ss == nl + 1) {
         // newline found in the r->read_buffer
-
-        *ds++ = *ss++; // copy the newline too
-        dst->len++;
-
         *ds = '\0';
 
         reader->pos = ss - reader->read_buffer;
         return true;
     }
 
+    *ds = '\0';
     reader->pos = 0;
     reader->read_len = 0;
     reader->read_buffer[reader->read_len] = '\0';
     return false;
 }
 
+/* Give the next full line in place, in the read buffer, without copying it.
+ * The line includes its newline and it is null terminated, until the next call.
+ * When there is no full line, the partial one is moved to the beginning of the
+ * buffer for the next fill and NULL is returned. A line that does not fit in the
+ * read buffer makes the next read return BUFFERED_READER_READ_BUFFER_FULL - it
+ * can still be read with buffered_reader_next_line().
+ */
+static inline char *buffered_reader_next_line_inplace(struct buffered_reader *reader) {
+    buffered_reader_unterminate(reader);
+
+    char *ss = &reader->read_buffer[reader->pos];
+    char *se = &reader->read_buffer[reader->read_len];
+    char *nl = (ss < se) ? memchr(ss, '\n', se - ss) : NULL;
+
+    if(!nl) {
+        size_t remaining = se - ss;
+        if(remaining && reader->pos)
+            memmove(reader->read_buffer, ss, remaining);
+
+        reader->pos = 0;
+        reader->read_len = (ssize_t)remaining;
+        reader->read_buffer[reader->read_len] = '\0';
+        return NULL;
+    }
+
+    char *next = nl + 1;
+    reader->terminated_at = next;
+    reader->terminated_byte = *next;
+    *next = '\0';
+
+    reader->pos = next - reader->read_buffer;
+    return ss;
+}
+
 #endif //NETDATA_BUFFERED_READER_H
@@ -107,6 +107,28 @@ size_t cbuffer_next_unsafe(struct circular_buffer *buf, char **start) {
     return buf->size - buf->read;
 }
 
+// Fills iov with the data waiting to be read, one segment when it is contiguous
+// and two when it wraps around the end of the buffer. Returns the number of segments.
+size_t cbuffer_next_segments_unsafe(struct circular_buffer *buf, struct iovec iov[2]) {
+    if (buf->read == buf->write)
+        return 0;
+
+    iov[0].iov_base = buf->data + buf->read;
+
+    if (buf->read < buf->write) {
+        iov[0].iov_len = buf->write - buf->read;
+        return 1;
+    }
+
+    iov[0].iov_len = buf->size - buf->read;
+    if (!buf->write)
+        return 1;
+
+    iov[1].iov_base = buf->data;
+    iov[1].iov_len = buf->write;
+    return 2;
+}
+
 void cbuffer_flush(struct circular_buffer*buf) {
     buf->write = 0;
     buf->read = 0;
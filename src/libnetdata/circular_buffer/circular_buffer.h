@@ -2,6 +2,7 @@
 #define CIRCULAR_BUFFER_H 1
 
 #include <string.h>
+#include <sys/uio.h>
 
 struct circular_buffer {
     size_t size, write, read, max_size;
@@ -14,6 +15,7 @@ void cbuffer_free(struct circular_buffer *buf);
 int cbuffer_add_unsafe(struct circular_buffer *buf, const char *d, size_t d_len);
 void cbuffer_remove_unsafe(struct circular_buffer *buf, size_t num);
 size_t cbuffer_next_unsafe(struct circular_buffer *buf, char **start);
+size_t cbuffer_next_segments_unsafe(struct circular_buffer *buf, struct iovec iov[2]);
 size_t cbuffer_available_size_unsafe(struct circular_buffer *buf);
 void cbuffer_flush(struct circular_buffer*buf);
 
@@ -290,9 +290,20 @@ void heartbeat_statistics(usec_t *min_ptr, usec_t *max_ptr, usec_t *average_ptr,
     memcpy(old, current, sizeof(struct heartbeat_thread_statistics) * HEARTBEAT_ALIGNMENT_STATISTICS_SIZE);
 }
 
+// when set, all the heartbeats initialized afterwards wake up at the same offset
+// of their ticks, so that their work (like rrdset_done()) happens together
+static bool heartbeat_aligned = false;
+
+void heartbeat_align_all(bool align) {
+    heartbeat_aligned = align;
+}
+
 inline void heartbeat_init(heartbeat_t *hb) {
     hb->realtime = 0ULL;
-    hb->randomness = (usec_t)250 * USEC_PER_MS + ((usec_t)(now_realtime_usec() * clock_realtime_resolution) % (250 * USEC_PER_MS));
+    if(heartbeat_aligned)
+        hb->randomness = (usec_t)250 * USEC_PER_MS;
+    else
+        hb->randomness = (usec_t)250 * USEC_PER_MS + ((usec_t)(now_realtime_usec() * clock_realtime_resolution) % (250 * USEC_PER_MS));
     hb->randomness -= (hb->randomness % clock_realtime_resolution);
 
     netdata_mutex_lock(&heartbeat_alignment_mutex);
@@ -138,6 +138,7 @@ usec_t dt_usec(struct timeval *now, struct timeval *old);
 susec_t dt_usec_signed(struct timeval *now, struct timeval *old);
 
 void heartbeat_init(heartbeat_t *hb);
+void heartbeat_align_all(bool align);
 
 /* Sleeps until next multiple of tick using monotonic clock.
  * Returns elapsed time in microseconds since previous heartbeat
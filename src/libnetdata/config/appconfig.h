@@ -113,23 +113,30 @@
 #define CONFIG_FILE_LINE_MAX ((CONFIG_MAX_NAME + CONFIG_MAX_VALUE + 1024) * 2)
 
 struct config_section;
+struct config_sections_index;
 
 struct config {
     struct config_section *sections;
     SPINLOCK spinlock;
-    avl_tree_lock index;
+    struct config_sections_index *index;    // atomic - created on first use
+
+    // when set, getting a value from a section that does not exist returns the default,
+    // without creating the section - for configs with sections looked up for arbitrary names
+    bool lazy_sections;
 };
 
 #define APPCONFIG_INITIALIZER (struct config) {         \
         .sections = NULL,                               \
         .spinlock = NETDATA_SPINLOCK_INITIALIZER,       \
-        .index = {                                      \
-            .avl_tree = {                               \
-                .root = NULL,                           \
-                .compar = appconfig_section_compare,    \
-            },                                          \
-            .rwlock = AVL_LOCK_INITIALIZER,             \
-        },                                              \
+        .index = NULL,                                  \
+        .lazy_sections = false,                         \
+    }
+
+#define APPCONFIG_LAZY_INITIALIZER (struct config) {    \
+        .sections = NULL,                               \
+        .spinlock = NETDATA_SPINLOCK_INITIALIZER,       \
+        .index = NULL,                                  \
+        .lazy_sections = true,                          \
     }
 
 int appconfig_load(struct config *root, char *filename, int overwrite_used, const char *section_name);
@@ -146,8 +153,6 @@ int appconfig_move_everywhere(struct config *root, const char *name_old, const c
 
 void appconfig_generate(struct config *root, BUFFER *wb, int only_changed, bool netdata_conf);
 
-int appconfig_section_compare(void *a, void *b);
-
 bool appconfig_test_boolean_value(const char *s);
 
 struct connector_instance {
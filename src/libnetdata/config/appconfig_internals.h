@@ -37,8 +37,6 @@ typedef enum __attribute__((packed)) {
 } CONFIG_VALUE_FLAGS;
 
 struct config_option {
-    avl_t avl_node;         // the index entry of this entry - this has to be first!
-
     CONFIG_VALUE_TYPES type;
     CONFIG_VALUE_FLAGS flags;
 
@@ -58,18 +56,61 @@ struct config_option {
     struct config_option *prev, *next; // config->mutex protects just this
 };
 
-struct config_section {
-    avl_t avl_node;         // the index entry of this section - this has to be first!
+// ----------------------------------------------------------------------------
+// indexes
+
+// sections and options are indexed by the hash of their names, so that lookups
+// hash the name given by the caller, without creating a STRING for it
+
+static inline const char *appconfig_option_index_key(struct config_option *opt) {
+    return string2str(opt->name);
+}
+
+static inline bool appconfig_index_keys_match(const char *k1, const char *k2) {
+    return strcmp(k1, k2) == 0;
+}
+
+static inline uint64_t appconfig_index_hash(const char *name) {
+    return XXH3_64bits(name, strlen(name));
+}
+
+#include "../simple_hashtable_undef.h"
+#define SIMPLE_HASHTABLE_NAME _CONFIG_OPTIONS
+#define SIMPLE_HASHTABLE_VALUE_TYPE struct config_option
+#define SIMPLE_HASHTABLE_KEY_TYPE const char
+#define SIMPLE_HASHTABLE_VALUE2KEY_FUNCTION appconfig_option_index_key
+#define SIMPLE_HASHTABLE_COMPARE_KEYS_FUNCTION appconfig_index_keys_match
+#include "../simple_hashtable.h"
 
+struct config_section {
     STRING *name;
 
     struct config_option *values;
-    avl_tree_lock values_index;
+
+    SPINLOCK index_spinlock;                // protects just the values_index
+    SIMPLE_HASHTABLE_CONFIG_OPTIONS values_index;
 
     SPINLOCK spinlock;
     struct config_section *prev, *next;    // global config_mutex protects just this
 };
 
+static inline const char *appconfig_section_index_key(struct config_section *sect) {
+    return string2str(sect->name);
+}
+
+#include "../simple_hashtable_undef.h"
+#define SIMPLE_HASHTABLE_NAME _CONFIG_SECTIONS
+#define SIMPLE_HASHTABLE_VALUE_TYPE struct config_section
+#define SIMPLE_HASHTABLE_KEY_TYPE const char
+#define SIMPLE_HASHTABLE_VALUE2KEY_FUNCTION appconfig_section_index_key
+#define SIMPLE_HASHTABLE_COMPARE_KEYS_FUNCTION appconfig_index_keys_match
+#include "../simple_hashtable.h"
+
+struct config_sections_index {
+    SPINLOCK spinlock;
+    SIMPLE_HASHTABLE_CONFIG_SECTIONS hashtable;
+};
+
 // ----------------------------------------------------------------------------
 // locking
 
@@ -81,8 +122,8 @@ struct config_section {
 // config sections
 void appconfig_section_free(struct config_section *sect);
 void appconfig_section_remove_and_delete(struct config *root, struct config_section *sect, bool have_root_lock, bool have_sect_lock);
-#define appconfig_section_add(root, cfg) (struct config_section *)avl_insert_lock(&(root)->index, (avl_t *)(cfg))
-#define appconfig_section_del(root, cfg) (struct config_section *)avl_remove_lock(&(root)->index, (avl_t *)(cfg))
+struct config_section *appconfig_section_add(struct config *root, struct config_section *sect);
+struct config_section *appconfig_section_del(struct config *root, struct config_section *sect);
 struct config_section *appconfig_section_find(struct config *root, const char *name);
 struct config_section *appconfig_section_create(struct config *root, const char *section);
 
@@ -91,9 +132,8 @@ void appconfig_option_cleanup(struct config_option *opt);
 void appconfig_option_free(struct config_option *opt);
 void appconfig_option_remove_and_delete(struct config_section *sect, struct config_option *opt, bool have_sect_lock);
 void appconfig_option_remove_and_delete_all(struct config_section *sect, bool have_sect_lock);
-int appconfig_option_compare(void *a, void *b);
-#define appconfig_option_add(co, cv) (struct config_option *)avl_insert_lock(&((co)->values_index), (avl_t *)(cv))
-#define appconfig_option_del(co, cv) (struct config_option *)avl_remove_lock(&((co)->values_index), (avl_t *)(cv))
+struct config_option *appconfig_option_add(struct config_section *sect, struct config_option *opt);
+struct config_option *appconfig_option_del(struct config_section *sect, struct config_option *opt);
 struct config_option *appconfig_option_find(struct config_section *sect, const char *name);
 struct config_option *appconfig_option_create(struct config_section *sect, const char *name, const char *value);
 
@@ -5,21 +5,49 @@
 // ----------------------------------------------------------------------------
 // config options index
 
-int appconfig_option_compare(void *a, void *b) {
-    if(((struct config_option *)a)->name < ((struct config_option *)b)->name) return -1;
-    else if(((struct config_option *)a)->name > ((struct config_option *)b)->name) return 1;
-    else return string_cmp(((struct config_option *)a)->name, ((struct config_option *)b)->name);
+struct config_option *appconfig_option_find(struct config_section *sect, const char *name) {
+    if(!name) name = "";
+
+    uint64_t hash = appconfig_index_hash(name);
+
+    spinlock_lock(&sect->index_spinlock);
+    SIMPLE_HASHTABLE_SLOT_CONFIG_OPTIONS *sl = simple_hashtable_get_slot_CONFIG_OPTIONS(&sect->values_index, hash, name, false);
+    struct config_option *opt = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+    spinlock_unlock(&sect->index_spinlock);
+
+    return opt;
 }
 
-struct config_option *appconfig_option_find(struct config_section *sect, const char *name) {
-    struct config_option opt_tmp = {
-        .name = string_strdupz(name),
-    };
+// returns the option already indexed with the same name, or the one given
+struct config_option *appconfig_option_add(struct config_section *sect, struct config_option *opt) {
+    const char *name = string2str(opt->name);
+    uint64_t hash = appconfig_index_hash(name);
+
+    spinlock_lock(&sect->index_spinlock);
+    SIMPLE_HASHTABLE_SLOT_CONFIG_OPTIONS *sl = simple_hashtable_get_slot_CONFIG_OPTIONS(&sect->values_index, hash, name, true);
+    struct config_option *found = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+    if(!found) {
+        simple_hashtable_set_slot_CONFIG_OPTIONS(&sect->values_index, sl, hash, opt);
+        found = opt;
+    }
+    spinlock_unlock(&sect->index_spinlock);
+
+    return found;
+}
+
+// returns the option indexed with the name of the one given, removing it only when it is the same
+struct config_option *appconfig_option_del(struct config_section *sect, struct config_option *opt) {
+    const char *name = string2str(opt->name);
+    uint64_t hash = appconfig_index_hash(name);
 
-    struct config_option *rc = (struct config_option *)avl_search_lock(&(sect->values_index), (avl_t *) &opt_tmp);
+    spinlock_lock(&sect->index_spinlock);
+    SIMPLE_HASHTABLE_SLOT_CONFIG_OPTIONS *sl = simple_hashtable_get_slot_CONFIG_OPTIONS(&sect->values_index, hash, name, false);
+    struct config_option *found = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+    if(found == opt)
+        simple_hashtable_del_slot_CONFIG_OPTIONS(&sect->values_index, sl);
+    spinlock_unlock(&sect->index_spinlock);
 
-    appconfig_option_cleanup(&opt_tmp);
-    return rc;
+    return found;
 }
 
 // ----------------------------------------------------------------------------
@@ -144,7 +172,7 @@ struct config_option *appconfig_get_raw_value_of_option_in_section(struct config
 struct config_option *appconfig_get_raw_value(struct config *root, const char *section, const char *option, const char *default_value, CONFIG_VALUE_TYPES type, reformat_t cb) {
     struct config_section *sect = appconfig_section_find(root, section);
     if(!sect) {
-        if(!default_value) return NULL;
+        if(!default_value || root->lazy_sections) return NULL;
         sect = appconfig_section_create(root, section);
     }
 
@@ -5,27 +5,80 @@
 // ----------------------------------------------------------------------------
 // config sections index
 
-int appconfig_section_compare(void *a, void *b) {
-    if(((struct config_section *)a)->name < ((struct config_section *)b)->name) return -1;
-    else if(((struct config_section *)a)->name > ((struct config_section *)b)->name) return 1;
-    else return string_cmp(((struct config_section *)a)->name, ((struct config_section *)b)->name);
+static struct config_sections_index *appconfig_sections_index(struct config *root) {
+    struct config_sections_index *idx = __atomic_load_n(&root->index, __ATOMIC_ACQUIRE);
+    if(likely(idx))
+        return idx;
+
+    // the index is created on first use, so that APPCONFIG_INITIALIZER can stay static
+    idx = callocz(1, sizeof(*idx));
+    spinlock_init(&idx->spinlock);
+    simple_hashtable_init_CONFIG_SECTIONS(&idx->hashtable, 32);
+
+    struct config_sections_index *expected = NULL;
+    if(!__atomic_compare_exchange_n(&root->index, &expected, idx, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // another thread created it
+        simple_hashtable_destroy_CONFIG_SECTIONS(&idx->hashtable);
+        freez(idx);
+        idx = expected;
+    }
+
+    return idx;
 }
 
 struct config_section *appconfig_section_find(struct config *root, const char *name) {
-    struct config_section sect_tmp = {
-        .name = string_strdupz(name),
-    };
+    if(!name) name = "";
+
+    struct config_sections_index *idx = appconfig_sections_index(root);
+    uint64_t hash = appconfig_index_hash(name);
+
+    spinlock_lock(&idx->spinlock);
+    SIMPLE_HASHTABLE_SLOT_CONFIG_SECTIONS *sl = simple_hashtable_get_slot_CONFIG_SECTIONS(&idx->hashtable, hash, name, false);
+    struct config_section *sect = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+    spinlock_unlock(&idx->spinlock);
+
+    return sect;
+}
+
+// returns the section already indexed with the same name, or the one given
+struct config_section *appconfig_section_add(struct config *root, struct config_section *sect) {
+    struct config_sections_index *idx = appconfig_sections_index(root);
+    const char *name = string2str(sect->name);
+    uint64_t hash = appconfig_index_hash(name);
+
+    spinlock_lock(&idx->spinlock);
+    SIMPLE_HASHTABLE_SLOT_CONFIG_SECTIONS *sl = simple_hashtable_get_slot_CONFIG_SECTIONS(&idx->hashtable, hash, name, true);
+    struct config_section *found = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+    if(!found) {
+        simple_hashtable_set_slot_CONFIG_SECTIONS(&idx->hashtable, sl, hash, sect);
+        found = sect;
+    }
+    spinlock_unlock(&idx->spinlock);
+
+    return found;
+}
+
+// returns the section indexed with the name of the one given, removing it only when it is the same
+struct config_section *appconfig_section_del(struct config *root, struct config_section *sect) {
+    struct config_sections_index *idx = appconfig_sections_index(root);
+    const char *name = string2str(sect->name);
+    uint64_t hash = appconfig_index_hash(name);
+
+    spinlock_lock(&idx->spinlock);
+    SIMPLE_HASHTABLE_SLOT_CONFIG_SECTIONS *sl = simple_hashtable_get_slot_CONFIG_SECTIONS(&idx->hashtable, hash, name, false);
+    struct config_section *found = SIMPLE_HASHTABLE_SLOT_DATA(sl);
+    if(found == sect)
+        simple_hashtable_del_slot_CONFIG_SECTIONS(&idx->hashtable, sl);
+    spinlock_unlock(&idx->spinlock);
 
-    struct config_section *rc = (struct config_section *)avl_search_lock(&root->index, (avl_t *) &sect_tmp);
-    string_freez(sect_tmp.name);
-    return rc;
+    return found;
 }
 
 // ----------------------------------------------------------------------------
 // config section methods
 
 void appconfig_section_free(struct config_section *sect) {
-    avl_destroy_lock(&sect->values_index);
+    simple_hashtable_destroy_CONFIG_OPTIONS(&sect->values_index);
     string_freez(sect->name);
     freez(sect);
 }
@@ -61,7 +114,8 @@ struct config_section *appconfig_section_create(struct config *root, const char
     sect->name = string_strdupz(section);
     spinlock_init(&sect->spinlock);
 
-    avl_init_lock(&sect->values_index, appconfig_option_compare);
+    spinlock_init(&sect->index_spinlock);
+    simple_hashtable_init_CONFIG_OPTIONS(&sect->values_index, 16);
 
     struct config_section *sect_found = appconfig_section_add(root, sect);
     if(sect_found != sect) {
@@ -60,16 +60,66 @@ size_t rfc3339_datetime_ut(char *buffer, size_t len, usec_t now_ut, size_t fract
     return used_length;
 }
 
+// days since 1970-01-01 of a proleptic gregorian date
+static inline int64_t rfc3339_days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static inline bool rfc3339_digits(const char *s, size_t digits, unsigned *value) {
+    unsigned v = 0;
+    for(size_t i = 0; i < digits ; i++) {
+        unsigned d = (unsigned)(uint8_t)s[i] - '0';
+        if(d > 9)
+            return false;
+        v = v * 10 + d;
+    }
+    *value = v;
+    return true;
+}
+
+// the fixed layout YYYY-MM-DDTHH:MM:SS, that all RFC 3339 timestamps have
+static inline const char *rfc3339_parse_fixed(const char *s, time_t *epoch_s) {
+    unsigned year, month, day, hour, min, sec;
+
+    if(!rfc3339_digits(&s[0], 4, &year) || s[4] != '-' ||
+        !rfc3339_digits(&s[5], 2, &month) || s[7] != '-' ||
+        !rfc3339_digits(&s[8], 2, &day) || (s[10] != 'T' && s[10] != 't' && s[10] != ' ') ||
+        !rfc3339_digits(&s[11], 2, &hour) || s[13] != ':' ||
+        !rfc3339_digits(&s[14], 2, &min) || s[16] != ':' ||
+        !rfc3339_digits(&s[17], 2, &sec))
+        return NULL;
+
+    if(month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || min > 59 || sec > 60)
+        return NULL;
+
+    *epoch_s = (time_t)(rfc3339_days_from_civil(year, month, day) * 86400 + hour * 3600 + min * 60 + sec);
+    return &s[19];
+}
+
 usec_t rfc3339_parse_ut(const char *rfc3339, char **endptr) {
-    struct tm tm = { 0 };
     int tz_hours = 0, tz_mins = 0;
     char *s;
+    time_t epoch_s;
     usec_t timestamp, usec = 0;
 
-    // Use strptime to parse up to seconds
-    s = strptime(rfc3339, "%Y-%m-%dT%H:%M:%S", &tm);
-    if (!s)
-        return 0; // Parsing error
+    s = (char *)rfc3339_parse_fixed(rfc3339, &epoch_s);
+    if(!s) {
+        // not zero padded, use strptime to parse up to seconds
+        struct tm tm = { 0 };
+        s = strptime(rfc3339, "%Y-%m-%dT%H:%M:%S", &tm);
+        if (!s)
+            return 0; // Parsing error
+
+        // the fields are UTC, the timezone is applied below
+        epoch_s = timegm(&tm);
+        if (epoch_s == -1)
+            return 0; // Error in time conversion
+    }
 
     // Parse fractional seconds if present
     if (*s == '.') {
@@ -115,16 +165,11 @@ usec_t rfc3339_parse_ut(const char *rfc3339, char **endptr) {
 
         s += 6; // Move past the timezone part
     }
-    else if (*s == 'Z')
+    else if (*s == 'Z' || *s == 'z')
         s++;
     else
         return 0; // Invalid RFC 3339 format
 
-    // Convert to time_t (assuming local time, then adjusting for timezone later)
-    time_t epoch_s = mktime(&tm);
-    if (epoch_s == -1)
-        return 0; // Error in time conversion
-
     timestamp = (usec_t)epoch_s * USEC_PER_SEC + usec;
     timestamp -= tz_offset * USEC_PER_SEC;
 
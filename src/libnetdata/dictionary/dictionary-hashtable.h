@@ -24,28 +24,23 @@ static inline void *item_to_key(DICTIONARY_ITEM *item) {
 #define SIMPLE_HASHTABLE_COMPARE_KEYS_FUNCTION compare_keys
 #include "..//simple_hashtable.h"
 
-static inline size_t hashtable_init_hashtable(DICTIONARY *dict) {
+static inline SIMPLE_HASHTABLE_DICTIONARY *hashtable_create_ht(void) {
     SIMPLE_HASHTABLE_DICTIONARY *ht = callocz(1, sizeof(*ht));
     simple_hashtable_init_DICTIONARY(ht, 4);
-    dict->index.JudyHSArray = ht;
-    return 0;
+    return ht;
 }
 
-static inline size_t hashtable_destroy_hashtable(DICTIONARY *dict) {
-    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
+static inline size_t hashtable_destroy_ht(SIMPLE_HASHTABLE_DICTIONARY *ht) {
     if(unlikely(!ht)) return 0;
 
     size_t mem = sizeof(*ht) + ht->size * sizeof(SIMPLE_HASHTABLE_SLOT_DICTIONARY);
     simple_hashtable_destroy_DICTIONARY(ht);
     freez(ht);
-    dict->index.JudyHSArray = NULL;
 
     return mem;
 }
 
-static inline void *hashtable_insert_hashtable(DICTIONARY *dict, const char *name, size_t name_len) {
-    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
-
+static inline void *hashtable_insert_ht(SIMPLE_HASHTABLE_DICTIONARY *ht, const char *name, size_t name_len) {
     char key[name_len+1];
     memcpy(key, name, name_len);
     key[name_len] = '\0';
@@ -63,16 +58,12 @@ static inline DICTIONARY_ITEM *hashtable_insert_handle_to_item_hashtable(DICTION
     return item;
 }
 
-static inline void hashtable_set_item_hashtable(DICTIONARY *dict, void *handle, DICTIONARY_ITEM *item) {
-    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
+static inline void hashtable_set_item_ht(SIMPLE_HASHTABLE_DICTIONARY *ht, void *handle, DICTIONARY_ITEM *item) {
     SIMPLE_HASHTABLE_SLOT_DICTIONARY *sl = handle;
     simple_hashtable_set_slot_DICTIONARY(ht, sl, sl->hash, item);
 }
 
-static inline int hashtable_delete_hashtable(DICTIONARY *dict, const char *name, size_t name_len, DICTIONARY_ITEM *item_to_delete) {
-    (void)item_to_delete;
-    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
-
+static inline int hashtable_delete_ht(SIMPLE_HASHTABLE_DICTIONARY *ht, const char *name, size_t name_len) {
     char key[name_len+1];
     memcpy(key, name, name_len);
     key[name_len] = '\0';
@@ -86,8 +77,7 @@ static inline int hashtable_delete_hashtable(DICTIONARY *dict, const char *name,
     return 1; // return deleted
 }
 
-static inline DICTIONARY_ITEM *hashtable_get_hashtable(DICTIONARY *dict, const char *name, size_t name_len) {
-    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
+static inline DICTIONARY_ITEM *hashtable_get_ht(SIMPLE_HASHTABLE_DICTIONARY *ht, const char *name, size_t name_len) {
     if(unlikely(!ht)) return NULL;
 
     char key[name_len+1];
@@ -99,6 +89,85 @@ static inline DICTIONARY_ITEM *hashtable_get_hashtable(DICTIONARY *dict, const c
     return SIMPLE_HASHTABLE_SLOT_DATA(sl);
 }
 
+static inline size_t hashtable_init_hashtable(DICTIONARY *dict) {
+    dict->index.JudyHSArray = hashtable_create_ht();
+    return 0;
+}
+
+static inline size_t hashtable_destroy_hashtable(DICTIONARY *dict) {
+    size_t mem = hashtable_destroy_ht(dict->index.JudyHSArray);
+    dict->index.JudyHSArray = NULL;
+    return mem;
+}
+
+static inline void *hashtable_insert_hashtable(DICTIONARY *dict, const char *name, size_t name_len) {
+    return hashtable_insert_ht(dict->index.JudyHSArray, name, name_len);
+}
+
+static inline void hashtable_set_item_hashtable(DICTIONARY *dict, void *handle, DICTIONARY_ITEM *item) {
+    hashtable_set_item_ht(dict->index.JudyHSArray, handle, item);
+}
+
+static inline int hashtable_delete_hashtable(DICTIONARY *dict, const char *name, size_t name_len, DICTIONARY_ITEM *item_to_delete) {
+    (void)item_to_delete;
+    return hashtable_delete_ht(dict->index.JudyHSArray, name, name_len);
+}
+
+static inline DICTIONARY_ITEM *hashtable_get_hashtable(DICTIONARY *dict, const char *name, size_t name_len) {
+    return hashtable_get_ht(dict->index.JudyHSArray, name, name_len);
+}
+
+// ----------------------------------------------------------------------------
+// hashtable operations with a simple hashtable per stripe
+// the caller has locked the stripe of the key (or all of them)
+
+static inline SIMPLE_HASHTABLE_DICTIONARY *hashtable_stripe_ht(DICTIONARY *dict, const char *name, size_t name_len) {
+    return dictionary_index_stripe(dict, name, name_len)->ht;
+}
+
+static inline size_t hashtable_init_concurrent(DICTIONARY *dict) {
+    dict->index.stripes = callocz(DICTIONARY_INDEX_STRIPES, sizeof(struct dictionary_index_stripe));
+
+    for(size_t i = 0; i < DICTIONARY_INDEX_STRIPES ;i++) {
+        rw_spinlock_init(&dict->index.stripes[i].rw_spinlock);
+        dict->index.stripes[i].ht = hashtable_create_ht();
+    }
+
+    return DICTIONARY_INDEX_STRIPES * sizeof(struct dictionary_index_stripe);
+}
+
+static inline size_t hashtable_destroy_concurrent(DICTIONARY *dict) {
+    if(unlikely(!dict->index.stripes)) return 0;
+
+    size_t mem = DICTIONARY_INDEX_STRIPES * sizeof(struct dictionary_index_stripe);
+    for(size_t i = 0; i < DICTIONARY_INDEX_STRIPES ;i++) {
+        mem += hashtable_destroy_ht(dict->index.stripes[i].ht);
+        dict->index.stripes[i].ht = NULL;
+    }
+
+    // the stripes are freed with the dictionary, because their locks are still held by the caller
+    return mem;
+}
+
+static inline void *hashtable_insert_concurrent(DICTIONARY *dict, const char *name, size_t name_len) {
+    return hashtable_insert_ht(hashtable_stripe_ht(dict, name, name_len), name, name_len);
+}
+
+static inline void hashtable_set_item_concurrent(DICTIONARY *dict, void *handle, DICTIONARY_ITEM *item) {
+    // the handle is a slot of the simple hashtable, so find the stripe by the name of the item
+    hashtable_set_item_ht(hashtable_stripe_ht(dict, item_get_name(item), item->key_len), handle, item);
+}
+
+static inline int hashtable_delete_concurrent(DICTIONARY *dict, const char *name, size_t name_len, DICTIONARY_ITEM *item_to_delete) {
+    (void)item_to_delete;
+    return hashtable_delete_ht(hashtable_stripe_ht(dict, name, name_len), name, name_len);
+}
+
+static inline DICTIONARY_ITEM *hashtable_get_concurrent(DICTIONARY *dict, const char *name, size_t name_len) {
+    if(unlikely(!dict->index.stripes)) return NULL;
+    return hashtable_get_ht(hashtable_stripe_ht(dict, name, name_len), name, name_len);
+}
+
 // ----------------------------------------------------------------------------
 // hashtable operations with Judy
 
@@ -201,7 +270,9 @@ static inline DICTIONARY_ITEM *hashtable_get_judy(DICTIONARY *dict, const char *
 // select the right hashtable
 
 static inline size_t hashtable_init_unsafe(DICTIONARY *dict) {
-    if(dict->options & DICT_OPTION_INDEX_JUDY)
+    if(is_dictionary_concurrent(dict))
+        return hashtable_init_concurrent(dict);
+    else if(dict->options & DICT_OPTION_INDEX_JUDY)
         return hashtable_init_judy(dict);
     else
         return hashtable_init_hashtable(dict);
@@ -210,14 +281,18 @@ static inline size_t hashtable_init_unsafe(DICTIONARY *dict) {
 static inline size_t hashtable_destroy_unsafe(DICTIONARY *dict) {
     pointer_destroy_index(dict);
 
-    if(dict->options & DICT_OPTION_INDEX_JUDY)
+    if(is_dictionary_concurrent(dict))
+        return hashtable_destroy_concurrent(dict);
+    else if(dict->options & DICT_OPTION_INDEX_JUDY)
         return hashtable_destroy_judy(dict);
     else
         return hashtable_destroy_hashtable(dict);
 }
 
 static inline void *hashtable_insert_unsafe(DICTIONARY *dict, const char *name, size_t name_len) {
-    if(dict->options & DICT_OPTION_INDEX_JUDY)
+    if(is_dictionary_concurrent(dict))
+        return hashtable_insert_concurrent(dict, name, name_len);
+    else if(dict->options & DICT_OPTION_INDEX_JUDY)
         return hashtable_insert_judy(dict, name, name_len);
     else
         return hashtable_insert_hashtable(dict, name, name_len);
@@ -231,7 +306,9 @@ static inline DICTIONARY_ITEM *hashtable_insert_handle_to_item_unsafe(DICTIONARY
 }
 
 static inline int hashtable_delete_unsafe(DICTIONARY *dict, const char *name, size_t name_len, DICTIONARY_ITEM *item) {
-    if(dict->options & DICT_OPTION_INDEX_JUDY)
+    if(is_dictionary_concurrent(dict))
+        return hashtable_delete_concurrent(dict, name, name_len, item);
+    else if(dict->options & DICT_OPTION_INDEX_JUDY)
         return hashtable_delete_judy(dict, name, name_len, item);
     else
         return hashtable_delete_hashtable(dict, name, name_len, item);
@@ -242,7 +319,9 @@ static inline DICTIONARY_ITEM *hashtable_get_unsafe(DICTIONARY *dict, const char
 
     DICTIONARY_ITEM *item;
 
-    if(dict->options & DICT_OPTION_INDEX_JUDY)
+    if(is_dictionary_concurrent(dict))
+        item = hashtable_get_concurrent(dict, name, name_len);
+    else if(dict->options & DICT_OPTION_INDEX_JUDY)
         item = hashtable_get_judy(dict, name, name_len);
     else
         item = hashtable_get_hashtable(dict, name, name_len);
@@ -254,7 +333,9 @@ static inline DICTIONARY_ITEM *hashtable_get_unsafe(DICTIONARY *dict, const char
 }
 
 static inline void hashtable_set_item_unsafe(DICTIONARY *dict, void *handle, DICTIONARY_ITEM *item) {
-    if(dict->options & DICT_OPTION_INDEX_JUDY)
+    if(is_dictionary_concurrent(dict))
+        hashtable_set_item_concurrent(dict, handle, item);
+    else if(dict->options & DICT_OPTION_INDEX_JUDY)
         hashtable_set_item_judy(dict, handle, item);
     else
         hashtable_set_item_hashtable(dict, handle, item);
@@ -21,6 +21,7 @@ typedef enum __attribute__ ((__packed__)) {
 
 // configuration options macros
 #define is_dictionary_single_threaded(dict) ((dict)->options & DICT_OPTION_SINGLE_THREADED)
+#define is_dictionary_concurrent(dict) ((dict)->options & DICT_OPTION_INDEX_CONCURRENT)
 #define is_view_dictionary(dict) ((dict)->master)
 #define is_master_dictionary(dict) (!is_view_dictionary(dict))
 
@@ -130,6 +131,17 @@ struct dictionary_hooks {
     void *delelte_callback_data;
 };
 
+// the index of DICT_OPTION_INDEX_CONCURRENT dictionaries is split into stripes
+// selected by the top bits of the hash of the key, so that lookups and
+// modifications of different keys do not queue on the same lock
+#define DICTIONARY_INDEX_STRIPES_BITS 4
+#define DICTIONARY_INDEX_STRIPES (1 << DICTIONARY_INDEX_STRIPES_BITS)
+
+struct dictionary_index_stripe {
+    RW_SPINLOCK rw_spinlock;            // protect this stripe of the index
+    void *ht;                           // the hash table of this stripe
+} __attribute__((aligned(64)));
+
 struct dictionary {
 #ifdef NETDATA_INTERNAL_CHECKS
     const char *creation_function;
@@ -147,6 +159,7 @@ struct dictionary {
     struct {                            // support for multiple indexing engines
         Pvoid_t JudyHSArray;        // the hash table
         RW_SPINLOCK rw_spinlock;        // protect the index
+        struct dictionary_index_stripe *stripes; // the stripes of the index, with DICT_OPTION_INDEX_CONCURRENT
     } index;
 
     struct {
@@ -375,12 +375,12 @@ static inline bool dict_item_del(DICTIONARY *dict, const char *name, ssize_t nam
     // item that was deleted, so we have to find it before we delete it,
     // since we need to release our structures too.
 
-    dictionary_index_lock_wrlock(dict);
+    dictionary_index_key_lock_wrlock(dict, name, name_len);
 
     int ret;
     DICTIONARY_ITEM *item = hashtable_get_unsafe(dict, name, name_len);
     if(unlikely(!item)) {
-        dictionary_index_wrlock_unlock(dict);
+        dictionary_index_key_wrlock_unlock(dict, name, name_len);
         ret = false;
     }
     else {
@@ -391,7 +391,7 @@ static inline bool dict_item_del(DICTIONARY *dict, const char *name, ssize_t nam
         else
             pointer_del(dict, item);
 
-        dictionary_index_wrlock_unlock(dict);
+        dictionary_index_key_wrlock_unlock(dict, name, name_len);
 
         dict_item_free_or_mark_deleted(dict, item);
         ret = true;
@@ -433,7 +433,7 @@ static inline DICTIONARY_ITEM *dict_item_add_or_reset_value_and_acquire(DICTIONA
     // But the caller has the option to do this on his/her own.
     // So, let's do the fastest here and let the caller decide the flow of calls.
 
-    dictionary_index_lock_wrlock(dict);
+    dictionary_index_key_lock_wrlock(dict, name, name_len);
 
     bool added_or_updated = false;
     size_t spins = 0;
@@ -453,7 +453,7 @@ static inline DICTIONARY_ITEM *dict_item_add_or_reset_value_and_acquire(DICTIONA
 
             // unlock the index lock, before we add it to the linked list
             // DON'T DO IT THE OTHER WAY AROUND - DO NOT CROSS THE LOCKS!
-            dictionary_index_wrlock_unlock(dict);
+            dictionary_index_key_wrlock_unlock(dict, name, name_len);
 
             item_linked_list_add(dict, item);
 
@@ -502,7 +502,7 @@ static inline DICTIONARY_ITEM *dict_item_add_or_reset_value_and_acquire(DICTIONA
                 }
             }
 
-            dictionary_index_wrlock_unlock(dict);
+            dictionary_index_key_wrlock_unlock(dict, name, name_len);
         }
     } while(!item);
 
@@ -538,7 +538,7 @@ static inline DICTIONARY_ITEM *dict_item_find_and_acquire(DICTIONARY *dict, cons
 
     netdata_log_debug(D_DICTIONARY, "GET dictionary entry with name '%s'.", name);
 
-    dictionary_index_lock_rdlock(dict);
+    dictionary_index_key_lock_rdlock(dict, name, name_len);
 
     DICTIONARY_ITEM *item = hashtable_get_unsafe(dict, name, name_len);
     if(unlikely(item && !item_check_and_acquire(dict, item))) {
@@ -546,7 +546,7 @@ static inline DICTIONARY_ITEM *dict_item_find_and_acquire(DICTIONARY *dict, cons
         DICTIONARY_STATS_SEARCH_IGNORES_PLUS1(dict);
     }
 
-    dictionary_index_rdlock_unlock(dict);
+    dictionary_index_key_rdlock_unlock(dict, name, name_len);
 
     return item;
 }
@@ -17,7 +17,10 @@ static inline size_t dictionary_locks_init(DICTIONARY *dict) {
     return 0;
 }
 
-static inline size_t dictionary_locks_destroy(DICTIONARY *dict __maybe_unused) {
+static inline size_t dictionary_locks_destroy(DICTIONARY *dict) {
+    // the stripes of the concurrent index carry their locks, so they are freed last
+    freez(dict->index.stripes);
+    dict->index.stripes = NULL;
     return 0;
 }
 
@@ -81,31 +84,76 @@ static inline void ll_recursive_unlock(DICTIONARY *dict, char rw) {
     }
 }
 
-static inline void dictionary_index_lock_rdlock(DICTIONARY *dict) {
+// ----------------------------------------------------------------------------
+// index locks for a single key
+// with DICT_OPTION_INDEX_CONCURRENT they lock only the stripe of the key
+
+static inline struct dictionary_index_stripe *dictionary_index_stripe(DICTIONARY *dict, const char *name, size_t name_len) {
+    XXH64_hash_t hash = XXH3_64bits(name, name_len);
+    return &dict->index.stripes[hash >> (64 - DICTIONARY_INDEX_STRIPES_BITS)];
+}
+
+static inline RW_SPINLOCK *dictionary_index_key_spinlock(DICTIONARY *dict, const char *name, size_t name_len) {
+    if(is_dictionary_concurrent(dict))
+        return &dictionary_index_stripe(dict, name, name_len)->rw_spinlock;
+
+    return &dict->index.rw_spinlock;
+}
+
+static inline void dictionary_index_key_lock_rdlock(DICTIONARY *dict, const char *name, size_t name_len) {
+    if(unlikely(is_dictionary_single_threaded(dict)))
+        return;
+
+    rw_spinlock_read_lock(dictionary_index_key_spinlock(dict, name, name_len));
+}
+
+static inline void dictionary_index_key_rdlock_unlock(DICTIONARY *dict, const char *name, size_t name_len) {
+    if(unlikely(is_dictionary_single_threaded(dict)))
+        return;
+
+    rw_spinlock_read_unlock(dictionary_index_key_spinlock(dict, name, name_len));
+}
+
+static inline void dictionary_index_key_lock_wrlock(DICTIONARY *dict, const char *name, size_t name_len) {
     if(unlikely(is_dictionary_single_threaded(dict)))
         return;
 
-    rw_spinlock_read_lock(&dict->index.rw_spinlock);
+    rw_spinlock_write_lock(dictionary_index_key_spinlock(dict, name, name_len));
 }
 
-static inline void dictionary_index_rdlock_unlock(DICTIONARY *dict) {
+static inline void dictionary_index_key_wrlock_unlock(DICTIONARY *dict, const char *name, size_t name_len) {
     if(unlikely(is_dictionary_single_threaded(dict)))
         return;
 
-    rw_spinlock_read_unlock(&dict->index.rw_spinlock);
+    rw_spinlock_write_unlock(dictionary_index_key_spinlock(dict, name, name_len));
 }
 
+// ----------------------------------------------------------------------------
+// index locks for the whole index
+// with DICT_OPTION_INDEX_CONCURRENT they lock all the stripes, always in the same order
+
 static inline void dictionary_index_lock_wrlock(DICTIONARY *dict) {
     if(unlikely(is_dictionary_single_threaded(dict)))
         return;
 
-    rw_spinlock_write_lock(&dict->index.rw_spinlock);
+    if(is_dictionary_concurrent(dict)) {
+        for(size_t i = 0; i < DICTIONARY_INDEX_STRIPES ;i++)
+            rw_spinlock_write_lock(&dict->index.stripes[i].rw_spinlock);
+    }
+    else
+        rw_spinlock_write_lock(&dict->index.rw_spinlock);
 }
+
 static inline void dictionary_index_wrlock_unlock(DICTIONARY *dict) {
     if(unlikely(is_dictionary_single_threaded(dict)))
         return;
 
-    rw_spinlock_write_unlock(&dict->index.rw_spinlock);
+    if(is_dictionary_concurrent(dict)) {
+        for(size_t i = DICTIONARY_INDEX_STRIPES; i > 0 ;i--)
+            rw_spinlock_write_unlock(&dict->index.stripes[i - 1].rw_spinlock);
+    }
+    else
+        rw_spinlock_write_unlock(&dict->index.rw_spinlock);
 }
 
 
@@ -1050,6 +1050,10 @@ int dictionary_unittest(size_t entries) {
     dict = dictionary_create(DICT_OPTION_NONE);
     dictionary_unittest_clone(dict, names, values, entries, &errors);
 
+    fprintf(stderr, "\nCreating dictionary multi threaded, concurrent index, clone, %zu items\n", entries);
+    dict = dictionary_create(DICT_OPTION_INDEX_CONCURRENT);
+    dictionary_unittest_clone(dict, names, values, entries, &errors);
+
     fprintf(stderr, "\nCreating dictionary single threaded, non-clone, add-in-front options, %zu items\n", entries);
     dict = dictionary_create(
         DICT_OPTION_SINGLE_THREADED | DICT_OPTION_NAME_LINK_DONT_CLONE | DICT_OPTION_VALUE_LINK_DONT_CLONE |
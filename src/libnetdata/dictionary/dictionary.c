@@ -205,24 +205,30 @@ void dictionary_static_items_aral_init(void) {
         spinlock_lock(&spinlock);
 
         // we have to check again
-        if(!dict_items_aral)
-            dict_items_aral = aral_create(
+        if(!dict_items_aral) {
+            ARAL *ar = aral_create(
                     "dict-items",
                     sizeof(DICTIONARY_ITEM),
                     0,
                     65536,
                     aral_by_size_statistics(),
                     NULL, NULL, false, false);
+            aral_magazines_enable(ar);
+            dict_items_aral = ar;
+        }
 
         // we have to check again
-        if(!dict_shared_items_aral)
-            dict_shared_items_aral = aral_create(
+        if(!dict_shared_items_aral) {
+            ARAL *ar = aral_create(
                     "dict-shared-items",
                     sizeof(DICTIONARY_ITEM_SHARED),
                     0,
                     65536,
                     aral_by_size_statistics(),
                     NULL, NULL, false, false);
+            aral_magazines_enable(ar);
+            dict_shared_items_aral = ar;
+        }
 
         spinlock_unlock(&spinlock);
     }
@@ -497,7 +503,7 @@ static DICTIONARY *dictionary_create_internal(DICT_OPTIONS options, struct dicti
     else
         dict->value_aral = NULL;
 
-    if(!(dict->options & (DICT_OPTION_INDEX_JUDY|DICT_OPTION_INDEX_HASHTABLE)))
+    if(!(dict->options & (DICT_OPTION_INDEX_JUDY|DICT_OPTION_INDEX_HASHTABLE|DICT_OPTION_INDEX_CONCURRENT)))
         dict->options |= DICT_OPTION_INDEX_JUDY;
 
     size_t dict_size = 0;
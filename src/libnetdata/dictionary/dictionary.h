@@ -60,6 +60,7 @@ typedef enum __attribute__((packed)) dictionary_options {
     DICT_OPTION_FIXED_SIZE              = (1 << 5), // the items of the dictionary have a fixed size
     DICT_OPTION_INDEX_JUDY              = (1 << 6), // the default, if no other indexing is set
     DICT_OPTION_INDEX_HASHTABLE         = (1 << 7), // use SIMPLE_HASHTABLE for indexing
+    DICT_OPTION_INDEX_CONCURRENT        = (1 << 8), // use SIMPLE_HASHTABLEs split into stripes, each with its own lock
 } DICT_OPTIONS;
 
 struct dictionary_stats {
@@ -36,6 +36,52 @@ typedef struct eval_node {
     EVAL_VALUE ops[];
 } EVAL_NODE;
 
+// ----------------------------------------------------------------------------
+// data structures for the compiled expression
+//
+// The tree of nodes is kept for printing and hardcoding variables, but it is
+// evaluated as a flat program for a stack machine. Sub-expressions without
+// variables are folded into constants while compiling, and every distinct
+// variable gets a slot, so that it is looked up once per evaluation, no matter
+// how many times the expression uses it.
+
+typedef enum __attribute__((packed)) {
+    EVAL_INSTRUCTION_NUMBER = 0,        // push the number
+    EVAL_INSTRUCTION_VARIABLE,          // push the value of the variable of the slot
+    EVAL_INSTRUCTION_OPERATOR,          // replace the operands at the top of the stack with the result of the operator
+    EVAL_INSTRUCTION_AND,               // if the top is false, make it 0 and jump to the target, otherwise pop it
+    EVAL_INSTRUCTION_OR,                // if the top is true, make it 1 and jump to the target, otherwise pop it
+    EVAL_INSTRUCTION_TRUTH,             // make the top 1 or 0
+    EVAL_INSTRUCTION_JUMP_IF_FALSE,     // pop the top and jump to the target if it is false
+    EVAL_INSTRUCTION_JUMP,              // jump to the target
+    EVAL_INSTRUCTION_ERROR,             // push 0 and fail with the error
+} EVAL_INSTRUCTION_TYPE;
+
+typedef struct eval_instruction {
+    EVAL_INSTRUCTION_TYPE type;
+    unsigned char operator;
+
+    union {
+        NETDATA_DOUBLE number;
+        uint32_t slot;
+        uint32_t target;
+        int error;
+    };
+} EVAL_INSTRUCTION;
+
+typedef struct eval_program {
+    EVAL_INSTRUCTION *code;
+    uint32_t used;
+    uint32_t size;
+
+    uint32_t depth;                     // the depth of the stack, while compiling
+    uint32_t max_depth;                 // the stack needed to run the program
+
+    STRING **variables;                 // the variables, indexed by slot
+    uint32_t variables_used;
+    uint32_t variables_size;
+} EVAL_PROGRAM;
+
 struct eval_expression {
     STRING *source;
     STRING *parsed_as;
@@ -46,6 +92,7 @@ struct eval_expression {
     BUFFER *error_msg;
 
     EVAL_NODE *nodes;
+    EVAL_PROGRAM program;
 
     void *variable_lookup_cb_data;
     eval_expression_variable_lookup_t variable_lookup_cb;
@@ -81,53 +128,27 @@ struct eval_expression {
 static inline void eval_node_free(EVAL_NODE *op);
 static inline EVAL_NODE *parse_full_expression(const char **string, int *error);
 static inline EVAL_NODE *parse_one_full_operand(const char **string, int *error);
-static inline NETDATA_DOUBLE eval_node(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error);
 static inline void print_parsed_as_node(BUFFER *out, EVAL_NODE *op, int *error);
 static inline void print_parsed_as_constant(BUFFER *out, NETDATA_DOUBLE n);
 
 // ----------------------------------------------------------------------------
 // evaluation of expressions
 
-static inline NETDATA_DOUBLE eval_variable(EVAL_EXPRESSION *exp, EVAL_VARIABLE *v, int *error) {
+static inline NETDATA_DOUBLE eval_variable(EVAL_EXPRESSION *exp, STRING *name, int *error) {
     NETDATA_DOUBLE n;
 
-    if(exp->variable_lookup_cb && exp->variable_lookup_cb(v->name, exp->variable_lookup_cb_data, &n)) {
-        buffer_sprintf(exp->error_msg, "[ ${%s} = ", string2str(v->name));
+    if(exp->variable_lookup_cb && exp->variable_lookup_cb(name, exp->variable_lookup_cb_data, &n)) {
+        buffer_sprintf(exp->error_msg, "[ ${%s} = ", string2str(name));
         print_parsed_as_constant(exp->error_msg, n);
         buffer_strcat(exp->error_msg, " ] ");
         return n;
     }
 
     *error = EVAL_ERROR_UNKNOWN_VARIABLE;
-    buffer_sprintf(exp->error_msg, "[ undefined variable '%s' ] ", string2str(v->name));
+    buffer_sprintf(exp->error_msg, "[ undefined variable '%s' ] ", string2str(name));
     return NAN;
 }
 
-static inline NETDATA_DOUBLE eval_value(EVAL_EXPRESSION *exp, EVAL_VALUE *v, int *error) {
-    NETDATA_DOUBLE n;
-
-    switch(v->type) {
-        case EVAL_VALUE_EXPRESSION:
-            n = eval_node(exp, v->expression, error);
-            break;
-
-        case EVAL_VALUE_NUMBER:
-            n = v->number;
-            break;
-
-        case EVAL_VALUE_VARIABLE:
-            n = eval_variable(exp, v->variable, error);
-            break;
-
-        default:
-            *error = EVAL_ERROR_INVALID_VALUE;
-            n = 0;
-            break;
-    }
-
-    return n;
-}
-
 static inline int is_true(NETDATA_DOUBLE n) {
     if(isnan(n)) return 0;
     if(isinf(n)) return 1;
@@ -135,98 +156,80 @@ static inline int is_true(NETDATA_DOUBLE n) {
     return 1;
 }
 
-NETDATA_DOUBLE eval_and(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return is_true(eval_value(exp, &op->ops[0], error)) && is_true(eval_value(exp, &op->ops[1], error));
+// the operators get their operands already evaluated, in n[]
+// AND, OR and IF-THEN-ELSE are compiled to jumps, so that they evaluate only the operands they need
+
+static NETDATA_DOUBLE eval_and(const NETDATA_DOUBLE *n) {
+    return is_true(n[0]) && is_true(n[1]);
 }
-NETDATA_DOUBLE eval_or(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return is_true(eval_value(exp, &op->ops[0], error)) || is_true(eval_value(exp, &op->ops[1], error));
+static NETDATA_DOUBLE eval_or(const NETDATA_DOUBLE *n) {
+    return is_true(n[0]) || is_true(n[1]);
 }
-NETDATA_DOUBLE eval_greater_than_or_equal(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    return isgreaterequal(n1, n2);
+static NETDATA_DOUBLE eval_greater_than_or_equal(const NETDATA_DOUBLE *n) {
+    return isgreaterequal(n[0], n[1]);
 }
-NETDATA_DOUBLE eval_less_than_or_equal(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    return islessequal(n1, n2);
+static NETDATA_DOUBLE eval_less_than_or_equal(const NETDATA_DOUBLE *n) {
+    return islessequal(n[0], n[1]);
 }
-NETDATA_DOUBLE eval_equal(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
+static NETDATA_DOUBLE eval_equal(const NETDATA_DOUBLE *n) {
+    NETDATA_DOUBLE n1 = n[0];
+    NETDATA_DOUBLE n2 = n[1];
     if(isnan(n1) && isnan(n2)) return 1;
     if(isinf(n1) && isinf(n2)) return 1;
     if(isnan(n1) || isnan(n2)) return 0;
     if(isinf(n1) || isinf(n2)) return 0;
     return considered_equal_ndd(n1, n2);
 }
-NETDATA_DOUBLE eval_not_equal(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return !eval_equal(exp, op, error);
-}
-NETDATA_DOUBLE eval_less(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    return isless(n1, n2);
-}
-NETDATA_DOUBLE eval_greater(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    return isgreater(n1, n2);
-}
-NETDATA_DOUBLE eval_plus(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) || isnan(n2)) return NAN;
-    if(isinf(n1) || isinf(n2)) return INFINITY;
-    return n1 + n2;
-}
-NETDATA_DOUBLE eval_minus(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) || isnan(n2)) return NAN;
-    if(isinf(n1) || isinf(n2)) return INFINITY;
-    return n1 - n2;
-}
-NETDATA_DOUBLE eval_multiply(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) || isnan(n2)) return NAN;
-    if(isinf(n1) || isinf(n2)) return INFINITY;
-    return n1 * n2;
-}
-NETDATA_DOUBLE eval_divide(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) || isnan(n2)) return NAN;
-    if(isinf(n1) || isinf(n2)) return INFINITY;
-    return n1 / n2;
-}
-NETDATA_DOUBLE eval_nop(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return eval_value(exp, &op->ops[0], error);
-}
-NETDATA_DOUBLE eval_not(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return !is_true(eval_value(exp, &op->ops[0], error));
-}
-NETDATA_DOUBLE eval_sign_plus(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return eval_value(exp, &op->ops[0], error);
-}
-NETDATA_DOUBLE eval_sign_minus(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    if(isnan(n1)) return NAN;
-    if(isinf(n1)) return INFINITY;
-    return -n1;
-}
-NETDATA_DOUBLE eval_abs(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    if(isnan(n1)) return NAN;
-    if(isinf(n1)) return INFINITY;
-    return ABS(n1);
-}
-NETDATA_DOUBLE eval_if_then_else(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    if(is_true(eval_value(exp, &op->ops[0], error)))
-        return eval_value(exp, &op->ops[1], error);
-    else
-        return eval_value(exp, &op->ops[2], error);
+static NETDATA_DOUBLE eval_not_equal(const NETDATA_DOUBLE *n) {
+    return !eval_equal(n);
+}
+static NETDATA_DOUBLE eval_less(const NETDATA_DOUBLE *n) {
+    return isless(n[0], n[1]);
+}
+static NETDATA_DOUBLE eval_greater(const NETDATA_DOUBLE *n) {
+    return isgreater(n[0], n[1]);
+}
+static NETDATA_DOUBLE eval_plus(const NETDATA_DOUBLE *n) {
+    if(isnan(n[0]) || isnan(n[1])) return NAN;
+    if(isinf(n[0]) || isinf(n[1])) return INFINITY;
+    return n[0] + n[1];
+}
+static NETDATA_DOUBLE eval_minus(const NETDATA_DOUBLE *n) {
+    if(isnan(n[0]) || isnan(n[1])) return NAN;
+    if(isinf(n[0]) || isinf(n[1])) return INFINITY;
+    return n[0] - n[1];
+}
+static NETDATA_DOUBLE eval_multiply(const NETDATA_DOUBLE *n) {
+    if(isnan(n[0]) || isnan(n[1])) return NAN;
+    if(isinf(n[0]) || isinf(n[1])) return INFINITY;
+    return n[0] * n[1];
+}
+static NETDATA_DOUBLE eval_divide(const NETDATA_DOUBLE *n) {
+    if(isnan(n[0]) || isnan(n[1])) return NAN;
+    if(isinf(n[0]) || isinf(n[1])) return INFINITY;
+    return n[0] / n[1];
+}
+static NETDATA_DOUBLE eval_nop(const NETDATA_DOUBLE *n) {
+    return n[0];
+}
+static NETDATA_DOUBLE eval_not(const NETDATA_DOUBLE *n) {
+    return !is_true(n[0]);
+}
+static NETDATA_DOUBLE eval_sign_plus(const NETDATA_DOUBLE *n) {
+    return n[0];
+}
+static NETDATA_DOUBLE eval_sign_minus(const NETDATA_DOUBLE *n) {
+    if(isnan(n[0])) return NAN;
+    if(isinf(n[0])) return INFINITY;
+    return -n[0];
+}
+static NETDATA_DOUBLE eval_abs(const NETDATA_DOUBLE *n) {
+    if(isnan(n[0])) return NAN;
+    if(isinf(n[0])) return INFINITY;
+    return ABS(n[0]);
+}
+static NETDATA_DOUBLE eval_if_then_else(const NETDATA_DOUBLE *n) {
+    return is_true(n[0]) ? n[1] : n[2];
 }
 
 static struct operator {
@@ -234,7 +237,7 @@ static struct operator {
     char precedence;
     char parameters;
     char isfunction;
-    NETDATA_DOUBLE (*eval)(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error);
+    NETDATA_DOUBLE (*eval)(const NETDATA_DOUBLE *n);
 } operators[256] = {
         // this is a random access array
         // we always access it with a known EVAL_OPERATOR_X
@@ -265,15 +268,269 @@ static struct operator {
 
 #define eval_precedence(operator) (operators[(unsigned char)(operator)].precedence)
 
-static inline NETDATA_DOUBLE eval_node(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
+// ----------------------------------------------------------------------------
+// compiling the tree of nodes to a program
+
+static uint32_t eval_program_emit(EVAL_PROGRAM *p, EVAL_INSTRUCTION_TYPE type, unsigned char operator) {
+    if(p->used == p->size) {
+        p->size = p->size ? p->size * 2 : 16;
+        p->code = reallocz(p->code, p->size * sizeof(EVAL_INSTRUCTION));
+    }
+
+    uint32_t pc = p->used++;
+    p->code[pc] = (EVAL_INSTRUCTION){
+        .type = type,
+        .operator = operator,
+    };
+    return pc;
+}
+
+static inline void eval_program_push(EVAL_PROGRAM *p) {
+    if(++p->depth > p->max_depth)
+        p->max_depth = p->depth;
+}
+
+static uint32_t eval_program_variable_slot(EVAL_PROGRAM *p, STRING *name) {
+    for(uint32_t i = 0; i < p->variables_used ; i++)
+        if(p->variables[i] == name)
+            return i;
+
+    if(p->variables_used == p->variables_size) {
+        p->variables_size = p->variables_size ? p->variables_size * 2 : 4;
+        p->variables = reallocz(p->variables, p->variables_size * sizeof(STRING *));
+    }
+
+    p->variables[p->variables_used] = string_dup(name);
+    return p->variables_used++;
+}
+
+static void eval_program_free(EVAL_PROGRAM *p) {
+    for(uint32_t i = 0; i < p->variables_used ; i++)
+        string_freez(p->variables[i]);
+
+    freez(p->variables);
+    freez(p->code);
+    memset(p, 0, sizeof(*p));
+}
+
+static NETDATA_DOUBLE eval_program_run(EVAL_PROGRAM *p, EVAL_EXPRESSION *exp, int *error);
+static void eval_compile_node(EVAL_PROGRAM *p, EVAL_NODE *op, bool fold);
+
+static inline void eval_compile_error(EVAL_PROGRAM *p, int error) {
+    uint32_t pc = eval_program_emit(p, EVAL_INSTRUCTION_ERROR, EVAL_OPERATOR_NOP);
+    p->code[pc].error = error;
+    eval_program_push(p);
+}
+
+static bool eval_node_is_constant(EVAL_NODE *op) {
+    if(op->count != operators[op->operator].parameters)
+        return false;
+
+    for(int i = 0; i < op->count ; i++) {
+        switch(op->ops[i].type) {
+            case EVAL_VALUE_NUMBER:
+                break;
+
+            case EVAL_VALUE_EXPRESSION:
+                if(!eval_node_is_constant(op->ops[i].expression))
+                    return false;
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void eval_compile_value(EVAL_PROGRAM *p, EVAL_VALUE *v, bool fold) {
+    uint32_t pc;
+
+    switch(v->type) {
+        case EVAL_VALUE_EXPRESSION:
+            eval_compile_node(p, v->expression, fold);
+            break;
+
+        case EVAL_VALUE_NUMBER:
+            pc = eval_program_emit(p, EVAL_INSTRUCTION_NUMBER, EVAL_OPERATOR_NOP);
+            p->code[pc].number = v->number;
+            eval_program_push(p);
+            break;
+
+        case EVAL_VALUE_VARIABLE:
+            pc = eval_program_emit(p, EVAL_INSTRUCTION_VARIABLE, EVAL_OPERATOR_NOP);
+            p->code[pc].slot = eval_program_variable_slot(p, v->variable->name);
+            eval_program_push(p);
+            break;
+
+        default:
+            eval_compile_error(p, EVAL_ERROR_INVALID_VALUE);
+            break;
+    }
+}
+
+static void eval_compile_node(EVAL_PROGRAM *p, EVAL_NODE *op, bool fold) {
     if(unlikely(op->count != operators[op->operator].parameters)) {
-        *error = EVAL_ERROR_INVALID_NUMBER_OF_OPERANDS;
+        eval_compile_error(p, EVAL_ERROR_INVALID_NUMBER_OF_OPERANDS);
+        return;
+    }
+
+    if(fold && eval_node_is_constant(op)) {
+        // run the sub-expression now and keep only its result
+        EVAL_PROGRAM constant = { 0 };
+        eval_compile_node(&constant, op, false);
+
+        int error = EVAL_ERROR_OK;
+        NETDATA_DOUBLE n = eval_program_run(&constant, NULL, &error);
+        eval_program_free(&constant);
+
+        if(error == EVAL_ERROR_OK) {
+            uint32_t pc = eval_program_emit(p, EVAL_INSTRUCTION_NUMBER, EVAL_OPERATOR_NOP);
+            p->code[pc].number = n;
+            eval_program_push(p);
+            return;
+        }
+    }
+
+    uint32_t pc;
+    switch(op->operator) {
+        case EVAL_OPERATOR_NOP:
+        case EVAL_OPERATOR_EXPRESSION_OPEN:
+        case EVAL_OPERATOR_EXPRESSION_CLOSE:
+        case EVAL_OPERATOR_SIGN_PLUS:
+            eval_compile_value(p, &op->ops[0], fold);
+            break;
+
+        case EVAL_OPERATOR_AND:
+        case EVAL_OPERATOR_OR:
+            eval_compile_value(p, &op->ops[0], fold);
+            pc = eval_program_emit(p, op->operator == EVAL_OPERATOR_AND ? EVAL_INSTRUCTION_AND : EVAL_INSTRUCTION_OR, op->operator);
+            p->depth--;
+            eval_compile_value(p, &op->ops[1], fold);
+            eval_program_emit(p, EVAL_INSTRUCTION_TRUTH, op->operator);
+            p->code[pc].target = p->used;
+            break;
+
+        case EVAL_OPERATOR_IF_THEN_ELSE: {
+            eval_compile_value(p, &op->ops[0], fold);
+            uint32_t jump_to_else = eval_program_emit(p, EVAL_INSTRUCTION_JUMP_IF_FALSE, op->operator);
+            p->depth--;
+
+            eval_compile_value(p, &op->ops[1], fold);
+            uint32_t jump_to_end = eval_program_emit(p, EVAL_INSTRUCTION_JUMP, op->operator);
+            p->depth--;
+
+            p->code[jump_to_else].target = p->used;
+            eval_compile_value(p, &op->ops[2], fold);
+            p->code[jump_to_end].target = p->used;
+            break;
+        }
+
+        default:
+            for(int i = 0; i < op->count ; i++)
+                eval_compile_value(p, &op->ops[i], fold);
+
+            eval_program_emit(p, EVAL_INSTRUCTION_OPERATOR, op->operator);
+            p->depth -= op->count - 1;
+            break;
+    }
+}
+
+static void expression_compile(EVAL_EXPRESSION *exp) {
+    eval_program_free(&exp->program);
+    eval_compile_node(&exp->program, exp->nodes, true);
+}
+
+// ----------------------------------------------------------------------------
+// running the program
+
+static NETDATA_DOUBLE eval_program_run(EVAL_PROGRAM *p, EVAL_EXPRESSION *exp, int *error) {
+    if(unlikely(!p->used)) {
+        *error = EVAL_ERROR_INVALID_VALUE;
         return 0;
     }
 
-    NETDATA_DOUBLE n = operators[op->operator].eval(exp, op, error);
+    NETDATA_DOUBLE stack[p->max_depth];
+    uint32_t sp = 0;
+
+    // the values of the variables, looked up the first time they are used
+    NETDATA_DOUBLE values[p->variables_used + 1];
+    bool resolved[p->variables_used + 1];
+    memset(resolved, 0, sizeof(resolved));
+
+    uint32_t pc = 0;
+    while(pc < p->used) {
+        EVAL_INSTRUCTION *i = &p->code[pc++];
 
-    return n;
+        switch(i->type) {
+            case EVAL_INSTRUCTION_NUMBER:
+                stack[sp++] = i->number;
+                break;
+
+            case EVAL_INSTRUCTION_VARIABLE:
+                if(!resolved[i->slot]) {
+                    if(likely(exp))
+                        values[i->slot] = eval_variable(exp, p->variables[i->slot], error);
+                    else {
+                        values[i->slot] = NAN;
+                        *error = EVAL_ERROR_UNKNOWN_VARIABLE;
+                    }
+                    resolved[i->slot] = true;
+                }
+                stack[sp++] = values[i->slot];
+                break;
+
+            case EVAL_INSTRUCTION_OPERATOR:
+                sp -= operators[i->operator].parameters;
+                stack[sp] = operators[i->operator].eval(&stack[sp]);
+                sp++;
+                break;
+
+            case EVAL_INSTRUCTION_AND:
+                if(!is_true(stack[sp - 1])) {
+                    stack[sp - 1] = 0;
+                    pc = i->target;
+                }
+                else
+                    sp--;
+                break;
+
+            case EVAL_INSTRUCTION_OR:
+                if(is_true(stack[sp - 1])) {
+                    stack[sp - 1] = 1;
+                    pc = i->target;
+                }
+                else
+                    sp--;
+                break;
+
+            case EVAL_INSTRUCTION_TRUTH:
+                stack[sp - 1] = is_true(stack[sp - 1]);
+                break;
+
+            case EVAL_INSTRUCTION_JUMP_IF_FALSE:
+                if(!is_true(stack[--sp]))
+                    pc = i->target;
+                break;
+
+            case EVAL_INSTRUCTION_JUMP:
+                pc = i->target;
+                break;
+
+            case EVAL_INSTRUCTION_ERROR:
+                *error = i->error;
+                stack[sp++] = 0;
+                break;
+        }
+    }
+
+    if(unlikely(sp != 1)) {
+        *error = EVAL_ERROR_INVALID_VALUE;
+        return 0;
+    }
+
+    return stack[0];
 }
 
 // ----------------------------------------------------------------------------
@@ -1022,7 +1279,7 @@ int expression_evaluate(EVAL_EXPRESSION *expression) {
     expression->error = EVAL_ERROR_OK;
 
     buffer_reset(expression->error_msg);
-    expression->result = eval_node(expression, expression->nodes, &expression->error);
+    expression->result = eval_program_run(&expression->program, expression, &expression->error);
 
     if(unlikely(isnan(expression->result))) {
         if(expression->error == EVAL_ERROR_OK)
@@ -1094,6 +1351,7 @@ EVAL_EXPRESSION *expression_parse(const char *string, const char **failed_at, in
 
     exp->error_msg = buffer_create(100, NULL);
     exp->nodes = op;
+    expression_compile(exp);
 
     return exp;
 }
@@ -1102,6 +1360,7 @@ void expression_free(EVAL_EXPRESSION *expression) {
     if(!expression) return;
 
     if(expression->nodes) eval_node_free(expression->nodes);
+    eval_program_free(&expression->program);
     string_freez((void *)expression->source);
     string_freez((void *)expression->parsed_as);
     buffer_free(expression->error_msg);
@@ -1221,6 +1480,9 @@ void expression_hardcode_variable(EVAL_EXPRESSION *expression, STRING *variable,
 
     size_t matches = expression_hardcode_node_variable(expression->nodes, variable, value);
     if (matches) {
+        // the variable is now a constant, so more can be folded
+        expression_compile(expression);
+
         char replace[1024];
         snprintfz(replace, sizeof(replace), NETDATA_DOUBLE_FORMAT_AUTO, value);
         size_t replace_len = strlen(replace);
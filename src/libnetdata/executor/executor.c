@@ -0,0 +1,412 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "executor.h"
+
+#define ND_EXECUTOR_WORKER_NAME "EXECUTOR"
+#define ND_EXECUTOR_PARK_TIMEOUT_MS 100
+
+typedef struct nd_executor_job {
+    ND_EXECUTOR_SUBSYSTEM *ss;
+    nd_executor_cb cb;
+    void *data;
+
+    struct nd_executor_job *prev, *next;
+} ND_EXECUTOR_JOB;
+
+struct nd_executor_subsystem {
+    char name[32];
+    size_t id;                              // the worker job type of this subsystem
+    ND_EXECUTOR_PRIORITY priority;
+    size_t max_concurrency;                 // 0 = all the threads
+
+    size_t queued;                          // atomic - jobs waiting in the queues
+    size_t running;                         // atomic - jobs currently executing
+};
+
+typedef struct nd_executor_queue {
+    SPINLOCK spinlock;
+    size_t jobs;                            // atomic - to skip empty queues without locking them
+    ND_EXECUTOR_JOB *list[ND_EXECUTOR_PRIORITY_MAX];
+} ND_EXECUTOR_QUEUE;
+
+static struct {
+    SPINLOCK spinlock;                      // protects initialization and subsystems registration
+    bool initialized;
+    bool stopping;
+
+    size_t threads;
+    ND_THREAD **thread;
+    ND_EXECUTOR_QUEUE *queues;
+    size_t next_queue;                      // atomic - round robin for submitters outside the pool
+
+    size_t subsystems_count;
+    ND_EXECUTOR_SUBSYSTEM *subsystems[ND_EXECUTOR_MAX_SUBSYSTEMS];
+
+    ARAL *ar;
+
+    struct {
+        netdata_mutex_t mutex;
+        pthread_cond_t cond;
+        size_t sleeping;                    // atomic - threads waiting for jobs
+    } park;
+} executor = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .park = {
+        .mutex = NETDATA_MUTEX_INITIALIZER,
+        .cond = PTHREAD_COND_INITIALIZER,
+    },
+};
+
+// the queue of the calling thread, or -1 when it is not an executor thread
+static __thread ssize_t executor_queue_id = -1;
+
+// ----------------------------------------------------------------------------
+// queues
+
+// take the first job of the queue, with the highest priority,
+// that its subsystem has not reached its concurrency limit
+static ND_EXECUTOR_JOB *executor_queue_take(ND_EXECUTOR_QUEUE *q) {
+    if(!__atomic_load_n(&q->jobs, __ATOMIC_RELAXED))
+        return NULL;
+
+    ND_EXECUTOR_JOB *job = NULL;
+
+    spinlock_lock(&q->spinlock);
+    for(size_t p = 0; p < ND_EXECUTOR_PRIORITY_MAX && !job ; p++) {
+        for(ND_EXECUTOR_JOB *j = q->list[p]; j ; j = j->next) {
+            ND_EXECUTOR_SUBSYSTEM *ss = j->ss;
+
+            if(ss->max_concurrency &&
+                __atomic_add_fetch(&ss->running, 1, __ATOMIC_ACQUIRE) > ss->max_concurrency) {
+                __atomic_sub_fetch(&ss->running, 1, __ATOMIC_RELEASE);
+                continue;
+            }
+
+            if(!ss->max_concurrency)
+                __atomic_add_fetch(&ss->running, 1, __ATOMIC_ACQUIRE);
+
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(q->list[p], j, prev, next);
+            __atomic_sub_fetch(&q->jobs, 1, __ATOMIC_RELAXED);
+            __atomic_sub_fetch(&ss->queued, 1, __ATOMIC_RELAXED);
+            job = j;
+            break;
+        }
+    }
+    spinlock_unlock(&q->spinlock);
+
+    return job;
+}
+
+static ND_EXECUTOR_JOB *executor_get_job(size_t my_queue) {
+    // our own queue first
+    ND_EXECUTOR_JOB *job = executor_queue_take(&executor.queues[my_queue]);
+
+    // then steal from the others, starting from our neighbour
+    for(size_t i = 1; !job && i < executor.threads ; i++)
+        job = executor_queue_take(&executor.queues[(my_queue + i) % executor.threads]);
+
+    return job;
+}
+
+static bool executor_has_jobs(void) {
+    for(size_t i = 0; i < executor.threads ; i++)
+        if(__atomic_load_n(&executor.queues[i].jobs, __ATOMIC_RELAXED))
+            return true;
+
+    return false;
+}
+
+static void executor_wake_up_one(void) {
+    if(!__atomic_load_n(&executor.park.sleeping, __ATOMIC_RELAXED))
+        return;
+
+    netdata_mutex_lock(&executor.park.mutex);
+    pthread_cond_signal(&executor.park.cond);
+    netdata_mutex_unlock(&executor.park.mutex);
+}
+
+static void executor_park(void) {
+    netdata_mutex_lock(&executor.park.mutex);
+    __atomic_add_fetch(&executor.park.sleeping, 1, __ATOMIC_RELAXED);
+
+    // the timeout covers jobs that were queued, but could not run
+    // because their subsystem was at its concurrency limit
+    if(!executor_has_jobs() && !__atomic_load_n(&executor.stopping, __ATOMIC_RELAXED)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += ND_EXECUTOR_PARK_TIMEOUT_MS * NSEC_PER_MSEC;
+        if(ts.tv_nsec >= (long)NSEC_PER_SEC) {
+            ts.tv_sec++;
+            ts.tv_nsec -= NSEC_PER_SEC;
+        }
+        pthread_cond_timedwait(&executor.park.cond, &executor.park.mutex, &ts);
+    }
+
+    __atomic_sub_fetch(&executor.park.sleeping, 1, __ATOMIC_RELAXED);
+    netdata_mutex_unlock(&executor.park.mutex);
+}
+
+// ----------------------------------------------------------------------------
+// threads
+
+static void *executor_thread(void *ptr) {
+    size_t my_queue = (size_t)(uintptr_t)ptr;
+    executor_queue_id = (ssize_t)my_queue;
+
+    worker_register(ND_EXECUTOR_WORKER_NAME);
+    size_t job_names_registered = 0;
+
+    while(!__atomic_load_n(&executor.stopping, __ATOMIC_RELAXED)) {
+        ND_EXECUTOR_JOB *job = executor_get_job(my_queue);
+        if(!job) {
+            worker_is_idle();
+            executor_park();
+            continue;
+        }
+
+        ND_EXECUTOR_SUBSYSTEM *ss = job->ss;
+
+        // subsystems may be added while we run
+        size_t subsystems = __atomic_load_n(&executor.subsystems_count, __ATOMIC_ACQUIRE);
+        for(; job_names_registered < subsystems ; job_names_registered++)
+            worker_register_job_name(job_names_registered, executor.subsystems[job_names_registered]->name);
+
+        worker_is_busy(ss->id);
+        job->cb(job->data);
+
+        __atomic_sub_fetch(&ss->running, 1, __ATOMIC_RELEASE);
+        aral_freez(executor.ar, job);
+
+        // a slot of this subsystem is now free
+        if(ss->max_concurrency && __atomic_load_n(&ss->queued, __ATOMIC_RELAXED))
+            executor_wake_up_one();
+    }
+
+    worker_unregister();
+    executor_queue_id = -1;
+    return NULL;
+}
+
+// start the threads of the executor - 0 threads = as many as the CPUs
+// it is called automatically with 0 when the first subsystem is created
+void nd_executor_init(size_t threads) {
+    spinlock_lock(&executor.spinlock);
+
+    if(executor.initialized) {
+        spinlock_unlock(&executor.spinlock);
+        return;
+    }
+
+    if(!threads)
+        threads = (size_t)os_get_system_cpus();
+
+    if(threads < 2)
+        threads = 2;
+
+    executor.threads = threads;
+    executor.queues = callocz(threads, sizeof(ND_EXECUTOR_QUEUE));
+    executor.thread = callocz(threads, sizeof(ND_THREAD *));
+    executor.ar = aral_create("executor-jobs", sizeof(ND_EXECUTOR_JOB), 0, 16384, NULL, NULL, NULL, false, false);
+
+    for(size_t i = 0; i < threads ; i++)
+        spinlock_init(&executor.queues[i].spinlock);
+
+    for(size_t i = 0; i < threads ; i++) {
+        char tag[ND_THREAD_TAG_MAX + 1];
+        snprintfz(tag, sizeof(tag) - 1, "EXECUTOR[%zu]", i);
+        executor.thread[i] = nd_thread_create(tag, NETDATA_THREAD_OPTION_JOINABLE | NETDATA_THREAD_OPTION_DONT_LOG,
+                                              executor_thread, (void *)(uintptr_t)i);
+    }
+
+    executor.initialized = true;
+    spinlock_unlock(&executor.spinlock);
+
+    nd_log(NDLS_DAEMON, NDLP_INFO, "EXECUTOR: started %zu threads", threads);
+}
+
+// stop the threads - the jobs still in the queues are not executed
+void nd_executor_shutdown(void) {
+    spinlock_lock(&executor.spinlock);
+    if(!executor.initialized || executor.stopping) {
+        spinlock_unlock(&executor.spinlock);
+        return;
+    }
+    __atomic_store_n(&executor.stopping, true, __ATOMIC_RELAXED);
+    spinlock_unlock(&executor.spinlock);
+
+    netdata_mutex_lock(&executor.park.mutex);
+    pthread_cond_broadcast(&executor.park.cond);
+    netdata_mutex_unlock(&executor.park.mutex);
+
+    for(size_t i = 0; i < executor.threads ; i++)
+        nd_thread_join(executor.thread[i]);
+
+    for(size_t i = 0; i < executor.threads ; i++) {
+        for(size_t p = 0; p < ND_EXECUTOR_PRIORITY_MAX ; p++) {
+            ND_EXECUTOR_JOB *job;
+            while((job = executor.queues[i].list[p])) {
+                DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(executor.queues[i].list[p], job, prev, next);
+                __atomic_sub_fetch(&job->ss->queued, 1, __ATOMIC_RELAXED);
+                aral_freez(executor.ar, job);
+            }
+        }
+    }
+}
+
+size_t nd_executor_threads(void) {
+    return executor.threads;
+}
+
+// ----------------------------------------------------------------------------
+// subsystems and jobs
+
+// max_concurrency = 0 allows the subsystem to use all the threads
+ND_EXECUTOR_SUBSYSTEM *nd_executor_subsystem_create(const char *name, ND_EXECUTOR_PRIORITY priority, size_t max_concurrency) {
+    nd_executor_init(0);
+
+    if(priority >= ND_EXECUTOR_PRIORITY_MAX)
+        priority = ND_EXECUTOR_PRIORITY_NORMAL;
+
+    spinlock_lock(&executor.spinlock);
+
+    if(executor.subsystems_count >= ND_EXECUTOR_MAX_SUBSYSTEMS)
+        fatal("EXECUTOR: cannot register subsystem '%s', the max of %d subsystems has been reached",
+              name, ND_EXECUTOR_MAX_SUBSYSTEMS);
+
+    ND_EXECUTOR_SUBSYSTEM *ss = callocz(1, sizeof(ND_EXECUTOR_SUBSYSTEM));
+    strncpyz(ss->name, name, sizeof(ss->name) - 1);
+    ss->id = executor.subsystems_count;
+    ss->priority = priority;
+    ss->max_concurrency = max_concurrency;
+
+    executor.subsystems[ss->id] = ss;
+    __atomic_store_n(&executor.subsystems_count, ss->id + 1, __ATOMIC_RELEASE);
+
+    spinlock_unlock(&executor.spinlock);
+
+    return ss;
+}
+
+void nd_executor_submit(ND_EXECUTOR_SUBSYSTEM *ss, nd_executor_cb cb, void *data) {
+    ND_EXECUTOR_JOB *job = aral_mallocz(executor.ar);
+    job->ss = ss;
+    job->cb = cb;
+    job->data = data;
+    job->prev = job->next = NULL;
+
+    // executor threads queue their jobs locally, the rest are spread round-robin
+    size_t qid;
+    if(executor_queue_id >= 0)
+        qid = (size_t)executor_queue_id;
+    else
+        qid = __atomic_fetch_add(&executor.next_queue, 1, __ATOMIC_RELAXED) % executor.threads;
+
+    ND_EXECUTOR_QUEUE *q = &executor.queues[qid];
+
+    __atomic_add_fetch(&ss->queued, 1, __ATOMIC_RELAXED);
+
+    spinlock_lock(&q->spinlock);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(q->list[ss->priority], job, prev, next);
+    __atomic_add_fetch(&q->jobs, 1, __ATOMIC_RELAXED);
+    spinlock_unlock(&q->spinlock);
+
+    executor_wake_up_one();
+}
+
+size_t nd_executor_subsystem_queued(ND_EXECUTOR_SUBSYSTEM *ss) {
+    return __atomic_load_n(&ss->queued, __ATOMIC_RELAXED);
+}
+
+size_t nd_executor_subsystem_running(ND_EXECUTOR_SUBSYSTEM *ss) {
+    return __atomic_load_n(&ss->running, __ATOMIC_RELAXED);
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+#define EXECUTOR_UNITTEST_JOBS 100000
+
+struct executor_unittest {
+    ND_EXECUTOR_SUBSYSTEM *ss;
+    size_t executed;
+    size_t max_running;
+    bool resubmitted;
+};
+
+static void executor_unittest_job(void *data) {
+    struct executor_unittest *t = data;
+
+    size_t running = nd_executor_subsystem_running(t->ss);
+    size_t max = __atomic_load_n(&t->max_running, __ATOMIC_RELAXED);
+    while(running > max && !__atomic_compare_exchange_n(&t->max_running, &max, running, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    __atomic_add_fetch(&t->executed, 1, __ATOMIC_RELAXED);
+}
+
+static void executor_unittest_resubmit_job(void *data) {
+    struct executor_unittest *t = data;
+
+    // jobs submitted by the executor threads go to their own queue
+    if(!__atomic_exchange_n(&t->resubmitted, true, __ATOMIC_RELAXED))
+        nd_executor_submit(t->ss, executor_unittest_job, t);
+
+    __atomic_add_fetch(&t->executed, 1, __ATOMIC_RELAXED);
+}
+
+int nd_executor_unittest(void) {
+    fprintf(stderr, "\nTesting the executor...\n");
+
+    nd_executor_init(4);
+
+    struct executor_unittest unlimited = { .ss = nd_executor_subsystem_create("unittest-unlimited", ND_EXECUTOR_PRIORITY_HIGH, 0) };
+    struct executor_unittest limited = { .ss = nd_executor_subsystem_create("unittest-limited", ND_EXECUTOR_PRIORITY_LOW, 2) };
+    struct executor_unittest resubmit = { .ss = nd_executor_subsystem_create("unittest-resubmit", ND_EXECUTOR_PRIORITY_NORMAL, 0) };
+
+    usec_t started_ut = now_monotonic_usec();
+
+    for(size_t i = 0; i < EXECUTOR_UNITTEST_JOBS ; i++) {
+        nd_executor_submit(unlimited.ss, executor_unittest_job, &unlimited);
+        nd_executor_submit(limited.ss, executor_unittest_job, &limited);
+    }
+    nd_executor_submit(resubmit.ss, executor_unittest_resubmit_job, &resubmit);
+
+    // wait for them to complete, up to 60 seconds
+    for(size_t i = 0; i < 600 ; i++) {
+        if(__atomic_load_n(&unlimited.executed, __ATOMIC_RELAXED) == EXECUTOR_UNITTEST_JOBS &&
+            __atomic_load_n(&limited.executed, __ATOMIC_RELAXED) == EXECUTOR_UNITTEST_JOBS &&
+            __atomic_load_n(&resubmit.executed, __ATOMIC_RELAXED) == 2)
+            break;
+
+        sleep_usec(100 * USEC_PER_MS);
+    }
+
+    usec_t ended_ut = now_monotonic_usec();
+
+    int errors = 0;
+
+    if(unlimited.executed != EXECUTOR_UNITTEST_JOBS || limited.executed != EXECUTOR_UNITTEST_JOBS) {
+        fprintf(stderr, " > FAILED: executed %zu and %zu jobs, expected %d each\n",
+                unlimited.executed, limited.executed, EXECUTOR_UNITTEST_JOBS);
+        errors++;
+    }
+
+    if(resubmit.executed != 2) {
+        fprintf(stderr, " > FAILED: executed %zu jobs submitted by executor threads, expected 2\n", resubmit.executed);
+        errors++;
+    }
+
+    if(limited.max_running > 2) {
+        fprintf(stderr, " > FAILED: the limited subsystem had %zu jobs running concurrently, the limit is 2\n", limited.max_running);
+        errors++;
+    }
+
+    fprintf(stderr, " > executed %d jobs in %"PRIu64" usec, on %zu threads (max concurrency %zu unlimited, %zu limited)\n",
+            EXECUTOR_UNITTEST_JOBS * 2, ended_ut - started_ut, nd_executor_threads(),
+            unlimited.max_running, limited.max_running);
+
+    nd_executor_shutdown();
+
+    fprintf(stderr, "%s\n", errors ? "EXECUTOR TEST FAILED" : "EXECUTOR TEST PASSED");
+    return errors;
+}
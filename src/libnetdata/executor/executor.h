@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_EXECUTOR_H
+#define NETDATA_EXECUTOR_H 1
+
+#include "../libnetdata.h"
+
+// a shared pool of threads, executing the jobs of many subsystems
+// each thread has its own queue, and idle threads steal jobs from the others
+
+typedef enum __attribute__((packed)) {
+    ND_EXECUTOR_PRIORITY_HIGH = 0,
+    ND_EXECUTOR_PRIORITY_NORMAL,
+    ND_EXECUTOR_PRIORITY_LOW,
+
+    // terminator
+    ND_EXECUTOR_PRIORITY_MAX,
+} ND_EXECUTOR_PRIORITY;
+
+// the subsystems are also the job types of the EXECUTOR workers,
+// so that worker_utilization charts show the time spent on each of them
+#define ND_EXECUTOR_MAX_SUBSYSTEMS WORKER_UTILIZATION_MAX_JOB_TYPES
+
+typedef struct nd_executor_subsystem ND_EXECUTOR_SUBSYSTEM;
+typedef void (*nd_executor_cb)(void *data);
+
+void nd_executor_init(size_t threads);
+void nd_executor_shutdown(void);
+size_t nd_executor_threads(void);
+
+ND_EXECUTOR_SUBSYSTEM *nd_executor_subsystem_create(const char *name, ND_EXECUTOR_PRIORITY priority, size_t max_concurrency);
+void nd_executor_submit(ND_EXECUTOR_SUBSYSTEM *ss, nd_executor_cb cb, void *data);
+size_t nd_executor_subsystem_queued(ND_EXECUTOR_SUBSYSTEM *ss);
+size_t nd_executor_subsystem_running(ND_EXECUTOR_SUBSYSTEM *ss);
+
+int nd_executor_unittest(void);
+
+#endif // NETDATA_EXECUTOR_H
@@ -122,6 +122,16 @@ struct facet_key;
 #define SIMPLE_HASHTABLE_NAME _KEY
 #include "../simple_hashtable.h"
 
+// ----------------------------------------------------------------------------
+// hashtable for the interned value names
+
+// cleanup hashtable defines
+#include "../../libnetdata/simple_hashtable_undef.h"
+
+#define SIMPLE_HASHTABLE_VALUE_TYPE char
+#define SIMPLE_HASHTABLE_NAME _INTERNED
+#include "../simple_hashtable.h"
+
 // ----------------------------------------------------------------------------
 
 typedef struct facet_value {
@@ -219,6 +229,9 @@ struct facet_key {
 };
 
 struct facets {
+    ONEWAYALLOC *owa;               // the values, their names and the rows are released all together
+    SIMPLE_HASHTABLE_INTERNED interned; // the value names, indexed by their hash
+
     SIMPLE_PATTERN *visible_keys;
     SIMPLE_PATTERN *excluded_keys;
     SIMPLE_PATTERN *included_keys;
@@ -401,14 +414,7 @@ static inline void FACETS_VALUES_INDEX_CREATE(FACET_KEY *k) {
 }
 
 static inline void FACETS_VALUES_INDEX_DESTROY(FACET_KEY *k) {
-    FACET_VALUE *v = k->values.ll;
-    while(v) {
-        FACET_VALUE *next = v->next;
-        freez(v->histogram);
-        freez((void *)v->name);
-        freez(v);
-        v = next;
-    }
+    // the values are allocated in the arena of the facets
     k->values.ll = NULL;
     k->values.used = 0;
     k->values.enabled = false;
@@ -431,21 +437,30 @@ static inline void facets_key_value_copy_to_buffer(FACET_KEY *k) {
     }
 }
 
-static const char *facets_value_dup(const char *s, uint32_t len) {
-    char *d = mallocz(len + 1);
+// values with the same hash share a single copy of their name, across all keys
+static const char *facets_value_dup(FACETS *facets, FACETS_HASH hash, const char *s, uint32_t len) {
+    SIMPLE_HASHTABLE_SLOT_INTERNED *slot = simple_hashtable_get_slot_INTERNED(&facets->interned, hash, NULL, true);
+    const char *interned = SIMPLE_HASHTABLE_SLOT_DATA(slot);
+    if(interned && strncmp(interned, s, len) == 0 && interned[len] == '\0')
+        return interned;
+
+    char *d = onewayalloc_mallocz(facets->owa, len + 1);
 
     if(len)
         memcpy(d, s, len);
 
     d[len] = '\0';
 
+    if(!interned)
+        simple_hashtable_set_slot_INTERNED(&facets->interned, slot, hash, d);
+
     return d;
 }
 
 static inline void FACET_VALUE_ADD_CONFLICT(FACET_KEY *k, FACET_VALUE *v, const FACET_VALUE * const nv) {
     if(!v->name && !v->name_len && nv->name && nv->name_len) {
         // an actual value, not a filter
-        v->name = facets_value_dup(nv->name, nv->name_len);
+        v->name = facets_value_dup(k->facets, v->hash, nv->name, nv->name_len);
         v->name_len = nv->name_len;
     }
 
@@ -477,7 +492,7 @@ static inline FACET_VALUE *FACET_VALUE_ADD_TO_INDEX(FACET_KEY *k, const FACET_VA
 
     // we have to add it
 
-    FACET_VALUE *v = mallocz(sizeof(*v));
+    FACET_VALUE *v = onewayalloc_mallocz(k->facets->owa, sizeof(*v));
     simple_hashtable_set_slot_VALUE(&k->values.ht, slot, tv->hash, v);
 
     memcpy(v, tv, sizeof(*v));
@@ -500,7 +515,7 @@ static inline FACET_VALUE *FACET_VALUE_ADD_TO_INDEX(FACET_KEY *k, const FACET_VA
 
     if(v->name && v->name_len) {
         // an actual value, not a filter
-        v->name = facets_value_dup(v->name, v->name_len);
+        v->name = facets_value_dup(k->facets, v->hash, v->name, v->name_len);
         facet_value_is_used(k, v);
     }
     else {
@@ -883,22 +898,15 @@ void facets_set_timeframe_and_histogram_by_name(FACETS *facets, const char *key_
 
 static inline uint32_t facets_histogram_slot_at_time_ut(FACETS *facets, usec_t usec, FACET_VALUE *v) {
     if(unlikely(!v->histogram))
-        v->histogram = callocz(facets->histogram.slots, sizeof(*v->histogram));
+        v->histogram = onewayalloc_callocz(facets->owa, facets->histogram.slots, sizeof(*v->histogram));
 
-    usec_t base_ut = facets_histogram_slot_baseline_ut(facets, usec);
+    // slot N covers [after_ut + N * slot_width_ut, after_ut + (N + 1) * slot_width_ut);
+    // this is called for every row, so the clamping is done with MIN/MAX,
+    // that the compiler turns into conditional moves instead of branches
+    usec_t ut = MIN(MAX(usec, facets->histogram.after_ut), facets->histogram.before_ut);
+    usec_t slot = (ut - facets->histogram.after_ut) / facets->histogram.slot_width_ut;
 
-    if(unlikely(base_ut < facets->histogram.after_ut))
-        base_ut = facets->histogram.after_ut;
-
-    if(unlikely(base_ut > facets->histogram.before_ut))
-        base_ut = facets->histogram.before_ut;
-
-    uint32_t slot = (base_ut - facets->histogram.after_ut) / facets->histogram.slot_width_ut;
-
-    if(unlikely(slot >= facets->histogram.slots))
-        slot = facets->histogram.slots - 1;
-
-    return slot;
+    return (uint32_t)MIN(slot, (usec_t)facets->histogram.slots - 1);
 }
 
 static inline void facets_histogram_update_value_slot(FACETS *facets, usec_t usec, FACET_VALUE *v) {
@@ -1680,6 +1688,8 @@ void *facets_row_bin_data_get(FACETS *facets __maybe_unused, FACET_ROW *row) {
 
 FACETS *facets_create(uint32_t items_to_return, FACETS_OPTIONS options, const char *visible_keys, const char *facet_keys, const char *non_facet_keys) {
     FACETS *facets = callocz(1, sizeof(FACETS));
+    facets->owa = onewayalloc_create(0);
+    simple_hashtable_init_INTERNED(&facets->interned, FACETS_VALUES_HASHTABLE_ENTRIES);
     facets->all_keys_included_by_default = true;
     facets->options = options;
     FACETS_KEYS_INDEX_CREATE(facets);
@@ -1725,6 +1735,9 @@ void facets_destroy(FACETS *facets) {
     // make sure we didn't lose any data
     fatal_assert(facets->operations.bin_data_inflight == 0);
 
+    simple_hashtable_destroy_INTERNED(&facets->interned);
+    onewayalloc_destroy(facets->owa);
+
     freez(facets->histogram.chart);
     freez(facets);
 }
@@ -2025,7 +2038,7 @@ static void facets_row_free(FACETS *facets __maybe_unused, FACET_ROW *row) {
     facets_row_bin_data_cleanup(facets, &row->bin_data);
     dictionary_destroy(row->dict);
     row->dict = NULL;
-    freez(row);
+    onewayalloc_freez(facets->owa, row);
 }
 
 static FACET_ROW *facets_row_create(FACETS *facets, usec_t usec, FACET_ROW *into) {
@@ -2037,7 +2050,7 @@ static FACET_ROW *facets_row_create(FACETS *facets, usec_t usec, FACET_ROW *into
         facets_row_bin_data_cleanup(facets, &row->bin_data);
     }
     else {
-        row = callocz(1, sizeof(FACET_ROW));
+        row = onewayalloc_callocz(facets->owa, 1, sizeof(FACET_ROW));
         row->dict = dictionary_create_advanced(DICT_OPTION_SINGLE_THREADED|DICT_OPTION_DONT_OVERWRITE_VALUE|DICT_OPTION_FIXED_SIZE, NULL, sizeof(FACET_ROW_KEY_VALUE));
         dictionary_register_insert_callback(row->dict, facet_row_key_value_insert_callback, row);
         dictionary_register_conflict_callback(row->dict, facet_row_key_value_conflict_callback, row);
@@ -2147,13 +2160,21 @@ bool facets_row_candidate_to_keep(FACETS *facets, usec_t usec) {
             facets->items_to_return < facets->max_items_to_return;
 }
 
-static void facets_row_keep(FACETS *facets, usec_t usec) {
-    facets->operations.rows.matched++;
-
+// keep a row at usec, either a new one from the current keys, or the given one when merging
+// returns false when the row is not kept (the given row is then still owned by the caller)
+static bool facets_row_keep_row(FACETS *facets, usec_t usec, FACET_ROW *merged) {
     if(unlikely(!facets->base)) {
         // the first row to keep
-        facets_row_keep_first_entry(facets, usec);
-        return;
+        if(merged) {
+            facets->operations.last_added = merged;
+            DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(facets->base, merged, prev, next);
+            facets->items_to_return++;
+            facets->operations.first++;
+        }
+        else
+            facets_row_keep_first_entry(facets, usec);
+
+        return true;
     }
 
     FACET_ROW *closest = facets_row_keep_seek_to_position(facets, usec);
@@ -2168,7 +2189,7 @@ static void facets_row_keep(FACETS *facets, usec_t usec) {
                 if(closest == facets->base->prev && usec < closest->usec) {
                     // this is to the end of the list, belonging to the next page
                     facets->operations.skips_after++;
-                    return;
+                    return false;
                 }
 
                 // it seems we need to remove an item - the last one
@@ -2182,7 +2203,7 @@ static void facets_row_keep(FACETS *facets, usec_t usec) {
                 if(closest == facets->base && usec > closest->usec) {
                     // this is to the beginning of the list, belonging to the next page
                     facets->operations.skips_before++;
-                    return;
+                    return false;
                 }
 
                 // it seems we need to remove an item - the first one
@@ -2201,7 +2222,14 @@ static void facets_row_keep(FACETS *facets, usec_t usec) {
     internal_fatal(!closest, "FACETS: closest cannot be NULL");
     internal_fatal(closest == to_replace, "FACETS: closest cannot be the same as to_replace");
 
-    facets->operations.last_added = facets_row_create(facets, usec, to_replace);
+    if(merged) {
+        if(to_replace)
+            facets_row_free(facets, to_replace);
+
+        facets->operations.last_added = merged;
+    }
+    else
+        facets->operations.last_added = facets_row_create(facets, usec, to_replace);
 
     if(usec < closest->usec) {
         DOUBLE_LINKED_LIST_INSERT_ITEM_AFTER_UNSAFE(facets->base, closest, facets->operations.last_added, prev, next);
@@ -2213,6 +2241,12 @@ static void facets_row_keep(FACETS *facets, usec_t usec) {
     }
 
     facets->items_to_return++;
+    return true;
+}
+
+static void facets_row_keep(FACETS *facets, usec_t usec) {
+    facets->operations.rows.matched++;
+    facets_row_keep_row(facets, usec, NULL);
 }
 
 static inline void facets_reset_key(FACET_KEY *k) {
@@ -2275,6 +2309,7 @@ bool facets_row_finished(FACETS *facets, usec_t usec) {
     size_t entries = facets->keys_with_values.used;
     size_t total_keys = 0;
     size_t selected_keys = 0;
+    FACET_KEY *unselected_key = NULL;
 
     for(size_t p = 0; p < entries ;p++) {
         FACET_KEY *k = facets->keys_with_values.array[p];
@@ -2288,31 +2323,22 @@ bool facets_row_finished(FACETS *facets, usec_t usec) {
 
         if(k->key_values_selected_in_row)
             selected_keys++;
+        else
+            unselected_key = k;
 
         if(unlikely(!facets->histogram.key && facets->histogram.hash == k->hash))
             facets->histogram.key = k;
     }
 
-    if(selected_keys >= total_keys - 1) {
-        size_t found = 0;
-        (void) found;
-
-        for(size_t p = 0; p < entries; p++) {
-            FACET_KEY *k = facets->keys_with_values.array[p];
-
-            size_t counted_by = selected_keys;
-
-            if(counted_by != total_keys && !k->key_values_selected_in_row)
-                counted_by++;
-
-            if(counted_by == total_keys) {
-                k->current_value.v->final_facet_value_counter++;
-                found++;
-            }
-        }
-
-        internal_fatal(!found, "We should find at least one facet to count this row");
+    // a value is counted when the row is selected by all the other keys:
+    // - when all the keys select the row, the values of all the keys are counted
+    // - when all but one select it, only the value of the one that does not select it is counted
+    if(selected_keys == total_keys) {
+        for(size_t p = 0; p < entries; p++)
+            facets->keys_with_values.array[p]->current_value.v->final_facet_value_counter++;
     }
+    else if(selected_keys + 1 == total_keys)
+        unselected_key->current_value.v->final_facet_value_counter++;
 
     if(selected_keys == total_keys) {
         // we need to keep this row
@@ -2327,6 +2353,143 @@ bool facets_row_finished(FACETS *facets, usec_t usec) {
     return selected_keys == total_keys;
 }
 
+// ----------------------------------------------------------------------------
+// merging
+
+static void facets_merge_value_histogram(FACETS *dst, FACET_VALUE *dv, FACETS *src, FACET_VALUE *v) {
+    if(!v->histogram || !dst->histogram.enabled || !dst->histogram.slots)
+        return;
+
+    if(!dv->histogram)
+        dv->histogram = onewayalloc_callocz(dst->owa, dst->histogram.slots, sizeof(*dv->histogram));
+
+    bool same_slots = dst->histogram.after_ut == src->histogram.after_ut &&
+                      dst->histogram.slot_width_ut == src->histogram.slot_width_ut &&
+                      dst->histogram.slots == src->histogram.slots;
+
+    for(uint32_t slot = 0; slot < src->histogram.slots ;slot++) {
+        if(!v->histogram[slot])
+            continue;
+
+        if(same_slots)
+            dv->histogram[slot] += v->histogram[slot];
+        else {
+            usec_t slot_ut = src->histogram.after_ut + slot * src->histogram.slot_width_ut;
+            if(slot_ut < dst->histogram.after_ut || slot_ut > dst->histogram.before_ut)
+                continue;
+
+            dv->histogram[facets_histogram_slot_at_time_ut(dst, slot_ut, dv)] += v->histogram[slot];
+        }
+    }
+}
+
+static void facets_merge_key(FACETS *dst, FACETS *src, FACET_KEY *k) {
+    FACET_KEY *dk = FACETS_KEY_ADD_TO_INDEX(dst, k->hash, k->name, k->name ? strlen(k->name) : 0,
+                                            k->options & ~(FACET_KEY_OPTION_REORDER | FACET_KEY_OPTION_REORDER_DONE));
+
+    if(!k->default_selected_for_values)
+        dk->default_selected_for_values = false;
+
+    if(!dk->transform.cb && k->transform.cb) {
+        dk->transform.cb = k->transform.cb;
+        dk->transform.data = k->transform.data;
+        dk->transform.view_only = k->transform.view_only;
+    }
+
+    if(!dk->dynamic.cb && k->dynamic.cb) {
+        dk->dynamic.cb = k->dynamic.cb;
+        dk->dynamic.data = k->dynamic.data;
+    }
+
+    if(!dst->histogram.key && dst->histogram.hash == dk->hash)
+        dst->histogram.key = dk;
+
+    if(!k->values.enabled || !dk->values.enabled)
+        return;
+
+    FACET_VALUE *v;
+    foreach_value_in_key(k, v) {
+        FACET_VALUE *dv = FACET_VALUE_GET_FROM_INDEX(dk, v->hash);
+        if(!dv) {
+            FACET_VALUE tv = {
+                    .hash = v->hash,
+                    .name = v->name,
+                    .name_len = v->name_len,
+                    .color = v->color,
+                    .selected = v->selected,
+                    .empty = v->empty,
+                    .unsampled = v->unsampled,
+                    .estimated = v->estimated,
+            };
+            dv = FACET_VALUE_ADD_TO_INDEX(dk, &tv);
+
+            // the index counts it as found in the current row, but we merge counters, not rows
+            dv->rows_matching_facet_value = 0;
+        }
+        else if(!dv->name && v->name && v->name_len) {
+            dv->name = facets_value_dup(dst, dv->hash, v->name, v->name_len);
+            dv->name_len = v->name_len;
+        }
+
+        if(v->empty)
+            dk->empty_value.v = dv;
+        else if(v->unsampled)
+            dk->unsampled_value.v = dv;
+        else if(v->estimated)
+            dk->estimated_value.v = dv;
+
+        dv->rows_matching_facet_value += v->rows_matching_facet_value;
+        dv->final_facet_value_counter += v->final_facet_value_counter;
+        facets_merge_value_histogram(dst, dv, src, v);
+    }
+    foreach_value_in_key_done(v);
+
+    facets_reset_key(dk);
+}
+
+// Merge the partial results of src into dst.
+// Both have to be set up for the same query (keys, filters, anchor, timeframe and histogram),
+// and no row may be in progress on either of them. The value counters and the histograms
+// are added, and the rows of src are moved to dst, keeping only the ones the page of dst
+// can hold. src is left without rows and is expected to be destroyed after this.
+void facets_merge(FACETS *dst, FACETS *src) {
+    if(!dst || !src || dst == src)
+        return;
+
+    FACET_KEY *k;
+    foreach_key_in_facets(src, k) {
+        facets_merge_key(dst, src, k);
+    }
+    foreach_key_in_facets_done(k);
+
+    dst->operations.rows.evaluated += src->operations.rows.evaluated;
+    dst->operations.rows.matched += src->operations.rows.matched;
+    dst->operations.rows.unsampled += src->operations.rows.unsampled;
+    dst->operations.rows.estimated += src->operations.rows.estimated;
+    dst->operations.fts.searches += src->operations.fts.searches;
+
+    while(src->base) {
+        FACET_ROW *src_row = src->base;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(src->base, src_row, prev, next);
+        src->items_to_return--;
+
+        // the row is allocated in the arena of src, move it to the arena of dst
+        FACET_ROW *row = onewayalloc_memdupz(dst->owa, src_row, sizeof(*src_row));
+        onewayalloc_freez(src->owa, src_row);
+
+        // the bin_data of the row move with it
+        bool has_bin_data = row->bin_data.data != NULL;
+        if(has_bin_data) {
+            src->operations.bin_data_inflight--;
+            dst->operations.bin_data_inflight++;
+        }
+
+        if(!facets_row_keep_row(dst, row->usec, row))
+            facets_row_free(dst, row);
+    }
+    src->operations.last_added = NULL;
+}
+
 // ----------------------------------------------------------------------------
 // output
 
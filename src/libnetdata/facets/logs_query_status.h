@@ -326,7 +326,7 @@ static inline void lqs_function_help(LOGS_QUERY_STATUS *lqs, BUFFER *wb) {
                    );
 }
 
-static inline bool lqs_request_parse_json_payload(json_object *jobj, const char *path, void *data, BUFFER *error) {
+static inline bool lqs_request_parse_json_payload(JSON_STREAM *js, JSON_STREAM_VALUE *root, const char *path, void *data, BUFFER *error) {
     struct logs_query_data *qd = data;
     LOGS_QUERY_REQUEST *rq = qd->rq;
     BUFFER *wb = qd->wb;
@@ -335,24 +335,27 @@ static inline bool lqs_request_parse_json_payload(json_object *jobj, const char
 
     buffer_flush(error);
 
-    JSONC_PARSE_BOOL_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_INFO, rq->info, error, false);
-    JSONC_PARSE_BOOL_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_DELTA, rq->delta, error, false);
-    JSONC_PARSE_BOOL_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_TAIL, rq->tail, error, false);
-    JSONC_PARSE_BOOL_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_SLICE, rq->slice, error, false);
-    JSONC_PARSE_BOOL_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_DATA_ONLY, rq->data_only, error, false);
-    JSONC_PARSE_UINT64_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_SAMPLING, rq->sampling, error, false);
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_AFTER, rq->after_s, error, false);
-    JSONC_PARSE_INT64_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_BEFORE, rq->before_s, error, false);
-    JSONC_PARSE_UINT64_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_IF_MODIFIED_SINCE, rq->if_modified_since, error, false);
-    JSONC_PARSE_UINT64_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_ANCHOR, rq->anchor, error, false);
-    JSONC_PARSE_UINT64_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_LAST, rq->entries, error, false);
-    JSONC_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_DIRECTION, lgs_get_direction, rq->direction, error, false);
-    JSONC_PARSE_TXT2STRDUPZ_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_QUERY, rq->query, error, false);
-    JSONC_PARSE_TXT2STRDUPZ_OR_ERROR_AND_RETURN(jobj, path, LQS_PARAMETER_HISTOGRAM, rq->histogram, error, false);
-
-    json_object *sources;
-    if (json_object_object_get_ex(jobj, LQS_PARAMETER_SOURCE, &sources)) {
-        if (json_object_get_type(sources) != json_type_array) {
+    JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_INFO, rq->info, error, false);
+    JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_DELTA, rq->delta, error, false);
+    JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_TAIL, rq->tail, error, false);
+    JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_SLICE, rq->slice, error, false);
+    JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_DATA_ONLY, rq->data_only, error, false);
+    JSONS_PARSE_UINT64_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_SAMPLING, rq->sampling, error, false);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_AFTER, rq->after_s, error, false);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_BEFORE, rq->before_s, error, false);
+    JSONS_PARSE_UINT64_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_IF_MODIFIED_SINCE, rq->if_modified_since, error, false);
+    JSONS_PARSE_UINT64_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_ANCHOR, rq->anchor, error, false);
+    JSONS_PARSE_UINT64_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_LAST, rq->entries, error, false);
+    JSONS_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_DIRECTION, lgs_get_direction, rq->direction, error, false);
+    JSONS_PARSE_TXT2STRDUPZ_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_QUERY, rq->query, error, false);
+    JSONS_PARSE_TXT2STRDUPZ_OR_ERROR_AND_RETURN(js, root, path, LQS_PARAMETER_HISTOGRAM, rq->histogram, error, false);
+
+    JSON_STREAM_ITERATOR it;
+    JSON_STREAM_VALUE item;
+
+    JSON_STREAM_VALUE sources;
+    if (json_stream_object_get(js, root, LQS_PARAMETER_SOURCE, &sources)) {
+        if (sources.type != JSON_ARRAY) {
             buffer_sprintf(error, "member '%s' is not an array", LQS_PARAMETER_SOURCE);
             // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: '%s' is not an array", LQS_PARAMETER_SOURCE);
             return false;
@@ -364,17 +367,15 @@ static inline bool lqs_request_parse_json_payload(json_object *jobj, const char
 
         rq->source_type = LQS_SOURCE_TYPE_NONE;
 
-        size_t sources_len = json_object_array_length(sources);
-        for (size_t i = 0; i < sources_len; i++) {
-            json_object *src = json_object_array_get_idx(sources, i);
-
-            if (json_object_get_type(src) != json_type_string) {
-                buffer_sprintf(error, "sources array item %zu is not a string", i);
-                // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: sources array item %zu is not a string", i);
+        json_stream_iterator_init(js, &sources, &it);
+        while (json_stream_array_next(js, &it, &item)) {
+            if (item.type != JSON_STRING) {
+                buffer_sprintf(error, "sources array item %zu is not a string", it.index - 1);
+                // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: sources array item %zu is not a string", it.index - 1);
                 return false;
             }
 
-            const char *value = json_object_get_string(src);
+            const char *value = json_stream_string(js, &item);
             buffer_json_add_array_item_string(wb, value);
 
             LQS_SOURCE_TYPE t = LQS_FUNCTION_GET_INTERNAL_SOURCE_TYPE(value);
@@ -399,9 +400,9 @@ static inline bool lqs_request_parse_json_payload(json_object *jobj, const char
         buffer_json_array_close(wb); // source
     }
 
-    json_object *fcts;
-    if (json_object_object_get_ex(jobj, LQS_PARAMETER_FACETS, &fcts)) {
-        if (json_object_get_type(sources) != json_type_array) {
+    JSON_STREAM_VALUE fcts;
+    if (json_stream_object_get(js, root, LQS_PARAMETER_FACETS, &fcts)) {
+        if (fcts.type != JSON_ARRAY) {
             buffer_sprintf(error, "member '%s' is not an array", LQS_PARAMETER_FACETS);
             // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: '%s' is not an array", LQS_PARAMETER_FACETS);
             return false;
@@ -412,17 +413,15 @@ static inline bool lqs_request_parse_json_payload(json_object *jobj, const char
 
         buffer_json_member_add_array(wb, LQS_PARAMETER_FACETS);
 
-        size_t facets_len = json_object_array_length(fcts);
-        for (size_t i = 0; i < facets_len; i++) {
-            json_object *fct = json_object_array_get_idx(fcts, i);
-
-            if (json_object_get_type(fct) != json_type_string) {
-                buffer_sprintf(error, "facets array item %zu is not a string", i);
-                // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: facets array item %zu is not a string", i);
+        json_stream_iterator_init(js, &fcts, &it);
+        while (json_stream_array_next(js, &it, &item)) {
+            if (item.type != JSON_STRING) {
+                buffer_sprintf(error, "facets array item %zu is not a string", it.index - 1);
+                // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: facets array item %zu is not a string", it.index - 1);
                 return false;
             }
 
-            const char *value = json_object_get_string(fct);
+            const char *value = json_stream_string(js, &item);
             facets_register_facet(facets, value, FACET_KEY_OPTION_FACET|FACET_KEY_OPTION_FTS|FACET_KEY_OPTION_REORDER);
             buffer_json_add_array_item_string(wb, value);
         }
@@ -430,9 +429,9 @@ static inline bool lqs_request_parse_json_payload(json_object *jobj, const char
         buffer_json_array_close(wb); // facets
     }
 
-    json_object *selections;
-    if (json_object_object_get_ex(jobj, "selections", &selections)) {
-        if (json_object_get_type(selections) != json_type_object) {
+    JSON_STREAM_VALUE selections;
+    if (json_stream_object_get(js, root, "selections", &selections)) {
+        if (selections.type != JSON_OBJECT) {
             buffer_sprintf(error, "member 'selections' is not an object");
             // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: '%s' is not an object", "selections");
             return false;
@@ -440,8 +439,14 @@ static inline bool lqs_request_parse_json_payload(json_object *jobj, const char
 
         buffer_json_member_add_object(wb, "selections");
 
-        json_object_object_foreach(selections, key, val) {
-            if (json_object_get_type(val) != json_type_array) {
+        CLEAN_BUFFER *key_buffer = buffer_create(0, NULL);
+        JSON_STREAM_ITERATOR sit;
+        JSON_STREAM_VALUE val;
+        json_stream_iterator_init(js, &selections, &sit);
+        while (json_stream_object_next(js, &sit, key_buffer, &val)) {
+            const char *key = buffer_tostring(key_buffer);
+
+            if (val.type != JSON_ARRAY) {
                 buffer_sprintf(error, "selection '%s' is not an array", key);
                 // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: selection '%s' is not an array", key);
                 return false;
@@ -449,17 +454,15 @@ static inline bool lqs_request_parse_json_payload(json_object *jobj, const char
 
             buffer_json_member_add_array(wb, key);
 
-            size_t values_len = json_object_array_length(val);
-            for (size_t i = 0; i < values_len; i++) {
-                json_object *value_obj = json_object_array_get_idx(val, i);
-
-                if (json_object_get_type(value_obj) != json_type_string) {
-                    buffer_sprintf(error, "selection '%s' array item %zu is not a string", key, i);
-                    // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: selection '%s' array item %zu is not a string", key, i);
+            json_stream_iterator_init(js, &val, &it);
+            while (json_stream_array_next(js, &it, &item)) {
+                if (item.type != JSON_STRING) {
+                    buffer_sprintf(error, "selection '%s' array item %zu is not a string", key, it.index - 1);
+                    // nd_log(NDLS_COLLECTORS, NDLP_ERR, "POST payload: selection '%s' array item %zu is not a string", key, it.index - 1);
                     return false;
                 }
 
-                const char *value = json_object_get_string(value_obj);
+                const char *value = json_stream_string(js, &item);
 
                 // Call facets_register_facet_id_filter for each value
                 facets_register_facet_filter(
@@ -494,11 +497,10 @@ static inline bool lqs_request_parse_POST(LOGS_QUERY_STATUS *lqs, BUFFER *wb, BU
     };
 
     int code;
-    CLEAN_JSON_OBJECT *jobj =
-        json_parse_function_payload_or_error(wb, payload, &code, lqs_request_parse_json_payload, &qd);
+    bool ok = json_stream_parse_function_payload_or_error(wb, payload, &code, lqs_request_parse_json_payload, &qd);
     wb->response_code = code;
 
-    return (jobj && code == HTTP_RESP_OK);
+    return (ok && code == HTTP_RESP_OK);
 }
 
 static inline bool lqs_request_parse_GET(LOGS_QUERY_STATUS *lqs, BUFFER *wb, char *function) {
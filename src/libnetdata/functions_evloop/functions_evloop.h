@@ -48,12 +48,18 @@
 #define PLUGINSD_KEYWORD_REPLAY_RRDSET_STATE    "RSSTATE"
 #define PLUGINSD_KEYWORD_REPLAY_END             "REND"
 
+// chart definitions the parent already has, from a previous connection
+// enabled with STREAM_CAP_DIGEST
+#define PLUGINSD_KEYWORD_CHART_REUSE            "CHART_REUSE"   // child to parent
+#define PLUGINSD_KEYWORD_CHART_RESEND           "CHART_RESEND"  // parent to child
+
 // plugins.d accepts these for functions (from external plugins or streaming children)
 // related to STREAM_CAP_FUNCTIONS, STREAM_CAP_PROGRESS
 #define PLUGINSD_KEYWORD_FUNCTION               "FUNCTION"                  // define a function
 #define PLUGINSD_KEYWORD_FUNCTION_PROGRESS      "FUNCTION_PROGRESS"         // send updates about function progress
 #define PLUGINSD_KEYWORD_FUNCTION_RESULT_BEGIN  "FUNCTION_RESULT_BEGIN"     // the result of a function transaction
 #define PLUGINSD_KEYWORD_FUNCTION_RESULT_END    "FUNCTION_RESULT_END"       // the end of the result of a func. trans.
+#define PLUGINSD_FUNCTION_RESULT_PARTIAL        "partial"                   // the 5th parameter of FUNCTION_RESULT_BEGIN, when more results follow
 
 // plugins.d sends these for functions (to external plugins or streaming children)
 // related to STREAM_CAP_FUNCTIONS, STREAM_CAP_PROGRESS
@@ -111,6 +117,20 @@ static inline void functions_stop_monotonic_update_on_progress(usec_t *stop_mono
 #define pluginsd_function_result_end_to_buffer(wb) \
     buffer_strcat(wb, "\n" PLUGINSD_KEYWORD_FUNCTION_RESULT_END "\n")
 
+#define pluginsd_function_result_partial_begin_to_buffer(wb, transaction, code, content_type, expires) \
+    buffer_sprintf(wb                                                                               \
+                    , PLUGINSD_KEYWORD_FUNCTION_RESULT_BEGIN " \"%s\" %d \"%s\" %ld " PLUGINSD_FUNCTION_RESULT_PARTIAL "\n" \
+                    , (transaction) ? (transaction) : ""                                            \
+                    , (int)(code)                                                                   \
+                    , (content_type) ? (content_type) : ""                                          \
+                    , (long int)(expires)                                                           \
+    )
+
+// partial results are concatenated as they are, so we add a newline only when they do not end with one
+#define pluginsd_function_result_partial_end_to_buffer(wb, result)                                  \
+    buffer_strcat(wb, (buffer_strlen(result) && buffer_tostring(result)[buffer_strlen(result) - 1] == '\n') ? \
+                  PLUGINSD_KEYWORD_FUNCTION_RESULT_END "\n" : "\n" PLUGINSD_KEYWORD_FUNCTION_RESULT_END "\n")
+
 #define pluginsd_function_result_begin_to_stdout(transaction, code, content_type, expires)          \
     fprintf(stdout                                                                                  \
                     , PLUGINSD_KEYWORD_FUNCTION_RESULT_BEGIN " \"%s\" %d \"%s\" %ld\n"              \
@@ -144,6 +164,27 @@ static inline void pluginsd_function_result_to_stdout(const char *transaction, B
     fflush(stdout);
 }
 
+// send a part of the result, before the final pluginsd_function_result_to_stdout()
+// the parts should end at line boundaries (a newline is added otherwise),
+// so that the caller receives exactly the concatenation of all of them
+static inline void pluginsd_function_result_partial_to_stdout(const char *transaction, BUFFER *result) {
+    fprintf(stdout,
+            PLUGINSD_KEYWORD_FUNCTION_RESULT_BEGIN " \"%s\" %d \"%s\" %ld " PLUGINSD_FUNCTION_RESULT_PARTIAL "\n",
+            transaction ? transaction : "", result->response_code,
+            content_type_id2string(result->content_type), (long int)result->expires);
+
+    size_t len = buffer_strlen(result);
+    fwrite(buffer_tostring(result), len, 1, stdout);
+
+    if(!len || buffer_tostring(result)[len - 1] != '\n')
+        fputc('\n', stdout);
+
+    fprintf(stdout, PLUGINSD_KEYWORD_FUNCTION_RESULT_END "\n");
+
+    // a blocking stdout is our flow control: the agent reads it only as fast as it can forward it
+    fflush(stdout);
+}
+
 static inline void pluginsd_function_progress_to_stdout(const char *transaction, size_t done, size_t all) {
     fprintf(stdout, PLUGINSD_KEYWORD_FUNCTION_PROGRESS " '%s' %zu %zu\n",
             transaction, done, all);
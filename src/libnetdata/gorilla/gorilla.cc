@@ -17,6 +17,23 @@ static constexpr size_t bit_size() noexcept
     return (sizeof(T) * CHAR_BIT);
 }
 
+// the number of bits needed to store the LZC of a word
+template <typename T>
+static constexpr size_t lzc_bit_size() noexcept
+{
+    return (bit_size<T>() == 32) ? 5 : 6;
+}
+
+static inline uint32_t leading_zeros(uint32_t v)
+{
+    return __builtin_clz(v);
+}
+
+static inline uint32_t leading_zeros(uint64_t v)
+{
+    return __builtin_clzll(v);
+}
+
 static void bit_buffer_write(uint32_t *buf, size_t pos, uint32_t v, size_t nbits)
 {
     assert(nbits > 0 && nbits <= bit_size<uint32_t>());
@@ -45,6 +62,20 @@ static void bit_buffer_write(uint32_t *buf, size_t pos, uint32_t v, size_t nbits
     }
 }
 
+static void bit_buffer_write(uint32_t *buf, size_t pos, uint64_t v, size_t nbits)
+{
+    assert(nbits > 0 && nbits <= bit_size<uint64_t>());
+
+    if (nbits <= bit_size<uint32_t>()) {
+        bit_buffer_write(buf, pos, static_cast<uint32_t>(v), nbits);
+        return;
+    }
+
+    // the buffer is made of 32-bit words, write the lower and then the upper half
+    bit_buffer_write(buf, pos, static_cast<uint32_t>(v), bit_size<uint32_t>());
+    bit_buffer_write(buf, pos + bit_size<uint32_t>(), static_cast<uint32_t>(v >> 32), nbits - bit_size<uint32_t>());
+}
+
 static void bit_buffer_read(const uint32_t *buf, size_t pos, uint32_t *v, size_t nbits)
 {
     assert(nbits > 0 && nbits <= bit_size<uint32_t>());
@@ -72,21 +103,29 @@ static void bit_buffer_read(const uint32_t *buf, size_t pos, uint32_t *v, size_t
     }
 }
 
-gorilla_writer_t gorilla_writer_init(gorilla_buffer_t *gbuf, size_t n)
+static void bit_buffer_read(const uint32_t *buf, size_t pos, uint64_t *v, size_t nbits)
 {
-    gorilla_writer_t gw = gorilla_writer_t {
-        .head_buffer = gbuf,
-        .last_buffer = NULL,
-        .prev_number = 0,
-        .prev_xor_lzc = 0,
-        .capacity = 0
-    };
+    assert(nbits > 0 && nbits <= bit_size<uint64_t>());
 
-    gorilla_writer_add_buffer(&gw, gbuf, n);
-    return gw;
+    uint32_t low = 0, high = 0;
+
+    if (nbits <= bit_size<uint32_t>()) {
+        bit_buffer_read(buf, pos, &low, nbits);
+    } else {
+        bit_buffer_read(buf, pos, &low, bit_size<uint32_t>());
+        bit_buffer_read(buf, pos + bit_size<uint32_t>(), &high, nbits - bit_size<uint32_t>());
+    }
+
+    *v = (static_cast<uint64_t>(high) << 32) | low;
 }
 
-void gorilla_writer_add_buffer(gorilla_writer_t *gw, gorilla_buffer_t *gbuf, size_t n)
+/*
+ * The writers and readers of 32-bit and 64-bit words share the same
+ * implementation. Only the word size of the values differs.
+*/
+
+template <typename Writer>
+static void writer_add_buffer(Writer *gw, gorilla_buffer_t *gbuf, size_t n)
 {
     gbuf->header.next = NULL;
     gbuf->header.entries = 0;
@@ -104,7 +143,23 @@ void gorilla_writer_add_buffer(gorilla_writer_t *gw, gorilla_buffer_t *gbuf, siz
     __atomic_store_n(&gw->last_buffer, gbuf, __ATOMIC_RELAXED);
 }
 
-uint32_t gorilla_writer_entries(const gorilla_writer_t *gw) {
+template <typename Writer>
+static Writer writer_init(gorilla_buffer_t *gbuf, size_t n)
+{
+    Writer gw = Writer {
+        .head_buffer = gbuf,
+        .last_buffer = NULL,
+        .prev_number = 0,
+        .prev_xor_lzc = 0,
+        .capacity = 0
+    };
+
+    writer_add_buffer(&gw, gbuf, n);
+    return gw;
+}
+
+template <typename Writer>
+static uint32_t writer_entries(const Writer *gw) {
     uint32_t entries = 0;
 
     const gorilla_buffer_t *curr_gbuf = __atomic_load_n(&gw->head_buffer, __ATOMIC_SEQ_CST);
@@ -119,18 +174,19 @@ uint32_t gorilla_writer_entries(const gorilla_writer_t *gw) {
     return entries;
 }
 
-bool gorilla_writer_write(gorilla_writer_t *gw, uint32_t number)
+template <typename Word, typename Writer>
+static bool writer_write(Writer *gw, Word number)
 {
     gorilla_header_t *hdr = &gw->last_buffer->header;
     uint32_t *data = gw->last_buffer->data;
 
     // this is the first number we are writing
     if (hdr->entries == 0) {
-        if (hdr->nbits + bit_size<uint32_t>() >= gw->capacity)
+        if (hdr->nbits + bit_size<Word>() >= gw->capacity)
             return false;
-        bit_buffer_write(data, hdr->nbits, number, bit_size<uint32_t>());
+        bit_buffer_write(data, hdr->nbits, number, bit_size<Word>());
 
-        __atomic_fetch_add(&hdr->nbits, bit_size<uint32_t>(), __ATOMIC_RELAXED);
+        __atomic_fetch_add(&hdr->nbits, bit_size<Word>(), __ATOMIC_RELAXED);
         __atomic_fetch_add(&hdr->entries, 1, __ATOMIC_RELAXED);
         gw->prev_number = number;
         return true;
@@ -152,17 +208,17 @@ bool gorilla_writer_write(gorilla_writer_t *gw, uint32_t number)
     bit_buffer_write(data, hdr->nbits, static_cast<uint32_t>(0), 1);
     __atomic_fetch_add(&hdr->nbits, 1, __ATOMIC_RELAXED);
 
-    uint32_t xor_value = gw->prev_number ^ number;
-    uint32_t xor_lzc = (bit_size<uint32_t>() == 32) ? __builtin_clz(xor_value) : __builtin_clzll(xor_value);
+    Word xor_value = gw->prev_number ^ number;
+    uint32_t xor_lzc = leading_zeros(xor_value);
     uint32_t is_xor_lzc_same = (xor_lzc == gw->prev_xor_lzc) ? 1 : 0;
 
     if (hdr->nbits + 1 >= gw->capacity)
         return false;
     bit_buffer_write(data, hdr->nbits, is_xor_lzc_same, 1);
     __atomic_fetch_add(&hdr->nbits, 1, __ATOMIC_RELAXED);
-    
+
     if (!is_xor_lzc_same) {
-        size_t bits_needed = (bit_size<uint32_t>() == 32) ? 5 : 6;
+        size_t bits_needed = lzc_bit_size<Word>();
         if ((hdr->nbits + bits_needed) >= gw->capacity)
             return false;
         bit_buffer_write(data, hdr->nbits, xor_lzc, bits_needed);
@@ -170,10 +226,10 @@ bool gorilla_writer_write(gorilla_writer_t *gw, uint32_t number)
     }
 
     // write the bits of the XOR'd value without the LZC prefix
-    if (hdr->nbits + (bit_size<uint32_t>() - xor_lzc) >= gw->capacity)
+    if (hdr->nbits + (bit_size<Word>() - xor_lzc) >= gw->capacity)
         return false;
-    bit_buffer_write(data, hdr->nbits, xor_value, bit_size<uint32_t>() - xor_lzc);
-    __atomic_fetch_add(&hdr->nbits, bit_size<uint32_t>() - xor_lzc, __ATOMIC_RELAXED);
+    bit_buffer_write(data, hdr->nbits, xor_value, bit_size<Word>() - xor_lzc);
+    __atomic_fetch_add(&hdr->nbits, bit_size<Word>() - xor_lzc, __ATOMIC_RELAXED);
     __atomic_fetch_add(&hdr->entries, 1, __ATOMIC_RELAXED);
 
     gw->prev_number = number;
@@ -181,7 +237,8 @@ bool gorilla_writer_write(gorilla_writer_t *gw, uint32_t number)
     return true;
 }
 
-gorilla_buffer_t *gorilla_writer_drop_head_buffer(gorilla_writer_t *gw) {
+template <typename Writer>
+static gorilla_buffer_t *writer_drop_head_buffer(Writer *gw) {
     if (!gw->head_buffer)
         return NULL;
 
@@ -191,7 +248,8 @@ gorilla_buffer_t *gorilla_writer_drop_head_buffer(gorilla_writer_t *gw) {
     return curr_head;
 }
 
-uint32_t gorilla_writer_nbytes(const gorilla_writer_t *gw)
+template <typename Writer>
+static uint32_t writer_nbytes(const Writer *gw)
 {
     uint32_t nbits = 0;
 
@@ -207,7 +265,8 @@ uint32_t gorilla_writer_nbytes(const gorilla_writer_t *gw)
     return (nbits + (CHAR_BIT - 1)) / CHAR_BIT;
 }
 
-bool gorilla_writer_serialize(const gorilla_writer_t *gw, uint8_t *dst, uint32_t dst_size) {
+template <typename Writer>
+static bool writer_serialize(const Writer *gw, uint8_t *dst, uint32_t dst_size) {
     const gorilla_buffer_t *curr_gbuf = gw->head_buffer;
 
     do {
@@ -215,7 +274,7 @@ bool gorilla_writer_serialize(const gorilla_writer_t *gw, uint8_t *dst, uint32_t
 
         size_t bytes = RRDENG_GORILLA_32BIT_BUFFER_SIZE;
         if (bytes > dst_size)
-            return false;   
+            return false;
 
         memcpy(dst, curr_gbuf, bytes);
         dst += bytes;
@@ -247,31 +306,13 @@ uint32_t gorilla_buffer_patch(gorilla_buffer_t *gbuf) {
     return n;
 }
 
-gorilla_reader_t gorilla_writer_get_reader(const gorilla_writer_t *gw)
-{
-    const gorilla_buffer_t *buffer = __atomic_load_n(&gw->head_buffer, __ATOMIC_SEQ_CST);
-
-    uint32_t entries = __atomic_load_n(&buffer->header.entries, __ATOMIC_SEQ_CST);
-    uint32_t capacity = __atomic_load_n(&buffer->header.nbits, __ATOMIC_SEQ_CST);
-
-    return gorilla_reader_t {
-        .buffer = buffer,
-        .entries = entries,
-        .index = 0,
-        .capacity = capacity,
-        .position = 0,
-        .prev_number = 0,
-        .prev_xor_lzc = 0,
-        .prev_xor = 0,
-    };
-}
-
-gorilla_reader_t gorilla_reader_init(gorilla_buffer_t *gbuf)
+template <typename Reader>
+static Reader reader_init(const gorilla_buffer_t *gbuf)
 {
     uint32_t entries = __atomic_load_n(&gbuf->header.entries, __ATOMIC_SEQ_CST);
     uint32_t capacity = __atomic_load_n(&gbuf->header.nbits, __ATOMIC_SEQ_CST);
 
-    return gorilla_reader_t {
+    return Reader {
         .buffer = gbuf,
         .entries = entries,
         .index = 0,
@@ -283,7 +324,15 @@ gorilla_reader_t gorilla_reader_init(gorilla_buffer_t *gbuf)
     };
 }
 
-bool gorilla_reader_read(gorilla_reader_t *gr, uint32_t *number)
+template <typename Reader, typename Writer>
+static Reader writer_get_reader(const Writer *gw)
+{
+    const gorilla_buffer_t *buffer = __atomic_load_n(&gw->head_buffer, __ATOMIC_SEQ_CST);
+    return reader_init<Reader>(buffer);
+}
+
+template <typename Word, typename Reader>
+static bool reader_read(Reader *gr, Word *number)
 {
     const uint32_t *data = gr->buffer->data;
 
@@ -305,17 +354,17 @@ bool gorilla_reader_read(gorilla_reader_t *gr, uint32_t *number)
             }
 
             // fprintf(stderr, "Consumed reader with %zu entries from buffer %p\n", gr->length, gr->buffer);
-            *gr = gorilla_reader_init(next_buffer);
-            return gorilla_reader_read(gr, number);
+            *gr = reader_init<Reader>(next_buffer);
+            return reader_read(gr, number);
         }
     }
 
     // read the first number
     if (gr->index == 0) {
-        bit_buffer_read(data, gr->position, number, bit_size<uint32_t>());
+        bit_buffer_read(data, gr->position, number, bit_size<Word>());
 
         gr->index++;
-        gr->position += bit_size<uint32_t>();
+        gr->position += bit_size<Word>();
         gr->prev_number = *number;
         return true;
     }
@@ -339,14 +388,14 @@ bool gorilla_reader_read(gorilla_reader_t *gr, uint32_t *number)
     gr->position++;
 
     if (!same_xor_lzc) {
-        bit_buffer_read(data, gr->position, &xor_lzc, (bit_size<uint32_t>() == 32) ? 5 : 6);
-        gr->position += (bit_size<uint32_t>() == 32) ? 5 : 6;
+        bit_buffer_read(data, gr->position, &xor_lzc, lzc_bit_size<Word>());
+        gr->position += lzc_bit_size<Word>();
     }
 
     // process the non-lzc suffix
-    uint32_t xor_value = 0;
-    bit_buffer_read(data, gr->position, &xor_value, bit_size<uint32_t>() - xor_lzc);
-    gr->position += bit_size<uint32_t>() - xor_lzc;
+    Word xor_value = 0;
+    bit_buffer_read(data, gr->position, &xor_value, bit_size<Word>() - xor_lzc);
+    gr->position += bit_size<Word>() - xor_lzc;
 
     *number = (gr->prev_number ^ xor_value);
 
@@ -358,6 +407,218 @@ bool gorilla_reader_read(gorilla_reader_t *gr, uint32_t *number)
     return true;
 }
 
+/*
+ * Decode up to max numbers at once.
+ *
+ * The reader state is kept in local variables while decoding the numbers
+ * of the current buffer, and the buffer entries are re-checked only when
+ * they have been consumed.
+ *
+ * Repeated numbers are encoded as a single set bit each, so the bits of
+ * up to 32 numbers are tested at once: a run of repeated numbers costs a
+ * single read of the buffer, followed by a plain fill of the output that
+ * the compiler vectorizes.
+*/
+
+template <typename Word, typename Reader>
+static size_t reader_read_batch(Reader *gr, Word *numbers, size_t max)
+{
+    size_t n = 0;
+
+    while (n < max) {
+        if (gr->index == 0 || gr->index + 1 > gr->entries) {
+            // the first number of a buffer, or we have to check for more
+            // entries or for the next buffer - let the slow path handle it
+            if (!reader_read(gr, &numbers[n]))
+                break;
+
+            n++;
+            continue;
+        }
+
+        const uint32_t *data = gr->buffer->data;
+        const size_t entries = gr->entries;
+
+        size_t index = gr->index;
+        size_t position = gr->position;
+        Word prev_number = gr->prev_number;
+        uint32_t prev_xor_lzc = gr->prev_xor_lzc;
+        Word prev_xor = gr->prev_xor;
+
+        while (index < entries && n < max) {
+            // every remaining entry takes at least one bit,
+            // so these bits have been written already
+            size_t peek = entries - index;
+            if (peek > max - n)
+                peek = max - n;
+            if (peek > bit_size<uint32_t>())
+                peek = bit_size<uint32_t>();
+
+            // process the same-number bits, as many as possible at once
+            uint32_t same_number_bits;
+            bit_buffer_read(data, position, &same_number_bits, peek);
+
+            size_t run = (~same_number_bits) ? __builtin_ctz(~same_number_bits) : bit_size<uint32_t>();
+            if (run > peek)
+                run = peek;
+
+            if (run) {
+                for (size_t i = 0; i != run; i++)
+                    numbers[n + i] = prev_number;
+
+                n += run;
+                index += run;
+                position += run;
+                continue;
+            }
+
+            // the same-number bit is not set
+            position++;
+
+            // proceess same-xor-lzc bit
+            uint32_t same_xor_lzc;
+            bit_buffer_read(data, position, &same_xor_lzc, 1);
+            position++;
+
+            if (!same_xor_lzc) {
+                bit_buffer_read(data, position, &prev_xor_lzc, lzc_bit_size<Word>());
+                position += lzc_bit_size<Word>();
+            }
+
+            // process the non-lzc suffix
+            Word xor_value = 0;
+            bit_buffer_read(data, position, &xor_value, bit_size<Word>() - prev_xor_lzc);
+            position += bit_size<Word>() - prev_xor_lzc;
+
+            prev_number ^= xor_value;
+            prev_xor = xor_value;
+
+            numbers[n++] = prev_number;
+            index++;
+        }
+
+        gr->index = index;
+        gr->position = position;
+        gr->prev_number = prev_number;
+        gr->prev_xor_lzc = prev_xor_lzc;
+        gr->prev_xor = prev_xor;
+    }
+
+    return n;
+}
+
+/*
+ * 32-bit words
+*/
+
+gorilla_writer_t gorilla_writer_init(gorilla_buffer_t *gbuf, size_t n)
+{
+    return writer_init<gorilla_writer_t>(gbuf, n);
+}
+
+void gorilla_writer_add_buffer(gorilla_writer_t *gw, gorilla_buffer_t *gbuf, size_t n)
+{
+    writer_add_buffer(gw, gbuf, n);
+}
+
+uint32_t gorilla_writer_entries(const gorilla_writer_t *gw) {
+    return writer_entries(gw);
+}
+
+bool gorilla_writer_write(gorilla_writer_t *gw, uint32_t number)
+{
+    return writer_write(gw, number);
+}
+
+gorilla_buffer_t *gorilla_writer_drop_head_buffer(gorilla_writer_t *gw) {
+    return writer_drop_head_buffer(gw);
+}
+
+uint32_t gorilla_writer_nbytes(const gorilla_writer_t *gw)
+{
+    return writer_nbytes(gw);
+}
+
+bool gorilla_writer_serialize(const gorilla_writer_t *gw, uint8_t *dst, uint32_t dst_size) {
+    return writer_serialize(gw, dst, dst_size);
+}
+
+gorilla_reader_t gorilla_writer_get_reader(const gorilla_writer_t *gw)
+{
+    return writer_get_reader<gorilla_reader_t>(gw);
+}
+
+gorilla_reader_t gorilla_reader_init(gorilla_buffer_t *gbuf)
+{
+    return reader_init<gorilla_reader_t>(gbuf);
+}
+
+bool gorilla_reader_read(gorilla_reader_t *gr, uint32_t *number)
+{
+    return reader_read(gr, number);
+}
+
+size_t gorilla_reader_read_batch(gorilla_reader_t *gr, uint32_t *numbers, size_t max)
+{
+    return reader_read_batch(gr, numbers, max);
+}
+
+/*
+ * 64-bit words
+*/
+
+gorilla64_writer_t gorilla64_writer_init(gorilla_buffer_t *gbuf, size_t n)
+{
+    return writer_init<gorilla64_writer_t>(gbuf, n);
+}
+
+void gorilla64_writer_add_buffer(gorilla64_writer_t *gw, gorilla_buffer_t *gbuf, size_t n)
+{
+    writer_add_buffer(gw, gbuf, n);
+}
+
+uint32_t gorilla64_writer_entries(const gorilla64_writer_t *gw) {
+    return writer_entries(gw);
+}
+
+bool gorilla64_writer_write(gorilla64_writer_t *gw, uint64_t number)
+{
+    return writer_write(gw, number);
+}
+
+gorilla_buffer_t *gorilla64_writer_drop_head_buffer(gorilla64_writer_t *gw) {
+    return writer_drop_head_buffer(gw);
+}
+
+uint32_t gorilla64_writer_nbytes(const gorilla64_writer_t *gw)
+{
+    return writer_nbytes(gw);
+}
+
+bool gorilla64_writer_serialize(const gorilla64_writer_t *gw, uint8_t *dst, uint32_t dst_size) {
+    return writer_serialize(gw, dst, dst_size);
+}
+
+gorilla64_reader_t gorilla64_writer_get_reader(const gorilla64_writer_t *gw)
+{
+    return writer_get_reader<gorilla64_reader_t>(gw);
+}
+
+gorilla64_reader_t gorilla64_reader_init(gorilla_buffer_t *gbuf)
+{
+    return reader_init<gorilla64_reader_t>(gbuf);
+}
+
+bool gorilla64_reader_read(gorilla64_reader_t *gr, uint64_t *number)
+{
+    return reader_read(gr, number);
+}
+
+size_t gorilla64_reader_read_batch(gorilla64_reader_t *gr, uint64_t *numbers, size_t max)
+{
+    return reader_read_batch(gr, numbers, max);
+}
+
 /*
  * Internal code used for fuzzing the library
 */
@@ -445,6 +706,38 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
                 && "Read wrong number from gorilla buffer");
     }
 
+    /*
+     * write and read 64-bit data
+    */
+    std::vector<uint64_t> RandomData64 = random_vector<uint64_t>(Data, Size);
+
+    gorilla_buffer_t *first_buffer64 = S.alloc_buffer(words_per_buffer);
+    gorilla64_writer_t gw64 = gorilla64_writer_init(first_buffer64, words_per_buffer);
+
+    for (size_t i = 0; i != RandomData64.size(); i++) {
+        bool ok = gorilla64_writer_write(&gw64, RandomData64[i]);
+        if (ok)
+            continue;
+
+        // add new buffer
+        gorilla_buffer_t *buffer = S.alloc_buffer(words_per_buffer);
+        gorilla64_writer_add_buffer(&gw64, buffer, words_per_buffer);
+
+        ok = gorilla64_writer_write(&gw64, RandomData64[i]);
+        assert(ok && "Could not write data to new buffer!!!");
+    }
+
+    gorilla64_reader_t gr64 = gorilla64_writer_get_reader(&gw64);
+    std::vector<uint64_t> Numbers64(RandomData64.size());
+
+    size_t n = gorilla64_reader_read_batch(&gr64, Numbers64.data(), Numbers64.size());
+    assert((n == RandomData64.size()) && "Failed to read numbers from gorilla buffer");
+
+    for (size_t i = 0; i != n; i++) {
+        assert((Numbers64[i] == RandomData64[i])
+                && "Read wrong number from gorilla buffer");
+    }
+
     S.free_buffers();
     return 0;
 }
@@ -51,6 +51,39 @@ typedef struct {
     uint32_t prev_xor;
 } gorilla_reader_t;
 
+/*
+ * The 64-bit variant encodes 64-bit words (e.g. the bits of doubles) in
+ * the same buffers. The XOR'd values are prefixed by 6-bit LZCs instead
+ * of 5-bit ones, and the first value of each buffer takes 64 bits.
+*/
+
+typedef struct {
+    gorilla_buffer_t *head_buffer;
+    gorilla_buffer_t *last_buffer;
+
+    uint64_t prev_number;
+    uint32_t prev_xor_lzc;
+
+    // in bits
+    uint32_t capacity;
+} gorilla64_writer_t;
+
+typedef struct {
+    const gorilla_buffer_t *buffer;
+
+    // number of values
+    size_t entries;
+    size_t index;
+
+    // in bits
+    size_t capacity;
+    size_t position;
+
+    uint64_t prev_number;
+    uint32_t prev_xor_lzc;
+    uint64_t prev_xor;
+} gorilla64_reader_t;
+
 gorilla_writer_t gorilla_writer_init(gorilla_buffer_t *gbuf, size_t n);
 void gorilla_writer_add_buffer(gorilla_writer_t *gw, gorilla_buffer_t *gbuf, size_t n);
 bool gorilla_writer_write(gorilla_writer_t *gw, uint32_t number);
@@ -66,6 +99,23 @@ bool gorilla_writer_serialize(const gorilla_writer_t *gw, uint8_t *dst, uint32_t
 uint32_t gorilla_buffer_patch(gorilla_buffer_t *buf);
 gorilla_reader_t gorilla_reader_init(gorilla_buffer_t *buf);
 bool gorilla_reader_read(gorilla_reader_t *gr, uint32_t *number);
+size_t gorilla_reader_read_batch(gorilla_reader_t *gr, uint32_t *numbers, size_t max);
+
+gorilla64_writer_t gorilla64_writer_init(gorilla_buffer_t *gbuf, size_t n);
+void gorilla64_writer_add_buffer(gorilla64_writer_t *gw, gorilla_buffer_t *gbuf, size_t n);
+bool gorilla64_writer_write(gorilla64_writer_t *gw, uint64_t number);
+uint32_t gorilla64_writer_entries(const gorilla64_writer_t *gw);
+
+gorilla64_reader_t gorilla64_writer_get_reader(const gorilla64_writer_t *gw);
+
+gorilla_buffer_t *gorilla64_writer_drop_head_buffer(gorilla64_writer_t *gw);
+
+uint32_t gorilla64_writer_nbytes(const gorilla64_writer_t *gw);
+bool gorilla64_writer_serialize(const gorilla64_writer_t *gw, uint8_t *dst, uint32_t dst_size);
+
+gorilla64_reader_t gorilla64_reader_init(gorilla_buffer_t *buf);
+bool gorilla64_reader_read(gorilla64_reader_t *gr, uint64_t *number);
+size_t gorilla64_reader_read_batch(gorilla64_reader_t *gr, uint64_t *numbers, size_t max);
 
 #define RRDENG_GORILLA_32BIT_BUFFER_SLOTS 128
 #define RRDENG_GORILLA_32BIT_BUFFER_SIZE (RRDENG_GORILLA_32BIT_BUFFER_SLOTS * sizeof(uint32_t))
@@ -44,6 +44,7 @@ static struct {
 
     { .format = "text/plain",                   CT_PROMETHEUS, false, "version=0.0.4" },
     { .format = "prometheus",                   CT_PROMETHEUS },
+    { .format = "application/vnd.google.protobuf", CT_PROMETHEUS_PROTOBUF, false, "proto=io.prometheus.client.MetricFamily; encoding=delimited" },
     { .format = "text",                         CT_TEXT_PLAIN },
     { .format = "txt",                          CT_TEXT_PLAIN },
     { .format = "json",                         CT_APPLICATION_JSON },
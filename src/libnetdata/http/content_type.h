@@ -34,6 +34,7 @@ typedef enum __attribute__ ((__packed__)) {
     CT_APPLICATION_ZIP,
     CT_TEXT_YAML,
     CT_APPLICATION_YAML,
+    CT_PROMETHEUS_PROTOBUF,
 } HTTP_CONTENT_TYPE;
 
 HTTP_CONTENT_TYPE content_type_string2id(const char *format);
@@ -169,7 +169,69 @@ static inline uint32_t str2uint32_t(const char *s, char **endptr) {
     return n;
 }
 
-static inline uint64_t str2uint64_t(const char *s, char **endptr) {
+// ----------------------------------------------------------------------------
+// parsing 8 characters at a time (SWAR - SIMD within a register)
+//
+// 8 characters are loaded into a 64-bit integer, the leading digits are found
+// with a few arithmetic operations and are converted together. Loading 8 bytes
+// may read past the end of the string, so we do it only when the 8 bytes are on
+// the same memory page, which is mapped, since the string is on it.
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) && !defined(ENV32BIT) && !defined(__SANITIZE_ADDRESS__)
+#define NETDATA_SWAR_PARSING 1
+
+#define SWAR_ONES  0x0101010101010101ULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+static inline bool swar_load8(const char *s, uint64_t *chunk) {
+    if(unlikely(((uintptr_t)s & 4095) > 4096 - sizeof(uint64_t)))
+        return false;
+
+    memcpy(chunk, s, sizeof(uint64_t));
+    return true;
+}
+
+// the high bit of each byte is set when the byte is >= n - the bytes have to be below 128
+#define swar_bytes_ge(x, n) (((x) + (0x80 - (n)) * SWAR_ONES) & SWAR_HIGHS)
+
+// the high bit of the first byte that is below n (or equal to c) is set - higher bits may be set too
+#define swar_bytes_lt(x, n) (((x) - (n) * SWAR_ONES) & ~(x) & SWAR_HIGHS)
+#define swar_bytes_eq(x, c) swar_bytes_lt((x) ^ ((c) * SWAR_ONES), 1)
+
+// the number of leading bytes (in string order) that have their high bit set in mask
+static inline size_t swar_leading_bytes(uint64_t mask) {
+    uint64_t invalid = ~mask & SWAR_HIGHS;
+    return invalid ? (size_t)__builtin_ctzll(invalid) / 8 : 8;
+}
+
+// the index of the first byte that has its high bit set in mask
+static inline size_t swar_first_byte(uint64_t mask) {
+    return mask ? (size_t)__builtin_ctzll(mask) / 8 : 8;
+}
+
+static inline uint64_t swar_decimal_digits(uint64_t x) {
+    uint64_t y = x & ~SWAR_HIGHS;
+    return swar_bytes_ge(y, '0') & ~swar_bytes_ge(y, '9' + 1) & ~x & SWAR_HIGHS;
+}
+
+// the value of the first k (1 to 8) decimal digits of x
+static inline uint64_t swar_decimal_value(uint64_t x, size_t k) {
+    uint64_t keep = (k == 8) ? ~0ULL : ((1ULL << (8 * k)) - 1);
+
+    // the digits are moved to the end, so that the first bytes become leading zeros
+    x = ((x - 0x30 * SWAR_ONES) & keep) << (8 * (8 - k));
+
+    x = (x * 10) + (x >> 8);
+    x = (((x & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+         (((x >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+
+    return (uint32_t)x;
+}
+
+#endif // NETDATA_SWAR_PARSING
+
+// the byte at a time parser, the only one on builds without NETDATA_SWAR_PARSING
+static inline uint64_t str2uint64_t_bytes(const char *s, char **endptr) {
     uint64_t n = 0;
 
 #ifdef ENV32BIT
@@ -189,6 +251,35 @@ static inline uint64_t str2uint64_t(const char *s, char **endptr) {
     return n;
 }
 
+static inline uint64_t str2uint64_t(const char *s, char **endptr) {
+#ifdef NETDATA_SWAR_PARSING
+    static const uint64_t powers_of_10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+    uint64_t n = 0, chunk;
+
+    while(swar_load8(s, &chunk)) {
+        size_t k = swar_leading_bytes(swar_decimal_digits(chunk));
+        if(!k)
+            break;
+
+        n = n * powers_of_10[k] + swar_decimal_value(chunk, k);
+        s += k;
+
+        if(k < 8)
+            break;
+    }
+
+    while(*s >= '0' && *s <= '9')
+        n = n * 10 + (*s++ - '0');
+
+    if(unlikely(endptr))
+        *endptr = (char *)s;
+
+    return n;
+#else
+    return str2uint64_t_bytes(s, endptr);
+#endif
+}
+
 static inline unsigned long long int str2ull(const char *s, char **endptr) {
     return str2uint64_t(s, endptr);
 }
@@ -231,8 +231,6 @@
     }                                                                                                           \
 } while(0)
 
-typedef bool (*json_parse_function_payload_t)(json_object *jobj, const char *path, void *data, BUFFER *error);
 int rrd_call_function_error(BUFFER *wb, const char *msg, int code);
-struct json_object *json_parse_function_payload_or_error(BUFFER *output, BUFFER *payload, int *code, json_parse_function_payload_t cb, void *cb_data);
 
 #endif //NETDATA_JSON_C_PARSER_INLINE_H
@@ -0,0 +1,745 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../libnetdata.h"
+
+// ----------------------------------------------------------------------------
+// validation - the only pass that has to check anything
+
+static inline const char *jsp_ws(const char *s, const char *e) {
+    while(s < e && (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r'))
+        s++;
+
+    return s;
+}
+
+static inline bool jsp_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline bool jsp_is_hex(char c) {
+    return jsp_is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static const char *jsp_failed(JSON_STREAM *js, const char *pos, const char *error) {
+    js->error = error;
+    js->error_pos = pos - js->payload;
+    return NULL;
+}
+
+static const char *jsp_validate_string(JSON_STREAM *js, const char *s) {
+    const char *e = js->end;
+
+    // s is at the opening quote
+    for(s++; s < e ; s++) {
+        unsigned char c = (unsigned char)*s;
+
+        if(c == '"')
+            return s + 1;
+
+        if(c < 0x20)
+            return jsp_failed(js, s, "control character in string");
+
+        if(c == '\\') {
+            if(++s >= e)
+                break;
+
+            switch(*s) {
+                case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                    break;
+
+                case 'u':
+                    if(e - s < 5 || !jsp_is_hex(s[1]) || !jsp_is_hex(s[2]) || !jsp_is_hex(s[3]) || !jsp_is_hex(s[4]))
+                        return jsp_failed(js, s, "invalid unicode escape in string");
+                    s += 4;
+                    break;
+
+                default:
+                    return jsp_failed(js, s, "invalid escape in string");
+            }
+        }
+    }
+
+    return jsp_failed(js, s, "unterminated string");
+}
+
+static const char *jsp_validate_number(JSON_STREAM *js, const char *s) {
+    const char *e = js->end;
+    const char *start = s;
+
+    if(s < e && *s == '-')
+        s++;
+
+    if(s < e && *s == '0')
+        s++;
+    else if(s < e && jsp_is_digit(*s))
+        while(s < e && jsp_is_digit(*s)) s++;
+    else
+        return jsp_failed(js, start, "invalid value");
+
+    if(s < e && *s == '.') {
+        s++;
+        if(s >= e || !jsp_is_digit(*s))
+            return jsp_failed(js, s, "invalid number fraction");
+        while(s < e && jsp_is_digit(*s)) s++;
+    }
+
+    if(s < e && (*s == 'e' || *s == 'E')) {
+        s++;
+        if(s < e && (*s == '+' || *s == '-'))
+            s++;
+        if(s >= e || !jsp_is_digit(*s))
+            return jsp_failed(js, s, "invalid number exponent");
+        while(s < e && jsp_is_digit(*s)) s++;
+    }
+
+    return s;
+}
+
+static const char *jsp_validate_literal(JSON_STREAM *js, const char *s, const char *literal, size_t len) {
+    if((size_t)(js->end - s) < len || memcmp(s, literal, len) != 0)
+        return jsp_failed(js, s, "invalid value");
+
+    return s + len;
+}
+
+static const char *jsp_validate_value(JSON_STREAM *js, const char *s, size_t depth) {
+    const char *e = js->end;
+
+    s = jsp_ws(s, e);
+    if(s >= e)
+        return jsp_failed(js, s, "unexpected end of payload");
+
+    switch(*s) {
+        case '{':
+            if(depth >= JSON_STREAM_MAX_DEPTH)
+                return jsp_failed(js, s, "too deeply nested");
+
+            s = jsp_ws(s + 1, e);
+            if(s < e && *s == '}')
+                return s + 1;
+
+            while(true) {
+                if(s >= e || *s != '"')
+                    return jsp_failed(js, s, "expected a member name");
+
+                if(!(s = jsp_validate_string(js, s)))
+                    return NULL;
+
+                s = jsp_ws(s, e);
+                if(s >= e || *s != ':')
+                    return jsp_failed(js, s, "expected ':' after the member name");
+
+                if(!(s = jsp_validate_value(js, s + 1, depth + 1)))
+                    return NULL;
+
+                s = jsp_ws(s, e);
+                if(s < e && *s == ',')
+                    s = jsp_ws(s + 1, e);
+                else if(s < e && *s == '}')
+                    return s + 1;
+                else
+                    return jsp_failed(js, s, "expected ',' or '}' in object");
+            }
+
+        case '[':
+            if(depth >= JSON_STREAM_MAX_DEPTH)
+                return jsp_failed(js, s, "too deeply nested");
+
+            s = jsp_ws(s + 1, e);
+            if(s < e && *s == ']')
+                return s + 1;
+
+            while(true) {
+                if(!(s = jsp_validate_value(js, s, depth + 1)))
+                    return NULL;
+
+                s = jsp_ws(s, e);
+                if(s < e && *s == ',')
+                    s++;
+                else if(s < e && *s == ']')
+                    return s + 1;
+                else
+                    return jsp_failed(js, s, "expected ',' or ']' in array");
+            }
+
+        case '"':
+            return jsp_validate_string(js, s);
+
+        case 't':
+            return jsp_validate_literal(js, s, "true", 4);
+
+        case 'f':
+            return jsp_validate_literal(js, s, "false", 5);
+
+        case 'n':
+            return jsp_validate_literal(js, s, "null", 4);
+
+        default:
+            return jsp_validate_number(js, s);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// navigation - the payload is known to be valid, so nothing is checked
+
+static inline JSON_ENTRY_TYPE jsp_type(const char *s) {
+    switch(*s) {
+        case '{': return JSON_OBJECT;
+        case '[': return JSON_ARRAY;
+        case '"': return JSON_STRING;
+        case 't':
+        case 'f': return JSON_BOOLEAN;
+        case 'n': return JSON_NULL;
+        default:  return JSON_NUMBER;
+    }
+}
+
+// returns the closing quote
+static inline const char *jsp_string_end(const char *s) {
+    for(s++; *s != '"' ; s++)
+        if(*s == '\\') s++;
+
+    return s;
+}
+
+static const char *jsp_skip(const char *s, const char *e) {
+    switch(*s) {
+        case '"':
+            return jsp_string_end(s) + 1;
+
+        case '{':
+        case '[': {
+            size_t depth = 0;
+            do {
+                switch(*s) {
+                    case '"':
+                        s = jsp_string_end(s);
+                        break;
+
+                    case '{':
+                    case '[':
+                        depth++;
+                        break;
+
+                    case '}':
+                    case ']':
+                        depth--;
+                        break;
+                }
+                s++;
+            } while(depth);
+            return s;
+        }
+
+        default:
+            // numbers, true, false, null
+            while(s < e && *s != ',' && *s != '}' && *s != ']' && *s != ' ' && *s != '\t' && *s != '\n' && *s != '\r')
+                s++;
+            return s;
+    }
+}
+
+static inline void jsp_value(JSON_STREAM_VALUE *v, const char *s) {
+    v->pos = s;
+    v->type = jsp_type(s);
+}
+
+static inline uint32_t jsp_hex4(const char *s) {
+    uint32_t v = 0;
+    for(size_t i = 0; i < 4 ;i++) {
+        char c = s[i];
+        v <<= 4;
+        if(c >= '0' && c <= '9') v |= c - '0';
+        else if(c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else v |= c - 'A' + 10;
+    }
+    return v;
+}
+
+static inline char *jsp_utf8(char *d, uint32_t cp) {
+    if(cp < 0x80)
+        *d++ = (char)cp;
+    else if(cp < 0x800) {
+        *d++ = (char)(0xC0 | (cp >> 6));
+        *d++ = (char)(0x80 | (cp & 0x3F));
+    }
+    else if(cp < 0x10000) {
+        *d++ = (char)(0xE0 | (cp >> 12));
+        *d++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *d++ = (char)(0x80 | (cp & 0x3F));
+    }
+    else {
+        *d++ = (char)(0xF0 | (cp >> 18));
+        *d++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *d++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *d++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return d;
+}
+
+// unescape the text between s and e (the quotes excluded) to dst,
+// which should have at least e - s + 1 bytes - the unescaped text is never longer
+static size_t jsp_unescape(const char *s, const char *e, char *dst) {
+    char *d = dst;
+
+    while(s < e) {
+        const char *bs = memchr(s, '\\', e - s);
+        if(!bs) {
+            memcpy(d, s, e - s);
+            d += e - s;
+            break;
+        }
+
+        memcpy(d, s, bs - s);
+        d += bs - s;
+        s = bs + 1;
+
+        switch(*s++) {
+            case 'b': *d++ = '\b'; break;
+            case 'f': *d++ = '\f'; break;
+            case 'n': *d++ = '\n'; break;
+            case 'r': *d++ = '\r'; break;
+            case 't': *d++ = '\t'; break;
+
+            case 'u': {
+                uint32_t cp = jsp_hex4(s);
+                s += 4;
+
+                if(cp >= 0xD800 && cp <= 0xDBFF) {
+                    if(e - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+                        uint32_t low = jsp_hex4(&s[2]);
+                        if(low >= 0xDC00 && low <= 0xDFFF) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            s += 6;
+                        }
+                        else
+                            cp = 0xFFFD;
+                    }
+                    else
+                        cp = 0xFFFD;
+                }
+                else if(cp >= 0xDC00 && cp <= 0xDFFF)
+                    cp = 0xFFFD;
+
+                d = jsp_utf8(d, cp);
+                break;
+            }
+
+            default:
+                // '"', '\\' and '/'
+                *d++ = s[-1];
+                break;
+        }
+    }
+
+    *d = '\0';
+    return d - dst;
+}
+
+static bool jsp_key_matches(const char *k, const char *k_end, const char *member, size_t member_len) {
+    size_t len = k_end - k;
+
+    if(len == member_len && memcmp(k, member, len) == 0)
+        return true;
+
+    // an escaped key is longer than the member, but not more than 6 times
+    if(len <= member_len || len > member_len * 6 || !memchr(k, '\\', len))
+        return false;
+
+    char tmp[len + 1];
+    return jsp_unescape(k, k_end, tmp) == member_len && memcmp(tmp, member, member_len) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// public API
+
+bool json_stream_init(JSON_STREAM *js, const char *payload, size_t len, JSON_STREAM_VALUE *root) {
+    *js = (JSON_STREAM) {
+        .payload = payload,
+        .end = payload + len,
+    };
+
+    const char *s = jsp_validate_value(js, payload, 0);
+    if(!s)
+        return false;
+
+    s = jsp_ws(s, js->end);
+    if(s < js->end) {
+        jsp_failed(js, s, "unexpected characters after the end of the payload");
+        return false;
+    }
+
+    jsp_value(root, jsp_ws(payload, js->end));
+    return true;
+}
+
+void json_stream_cleanup(JSON_STREAM *js) {
+    buffer_free(js->scratch);
+    js->scratch = NULL;
+}
+
+bool json_stream_object_get(JSON_STREAM *js, JSON_STREAM_VALUE *obj, const char *member, JSON_STREAM_VALUE *value) {
+    if(!obj || obj->type != JSON_OBJECT)
+        return false;
+
+    const char *e = js->end;
+    size_t member_len = strlen(member);
+
+    const char *s = jsp_ws(obj->pos + 1, e);
+    while(*s != '}') {
+        const char *k_end = jsp_string_end(s);
+        bool found = jsp_key_matches(s + 1, k_end, member, member_len);
+
+        s = jsp_ws(jsp_ws(k_end + 1, e) + 1, e);
+        if(found) {
+            jsp_value(value, s);
+            return true;
+        }
+
+        s = jsp_ws(jsp_skip(s, e), e);
+        if(*s == ',')
+            s = jsp_ws(s + 1, e);
+    }
+
+    return false;
+}
+
+void json_stream_iterator_init(JSON_STREAM *js, JSON_STREAM_VALUE *v, JSON_STREAM_ITERATOR *it) {
+    it->index = 0;
+
+    if(v && (v->type == JSON_OBJECT || v->type == JSON_ARRAY)) {
+        it->close = (v->type == JSON_OBJECT) ? '}' : ']';
+        it->pos = jsp_ws(v->pos + 1, js->end);
+        if(*it->pos == it->close)
+            it->pos = NULL;
+    }
+    else {
+        it->close = '\0';
+        it->pos = NULL;
+    }
+}
+
+static inline void jsp_iterator_advance(JSON_STREAM *js, JSON_STREAM_ITERATOR *it, const char *s) {
+    s = jsp_ws(jsp_skip(s, js->end), js->end);
+    it->pos = (*s == ',') ? jsp_ws(s + 1, js->end) : NULL;
+    it->index++;
+}
+
+bool json_stream_object_next(JSON_STREAM *js, JSON_STREAM_ITERATOR *it, BUFFER *key, JSON_STREAM_VALUE *value) {
+    if(!it->pos || it->close != '}')
+        return false;
+
+    const char *s = it->pos;
+    const char *k_end = jsp_string_end(s);
+
+    if(key) {
+        buffer_flush(key);
+        buffer_need_bytes(key, k_end - s);
+        key->len = jsp_unescape(s + 1, k_end, key->buffer);
+    }
+
+    s = jsp_ws(jsp_ws(k_end + 1, js->end) + 1, js->end);
+    jsp_value(value, s);
+    jsp_iterator_advance(js, it, s);
+    return true;
+}
+
+bool json_stream_array_next(JSON_STREAM *js, JSON_STREAM_ITERATOR *it, JSON_STREAM_VALUE *value) {
+    if(!it->pos || it->close != ']')
+        return false;
+
+    jsp_value(value, it->pos);
+    jsp_iterator_advance(js, it, it->pos);
+    return true;
+}
+
+size_t json_stream_array_length(JSON_STREAM *js, JSON_STREAM_VALUE *array) {
+    JSON_STREAM_ITERATOR it;
+    JSON_STREAM_VALUE v;
+
+    json_stream_iterator_init(js, array, &it);
+    while(json_stream_array_next(js, &it, &v)) ;
+
+    return it.index;
+}
+
+const char *json_stream_string(JSON_STREAM *js, JSON_STREAM_VALUE *v) {
+    if(!v || v->type != JSON_STRING)
+        return NULL;
+
+    const char *e = jsp_string_end(v->pos);
+    size_t len = e - v->pos;
+
+    if(!js->scratch)
+        js->scratch = buffer_create(len + 1, NULL);
+
+    buffer_flush(js->scratch);
+    buffer_need_bytes(js->scratch, len);
+    js->scratch->len = jsp_unescape(v->pos + 1, e, js->scratch->buffer);
+    return js->scratch->buffer;
+}
+
+bool json_stream_number_is_integer(JSON_STREAM_VALUE *v) {
+    if(v->type != JSON_NUMBER)
+        return false;
+
+    for(const char *s = (*v->pos == '-') ? v->pos + 1 : v->pos; ; s++) {
+        if(*s == '.' || *s == 'e' || *s == 'E')
+            return false;
+        if(!jsp_is_digit(*s))
+            return true;
+    }
+}
+
+// numbers are copied, since the payload is not necessarily terminated after them
+static bool jsp_number_copy(JSON_STREAM *js, JSON_STREAM_VALUE *v, char *dst, size_t size) {
+    if(v->type != JSON_NUMBER)
+        return false;
+
+    size_t len = jsp_skip(v->pos, js->end) - v->pos;
+    if(len >= size)
+        return false;
+
+    memcpy(dst, v->pos, len);
+    dst[len] = '\0';
+    return true;
+}
+
+int64_t json_stream_int64(JSON_STREAM *js, JSON_STREAM_VALUE *v) {
+    char tmp[64];
+    if(!jsp_number_copy(js, v, tmp, sizeof(tmp)))
+        return 0;
+
+    if(json_stream_number_is_integer(v))
+        return strtoll(tmp, NULL, 10);
+
+    return (int64_t)strtod(tmp, NULL);
+}
+
+uint64_t json_stream_uint64(JSON_STREAM *js, JSON_STREAM_VALUE *v) {
+    char tmp[64];
+    if(!jsp_number_copy(js, v, tmp, sizeof(tmp)) || *tmp == '-')
+        return 0;
+
+    if(json_stream_number_is_integer(v))
+        return strtoull(tmp, NULL, 10);
+
+    return (uint64_t)strtod(tmp, NULL);
+}
+
+NETDATA_DOUBLE json_stream_double(JSON_STREAM *js, JSON_STREAM_VALUE *v) {
+    char tmp[64];
+    if(!jsp_number_copy(js, v, tmp, sizeof(tmp)))
+        return NAN;
+
+    return (NETDATA_DOUBLE)strtod(tmp, NULL);
+}
+
+bool json_stream_parse_function_payload_or_error(BUFFER *output, BUFFER *payload, int *code, json_stream_parse_function_payload_t cb, void *cb_data) {
+    if(!payload || !buffer_strlen(payload)) {
+        *code = rrd_call_function_error(output, "No payload given", HTTP_RESP_BAD_REQUEST);
+        return false;
+    }
+
+    CLEAN_JSON_STREAM js = { 0 };
+    JSON_STREAM_VALUE root;
+    if(!json_stream_init(&js, buffer_tostring(payload), buffer_strlen(payload), &root)) {
+        char tmp[strlen(js.error) + 100];
+        snprintfz(tmp, sizeof(tmp), "JSON parser failed: %s at position %zu", js.error, js.error_pos);
+        *code = rrd_call_function_error(output, tmp, HTTP_RESP_BAD_REQUEST);
+        return false;
+    }
+
+    CLEAN_BUFFER *error = buffer_create(0, NULL);
+    if(!cb(&js, &root, "", cb_data, error)) {
+        char tmp[buffer_strlen(error) + 100];
+        snprintfz(tmp, sizeof(tmp), "JSON parser failed: %s", buffer_tostring(error));
+        *code = rrd_call_function_error(output, tmp, HTTP_RESP_BAD_REQUEST);
+        return false;
+    }
+
+    *code = HTTP_RESP_OK;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+static int json_stream_unittest_invalid(void) {
+    const char *invalid[] = {
+        "",
+        "   ",
+        "{",
+        "}",
+        "{\"a\":}",
+        "{\"a\" 1}",
+        "{\"a\":1,}",
+        "{a:1}",
+        "[1,]",
+        "[1 2]",
+        "[01]",
+        "-",
+        "1.",
+        "1e",
+        "tru",
+        "nul",
+        "\"abc",
+        "\"a\nb\"",
+        "\"\\x\"",
+        "\"\\u12G4\"",
+        "{} x",
+        NULL,
+    };
+
+    int errors = 0;
+    for(size_t i = 0; invalid[i] ;i++) {
+        CLEAN_JSON_STREAM js = { 0 };
+        JSON_STREAM_VALUE root;
+        if(json_stream_init(&js, invalid[i], strlen(invalid[i]), &root)) {
+            fprintf(stderr, " > JSON STREAM: '%s' should not be accepted\n", invalid[i]);
+            errors++;
+        }
+    }
+
+    char deep[JSON_STREAM_MAX_DEPTH * 2 + 3];
+    memset(deep, '[', JSON_STREAM_MAX_DEPTH + 1);
+    memset(&deep[JSON_STREAM_MAX_DEPTH + 1], ']', JSON_STREAM_MAX_DEPTH + 1);
+    deep[sizeof(deep) - 1] = '\0';
+    {
+        CLEAN_JSON_STREAM js = { 0 };
+        JSON_STREAM_VALUE root;
+        if(json_stream_init(&js, deep, strlen(deep), &root)) {
+            fprintf(stderr, " > JSON STREAM: %d nested arrays should not be accepted\n", JSON_STREAM_MAX_DEPTH + 1);
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+struct json_stream_unittest_data {
+    bool b;
+    int64_t i;
+    uint64_t u;
+    NETDATA_DOUBLE d;
+    NETDATA_DOUBLE n;
+    STRING *s;
+    nd_uuid_t uuid;
+    int64_t nested;
+};
+
+static bool json_stream_unittest_nested(JSON_STREAM *js, JSON_STREAM_VALUE *obj, const char *path, struct json_stream_unittest_data *d, BUFFER *error, bool required) {
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, obj, path, "value", d->nested, error, required);
+    return true;
+}
+
+static bool json_stream_unittest_parse(JSON_STREAM *js, JSON_STREAM_VALUE *root, const char *path, void *data, BUFFER *error) {
+    struct json_stream_unittest_data *d = data;
+    JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, root, path, "b", d->b, error, true);
+    JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, root, path, "i", d->i, error, true);
+    JSONS_PARSE_UINT64_OR_ERROR_AND_RETURN(js, root, path, "u", d->u, error, true);
+    JSONS_PARSE_DOUBLE_OR_ERROR_AND_RETURN(js, root, path, "d", d->d, error, true);
+    JSONS_PARSE_DOUBLE_OR_ERROR_AND_RETURN(js, root, path, "n", d->n, error, true);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, root, path, "s", d->s, error, true);
+    JSONS_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(js, root, path, "uuid", d->uuid, error, true);
+    JSONS_PARSE_SUBOBJECT(js, root, path, "nested", d, json_stream_unittest_nested, error, true);
+    return true;
+}
+
+int json_stream_unittest(void) {
+    fprintf(stderr, "\nChecking the JSON stream parser...\n");
+
+    int errors = json_stream_unittest_invalid();
+
+    const char *json =
+        " { \"b\" : true, \"i\": -42, \"u\": 18446744073709551615, \"d\": 1.5e3, \"n\": null,"
+        "   \"skip\": { \"x\": [1, {\"y\": \"}]\"}, \"\\\"\"], \"z\": {} },"
+        "   \"s\": \"a\\\"b\\\\c\\/d\\n\\u00e9\\ud83d\\ude00\","
+        "   \"u\\u0075id\": \"0c9a1a24-8621-4f2d-9b6b-6b7c2c7e2a6e\","
+        "   \"nested\": { \"value\": 7.9 },"
+        "   \"array\": [ \"one\", 2, false, null, [3], {\"four\": 4} ],"
+        "   \"empty\": [] } ";
+
+    CLEAN_BUFFER *payload = buffer_create(0, NULL);
+    buffer_strcat(payload, json);
+
+    CLEAN_BUFFER *output = buffer_create(0, NULL);
+    struct json_stream_unittest_data d = { 0 };
+    int code = 0;
+    if(!json_stream_parse_function_payload_or_error(output, payload, &code, json_stream_unittest_parse, &d) || code != HTTP_RESP_OK) {
+        fprintf(stderr, " > JSON STREAM: parsing failed with code %d: %s\n", code, buffer_tostring(output));
+        errors++;
+    }
+    else {
+        char uuid[UUID_STR_LEN];
+        uuid_unparse_lower(d.uuid, uuid);
+
+        if(!d.b) { fprintf(stderr, " > JSON STREAM: boolean is wrong\n"); errors++; }
+        if(d.i != -42) { fprintf(stderr, " > JSON STREAM: int64 is %"PRId64"\n", d.i); errors++; }
+        if(d.u != UINT64_MAX) { fprintf(stderr, " > JSON STREAM: uint64 is %"PRIu64"\n", d.u); errors++; }
+        if(d.d != 1500.0) { fprintf(stderr, " > JSON STREAM: double is " NETDATA_DOUBLE_FORMAT "\n", d.d); errors++; }
+        if(!isnan(d.n)) { fprintf(stderr, " > JSON STREAM: null double is not NAN\n"); errors++; }
+        if(d.nested != 7) { fprintf(stderr, " > JSON STREAM: nested int64 is %"PRId64"\n", d.nested); errors++; }
+        if(strcmp(string2str(d.s), "a\"b\\c/d\n\xc3\xa9\xf0\x9f\x98\x80") != 0) {
+            fprintf(stderr, " > JSON STREAM: string is '%s'\n", string2str(d.s));
+            errors++;
+        }
+        if(strcmp(uuid, "0c9a1a24-8621-4f2d-9b6b-6b7c2c7e2a6e") != 0) {
+            fprintf(stderr, " > JSON STREAM: escaped member name is not matched, uuid is '%s'\n", uuid);
+            errors++;
+        }
+    }
+    string_freez(d.s);
+
+    // walk the arrays and the objects
+    CLEAN_JSON_STREAM js = { 0 };
+    JSON_STREAM_VALUE root, v, item;
+    if(!json_stream_init(&js, json, strlen(json), &root)) {
+        fprintf(stderr, " > JSON STREAM: parsing failed: %s at %zu\n", js.error, js.error_pos);
+        return 1;
+    }
+
+    JSON_ENTRY_TYPE types[] = { JSON_STRING, JSON_NUMBER, JSON_BOOLEAN, JSON_NULL, JSON_ARRAY, JSON_OBJECT };
+    if(!json_stream_object_get(&js, &root, "array", &v) || json_stream_array_length(&js, &v) != 6) {
+        fprintf(stderr, " > JSON STREAM: array is not found, or has wrong length\n");
+        errors++;
+    }
+    else {
+        JSON_STREAM_ITERATOR it;
+        json_stream_iterator_init(&js, &v, &it);
+        while(json_stream_array_next(&js, &it, &item)) {
+            if(item.type != types[it.index - 1]) {
+                fprintf(stderr, " > JSON STREAM: array item %zu has type %d\n", it.index - 1, item.type);
+                errors++;
+            }
+        }
+    }
+
+    if(!json_stream_object_get(&js, &root, "empty", &v) || json_stream_array_length(&js, &v) != 0) {
+        fprintf(stderr, " > JSON STREAM: empty array is not empty\n");
+        errors++;
+    }
+
+    if(json_stream_object_get(&js, &root, "x", &v) || json_stream_object_get(&js, &root, "y", &v)) {
+        fprintf(stderr, " > JSON STREAM: members of nested objects are found at the top level\n");
+        errors++;
+    }
+
+    const char *members[] = { "b", "i", "u", "d", "n", "skip", "s", "uuid", "nested", "array", "empty" };
+    CLEAN_BUFFER *key = buffer_create(0, NULL);
+    JSON_STREAM_ITERATOR it;
+    json_stream_iterator_init(&js, &root, &it);
+    while(json_stream_object_next(&js, &it, key, &v)) {
+        if(it.index > sizeof(members) / sizeof(members[0]) || strcmp(buffer_tostring(key), members[it.index - 1]) != 0) {
+            fprintf(stderr, " > JSON STREAM: member %zu is '%s'\n", it.index - 1, buffer_tostring(key));
+            errors++;
+        }
+    }
+    if(it.index != sizeof(members) / sizeof(members[0])) {
+        fprintf(stderr, " > JSON STREAM: iterated %zu members, expected %zu\n", it.index, sizeof(members) / sizeof(members[0]));
+        errors++;
+    }
+
+    fprintf(stderr, "JSON stream parser %s\n", errors ? "FAILED" : "OK");
+    return errors ? 1 : 0;
+}
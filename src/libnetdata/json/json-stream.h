@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_JSON_STREAM_H
+#define NETDATA_JSON_STREAM_H
+
+// An on-demand JSON parser for the payloads of functions and dyncfg.
+//
+// The payload is validated once, in a single pass that allocates nothing.
+// Then the members and the array items are looked up directly in the text
+// of the payload, and only the values actually read are converted, straight
+// into the structures of the callers. No tree of objects is built.
+//
+// A JSON_STREAM_VALUE is just a position in the payload, so it is valid
+// for as long as the payload is.
+
+#define JSON_STREAM_MAX_DEPTH 128
+
+typedef struct json_stream {
+    const char *payload;
+    const char *end;
+    BUFFER *scratch;                // strings are unescaped here
+    const char *error;              // why the validation failed
+    size_t error_pos;               // the offset in the payload it failed
+} JSON_STREAM;
+
+typedef struct json_stream_value {
+    JSON_ENTRY_TYPE type;
+    const char *pos;                // the first character of the value
+} JSON_STREAM_VALUE;
+
+typedef struct json_stream_iterator {
+    const char *pos;                // the next member or item, NULL when done
+    char close;                     // '}' for objects, ']' for arrays
+    size_t index;
+} JSON_STREAM_ITERATOR;
+
+bool json_stream_init(JSON_STREAM *js, const char *payload, size_t len, JSON_STREAM_VALUE *root);
+void json_stream_cleanup(JSON_STREAM *js);
+#define CLEAN_JSON_STREAM _cleanup_(json_stream_cleanup) JSON_STREAM
+
+// the first member with this name, false when there is not any (or obj is not an object)
+bool json_stream_object_get(JSON_STREAM *js, JSON_STREAM_VALUE *obj, const char *member, JSON_STREAM_VALUE *value);
+
+void json_stream_iterator_init(JSON_STREAM *js, JSON_STREAM_VALUE *v, JSON_STREAM_ITERATOR *it);
+bool json_stream_object_next(JSON_STREAM *js, JSON_STREAM_ITERATOR *it, BUFFER *key, JSON_STREAM_VALUE *value);
+bool json_stream_array_next(JSON_STREAM *js, JSON_STREAM_ITERATOR *it, JSON_STREAM_VALUE *value);
+size_t json_stream_array_length(JSON_STREAM *js, JSON_STREAM_VALUE *array);
+
+// unescaped into js->scratch, valid until the next call - NULL when v is not a string
+const char *json_stream_string(JSON_STREAM *js, JSON_STREAM_VALUE *v);
+
+bool json_stream_number_is_integer(JSON_STREAM_VALUE *v);
+int64_t json_stream_int64(JSON_STREAM *js, JSON_STREAM_VALUE *v);
+uint64_t json_stream_uint64(JSON_STREAM *js, JSON_STREAM_VALUE *v);
+NETDATA_DOUBLE json_stream_double(JSON_STREAM *js, JSON_STREAM_VALUE *v);
+
+static inline bool json_stream_boolean(JSON_STREAM_VALUE *v) {
+    return v->type == JSON_BOOLEAN && *v->pos == 't';
+}
+
+// ----------------------------------------------------------------------------
+// the equivalents of the JSONC_PARSE_* macros
+
+#define JSONS_PARSE_BOOL_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {                  \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v) && _v.type == JSON_BOOLEAN)                                \
+        dst = json_stream_boolean(&_v);                                                                         \
+    else if(required) {                                                                                         \
+        buffer_sprintf(error, "missing or invalid type for '%s.%s' boolean", path, member);                     \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {            \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v) && _v.type == JSON_STRING) {                               \
+        string_freez(dst);                                                                                      \
+        dst = string_strdupz(json_stream_string(js, &_v));                                                      \
+    }                                                                                                           \
+    else if(required) {                                                                                         \
+        buffer_sprintf(error, "missing or invalid type for '%s.%s' string", path, member);                      \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_TXT2STRDUPZ_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {           \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v) && _v.type == JSON_STRING) {                               \
+        freez((void *)dst);                                                                                     \
+        dst = strdupz(json_stream_string(js, &_v));                                                             \
+    }                                                                                                           \
+    else if(required) {                                                                                         \
+        buffer_sprintf(error, "missing or invalid type for '%s.%s' string", path, member);                      \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {              \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v)) {                                                         \
+        if (_v.type == JSON_STRING) {                                                                           \
+            if (uuid_parse(json_stream_string(js, &_v), dst) != 0) {                                            \
+                if(required) {                                                                                  \
+                    buffer_sprintf(error, "invalid UUID '%s.%s'", path, member);                                \
+                    return false;                                                                               \
+                }                                                                                               \
+                else                                                                                            \
+                    uuid_clear(dst);                                                                            \
+            }                                                                                                   \
+        }                                                                                                       \
+        else if (_v.type == JSON_NULL) {                                                                        \
+            uuid_clear(dst);                                                                                    \
+        }                                                                                                       \
+        else if (required) {                                                                                    \
+            buffer_sprintf(error, "expected UUID or null '%s.%s'", path, member);                               \
+            return false;                                                                                       \
+        }                                                                                                       \
+    }                                                                                                           \
+    else if (required) {                                                                                        \
+        buffer_sprintf(error, "missing UUID '%s.%s'", path, member);                                            \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_TXT2PATTERN_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {           \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v) && _v.type == JSON_STRING) {                               \
+        string_freez(dst);                                                                                      \
+        const char *_s = json_stream_string(js, &_v);                                                           \
+        if(strcmp(_s, "*") == 0)                                                                                \
+            dst = NULL;                                                                                         \
+        else                                                                                                    \
+            dst = string_strdupz(_s);                                                                           \
+    }                                                                                                           \
+    else if(required) {                                                                                         \
+        buffer_sprintf(error, "missing or invalid type for '%s.%s' string", path, member);                      \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_TXT2EXPRESSION_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {        \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v) && _v.type == JSON_STRING) {                               \
+        const char *_t = json_stream_string(js, &_v);                                                           \
+        if(_t && *_t && strcmp(_t, "*") != 0) {                                                                 \
+            const char *_failed_at = NULL;                                                                      \
+            int _err = 0;                                                                                       \
+            expression_free(dst);                                                                               \
+            dst = expression_parse(_t, &_failed_at, &_err);                                                     \
+            if(!dst) {                                                                                          \
+                buffer_sprintf(error, "expression '%s.%s' has a non-parseable expression '%s': %s at '%s'",     \
+                               path, member, _t, expression_strerror(_err), _failed_at);                        \
+                return false;                                                                                   \
+            }                                                                                                   \
+        }                                                                                                       \
+    }                                                                                                           \
+    else if(required) {                                                                                         \
+        buffer_sprintf(error, "missing or invalid type for '%s.%s' expression", path, member);                  \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_ARRAY_OF_TXT2BITMAP_OR_ERROR_AND_RETURN(js, obj, path, member, converter, dst, error, required) do { \
+    JSON_STREAM_VALUE _array;                                                                                   \
+    if (json_stream_object_get(js, obj, member, &_array) && _array.type == JSON_ARRAY) {                        \
+        JSON_STREAM_ITERATOR _it;                                                                               \
+        JSON_STREAM_VALUE _item;                                                                                \
+        json_stream_iterator_init(js, &_array, &_it);                                                           \
+        dst = 0;                                                                                                \
+        while (json_stream_array_next(js, &_it, &_item)) {                                                      \
+            if (_item.type != JSON_STRING) {                                                                    \
+                buffer_sprintf(error, "invalid type for '%s.%s' at index %zu", path, member, _it.index - 1);    \
+                return false;                                                                                   \
+            }                                                                                                   \
+            const char *_option_str = json_stream_string(js, &_item);                                           \
+            typeof(dst) _bit = converter(_option_str);                                                          \
+            if (_bit == 0) {                                                                                    \
+                buffer_sprintf(error, "unknown option '%s' in '%s.%s' at index %zu",                            \
+                               _option_str, path, member, _it.index - 1);                                       \
+                return false;                                                                                   \
+            }                                                                                                   \
+            dst |= _bit;                                                                                        \
+        }                                                                                                       \
+    } else if(required) {                                                                                       \
+        buffer_sprintf(error, "missing or invalid type for '%s.%s' array", path, member);                       \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(js, obj, path, member, converter, dst, error, required) do {   \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v) && _v.type == JSON_STRING)                                 \
+        dst = converter(json_stream_string(js, &_v));                                                           \
+    else if(required) {                                                                                         \
+        buffer_sprintf(error, "missing or invalid type (expected text value) for '%s.%s' enum", path, member);  \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_INT64_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {                 \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v)) {                                                         \
+        if (_v.type == JSON_NUMBER)                                                                             \
+            dst = (typeof(dst))json_stream_int64(js, &_v);                                                      \
+        else if (_v.type == JSON_NULL)                                                                          \
+            dst = 0;                                                                                            \
+        else {                                                                                                  \
+            buffer_sprintf(error, "not supported type (expected int) for '%s.%s'", path, member);               \
+            return false;                                                                                       \
+        }                                                                                                       \
+    } else if(required) {                                                                                       \
+        buffer_sprintf(error, "missing or invalid type (expected int value or null) for '%s.%s'", path, member);\
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_UINT64_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {                \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v)) {                                                         \
+        if (_v.type == JSON_NUMBER)                                                                             \
+            dst = (typeof(dst))json_stream_uint64(js, &_v);                                                     \
+        else if (_v.type == JSON_NULL)                                                                          \
+            dst = 0;                                                                                            \
+        else {                                                                                                  \
+            buffer_sprintf(error, "not supported type (expected int) for '%s.%s'", path, member);               \
+            return false;                                                                                       \
+        }                                                                                                       \
+    } else if(required) {                                                                                       \
+        buffer_sprintf(error, "missing or invalid type (expected int value or null) for '%s.%s'", path, member);\
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_DOUBLE_OR_ERROR_AND_RETURN(js, obj, path, member, dst, error, required) do {                \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v)) {                                                         \
+        if (_v.type == JSON_NUMBER)                                                                             \
+            dst = (typeof(dst))json_stream_double(js, &_v);                                                     \
+        else if (_v.type == JSON_NULL)                                                                          \
+            dst = NAN;                                                                                          \
+        else {                                                                                                  \
+            buffer_sprintf(error, "not supported type (expected double) for '%s.%s'", path, member);            \
+            return false;                                                                                       \
+        }                                                                                                       \
+    } else if(required) {                                                                                       \
+        buffer_sprintf(error, "missing or invalid type (expected double value or null) for '%s.%s'", path, member); \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+#define JSONS_PARSE_SUBOBJECT(js, obj, path, member, dst, callback, error, required) do {                       \
+    JSON_STREAM_VALUE _v;                                                                                       \
+    if (json_stream_object_get(js, obj, member, &_v)) {                                                         \
+        char _new_path[strlen(path) + strlen(member) + 2];                                                      \
+        snprintfz(_new_path, sizeof(_new_path), "%s%s%s", path, *path?".":"", member);                          \
+        if (!callback(js, &_v, _new_path, dst, error, required)) {                                              \
+            return false;                                                                                       \
+        }                                                                                                       \
+    } else if(required) {                                                                                       \
+        buffer_sprintf(error, "missing '%s.%s' object", path, member);                                          \
+        return false;                                                                                           \
+    }                                                                                                           \
+} while(0)
+
+typedef bool (*json_stream_parse_function_payload_t)(JSON_STREAM *js, JSON_STREAM_VALUE *root, const char *path, void *data, BUFFER *error);
+bool json_stream_parse_function_payload_or_error(BUFFER *output, BUFFER *payload, int *code, json_stream_parse_function_payload_t cb, void *cb_data);
+
+int json_stream_unittest(void);
+
+#endif //NETDATA_JSON_STREAM_H
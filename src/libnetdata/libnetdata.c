@@ -407,35 +407,44 @@ void freez_int(void *ptr, const char *file, const char *function, size_t line) {
 char *strdupz(const char *s) {
     char *t = strdup(s);
     if (unlikely(!t)) fatal("Cannot strdup() string '%s'", s);
+    if (unlikely(malloc_sampling_enabled())) malloc_sampling_alloc(t, strlen(t) + 1);
     return t;
 }
 
 char *strndupz(const char *s, size_t len) {
     char *t = strndup(s, len);
     if (unlikely(!t)) fatal("Cannot strndup() string '%s' of len %zu", s, len);
+    if (unlikely(malloc_sampling_enabled())) malloc_sampling_alloc(t, strlen(t) + 1);
     return t;
 }
 
 // If ptr is NULL, no operation is performed.
 void freez(void *ptr) {
-    if(likely(ptr)) free(ptr);
+    if(likely(ptr)) {
+        malloc_sampling_free(ptr);
+        free(ptr);
+    }
 }
 
 void *mallocz(size_t size) {
     void *p = malloc(size);
     if (unlikely(!p)) fatal("Cannot allocate %zu bytes of memory.", size);
+    malloc_sampling_alloc(p, size);
     return p;
 }
 
 void *callocz(size_t nmemb, size_t size) {
     void *p = calloc(nmemb, size);
     if (unlikely(!p)) fatal("Cannot allocate %zu bytes of memory.", nmemb * size);
+    malloc_sampling_alloc(p, nmemb * size);
     return p;
 }
 
 void *reallocz(void *ptr, size_t size) {
+    if(ptr) malloc_sampling_free(ptr);
     void *p = realloc(ptr, size);
     if (unlikely(!p)) fatal("Cannot re-allocate memory to %zu bytes.", size);
+    malloc_sampling_alloc(p, size);
     return p;
 }
 
@@ -558,6 +567,19 @@ inline int madvise_dontdump(void *mem __maybe_unused, size_t len __maybe_unused)
 #endif
 }
 
+inline int madvise_hugepage(void *mem __maybe_unused, size_t len __maybe_unused) {
+#ifdef MADV_HUGEPAGE
+    static int logger = 1;
+    int ret = madvise(mem, len, MADV_HUGEPAGE);
+
+    if (ret != 0 && logger-- > 0)
+        netdata_log_error("madvise(MADV_HUGEPAGE) failed.");
+    return ret;
+#else
+    return 0;
+#endif
+}
+
 inline int madvise_mergeable(void *mem __maybe_unused, size_t len __maybe_unused) {
 #ifdef MADV_MERGEABLE
     static int logger = 1;
@@ -307,6 +307,12 @@ typedef uint32_t uid_t;
 #define WARNUNUSED
 #endif
 
+#ifdef HAVE_FUNC_ATTRIBUTE_TARGET_CLONES
+#define SIMD_CLONES __attribute__ ((target_clones("avx2", "default")))
+#else
+#define SIMD_CLONES
+#endif
+
 #include "libjudy/judy-malloc.h"
 
 #define ABS(x) (((x) < 0)? (-(x)) : (x))
@@ -334,6 +340,7 @@ int madvise_willneed(void *mem, size_t len);
 int madvise_dontneed(void *mem, size_t len);
 int madvise_dontdump(void *mem, size_t len);
 int madvise_mergeable(void *mem, size_t len);
+int madvise_hugepage(void *mem, size_t len);
 
 int  vsnprintfz(char *dst, size_t n, const char *fmt, va_list args);
 int  snprintfz(char *dst, size_t n, const char *fmt, ...) PRINTFLIKE(3, 4);
@@ -438,6 +445,7 @@ extern const char *netdata_configured_host_prefix;
 #include "xxhash.h"
 
 #include "uuid/uuid.h"
+#include "uuid/uuidmap.h"
 #include "template-enum.h"
 #include "http/http_access.h"
 #include "http/content_type.h"
@@ -462,6 +470,7 @@ extern const char *netdata_configured_host_prefix;
 #include "log/log.h"
 #include "spawn_server/spawn_server.h"
 #include "spawn_server/spawn_popen.h"
+#include "shm_ring/shm_ring.h"
 #include "simple_pattern/simple_pattern.h"
 #include "socket/security.h"
 #include "socket/socket.h"
@@ -483,10 +492,14 @@ extern const char *netdata_configured_host_prefix;
 #include "url/url.h"
 #include "json/json.h"
 #include "json/json-c-parser-inline.h"
+#include "json/json-stream.h"
 #include "string/utf8.h"
 #include "libnetdata/aral/aral.h"
 #include "onewayalloc/onewayalloc.h"
 #include "worker_utilization/worker_utilization.h"
+#include "executor/executor.h"
+#include "sampling_profiler/sampling_profiler.h"
+#include "malloc_sampling/malloc_sampling.h"
 #include "yaml.h"
 #include "http/http_defs.h"
 #include "gorilla/gorilla.h"
@@ -31,7 +31,29 @@ extern bool isspace_map_config[256];
 extern bool isspace_map_group_by_label[256];
 extern bool isspace_dyncfg_id_map[256];
 
-static inline size_t quoted_strings_splitter(char *str, char **words, size_t max_words, bool *isspace_map) {
+// skips the characters that cannot end a pluginsd word, 8 at a time:
+// everything except control characters, spaces, '=', quotes and backslashes
+static inline char *pluginsd_skip_word_characters(char *s) {
+#ifdef NETDATA_SWAR_PARSING
+    uint64_t x;
+    while(swar_load8(s, &x)) {
+        uint64_t special = swar_bytes_lt(x, 0x21) |
+                           swar_bytes_eq(x, '=') |
+                           swar_bytes_eq(x, '"') |
+                           swar_bytes_eq(x, '\'') |
+                           swar_bytes_eq(x, '\\');
+
+        if(special)
+            return s + swar_first_byte(special);
+
+        s += 8;
+    }
+#endif
+
+    return s;
+}
+
+static inline size_t quoted_strings_splitter_internal(char *str, char **words, size_t max_words, bool *isspace_map, bool pluginsd) {
     char *s = str, quote = 0;
     size_t i = 0;
 
@@ -98,8 +120,12 @@ static inline size_t quoted_strings_splitter(char *str, char **words, size_t max
         }
 
             // anything else
-        else
+        else {
             s++;
+
+            if(pluginsd)
+                s = pluginsd_skip_word_characters(s);
+        }
     }
 
     if (likely(i < max_words))
@@ -108,6 +134,10 @@ static inline size_t quoted_strings_splitter(char *str, char **words, size_t max
     return i;
 }
 
+static inline size_t quoted_strings_splitter(char *str, char **words, size_t max_words, bool *isspace_map) {
+    return quoted_strings_splitter_internal(str, words, max_words, isspace_map, false);
+}
+
 #define quoted_strings_splitter_whitespace(str, words, max_words) \
         quoted_strings_splitter(str, words, max_words, isspace_map_whitespace)
 
@@ -118,7 +148,7 @@ static inline size_t quoted_strings_splitter(char *str, char **words, size_t max
         quoted_strings_splitter(str, words, max_words, isspace_map_config)
 
 #define quoted_strings_splitter_pluginsd(str, words, max_words) \
-        quoted_strings_splitter(str, words, max_words, isspace_map_pluginsd)
+        quoted_strings_splitter_internal(str, words, max_words, isspace_map_pluginsd, true)
 
 #define quoted_strings_splitter_dyncfg_id(str, words, max_words) \
         quoted_strings_splitter(str, words, max_words, isspace_dyncfg_id_map)
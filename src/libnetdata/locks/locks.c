@@ -2,6 +2,20 @@
 
 #include "../libnetdata.h"
 
+#ifdef OS_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+// the header turns these into macros that capture the call site
+#undef spinlock_lock
+#undef spinlock_lock_cancelable
+#undef rw_spinlock_read_lock
+#undef rw_spinlock_write_lock
+#undef adaptive_lock_lock
+#endif
+
 #ifdef NETDATA_TRACE_RWLOCKS
 
 #ifndef NETDATA_TRACE_RWLOCKS_WAIT_TIME_TO_IGNORE_USEC
@@ -236,12 +250,67 @@ void spinlock_init(SPINLOCK *spinlock)
 }
 #endif
 
+// ----------------------------------------------------------------------------
+// locks contention tracing
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+
+static LOCK_CONTENTION_SITE *lock_contention_sites_list = NULL;
+
+LOCK_CONTENTION_SITE *lock_contention_sites(void) {
+    return __atomic_load_n(&lock_contention_sites_list, __ATOMIC_ACQUIRE);
+}
+
+static void lock_contention_record(LOCK_CONTENTION_SITE *site, size_t spins, usec_t started_ut) {
+    if(!site)
+        return;
+
+    usec_t wait_ut = now_monotonic_high_precision_usec() - started_ut;
+
+    // link the site to the global list, the first time it is contended
+    // sites are static variables, so they are never removed from it
+    bool expected = false;
+    if(!__atomic_load_n(&site->registered, __ATOMIC_RELAXED) &&
+        __atomic_compare_exchange_n(&site->registered, &expected, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        LOCK_CONTENTION_SITE *head = __atomic_load_n(&lock_contention_sites_list, __ATOMIC_RELAXED);
+        do {
+            site->next = head;
+        } while(!__atomic_compare_exchange_n(&lock_contention_sites_list, &head, site, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+    __atomic_add_fetch(&site->contended, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&site->spins, spins, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&site->wait_ut, wait_ut, __ATOMIC_RELAXED);
+
+    usec_t max_ut = __atomic_load_n(&site->max_wait_ut, __ATOMIC_RELAXED);
+    while(wait_ut > max_ut &&
+          !__atomic_compare_exchange_n(&site->max_wait_ut, &max_ut, wait_ut, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+#define LOCK_CONTENTION_SITE_PARAM , LOCK_CONTENTION_SITE *site
+#define LOCK_CONTENTION_SITE_ARG , site
+#define LOCK_CONTENTION_NO_SITE , NULL
+#define LOCK_CONTENTION_STARTED(var) usec_t var = 0
+#define LOCK_CONTENTION_START(var) do { if(!(var)) (var) = now_monotonic_high_precision_usec(); } while(0)
+#define LOCK_CONTENTION_RECORD(spins, var) do { if(var) lock_contention_record(site, spins, var); } while(0)
+
+#else // NETDATA_TRACE_LOCKS_CONTENTION
+
+#define LOCK_CONTENTION_SITE_PARAM
+#define LOCK_CONTENTION_SITE_ARG
+#define LOCK_CONTENTION_NO_SITE
+#define LOCK_CONTENTION_STARTED(var) do { ; } while(0)
+#define LOCK_CONTENTION_START(var) do { ; } while(0)
+#define LOCK_CONTENTION_RECORD(spins, var) do { (void)(spins); } while(0)
+
+#endif // NETDATA_TRACE_LOCKS_CONTENTION
+
 #ifndef SPINLOCK_IMPL_WITH_MUTEX
-static inline void spinlock_lock_internal(SPINLOCK *spinlock)
+static inline void spinlock_lock_internal(SPINLOCK *spinlock LOCK_CONTENTION_SITE_PARAM)
 {
-    #ifdef NETDATA_INTERNAL_CHECKS
     size_t spins = 0;
-    #endif
+    LOCK_CONTENTION_STARTED(started_ut);
 
     for(int i = 1;
         __atomic_load_n(&spinlock->locked, __ATOMIC_RELAXED) ||
@@ -249,9 +318,8 @@ static inline void spinlock_lock_internal(SPINLOCK *spinlock)
         ; i++
         ) {
 
-        #ifdef NETDATA_INTERNAL_CHECKS
         spins++;
-        #endif
+        LOCK_CONTENTION_START(started_ut);
 
         if(unlikely(i == 8)) {
             i = 0;
@@ -261,6 +329,8 @@ static inline void spinlock_lock_internal(SPINLOCK *spinlock)
 
     // we have the lock
 
+    LOCK_CONTENTION_RECORD(spins, started_ut);
+
     #ifdef NETDATA_INTERNAL_CHECKS
     spinlock->spins += spins;
     spinlock->locker_pid = gettid_cached();
@@ -304,9 +374,23 @@ void spinlock_lock(SPINLOCK *spinlock)
 #else
 void spinlock_lock(SPINLOCK *spinlock)
 {
-    spinlock_lock_internal(spinlock);
+    spinlock_lock_internal(spinlock LOCK_CONTENTION_NO_SITE);
+}
+#endif
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+#ifdef SPINLOCK_IMPL_WITH_MUTEX
+void spinlock_lock_with_site(SPINLOCK *spinlock, LOCK_CONTENTION_SITE *site __maybe_unused)
+{
+    netdata_mutex_lock(&spinlock->inner);
+}
+#else
+void spinlock_lock_with_site(SPINLOCK *spinlock, LOCK_CONTENTION_SITE *site)
+{
+    spinlock_lock_internal(spinlock, site);
 }
 #endif
+#endif // NETDATA_TRACE_LOCKS_CONTENTION
 
 #ifdef SPINLOCK_IMPL_WITH_MUTEX
 void spinlock_unlock(SPINLOCK *spinlock)
@@ -340,7 +424,7 @@ void spinlock_lock_cancelable(SPINLOCK *spinlock)
 #else
 void spinlock_lock_cancelable(SPINLOCK *spinlock)
 {
-    spinlock_lock_internal(spinlock);
+    spinlock_lock_internal(spinlock LOCK_CONTENTION_NO_SITE);
 }
 #endif
 
@@ -376,14 +460,22 @@ void rw_spinlock_init(RW_SPINLOCK *rw_spinlock) {
     spinlock_init(&rw_spinlock->spinlock);
 }
 
-void rw_spinlock_read_lock(RW_SPINLOCK *rw_spinlock) {
+static inline void rw_spinlock_read_lock_internal(RW_SPINLOCK *rw_spinlock LOCK_CONTENTION_SITE_PARAM) {
+#if defined(NETDATA_TRACE_LOCKS_CONTENTION) && !defined(SPINLOCK_IMPL_WITH_MUTEX)
+    spinlock_lock_internal(&rw_spinlock->spinlock, site);
+#else
     spinlock_lock(&rw_spinlock->spinlock);
+#endif
     __atomic_add_fetch(&rw_spinlock->readers, 1, __ATOMIC_RELAXED);
     spinlock_unlock(&rw_spinlock->spinlock);
 
     nd_thread_rwspinlock_read_locked();
 }
 
+void rw_spinlock_read_lock(RW_SPINLOCK *rw_spinlock) {
+    rw_spinlock_read_lock_internal(rw_spinlock LOCK_CONTENTION_NO_SITE);
+}
+
 void rw_spinlock_read_unlock(RW_SPINLOCK *rw_spinlock) {
 #ifndef NETDATA_INTERNAL_CHECKS
     __atomic_sub_fetch(&rw_spinlock->readers, 1, __ATOMIC_RELAXED);
@@ -396,25 +488,48 @@ void rw_spinlock_read_unlock(RW_SPINLOCK *rw_spinlock) {
     nd_thread_rwspinlock_read_unlocked();
 }
 
-void rw_spinlock_write_lock(RW_SPINLOCK *rw_spinlock) {
+static inline void rw_spinlock_write_lock_internal(RW_SPINLOCK *rw_spinlock LOCK_CONTENTION_SITE_PARAM) {
     size_t spins = 0;
+    LOCK_CONTENTION_STARTED(started_ut);
+
     while(1) {
-        spins++;
+#if defined(NETDATA_TRACE_LOCKS_CONTENTION) && !defined(SPINLOCK_IMPL_WITH_MUTEX)
+        spinlock_lock_internal(&rw_spinlock->spinlock, site);
+#else
         spinlock_lock(&rw_spinlock->spinlock);
+#endif
 
         if(__atomic_load_n(&rw_spinlock->readers, __ATOMIC_RELAXED) == 0)
             break;
 
+        spins++;
+        LOCK_CONTENTION_START(started_ut);
+
         // Busy wait until all readers have released their locks.
         spinlock_unlock(&rw_spinlock->spinlock);
         tinysleep();
     }
 
-    (void)spins;
+    // waiting for the readers is accounted on top of waiting for the spinlock
+    LOCK_CONTENTION_RECORD(spins, started_ut);
 
     nd_thread_rwspinlock_write_locked();
 }
 
+void rw_spinlock_write_lock(RW_SPINLOCK *rw_spinlock) {
+    rw_spinlock_write_lock_internal(rw_spinlock LOCK_CONTENTION_NO_SITE);
+}
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+void rw_spinlock_read_lock_with_site(RW_SPINLOCK *rw_spinlock, LOCK_CONTENTION_SITE *site) {
+    rw_spinlock_read_lock_internal(rw_spinlock, site);
+}
+
+void rw_spinlock_write_lock_with_site(RW_SPINLOCK *rw_spinlock, LOCK_CONTENTION_SITE *site) {
+    rw_spinlock_write_lock_internal(rw_spinlock, site);
+}
+#endif // NETDATA_TRACE_LOCKS_CONTENTION
+
 void rw_spinlock_write_unlock(RW_SPINLOCK *rw_spinlock) {
     spinlock_unlock(&rw_spinlock->spinlock);
     nd_thread_rwspinlock_write_unlocked();
@@ -448,6 +563,92 @@ bool rw_spinlock_trywrite_lock(RW_SPINLOCK *rw_spinlock) {
 }
 
 
+// ----------------------------------------------------------------------------
+// adaptive lock implementation
+// state: 0 = unlocked, 1 = locked, 2 = locked with threads parked on the futex
+// (Ulrich Drepper, "Futexes Are Tricky", mutex #2)
+
+#define ADAPTIVE_LOCK_SPINS 128
+
+static inline void adaptive_lock_park(ADAPTIVE_LOCK *lock) {
+#ifdef OS_LINUX
+    syscall(SYS_futex, &lock->state, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+#else
+    (void)lock;
+    tinysleep();
+#endif
+}
+
+static inline void adaptive_lock_wake_one(ADAPTIVE_LOCK *lock) {
+#ifdef OS_LINUX
+    syscall(SYS_futex, &lock->state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    (void)lock;
+#endif
+}
+
+void adaptive_lock_init(ADAPTIVE_LOCK *lock) {
+    lock->state = 0;
+}
+
+bool adaptive_lock_trylock(ADAPTIVE_LOCK *lock) {
+    int32_t expected = 0;
+    if(__atomic_compare_exchange_n(&lock->state, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        nd_thread_spinlock_locked();
+        return true;
+    }
+
+    return false;
+}
+
+static inline void adaptive_lock_lock_internal(ADAPTIVE_LOCK *lock LOCK_CONTENTION_SITE_PARAM) {
+    int32_t expected = 0;
+    if(likely(__atomic_compare_exchange_n(&lock->state, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))) {
+        nd_thread_spinlock_locked();
+        return;
+    }
+
+    size_t spins = 0;
+    LOCK_CONTENTION_STARTED(started_ut);
+    LOCK_CONTENTION_START(started_ut);
+
+    // spin for a while, hoping the holder will release it soon
+    for(; spins < ADAPTIVE_LOCK_SPINS ; spins++) {
+        expected = 0;
+        if(!__atomic_load_n(&lock->state, __ATOMIC_RELAXED) &&
+            __atomic_compare_exchange_n(&lock->state, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            goto locked;
+    }
+
+    // park on the futex, marking the lock as having waiters,
+    // so that the unlocker will wake us up
+    while(__atomic_exchange_n(&lock->state, 2, __ATOMIC_ACQUIRE) != 0) {
+        spins++;
+        adaptive_lock_park(lock);
+    }
+
+locked:
+    LOCK_CONTENTION_RECORD(spins, started_ut);
+    nd_thread_spinlock_locked();
+}
+
+void adaptive_lock_lock(ADAPTIVE_LOCK *lock) {
+    adaptive_lock_lock_internal(lock LOCK_CONTENTION_NO_SITE);
+}
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+void adaptive_lock_lock_with_site(ADAPTIVE_LOCK *lock, LOCK_CONTENTION_SITE *site) {
+    adaptive_lock_lock_internal(lock, site);
+}
+#endif
+
+void adaptive_lock_unlock(ADAPTIVE_LOCK *lock) {
+    if(__atomic_exchange_n(&lock->state, 0, __ATOMIC_RELEASE) == 2)
+        adaptive_lock_wake_one(lock);
+
+    nd_thread_spinlock_unlocked();
+}
+
 #ifdef NETDATA_TRACE_RWLOCKS
 
 // ----------------------------------------------------------------------------
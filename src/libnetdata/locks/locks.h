@@ -60,6 +60,79 @@ void rw_spinlock_write_unlock(RW_SPINLOCK *rw_spinlock);
 bool rw_spinlock_tryread_lock(RW_SPINLOCK *rw_spinlock);
 bool rw_spinlock_trywrite_lock(RW_SPINLOCK *rw_spinlock);
 
+// ----------------------------------------------------------------------------
+// adaptive lock
+// spins for a while, and then parks the thread on a futex (linux)
+// fits locks that may be held long enough to waste CPU spinning on them
+
+typedef struct netdata_adaptive_lock {
+    int32_t state;                  // 0 = unlocked, 1 = locked, 2 = locked with threads parked
+} ADAPTIVE_LOCK;
+
+#define NETDATA_ADAPTIVE_LOCK_INITIALIZER { .state = 0 }
+
+void adaptive_lock_init(ADAPTIVE_LOCK *lock);
+void adaptive_lock_lock(ADAPTIVE_LOCK *lock);
+void adaptive_lock_unlock(ADAPTIVE_LOCK *lock);
+bool adaptive_lock_trylock(ADAPTIVE_LOCK *lock);
+
+// ----------------------------------------------------------------------------
+// locks contention tracing
+// enabled at compile time with CFLAGS="-DNETDATA_TRACE_LOCKS_CONTENTION=1"
+// every call site of the lock functions gets a static LOCK_CONTENTION_SITE,
+// which is linked to the global list the first time the lock is found locked
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+
+typedef struct lock_contention_site {
+    const char *type;
+    const char *file;
+    const char *function;
+    uint32_t line;
+
+    bool registered;
+    size_t contended;               // the number of times the lock was found locked
+    size_t spins;                   // the number of spins while waiting
+    usec_t wait_ut;                 // the total time spent waiting
+    usec_t max_wait_ut;             // the max time spent waiting
+
+    struct lock_contention_site *next;
+} LOCK_CONTENTION_SITE;
+
+#define LOCK_CONTENTION_SITE_DEFINE(name, lock_type) \
+    static LOCK_CONTENTION_SITE name = { lock_type, __FILE__, __FUNCTION__, __LINE__, false, 0, 0, 0, 0, NULL }
+
+LOCK_CONTENTION_SITE *lock_contention_sites(void);
+
+void spinlock_lock_with_site(SPINLOCK *spinlock, LOCK_CONTENTION_SITE *site);
+void rw_spinlock_read_lock_with_site(RW_SPINLOCK *rw_spinlock, LOCK_CONTENTION_SITE *site);
+void rw_spinlock_write_lock_with_site(RW_SPINLOCK *rw_spinlock, LOCK_CONTENTION_SITE *site);
+void adaptive_lock_lock_with_site(ADAPTIVE_LOCK *lock, LOCK_CONTENTION_SITE *site);
+
+#define spinlock_lock(spinlock) do {                                \
+        LOCK_CONTENTION_SITE_DEFINE(_lock_site, "spinlock");        \
+        spinlock_lock_with_site(spinlock, &_lock_site);             \
+    } while(0)
+
+#define spinlock_lock_cancelable(spinlock) spinlock_lock(spinlock)
+
+#define rw_spinlock_read_lock(rw_spinlock) do {                     \
+        LOCK_CONTENTION_SITE_DEFINE(_lock_site, "rw_spinlock read");\
+        rw_spinlock_read_lock_with_site(rw_spinlock, &_lock_site);  \
+    } while(0)
+
+#define rw_spinlock_write_lock(rw_spinlock) do {                    \
+        LOCK_CONTENTION_SITE_DEFINE(_lock_site, "rw_spinlock write");\
+        rw_spinlock_write_lock_with_site(rw_spinlock, &_lock_site); \
+    } while(0)
+
+#define adaptive_lock_lock(lock) do {                               \
+        LOCK_CONTENTION_SITE_DEFINE(_lock_site, "adaptive lock");   \
+        adaptive_lock_lock_with_site(lock, &_lock_site);            \
+    } while(0)
+
+#endif // NETDATA_TRACE_LOCKS_CONTENTION
+
 #ifdef NETDATA_TRACE_RWLOCKS
 
 typedef enum {
@@ -129,6 +129,116 @@ bool journal_direct_send(int fd, const char *msg, size_t msg_len) {
     return true;
 }
 
+// ----------------------------------------------------------------------------
+// batched submission
+
+void journal_direct_batch_init(JOURNAL_DIRECT_BATCH *b) {
+    memset(b, 0, sizeof(*b));
+    b->wb = buffer_create(JOURNAL_DIRECT_BATCH_MAX_BYTES / 16, NULL);
+}
+
+void journal_direct_batch_cleanup(JOURNAL_DIRECT_BATCH *b) {
+    buffer_free(b->wb);
+    memset(b, 0, sizeof(*b));
+}
+
+static inline bool journal_direct_batch_send_one(JOURNAL_DIRECT_BATCH *b, int fd, const char *msg, size_t msg_len) {
+    if(b->memfd_threshold && msg_len >= b->memfd_threshold)
+        return journal_send_with_memfd(fd, msg, msg_len);
+
+    if (send(fd, msg, msg_len, 0) < 0) {
+        if(errno != EMSGSIZE)
+            return false;
+
+        if(!b->memfd_threshold || msg_len < b->memfd_threshold)
+            b->memfd_threshold = msg_len;
+
+        return journal_send_with_memfd(fd, msg, msg_len);
+    }
+
+    return true;
+}
+
+size_t journal_direct_batch_flush(JOURNAL_DIRECT_BATCH *b, int fd) {
+    size_t used = b->used, failed = 0;
+    if(!used)
+        return 0;
+
+    const char *base = buffer_tostring(b->wb);
+
+    if(fd < 0) {
+        failed = used;
+        goto cleanup;
+    }
+
+#if defined(HAVE_SENDMMSG)
+    struct iovec iov[JOURNAL_DIRECT_BATCH_MAX_RECORDS];
+    struct mmsghdr msgs[JOURNAL_DIRECT_BATCH_MAX_RECORDS];
+    memset(msgs, 0, sizeof(msgs[0]) * used);
+
+    for(size_t i = 0; i < used ; i++) {
+        iov[i].iov_base = (void *)&base[b->offsets[i]];
+        iov[i].iov_len = b->lengths[i];
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t i = 0;
+    while(i < used) {
+        // the records known to be too big for a datagram are sent alone
+        if(b->memfd_threshold && b->lengths[i] >= b->memfd_threshold) {
+            if(!journal_send_with_memfd(fd, &base[b->offsets[i]], b->lengths[i]))
+                failed++;
+            i++;
+            continue;
+        }
+
+        size_t n = 1;
+        while(i + n < used && (!b->memfd_threshold || b->lengths[i + n] < b->memfd_threshold))
+            n++;
+
+        int sent = sendmmsg(fd, &msgs[i], (unsigned int)n, 0);
+        if(sent > 0) {
+            i += sent;
+            continue;
+        }
+
+        if(sent < 0 && errno == EINTR)
+            continue;
+
+        // the first record of this run failed, send it alone to handle EMSGSIZE
+        if(!journal_direct_batch_send_one(b, fd, &base[b->offsets[i]], b->lengths[i]))
+            failed++;
+        i++;
+    }
+#else
+    for(size_t i = 0; i < used ; i++) {
+        if(!journal_direct_batch_send_one(b, fd, &base[b->offsets[i]], b->lengths[i]))
+            failed++;
+    }
+#endif
+
+cleanup:
+    b->used = 0;
+    buffer_flush(b->wb);
+    return failed;
+}
+
+size_t journal_direct_batch_add(JOURNAL_DIRECT_BATCH *b, int fd, const char *msg, size_t msg_len) {
+    size_t failed = 0;
+
+    if(b->used >= JOURNAL_DIRECT_BATCH_MAX_RECORDS ||
+        (b->used && buffer_strlen(b->wb) + msg_len > JOURNAL_DIRECT_BATCH_MAX_BYTES))
+        failed += journal_direct_batch_flush(b, fd);
+
+    b->offsets[b->used] = buffer_strlen(b->wb);
+    b->lengths[b->used] = msg_len;
+    buffer_memcat(b->wb, msg, msg_len);
+    b->used++;
+
+    return failed;
+}
+
 void journal_construct_path(char *dst, size_t dst_len, const char *host_prefix, const char *namespace_str) {
     if(!host_prefix)
         host_prefix = "";
@@ -12,6 +12,30 @@ void journal_construct_path(char *dst, size_t dst_len, const char *host_prefix,
 int journal_direct_fd(const char *path);
 bool journal_direct_send(int fd, const char *msg, size_t msg_len);
 
+// batched submission of many records to the journal socket, with sendmmsg() where available
+// the records are copied, so the caller may reuse its buffers after adding them
+
+#define JOURNAL_DIRECT_BATCH_MAX_RECORDS 64
+#define JOURNAL_DIRECT_BATCH_MAX_BYTES (1024 * 1024)
+
+typedef struct journal_direct_batch {
+    BUFFER *wb;                                         // the payloads of all records, back to back
+    size_t used;
+    size_t offsets[JOURNAL_DIRECT_BATCH_MAX_RECORDS];
+    size_t lengths[JOURNAL_DIRECT_BATCH_MAX_RECORDS];
+
+    // the smallest record that did not fit in a datagram,
+    // so that records of this size go to a memfd without trying a datagram first
+    size_t memfd_threshold;
+} JOURNAL_DIRECT_BATCH;
+
+void journal_direct_batch_init(JOURNAL_DIRECT_BATCH *b);
+void journal_direct_batch_cleanup(JOURNAL_DIRECT_BATCH *b);
+
+// they return the number of records that failed to be sent
+size_t journal_direct_batch_add(JOURNAL_DIRECT_BATCH *b, int fd, const char *msg, size_t msg_len);
+size_t journal_direct_batch_flush(JOURNAL_DIRECT_BATCH *b, int fd);
+
 bool is_path_unix_socket(const char *path);
 bool is_stderr_connected_to_journal(void);
 
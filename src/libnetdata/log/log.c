@@ -362,6 +362,51 @@ struct nd_log_limit {
 #define ND_LOG_LIMITS_DEFAULT (struct nd_log_limit){ .logs_per_period = ND_LOG_DEFAULT_THROTTLE_LOGS, .logs_per_period_backup = ND_LOG_DEFAULT_THROTTLE_LOGS, .throttle_period = ND_LOG_DEFAULT_THROTTLE_PERIOD, }
 #define ND_LOG_LIMITS_UNLIMITED (struct nd_log_limit){  .logs_per_period = 0, .logs_per_period_backup = 0, .throttle_period = 0, }
 
+// ----------------------------------------------------------------------------
+// per call site flood protection - the call sites are found by the file and line they log from,
+// in a fixed size lock-free hash table, so that throttled logs are dropped before being formatted
+
+#define ND_LOG_CALL_SITES 4096 // power of 2
+#define ND_LOG_CALL_SITE_PROBES 8
+
+struct nd_log_call_site {
+    uint64_t key;                   // atomic - 0 when the slot is free
+    const char *file;
+    const char *function;
+    unsigned long line;
+
+    usec_t started_monotonic_ut;    // atomic
+    uint32_t counter;               // atomic
+    uint32_t prevented;             // atomic
+};
+
+// ----------------------------------------------------------------------------
+// asynchronous logging - each thread serializes its log entries into a ring buffer of its own
+// (single producer, single consumer) and a writer thread writes them to their outputs
+
+#define ND_LOG_RING_SIZE (64 * 1024) // power of 2
+#define ND_LOG_RING_MAX_ENTRY (ND_LOG_RING_SIZE / 4)
+#define ND_LOG_RING_SKIP UINT32_MAX
+#define ND_LOG_ASYNC_IDLE_MS 100
+
+typedef struct nd_log_ring_entry {
+    uint32_t size;                  // the bytes of the payload, ND_LOG_RING_SKIP to continue at the beginning
+    uint8_t source;
+    uint8_t method;
+    uint8_t priority;
+    uint8_t unused;
+} ND_LOG_RING_ENTRY;
+
+#define ND_LOG_RING_ENTRY_BYTES(size) (sizeof(ND_LOG_RING_ENTRY) + (((size) + 7) & ~((size_t)7)))
+
+typedef struct nd_log_ring {
+    char *data;
+    size_t head;                    // atomic - updated by the thread logging
+    size_t tail;                    // atomic - updated by the writer
+    bool exited;                    // atomic - the thread has exited, free it when drained
+    struct nd_log_ring *prev, *next;
+} ND_LOG_RING;
+
 struct nd_log_source {
     SPINLOCK spinlock;
     ND_LOG_METHOD method;
@@ -372,6 +417,8 @@ struct nd_log_source {
 
     ND_LOG_FIELD_PRIORITY min_priority;
     const char *pending_msg;
+
+    SPINLOCK limits_spinlock;       // the limits are checked without the spinlock, when logging asynchronously
     struct nd_log_limit limits;
 };
 
@@ -407,6 +454,39 @@ static struct {
         bool initialized;
     } std_error;
 
+    struct {
+        uint32_t throttle_period;
+        uint32_t logs_per_period;
+        uint32_t logs_per_period_backup;
+        struct nd_log_call_site array[ND_LOG_CALL_SITES];
+    } call_sites;
+
+    struct {
+        bool running;               // atomic - the writer accepts entries
+        bool stop;                  // atomic
+        ND_THREAD *thread;
+
+        pthread_key_t key;          // to know when threads exit
+        bool key_created;
+
+        SPINLOCK spinlock;          // protects the new rings
+        ND_LOG_RING *new_rings;
+
+        SPINLOCK drain_spinlock;    // protects the rings being drained, only one drainer at a time
+        ND_LOG_RING *rings;
+        BUFFER *wb;
+        JOURNAL_DIRECT_BATCH journal;   // the journal entries of all rings, submitted together
+
+        size_t dropped;             // atomic - the entries that did not fit in the rings, or failed to be written
+        size_t dropped_reported;
+
+        struct {
+            netdata_mutex_t mutex;
+            pthread_cond_t cond;
+            bool sleeping;          // atomic
+        } park;
+    } async;
+
 } nd_log = {
         .overwrite_process_source = 0,
         .journal = {
@@ -428,9 +508,24 @@ static struct {
                 .spinlock = NETDATA_SPINLOCK_INITIALIZER,
                 .initialized = false,
         },
+        .call_sites = {
+                .throttle_period = ND_LOG_DEFAULT_THROTTLE_PERIOD,
+                .logs_per_period = ND_LOG_DEFAULT_CALL_SITE_THROTTLE_LOGS,
+                .logs_per_period_backup = ND_LOG_DEFAULT_CALL_SITE_THROTTLE_LOGS,
+        },
+        .async = {
+                .running = false,
+                .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                .drain_spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                .park = {
+                        .mutex = NETDATA_MUTEX_INITIALIZER,
+                        .cond = PTHREAD_COND_INITIALIZER,
+                },
+        },
         .sources = {
                 [NDLS_UNSET] = {
                         .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                        .limits_spinlock = NETDATA_SPINLOCK_INITIALIZER,
                         .method = NDLM_DISABLED,
                         .format = NDLF_JOURNAL,
                         .filename = NULL,
@@ -441,6 +536,7 @@ static struct {
                 },
                 [NDLS_ACCESS] = {
                         .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                        .limits_spinlock = NETDATA_SPINLOCK_INITIALIZER,
                         .method = NDLM_DEFAULT,
                         .format = NDLF_LOGFMT,
                         .filename = LOG_DIR "/access.log",
@@ -451,6 +547,7 @@ static struct {
                 },
                 [NDLS_ACLK] = {
                         .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                        .limits_spinlock = NETDATA_SPINLOCK_INITIALIZER,
                         .method = NDLM_FILE,
                         .format = NDLF_LOGFMT,
                         .filename = LOG_DIR "/aclk.log",
@@ -461,6 +558,7 @@ static struct {
                 },
                 [NDLS_COLLECTORS] = {
                         .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                        .limits_spinlock = NETDATA_SPINLOCK_INITIALIZER,
                         .method = NDLM_DEFAULT,
                         .format = NDLF_LOGFMT,
                         .filename = LOG_DIR "/collector.log",
@@ -471,6 +569,7 @@ static struct {
                 },
                 [NDLS_DEBUG] = {
                         .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                        .limits_spinlock = NETDATA_SPINLOCK_INITIALIZER,
                         .method = NDLM_DISABLED,
                         .format = NDLF_LOGFMT,
                         .filename = LOG_DIR "/debug.log",
@@ -481,6 +580,7 @@ static struct {
                 },
                 [NDLS_DAEMON] = {
                         .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                        .limits_spinlock = NETDATA_SPINLOCK_INITIALIZER,
                         .method = NDLM_DEFAULT,
                         .filename = LOG_DIR "/daemon.log",
                         .format = NDLF_LOGFMT,
@@ -491,6 +591,7 @@ static struct {
                 },
                 [NDLS_HEALTH] = {
                         .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+                        .limits_spinlock = NETDATA_SPINLOCK_INITIALIZER,
                         .method = NDLM_DEFAULT,
                         .format = NDLF_LOGFMT,
                         .filename = LOG_DIR "/health.log",
@@ -704,6 +805,8 @@ void nd_log_set_flood_protection(size_t logs, time_t period) {
     nd_log.sources[NDLS_DAEMON].limits.throttle_period =
             nd_log.sources[NDLS_COLLECTORS].limits.throttle_period = period;
 
+    nd_log.call_sites.throttle_period = period;
+
     char buf[100];
     snprintfz(buf, sizeof(buf), "%" PRIu64, (uint64_t )period);
     nd_setenv("NETDATA_ERRORS_THROTTLE_PERIOD", buf, 1);
@@ -711,6 +814,10 @@ void nd_log_set_flood_protection(size_t logs, time_t period) {
     nd_setenv("NETDATA_ERRORS_PER_PERIOD", buf, 1);
 }
 
+void nd_log_set_call_site_flood_protection(size_t logs) {
+    nd_log.call_sites.logs_per_period = nd_log.call_sites.logs_per_period_backup = logs;
+}
+
 static bool nd_log_journal_systemd_init(void) {
 #ifdef HAVE_SYSTEMD
     nd_log.journal.initialized = true;
@@ -1022,6 +1129,10 @@ void nd_log_reopen_log_files_for_spawn_server(void) {
         nd_log_journal_direct_init(NULL);
     }
 
+    // the writer thread does not exist in the spawn server
+    __atomic_store_n(&nd_log.async.running, false, __ATOMIC_RELEASE);
+    nd_log.async.thread = NULL;
+
     nd_log.sources[NDLS_UNSET].method = NDLM_DISABLED;
     nd_log.sources[NDLS_ACCESS].method = NDLM_DISABLED;
     nd_log.sources[NDLS_ACLK].method = NDLM_DISABLED;
@@ -1931,10 +2042,7 @@ static bool nd_logger_journal_libsystemd(struct log_field *fields __maybe_unused
 #endif
 }
 
-static bool nd_logger_journal_direct(struct log_field *fields, size_t fields_max) {
-    if(!nd_log.journal_direct.initialized)
-        return false;
-
+static void nd_logger_journal_direct_format(BUFFER *wb, struct log_field *fields, size_t fields_max) {
     //  --- FIELD_PARSER_VERSIONS ---
     //
     // IMPORTANT:
@@ -1949,7 +2057,6 @@ static bool nd_logger_journal_direct(struct log_field *fields, size_t fields_max
     //
     // UPDATE ALL OF THEM FOR NEW FEATURES OR FIXES
 
-    CLEAN_BUFFER *wb = buffer_create(4096, NULL);
     CLEAN_BUFFER *tmp = NULL;
 
     for (size_t i = 0; i < fields_max; i++) {
@@ -2030,6 +2137,14 @@ static bool nd_logger_journal_direct(struct log_field *fields, size_t fields_max
             }
         }
     }
+}
+
+static bool nd_logger_journal_direct(struct log_field *fields, size_t fields_max) {
+    if(!nd_log.journal_direct.initialized)
+        return false;
+
+    CLEAN_BUFFER *wb = buffer_create(4096, NULL);
+    nd_logger_journal_direct_format(wb, fields, fields_max);
 
     return journal_direct_send(nd_log.journal_direct.fd, buffer_tostring(wb), buffer_strlen(wb));
 }
@@ -2049,15 +2164,21 @@ static bool nd_logger_syslog(int priority, ND_LOG_FORMAT format __maybe_unused,
 // ----------------------------------------------------------------------------
 // file logger - uses logfmt
 
-static bool nd_logger_file(FILE *fp, ND_LOG_FORMAT format, struct log_field *fields, size_t fields_max) {
-    BUFFER *wb = buffer_create(1024, NULL);
-
+static void nd_logger_file_format(BUFFER *wb, ND_LOG_FORMAT format, struct log_field *fields, size_t fields_max) {
     if(format == NDLF_JSON)
         nd_logger_json(wb, fields, fields_max);
     else
         nd_logger_logfmt(wb, fields, fields_max);
 
-    int r = fprintf(fp, "%s\n", buffer_tostring(wb));
+    buffer_putc(wb, '\n');
+}
+
+static bool nd_logger_file(FILE *fp, ND_LOG_FORMAT format, struct log_field *fields, size_t fields_max) {
+    BUFFER *wb = buffer_create(1024, NULL);
+
+    nd_logger_file_format(wb, format, fields, fields_max);
+
+    size_t r = fwrite(buffer_tostring(wb), 1, buffer_strlen(wb), fp);
     fflush(fp);
 
     buffer_free(wb);
@@ -2132,17 +2253,363 @@ static ND_LOG_METHOD nd_logger_select_output(ND_LOG_SOURCES source, FILE **fpp,
     return output;
 }
 
+// ----------------------------------------------------------------------------
+// asynchronous logger
+
+static __thread ND_LOG_RING *nd_log_thread_ring = NULL;
+static __thread bool nd_log_thread_is_writer = false;
+
+static void nd_log_ring_thread_exit(void *ptr) {
+    ND_LOG_RING *r = ptr;
+    nd_log_thread_ring = NULL;
+    __atomic_store_n(&r->exited, true, __ATOMIC_RELEASE);
+}
+
+static ND_LOG_RING *nd_log_thread_ring_get(void) {
+    if(likely(nd_log_thread_ring))
+        return nd_log_thread_ring;
+
+    ND_LOG_RING *r = callocz(1, sizeof(ND_LOG_RING));
+    r->data = mallocz(ND_LOG_RING_SIZE);
+
+    spinlock_lock(&nd_log.async.spinlock);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(nd_log.async.new_rings, r, prev, next);
+    spinlock_unlock(&nd_log.async.spinlock);
+
+    pthread_setspecific(nd_log.async.key, r);
+    nd_log_thread_ring = r;
+    return r;
+}
+
+static void nd_log_async_wake_up_writer(void) {
+    if(!__atomic_load_n(&nd_log.async.park.sleeping, __ATOMIC_RELAXED))
+        return;
+
+    netdata_mutex_lock(&nd_log.async.park.mutex);
+    pthread_cond_signal(&nd_log.async.park.cond);
+    netdata_mutex_unlock(&nd_log.async.park.mutex);
+}
+
+// called by the thread logging - it never waits for the writer
+static bool nd_log_async_push(ND_LOG_SOURCES source, ND_LOG_METHOD method, ND_LOG_FIELD_PRIORITY priority, const char *payload, size_t size) {
+    ND_LOG_RING *r = nd_log_thread_ring_get();
+
+    size_t needed = ND_LOG_RING_ENTRY_BYTES(size);
+    size_t head = r->head;
+    size_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    size_t offset = head & (ND_LOG_RING_SIZE - 1);
+
+    // the entries are contiguous, so one that does not fit at the end is written at the beginning
+    size_t skip = (ND_LOG_RING_SIZE - offset < needed) ? ND_LOG_RING_SIZE - offset : 0;
+
+    if(ND_LOG_RING_SIZE - (head - tail) < skip + needed) {
+        __atomic_add_fetch(&nd_log.async.dropped, 1, __ATOMIC_RELAXED);
+        nd_log_async_wake_up_writer();
+        return false;
+    }
+
+    if(skip) {
+        ND_LOG_RING_ENTRY *e = (ND_LOG_RING_ENTRY *)&r->data[offset];
+        e->size = ND_LOG_RING_SKIP;
+        head += skip;
+        offset = 0;
+    }
+
+    ND_LOG_RING_ENTRY *e = (ND_LOG_RING_ENTRY *)&r->data[offset];
+    e->size = (uint32_t)size;
+    e->source = (uint8_t)source;
+    e->method = (uint8_t)method;
+    e->priority = (uint8_t)priority;
+    memcpy(&r->data[offset + sizeof(ND_LOG_RING_ENTRY)], payload, size);
+
+    __atomic_store_n(&r->head, head + needed, __ATOMIC_RELEASE);
+
+    nd_log_async_wake_up_writer();
+    return true;
+}
+
+// the file entries are collected and written to their file in one go, until the file changes
+static void nd_log_async_flush_file(FILE **fpp, SPINLOCK **spinlock, BUFFER *wb) {
+    if(*fpp && buffer_strlen(wb)) {
+        if(*spinlock)
+            spinlock_lock(*spinlock);
+
+        fwrite(buffer_tostring(wb), 1, buffer_strlen(wb), *fpp);
+        fflush(*fpp);
+
+        if(*spinlock)
+            spinlock_unlock(*spinlock);
+    }
+
+    buffer_flush(wb);
+    *fpp = NULL;
+    *spinlock = NULL;
+}
+
+static size_t nd_log_async_drain_ring(ND_LOG_RING *r, BUFFER *wb) {
+    size_t entries = 0;
+    size_t tail = r->tail;
+    size_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+    FILE *fp = NULL;
+    SPINLOCK *spinlock = NULL;
+
+    while(tail != head) {
+        size_t offset = tail & (ND_LOG_RING_SIZE - 1);
+        ND_LOG_RING_ENTRY *e = (ND_LOG_RING_ENTRY *)&r->data[offset];
+
+        if(e->size == ND_LOG_RING_SKIP) {
+            tail += ND_LOG_RING_SIZE - offset;
+            continue;
+        }
+
+        const char *payload = &r->data[offset + sizeof(ND_LOG_RING_ENTRY)];
+
+        if(e->method == NDLM_FILE) {
+            FILE *entry_fp;
+            SPINLOCK *entry_spinlock;
+            if(nd_logger_select_output(e->source, &entry_fp, &entry_spinlock) != NDLM_FILE) {
+                // the method of the source changed after the entry was formatted for a file
+                entry_fp = stderr;
+                entry_spinlock = &nd_log.std_error.spinlock;
+            }
+
+            if(entry_fp != fp)
+                nd_log_async_flush_file(&fp, &spinlock, wb);
+
+            fp = entry_fp;
+            spinlock = entry_spinlock;
+            buffer_fast_strcat(wb, payload, e->size);
+        }
+        else if(e->method == NDLM_JOURNAL) {
+            size_t failed = nd_log.journal_direct.initialized ?
+                journal_direct_batch_add(&nd_log.async.journal, nd_log.journal_direct.fd, payload, e->size) : 1;
+
+            if(failed)
+                __atomic_add_fetch(&nd_log.async.dropped, failed, __ATOMIC_RELAXED);
+        }
+        else if(e->method == NDLM_SYSLOG)
+            syslog(e->priority, "%s", payload);
+
+        tail += ND_LOG_RING_ENTRY_BYTES(e->size);
+        entries++;
+    }
+
+    nd_log_async_flush_file(&fp, &spinlock, wb);
+    __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+
+    return entries;
+}
+
+static size_t nd_log_async_drain(void) {
+    size_t entries = 0;
+
+    spinlock_lock(&nd_log.async.drain_spinlock);
+
+    spinlock_lock(&nd_log.async.spinlock);
+    while(nd_log.async.new_rings) {
+        ND_LOG_RING *r = nd_log.async.new_rings;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(nd_log.async.new_rings, r, prev, next);
+        DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(nd_log.async.rings, r, prev, next);
+    }
+    spinlock_unlock(&nd_log.async.spinlock);
+
+    if(!nd_log.async.wb) {
+        nd_log.async.wb = buffer_create(ND_LOG_RING_SIZE, NULL);
+        journal_direct_batch_init(&nd_log.async.journal);
+    }
+
+    ND_LOG_RING *r = nd_log.async.rings;
+    while(r) {
+        ND_LOG_RING *next = r->next;
+
+        // when it has exited, nothing will be added after we drain it
+        bool exited = __atomic_load_n(&r->exited, __ATOMIC_ACQUIRE);
+
+        entries += nd_log_async_drain_ring(r, nd_log.async.wb);
+
+        if(exited) {
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(nd_log.async.rings, r, prev, next);
+            freez(r->data);
+            freez(r);
+        }
+
+        r = next;
+    }
+
+    size_t failed = journal_direct_batch_flush(&nd_log.async.journal, nd_log.journal_direct.fd);
+    if(failed)
+        __atomic_add_fetch(&nd_log.async.dropped, failed, __ATOMIC_RELAXED);
+
+    spinlock_unlock(&nd_log.async.drain_spinlock);
+    return entries;
+}
+
+static void nd_log_async_report_dropped(void) {
+    size_t dropped = __atomic_load_n(&nd_log.async.dropped, __ATOMIC_RELAXED);
+    if(dropped > nd_log.async.dropped_reported) {
+        size_t new_dropped = dropped - nd_log.async.dropped_reported;
+        nd_log.async.dropped_reported = dropped;
+
+        nd_log(NDLS_DAEMON, NDLP_WARNING,
+               "LOG FLOOD PROTECTION: %zu log entries were dropped, because they were logged faster than they could be written",
+               new_dropped);
+    }
+}
+
+static void nd_log_async_park(void) {
+    netdata_mutex_lock(&nd_log.async.park.mutex);
+    __atomic_store_n(&nd_log.async.park.sleeping, true, __ATOMIC_RELAXED);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += ND_LOG_ASYNC_IDLE_MS * NSEC_PER_MSEC;
+    if(ts.tv_nsec >= (long)NSEC_PER_SEC) {
+        ts.tv_sec++;
+        ts.tv_nsec -= NSEC_PER_SEC;
+    }
+
+    if(!__atomic_load_n(&nd_log.async.stop, __ATOMIC_RELAXED))
+        pthread_cond_timedwait(&nd_log.async.park.cond, &nd_log.async.park.mutex, &ts);
+
+    __atomic_store_n(&nd_log.async.park.sleeping, false, __ATOMIC_RELAXED);
+    netdata_mutex_unlock(&nd_log.async.park.mutex);
+}
+
+static void *nd_log_async_writer_thread(void *ptr __maybe_unused) {
+    // the logs of the writer itself are written synchronously
+    nd_log_thread_is_writer = true;
+
+    while(!__atomic_load_n(&nd_log.async.stop, __ATOMIC_RELAXED)) {
+        if(!nd_log_async_drain())
+            nd_log_async_park();
+
+        nd_log_async_report_dropped();
+    }
+
+    nd_log_async_drain();
+    nd_log_async_report_dropped();
+    return NULL;
+}
+
+void nd_log_async_start(void) {
+    if(nd_log.async.thread)
+        return;
+
+    if(!nd_log.async.key_created) {
+        if(pthread_key_create(&nd_log.async.key, nd_log_ring_thread_exit) != 0) {
+            nd_log(NDLS_DAEMON, NDLP_ERR, "LOG: cannot create the thread key of asynchronous logging, logging synchronously");
+            return;
+        }
+        nd_log.async.key_created = true;
+    }
+
+    __atomic_store_n(&nd_log.async.stop, false, __ATOMIC_RELAXED);
+    nd_log.async.thread = nd_thread_create("LOGS", NETDATA_THREAD_OPTION_JOINABLE | NETDATA_THREAD_OPTION_DONT_LOG,
+                                           nd_log_async_writer_thread, NULL);
+
+    if(nd_log.async.thread)
+        __atomic_store_n(&nd_log.async.running, true, __ATOMIC_RELEASE);
+}
+
+void nd_log_async_stop(void) {
+    if(!nd_log.async.thread)
+        return;
+
+    // the new entries are written synchronously
+    __atomic_store_n(&nd_log.async.running, false, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&nd_log.async.stop, true, __ATOMIC_RELAXED);
+    netdata_mutex_lock(&nd_log.async.park.mutex);
+    pthread_cond_signal(&nd_log.async.park.cond);
+    netdata_mutex_unlock(&nd_log.async.park.mutex);
+
+    nd_thread_join(nd_log.async.thread);
+    nd_log.async.thread = NULL;
+
+    // the entries pushed while we were stopping the writer
+    nd_log_async_drain();
+    nd_log_async_report_dropped();
+}
+
+static inline bool nd_log_async_enabled(ND_LOG_FIELD_PRIORITY priority) {
+    // critical entries are written synchronously, since they may be the last ones
+    return __atomic_load_n(&nd_log.async.running, __ATOMIC_ACQUIRE) &&
+           !nd_log_thread_is_writer &&
+           priority > NDLP_CRIT;
+}
+
+// serialize the fields once, in the format of the output, and queue them for the writer
+static bool nd_logger_log_fields_async(ND_LOG_FIELD_PRIORITY priority, ND_LOG_METHOD output, struct nd_log_source *source,
+                                       struct log_field *fields, size_t fields_max) {
+    static __thread BUFFER *wb = NULL;
+    if(!wb)
+        wb = buffer_create(1024, NULL);
+    else
+        buffer_flush(wb);
+
+    switch(output) {
+        case NDLM_FILE:
+            nd_logger_file_format(wb, source->format, fields, fields_max);
+            break;
+
+        case NDLM_JOURNAL:
+            if(!nd_log.journal_direct.initialized)
+                return false;
+
+            nd_logger_journal_direct_format(wb, fields, fields_max);
+            break;
+
+        case NDLM_SYSLOG:
+            nd_logger_logfmt(wb, fields, fields_max);
+
+            // syslog() gets it as a string
+            buffer_putc(wb, '\0');
+            break;
+
+        default:
+            return false;
+    }
+
+    if(buffer_strlen(wb) > ND_LOG_RING_MAX_ENTRY)
+        return false;
+
+    // when the ring is full, the entry is dropped, and the writer reports it
+    nd_log_async_push(source - nd_log.sources, output, priority, buffer_tostring(wb), buffer_strlen(wb));
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 // high level logger
 
 static void nd_logger_log_fields(SPINLOCK *spinlock, FILE *fp, bool limit, ND_LOG_FIELD_PRIORITY priority,
                                  ND_LOG_METHOD output, struct nd_log_source *source,
                                  struct log_field *fields, size_t fields_max) {
+    if(nd_log_async_enabled(priority)) {
+        spinlock_lock(&source->limits_spinlock);
+        bool reached = limit && nd_log_limit_reached(source);
+        spinlock_unlock(&source->limits_spinlock);
+
+        if(reached || nd_logger_log_fields_async(priority, output, source, fields, fields_max))
+            return;
+
+        // it cannot be queued, it will be written synchronously, and it has been counted already
+        limit = false;
+    }
+    else if(priority <= NDLP_CRIT && __atomic_load_n(&nd_log.async.running, __ATOMIC_ACQUIRE) && !nd_log_thread_is_writer) {
+        // write everything logged before it
+        nd_log_async_drain();
+    }
+
     if(spinlock)
         spinlock_lock(spinlock);
 
     // check the limits
-    if(limit && nd_log_limit_reached(source))
+    spinlock_lock(&source->limits_spinlock);
+    bool reached = limit && nd_log_limit_reached(source);
+    spinlock_unlock(&source->limits_spinlock);
+
+    if(reached)
         goto cleanup;
 
     if(output == NDLM_JOURNAL) {
@@ -2338,6 +2805,90 @@ static ND_LOG_SOURCES nd_log_validate_source(ND_LOG_SOURCES source) {
     return source;
 }
 
+// ----------------------------------------------------------------------------
+// per call site flood protection
+
+static void nd_logger_call_site_message(const char *file, const char *function, const unsigned long line,
+                                        ND_LOG_SOURCES source, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    nd_logger(file, function, line, source, NDLP_WARNING, false, 0, 0, fmt, args);
+    va_end(args);
+}
+
+static struct nd_log_call_site *nd_log_call_site_get(const char *file, const char *function, const unsigned long line) {
+    // the file is a string literal, so its address identifies it
+    uint64_t key = ((uint64_t)(uintptr_t)file * 0x9E3779B97F4A7C15ULL) ^ (uint64_t)line;
+    if(unlikely(!key)) key = 1;
+
+    size_t slot = (size_t)(key ^ (key >> 32));
+    for(size_t i = 0; i < ND_LOG_CALL_SITE_PROBES ; i++) {
+        struct nd_log_call_site *cs = &nd_log.call_sites.array[(slot + i) & (ND_LOG_CALL_SITES - 1)];
+
+        uint64_t expected = __atomic_load_n(&cs->key, __ATOMIC_ACQUIRE);
+        if(expected == key)
+            return cs;
+
+        if(!expected) {
+            if(__atomic_compare_exchange_n(&cs->key, &expected, key, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                cs->file = file;
+                cs->function = function;
+                cs->line = line;
+                return cs;
+            }
+
+            if(expected == key)
+                return cs;
+        }
+    }
+
+    // too many call sites collide here, they are not limited
+    return NULL;
+}
+
+static bool nd_log_call_site_limit_reached(const char *file, const char *function, const unsigned long line, ND_LOG_SOURCES source) {
+    uint32_t logs_per_period = nd_log.call_sites.logs_per_period;
+    uint32_t throttle_period = nd_log.call_sites.throttle_period;
+    if(!logs_per_period || !throttle_period || !file)
+        return false;
+
+    struct nd_log_call_site *cs = nd_log_call_site_get(file, function, line);
+    if(!cs)
+        return false;
+
+    usec_t now_ut = now_monotonic_usec();
+    usec_t started_ut = __atomic_load_n(&cs->started_monotonic_ut, __ATOMIC_RELAXED);
+
+    if(now_ut - started_ut > (usec_t)throttle_period * USEC_PER_SEC &&
+        __atomic_compare_exchange_n(&cs->started_monotonic_ut, &started_ut, now_ut, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        // we restart the period accounting
+        __atomic_store_n(&cs->counter, 0, __ATOMIC_RELAXED);
+        uint32_t prevented = __atomic_exchange_n(&cs->prevented, 0, __ATOMIC_RELAXED);
+
+        if(prevented)
+            nd_logger_call_site_message(file, function, line, source,
+                                        "LOG FLOOD PROTECTION: resuming logging from this call site "
+                                        "(prevented %"PRIu32" logs in the last %"PRIu32" seconds).",
+                                        prevented, throttle_period);
+    }
+
+    if(__atomic_add_fetch(&cs->counter, 1, __ATOMIC_RELAXED) > logs_per_period) {
+        if(__atomic_fetch_add(&cs->prevented, 1, __ATOMIC_RELAXED) == 0)
+            nd_logger_call_site_message(file, function, line, source,
+                                        "LOG FLOOD PROTECTION: too many logs from this call site (threshold is set to %"PRIu32" logs "
+                                        "in %"PRIu32" seconds). Preventing more logs from it, until the period ends.",
+                                        logs_per_period, throttle_period);
+
+#ifdef NETDATA_INTERNAL_CHECKS
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    return false;
+}
+
 // ----------------------------------------------------------------------------
 // public API for loggers
 
@@ -2355,10 +2906,15 @@ void netdata_logger(ND_LOG_SOURCES source, ND_LOG_FIELD_PRIORITY priority, const
     if (source != NDLS_DEBUG && priority > nd_log.sources[source].min_priority)
         return;
 
+    bool limit = source == NDLS_DAEMON || source == NDLS_COLLECTORS;
+
+    // before formatting anything
+    if(limit && nd_log_call_site_limit_reached(file, function, line, source))
+        return;
+
     va_list args;
     va_start(args, fmt);
-    nd_logger(file, function, line, source, priority,
-              source == NDLS_DAEMON || source == NDLS_COLLECTORS,
+    nd_logger(file, function, line, source, priority, limit,
               saved_errno, saved_winerror, fmt, args);
     va_end(args);
 }
@@ -2472,6 +3028,8 @@ void nd_log_limits_reset(void) {
         spinlock_unlock(&nd_log.sources[i].spinlock);
     }
 
+    nd_log.call_sites.logs_per_period = nd_log.call_sites.logs_per_period_backup;
+
     spinlock_unlock(&nd_log.std_output.spinlock);
     spinlock_unlock(&nd_log.std_error.spinlock);
 }
@@ -2481,6 +3039,8 @@ void nd_log_limits_unlimited(void) {
     for(size_t i = 0; i < _NDLS_MAX ;i++) {
         nd_log.sources[i].limits.logs_per_period = 0;
     }
+
+    nd_log.call_sites.logs_per_period = 0;
 }
 
 static bool nd_log_limit_reached(struct nd_log_source *source) {
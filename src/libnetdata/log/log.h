@@ -11,6 +11,7 @@ extern "C" {
 
 #define ND_LOG_DEFAULT_THROTTLE_LOGS 1000
 #define ND_LOG_DEFAULT_THROTTLE_PERIOD 60
+#define ND_LOG_DEFAULT_CALL_SITE_THROTTLE_LOGS 200
 
 typedef enum  __attribute__((__packed__)) {
     NDLS_UNSET = 0,   // internal use only
@@ -153,6 +154,9 @@ void nd_log_reopen_log_files(bool log);
 void chown_open_file(int fd, uid_t uid, gid_t gid);
 void nd_log_chown_log_files(uid_t uid, gid_t gid);
 void nd_log_set_flood_protection(size_t logs, time_t period);
+void nd_log_set_call_site_flood_protection(size_t logs);
+void nd_log_async_start(void);
+void nd_log_async_stop(void);
 void nd_log_initialize_for_external_plugins(const char *name);
 void nd_log_reopen_log_files_for_spawn_server(void);
 bool nd_log_journal_socket_available(void);
@@ -27,9 +27,15 @@ static inline void log_message_to_stderr(BUFFER *msg) {
     fprintf(stderr, "SENDING: %s\n", buffer_tostring(tmp));
 }
 
-static inline buffered_reader_ret_t get_next_line(struct buffered_reader *reader, BUFFER *line, int timeout_ms) {
+typedef void (*get_next_line_idle_cb)(void *data);
+
+static inline buffered_reader_ret_t get_next_line_with_idle(struct buffered_reader *reader, BUFFER *line, int timeout_ms, get_next_line_idle_cb idle_cb, void *idle_data) {
     while(true) {
         if(unlikely(!buffered_reader_next_line(reader, line))) {
+            // we are about to wait for more input
+            if(idle_cb)
+                idle_cb(idle_data);
+
             buffered_reader_ret_t ret = buffered_reader_read_timeout(reader, STDIN_FILENO, timeout_ms, false);
             if(unlikely(ret != BUFFERED_READER_READ_OK))
                 return ret;
@@ -49,6 +55,10 @@ static inline buffered_reader_ret_t get_next_line(struct buffered_reader *reader
     }
 }
 
+static inline buffered_reader_ret_t get_next_line(struct buffered_reader *reader, BUFFER *line, int timeout_ms) {
+    return get_next_line_with_idle(reader, line, timeout_ms, NULL, NULL);
+}
+
 static inline size_t copy_replacing_newlines(char *dst, size_t dst_len, const char *src, size_t src_len, const char *newline) {
     if (!dst || !src) return 0;
 
@@ -658,14 +668,31 @@ static int log_input_as_netdata(const char *newline, int timeout_ms) {
 // ----------------------------------------------------------------------------
 // log to a local systemd-journald
 
-static bool journal_local_send_buffer(int fd, BUFFER *msg) {
+struct journal_local_batch {
+    JOURNAL_DIRECT_BATCH batch;
+    int fd;
+    size_t failed;
+};
+
+// the messages are batched while the input has more, and sent when we need to wait for input
+static void journal_local_flush(void *data) {
+    struct journal_local_batch *jb = data;
+
+    size_t failed = journal_direct_batch_flush(&jb->batch, jb->fd);
+    if(failed)
+        fprintf(stderr, "Cannot send %zu messages to systemd journal.\n", failed);
+
+    jb->failed += failed;
+}
+
+static void journal_local_send_buffer(struct journal_local_batch *jb, BUFFER *msg) {
     // log_message_to_stderr(msg);
 
-    bool ret = journal_direct_send(fd, msg->buffer, msg->len);
-    if (!ret)
-        fprintf(stderr, "Cannot send message to systemd journal.\n");
+    size_t failed = journal_direct_batch_add(&jb->batch, jb->fd, msg->buffer, msg->len);
+    if(failed)
+        fprintf(stderr, "Cannot send %zu messages to systemd journal.\n", failed);
 
-    return ret;
+    jb->failed += failed;
 }
 
 static int log_input_to_journal(const char *socket, const char *namespace, const char *newline, int timeout_ms) {
@@ -689,19 +716,18 @@ static int log_input_to_journal(const char *socket, const char *namespace, const
     CLEAN_BUFFER *line = buffer_create(sizeof(reader.read_buffer), NULL);
     CLEAN_BUFFER *msg = buffer_create(sizeof(reader.read_buffer), NULL);
 
+    struct journal_local_batch jb = { .fd = fd, };
+    journal_direct_batch_init(&jb.batch);
+
     size_t messages_logged = 0;
-    size_t failed_messages = 0;
 
-    while(get_next_line(&reader, line, timeout_ms) == BUFFERED_READER_READ_OK) {
+    while(!jb.failed &&
+           get_next_line_with_idle(&reader, line, timeout_ms, journal_local_flush, &jb) == BUFFERED_READER_READ_OK) {
         if (!line->len) {
             // an empty line - we are done for this message
             if (msg->len) {
-                if(journal_local_send_buffer(fd, msg))
-                    messages_logged++;
-                else {
-                    failed_messages++;
-                    goto cleanup;
-                }
+                journal_local_send_buffer(&jb, msg);
+                messages_logged++;
             }
 
             buffer_flush(msg);
@@ -712,15 +738,15 @@ static int log_input_to_journal(const char *socket, const char *namespace, const
         buffer_flush(line);
     }
 
-    if (msg && msg->len) {
-        if(journal_local_send_buffer(fd, msg))
-            messages_logged++;
-        else
-            failed_messages++;
+    if (!jb.failed && msg && msg->len) {
+        journal_local_send_buffer(&jb, msg);
+        messages_logged++;
     }
 
-cleanup:
-    return !failed_messages && messages_logged ? 0 : 1;
+    journal_local_flush(&jb);
+    journal_direct_batch_cleanup(&jb.batch);
+
+    return !jb.failed && messages_logged ? 0 : 1;
 }
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "malloc_sampling.h"
+
+// the sampled pointers are kept in a fixed size hash table, so that freeing
+// a pointer that has not been sampled costs just a lookup of an (usually empty) bucket
+#define MALLOC_SAMPLING_BUCKETS_BITS 18
+#define MALLOC_SAMPLING_BUCKETS (1 << MALLOC_SAMPLING_BUCKETS_BITS)
+#define MALLOC_SAMPLING_STRIPES 1024
+
+// the nodes of the hash table are allocated with libc directly,
+// so that the sampler does not sample its own allocations
+
+typedef struct malloc_sample {
+    void *ptr;
+    size_t weight;              // the bytes this sample represents
+    uint8_t subsystem;
+    struct malloc_sample *next;
+} MALLOC_SAMPLE;
+
+typedef struct malloc_sampling_subsystem {
+    char name[MALLOC_SAMPLING_SUBSYSTEM_NAME_MAX + 1];
+    size_t live_bytes;          // atomic
+    size_t live_samples;        // atomic
+} MALLOC_SAMPLING_SUBSYSTEM;
+
+struct malloc_sampling_globals malloc_sampling_globals = {
+    .enabled = false,
+    .interval = 0,
+};
+
+static struct {
+    MALLOC_SAMPLE **buckets;
+    SPINLOCK stripes[MALLOC_SAMPLING_STRIPES];
+
+    struct {
+        SPINLOCK spinlock;
+        size_t used;            // atomic
+        MALLOC_SAMPLING_SUBSYSTEM array[MALLOC_SAMPLING_MAX_SUBSYSTEMS];
+    } subsystems;
+
+    size_t memory;              // atomic
+} malloc_sampling = {
+    .subsystems = {
+        .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    },
+};
+
+__thread int64_t malloc_sampling_countdown = 0;
+static __thread uint64_t malloc_sampling_random_state = 0;
+
+// ----------------------------------------------------------------------------
+// sampling intervals
+
+static inline uint64_t malloc_sampling_random(void) {
+    if(unlikely(!malloc_sampling_random_state))
+        malloc_sampling_random_state = ((uint64_t)(uintptr_t)&malloc_sampling_random_state) ^ now_monotonic_usec() ^ 0x9E3779B97F4A7C15ULL;
+
+    // xorshift64
+    uint64_t x = malloc_sampling_random_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return malloc_sampling_random_state = x;
+}
+
+// the bytes until the next sample are exponentially distributed around the interval,
+// so that allocation patterns aligned to the interval cannot skew the results
+static inline int64_t malloc_sampling_next_countdown(void) {
+    double u = (double)((malloc_sampling_random() >> 11) + 1) / (double)(1ULL << 53);
+    double next = -log(u) * (double)malloc_sampling_globals.interval;
+
+    if(next < 1.0) next = 1.0;
+    if(next > (double)(malloc_sampling_globals.interval * 64)) next = (double)(malloc_sampling_globals.interval * 64);
+
+    return (int64_t)next;
+}
+
+// the expected bytes allocated per sample of this size
+static inline size_t malloc_sampling_weight(size_t size) {
+    double interval = (double)malloc_sampling_globals.interval;
+    double probability = 1.0 - exp(-(double)size / interval);
+    return (probability > 0.0) ? (size_t)((double)size / probability) : malloc_sampling_globals.interval;
+}
+
+// ----------------------------------------------------------------------------
+// subsystems
+
+static uint8_t malloc_sampling_subsystem_id(void) {
+    char name[MALLOC_SAMPLING_SUBSYSTEM_NAME_MAX + 1];
+
+    // the thread tag, up to its first '['
+    const char *tag = nd_thread_tag();
+    size_t len = 0;
+    while(tag && tag[len] && tag[len] != '[' && len < MALLOC_SAMPLING_SUBSYSTEM_NAME_MAX) {
+        name[len] = tag[len];
+        len++;
+    }
+    name[len] = '\0';
+
+    if(!len)
+        return 0;
+
+    size_t used = __atomic_load_n(&malloc_sampling.subsystems.used, __ATOMIC_ACQUIRE);
+    for(size_t i = 0; i < used ; i++)
+        if(strcmp(malloc_sampling.subsystems.array[i].name, name) == 0)
+            return (uint8_t)i;
+
+    spinlock_lock(&malloc_sampling.subsystems.spinlock);
+
+    size_t i;
+    used = malloc_sampling.subsystems.used;
+    for(i = 0; i < used ; i++)
+        if(strcmp(malloc_sampling.subsystems.array[i].name, name) == 0)
+            break;
+
+    if(i == used) {
+        if(used < MALLOC_SAMPLING_MAX_SUBSYSTEMS) {
+            strncpyz(malloc_sampling.subsystems.array[i].name, name, MALLOC_SAMPLING_SUBSYSTEM_NAME_MAX);
+            __atomic_store_n(&malloc_sampling.subsystems.used, used + 1, __ATOMIC_RELEASE);
+        }
+        else
+            // the table is full, use "other"
+            i = 0;
+    }
+
+    spinlock_unlock(&malloc_sampling.subsystems.spinlock);
+    return (uint8_t)i;
+}
+
+// ----------------------------------------------------------------------------
+// the index of sampled pointers
+
+static inline size_t malloc_sampling_bucket(void *ptr) {
+    return (size_t)((((uint64_t)(uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ULL) >> (64 - MALLOC_SAMPLING_BUCKETS_BITS));
+}
+
+static inline SPINLOCK *malloc_sampling_stripe(size_t bucket) {
+    return &malloc_sampling.stripes[bucket % MALLOC_SAMPLING_STRIPES];
+}
+
+static inline void malloc_sampling_account(MALLOC_SAMPLE *s, bool add) {
+    MALLOC_SAMPLING_SUBSYSTEM *ss = &malloc_sampling.subsystems.array[s->subsystem];
+
+    if(add) {
+        __atomic_add_fetch(&ss->live_bytes, s->weight, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ss->live_samples, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        __atomic_sub_fetch(&ss->live_bytes, s->weight, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&ss->live_samples, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void malloc_sampling_alloc_sample(void *ptr, size_t size) {
+    malloc_sampling_countdown = malloc_sampling_next_countdown();
+
+    if(unlikely(!ptr || !malloc_sampling.buckets))
+        return;
+
+    MALLOC_SAMPLE *s = malloc(sizeof(MALLOC_SAMPLE));
+    if(unlikely(!s))
+        return;
+
+    s->ptr = ptr;
+    s->weight = malloc_sampling_weight(size);
+    s->subsystem = malloc_sampling_subsystem_id();
+
+    size_t bucket = malloc_sampling_bucket(ptr);
+    SPINLOCK *spinlock = malloc_sampling_stripe(bucket);
+
+    MALLOC_SAMPLE *old = NULL;
+    spinlock_lock(spinlock);
+
+    // the same pointer may be there, when it was released without freez()
+    MALLOC_SAMPLE **pp = &malloc_sampling.buckets[bucket];
+    while(*pp) {
+        if((*pp)->ptr == ptr) {
+            old = *pp;
+            *pp = old->next;
+            break;
+        }
+        pp = &(*pp)->next;
+    }
+
+    s->next = malloc_sampling.buckets[bucket];
+    __atomic_store_n(&malloc_sampling.buckets[bucket], s, __ATOMIC_RELEASE);
+    malloc_sampling_account(s, true);
+
+    if(old)
+        malloc_sampling_account(old, false);
+
+    spinlock_unlock(spinlock);
+
+    if(old)
+        free(old);
+    else
+        __atomic_add_fetch(&malloc_sampling.memory, sizeof(MALLOC_SAMPLE), __ATOMIC_RELAXED);
+}
+
+void malloc_sampling_free_sample(void *ptr) {
+    if(unlikely(!ptr || !malloc_sampling.buckets))
+        return;
+
+    size_t bucket = malloc_sampling_bucket(ptr);
+
+    // most of the buckets are empty, so most frees return here without locking
+    if(likely(!__atomic_load_n(&malloc_sampling.buckets[bucket], __ATOMIC_ACQUIRE)))
+        return;
+
+    SPINLOCK *spinlock = malloc_sampling_stripe(bucket);
+    MALLOC_SAMPLE *found = NULL;
+
+    spinlock_lock(spinlock);
+    MALLOC_SAMPLE **pp = &malloc_sampling.buckets[bucket];
+    while(*pp) {
+        if((*pp)->ptr == ptr) {
+            found = *pp;
+            __atomic_store_n(pp, found->next, __ATOMIC_RELEASE);
+            malloc_sampling_account(found, false);
+            break;
+        }
+        pp = &(*pp)->next;
+    }
+    spinlock_unlock(spinlock);
+
+    if(found) {
+        free(found);
+        __atomic_sub_fetch(&malloc_sampling.memory, sizeof(MALLOC_SAMPLE), __ATOMIC_RELAXED);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// public API
+
+// interval_bytes = 0 keeps sampling disabled
+// it can be enabled only once - the allocations made before are not tracked
+void malloc_sampling_enable(size_t interval_bytes) {
+    if(!interval_bytes || malloc_sampling.buckets)
+        return;
+
+    for(size_t i = 0; i < MALLOC_SAMPLING_STRIPES ; i++)
+        spinlock_init(&malloc_sampling.stripes[i]);
+
+    // the first subsystem collects everything that cannot be attributed
+    strncpyz(malloc_sampling.subsystems.array[0].name, "other", MALLOC_SAMPLING_SUBSYSTEM_NAME_MAX);
+    malloc_sampling.subsystems.used = 1;
+
+    malloc_sampling.buckets = calloc(MALLOC_SAMPLING_BUCKETS, sizeof(MALLOC_SAMPLE *));
+    if(!malloc_sampling.buckets) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "MALLOC SAMPLING: cannot allocate the index of sampled allocations");
+        return;
+    }
+
+    __atomic_add_fetch(&malloc_sampling.memory, MALLOC_SAMPLING_BUCKETS * sizeof(MALLOC_SAMPLE *), __ATOMIC_RELAXED);
+
+    malloc_sampling_globals.interval = interval_bytes;
+    __atomic_store_n(&malloc_sampling_globals.enabled, true, __ATOMIC_RELEASE);
+
+    nd_log(NDLS_DAEMON, NDLP_INFO, "MALLOC SAMPLING: sampling one allocation every %zu bytes", interval_bytes);
+}
+
+size_t malloc_sampling_subsystems(MALLOC_SAMPLING_SUBSYSTEM_STATS *stats, size_t max) {
+    if(!malloc_sampling_enabled())
+        return 0;
+
+    size_t used = __atomic_load_n(&malloc_sampling.subsystems.used, __ATOMIC_ACQUIRE);
+    if(used > max) used = max;
+
+    for(size_t i = 0; i < used ; i++) {
+        MALLOC_SAMPLING_SUBSYSTEM *ss = &malloc_sampling.subsystems.array[i];
+        strncpyz(stats[i].name, ss->name, MALLOC_SAMPLING_SUBSYSTEM_NAME_MAX);
+        stats[i].live_bytes = __atomic_load_n(&ss->live_bytes, __ATOMIC_RELAXED);
+        stats[i].live_samples = __atomic_load_n(&ss->live_samples, __ATOMIC_RELAXED);
+    }
+
+    return used;
+}
+
+// the memory used by the sampler itself
+size_t malloc_sampling_memory(void) {
+    return __atomic_load_n(&malloc_sampling.memory, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_MALLOC_SAMPLING_H
+#define NETDATA_MALLOC_SAMPLING_H 1
+
+#include "../libnetdata.h"
+
+// sampled accounting of the allocations made with mallocz() and friends
+// on average one allocation every interval bytes is sampled, and it is attributed
+// to the subsystem of the thread that made it (its thread tag, without the [...] suffix)
+
+#define MALLOC_SAMPLING_MAX_SUBSYSTEMS 64
+#define MALLOC_SAMPLING_SUBSYSTEM_NAME_MAX 15
+
+typedef struct malloc_sampling_subsystem_stats {
+    char name[MALLOC_SAMPLING_SUBSYSTEM_NAME_MAX + 1];
+    size_t live_bytes;          // the estimated bytes currently allocated
+    size_t live_samples;        // the allocations currently tracked
+} MALLOC_SAMPLING_SUBSYSTEM_STATS;
+
+extern struct malloc_sampling_globals {
+    bool enabled;
+    size_t interval;
+} malloc_sampling_globals;
+
+extern __thread int64_t malloc_sampling_countdown;
+
+void malloc_sampling_enable(size_t interval_bytes);
+void malloc_sampling_alloc_sample(void *ptr, size_t size);
+void malloc_sampling_free_sample(void *ptr);
+size_t malloc_sampling_subsystems(MALLOC_SAMPLING_SUBSYSTEM_STATS *stats, size_t max);
+size_t malloc_sampling_memory(void);
+
+static inline bool malloc_sampling_enabled(void) {
+    return __atomic_load_n(&malloc_sampling_globals.enabled, __ATOMIC_RELAXED);
+}
+
+// to be called after every successful allocation
+static inline void malloc_sampling_alloc(void *ptr, size_t size) {
+    if(likely(!malloc_sampling_enabled()))
+        return;
+
+    malloc_sampling_countdown -= (int64_t)size;
+    if(unlikely(malloc_sampling_countdown <= 0))
+        malloc_sampling_alloc_sample(ptr, size);
+}
+
+// to be called before every free
+static inline void malloc_sampling_free(void *ptr) {
+    if(unlikely(malloc_sampling_enabled()))
+        malloc_sampling_free_sample(ptr);
+}
+
+#endif // NETDATA_MALLOC_SAMPLING_H
@@ -15,6 +15,18 @@ typedef struct owa_page {
 } OWA_PAGE;
 
 static size_t onewayalloc_total_memory = 0;
+static size_t OWA_NATURAL_PAGE_SIZE = 0;
+
+// each thread keeps the pages of destroyed OWAs, to reuse them for the next ones
+// pages are cached in size classes of 1, 2, 4, 8 ... hardware pages,
+// and the thread stops caching them when it has OWA_CACHE_MAX_BYTES cached
+#define OWA_CACHE_CLASSES 12
+#define OWA_CACHE_MAX_BYTES (8 * 1024 * 1024)
+
+static __thread struct {
+    size_t bytes;
+    OWA_PAGE *pages[OWA_CACHE_CLASSES];
+} owa_cache = { 0 };
 
 size_t onewayalloc_allocated_memory(void) {
     return __atomic_load_n(&onewayalloc_total_memory, __ATOMIC_RELAXED);
@@ -33,9 +45,57 @@ static inline size_t natural_alignment(size_t size) {
 // Once it is created, the called may call the onewayalloc_mallocz()
 // any number of times, for any amount of memory.
 
-static OWA_PAGE *onewayalloc_create_internal(OWA_PAGE *head, size_t size_hint) {
-    static size_t OWA_NATURAL_PAGE_SIZE = 0;
+// returns the cache class of a page size (a multiple of the hardware page size),
+// or OWA_CACHE_CLASSES if the size is too big to be cached
+static inline size_t onewayalloc_cache_class(size_t size) {
+    size_t pages = size / OWA_NATURAL_PAGE_SIZE;
+    size_t class = 0;
+
+    while(((size_t)1 << class) < pages && class < OWA_CACHE_CLASSES)
+        class++;
+
+    return class;
+}
+
+static inline OWA_PAGE *onewayalloc_cache_get(size_t class) {
+    OWA_PAGE *page = owa_cache.pages[class];
+    if(page) {
+        owa_cache.pages[class] = page->next;
+        owa_cache.bytes -= page->size;
+    }
+
+    return page;
+}
+
+static inline bool onewayalloc_cache_put(OWA_PAGE *page) {
+    size_t class = onewayalloc_cache_class(page->size);
+    if(class >= OWA_CACHE_CLASSES ||
+        page->size != OWA_NATURAL_PAGE_SIZE << class ||
+        owa_cache.bytes + page->size > OWA_CACHE_MAX_BYTES)
+        return false;
+
+    page->next = owa_cache.pages[class];
+    owa_cache.pages[class] = page;
+    owa_cache.bytes += page->size;
+    return true;
+}
+
+// free the pages cached by the calling thread - called when the thread exits
+void onewayalloc_thread_cache_free(void) {
+    size_t total_size = 0;
+
+    for(size_t class = 0; class < OWA_CACHE_CLASSES ; class++) {
+        OWA_PAGE *page;
+        while((page = onewayalloc_cache_get(class))) {
+            total_size += page->size;
+            freez(page);
+        }
+    }
+
+    __atomic_sub_fetch(&onewayalloc_total_memory, total_size, __ATOMIC_RELAXED);
+}
 
+static OWA_PAGE *onewayalloc_create_internal(OWA_PAGE *head, size_t size_hint) {
     if(unlikely(!OWA_NATURAL_PAGE_SIZE)) {
         long int page_size = sysconf(_SC_PAGE_SIZE);
         if (unlikely(page_size == -1))
@@ -63,10 +123,20 @@ static OWA_PAGE *onewayalloc_create_internal(OWA_PAGE *head, size_t size_hint) {
     // Make sure our allocations are always a multiple of the hardware page size
     if(size % OWA_NATURAL_PAGE_SIZE) size = size + OWA_NATURAL_PAGE_SIZE - (size % OWA_NATURAL_PAGE_SIZE);
 
-    // OWA_PAGE *page = (OWA_PAGE *)netdata_mmap(NULL, size, MAP_ANONYMOUS|MAP_PRIVATE, 0);
-    // if(unlikely(!page)) fatal("Cannot allocate onewayalloc buffer of size %zu", size);
-    OWA_PAGE *page = (OWA_PAGE *)mallocz(size);
-    __atomic_add_fetch(&onewayalloc_total_memory, size, __ATOMIC_RELAXED);
+    // round it up to its cache class, to reuse a cached page if there is one
+    OWA_PAGE *page = NULL;
+    size_t class = onewayalloc_cache_class(size);
+    if(class < OWA_CACHE_CLASSES) {
+        size = OWA_NATURAL_PAGE_SIZE << class;
+        page = onewayalloc_cache_get(class);
+    }
+
+    if(!page) {
+        // OWA_PAGE *page = (OWA_PAGE *)netdata_mmap(NULL, size, MAP_ANONYMOUS|MAP_PRIVATE, 0);
+        // if(unlikely(!page)) fatal("Cannot allocate onewayalloc buffer of size %zu", size);
+        page = (OWA_PAGE *)mallocz(size);
+        __atomic_add_fetch(&onewayalloc_total_memory, size, __ATOMIC_RELAXED);
+    }
 
     page->size = size;
     page->offset = natural_alignment(sizeof(OWA_PAGE));
@@ -200,11 +270,14 @@ void onewayalloc_destroy(ONEWAYALLOC *owa) {
     size_t total_size = 0;
     OWA_PAGE *page = head;
     while(page) {
-        total_size += page->size;
-
         OWA_PAGE *p = page;
         page = page->next;
 
+        if(onewayalloc_cache_put(p))
+            continue;
+
+        total_size += p->size;
+
         // munmap(p, p->size);
         freez(p);
     }
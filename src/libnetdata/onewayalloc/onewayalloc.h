@@ -17,5 +17,6 @@ void onewayalloc_freez(ONEWAYALLOC *owa, const void *ptr);
 void *onewayalloc_doublesize(ONEWAYALLOC *owa, const void *src, size_t oldsize);
 
 size_t onewayalloc_allocated_memory(void);
+void onewayalloc_thread_cache_free(void);
 
 #endif // ONEWAYALLOC_H
@@ -14,27 +14,33 @@
 // and the RegQueryValueEx will set your size variable to the required buffer size. However,
 // if the source is "Global" or one or more object index values, you will need to increment
 // the buffer size in a loop until RegQueryValueEx does not return ERROR_MORE_DATA.
+//
+// RegQueryValueEx sets size to the bytes it returned, so the size of the buffer is kept
+// separately: the same buffer is used for all the objects this thread queries, and it grows
+// only until it fits the biggest of them, instead of growing again for every bigger object.
 static LPBYTE getPerformanceData(const char *pwszSource) {
-    static __thread DWORD size = 0;
+    static __thread DWORD allocated = 0;
     static __thread LPBYTE buffer = NULL;
 
     if(pwszSource == (const char *)0x01) {
         freez(buffer);
         buffer = NULL;
-        size = 0;
+        allocated = 0;
         return NULL;
     }
 
-    if(!size) {
-        size = 32 * 1024;
-        buffer = mallocz(size);
+    if(!allocated) {
+        allocated = 32 * 1024;
+        buffer = mallocz(allocated);
     }
 
     LONG status = ERROR_SUCCESS;
+    DWORD size = allocated;
     while ((status = RegQueryValueEx(HKEY_PERFORMANCE_DATA, pwszSource,
                                      NULL, NULL, buffer, &size)) == ERROR_MORE_DATA) {
-        size *= 2;
-        buffer = reallocz(buffer, size);
+        allocated *= 2;
+        buffer = reallocz(buffer, allocated);
+        size = allocated;
     }
 
     if (status != ERROR_SUCCESS) {
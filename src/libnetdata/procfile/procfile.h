@@ -47,6 +47,9 @@ typedef enum __attribute__ ((__packed__)) procfile_separator {
     PF_CHAR_IS_CLOSE
 } PF_CHAR_TYPE;
 
+#define PROCFILE_FAST_SEPARATORS_MAX 16
+#define PROCFILE_FAST_PARSER_DISABLED 0xff
+
 typedef struct procfile {
     char *filename;                 // not populated until procfile_filename() is called
     uint32_t flags;
@@ -56,6 +59,13 @@ typedef struct procfile {
     pflines *lines;
     pfwords *words;
     PF_CHAR_TYPE separators[256];
+
+    // the non-word characters above space, when the file can be parsed with
+    // the vectorized parser (no quotes, no parenthesis, only '\n' and '\r' as newlines)
+    // PROCFILE_FAST_PARSER_DISABLED when the byte loop has to be used
+    uint8_t fast_separators_count;
+    unsigned char fast_separators[PROCFILE_FAST_SEPARATORS_MAX];
+
     char data[];                    // allocated buffer to keep file contents
 } procfile;
 
@@ -72,6 +82,15 @@ procfile *procfile_open(const char *filename, const char *separators, uint32_t f
 // if separators == NULL, the last separators are used
 procfile *procfile_reopen(procfile *ff, const char *filename, const char *separators, uint32_t flags);
 
+// allocate a procfile without a file, to be used with procfile_readall_fd()
+procfile *procfile_new(const char *separators, uint32_t flags);
+
+// read and parse a file the caller keeps open, using positional reads
+// the fd is never closed by procfile, so the caller can keep it open across iterations
+// if ff == NULL, a new procfile is allocated; on failure ff is freed and NULL is returned
+// if separators == NULL, the last separators are used
+procfile *procfile_readall_fd(procfile *ff, int fd, const char *separators, uint32_t flags);
+
 // example walk-through a procfile parsed file
 void procfile_print(procfile *ff);
 
@@ -18,6 +18,7 @@ void sender_thread_buffer_free(void){}
 void query_target_free(void){}
 void service_exits(void){}
 void rrd_collector_finished(void){}
+void global_statistics_thread_exit(void){}
 
 // required by get_system_cpus()
 const char *netdata_configured_host_prefix = "";
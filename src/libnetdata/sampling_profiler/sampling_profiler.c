@@ -0,0 +1,272 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "sampling_profiler.h"
+
+#if defined(OS_LINUX) && defined(HAVE_BACKTRACE)
+#include <execinfo.h>
+#include <sys/time.h>
+
+// the frames of the signal handler and the signal trampoline
+#define ND_PROFILER_SKIP_FRAMES 2
+
+typedef struct nd_profiler_sample {
+    bool ready;                                 // the signal handler has finished writing it
+    char tag[ND_THREAD_TAG_MAX + 1];
+    uint32_t frames;
+    void *pc[ND_PROFILER_MAX_FRAMES + ND_PROFILER_SKIP_FRAMES];
+} ND_PROFILER_SAMPLE;
+
+static struct {
+    SPINLOCK spinlock;                          // protects the installation of the signal handler
+    bool handler_installed;
+    bool running;                               // atomic - a session is in progress
+
+    ND_PROFILER_SAMPLE *samples;                // atomic - not NULL only while sampling
+    size_t max;
+    size_t used;                                // atomic
+    size_t dropped;                             // atomic
+    size_t in_handler;                          // atomic - signal handlers currently running
+} profiler = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+};
+
+static void nd_profiler_signal_handler(int signo __maybe_unused) {
+    int saved_errno = errno;
+
+    __atomic_add_fetch(&profiler.in_handler, 1, __ATOMIC_ACQUIRE);
+
+    ND_PROFILER_SAMPLE *samples = __atomic_load_n(&profiler.samples, __ATOMIC_ACQUIRE);
+    if(samples) {
+        size_t slot = __atomic_fetch_add(&profiler.used, 1, __ATOMIC_RELAXED);
+        if(slot < profiler.max) {
+            ND_PROFILER_SAMPLE *s = &samples[slot];
+
+            // only threads with a netdata tag unblock SIGPROF, so this does not query the OS
+            const char *tag = nd_thread_tag();
+            size_t i;
+            for(i = 0; i < ND_THREAD_TAG_MAX && tag[i] ; i++)
+                s->tag[i] = tag[i];
+            s->tag[i] = '\0';
+
+            int frames = backtrace(s->pc, ND_PROFILER_MAX_FRAMES + ND_PROFILER_SKIP_FRAMES);
+            s->frames = (frames > ND_PROFILER_SKIP_FRAMES) ? (uint32_t)frames : 0;
+
+            __atomic_store_n(&s->ready, true, __ATOMIC_RELEASE);
+        }
+        else
+            __atomic_add_fetch(&profiler.dropped, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_sub_fetch(&profiler.in_handler, 1, __ATOMIC_RELEASE);
+
+    errno = saved_errno;
+}
+
+static void nd_profiler_install_handler(void) {
+    if(__atomic_load_n(&profiler.handler_installed, __ATOMIC_ACQUIRE))
+        return;
+
+    spinlock_lock(&profiler.spinlock);
+    if(!profiler.handler_installed) {
+        // backtrace() loads libgcc the first time it is called,
+        // which is not safe to happen inside a signal handler
+        void *warmup[2];
+        backtrace(warmup, 2);
+
+        struct sigaction sa = { 0 };
+        sa.sa_handler = nd_profiler_signal_handler;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+
+        if(sigaction(SIGPROF, &sa, NULL) == -1)
+            nd_log(NDLS_DAEMON, NDLP_ERR, "PROFILER: cannot install the SIGPROF handler");
+        else
+            __atomic_store_n(&profiler.handler_installed, true, __ATOMIC_RELEASE);
+    }
+    spinlock_unlock(&profiler.spinlock);
+}
+
+void nd_profiler_thread_init(void) {
+    nd_profiler_install_handler();
+
+    // all signals are blocked by the signals thread before any other thread is started
+    sigset_t sigset;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGPROF);
+    pthread_sigmask(SIG_UNBLOCK, &sigset, NULL);
+}
+
+static bool nd_profiler_timer_set(size_t frequency_hz) {
+    struct itimerval timer = { 0 };
+
+    if(frequency_hz) {
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = (suseconds_t)(USEC_PER_SEC / frequency_hz);
+        timer.it_value = timer.it_interval;
+    }
+
+    return setitimer(ITIMER_PROF, &timer, NULL) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// aggregation
+
+static int nd_profiler_sample_compar(const void *a, const void *b) {
+    const ND_PROFILER_SAMPLE *s1 = a, *s2 = b;
+
+    int rc = strcmp(s1->tag, s2->tag);
+    if(rc) return rc;
+
+    if(s1->frames != s2->frames)
+        return (s1->frames < s2->frames) ? -1 : 1;
+
+    return memcmp(s1->pc, s2->pc, s1->frames * sizeof(void *));
+}
+
+// backtrace_symbols() returns "binary(function+0x12) [0x1234]", or "binary(+0x12) [0x1234]"
+// when the function is not exported - we keep the function, or the binary and the offset
+static void nd_profiler_frame_to_buffer(BUFFER *wb, const char *symbol) {
+    const char *open = strchr(symbol, '(');
+    const char *close = open ? strchr(open, ')') : NULL;
+
+    if(open && close && open[1] != '+' && open[1] != ')') {
+        const char *end = open + 1;
+        while(end < close && *end != '+')
+            end++;
+
+        buffer_fast_strcat(wb, open + 1, end - open - 1);
+        return;
+    }
+
+    if(open && close) {
+        const char *binary = open;
+        while(binary > symbol && binary[-1] != '/')
+            binary--;
+
+        buffer_fast_strcat(wb, binary, open - binary);
+        buffer_fast_strcat(wb, open + 1, close - open - 1);
+        return;
+    }
+
+    // no parenthesis, keep it as-is, without the characters that have a meaning in folded stacks
+    for(const char *s = symbol; *s ; s++)
+        buffer_putc(wb, (*s == ' ' || *s == ';') ? '_' : *s);
+}
+
+static void nd_profiler_stack_to_buffer(BUFFER *wb, ND_PROFILER_SAMPLE *s, size_t count) {
+    buffer_strcat(wb, s->tag[0] ? s->tag : "UNKNOWN");
+
+    int frames = (int)s->frames - ND_PROFILER_SKIP_FRAMES;
+    void **pc = &s->pc[ND_PROFILER_SKIP_FRAMES];
+
+    char **symbols = backtrace_symbols(pc, frames);
+
+    // folded stacks start from the outermost frame
+    for(int f = frames - 1; f >= 0 ; f--) {
+        buffer_putc(wb, ';');
+
+        if(symbols)
+            nd_profiler_frame_to_buffer(wb, symbols[f]);
+        else
+            buffer_sprintf(wb, "%p", pc[f]);
+    }
+
+    free(symbols);
+
+    buffer_sprintf(wb, " %zu\n", count);
+}
+
+// ----------------------------------------------------------------------------
+// public API
+
+ND_PROFILER_STATUS nd_profiler_folded_stacks(BUFFER *wb, time_t duration_s, size_t frequency_hz, size_t *samples, size_t *dropped) {
+    *samples = 0;
+    *dropped = 0;
+
+    if(!__atomic_load_n(&profiler.handler_installed, __ATOMIC_ACQUIRE))
+        return ND_PROFILER_NOT_SUPPORTED;
+
+    bool expected = false;
+    if(!__atomic_compare_exchange_n(&profiler.running, &expected, true, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return ND_PROFILER_BUSY;
+
+    if(duration_s < 1) duration_s = 1;
+    if(duration_s > ND_PROFILER_MAX_DURATION) duration_s = ND_PROFILER_MAX_DURATION;
+    if(!frequency_hz) frequency_hz = ND_PROFILER_DEFAULT_FREQUENCY;
+    if(frequency_hz > ND_PROFILER_MAX_FREQUENCY) frequency_hz = ND_PROFILER_MAX_FREQUENCY;
+
+    // ITIMER_PROF counts the CPU time of the whole process,
+    // so the expected samples scale with the number of CPUs
+    size_t max = (size_t)duration_s * frequency_hz * (size_t)os_get_system_cpus();
+    if(max > ND_PROFILER_MAX_SAMPLES) max = ND_PROFILER_MAX_SAMPLES;
+
+    ND_PROFILER_SAMPLE *array = callocz(max, sizeof(ND_PROFILER_SAMPLE));
+    profiler.max = max;
+    __atomic_store_n(&profiler.used, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&profiler.dropped, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&profiler.samples, array, __ATOMIC_RELEASE);
+
+    ND_PROFILER_STATUS status = ND_PROFILER_OK;
+    if(nd_profiler_timer_set(frequency_hz)) {
+        // the threads calling us are not sampled while they sleep here,
+        // since ITIMER_PROF signals are delivered to the threads consuming CPU
+        sleep_usec((usec_t)duration_s * USEC_PER_SEC);
+        nd_profiler_timer_set(0);
+    }
+    else {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "PROFILER: cannot arm the profiling timer");
+        status = ND_PROFILER_FAILED;
+    }
+
+    // stop sampling, and wait for the signal handlers still running
+    __atomic_store_n(&profiler.samples, NULL, __ATOMIC_RELEASE);
+    while(__atomic_load_n(&profiler.in_handler, __ATOMIC_ACQUIRE))
+        tinysleep();
+
+    size_t used = __atomic_load_n(&profiler.used, __ATOMIC_RELAXED);
+    if(used > max) used = max;
+    *dropped = __atomic_load_n(&profiler.dropped, __ATOMIC_RELAXED);
+
+    // keep only the complete samples at the beginning of the array
+    size_t entries = 0;
+    for(size_t i = 0; i < used ; i++) {
+        if(!__atomic_load_n(&array[i].ready, __ATOMIC_ACQUIRE) || !array[i].frames)
+            continue;
+
+        if(entries != i)
+            array[entries] = array[i];
+
+        entries++;
+    }
+    *samples = entries;
+
+    qsort(array, entries, sizeof(ND_PROFILER_SAMPLE), nd_profiler_sample_compar);
+
+    for(size_t i = 0; i < entries ; ) {
+        size_t count = 1;
+        while(i + count < entries && nd_profiler_sample_compar(&array[i], &array[i + count]) == 0)
+            count++;
+
+        nd_profiler_stack_to_buffer(wb, &array[i], count);
+        i += count;
+    }
+
+    freez(array);
+    __atomic_store_n(&profiler.running, false, __ATOMIC_RELEASE);
+
+    return status;
+}
+
+#else // !OS_LINUX || !HAVE_BACKTRACE
+
+void nd_profiler_thread_init(void) {
+    ;
+}
+
+ND_PROFILER_STATUS nd_profiler_folded_stacks(BUFFER *wb __maybe_unused, time_t duration_s __maybe_unused, size_t frequency_hz __maybe_unused, size_t *samples, size_t *dropped) {
+    *samples = 0;
+    *dropped = 0;
+    return ND_PROFILER_NOT_SUPPORTED;
+}
+
+#endif
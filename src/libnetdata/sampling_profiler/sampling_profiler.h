@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_SAMPLING_PROFILER_H
+#define NETDATA_SAMPLING_PROFILER_H 1
+
+#include "../libnetdata.h"
+
+// a sampling CPU profiler for the threads of netdata
+// SIGPROF is delivered to the threads consuming CPU, which record their stack
+
+#define ND_PROFILER_MAX_FRAMES 32
+#define ND_PROFILER_MAX_SAMPLES 65536
+#define ND_PROFILER_DEFAULT_FREQUENCY 99
+#define ND_PROFILER_MAX_FREQUENCY 1000
+#define ND_PROFILER_MAX_DURATION 60
+
+typedef enum __attribute__((packed)) {
+    ND_PROFILER_OK = 0,
+    ND_PROFILER_BUSY,               // another profiling session is running
+    ND_PROFILER_NOT_SUPPORTED,      // not available on this system
+    ND_PROFILER_FAILED,             // the timer could not be armed
+} ND_PROFILER_STATUS;
+
+// called by every thread created by nd_thread_create(), to accept SIGPROF
+void nd_profiler_thread_init(void);
+
+// profile for duration_s seconds, sampling at frequency_hz per second of CPU time
+// and append the stacks to wb, in folded format (flamegraph / speedscope compatible):
+// THREAD_TAG;outermost_frame;...;innermost_frame SAMPLES
+ND_PROFILER_STATUS nd_profiler_folded_stacks(BUFFER *wb, time_t duration_s, size_t frequency_hz, size_t *samples, size_t *dropped);
+
+#endif // NETDATA_SAMPLING_PROFILER_H
@@ -0,0 +1,522 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "shm_ring.h"
+
+static inline size_t shm_ring_size(uint32_t records) {
+    return sizeof(struct shm_ring_header) + (size_t)records * sizeof(SHM_RING_RECORD);
+}
+
+static SHM_RING *shm_ring_map(const char *filename, int fd, size_t size, bool owner) {
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(mem == MAP_FAILED) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "SHM RING: cannot mmap() %zu bytes of '%s'", size, filename);
+        return NULL;
+    }
+
+    SHM_RING *ring = callocz(1, sizeof(SHM_RING));
+    ring->filename = strdupz(filename);
+    ring->fd = fd;
+    ring->size = size;
+    ring->owner = owner;
+    ring->hdr = mem;
+    return ring;
+}
+
+void shm_ring_destroy(SHM_RING *ring) {
+    if(!ring) return;
+
+    munmap(ring->hdr, ring->size);
+    close(ring->fd);
+
+    if(ring->owner)
+        unlink(ring->filename);
+
+    freez(ring->filename);
+    freez(ring);
+}
+
+// ----------------------------------------------------------------------------
+// the agent side
+
+SHM_RING *shm_ring_create(const char *filename, uint32_t records) {
+    // round up to a power of 2, so that positions are found with a mask
+    uint32_t n = 64;
+    while(n < records && n < (1U << 30))
+        n <<= 1;
+    records = n;
+
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if(fd == -1) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "SHM RING: cannot create '%s'", filename);
+        return NULL;
+    }
+
+    size_t size = shm_ring_size(records);
+    if(ftruncate(fd, (off_t)size) != 0) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "SHM RING: cannot resize '%s' to %zu bytes", filename, size);
+        close(fd);
+        unlink(filename);
+        return NULL;
+    }
+
+    SHM_RING *ring = shm_ring_map(filename, fd, size, true);
+    if(!ring) {
+        close(fd);
+        unlink(filename);
+        return NULL;
+    }
+
+    ring->mask = records - 1;
+    ring->hdr->records = records;
+    ring->hdr->version = SHM_RING_VERSION;
+    __atomic_store_n(&ring->hdr->head, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->hdr->tail, 0, __ATOMIC_RELAXED);
+
+    // the magic goes last, so that a producer never sees a half initialized header
+    __atomic_store_n(&ring->hdr->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+
+    return ring;
+}
+
+size_t shm_ring_consume(SHM_RING *ring, shm_ring_consume_cb_t cb, void *data) {
+    uint64_t head = __atomic_load_n(&ring->hdr->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = __atomic_load_n(&ring->hdr->tail, __ATOMIC_RELAXED);
+
+    if(unlikely(head - tail > (uint64_t)ring->mask + 1)) {
+        // the producer wrote garbage - ignore what it has written
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "SHM RING: '%s' has head %"PRIu64" and tail %"PRIu64", more than %u records apart - discarding them",
+               ring->filename, head, tail, ring->mask + 1);
+        __atomic_store_n(&ring->hdr->tail, head, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    size_t count = 0;
+    while(tail != head) {
+        // copy the record, so that the producer cannot change it while we use it
+        SHM_RING_RECORD rec = ring->hdr->data[tail & ring->mask];
+        tail++;
+        count++;
+
+        if(unlikely(!cb(&rec, data)))
+            break;
+    }
+
+    __atomic_store_n(&ring->hdr->tail, tail, __ATOMIC_RELEASE);
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+// the plugin side
+
+SHM_RING *shm_ring_attach(const char *filename, shm_ring_full_cb_t full_cb, void *full_cb_data) {
+    int fd = open(filename, O_RDWR | O_CLOEXEC);
+    if(fd == -1) {
+        nd_log(NDLS_COLLECTORS, NDLP_ERR, "SHM RING: cannot open '%s'", filename);
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct shm_ring_header)) {
+        nd_log(NDLS_COLLECTORS, NDLP_ERR, "SHM RING: '%s' is too small", filename);
+        close(fd);
+        return NULL;
+    }
+
+    SHM_RING *ring = shm_ring_map(filename, fd, (size_t)st.st_size, false);
+    if(!ring) {
+        close(fd);
+        return NULL;
+    }
+
+    struct shm_ring_header *hdr = ring->hdr;
+    if(__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+        hdr->version != SHM_RING_VERSION ||
+        !hdr->records || (hdr->records & (hdr->records - 1)) ||
+        shm_ring_size(hdr->records) > ring->size) {
+        nd_log(NDLS_COLLECTORS, NDLP_ERR, "SHM RING: '%s' is not a version %d ring", filename, SHM_RING_VERSION);
+        shm_ring_destroy(ring);
+        return NULL;
+    }
+
+    ring->mask = hdr->records - 1;
+    ring->producer.head = __atomic_load_n(&hdr->head, __ATOMIC_RELAXED);
+    ring->producer.tail = __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+    ring->producer.full_cb = full_cb;
+    ring->producer.full_cb_data = full_cb_data;
+    __atomic_store_n(&hdr->producer_pid, (uint32_t)getpid(), __ATOMIC_RELAXED);
+
+    return ring;
+}
+
+SHM_RING *shm_ring_attach_from_env(shm_ring_full_cb_t full_cb, void *full_cb_data) {
+    const char *filename = getenv(SHM_RING_ENV);
+    if(!filename || !*filename)
+        return NULL;
+
+    return shm_ring_attach(filename, full_cb, full_cb_data);
+}
+
+void shm_ring_commit(SHM_RING *ring) {
+    __atomic_store_n(&ring->hdr->head, ring->producer.head, __ATOMIC_RELEASE);
+}
+
+static bool shm_ring_wait_for_space(SHM_RING *ring) {
+    // publish what we have and ask the consumer to drain it
+    shm_ring_commit(ring);
+    if(ring->producer.full_cb)
+        ring->producer.full_cb(ring->producer.full_cb_data);
+
+    usec_t started_ut = now_monotonic_usec();
+    while(true) {
+        ring->producer.tail = __atomic_load_n(&ring->hdr->tail, __ATOMIC_ACQUIRE);
+        if(ring->producer.head - ring->producer.tail <= ring->mask)
+            return true;
+
+        if(now_monotonic_usec() - started_ut > SHM_RING_FULL_TIMEOUT_UT) {
+            nd_log(NDLS_COLLECTORS, NDLP_ERR, "SHM RING: '%s' is full and the agent does not drain it", ring->filename);
+            return false;
+        }
+
+        sleep_usec(100);
+    }
+}
+
+bool shm_ring_push(SHM_RING *ring, SHM_RING_RECORD_TYPE type, uint32_t slot, int64_t value) {
+    if(unlikely(ring->producer.head - ring->producer.tail > ring->mask)) {
+        ring->producer.tail = __atomic_load_n(&ring->hdr->tail, __ATOMIC_ACQUIRE);
+
+        if(unlikely(ring->producer.head - ring->producer.tail > ring->mask && !shm_ring_wait_for_space(ring)))
+            return false;
+    }
+
+    SHM_RING_RECORD *rec = &ring->hdr->data[ring->producer.head & ring->mask];
+    rec->type = type;
+    rec->slot = slot;
+    rec->value = value;
+    ring->producer.head++;
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// the pipe fallback of the plugin side
+
+SHM_RING_PIPE *shm_ring_pipe_create(int fd) {
+    void *mem = mmap(NULL, SHM_RING_PIPE_MEMORY_DEFAULT, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mem == MAP_FAILED) {
+        nd_log(NDLS_COLLECTORS, NDLP_ERR, "SHM RING: cannot mmap() %d bytes for the pipe writer", SHM_RING_PIPE_MEMORY_DEFAULT);
+        return NULL;
+    }
+
+    SHM_RING_PIPE *p = callocz(1, sizeof(SHM_RING_PIPE));
+    p->fd = fd;
+    p->size = SHM_RING_PIPE_MEMORY_DEFAULT;
+    p->memory = mem;
+
+#if defined(OS_LINUX)
+    struct stat st;
+    p->vmsplice = fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+#endif
+
+    return p;
+}
+
+static bool shm_ring_pipe_wait_writable(int fd) {
+    struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+    while(poll(&pfd, 1, -1) == -1) {
+        if(errno != EINTR)
+            return false;
+    }
+    return !(pfd.revents & (POLLERR | POLLHUP | POLLNVAL));
+}
+
+static bool shm_ring_pipe_write_all(int fd, const char *data, size_t len) {
+    while(len) {
+        ssize_t rc = write(fd, data, len);
+        if(rc > 0) {
+            data += rc;
+            len -= rc;
+            continue;
+        }
+
+        if(rc < 0 && errno == EINTR)
+            continue;
+
+        if(rc < 0 && errno == EAGAIN && shm_ring_pipe_wait_writable(fd))
+            continue;
+
+        nd_log(NDLS_COLLECTORS, NDLP_ERR, "SHM RING: cannot write %zu bytes to fd %d", len, fd);
+        return false;
+    }
+
+    return true;
+}
+
+// give the pending bytes of the memory to the fd
+static bool shm_ring_pipe_give(SHM_RING_PIPE *p) {
+    while(p->given < p->used) {
+        ssize_t rc;
+
+#if defined(OS_LINUX)
+        if(p->vmsplice) {
+            struct iovec iov = {
+                .iov_base = p->memory + p->given,
+                .iov_len = p->used - p->given,
+            };
+            rc = vmsplice(p->fd, &iov, 1, 0);
+
+            if(rc < 0 && (errno == EINVAL || errno == ENOSYS || errno == EBADF)) {
+                // the kernel or the fd does not support it - copy from now on
+                p->vmsplice = false;
+                continue;
+            }
+
+            if(rc > 0)
+                p->in_pipe = true;
+        }
+        else
+#endif
+            rc = write(p->fd, p->memory + p->given, p->used - p->given);
+
+        if(rc > 0) {
+            p->given += rc;
+            continue;
+        }
+
+        if(rc < 0 && errno == EINTR)
+            continue;
+
+        if(rc < 0 && errno == EAGAIN && shm_ring_pipe_wait_writable(p->fd))
+            continue;
+
+        nd_log(NDLS_COLLECTORS, NDLP_ERR, "SHM RING: cannot give %zu bytes to fd %d", p->used - p->given, p->fd);
+        return false;
+    }
+
+    // the bytes copied by write() can be overwritten
+    if(!p->in_pipe)
+        p->used = p->given = 0;
+
+    return true;
+}
+
+// the pages given with vmsplice() are referenced by the pipe until the agent
+// reads them, so the memory is reused only when the pipe is empty
+static void shm_ring_pipe_reclaim(SHM_RING_PIPE *p) {
+    if(!p->in_pipe || p->given != p->used)
+        return;
+
+    int unread = 0;
+    if(ioctl(p->fd, FIONREAD, &unread) == 0 && unread == 0) {
+        p->in_pipe = false;
+        p->used = p->given = 0;
+    }
+}
+
+static bool shm_ring_pipe_make_room(SHM_RING_PIPE *p, size_t len, bool *error) {
+    if(p->size - p->used >= len)
+        return true;
+
+    if(!shm_ring_pipe_give(p)) {
+        *error = true;
+        return false;
+    }
+
+    shm_ring_pipe_reclaim(p);
+    return p->size - p->used >= len;
+}
+
+bool shm_ring_pipe_write(SHM_RING_PIPE *p, const char *data, size_t len) {
+    bool error = false;
+    if(unlikely(!shm_ring_pipe_make_room(p, len, &error))) {
+        if(error)
+            return false;
+
+        // everything pending has been given to the fd, so the order is kept
+        return shm_ring_pipe_write_all(p->fd, data, len);
+    }
+
+    memcpy(p->memory + p->used, data, len);
+    p->used += len;
+    return true;
+}
+
+bool shm_ring_pipe_printf(SHM_RING_PIPE *p, const char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    int len = vsnprintf(p->memory + p->used, p->size - p->used, fmt, args);
+    va_end(args);
+
+    if(unlikely(len < 0))
+        return false;
+
+    if(likely((size_t)len < p->size - p->used)) {
+        p->used += len;
+        return true;
+    }
+
+    bool error = false;
+    if(shm_ring_pipe_make_room(p, len + 1, &error)) {
+        va_start(args, fmt);
+        vsnprintf(p->memory + p->used, p->size - p->used, fmt, args);
+        va_end(args);
+        p->used += len;
+        return true;
+    }
+
+    if(error)
+        return false;
+
+    // it does not fit in the free memory - format it aside and copy it
+    char *txt = mallocz(len + 1);
+    va_start(args, fmt);
+    vsnprintf(txt, len + 1, fmt, args);
+    va_end(args);
+
+    bool ret = shm_ring_pipe_write_all(p->fd, txt, len);
+    freez(txt);
+    return ret;
+}
+
+bool shm_ring_pipe_flush(SHM_RING_PIPE *p) {
+    return shm_ring_pipe_give(p);
+}
+
+void shm_ring_pipe_destroy(SHM_RING_PIPE *p) {
+    if(!p) return;
+
+    shm_ring_pipe_flush(p);
+
+    // the pipe keeps its own references to the pages still in it
+    munmap(p->memory, p->size);
+    freez(p);
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+#define SHM_RING_PIPE_UNITTEST_LINES 100000
+
+struct shm_ring_pipe_unittest {
+    int fd;
+    bool vmsplice;
+    bool ok;
+};
+
+static size_t shm_ring_pipe_unittest_line(size_t i, char *dst, size_t size) {
+    if(i % 10000 == 9999) {
+        // larger than the memory of the writer
+        size_t len = SHM_RING_PIPE_MEMORY_DEFAULT + 1000 + i % 100;
+        if(dst) {
+            for(size_t c = 0; c < len - 1 && c < size; c++)
+                dst[c] = (char)('a' + (i + c) % 26);
+            dst[len - 1] = '\n';
+        }
+        return len;
+    }
+
+    return (size_t)snprintf(dst, size, "SET2 'dimension%zu' %zu %*s\n", i, i * 7919, (int)(i % 200), "x");
+}
+
+static void *shm_ring_pipe_unittest_writer(void *ptr) {
+    struct shm_ring_pipe_unittest *t = ptr;
+
+    SHM_RING_PIPE *p = shm_ring_pipe_create(t->fd);
+    if(!p) {
+        close(t->fd);
+        return NULL;
+    }
+
+    if(!t->vmsplice)
+        p->vmsplice = false;
+
+    char *big = mallocz(SHM_RING_PIPE_MEMORY_DEFAULT * 2);
+    bool ok = true;
+    for(size_t i = 0; ok && i < SHM_RING_PIPE_UNITTEST_LINES; i++) {
+        if(i % 10000 == 9999) {
+            size_t len = shm_ring_pipe_unittest_line(i, big, SHM_RING_PIPE_MEMORY_DEFAULT * 2);
+            ok = shm_ring_pipe_write(p, big, len);
+        }
+        else if(i % 2)
+            ok = shm_ring_pipe_printf(p, "SET2 'dimension%zu' %zu %*s\n", i, i * 7919, (int)(i % 200), "x");
+        else {
+            char line[512];
+            size_t len = shm_ring_pipe_unittest_line(i, line, sizeof(line));
+            ok = shm_ring_pipe_write(p, line, len);
+        }
+
+        if(ok && i % 1000 == 0)
+            ok = shm_ring_pipe_flush(p);
+    }
+    freez(big);
+
+    t->ok = ok && shm_ring_pipe_flush(p);
+    shm_ring_pipe_destroy(p);
+    close(t->fd);
+    return NULL;
+}
+
+static int shm_ring_pipe_unittest_run(bool vmsplice) {
+    int fds[2];
+    if(pipe(fds) == -1) {
+        fprintf(stderr, "SHM RING PIPE: cannot create a pipe\n");
+        return 1;
+    }
+
+#if defined(OS_LINUX)
+    // a small pipe makes the writer wait for the reader
+    (void)fcntl(fds[1], F_SETPIPE_SZ, 4096);
+#endif
+
+    struct shm_ring_pipe_unittest t = { .fd = fds[1], .vmsplice = vmsplice, };
+    ND_THREAD *thread = nd_thread_create("SHMPIPE", NETDATA_THREAD_OPTION_JOINABLE, shm_ring_pipe_unittest_writer, &t);
+
+    BUFFER *received = buffer_create(0, NULL);
+    while(true) {
+        buffer_need_bytes(received, 65536);
+        ssize_t rc = read(fds[0], &received->buffer[received->len], received->size - received->len - 1);
+        if(rc > 0) {
+            received->len += rc;
+            continue;
+        }
+        if(rc < 0 && errno == EINTR)
+            continue;
+        break;
+    }
+    nd_thread_join(thread);
+    close(fds[0]);
+
+    BUFFER *expected = buffer_create(0, NULL);
+    for(size_t i = 0; i < SHM_RING_PIPE_UNITTEST_LINES; i++) {
+        size_t len = shm_ring_pipe_unittest_line(i, NULL, 0);
+        buffer_need_bytes(expected, len + 1);
+        shm_ring_pipe_unittest_line(i, &expected->buffer[expected->len], len + 1);
+        expected->len += len;
+    }
+
+    int errors = 0;
+    if(!t.ok) {
+        fprintf(stderr, "SHM RING PIPE: the writer failed (vmsplice %s)\n", vmsplice ? "enabled" : "disabled");
+        errors++;
+    }
+
+    if(received->len != expected->len || memcmp(received->buffer, expected->buffer, expected->len) != 0) {
+        fprintf(stderr, "SHM RING PIPE: received %zu bytes, expected %zu bytes, the data differ (vmsplice %s)\n",
+                (size_t)received->len, (size_t)expected->len, vmsplice ? "enabled" : "disabled");
+        errors++;
+    }
+
+    buffer_free(received);
+    buffer_free(expected);
+    return errors;
+}
+
+int shm_ring_pipe_unittest(void) {
+    int errors = shm_ring_pipe_unittest_run(true);
+    errors += shm_ring_pipe_unittest_run(false);
+
+    fprintf(stderr, "SHM RING PIPE: %s\n", errors ? "FAILED" : "OK");
+    return errors;
+}
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_SHM_RING_H
+#define NETDATA_SHM_RING_H
+
+#include "../libnetdata.h"
+
+// ----------------------------------------------------------------------------
+// shared memory ring
+//
+// A single producer, single consumer ring of fixed size binary records, in a
+// file mapped by an external plugin (the producer) and the agent (the
+// consumer). When the shared memory transport is enabled for a plugin, the
+// agent creates it before starting the plugin and gives its filename to the
+// plugin in the environment variable SHM_RING_ENV.
+//
+// The plugin still defines charts and dimensions on its text pipe, giving
+// them slots (SLOT:N), and then it writes BEGIN / SET / END records to the
+// ring, referencing them by these slots. After a batch of records it sends
+// FLUSH on the pipe. The agent processes the records when it reaches the
+// FLUSH, so they are always processed after the text lines sent before them.
+
+#define SHM_RING_ENV "NETDATA_PLUGIN_SHM"
+#define SHM_RING_MAGIC 0x4e445348 // NDSH
+#define SHM_RING_VERSION 1
+#define SHM_RING_RECORDS_DEFAULT 32768
+#define SHM_RING_FULL_TIMEOUT_UT (60 * USEC_PER_SEC)
+
+typedef enum __attribute__((packed)) {
+    SHM_RING_RECORD_BEGIN = 1,      // slot: the chart slot, value: microseconds since the last collection, or 0
+    SHM_RING_RECORD_SET = 2,        // slot: the dimension slot, value: the collected value
+    SHM_RING_RECORD_END = 3,        // value: the collection timestamp in microseconds, or 0 for now
+} SHM_RING_RECORD_TYPE;
+
+typedef struct shm_ring_record {
+    uint32_t type;
+    uint32_t slot;
+    int64_t value;
+} SHM_RING_RECORD;
+
+struct shm_ring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t records;                   // a power of 2
+    uint32_t producer_pid;              // set by the producer when it attaches
+
+    // head and tail are ever increasing record counters, on their own cache lines
+    uint64_t head __attribute__((aligned(64)));     // written only by the producer
+    uint64_t tail __attribute__((aligned(64)));     // written only by the consumer
+
+    SHM_RING_RECORD data[] __attribute__((aligned(64)));
+};
+
+typedef void (*shm_ring_full_cb_t)(void *data);
+typedef bool (*shm_ring_consume_cb_t)(const SHM_RING_RECORD *rec, void *data);
+
+typedef struct shm_ring {
+    char *filename;
+    int fd;
+    size_t size;
+    bool owner;                         // we created the file, so we delete it
+    uint32_t mask;
+    struct shm_ring_header *hdr;
+
+    struct {
+        uint64_t head;                  // records written, not committed yet
+        uint64_t tail;                  // the last tail seen
+        shm_ring_full_cb_t full_cb;     // called when the ring is full, to make the consumer drain it
+        void *full_cb_data;
+    } producer;
+} SHM_RING;
+
+// the agent side
+SHM_RING *shm_ring_create(const char *filename, uint32_t records);
+size_t shm_ring_consume(SHM_RING *ring, shm_ring_consume_cb_t cb, void *data);
+
+// the plugin side
+SHM_RING *shm_ring_attach(const char *filename, shm_ring_full_cb_t full_cb, void *full_cb_data);
+SHM_RING *shm_ring_attach_from_env(shm_ring_full_cb_t full_cb, void *full_cb_data);
+bool shm_ring_push(SHM_RING *ring, SHM_RING_RECORD_TYPE type, uint32_t slot, int64_t value);
+void shm_ring_commit(SHM_RING *ring);
+
+void shm_ring_destroy(SHM_RING *ring);
+
+// ----------------------------------------------------------------------------
+// the pipe fallback of the plugin side
+//
+// When the ring is not available (the transport is disabled, or the ring cannot
+// be attached), plugins send their values as text on their pipe. The pipe writer
+// formats the text in its own memory and, when the fd is a pipe (Linux only),
+// gives the pages of that memory to the pipe with vmsplice(), so that the kernel
+// does not copy them, like write() does. The memory is written again only when
+// the pipe has no unread bytes (FIONREAD), so after the agent has read all the
+// pages given to the pipe. Until then, and when the fd is not a pipe, the text
+// is copied to the fd with write().
+//
+// The pipe writer is not thread safe. Plugins that also write to the same fd
+// with stdio have to flush stdio before using it, and the other way around.
+
+#define SHM_RING_PIPE_MEMORY_DEFAULT (256 * 1024)
+
+typedef struct shm_ring_pipe {
+    int fd;
+    bool vmsplice;                      // the fd is a pipe, and vmsplice() works on it
+    bool in_pipe;                       // pages of the memory are given to the pipe, and may not be read yet
+    size_t size;                        // the size of the memory
+    size_t used;                        // the bytes of the memory filled with text
+    size_t given;                       // the bytes of the memory given to the fd
+    char *memory;
+} SHM_RING_PIPE;
+
+SHM_RING_PIPE *shm_ring_pipe_create(int fd);
+bool shm_ring_pipe_write(SHM_RING_PIPE *p, const char *data, size_t len);
+bool shm_ring_pipe_printf(SHM_RING_PIPE *p, const char *fmt, ...) PRINTFLIKE(2, 3);
+bool shm_ring_pipe_flush(SHM_RING_PIPE *p);
+void shm_ring_pipe_destroy(SHM_RING_PIPE *p);
+
+int shm_ring_pipe_unittest(void);
+
+static inline bool shm_ring_begin(SHM_RING *ring, uint32_t chart_slot, usec_t microseconds) {
+    return shm_ring_push(ring, SHM_RING_RECORD_BEGIN, chart_slot, (int64_t)microseconds);
+}
+
+static inline bool shm_ring_set(SHM_RING *ring, uint32_t dimension_slot, int64_t value) {
+    return shm_ring_push(ring, SHM_RING_RECORD_SET, dimension_slot, value);
+}
+
+static inline bool shm_ring_end(SHM_RING *ring, usec_t timestamp_ut) {
+    return shm_ring_push(ring, SHM_RING_RECORD_END, 0, (int64_t)timestamp_ut);
+}
+
+#endif //NETDATA_SHM_RING_H
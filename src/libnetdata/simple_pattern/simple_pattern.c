@@ -2,9 +2,32 @@
 
 #include "../libnetdata.h"
 
+// lists with at least this many patterns get an index
+#define SIMPLE_PATTERN_INDEX_MIN_PATTERNS 8
+
+// case insensitive lookups in the index of longer strings are not indexed
+#define SIMPLE_PATTERN_INDEX_MAX_KEY 1024
+
+// The index of a long list of patterns.
+// Exact and prefix patterns without asterisks in the middle are hashed, so they
+// are looked up at once, while the rest are still tried one by one, but only
+// up to the position of the best indexed match. The first pattern in the list
+// that matches is always the one that decides, like without the index.
+struct simple_pattern_index {
+    Pvoid_t exact;                      // JudyHS: match -> the first exact pattern with it
+    Pvoid_t prefixes;                   // JudyHS: match -> the first prefix pattern with it
+
+    uint32_t *prefix_lengths;           // the distinct lengths of the prefixes, ascending
+    uint32_t prefix_lengths_count;
+
+    struct simple_pattern **others;     // the patterns that are not indexed, in order
+    uint32_t others_count;
+};
+
 struct simple_pattern {
     const char *match;
     uint32_t len;
+    uint32_t position;                  // the position of the pattern in the list
 
     SIMPLE_PREFIX_MODE mode;
     bool negative;
@@ -12,8 +35,15 @@ struct simple_pattern {
 
     struct simple_pattern *child;
     struct simple_pattern *next;
+
+    struct simple_pattern_index *index; // only on the first pattern of the list
+    uint64_t id;                        // only on the first pattern of the list
 };
 
+static uint64_t simple_pattern_last_id = 0;
+
+static void simple_pattern_index_build(struct simple_pattern *root, uint32_t patterns);
+
 static struct simple_pattern *parse_pattern(char *str, SIMPLE_PREFIX_MODE default_mode, size_t count) {
     if(unlikely(count >= 1000))
         return NULL;
@@ -97,6 +127,7 @@ SIMPLE_PATTERN *simple_pattern_create(const char *list, const char *separators,
 
     char *buf = mallocz(strlen(list) + 1);
     const char *s = list;
+    uint32_t patterns = 0;
 
     while(s && *s) {
         buf[0] = '\0';
@@ -146,6 +177,7 @@ SIMPLE_PATTERN *simple_pattern_create(const char *list, const char *separators,
         struct simple_pattern *m = parse_pattern(buf, default_mode, 0);
         m->negative = negative;
         m->case_sensitive = case_sensitive;
+        m->position = patterns++;
 
         if(default_mode == SIMPLE_PATTERN_SUBSTRING) {
             m->mode = SIMPLE_PATTERN_SUBSTRING;
@@ -165,6 +197,13 @@ SIMPLE_PATTERN *simple_pattern_create(const char *list, const char *separators,
     }
 
     freez(buf);
+
+    if(root && patterns >= SIMPLE_PATTERN_INDEX_MIN_PATTERNS)
+        simple_pattern_index_build(root, patterns);
+
+    if(root)
+        root->id = __atomic_add_fetch(&simple_pattern_last_id, 1, __ATOMIC_RELAXED);
+
     return (SIMPLE_PATTERN *)root;
 }
 
@@ -203,9 +242,9 @@ static inline int sp_strncmp(const char *s1, const char *s2, size_t n, bool case
     return strncasecmp(s1, s2, n);
 }
 
-static inline char *sp_strstr(const char *haystack, const char *needle, bool case_sensitive) {
+static inline char *sp_strstr(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len, bool case_sensitive) {
     if(case_sensitive)
-        return strstr(haystack, needle);
+        return memmem(haystack, haystack_len, needle, needle_len);
 
     return strcasestr(haystack, needle);
 }
@@ -228,7 +267,7 @@ static inline bool match_pattern(struct simple_pattern *m, const char *str, size
 
             case SIMPLE_PATTERN_SUBSTRING:
                 if(!m->len) return true;
-                if((s = sp_strstr(str, m->match, m->case_sensitive))) {
+                if((s = sp_strstr(str, len, m->match, m->len, m->case_sensitive))) {
                     wildcarded = add_wildcarded(str, s - str, wildcarded, wildcarded_size);
                     if(!m->child) {
                         add_wildcarded(&s[m->len], len - (&s[m->len] - str), wildcarded, wildcarded_size);
@@ -276,9 +315,146 @@ static inline bool match_pattern(struct simple_pattern *m, const char *str, size
     return false;
 }
 
+// ----------------------------------------------------------------------------
+// the index
+
+static inline void simple_pattern_index_key(char *dst, const char *src, size_t len) {
+    for(size_t i = 0; i < len ; i++)
+        dst[i] = (char)tolower((unsigned char)src[i]);
+}
+
+static void simple_pattern_index_add(Pvoid_t *judy, struct simple_pattern *m) {
+    char key[m->len + 1];
+    const char *k = m->match;
+
+    if(!m->case_sensitive) {
+        simple_pattern_index_key(key, m->match, m->len);
+        k = key;
+    }
+
+    Pvoid_t *PValue = JudyHSIns(judy, (void *)k, m->len, PJE0);
+    if(!PValue || PValue == PJERR)
+        fatal("SIMPLE PATTERN: corrupted JudyHS array");
+
+    // keep the first one
+    if(!*PValue)
+        *PValue = m;
+}
+
+static inline bool simple_pattern_is_indexable(struct simple_pattern *m) {
+    return !m->child && m->len &&
+           (m->mode == SIMPLE_PATTERN_EXACT || m->mode == SIMPLE_PATTERN_PREFIX) &&
+           (m->case_sensitive || m->len <= SIMPLE_PATTERN_INDEX_MAX_KEY);
+}
+
+static void simple_pattern_index_build(struct simple_pattern *root, uint32_t patterns) {
+    struct simple_pattern_index *idx = callocz(1, sizeof(*idx));
+    idx->others = mallocz(patterns * sizeof(*idx->others));
+    idx->prefix_lengths = mallocz(patterns * sizeof(*idx->prefix_lengths));
+
+    for(struct simple_pattern *m = root; m ; m = m->next) {
+        if(!simple_pattern_is_indexable(m)) {
+            idx->others[idx->others_count++] = m;
+            continue;
+        }
+
+        if(m->mode == SIMPLE_PATTERN_EXACT)
+            simple_pattern_index_add(&idx->exact, m);
+
+        else {
+            simple_pattern_index_add(&idx->prefixes, m);
+
+            // insert its length, keeping them sorted and unique
+            uint32_t i = 0;
+            while(i < idx->prefix_lengths_count && idx->prefix_lengths[i] < m->len)
+                i++;
+
+            if(i == idx->prefix_lengths_count || idx->prefix_lengths[i] != m->len) {
+                memmove(&idx->prefix_lengths[i + 1], &idx->prefix_lengths[i],
+                        (idx->prefix_lengths_count - i) * sizeof(*idx->prefix_lengths));
+                idx->prefix_lengths[i] = m->len;
+                idx->prefix_lengths_count++;
+            }
+        }
+    }
+
+    root->index = idx;
+}
+
+static void simple_pattern_index_free(struct simple_pattern_index *idx) {
+    if(!idx) return;
+
+    JudyHSFreeArray(&idx->exact, PJE0);
+    JudyHSFreeArray(&idx->prefixes, PJE0);
+    freez(idx->prefix_lengths);
+    freez(idx->others);
+    freez(idx);
+}
+
+static inline bool match_pattern(struct simple_pattern *m, const char *str, size_t len, char *wildcarded, size_t *wildcarded_size);
+
+static inline struct simple_pattern *simple_pattern_index_match(struct simple_pattern *root, const char *str, size_t len) {
+    struct simple_pattern_index *idx = root->index;
+    struct simple_pattern *best = NULL;
+
+    char key[SIMPLE_PATTERN_INDEX_MAX_KEY];
+    const char *k = str;
+    size_t key_len = len;
+
+    if(!root->case_sensitive) {
+        // prefixes are at most SIMPLE_PATTERN_INDEX_MAX_KEY, so this is enough for them,
+        // and longer strings cannot match the exact patterns we indexed
+        if(key_len > sizeof(key)) key_len = sizeof(key);
+        simple_pattern_index_key(key, str, key_len);
+        k = key;
+    }
+
+    Pvoid_t *PValue;
+    if(idx->exact && key_len == len && (PValue = JudyHSGet(idx->exact, (void *)k, len)))
+        best = *PValue;
+
+    for(uint32_t i = 0; i < idx->prefix_lengths_count && idx->prefix_lengths[i] <= key_len ; i++) {
+        PValue = JudyHSGet(idx->prefixes, (void *)k, idx->prefix_lengths[i]);
+        if(PValue) {
+            struct simple_pattern *m = *PValue;
+            if(!best || m->position < best->position)
+                best = m;
+        }
+    }
+
+    // try the rest, up to the best match we have
+    for(uint32_t i = 0; i < idx->others_count ; i++) {
+        struct simple_pattern *m = idx->others[i];
+        if(best && m->position > best->position)
+            break;
+
+        size_t wss = 0;
+        if(match_pattern(m, str, len, NULL, &wss))
+            return m;
+    }
+
+    return best;
+}
+
+// ----------------------------------------------------------------------------
+
 static inline SIMPLE_PATTERN_RESULT simple_pattern_matches_extract_with_length(SIMPLE_PATTERN *list, const char *str, size_t len, char *wildcarded, size_t wildcarded_size) {
     struct simple_pattern *m, *root = (struct simple_pattern *)list;
 
+    if(root->index) {
+        m = simple_pattern_index_match(root, str, len);
+        if(!m)
+            return SP_NOT_MATCHED;
+
+        if(unlikely(wildcarded)) {
+            // the index does not extract, so match it again to do it
+            *wildcarded = '\0';
+            match_pattern(m, str, len, wildcarded, &wildcarded_size);
+        }
+
+        return m->negative ? SP_MATCHED_NEGATIVE : SP_MATCHED_POSITIVE;
+    }
+
     for(m = root; m ; m = m->next) {
         char *ws = wildcarded;
         size_t wss = wildcarded_size;
@@ -294,7 +470,7 @@ static inline SIMPLE_PATTERN_RESULT simple_pattern_matches_extract_with_length(S
 }
 
 SIMPLE_PATTERN_RESULT simple_pattern_matches_buffer_extract(SIMPLE_PATTERN *list, BUFFER *str, char *wildcarded, size_t wildcarded_size) {
-    if(!list || !str || buffer_strlen(str)) return SP_NOT_MATCHED;
+    if(!list || !str || !buffer_strlen(str)) return SP_NOT_MATCHED;
     return simple_pattern_matches_extract_with_length(list, buffer_tostring(str), buffer_strlen(str), wildcarded, wildcarded_size);
 }
 
@@ -322,9 +498,14 @@ static inline void free_pattern(struct simple_pattern *m) {
     freez(m);
 }
 
+uint64_t simple_pattern_id(SIMPLE_PATTERN *list) {
+    return list ? list->id : 0;
+}
+
 void simple_pattern_free(SIMPLE_PATTERN *list) {
     if(!list) return;
 
+    simple_pattern_index_free(((struct simple_pattern *)list)->index);
     free_pattern(((struct simple_pattern *)list));
 }
 
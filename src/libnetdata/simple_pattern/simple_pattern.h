@@ -45,6 +45,10 @@ SIMPLE_PATTERN_RESULT simple_pattern_matches_length_extract(SIMPLE_PATTERN *list
 // list can be NULL, in which case, this does nothing.
 void simple_pattern_free(SIMPLE_PATTERN *list);
 
+// a number identifying this pattern, unique for the lifetime of the process (0 for NULL)
+// unlike the pointer, it is never reused, so results can be cached by it
+uint64_t simple_pattern_id(SIMPLE_PATTERN *list);
+
 void simple_pattern_dump(uint64_t debug_type, SIMPLE_PATTERN *p) ;
 int simple_pattern_is_potential_name(SIMPLE_PATTERN *p) ;
 char *simple_pattern_iterate(SIMPLE_PATTERN **p);
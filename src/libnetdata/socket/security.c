@@ -9,6 +9,7 @@ const char *tls_version=NULL;
 const char *tls_ciphers=NULL;
 bool netdata_ssl_validate_certificate =  true;
 bool netdata_ssl_validate_certificate_sender =  true;
+bool netdata_ssl_kernel_offload = true;
 
 static SOCKET_PEERS netdata_ssl_peers(NETDATA_SSL *ssl) {
     int sock_fd;
@@ -423,6 +424,94 @@ bool netdata_ssl_accept(NETDATA_SSL *ssl) {
     return true;
 }
 
+/**
+ * Kernel TLS
+ *
+ * Asks OpenSSL to hand the encryption of the connections of this context to the
+ * kernel after the handshake, when both OpenSSL and the kernel support it.
+ * SSL_read() and SSL_write() keep working as before, but the records are
+ * encrypted and decrypted by the kernel.
+ *
+ * @param ctx the context to change
+ */
+static void netdata_ssl_enable_kernel_offload(SSL_CTX *ctx) {
+#ifdef SSL_OP_ENABLE_KTLS
+    if(ctx && netdata_ssl_kernel_offload)
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#else
+    (void)ctx;
+#endif
+}
+
+/**
+ * Kernel TLS status
+ *
+ * @param ssl the connection to check
+ *
+ * @return true when the kernel encrypts the data sent on this connection
+ */
+bool netdata_ssl_kernel_offload_active(NETDATA_SSL *ssl) {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+    if(SSL_connection(ssl) && ssl->state == NETDATA_SSL_STATE_COMPLETE)
+        return BIO_get_ktls_send(SSL_get_wbio(ssl->conn)) != 0;
+#else
+    (void)ssl;
+#endif
+
+    return false;
+}
+
+/**
+ * TLS session resumption - get
+ *
+ * Returns a reference to the session of a client connection, so that the
+ * next connection to the same server can resume it, skipping the certificate
+ * exchange and the key agreement. TLS 1.3 servers send their tickets after
+ * the handshake, so this should be called when the connection is closing.
+ *
+ * @param ssl the connection
+ *
+ * @return the session, to be freed with netdata_ssl_session_free(), or NULL
+ */
+SSL_SESSION *netdata_ssl_session_get(NETDATA_SSL *ssl) {
+    if(!SSL_connection(ssl) || ssl->state != NETDATA_SSL_STATE_COMPLETE)
+        return NULL;
+
+    SSL_SESSION *session = SSL_get1_session(ssl->conn);
+
+#if OPENSSL_VERSION_NUMBER >= OPENSSL_VERSION_111
+    if(session && !SSL_SESSION_is_resumable(session)) {
+        SSL_SESSION_free(session);
+        session = NULL;
+    }
+#endif
+
+    return session;
+}
+
+/**
+ * TLS session resumption - set
+ *
+ * Offers a session of a previous connection to the server, before the handshake.
+ * If the server does not accept it, a full handshake is made.
+ *
+ * @param ssl the connection, opened but not connected yet
+ * @param session the session of the previous connection, can be NULL
+ */
+void netdata_ssl_session_set(NETDATA_SSL *ssl, SSL_SESSION *session) {
+    if(session && SSL_connection(ssl) && ssl->state == NETDATA_SSL_STATE_INIT)
+        SSL_set_session(ssl->conn, session);
+}
+
+bool netdata_ssl_session_reused(NETDATA_SSL *ssl) {
+    return SSL_connection(ssl) && ssl->state == NETDATA_SSL_STATE_COMPLETE && SSL_session_reused(ssl->conn);
+}
+
+void netdata_ssl_session_free(SSL_SESSION *session) {
+    if(session)
+        SSL_SESSION_free(session);
+}
+
 /**
  * Info Callback
  *
@@ -622,6 +711,8 @@ void netdata_ssl_initialize_ctx(int selector) {
                             // SSL_MODE_AUTO_RETRY |
                             0);
 
+                    netdata_ssl_enable_kernel_offload(netdata_ssl_web_server_ctx);
+
                     if(netdata_ssl_web_server_ctx && !netdata_ssl_validate_certificate)
                         SSL_CTX_set_verify(netdata_ssl_web_server_ctx, SSL_VERIFY_NONE, NULL);
                 }
@@ -640,6 +731,8 @@ void netdata_ssl_initialize_ctx(int selector) {
                         0
                 );
 
+                netdata_ssl_enable_kernel_offload(netdata_ssl_streaming_sender_ctx);
+
                 if(netdata_ssl_streaming_sender_ctx && !netdata_ssl_validate_certificate_sender)
                     SSL_CTX_set_verify(netdata_ssl_streaming_sender_ctx, SSL_VERIFY_NONE, NULL);
             }
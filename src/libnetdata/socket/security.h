@@ -51,6 +51,7 @@ extern const char *tls_version;
 extern const char *tls_ciphers;
 extern bool netdata_ssl_validate_certificate;
 extern bool netdata_ssl_validate_certificate_sender;
+extern bool netdata_ssl_kernel_offload;
 int ssl_security_location_for_context(SSL_CTX *ctx, const char *file, const char *path);
 
 void netdata_ssl_initialize_openssl();
@@ -71,5 +72,11 @@ ssize_t netdata_ssl_write(NETDATA_SSL *ssl, const void *buf, size_t num);
 
 ssize_t netdata_ssl_pending(NETDATA_SSL *ssl);
 bool netdata_ssl_has_pending(NETDATA_SSL *ssl);
+bool netdata_ssl_kernel_offload_active(NETDATA_SSL *ssl);
+
+SSL_SESSION *netdata_ssl_session_get(NETDATA_SSL *ssl);
+void netdata_ssl_session_set(NETDATA_SSL *ssl, SSL_SESSION *session);
+bool netdata_ssl_session_reused(NETDATA_SSL *ssl);
+void netdata_ssl_session_free(SSL_SESSION *session);
 
 #endif //NETDATA_SECURITY_H
@@ -10,6 +10,10 @@
 
 #include "../libnetdata.h"
 
+#if defined(OS_LINUX)
+#include <sys/epoll.h>
+#endif
+
 bool ip_to_hostname(const char *ip, char *dst, size_t dst_len) {
     if(!dst || !dst_len)
         return false;
@@ -342,7 +346,31 @@ int create_listen_socket_unix(const char *path, int listen_backlog) {
     return sock;
 }
 
-int create_listen_socket4(int socktype, const char *ip, uint16_t port, int listen_backlog) {
+// SO_REUSEPORT lets any process of the same user bind the same address,
+// so before using it, check that nobody else listens there already
+static bool listen_address_in_use(int family, int socktype, const struct sockaddr *sa, socklen_t sa_len) {
+    int sock = socket(family, socktype | DEFAULT_SOCKET_FLAGS, 0);
+    if(sock < 0)
+        return false;
+
+    // for UDP, SO_REUSEADDR would let us share the address with the other socket
+    if(socktype == SOCK_STREAM) {
+        int reuse = 1;
+        (void)setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+
+    if(family == AF_INET6) {
+        int ipv6only = 1;
+        (void)setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (void*)&ipv6only, sizeof(ipv6only));
+    }
+
+    bool in_use = (bind(sock, sa, sa_len) < 0 && errno == EADDRINUSE);
+    close(sock);
+
+    return in_use;
+}
+
+int create_listen_socket4(int socktype, const char *ip, uint16_t port, int listen_backlog, bool reuse_port) {
     int sock;
 
     sock = socket(AF_INET, socktype | DEFAULT_SOCKET_FLAGS, 0);
@@ -354,7 +382,8 @@ int create_listen_socket4(int socktype, const char *ip, uint16_t port, int liste
         return -1;
     }
     sock_setreuse(sock, 1);
-    sock_setreuse_port(sock, 0);
+    reuse_port = reuse_port && (socktype == SOCK_STREAM || socktype == SOCK_DGRAM);
+    sock_setreuse_port(sock, reuse_port ? 1 : 0);
     sock_setnonblock(sock);
     sock_setcloexec(sock);
     sock_enlarge_in(sock);
@@ -374,7 +403,8 @@ int create_listen_socket4(int socktype, const char *ip, uint16_t port, int liste
         return -1;
     }
 
-    if(bind (sock, (struct sockaddr *) &name, sizeof (name)) < 0) {
+    if((reuse_port && listen_address_in_use(AF_INET, socktype, (struct sockaddr *) &name, sizeof(name))) ||
+        bind (sock, (struct sockaddr *) &name, sizeof (name)) < 0) {
         close(sock);
         nd_log(NDLS_DAEMON, NDLP_ERR,
                "LISTENER: IPv4 bind() on ip '%s' port %d, socktype %d failed.",
@@ -399,7 +429,7 @@ int create_listen_socket4(int socktype, const char *ip, uint16_t port, int liste
     return sock;
 }
 
-int create_listen_socket6(int socktype, uint32_t scope_id, const char *ip, int port, int listen_backlog) {
+int create_listen_socket6(int socktype, uint32_t scope_id, const char *ip, int port, int listen_backlog, bool reuse_port) {
     int sock;
     int ipv6only = 1;
 
@@ -412,7 +442,8 @@ int create_listen_socket6(int socktype, uint32_t scope_id, const char *ip, int p
         return -1;
     }
     sock_setreuse(sock, 1);
-    sock_setreuse_port(sock, 0);
+    reuse_port = reuse_port && (socktype == SOCK_STREAM || socktype == SOCK_DGRAM);
+    sock_setreuse_port(sock, reuse_port ? 1 : 0);
     sock_setnonblock(sock);
     sock_setcloexec(sock);
     sock_enlarge_in(sock);
@@ -441,7 +472,8 @@ int create_listen_socket6(int socktype, uint32_t scope_id, const char *ip, int p
 
     name.sin6_scope_id = scope_id;
 
-    if (bind (sock, (struct sockaddr *) &name, sizeof (name)) < 0) {
+    if ((reuse_port && listen_address_in_use(AF_INET6, socktype, (struct sockaddr *) &name, sizeof(name))) ||
+        bind (sock, (struct sockaddr *) &name, sizeof (name)) < 0) {
         close(sock);
         nd_log(NDLS_DAEMON, NDLP_ERR,
                "LISTENER: IPv6 bind() on ip '%s' port %d, socktype %d failed.",
@@ -481,6 +513,7 @@ static inline int listen_sockets_add(LISTEN_SOCKETS *sockets, int fd, int family
     sockets->fds_families[sockets->opened] = family;
     sockets->fds_names[sockets->opened] = strdup_client_description(family, protocol, ip, port);
     sockets->fds_acl_flags[sockets->opened] = acl_flags;
+    sockets->fds_shared[sockets->opened] = false;
 
     sockets->opened++;
     return 0;
@@ -500,6 +533,7 @@ static inline void listen_sockets_init(LISTEN_SOCKETS *sockets) {
         sockets->fds[i] = -1;
         sockets->fds_names[i] = NULL;
         sockets->fds_types[i] = -1;
+        sockets->fds_shared[i] = false;
     }
 
     sockets->opened = 0;
@@ -509,8 +543,11 @@ static inline void listen_sockets_init(LISTEN_SOCKETS *sockets) {
 void listen_sockets_close(LISTEN_SOCKETS *sockets) {
     size_t i;
     for(i = 0; i < sockets->opened ;i++) {
-        close(sockets->fds[i]);
+        if(!sockets->fds_shared[i])
+            close(sockets->fds[i]);
+
         sockets->fds[i] = -1;
+        sockets->fds_shared[i] = false;
 
         freez(sockets->fds_names[i]);
         sockets->fds_names[i] = NULL;
@@ -714,7 +751,7 @@ static inline int bind_to_this(LISTEN_SOCKETS *sockets, const char *definition,
                 struct sockaddr_in *sin = (struct sockaddr_in *) rp->ai_addr;
                 inet_ntop(AF_INET, &sin->sin_addr, rip, INET_ADDRSTRLEN);
                 rport = ntohs(sin->sin_port);
-                fd = create_listen_socket4(socktype, rip, rport, listen_backlog);
+                fd = create_listen_socket4(socktype, rip, rport, listen_backlog, sockets->reuse_port);
                 break;
             }
 
@@ -722,7 +759,7 @@ static inline int bind_to_this(LISTEN_SOCKETS *sockets, const char *definition,
                 struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) rp->ai_addr;
                 inet_ntop(AF_INET6, &sin6->sin6_addr, rip, INET6_ADDRSTRLEN);
                 rport = ntohs(sin6->sin6_port);
-                fd = create_listen_socket6(socktype, scope_id, rip, rport, listen_backlog);
+                fd = create_listen_socket6(socktype, scope_id, rip, rport, listen_backlog, sockets->reuse_port);
                 break;
             }
 
@@ -799,6 +836,83 @@ int listen_sockets_setup(LISTEN_SOCKETS *sockets) {
     return (int)sockets->opened;
 }
 
+// a new listening socket, in the SO_REUSEPORT group of fd, so that the
+// kernel balances the TCP connections or the UDP datagrams between them
+static int create_listen_socket_clone(int fd, int socktype, int family, int listen_backlog) {
+    struct sockaddr_storage name;
+    socklen_t name_len = sizeof(name);
+
+    if(getsockname(fd, (struct sockaddr *)&name, &name_len) != 0)
+        return -1;
+
+    int sock = socket(family, socktype | DEFAULT_SOCKET_FLAGS, 0);
+    if(sock < 0)
+        return -1;
+
+    sock_setreuse(sock, 1);
+    if(sock_setreuse_port(sock, 1) != 0) {
+        close(sock);
+        return -1;
+    }
+    sock_setnonblock(sock);
+    sock_setcloexec(sock);
+    sock_enlarge_in(sock);
+
+    if(family == AF_INET6) {
+        int ipv6only = 1;
+        (void)setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (void*)&ipv6only, sizeof(ipv6only));
+    }
+
+    if(bind(sock, (struct sockaddr *)&name, name_len) < 0 ||
+        (socktype == SOCK_STREAM && listen(sock, listen_backlog) < 0)) {
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+// gives dst its own listening socket for every TCP and UDP socket of src opened
+// with reuse_port - the rest of the sockets are shared with src
+// returns the number of sockets dst owns
+size_t listen_sockets_clone(LISTEN_SOCKETS *src, LISTEN_SOCKETS *dst) {
+    listen_sockets_init(dst);
+
+    dst->config = src->config;
+    dst->config_section = src->config_section;
+    dst->default_bind_to = src->default_bind_to;
+    dst->default_port = src->default_port;
+    dst->backlog = src->backlog;
+    dst->reuse_port = src->reuse_port;
+
+    size_t owned = 0;
+    for(size_t i = 0; i < src->opened ;i++) {
+        int fd = -1;
+
+        if(src->reuse_port && (src->fds_types[i] == SOCK_STREAM || src->fds_types[i] == SOCK_DGRAM) &&
+            (src->fds_families[i] == AF_INET || src->fds_families[i] == AF_INET6)) {
+            fd = create_listen_socket_clone(src->fds[i], src->fds_types[i], src->fds_families[i], src->backlog);
+            if(fd == -1)
+                nd_log(NDLS_DAEMON, NDLP_WARNING,
+                       "LISTENER: cannot clone listening socket %s, sharing it",
+                       src->fds_names[i]);
+        }
+
+        dst->fds[i] = (fd != -1) ? fd : src->fds[i];
+        dst->fds_shared[i] = (fd == -1);
+        dst->fds_types[i] = src->fds_types[i];
+        dst->fds_families[i] = src->fds_families[i];
+        dst->fds_names[i] = src->fds_names[i] ? strdupz(src->fds_names[i]) : NULL;
+        dst->fds_acl_flags[i] = src->fds_acl_flags[i];
+
+        if(fd != -1)
+            owned++;
+    }
+    dst->opened = src->opened;
+
+    return owned;
+}
+
 
 // --------------------------------------------------------------------------------------------------------------------
 // connect to another host/port
@@ -1514,9 +1628,88 @@ int accept_socket(int fd, int flags, char *client_ip, size_t ipsize, char *clien
 // --------------------------------------------------------------------------------------------------------------------
 // poll() based listener
 // this should be the fastest possible listener for up to 100 sockets
-// above 100, an epoll() interface is needed on Linux
+// above 100, the epoll() interface is used on Linux: it is level triggered,
+// like poll(), because the callbacks do one read or write per event
 
 #define POLL_FDS_INCREASE_STEP 10
+#define POLL_EPOLL_MAX_EVENTS 1024
+
+#if defined(OS_LINUX)
+static inline uint32_t poll_to_epoll_events(short int events) {
+    uint32_t ev = 0;
+    if(events & POLLIN)  ev |= EPOLLIN;
+    if(events & POLLPRI) ev |= EPOLLPRI;
+    if(events & POLLOUT) ev |= EPOLLOUT;
+    return ev;
+}
+
+static inline short int epoll_to_poll_events(uint32_t ev) {
+    short int events = 0;
+    if(ev & EPOLLIN)  events |= POLLIN;
+    if(ev & EPOLLPRI) events |= POLLPRI;
+    if(ev & EPOLLOUT) events |= POLLOUT;
+    if(ev & EPOLLERR) events |= POLLERR;
+    if(ev & EPOLLHUP) events |= POLLHUP;
+    return events;
+}
+#endif
+
+// registers the slot to epoll, or updates its events when they changed
+static inline void poll_epoll_sync(POLLJOB *p, size_t slot, bool add) {
+#if defined(OS_LINUX)
+    POLLINFO *pi = &p->inf[slot];
+    struct pollfd *pf = &p->fds[slot];
+
+    if(p->epoll_fd == -1 || pf->fd == -1 || pi->epoll_unsupported || (!add && pi->epoll_events == pf->events))
+        return;
+
+    struct epoll_event ev = {
+        .events = poll_to_epoll_events(pf->events),
+        .data.u64 = slot,
+    };
+
+    if(epoll_ctl(p->epoll_fd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, pf->fd, &ev) == -1) {
+        if(add && errno == EPERM) {
+            // regular files cannot be watched, but they are always ready
+            pi->epoll_unsupported = true;
+            p->epoll_unsupported++;
+        }
+        else
+            nd_log(NDLS_DAEMON, NDLP_ERR,
+                   "POLLFD: LISTENER: epoll_ctl() failed on socket at slot %zu (fd %d)",
+                   slot, pf->fd);
+        return;
+    }
+
+    pi->epoll_events = pf->events;
+#else
+    (void)p; (void)slot; (void)add;
+#endif
+}
+
+static inline void poll_epoll_del(POLLJOB *p, POLLINFO *pi) {
+#if defined(OS_LINUX)
+    if(p->epoll_fd == -1)
+        return;
+
+    if(pi->epoll_unsupported) {
+        pi->epoll_unsupported = false;
+        p->epoll_unsupported--;
+    }
+    else if(pi->fd != -1)
+        (void)epoll_ctl(p->epoll_fd, EPOLL_CTL_DEL, pi->fd, NULL);
+
+    pi->epoll_events = 0;
+#else
+    (void)p; (void)pi;
+#endif
+}
+
+// changes the events of another slot, outside its callbacks
+void poll_set_events(POLLJOB *p, size_t slot, short int events) {
+    p->fds[slot].events = events;
+    poll_epoll_sync(p, slot, false);
+}
 
 inline POLLINFO *poll_add_fd(POLLJOB *p
                              , int fd
@@ -1558,6 +1751,8 @@ inline POLLINFO *poll_add_fd(POLLJOB *p
             p->inf[i].flags = 0;
             p->inf[i].socktype = -1;
             p->inf[i].port_acl = -1;
+            p->inf[i].epoll_events = 0;
+            p->inf[i].epoll_unsupported = false;
 
             p->inf[i].client_ip = NULL;
             p->inf[i].client_port = NULL;
@@ -1617,6 +1812,8 @@ inline POLLINFO *poll_add_fd(POLLJOB *p
         p->min = pi->slot;
     }
 
+    poll_epoll_sync(p, pi->slot, true);
+
     return pi;
 }
 
@@ -1627,6 +1824,8 @@ inline void poll_close_fd(POLLINFO *pi) {
 
     if(unlikely(pf->fd == -1)) return;
 
+    poll_epoll_del(p, pi);
+
     if(pi->flags & POLLINFO_FLAG_CLIENT_SOCKET) {
         pi->del_callback(pi);
 
@@ -1743,6 +1942,11 @@ static void poll_events_cleanup(void *pptr) {
 
     freez(p->fds);
     freez(p->inf);
+
+    if(p->epoll_fd != -1) {
+        close(p->epoll_fd);
+        p->epoll_fd = -1;
+    }
 }
 
 static int poll_process_error(POLLINFO *pi, struct pollfd *pf, short int revents) {
@@ -1783,6 +1987,8 @@ static inline int poll_process_send(POLLJOB *p, POLLINFO *pi, struct pollfd *pf,
 
     if (unlikely(pi->snd_callback(pi, &pf->events) == -1))
         poll_close_fd(&p->inf[slot]);
+    else
+        poll_epoll_sync(p, slot, false);
 
     // IMPORTANT:
     // pf and pi may be invalid below this point, they may have been reallocated.
@@ -1802,6 +2008,8 @@ static inline int poll_process_tcp_read(POLLJOB *p, POLLINFO *pi, struct pollfd
 
     if (pi->rcv_callback(pi, &pf->events) == -1)
         poll_close_fd(&p->inf[slot]);
+    else
+        poll_epoll_sync(p, slot, false);
 
     // IMPORTANT:
     // pf and pi may be invalid below this point, they may have been reallocated.
@@ -1809,7 +2017,7 @@ static inline int poll_process_tcp_read(POLLJOB *p, POLLINFO *pi, struct pollfd
     return 1;
 }
 
-static inline int poll_process_udp_read(POLLINFO *pi, struct pollfd *pf, time_t now __maybe_unused) {
+static inline int poll_process_udp_read(POLLJOB *p, POLLINFO *pi, struct pollfd *pf, time_t now __maybe_unused) {
     pi->last_received_t = now;
     pi->recv_count++;
 
@@ -1817,8 +2025,13 @@ static inline int poll_process_udp_read(POLLINFO *pi, struct pollfd *pf, time_t
     // but checking the access list on every UDP packet will destroy
     // performance, especially for statsd.
 
+    size_t slot = pi->slot;
+
     pf->events = 0;
-    if(pi->rcv_callback(pi, &pf->events) == -1)
+    int ret = pi->rcv_callback(pi, &pf->events);
+    poll_epoll_sync(p, slot, false);
+
+    if(ret == -1)
         return 0;
 
     // IMPORTANT:
@@ -1930,6 +2143,9 @@ void poll_events(LISTEN_SOCKETS *sockets
             .inf = NULL,
             .first_free = NULL,
 
+            .epoll_fd = -1,
+            .epoll_unsupported = 0,
+
             .complete_request_timeout = tcp_request_timeout_seconds,
             .idle_timeout = tcp_idle_timeout_seconds,
             .checks_every = (tcp_idle_timeout_seconds / 3) + 1,
@@ -1947,6 +2163,13 @@ void poll_events(LISTEN_SOCKETS *sockets
             .tmr_callback = tmr_callback?tmr_callback:poll_default_tmr_callback
     };
 
+#if defined(OS_LINUX)
+    p.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(p.epoll_fd == -1)
+        nd_log(NDLS_DAEMON, NDLP_ERR,
+               "POLLFD: LISTENER: epoll_create1() failed, falling back to poll()");
+#endif
+
     size_t i;
     for(i = 0; i < sockets->opened ;i++) {
 
@@ -2008,22 +2231,71 @@ void poll_events(LISTEN_SOCKETS *sockets
 
             for (i = 0; i <= p.max; i++) {
                 if(p.inf[i].flags & POLLINFO_FLAG_SERVER_SOCKET && p.inf[i].socktype == SOCK_STREAM) {
-                    p.fds[i].events = (short int) ((listen_sockets_active) ? POLLIN : 0);
+                    poll_set_events(&p, i, (short int) ((listen_sockets_active) ? POLLIN : 0));
+                }
+            }
+        }
+
+        // the slots that have events
+        size_t ready[p.max + 1], ready_max = 0;
+
+#if defined(OS_LINUX)
+        if(p.epoll_fd != -1) {
+            struct epoll_event evs[POLL_EPOLL_MAX_EVENTS];
+
+            // fds epoll cannot watch are always ready, so do not wait when we have them
+            retval = epoll_wait(p.epoll_fd, evs, POLL_EPOLL_MAX_EVENTS,
+                                p.epoll_unsupported ? 0 : ND_CHECK_CANCELLABILITY_WHILE_WAITING_EVERY_MS);
+
+            if(retval > 0) {
+                for(int e = 0; e < retval; e++) {
+                    size_t slot = (size_t)evs[e].data.u64;
+                    if(unlikely(slot > p.max || p.fds[slot].fd == -1))
+                        continue;
+
+                    p.fds[slot].revents = epoll_to_poll_events(evs[e].events);
+                    ready[ready_max++] = slot;
+                }
+            }
+
+            if(retval != -1 && p.epoll_unsupported) {
+                for(i = 0; i <= p.max; i++) {
+                    if(p.inf[i].epoll_unsupported && p.fds[i].fd != -1 && (p.fds[i].events & (POLLIN | POLLOUT))) {
+                        p.fds[i].revents = (short int)(p.fds[i].events & (POLLIN | POLLOUT));
+                        ready[ready_max++] = i;
+                    }
+                }
+
+                if(ready_max && !retval)
+                    retval = (int)ready_max;
+            }
+
+            if(unlikely(retval == -1 && errno == EINTR))
+                retval = 0;
+        }
+        else
+#endif
+        {
+            retval = poll(p.fds, p.max + 1, ND_CHECK_CANCELLABILITY_WHILE_WAITING_EVERY_MS);
+
+            if(retval > 0) {
+                for(i = 0; i <= p.max; i++) {
+                    if(p.fds[i].revents && p.fds[i].fd != -1)
+                        ready[ready_max++] = i;
                 }
             }
         }
 
-        retval = poll(p.fds, p.max + 1, ND_CHECK_CANCELLABILITY_WHILE_WAITING_EVERY_MS);
         time_t now = now_boottime_sec();
 
         if(unlikely(retval == -1)) {
             nd_log(NDLS_DAEMON, NDLP_ERR,
-                   "POLLFD: LISTENER: poll() failed while waiting on %zu sockets.",
-                   p.max + 1);
+                   "POLLFD: LISTENER: %s() failed while waiting on %zu sockets.",
+                   p.epoll_fd != -1 ? "epoll_wait" : "poll", p.max + 1);
 
             break;
         }
-        else if(unlikely(!retval)) {
+        else if(unlikely(!ready_max)) {
             // timeout
             ;
         }
@@ -2035,12 +2307,13 @@ void poll_events(LISTEN_SOCKETS *sockets
 
             // keep fast lookup arrays per function
             // to avoid looping through the entire list every time
-            size_t sends[p.max + 1], sends_max = 0;
-            size_t reads[p.max + 1], reads_max = 0;
-            size_t conns[p.max + 1], conns_max = 0;
-            size_t udprd[p.max + 1], udprd_max = 0;
+            size_t sends[ready_max], sends_max = 0;
+            size_t reads[ready_max], reads_max = 0;
+            size_t conns[ready_max], conns_max = 0;
+            size_t udprd[ready_max], udprd_max = 0;
 
-            for (i = 0; i <= p.max; i++) {
+            for (idx = 0; idx < ready_max; idx++) {
+                i = ready[idx];
                 pi = &p.inf[i];
                 pf = &p.fds[i];
                 revents = pf->revents;
@@ -2124,7 +2397,7 @@ void poll_events(LISTEN_SOCKETS *sockets
                 pi = &p.inf[i];
                 pf = &p.fds[i];
                 pf->revents = 0;
-                processed += poll_process_udp_read(pi, pf, now);
+                processed += poll_process_udp_read(&p, pi, pf, now);
             }
 
             // process TCP reads
@@ -2157,7 +2430,7 @@ void poll_events(LISTEN_SOCKETS *sockets
             for(i = 0; i <= p.max; i++) {
                 POLLINFO *pi = &p.inf[i];
 
-                if(likely(pi->flags & POLLINFO_FLAG_CLIENT_SOCKET)) {
+                if(likely((pi->flags & POLLINFO_FLAG_CLIENT_SOCKET) && !(pi->flags & POLLINFO_FLAG_NO_TIMEOUT))) {
                     if (unlikely(pi->send_count == 0 && p.complete_request_timeout > 0 && (now - pi->connected_t) >= p.complete_request_timeout)) {
                         nd_log(NDLS_DAEMON, NDLP_DEBUG,
                                "POLLFD: LISTENER: client slot %zu (fd %d) from %s port %s has not sent a complete request in %zu seconds - closing it. "
@@ -17,6 +17,7 @@ typedef struct listen_sockets {
     const char *default_bind_to;        // the default bind to configuration string
     uint16_t default_port;              // the default port to use
     int backlog;                        // the default listen backlog to use
+    bool reuse_port;                    // bind TCP and UDP sockets with SO_REUSEPORT, so that they can be cloned
 
     size_t opened;                      // the number of sockets opened
     size_t failed;                      // the number of sockets attempted to open, but failed
@@ -25,11 +26,13 @@ typedef struct listen_sockets {
     int fds_types[MAX_LISTEN_FDS];      // the socktype for the open sockets (SOCK_STREAM, SOCK_DGRAM)
     int fds_families[MAX_LISTEN_FDS];   // the family of the open sockets (AF_UNIX, AF_INET, AF_INET6)
     HTTP_ACL fds_acl_flags[MAX_LISTEN_FDS];  // the acl to apply to the open sockets (dashboard, badges, streaming, netdata.conf, management)
+    bool fds_shared[MAX_LISTEN_FDS];    // the socket is owned by the LISTEN_SOCKETS this was cloned from
 } LISTEN_SOCKETS;
 
 char *strdup_client_description(int family, const char *protocol, const char *ip, uint16_t port);
 
 int listen_sockets_setup(LISTEN_SOCKETS *sockets);
+size_t listen_sockets_clone(LISTEN_SOCKETS *src, LISTEN_SOCKETS *dst);
 void listen_sockets_close(LISTEN_SOCKETS *sockets);
 
 void foreach_entry_in_connection_string(const char *destination, bool (*callback)(char *entry, void *data), void *data);
@@ -78,11 +81,12 @@ int accept4(int sock, struct sockaddr *addr, socklen_t *addrlen, int flags);
 
 
 // ----------------------------------------------------------------------------
-// poll() based listener
+// poll() based listener - on Linux it uses epoll()
 
 #define POLLINFO_FLAG_SERVER_SOCKET 0x00000001
 #define POLLINFO_FLAG_CLIENT_SOCKET 0x00000002
 #define POLLINFO_FLAG_DONT_CLOSE    0x00000004
+#define POLLINFO_FLAG_NO_TIMEOUT    0x00000008 // never closed by the request and idle timeouts
 
 typedef struct poll POLLJOB;
 
@@ -106,6 +110,9 @@ typedef struct pollinfo {
 
     uint32_t flags;         // internal flags
 
+    short int epoll_events; // the events registered to epoll, for this slot
+    bool epoll_unsupported; // epoll() cannot watch this fd (e.g. a regular file), so it is always ready
+
     // callbacks for this socket
     void  (*del_callback)(struct pollinfo *pi);
     int   (*rcv_callback)(struct pollinfo *pi, short int *events);
@@ -140,6 +147,9 @@ struct poll {
     struct pollinfo *inf;
     struct pollinfo *first_free;
 
+    int epoll_fd;           // -1 when poll() is used
+    size_t epoll_unsupported;
+
     SIMPLE_PATTERN *access_list;
     int allow_dns;
 
@@ -172,6 +182,7 @@ POLLINFO *poll_add_fd(POLLJOB *p
                              , void *data
 );
 void poll_close_fd(POLLINFO *pi);
+void poll_set_events(POLLJOB *p, size_t slot, short int events);
 
 void poll_events(LISTEN_SOCKETS *sockets
         , void *(*add_callback)(POLLINFO *pi, short int *events, void *data)
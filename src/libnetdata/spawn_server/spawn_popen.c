@@ -15,6 +15,27 @@ struct popen_instance {
 SPAWN_SERVER *netdata_main_spawn_server = NULL;
 static SPINLOCK netdata_main_spawn_server_spinlock = NETDATA_SPINLOCK_INITIALIZER;
 
+static SPAWN_POPEN_STATISTICS spawn_popen_stats = { 0 };
+
+static void spawn_popen_statistics_update(usec_t started_ut, bool ok) {
+    usec_t dt = now_monotonic_usec() - started_ut;
+
+    __atomic_add_fetch(ok ? &spawn_popen_stats.started : &spawn_popen_stats.failed, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&spawn_popen_stats.latency_ut, dt, __ATOMIC_RELAXED);
+
+    usec_t old_max = __atomic_load_n(&spawn_popen_stats.latency_max_ut, __ATOMIC_RELAXED);
+    while(dt > old_max &&
+           !__atomic_compare_exchange_n(&spawn_popen_stats.latency_max_ut, &old_max, dt, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void spawn_popen_statistics(SPAWN_POPEN_STATISTICS *stats) {
+    stats->started = __atomic_load_n(&spawn_popen_stats.started, __ATOMIC_RELAXED);
+    stats->failed = __atomic_load_n(&spawn_popen_stats.failed, __ATOMIC_RELAXED);
+    stats->latency_ut = __atomic_load_n(&spawn_popen_stats.latency_ut, __ATOMIC_RELAXED);
+    stats->latency_max_ut = __atomic_exchange_n(&spawn_popen_stats.latency_max_ut, 0, __ATOMIC_RELAXED);
+}
+
 bool netdata_main_spawn_server_init(const char *name, int argc, const char **argv) {
     if(netdata_main_spawn_server == NULL) {
         spinlock_lock(&netdata_main_spawn_server_spinlock);
@@ -64,8 +85,10 @@ FILE *spawn_popen_stdout(POPEN_INSTANCE *pi) {
 POPEN_INSTANCE *spawn_popen_run_argv(const char **argv) {
     netdata_main_spawn_server_init(NULL, 0, NULL);
 
+    usec_t started_ut = now_monotonic_usec();
     SPAWN_INSTANCE *si = spawn_server_exec(netdata_main_spawn_server, nd_log_collectors_fd(),
         0, argv, NULL, 0, SPAWN_INSTANCE_TYPE_EXEC);
+    spawn_popen_statistics_update(started_ut, si != NULL);
 
     if(si == NULL) return NULL;
 
@@ -23,4 +23,13 @@ int spawn_popen_write_fd(POPEN_INSTANCE *pi);
 FILE *spawn_popen_stdin(POPEN_INSTANCE *pi);
 FILE *spawn_popen_stdout(POPEN_INSTANCE *pi);
 
+typedef struct spawn_popen_statistics {
+    size_t started;             // commands started
+    size_t failed;              // commands that could not be started
+    usec_t latency_ut;          // total time to start the commands
+    usec_t latency_max_ut;      // the max time to start a command, since the last call
+} SPAWN_POPEN_STATISTICS;
+
+void spawn_popen_statistics(SPAWN_POPEN_STATISTICS *stats);
+
 #endif //SPAWN_POPEN_H
@@ -311,6 +311,11 @@ static bool spawn_external_command(SPAWN_SERVER *server __maybe_unused, SPAWN_RE
     }
 
     short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#if defined(POSIX_SPAWN_USEVFORK)
+    // recent glibc always uses clone(CLONE_VM | CLONE_VFORK) - older ones need to be asked
+    // so that they do not copy the page tables of the spawn server for every command
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
     if (posix_spawnattr_setflags(&attr, flags) != 0) {
         nd_log(NDLS_COLLECTORS, NDLP_ERR, "SPAWN PARENT: posix_spawnattr_setflags() failed: %s", rq->cmdline);
         posix_spawn_file_actions_destroy(&file_actions);
@@ -458,3 +458,239 @@ NETDATA_DOUBLE holtwinters(const NETDATA_DOUBLE *series, size_t entries,
 
     return value;
 }
+
+// --------------------------------------------------------------------------------------------------------------------
+// quantile sketch
+
+#define QUANTILE_SKETCH_INITIAL_BUCKETS 64
+
+void quantile_sketch_init(QUANTILE_SKETCH *qs, NETDATA_DOUBLE relative_accuracy, uint32_t max_buckets) {
+    if(unlikely(!(relative_accuracy > 0.0) || relative_accuracy >= 1.0))
+        relative_accuracy = 0.01;
+
+    if(unlikely(max_buckets < QUANTILE_SKETCH_INITIAL_BUCKETS))
+        max_buckets = QUANTILE_SKETCH_INITIAL_BUCKETS;
+
+    memset(qs, 0, sizeof(*qs));
+    qs->gamma = (1.0 + relative_accuracy) / (1.0 - relative_accuracy);
+    qs->gamma_ln = logndd(qs->gamma);
+    qs->max_buckets = max_buckets;
+}
+
+static void quantile_sketch_store_reposition(QUANTILE_SKETCH_STORE *s, int32_t new_min, int32_t new_max, uint32_t max_buckets) {
+    uint32_t span = (uint32_t)(new_max - new_min) + 1;
+
+    uint32_t capacity = s->capacity ? s->capacity : QUANTILE_SKETCH_INITIAL_BUCKETS;
+    while(capacity < span)
+        capacity *= 2;
+    if(capacity > max_buckets)
+        capacity = max_buckets;
+
+    uint64_t *counts = callocz(capacity, sizeof(uint64_t));
+    int32_t offset = new_min - (int32_t)((capacity - span) / 2);
+
+    if(s->total) {
+        // copy the used buckets, merging the ones below new_min into it
+        for(int32_t k = s->min_key; k <= s->max_key; k++) {
+            int32_t to = (k < new_min) ? new_min : k;
+            counts[to - offset] += s->counts[k - s->offset];
+        }
+
+        if(s->min_key < new_min)
+            s->min_key = new_min;
+    }
+
+    freez(s->counts);
+    s->counts = counts;
+    s->capacity = capacity;
+    s->offset = offset;
+}
+
+static void quantile_sketch_store_add(QUANTILE_SKETCH_STORE *s, int32_t key, uint64_t times, uint32_t max_buckets) {
+    if(!s->total) {
+        if(!s->counts || key < s->offset || key >= s->offset + (int32_t)s->capacity) {
+            freez(s->counts);
+            s->counts = NULL;
+            s->capacity = 0;
+            quantile_sketch_store_reposition(s, key, key, max_buckets);
+        }
+
+        s->min_key = s->max_key = key;
+    }
+    else {
+        // the lowest buckets are merged, when the keys span more than max_buckets
+        int32_t lowest = (key > s->max_key ? key : s->max_key) - (int32_t)max_buckets + 1;
+        if(key < lowest)
+            key = lowest;
+
+        int32_t new_min = (key < s->min_key) ? key : s->min_key;
+        int32_t new_max = (key > s->max_key) ? key : s->max_key;
+        if(new_min < lowest)
+            new_min = lowest;
+
+        if(new_min != s->min_key || new_min < s->offset || new_max >= s->offset + (int32_t)s->capacity)
+            quantile_sketch_store_reposition(s, new_min, new_max, max_buckets);
+
+        s->min_key = new_min;
+        s->max_key = new_max;
+    }
+
+    s->counts[key - s->offset] += times;
+    s->total += times;
+}
+
+static inline int32_t quantile_sketch_key(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE value) {
+    NETDATA_DOUBLE k = ceilndd(logndd(value) / qs->gamma_ln);
+
+    if(unlikely(k < (NETDATA_DOUBLE)(INT32_MIN / 2))) return INT32_MIN / 2;
+    if(unlikely(k > (NETDATA_DOUBLE)(INT32_MAX / 2))) return INT32_MAX / 2;
+    return (int32_t)k;
+}
+
+static inline NETDATA_DOUBLE quantile_sketch_value(const QUANTILE_SKETCH *qs, int32_t key) {
+    return 2.0 * expndd((NETDATA_DOUBLE)key * qs->gamma_ln) / (qs->gamma + 1.0);
+}
+
+void quantile_sketch_add(QUANTILE_SKETCH *qs, NETDATA_DOUBLE value, uint64_t times) {
+    if(unlikely(!times || !netdata_double_isnumber(value)))
+        return;
+
+    if(!qs->count || value < qs->min) qs->min = value;
+    if(!qs->count || value > qs->max) qs->max = value;
+
+    // Welford, for the times the value has been added at once
+    uint64_t count = qs->count + times;
+    NETDATA_DOUBLE delta = value - qs->mean;
+    qs->mean += delta * (NETDATA_DOUBLE)times / (NETDATA_DOUBLE)count;
+    qs->m2 += delta * (value - qs->mean) * (NETDATA_DOUBLE)times;
+    qs->count = count;
+    qs->sum += value * (NETDATA_DOUBLE)times;
+
+    if(value > 0.0)
+        quantile_sketch_store_add(&qs->positive, quantile_sketch_key(qs, value), times, qs->max_buckets);
+    else if(value < 0.0)
+        quantile_sketch_store_add(&qs->negative, quantile_sketch_key(qs, -value), times, qs->max_buckets);
+    else
+        qs->zeros += times;
+}
+
+NETDATA_DOUBLE quantile_sketch_quantile(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE q) {
+    if(unlikely(!qs->count))
+        return NAN;
+
+    if(q <= 0.0) return qs->min;
+    if(q >= 1.0) return qs->max;
+
+    uint64_t rank = (uint64_t)floorndd(q * (NETDATA_DOUBLE)(qs->count - 1));
+    uint64_t seen = 0;
+    NETDATA_DOUBLE value = qs->max;
+    bool found = false;
+
+    // the most negative values first
+    const QUANTILE_SKETCH_STORE *s = &qs->negative;
+    for(int32_t k = s->max_key; s->total && k >= s->min_key; k--) {
+        seen += s->counts[k - s->offset];
+        if(seen > rank) {
+            value = -quantile_sketch_value(qs, k);
+            found = true;
+            break;
+        }
+    }
+
+    if(!found) {
+        seen += qs->zeros;
+        if(seen > rank) {
+            value = 0.0;
+            found = true;
+        }
+    }
+
+    s = &qs->positive;
+    for(int32_t k = s->min_key; !found && s->total && k <= s->max_key; k++) {
+        seen += s->counts[k - s->offset];
+        if(seen > rank) {
+            value = quantile_sketch_value(qs, k);
+            found = true;
+        }
+    }
+
+    if(value < qs->min) value = qs->min;
+    if(value > qs->max) value = qs->max;
+    return value;
+}
+
+NETDATA_DOUBLE quantile_sketch_stddev(const QUANTILE_SKETCH *qs) {
+    if(unlikely(!qs->count)) return NAN;
+
+    // like standard_deviation(), a single value is its own deviation
+    if(unlikely(qs->count == 1)) return qs->mean;
+
+    // population standard deviation
+    return sqrtndd(qs->m2 / (NETDATA_DOUBLE)qs->count);
+}
+
+static void quantile_sketch_store_reset(QUANTILE_SKETCH_STORE *s) {
+    // keep the buckets allocated, for the next values
+    if(s->total)
+        memset(&s->counts[s->min_key - s->offset], 0, (size_t)(s->max_key - s->min_key + 1) * sizeof(uint64_t));
+
+    s->total = 0;
+}
+
+void quantile_sketch_reset(QUANTILE_SKETCH *qs) {
+    quantile_sketch_store_reset(&qs->positive);
+    quantile_sketch_store_reset(&qs->negative);
+
+    qs->count = 0;
+    qs->zeros = 0;
+    qs->min = qs->max = 0.0;
+    qs->sum = qs->mean = qs->m2 = 0.0;
+}
+
+void quantile_sketch_free(QUANTILE_SKETCH *qs) {
+    freez(qs->positive.counts);
+    freez(qs->negative.counts);
+    qs->positive = (QUANTILE_SKETCH_STORE){ 0 };
+    qs->negative = (QUANTILE_SKETCH_STORE){ 0 };
+    quantile_sketch_reset(qs);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// HyperLogLog
+
+void hyperloglog_add(HYPERLOGLOG *hll, uint64_t hash) {
+    size_t index = (size_t)(hash >> (64 - HYPERLOGLOG_PRECISION));
+
+    // the position of the first set bit of the rest of the hash,
+    // with a guard bit, so that it is never zero
+    uint64_t rest = (hash << HYPERLOGLOG_PRECISION) | (1ULL << (HYPERLOGLOG_PRECISION - 1));
+    uint8_t rank = (uint8_t)(__builtin_clzll(rest) + 1);
+
+    if(rank > hll->registers[index])
+        hll->registers[index] = rank;
+}
+
+NETDATA_DOUBLE hyperloglog_estimate(const HYPERLOGLOG *hll) {
+    const NETDATA_DOUBLE m = (NETDATA_DOUBLE)HYPERLOGLOG_REGISTERS;
+    const NETDATA_DOUBLE alpha = 0.7213 / (1.0 + 1.079 / m);
+
+    NETDATA_DOUBLE sum = 0.0;
+    size_t zeros = 0;
+    for(size_t i = 0; i < HYPERLOGLOG_REGISTERS ;i++) {
+        sum += 1.0 / (NETDATA_DOUBLE)(1ULL << hll->registers[i]);
+        if(!hll->registers[i])
+            zeros++;
+    }
+
+    NETDATA_DOUBLE estimate = alpha * m * m / sum;
+
+    // small ranges are estimated better by linear counting
+    if(estimate <= 2.5 * m && zeros)
+        estimate = m * logndd(m / (NETDATA_DOUBLE)zeros);
+
+    return estimate;
+}
+
+void hyperloglog_reset(HYPERLOGLOG *hll) {
+    memset(hll->registers, 0, sizeof(hll->registers));
+}
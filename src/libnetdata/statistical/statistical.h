@@ -31,4 +31,61 @@ NETDATA_DOUBLE median_on_sorted_series(const NETDATA_DOUBLE *series, size_t entr
 NETDATA_DOUBLE *copy_series(const NETDATA_DOUBLE *series, size_t entries);
 void sort_series(NETDATA_DOUBLE *series, size_t entries);
 
+// ----------------------------------------------------------------------------
+// quantile sketch
+//
+// A bounded memory, relative error quantile sketch (DDSketch). Values are counted in logarithmic buckets, so
+// that any quantile is estimated within the configured relative accuracy of the real one. When the values span
+// more than max_buckets buckets, the lowest buckets are merged. The count, sum, min, max and variance are exact.
+
+typedef struct quantile_sketch_store {
+    uint64_t *counts;
+    uint32_t capacity;
+    int32_t offset;                 // the key of counts[0]
+    int32_t min_key;                // the keys used, valid when total > 0
+    int32_t max_key;
+    uint64_t total;
+} QUANTILE_SKETCH_STORE;
+
+typedef struct quantile_sketch {
+    NETDATA_DOUBLE gamma;
+    NETDATA_DOUBLE gamma_ln;
+    uint32_t max_buckets;
+
+    uint64_t count;
+    uint64_t zeros;
+    NETDATA_DOUBLE min;
+    NETDATA_DOUBLE max;
+    NETDATA_DOUBLE sum;
+    NETDATA_DOUBLE mean;            // running mean and sum of squared differences (Welford)
+    NETDATA_DOUBLE m2;
+
+    QUANTILE_SKETCH_STORE positive;
+    QUANTILE_SKETCH_STORE negative;
+} QUANTILE_SKETCH;
+
+void quantile_sketch_init(QUANTILE_SKETCH *qs, NETDATA_DOUBLE relative_accuracy, uint32_t max_buckets);
+void quantile_sketch_add(QUANTILE_SKETCH *qs, NETDATA_DOUBLE value, uint64_t times);
+NETDATA_DOUBLE quantile_sketch_quantile(const QUANTILE_SKETCH *qs, NETDATA_DOUBLE q);
+NETDATA_DOUBLE quantile_sketch_stddev(const QUANTILE_SKETCH *qs);
+void quantile_sketch_reset(QUANTILE_SKETCH *qs);
+void quantile_sketch_free(QUANTILE_SKETCH *qs);
+
+// ----------------------------------------------------------------------------
+// cardinality estimation
+//
+// HyperLogLog, with 1024 registers: it estimates the number of distinct hashes added, with a standard
+// error of about 3%, in 1KiB. Concurrent adds may lose updates, making the estimate slightly lower.
+
+#define HYPERLOGLOG_PRECISION 10
+#define HYPERLOGLOG_REGISTERS (1 << HYPERLOGLOG_PRECISION)
+
+typedef struct hyperloglog {
+    uint8_t registers[HYPERLOGLOG_REGISTERS];
+} HYPERLOGLOG;
+
+void hyperloglog_add(HYPERLOGLOG *hll, uint64_t hash);
+NETDATA_DOUBLE hyperloglog_estimate(const HYPERLOGLOG *hll);
+void hyperloglog_reset(HYPERLOGLOG *hll);
+
 #endif //NETDATA_STATISTICAL_H
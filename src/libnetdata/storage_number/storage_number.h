@@ -28,6 +28,8 @@ typedef long double NETDATA_DOUBLE;
 #define floorndd(x) floorl(x)
 #define ceilndd(x) ceill(x)
 #define log10ndd(x) log10l(x)
+#define logndd(x) logl(x)
+#define expndd(x) expl(x)
 
 #else // NETDATA_WITH_LONG_DOUBLE
 
@@ -51,6 +53,8 @@ typedef double NETDATA_DOUBLE;
 #define floorndd(x) floor(x)
 #define ceilndd(x) ceil(x)
 #define log10ndd(x) log10(x)
+#define logndd(x) log(x)
+#define expndd(x) exp(x)
 
 #endif // NETDATA_WITH_LONG_DOUBLE
 
@@ -8,10 +8,13 @@ typedef int32_t REFCOUNT;
 // ----------------------------------------------------------------------------
 // STRING implementation - dedup all STRING
 
-#define STRING_PARTITION_SHIFTS (0)
-#define STRING_PARTITIONS (256 >> STRING_PARTITION_SHIFTS)
-#define string_partition_str(str) ((uint8_t)((str)[0]) >> STRING_PARTITION_SHIFTS)
-#define string_partition(string) (string_partition_str((string)->str))
+// The partition is picked by a hash of the whole string, not by its first
+// character, because most strings share a few prefixes (like "cgroup_",
+// "system.", "net.", "disk.") and they would all land on a few partitions
+// and their locks.
+#define STRING_PARTITIONS 256
+#define string_partition_str(str, length) ((uint8_t)XXH3_64bits(str, (length) - 1))
+#define string_partition(string) (string_partition_str((string)->str, (string)->length))
 
 struct netdata_string {
     uint32_t length;    // the string length including the terminating '\0'
@@ -146,11 +149,9 @@ STRING *string_dup(STRING *string) {
 }
 
 // Search the index and return an ACQUIRED string entry, or NULL
-static inline STRING *string_index_search(const char *str, size_t length) {
+static inline STRING *string_index_search(const char *str, size_t length, uint8_t partition) {
     STRING *string;
 
-    uint8_t partition = string_partition_str(str);
-
     // Find the string in the index
     // With a read-lock so that multiple readers can use the index concurrently.
 
@@ -189,11 +190,9 @@ static inline STRING *string_index_search(const char *str, size_t length) {
 // The returned entry is ACQUIRED, and it can either be:
 //   1. a new item inserted, or
 //   2. an item found in the index that is not currently deleted
-static inline STRING *string_index_insert(const char *str, size_t length) {
+static inline STRING *string_index_insert(const char *str, size_t length, uint8_t partition) {
     STRING *string;
 
-    uint8_t partition = string_partition_str(str);
-
     rw_spinlock_write_lock(&string_base[partition].spinlock);
 
     STRING **ptr;
@@ -286,19 +285,16 @@ static inline void string_index_delete(STRING *string) {
 STRING *string_strdupz(const char *str) {
     if(unlikely(!str || !*str)) return NULL;
 
-#ifdef NETDATA_INTERNAL_CHECKS
-    uint8_t partition = string_partition_str(str);
-#endif
-
     size_t length = strlen(str) + 1;
-    STRING *string = string_index_search(str, length);
+    uint8_t partition = string_partition_str(str, length);
+    STRING *string = string_index_search(str, length, partition);
 
     while(!string) {
         // The search above did not find anything,
         // We loop here, because during insert we may find an entry that is being deleted by another thread.
         // So, we have to let it go and retry to insert it again.
 
-        string = string_index_insert(str, length);
+        string = string_index_insert(str, length, partition);
     }
 
     // statistics
@@ -310,17 +306,14 @@ STRING *string_strdupz(const char *str) {
 STRING *string_strndupz(const char *str, size_t len) {
     if(unlikely(!str || !*str || !len)) return NULL;
 
-#ifdef NETDATA_INTERNAL_CHECKS
-    uint8_t partition = string_partition_str(str);
-#endif
-
     char buf[len + 1];
     memcpy(buf, str, len);
     buf[len] = '\0';
 
-    STRING *string = string_index_search(buf, len + 1);
+    uint8_t partition = string_partition_str(buf, len + 1);
+    STRING *string = string_index_search(buf, len + 1, partition);
     while(!string)
-        string = string_index_insert(buf, len + 1);
+        string = string_index_insert(buf, len + 1, partition);
 
     string_stats_atomic_increment(partition, active_references);
     return string;
@@ -426,16 +419,21 @@ STRING *string_2way_merge(STRING *a, STRING *b) {
 struct thread_unittest {
     int join;
     int dups;
+    char **names;       // the strings the threads look up, sharing a few prefixes like metric names do
+    size_t entries;
+    size_t operations;
 };
 
 static void *string_thread(void *arg) {
     struct thread_unittest *tu = arg;
+    size_t operations = 0;
 
-    for(; 1 ;) {
+    for(size_t n = gettid_cached(); 1 ; n++) {
         if(__atomic_load_n(&tu->join, __ATOMIC_RELAXED))
             break;
 
-        STRING *s = string_strdupz("string thread checking 1234567890");
+        const char *name = tu->entries ? tu->names[n % tu->entries] : "string thread checking 1234567890";
+        STRING *s = string_strdupz(name);
 
         for(int i = 0; i < tu->dups ; i++)
             string_dup(s);
@@ -444,11 +442,25 @@ static void *string_thread(void *arg) {
             string_freez(s);
 
         string_freez(s);
+        operations++;
     }
 
+    __atomic_add_fetch(&tu->operations, operations, __ATOMIC_RELAXED);
     return arg;
 }
 
+static char **string_unittest_generate_prefixed_names(size_t entries) {
+    const char *prefixes[] = { "cgroup_", "system.", "net.", "disk." };
+
+    char **names = mallocz(sizeof(char *) * entries);
+    for(size_t i = 0; i < entries ;i++) {
+        char buf[100 + 1];
+        snprintfz(buf, sizeof(buf) - 1, "%s%zu.metric", prefixes[i % (sizeof(prefixes) / sizeof(prefixes[0]))], i);
+        names[i] = strdupz(buf);
+    }
+    return names;
+}
+
 static char **string_unittest_generate_names(size_t entries) {
     char **names = mallocz(sizeof(char *) * entries);
     for(size_t i = 0; i < entries ;i++) {
@@ -653,13 +665,63 @@ int string_unittest(size_t entries) {
         }
     }
 
-    // threads testing of string
+    // check the distribution of prefixed strings to partitions
     {
+        char **prefixed = string_unittest_generate_prefixed_names(entries);
+        STRING **strings = mallocz(entries * sizeof(STRING *));
+
+        long before[STRING_PARTITIONS];
+        for(size_t p = 0; p < STRING_PARTITIONS ;p++)
+            before[p] = string_base[p].entries;
+
+        for(size_t i = 0; i < entries ;i++)
+            strings[i] = string_strdupz(prefixed[i]);
+
+        long min = LONG_MAX, max = 0;
+        for(size_t p = 0; p < STRING_PARTITIONS ;p++) {
+            long added = string_base[p].entries - before[p];
+            if(added < min) min = added;
+            if(added > max) max = added;
+        }
+
+        fprintf(stderr, "\nChecking the partitioning of %zu strings with 4 prefixes: min %ld, max %ld per partition\n",
+                entries, min, max);
+
+        // with the first character, all of them would be on 3 partitions
+        if(entries >= STRING_PARTITIONS * 100 && (size_t)max > 2 * (entries / STRING_PARTITIONS)) {
+            errors++;
+            fprintf(stderr, "ERROR: strings are not evenly distributed to partitions\n");
+        }
+        else
+            fprintf(stderr, "OK: strings are distributed to partitions\n");
+
+        for(size_t i = 0; i < entries ;i++)
+            string_freez(strings[i]);
+
+        freez(strings);
+        string_unittest_free_char_pp(prefixed, entries);
+    }
+
+    // threads testing of string
+    for(int run = 0; run < 2 ;run++) {
         struct thread_unittest tu = {
             .dups = 1,
             .join = 0,
         };
 
+        // the first run hammers a single string from 2 threads,
+        // the second run looks up many prefixed strings from all the cpus
+        char **prefixed = NULL;
+        if(run == 1) {
+            tu.entries = entries < 10000 ? entries : 10000;
+            prefixed = tu.names = string_unittest_generate_prefixed_names(tu.entries);
+        }
+
+        // keep the strings of the second run referenced, so that the threads measure lookups
+        STRING **held = tu.entries ? mallocz(tu.entries * sizeof(STRING *)) : NULL;
+        for(size_t i = 0; i < tu.entries ;i++)
+            held[i] = string_strdupz(tu.names[i]);
+
 #ifdef NETDATA_INTERNAL_CHECKS
         size_t ofound_deleted_on_search = unittest_string_found_deleted_on_search(),
                ofound_available_on_search = unittest_string_found_available_on_search(),
@@ -673,11 +735,18 @@ int string_unittest(size_t entries) {
 
         time_t seconds_to_run = 5;
         int threads_to_create = 2;
+        if(run == 1) {
+            threads_to_create = (int)os_get_system_cpus();
+            if(threads_to_create < 2) threads_to_create = 2;
+            if(threads_to_create > 64) threads_to_create = 64;
+        }
+
         fprintf(
             stderr,
-            "Checking string concurrency with %d threads for %lld seconds...\n",
+            "\nChecking string concurrency with %d threads for %lld seconds, on %zu strings...\n",
             threads_to_create,
-            (long long)seconds_to_run);
+            (long long)seconds_to_run,
+            tu.entries ? tu.entries : (size_t)1);
         // check string concurrency
         ND_THREAD *threads[threads_to_create];
         tu.join = 0;
@@ -698,6 +767,11 @@ int string_unittest(size_t entries) {
         fprintf(stderr, "inserts %zu, deletes %zu, searches %zu, entries %zu, references %zu, memory %zu, duplications %zu, releases %zu\n",
                 inserts - oinserts, deletes - odeletes, searches - osearches, sentries - oentries, references - oreferences, memory - omemory, duplications - oduplications, releases - oreleases);
 
+        fprintf(stderr, "throughput: %zu lookups, %0.2f million lookups/s, %0.2f million lookups/s per thread\n",
+                tu.operations,
+                (double)tu.operations / (double)seconds_to_run / 1000000.0,
+                (double)tu.operations / (double)seconds_to_run / (double)threads_to_create / 1000000.0);
+
 #ifdef NETDATA_INTERNAL_CHECKS
         size_t found_deleted_on_search = unittest_string_found_deleted_on_search(),
                found_available_on_search = unittest_string_found_available_on_search(),
@@ -713,6 +787,13 @@ int string_unittest(size_t entries) {
                 spins - ospins
         );
 #endif
+
+        for(size_t i = 0; i < tu.entries ;i++)
+            string_freez(held[i]);
+
+        freez(held);
+        if(prefixed)
+            string_unittest_free_char_pp(prefixed, tu.entries);
     }
 
     string_unittest_free_char_pp(names, entries);
@@ -233,6 +233,152 @@ void netdata_threads_init_for_external_plugins(size_t stacksize) {
     netdata_threads_init_after_fork(stacksize ? stacksize : default_stacksize);
 }
 
+// ----------------------------------------------------------------------------
+// policies, applied to the threads by their tags, when they start
+
+#define ND_THREAD_POLICIES_MAX 32
+
+static struct {
+    SPINLOCK spinlock;
+    size_t used;
+
+    struct {
+        SIMPLE_PATTERN *tags;
+#if defined(OS_LINUX)
+        bool nice_set;
+        int nice;
+        bool cpus_set;
+        cpu_set_t cpus;
+#endif
+    } array[ND_THREAD_POLICIES_MAX];
+} threads_policies = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .used = 0,
+};
+
+#if defined(OS_LINUX)
+static bool nd_thread_policy_add(const char *tags, bool nice_set, int nice, cpu_set_t *cpus) {
+    spinlock_lock(&threads_policies.spinlock);
+
+    if(threads_policies.used >= ND_THREAD_POLICIES_MAX) {
+        spinlock_unlock(&threads_policies.spinlock);
+        nd_log(NDLS_DAEMON, NDLP_ERR, "THREADS: too many thread policies, ignoring the one for '%s'", tags);
+        return false;
+    }
+
+    size_t i = threads_policies.used;
+    threads_policies.array[i].tags = simple_pattern_create(tags, " ", SIMPLE_PATTERN_EXACT, true);
+    threads_policies.array[i].nice_set = nice_set;
+    threads_policies.array[i].nice = nice;
+    threads_policies.array[i].cpus_set = cpus != NULL;
+    if(cpus)
+        threads_policies.array[i].cpus = *cpus;
+
+    // publish it after it is complete, the starting threads read the policies without the lock
+    __atomic_store_n(&threads_policies.used, i + 1, __ATOMIC_RELEASE);
+
+    spinlock_unlock(&threads_policies.spinlock);
+    return true;
+}
+#endif
+
+bool nd_thread_policy_nice_add(const char *tags, int nice) {
+#if defined(OS_LINUX)
+    if(nice < -20) nice = -20;
+    if(nice > 19) nice = 19;
+
+    return nd_thread_policy_add(tags, true, nice, NULL);
+#else
+    nd_log(NDLS_DAEMON, NDLP_ERR, "THREADS: setting the nice level of the threads '%s' to %d is not supported on this system", tags, nice);
+    return false;
+#endif
+}
+
+// cpus is a list of cpus and ranges of them, like "0-3,6"
+bool nd_thread_policy_cpus_add(const char *tags, const char *cpus) {
+#if defined(OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    const char *s = cpus;
+    while(s && *s) {
+        while(isspace((uint8_t)*s) || *s == ',') s++;
+        if(!*s) break;
+
+        char *end;
+        unsigned long first = strtoul(s, &end, 10), last;
+        if(end == s)
+            goto invalid;
+
+        s = end;
+        if(*s == '-') {
+            last = strtoul(++s, &end, 10);
+            if(end == s || last < first)
+                goto invalid;
+            s = end;
+        }
+        else
+            last = first;
+
+        if(last >= CPU_SETSIZE)
+            goto invalid;
+
+        for(unsigned long cpu = first; cpu <= last ; cpu++)
+            CPU_SET(cpu, &set);
+
+        while(isspace((uint8_t)*s)) s++;
+        if(*s && *s != ',')
+            goto invalid;
+    }
+
+    if(!CPU_COUNT(&set))
+        goto invalid;
+
+    return nd_thread_policy_add(tags, false, 0, &set);
+
+invalid:
+    nd_log(NDLS_DAEMON, NDLP_ERR, "THREADS: invalid list of cpus '%s' for the threads '%s'", cpus, tags);
+    return false;
+#else
+    nd_log(NDLS_DAEMON, NDLP_ERR, "THREADS: setting the cpus of the threads '%s' to '%s' is not supported on this system", tags, cpus);
+    return false;
+#endif
+}
+
+// the first policy of each kind that matches the tag of the thread is applied
+static void nd_thread_policies_apply(ND_THREAD *nti) {
+    size_t used = __atomic_load_n(&threads_policies.used, __ATOMIC_ACQUIRE);
+    if(likely(!used))
+        return;
+
+#if defined(OS_LINUX)
+    bool nice_done = false, cpus_done = false;
+
+    for(size_t i = 0; i < used ; i++) {
+        if(!simple_pattern_matches(threads_policies.array[i].tags, nti->tag))
+            continue;
+
+        if(threads_policies.array[i].nice_set && !nice_done) {
+            nice_done = true;
+
+            // on linux, a tid sets the nice level of this thread only
+            if(setpriority(PRIO_PROCESS, (id_t)nti->tid, threads_policies.array[i].nice) != 0)
+                nd_log(NDLS_DAEMON, NDLP_WARNING, "THREADS: cannot set the nice level of thread '%s' to %d",
+                       nti->tag, threads_policies.array[i].nice);
+        }
+
+        if(threads_policies.array[i].cpus_set && !cpus_done) {
+            cpus_done = true;
+
+            if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &threads_policies.array[i].cpus) != 0)
+                nd_log(NDLS_DAEMON, NDLP_WARNING, "THREADS: cannot set the cpus of thread '%s'", nti->tag);
+        }
+    }
+#else
+    (void)nti;
+#endif
+}
+
 // ----------------------------------------------------------------------------
 
 void rrdset_thread_rda_free(void);
@@ -240,6 +386,7 @@ void sender_thread_buffer_free(void);
 void query_target_free(void);
 void service_exits(void);
 void rrd_collector_finished(void);
+void global_statistics_thread_exit(void);
 
 static void nd_thread_join_exited_detached_threads(void) {
     while(1) {
@@ -309,7 +456,9 @@ static void nd_thread_exit(void *pptr) {
     rrdset_thread_rda_free();
     query_target_free();
     thread_cache_destroy();
+    onewayalloc_thread_cache_free();
     service_exits();
+    global_statistics_thread_exit();
     worker_unregister();
 
     nd_thread_status_set(nti, NETDATA_THREAD_STATUS_FINISHED);
@@ -331,6 +480,8 @@ static void *nd_thread_starting_point(void *ptr) {
 
     nti->tid = gettid_cached();
     nd_thread_tag_set(nti->tag);
+    nd_thread_policies_apply(nti);
+    nd_profiler_thread_init();
 
     if(nd_thread_status_check(nti, NETDATA_THREAD_OPTION_DONT_LOG_STARTUP) != NETDATA_THREAD_OPTION_DONT_LOG_STARTUP)
         nd_log(NDLS_DAEMON, NDLP_DEBUG, "thread created with task id %d", gettid_cached());
@@ -69,6 +69,9 @@ size_t netdata_threads_init(void);
 void netdata_threads_init_after_fork(size_t stacksize);
 void netdata_threads_init_for_external_plugins(size_t stacksize);
 
+bool nd_thread_policy_nice_add(const char *tags, int nice);
+bool nd_thread_policy_cpus_add(const char *tags, const char *cpus);
+
 ND_THREAD *nd_thread_create(const char *tag, NETDATA_THREAD_OPTIONS options, void *(*start_routine) (void *), void *arg);
 int nd_thread_join(ND_THREAD * nti);
 ND_THREAD *nd_thread_self(void);
@@ -21,58 +21,127 @@ ND_UUID UUID_generate_from_hash(const void *payload, size_t payload_len) {
     return uuid;
 }
 
-void uuid_unparse_lower_compact(const nd_uuid_t uuid, char *out) {
-    static const char *hex_chars = "0123456789abcdef";
-    for (int i = 0; i < 16; i++) {
-        out[i * 2] = hex_chars[(uuid[i] >> 4) & 0x0F];
-        out[i * 2 + 1] = hex_chars[uuid[i] & 0x0F];
+// ----------------------------------------------------------------------------
+// formatting and parsing
+//
+// UUIDs are formatted and parsed millions of times per API call, so the hex
+// pairs of all bytes are looked up in tables (one 16-bit store per byte), the
+// positions of the hyphens are fixed (no branches in the loops), and the hex
+// digits are converted with a table that also flags the invalid ones, so that
+// the validity of all of them is checked once at the end.
+
+#define UUID_HEX_ROW(h, d) \
+    {h,d[0]},{h,d[1]},{h,d[2]},{h,d[3]},{h,d[4]},{h,d[5]},{h,d[6]},{h,d[7]}, \
+    {h,d[8]},{h,d[9]},{h,d[10]},{h,d[11]},{h,d[12]},{h,d[13]},{h,d[14]},{h,d[15]}
+
+#define UUID_HEX_TABLE(d) { \
+    UUID_HEX_ROW(d[0], d), UUID_HEX_ROW(d[1], d), UUID_HEX_ROW(d[2], d), UUID_HEX_ROW(d[3], d), \
+    UUID_HEX_ROW(d[4], d), UUID_HEX_ROW(d[5], d), UUID_HEX_ROW(d[6], d), UUID_HEX_ROW(d[7], d), \
+    UUID_HEX_ROW(d[8], d), UUID_HEX_ROW(d[9], d), UUID_HEX_ROW(d[10], d), UUID_HEX_ROW(d[11], d), \
+    UUID_HEX_ROW(d[12], d), UUID_HEX_ROW(d[13], d), UUID_HEX_ROW(d[14], d), UUID_HEX_ROW(d[15], d), \
+}
+
+static const char uuid_hex_pairs_lower[256][2] = UUID_HEX_TABLE("0123456789abcdef");
+static const char uuid_hex_pairs_upper[256][2] = UUID_HEX_TABLE("0123456789ABCDEF");
+
+// the value of each hex digit plus 1, zero for everything else
+static const uint8_t uuid_hex_values_plus_one[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+static inline void uuid_bytes_to_hex(const uint8_t *in, size_t bytes, char *out, const char (*pairs)[2]) {
+    for(size_t i = 0; i < bytes; i++)
+        memcpy(&out[i * 2], pairs[in[i]], 2);
+}
+
+// returns false when any of the characters is not a hex digit
+static inline bool uuid_hex_to_bytes(const char *in, size_t bytes, uint8_t *out) {
+    uint8_t invalid = 0;
+
+    for(size_t i = 0; i < bytes; i++) {
+        uint8_t high = uuid_hex_values_plus_one[(uint8_t)in[i * 2]];
+        uint8_t low = uuid_hex_values_plus_one[(uint8_t)in[i * 2 + 1]];
+        invalid |= (uint8_t)((high == 0) | (low == 0));
+        out[i] = (uint8_t)(((high - 1) << 4) | ((low - 1) & 0x0F));
     }
+
+    return !invalid;
+}
+
+void uuid_unparse_lower_compact(const nd_uuid_t uuid, char *out) {
+    uuid_bytes_to_hex(uuid, 16, out, uuid_hex_pairs_lower);
     out[32] = '\0'; // Null-terminate the string
 }
 
-static inline void nd_uuid_unparse_full(const nd_uuid_t uuid, char *out, const char *hex_chars) {
-    int shifts = 0;
-    for (int i = 0; i < 16; i++) {
-        if (i == 4 || i == 6 || i == 8 || i == 10) {
-            out[i * 2 + shifts] = '-';
-            shifts++;
-        }
-        out[i * 2 + shifts] = hex_chars[(uuid[i] >> 4) & 0x0F];
-        out[i * 2 + 1 + shifts] = hex_chars[uuid[i] & 0x0F];
-    }
+static inline void nd_uuid_unparse_full(const nd_uuid_t uuid, char *out, const char (*pairs)[2]) {
+    // 8-4-4-4-12
+    uuid_bytes_to_hex(&uuid[0], 4, &out[0], pairs);
+    out[8] = '-';
+    uuid_bytes_to_hex(&uuid[4], 2, &out[9], pairs);
+    out[13] = '-';
+    uuid_bytes_to_hex(&uuid[6], 2, &out[14], pairs);
+    out[18] = '-';
+    uuid_bytes_to_hex(&uuid[8], 2, &out[19], pairs);
+    out[23] = '-';
+    uuid_bytes_to_hex(&uuid[10], 6, &out[24], pairs);
     out[36] = '\0'; // Null-terminate the string
 }
 
 // Wrapper functions for lower and upper case hexadecimal representation
 void nd_uuid_unparse_lower(const nd_uuid_t uuid, char *out) {
-    nd_uuid_unparse_full(uuid, out, "0123456789abcdef");
+    nd_uuid_unparse_full(uuid, out, uuid_hex_pairs_lower);
 }
 
 void nd_uuid_unparse_upper(const nd_uuid_t uuid, char *out) {
-    nd_uuid_unparse_full(uuid, out, "0123456789ABCDEF");
+    nd_uuid_unparse_full(uuid, out, uuid_hex_pairs_upper);
 }
 
 inline int uuid_parse_compact(const char *in, nd_uuid_t uuid) {
     if (strlen(in) != 32)
         return -1; // Invalid input length
 
-    for (int i = 0; i < 16; i++) {
-        int high = hex_char_to_int(in[i * 2]);
-        int low = hex_char_to_int(in[i * 2 + 1]);
+    if (!uuid_hex_to_bytes(in, 16, uuid))
+        return -1; // Invalid hexadecimal character
 
-        if (high < 0 || low < 0)
-            return -1; // Invalid hexadecimal character
+    return 0; // Success
+}
 
-        uuid[i] = (high << 4) | low;
+// the canonical 8-4-4-4-12 form, or 32 hex digits, in one pass
+static inline bool uuid_parse_fast(const char *in, nd_uuid_t uu) {
+    size_t len = strnlen(in, 36);
+    nd_uuid_t uuid;
+
+    if (len == 36 && in[8] == '-' && in[13] == '-' && in[18] == '-' && in[23] == '-') {
+        bool ok = uuid_hex_to_bytes(&in[0], 4, &uuid[0]) &
+                  uuid_hex_to_bytes(&in[9], 2, &uuid[4]) &
+                  uuid_hex_to_bytes(&in[14], 2, &uuid[6]) &
+                  uuid_hex_to_bytes(&in[19], 2, &uuid[8]) &
+                  uuid_hex_to_bytes(&in[24], 6, &uuid[10]);
+        if (!ok)
+            return false;
+    }
+    else if (len >= 32 && uuid_hex_to_bytes(in, 16, uuid)) {
+        // like the generic parser, anything after the 16th byte is ignored
+        ;
     }
+    else
+        return false;
 
-    return 0; // Success
+    memcpy(uu, uuid, sizeof(nd_uuid_t));
+    return true;
 }
 
 int uuid_parse_flexi(const char *in, nd_uuid_t uu) {
     if(!in || !*in)
         return -1;
 
+    if(likely(uuid_parse_fast(in, uu)))
+        return 0;
+
+    // anything else, or an invalid one, that needs the exact error
+
     size_t hexCharCount = 0;
     size_t hyphenCount = 0;
     const char *s = in;
@@ -215,6 +284,41 @@ int uuid_unittest(void) {
             break;
     }
 
+    // a known value, in all its forms
+    {
+        static const nd_uuid_t known = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10 };
+        char lower[UUID_STR_LEN], upper[UUID_STR_LEN], compact[UUID_COMPACT_STR_LEN];
+        nd_uuid_t parsed;
+
+        uuid_unparse_lower(known, lower);
+        uuid_unparse_upper(known, upper);
+        uuid_unparse_lower_compact(known, compact);
+
+        if(strcmp(lower, "01234567-89ab-cdef-fedc-ba9876543210") != 0 ||
+            strcmp(upper, "01234567-89AB-CDEF-FEDC-BA9876543210") != 0 ||
+            strcmp(compact, "0123456789abcdeffedcba9876543210") != 0) {
+            printf("UUID: the known UUID is formatted as '%s', '%s', '%s'\n", lower, upper, compact);
+            failed_tests++;
+        }
+
+        if(uuid_parse_flexi(upper, parsed) != 0 || uuid_compare(known, parsed) != 0 ||
+            uuid_parse_compact(compact, parsed) != 0 || uuid_compare(known, parsed) != 0) {
+            printf("UUID: the known UUID is not parsed back\n");
+            failed_tests++;
+        }
+
+        // invalid ones
+        if(uuid_parse_flexi("01234567-89ab-cdef-fedc-ba987654321g", parsed) == 0 ||
+            uuid_parse_flexi("0123456789abcdeffedcba987654321", parsed) == 0 ||
+            uuid_parse_flexi("01234567-89ab-cdef-fedc", parsed) == 0 ||
+            uuid_parse_compact("0123456789abcdeffedcba98765432 0", parsed) == 0) {
+            printf("UUID: an invalid UUID is parsed\n");
+            failed_tests++;
+        }
+    }
+
     printf("UUID: failed %d out of %d tests.\n", failed_tests, i);
+
+    failed_tests += uuidmap_unittest();
     return failed_tests;
 }
@@ -0,0 +1,356 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../libnetdata.h"
+
+typedef int32_t UUIDMAP_REFCOUNT;
+
+struct uuidmap_entry {
+    nd_uuid_t uuid;
+    UUIDMAP_REFCOUNT refcount;
+};
+
+// The entries are allocated in pages that never move, so that readers can
+// resolve an id to its UUID without any locks. The index (UUID to id) is
+// only used when references are acquired or released, and it is partitioned
+// to keep the writers of different UUIDs apart.
+
+#define UUIDMAP_PAGE_BITS 14
+#define UUIDMAP_PAGE_ENTRIES (1U << UUIDMAP_PAGE_BITS)
+#define UUIDMAP_MAX_PAGES (1U << (32 - UUIDMAP_PAGE_BITS))
+#define UUIDMAP_MAX_ID (UINT32_MAX - 1)
+
+#define UUIDMAP_PARTITIONS 16
+#define UUIDMAP_INDEX_MIN_SIZE 256
+#define UUIDMAP_INDEX_DELETED UINT32_MAX
+
+struct uuidmap_index {
+    size_t size;                    // always a power of 2
+    size_t used;                    // slots with an id
+    size_t deleted;                 // slots marked deleted
+    UUIDMAP_ID *slots;
+};
+
+static struct {
+    struct {
+        SPINLOCK spinlock;          // protects everything in ids
+        UUIDMAP_ID next;            // the next id never given before
+        UUIDMAP_ID *released;       // ids to be reused
+        size_t released_used;
+        size_t released_size;
+        size_t entries;
+        size_t pages;
+    } ids;
+
+    struct {
+        SPINLOCK spinlock;
+        struct uuidmap_index index;
+    } partitions[UUIDMAP_PARTITIONS];
+
+    struct uuidmap_entry *pages[UUIDMAP_MAX_PAGES];
+} uuidmap = {
+    .ids = {
+        .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+        .next = 1,
+    },
+    .partitions = {
+        [0 ... UUIDMAP_PARTITIONS - 1] = { .spinlock = NETDATA_SPINLOCK_INITIALIZER },
+    },
+};
+
+static inline uint64_t uuidmap_hash(const nd_uuid_t uuid) {
+    uint64_t h[2];
+    memcpy(h, uuid, sizeof(h));
+
+    uint64_t x = h[0] ^ (h[1] * 0x9E3779B97F4A7C15ULL);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return x;
+}
+
+static inline struct uuidmap_entry *uuidmap_entry(UUIDMAP_ID id) {
+    struct uuidmap_entry *page = __atomic_load_n(&uuidmap.pages[id >> UUIDMAP_PAGE_BITS], __ATOMIC_ACQUIRE);
+    return &page[id & (UUIDMAP_PAGE_ENTRIES - 1)];
+}
+
+// ----------------------------------------------------------------------------
+// ids
+
+static UUIDMAP_ID uuidmap_id_get(void) {
+    UUIDMAP_ID id;
+
+    spinlock_lock(&uuidmap.ids.spinlock);
+
+    if(uuidmap.ids.released_used)
+        id = uuidmap.ids.released[--uuidmap.ids.released_used];
+
+    else {
+        if(unlikely(uuidmap.ids.next > UUIDMAP_MAX_ID))
+            fatal("UUIDMAP: all %u ids are used", UUIDMAP_MAX_ID);
+
+        id = uuidmap.ids.next++;
+
+        size_t page = id >> UUIDMAP_PAGE_BITS;
+        if(!uuidmap.pages[page]) {
+            __atomic_store_n(&uuidmap.pages[page], callocz(UUIDMAP_PAGE_ENTRIES, sizeof(struct uuidmap_entry)), __ATOMIC_RELEASE);
+            uuidmap.ids.pages++;
+        }
+    }
+
+    uuidmap.ids.entries++;
+
+    spinlock_unlock(&uuidmap.ids.spinlock);
+
+    return id;
+}
+
+static void uuidmap_id_release(UUIDMAP_ID id) {
+    spinlock_lock(&uuidmap.ids.spinlock);
+
+    if(uuidmap.ids.released_used == uuidmap.ids.released_size) {
+        uuidmap.ids.released_size = uuidmap.ids.released_size ? uuidmap.ids.released_size * 2 : 1024;
+        uuidmap.ids.released = reallocz(uuidmap.ids.released, uuidmap.ids.released_size * sizeof(UUIDMAP_ID));
+    }
+
+    uuidmap.ids.released[uuidmap.ids.released_used++] = id;
+    uuidmap.ids.entries--;
+
+    spinlock_unlock(&uuidmap.ids.spinlock);
+}
+
+// ----------------------------------------------------------------------------
+// index - all under the partition lock
+
+static inline void uuidmap_index_insert_unsafe(struct uuidmap_index *idx, UUIDMAP_ID id, uint64_t hash) {
+    size_t mask = idx->size - 1;
+    size_t slot = hash & mask;
+
+    while(idx->slots[slot] && idx->slots[slot] != UUIDMAP_INDEX_DELETED)
+        slot = (slot + 1) & mask;
+
+    if(idx->slots[slot] == UUIDMAP_INDEX_DELETED)
+        idx->deleted--;
+
+    idx->slots[slot] = id;
+    idx->used++;
+}
+
+static inline size_t uuidmap_index_find_slot_unsafe(struct uuidmap_index *idx, const nd_uuid_t uuid, uint64_t hash) {
+    if(!idx->size)
+        return SIZE_MAX;
+
+    size_t mask = idx->size - 1;
+    size_t slot = hash & mask;
+
+    for(size_t i = 0; i < idx->size ; i++, slot = (slot + 1) & mask) {
+        UUIDMAP_ID id = idx->slots[slot];
+
+        if(!id)
+            return SIZE_MAX;
+
+        if(id != UUIDMAP_INDEX_DELETED && uuid_eq(uuidmap_entry(id)->uuid, uuid))
+            return slot;
+    }
+
+    return SIZE_MAX;
+}
+
+static inline void uuidmap_index_reserve_unsafe(struct uuidmap_index *idx) {
+    // keep the load factor (including the deleted slots) at or below 1/2
+    if(likely(idx->size && (idx->used + idx->deleted + 1) * 2 <= idx->size))
+        return;
+
+    struct uuidmap_index old = *idx;
+
+    size_t size = UUIDMAP_INDEX_MIN_SIZE;
+    while(size < (old.used + 1) * 4)
+        size <<= 1;
+
+    idx->size = size;
+    idx->used = 0;
+    idx->deleted = 0;
+    idx->slots = callocz(size, sizeof(UUIDMAP_ID));
+
+    for(size_t i = 0; i < old.size ; i++) {
+        UUIDMAP_ID id = old.slots[i];
+        if(id && id != UUIDMAP_INDEX_DELETED)
+            uuidmap_index_insert_unsafe(idx, id, uuidmap_hash(uuidmap_entry(id)->uuid));
+    }
+
+    freez(old.slots);
+}
+
+// ----------------------------------------------------------------------------
+// public API
+
+UUIDMAP_ID uuidmap_create(const nd_uuid_t uuid) {
+    uint64_t hash = uuidmap_hash(uuid);
+    size_t partition = (hash >> 56) % UUIDMAP_PARTITIONS;
+    struct uuidmap_index *idx = &uuidmap.partitions[partition].index;
+
+    spinlock_lock(&uuidmap.partitions[partition].spinlock);
+
+    UUIDMAP_ID id;
+    size_t slot = uuidmap_index_find_slot_unsafe(idx, uuid, hash);
+    if(slot != SIZE_MAX) {
+        id = idx->slots[slot];
+        __atomic_add_fetch(&uuidmap_entry(id)->refcount, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        id = uuidmap_id_get();
+
+        struct uuidmap_entry *e = uuidmap_entry(id);
+        uuid_copy(e->uuid, uuid);
+        __atomic_store_n(&e->refcount, 1, __ATOMIC_RELEASE);
+
+        uuidmap_index_reserve_unsafe(idx);
+        uuidmap_index_insert_unsafe(idx, id, hash);
+    }
+
+    spinlock_unlock(&uuidmap.partitions[partition].spinlock);
+
+    return id;
+}
+
+UUIDMAP_ID uuidmap_dup(UUIDMAP_ID id) {
+    if(unlikely(!id))
+        return 0;
+
+    // the caller holds a reference, so it cannot reach zero
+    __atomic_add_fetch(&uuidmap_entry(id)->refcount, 1, __ATOMIC_RELAXED);
+    return id;
+}
+
+void uuidmap_free(UUIDMAP_ID id) {
+    if(unlikely(!id))
+        return;
+
+    struct uuidmap_entry *e = uuidmap_entry(id);
+    uint64_t hash = uuidmap_hash(e->uuid);
+    size_t partition = (hash >> 56) % UUIDMAP_PARTITIONS;
+    struct uuidmap_index *idx = &uuidmap.partitions[partition].index;
+
+    // the last reference is released under the partition lock,
+    // so that uuidmap_create() cannot find it in the meantime
+    spinlock_lock(&uuidmap.partitions[partition].spinlock);
+
+    UUIDMAP_REFCOUNT refcount = __atomic_sub_fetch(&e->refcount, 1, __ATOMIC_ACQ_REL);
+    if(unlikely(refcount < 0))
+        fatal("UUIDMAP: id %u was released more times than acquired", id);
+
+    if(!refcount) {
+        size_t slot = uuidmap_index_find_slot_unsafe(idx, e->uuid, hash);
+        if(likely(slot != SIZE_MAX)) {
+            idx->slots[slot] = UUIDMAP_INDEX_DELETED;
+            idx->used--;
+            idx->deleted++;
+        }
+
+        uuidmap_id_release(id);
+    }
+
+    spinlock_unlock(&uuidmap.partitions[partition].spinlock);
+}
+
+nd_uuid_t *uuidmap_uuid_ptr(UUIDMAP_ID id) {
+    return &uuidmap_entry(id)->uuid;
+}
+
+size_t uuidmap_entries(void) {
+    return __atomic_load_n(&uuidmap.ids.entries, __ATOMIC_RELAXED);
+}
+
+size_t uuidmap_memory(void) {
+    spinlock_lock(&uuidmap.ids.spinlock);
+    size_t bytes = uuidmap.ids.pages * UUIDMAP_PAGE_ENTRIES * sizeof(struct uuidmap_entry) +
+                   uuidmap.ids.released_size * sizeof(UUIDMAP_ID);
+    spinlock_unlock(&uuidmap.ids.spinlock);
+
+    for(size_t i = 0; i < UUIDMAP_PARTITIONS ; i++) {
+        spinlock_lock(&uuidmap.partitions[i].spinlock);
+        bytes += uuidmap.partitions[i].index.size * sizeof(UUIDMAP_ID);
+        spinlock_unlock(&uuidmap.partitions[i].spinlock);
+    }
+
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------
+// unit test
+
+int uuidmap_unittest(void) {
+    const size_t entries = 100000;
+    int errors = 0;
+
+    nd_uuid_t *uuids = mallocz(entries * sizeof(nd_uuid_t));
+    UUIDMAP_ID *ids = mallocz(entries * sizeof(UUIDMAP_ID));
+
+    size_t base = uuidmap_entries();
+
+    for(size_t i = 0; i < entries ; i++) {
+        uuid_generate_random(uuids[i]);
+        ids[i] = uuidmap_create(uuids[i]);
+    }
+
+    if(uuidmap_entries() != base + entries) {
+        fprintf(stderr, "UUIDMAP: expected %zu entries, found %zu\n", base + entries, uuidmap_entries());
+        errors++;
+    }
+
+    for(size_t i = 0; i < entries ; i++) {
+        // the same UUID gets the same id
+        if(uuidmap_create(uuids[i]) != ids[i]) {
+            fprintf(stderr, "UUIDMAP: second create of entry %zu gave a different id\n", i);
+            errors++;
+        }
+
+        if(!uuid_eq(*uuidmap_uuid_ptr(ids[i]), uuids[i])) {
+            fprintf(stderr, "UUIDMAP: id %u does not resolve to its UUID\n", ids[i]);
+            errors++;
+        }
+    }
+
+    // release the second references - all ids must still be there
+    for(size_t i = 0; i < entries ; i++)
+        uuidmap_free(ids[i]);
+
+    if(uuidmap_entries() != base + entries) {
+        fprintf(stderr, "UUIDMAP: entries were released while still referenced\n");
+        errors++;
+    }
+
+    for(size_t i = 0; i < entries ; i++) {
+        if(!uuid_eq(*uuidmap_uuid_ptr(ids[i]), uuids[i])) {
+            fprintf(stderr, "UUIDMAP: id %u changed while still referenced\n", ids[i]);
+            errors++;
+        }
+
+        uuidmap_free(ids[i]);
+    }
+
+    if(uuidmap_entries() != base) {
+        fprintf(stderr, "UUIDMAP: expected %zu entries after freeing all, found %zu\n", base, uuidmap_entries());
+        errors++;
+    }
+
+    // released ids are reused
+    UUIDMAP_ID id = uuidmap_create(uuids[0]);
+    bool reused = false;
+    for(size_t i = 0; i < entries && !reused ; i++)
+        reused = (id == ids[i]);
+
+    if(!reused) {
+        fprintf(stderr, "UUIDMAP: released ids are not reused\n");
+        errors++;
+    }
+    uuidmap_free(id);
+
+    freez(uuids);
+    freez(ids);
+
+    fprintf(stderr, "UUIDMAP: %d errors\n", errors);
+    return errors;
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_UUIDMAP_H
+#define NETDATA_UUIDMAP_H
+
+// A process wide map of UUIDs to 32-bit ids.
+//
+// Structures that index millions of objects by UUID (like the dbengine metrics
+// registry, which has one entry per metric per tier) can keep a 32-bit id
+// instead of the 16-byte UUID. Each UUID is stored once, no matter how many
+// structures refer to it.
+//
+// Ids are reference counted. They are only valid while a reference is held,
+// and they are reused after the last reference is released. They are not
+// persisted - at storage and API boundaries, UUIDs are still used.
+
+typedef uint32_t UUIDMAP_ID;    // 0 is never a valid id
+
+// get the id of a UUID, creating it when it does not exist - acquires a reference
+UUIDMAP_ID uuidmap_create(const nd_uuid_t uuid);
+
+// acquire one more reference on an id the caller already holds
+UUIDMAP_ID uuidmap_dup(UUIDMAP_ID id);
+
+// release a reference - the id is reused when the last one is released
+void uuidmap_free(UUIDMAP_ID id);
+
+// lock free - the pointer is valid for as long as the caller holds a reference
+nd_uuid_t *uuidmap_uuid_ptr(UUIDMAP_ID id);
+
+size_t uuidmap_entries(void);
+size_t uuidmap_memory(void);
+
+int uuidmap_unittest(void);
+
+#endif //NETDATA_UUIDMAP_H
@@ -3,18 +3,24 @@
 #define WORKER_IDLE 'I'
 #define WORKER_BUSY 'B'
 
+#define WORKER_CACHE_LINE_PADDING(x) uint8_t padding##x[64]
+
+// the workers keep time in clock ticks - the TSC when it is invariant, or microseconds otherwise
+// ticks are converted to microseconds only by the statistics thread
+typedef uint64_t worker_ticks_t;
+
 struct worker_job_type {
     STRING *name;
     STRING *units;
 
     // statistics controlled variables
     size_t statistics_last_jobs_started;
-    usec_t statistics_last_busy_time;
+    worker_ticks_t statistics_last_busy_time;
     NETDATA_DOUBLE statistics_last_custom_value;
 
     // worker controlled variables
     volatile size_t worker_jobs_started;
-    volatile usec_t worker_busy_time;
+    volatile worker_ticks_t worker_busy_time;
 
     WORKER_METRIC_TYPE type;
     NETDATA_DOUBLE custom_value;
@@ -25,23 +31,30 @@ struct worker {
     const char *tag;
     const char *workname;
 
+    struct worker *next;
+    struct worker *prev;
+
     // statistics controlled variables
-    volatile usec_t statistics_last_checkpoint;
+    // the statistics thread never writes to the worker controlled variables,
+    // so that the cache lines of the worker are not bouncing between the CPUs
+    volatile worker_ticks_t statistics_last_checkpoint;
     size_t statistics_last_jobs_started;
-    usec_t statistics_last_busy_time;
+    worker_ticks_t statistics_last_busy_time;
+    worker_ticks_t statistics_running_since;      // the start of the job we have partially reported
+    worker_ticks_t statistics_running_reported;   // the busy time of it that we have already reported
+    size_t statistics_running_job_id;
+
+    WORKER_CACHE_LINE_PADDING(0);
 
     // the worker controlled variables
     size_t worker_max_job_id;
     volatile size_t job_id;
     volatile size_t jobs_started;
-    volatile usec_t busy_time;
-    volatile usec_t last_action_timestamp;
+    volatile worker_ticks_t busy_time;
+    volatile worker_ticks_t last_action_timestamp;
     volatile char last_action;
 
     struct worker_job_type per_job_type[WORKER_UTILIZATION_MAX_JOB_TYPES];
-
-    struct worker *next;
-    struct worker *prev;
 };
 
 struct workers_workname {                           // this is what we add to JudyHS
@@ -52,6 +65,13 @@ struct workers_workname {                           // this is what we add to Ju
 static struct workers_globals {
     bool enabled;
 
+    struct {
+        bool enabled;                           // the workers use the TSC for timing
+        worker_ticks_t calibration_ticks;       // the TSC when workers were enabled
+        usec_t calibration_ut;                  // the monotonic time when workers were enabled
+        NETDATA_DOUBLE ticks_per_usec;
+    } tsc;
+
     SPINLOCK spinlock;
     Pvoid_t worknames_JudyHS;
     size_t memory;
@@ -64,15 +84,90 @@ static struct workers_globals {
 
 static __thread struct worker *worker = NULL; // the current thread worker
 
-static inline usec_t worker_now_monotonic_usec(void) {
+#if defined(__x86_64__) && !defined(NETDATA_WORKERS_WITHOUT_TSC)
+#include <x86intrin.h>
+#define WORKERS_HAVE_TSC 1
+#endif
+
+static inline worker_ticks_t worker_now_ticks(void) {
 #ifdef NETDATA_WITHOUT_WORKERS_LATENCY
     return 0;
 #else
+#ifdef WORKERS_HAVE_TSC
+    if(likely(workers_globals.tsc.enabled))
+        return __rdtsc();
+#endif
     return now_monotonic_usec();
 #endif
 }
 
+// the TSC can be used only when it ticks at a constant rate and does not stop when the CPUs sleep
+static bool workers_tsc_is_invariant(void) {
+#ifdef WORKERS_HAVE_TSC
+    procfile *ff = procfile_open("/proc/cpuinfo", ": \t", PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
+    if(!ff) return false;
+
+    ff = procfile_readall(ff);
+    if(!ff) return false;
+
+    bool constant = false, nonstop = false;
+    for(size_t l = 0, lines = procfile_lines(ff); l < lines ; l++) {
+        size_t words = procfile_linewords(ff, l);
+        if(!words || strcmp(procfile_lineword(ff, l, 0), "flags") != 0)
+            continue;
+
+        for(size_t w = 1; w < words ; w++) {
+            const char *flag = procfile_lineword(ff, l, w);
+            if(strcmp(flag, "constant_tsc") == 0) constant = true;
+            else if(strcmp(flag, "nonstop_tsc") == 0) nonstop = true;
+        }
+        break;
+    }
+
+    procfile_close(ff);
+    return constant && nonstop;
+#else
+    return false;
+#endif
+}
+
+// the TSC frequency is calibrated against the monotonic clock, by the statistics thread,
+// over the whole time since workers were enabled - so it gets more accurate over time
+static void workers_tsc_calibrate(void) {
+#ifdef WORKERS_HAVE_TSC
+    if(!workers_globals.tsc.enabled)
+        return;
+
+    usec_t elapsed_ut = now_monotonic_usec() - workers_globals.tsc.calibration_ut;
+    if(elapsed_ut < 10 * USEC_PER_MS) {
+        sleep_usec(10 * USEC_PER_MS - elapsed_ut);
+        elapsed_ut = now_monotonic_usec() - workers_globals.tsc.calibration_ut;
+    }
+
+    worker_ticks_t elapsed_ticks = __rdtsc() - workers_globals.tsc.calibration_ticks;
+    workers_globals.tsc.ticks_per_usec = (NETDATA_DOUBLE)elapsed_ticks / (NETDATA_DOUBLE)elapsed_ut;
+#endif
+}
+
+static inline usec_t workers_ticks_to_usec(worker_ticks_t ticks) {
+    if(!workers_globals.tsc.enabled)
+        return ticks;
+
+    return (usec_t)((NETDATA_DOUBLE)ticks / workers_globals.tsc.ticks_per_usec);
+}
+
 void workers_utilization_enable(void) {
+    // this has to run before any worker is registered
+    workers_globals.tsc.ticks_per_usec = 1.0;
+
+#ifdef WORKERS_HAVE_TSC
+    if(workers_tsc_is_invariant()) {
+        workers_globals.tsc.calibration_ut = now_monotonic_usec();
+        workers_globals.tsc.calibration_ticks = __rdtsc();
+        workers_globals.tsc.enabled = true;
+    }
+#endif
+
     workers_globals.enabled = true;
 }
 
@@ -96,7 +191,7 @@ void worker_register(const char *name) {
     worker->tag = strdupz(nd_thread_tag());
     worker->workname = strdupz(name);
 
-    usec_t now = worker_now_monotonic_usec();
+    worker_ticks_t now = worker_now_ticks();
     worker->statistics_last_checkpoint = now;
     worker->last_action_timestamp = now;
     worker->last_action = WORKER_IDLE;
@@ -184,8 +279,8 @@ void worker_unregister(void) {
     worker = NULL;
 }
 
-static inline void worker_is_idle_with_time(usec_t now) {
-    usec_t delta = now - worker->last_action_timestamp;
+static inline void worker_is_idle_with_time(worker_ticks_t now) {
+    worker_ticks_t delta = now - worker->last_action_timestamp;
     worker->busy_time += delta;
     worker->per_job_type[worker->job_id].worker_busy_time += delta;
 
@@ -193,21 +288,20 @@ static inline void worker_is_idle_with_time(usec_t now) {
     // set it to idle before we set the timestamp
 
     worker->last_action = WORKER_IDLE;
-    if(likely(worker->last_action_timestamp < now))
-        worker->last_action_timestamp = now;
+    worker->last_action_timestamp = now;
 }
 
 void worker_is_idle(void) {
     if(unlikely(!worker || worker->last_action != WORKER_BUSY)) return;
 
-    worker_is_idle_with_time(worker_now_monotonic_usec());
+    worker_is_idle_with_time(worker_now_ticks());
 }
 
 void worker_is_busy(size_t job_id) {
     if(unlikely(!worker || job_id >= WORKER_UTILIZATION_MAX_JOB_TYPES))
         return;
 
-    usec_t now = worker_now_monotonic_usec();
+    worker_ticks_t now = worker_now_ticks();
 
     if(worker->last_action == WORKER_BUSY)
         worker_is_idle_with_time(now);
@@ -262,8 +356,10 @@ void workers_foreach(const char *name, void (*callback)(
     if(!workers_globals.enabled)
         return;
 
+    workers_tsc_calibrate();
+
     spinlock_lock(&workers_globals.spinlock);
-    usec_t busy_time, delta;
+    worker_ticks_t busy_time, delta;
     size_t i, jobs_started, jobs_running;
 
     size_t workname_size = strlen(name) + 1;
@@ -283,13 +379,14 @@ void workers_foreach(const char *name, void (*callback)(
 
     struct worker *p;
     DOUBLE_LINKED_LIST_FOREACH_FORWARD(workname->base, p, prev, next) {
-        usec_t now = worker_now_monotonic_usec();
+        worker_ticks_t now = worker_now_ticks();
 
         // find per job type statistics
         STRING *per_job_type_name[WORKER_UTILIZATION_MAX_JOB_TYPES];
         STRING *per_job_type_units[WORKER_UTILIZATION_MAX_JOB_TYPES];
         WORKER_METRIC_TYPE per_job_metric_type[WORKER_UTILIZATION_MAX_JOB_TYPES];
         size_t per_job_type_jobs_started[WORKER_UTILIZATION_MAX_JOB_TYPES];
+        worker_ticks_t per_job_type_busy_ticks[WORKER_UTILIZATION_MAX_JOB_TYPES];
         usec_t per_job_type_busy_time[WORKER_UTILIZATION_MAX_JOB_TYPES];
         NETDATA_DOUBLE per_job_custom_values[WORKER_UTILIZATION_MAX_JOB_TYPES];
 
@@ -303,7 +400,7 @@ void workers_foreach(const char *name, void (*callback)(
                 default:
                 case WORKER_METRIC_EMPTY: {
                     per_job_type_jobs_started[i] = 0;
-                    per_job_type_busy_time[i] = 0;
+                    per_job_type_busy_ticks[i] = 0;
                     per_job_custom_values[i] = NAN;
                     break;
                 }
@@ -313,8 +410,8 @@ void workers_foreach(const char *name, void (*callback)(
                     per_job_type_jobs_started[i] = tmp_jobs_started - p->per_job_type[i].statistics_last_jobs_started;
                     p->per_job_type[i].statistics_last_jobs_started = tmp_jobs_started;
 
-                    usec_t tmp_busy_time = p->per_job_type[i].worker_busy_time;
-                    per_job_type_busy_time[i] = tmp_busy_time - p->per_job_type[i].statistics_last_busy_time;
+                    worker_ticks_t tmp_busy_time = p->per_job_type[i].worker_busy_time;
+                    per_job_type_busy_ticks[i] = tmp_busy_time - p->per_job_type[i].statistics_last_busy_time;
                     p->per_job_type[i].statistics_last_busy_time = tmp_busy_time;
 
                     per_job_custom_values[i] = NAN;
@@ -323,7 +420,7 @@ void workers_foreach(const char *name, void (*callback)(
 
                 case WORKER_METRIC_ABSOLUTE: {
                     per_job_type_jobs_started[i] = 0;
-                    per_job_type_busy_time[i] = 0;
+                    per_job_type_busy_ticks[i] = 0;
 
                     per_job_custom_values[i] = p->per_job_type[i].custom_value;
                     break;
@@ -332,7 +429,7 @@ void workers_foreach(const char *name, void (*callback)(
                 case WORKER_METRIC_INCREMENTAL_TOTAL:
                 case WORKER_METRIC_INCREMENT: {
                     per_job_type_jobs_started[i] = 0;
-                    per_job_type_busy_time[i] = 0;
+                    per_job_type_busy_ticks[i] = 0;
 
                     NETDATA_DOUBLE tmp_custom_value = p->per_job_type[i].custom_value;
                     per_job_custom_values[i] = tmp_custom_value - p->per_job_type[i].statistics_last_custom_value;
@@ -345,20 +442,14 @@ void workers_foreach(const char *name, void (*callback)(
 
         // get a copy of the worker variables
         size_t worker_job_id = p->job_id;
-        usec_t worker_busy_time = p->busy_time;
+        worker_ticks_t worker_busy_time = p->busy_time;
         size_t worker_jobs_started = p->jobs_started;
         char worker_last_action = p->last_action;
-        usec_t worker_last_action_timestamp = p->last_action_timestamp;
+        worker_ticks_t worker_last_action_timestamp = p->last_action_timestamp;
 
         delta = now - p->statistics_last_checkpoint;
         p->statistics_last_checkpoint = now;
 
-        // this is the only variable both the worker thread and the statistics thread are writing
-        // we set this only when the worker is busy, so that the worker will not
-        // accumulate all the busy time, but only the time after the point we collected statistics
-        if(worker_last_action == WORKER_BUSY && p->last_action_timestamp == worker_last_action_timestamp && p->last_action == WORKER_BUSY)
-            p->last_action_timestamp = now;
-
         // calculate delta busy time
         busy_time = worker_busy_time - p->statistics_last_busy_time;
         p->statistics_last_busy_time = worker_busy_time;
@@ -367,22 +458,50 @@ void workers_foreach(const char *name, void (*callback)(
         jobs_started = worker_jobs_started - p->statistics_last_jobs_started;
         p->statistics_last_jobs_started = worker_jobs_started;
 
+        bool same_running_job = worker_last_action == WORKER_BUSY &&
+                                p->statistics_running_since == worker_last_action_timestamp;
+
+        if(p->statistics_running_reported && !same_running_job) {
+            // the job we partially reported last time has finished,
+            // and its whole duration is now included in the busy time
+            // remove the part we have already reported
+            worker_ticks_t reported = p->statistics_running_reported;
+            size_t reported_job_id = p->statistics_running_job_id;
+
+            busy_time = (busy_time > reported) ? busy_time - reported : 0;
+            if(reported_job_id <= max_job_id)
+                per_job_type_busy_ticks[reported_job_id] = (per_job_type_busy_ticks[reported_job_id] > reported) ?
+                                                           per_job_type_busy_ticks[reported_job_id] - reported : 0;
+
+            p->statistics_running_reported = 0;
+        }
+
         jobs_running = 0;
         if(worker_last_action == WORKER_BUSY) {
             // the worker is still busy with something
-            // let's add that busy time to the reported one
-            usec_t dt = now - worker_last_action_timestamp;
+            // let's add the busy time we have not reported yet
+            worker_ticks_t running = (now > worker_last_action_timestamp) ? now - worker_last_action_timestamp : 0;
+            worker_ticks_t dt = (running > p->statistics_running_reported) ? running - p->statistics_running_reported : 0;
+
             busy_time += dt;
-            per_job_type_busy_time[worker_job_id] += dt;
+            if(worker_job_id <= max_job_id)
+                per_job_type_busy_ticks[worker_job_id] += dt;
+
+            p->statistics_running_since = worker_last_action_timestamp;
+            p->statistics_running_reported = running;
+            p->statistics_running_job_id = worker_job_id;
             jobs_running = 1;
         }
 
+        for(i = 0; i <= max_job_id ;i++)
+            per_job_type_busy_time[i] = workers_ticks_to_usec(per_job_type_busy_ticks[i]);
+
         callback(data
                  , p->pid
                  , p->tag
                  , max_job_id
-                 , busy_time
-                 , delta
+                 , workers_ticks_to_usec(busy_time)
+                 , workers_ticks_to_usec(delta)
                  , jobs_started
                  , jobs_running
                  , per_job_type_name
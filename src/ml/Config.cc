@@ -48,6 +48,14 @@ void ml_config_load(ml_config_t *cfg) {
     size_t num_training_threads = config_get_number(config_section_ml, "num training threads", 4);
     size_t flush_models_batch_size = config_get_number(config_section_ml, "flush models batch size", 128);
 
+    unsigned training_cpu_percent = config_get_number(config_section_ml, "training thread cpu percent", 50);
+    double min_distribution_shift = config_get_double(config_section_ml, "minimum distribution shift to retrain", 0.1);
+    bool share_models = config_get_boolean(config_section_ml, "share models between similar dimensions", false);
+
+    bool incremental_training = config_get_boolean(config_section_ml, "incremental training", false);
+    unsigned full_train_every = config_get_duration_seconds(config_section_ml, "full training every", 24 * 3600);
+    unsigned tier1_check_after = config_get_duration_seconds(config_section_ml, "check tier 1 before retraining windows longer than", 0);
+
     size_t suppression_window =
         config_get_duration_seconds(config_section_ml, "dimension anomaly rate suppression window", 900);
 
@@ -64,7 +72,7 @@ void ml_config_load(ml_config_t *cfg) {
     min_train_samples = clamp<unsigned>(min_train_samples, 1 * 900, 6 * 3600);
     train_every = clamp<unsigned>(train_every, 1 * 3600, 6 * 3600);
 
-    num_models_to_use = clamp<unsigned>(num_models_to_use, 1, 7 * 24);
+    num_models_to_use = clamp<unsigned>(num_models_to_use, 1, ML_MODELS_MAX);
     delete_models_older_than = clamp<unsigned>(delete_models_older_than, 60 * 60 * 24 * 1, 60 * 60 * 24 * 7);
 
     diff_n = clamp(diff_n, 0u, 1u);
@@ -82,6 +90,12 @@ void ml_config_load(ml_config_t *cfg) {
     num_training_threads = clamp<size_t>(num_training_threads, 1, 128);
     flush_models_batch_size = clamp<size_t>(flush_models_batch_size, 8, 512);
 
+    training_cpu_percent = clamp<unsigned>(training_cpu_percent, 1, 100);
+    min_distribution_shift = clamp(min_distribution_shift, 0.0, 10.0);
+    full_train_every = clamp<unsigned>(full_train_every, train_every, 7 * 24 * 3600);
+    if (tier1_check_after)
+        tier1_check_after = clamp<unsigned>(tier1_check_after, 3600, 7 * 24 * 3600);
+
     suppression_window = clamp<size_t>(suppression_window, 1, max_train_samples);
     suppression_threshold = clamp<size_t>(suppression_threshold, 1, suppression_window);
 
@@ -135,6 +149,14 @@ void ml_config_load(ml_config_t *cfg) {
     cfg->num_training_threads = num_training_threads;
     cfg->flush_models_batch_size = flush_models_batch_size;
 
+    cfg->training_cpu_percent = training_cpu_percent;
+    cfg->min_distribution_shift = min_distribution_shift;
+    cfg->share_models = share_models;
+
+    cfg->incremental_training = incremental_training;
+    cfg->full_train_every = full_train_every;
+    cfg->tier1_check_after = tier1_check_after;
+
     cfg->suppression_window = suppression_window;
     cfg->suppression_threshold = suppression_threshold;
 
@@ -288,7 +288,7 @@ void ml_update_host_and_detection_rate_charts(ml_host_t *host, collected_number
             rrdset_flag_set(host->type_anomaly_rate_rs, RRDSET_FLAG_ANOMALY_DETECTION);
         }
 
-        spinlock_lock_cancelable(&host->type_anomaly_rate_spinlock);
+        spinlock_lock_cancelable(&host->stats_spinlock);
         for (auto &entry : host->type_anomaly_rate) {
             ml_type_anomaly_rate_t &type_anomaly_rate = entry.second;
 
@@ -301,11 +301,8 @@ void ml_update_host_and_detection_rate_charts(ml_host_t *host, collected_number
                 ar = static_cast<double>(type_anomaly_rate.anomalous_dimensions) / n;
 
             rrddim_set_by_pointer(host->type_anomaly_rate_rs, type_anomaly_rate.rd, ar * 10000.0);
-
-            type_anomaly_rate.anomalous_dimensions = 0;
-            type_anomaly_rate.normal_dimensions = 0;
         }
-        spinlock_unlock_cancelable(&host->type_anomaly_rate_spinlock);
+        spinlock_unlock_cancelable(&host->stats_spinlock);
 
         rrdset_done(host->type_anomaly_rate_rs);
     }
@@ -526,6 +523,12 @@ void ml_update_training_statistics_chart(ml_training_thread_t *training_thread,
                 rrddim_add(training_thread->training_results_rs, "null-acquired-dimensions", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
             training_thread->training_results_chart_under_replication_rd =
                 rrddim_add(training_thread->training_results_rs, "chart-under-replication", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            training_thread->training_results_distribution_unchanged_rd =
+                rrddim_add(training_thread->training_results_rs, "distribution-unchanged", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            training_thread->training_results_shared_model_rd =
+                rrddim_add(training_thread->training_results_rs, "shared-models", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            training_thread->training_results_incremental_rd =
+                rrddim_add(training_thread->training_results_rs, "incremental", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
         }
 
         rrddim_set_by_pointer(training_thread->training_results_rs,
@@ -538,6 +541,12 @@ void ml_update_training_statistics_chart(ml_training_thread_t *training_thread,
                               training_thread->training_results_null_acquired_dimension_rd, ts.training_result_null_acquired_dimension);
         rrddim_set_by_pointer(training_thread->training_results_rs,
                               training_thread->training_results_chart_under_replication_rd, ts.training_result_chart_under_replication);
+        rrddim_set_by_pointer(training_thread->training_results_rs,
+                              training_thread->training_results_distribution_unchanged_rd, ts.training_result_distribution_unchanged);
+        rrddim_set_by_pointer(training_thread->training_results_rs,
+                              training_thread->training_results_shared_model_rd, ts.training_result_shared_model);
+        rrddim_set_by_pointer(training_thread->training_results_rs,
+                              training_thread->training_results_incremental_rd, ts.training_result_incremental);
 
         rrdset_done(training_thread->training_results_rs);
     }
@@ -84,6 +84,10 @@ void ml_chart_update_end(RRDSET *rs) {
     UNUSED(rs);
 }
 
+void ml_chart_obsolete(RRDSET *rs) {
+    UNUSED(rs);
+}
+
 void ml_dimension_new(RRDDIM *rd) {
     UNUSED(rd);
 }
@@ -100,8 +104,9 @@ bool ml_dimension_is_anomalous(RRDDIM *rd, time_t curr_time, double value, bool
     return false;
 }
 
-int ml_dimension_load_models(RRDDIM *rd, sqlite3_stmt **stmp __maybe_unused) {
-    UNUSED(rd);
+int ml_dimensions_load_models(RRDDIM **rds, size_t entries, sqlite3_stmt **stmp __maybe_unused) {
+    UNUSED(rds);
+    UNUSED(entries);
     return 0;
 }
 
@@ -18,6 +18,15 @@ using std::isfinite;
 typedef double calculated_number_t;
 typedef dlib::matrix<calculated_number_t, 6, 1> DSample;
 
+// the maximum number of features of a sample (lag_n + 1)
+#define ML_FEATURES_MAX 6
+
+// the cluster centers of a model
+#define ML_KMEANS_CENTERS 2
+
+// the maximum number of models per dimension
+#define ML_MODELS_MAX (7 * 24)
+
 /*
  * Features
  */
@@ -48,8 +57,24 @@ typedef struct {
 
     uint32_t after;
     uint32_t before;
+
+    // The samples each center represents, for incremental training
+    uint32_t counts[ML_KMEANS_CENTERS];
 } ml_kmeans_t;
 
+/*
+ * The models of a dimension, laid out contiguously, so that a sample is
+ * scored against all their cluster centers with one vectorizable pass.
+ * Features beyond lag_n + 1 are zero in both the centers and the sample.
+ */
+
+typedef struct {
+    size_t models;
+    std::vector<calculated_number_t> centers;   // models x ML_KMEANS_CENTERS x ML_FEATURES_MAX
+    std::vector<calculated_number_t> min_dist;
+    std::vector<calculated_number_t> max_dist;
+} ml_kmeans_batch_t;
+
 typedef struct machine_learning_stats_t {
     size_t num_machine_learning_status_enabled;
     size_t num_machine_learning_status_disabled_sp;
@@ -80,6 +105,9 @@ typedef struct training_stats_t {
     size_t training_result_not_enough_collected_values;
     size_t training_result_null_acquired_dimension;
     size_t training_result_chart_under_replication;
+    size_t training_result_distribution_unchanged;
+    size_t training_result_shared_model;
+    size_t training_result_incremental;
 } ml_training_stats_t;
 
 enum ml_metric_type {
@@ -130,6 +158,15 @@ enum ml_training_result {
 
     // Chart is under replication
     TRAINING_RESULT_CHART_UNDER_REPLICATION,
+
+    // We used the model of a similar dimension
+    TRAINING_RESULT_SHARED_MODEL,
+
+    // We updated the last model with the new samples
+    TRAINING_RESULT_INCREMENTAL,
+
+    // The data did not change since the last model, so it was kept
+    TRAINING_RESULT_DISTRIBUTION_UNCHANGED,
 };
 
 typedef struct {
@@ -145,6 +182,13 @@ typedef struct {
     // at the point the request was made
     time_t first_entry_on_request;
     time_t last_entry_on_request;
+
+    // The staleness of the model, weighted by the anomaly rate of the
+    // dimension: requests with higher priority are trained first
+    double priority;
+
+    // Order of arrival, to train requests of equal priority in order
+    uint64_t sequence;
 } ml_training_request_t;
 
 typedef struct {
@@ -182,12 +226,30 @@ typedef struct {
 */
 
 typedef struct {
-    std::queue<ml_training_request_t> internal;
+    bool operator()(const ml_training_request_t &a, const ml_training_request_t &b) const {
+        if (a.priority != b.priority)
+            return a.priority < b.priority;
+
+        return a.sequence > b.sequence;
+    }
+} ml_training_request_compare_t;
+
+typedef struct {
+    std::priority_queue<ml_training_request_t, std::vector<ml_training_request_t>, ml_training_request_compare_t> internal;
+    uint64_t sequence;
     netdata_mutex_t mutex;
     pthread_cond_t cond_var;
     std::atomic<bool> exit;
 } ml_queue_t;
 
+// The per-minute points of a training window, summarized: their average,
+// the standard deviation of their averages and their average range
+typedef struct {
+    calculated_number_t mean;
+    calculated_number_t stddev;
+    calculated_number_t range;
+} ml_tier1_distribution_t;
+
 typedef struct {
     RRDDIM *rd;
 
@@ -197,14 +259,25 @@ typedef struct {
 
     ml_training_response_t tr;
     time_t last_training_time;
+    time_t last_full_training_time;
 
     std::vector<calculated_number_t> cns;
 
     std::vector<ml_kmeans_t> km_contexts;
+    ml_kmeans_batch_t km_batch;
     SPINLOCK slock;
     ml_kmeans_t kmeans;
     std::vector<DSample> feature;
 
+    // The distribution of the values the last model was trained on
+    bool has_training_distribution;
+    calculated_number_t training_mean;
+    calculated_number_t training_stddev;
+
+    // The same window, as summarized by tier 1
+    bool has_tier1_distribution;
+    ml_tier1_distribution_t tier1_distribution;
+
     uint32_t suppression_window_counter;
     uint32_t suppression_anomaly_counter;
 } ml_dimension_t;
@@ -212,6 +285,9 @@ typedef struct {
 typedef struct {
     RRDSET *rs;
     ml_machine_learning_stats_t mls;
+
+    // the stats last added to the totals of the host
+    ml_machine_learning_stats_t published_mls;
 } ml_chart_t;
 
 void ml_chart_update_dimension(ml_chart_t *chart, ml_dimension_t *dim, bool is_anomalous);
@@ -269,7 +345,11 @@ typedef struct {
     RRDDIM *detector_events_new_anomaly_event_rd;
 
     RRDSET *type_anomaly_rate_rs;
-    SPINLOCK type_anomaly_rate_spinlock;
+
+    // the totals of the host and of each chart type, updated by the charts
+    // when their stats change, protected by the stats spinlock
+    SPINLOCK stats_spinlock;
+    ml_machine_learning_stats_t published_mls;
     std::unordered_map<STRING *, ml_type_anomaly_rate_t> type_anomaly_rate;
 } ml_host_t;
 
@@ -278,6 +358,15 @@ typedef struct {
     ml_kmeans_t kmeans;
 } ml_model_info_t;
 
+// The last model trained for a context and dimension id, given to the
+// similar dimensions of all the hosts, instead of training their own
+typedef struct {
+    ml_kmeans_t kmeans;
+    calculated_number_t mean;
+    calculated_number_t stddev;
+    time_t trained_at;
+} ml_shared_model_t;
+
 typedef struct {
     size_t id;
     ND_THREAD *nd_thread;
@@ -307,6 +396,9 @@ typedef struct {
     RRDDIM *training_results_not_enough_collected_values_rd;
     RRDDIM *training_results_null_acquired_dimension_rd;
     RRDDIM *training_results_chart_under_replication_rd;
+    RRDDIM *training_results_distribution_unchanged_rd;
+    RRDDIM *training_results_shared_model_rd;
+    RRDDIM *training_results_incremental_rd;
 
     size_t num_db_transactions;
     size_t num_models_to_prune;
@@ -353,6 +445,14 @@ typedef struct {
     size_t num_training_threads;
     size_t flush_models_batch_size;
 
+    unsigned training_cpu_percent;
+    double min_distribution_shift;
+    bool share_models;
+
+    bool incremental_training;
+    unsigned full_train_every;
+    unsigned tier1_check_after;
+
     std::vector<ml_training_thread_t> training_threads;
     std::atomic<bool> training_stop;
 
@@ -23,6 +23,9 @@
 static sqlite3 *db = NULL;
 static netdata_mutex_t db_mutex = NETDATA_MUTEX_INITIALIZER;
 
+static std::unordered_map<std::string, ml_shared_model_t> shared_models;
+static netdata_mutex_t shared_models_mutex = NETDATA_MUTEX_INITIALIZER;
+
 /*
  * Functions to convert enums to strings
 */
@@ -86,6 +89,12 @@ ml_training_result_to_string(enum ml_training_result tr)
             return "null-acquired-dim";
         case TRAINING_RESULT_CHART_UNDER_REPLICATION:
             return "chart-under-replication";
+        case TRAINING_RESULT_SHARED_MODEL:
+            return "shared-model";
+        case TRAINING_RESULT_INCREMENTAL:
+            return "incremental";
+        case TRAINING_RESULT_DISTRIBUTION_UNCHANGED:
+            return "distribution-unchanged";
         default:
             return "unknown";
     }
@@ -180,10 +189,89 @@ ml_features_preprocess(ml_features_t *features)
  * KMeans
 */
 
+// the models of a dimension are scored in one pass, over contiguous arrays
+
+static inline void
+ml_kmeans_sample_flatten(const DSample &DS, calculated_number_t *dst)
+{
+    size_t features = MIN((size_t) DS.size(), (size_t) ML_FEATURES_MAX);
+
+    for (size_t idx = 0; idx != ML_FEATURES_MAX; idx++)
+        dst[idx] = (idx < features) ? DS(idx) : 0.0;
+}
+
+static void
+ml_kmeans_batch_update(ml_kmeans_batch_t *batch, const std::vector<ml_kmeans_t> &km_contexts)
+{
+    batch->models = km_contexts.size();
+    batch->centers.assign(batch->models * ML_KMEANS_CENTERS * ML_FEATURES_MAX, 0.0);
+    batch->min_dist.resize(batch->models);
+    batch->max_dist.resize(batch->models);
+
+    for (size_t m = 0; m != batch->models; m++) {
+        const ml_kmeans_t &km = km_contexts[m];
+
+        size_t centers = MIN(km.cluster_centers.size(), (size_t) ML_KMEANS_CENTERS);
+        for (size_t c = 0; c != centers; c++)
+            ml_kmeans_sample_flatten(km.cluster_centers[c], &batch->centers[(m * ML_KMEANS_CENTERS + c) * ML_FEATURES_MAX]);
+
+        batch->min_dist[m] = km.min_dist;
+        batch->max_dist[m] = km.max_dist;
+    }
+}
+
+// the euclidean distances of a sample to a contiguous array of centers
+static void
+ml_kmeans_distances(const calculated_number_t *centers, size_t n, const calculated_number_t *sample, calculated_number_t *distances)
+{
+    for (size_t c = 0; c != n; c++) {
+        const calculated_number_t *cc = &centers[c * ML_FEATURES_MAX];
+
+        calculated_number_t sum = 0.0;
+        for (size_t idx = 0; idx != ML_FEATURES_MAX; idx++) {
+            calculated_number_t d = cc[idx] - sample[idx];
+            sum += d * d;
+        }
+
+        distances[c] = sum;
+    }
+
+    for (size_t c = 0; c != n; c++)
+        distances[c] = std::sqrt(distances[c]);
+}
+
+// the anomaly score of a sample for every model of the batch
+static void
+ml_kmeans_batch_anomaly_scores(const ml_kmeans_batch_t *batch, const calculated_number_t *sample, calculated_number_t *scores)
+{
+    calculated_number_t distances[ML_MODELS_MAX * ML_KMEANS_CENTERS];
+    ml_kmeans_distances(batch->centers.data(), batch->models * ML_KMEANS_CENTERS, sample, distances);
+
+    for (size_t m = 0; m != batch->models; m++) {
+        calculated_number_t mean_dist = 0.0;
+        for (size_t c = 0; c != ML_KMEANS_CENTERS; c++)
+            mean_dist += distances[m * ML_KMEANS_CENTERS + c];
+
+        mean_dist /= ML_KMEANS_CENTERS;
+
+        calculated_number_t min_dist = batch->min_dist[m];
+        calculated_number_t max_dist = batch->max_dist[m];
+
+        if (max_dist == min_dist) {
+            scores[m] = 0.0;
+            continue;
+        }
+
+        calculated_number_t anomaly_score = 100.0 * std::abs((mean_dist - min_dist) / (max_dist - min_dist));
+        scores[m] = (anomaly_score > 100.0) ? 100.0 : anomaly_score;
+    }
+}
+
 static void
 ml_kmeans_init(ml_kmeans_t *kmeans)
 {
-    kmeans->cluster_centers.reserve(2);
+    kmeans->cluster_centers.reserve(ML_KMEANS_CENTERS);
+    memset(kmeans->counts, 0, sizeof(kmeans->counts));
     kmeans->min_dist = std::numeric_limits<calculated_number_t>::max();
     kmeans->max_dist = std::numeric_limits<calculated_number_t>::min();
 }
@@ -198,41 +286,117 @@ ml_kmeans_train(ml_kmeans_t *kmeans, const ml_features_t *features, time_t after
     kmeans->max_dist  = std::numeric_limits<calculated_number_t>::min();
 
     kmeans->cluster_centers.clear();
+    memset(kmeans->counts, 0, sizeof(kmeans->counts));
 
-    dlib::pick_initial_centers(2, kmeans->cluster_centers, features->preprocessed_features);
+    dlib::pick_initial_centers(ML_KMEANS_CENTERS, kmeans->cluster_centers, features->preprocessed_features);
     dlib::find_clusters_using_kmeans(features->preprocessed_features, kmeans->cluster_centers, Cfg.max_kmeans_iters);
 
+    size_t n_centers = MIN(kmeans->cluster_centers.size(), (size_t) ML_KMEANS_CENTERS);
+    if (!n_centers)
+        return;
+
+    calculated_number_t centers[ML_KMEANS_CENTERS * ML_FEATURES_MAX];
+    for (size_t c = 0; c != n_centers; c++)
+        ml_kmeans_sample_flatten(kmeans->cluster_centers[c], &centers[c * ML_FEATURES_MAX]);
+
     for (const auto &preprocessed_feature : features->preprocessed_features) {
-        calculated_number_t mean_dist = 0.0;
+        calculated_number_t sample[ML_FEATURES_MAX];
+        calculated_number_t distances[ML_KMEANS_CENTERS];
 
-        for (const auto &cluster_center : kmeans->cluster_centers) {
-            mean_dist += dlib::length(cluster_center - preprocessed_feature);
-        }
+        ml_kmeans_sample_flatten(preprocessed_feature, sample);
+        ml_kmeans_distances(centers, n_centers, sample, distances);
+
+        calculated_number_t mean_dist = 0.0;
+        for (size_t c = 0; c != n_centers; c++)
+            mean_dist += distances[c];
 
-        mean_dist /= kmeans->cluster_centers.size();
+        mean_dist /= n_centers;
 
         if (mean_dist < kmeans->min_dist)
             kmeans->min_dist = mean_dist;
 
         if (mean_dist > kmeans->max_dist)
             kmeans->max_dist = mean_dist;
+
+        size_t nearest = 0;
+        for (size_t c = 1; c != n_centers; c++)
+            if (distances[c] < distances[nearest])
+                nearest = c;
+
+        kmeans->counts[nearest]++;
     }
 }
 
-static calculated_number_t
-ml_kmeans_anomaly_score(const ml_kmeans_t *kmeans, const DSample &DS)
+// mini-batch k-means: each new sample moves its nearest center towards it,
+// by the inverse of the number of samples the center represents
+static void
+ml_kmeans_update(ml_kmeans_t *kmeans, const ml_features_t *features, time_t before)
 {
-    calculated_number_t mean_dist = 0.0;
-    for (const auto &CC: kmeans->cluster_centers)
-        mean_dist += dlib::length(CC - DS);
+    size_t n_centers = MIN(kmeans->cluster_centers.size(), (size_t) ML_KMEANS_CENTERS);
+    if (!n_centers || features->preprocessed_features.empty())
+        return;
+
+    // models loaded from the database do not know the samples of their centers
+    uint32_t max_count = Cfg.max_train_samples;
+    for (size_t c = 0; c != n_centers; c++) {
+        if (!kmeans->counts[c])
+            kmeans->counts[c] = std::max<uint32_t>(1, (uint32_t) (Cfg.max_train_samples * Cfg.random_sampling_ratio / n_centers));
+    }
+
+    calculated_number_t centers[ML_KMEANS_CENTERS * ML_FEATURES_MAX];
+    for (size_t c = 0; c != n_centers; c++)
+        ml_kmeans_sample_flatten(kmeans->cluster_centers[c], &centers[c * ML_FEATURES_MAX]);
+
+    for (const auto &preprocessed_feature : features->preprocessed_features) {
+        calculated_number_t sample[ML_FEATURES_MAX];
+        calculated_number_t distances[ML_KMEANS_CENTERS];
+
+        ml_kmeans_sample_flatten(preprocessed_feature, sample);
+        ml_kmeans_distances(centers, n_centers, sample, distances);
+
+        size_t nearest = 0;
+        for (size_t c = 1; c != n_centers; c++)
+            if (distances[c] < distances[nearest])
+                nearest = c;
+
+        // the counts are capped, so that centers keep following the data
+        if (kmeans->counts[nearest] < max_count)
+            kmeans->counts[nearest]++;
+
+        calculated_number_t eta = 1.0 / kmeans->counts[nearest];
+        calculated_number_t *cc = &centers[nearest * ML_FEATURES_MAX];
+        for (size_t idx = 0; idx != ML_FEATURES_MAX; idx++)
+            cc[idx] += eta * (sample[idx] - cc[idx]);
+    }
+
+    for (size_t c = 0; c != n_centers; c++) {
+        DSample &DS = kmeans->cluster_centers[c];
+        for (long idx = 0; idx != DS.size() && idx != ML_FEATURES_MAX; idx++)
+            DS(idx) = centers[c * ML_FEATURES_MAX + idx];
+    }
+
+    // widen the range of distances with the new samples
+    for (const auto &preprocessed_feature : features->preprocessed_features) {
+        calculated_number_t sample[ML_FEATURES_MAX];
+        calculated_number_t distances[ML_KMEANS_CENTERS];
+
+        ml_kmeans_sample_flatten(preprocessed_feature, sample);
+        ml_kmeans_distances(centers, n_centers, sample, distances);
+
+        calculated_number_t mean_dist = 0.0;
+        for (size_t c = 0; c != n_centers; c++)
+            mean_dist += distances[c];
 
-    mean_dist /= kmeans->cluster_centers.size();
+        mean_dist /= n_centers;
 
-    if (kmeans->max_dist == kmeans->min_dist)
-        return 0.0;
+        if (mean_dist < kmeans->min_dist)
+            kmeans->min_dist = mean_dist;
+
+        if (mean_dist > kmeans->max_dist)
+            kmeans->max_dist = mean_dist;
+    }
 
-    calculated_number_t anomaly_score = 100.0 * std::abs((mean_dist - kmeans->min_dist) / (kmeans->max_dist - kmeans->min_dist));
-    return (anomaly_score > 100.0) ? 100.0 : anomaly_score;
+    kmeans->before = (uint32_t) before;
 }
 
 /*
@@ -246,6 +410,7 @@ ml_queue_init()
 
     netdata_mutex_init(&q->mutex);
     pthread_cond_init(&q->cond_var, NULL);
+    q->sequence = 0;
     q->exit = false;
     return q;
 }
@@ -259,9 +424,10 @@ ml_queue_destroy(ml_queue_t *q)
 }
 
 static void
-ml_queue_push(ml_queue_t *q, const ml_training_request_t req)
+ml_queue_push(ml_queue_t *q, ml_training_request_t req)
 {
     netdata_mutex_lock(&q->mutex);
+    req.sequence = q->sequence++;
     q->internal.push(req);
     pthread_cond_signal(&q->cond_var);
     netdata_mutex_unlock(&q->mutex);
@@ -278,7 +444,9 @@ ml_queue_pop(ml_queue_t *q)
         NULL, // dimension id
         0, // current time
         0, // first entry
-        0  // last entry
+        0, // last entry
+        0, // priority
+        0  // sequence
     };
 
     while (q->internal.empty()) {
@@ -292,7 +460,7 @@ ml_queue_pop(ml_queue_t *q)
         }
     }
 
-    req = q->internal.front();
+    req = q->internal.top();
     q->internal.pop();
 
     netdata_mutex_unlock(&q->mutex);
@@ -321,8 +489,22 @@ ml_queue_signal(ml_queue_t *q)
  * Dimension
 */
 
+static void
+ml_dimension_training_window(ml_dimension_t *dim, ml_training_response_t *training_response)
+{
+    training_response->first_entry_on_response = rrddim_first_entry_s_of_tier(dim->rd, 0);
+    training_response->last_entry_on_response = rrddim_last_entry_s_of_tier(dim->rd, 0);
+
+    // Figure out what our time window should be.
+    training_response->query_before_t = training_response->last_entry_on_response;
+    training_response->query_after_t = std::max(
+        training_response->query_before_t - static_cast<time_t>((Cfg.max_train_samples - 1) * dim->rd->rrdset->update_every),
+        training_response->first_entry_on_response
+    );
+}
+
 static std::pair<calculated_number_t *, ml_training_response_t>
-ml_dimension_calculated_numbers(ml_training_thread_t *training_thread, ml_dimension_t *dim, const ml_training_request_t &training_request)
+ml_dimension_calculated_numbers(ml_training_thread_t *training_thread, ml_dimension_t *dim, const ml_training_request_t &training_request, time_t incremental_after)
 {
     ml_training_response_t training_response = {};
 
@@ -330,18 +512,17 @@ ml_dimension_calculated_numbers(ml_training_thread_t *training_thread, ml_dimens
     training_response.first_entry_on_request = training_request.first_entry_on_request;
     training_response.last_entry_on_request = training_request.last_entry_on_request;
 
-    training_response.first_entry_on_response = rrddim_first_entry_s_of_tier(dim->rd, 0);
-    training_response.last_entry_on_response = rrddim_last_entry_s_of_tier(dim->rd, 0);
+    ml_dimension_training_window(dim, &training_response);
 
     size_t min_n = Cfg.min_train_samples;
     size_t max_n = Cfg.max_train_samples;
 
-    // Figure out what our time window should be.
-    training_response.query_before_t = training_response.last_entry_on_response;
-    training_response.query_after_t = std::max(
-        training_response.query_before_t - static_cast<time_t>((max_n - 1) * dim->rd->rrdset->update_every),
-        training_response.first_entry_on_response
-    );
+    // Incremental training needs only the samples collected since the last
+    // model, and enough before them to preprocess the first one
+    if (incremental_after) {
+        training_response.query_after_t = std::max(incremental_after, training_response.query_after_t);
+        min_n = Cfg.diff_n + Cfg.smooth_n + Cfg.lag_n + 1;
+    }
 
     if (training_response.query_after_t >= training_response.query_before_t) {
         training_response.result = TRAINING_RESULT_INVALID_QUERY_TIME_RANGE;
@@ -430,9 +611,25 @@ const char *db_models_add_model =
     "    @c00, @c01, @c02, @c03, @c04, @c05,"
     "    @c10, @c11, @c12, @c13, @c14, @c15);";
 
-const char *db_models_load =
-    "SELECT * FROM models "
-    "WHERE dim_id = @dim_id AND after >= @after ORDER BY before ASC;";
+// the models of up to ML_MODELS_LOAD_BATCH_SIZE dimensions, in one scan of
+// the primary key, the unused dim_id parameters are bound to NULL
+static std::string
+ml_db_models_load_sql()
+{
+    std::string sql =
+        "SELECT dim_id, after, before,"
+        "    min_dist, max_dist,"
+        "    c00, c01, c02, c03, c04, c05,"
+        "    c10, c11, c12, c13, c14, c15 "
+        "FROM models "
+        "WHERE after >= @after AND dim_id IN (";
+
+    for (size_t idx = 0; idx != ML_MODELS_LOAD_BATCH_SIZE; idx++)
+        sql += idx ? ", ?" : "?";
+
+    sql += ") ORDER BY dim_id, before ASC;";
+    return sql;
+}
 
 const char *db_models_delete =
     "DELETE FROM models "
@@ -621,19 +818,28 @@ bind_fail:
     return rc;
 }
 
-int ml_dimension_load_models(RRDDIM *rd, sqlite3_stmt **active_stmt) {
-    ml_dimension_t *dim = (ml_dimension_t *) rd->ml_dimension;
-    if (!dim)
-        return 0;
+int ml_dimensions_load_models(RRDDIM **rds, size_t entries, sqlite3_stmt **active_stmt) {
+    ml_dimension_t *dims[ML_MODELS_LOAD_BATCH_SIZE];
+    size_t used = 0;
 
-    spinlock_lock(&dim->slock);
-    bool is_empty = dim->km_contexts.empty();
-    spinlock_unlock(&dim->slock);
+    if (entries > ML_MODELS_LOAD_BATCH_SIZE)
+        entries = ML_MODELS_LOAD_BATCH_SIZE;
 
-    if (!is_empty)
-        return 0;
+    for (size_t idx = 0; idx != entries; idx++) {
+        ml_dimension_t *dim = (ml_dimension_t *) rds[idx]->ml_dimension;
+        if (!dim)
+            continue;
 
-    std::vector<ml_kmeans_t> V;
+        spinlock_lock(&dim->slock);
+        bool is_empty = dim->km_contexts.empty();
+        spinlock_unlock(&dim->slock);
+
+        if (is_empty)
+            dims[used++] = dim;
+    }
+
+    if (!used)
+        return 0;
 
     sqlite3_stmt *res = active_stmt ? *active_stmt : NULL;
     int rc = 0;
@@ -645,7 +851,7 @@ int ml_dimension_load_models(RRDDIM *rd, sqlite3_stmt **active_stmt) {
     }
 
     if (unlikely(!res)) {
-        rc = sqlite3_prepare_v2(db, db_models_load, -1, &res, NULL);
+        rc = sqlite3_prepare_v2(db, ml_db_models_load_sql().c_str(), -1, &res, NULL);
         if (unlikely(rc != SQLITE_OK)) {
             error_report("Failed to prepare statement to load models, rc = %d", rc);
             return 1;
@@ -654,55 +860,83 @@ int ml_dimension_load_models(RRDDIM *rd, sqlite3_stmt **active_stmt) {
             *active_stmt = res;
     }
 
-    rc = sqlite3_bind_blob(res, ++param, &dim->rd->metric_uuid, sizeof(dim->rd->metric_uuid), SQLITE_STATIC);
-    if (unlikely(rc != SQLITE_OK))
-        goto bind_fail;
-
     rc = sqlite3_bind_int64(res, ++param, now_realtime_sec() - (Cfg.num_models_to_use * Cfg.max_train_samples));
     if (unlikely(rc != SQLITE_OK))
         goto bind_fail;
 
-    spinlock_lock(&dim->slock);
+    for (size_t idx = 0; idx != ML_MODELS_LOAD_BATCH_SIZE; idx++) {
+        if (idx < used)
+            rc = sqlite3_bind_blob(res, ++param, &dims[idx]->rd->metric_uuid, sizeof(dims[idx]->rd->metric_uuid), SQLITE_STATIC);
+        else
+            rc = sqlite3_bind_null(res, ++param);
 
-    dim->km_contexts.reserve(Cfg.num_models_to_use);
-    while ((rc = sqlite3_step_monitored(res)) == SQLITE_ROW) {
-        ml_kmeans_t km;
+        if (unlikely(rc != SQLITE_OK))
+            goto bind_fail;
+    }
 
-        km.after = sqlite3_column_int(res, 2);
-        km.before = sqlite3_column_int(res, 3);
+    {
+        // the rows come grouped by dimension, decode them without holding
+        // the lock of any dimension, and hand each dimension its models at once
+        std::vector<ml_kmeans_t> models[ML_MODELS_LOAD_BATCH_SIZE];
+        size_t current = 0;
+
+        while ((rc = sqlite3_step_monitored(res)) == SQLITE_ROW) {
+            const void *dim_id = sqlite3_column_blob(res, 0);
+            if (sqlite3_column_bytes(res, 0) != sizeof(nd_uuid_t))
+                continue;
 
-        km.min_dist = sqlite3_column_int(res, 4);
-        km.max_dist = sqlite3_column_int(res, 5);
+            if (memcmp(dim_id, &dims[current]->rd->metric_uuid, sizeof(nd_uuid_t)) != 0) {
+                for (current = 0; current != used; current++) {
+                    if (!memcmp(dim_id, &dims[current]->rd->metric_uuid, sizeof(nd_uuid_t)))
+                        break;
+                }
 
-        km.cluster_centers.resize(2);
+                if (current == used) {
+                    current = 0;
+                    continue;
+                }
+            }
 
-        km.cluster_centers[0].set_size(Cfg.lag_n + 1);
-        km.cluster_centers[0](0) = sqlite3_column_double(res, 6);
-        km.cluster_centers[0](1) = sqlite3_column_double(res, 7);
-        km.cluster_centers[0](2) = sqlite3_column_double(res, 8);
-        km.cluster_centers[0](3) = sqlite3_column_double(res, 9);
-        km.cluster_centers[0](4) = sqlite3_column_double(res, 10);
-        km.cluster_centers[0](5) = sqlite3_column_double(res, 11);
+            ml_kmeans_t km;
+            memset(km.counts, 0, sizeof(km.counts));
 
-        km.cluster_centers[1].set_size(Cfg.lag_n + 1);
-        km.cluster_centers[1](0) = sqlite3_column_double(res, 12);
-        km.cluster_centers[1](1) = sqlite3_column_double(res, 13);
-        km.cluster_centers[1](2) = sqlite3_column_double(res, 14);
-        km.cluster_centers[1](3) = sqlite3_column_double(res, 15);
-        km.cluster_centers[1](4) = sqlite3_column_double(res, 16);
-        km.cluster_centers[1](5) = sqlite3_column_double(res, 17);
+            km.after = sqlite3_column_int(res, 1);
+            km.before = sqlite3_column_int(res, 2);
 
-        dim->km_contexts.push_back(km);
-    }
+            km.min_dist = sqlite3_column_double(res, 3);
+            km.max_dist = sqlite3_column_double(res, 4);
 
-    if (!dim->km_contexts.empty()) {
-        dim->ts = TRAINING_STATUS_TRAINED;
-    }
+            km.cluster_centers.resize(2);
 
-    spinlock_unlock(&dim->slock);
+            for (int c = 0; c != 2; c++) {
+                km.cluster_centers[c].set_size(Cfg.lag_n + 1);
+                for (int f = 0; f != 6; f++)
+                    km.cluster_centers[c](f) = sqlite3_column_double(res, 5 + c * 6 + f);
+            }
 
-    if (unlikely(rc != SQLITE_DONE))
-        error_report("Failed to load models, rc = %d", rc);
+            models[current].push_back(km);
+        }
+
+        if (unlikely(rc != SQLITE_DONE))
+            error_report("Failed to load models, rc = %d", rc);
+
+        for (size_t idx = 0; idx != used; idx++) {
+            if (models[idx].empty())
+                continue;
+
+            ml_dimension_t *dim = dims[idx];
+            spinlock_lock(&dim->slock);
+
+            // training may have produced a model in the meantime
+            if (dim->km_contexts.empty()) {
+                dim->km_contexts = std::move(models[idx]);
+                ml_kmeans_batch_update(&dim->km_batch, dim->km_contexts);
+                dim->ts = TRAINING_STATUS_TRAINED;
+            }
+
+            spinlock_unlock(&dim->slock);
+        }
+    }
 
     if (active_stmt)
         rc = sqlite3_reset(res);
@@ -718,14 +952,322 @@ bind_fail:
     rc = sqlite3_reset(res);
     if (unlikely(rc != SQLITE_OK))
         error_report("Failed to reset statement to load models, rc = %d", rc);
+    if (!active_stmt)
+        sqlite3_finalize(res);
     return 1;
 }
 
+static void
+ml_calculated_numbers_distribution(const calculated_number_t *cns, size_t n, calculated_number_t *mean, calculated_number_t *stddev)
+{
+    calculated_number_t sum = 0.0;
+    for (size_t idx = 0; idx != n; idx++)
+        sum += cns[idx];
+
+    *mean = n ? sum / n : 0.0;
+
+    calculated_number_t sum_sq = 0.0;
+    for (size_t idx = 0; idx != n; idx++) {
+        calculated_number_t d = cns[idx] - *mean;
+        sum_sq += d * d;
+    }
+
+    *stddev = n ? std::sqrt(sum_sq / n) : 0.0;
+}
+
+// the dimension has a model, trained recently enough that its training
+// window overlaps the new one, it has not been anomalous since, and the
+// mean and the standard deviation of its values have not moved by more than
+// the configured fraction of the standard deviation they had
+static bool
+ml_dimension_distribution_unchanged(const ml_dimension_t *dim, const ml_training_response_t &training_response,
+                                    calculated_number_t mean, calculated_number_t stddev)
+{
+    if (Cfg.min_distribution_shift == 0.0 || !dim->has_training_distribution)
+        return false;
+
+    if (dim->ts != TRAINING_STATUS_PENDING_WITH_MODEL || dim->km_contexts.empty())
+        return false;
+
+    if (dim->suppression_anomaly_counter)
+        return false;
+
+    time_t window = (time_t) Cfg.max_train_samples * dim->rd->rrdset->update_every;
+    if ((time_t) dim->km_contexts.back().before + window < training_response.query_before_t)
+        return false;
+
+    calculated_number_t scale = std::max(dim->training_stddev,
+        std::numeric_limits<calculated_number_t>::epsilon() * std::max(1.0, std::abs(dim->training_mean)));
+
+    return (std::abs(mean - dim->training_mean) / scale < Cfg.min_distribution_shift) &&
+           (std::abs(stddev - dim->training_stddev) / scale < Cfg.min_distribution_shift);
+}
+
+// the fewest tier 1 points a window is summarized from
+#define ML_TIER1_MIN_POINTS 30
+
+static bool
+ml_dimension_tier1_distribution(ml_dimension_t *dim, time_t after, time_t before, ml_tier1_distribution_t *d)
+{
+    if (!Cfg.tier1_check_after || before - after < (time_t) Cfg.tier1_check_after)
+        return false;
+
+    if (storage_tiers < 2 || !dim->rd->tiers[1].smh)
+        return false;
+
+    struct storage_engine_query_handle handle;
+    storage_engine_query_init(dim->rd->tiers[1].seb, dim->rd->tiers[1].smh, &handle,
+                              after, before, STORAGE_PRIORITY_BEST_EFFORT);
+
+    size_t points = 0;
+    calculated_number_t sum = 0.0, count = 0.0;
+    calculated_number_t sum_avg = 0.0, sum_avg_sq = 0.0, sum_range = 0.0;
+
+    while (!storage_engine_query_is_finished(&handle)) {
+        STORAGE_POINT sp = storage_engine_query_next_metric(&handle);
+        if (storage_point_is_unset(sp) || storage_point_is_gap(sp))
+            continue;
+
+        calculated_number_t avg = sp.sum / sp.count;
+
+        sum += sp.sum;
+        count += sp.count;
+        sum_avg += avg;
+        sum_avg_sq += avg * avg;
+        sum_range += sp.max - sp.min;
+        points++;
+    }
+    storage_engine_query_finalize(&handle);
+
+    global_statistics_ml_query_completed(/* points_read */ points);
+
+    if (points < ML_TIER1_MIN_POINTS)
+        return false;
+
+    calculated_number_t mean_avg = sum_avg / points;
+
+    d->mean = sum / count;
+    d->stddev = std::sqrt(std::max(0.0, sum_avg_sq / points - mean_avg * mean_avg));
+    d->range = sum_range / points;
+    return true;
+}
+
+// the same conditions ml_dimension_distribution_unchanged() has, checked on
+// the tier 1 summaries of the windows, before reading their tier 0 data
+static bool
+ml_dimension_tier1_distribution_unchanged(const ml_dimension_t *dim, const ml_training_response_t &training_response,
+                                          const ml_tier1_distribution_t &d)
+{
+    if (Cfg.min_distribution_shift == 0.0 || !dim->has_tier1_distribution)
+        return false;
+
+    if (dim->ts != TRAINING_STATUS_PENDING_WITH_MODEL || dim->km_contexts.empty())
+        return false;
+
+    if (dim->suppression_anomaly_counter)
+        return false;
+
+    time_t window = (time_t) Cfg.max_train_samples * dim->rd->rrdset->update_every;
+    if ((time_t) dim->km_contexts.back().before + window < training_response.query_before_t)
+        return false;
+
+    const ml_tier1_distribution_t &t = dim->tier1_distribution;
+    calculated_number_t epsilon = std::numeric_limits<calculated_number_t>::epsilon() * std::max(1.0, std::abs(t.mean));
+    calculated_number_t scale = std::max(t.stddev, epsilon);
+    calculated_number_t range_scale = std::max(t.range, epsilon);
+
+    return (std::abs(d.mean - t.mean) / scale < Cfg.min_distribution_shift) &&
+           (std::abs(d.stddev - t.stddev) / scale < Cfg.min_distribution_shift) &&
+           (std::abs(d.range - t.range) / range_scale < Cfg.min_distribution_shift);
+}
+
+/*
+ * Shared models
+ *
+ * Dimensions with the same context, id and update every (e.g. the same
+ * container on many children of a parent) usually have near identical data.
+ * The last model trained for them is kept here and used by the others, when
+ * the distribution of their data is within the distribution shift allowed for
+ * retraining, instead of running k-means again for each of them.
+*/
+
+static std::string
+ml_shared_model_key(const ml_dimension_t *dim)
+{
+    char buf[32];
+    snprintfz(buf, sizeof(buf), "|%d", dim->rd->rrdset->update_every);
+
+    std::string key = rrdset_context(dim->rd->rrdset);
+    key += '|';
+    key += rrddim_id(dim->rd);
+    key += buf;
+    return key;
+}
+
+static inline bool
+ml_shared_model_is_fresh(const ml_shared_model_t &sm, const ml_dimension_t *dim, const ml_training_response_t &training_response)
+{
+    time_t period = (time_t) Cfg.train_every * dim->rd->rrdset->update_every;
+    return std::abs((long long) (training_response.query_before_t - sm.trained_at)) <= (long long) period;
+}
+
+static bool
+ml_shared_model_get(const ml_dimension_t *dim, const ml_training_response_t &training_response,
+                    calculated_number_t mean, calculated_number_t stddev, ml_kmeans_t *kmeans)
+{
+    if (Cfg.min_distribution_shift == 0.0)
+        return false;
+
+    std::string key = ml_shared_model_key(dim);
+    bool found = false;
+
+    netdata_mutex_lock(&shared_models_mutex);
+
+    auto it = shared_models.find(key);
+    if (it != shared_models.end() && ml_shared_model_is_fresh(it->second, dim, training_response)) {
+        const ml_shared_model_t &sm = it->second;
+
+        calculated_number_t scale = std::max(sm.stddev,
+            std::numeric_limits<calculated_number_t>::epsilon() * std::max(1.0, std::abs(sm.mean)));
+
+        if ((std::abs(mean - sm.mean) / scale < Cfg.min_distribution_shift) &&
+            (std::abs(stddev - sm.stddev) / scale < Cfg.min_distribution_shift)) {
+            *kmeans = sm.kmeans;
+            found = true;
+        }
+    }
+
+    netdata_mutex_unlock(&shared_models_mutex);
+
+    if (found) {
+        kmeans->after = (uint32_t) training_response.query_after_t;
+        kmeans->before = (uint32_t) training_response.query_before_t;
+    }
+
+    return found;
+}
+
+static void
+ml_shared_model_set(const ml_dimension_t *dim, const ml_training_response_t &training_response,
+                    calculated_number_t mean, calculated_number_t stddev, const ml_kmeans_t &kmeans)
+{
+    std::string key = ml_shared_model_key(dim);
+
+    netdata_mutex_lock(&shared_models_mutex);
+
+    // keep the model being shared until it gets stale
+    auto it = shared_models.find(key);
+    if (it == shared_models.end() || !ml_shared_model_is_fresh(it->second, dim, training_response)) {
+        ml_shared_model_t &sm = shared_models[key];
+        sm.kmeans = kmeans;
+        sm.mean = mean;
+        sm.stddev = stddev;
+        sm.trained_at = training_response.query_before_t;
+    }
+
+    netdata_mutex_unlock(&shared_models_mutex);
+}
+
+// updates the last model of the dimension with the samples collected since it
+// was trained, and saves it again in place of the previous version
+static enum ml_training_result
+ml_dimension_train_model_incrementally(ml_training_thread_t *training_thread, ml_dimension_t *dim,
+                                       const ml_training_response_t &training_response)
+{
+    worker_is_busy(WORKER_TRAIN_KMEANS);
+
+    memcpy(training_thread->scratch_training_cns, training_thread->training_cns,
+           training_response.total_values * sizeof(calculated_number_t));
+
+    ml_features_t features = {
+        Cfg.diff_n, Cfg.smooth_n, Cfg.lag_n,
+        training_thread->scratch_training_cns, training_response.total_values,
+        training_thread->training_cns, training_response.total_values,
+        training_thread->training_samples
+    };
+    ml_features_preprocess(&features);
+
+    worker_is_busy(WORKER_TRAIN_UPDATE_MODELS);
+    spinlock_lock(&dim->slock);
+
+    ml_kmeans_t *km = &dim->km_contexts.back();
+    ml_kmeans_update(km, &features, training_response.query_before_t);
+    ml_kmeans_batch_update(&dim->km_batch, dim->km_contexts);
+
+    dim->mt = METRIC_TYPE_CONSTANT;
+    dim->ts = TRAINING_STATUS_TRAINED;
+
+    dim->suppression_anomaly_counter = 0;
+    dim->suppression_window_counter = 0;
+
+    dim->tr = training_response;
+    dim->last_training_time = rrddim_last_entry_s(dim->rd);
+
+    // the model keeps its 'after', so it replaces its previous version in the database
+    ml_model_info_t model_info;
+    uuid_copy(model_info.metric_uuid, dim->rd->metric_uuid);
+    model_info.kmeans = *km;
+    training_thread->pending_model_info.push_back(model_info);
+
+    spinlock_unlock(&dim->slock);
+
+    return TRAINING_RESULT_INCREMENTAL;
+}
+
 static enum ml_training_result
 ml_dimension_train_model(ml_training_thread_t *training_thread, ml_dimension_t *dim, const ml_training_request_t &training_request)
 {
     worker_is_busy(WORKER_TRAIN_QUERY);
-    auto P = ml_dimension_calculated_numbers(training_thread, dim, training_request);
+    // Decide if the last model can be updated with the new samples only
+    time_t incremental_after = 0;
+    if (Cfg.incremental_training) {
+        spinlock_lock(&dim->slock);
+
+        time_t update_every = dim->rd->rrdset->update_every;
+        if (dim->ts == TRAINING_STATUS_PENDING_WITH_MODEL && !dim->km_contexts.empty() && dim->last_full_training_time &&
+            dim->last_full_training_time + (time_t) Cfg.full_train_every * update_every > training_request.last_entry_on_request)
+            incremental_after = (time_t) dim->km_contexts.back().before -
+                                (time_t) (Cfg.diff_n + Cfg.smooth_n + Cfg.lag_n) * update_every;
+
+        spinlock_unlock(&dim->slock);
+    }
+
+    // keep the last model, when tier 1 shows the data have not changed since
+    // it was trained, without reading the tier 0 data of the window
+    ml_tier1_distribution_t tier1_distribution = {};
+    bool has_tier1_distribution = false;
+    if (!incremental_after && Cfg.tier1_check_after) {
+        ml_training_response_t window = {};
+        ml_dimension_training_window(dim, &window);
+
+        has_tier1_distribution = ml_dimension_tier1_distribution(dim, window.query_after_t, window.query_before_t, &tier1_distribution);
+        if (has_tier1_distribution) {
+            spinlock_lock(&dim->slock);
+
+            if (ml_dimension_tier1_distribution_unchanged(dim, window, tier1_distribution)) {
+                window.request_time = training_request.request_time;
+                window.first_entry_on_request = training_request.first_entry_on_request;
+                window.last_entry_on_request = training_request.last_entry_on_request;
+                window.result = TRAINING_RESULT_OK;
+
+                dim->mt = METRIC_TYPE_CONSTANT;
+                dim->ts = TRAINING_STATUS_TRAINED;
+
+                dim->suppression_anomaly_counter = 0;
+                dim->suppression_window_counter = 0;
+
+                dim->tr = window;
+                dim->last_training_time = rrddim_last_entry_s(dim->rd);
+
+                spinlock_unlock(&dim->slock);
+                return TRAINING_RESULT_DISTRIBUTION_UNCHANGED;
+            }
+
+            spinlock_unlock(&dim->slock);
+        }
+    }
+
+    auto P = ml_dimension_calculated_numbers(training_thread, dim, training_request, incremental_after);
     ml_training_response_t training_response = P.second;
 
     if (training_response.result != TRAINING_RESULT_OK) {
@@ -756,9 +1298,40 @@ ml_dimension_train_model(ml_training_thread_t *training_thread, ml_dimension_t *
         return result;
     }
 
+    if (incremental_after)
+        return ml_dimension_train_model_incrementally(training_thread, dim, training_response);
+
+    // keep the last model, when the data have not changed since it was trained
+    calculated_number_t training_mean, training_stddev;
+    ml_calculated_numbers_distribution(training_thread->training_cns, training_response.total_values,
+                                       &training_mean, &training_stddev);
+    {
+        spinlock_lock(&dim->slock);
+
+        if (ml_dimension_distribution_unchanged(dim, training_response, training_mean, training_stddev)) {
+            dim->mt = METRIC_TYPE_CONSTANT;
+            dim->ts = TRAINING_STATUS_TRAINED;
+
+            dim->suppression_anomaly_counter = 0;
+            dim->suppression_window_counter = 0;
+
+            dim->tr = training_response;
+            dim->last_training_time = rrddim_last_entry_s(dim->rd);
+
+            spinlock_unlock(&dim->slock);
+            return TRAINING_RESULT_DISTRIBUTION_UNCHANGED;
+        }
+
+        spinlock_unlock(&dim->slock);
+    }
+
+    // use the model of a similar dimension, when there is one
+    bool shared_model = Cfg.share_models &&
+        ml_shared_model_get(dim, training_response, training_mean, training_stddev, &dim->kmeans);
+
     // compute kmeans
     worker_is_busy(WORKER_TRAIN_KMEANS);
-    {
+    if (!shared_model) {
         memcpy(training_thread->scratch_training_cns, training_thread->training_cns,
                training_response.total_values * sizeof(calculated_number_t));
 
@@ -772,6 +1345,9 @@ ml_dimension_train_model(ml_training_thread_t *training_thread, ml_dimension_t *
 
         ml_kmeans_init(&dim->kmeans);
         ml_kmeans_train(&dim->kmeans, &features, training_response.query_after_t, training_response.query_before_t);
+
+        if (Cfg.share_models)
+            ml_shared_model_set(dim, training_response, training_mean, training_stddev, dim->kmeans);
     }
 
     // update models
@@ -801,6 +1377,8 @@ ml_dimension_train_model(ml_training_thread_t *training_thread, ml_dimension_t *
             }
         }
 
+        ml_kmeans_batch_update(&dim->km_batch, dim->km_contexts);
+
         dim->mt = METRIC_TYPE_CONSTANT;
         dim->ts = TRAINING_STATUS_TRAINED;
 
@@ -810,16 +1388,28 @@ ml_dimension_train_model(ml_training_thread_t *training_thread, ml_dimension_t *
         dim->tr = training_response;
         dim->last_training_time = rrddim_last_entry_s(dim->rd);
 
-        // Add the newly generated model to the list of pending models to flush
-        ml_model_info_t model_info;
-        uuid_copy(model_info.metric_uuid, dim->rd->metric_uuid);
-        model_info.kmeans = dim->km_contexts.back();
-        training_thread->pending_model_info.push_back(model_info);
+        dim->last_full_training_time = dim->last_training_time;
+
+        dim->has_training_distribution = true;
+        dim->training_mean = training_mean;
+        dim->training_stddev = training_stddev;
+
+        dim->has_tier1_distribution = has_tier1_distribution;
+        dim->tier1_distribution = tier1_distribution;
+
+        // Add the newly generated model to the list of pending models to flush,
+        // shared models are saved only by the dimension that trained them
+        if (!shared_model) {
+            ml_model_info_t model_info;
+            uuid_copy(model_info.metric_uuid, dim->rd->metric_uuid);
+            model_info.kmeans = dim->km_contexts.back();
+            training_thread->pending_model_info.push_back(model_info);
+        }
 
         spinlock_unlock(&dim->slock);
     }
 
-    return training_response.result;
+    return shared_model ? TRAINING_RESULT_SHARED_MODEL : training_response.result;
 }
 
 static void
@@ -862,6 +1452,16 @@ ml_dimension_schedule_for_training(ml_dimension_t *dim, time_t curr_time)
         req.first_entry_on_request = rrddim_first_entry_s(dim->rd);
         req.last_entry_on_request = rrddim_last_entry_s(dim->rd);
 
+        // staleness is the number of training periods since the last training,
+        // so dimensions without a model go first, and dimensions that were
+        // anomalous since their last training go before equally stale ones
+        double period = (double) Cfg.train_every * dim->rd->rrdset->update_every;
+        double staleness = (double) (curr_time - dim->last_training_time) / period;
+        double anomaly_rate = dim->suppression_window_counter ?
+            (double) dim->suppression_anomaly_counter / (double) dim->suppression_window_counter : 0.0;
+        req.priority = staleness * (1.0 + anomaly_rate);
+        req.sequence = 0;
+
         ml_host_t *host = (ml_host_t *) dim->rd->rrdset->rrdhost->ml_host;
         ml_queue_push(host->training_queue, req);
     }
@@ -946,10 +1546,16 @@ ml_dimension_predict(ml_dimension_t *dim, time_t curr_time, calculated_number_t
     size_t sum = 0;
     size_t models_consulted = 0;
 
-    for (const auto &km_ctx : dim->km_contexts) {
+    calculated_number_t sample[ML_FEATURES_MAX];
+    calculated_number_t anomaly_scores[ML_MODELS_MAX];
+
+    ml_kmeans_sample_flatten(features.preprocessed_features[0], sample);
+    ml_kmeans_batch_anomaly_scores(&dim->km_batch, sample, anomaly_scores);
+
+    for (size_t m = 0; m != dim->km_batch.models; m++) {
         models_consulted++;
 
-        calculated_number_t anomaly_score = ml_kmeans_anomaly_score(&km_ctx, features.preprocessed_features[0]);
+        calculated_number_t anomaly_score = anomaly_scores[m];
         if (anomaly_score == std::numeric_limits<calculated_number_t>::quiet_NaN())
             continue;
 
@@ -1039,6 +1645,58 @@ ml_chart_update_dimension(ml_chart_t *chart, ml_dimension_t *dim, bool is_anomal
     }
 }
 
+static inline void
+ml_machine_learning_stats_add_delta(ml_machine_learning_stats_t *dst,
+                                    const ml_machine_learning_stats_t &now,
+                                    const ml_machine_learning_stats_t &before)
+{
+    // unsigned arithmetic, the totals always include what is subtracted
+    dst->num_machine_learning_status_enabled += now.num_machine_learning_status_enabled - before.num_machine_learning_status_enabled;
+    dst->num_machine_learning_status_disabled_sp += now.num_machine_learning_status_disabled_sp - before.num_machine_learning_status_disabled_sp;
+
+    dst->num_metric_type_constant += now.num_metric_type_constant - before.num_metric_type_constant;
+    dst->num_metric_type_variable += now.num_metric_type_variable - before.num_metric_type_variable;
+
+    dst->num_training_status_untrained += now.num_training_status_untrained - before.num_training_status_untrained;
+    dst->num_training_status_pending_without_model += now.num_training_status_pending_without_model - before.num_training_status_pending_without_model;
+    dst->num_training_status_trained += now.num_training_status_trained - before.num_training_status_trained;
+    dst->num_training_status_pending_with_model += now.num_training_status_pending_with_model - before.num_training_status_pending_with_model;
+    dst->num_training_status_silenced += now.num_training_status_silenced - before.num_training_status_silenced;
+
+    dst->num_anomalous_dimensions += now.num_anomalous_dimensions - before.num_anomalous_dimensions;
+    dst->num_normal_dimensions += now.num_normal_dimensions - before.num_normal_dimensions;
+}
+
+// Replace the stats the chart contributes to the totals of its host and its
+// type. Charts call this when they finish an update, so the detection thread
+// does not have to walk all the charts of all the hosts every second.
+static void
+ml_chart_publish_stats(ml_host_t *host, ml_chart_t *chart, const ml_machine_learning_stats_t &mls)
+{
+    if (!memcmp(&mls, &chart->published_mls, sizeof(mls)))
+        return;
+
+    spinlock_lock(&host->stats_spinlock);
+
+    ml_machine_learning_stats_add_delta(&host->published_mls, mls, chart->published_mls);
+
+    auto &um = host->type_anomaly_rate;
+    auto it = um.find(chart->rs->parts.type);
+    if (it == um.end())
+        it = um.emplace(chart->rs->parts.type, ml_type_anomaly_rate_t {
+            .rd = NULL,
+            .normal_dimensions = 0,
+            .anomalous_dimensions = 0
+        }).first;
+
+    it->second.anomalous_dimensions += mls.num_anomalous_dimensions - chart->published_mls.num_anomalous_dimensions;
+    it->second.normal_dimensions += mls.num_normal_dimensions - chart->published_mls.num_normal_dimensions;
+
+    chart->published_mls = mls;
+
+    spinlock_unlock(&host->stats_spinlock);
+}
+
 /*
  * Host detection & training functions
 */
@@ -1060,56 +1718,11 @@ ml_host_detect_once(ml_host_t *host)
         netdata_mutex_lock(&host->mutex);
 
         /*
-         * prediction/detection stats
+         * prediction/detection stats, as published by the charts
         */
-        void *rsp = NULL;
-        rrdset_foreach_read(rsp, host->rh) {
-            RRDSET *rs = static_cast<RRDSET *>(rsp);
-
-            ml_chart_t *chart = (ml_chart_t *) rs->ml_chart;
-            if (!chart)
-                continue;
-
-            if (!ml_chart_is_available_for_ml(chart))
-                continue;
-
-            ml_machine_learning_stats_t chart_mls = chart->mls;
-
-            host->mls.num_machine_learning_status_enabled += chart_mls.num_machine_learning_status_enabled;
-            host->mls.num_machine_learning_status_disabled_sp += chart_mls.num_machine_learning_status_disabled_sp;
-
-            host->mls.num_metric_type_constant += chart_mls.num_metric_type_constant;
-            host->mls.num_metric_type_variable += chart_mls.num_metric_type_variable;
-
-            host->mls.num_training_status_untrained += chart_mls.num_training_status_untrained;
-            host->mls.num_training_status_pending_without_model += chart_mls.num_training_status_pending_without_model;
-            host->mls.num_training_status_trained += chart_mls.num_training_status_trained;
-            host->mls.num_training_status_pending_with_model += chart_mls.num_training_status_pending_with_model;
-            host->mls.num_training_status_silenced += chart_mls.num_training_status_silenced;
-
-            host->mls.num_anomalous_dimensions += chart_mls.num_anomalous_dimensions;
-            host->mls.num_normal_dimensions += chart_mls.num_normal_dimensions;
-
-            if (spinlock_trylock_cancelable(&host->type_anomaly_rate_spinlock))
-            {
-                STRING *key = rs->parts.type;
-                auto &um = host->type_anomaly_rate;
-                auto it = um.find(key);
-                if (it == um.end()) {
-                    um[key] = ml_type_anomaly_rate_t {
-                        .rd = NULL,
-                        .normal_dimensions = 0,
-                        .anomalous_dimensions = 0
-                    };
-                    it = um.find(key);
-                }
-
-                it->second.anomalous_dimensions += chart_mls.num_anomalous_dimensions;
-                it->second.normal_dimensions += chart_mls.num_normal_dimensions;
-                spinlock_unlock_cancelable(&host->type_anomaly_rate_spinlock);
-            }
-        }
-        rrdset_foreach_done(rsp);
+        spinlock_lock_cancelable(&host->stats_spinlock);
+        host->mls = host->published_mls;
+        spinlock_unlock_cancelable(&host->stats_spinlock);
 
         host->host_anomaly_rate = 0.0;
         size_t NumActiveDimensions = host->mls.num_anomalous_dimensions + host->mls.num_normal_dimensions;
@@ -1121,15 +1734,6 @@ ml_host_detect_once(ml_host_t *host)
         netdata_mutex_unlock(&host->mutex);
     } else {
         host->host_anomaly_rate = 0.0;
-
-        auto &um = host->type_anomaly_rate;
-        for (auto &entry: um) {
-            entry.second = ml_type_anomaly_rate_t {
-                .rd = NULL,
-                .normal_dimensions = 0,
-                .anomalous_dimensions = 0
-            };
-        }
     }
 
     worker_is_busy(WORKER_JOB_DETECTION_DIM_CHART);
@@ -1263,6 +1867,9 @@ ml_detect_main(void *arg)
                     training_stats.training_result_not_enough_collected_values = 0;
                     training_stats.training_result_null_acquired_dimension = 0;
                     training_stats.training_result_chart_under_replication = 0;
+                    training_stats.training_result_distribution_unchanged = 0;
+                    training_stats.training_result_shared_model = 0;
+                    training_stats.training_result_incremental = 0;
                 }
 
                 ml_update_training_statistics_chart(training_thread, training_stats);
@@ -1318,7 +1925,8 @@ void ml_host_new(RRDHOST *rh)
     host->training_queue = Cfg.training_threads[times_called++ % Cfg.num_training_threads].training_queue;
 
     netdata_mutex_init(&host->mutex);
-    spinlock_init(&host->type_anomaly_rate_spinlock);
+    spinlock_init(&host->stats_spinlock);
+    host->published_mls = ml_machine_learning_stats_t();
 
     host->ml_running = true;
     rh->ml_host = (rrd_ml_host_t *) host;
@@ -1350,9 +1958,16 @@ void ml_host_stop(RRDHOST *rh) {
         return;
 
     netdata_mutex_lock(&host->mutex);
+    spinlock_lock(&host->stats_spinlock);
 
     // reset host stats
     host->mls = ml_machine_learning_stats_t();
+    host->published_mls = ml_machine_learning_stats_t();
+
+    for (auto &entry : host->type_anomaly_rate) {
+        entry.second.normal_dimensions = 0;
+        entry.second.anomalous_dimensions = 0;
+    }
 
     // reset charts/dims
     void *rsp = NULL;
@@ -1365,6 +1980,7 @@ void ml_host_stop(RRDHOST *rh) {
 
         // reset chart
         chart->mls = ml_machine_learning_stats_t();
+        chart->published_mls = ml_machine_learning_stats_t();
 
         void *rdp = NULL;
         rrddim_foreach_read(rdp, rs) {
@@ -1383,6 +1999,7 @@ void ml_host_stop(RRDHOST *rh) {
             dim->mt = METRIC_TYPE_CONSTANT;
             dim->ts = TRAINING_STATUS_UNTRAINED;
             dim->last_training_time = 0;
+            dim->last_full_training_time = 0;
             dim->suppression_anomaly_counter = 0;
             dim->suppression_window_counter = 0;
             dim->cns.clear();
@@ -1395,6 +2012,7 @@ void ml_host_stop(RRDHOST *rh) {
     }
     rrdset_foreach_done(rsp);
 
+    spinlock_unlock(&host->stats_spinlock);
     netdata_mutex_unlock(&host->mutex);
 
     host->ml_running = false;
@@ -1499,6 +2117,7 @@ void ml_chart_new(RRDSET *rs)
 
     chart->rs = rs;
     chart->mls = ml_machine_learning_stats_t();
+    chart->published_mls = ml_machine_learning_stats_t();
 
     rs->ml_chart = (rrd_ml_chart_t *) chart;
 }
@@ -1510,6 +2129,8 @@ void ml_chart_delete(RRDSET *rs)
         return;
 
     ml_chart_t *chart = (ml_chart_t *) rs->ml_chart;
+    if (chart)
+        ml_chart_publish_stats(host, chart, ml_machine_learning_stats_t());
 
     delete chart;
     rs->ml_chart = NULL;
@@ -1530,6 +2151,24 @@ void ml_chart_update_end(RRDSET *rs)
     ml_chart_t *chart = (ml_chart_t *) rs->ml_chart;
     if (!chart)
         return;
+
+    ml_host_t *host = (ml_host_t *) rs->rrdhost->ml_host;
+
+    if (ml_chart_is_available_for_ml(chart))
+        ml_chart_publish_stats(host, chart, chart->mls);
+    else
+        ml_chart_publish_stats(host, chart, ml_machine_learning_stats_t());
+}
+
+void ml_chart_obsolete(RRDSET *rs)
+{
+    ml_chart_t *chart = (ml_chart_t *) rs->ml_chart;
+    if (!chart)
+        return;
+
+    // obsolete charts are not collected anymore, they stop counting now
+    ml_host_t *host = (ml_host_t *) rs->rrdhost->ml_host;
+    ml_chart_publish_stats(host, chart, ml_machine_learning_stats_t());
 }
 
 void ml_dimension_new(RRDDIM *rd)
@@ -1548,6 +2187,15 @@ void ml_dimension_new(RRDDIM *rd)
     dim->suppression_anomaly_counter = 0;
     dim->suppression_window_counter = 0;
 
+    dim->last_full_training_time = 0;
+
+    dim->has_training_distribution = false;
+    dim->training_mean = 0.0;
+    dim->training_stddev = 0.0;
+
+    dim->has_tier1_distribution = false;
+    dim->tier1_distribution = {};
+
     ml_kmeans_init(&dim->kmeans);
 
     if (simple_pattern_matches(Cfg.sp_charts_to_skip, rrdset_name(rd->rrdset)))
@@ -1702,6 +2350,13 @@ static void *ml_train_main(void *arg) {
         if (consumed_ut < allotted_ut)
             remaining_ut = allotted_ut - consumed_ut;
 
+        // rest long enough to use at most the configured share of a cpu
+        if (Cfg.training_cpu_percent < 100) {
+            usec_t budget_ut = consumed_ut * (100 - Cfg.training_cpu_percent) / Cfg.training_cpu_percent;
+            if (remaining_ut < budget_ut)
+                remaining_ut = budget_ut;
+        }
+
         if (Cfg.enable_statistics_charts) {
             worker_is_busy(WORKER_TRAIN_UPDATE_HOST);
 
@@ -1730,6 +2385,15 @@ static void *ml_train_main(void *arg) {
                 case TRAINING_RESULT_CHART_UNDER_REPLICATION:
                     training_thread->training_stats.training_result_chart_under_replication += 1;
                     break;
+                case TRAINING_RESULT_DISTRIBUTION_UNCHANGED:
+                    training_thread->training_stats.training_result_distribution_unchanged += 1;
+                    break;
+                case TRAINING_RESULT_SHARED_MODEL:
+                    training_thread->training_stats.training_result_shared_model += 1;
+                    break;
+                case TRAINING_RESULT_INCREMENTAL:
+                    training_thread->training_stats.training_result_incremental += 1;
+                    break;
             }
 
             netdata_mutex_unlock(&training_thread->nd_mutex);
@@ -35,12 +35,16 @@ void ml_chart_new(RRDSET *rs);
 void ml_chart_delete(RRDSET *rs);
 bool ml_chart_update_begin(RRDSET *rs);
 void ml_chart_update_end(RRDSET *rs);
+void ml_chart_obsolete(RRDSET *rs);
 
 void ml_dimension_new(RRDDIM *rd);
 void ml_dimension_delete(RRDDIM *rd);
 bool ml_dimension_is_anomalous(RRDDIM *rd, time_t curr_time, double value, bool exists);
 
-int ml_dimension_load_models(RRDDIM *rd, sqlite3_stmt **stmt);
+// the most dimensions whose models are loaded with one query
+#define ML_MODELS_LOAD_BATCH_SIZE 32
+
+int ml_dimensions_load_models(RRDDIM **rds, size_t entries, sqlite3_stmt **stmt);
 
 void ml_update_global_statistics_charts(uint64_t models_consulted);
 
@@ -57,6 +57,32 @@ static inline bool plugin_is_running(struct plugind *cd) {
     return ret;
 }
 
+// creates the shared memory ring of the plugin, and prepends its filename to the command
+static const char *pluginsd_shm_create(struct plugind *cd, char *cmd, size_t cmd_size) {
+#if defined(OS_LINUX)
+    if(cd->shm && !cd->unsafe.shm && access("/dev/shm", W_OK) == 0) {
+        char filename[FILENAME_MAX + 1];
+        snprintfz(filename, FILENAME_MAX, "/dev/shm/netdata-%d-%s", getpid(), cd->filename);
+
+        cd->unsafe.shm = shm_ring_create(filename, SHM_RING_RECORDS_DEFAULT);
+        if(cd->unsafe.shm) {
+            snprintfz(cmd, cmd_size, SHM_RING_ENV "='%s' %s", filename, cd->cmd);
+            return cmd;
+        }
+    }
+#else
+    (void)cmd;
+    (void)cmd_size;
+#endif
+
+    return cd->cmd;
+}
+
+static void pluginsd_shm_destroy(struct plugind *cd) {
+    shm_ring_destroy(cd->unsafe.shm);
+    cd->unsafe.shm = NULL;
+}
+
 static void pluginsd_worker_thread_cleanup(void *pptr) {
     struct plugind *cd = CLEANUP_FUNCTION_GET_PTR(pptr);
     if(!cd) return;
@@ -77,6 +103,8 @@ static void pluginsd_worker_thread_cleanup(void *pptr) {
 
     if (pi)
         spawn_popen_kill(pi);
+
+    pluginsd_shm_destroy(cd);
 }
 
 #define SERIAL_FAILURES_THRESHOLD 10
@@ -152,10 +180,14 @@ static void *pluginsd_worker_thread(void *arg) {
     size_t count = 0;
 
     while(service_running(SERVICE_COLLECTORS)) {
-        cd->unsafe.pi = spawn_popen_run(cd->cmd);
+        char shm_cmd[PLUGINSD_CMD_MAX + FILENAME_MAX + 50];
+        const char *cmd = pluginsd_shm_create(cd, shm_cmd, sizeof(shm_cmd));
+
+        cd->unsafe.pi = spawn_popen_run(cmd);
         if(!cd->unsafe.pi) {
             netdata_log_error("PLUGINSD: 'host:%s', cannot popen(\"%s\", \"r\").",
-                              rrdhost_hostname(cd->host), cd->cmd);
+                              rrdhost_hostname(cd->host), cmd);
+            pluginsd_shm_destroy(cd);
             break;
         }
         cd->unsafe.pid = spawn_popen_pid(cd->unsafe.pi);
@@ -192,6 +224,7 @@ static void *pluginsd_worker_thread(void *arg) {
 
         int worker_ret_code = spawn_popen_kill(cd->unsafe.pi);
         cd->unsafe.pi = NULL;
+        pluginsd_shm_destroy(cd);
 
         if(likely(worker_ret_code == 0))
             pluginsd_worker_thread_handle_success(cd);
@@ -266,6 +299,8 @@ void *pluginsd_main(void *ptr) {
     if (scan_frequency < 1)
         scan_frequency = 1;
 
+    bool shm_transport = config_get_boolean(CONFIG_SECTION_PLUGINS, "shared memory transport", CONFIG_BOOLEAN_NO);
+
     // disable some plugins by default
     config_get_boolean(CONFIG_SECTION_PLUGINS, "slabinfo", CONFIG_BOOLEAN_NO);
     // it crashes (both threads) on Alpine after we made it multi-threaded
@@ -344,6 +379,7 @@ void *pluginsd_main(void *ptr) {
                     cd->unsafe.running = false;
 
                     cd->update_every = (int)config_get_duration_seconds(cd->id, "update every", localhost->rrd_update_every);
+                    cd->shm = config_get_boolean(cd->id, "shared memory transport", shm_transport);
                     cd->started_t = now_realtime_sec();
 
                     char *def = "";
@@ -26,6 +26,7 @@ struct plugind {
 
     RRDHOST *host;                      // the host the plugin collects data for
     int update_every;                   // the plugin default data collection frequency
+    bool shm;                           // offer the shared memory transport to the plugin
 
     struct {
         SPINLOCK spinlock;
@@ -33,6 +34,7 @@ struct plugind {
         bool enabled;                   // if this is enabled or not
         ND_THREAD *thread;
         POPEN_INSTANCE *pi;
+        SHM_RING *shm;                  // the shared memory ring of the running plugin
         pid_t pid;
     } unsafe;
 
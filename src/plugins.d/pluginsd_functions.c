@@ -112,6 +112,8 @@ void pluginsd_inflight_functions_init(PARSER *parser) {
 
 void pluginsd_inflight_functions_cleanup(PARSER *parser) {
     dictionary_destroy(parser->inflight.functions);
+    buffer_free(parser->inflight.partial);
+    parser->inflight.partial = NULL;
 }
 
 // ----------------------------------------------------------------------------
@@ -224,6 +226,10 @@ int pluginsd_function_execute_cb(struct rrd_function_execute *rfe, void *data) {
                     .cb = rfe->result.cb,
                     .data = rfe->result.data,
             },
+            .partial = {
+                    .cb = rfe->partial.cb,
+                    .data = rfe->partial.data,
+            },
             .progress = {
                     .cb = rfe->progress.cb,
                     .data = rfe->progress.data,
@@ -336,6 +342,22 @@ static void pluginsd_function_result_end(struct parser *parser, void *action_dat
     parser->user.data_collections_count++;
 }
 
+static void pluginsd_function_result_partial_end(struct parser *parser, void *action_data) {
+    STRING *key = action_data;
+
+    // when the caller does not forward partial results, they have been accumulated into its result buffer
+    if(key && parser->defer.response && parser->defer.response == parser->inflight.partial) {
+        struct inflight_function *pf = dictionary_get(parser->inflight.functions, string2str(key));
+        if(pf && pf->partial.cb)
+            pf->partial.cb(parser->inflight.partial, pf->code, pf->partial.data);
+
+        buffer_flush(parser->inflight.partial);
+    }
+    string_freez(key);
+
+    parser->user.data_collections_count++;
+}
+
 static inline struct inflight_function *inflight_function_find(PARSER *parser, const char *transaction) {
     struct inflight_function *pf = NULL;
 
@@ -353,6 +375,7 @@ PARSER_RC pluginsd_function_result_begin(char **words, size_t num_words, PARSER
     char *status = get_word(words, num_words, 2);
     char *format = get_word(words, num_words, 3);
     char *expires = get_word(words, num_words, 4);
+    char *partial_str = get_word(words, num_words, 5);
 
     if (unlikely(!transaction || !*transaction || !status || !*status || !format || !*format || !expires || !*expires)) {
         netdata_log_error("got a " PLUGINSD_KEYWORD_FUNCTION_RESULT_BEGIN " without providing the required data (key = '%s', status = '%s', format = '%s', expires = '%s')."
@@ -369,23 +392,38 @@ PARSER_RC pluginsd_function_result_begin(char **words, size_t num_words, PARSER
 
     time_t expiration = (expires && *expires) ? str2l(expires) : 0;
 
+    // a partial result is followed by more, until one without this flag completes the transaction
+    bool partial = partial_str && strcmp(partial_str, PLUGINSD_FUNCTION_RESULT_PARTIAL) == 0;
+
+    BUFFER *wb = NULL;
     struct inflight_function *pf = inflight_function_find(parser, transaction);
     if(pf) {
+        wb = pf->result_body_wb;
+
+        if(partial && pf->partial.cb) {
+            // the caller forwards partial results, so we do not accumulate them
+            if(!parser->inflight.partial)
+                parser->inflight.partial = buffer_create(PLUGINSD_LINE_MAX, &netdata_buffers_statistics.buffers_functions);
+
+            wb = parser->inflight.partial;
+            buffer_flush(wb);
+        }
+
         if(format && *format)
-            pf->result_body_wb->content_type = content_type_string2id(format);
+            wb->content_type = pf->result_body_wb->content_type = content_type_string2id(format);
 
         pf->code = code;
 
-        pf->result_body_wb->expires = expiration;
+        wb->expires = expiration;
         if(expiration <= now_realtime_sec())
-            buffer_no_cacheable(pf->result_body_wb);
+            buffer_no_cacheable(wb);
         else
-            buffer_cacheable(pf->result_body_wb);
+            buffer_cacheable(wb);
     }
 
-    parser->defer.response = (pf) ? pf->result_body_wb : NULL;
+    parser->defer.response = wb;
     parser->defer.end_keyword = PLUGINSD_KEYWORD_FUNCTION_RESULT_END;
-    parser->defer.action = pluginsd_function_result_end;
+    parser->defer.action = partial ? pluginsd_function_result_partial_end : pluginsd_function_result_end;
     parser->defer.action_data = string_strdupz(transaction); // it is ok is key is NULL
     parser->flags |= PARSER_DEFER_UNTIL_KEYWORD;
 
@@ -29,6 +29,11 @@ struct inflight_function {
         void *data;
     } result;
 
+    struct {
+        rrd_function_result_callback_t cb;
+        void *data;
+    } partial;
+
     struct {
         rrd_function_progress_cb_t cb;
         void *data;
@@ -2,6 +2,117 @@
 
 #include "pluginsd_internals.h"
 
+// The sockets of the children served by the streaming receivers pool are
+// non-blocking. We never wait for them while holding the writer lock (that
+// would stall every thread sending to this child, and the pool thread with
+// all its other children). The output they do not accept is queued instead,
+// and the pool thread flushes it when poll() says the socket is ready.
+
+#define PLUGINSD_PENDING_OUTPUT_MAX (4 * 1024 * 1024)
+#define PLUGINSD_PENDING_OUTPUT_TIMEOUT_S 10
+
+// returns the bytes written, zero when the socket would block, or -1 on failure
+static ssize_t send_to_plugin_write_locked(PARSER *parser, const char *txt, size_t size) {
+    NETDATA_SSL *ssl = parser->ssl_output;
+    ssize_t sent;
+
+    if(ssl) {
+        if(!SSL_connection(ssl))
+            return -1;
+
+        sent = netdata_ssl_write(ssl, (void *)txt, size);
+        if(sent > 0)
+            return sent;
+
+        // openssl tells us what it waits for, to complete the write
+        if(ssl->ssl_errno == SSL_ERROR_WANT_READ) {
+            parser->writer.pending_events = POLLIN;
+            return 0;
+        }
+
+        if(ssl->ssl_errno == SSL_ERROR_WANT_WRITE) {
+            parser->writer.pending_events = POLLOUT;
+            return 0;
+        }
+
+        return -1;
+    }
+
+    if(parser->fd_output == -1)
+        return -1;
+
+    do {
+        errno_clear();
+        sent = write(parser->fd_output, txt, size);
+    } while(sent < 0 && errno == EINTR);
+
+    if(sent > 0)
+        return sent;
+
+    if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        parser->writer.pending_events = POLLOUT;
+        return 0;
+    }
+
+    return -1;
+}
+
+// write as much of the queued output as the socket accepts
+// returns false when the socket failed
+static bool send_to_plugin_flush_locked(PARSER *parser) {
+    BUFFER *wb = parser->writer.pending;
+
+    while(parser->writer.pending_offset < buffer_strlen(wb)) {
+        ssize_t sent = send_to_plugin_write_locked(
+            parser, &wb->buffer[parser->writer.pending_offset], buffer_strlen(wb) - parser->writer.pending_offset);
+
+        if(sent < 0)
+            return false;
+
+        if(!sent) {
+            // move the rest to the beginning, so that the queue does not grow forever
+            if(parser->writer.pending_offset) {
+                wb->len -= parser->writer.pending_offset;
+                memmove(wb->buffer, &wb->buffer[parser->writer.pending_offset], wb->len);
+                wb->buffer[wb->len] = '\0';
+                parser->writer.pending_offset = 0;
+            }
+            return true;
+        }
+
+        parser->writer.pending_offset += sent;
+        parser->writer.pending_progress_s = now_monotonic_sec();
+    }
+
+    buffer_flush(wb);
+    parser->writer.pending_offset = 0;
+    parser->writer.pending_events = 0;
+    return true;
+}
+
+short send_to_plugin_pending_events(PARSER *parser) {
+    return __atomic_load_n(&parser->writer.pending_events, __ATOMIC_RELAXED);
+}
+
+bool send_to_plugin_flush(PARSER *parser) {
+    bool ret = true;
+
+    spinlock_lock(&parser->writer.spinlock);
+    if(parser->writer.pending_events) {
+        ret = send_to_plugin_flush_locked(parser);
+
+        if(ret && parser->writer.pending_events &&
+            now_monotonic_sec() - parser->writer.pending_progress_s > PLUGINSD_PENDING_OUTPUT_TIMEOUT_S) {
+            netdata_log_error("PLUGINSD: the output socket did not accept any data for %d seconds",
+                              PLUGINSD_PENDING_OUTPUT_TIMEOUT_S);
+            ret = false;
+        }
+    }
+    spinlock_unlock(&parser->writer.spinlock);
+
+    return ret;
+}
+
 ssize_t send_to_plugin(const char *txt, PARSER *parser) {
     if(!txt || !*txt || !parser)
         return 0;
@@ -13,44 +124,57 @@ ssize_t send_to_plugin(const char *txt, PARSER *parser) {
 
     errno_clear();
     spinlock_lock(&parser->writer.spinlock);
-    ssize_t bytes = -1;
 
-    NETDATA_SSL *ssl = parser->ssl_output;
-    if(ssl) {
+    if(!parser->ssl_output && parser->fd_output == -1) {
+        spinlock_unlock(&parser->writer.spinlock);
+        netdata_log_error("PLUGINSD: cannot send command (no output socket/pipe/file given to plugins.d parser)");
+        return -4;
+    }
 
-        if(SSL_connection(ssl))
-            bytes = netdata_ssl_write(ssl, (void *) txt, strlen(txt));
+    const char *type = parser->ssl_output ? "SSL" : "fd";
+    size_t total = strlen(txt);
+    size_t bytes = 0;
+    bool queued = parser->writer.pending_events != 0;
+
+    // when there is queued output, this has to go after it
+    while(!queued && bytes < total) {
+        ssize_t sent = send_to_plugin_write_locked(parser, &txt[bytes], total - bytes);
+        if(sent < 0) {
+            spinlock_unlock(&parser->writer.spinlock);
+            netdata_log_error("PLUGINSD: cannot send command (%s)", type);
+            return parser->ssl_output ? -1 : -3;
+        }
 
-        else
-            netdata_log_error("PLUGINSD: cannot send command (SSL)");
+        if(!sent)
+            break;
 
-        spinlock_unlock(&parser->writer.spinlock);
-        return bytes;
+        bytes += sent;
     }
 
-    if(parser->fd_output != -1) {
-        bytes = 0;
-        ssize_t total = (ssize_t)strlen(txt);
-        ssize_t sent;
-
-        do {
-            sent = write(parser->fd_output, &txt[bytes], total - bytes);
-            if(sent <= 0) {
-                netdata_log_error("PLUGINSD: cannot send command (fd)");
-                spinlock_unlock(&parser->writer.spinlock);
-                return -3;
-            }
-            bytes += sent;
+    if(bytes < total) {
+        if(!parser->writer.pending)
+            parser->writer.pending = buffer_create(total - bytes, NULL);
+
+        if(buffer_strlen(parser->writer.pending) - parser->writer.pending_offset + total - bytes > PLUGINSD_PENDING_OUTPUT_MAX) {
+            spinlock_unlock(&parser->writer.spinlock);
+            netdata_log_error("PLUGINSD: cannot send command (%s), the output queue is full", type);
+            return -5;
         }
-        while(bytes < total);
 
-        spinlock_unlock(&parser->writer.spinlock);
-        return (int)bytes;
+        if(!queued)
+            parser->writer.pending_progress_s = now_monotonic_sec();
+
+        buffer_memcat(parser->writer.pending, &txt[bytes], total - bytes);
+
+        if(queued && !send_to_plugin_flush_locked(parser)) {
+            spinlock_unlock(&parser->writer.spinlock);
+            netdata_log_error("PLUGINSD: cannot send command (%s)", type);
+            return parser->ssl_output ? -1 : -3;
+        }
     }
 
     spinlock_unlock(&parser->writer.spinlock);
-    netdata_log_error("PLUGINSD: cannot send command (no output socket/pipe/file given to plugins.d parser)");
-    return -4;
+    return (ssize_t)total;
 }
 
 PARSER_RC PLUGINSD_DISABLE_PLUGIN(PARSER *parser, const char *keyword, const char *msg) {
@@ -78,6 +202,7 @@ void parser_destroy(PARSER *parser) {
 
     pluginsd_inflight_functions_cleanup(parser);
 
+    buffer_free(parser->writer.pending);
     freez(parser);
 }
 
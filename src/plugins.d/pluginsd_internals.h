@@ -155,8 +155,17 @@ static inline void pluginsd_rrddim_put_to_slot(PARSER *parser, RRDSET *st, RRDDI
     }
 }
 
+// when the stream has STREAM_CAP_COMPACT, BEGIN2 and SET2 carry the slot without the id
+static inline bool pluginsd_slot_without_id(PARSER *parser, ssize_t slot) {
+    return slot > 0 && stream_has_capability(&parser->user, STREAM_CAP_COMPACT);
+}
+
+// the dimension id may be NULL, when the slot is enough to find the dimension
 static inline RRDDIM *pluginsd_acquire_dimension(RRDHOST *host, RRDSET *st, const char *dimension, ssize_t slot, const char *cmd) {
-    if (unlikely(!dimension || !*dimension)) {
+    if (unlikely(dimension && !*dimension))
+        dimension = NULL;
+
+    if (unlikely(!dimension && slot < 1)) {
         netdata_log_error("PLUGINSD: 'host:%s/chart:%s' got a %s, without a dimension.",
                           rrdhost_hostname(host), rrdset_id(st), cmd);
         return NULL;
@@ -185,7 +194,7 @@ static inline RRDDIM *pluginsd_acquire_dimension(RRDHOST *host, RRDSET *st, cons
         rd = prd->rd;
         if(likely(rd)) {
 #ifdef NETDATA_INTERNAL_CHECKS
-            if(strcmp(prd->id, dimension) != 0) {
+            if(dimension && strcmp(prd->id, dimension) != 0) {
                 ssize_t t;
                 for(t = 0; t < st->pluginsd.size ;t++) {
                     if (strcmp(st->pluginsd.prd_array[t].id, dimension) == 0)
@@ -212,7 +221,7 @@ static inline RRDDIM *pluginsd_acquire_dimension(RRDHOST *host, RRDSET *st, cons
         prd = &st->pluginsd.prd_array[st->pluginsd.pos++];
 
         rd = prd->rd;
-        if(likely(rd)) {
+        if(likely(rd) && dimension) {
             const char *id = prd->id;
 
             if(strcmp(id, dimension) == 0) {
@@ -231,6 +240,13 @@ static inline RRDDIM *pluginsd_acquire_dimension(RRDHOST *host, RRDSET *st, cons
 
     // we need to find the dimension and set it to prd
 
+    if (unlikely(!dimension)) {
+        netdata_log_error("PLUGINSD: 'host:%s/chart:%s' got a %s for slot %zd, without a dimension, "
+                          "but the slot is not assigned to a dimension.",
+                          rrdhost_hostname(host), rrdset_id(st), cmd, slot);
+        return NULL;
+    }
+
     RRDDIM_ACQUIRED *rda = rrddim_find_and_acquire(st, dimension);
     if (unlikely(!rda)) {
         netdata_log_error("PLUGINSD: 'host:%s/chart:%s/dim:%s' got a %s but dimension does not exist.",
@@ -317,7 +333,7 @@ static inline RRDSET *pluginsd_rrdset_cache_get_from_slot(PARSER *parser, RRDHOS
             pluginsd_rrdset_cache_put_to_slot(parser, st, slot, rrdset_flag_check(st, RRDSET_FLAG_OBSOLETE));
     }
     else {
-        internal_fatal(string_strcmp(st->id, id) != 0,
+        internal_fatal(id && string_strcmp(st->id, id) != 0,
                        "PLUGINSD: wrong chart in slot %zd, expected '%s', found '%s'",
                        slot - 1, id, string2str(st->id));
     }
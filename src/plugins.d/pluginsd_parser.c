@@ -2,14 +2,7 @@
 
 #include "pluginsd_internals.h"
 
-static inline PARSER_RC pluginsd_set(char **words, size_t num_words, PARSER *parser) {
-    int idx = 1;
-    ssize_t slot = pluginsd_parse_rrd_slot(words, num_words);
-    if(slot >= 0) idx++;
-
-    char *dimension = get_word(words, num_words, idx++);
-    char *value = get_word(words, num_words, idx++);
-
+static inline PARSER_RC pluginsd_set_internal(PARSER *parser, const char *dimension, ssize_t slot, collected_number value, bool has_value) {
     RRDHOST *host = pluginsd_require_scope_host(parser, PLUGINSD_KEYWORD_SET);
     if(!host) return PLUGINSD_DISABLE_PLUGIN(parser, NULL, NULL);
 
@@ -21,24 +14,34 @@ static inline PARSER_RC pluginsd_set(char **words, size_t num_words, PARSER *par
 
     st->pluginsd.set = true;
 
-    if (unlikely(rrdset_flag_check(st, RRDSET_FLAG_DEBUG)))
-        netdata_log_debug(D_PLUGINSD, "PLUGINSD: 'host:%s/chart:%s/dim:%s' SET is setting value to '%s'",
-              rrdhost_hostname(host), rrdset_id(st), dimension, value && *value ? value : "UNSET");
+    if (unlikely(rrdset_flag_check(st, RRDSET_FLAG_DEBUG))) {
+        if(has_value)
+            netdata_log_debug(D_PLUGINSD, "PLUGINSD: 'host:%s/chart:%s/dim:%s' SET is setting value to '%lld'",
+                              rrdhost_hostname(host), rrdset_id(st), rrddim_id(rd), (long long)value);
+        else
+            netdata_log_debug(D_PLUGINSD, "PLUGINSD: 'host:%s/chart:%s/dim:%s' SET is setting value to 'UNSET'",
+                              rrdhost_hostname(host), rrdset_id(st), rrddim_id(rd));
+    }
 
-    if (value && *value)
-        rrddim_set_by_pointer(st, rd, str2ll_encoded(value));
+    if (has_value)
+        rrddim_set_by_pointer(st, rd, value);
 
     return PARSER_RC_OK;
 }
 
-static inline PARSER_RC pluginsd_begin(char **words, size_t num_words, PARSER *parser) {
+static inline PARSER_RC pluginsd_set(char **words, size_t num_words, PARSER *parser) {
     int idx = 1;
     ssize_t slot = pluginsd_parse_rrd_slot(words, num_words);
     if(slot >= 0) idx++;
 
-    char *id = get_word(words, num_words, idx++);
-    char *microseconds_txt = get_word(words, num_words, idx++);
+    char *dimension = get_word(words, num_words, idx++);
+    char *value = get_word(words, num_words, idx++);
+
+    bool has_value = value && *value;
+    return pluginsd_set_internal(parser, dimension, slot, has_value ? str2ll_encoded(value) : 0, has_value);
+}
 
+static inline PARSER_RC pluginsd_begin_internal(PARSER *parser, const char *id, ssize_t slot, usec_t microseconds) {
     RRDHOST *host = pluginsd_require_scope_host(parser, PLUGINSD_KEYWORD_BEGIN);
     if(!host) return PLUGINSD_DISABLE_PLUGIN(parser, NULL, NULL);
 
@@ -48,13 +51,6 @@ static inline PARSER_RC pluginsd_begin(char **words, size_t num_words, PARSER *p
     if(!pluginsd_set_scope_chart(parser, st, PLUGINSD_KEYWORD_BEGIN))
         return PLUGINSD_DISABLE_PLUGIN(parser, NULL, NULL);
 
-    usec_t microseconds = 0;
-    if (microseconds_txt && *microseconds_txt) {
-        long long t = str2ll(microseconds_txt, NULL);
-        if(t >= 0)
-            microseconds = t;
-    }
-
 #ifdef NETDATA_LOG_REPLICATION_REQUESTS
     if(st->replay.log_next_data_collection) {
         st->replay.log_next_data_collection = false;
@@ -82,11 +78,25 @@ static inline PARSER_RC pluginsd_begin(char **words, size_t num_words, PARSER *p
     return PARSER_RC_OK;
 }
 
-static inline PARSER_RC pluginsd_end(char **words, size_t num_words, PARSER *parser) {
-    char *tv_sec = get_word(words, num_words, 1);
-    char *tv_usec = get_word(words, num_words, 2);
-    char *pending_rrdset_next = get_word(words, num_words, 3);
+static inline PARSER_RC pluginsd_begin(char **words, size_t num_words, PARSER *parser) {
+    int idx = 1;
+    ssize_t slot = pluginsd_parse_rrd_slot(words, num_words);
+    if(slot >= 0) idx++;
+
+    char *id = get_word(words, num_words, idx++);
+    char *microseconds_txt = get_word(words, num_words, idx++);
+
+    usec_t microseconds = 0;
+    if (microseconds_txt && *microseconds_txt) {
+        long long t = str2ll(microseconds_txt, NULL);
+        if(t >= 0)
+            microseconds = t;
+    }
+
+    return pluginsd_begin_internal(parser, id, slot, microseconds);
+}
 
+static inline PARSER_RC pluginsd_end_internal(PARSER *parser, struct timeval tv, bool pending_rrdset_next) {
     RRDHOST *host = pluginsd_require_scope_host(parser, PLUGINSD_KEYWORD_END);
     if(!host) return PLUGINSD_DISABLE_PLUGIN(parser, NULL, NULL);
 
@@ -99,19 +109,27 @@ static inline PARSER_RC pluginsd_end(char **words, size_t num_words, PARSER *par
     pluginsd_clear_scope_chart(parser, PLUGINSD_KEYWORD_END);
     parser->user.data_collections_count++;
 
-    struct timeval tv = {
-        .tv_sec  = (tv_sec  && *tv_sec)  ? str2ll(tv_sec,  NULL) : 0,
-        .tv_usec = (tv_usec && *tv_usec) ? str2ll(tv_usec, NULL) : 0
-    };
-    
     if(!tv.tv_sec)
         now_realtime_timeval(&tv);
 
-    rrdset_timed_done(st, tv, pending_rrdset_next && *pending_rrdset_next ? true : false);
+    rrdset_timed_done(st, tv, pending_rrdset_next);
 
     return PARSER_RC_OK;
 }
 
+static inline PARSER_RC pluginsd_end(char **words, size_t num_words, PARSER *parser) {
+    char *tv_sec = get_word(words, num_words, 1);
+    char *tv_usec = get_word(words, num_words, 2);
+    char *pending_rrdset_next = get_word(words, num_words, 3);
+
+    struct timeval tv = {
+        .tv_sec  = (tv_sec  && *tv_sec)  ? str2ll(tv_sec,  NULL) : 0,
+        .tv_usec = (tv_usec && *tv_usec) ? str2ll(tv_usec, NULL) : 0
+    };
+
+    return pluginsd_end_internal(parser, tv, pending_rrdset_next && *pending_rrdset_next ? true : false);
+}
+
 static void pluginsd_host_define_cleanup(PARSER *parser) {
     string_freez(parser->user.host_define.hostname);
     rrdlabels_destroy(parser->user.host_define.rrdlabels);
@@ -366,17 +384,66 @@ static inline PARSER_RC pluginsd_chart(char **words, size_t num_words, PARSER *p
             return PLUGINSD_DISABLE_PLUGIN(parser, NULL, NULL);
 
         pluginsd_rrdset_cache_put_to_slot(parser, st, slot, obsolete);
+
+        // CHART_DEFINITION_END will set it, when the definition is complete
+        st->rrdpush.receiver.definition_digest = 0;
     }
     else
         pluginsd_clear_scope_chart(parser, PLUGINSD_KEYWORD_CHART);
 
+    parser->user.chart_reuse_failed = false;
     return PARSER_RC_OK;
 }
 
+static inline PARSER_RC pluginsd_chart_reuse(char **words, size_t num_words, PARSER *parser) {
+    ssize_t slot = pluginsd_parse_rrd_slot(words, num_words);
+    char *id = get_word(words, num_words, 2);
+    char *digest_txt = get_word(words, num_words, 3);
+
+    RRDHOST *host = pluginsd_require_scope_host(parser, PLUGINSD_KEYWORD_CHART_REUSE);
+    if(!host) return PLUGINSD_DISABLE_PLUGIN(parser, NULL, NULL);
+
+    if(unlikely(slot < 1 || !id || !*id || !digest_txt || !*digest_txt))
+        return PLUGINSD_DISABLE_PLUGIN(parser, PLUGINSD_KEYWORD_CHART_REUSE, "missing parameters");
+
+    uint64_t digest = str2ull_encoded(digest_txt);
+
+    // the chart has to be in the same slot, with all its dimensions still slotted,
+    // exactly as the previous connection of the child left it
+    RRDSET *st = NULL;
+    if((size_t)slot <= host->rrdpush.receive.pluginsd_chart_slots.size)
+        st = host->rrdpush.receive.pluginsd_chart_slots.array[slot - 1];
+
+    if(likely(st && st->pluginsd.last_slot == (int32_t)slot - 1 && st->pluginsd.dims_with_slots &&
+              st->rrdpush.receiver.definition_digest == digest && string_strcmp(st->id, id) == 0)) {
+        if(!pluginsd_set_scope_chart(parser, st, PLUGINSD_KEYWORD_CHART_REUSE))
+            return PLUGINSD_DISABLE_PLUGIN(parser, NULL, NULL);
+
+        parser->user.chart_reuse_failed = false;
+        return PARSER_RC_OK;
+    }
+
+    // we don't have it - ask the child to send the full definition
+    pluginsd_clear_scope_chart(parser, PLUGINSD_KEYWORD_CHART_REUSE);
+    parser->user.chart_reuse_failed = true;
+
+    char buffer[2048 + 1];
+    snprintfz(buffer, sizeof(buffer) - 1, PLUGINSD_KEYWORD_CHART_RESEND " \"%s\"\n", id);
+
+    return (send_to_plugin(buffer, parser) < 0) ? PARSER_RC_ERROR : PARSER_RC_OK;
+}
+
 static inline PARSER_RC pluginsd_chart_definition_end(char **words, size_t num_words, PARSER *parser) {
     const char *first_entry_txt = get_word(words, num_words, 1);
     const char *last_entry_txt = get_word(words, num_words, 2);
     const char *wall_clock_time_txt = get_word(words, num_words, 3);
+    const char *digest_txt = get_word(words, num_words, 4);
+
+    if(unlikely(parser->user.chart_reuse_failed)) {
+        // the child will send the full definition of the chart
+        parser->user.chart_reuse_failed = false;
+        return PARSER_RC_OK;
+    }
 
     RRDHOST *host = pluginsd_require_scope_host(parser, PLUGINSD_KEYWORD_CHART_DEFINITION_END);
     if(!host) return PLUGINSD_DISABLE_PLUGIN(parser, NULL, NULL);
@@ -388,6 +455,8 @@ static inline PARSER_RC pluginsd_chart_definition_end(char **words, size_t num_w
     time_t last_entry_child = (last_entry_txt && *last_entry_txt) ? (time_t)str2ul(last_entry_txt) : 0;
     time_t child_wall_clock_time = (wall_clock_time_txt && *wall_clock_time_txt) ? (time_t)str2ul(wall_clock_time_txt) : now_realtime_sec();
 
+    st->rrdpush.receiver.definition_digest = (digest_txt && *digest_txt) ? str2ull_encoded(digest_txt) : 0;
+
     bool ok = true;
     if(!rrdset_flag_check(st, RRDSET_FLAG_RECEIVER_REPLICATION_IN_PROGRESS)) {
 
@@ -593,13 +662,74 @@ static inline PARSER_RC pluginsd_variable(char **words, size_t num_words, PARSER
     return PARSER_RC_OK;
 }
 
+// ----------------------------------------------------------------------------
+// the shared memory transport
+// plugins send FLUSH after writing records to the ring, so we process them
+// here, after all the text lines the plugin sent before them
+// a plugin that fills the ring sends FLUSH in the middle of its records, so
+// a chart may be left open by one drain, to be continued by the next
+
+struct pluginsd_shm_consume {
+    PARSER *parser;
+    PARSER_RC rc;
+};
+
+static bool pluginsd_shm_record(const SHM_RING_RECORD *rec, void *data) {
+    struct pluginsd_shm_consume *t = data;
+
+    switch(rec->type) {
+        case SHM_RING_RECORD_BEGIN:
+            t->rc = pluginsd_begin_internal(t->parser, NULL, rec->slot, rec->value > 0 ? (usec_t)rec->value : 0);
+            t->parser->user.shm_chart_open = (t->rc == PARSER_RC_OK);
+            break;
+
+        case SHM_RING_RECORD_SET:
+            t->rc = pluginsd_set_internal(t->parser, NULL, rec->slot, (collected_number)rec->value, true);
+            break;
+
+        case SHM_RING_RECORD_END: {
+            struct timeval tv = { 0 };
+            if(rec->value > 0) {
+                tv.tv_sec = (time_t)(rec->value / USEC_PER_SEC);
+                tv.tv_usec = (suseconds_t)(rec->value % USEC_PER_SEC);
+            }
+            t->rc = pluginsd_end_internal(t->parser, tv, false);
+            t->parser->user.shm_chart_open = false;
+            break;
+        }
+
+        default:
+            t->rc = PLUGINSD_DISABLE_PLUGIN(t->parser, PLUGINSD_KEYWORD_FLUSH, "unknown shared memory record");
+            break;
+    }
+
+    return t->rc == PARSER_RC_OK;
+}
+
+static inline PARSER_RC pluginsd_shm_drain(PARSER *parser) {
+    struct pluginsd_shm_consume t = {
+        .parser = parser,
+        .rc = PARSER_RC_OK,
+    };
+
+    shm_ring_consume(parser->user.shm, pluginsd_shm_record, &t);
+    return t.rc;
+}
+
 static inline PARSER_RC pluginsd_flush(char **words __maybe_unused, size_t num_words __maybe_unused, PARSER *parser) {
     netdata_log_debug(D_PLUGINSD, "requested a " PLUGINSD_KEYWORD_FLUSH);
-    pluginsd_clear_scope_chart(parser, PLUGINSD_KEYWORD_FLUSH);
+
+    if(!parser->user.shm_chart_open)
+        pluginsd_clear_scope_chart(parser, PLUGINSD_KEYWORD_FLUSH);
+
     parser->user.replay.start_time = 0;
     parser->user.replay.end_time = 0;
     parser->user.replay.start_time_ut = 0;
     parser->user.replay.end_time_ut = 0;
+
+    if(parser->user.shm)
+        return pluginsd_shm_drain(parser);
+
     return PARSER_RC_OK;
 }
 
@@ -744,12 +874,13 @@ static inline PARSER_RC pluginsd_begin_v2(char **words, size_t num_words, PARSER
     ssize_t slot = pluginsd_parse_rrd_slot(words, num_words);
     if(slot >= 0) idx++;
 
-    char *id = get_word(words, num_words, idx++);
+    bool with_id = !pluginsd_slot_without_id(parser, slot);
+    char *id = with_id ? get_word(words, num_words, idx++) : NULL;
     char *update_every_str = get_word(words, num_words, idx++);
     char *end_time_str = get_word(words, num_words, idx++);
     char *wall_clock_time_str = get_word(words, num_words, idx++);
 
-    if(unlikely(!id || !update_every_str || !end_time_str || !wall_clock_time_str))
+    if(unlikely((with_id && !id) || !update_every_str || !end_time_str || !wall_clock_time_str))
         return PLUGINSD_DISABLE_PLUGIN(parser, PLUGINSD_KEYWORD_BEGIN_V2, "missing parameters");
 
     RRDHOST *host = pluginsd_require_scope_host(parser, PLUGINSD_KEYWORD_BEGIN_V2);
@@ -810,6 +941,7 @@ static inline PARSER_RC pluginsd_begin_v2(char **words, size_t num_words, PARSER
 
         // check sender capabilities
         bool with_slots = stream_has_capability(&parser->user.v2.stream_buffer, STREAM_CAP_SLOTS) ? true : false;
+        bool with_ids = !with_slots || !stream_has_capability(&parser->user.v2.stream_buffer, STREAM_CAP_COMPACT);
         NUMBER_ENCODING integer_encoding = stream_has_capability(&parser->user.v2.stream_buffer, STREAM_CAP_IEEE754) ? NUMBER_ENCODING_BASE64 : NUMBER_ENCODING_HEX;
 
         BUFFER *wb = parser->user.v2.stream_buffer.wb;
@@ -826,9 +958,13 @@ static inline PARSER_RC pluginsd_begin_v2(char **words, size_t num_words, PARSER
             buffer_print_uint64_encoded(wb, integer_encoding, st->rrdpush.sender.chart_slot);
         }
 
-        buffer_fast_strcat(wb, " '", 2);
-        buffer_fast_strcat(wb, rrdset_id(st), string_strlen(st->id));
-        buffer_fast_strcat(wb, "' ", 2);
+        if(with_ids) {
+            buffer_fast_strcat(wb, " '", 2);
+            buffer_fast_strcat(wb, rrdset_id(st), string_strlen(st->id));
+            buffer_fast_strcat(wb, "' ", 2);
+        }
+        else
+            buffer_fast_strcat(wb, " ", 1);
 
         if(can_copy)
             buffer_strcat(wb, update_every_str);
@@ -884,12 +1020,13 @@ static inline PARSER_RC pluginsd_set_v2(char **words, size_t num_words, PARSER *
     ssize_t slot = pluginsd_parse_rrd_slot(words, num_words);
     if(slot >= 0) idx++;
 
-    char *dimension = get_word(words, num_words, idx++);
+    bool with_id = !pluginsd_slot_without_id(parser, slot);
+    char *dimension = with_id ? get_word(words, num_words, idx++) : NULL;
     char *collected_str = get_word(words, num_words, idx++);
     char *value_str = get_word(words, num_words, idx++);
     char *flags_str = get_word(words, num_words, idx++);
 
-    if(unlikely(!dimension || !collected_str || !value_str || !flags_str))
+    if(unlikely((with_id && !dimension) || !collected_str || !value_str || !flags_str))
         return PLUGINSD_DISABLE_PLUGIN(parser, PLUGINSD_KEYWORD_SET_V2, "missing parameters");
 
     RRDHOST *host = pluginsd_require_scope_host(parser, PLUGINSD_KEYWORD_SET_V2);
@@ -955,6 +1092,7 @@ static inline PARSER_RC pluginsd_set_v2(char **words, size_t num_words, PARSER *
 
         // check the sender capabilities
         bool with_slots = stream_has_capability(&parser->user.v2.stream_buffer, STREAM_CAP_SLOTS) ? true : false;
+        bool with_ids = !with_slots || !stream_has_capability(&parser->user.v2.stream_buffer, STREAM_CAP_COMPACT);
         NUMBER_ENCODING integer_encoding = stream_has_capability(&parser->user.v2.stream_buffer, STREAM_CAP_IEEE754) ? NUMBER_ENCODING_BASE64 : NUMBER_ENCODING_HEX;
         NUMBER_ENCODING doubles_encoding = stream_has_capability(&parser->user.v2.stream_buffer, STREAM_CAP_IEEE754) ? NUMBER_ENCODING_BASE64 : NUMBER_ENCODING_DECIMAL;
 
@@ -967,9 +1105,14 @@ static inline PARSER_RC pluginsd_set_v2(char **words, size_t num_words, PARSER *
             buffer_print_uint64_encoded(wb, integer_encoding, rd->rrdpush.sender.dim_slot);
         }
 
-        buffer_fast_strcat(wb, " '", 2);
-        buffer_fast_strcat(wb, rrddim_id(rd), string_strlen(rd->id));
-        buffer_fast_strcat(wb, "' ", 2);
+        if(with_ids) {
+            buffer_fast_strcat(wb, " '", 2);
+            buffer_fast_strcat(wb, rrddim_id(rd), string_strlen(rd->id));
+            buffer_fast_strcat(wb, "' ", 2);
+        }
+        else
+            buffer_fast_strcat(wb, " ", 1);
+
         if(can_copy)
             buffer_strcat(wb, collected_str);
         else
@@ -1031,6 +1174,12 @@ static inline PARSER_RC pluginsd_end_v2(char **words __maybe_unused, size_t num_
     rrdcontext_collected_rrdset(st);
     store_metric_collection_completed();
 
+    if(unlikely(st->backfill_pending))
+        rrdset_backfill_submit(st);
+
+    if(unlikely(st->live))
+        rrdset_live_collected(st);
+
     timing_step(TIMING_STEP_END2_RRDSET);
 
     // ------------------------------------------------------------------------
@@ -1184,6 +1333,7 @@ inline size_t pluginsd_process(RRDHOST *host, struct plugind *cd, int fd_input,
                 .enabled = cd->unsafe.enabled,
                 .host = host,
                 .cd = cd,
+                .shm = cd->unsafe.shm,
                 .trust_durations = trust_durations
         };
 
@@ -1207,14 +1357,32 @@ inline size_t pluginsd_process(RRDHOST *host, struct plugind *cd, int fd_input,
 
     CLEANUP_FUNCTION_REGISTER(pluginsd_process_thread_cleanup) cleanup_parser = parser;
     buffered_reader_init(&parser->reader);
-    CLEAN_BUFFER *buffer = buffer_create(sizeof(parser->reader.read_buffer) + 2, NULL);
+
+    // the lines are parsed in place, in the read buffer of the reader;
+    // only the lines too long to fit in it are assembled in this buffer
+    CLEAN_BUFFER *buffer = buffer_create(0, NULL);
+    bool long_line = false;
+
     while(likely(service_running(SERVICE_COLLECTORS))) {
+        char *line;
+
+        if(unlikely(long_line)) {
+            line = buffered_reader_next_line(&parser->reader, buffer) ? buffer->buffer : NULL;
+            long_line = (line == NULL);
+        }
+        else
+            line = buffered_reader_next_line_inplace(&parser->reader);
 
-        if(unlikely(!buffered_reader_next_line(&parser->reader, buffer))) {
+        if(unlikely(!line)) {
             buffered_reader_ret_t ret = buffered_reader_read_timeout(
                     &parser->reader, parser->fd_input,
                     2 * 60 * MSEC_PER_SEC, true);
 
+            if(unlikely(ret == BUFFERED_READER_READ_BUFFER_FULL && !long_line)) {
+                long_line = true;
+                continue;
+            }
+
             if(unlikely(ret != BUFFERED_READER_READ_OK)) {
                 nd_log(NDLS_COLLECTORS, NDLP_INFO, "Buffered reader not OK");
                 break;
@@ -1223,7 +1391,7 @@ inline size_t pluginsd_process(RRDHOST *host, struct plugind *cd, int fd_input,
             continue;
         }
 
-        if(unlikely(parser_action(parser, buffer->buffer)))
+        if(unlikely(parser_action(parser, line)))
             break;
 
         buffer->len = 0;
@@ -1277,6 +1445,8 @@ PARSER_RC parser_execute(PARSER *parser, const PARSER_KEYWORD *keyword, char **w
             return pluginsd_chart(words, num_words, parser);
         case PLUGINSD_KEYWORD_ID_CHART_DEFINITION_END:
             return pluginsd_chart_definition_end(words, num_words, parser);
+        case PLUGINSD_KEYWORD_ID_CHART_REUSE:
+            return pluginsd_chart_reuse(words, num_words, parser);
         case PLUGINSD_KEYWORD_ID_CLABEL:
             return pluginsd_clabel(words, num_words, parser);
         case PLUGINSD_KEYWORD_ID_CLABEL_COMMIT:
@@ -1376,3 +1546,205 @@ int pluginsd_parser_unittest(void) {
     parser_destroy(p);
     return 0;
 }
+
+// ----------------------------------------------------------------------------
+// shared memory transport unittest
+// the test is both the plugin (the producer) and the agent (the consumer):
+// it defines a chart on the text protocol, pushes its values to the ring,
+// and drives the parser with FLUSH, like a plugin writing to its pipe would
+
+#define SHM_UNITTEST_DIMENSIONS 3
+#define SHM_UNITTEST_ITERATIONS 100
+
+struct pluginsd_shm_unittest {
+    PARSER *parser;
+    size_t full;
+    size_t flush_errors;
+};
+
+static int pluginsd_shm_unittest_line(PARSER *parser, const char *line) {
+    char input[PLUGINSD_LINE_MAX + 1];
+    strncpyz(input, line, PLUGINSD_LINE_MAX);
+    return parser_action(parser, input);
+}
+
+// the plugin outputs FLUSH when the ring is full, so that the agent drains it
+static void pluginsd_shm_unittest_full(void *data) {
+    struct pluginsd_shm_unittest *t = data;
+    t->full++;
+
+    if(pluginsd_shm_unittest_line(t->parser, PLUGINSD_KEYWORD_FLUSH))
+        t->flush_errors++;
+}
+
+static bool pluginsd_shm_unittest_discard(const SHM_RING_RECORD *rec __maybe_unused, void *data __maybe_unused) {
+    return true;
+}
+
+// pushes an iteration with a bad record in it, and expects FLUSH to fail
+static int pluginsd_shm_unittest_bad(PARSER *parser, SHM_RING *producer, SHM_RING *consumer, const char *name,
+                                     SHM_RING_RECORD_TYPE type, uint32_t slot) {
+    int errors = 0;
+
+    shm_ring_begin(producer, 1, 0);
+    shm_ring_push(producer, type, slot, 1);
+    shm_ring_end(producer, 0);
+    shm_ring_commit(producer);
+
+    if(!pluginsd_shm_unittest_line(parser, PLUGINSD_KEYWORD_FLUSH)) {
+        fprintf(stderr, "SHM RING: %s was accepted\n", name);
+        errors++;
+    }
+
+    if(parser->user.enabled) {
+        fprintf(stderr, "SHM RING: %s did not disable the plugin\n", name);
+        errors++;
+    }
+
+    // start clean for the next test
+    shm_ring_consume(consumer, pluginsd_shm_unittest_discard, NULL);
+    pluginsd_clear_scope_chart(parser, PLUGINSD_KEYWORD_FLUSH);
+    parser->user.shm_chart_open = false;
+    parser->user.enabled = 1;
+
+    return errors;
+}
+
+int pluginsd_shm_unittest(void) {
+    int errors = 0;
+    RRDSET *st = NULL;
+
+    char filename[FILENAME_MAX + 1];
+    snprintfz(filename, FILENAME_MAX, "/tmp/netdata-shm-ring-unittest-%d", getpid());
+
+    // the smallest ring, so that the records of the iterations do not fit in it
+    SHM_RING *consumer = shm_ring_create(filename, 1);
+    if(!consumer) {
+        fprintf(stderr, "SHM RING: cannot create '%s'\n", filename);
+        return 1;
+    }
+
+    struct plugind cd = {
+        .update_every = 1,
+        .unsafe = {
+            .enabled = true,
+            .shm = consumer,
+        },
+    };
+    strncpyz(cd.id, "shm_ring_unittest", sizeof(cd.id) - 1);
+    strncpyz(cd.filename, "shm_ring_unittest.plugin", sizeof(cd.filename) - 1);
+
+    PARSER_USER_OBJECT user = {
+        .enabled = cd.unsafe.enabled,
+        .host = localhost,
+        .cd = &cd,
+        .shm = cd.unsafe.shm,
+        .trust_durations = 1,
+    };
+    PARSER *parser = parser_init(&user, -1, -1, PARSER_INPUT_SPLIT, NULL);
+    pluginsd_keywords_init(parser, PARSER_INIT_PLUGINSD);
+
+    struct pluginsd_shm_unittest t = {
+        .parser = parser,
+    };
+
+    SHM_RING *producer = shm_ring_attach(filename, pluginsd_shm_unittest_full, &t);
+    if(!producer) {
+        fprintf(stderr, "SHM RING: cannot attach to '%s'\n", filename);
+        errors++;
+        goto cleanup;
+    }
+
+    // the definitions are sent as text, giving slots to the chart and its dimensions
+    errors += pluginsd_shm_unittest_line(parser,
+            "CHART SLOT:1 unittest.shm_ring '' 'shared memory ring unittest' values unittest unittest.shm_ring line 1000 1");
+    for(size_t d = 1; d <= SHM_UNITTEST_DIMENSIONS ; d++) {
+        char line[100];
+        snprintfz(line, sizeof(line) - 1, "DIMENSION SLOT:%zu d%zu '' absolute 1 1", d, d);
+        errors += pluginsd_shm_unittest_line(parser, line);
+    }
+
+    st = rrdset_find(localhost, "unittest.shm_ring");
+    if(errors || !st || st->pluginsd.size != SHM_UNITTEST_DIMENSIONS) {
+        fprintf(stderr, "SHM RING: cannot define the chart\n");
+        errors++;
+        goto cleanup;
+    }
+
+    // the records of all the iterations together do not fit in the ring,
+    // and an iteration does not fit evenly, so the ring fills in the middle of charts
+    usec_t now_ut = now_realtime_usec();
+    usec_t started_ut = (now_ut / USEC_PER_SEC - SHM_UNITTEST_ITERATIONS - 1) * USEC_PER_SEC;
+    size_t collections_before = parser->user.data_collections_count;
+    for(size_t i = 0; i < SHM_UNITTEST_ITERATIONS ; i++) {
+        bool ok = shm_ring_begin(producer, 1, i ? USEC_PER_SEC : 0);
+        for(size_t d = 1; d <= SHM_UNITTEST_DIMENSIONS ; d++)
+            ok = ok && shm_ring_set(producer, d, (int64_t)(i * 1000 + d));
+        ok = ok && shm_ring_end(producer, started_ut + i * USEC_PER_SEC);
+
+        if(!ok) {
+            fprintf(stderr, "SHM RING: push failed at iteration %zu\n", i);
+            errors++;
+            break;
+        }
+    }
+    shm_ring_commit(producer);
+    errors += pluginsd_shm_unittest_line(parser, PLUGINSD_KEYWORD_FLUSH);
+
+    if(!t.full || t.flush_errors) {
+        fprintf(stderr, "SHM RING: the ring got full %zu times, with %zu failed flushes\n", t.full, t.flush_errors);
+        errors++;
+    }
+
+    if(parser->user.data_collections_count - collections_before != SHM_UNITTEST_ITERATIONS) {
+        fprintf(stderr, "SHM RING: expected %d collections, got %zu\n",
+                SHM_UNITTEST_ITERATIONS, parser->user.data_collections_count - collections_before);
+        errors++;
+    }
+
+    for(size_t d = 1; d <= SHM_UNITTEST_DIMENSIONS ; d++) {
+        RRDDIM *rd = st->pluginsd.prd_array[d - 1].rd;
+        collected_number expected = (collected_number)((SHM_UNITTEST_ITERATIONS - 1) * 1000 + d);
+        if(!rd || rd->collector.last_collected_value != expected) {
+            fprintf(stderr, "SHM RING: dimension d%zu expected " COLLECTED_NUMBER_FORMAT ", got " COLLECTED_NUMBER_FORMAT "\n",
+                    d, expected, rd ? rd->collector.last_collected_value : 0);
+            errors++;
+        }
+    }
+
+    if(parser->user.st || parser->user.shm_chart_open) {
+        fprintf(stderr, "SHM RING: a chart has been left open\n");
+        errors++;
+    }
+
+    // bad records disable the plugin
+    errors += pluginsd_shm_unittest_bad(parser, producer, consumer, "a dimension slot out of range",
+                                        SHM_RING_RECORD_SET, SHM_UNITTEST_DIMENSIONS + 1);
+    errors += pluginsd_shm_unittest_bad(parser, producer, consumer, "dimension slot 0",
+                                        SHM_RING_RECORD_SET, 0);
+    errors += pluginsd_shm_unittest_bad(parser, producer, consumer, "a chart slot out of range",
+                                        SHM_RING_RECORD_BEGIN, 1000000);
+    errors += pluginsd_shm_unittest_bad(parser, producer, consumer, "an unknown record type",
+                                        (SHM_RING_RECORD_TYPE)99, 1);
+
+    // a producer that corrupts the head gets its records discarded
+    __atomic_store_n(&consumer->hdr->head, consumer->hdr->tail + consumer->mask + 2, __ATOMIC_RELEASE);
+    size_t collections_before_corruption = parser->user.data_collections_count;
+    errors += pluginsd_shm_unittest_line(parser, PLUGINSD_KEYWORD_FLUSH);
+    if(consumer->hdr->tail != consumer->hdr->head || parser->user.data_collections_count != collections_before_corruption) {
+        fprintf(stderr, "SHM RING: the records of a corrupted ring were not discarded\n");
+        errors++;
+    }
+
+cleanup:
+    shm_ring_destroy(producer);
+    pluginsd_cleanup_v2(parser);
+    parser_destroy(parser);
+    shm_ring_destroy(consumer);
+
+    if(st)
+        rrdset_is_obsolete___safe_from_collector_thread(st);
+
+    fprintf(stderr, "SHM RING: %d errors\n", errors);
+    return errors;
+}
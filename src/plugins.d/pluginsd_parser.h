@@ -46,10 +46,13 @@ typedef struct parser_keyword {
 
 typedef struct parser_user_object {
     bool cleanup_slots;
+    bool chart_reuse_failed;            // the CHART_DEFINITION_END that follows has to be ignored
     RRDSET *st;
     RRDHOST *host;
     void    *opaque;
     struct plugind *cd;
+    SHM_RING *shm;                      // the shared memory transport, when the plugin has one
+    bool shm_chart_open;                // the ring was drained between a BEGIN and its END
     int trust_durations;
     RRDLABELS *new_host_labels;
     RRDLABELS *chart_rrdlabels_linked_temporarily;
@@ -124,16 +127,23 @@ struct parser {
     struct {
         DICTIONARY *functions;
         usec_t smaller_monotonic_timeout_ut;
+        BUFFER *partial;            // the partial result being received, when the caller forwards them
     } inflight;
 
     struct {
         SPINLOCK spinlock;
+        BUFFER *pending;            // the output a non-blocking socket has not accepted yet
+        size_t pending_offset;      // the bytes of pending already written
+        short pending_events;       // what poll() should wait for to flush it, 0 when nothing is pending
+        time_t pending_progress_s;  // the last time the socket accepted some of it
     } writer;
 };
 
 typedef struct parser PARSER;
 
 PARSER *parser_init(struct parser_user_object *user, int fd_input, int fd_output, PARSER_INPUT_TYPE flags, void *ssl);
+short send_to_plugin_pending_events(PARSER *parser);
+bool send_to_plugin_flush(PARSER *parser);
 void parser_init_repertoire(PARSER *parser, PARSER_REPERTOIRE repertoire);
 void parser_destroy(PARSER *working_parser);
 void pluginsd_cleanup_v2(PARSER *parser);
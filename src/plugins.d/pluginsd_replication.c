@@ -328,6 +328,9 @@ PARSER_RC pluginsd_replay_end(char **words, size_t num_words, PARSER *parser) {
     st->counter_done++;
     store_metric_collection_completed();
 
+    if(unlikely(st->backfill_pending))
+        rrdset_backfill_submit(st);
+
 #ifdef NETDATA_LOG_REPLICATION_REQUESTS
     st->replay.start_streaming = false;
     st->replay.after = 0;
@@ -103,39 +103,15 @@ static inline int registry_person_save(const DICTIONARY_ITEM *item __maybe_unuse
 }
 
 // ----------------------------------------------------------------------------
-// SAVE THE REGISTRY DATABASE
-
-int registry_db_save(void) {
-    if(unlikely(!registry.enabled))
-        return -1;
-
-    if(unlikely(!registry_db_should_be_saved()))
-        return -2;
-
-    nd_log_limits_unlimited();
-
-    char tmp_filename[FILENAME_MAX + 1];
-    char old_filename[FILENAME_MAX + 1];
-
-    snprintfz(old_filename, FILENAME_MAX, "%s.old", registry.db_filename);
-    snprintfz(tmp_filename, FILENAME_MAX, "%s.tmp", registry.db_filename);
-
-    netdata_log_debug(D_REGISTRY, "REGISTRY: Creating file '%s'", tmp_filename);
-    FILE *fp = fopen(tmp_filename, "w");
-    if(!fp) {
-        netdata_log_error("REGISTRY: Cannot create file: %s", tmp_filename);
-        nd_log_limits_reset();
-        return -1;
-    }
+// SAVE THE REGISTRY DATABASE AS TEXT
 
+static int registry_db_save_text(FILE *fp) {
     // dictionary_walkthrough_read() has its own locking, so this is safe to do
 
     netdata_log_debug(D_REGISTRY, "REGISTRY: saving all machines");
     int bytes1 = dictionary_walkthrough_read(registry.machines, registry_machine_save, fp);
     if(bytes1 < 0) {
         netdata_log_error("REGISTRY: Cannot save registry machines - return value %d", bytes1);
-        fclose(fp);
-        nd_log_limits_reset();
         return bytes1;
     }
     netdata_log_debug(D_REGISTRY, "REGISTRY: saving machines took %d bytes", bytes1);
@@ -144,8 +120,6 @@ int registry_db_save(void) {
     int bytes2 = dictionary_walkthrough_read(registry.persons, registry_person_save, fp);
     if(bytes2 < 0) {
         netdata_log_error("REGISTRY: Cannot save registry persons - return value %d", bytes2);
-        fclose(fp);
-        nd_log_limits_reset();
         return bytes2;
     }
     netdata_log_debug(D_REGISTRY, "REGISTRY: saving persons took %d bytes", bytes2);
@@ -160,6 +134,254 @@ int registry_db_save(void) {
             registry.machines_urls_count
     );
 
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// THE BINARY REGISTRY DATABASE
+//
+// The file starts with a header, followed by a table of all the strings
+// (urls and machine names, each stored once, NULL terminated), followed by all
+// the machines (each followed by its urls) and all the persons (each followed by
+// its urls). Urls and machine names refer to the string table by index, and
+// person urls refer to their machine by its index in the file.
+//
+// Loading it mmaps the file and walks it once; each string of the table is
+// interned once, instead of once per line of the text format.
+
+#define REGISTRY_DB_BINARY_MAGIC "NDREGDB\x01"
+#define REGISTRY_DB_BINARY_VERSION 1
+
+struct registry_db_binary_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+
+    uint64_t strings;
+    uint64_t strings_bytes;
+    uint64_t machines;
+    uint64_t machine_urls;
+    uint64_t persons;
+    uint64_t person_urls;
+
+    // the totals
+    uint64_t persons_count;
+    uint64_t machines_count;
+    uint64_t usages_count;
+    uint64_t persons_urls_count;
+    uint64_t machines_urls_count;
+} __attribute__((packed));
+
+struct registry_db_binary_entry {       // a machine or a person
+    char guid[GUID_LEN];
+    uint32_t first_t;
+    uint32_t last_t;
+    uint32_t usages;
+    uint32_t urls;                      // the number of urls following it
+} __attribute__((packed));
+
+struct registry_db_binary_machine_url {
+    uint32_t url;
+    uint32_t first_t;
+    uint32_t last_t;
+    uint32_t usages;
+    uint8_t flags;
+} __attribute__((packed));
+
+struct registry_db_binary_person_url {
+    uint32_t machine;
+    uint32_t machine_name;
+    uint32_t url;
+    uint32_t first_t;
+    uint32_t last_t;
+    uint32_t usages;
+    uint8_t flags;
+} __attribute__((packed));
+
+struct registry_db_binary_strings {
+    Pvoid_t JudyL;                      // STRING * -> index + 1
+    STRING **array;
+    size_t used;
+    size_t size;
+    size_t bytes;
+};
+
+static uint32_t registry_db_binary_string_index(struct registry_db_binary_strings *st, STRING *s) {
+    Pvoid_t *PValue = JudyLIns(&st->JudyL, (Word_t)s, PJE0);
+    if(*PValue)
+        return (uint32_t)((Word_t)*PValue - 1);
+
+    if(st->used == st->size) {
+        st->size = st->size ? st->size * 2 : 1024;
+        st->array = reallocz(st->array, st->size * sizeof(STRING *));
+    }
+
+    st->array[st->used] = s;
+    st->bytes += string_strlen(s) + 1;
+    *PValue = (void *)(Word_t)(++st->used);
+    return (uint32_t)(st->used - 1);
+}
+
+// urls are prepended to their lists when loaded, so they are saved from the last to the first
+#define registry_db_binary_foreach_url_reverse(head, u) \
+    for((u) = (head) ? (head)->prev : NULL; (u) ; (u) = ((u) == (head)) ? NULL : (u)->prev)
+
+static int registry_db_save_binary(FILE *fp) {
+    struct registry_db_binary_strings st = { 0 };
+    Pvoid_t machines_JudyL = NULL;      // REGISTRY_MACHINE * -> index
+
+    struct registry_db_binary_header h = {
+        .version = REGISTRY_DB_BINARY_VERSION,
+        .persons_count = registry.persons_count,
+        .machines_count = registry.machines_count,
+        .usages_count = registry.usages_count + 1, // this is required - it is lost on db rotation
+        .persons_urls_count = registry.persons_urls_count,
+        .machines_urls_count = registry.machines_urls_count,
+    };
+    memcpy(h.magic, REGISTRY_DB_BINARY_MAGIC, sizeof(h.magic));
+
+    // index the strings and count everything
+
+    REGISTRY_MACHINE *m;
+    dfe_start_read(registry.machines, m) {
+        h.machines++;
+        for(REGISTRY_MACHINE_URL *mu = m->machine_urls; mu ; mu = mu->next) {
+            registry_db_binary_string_index(&st, mu->url);
+            h.machine_urls++;
+        }
+    }
+    dfe_done(m);
+
+    REGISTRY_PERSON *p;
+    dfe_start_read(registry.persons, p) {
+        h.persons++;
+        for(REGISTRY_PERSON_URL *pu = p->person_urls; pu ; pu = pu->next) {
+            registry_db_binary_string_index(&st, pu->machine_name);
+            registry_db_binary_string_index(&st, pu->url);
+            h.person_urls++;
+        }
+    }
+    dfe_done(p);
+
+    h.strings = st.used;
+    h.strings_bytes = st.bytes;
+
+    fwrite(&h, sizeof(h), 1, fp);
+
+    for(size_t i = 0; i < st.used ;i++)
+        fwrite(string2str(st.array[i]), string_strlen(st.array[i]) + 1, 1, fp);
+
+    // the machines
+
+    Word_t machine_index = 0;
+    dfe_start_read(registry.machines, m) {
+        Pvoid_t *PValue = JudyLIns(&machines_JudyL, (Word_t)m, PJE0);
+        *PValue = (void *)machine_index++;
+
+        struct registry_db_binary_entry e = {
+            .first_t = m->first_t,
+            .last_t = m->last_t,
+            .usages = m->usages,
+        };
+        memcpy(e.guid, m->guid, sizeof(e.guid));
+
+        for(REGISTRY_MACHINE_URL *mu = m->machine_urls; mu ; mu = mu->next)
+            e.urls++;
+
+        fwrite(&e, sizeof(e), 1, fp);
+
+        REGISTRY_MACHINE_URL *mu;
+        registry_db_binary_foreach_url_reverse(m->machine_urls, mu) {
+            struct registry_db_binary_machine_url r = {
+                .url = registry_db_binary_string_index(&st, mu->url),
+                .first_t = mu->first_t,
+                .last_t = mu->last_t,
+                .usages = mu->usages,
+                .flags = mu->flags,
+            };
+            fwrite(&r, sizeof(r), 1, fp);
+        }
+    }
+    dfe_done(m);
+
+    // the persons
+
+    dfe_start_read(registry.persons, p) {
+        struct registry_db_binary_entry e = {
+            .first_t = p->first_t,
+            .last_t = p->last_t,
+            .usages = p->usages,
+        };
+        memcpy(e.guid, p->guid, sizeof(e.guid));
+
+        for(REGISTRY_PERSON_URL *pu = p->person_urls; pu ; pu = pu->next)
+            e.urls++;
+
+        fwrite(&e, sizeof(e), 1, fp);
+
+        REGISTRY_PERSON_URL *pu;
+        registry_db_binary_foreach_url_reverse(p->person_urls, pu) {
+            Pvoid_t *PValue = JudyLGet(machines_JudyL, (Word_t)pu->machine, PJE0);
+
+            struct registry_db_binary_person_url r = {
+                .machine = PValue ? (uint32_t)(Word_t)*PValue : UINT32_MAX,
+                .machine_name = registry_db_binary_string_index(&st, pu->machine_name),
+                .url = registry_db_binary_string_index(&st, pu->url),
+                .first_t = pu->first_t,
+                .last_t = pu->last_t,
+                .usages = pu->usages,
+                .flags = pu->flags,
+            };
+            fwrite(&r, sizeof(r), 1, fp);
+        }
+    }
+    dfe_done(p);
+
+    JudyLFreeArray(&machines_JudyL, PJE0);
+    JudyLFreeArray(&st.JudyL, PJE0);
+    freez(st.array);
+
+    if(ferror(fp)) {
+        netdata_log_error("REGISTRY: Cannot write the binary registry db");
+        return -1;
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// SAVE THE REGISTRY DATABASE
+
+int registry_db_save(void) {
+    if(unlikely(!registry.enabled))
+        return -1;
+
+    if(unlikely(!registry_db_should_be_saved()))
+        return -2;
+
+    nd_log_limits_unlimited();
+
+    char tmp_filename[FILENAME_MAX + 1];
+    char old_filename[FILENAME_MAX + 1];
+
+    snprintfz(old_filename, FILENAME_MAX, "%s.old", registry.db_filename);
+    snprintfz(tmp_filename, FILENAME_MAX, "%s.tmp", registry.db_filename);
+
+    netdata_log_debug(D_REGISTRY, "REGISTRY: Creating file '%s'", tmp_filename);
+    FILE *fp = fopen(tmp_filename, "w");
+    if(!fp) {
+        netdata_log_error("REGISTRY: Cannot create file: %s", tmp_filename);
+        nd_log_limits_reset();
+        return -1;
+    }
+
+    int rc = registry.db_binary ? registry_db_save_binary(fp) : registry_db_save_text(fp);
+    if(rc < 0) {
+        fclose(fp);
+        nd_log_limits_reset();
+        return rc;
+    }
+
     fclose(fp);
 
     errno_clear();
@@ -209,6 +431,157 @@ int registry_db_save(void) {
     return -1;
 }
 
+// ----------------------------------------------------------------------------
+// LOAD THE BINARY REGISTRY DATABASE
+
+static size_t registry_db_load_binary(int fd, size_t size) {
+    const struct registry_db_binary_header *h;
+    STRING **strings = NULL;
+    REGISTRY_MACHINE **machines = NULL;
+    size_t records = 0, i = 0;
+
+    uint8_t *mem = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mem == MAP_FAILED) {
+        netdata_log_error("REGISTRY: cannot mmap() registry file: '%s'", registry.db_filename);
+        return 0;
+    }
+    madvise_sequential(mem, size);
+
+    const uint8_t *pos = mem, *end = mem + size;
+
+#define registry_db_binary_need(bytes) do {                                                          \
+        if((size_t)(end - pos) < (size_t)(bytes)) {                                                 \
+            netdata_log_error("REGISTRY: binary registry file '%s' is truncated", registry.db_filename); \
+            goto cleanup;                                                                           \
+        }                                                                                           \
+    } while(0)
+
+    registry_db_binary_need(sizeof(*h));
+    h = (const struct registry_db_binary_header *)pos;
+    pos += sizeof(*h);
+
+    if(h->version != REGISTRY_DB_BINARY_VERSION) {
+        netdata_log_error("REGISTRY: binary registry file '%s' has unknown version %u", registry.db_filename, h->version);
+        goto cleanup;
+    }
+
+    // the string table - every string is interned once
+
+    registry_db_binary_need(h->strings_bytes);
+    if(h->strings > h->strings_bytes || h->machines > size || h->persons > size) {
+        netdata_log_error("REGISTRY: binary registry file '%s' has an invalid header", registry.db_filename);
+        goto cleanup;
+    }
+
+    const char *table_end = (const char *)pos + h->strings_bytes;
+    strings = mallocz((h->strings ? h->strings : 1) * sizeof(STRING *));
+    for(i = 0; i < h->strings ;i++) {
+        const char *s = (const char *)pos;
+        const char *nul = memchr(s, '\0', table_end - s);
+        if(!nul) {
+            netdata_log_error("REGISTRY: binary registry file '%s' has a corrupted string table", registry.db_filename);
+            goto cleanup;
+        }
+
+        strings[i] = string_strdupz(s);
+        pos = (const uint8_t *)nul + 1;
+    }
+    pos = (const uint8_t *)table_end;
+
+    // the machines
+
+    machines = mallocz((h->machines ? h->machines : 1) * sizeof(REGISTRY_MACHINE *));
+    for(size_t mi = 0; mi < h->machines ;mi++) {
+        struct registry_db_binary_entry e;
+        registry_db_binary_need(sizeof(e));
+        memcpy(&e, pos, sizeof(e));
+        pos += sizeof(e);
+
+        char guid[GUID_LEN + 1];
+        memcpy(guid, e.guid, GUID_LEN);
+        guid[GUID_LEN] = '\0';
+
+        REGISTRY_MACHINE *m = machines[mi] = registry_machine_allocate(guid, e.first_t);
+        m->last_t = e.last_t;
+        m->usages = e.usages;
+        records++;
+
+        registry_db_binary_need((size_t)e.urls * sizeof(struct registry_db_binary_machine_url));
+        for(uint32_t u = 0; u < e.urls ;u++) {
+            struct registry_db_binary_machine_url r;
+            memcpy(&r, pos, sizeof(r));
+            pos += sizeof(r);
+
+            if(r.url >= h->strings)
+                continue;
+
+            REGISTRY_MACHINE_URL *mu = registry_machine_url_allocate(m, strings[r.url], r.first_t);
+            mu->last_t = r.last_t;
+            mu->usages = r.usages;
+            mu->flags = r.flags;
+            records++;
+        }
+    }
+
+    // the persons
+
+    for(size_t pi = 0; pi < h->persons ;pi++) {
+        struct registry_db_binary_entry e;
+        registry_db_binary_need(sizeof(e));
+        memcpy(&e, pos, sizeof(e));
+        pos += sizeof(e);
+
+        char guid[GUID_LEN + 1];
+        memcpy(guid, e.guid, GUID_LEN);
+        guid[GUID_LEN] = '\0';
+
+        REGISTRY_PERSON *p = registry_person_allocate(guid, e.first_t);
+        p->last_t = e.last_t;
+        p->usages = e.usages;
+        records++;
+
+        registry_db_binary_need((size_t)e.urls * sizeof(struct registry_db_binary_person_url));
+        for(uint32_t u = 0; u < e.urls ;u++) {
+            struct registry_db_binary_person_url r;
+            memcpy(&r, pos, sizeof(r));
+            pos += sizeof(r);
+
+            if(r.machine >= h->machines || r.url >= h->strings || r.machine_name >= h->strings) {
+                netdata_log_error("REGISTRY: ignoring invalid url of person '%s' in binary registry file '%s'", p->guid, registry.db_filename);
+                continue;
+            }
+
+            STRING *name = strings[r.machine_name];
+            REGISTRY_PERSON_URL *pu = registry_person_url_allocate(
+                p, machines[r.machine], strings[r.url], (char *)string2str(name), string_strlen(name), r.first_t);
+            pu->last_t = r.last_t;
+            pu->usages = r.usages;
+            pu->flags = r.flags;
+            records++;
+        }
+    }
+
+#undef registry_db_binary_need
+
+    registry.persons_count = h->persons_count;
+    registry.machines_count = h->machines_count;
+    registry.usages_count = h->usages_count;
+    registry.persons_urls_count = h->persons_urls_count;
+    registry.machines_urls_count = h->machines_urls_count;
+
+cleanup:
+    // the objects hold their own references to the strings
+    for(size_t s = 0; strings && s < i ;s++)
+        string_freez(strings[s]);
+
+    freez(strings);
+    freez(machines);
+    munmap(mem, size);
+
+    netdata_log_debug(D_REGISTRY, "REGISTRY: loaded %zu records from binary db", records);
+    return records;
+}
+
 // ----------------------------------------------------------------------------
 // LOAD THE REGISTRY DATABASE
 
@@ -227,6 +600,15 @@ size_t registry_db_load(void) {
         return 0;
     }
 
+    char magic[sizeof(REGISTRY_DB_BINARY_MAGIC) - 1];
+    if(fread(magic, sizeof(magic), 1, fp) == 1 && !memcmp(magic, REGISTRY_DB_BINARY_MAGIC, sizeof(magic))) {
+        struct stat st;
+        line = (fstat(fileno(fp), &st) == 0) ? registry_db_load_binary(fileno(fp), (size_t)st.st_size) : 0;
+        fclose(fp);
+        return line;
+    }
+    rewind(fp);
+
     REGISTRY_MACHINE_URL *mu;
     size_t len = 0;
     buf[4096] = '\0';
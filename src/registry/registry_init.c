@@ -87,6 +87,7 @@ int registry_init(void) {
 
     snprintfz(filename, FILENAME_MAX, "%s/registry.db", registry.pathname);
     registry.db_filename = config_get(CONFIG_SECTION_REGISTRY, "registry db file", filename);
+    registry.db_binary = config_get_boolean(CONFIG_SECTION_REGISTRY, "registry db binary format", 1);
 
     snprintfz(filename, FILENAME_MAX, "%s/registry-log.db", registry.pathname);
     registry.log_filename = config_get(CONFIG_SECTION_REGISTRY, "registry log file", filename);
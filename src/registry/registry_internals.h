@@ -37,6 +37,7 @@ struct registry {
     time_t persons_expiration; // seconds to expire idle persons
     int verify_cookies_redirects;
     int enable_cookies_samesite_secure;
+    int db_binary;
 
     size_t max_url_length;
     size_t max_name_length;
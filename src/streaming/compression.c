@@ -24,6 +24,54 @@ int rrdpush_compression_levels[COMPRESSION_ALGORITHM_MAX] = {
         [COMPRESSION_ALGORITHM_GZIP]    = 1,    // 1 (faster)  -  9 (smaller)
 };
 
+// ----------------------------------------------------------------------------
+// the protocol dictionary
+//
+// A new connection has no history to find matches in, so the first messages
+// (chart and dimension definitions, labels, the first data collections) compress
+// poorly. Compressors that support it start with this text as their history.
+// Frequent strings are near the end, where matches are cheaper.
+
+const char rrdpush_compression_dictionary[] =
+        "HOST_DEFINE HOST_DEFINE_END HOST_LABEL NODE_ID CLAIMED_ID FUNCTION FUNCTION_PROGRESS FUNCTION_RESULT_BEGIN "
+        "FUNCTION_RESULT_END CONFIG DYNCFG_ENABLE DYNCFG_REGISTER_MODULE DYNCFG_REGISTER_JOB DYNCFG_RESET "
+        "REPORT_JOB_STATUS DELETE_JOB VARIABLE CHART VARIABLE HOST LABEL OVERWRITE "
+        "'_os_name' '_os_version' '_kernel_version' '_architecture' '_virtualization' '_container' "
+        "'_is_parent' '_is_ephemeral' '_is_k8s_node' '_hostname' '_timezone' '_net_default_iface_ip' "
+        "'application/json' 'text/plain' "
+        "'bits/s' 'kilobits/s' 'megabits/s' 'bytes/s' 'KiB/s' 'MiB/s' 'packets/s' 'errors/s' 'drops/s' "
+        "'operations/s' 'requests/s' 'events/s' 'connections/s' 'interrupts/s' 'milliseconds' 'seconds' "
+        "'percentage' 'processes' 'threads' 'files' 'sockets' 'children' 'KiB' 'MiB' 'GiB' "
+        "'system.' 'cpu.' 'mem.' 'disk.' 'disk_space.' 'disk_inodes.' 'net.' 'ip.' 'ipv4.' 'ipv6.' "
+        "'apps.' 'users.' 'groups.' 'cgroup.' 'k8s.' 'netdata.' 'services.' 'ebpf.' 'docker.' "
+        "'proc.plugin' 'apps.plugin' 'cgroups.plugin' 'diskspace.plugin' 'go.d.plugin' 'python.d.plugin' "
+        "'ebpf.plugin' 'systemd-journal.plugin' 'network-viewer.plugin' 'statsd.plugin' 'netdata' "
+        "'/proc/stat' '/proc/meminfo' '/proc/diskstats' '/proc/net/dev' '/proc/vmstat' "
+        "'user' 'system' 'nice' 'idle' 'iowait' 'irq' 'softirq' 'steal' 'guest' 'guest_nice' "
+        "'used' 'free' 'cached' 'buffers' 'avail' 'reserved' 'in' 'out' 'received' 'sent' "
+        "'reads' 'writes' 'read' 'write' 'inbound' 'outbound' 'errors' 'dropped' 'total' "
+        "'line' 'area' 'stacked' 'heatmap' 'obsolete' 'detail' 'hidden' 'noreset' 'nooverflow' "
+        "'store_first' 'absolute' 'incremental' 'percentage-of-absolute-row' "
+        "CLABEL '_collect_plugin' '_collect_module' '_instance_family' 'device' 'mount_point' "
+        "'filesystem' 'interface_type' 'cgroup_name' 'image' 'container_name' 1\n"
+        "CLABEL_COMMIT\n"
+        "CHART_DEFINITION_END\n"
+        "RBEGIN RSET RDSTATE RSSTATE REND\n"
+        "CHART '' '' '' '' '' line 1000 1 '' '' ''\n"
+        "DIMENSION '' '' absolute 1 1 ''\n"
+        "DIMENSION '' '' incremental 1 1 ''\n"
+        "BEGIN2 SLOT: '' 1 #\n"
+        "SET2 SLOT: '' # A\n"
+        "END2\n"
+        "BEGIN2 SLOT:\n"
+        "SET2 SLOT: # A\n"
+        "SET2 SLOT: # A\n"
+        "END2\n";
+
+const size_t rrdpush_compression_dictionary_size = sizeof(rrdpush_compression_dictionary) - 1;
+
+// ----------------------------------------------------------------------------
+
 void rrdpush_parse_compression_order(struct receiver_state *rpt, const char *order) {
     // empty all slots
     for(size_t i = 0; i < COMPRESSION_ALGORITHM_MAX ;i++)
@@ -110,6 +158,7 @@ bool rrdpush_compression_initialize(struct sender_state *s) {
 
     if(s->compressor.algorithm != COMPRESSION_ALGORITHM_NONE) {
         s->compressor.level = rrdpush_compression_levels[s->compressor.algorithm];
+        s->compressor.dictionary = stream_has_capability(s, STREAM_CAP_DICTIONARY);
         rrdpush_compressor_init(&s->compressor);
         return true;
     }
@@ -135,6 +184,7 @@ bool rrdpush_decompression_initialize(struct receiver_state *rpt) {
         rpt->decompressor.algorithm = COMPRESSION_ALGORITHM_NONE;
 
     if(rpt->decompressor.algorithm != COMPRESSION_ALGORITHM_NONE) {
+        rpt->decompressor.dictionary = stream_has_capability(rpt, STREAM_CAP_DICTIONARY);
         rrdpush_decompressor_init(&rpt->decompressor);
         return true;
     }
@@ -78,8 +78,14 @@ static inline void simple_ring_buffer_destroy(SIMPLE_RING_BUFFER *b) {
 
 // ----------------------------------------------------------------------------
 
+// the built-in dictionary both peers load when they negotiate STREAM_CAP_DICTIONARY
+// changing it breaks the compatibility with the peers having the old one
+extern const char rrdpush_compression_dictionary[];
+extern const size_t rrdpush_compression_dictionary_size;
+
 struct compressor_state {
     bool initialized;
+    bool dictionary;                    // start with rrdpush_compression_dictionary
     compression_algorithm_t algorithm;
 
     SIMPLE_RING_BUFFER input;
@@ -103,6 +109,7 @@ size_t rrdpush_compress(struct compressor_state *state, const char *data, size_t
 
 struct decompressor_state {
     bool initialized;
+    bool dictionary;                    // start with rrdpush_compression_dictionary
     compression_algorithm_t algorithm;
     size_t signature_size;
 
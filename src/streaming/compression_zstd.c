@@ -20,6 +20,13 @@ void rrdpush_compressor_init_zstd(struct compressor_state *state) {
         if(ZSTD_isError(ret))
             netdata_log_error("STREAM: ZSTD_initCStream() returned error: %s", ZSTD_getErrorName(ret));
 
+        // ZSTD_initCStream() clears the dictionary, so load it after it
+        if(state->dictionary) {
+            ret = ZSTD_CCtx_loadDictionary(state->stream, rrdpush_compression_dictionary, rrdpush_compression_dictionary_size);
+            if(ZSTD_isError(ret))
+                netdata_log_error("STREAM: ZSTD_CCtx_loadDictionary() returned error: %s", ZSTD_getErrorName(ret));
+        }
+
         // ZSTD_CCtx_setParameter(state->stream, ZSTD_c_compressionLevel, 1);
         // ZSTD_CCtx_setParameter(state->stream, ZSTD_c_strategy, ZSTD_fast);
     }
@@ -101,6 +108,13 @@ void rrdpush_decompressor_init_zstd(struct decompressor_state *state) {
         if(ZSTD_isError(ret))
             netdata_log_error("STREAM: ZSTD_initDStream() returned error: %s", ZSTD_getErrorName(ret));
 
+        // ZSTD_initDStream() clears the dictionary, so load it after it
+        if(state->dictionary) {
+            ret = ZSTD_DCtx_loadDictionary(state->stream, rrdpush_compression_dictionary, rrdpush_compression_dictionary_size);
+            if(ZSTD_isError(ret))
+                netdata_log_error("STREAM: ZSTD_DCtx_loadDictionary() returned error: %s", ZSTD_getErrorName(ret));
+        }
+
         simple_ring_buffer_make_room(&state->output, MAX(COMPRESSION_MAX_CHUNK, ZSTD_DStreamOutSize()));
     }
 }
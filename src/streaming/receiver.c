@@ -5,7 +5,81 @@
 
 extern struct config stream_config;
 
+// ----------------------------------------------------------------------------
+// admission control
+//
+// The parent limits the children in the handshake phase, so that a storm of
+// connections (e.g. all children restarting at once) is accepted gradually.
+// The rest are asked to try later and reconnect after their reconnect delay.
+
+static struct {
+    size_t handshakes;                  // the children in the handshake phase
+    size_t rejected;                    // the children asked to try later
+} receiver_admission = {
+    .handshakes = 0,
+    .rejected = 0,
+};
+
+bool rrdpush_receiver_admission_handshake_start(struct receiver_state *rpt) {
+    size_t handshakes = __atomic_add_fetch(&receiver_admission.handshakes, 1, __ATOMIC_RELAXED);
+    if(rrdpush_receiver_max_handshakes && handshakes > rrdpush_receiver_max_handshakes) {
+        __atomic_sub_fetch(&receiver_admission.handshakes, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    rpt->admission.handshaking = true;
+    return true;
+}
+
+void rrdpush_receiver_admission_handshake_done(struct receiver_state *rpt) {
+    if(!rpt->admission.handshaking)
+        return;
+
+    rpt->admission.handshaking = false;
+    __atomic_sub_fetch(&receiver_admission.handshakes, 1, __ATOMIC_RELAXED);
+}
+
+size_t rrdpush_receiver_admission_handshakes(void) {
+    return __atomic_load_n(&receiver_admission.handshakes, __ATOMIC_RELAXED);
+}
+
+size_t rrdpush_receiver_admission_rejected(void) {
+    return __atomic_load_n(&receiver_admission.rejected, __ATOMIC_RELAXED);
+}
+
+void rrdpush_receiver_admission_rejected_one(void) {
+    __atomic_add_fetch(&receiver_admission.rejected, 1, __ATOMIC_RELAXED);
+}
+
+// true when the child has read all the bytes it is allowed to read in this second
+static inline bool receiver_admission_throttled(struct receiver_state *r, time_t now_s) {
+    if(likely(!rrdpush_receiver_max_bytes_per_sec))
+        return false;
+
+    if(r->admission.window_s != now_s) {
+        r->admission.window_s = now_s;
+        r->admission.window_bytes = 0;
+        return false;
+    }
+
+    return r->admission.window_bytes >= rrdpush_receiver_max_bytes_per_sec;
+}
+
+static inline void receiver_admission_bytes_read(struct receiver_state *r, size_t bytes) {
+    if(likely(!rrdpush_receiver_max_bytes_per_sec))
+        return;
+
+    size_t before = r->admission.window_bytes;
+    r->admission.window_bytes += bytes;
+
+    if(before < rrdpush_receiver_max_bytes_per_sec && r->admission.window_bytes >= rrdpush_receiver_max_bytes_per_sec)
+        __atomic_add_fetch(&r->admission.throttled, 1, __ATOMIC_RELAXED);
+}
+
+// ----------------------------------------------------------------------------
+
 void receiver_state_free(struct receiver_state *rpt) {
+    rrdpush_receiver_admission_handshake_done(rpt);
     netdata_ssl_close(&rpt->ssl);
 
     if(rpt->fd != -1) {
@@ -15,6 +89,10 @@ void receiver_state_free(struct receiver_state *rpt) {
 
     rrdpush_decompressor_destroy(&rpt->decompressor);
 
+    buffer_free(rpt->pool.line);
+    freez(rpt->pool.compressed);
+    freez(rpt->cd);
+
     if(rpt->system_info)
         rrdhost_system_info_free(rpt->system_info);
 
@@ -47,6 +125,9 @@ void receiver_state_free(struct receiver_state *rpt) {
 #error The define WORKER_PARSER_FIRST_JOB needs to be at least 1
 #endif
 
+// children not sending anything for this long are disconnected
+#define RECEIVER_SOCKET_READ_TIMEOUT_S 600
+
 static inline int read_stream(struct receiver_state *r, char* buffer, size_t size) {
     if(unlikely(!size)) {
         internal_error(true, "%s() asked to read zero bytes", __FUNCTION__);
@@ -62,6 +143,14 @@ static inline int read_stream(struct receiver_state *r, char* buffer, size_t siz
     }
 #endif
 
+    // the child has read its bytes for this second, wait for the next one
+    while(unlikely(receiver_admission_throttled(r, now_monotonic_sec()))) {
+        if(nd_thread_signaled_to_cancel())
+            return -4;
+
+        sleep_usec(50 * USEC_PER_MS);
+    }
+
     int tries = 100;
     ssize_t bytes_read;
 
@@ -108,6 +197,8 @@ static inline int read_stream(struct receiver_state *r, char* buffer, size_t siz
         netdata_log_error("STREAM: %s() failed to read from socket!", __FUNCTION__);
         bytes_read = -2;
     }
+    else
+        receiver_admission_bytes_read(r, (size_t)bytes_read);
 
     return (int)bytes_read;
 }
@@ -303,9 +394,7 @@ static inline bool receiver_should_stop(struct receiver_state *rpt) {
     return false;
 }
 
-static size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, int fd, void *ssl) {
-    size_t result = 0;
-
+static PARSER *streaming_parser_start(struct receiver_state *rpt, struct plugind *cd, int fd, void *ssl, bool *compressed_connection) {
     PARSER *parser = NULL;
     {
         PARSER_USER_OBJECT user = {
@@ -328,7 +417,7 @@ static size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, i
 
     rrd_collector_started();
 
-    bool compressed_connection = rrdpush_decompression_initialize(rpt);
+    *compressed_connection = rrdpush_decompression_initialize(rpt);
     buffered_reader_init(&rpt->reader);
 
 #ifdef NETDATA_LOG_STREAM_RECEIVE
@@ -342,6 +431,200 @@ static size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, i
     }
 #endif
 
+    return parser;
+}
+
+static size_t streaming_parser_stop(PARSER *parser) {
+    // make sure send_to_plugin() will not write any data to the socket
+    spinlock_lock(&parser->writer.spinlock);
+    parser->fd_output = -1;
+    parser->ssl_output = NULL;
+    spinlock_unlock(&parser->writer.spinlock);
+
+    return parser->user.data_collections_count;
+}
+
+// ----------------------------------------------------------------------------
+// receiver pipeline
+//
+// When enabled, a child is served by two threads: one reads the socket and
+// decompresses, the other parses and stores. The first one hands over what
+// it reads in blocks, through a fixed ring of them, so the lines reach the
+// parser in the order they were sent.
+
+#define RECEIVER_PIPELINE_BLOCKS 16
+#define RECEIVER_PIPELINE_WAIT_MS 100
+
+struct receiver_pipeline_block {
+    ssize_t len;
+    char data[sizeof(((struct buffered_reader *)0)->read_buffer)];
+};
+
+struct receiver_pipeline {
+    struct receiver_state *rpt;
+    bool compressed_connection;
+    ND_THREAD *thread;
+
+    netdata_mutex_t mutex;
+    pthread_cond_t cond;                // signaled when a block is filled or emptied
+
+    size_t head;                        // the next block to be filled by the reader
+    size_t tail;                        // the next block to be parsed
+    bool stop;                          // the parser does not need more data
+    bool failed;                        // the reader cannot read more data
+    STREAM_HANDSHAKE reason;            // why the reader failed
+
+    struct receiver_pipeline_block blocks[RECEIVER_PIPELINE_BLOCKS];
+};
+
+static void receiver_worker_register(void);
+
+static void receiver_pipeline_timed_wait(struct receiver_pipeline *p) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += RECEIVER_PIPELINE_WAIT_MS * NSEC_PER_MSEC;
+    if(ts.tv_nsec >= (long)NSEC_PER_SEC) {
+        ts.tv_sec++;
+        ts.tv_nsec -= NSEC_PER_SEC;
+    }
+    pthread_cond_timedwait(&p->cond, &p->mutex, &ts);
+}
+
+static void *receiver_pipeline_reader_main(void *ptr) {
+    struct receiver_pipeline *p = ptr;
+    struct receiver_state *rpt = p->rpt;
+
+    receiver_worker_register();
+
+    while(true) {
+        STREAM_HANDSHAKE reason = STREAM_HANDSHAKE_DISCONNECT_UNKNOWN_SOCKET_READ_ERROR;
+
+        bool have_new_data = p->compressed_connection ? receiver_read_compressed(rpt, &reason)
+                                                      : receiver_read_uncompressed(rpt, &reason);
+
+        netdata_mutex_lock(&p->mutex);
+
+        if(unlikely(!have_new_data)) {
+            p->failed = true;
+            p->reason = reason;
+            pthread_cond_signal(&p->cond);
+            netdata_mutex_unlock(&p->mutex);
+            break;
+        }
+
+        // wait for a free block
+        while(!p->stop && p->head - p->tail >= RECEIVER_PIPELINE_BLOCKS) {
+            worker_is_idle();
+            receiver_pipeline_timed_wait(p);
+        }
+
+        if(p->stop) {
+            netdata_mutex_unlock(&p->mutex);
+            break;
+        }
+
+        netdata_mutex_unlock(&p->mutex);
+
+        // only the reader fills the block at head, no need to lock for copying to it
+        struct receiver_pipeline_block *b = &p->blocks[p->head % RECEIVER_PIPELINE_BLOCKS];
+        memcpy(b->data, rpt->reader.read_buffer, rpt->reader.read_len);
+        b->len = rpt->reader.read_len;
+
+        rpt->reader.read_len = 0;
+        rpt->reader.pos = 0;
+        rpt->reader.read_buffer[0] = '\0';
+
+        netdata_mutex_lock(&p->mutex);
+        p->head++;
+        pthread_cond_signal(&p->cond);
+        netdata_mutex_unlock(&p->mutex);
+    }
+
+    worker_unregister();
+    return NULL;
+}
+
+static struct receiver_pipeline *receiver_pipeline_start(struct receiver_state *rpt, bool compressed_connection) {
+    struct receiver_pipeline *p = callocz(1, sizeof(*p));
+    p->rpt = rpt;
+    p->compressed_connection = compressed_connection;
+    netdata_mutex_init(&p->mutex);
+    pthread_cond_init(&p->cond, NULL);
+
+    char tag[NETDATA_THREAD_TAG_MAX + 1];
+    snprintfz(tag, NETDATA_THREAD_TAG_MAX, THREAD_TAG_STREAM_RECEIVER "-RD[%s]", rpt->hostname);
+
+    p->thread = nd_thread_create(tag, NETDATA_THREAD_OPTION_DEFAULT, receiver_pipeline_reader_main, p);
+    if(!p->thread) {
+        netdata_log_error("STREAM '%s': cannot start the reader thread of the receiver pipeline, "
+                          "parsing on the same thread", rpt->hostname);
+        pthread_cond_destroy(&p->cond);
+        netdata_mutex_destroy(&p->mutex);
+        freez(p);
+        return NULL;
+    }
+
+    return p;
+}
+
+static void receiver_pipeline_stop(struct receiver_pipeline *p) {
+    netdata_mutex_lock(&p->mutex);
+    p->stop = true;
+    pthread_cond_signal(&p->cond);
+    netdata_mutex_unlock(&p->mutex);
+
+    // the reader may be waiting for data on the socket
+    nd_thread_signal_cancel(p->thread);
+    nd_thread_join(p->thread);
+
+    pthread_cond_destroy(&p->cond);
+    netdata_mutex_destroy(&p->mutex);
+    freez(p);
+}
+
+// moves the next block of the reader to dst
+// returns false when the child has to be disconnected
+static bool receiver_pipeline_next(struct receiver_pipeline *p, struct buffered_reader *dst, STREAM_HANDSHAKE *reason) {
+    netdata_mutex_lock(&p->mutex);
+
+    while(p->head == p->tail) {
+        if(p->failed) {
+            *reason = p->reason;
+            netdata_mutex_unlock(&p->mutex);
+            return false;
+        }
+
+        if(receiver_should_stop(p->rpt)) {
+            *reason = p->rpt->exit.reason;
+            netdata_mutex_unlock(&p->mutex);
+            return false;
+        }
+
+        worker_is_idle();
+        receiver_pipeline_timed_wait(p);
+    }
+
+    netdata_mutex_unlock(&p->mutex);
+
+    // only the parser empties the block at tail, no need to lock for copying from it
+    struct receiver_pipeline_block *b = &p->blocks[p->tail % RECEIVER_PIPELINE_BLOCKS];
+    memcpy(dst->read_buffer, b->data, b->len);
+    dst->read_len = b->len;
+    dst->pos = 0;
+    dst->read_buffer[dst->read_len] = '\0';
+
+    netdata_mutex_lock(&p->mutex);
+    p->tail++;
+    pthread_cond_signal(&p->cond);
+    netdata_mutex_unlock(&p->mutex);
+
+    return true;
+}
+
+static size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, int fd, void *ssl) {
+    bool compressed_connection;
+    PARSER *parser = streaming_parser_start(rpt, cd, fd, ssl, &compressed_connection);
+
     CLEAN_BUFFER *buffer = buffer_create(sizeof(rpt->reader.read_buffer), NULL);
 
     ND_LOG_STACK lgs[] = {
@@ -356,13 +639,28 @@ static size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, i
     __atomic_store_n(&rpt->parser, parser, __ATOMIC_RELAXED);
     rrdpush_receiver_send_node_and_claim_id_to_child(rpt->host);
 
+    // with the pipeline, the socket is read by another thread, and the lines are parsed from this one
+    struct receiver_pipeline *pipeline = NULL;
+    struct buffered_reader *reader = &rpt->reader;
+    if(rrdpush_receiver_pipeline) {
+        pipeline = receiver_pipeline_start(rpt, compressed_connection);
+        if(pipeline) {
+            reader = mallocz(sizeof(*reader));
+            buffered_reader_init(reader);
+        }
+    }
+
     while(!receiver_should_stop(rpt)) {
 
-        if(!buffered_reader_next_line(&rpt->reader, buffer)) {
+        if(!buffered_reader_next_line(reader, buffer)) {
             STREAM_HANDSHAKE reason = STREAM_HANDSHAKE_DISCONNECT_UNKNOWN_SOCKET_READ_ERROR;
 
-            bool have_new_data = compressed_connection ? receiver_read_compressed(rpt, &reason)
-                                                       : receiver_read_uncompressed(rpt, &reason);
+            bool have_new_data;
+            if(pipeline)
+                have_new_data = receiver_pipeline_next(pipeline, reader, &reason);
+            else
+                have_new_data = compressed_connection ? receiver_read_compressed(rpt, &reason)
+                                                      : receiver_read_uncompressed(rpt, &reason);
 
             if(unlikely(!have_new_data)) {
                 receiver_set_exit_reason(rpt, reason, false);
@@ -381,14 +679,12 @@ static size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, i
         buffer->buffer[0] = '\0';
     }
 
-    // make sure send_to_plugin() will not write any data to the socket
-    spinlock_lock(&parser->writer.spinlock);
-    parser->fd_output = -1;
-    parser->ssl_output = NULL;
-    spinlock_unlock(&parser->writer.spinlock);
+    if(pipeline) {
+        receiver_pipeline_stop(pipeline);
+        freez(reader);
+    }
 
-    result = parser->user.data_collections_count;
-    return result;
+    return streaming_parser_stop(parser);
 }
 
 static void rrdpush_receiver_replication_reset(RRDHOST *host) {
@@ -516,7 +812,9 @@ bool stop_streaming_receiver(RRDHOST *host, STREAM_HANDSHAKE reason) {
             shutdown(host->receiver->fd, SHUT_RDWR);
         }
 
-        nd_thread_signal_cancel(host->receiver->thread);
+        // the threads of the receivers pool notice the shutdown of the socket
+        if(!host->receiver->pool.worker)
+            nd_thread_signal_cancel(host->receiver->thread);
     }
 
     int count = 2000;
@@ -580,7 +878,27 @@ void rrdpush_receive_log_status(struct receiver_state *rpt, const char *msg, con
                      );
 }
 
-static void rrdpush_receive(struct receiver_state *rpt)
+static void receiver_set_socket_blocking(struct receiver_state *rpt) {
+    // remove the non-blocking flag from the socket
+    if(sock_delnonblock(rpt->fd) < 0)
+        netdata_log_error("STREAM '%s' [receive from [%s]:%s]: "
+              "cannot remove the non-blocking flag from socket %d"
+              , rrdhost_hostname(rpt->host)
+              , rpt->client_ip, rpt->client_port
+              , rpt->fd);
+
+    struct timeval timeout;
+    timeout.tv_sec = RECEIVER_SOCKET_READ_TIMEOUT_S;
+    timeout.tv_usec = 0;
+    if (unlikely(setsockopt(rpt->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout) != 0))
+        netdata_log_error("STREAM '%s' [receive from [%s]:%s]: "
+              "cannot set timeout for socket %d"
+              , rrdhost_hostname(rpt->host)
+              , rpt->client_ip, rpt->client_port
+              , rpt->fd);
+}
+
+static bool rrdpush_receive_connect(struct receiver_state *rpt, struct plugind *cd, bool pooled)
 {
     rpt->config.mode = default_rrd_memory_mode;
     rpt->config.history = default_rrd_history_entries;
@@ -697,7 +1015,7 @@ static void rrdpush_receive(struct receiver_state *rpt)
                     RRDPUSH_STATUS_INTERNAL_SERVER_ERROR, NDLP_ERR);
 
             rrdpush_send_error_on_taken_over_connection(rpt, START_STREAMING_ERROR_INTERNAL_ERROR);
-            goto cleanup;
+            return false;
         }
 
         if (unlikely(rrdhost_flag_check(host, RRDHOST_FLAG_PENDING_CONTEXT_LOAD))) {
@@ -706,7 +1024,7 @@ static void rrdpush_receive(struct receiver_state *rpt)
                     RRDPUSH_STATUS_INITIALIZATION_IN_PROGRESS, NDLP_NOTICE);
 
             rrdpush_send_error_on_taken_over_connection(rpt, START_STREAMING_ERROR_INITIALIZATION);
-            goto cleanup;
+            return false;
         }
 
         // system_info has been consumed by the host structure
@@ -718,7 +1036,7 @@ static void rrdpush_receive(struct receiver_state *rpt)
                     RRDPUSH_STATUS_DUPLICATE_RECEIVER, NDLP_INFO);
 
             rrdpush_send_error_on_taken_over_connection(rpt, START_STREAMING_ERROR_ALREADY_STREAMING);
-            goto cleanup;
+            return false;
         }
     }
 
@@ -740,21 +1058,17 @@ static void rrdpush_receive(struct receiver_state *rpt)
 #endif // NETDATA_INTERNAL_CHECKS
 
 
-    struct plugind cd = {
-            .update_every = default_rrd_update_every,
-            .unsafe = {
-                    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
-                    .running = true,
-                    .enabled = true,
-            },
-            .started_t = now_realtime_sec(),
-    };
+    cd->update_every = default_rrd_update_every;
+    spinlock_init(&cd->unsafe.spinlock);
+    cd->unsafe.running = true;
+    cd->unsafe.enabled = true;
+    cd->started_t = now_realtime_sec();
 
     // put the client IP and port into the buffers used by plugins.d
-    snprintfz(cd.id,           CONFIG_MAX_NAME,  "%s:%s", rpt->client_ip, rpt->client_port);
-    snprintfz(cd.filename,     FILENAME_MAX,     "%s:%s", rpt->client_ip, rpt->client_port);
-    snprintfz(cd.fullfilename, FILENAME_MAX,     "%s:%s", rpt->client_ip, rpt->client_port);
-    snprintfz(cd.cmd,          PLUGINSD_CMD_MAX, "%s:%s", rpt->client_ip, rpt->client_port);
+    snprintfz(cd->id,           CONFIG_MAX_NAME,  "%s:%s", rpt->client_ip, rpt->client_port);
+    snprintfz(cd->filename,     FILENAME_MAX,     "%s:%s", rpt->client_ip, rpt->client_port);
+    snprintfz(cd->fullfilename, FILENAME_MAX,     "%s:%s", rpt->client_ip, rpt->client_port);
+    snprintfz(cd->cmd,          PLUGINSD_CMD_MAX, "%s:%s", rpt->client_ip, rpt->client_port);
 
     rrdpush_select_receiver_compression_algorithm(rpt);
 
@@ -793,7 +1107,7 @@ static void rrdpush_receive(struct receiver_state *rpt)
                 rrdpush_receive_log_status(
                         rpt, "cannot reply back, dropping connection",
                         RRDPUSH_STATUS_CANT_REPLY, NDLP_ERR);
-                goto cleanup;
+                return false;
             }
 #ifdef ENABLE_H2O
         }
@@ -804,23 +1118,17 @@ static void rrdpush_receive(struct receiver_state *rpt)
     unless_h2o_rrdpush(rpt)
 #endif
     {
-        // remove the non-blocking flag from the socket
-        if(sock_delnonblock(rpt->fd) < 0)
-            netdata_log_error("STREAM '%s' [receive from [%s]:%s]: "
-                  "cannot remove the non-blocking flag from socket %d"
-                  , rrdhost_hostname(rpt->host)
-                  , rpt->client_ip, rpt->client_port
-                  , rpt->fd);
-
-        struct timeval timeout;
-        timeout.tv_sec = 600;
-        timeout.tv_usec = 0;
-        if (unlikely(setsockopt(rpt->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout) != 0))
-            netdata_log_error("STREAM '%s' [receive from [%s]:%s]: "
-                  "cannot set timeout for socket %d"
-                  , rrdhost_hostname(rpt->host)
-                  , rpt->client_ip, rpt->client_port
-                  , rpt->fd);
+        if(pooled) {
+            // the receivers pool multiplexes non-blocking sockets
+            if(sock_setnonblock(rpt->fd) < 0)
+                netdata_log_error("STREAM '%s' [receive from [%s]:%s]: "
+                      "cannot set the non-blocking flag on socket %d"
+                      , rrdhost_hostname(rpt->host)
+                      , rpt->client_ip, rpt->client_port
+                      , rpt->fd);
+        }
+        else
+            receiver_set_socket_blocking(rpt);
     }
 
     rrdpush_receive_log_status(
@@ -839,9 +1147,10 @@ static void rrdpush_receive(struct receiver_state *rpt)
     // let it reconnect to parent immediately
     rrdpush_reset_destinations_postpone_time(rpt->host);
 
-    // receive data
-    size_t count = streaming_parser(rpt, &cd, rpt->fd, (rpt->ssl.conn) ? &rpt->ssl : NULL);
+    return true;
+}
 
+static void rrdpush_receive_disconnected(struct receiver_state *rpt, size_t count) {
     // the parser stopped
     receiver_set_exit_reason(rpt, STREAM_HANDSHAKE_DISCONNECT_PARSER_EXIT, false);
 
@@ -856,9 +1165,6 @@ static void rrdpush_receive(struct receiver_state *rpt)
     // in case we have cloud connection we inform cloud
     // a child disconnected
     aclk_host_state_update(rpt->host, 0, 1);
-
-cleanup:
-    ;
 }
 
 static bool stream_receiver_log_capabilities(BUFFER *wb, void *ptr) {
@@ -879,7 +1185,7 @@ static bool stream_receiver_log_transport(BUFFER *wb, void *ptr) {
     return true;
 }
 
-void *rrdpush_receiver_thread(void *ptr) {
+static void receiver_worker_register(void) {
     worker_register("STREAMRCV");
 
     worker_register_job_custom_metric(WORKER_RECEIVER_JOB_BYTES_READ,
@@ -893,6 +1199,542 @@ void *rrdpush_receiver_thread(void *ptr) {
     worker_register_job_custom_metric(WORKER_RECEIVER_JOB_REPLICATION_COMPLETION,
                                       "replication completion", "%",
                                       WORKER_METRIC_ABSOLUTE);
+}
+
+// ----------------------------------------------------------------------------
+// the receivers pool
+//
+// Once the handshake is done and the host is ready, the child is handed over
+// to one of a fixed number of threads, instead of keeping a thread of its own.
+// Each of these threads poll()s the sockets of its children and on every turn
+// it reads a limited number of buffers from each child that has data, so that
+// a busy child cannot starve the others. The parser state of each child lives
+// in its receiver_state, so it is resumed on the next turn.
+
+#define RECEIVER_POOL_READS_PER_TURN 4
+#define RECEIVER_POOL_POLL_TIMEOUT_MS 1000
+
+struct receiver_pool_worker {
+    ND_THREAD *thread;
+    size_t receivers;                   // the children assigned to this thread (atomic)
+    int wakeup[2];                      // a pipe to wake up the thread (0 = read, 1 = write)
+
+    SPINLOCK spinlock;
+    struct receiver_state *incoming;    // handed over, but not picked up by the thread yet
+
+    // accessed only by the thread
+    struct receiver_state *serving;
+    struct pollfd *fds;
+    size_t fds_size;
+};
+
+static struct {
+    SPINLOCK spinlock;
+    size_t threads;
+    struct receiver_pool_worker *workers;
+} receiver_pool = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .threads = 0,
+    .workers = NULL,
+};
+
+static void receiver_pool_wakeup(struct receiver_pool_worker *w) {
+    char c = 0;
+    if(write(w->wakeup[1], &c, 1) != 1 && errno != EAGAIN && errno != EWOULDBLOCK)
+        netdata_log_error("STREAM: cannot wake up a receivers pool thread");
+}
+
+static void receiver_pool_canceller(void *data) {
+    receiver_pool_wakeup(data);
+}
+
+// returns the bytes read, zero when there are no data available, or a read_stream() error code
+static inline int receiver_pool_read_socket(struct receiver_state *r, char *buffer, size_t size) {
+    if(unlikely(receiver_admission_throttled(r, now_monotonic_sec())))
+        return 0;
+
+    ssize_t bytes_read;
+    int tries = 100;
+
+    do {
+        errno_clear();
+
+        if (SSL_connection(&r->ssl))
+            bytes_read = netdata_ssl_read(&r->ssl, buffer, size);
+        else
+            bytes_read = read(r->fd, buffer, size);
+
+    } while(bytes_read < 0 && errno == EINTR && tries--);
+
+    if(bytes_read > 0) {
+        worker_set_metric(WORKER_RECEIVER_JOB_BYTES_READ, (NETDATA_DOUBLE)bytes_read);
+        r->last_msg_t = r->pool.last_read_s = now_monotonic_sec();
+        receiver_admission_bytes_read(r, (size_t)bytes_read);
+        return (int)bytes_read;
+    }
+
+    if(bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+
+    if (bytes_read == 0) {
+        netdata_log_error("STREAM: %s(): EOF while reading data from socket!", __FUNCTION__);
+        return -1;
+    }
+
+    netdata_log_error("STREAM: %s() failed to read from socket!", __FUNCTION__);
+    return -2;
+}
+
+// returns a positive number when it made progress, zero when it has to wait for more data,
+// or a negative number on failure, setting the reason
+static inline int receiver_pool_read_uncompressed(struct receiver_state *r, STREAM_HANDSHAKE *reason) {
+    int bytes_read = receiver_pool_read_socket(r, r->reader.read_buffer + r->reader.read_len, sizeof(r->reader.read_buffer) - r->reader.read_len - 1);
+    if(unlikely(bytes_read < 0)) {
+        *reason = read_stream_error_to_reason(bytes_read);
+        return -1;
+    }
+
+    if(bytes_read) {
+        worker_set_metric(WORKER_RECEIVER_JOB_BYTES_UNCOMPRESSED, (NETDATA_DOUBLE)bytes_read);
+
+        r->reader.read_len += bytes_read;
+        r->reader.read_buffer[r->reader.read_len] = '\0';
+    }
+
+    return bytes_read;
+}
+
+// like receiver_read_compressed(), but the signature and the compressed block may
+// arrive in pieces, over many turns
+static inline int receiver_pool_read_compressed(struct receiver_state *r, STREAM_HANDSHAKE *reason) {
+
+    internal_fatal(r->reader.read_buffer[r->reader.read_len] != '\0',
+                   "%s: read_buffer does not start with zero #2", __FUNCTION__ );
+
+    // first use any available uncompressed data
+    if (likely(rrdpush_decompressed_bytes_in_buffer(&r->decompressor))) {
+        STREAM_HANDSHAKE unused;
+        return receiver_read_compressed(r, &unused) ? 1 : -1;
+    }
+
+    if(!r->pool.compressed_size) {
+        // read the compression signature of the next block
+
+        if(unlikely(r->reader.read_len + r->decompressor.signature_size > sizeof(r->reader.read_buffer) - 1)) {
+            internal_error(true, "The last incomplete line does not leave enough room for the next compression header! "
+                                 "Already have %zd bytes in read_buffer.", r->reader.read_len);
+            return -1;
+        }
+
+        int bytes_read = receiver_pool_read_socket(r, &r->pool.signature[r->pool.signature_read], r->decompressor.signature_size - r->pool.signature_read);
+        if(unlikely(bytes_read <= 0)) {
+            *reason = read_stream_error_to_reason(bytes_read);
+            return bytes_read;
+        }
+
+        r->pool.signature_read += bytes_read;
+        if(r->pool.signature_read < r->decompressor.signature_size)
+            return bytes_read;
+
+        r->pool.signature_read = 0;
+
+        size_t compressed_message_size = rrdpush_decompressor_start(&r->decompressor, r->pool.signature, r->decompressor.signature_size);
+        if (unlikely(!compressed_message_size)) {
+            internal_error(true, "multiplexed uncompressed data in compressed stream!");
+            memcpy(r->reader.read_buffer + r->reader.read_len, r->pool.signature, r->decompressor.signature_size);
+            r->reader.read_len += (ssize_t)r->decompressor.signature_size;
+            r->reader.read_buffer[r->reader.read_len] = '\0';
+            return bytes_read;
+        }
+
+        if(unlikely(compressed_message_size > COMPRESSION_MAX_MSG_SIZE)) {
+            netdata_log_error("received a compressed message of %zu bytes, which is bigger than the max compressed message size supported of %zu. Ignoring message.",
+                              compressed_message_size, (size_t)COMPRESSION_MAX_MSG_SIZE);
+            return -1;
+        }
+
+        r->pool.compressed_size = compressed_message_size;
+        r->pool.compressed_read = 0;
+        return bytes_read;
+    }
+
+    // read the compressed block
+
+    int bytes_read = receiver_pool_read_socket(r, &r->pool.compressed[r->pool.compressed_read], r->pool.compressed_size - r->pool.compressed_read);
+    if(unlikely(bytes_read <= 0)) {
+        *reason = read_stream_error_to_reason(bytes_read);
+        return bytes_read;
+    }
+
+    r->pool.compressed_read += bytes_read;
+    if(r->pool.compressed_read < r->pool.compressed_size)
+        return bytes_read;
+
+    size_t compressed_bytes_read = r->pool.compressed_read;
+    r->pool.compressed_size = r->pool.compressed_read = 0;
+
+    // decompress the compressed block
+    size_t bytes_to_parse = rrdpush_decompress(&r->decompressor, r->pool.compressed, compressed_bytes_read);
+    if (unlikely(!bytes_to_parse)) {
+        internal_error(true, "no bytes to parse.");
+        return -1;
+    }
+
+    worker_set_metric(WORKER_RECEIVER_JOB_BYTES_UNCOMPRESSED, (NETDATA_DOUBLE)bytes_to_parse);
+
+    // fill read buffer with decompressed data
+    size_t len = rrdpush_decompressor_get(&r->decompressor, r->reader.read_buffer + r->reader.read_len, sizeof(r->reader.read_buffer) - r->reader.read_len - 1);
+    if (unlikely(!len)) {
+        internal_error(true, "decompressor returned zero length #2");
+        return -1;
+    }
+    r->reader.read_len += (int)len;
+    r->reader.read_buffer[r->reader.read_len] = '\0';
+
+    return bytes_read;
+}
+
+// one turn of a child: parse what it has sent, reading up to RECEIVER_POOL_READS_PER_TURN buffers
+// returns false when the child has to be disconnected
+static bool receiver_pool_process(struct receiver_state *rpt) {
+    PARSER *parser = rpt->parser;
+    BUFFER *buffer = rpt->pool.line;
+
+    ND_LOG_STACK lgs[] = {
+            ND_LOG_FIELD_CB(NDF_REQUEST, line_splitter_reconstruct_line, &parser->line),
+            ND_LOG_FIELD_CB(NDF_NIDL_NODE, parser_reconstruct_node, parser),
+            ND_LOG_FIELD_CB(NDF_NIDL_INSTANCE, parser_reconstruct_instance, parser),
+            ND_LOG_FIELD_CB(NDF_NIDL_CONTEXT, parser_reconstruct_context, parser),
+            ND_LOG_FIELD_END(),
+    };
+    ND_LOG_STACK_PUSH(lgs);
+
+    rrd_collector_switch(rpt->pool.collector);
+
+    bool ret = true;
+    size_t reads = 0;
+    rpt->pool.pending = false;
+
+    while(true) {
+        if(receiver_should_stop(rpt)) {
+            ret = false;
+            break;
+        }
+
+        if(!buffered_reader_next_line(&rpt->reader, buffer)) {
+            if(reads >= RECEIVER_POOL_READS_PER_TURN) {
+                // let the other children run, we will continue on the next turn
+                rpt->pool.pending = true;
+                break;
+            }
+
+            STREAM_HANDSHAKE reason = STREAM_HANDSHAKE_DISCONNECT_UNKNOWN_SOCKET_READ_ERROR;
+
+            int rc = rpt->pool.compressed_connection ? receiver_pool_read_compressed(rpt, &reason)
+                                                     : receiver_pool_read_uncompressed(rpt, &reason);
+
+            if(unlikely(rc < 0)) {
+                receiver_set_exit_reason(rpt, reason, false);
+                ret = false;
+                break;
+            }
+
+            if(!rc) {
+                // no more data for now
+                // openssl may have decrypted data poll() does not know about
+                rpt->pool.pending = SSL_connection(&rpt->ssl) && netdata_ssl_has_pending(&rpt->ssl);
+                break;
+            }
+
+            reads++;
+            continue;
+        }
+
+        if(unlikely(parser_action(parser, buffer->buffer))) {
+            receiver_set_exit_reason(rpt, STREAM_HANDSHAKE_DISCONNECT_PARSER_FAILED, false);
+            ret = false;
+            break;
+        }
+
+        buffer->len = 0;
+        buffer->buffer[0] = '\0';
+    }
+
+    rpt->pool.collector = rrd_collector_switch(NULL);
+    return ret;
+}
+
+static void receiver_pool_release(struct receiver_pool_worker *w, struct receiver_state *rpt) {
+    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(w->serving, rpt, pool.prev, pool.next);
+    __atomic_sub_fetch(&w->receivers, 1, __ATOMIC_RELAXED);
+
+    size_t count = streaming_parser_stop(rpt->parser);
+    rrdpush_receive_disconnected(rpt, count);
+
+    // the cleanup of the parser finishes the collector of this child
+    rrd_collector_switch(rpt->pool.collector);
+    rpt->pool.collector = NULL;
+
+    rrdhost_clear_receiver(rpt);
+    rrd_collector_switch(NULL);
+
+    rrdhost_set_is_parent_label();
+    receiver_state_free(rpt);
+}
+
+static void receiver_pool_serve(struct receiver_pool_worker *w, struct receiver_state *rpt, bool ready, time_t now_s) {
+    ND_LOG_STACK lgs[] = {
+            ND_LOG_FIELD_TXT(NDF_SRC_IP, rpt->client_ip),
+            ND_LOG_FIELD_TXT(NDF_SRC_PORT, rpt->client_port),
+            ND_LOG_FIELD_TXT(NDF_NIDL_NODE, rpt->hostname),
+            ND_LOG_FIELD_CB(NDF_SRC_TRANSPORT, stream_receiver_log_transport, rpt),
+            ND_LOG_FIELD_CB(NDF_SRC_CAPABILITIES, stream_receiver_log_capabilities, rpt),
+            ND_LOG_FIELD_END(),
+    };
+    ND_LOG_STACK_PUSH(lgs);
+
+    bool keep;
+
+    if(unlikely(send_to_plugin_pending_events(rpt->parser) && !send_to_plugin_flush(rpt->parser))) {
+        receiver_set_exit_reason(rpt, STREAM_HANDSHAKE_DISCONNECT_SOCKET_WRITE_FAILED, false);
+        keep = false;
+    }
+
+    else if(ready || rpt->pool.pending)
+        keep = receiver_pool_process(rpt);
+
+    else if(unlikely(__atomic_load_n(&rpt->exit.shutdown, __ATOMIC_RELAXED))) {
+        receiver_set_exit_reason(rpt, STREAM_HANDSHAKE_DISCONNECT_SHUTDOWN, false);
+        keep = false;
+    }
+
+    else if(unlikely(now_s - rpt->pool.last_read_s > RECEIVER_SOCKET_READ_TIMEOUT_S)) {
+        netdata_log_error("STREAM: %s(): timeout while waiting for data on socket!", __FUNCTION__);
+        receiver_set_exit_reason(rpt, STREAM_HANDSHAKE_DISCONNECT_SOCKET_READ_TIMEOUT, false);
+        keep = false;
+    }
+
+    else
+        keep = true;
+
+    if(!keep)
+        receiver_pool_release(w, rpt);
+}
+
+static void receiver_pool_pickup_incoming(struct receiver_pool_worker *w) {
+    spinlock_lock(&w->spinlock);
+    while(w->incoming) {
+        struct receiver_state *rpt = w->incoming;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(w->incoming, rpt, pool.prev, pool.next);
+
+        rpt->tid = gettid_cached();
+        DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(w->serving, rpt, pool.prev, pool.next);
+    }
+    spinlock_unlock(&w->spinlock);
+}
+
+static void *receiver_pool_worker_main(void *ptr) {
+    struct receiver_pool_worker *w = ptr;
+
+    receiver_worker_register();
+    nd_thread_register_canceller(receiver_pool_canceller, w);
+
+    while(service_running(SERVICE_STREAMING) && !nd_thread_signaled_to_cancel()) {
+        receiver_pool_pickup_incoming(w);
+
+        size_t entries = 1;
+        struct receiver_state *rpt;
+        for(rpt = w->serving; rpt ; rpt = rpt->pool.next)
+            entries++;
+
+        if(entries > w->fds_size) {
+            w->fds = reallocz(w->fds, entries * sizeof(*w->fds));
+            w->fds_size = entries;
+        }
+
+        bool pending = false;
+        w->fds[0] = (struct pollfd){ .fd = w->wakeup[0], .events = POLLIN, .revents = 0, };
+
+        time_t now_s = now_monotonic_sec();
+        size_t slot = 1;
+        for(rpt = w->serving; rpt ; rpt = rpt->pool.next) {
+            // poll() ignores the children that have read their bytes for this second,
+            // unless they have output queued
+            bool throttled = receiver_admission_throttled(rpt, now_s);
+            short output = send_to_plugin_pending_events(rpt->parser);
+            rpt->pool.slot = slot;
+            w->fds[slot++] = (struct pollfd){
+                .fd = (throttled && !output) ? -1 : rpt->fd,
+                .events = (short)((throttled ? 0 : POLLIN) | output),
+                .revents = 0,
+            };
+            pending = pending || rpt->pool.pending;
+        }
+
+        worker_is_idle();
+
+        errno_clear();
+        if(poll(w->fds, entries, pending ? 0 : RECEIVER_POOL_POLL_TIMEOUT_MS) < 0 && errno != EINTR) {
+            netdata_log_error("STREAM: receivers pool poll() failed");
+            sleep_usec(100 * USEC_PER_MS);
+            continue;
+        }
+
+        if(w->fds[0].revents & POLLIN) {
+            char buf[128];
+            while(read(w->wakeup[0], buf, sizeof(buf)) > 0) ;
+        }
+
+        now_s = now_monotonic_sec();
+        rpt = w->serving;
+        while(rpt) {
+            struct receiver_state *next = rpt->pool.next;
+            receiver_pool_serve(w, rpt, w->fds[rpt->pool.slot].revents != 0, now_s);
+            rpt = next;
+        }
+    }
+
+    // we are exiting, disconnect all our children
+    receiver_pool_pickup_incoming(w);
+    while(w->serving) {
+        struct receiver_state *rpt = w->serving;
+        receiver_set_exit_reason(rpt, service_running(SERVICE_STREAMING) ? STREAM_HANDSHAKE_DISCONNECT_SHUTDOWN : STREAM_HANDSHAKE_DISCONNECT_NETDATA_EXIT, false);
+        receiver_pool_release(w, rpt);
+    }
+
+    worker_unregister();
+    return NULL;
+}
+
+static void receiver_pool_start(void) {
+    size_t threads = rrdpush_receiver_pool_threads;
+    receiver_pool.workers = callocz(threads, sizeof(*receiver_pool.workers));
+
+    for(size_t i = 0; i < threads ;i++) {
+        struct receiver_pool_worker *w = &receiver_pool.workers[receiver_pool.threads];
+        spinlock_init(&w->spinlock);
+
+        if(pipe(w->wakeup) != 0) {
+            netdata_log_error("STREAM: cannot create the wake up pipe of a receivers pool thread");
+            continue;
+        }
+
+        sock_setnonblock(w->wakeup[0]);
+        sock_setnonblock(w->wakeup[1]);
+
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, THREAD_TAG_STREAM_RECEIVER "[%zu]", receiver_pool.threads);
+
+        w->thread = nd_thread_create(tag, NETDATA_THREAD_OPTION_DEFAULT, receiver_pool_worker_main, w);
+        if(!w->thread) {
+            close(w->wakeup[0]);
+            close(w->wakeup[1]);
+            continue;
+        }
+
+        receiver_pool.threads++;
+    }
+
+    netdata_log_info("STREAM: started %zu stream receiver threads", receiver_pool.threads);
+}
+
+// the least busy thread of the pool, starting the pool on first use
+static struct receiver_pool_worker *receiver_pool_worker_get(void) {
+    if(!rrdpush_receiver_pool_threads || !service_running(SERVICE_STREAMING))
+        return NULL;
+
+    spinlock_lock(&receiver_pool.spinlock);
+
+    if(!receiver_pool.workers)
+        receiver_pool_start();
+
+    struct receiver_pool_worker *w = NULL;
+    for(size_t i = 0; i < receiver_pool.threads ;i++) {
+        struct receiver_pool_worker *t = &receiver_pool.workers[i];
+        if(!w || __atomic_load_n(&t->receivers, __ATOMIC_RELAXED) < __atomic_load_n(&w->receivers, __ATOMIC_RELAXED))
+            w = t;
+    }
+
+    if(w)
+        __atomic_add_fetch(&w->receivers, 1, __ATOMIC_RELAXED);
+
+    spinlock_unlock(&receiver_pool.spinlock);
+
+    return w;
+}
+
+// hands over a connected child to the receivers pool
+// after this, the child is owned by the pool thread
+static bool receiver_pool_attach(struct receiver_state *rpt) {
+    struct receiver_pool_worker *w = receiver_pool_worker_get();
+    if(!w)
+        return false;
+
+    PARSER *parser = streaming_parser_start(rpt, rpt->cd, rpt->fd, (rpt->ssl.conn) ? &rpt->ssl : NULL, &rpt->pool.compressed_connection);
+
+    rpt->pool.line = buffer_create(sizeof(rpt->reader.read_buffer), NULL);
+    if(rpt->pool.compressed_connection)
+        rpt->pool.compressed = mallocz(COMPRESSION_MAX_MSG_SIZE);
+
+    rpt->pool.last_read_s = now_monotonic_sec();
+
+    __atomic_store_n(&rpt->parser, parser, __ATOMIC_RELAXED);
+    rrdpush_receiver_send_node_and_claim_id_to_child(rpt->host);
+
+    // the functions collector of this child follows it to the pool thread
+    rpt->pool.collector = rrd_collector_switch(NULL);
+
+    spinlock_lock(&rpt->host->receiver_lock);
+    rpt->pool.worker = w;
+    spinlock_unlock(&rpt->host->receiver_lock);
+
+    netdata_log_info("STREAM '%s' [receive from [%s]:%s]: "
+                     "handed over to the stream receiver threads"
+                     , rpt->hostname ? rpt->hostname : "-"
+                     , rpt->client_ip ? rpt->client_ip : "-", rpt->client_port ? rpt->client_port : "-");
+
+    spinlock_lock(&w->spinlock);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(w->incoming, rpt, pool.prev, pool.next);
+    spinlock_unlock(&w->spinlock);
+
+    receiver_pool_wakeup(w);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+// returns true when the child has been handed over to the receivers pool
+static bool rrdpush_receive(struct receiver_state *rpt) {
+    // the children of the receiver pipeline need threads of their own
+    bool pooled = rrdpush_receiver_pool_threads > 0 && !rrdpush_receiver_pipeline;
+
+#ifdef ENABLE_H2O
+    if(is_h2o_rrdpush(rpt))
+        pooled = false;
+#endif
+
+    rpt->cd = callocz(1, sizeof(*rpt->cd));
+    bool connected = rrdpush_receive_connect(rpt, rpt->cd, pooled);
+    rrdpush_receiver_admission_handshake_done(rpt);
+    if(!connected)
+        return false;
+
+    if(pooled) {
+        if(receiver_pool_attach(rpt))
+            return true;
+
+        // we will serve it from this thread
+        receiver_set_socket_blocking(rpt);
+    }
+
+    // receive data
+    size_t count = streaming_parser(rpt, rpt->cd, rpt->fd, (rpt->ssl.conn) ? &rpt->ssl : NULL);
+    rrdpush_receive_disconnected(rpt, count);
+    return false;
+}
+
+void *rrdpush_receiver_thread(void *ptr) {
+    receiver_worker_register();
 
     struct receiver_state *rpt = (struct receiver_state *) ptr;
     rpt->tid = gettid_cached();
@@ -910,7 +1752,11 @@ void *rrdpush_receiver_thread(void *ptr) {
     netdata_log_info("STREAM %s [%s]:%s: receive thread started", rpt->hostname, rpt->client_ip
                      , rpt->client_port);
 
-    rrdpush_receive(rpt);
+    if(rrdpush_receive(rpt)) {
+        // the pool owns rpt now, it may already be gone
+        worker_unregister();
+        return NULL;
+    }
 
     netdata_log_info("STREAM '%s' [receive from [%s]:%s]: "
                      "receive thread ended (task id %d)"
@@ -8,6 +8,12 @@
 #define MAX_SENDER_BUFFER_PERCENTAGE_ALLOWED 50ULL
 #define MIN_SENDER_BUFFER_PERCENTAGE_ALLOWED 10ULL
 
+// the back-pressure adapts to the speed of the link: replication may fill the
+// sender buffer with as much data as the connection can send in this time
+#define REPLICATION_BUFFER_DRAIN_SECONDS 5ULL
+#define REPLICATION_MAX_ADAPTIVE_BUFFER_PERCENTAGE 90ULL
+#define REPLICATION_MIN_ADAPTIVE_BUFFER_PERCENTAGE 20ULL
+
 #define WORKER_JOB_FIND_NEXT                            1
 #define WORKER_JOB_QUERYING                             2
 #define WORKER_JOB_DELETE_ENTRY                         3
@@ -27,6 +33,7 @@
 #define WORKER_JOB_CUSTOM_METRIC_DONE                   15
 #define WORKER_JOB_CUSTOM_METRIC_SENDER_RESETS          16
 #define WORKER_JOB_CUSTOM_METRIC_SENDER_FULL            17
+#define WORKER_JOB_CUSTOM_METRIC_MERGED                 18
 
 #define ITERATIONS_IDLE_WITHOUT_PENDING_TO_RUN_SENDER_VERIFICATION 30
 #define SECONDS_TO_RESET_POINT_IN_TIME 10
@@ -1013,6 +1020,7 @@ static struct replication_thread {
         // statistics
         size_t added;                   // number of requests added to the queue
         size_t removed;                 // number of requests removed from the queue
+        size_t merged;                  // number of requests merged into the range of a queued request
         size_t pending_no_room;         // number of requests skipped, because the sender has no room for responses
         size_t senders_full;             // number of times a sender reset our last position in the queue
         size_t sender_resets;           // number of times a sender reset our last position in the queue
@@ -1048,6 +1056,7 @@ static struct replication_thread {
 
                 .added = 0,
                 .removed = 0,
+                .merged = 0,
                 .pending_no_room = 0,
                 .sender_resets = 0,
                 .senders_full = 0,
@@ -1361,6 +1370,15 @@ static void replication_request_react_callback(const DICTIONARY_ITEM *item __may
     rrdpush_sender_replicating_charts_plus_one(s);
 }
 
+static inline bool replication_request_ranges_can_be_merged(struct replication_request *rq, struct replication_request *rq_new) {
+    // a zero before cannot be compared
+    if(!rq->before || !rq_new->before)
+        return false;
+
+    // overlapping or adjacent
+    return rq_new->after <= rq->before && rq->after <= rq_new->before;
+}
+
 static bool replication_request_conflict_callback(const DICTIONARY_ITEM *item __maybe_unused, void *old_value, void *new_value, void *sender_state) {
     struct sender_state *s = sender_state; (void)s;
     struct replication_request *rq = old_value; (void)rq;
@@ -1390,6 +1408,28 @@ static bool replication_request_conflict_callback(const DICTIONARY_ITEM *item __
                 (unsigned long long)rq->after, (unsigned long long)rq->before, rq->start_streaming ? "true" : "false",
                 (unsigned long long)rq_new->after, (unsigned long long)rq_new->before, rq_new->start_streaming ? "true" : "false");
     }
+    else if(rq->indexed_in_judy && replication_request_ranges_can_be_merged(rq, rq_new)) {
+        // still waiting in the queue - extend it, to answer both with one query
+        internal_error(
+                true,
+                "STREAM %s [send to %s]: REPLAY: 'host:%s/chart:%s' merging duplicate replication command received (existing from %llu to %llu [%s], new from %llu to %llu [%s])",
+                rrdhost_hostname(s->host), s->connected_to, rrdhost_hostname(s->host), dictionary_acquired_item_name(item),
+                (unsigned long long)rq->after, (unsigned long long)rq->before, rq->start_streaming ? "true" : "false",
+                (unsigned long long)rq_new->after, (unsigned long long)rq_new->before, rq_new->start_streaming ? "true" : "false");
+
+        if(rq_new->after < rq->after) {
+            // the queue is sorted by after, so it has to be indexed again
+            replication_sort_entry_del(rq, false);
+            rq->after = rq_new->after;
+            replication_sort_entry_add(rq);
+        }
+
+        if(rq_new->before > rq->before)
+            rq->before = rq_new->before;
+
+        rq->start_streaming = rq->start_streaming || rq_new->start_streaming;
+        replication_globals.unsafe.merged++;
+    }
     else {
         internal_error(
                 true,
@@ -1529,11 +1569,54 @@ void replication_cleanup_sender(struct sender_state *sender) {
     replication_recursive_unlock();
 }
 
+// measures the sending rate of the connection, at most once per second
+static void replication_measure_bandwidth_unsafe(struct sender_state *s) {
+    usec_t now_ut = now_monotonic_usec();
+    usec_t dt_ut = now_ut - s->replication.bandwidth.last_ut;
+
+    if(likely(s->replication.bandwidth.last_ut && dt_ut < USEC_PER_SEC))
+        return;
+
+    size_t sent = s->sent_bytes_on_this_connection;
+    if(s->replication.bandwidth.last_ut && sent >= s->replication.bandwidth.last_sent_bytes) {
+        size_t rate = (size_t)((unsigned long long)(sent - s->replication.bandwidth.last_sent_bytes) * USEC_PER_SEC / dt_ut);
+
+        // smooth it, so that a single slow second does not stop replication
+        s->replication.bandwidth.bytes_per_second = (s->replication.bandwidth.bytes_per_second * 3 + rate) / 4;
+    }
+    else
+        // a new connection
+        s->replication.bandwidth.bytes_per_second = 0;
+
+    s->replication.bandwidth.last_ut = now_ut;
+    s->replication.bandwidth.last_sent_bytes = sent;
+}
+
+// the percentage of the sender buffer replication may use
+static size_t replication_max_buffer_percentage_unsafe(struct sender_state *s) {
+    if(!s->replication.bandwidth.bytes_per_second)
+        return MAX_SENDER_BUFFER_PERCENTAGE_ALLOWED;
+
+    unsigned long long drain = (unsigned long long)s->replication.bandwidth.bytes_per_second * REPLICATION_BUFFER_DRAIN_SECONDS;
+    size_t percentage = (size_t)(drain * 100ULL / s->buffer->max_size);
+
+    if(percentage > REPLICATION_MAX_ADAPTIVE_BUFFER_PERCENTAGE)
+        percentage = REPLICATION_MAX_ADAPTIVE_BUFFER_PERCENTAGE;
+    else if(percentage < REPLICATION_MIN_ADAPTIVE_BUFFER_PERCENTAGE)
+        percentage = REPLICATION_MIN_ADAPTIVE_BUFFER_PERCENTAGE;
+
+    return percentage;
+}
+
 void replication_recalculate_buffer_used_ratio_unsafe(struct sender_state *s) {
     size_t available = cbuffer_available_size_unsafe(s->host->sender->buffer);
     size_t percentage = (s->buffer->max_size - available) * 100 / s->buffer->max_size;
 
-    if(unlikely(percentage > MAX_SENDER_BUFFER_PERCENTAGE_ALLOWED && !rrdpush_sender_replication_buffer_full_get(s))) {
+    replication_measure_bandwidth_unsafe(s);
+    size_t max_percentage = replication_max_buffer_percentage_unsafe(s);
+    size_t min_percentage = max_percentage * MIN_SENDER_BUFFER_PERCENTAGE_ALLOWED / MAX_SENDER_BUFFER_PERCENTAGE_ALLOWED;
+
+    if(unlikely(percentage > max_percentage && !rrdpush_sender_replication_buffer_full_get(s))) {
         rrdpush_sender_replication_buffer_full_set(s, true);
 
         struct replication_request *rq;
@@ -1547,7 +1630,7 @@ void replication_recalculate_buffer_used_ratio_unsafe(struct sender_state *s) {
         replication_globals.unsafe.senders_full++;
         replication_recursive_unlock();
     }
-    else if(unlikely(percentage < MIN_SENDER_BUFFER_PERCENTAGE_ALLOWED && rrdpush_sender_replication_buffer_full_get(s))) {
+    else if(unlikely(percentage < min_percentage && rrdpush_sender_replication_buffer_full_get(s))) {
         rrdpush_sender_replication_buffer_full_set(s, false);
 
         struct replication_request *rq;
@@ -1658,6 +1741,7 @@ static void replication_initialize_workers(bool master) {
         worker_register_job_custom_metric(WORKER_JOB_CUSTOM_METRIC_DONE, "finished requests", "requests/s", WORKER_METRIC_INCREMENTAL_TOTAL);
         worker_register_job_custom_metric(WORKER_JOB_CUSTOM_METRIC_SENDER_RESETS, "sender resets", "resets/s", WORKER_METRIC_INCREMENTAL_TOTAL);
         worker_register_job_custom_metric(WORKER_JOB_CUSTOM_METRIC_SENDER_FULL, "senders full", "senders", WORKER_METRIC_ABSOLUTE);
+        worker_register_job_custom_metric(WORKER_JOB_CUSTOM_METRIC_MERGED, "merged requests", "requests/s", WORKER_METRIC_INCREMENTAL_TOTAL);
     }
 }
 
@@ -1884,7 +1968,11 @@ void replication_initialize(void) {
 void *replication_thread_main(void *ptr __maybe_unused) {
     replication_initialize_workers(true);
 
-    int threads = config_get_number(CONFIG_SECTION_DB, "replication threads", 1);
+    int default_threads = (int)get_netdata_cpus() / 4;
+    if(default_threads < 1) default_threads = 1;
+    if(default_threads > MAX_REPLICATION_THREADS) default_threads = MAX_REPLICATION_THREADS;
+
+    int threads = config_get_number(CONFIG_SECTION_DB, "replication threads", default_threads);
     if(threads < 1 || threads > MAX_REPLICATION_THREADS) {
         netdata_log_error("replication threads given %d is invalid, resetting to 1", threads);
         threads = 1;
@@ -1975,6 +2063,7 @@ void *replication_thread_main(void *ptr __maybe_unused) {
             worker_set_metric(WORKER_JOB_CUSTOM_METRIC_SKIPPED_NO_ROOM, (NETDATA_DOUBLE)replication_globals.unsafe.pending_no_room);
             worker_set_metric(WORKER_JOB_CUSTOM_METRIC_SENDER_RESETS, (NETDATA_DOUBLE)replication_globals.unsafe.sender_resets);
             worker_set_metric(WORKER_JOB_CUSTOM_METRIC_SENDER_FULL, (NETDATA_DOUBLE)replication_globals.unsafe.senders_full);
+            worker_set_metric(WORKER_JOB_CUSTOM_METRIC_MERGED, (NETDATA_DOUBLE)replication_globals.unsafe.merged);
 
             replication_recursive_unlock();
             worker_is_idle();
@@ -21,21 +21,32 @@
  *
  * 3. a receiver thread, running at the receiving netdata
  *    this is spawned automatically when the sender connects to
- *    the receiver.
+ *    the receiver. Once the connection is established, the child
+ *    is handed over to the receivers pool, a fixed number of
+ *    threads serving all the children.
  *
  */
 
-struct config stream_config = APPCONFIG_INITIALIZER;
+// the receivers look up the sections of the api key and the machine guid of every child connecting,
+// so the sections not in stream.conf are not created - all their lookups return the defaults
+struct config stream_config = APPCONFIG_LAZY_INITIALIZER;
 
 unsigned int default_rrdpush_enabled = 0;
 
 unsigned int default_rrdpush_compression_enabled = 1;
+bool default_rrdpush_compression_dictionary = true;
 const char *default_rrdpush_destination = NULL;
 const char *default_rrdpush_api_key = NULL;
 const char *default_rrdpush_send_charts_matching = "*";
 bool default_rrdpush_enable_replication = true;
 time_t default_rrdpush_seconds_to_replicate = 86400;
 time_t default_rrdpush_replication_step = 600;
+size_t rrdpush_receiver_pool_threads = 0;
+bool rrdpush_receiver_pipeline = false;
+size_t rrdpush_sender_pool_threads = 0;
+size_t rrdpush_receiver_max_handshakes = 0;
+size_t rrdpush_receiver_max_replicating = 0;
+size_t rrdpush_receiver_max_bytes_per_sec = 0;
 const char *netdata_ssl_ca_path = NULL;
 const char *netdata_ssl_ca_file = NULL;
 
@@ -111,10 +122,37 @@ int rrdpush_init() {
     rrdhost_free_orphan_time_s =
         config_get_duration_seconds(CONFIG_SECTION_DB, "cleanup orphan hosts after", rrdhost_free_orphan_time_s);
 
+    long receiver_pool_threads = os_get_system_cpus() / 2;
+    if(receiver_pool_threads < 1) receiver_pool_threads = 1;
+    if(receiver_pool_threads > 16) receiver_pool_threads = 16;
+    receiver_pool_threads = config_get_number(CONFIG_SECTION_DB, "stream receiver threads", receiver_pool_threads);
+    rrdpush_receiver_pool_threads = (receiver_pool_threads > 0) ? (size_t)receiver_pool_threads : 0;
+
+    rrdpush_receiver_pipeline = config_get_boolean(CONFIG_SECTION_DB, "stream receiver pipeline", rrdpush_receiver_pipeline);
+
+    long sender_pool_threads = config_get_number(CONFIG_SECTION_DB, "stream sender threads", 0);
+    if(sender_pool_threads > 64) sender_pool_threads = 64;
+    rrdpush_sender_pool_threads = (sender_pool_threads > 0) ? (size_t)sender_pool_threads : 0;
+
+    long max_handshakes = os_get_system_cpus() * 4;
+    if(max_handshakes < 16) max_handshakes = 16;
+    max_handshakes = config_get_number(CONFIG_SECTION_DB, "stream receiver max handshakes", max_handshakes);
+    rrdpush_receiver_max_handshakes = (max_handshakes > 0) ? (size_t)max_handshakes : 0;
+
+    long max_replicating = config_get_number(CONFIG_SECTION_DB, "stream receiver max replicating children", 0);
+    rrdpush_receiver_max_replicating = (max_replicating > 0) ? (size_t)max_replicating : 0;
+
+    long max_kib_per_sec = config_get_number(CONFIG_SECTION_DB, "stream receiver max KiB/s per child", 0);
+    rrdpush_receiver_max_bytes_per_sec = (max_kib_per_sec > 0) ? (size_t)max_kib_per_sec * 1024 : 0;
+
     default_rrdpush_compression_enabled =
         (unsigned int)appconfig_get_boolean(&stream_config, CONFIG_SECTION_STREAM,
                                             "enable compression", default_rrdpush_compression_enabled);
 
+    default_rrdpush_compression_dictionary =
+        appconfig_get_boolean(&stream_config, CONFIG_SECTION_STREAM,
+                              "enable compression dictionary", default_rrdpush_compression_dictionary);
+
     rrdpush_compression_levels[COMPRESSION_ALGORITHM_BROTLI] = (int)appconfig_get_number(
             &stream_config, CONFIG_SECTION_STREAM, "brotli compression level",
             rrdpush_compression_levels[COMPRESSION_ALGORITHM_BROTLI]);
@@ -236,6 +274,9 @@ static inline bool rrdpush_send_chart_definition(BUFFER *wb, RRDSET *st) {
 
     bool replication_progress = false;
 
+    // where the definition starts in the buffer, to digest it
+    size_t definition_start = buffer_strlen(wb);
+
     // properly set the name for the remote end to parse it
     char *name = "";
     if(likely(st->name)) {
@@ -319,11 +360,41 @@ static inline bool rrdpush_send_chart_definition(BUFFER *wb, RRDSET *st) {
         time_t now = now_realtime_sec();
         rrdset_get_retention_of_tier_for_collected_chart(st, &db_first_time_t, &db_last_time_t, now, 0);
 
-        buffer_sprintf(wb, PLUGINSD_KEYWORD_CHART_DEFINITION_END " %llu %llu %llu\n",
+        uint64_t digest = 0;
+        if(stream_has_capability(host->sender, STREAM_CAP_DIGEST)) {
+            digest = XXH3_64bits(&buffer_tostring(wb)[definition_start], buffer_strlen(wb) - definition_start);
+            if(!digest) digest = 1;
+
+            if(digest == st->rrdpush.sender.definition_digest) {
+                // the parent got this definition on a previous connection,
+                // replace it with a reference to it
+                wb->len = definition_start;
+
+                buffer_fast_strcat(wb, PLUGINSD_KEYWORD_CHART_REUSE " "PLUGINSD_KEYWORD_SLOT":", sizeof(PLUGINSD_KEYWORD_CHART_REUSE) - 1 + sizeof(PLUGINSD_KEYWORD_SLOT) - 1 + 2);
+                buffer_print_uint64_encoded(wb, integer_encoding, st->rrdpush.sender.chart_slot);
+                buffer_fast_strcat(wb, " \"", 2);
+                buffer_fast_strcat(wb, rrdset_id(st), string_strlen(st->id));
+                buffer_fast_strcat(wb, "\" ", 2);
+                buffer_print_uint64_encoded(wb, integer_encoding, digest);
+                buffer_fast_strcat(wb, "\n", 1);
+            }
+
+            // if the parent does not have it, it will ask for it with CHART_RESEND
+            st->rrdpush.sender.definition_digest = digest;
+        }
+
+        buffer_sprintf(wb, PLUGINSD_KEYWORD_CHART_DEFINITION_END " %llu %llu %llu",
                        (unsigned long long)db_first_time_t,
                        (unsigned long long)db_last_time_t,
                        (unsigned long long)now);
 
+        if(digest) {
+            buffer_fast_strcat(wb, " ", 1);
+            buffer_print_uint64_encoded(wb, integer_encoding, digest);
+        }
+
+        buffer_fast_strcat(wb, "\n", 1);
+
         if(!rrdset_flag_check(st, RRDSET_FLAG_SENDER_REPLICATION_IN_PROGRESS)) {
             rrdset_flag_set(st, RRDSET_FLAG_SENDER_REPLICATION_IN_PROGRESS);
             rrdset_flag_clear(st, RRDSET_FLAG_SENDER_REPLICATION_FINISHED);
@@ -419,6 +490,7 @@ void rrddim_push_metrics_v2(RRDSET_STREAM_BUFFER *rsb, RRDDIM *rd, usec_t point_
         return;
 
     bool with_slots = stream_has_capability(rsb, STREAM_CAP_SLOTS) ? true : false;
+    bool with_ids = !with_slots || !stream_has_capability(rsb, STREAM_CAP_COMPACT);
     NUMBER_ENCODING integer_encoding = stream_has_capability(rsb, STREAM_CAP_IEEE754) ? NUMBER_ENCODING_BASE64 : NUMBER_ENCODING_HEX;
     NUMBER_ENCODING doubles_encoding = stream_has_capability(rsb, STREAM_CAP_IEEE754) ? NUMBER_ENCODING_BASE64 : NUMBER_ENCODING_DECIMAL;
     BUFFER *wb = rsb->wb;
@@ -435,9 +507,14 @@ void rrddim_push_metrics_v2(RRDSET_STREAM_BUFFER *rsb, RRDDIM *rd, usec_t point_
             buffer_print_uint64_encoded(wb, integer_encoding, rd->rrdset->rrdpush.sender.chart_slot);
         }
 
-        buffer_fast_strcat(wb, " '", 2);
-        buffer_fast_strcat(wb, rrdset_id(rd->rrdset), string_strlen(rd->rrdset->id));
-        buffer_fast_strcat(wb, "' ", 2);
+        if(with_ids) {
+            buffer_fast_strcat(wb, " '", 2);
+            buffer_fast_strcat(wb, rrdset_id(rd->rrdset), string_strlen(rd->rrdset->id));
+            buffer_fast_strcat(wb, "' ", 2);
+        }
+        else
+            buffer_fast_strcat(wb, " ", 1);
+
         buffer_print_uint64_encoded(wb, integer_encoding, rd->rrdset->update_every);
         buffer_fast_strcat(wb, " ", 1);
         buffer_print_uint64_encoded(wb, integer_encoding, point_end_time_s);
@@ -459,9 +536,14 @@ void rrddim_push_metrics_v2(RRDSET_STREAM_BUFFER *rsb, RRDDIM *rd, usec_t point_
         buffer_print_uint64_encoded(wb, integer_encoding, rd->rrdpush.sender.dim_slot);
     }
 
-    buffer_fast_strcat(wb, " '", 2);
-    buffer_fast_strcat(wb, rrddim_id(rd), string_strlen(rd->id));
-    buffer_fast_strcat(wb, "' ", 2);
+    if(with_ids) {
+        buffer_fast_strcat(wb, " '", 2);
+        buffer_fast_strcat(wb, rrddim_id(rd), string_strlen(rd->id));
+        buffer_fast_strcat(wb, "' ", 2);
+    }
+    else
+        buffer_fast_strcat(wb, " ", 1);
+
     buffer_print_int64_encoded(wb, integer_encoding, rd->collector.last_collected_value);
     buffer_fast_strcat(wb, " ", 1);
 
@@ -685,6 +767,7 @@ void rrdpush_destinations_free(RRDHOST *host) {
         struct rrdpush_destinations *tmp = host->destinations;
         DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(host->destinations, tmp, prev, next);
         string_freez(tmp->destination);
+        netdata_ssl_session_free(tmp->ssl_session);
         freez(tmp);
         __atomic_sub_fetch(&netdata_buffers_statistics.rrdhost_senders, sizeof(struct rrdpush_destinations), __ATOMIC_RELAXED);
     }
@@ -716,7 +799,7 @@ void rrdpush_sender_thread_stop(RRDHOST *host, STREAM_HANDSHAKE reason, bool wai
 
     if(wait) {
         sender_lock(host->sender);
-        while(host->sender->tid) {
+        while(host->sender->tid || __atomic_load_n(&host->sender->pool.worker, __ATOMIC_ACQUIRE)) {
             sender_unlock(host->sender);
             sleep_usec(10 * USEC_PER_MS);
             sender_lock(host->sender);
@@ -731,6 +814,9 @@ void rrdpush_sender_thread_stop(RRDHOST *host, STREAM_HANDSHAKE reason, bool wai
 static void rrdpush_sender_thread_spawn(RRDHOST *host) {
     sender_lock(host->sender);
 
+    if(!rrdhost_flag_check(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN) && rrdpush_sender_pool_add(host->sender))
+        rrdhost_flag_set(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
+
     if(!rrdhost_flag_check(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN)) {
         char tag[NETDATA_THREAD_TAG_MAX + 1];
         snprintfz(tag, NETDATA_THREAD_TAG_MAX, THREAD_TAG_STREAM_SENDER "[%s]", rrdhost_hostname(host));
@@ -1179,6 +1265,51 @@ int rrdpush_receiver_thread_spawn(struct web_client *w, char *decoded_query_stri
         }
     }
 
+    // admission control: while the parent is busy replicating or accepting many children,
+    // ask the new ones to come back later, instead of accepting all of them at once
+
+    if(unlikely(rrdpush_receiver_max_replicating)) {
+        size_t replicating = 0;
+
+        rrd_rdlock();
+        RRDHOST *host;
+        rrdhost_foreach_read(host) {
+            if(host != localhost && rrdhost_receiver_replicating_charts(host))
+                replicating++;
+        }
+        rrd_rdunlock();
+
+        if(replicating >= rrdpush_receiver_max_replicating) {
+            char msg[100 + 1];
+            snprintfz(msg, sizeof(msg) - 1,
+                      "admission control, %zu children are replicating (max %zu)",
+                      replicating, rrdpush_receiver_max_replicating);
+
+            rrdpush_receive_log_status(
+                    rpt, msg,
+                    RRDPUSH_STATUS_RATE_LIMIT, NDLP_NOTICE);
+
+            rrdpush_receiver_admission_rejected_one();
+            receiver_state_free(rpt);
+            return rrdpush_receiver_too_busy_now(w);
+        }
+    }
+
+    if(unlikely(!rrdpush_receiver_admission_handshake_start(rpt))) {
+        char msg[100 + 1];
+        snprintfz(msg, sizeof(msg) - 1,
+                  "admission control, %zu handshakes are in progress (max %zu)",
+                  rrdpush_receiver_admission_handshakes(), rrdpush_receiver_max_handshakes);
+
+        rrdpush_receive_log_status(
+                rpt, msg,
+                RRDPUSH_STATUS_RATE_LIMIT, NDLP_NOTICE);
+
+        rrdpush_receiver_admission_rejected_one();
+        receiver_state_free(rpt);
+        return rrdpush_receiver_too_busy_now(w);
+    }
+
     rrdpush_receiver_takeover_web_connection(w, rpt);
 
     char tag[NETDATA_THREAD_TAG_MAX + 1];
@@ -1242,6 +1373,7 @@ static struct {
     {STREAM_HANDSHAKE_DISCONNECT_SOCKET_EOF, "DISCONNECTED SOCKET EOF" },
     {STREAM_HANDSHAKE_DISCONNECT_SOCKET_READ_FAILED, "DISCONNECTED SOCKET READ FAILED" },
     {STREAM_HANDSHAKE_DISCONNECT_SOCKET_READ_TIMEOUT, "DISCONNECTED SOCKET READ TIMEOUT" },
+    { STREAM_HANDSHAKE_DISCONNECT_SOCKET_WRITE_FAILED, "DISCONNECTED SOCKET WRITE FAILED" },
     { 0, NULL },
 };
 
@@ -88,6 +88,7 @@ typedef enum {
     STREAM_HANDSHAKE_DISCONNECT_SOCKET_READ_FAILED = -25,
     STREAM_HANDSHAKE_DISCONNECT_SOCKET_READ_TIMEOUT = -26,
     STREAM_HANDSHAKE_ERROR_HTTP_UPGRADE = -27,
+    STREAM_HANDSHAKE_DISCONNECT_SOCKET_WRITE_FAILED = -28,
 
 } STREAM_HANDSHAKE;
 
@@ -182,6 +183,12 @@ struct sender_state {
             bool reached_max;                   // true when the sender buffer should not get more replication responses
         } atomic;
 
+        struct {
+            usec_t last_ut;                     // the last time the sending rate was measured
+            size_t last_sent_bytes;             // sent_bytes_on_this_connection at last_ut
+            size_t bytes_per_second;            // the recent sending rate of the connection
+        } bandwidth;
+
     } replication;
 
     struct {
@@ -200,6 +207,21 @@ struct sender_state {
     } defer;
 
     int parent_using_h2o;
+
+    struct {
+        void *worker;                           // the senders pool thread serving this sender, or NULL
+        bool was_connected;
+        bool connecting;                        // a connection attempt is running on its own thread
+        bool polled;
+        size_t slot;                            // the first pollfd of this sender
+        time_t reconnect_after_s;               // slow re-connection on repeating errors
+
+        SPINLOCK spinlock;                      // protects connector and connect_result
+        ND_THREAD *connector;
+        int connect_result;                     // 0 = connecting, 1 = connected, -1 = failed
+
+        struct sender_state *prev, *next;
+    } pool;
 };
 
 #define sender_lock(sender) spinlock_lock(&(sender)->spinlock)
@@ -325,6 +347,36 @@ struct receiver_state {
     // an atomic read.
     struct parser *parser;
 
+    struct plugind *cd;
+
+    // admission control of the parent
+    struct {
+        bool handshaking;                       // it is counted in the handshakes in progress
+        time_t window_s;                        // the second window_bytes have been read in
+        size_t window_bytes;
+        size_t throttled;                       // the seconds it reached the bytes/sec limit
+    } admission;
+
+    // when served by the receivers pool, instead of a thread of its own
+    struct {
+        struct receiver_pool_worker *worker;    // set with the host receiver lock
+        struct rrd_collector *collector;        // the functions collector of this child
+        BUFFER *line;                           // the line being parsed, across turns
+        bool compressed_connection;
+        bool pending;                           // it has more data to process
+        size_t slot;                            // its index in the pollfd array of the worker
+        time_t last_read_s;
+
+        size_t signature_read;
+        char signature[RRDPUSH_COMPRESSION_SIGNATURE_SIZE];
+
+        size_t compressed_size;                 // the size of the compressed block being read
+        size_t compressed_read;
+        char *compressed;
+
+        struct receiver_state *prev, *next;
+    } pool;
+
 #ifdef ENABLE_H2O
     void *h2o_ctx;
 #endif
@@ -343,12 +395,15 @@ struct rrdpush_destinations {
     time_t postpone_reconnection_until;
     STREAM_HANDSHAKE reason;
 
+    SSL_SESSION *ssl_session;       // the TLS session of the last connection, to resume it on reconnect
+
     struct rrdpush_destinations *prev;
     struct rrdpush_destinations *next;
 };
 
 extern unsigned int default_rrdpush_enabled;
 extern unsigned int default_rrdpush_compression_enabled;
+extern bool default_rrdpush_compression_dictionary;
 extern const char *default_rrdpush_destination;
 extern const char *default_rrdpush_api_key;
 extern const char *default_rrdpush_send_charts_matching;
@@ -356,6 +411,12 @@ extern bool default_rrdpush_enable_replication;
 extern time_t default_rrdpush_seconds_to_replicate;
 extern time_t default_rrdpush_replication_step;
 extern unsigned int remote_clock_resync_iterations;
+extern size_t rrdpush_receiver_pool_threads;
+extern bool rrdpush_receiver_pipeline;
+extern size_t rrdpush_sender_pool_threads;
+extern size_t rrdpush_receiver_max_handshakes;
+extern size_t rrdpush_receiver_max_replicating;
+extern size_t rrdpush_receiver_max_bytes_per_sec;
 
 void rrdpush_destinations_init(RRDHOST *host);
 void rrdpush_destinations_free(RRDHOST *host);
@@ -383,6 +444,7 @@ void rrddim_push_metrics_v2(RRDSET_STREAM_BUFFER *rsb, RRDDIM *rd, usec_t point_
 
 bool rrdset_push_chart_definition_now(RRDSET *st);
 void *rrdpush_sender_thread(void *ptr);
+bool rrdpush_sender_pool_add(struct sender_state *s);
 void rrdpush_send_host_labels(RRDHOST *host);
 void rrdpush_send_global_functions(RRDHOST *host);
 
@@ -406,6 +468,11 @@ const char *stream_handshake_error_to_string(STREAM_HANDSHAKE handshake_error);
 void rrdpush_receive_log_status(struct receiver_state *rpt, const char *msg, const char *status, ND_LOG_FIELD_PRIORITY priority);
 
 void receiver_state_free(struct receiver_state *rpt);
+bool rrdpush_receiver_admission_handshake_start(struct receiver_state *rpt);
+void rrdpush_receiver_admission_handshake_done(struct receiver_state *rpt);
+size_t rrdpush_receiver_admission_handshakes(void);
+size_t rrdpush_receiver_admission_rejected(void);
+void rrdpush_receiver_admission_rejected_one(void);
 bool stop_streaming_receiver(RRDHOST *host, STREAM_HANDSHAKE reason);
 
 void sender_thread_buffer_free(void);
@@ -631,6 +698,7 @@ typedef struct rrdhost_status {
         uint32_t id;
         time_t since;
         STREAM_HANDSHAKE reason;
+        size_t throttled;           // the seconds the receiver reached its bytes/sec limit
 
         struct {
             bool in_progress;
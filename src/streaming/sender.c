@@ -142,6 +142,25 @@ static void rrdpush_sender_on_disconnect(RRDHOST *host) {
 }
 
 // TCP window is open, and we have data to transmit.
+// sends both segments of the circular buffer at once, when it wraps around
+static ssize_t attempt_to_send_segments(struct sender_state *s, struct iovec iov[2], size_t segments) {
+    if(SSL_connection(&s->ssl)) {
+        ssize_t ret = netdata_ssl_write(&s->ssl, iov[0].iov_base, iov[0].iov_len);
+        if(ret == (ssize_t)iov[0].iov_len && segments > 1) {
+            ssize_t ret2 = netdata_ssl_write(&s->ssl, iov[1].iov_base, iov[1].iov_len);
+            if(ret2 > 0)
+                ret += ret2;
+        }
+        return ret;
+    }
+
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = segments,
+    };
+    return sendmsg(s->rrdpush_sender_socket, &msg, MSG_DONTWAIT);
+}
+
 static ssize_t attempt_to_send(struct sender_state *s) {
     ssize_t ret;
 
@@ -150,14 +169,14 @@ static ssize_t attempt_to_send(struct sender_state *s) {
 #endif
 
     sender_lock(s);
-    char *chunk;
-    size_t outstanding = cbuffer_next_unsafe(s->buffer, &chunk);
-    netdata_log_debug(D_STREAM, "STREAM: Sending data. Buffer r=%zu w=%zu s=%zu, next chunk=%zu", cb->read, cb->write, cb->size, outstanding);
+    struct iovec iov[2];
+    size_t segments = cbuffer_next_segments_unsafe(s->buffer, iov);
+    netdata_log_debug(D_STREAM, "STREAM: Sending data. Buffer r=%zu w=%zu s=%zu, segments=%zu", cb->read, cb->write, cb->size, segments);
 
-    if(SSL_connection(&s->ssl))
-        ret = netdata_ssl_write(&s->ssl, chunk, outstanding);
+    if(!segments)
+        ret = 0;
     else
-        ret = send(s->rrdpush_sender_socket, chunk, outstanding, MSG_DONTWAIT);
+        ret = attempt_to_send_segments(s, iov, segments);
 
     if (likely(ret > 0)) {
         cbuffer_remove_unsafe(s->buffer, ret);
@@ -403,19 +422,7 @@ static bool stream_sender_log_dst_port(BUFFER *wb, void *ptr) {
     return true;
 }
 
-void *rrdpush_sender_thread(void *ptr) {
-    struct sender_state *s = ptr;
-
-    ND_LOG_STACK lgs[] = {
-            ND_LOG_FIELD_STR(NDF_NIDL_NODE, s->host->hostname),
-            ND_LOG_FIELD_CB(NDF_DST_IP, stream_sender_log_dst_ip, s),
-            ND_LOG_FIELD_CB(NDF_DST_PORT, stream_sender_log_dst_port, s),
-            ND_LOG_FIELD_CB(NDF_DST_TRANSPORT, stream_sender_log_transport, s),
-            ND_LOG_FIELD_CB(NDF_SRC_CAPABILITIES, stream_sender_log_capabilities, s),
-            ND_LOG_FIELD_END(),
-    };
-    ND_LOG_STACK_PUSH(lgs);
-
+static void rrdpush_sender_worker_register(void) {
     worker_register("STREAMSND");
     worker_register_job_name(WORKER_SENDER_JOB_CONNECT, "connect");
     worker_register_job_name(WORKER_SENDER_JOB_PIPE_READ, "pipe read");
@@ -446,19 +453,22 @@ void *rrdpush_sender_thread(void *ptr) {
     worker_register_job_custom_metric(WORKER_SENDER_JOB_BYTES_UNCOMPRESSED, "bytes uncompressed", "bytes/s", WORKER_METRIC_INCREMENTAL_TOTAL);
     worker_register_job_custom_metric(WORKER_SENDER_JOB_BYTES_COMPRESSION_RATIO, "cumulative compression savings ratio", "%", WORKER_METRIC_ABSOLUTE);
     worker_register_job_custom_metric(WORKER_SENDER_JOB_REPLAY_DICT_SIZE, "replication dict entries", "entries", WORKER_METRIC_ABSOLUTE);
+}
 
+// claims the sender of the host for the calling thread and loads its configuration
+static bool rrdpush_sender_start(struct sender_state *s) {
     if(!rrdhost_has_rrdpush_sender_enabled(s->host) || !s->host->rrdpush.send.destination ||
        !*s->host->rrdpush.send.destination || !s->host->rrdpush.send.api_key ||
        !*s->host->rrdpush.send.api_key) {
         netdata_log_error("STREAM %s [send]: thread created (task id %d), but host has streaming disabled.",
               rrdhost_hostname(s->host), gettid_cached());
-        return NULL;
+        return false;
     }
 
     if(!rrdhost_set_sender(s->host)) {
         netdata_log_error("STREAM %s [send]: thread created (task id %d), but there is another sender running for this host.",
               rrdhost_hostname(s->host), gettid_cached());
-        return NULL;
+        return false;
     }
 
     rrdpush_initialize_ssl_ctx(s->host);
@@ -488,6 +498,259 @@ void *rrdpush_sender_thread(void *ptr) {
     // initialize rrdpush globals
     rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED | RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
 
+    if(!rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, true)) {
+        netdata_log_error("STREAM %s [send]: cannot create inter-thread communication pipe. Disabling streaming.",
+              rrdhost_hostname(s->host));
+
+        sender_lock(s);
+        rrdhost_clear_sender___while_having_sender_mutex(s->host);
+        sender_unlock(s);
+        return false;
+    }
+
+    return true;
+}
+
+static void rrdpush_sender_stop(struct sender_state *s, bool was_connected) {
+    if(was_connected)
+        rrdpush_sender_on_disconnect(s->host);
+
+    netdata_log_info("STREAM %s [send]: sending thread exits %s",
+                     rrdhost_hostname(s->host),
+                     s->exit.reason != STREAM_HANDSHAKE_NEVER ? stream_handshake_error_to_string(s->exit.reason) : "");
+
+    sender_lock(s);
+    {
+        rrdpush_sender_thread_close_socket(s);
+        rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, false);
+        rrdpush_sender_execute_commands_cleanup(s);
+
+        rrdhost_clear_sender___while_having_sender_mutex(s->host);
+
+#ifdef NETDATA_LOG_STREAM_SENDER
+        if (s->stream_log_fp) {
+            fclose(s->stream_log_fp);
+            s->stream_log_fp = NULL;
+        }
+#endif
+    }
+    sender_unlock(s);
+}
+
+// to be called before connecting to the parent
+static void rrdpush_sender_before_connect(struct sender_state *s, bool was_connected) {
+    if(was_connected)
+        rrdpush_sender_on_disconnect(s->host);
+
+    worker_is_busy(WORKER_SENDER_JOB_CONNECT);
+
+    rrdpush_sender_cbuffer_recreate_timed(s, now_monotonic_sec(), false, true);
+    rrdpush_sender_execute_commands_cleanup(s);
+
+    rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
+    s->flags &= ~SENDER_FLAG_OVERFLOW;
+    s->read_len = 0;
+    s->buffer->read = 0;
+    s->buffer->write = 0;
+}
+
+// to be called after we connected to the parent
+static void rrdpush_sender_connected(struct sender_state *s) {
+    s->last_traffic_seen_t = now_monotonic_sec();
+    stream_path_send_to_parent(s->host);
+    rrdpush_sender_send_claimed_id(s->host);
+    rrdpush_send_host_labels(s->host);
+    rrdpush_send_global_functions(s->host);
+    s->replication.oldest_request_after_t = 0;
+
+    rrdhost_flag_set(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
+
+    nd_log(NDLS_DAEMON, NDLP_DEBUG,
+           "STREAM %s [send to %s]: enabling metrics streaming...",
+           rrdhost_hostname(s->host), s->connected_to);
+}
+
+enum {
+    SENDER_POLL_COLLECTOR = 0,
+    SENDER_POLL_SOCKET,
+
+    // terminator
+    SENDER_POLL_FDS,
+};
+
+typedef enum {
+    SENDER_POLL_READY = 0,                  // the pollfds are ready for poll()
+    SENDER_POLL_SKIP,                       // the connection has been closed, try again
+    SENDER_POLL_EXIT,                       // the sender has to exit
+} SENDER_POLL_PREPARE;
+
+// checks a connected sender and prepares its pollfds
+static SENDER_POLL_PREPARE rrdpush_sender_poll_prepare(struct sender_state *s, time_t now_s, struct pollfd *fds) {
+    // If the TCP window never opened then something is wrong, restart connection
+    if(unlikely(now_s - s->last_traffic_seen_t > s->timeout &&
+        !rrdpush_sender_pending_replication_requests(s) &&
+        !rrdpush_sender_replicating_charts(s)
+    )) {
+        worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_TIMEOUT);
+        netdata_log_error("STREAM %s [send to %s]: could not send metrics for %d seconds - closing connection - we have sent %zu bytes on this connection via %zu send attempts.", rrdhost_hostname(s->host), s->connected_to, s->timeout, s->sent_bytes_on_this_connection, s->send_attempts);
+        rrdpush_sender_thread_close_socket(s);
+        return SENDER_POLL_SKIP;
+    }
+
+    sender_lock(s);
+    size_t outstanding = cbuffer_next_unsafe(s->buffer, NULL);
+    size_t available = cbuffer_available_size_unsafe(s->buffer);
+    if (unlikely(!outstanding)) {
+        rrdpush_sender_pipe_clear_pending_data(s);
+        rrdpush_sender_cbuffer_recreate_timed(s, now_s, true, false);
+    }
+
+    if(s->compressor.initialized) {
+        size_t bytes_uncompressed = s->compressor.sender_locked.total_uncompressed;
+        size_t bytes_compressed = s->compressor.sender_locked.total_compressed + s->compressor.sender_locked.total_compressions * sizeof(rrdpush_signature_t);
+        NETDATA_DOUBLE ratio = 100.0 - ((NETDATA_DOUBLE)bytes_compressed * 100.0 / (NETDATA_DOUBLE)bytes_uncompressed);
+        worker_set_metric(WORKER_SENDER_JOB_BYTES_UNCOMPRESSED, (NETDATA_DOUBLE)bytes_uncompressed);
+        worker_set_metric(WORKER_SENDER_JOB_BYTES_COMPRESSED, (NETDATA_DOUBLE)bytes_compressed);
+        worker_set_metric(WORKER_SENDER_JOB_BYTES_COMPRESSION_RATIO, ratio);
+    }
+    sender_unlock(s);
+
+    worker_set_metric(WORKER_SENDER_JOB_BUFFER_RATIO, (NETDATA_DOUBLE)(s->buffer->max_size - available) * 100.0 / (NETDATA_DOUBLE)s->buffer->max_size);
+
+    if(outstanding)
+        s->send_attempts++;
+
+    if(unlikely(s->rrdpush_sender_pipe[PIPE_READ] == -1)) {
+        if(!rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, true)) {
+            netdata_log_error("STREAM %s [send]: cannot create inter-thread communication pipe. "
+                              "Disabling streaming.", rrdhost_hostname(s->host));
+            rrdpush_sender_thread_close_socket(s);
+            return SENDER_POLL_EXIT;
+        }
+    }
+
+    // Wait until buffer opens in the socket or a rrdset_done_push wakes us
+    fds[SENDER_POLL_COLLECTOR] = (struct pollfd){
+        .fd = s->rrdpush_sender_pipe[PIPE_READ],
+        .events = POLLIN,
+        .revents = 0,
+    };
+    fds[SENDER_POLL_SOCKET] = (struct pollfd){
+        .fd = s->rrdpush_sender_socket,
+        .events = POLLIN | (outstanding ? POLLOUT : 0 ),
+        .revents = 0,
+    };
+
+    return SENDER_POLL_READY;
+}
+
+// processes the events poll() returned for a connected sender
+static void rrdpush_sender_poll_process(struct sender_state *s, struct pollfd *fds, char *pipe_buffer, size_t pipe_buffer_size) {
+    internal_error(fds[SENDER_POLL_COLLECTOR].fd != s->rrdpush_sender_pipe[PIPE_READ],
+        "STREAM %s [send to %s]: pipe changed after poll().", rrdhost_hostname(s->host), s->connected_to);
+
+    internal_error(fds[SENDER_POLL_SOCKET].fd != s->rrdpush_sender_socket,
+        "STREAM %s [send to %s]: socket changed after poll().", rrdhost_hostname(s->host), s->connected_to);
+
+     // If we have data and have seen the TCP window open then try to close it by a transmission.
+    if(likely((fds[SENDER_POLL_SOCKET].events & POLLOUT) && (fds[SENDER_POLL_SOCKET].revents & POLLOUT))) {
+        worker_is_busy(WORKER_SENDER_JOB_SOCKET_SEND);
+        ssize_t bytes = attempt_to_send(s);
+        if(bytes > 0) {
+            s->last_traffic_seen_t = now_monotonic_sec();
+            worker_set_metric(WORKER_SENDER_JOB_BYTES_SENT, (NETDATA_DOUBLE)bytes);
+        }
+    }
+
+    // If the collector woke us up then empty the pipe to remove the signal
+    if (fds[SENDER_POLL_COLLECTOR].revents & (POLLIN|POLLPRI)) {
+        worker_is_busy(WORKER_SENDER_JOB_PIPE_READ);
+        netdata_log_debug(D_STREAM, "STREAM: Data added to send buffer...");
+
+        if (read(fds[SENDER_POLL_COLLECTOR].fd, pipe_buffer, pipe_buffer_size) == -1)
+            netdata_log_error("STREAM %s [send to %s]: cannot read from internal pipe.", rrdhost_hostname(s->host), s->connected_to);
+    }
+
+    // Read as much as possible to fill the buffer, split into full lines for execution.
+    if (fds[SENDER_POLL_SOCKET].revents & POLLIN) {
+        worker_is_busy(WORKER_SENDER_JOB_SOCKET_RECEIVE);
+        ssize_t bytes = attempt_read(s);
+        if(bytes > 0) {
+            s->last_traffic_seen_t = now_monotonic_sec();
+            worker_set_metric(WORKER_SENDER_JOB_BYTES_RECEIVED, (NETDATA_DOUBLE)bytes);
+        }
+    }
+
+    if(unlikely(s->read_len))
+        rrdpush_sender_execute_commands(s);
+
+    if(unlikely(fds[SENDER_POLL_COLLECTOR].revents & (POLLERR|POLLHUP|POLLNVAL))) {
+        char *error = NULL;
+
+        if (unlikely(fds[SENDER_POLL_COLLECTOR].revents & POLLERR))
+            error = "pipe reports errors (POLLERR)";
+        else if (unlikely(fds[SENDER_POLL_COLLECTOR].revents & POLLHUP))
+            error = "pipe closed (POLLHUP)";
+        else if (unlikely(fds[SENDER_POLL_COLLECTOR].revents & POLLNVAL))
+            error = "pipe is invalid (POLLNVAL)";
+
+        if(error) {
+            rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, true);
+            netdata_log_error("STREAM %s [send to %s]: restarting internal pipe: %s.",
+                              rrdhost_hostname(s->host), s->connected_to, error);
+        }
+    }
+
+    if(unlikely(fds[SENDER_POLL_SOCKET].revents & (POLLERR|POLLHUP|POLLNVAL))) {
+        char *error = NULL;
+
+        if (unlikely(fds[SENDER_POLL_SOCKET].revents & POLLERR))
+            error = "socket reports errors (POLLERR)";
+        else if (unlikely(fds[SENDER_POLL_SOCKET].revents & POLLHUP))
+            error = "connection closed by remote end (POLLHUP)";
+        else if (unlikely(fds[SENDER_POLL_SOCKET].revents & POLLNVAL))
+            error = "connection is invalid (POLLNVAL)";
+
+        if(unlikely(error)) {
+            worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_SOCKET_ERROR);
+            netdata_log_error("STREAM %s [send to %s]: restarting connection: %s - %zu bytes transmitted.",
+                              rrdhost_hostname(s->host), s->connected_to, error, s->sent_bytes_on_this_connection);
+            rrdpush_sender_thread_close_socket(s);
+        }
+    }
+
+    // protection from overflow
+    if(unlikely(s->flags & SENDER_FLAG_OVERFLOW)) {
+        worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_OVERFLOW);
+        errno_clear();
+        netdata_log_error("STREAM %s [send to %s]: buffer full (allocated %zu bytes) after sending %zu bytes. Restarting connection",
+                          rrdhost_hostname(s->host), s->connected_to, s->buffer->size, s->sent_bytes_on_this_connection);
+        rrdpush_sender_thread_close_socket(s);
+    }
+
+    worker_set_metric(WORKER_SENDER_JOB_REPLAY_DICT_SIZE, (NETDATA_DOUBLE) dictionary_entries(s->replication.requests));
+}
+
+void *rrdpush_sender_thread(void *ptr) {
+    struct sender_state *s = ptr;
+
+    ND_LOG_STACK lgs[] = {
+            ND_LOG_FIELD_STR(NDF_NIDL_NODE, s->host->hostname),
+            ND_LOG_FIELD_CB(NDF_DST_IP, stream_sender_log_dst_ip, s),
+            ND_LOG_FIELD_CB(NDF_DST_PORT, stream_sender_log_dst_port, s),
+            ND_LOG_FIELD_CB(NDF_DST_TRANSPORT, stream_sender_log_transport, s),
+            ND_LOG_FIELD_CB(NDF_SRC_CAPABILITIES, stream_sender_log_capabilities, s),
+            ND_LOG_FIELD_END(),
+    };
+    ND_LOG_STACK_PUSH(lgs);
+
+    rrdpush_sender_worker_register();
+
+    if(!rrdpush_sender_start(s)) {
+        worker_unregister();
+        return NULL;
+    }
+
     int pipe_buffer_size = 10 * 1024;
 #ifdef F_GETPIPE_SZ
     pipe_buffer_size = fcntl(s->rrdpush_sender_pipe[PIPE_READ], F_GETPIPE_SZ);
@@ -495,12 +758,6 @@ void *rrdpush_sender_thread(void *ptr) {
     if(pipe_buffer_size < 10 * 1024)
         pipe_buffer_size = 10 * 1024;
 
-    if(!rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, true)) {
-        netdata_log_error("STREAM %s [send]: cannot create inter-thread communication pipe. Disabling streaming.",
-              rrdhost_hostname(s->host));
-        return NULL;
-    }
-
     char *pipe_buffer = mallocz(pipe_buffer_size);
 
     bool was_connected = false;
@@ -511,22 +768,8 @@ void *rrdpush_sender_thread(void *ptr) {
 
         // The connection attempt blocks (after which we use the socket in nonblocking)
         if(unlikely(s->rrdpush_sender_socket == -1)) {
-            if(was_connected) {
-                rrdpush_sender_on_disconnect(s->host);
-                was_connected = false;
-            }
-
-            worker_is_busy(WORKER_SENDER_JOB_CONNECT);
-
-            now_s = now_monotonic_sec();
-            rrdpush_sender_cbuffer_recreate_timed(s, now_s, false, true);
-            rrdpush_sender_execute_commands_cleanup(s);
-
-            rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
-            s->flags &= ~SENDER_FLAG_OVERFLOW;
-            s->read_len = 0;
-            s->buffer->read = 0;
-            s->buffer->write = 0;
+            rrdpush_sender_before_connect(s, was_connected);
+            was_connected = false;
 
             if(!attempt_to_connect(s))
                 continue;
@@ -534,103 +777,32 @@ void *rrdpush_sender_thread(void *ptr) {
             if(rrdhost_sender_should_exit(s))
                 break;
 
-            now_s = s->last_traffic_seen_t = now_monotonic_sec();
-            stream_path_send_to_parent(s->host);
-            rrdpush_sender_send_claimed_id(s->host);
-            rrdpush_send_host_labels(s->host);
-            rrdpush_send_global_functions(s->host);
-            s->replication.oldest_request_after_t = 0;
+            rrdpush_sender_connected(s);
+            now_s = s->last_traffic_seen_t;
             was_connected = true;
-
-            rrdhost_flag_set(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
-
-            nd_log(NDLS_DAEMON, NDLP_DEBUG,
-                   "STREAM %s [send to %s]: enabling metrics streaming...",
-                   rrdhost_hostname(s->host), s->connected_to);
-
             continue;
         }
 
         if(iterations % 1000 == 0)
             now_s = now_monotonic_sec();
 
-        // If the TCP window never opened then something is wrong, restart connection
-        if(unlikely(now_s - s->last_traffic_seen_t > s->timeout &&
-            !rrdpush_sender_pending_replication_requests(s) &&
-            !rrdpush_sender_replicating_charts(s)
-        )) {
-            worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_TIMEOUT);
-            netdata_log_error("STREAM %s [send to %s]: could not send metrics for %d seconds - closing connection - we have sent %zu bytes on this connection via %zu send attempts.", rrdhost_hostname(s->host), s->connected_to, s->timeout, s->sent_bytes_on_this_connection, s->send_attempts);
-            rrdpush_sender_thread_close_socket(s);
+        struct pollfd fds[SENDER_POLL_FDS];
+        SENDER_POLL_PREPARE prepared = rrdpush_sender_poll_prepare(s, now_s, fds);
+        if(prepared == SENDER_POLL_SKIP)
             continue;
-        }
-
-        sender_lock(s);
-        size_t outstanding = cbuffer_next_unsafe(s->buffer, NULL);
-        size_t available = cbuffer_available_size_unsafe(s->buffer);
-        if (unlikely(!outstanding)) {
-            rrdpush_sender_pipe_clear_pending_data(s);
-            rrdpush_sender_cbuffer_recreate_timed(s, now_s, true, false);
-        }
-
-        if(s->compressor.initialized) {
-            size_t bytes_uncompressed = s->compressor.sender_locked.total_uncompressed;
-            size_t bytes_compressed = s->compressor.sender_locked.total_compressed + s->compressor.sender_locked.total_compressions * sizeof(rrdpush_signature_t);
-            NETDATA_DOUBLE ratio = 100.0 - ((NETDATA_DOUBLE)bytes_compressed * 100.0 / (NETDATA_DOUBLE)bytes_uncompressed);
-            worker_set_metric(WORKER_SENDER_JOB_BYTES_UNCOMPRESSED, (NETDATA_DOUBLE)bytes_uncompressed);
-            worker_set_metric(WORKER_SENDER_JOB_BYTES_COMPRESSED, (NETDATA_DOUBLE)bytes_compressed);
-            worker_set_metric(WORKER_SENDER_JOB_BYTES_COMPRESSION_RATIO, ratio);
-        }
-        sender_unlock(s);
-
-        worker_set_metric(WORKER_SENDER_JOB_BUFFER_RATIO, (NETDATA_DOUBLE)(s->buffer->max_size - available) * 100.0 / (NETDATA_DOUBLE)s->buffer->max_size);
-
-        if(outstanding)
-            s->send_attempts++;
-
-        if(unlikely(s->rrdpush_sender_pipe[PIPE_READ] == -1)) {
-            if(!rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, true)) {
-                netdata_log_error("STREAM %s [send]: cannot create inter-thread communication pipe. "
-                                  "Disabling streaming.", rrdhost_hostname(s->host));
-                rrdpush_sender_thread_close_socket(s);
-                break;
-            }
-        }
+        if(prepared == SENDER_POLL_EXIT)
+            break;
 
         worker_is_idle();
 
-        // Wait until buffer opens in the socket or a rrdset_done_push wakes us
-        enum {
-            Collector = 0,
-            Socket    = 1,
-        };
-        struct pollfd fds[2] = {
-            [Collector] = {
-                .fd = s->rrdpush_sender_pipe[PIPE_READ],
-                .events = POLLIN,
-                .revents = 0,
-            },
-            [Socket] = {
-                .fd = s->rrdpush_sender_socket,
-                .events = POLLIN | (outstanding ? POLLOUT : 0 ),
-                .revents = 0,
-            }
-        };
-
-        int poll_rc = poll(fds, 2, 50); // timeout in milliseconds
+        int poll_rc = poll(fds, SENDER_POLL_FDS, 50); // timeout in milliseconds
 
-        netdata_log_debug(D_STREAM, "STREAM: poll() finished collector=%d socket=%d (current chunk %zu bytes)...",
-              fds[Collector].revents, fds[Socket].revents, outstanding);
+        netdata_log_debug(D_STREAM, "STREAM: poll() finished collector=%d socket=%d...",
+              fds[SENDER_POLL_COLLECTOR].revents, fds[SENDER_POLL_SOCKET].revents);
 
         if(unlikely(rrdhost_sender_should_exit(s)))
             break;
 
-        internal_error(fds[Collector].fd != s->rrdpush_sender_pipe[PIPE_READ],
-            "STREAM %s [send to %s]: pipe changed after poll().", rrdhost_hostname(s->host), s->connected_to);
-
-        internal_error(fds[Socket].fd != s->rrdpush_sender_socket,
-            "STREAM %s [send to %s]: socket changed after poll().", rrdhost_hostname(s->host), s->connected_to);
-
         // Spurious wake-ups without error - loop again
         if (poll_rc == 0 || ((poll_rc == -1) && (errno == EAGAIN || errno == EINTR))) {
             netdata_log_debug(D_STREAM, "Spurious wakeup");
@@ -647,111 +819,373 @@ void *rrdpush_sender_thread(void *ptr) {
             continue;
         }
 
-         // If we have data and have seen the TCP window open then try to close it by a transmission.
-        if(likely(outstanding && (fds[Socket].revents & POLLOUT))) {
-            worker_is_busy(WORKER_SENDER_JOB_SOCKET_SEND);
-            ssize_t bytes = attempt_to_send(s);
-            if(bytes > 0) {
-                s->last_traffic_seen_t = now_monotonic_sec();
-                worker_set_metric(WORKER_SENDER_JOB_BYTES_SENT, (NETDATA_DOUBLE)bytes);
-            }
+        rrdpush_sender_poll_process(s, fds, pipe_buffer, pipe_buffer_size);
+    }
+
+    rrdpush_sender_stop(s, was_connected);
+
+    freez(pipe_buffer);
+    worker_unregister();
+
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// the senders pool
+//
+// A parent relaying many hosts upstream runs one sender per host. When the
+// senders pool is enabled, the senders are served by a fixed number of threads
+// instead, each one poll()ing the pipes and the sockets of all its senders in
+// a single loop. Connecting to a parent blocks, so every connection attempt
+// runs on a short-lived thread, while the pool thread keeps serving the others.
+
+#define SENDER_POOL_PIPE_BUFFER_SIZE (10 * 1024)
+
+struct sender_pool_worker {
+    ND_THREAD *thread;
+    size_t senders;                     // the senders assigned to this thread (atomic)
+    int wakeup[2];                      // a pipe to wake up the thread
+
+    SPINLOCK spinlock;
+    struct sender_state *incoming;      // assigned, but not picked up by the thread yet
+
+    // accessed only by the thread
+    struct sender_state *serving;
+    struct pollfd *fds;
+    size_t fds_size;
+};
+
+static struct {
+    SPINLOCK spinlock;
+    size_t threads;
+    struct sender_pool_worker *workers;
+} sender_pool = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .threads = 0,
+    .workers = NULL,
+};
+
+static void sender_pool_wakeup(struct sender_pool_worker *w) {
+    if(write(w->wakeup[PIPE_WRITE], " ", 1) != 1 && errno != EAGAIN && errno != EWOULDBLOCK)
+        netdata_log_error("STREAM: cannot wake up a senders pool thread");
+}
+
+static void sender_pool_canceller(void *data) {
+    sender_pool_wakeup(data);
+}
+
+static void *sender_pool_connector_thread(void *ptr) {
+    struct sender_state *s = ptr;
+
+    ND_LOG_STACK lgs[] = {
+            ND_LOG_FIELD_STR(NDF_NIDL_NODE, s->host->hostname),
+            ND_LOG_FIELD_CB(NDF_DST_IP, stream_sender_log_dst_ip, s),
+            ND_LOG_FIELD_CB(NDF_DST_PORT, stream_sender_log_dst_port, s),
+            ND_LOG_FIELD_CB(NDF_DST_TRANSPORT, stream_sender_log_transport, s),
+            ND_LOG_FIELD_CB(NDF_SRC_CAPABILITIES, stream_sender_log_capabilities, s),
+            ND_LOG_FIELD_END(),
+    };
+    ND_LOG_STACK_PUSH(lgs);
+
+    bool connected = attempt_to_connect(s);
+
+    spinlock_lock(&s->pool.spinlock);
+    s->pool.connector = NULL;
+    s->pool.connect_result = connected ? 1 : -1;
+    spinlock_unlock(&s->pool.spinlock);
+
+    return NULL;
+}
+
+static void sender_pool_connect(struct sender_state *s, time_t now_s) {
+    rrdpush_sender_before_connect(s, s->pool.was_connected);
+    s->pool.was_connected = false;
+
+    char tag[NETDATA_THREAD_TAG_MAX + 1];
+    snprintfz(tag, NETDATA_THREAD_TAG_MAX, THREAD_TAG_STREAM_SENDER "[%s]", rrdhost_hostname(s->host));
+
+    spinlock_lock(&s->pool.spinlock);
+    s->pool.connect_result = 0;
+    s->pool.connector = nd_thread_create(tag, NETDATA_THREAD_OPTION_DEFAULT, sender_pool_connector_thread, s);
+    s->pool.connecting = (s->pool.connector != NULL);
+    spinlock_unlock(&s->pool.spinlock);
+
+    if(!s->pool.connecting) {
+        netdata_log_error("STREAM %s [send]: cannot create a thread to connect to the parent.", rrdhost_hostname(s->host));
+        s->pool.reconnect_after_s = now_s + s->reconnect_delay;
+    }
+}
+
+// returns 1 when the connection attempt finished, 0 while it is still running
+static int sender_pool_connecting(struct sender_state *s, time_t now_s, bool cancel) {
+    spinlock_lock(&s->pool.spinlock);
+    int result = s->pool.connect_result;
+    if(!result && cancel && s->pool.connector)
+        nd_thread_signal_cancel(s->pool.connector);
+    spinlock_unlock(&s->pool.spinlock);
+
+    if(!result)
+        return 0;
+
+    s->pool.connecting = false;
+
+    if(result > 0) {
+        rrdpush_sender_connected(s);
+        s->pool.was_connected = true;
+    }
+    else
+        // slow re-connection on repeating errors
+        s->pool.reconnect_after_s = now_s + s->reconnect_delay;
+
+    return 1;
+}
+
+static void sender_pool_release(struct sender_pool_worker *w, struct sender_state *s) {
+    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(w->serving, s, pool.prev, pool.next);
+    __atomic_sub_fetch(&w->senders, 1, __ATOMIC_RELAXED);
+
+    // wait for a running connection attempt to finish
+    while(s->pool.connecting && !sender_pool_connecting(s, now_monotonic_sec(), true))
+        sleep_usec(10 * USEC_PER_MS);
+
+    __atomic_store_n(&s->pool.worker, NULL, __ATOMIC_RELEASE);
+
+    // after this, the host may be freed at any time
+    rrdpush_sender_stop(s, s->pool.was_connected);
+}
+
+// prepares the pollfds of a sender
+// returns false when the sender has been released
+static bool sender_pool_prepare(struct sender_pool_worker *w, struct sender_state *s, time_t now_s, struct pollfd *fds) {
+    ND_LOG_STACK lgs[] = {
+            ND_LOG_FIELD_STR(NDF_NIDL_NODE, s->host->hostname),
+            ND_LOG_FIELD_CB(NDF_DST_IP, stream_sender_log_dst_ip, s),
+            ND_LOG_FIELD_CB(NDF_DST_PORT, stream_sender_log_dst_port, s),
+            ND_LOG_FIELD_CB(NDF_DST_TRANSPORT, stream_sender_log_transport, s),
+            ND_LOG_FIELD_CB(NDF_SRC_CAPABILITIES, stream_sender_log_capabilities, s),
+            ND_LOG_FIELD_END(),
+    };
+    ND_LOG_STACK_PUSH(lgs);
+
+    fds[SENDER_POLL_COLLECTOR] = (struct pollfd){ .fd = -1, .events = 0, .revents = 0, };
+    fds[SENDER_POLL_SOCKET] = (struct pollfd){ .fd = -1, .events = 0, .revents = 0, };
+    s->pool.polled = false;
+
+    bool should_exit = rrdhost_sender_should_exit(s);
+
+    if(s->pool.connecting && !sender_pool_connecting(s, now_s, should_exit))
+        return true;
+
+    if(should_exit || rrdhost_sender_should_exit(s)) {
+        sender_pool_release(w, s);
+        return false;
+    }
+
+    if(unlikely(s->rrdpush_sender_socket == -1)) {
+        if(now_s >= s->pool.reconnect_after_s)
+            sender_pool_connect(s, now_s);
+
+        return true;
+    }
+
+    switch(rrdpush_sender_poll_prepare(s, now_s, fds)) {
+        case SENDER_POLL_READY:
+            s->pool.polled = true;
+            break;
+
+        case SENDER_POLL_SKIP:
+            fds[SENDER_POLL_COLLECTOR].fd = fds[SENDER_POLL_SOCKET].fd = -1;
+            break;
+
+        case SENDER_POLL_EXIT:
+            sender_pool_release(w, s);
+            return false;
+    }
+
+    return true;
+}
+
+static void sender_pool_process(struct sender_state *s, struct pollfd *fds, char *pipe_buffer) {
+    ND_LOG_STACK lgs[] = {
+            ND_LOG_FIELD_STR(NDF_NIDL_NODE, s->host->hostname),
+            ND_LOG_FIELD_CB(NDF_DST_IP, stream_sender_log_dst_ip, s),
+            ND_LOG_FIELD_CB(NDF_DST_PORT, stream_sender_log_dst_port, s),
+            ND_LOG_FIELD_CB(NDF_DST_TRANSPORT, stream_sender_log_transport, s),
+            ND_LOG_FIELD_CB(NDF_SRC_CAPABILITIES, stream_sender_log_capabilities, s),
+            ND_LOG_FIELD_END(),
+    };
+    ND_LOG_STACK_PUSH(lgs);
+
+    if(!fds[SENDER_POLL_COLLECTOR].revents && !fds[SENDER_POLL_SOCKET].revents && !s->read_len)
+        return;
+
+    rrdpush_sender_poll_process(s, fds, pipe_buffer, SENDER_POOL_PIPE_BUFFER_SIZE);
+}
+
+static void sender_pool_pickup_incoming(struct sender_pool_worker *w) {
+    spinlock_lock(&w->spinlock);
+    struct sender_state *incoming = w->incoming;
+    w->incoming = NULL;
+    spinlock_unlock(&w->spinlock);
+
+    while(incoming) {
+        struct sender_state *s = incoming;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(incoming, s, pool.prev, pool.next);
+
+        ND_LOG_STACK lgs[] = {
+                ND_LOG_FIELD_STR(NDF_NIDL_NODE, s->host->hostname),
+                ND_LOG_FIELD_END(),
+        };
+        ND_LOG_STACK_PUSH(lgs);
+
+        if(!rrdpush_sender_start(s)) {
+            __atomic_sub_fetch(&w->senders, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&s->pool.worker, NULL, __ATOMIC_RELEASE);
+            continue;
         }
 
-        // If the collector woke us up then empty the pipe to remove the signal
-        if (fds[Collector].revents & (POLLIN|POLLPRI)) {
-            worker_is_busy(WORKER_SENDER_JOB_PIPE_READ);
-            netdata_log_debug(D_STREAM, "STREAM: Data added to send buffer (current buffer chunk %zu bytes)...", outstanding);
+        s->pool.was_connected = false;
+        s->pool.connecting = false;
+        s->pool.reconnect_after_s = 0;
+        DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(w->serving, s, pool.prev, pool.next);
+    }
+}
+
+static void *sender_pool_worker_main(void *ptr) {
+    struct sender_pool_worker *w = ptr;
+
+    rrdpush_sender_worker_register();
+    nd_thread_register_canceller(sender_pool_canceller, w);
+
+    char *pipe_buffer = mallocz(SENDER_POOL_PIPE_BUFFER_SIZE);
 
-            if (read(fds[Collector].fd, pipe_buffer, pipe_buffer_size) == -1)
-                netdata_log_error("STREAM %s [send to %s]: cannot read from internal pipe.", rrdhost_hostname(s->host), s->connected_to);
+    while(service_running(SERVICE_STREAMING) && !nd_thread_signaled_to_cancel()) {
+        sender_pool_pickup_incoming(w);
+
+        size_t entries = 1;
+        struct sender_state *s;
+        for(s = w->serving; s ; s = s->pool.next)
+            entries += SENDER_POLL_FDS;
+
+        if(entries > w->fds_size) {
+            w->fds = reallocz(w->fds, entries * sizeof(*w->fds));
+            w->fds_size = entries;
         }
 
-        // Read as much as possible to fill the buffer, split into full lines for execution.
-        if (fds[Socket].revents & POLLIN) {
-            worker_is_busy(WORKER_SENDER_JOB_SOCKET_RECEIVE);
-            ssize_t bytes = attempt_read(s);
-            if(bytes > 0) {
-                s->last_traffic_seen_t = now_monotonic_sec();
-                worker_set_metric(WORKER_SENDER_JOB_BYTES_RECEIVED, (NETDATA_DOUBLE)bytes);
+        w->fds[0] = (struct pollfd){ .fd = w->wakeup[PIPE_READ], .events = POLLIN, .revents = 0, };
+
+        time_t now_s = now_monotonic_sec();
+        size_t slot = 1;
+        s = w->serving;
+        while(s) {
+            struct sender_state *next = s->pool.next;
+
+            if(sender_pool_prepare(w, s, now_s, &w->fds[slot])) {
+                s->pool.slot = slot;
+                slot += SENDER_POLL_FDS;
             }
+
+            s = next;
         }
 
-        if(unlikely(s->read_len))
-            rrdpush_sender_execute_commands(s);
+        worker_is_idle();
 
-        if(unlikely(fds[Collector].revents & (POLLERR|POLLHUP|POLLNVAL))) {
-            char *error = NULL;
+        errno_clear();
+        int poll_rc = poll(w->fds, slot, 50); // timeout in milliseconds
+        if(poll_rc == -1 && errno != EAGAIN && errno != EINTR) {
+            worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_POLL_ERROR);
+            netdata_log_error("STREAM: senders pool failed to poll().");
+            sleep_usec(50 * USEC_PER_MS);
+            continue;
+        }
 
-            if (unlikely(fds[Collector].revents & POLLERR))
-                error = "pipe reports errors (POLLERR)";
-            else if (unlikely(fds[Collector].revents & POLLHUP))
-                error = "pipe closed (POLLHUP)";
-            else if (unlikely(fds[Collector].revents & POLLNVAL))
-                error = "pipe is invalid (POLLNVAL)";
+        if(poll_rc <= 0)
+            continue;
 
-            if(error) {
-                rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, true);
-                netdata_log_error("STREAM %s [send to %s]: restarting internal pipe: %s.",
-                                  rrdhost_hostname(s->host), s->connected_to, error);
-            }
+        if(w->fds[0].revents & POLLIN) {
+            while(read(w->wakeup[PIPE_READ], pipe_buffer, SENDER_POOL_PIPE_BUFFER_SIZE) > 0) ;
         }
 
-        if(unlikely(fds[Socket].revents & (POLLERR|POLLHUP|POLLNVAL))) {
-            char *error = NULL;
-
-            if (unlikely(fds[Socket].revents & POLLERR))
-                error = "socket reports errors (POLLERR)";
-            else if (unlikely(fds[Socket].revents & POLLHUP))
-                error = "connection closed by remote end (POLLHUP)";
-            else if (unlikely(fds[Socket].revents & POLLNVAL))
-                error = "connection is invalid (POLLNVAL)";
-
-            if(unlikely(error)) {
-                worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_SOCKET_ERROR);
-                netdata_log_error("STREAM %s [send to %s]: restarting connection: %s - %zu bytes transmitted.",
-                                  rrdhost_hostname(s->host), s->connected_to, error, s->sent_bytes_on_this_connection);
-                rrdpush_sender_thread_close_socket(s);
-            }
+        for(s = w->serving; s ; s = s->pool.next) {
+            if(s->pool.polled)
+                sender_pool_process(s, &w->fds[s->pool.slot], pipe_buffer);
         }
+    }
 
-        // protection from overflow
-        if(unlikely(s->flags & SENDER_FLAG_OVERFLOW)) {
-            worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_OVERFLOW);
-            errno_clear();
-            netdata_log_error("STREAM %s [send to %s]: buffer full (allocated %zu bytes) after sending %zu bytes. Restarting connection",
-                              rrdhost_hostname(s->host), s->connected_to, s->buffer->size, s->sent_bytes_on_this_connection);
-            rrdpush_sender_thread_close_socket(s);
+    // we are exiting, stop all our senders
+    sender_pool_pickup_incoming(w);
+    while(w->serving)
+        sender_pool_release(w, w->serving);
+
+    freez(pipe_buffer);
+    worker_unregister();
+    return NULL;
+}
+
+static void sender_pool_start(void) {
+    size_t threads = rrdpush_sender_pool_threads;
+    sender_pool.workers = callocz(threads, sizeof(*sender_pool.workers));
+
+    for(size_t i = 0; i < threads ;i++) {
+        struct sender_pool_worker *w = &sender_pool.workers[sender_pool.threads];
+        spinlock_init(&w->spinlock);
+
+        if(pipe(w->wakeup) != 0) {
+            netdata_log_error("STREAM: cannot create the wake up pipe of a senders pool thread");
+            continue;
         }
 
-        worker_set_metric(WORKER_SENDER_JOB_REPLAY_DICT_SIZE, (NETDATA_DOUBLE) dictionary_entries(s->replication.requests));
+        sock_setnonblock(w->wakeup[PIPE_READ]);
+        sock_setnonblock(w->wakeup[PIPE_WRITE]);
+
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, THREAD_TAG_STREAM_SENDER "[%zu]", sender_pool.threads);
+
+        w->thread = nd_thread_create(tag, NETDATA_THREAD_OPTION_DEFAULT, sender_pool_worker_main, w);
+        if(!w->thread) {
+            close(w->wakeup[PIPE_READ]);
+            close(w->wakeup[PIPE_WRITE]);
+            continue;
+        }
+
+        sender_pool.threads++;
     }
 
-    if(was_connected)
-        rrdpush_sender_on_disconnect(s->host);
+    netdata_log_info("STREAM: started %zu stream sender threads", sender_pool.threads);
+}
 
-    netdata_log_info("STREAM %s [send]: sending thread exits %s",
-                     rrdhost_hostname(s->host),
-                     s->exit.reason != STREAM_HANDSHAKE_NEVER ? stream_handshake_error_to_string(s->exit.reason) : "");
+// assigns the sender to the least busy thread of the pool, starting the pool on first use
+bool rrdpush_sender_pool_add(struct sender_state *s) {
+    if(!rrdpush_sender_pool_threads || !service_running(SERVICE_STREAMING))
+        return false;
 
-    sender_lock(s);
-    {
-        rrdpush_sender_thread_close_socket(s);
-        rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, false);
-        rrdpush_sender_execute_commands_cleanup(s);
+    spinlock_lock(&sender_pool.spinlock);
 
-        rrdhost_clear_sender___while_having_sender_mutex(s->host);
+    if(!sender_pool.workers)
+        sender_pool_start();
 
-#ifdef NETDATA_LOG_STREAM_SENDER
-        if (s->stream_log_fp) {
-            fclose(s->stream_log_fp);
-            s->stream_log_fp = NULL;
-        }
-#endif
+    struct sender_pool_worker *w = NULL;
+    for(size_t i = 0; i < sender_pool.threads ;i++) {
+        struct sender_pool_worker *t = &sender_pool.workers[i];
+        if(!w || __atomic_load_n(&t->senders, __ATOMIC_RELAXED) < __atomic_load_n(&w->senders, __ATOMIC_RELAXED))
+            w = t;
     }
-    sender_unlock(s);
 
-    freez(pipe_buffer);
-    worker_unregister();
+    if(w)
+        __atomic_add_fetch(&w->senders, 1, __ATOMIC_RELAXED);
 
-    return NULL;
+    spinlock_unlock(&sender_pool.spinlock);
+
+    if(!w)
+        return false;
+
+    __atomic_store_n(&s->pool.worker, w, __ATOMIC_RELEASE);
+    spinlock_init(&s->pool.spinlock);
+
+    spinlock_lock(&w->spinlock);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(w->incoming, s, pool.prev, pool.next);
+    spinlock_unlock(&w->spinlock);
+
+    sender_pool_wakeup(w);
+    return true;
 }
@@ -135,7 +135,9 @@ void sender_commit(struct sender_state *s, BUFFER *wb, STREAM_TRAFFIC_TYPE type)
                       size_to_compress, dst_len, decoded_dst_len);
 #endif
 
-            if(cbuffer_add_unsafe(s->buffer, (const char *)&signature, sizeof(signature)))
+            // never queue a signature without its payload
+            if(sizeof(signature) + dst_len >= cbuffer_available_size_unsafe(s->buffer) ||
+                cbuffer_add_unsafe(s->buffer, (const char *)&signature, sizeof(signature)))
                 s->flags |= SENDER_FLAG_OVERFLOW;
             else {
                 if(cbuffer_add_unsafe(s->buffer, dst, dst_len))
@@ -5,6 +5,16 @@
 void rrdpush_sender_thread_close_socket(struct sender_state *s) {
     rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED | RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
 
+    // keep the TLS session, to resume it when we reconnect to the same parent
+    struct rrdpush_destinations *d = s->host->destination;
+    if(d && d->ssl) {
+        SSL_SESSION *session = netdata_ssl_session_get(&s->ssl);
+        if(session) {
+            netdata_ssl_session_free(d->ssl_session);
+            d->ssl_session = session;
+        }
+    }
+
     netdata_ssl_close(&s->ssl);
 
     if(s->rrdpush_sender_socket != -1) {
@@ -246,9 +256,15 @@ static bool rrdpush_sender_connect_ssl(struct sender_state *s) {
         return true;
 
     if (netdata_ssl_open_ext(&host->sender->ssl, netdata_ssl_streaming_sender_ctx, s->rrdpush_sender_socket, alpn_proto_list, sizeof(alpn_proto_list))) {
+        netdata_ssl_session_set(&host->sender->ssl, host->destination->ssl_session);
+
         if(!netdata_ssl_connect(&host->sender->ssl)) {
             // couldn't connect
 
+            // do not offer this session again
+            netdata_ssl_session_free(host->destination->ssl_session);
+            host->destination->ssl_session = NULL;
+
             ND_LOG_STACK lgs[] = {
                 ND_LOG_FIELD_TXT(NDF_RESPONSE_CODE, RRDPUSH_STATUS_SSL_ERROR),
                 ND_LOG_FIELD_END(),
@@ -275,11 +291,23 @@ static bool rrdpush_sender_connect_ssl(struct sender_state *s) {
             worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_SSL_ERROR);
             netdata_log_error("SSL: closing the stream connection, because the server SSL certificate is not valid.");
             rrdpush_sender_thread_close_socket(s);
+            netdata_ssl_session_free(host->destination->ssl_session);
+            host->destination->ssl_session = NULL;
             host->destination->reason = STREAM_HANDSHAKE_ERROR_INVALID_CERTIFICATE;
             host->destination->postpone_reconnection_until = now_realtime_sec() + 5 * 60;
             return false;
         }
 
+        if(netdata_ssl_session_reused(&host->sender->ssl))
+            nd_log(NDLS_DAEMON, NDLP_DEBUG,
+                   "STREAM %s [send to %s]: resumed the TLS session of the previous connection",
+                   rrdhost_hostname(host), s->connected_to);
+
+        if(netdata_ssl_kernel_offload_active(&host->sender->ssl))
+            nd_log(NDLS_DAEMON, NDLP_DEBUG,
+                   "STREAM %s [send to %s]: TLS encryption is offloaded to the kernel",
+                   rrdhost_hostname(host), s->connected_to);
+
         return true;
     }
 
@@ -661,6 +689,10 @@ bool attempt_to_connect(struct sender_state *state) {
     // increase the failed connections counter
     state->not_connected_loops++;
 
+    // the senders pool postpones the next attempt itself
+    if(state->pool.worker)
+        return false;
+
     // slow re-connection on repeating errors
     usec_t now_ut = now_monotonic_usec();
     usec_t end_ut = now_ut + USEC_PER_SEC * state->reconnect_delay;
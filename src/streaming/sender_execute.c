@@ -2,10 +2,14 @@
 
 #include "sender_internals.h"
 
+// partial function results wait for the sender buffer to drain below this
+#define STREAM_FUNCTION_PARTIAL_MAX_BUFFER_PERCENTAGE 50
+
 struct inflight_stream_function {
     struct sender_state *sender;
     STRING *transaction;
     usec_t received_ut;
+    usec_t stop_monotonic_ut;
 };
 
 static void stream_execute_function_callback(BUFFER *func_wb, int code, void *data) {
@@ -39,6 +43,48 @@ static void stream_execute_function_callback(BUFFER *func_wb, int code, void *da
     freez(tmp);
 }
 
+static size_t stream_sender_buffer_used_percentage(struct sender_state *s) {
+    size_t percentage = 0;
+
+    sender_lock(s);
+    if(s->buffer && s->buffer->max_size) {
+        size_t available = cbuffer_available_size_unsafe(s->buffer);
+        percentage = (s->buffer->max_size - available) * 100 / s->buffer->max_size;
+    }
+    sender_unlock(s);
+
+    return percentage;
+}
+
+static void stream_execute_function_partial_callback(BUFFER *func_wb, int code, void *data) {
+    struct inflight_stream_function *tmp = data;
+    struct sender_state *s = tmp->sender;
+
+    // flow control - we block the thread delivering the partial results (the plugin's
+    // parser, or the receiver of a child) while the parent is not draining our buffer,
+    // so that the large results are not buffered in the sender
+    while(rrdhost_can_send_definitions_to_parent(s->host) &&
+           stream_sender_buffer_used_percentage(s) > STREAM_FUNCTION_PARTIAL_MAX_BUFFER_PERCENTAGE &&
+           now_monotonic_usec() < tmp->stop_monotonic_ut)
+        sleep_usec(10 * USEC_PER_MS);
+
+    if(rrdhost_can_send_definitions_to_parent(s->host)) {
+        BUFFER *wb = sender_start(s);
+
+        pluginsd_function_result_partial_begin_to_buffer(wb
+                                                         , string2str(tmp->transaction)
+                                                         , code
+                                                         , content_type_id2string(func_wb->content_type)
+                                                         , func_wb->expires);
+
+        buffer_fast_strcat(wb, buffer_tostring(func_wb), buffer_strlen(func_wb));
+        pluginsd_function_result_partial_end_to_buffer(wb, func_wb);
+
+        sender_commit(s, wb, STREAM_TRAFFIC_TYPE_FUNCTIONS);
+        sender_thread_buffer_free();
+    }
+}
+
 static void stream_execute_function_progress_callback(void *data, size_t done, size_t all) {
     struct inflight_stream_function *tmp = data;
     struct sender_state *s = tmp->sender;
@@ -71,6 +117,7 @@ static void execute_commands_function(struct sender_state *s, const char *comman
 
         struct inflight_stream_function *tmp = callocz(1, sizeof(struct inflight_stream_function));
         tmp->received_ut = now_realtime_usec();
+        tmp->stop_monotonic_ut = now_monotonic_usec() + timeout * USEC_PER_SEC;
         tmp->sender = s;
         tmp->transaction = string_strdupz(transaction);
         BUFFER *wb = buffer_create(1024, &netdata_buffers_statistics.buffers_functions);
@@ -78,6 +125,8 @@ static void execute_commands_function(struct sender_state *s, const char *comman
         int code = rrd_function_run(s->host, wb, timeout,
                                     http_access_from_hex_mapping_old_roles(access), function, false, transaction,
                                     stream_execute_function_callback, tmp,
+                                    stream_has_capability(s, STREAM_CAP_PARTIAL) ? stream_execute_function_partial_callback : NULL,
+                                    stream_has_capability(s, STREAM_CAP_PARTIAL) ? tmp : NULL,
                                     stream_has_capability(s, STREAM_CAP_PROGRESS) ? stream_execute_function_progress_callback : NULL,
                                     stream_has_capability(s, STREAM_CAP_PROGRESS) ? tmp : NULL,
                                     NULL, NULL, payload, source, true);
@@ -262,6 +311,20 @@ void rrdpush_sender_execute_commands(struct sender_state *s) {
                 );
             }
         }
+        else if(command && strcmp(command, PLUGINSD_KEYWORD_CHART_RESEND) == 0) {
+            const char *chart_id = get_word(s->line.words, s->line.num_words, 1);
+
+            RRDSET *st = (chart_id && *chart_id) ? rrdset_find(s->host, chart_id) : NULL;
+            if(st) {
+                // the parent does not have the definition, send it in full
+                st->rrdpush.sender.definition_digest = 0;
+                rrdset_metadata_updated(st);
+            }
+            else
+                netdata_log_error("STREAM %s [send to %s] %s command for unknown chart '%s'",
+                                  rrdhost_hostname(s->host), s->connected_to,
+                                  command, chart_id ? chart_id : "(unset)");
+        }
         else if(command && strcmp(command, PLUGINSD_KEYWORD_NODE_ID) == 0) {
             rrdpush_sender_get_node_and_claim_id_from_parent(s);
         }
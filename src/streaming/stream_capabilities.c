@@ -30,6 +30,10 @@ static struct {
     {STREAM_CAP_PROGRESS,     "PROGRESS" },
     {STREAM_CAP_NODE_ID,      "NODEID" },
     {STREAM_CAP_PATHS,        "PATHS" },
+    {STREAM_CAP_COMPACT,      "COMPACT" },
+    {STREAM_CAP_DICTIONARY,   "DICTIONARY" },
+    {STREAM_CAP_PARTIAL,      "PARTIAL" },
+    {STREAM_CAP_DIGEST,       "DIGEST" },
     {0 , NULL },
 };
 
@@ -118,8 +122,12 @@ STREAM_CAPABILITIES stream_our_capabilities(RRDHOST *host, bool sender) {
             STREAM_CAP_BINARY |
             STREAM_CAP_INTERPOLATED |
             STREAM_CAP_SLOTS |
+            STREAM_CAP_COMPACT |
             STREAM_CAP_PROGRESS |
+            STREAM_CAP_PARTIAL |
+            STREAM_CAP_DIGEST |
             STREAM_CAP_COMPRESSIONS_AVAILABLE |
+            STREAM_CAP_ZSTD_DICTIONARY_AVAILABLE |
             STREAM_CAP_DYNCFG |
             STREAM_CAP_NODE_ID |
             STREAM_CAP_PATHS |
@@ -153,6 +161,14 @@ STREAM_CAPABILITIES convert_stream_version_to_capabilities(int32_t version, RRDH
         // DATA WITH ML requires INTERPOLATED
         common_caps &= ~STREAM_CAP_DATA_WITH_ML;
 
+    if(!(common_caps & STREAM_CAP_SLOTS))
+        // COMPACT requires SLOTS
+        common_caps &= ~STREAM_CAP_COMPACT;
+
+    if((common_caps & (STREAM_CAP_SLOTS | STREAM_CAP_REPLICATION)) != (STREAM_CAP_SLOTS | STREAM_CAP_REPLICATION))
+        // DIGEST requires SLOTS and REPLICATION
+        common_caps &= ~STREAM_CAP_DIGEST;
+
     return common_caps;
 }
 
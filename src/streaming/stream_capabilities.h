@@ -48,6 +48,10 @@ typedef enum {
     STREAM_CAP_DYNCFG           = (1 << 23), // support for DYNCFG
     STREAM_CAP_NODE_ID          = (1 << 24), // support for sending NODE_ID back to the child
     STREAM_CAP_PATHS            = (1 << 25), // support for sending PATHS upstream and downstream
+    STREAM_CAP_COMPACT          = (1 << 26), // BEGIN2 and SET2 carry slots, without the ids of charts and dimensions
+    STREAM_CAP_DICTIONARY       = (1 << 27), // ZSTD compression starts with the built-in protocol dictionary
+    STREAM_CAP_PARTIAL          = (1 << 28), // Functions results can be sent in parts (FUNCTION_RESULT_BEGIN ... partial)
+    STREAM_CAP_DIGEST           = (1 << 29), // CHART_REUSE skips chart definitions the parent already has
 
     STREAM_CAP_INVALID          = (1 << 30), // used as an invalid value for capabilities when this is set
     // this must be signed int, so don't use the last bit
@@ -72,6 +76,12 @@ typedef enum {
 #define STREAM_CAP_BROTLI_AVAILABLE 0
 #endif  // ENABLE_BROTLI
 
+#ifdef ENABLE_ZSTD
+#define STREAM_CAP_ZSTD_DICTIONARY_AVAILABLE STREAM_CAP_DICTIONARY
+#else
+#define STREAM_CAP_ZSTD_DICTIONARY_AVAILABLE 0
+#endif  // ENABLE_ZSTD
+
 #define STREAM_CAP_COMPRESSIONS_AVAILABLE (STREAM_CAP_LZ4_AVAILABLE|STREAM_CAP_ZSTD_AVAILABLE|STREAM_CAP_BROTLI_AVAILABLE|STREAM_CAP_GZIP)
 
 #define stream_has_capability(rpt, capability) ((rpt) && ((rpt)->capabilities & (capability)) == (capability))
@@ -135,6 +135,73 @@ void rrdhost_stream_path_to_json(BUFFER *wb, struct rrdhost *host, const char *k
     spinlock_unlock(&host->rrdpush.path.spinlock);
 }
 
+// ----------------------------------------------------------------------------
+// node ownership in clusters of parents
+//
+// All the parents of a cluster have the data of all the nodes, so each parent
+// ends up caching a different random slice of the hot set. To concentrate the
+// queries of each node on one of them, the parents that have the node in their
+// stream path agree on an owner with rendezvous hashing: the owner is the parent
+// with the highest hash of the node and parent machine guids. All parents see
+// the same stream path, so they all agree, without any coordination, and when
+// a parent leaves, only the nodes it owned move to other parents.
+
+static uint64_t stream_path_owner_weight(ND_UUID node, ND_UUID parent) {
+    ND_UUID pair[2] = { node, parent };
+    return XXH3_64bits(pair, sizeof(pair));
+}
+
+bool stream_path_owner(RRDHOST *host, ND_UUID *owner_id, STRING **owner_hostname) {
+    // we have the data of this node, so we are a candidate,
+    // even when the stream path has not reached us yet
+    ND_UUID best_id = localhost->host_id;
+    uint64_t best = stream_path_owner_weight(host->host_id, localhost->host_id);
+
+    spinlock_lock(&host->rrdpush.path.spinlock);
+
+    STRING *best_hostname = NULL;
+    for(size_t i = 0; i < host->rrdpush.path.used ; i++) {
+        STREAM_PATH *p = &host->rrdpush.path.array[i];
+
+        // only the parents of the node are candidates, not the node itself
+        if(p->hops <= 0 || UUIDeq(p->host_id, localhost->host_id))
+            continue;
+
+        uint64_t weight = stream_path_owner_weight(host->host_id, p->host_id);
+        if(weight > best || (weight == best && memcmp(&p->host_id, &best_id, sizeof(best_id)) > 0)) {
+            best = weight;
+            best_id = p->host_id;
+            best_hostname = p->hostname;
+        }
+    }
+
+    if(owner_hostname)
+        *owner_hostname = string_dup(best_hostname ? best_hostname : localhost->hostname);
+
+    spinlock_unlock(&host->rrdpush.path.spinlock);
+
+    if(owner_id)
+        *owner_id = best_id;
+
+    return UUIDeq(best_id, localhost->host_id);
+}
+
+void rrdhost_stream_path_owner_to_json(BUFFER *wb, RRDHOST *host, const char *key) {
+    ND_UUID owner_id;
+    STRING *owner_hostname;
+    bool local = stream_path_owner(host, &owner_id, &owner_hostname);
+
+    buffer_json_member_add_object(wb, key);
+    {
+        buffer_json_member_add_string(wb, "hostname", string2str(owner_hostname));
+        buffer_json_member_add_uuid(wb, "host_id", owner_id.uuid);
+        buffer_json_member_add_boolean(wb, "local", local);
+    }
+    buffer_json_object_close(wb);
+
+    string_freez(owner_hostname);
+}
+
 static BUFFER *stream_path_payload(RRDHOST *host) {
     BUFFER *wb = buffer_create(0, NULL);
     buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_MINIFY);
@@ -50,4 +50,7 @@ void stream_path_parent_disconnected(struct rrdhost *host);
 
 bool stream_path_set_from_json(struct rrdhost *host, const char *json, bool from_parent);
 
+bool stream_path_owner(struct rrdhost *host, ND_UUID *owner_id, STRING **owner_hostname);
+void rrdhost_stream_path_owner_to_json(BUFFER *wb, struct rrdhost *host, const char *key);
+
 #endif //NETDATA_STREAM_PATH_H
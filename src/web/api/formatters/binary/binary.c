@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "binary.h"
+
+// ----------------------------------------------------------------------------
+// binary formatter
+//
+// The response is a header, followed by the columns section (the dimensions)
+// and the arrays of the result, exactly as RRDR keeps them in memory:
+//
+//  time_t           t[rows]                timestamps, older to newer
+//  NETDATA_DOUBLE   v[rows * columns]      values, row by row
+//  NETDATA_DOUBLE   ar[rows * columns]     anomaly rates (0 - 100), row by row
+//  RRDR_VALUE_FLAGS o[rows * columns]      point annotations (1 byte each), row by row
+//  uint32_t         gbc[rows * columns]    group by counts (when flagged in the header)
+//
+// The header is a multiple of RRDR_BINARY_ALIGNMENT bytes and each section is
+// padded to a multiple of it, so that clients can map the arrays in place,
+// without parsing anything.
+
+static inline void rrdr_binary_pad(BUFFER *wb, size_t len) {
+    static const char zeros[RRDR_BINARY_ALIGNMENT] = { 0 };
+
+    size_t pad = (RRDR_BINARY_ALIGNMENT - (len % RRDR_BINARY_ALIGNMENT)) % RRDR_BINARY_ALIGNMENT;
+    if(pad)
+        buffer_memcat(wb, zeros, pad);
+}
+
+static inline void rrdr_binary_add_uint32(BUFFER *wb, uint32_t v) {
+    buffer_memcat(wb, &v, sizeof(v));
+}
+
+static inline void rrdr_binary_add_string(BUFFER *wb, STRING *s) {
+    uint32_t len = (uint32_t)string_strlen(s);
+    rrdr_binary_add_uint32(wb, len);
+    if(len)
+        buffer_memcat(wb, string2str(s), len);
+}
+
+// the buffer may be flushed before each array, when the response is streamed,
+// so each array is padded according to its own size
+static inline void rrdr_binary_add_array(RRDR *r, BUFFER *wb, const void *array, size_t bytes) {
+    rrdr_buffer_flush_check(r, wb);
+
+    if(bytes)
+        buffer_memcat(wb, array, bytes);
+
+    rrdr_binary_pad(wb, bytes);
+}
+
+void rrdr2binary(RRDR *r, BUFFER *wb) {
+    QUERY_TARGET *qt = r->internal.qt;
+    RRDR_OPTIONS options = qt->window.options;
+
+    size_t rows = rrdr_rows(r);
+    size_t columns = r->d;
+
+    struct rrdr_binary_header header = {
+        .magic = { RRDR_BINARY_MAGIC[0], RRDR_BINARY_MAGIC[1], RRDR_BINARY_MAGIC[2], RRDR_BINARY_MAGIC[3] },
+        .byte_order = RRDR_BINARY_BYTE_ORDER,
+        .version = RRDR_BINARY_VERSION,
+        .value_size = sizeof(NETDATA_DOUBLE),
+        .time_size = sizeof(time_t),
+        .columns = (uint32_t)columns,
+        .rows = (uint32_t)rows,
+        .flags = r->gbc ? RRDR_BINARY_HAS_GROUP_BY_COUNT : 0,
+        .after = (int64_t)r->view.after,
+        .before = (int64_t)r->view.before,
+        .update_every = (int64_t)r->view.update_every,
+        .columns_size = 0,
+    };
+
+    // the header is written again below, when the size of the columns is known
+    size_t header_offset = buffer_strlen(wb);
+    buffer_memcat(wb, &header, sizeof(header));
+
+    // the columns: flags, exposed, id, name, units
+    size_t columns_offset = buffer_strlen(wb);
+    for(size_t d = 0; d < columns ;d++) {
+        rrdr_binary_add_uint32(wb, (uint32_t)r->od[d]);
+        rrdr_binary_add_uint32(wb, rrdr_dimension_should_be_exposed(r->od[d], options) ? 1 : 0);
+        rrdr_binary_add_string(wb, r->di[d]);
+        rrdr_binary_add_string(wb, r->dn[d]);
+        rrdr_binary_add_string(wb, r->du ? r->du[d] : NULL);
+    }
+    rrdr_binary_pad(wb, buffer_strlen(wb) - columns_offset);
+
+    header.columns_size = buffer_strlen(wb) - columns_offset;
+    memcpy(&wb->buffer[header_offset], &header, sizeof(header));
+
+    // the arrays, straight from the RRDR buffers
+    size_t points = rows * columns;
+    rrdr_binary_add_array(r, wb, r->t, rows * sizeof(*r->t));
+    rrdr_binary_add_array(r, wb, r->v, points * sizeof(*r->v));
+    rrdr_binary_add_array(r, wb, r->ar, points * sizeof(*r->ar));
+    rrdr_binary_add_array(r, wb, r->o, points * sizeof(*r->o));
+
+    if(r->gbc)
+        rrdr_binary_add_array(r, wb, r->gbc, points * sizeof(*r->gbc));
+}
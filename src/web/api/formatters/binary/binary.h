@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_API_FORMATTER_BINARY_H
+#define NETDATA_API_FORMATTER_BINARY_H
+
+#include "../rrd2json.h"
+
+#define RRDR_BINARY_MAGIC "NDRR"
+#define RRDR_BINARY_VERSION 1
+#define RRDR_BINARY_BYTE_ORDER 0x01020304
+#define RRDR_BINARY_ALIGNMENT 8
+
+typedef enum __attribute__ ((__packed__)) {
+    RRDR_BINARY_HAS_GROUP_BY_COUNT  = (1 << 0), // the group by counts array is included
+} RRDR_BINARY_FLAGS;
+
+// all fields are in the byte order of the agent - check byte_order
+struct rrdr_binary_header {
+    char magic[4];              // RRDR_BINARY_MAGIC
+    uint32_t byte_order;        // RRDR_BINARY_BYTE_ORDER
+    uint16_t version;           // RRDR_BINARY_VERSION
+    uint8_t value_size;         // the size of each value and anomaly rate (sizeof(NETDATA_DOUBLE))
+    uint8_t time_size;          // the size of each timestamp (sizeof(time_t))
+    uint32_t columns;           // the number of dimensions
+    uint32_t rows;              // the number of points per dimension
+    uint32_t flags;             // RRDR_BINARY_FLAGS
+    int64_t after;              // the first timestamp of the result
+    int64_t before;             // the last timestamp of the result
+    int64_t update_every;       // the duration of each point
+    uint64_t columns_size;      // the bytes of the columns section following the header
+};
+
+void rrdr2binary(RRDR *r, BUFFER *wb);
+
+#endif //NETDATA_API_FORMATTER_BINARY_H
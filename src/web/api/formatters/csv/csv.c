@@ -62,6 +62,8 @@ void rrdr2csv(RRDR *r, BUFFER *wb, uint32_t format, RRDR_OPTIONS options, const
 
     // for each line in the array
     for(i = start; i != end ;i += step) {
+        rrdr_buffer_flush_check(r, wb);
+
         NETDATA_DOUBLE *cn = &r->v[ i * r->d ];
         RRDR_VALUE_FLAGS *co = &r->o[ i * r->d ];
 
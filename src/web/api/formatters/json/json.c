@@ -143,13 +143,17 @@ void rrdr2json(RRDR *r, BUFFER *wb, RRDR_OPTIONS options, int datatable) {
 
     // pre-allocate a large enough buffer for us
     // this does not need to be accurate - it is just a hint to avoid multiple realloc().
-    buffer_need_bytes(wb,
-                      ( 20 * rrdr_rows(r)) // timestamp + json overhead
-                    + ( (pre_value_len + post_value_len + 4) * total_number_of_dimensions * rrdr_rows(r) ) // number
-                      );
+    // streamed responses never hold all the rows in the buffer, so they don't need it.
+    if(!r->internal.qt || !r->internal.qt->request.flush_callback)
+        buffer_need_bytes(wb,
+                          ( 20 * rrdr_rows(r)) // timestamp + json overhead
+                        + ( (pre_value_len + post_value_len + 4) * total_number_of_dimensions * rrdr_rows(r) ) // number
+                          );
 
     // for each line in the array
     for(i = start; i != end ;i += step) {
+        rrdr_buffer_flush_check(r, wb);
+
         NETDATA_DOUBLE *cn = &r->v[ i * r->d ];
         RRDR_VALUE_FLAGS *co = &r->o[ i * r->d ];
         NETDATA_DOUBLE *ar = &r->ar[ i * r->d ];
@@ -291,6 +295,8 @@ void rrdr2json_v2(RRDR *r, BUFFER *wb) {
 
         // for each line in the array
         for (i = start; i != end; i += step) {
+            rrdr_buffer_flush_check(r, wb);
+
             NETDATA_DOUBLE *cn = &r->v[ i * r->d ];
             NETDATA_DOUBLE *ch = send_hidden ? &r->vh[i * r->d ] : NULL;
             RRDR_VALUE_FLAGS *co = &r->o[ i * r->d ];
@@ -300,6 +306,9 @@ void rrdr2json_v2(RRDR *r, BUFFER *wb) {
 
             buffer_json_add_array_item_array(wb); // row
 
+            // the time and the points of all dimensions (up to 5 numbers each)
+            buffer_json_array_reserve(wb, used + 1, 64);
+
             if (options & RRDR_OPTION_MILLISECONDS)
                 buffer_json_add_array_item_time_ms(wb, now); // the time
             else
@@ -2,6 +2,7 @@
 
 #include "web/api/web_api_v1.h"
 #include "database/storage_engine.h"
+#include "web/api/queries/query_cache.h"
 
 void rrd_stats_api_v1_chart(RRDSET *st, BUFFER *wb)
 {
@@ -108,11 +109,20 @@ static inline void buffer_json_member_add_key_only(BUFFER *wb, const char *key)
 
 static inline void buffer_json_member_add_string_open(BUFFER *wb, const char *key) {
     buffer_json_member_add_key_only(wb, key);
-    buffer_strcat(wb, wb->json.value_quote);
+    buffer_print_json_quote(wb, wb->json.value_quote, wb->json.value_quote_len);
 }
 
 static inline void buffer_json_member_add_string_close(BUFFER *wb) {
-    buffer_strcat(wb, wb->json.value_quote);
+    buffer_print_json_quote(wb, wb->json.value_quote, wb->json.value_quote_len);
+}
+
+void rrdr_buffer_flush_check(RRDR *r, BUFFER *wb) {
+    QUERY_TARGET *qt = r->internal.qt;
+
+    if(unlikely(qt && qt->request.flush_callback && buffer_strlen(wb) >= qt->request.flush_size)) {
+        if(qt->request.flush_callback(wb, qt->request.flush_callback_data))
+            r->internal.flushes++;
+    }
 }
 
 int data_query_execute(ONEWAYALLOC *owa, BUFFER *wb, QUERY_TARGET *qt, time_t *latest_timestamp) {
@@ -124,6 +134,11 @@ int data_query_execute(ONEWAYALLOC *owa, BUFFER *wb, QUERY_TARGET *qt, time_t *l
         wrapper_end = rrdr_json_wrapper_end2;
     }
 
+    if(query_cache_get(qt, wb, latest_timestamp))
+        return HTTP_RESP_OK;
+
+    size_t wb_offset = buffer_strlen(wb);
+
     RRDR *r = rrd2rrdr(owa, qt);
 
     if(!r) {
@@ -344,8 +359,17 @@ int data_query_execute(ONEWAYALLOC *owa, BUFFER *wb, QUERY_TARGET *qt, time_t *l
         rrdr2json_v2(r, wb);
         wrapper_end(r, wb);
         break;
+
+    case DATASOURCE_BINARY:
+        wb->content_type = CT_APPLICATION_OCTET_STREAM;
+        rrdr2binary(r, wb);
+        break;
     }
 
+    // streamed responses are not in the buffer anymore
+    if(!r->internal.flushes)
+        query_cache_set(qt, wb, wb_offset, rrdr_rows(r) > 0 ? r->view.before : 0);
+
     rrdr_free(owa, r);
     return HTTP_RESP_OK;
 }
@@ -11,6 +11,7 @@
 #include "web/api/formatters/ssv/ssv.h"
 #include "web/api/formatters/json/json.h"
 #include "web/api/formatters/value/value.h"
+#include "web/api/formatters/binary/binary.h"
 
 #include "web/api/formatters/rrdset2json.h"
 #include "web/api/formatters/charts2json.h"
@@ -62,4 +63,7 @@ static inline bool rrdr_dimension_should_be_exposed(RRDR_DIMENSION_FLAGS rrdr_di
     return true;
 }
 
+// called by the formatters between rows, to stream the output generated so far
+void rrdr_buffer_flush_check(RRDR *r, BUFFER *wb);
+
 #endif /* NETDATA_RRD2JSON_H */
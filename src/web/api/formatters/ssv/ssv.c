@@ -16,6 +16,8 @@ void rrdr2ssv(RRDR *r, BUFFER *wb, RRDR_OPTIONS options, const char *prefix, con
 
     // for each line in the array
     for(i = start; i != end ;i += step) {
+        rrdr_buffer_flush_check(r, wb);
+
         int all_values_are_null = 0;
         NETDATA_DOUBLE v = rrdr2value(r, i, options, &all_values_are_null, NULL);
 
@@ -13,15 +13,15 @@ struct bearer_token_request {
     STRING *client_name;
 };
 
-static bool bearer_parse_json_payload(json_object *jobj, const char *path, void *data, BUFFER *error) {
+static bool bearer_parse_json_payload(JSON_STREAM *js, JSON_STREAM_VALUE *root, const char *path, void *data, BUFFER *error) {
     struct bearer_token_request *rq = data;
-    JSONC_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(jobj, path, "claim_id", rq->claim_id, error, true);
-    JSONC_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(jobj, path, "machine_guid", rq->machine_guid, error, true);
-    JSONC_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(jobj, path, "node_id", rq->node_id, error, true);
-    JSONC_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(jobj, path, "user_role", http_user_role2id, rq->user_role, error, true);
-    JSONC_PARSE_ARRAY_OF_TXT2BITMAP_OR_ERROR_AND_RETURN(jobj, path, "access", http_access2id_one, rq->access, error, true);
-    JSONC_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(jobj, path, "cloud_account_id", rq->cloud_account_id, error, true);
-    JSONC_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(jobj, path, "client_name", rq->client_name, error, true);
+    JSONS_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(js, root, path, "claim_id", rq->claim_id, error, true);
+    JSONS_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(js, root, path, "machine_guid", rq->machine_guid, error, true);
+    JSONS_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(js, root, path, "node_id", rq->node_id, error, true);
+    JSONS_PARSE_TXT2ENUM_OR_ERROR_AND_RETURN(js, root, path, "user_role", http_user_role2id, rq->user_role, error, true);
+    JSONS_PARSE_ARRAY_OF_TXT2BITMAP_OR_ERROR_AND_RETURN(js, root, path, "access", http_access2id_one, rq->access, error, true);
+    JSONS_PARSE_TXT2UUID_OR_ERROR_AND_RETURN(js, root, path, "cloud_account_id", rq->cloud_account_id, error, true);
+    JSONS_PARSE_TXT2STRING_OR_ERROR_AND_RETURN(js, root, path, "client_name", rq->client_name, error, true);
     return true;
 }
 
@@ -32,8 +32,7 @@ int function_bearer_get_token(BUFFER *wb, const char *function __maybe_unused, B
 
     int code;
     struct bearer_token_request rq = { 0 };
-    CLEAN_JSON_OBJECT *jobj = json_parse_function_payload_or_error(wb, payload, &code, bearer_parse_json_payload, &rq);
-    if(!jobj || code != HTTP_RESP_OK) {
+    if(!json_stream_parse_function_payload_or_error(wb, payload, &code, bearer_parse_json_payload, &rq) || code != HTTP_RESP_OK) {
         string_freez(rq.client_name);
         return code;
     }
@@ -77,5 +76,6 @@ int call_function_bearer_get_token(RRDHOST *host, struct web_client *w, const ch
                             transaction_str, NULL, NULL,
                             NULL, NULL,
                             NULL, NULL,
+                            NULL, NULL,
                             payload, buffer_tostring(source), true);
 }
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "function-locks.h"
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+
+int function_locks(BUFFER *wb, const char *function __maybe_unused, BUFFER *payload __maybe_unused, const char *source __maybe_unused) {
+    usec_t now_ut = now_realtime_usec();
+
+    buffer_flush(wb);
+    wb->content_type = CT_APPLICATION_JSON;
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_DEFAULT);
+
+    buffer_json_member_add_string(wb, "hostname", rrdhost_hostname(localhost));
+    buffer_json_member_add_uint64(wb, "status", HTTP_RESP_OK);
+    buffer_json_member_add_string(wb, "type", "table");
+    buffer_json_member_add_time_t(wb, "update_every", 1);
+    buffer_json_member_add_boolean(wb, "has_history", false);
+    buffer_json_member_add_string(wb, "help", RRDFUNCTIONS_LOCKS_HELP);
+    buffer_json_member_add_array(wb, "data");
+
+    size_t max_contended = 0, max_spins = 0;
+    usec_t max_wait_ut = 0, max_max_wait_ut = 0;
+    for(LOCK_CONTENTION_SITE *site = lock_contention_sites(); site ; site = site->next) {
+        size_t contended = __atomic_load_n(&site->contended, __ATOMIC_RELAXED);
+        size_t spins = __atomic_load_n(&site->spins, __ATOMIC_RELAXED);
+        usec_t wait_ut = __atomic_load_n(&site->wait_ut, __ATOMIC_RELAXED);
+        usec_t site_max_wait_ut = __atomic_load_n(&site->max_wait_ut, __ATOMIC_RELAXED);
+
+        if(contended > max_contended) max_contended = contended;
+        if(spins > max_spins) max_spins = spins;
+        if(wait_ut > max_wait_ut) max_wait_ut = wait_ut;
+        if(site_max_wait_ut > max_max_wait_ut) max_max_wait_ut = site_max_wait_ut;
+
+        char site_id[FILENAME_MAX + 1];
+        snprintfz(site_id, sizeof(site_id) - 1, "%s:%"PRIu32, site->file, site->line);
+
+        buffer_json_add_array_item_array(wb); // row
+        buffer_json_add_array_item_string(wb, site_id);
+        buffer_json_add_array_item_string(wb, site->type);
+        buffer_json_add_array_item_string(wb, site->function);
+        buffer_json_add_array_item_uint64(wb, contended);
+        buffer_json_add_array_item_uint64(wb, spins);
+        buffer_json_add_array_item_double(wb, (double)wait_ut / USEC_PER_MS);
+        buffer_json_add_array_item_double(wb, contended ? (double)wait_ut / (double)contended : 0.0);
+        buffer_json_add_array_item_double(wb, (double)site_max_wait_ut / USEC_PER_MS);
+        buffer_json_array_close(wb); // row
+    }
+
+    buffer_json_array_close(wb); // data
+    buffer_json_member_add_object(wb, "columns");
+    {
+        size_t field_id = 0;
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Site", "Lock Call Site",
+                                    RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                    0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_NONE,
+                                    RRDF_FIELD_OPTS_VISIBLE | RRDF_FIELD_OPTS_UNIQUE_KEY | RRDF_FIELD_OPTS_STICKY,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Type", "Lock Type",
+                                    RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                    0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                                    RRDF_FIELD_OPTS_VISIBLE, NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Function", "Calling Function",
+                                    RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                    0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                                    RRDF_FIELD_OPTS_VISIBLE, NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Contended", "Times the Lock was Found Locked",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_BAR, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, NULL, (double)max_contended, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE, NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Spins", "Spins While Waiting",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_BAR, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, NULL, (double)max_spins, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_NONE, NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Wait", "Total Time Waiting",
+                                    RRDF_FIELD_TYPE_DURATION, RRDF_FIELD_VISUAL_BAR, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    2, "ms", (double)max_wait_ut / USEC_PER_MS, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE, NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "AvgWait", "Average Time Waiting",
+                                    RRDF_FIELD_TYPE_DURATION, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    2, "us", NAN, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_MAX, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE, NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "MaxWait", "Max Time Waiting",
+                                    RRDF_FIELD_TYPE_DURATION, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    2, "ms", (double)max_max_wait_ut / USEC_PER_MS, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_MAX, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE, NULL);
+    }
+
+    buffer_json_object_close(wb); // columns
+    buffer_json_member_add_string(wb, "default_sort_column", "Wait");
+
+    buffer_json_member_add_time_t(wb, "expires", (time_t)((now_ut / USEC_PER_SEC) + 1));
+    buffer_json_finalize(wb);
+
+    return HTTP_RESP_OK;
+}
+
+#endif // NETDATA_TRACE_LOCKS_CONTENTION
@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_FUNCTION_LOCKS_H
+#define NETDATA_FUNCTION_LOCKS_H
+
+#include "daemon/common.h"
+
+#define RRDFUNCTIONS_LOCKS_HELP "Contention of the spinlocks of Netdata, per call site."
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+int function_locks(BUFFER *wb, const char *function, BUFFER *payload, const char *source);
+#endif
+
+#endif //NETDATA_FUNCTION_LOCKS_H
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "function-profile.h"
+
+#define PROFILE_KEYWORD_DURATION "duration:"
+#define PROFILE_KEYWORD_FREQUENCY "frequency:"
+
+#define PROFILE_DEFAULT_DURATION 10
+
+int function_profile(BUFFER *wb, const char *function, BUFFER *payload __maybe_unused, const char *source) {
+    char buf[1024 + 1];
+    strncpyz(buf, function, sizeof(buf) - 1);
+
+    char *words[PLUGINSD_MAX_WORDS] = { NULL };
+    size_t num_words = quoted_strings_splitter_whitespace(buf, words, PLUGINSD_MAX_WORDS);
+
+    time_t duration = PROFILE_DEFAULT_DURATION;
+    size_t frequency = ND_PROFILER_DEFAULT_FREQUENCY;
+
+    for(int i = 1; i < PLUGINSD_MAX_WORDS ;i++) {
+        const char *keyword = get_word(words, num_words, i);
+        if(!keyword) break;
+
+        if(strncmp(keyword, PROFILE_KEYWORD_DURATION, strlen(PROFILE_KEYWORD_DURATION)) == 0)
+            duration = str2i(&keyword[strlen(PROFILE_KEYWORD_DURATION)]);
+
+        else if(strncmp(keyword, PROFILE_KEYWORD_FREQUENCY, strlen(PROFILE_KEYWORD_FREQUENCY)) == 0)
+            frequency = str2u(&keyword[strlen(PROFILE_KEYWORD_FREQUENCY)]);
+    }
+
+    if(duration < 1 || duration > ND_PROFILER_MAX_DURATION)
+        return rrd_call_function_error(wb, "duration must be between 1 and " TOSTRING(ND_PROFILER_MAX_DURATION) " seconds", HTTP_RESP_BAD_REQUEST);
+
+    if(frequency < 1 || frequency > ND_PROFILER_MAX_FREQUENCY)
+        return rrd_call_function_error(wb, "frequency must be between 1 and " TOSTRING(ND_PROFILER_MAX_FREQUENCY) " Hz", HTTP_RESP_BAD_REQUEST);
+
+    nd_log(NDLS_ACCESS, NDLP_NOTICE, "PROFILER: profiling for %"PRId64" seconds at %zu Hz, requested by: %s",
+           (int64_t)duration, frequency, source ? source : "unknown");
+
+    CLEAN_BUFFER *stacks = buffer_create(0, NULL);
+    size_t samples, dropped;
+    switch(nd_profiler_folded_stacks(stacks, duration, frequency, &samples, &dropped)) {
+        case ND_PROFILER_OK:
+            break;
+
+        case ND_PROFILER_BUSY:
+            return rrd_call_function_error(wb, "another profiling session is running", HTTP_RESP_CONFLICT);
+
+        case ND_PROFILER_NOT_SUPPORTED:
+            return rrd_call_function_error(wb, "profiling is not supported on this system", HTTP_RESP_NOT_IMPLEMENTED);
+
+        default:
+        case ND_PROFILER_FAILED:
+            return rrd_call_function_error(wb, "cannot start the profiling timer", HTTP_RESP_INTERNAL_SERVER_ERROR);
+    }
+
+    buffer_flush(wb);
+    wb->content_type = CT_TEXT_PLAIN;
+    buffer_fast_strcat(wb, buffer_tostring(stacks), buffer_strlen(stacks));
+
+    nd_log(NDLS_DAEMON, NDLP_INFO, "PROFILER: collected %zu samples (%zu dropped)", samples, dropped);
+
+    return HTTP_RESP_OK;
+}
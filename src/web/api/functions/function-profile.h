@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_FUNCTION_PROFILE_H
+#define NETDATA_FUNCTION_PROFILE_H
+
+#include "daemon/common.h"
+
+#define RRDFUNCTIONS_PROFILE_HELP "Sample the CPU stacks of the threads of Netdata, and return them as folded stacks (use duration:SECONDS and frequency:HZ)."
+
+int function_profile(BUFFER *wb, const char *function, BUFFER *payload, const char *source);
+
+#endif //NETDATA_FUNCTION_PROFILE_H
@@ -21,6 +21,7 @@ int function_streaming(BUFFER *wb, const char *function __maybe_unused, BUFFER *
     size_t max_sent_bytes_on_this_connection_per_type[STREAM_TRAFFIC_TYPE_MAX] = { 0 };
     size_t max_db_metrics = 0, max_db_instances = 0, max_db_contexts = 0;
     size_t max_collection_replication_instances = 0, max_streaming_replication_instances = 0;
+    size_t max_collection_throttled = 0, collection_replicating = 0;
     size_t max_ml_anomalous = 0, max_ml_normal = 0, max_ml_trained = 0, max_ml_pending = 0, max_ml_silenced = 0;
     {
         RRDHOST *host;
@@ -41,6 +42,12 @@ int function_streaming(BUFFER *wb, const char *function __maybe_unused, BUFFER *
             if(s.ingest.replication.instances > max_collection_replication_instances)
                 max_collection_replication_instances = s.ingest.replication.instances;
 
+            if(s.ingest.throttled > max_collection_throttled)
+                max_collection_throttled = s.ingest.throttled;
+
+            if(s.ingest.replication.in_progress && s.host != localhost)
+                collection_replicating++;
+
             if(s.stream.replication.instances > max_streaming_replication_instances)
                 max_streaming_replication_instances = s.stream.replication.instances;
 
@@ -89,6 +96,7 @@ int function_streaming(BUFFER *wb, const char *function __maybe_unused, BUFFER *
             buffer_json_add_array_item_uint64(wb, s.ingest.peers.peer.port); // InRemotePort
             buffer_json_add_array_item_string(wb, s.ingest.ssl ? "SSL" : "PLAIN"); // InSSL
             stream_capabilities_to_json_array(wb, s.ingest.capabilities, NULL); // InCapabilities
+            buffer_json_add_array_item_uint64(wb, s.ingest.throttled); // InThrottled
 
             // streaming
             if(s.stream.since) {
@@ -316,6 +324,12 @@ int function_streaming(BUFFER *wb, const char *function __maybe_unused, BUFFER *
                                     RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
                                     RRDF_FIELD_OPTS_NONE, NULL);
 
+        buffer_rrdf_table_add_field(wb, field_id++, "InThrottled", "Inbound Seconds Throttled by the Bytes/sec Limit",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "seconds", (double)max_collection_throttled, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_NONE, NULL);
+
         // --- streaming ---
 
         buffer_rrdf_table_add_field(wb, field_id++, "OutSince", "Last Streaming Status Change",
@@ -620,6 +634,18 @@ int function_streaming(BUFFER *wb, const char *function __maybe_unused, BUFFER *
     }
     buffer_json_object_close(wb); // group_by
 
+    // the admission control of the receivers of this agent
+    buffer_json_member_add_object(wb, "admission");
+    {
+        buffer_json_member_add_uint64(wb, "handshakes", rrdpush_receiver_admission_handshakes());
+        buffer_json_member_add_uint64(wb, "max_handshakes", rrdpush_receiver_max_handshakes);
+        buffer_json_member_add_uint64(wb, "replicating", collection_replicating);
+        buffer_json_member_add_uint64(wb, "max_replicating", rrdpush_receiver_max_replicating);
+        buffer_json_member_add_uint64(wb, "max_bytes_per_sec_per_child", rrdpush_receiver_max_bytes_per_sec);
+        buffer_json_member_add_uint64(wb, "rejected", rrdpush_receiver_admission_rejected());
+    }
+    buffer_json_object_close(wb); // admission
+
     buffer_json_member_add_time_t(wb, "expires", now_realtime_sec() + 1);
     buffer_json_finalize(wb);
 
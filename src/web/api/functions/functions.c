@@ -37,4 +37,28 @@ void global_functions_add(void) {
         RRDFUNCTIONS_TAG_HIDDEN,
         HTTP_ACCESS_SIGNED_ID | HTTP_ACCESS_SAME_SPACE | HTTP_ACCESS_SENSITIVE_DATA,
         function_bearer_get_token);
+
+#ifdef NETDATA_TRACE_LOCKS_CONTENTION
+    rrd_function_add_inline(
+        localhost,
+        NULL,
+        "locks",
+        10,
+        RRDFUNCTIONS_PRIORITY_DEFAULT + 4,
+        RRDFUNCTIONS_LOCKS_HELP,
+        "top",
+        HTTP_ACCESS_SIGNED_ID | HTTP_ACCESS_SAME_SPACE | HTTP_ACCESS_SENSITIVE_DATA,
+        function_locks);
+#endif
+
+    rrd_function_add_inline(
+        localhost,
+        NULL,
+        "cpu-profile",
+        ND_PROFILER_MAX_DURATION + 10,
+        RRDFUNCTIONS_PRIORITY_DEFAULT + 5,
+        RRDFUNCTIONS_PROFILE_HELP,
+        RRDFUNCTIONS_TAG_HIDDEN,
+        HTTP_ACCESS_SIGNED_ID | HTTP_ACCESS_SAME_SPACE | HTTP_ACCESS_SENSITIVE_DATA,
+        function_profile);
 }
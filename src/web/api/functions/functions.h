@@ -8,6 +8,8 @@
 #include "function-streaming.h"
 #include "function-progress.h"
 #include "function-bearer_get_token.h"
+#include "function-locks.h"
+#include "function-profile.h"
 
 void global_functions_add(void);
 
@@ -91,6 +91,10 @@ static void http_header_host(struct web_client *w, const char *v, size_t len) {
 }
 
 static void http_header_accept_encoding(struct web_client *w, const char *v, size_t len __maybe_unused) {
+    // brotli is only used for the precompressed static files
+    if(strcasestr(v, "br"))
+        web_client_flag_set(w, WEB_CLIENT_ENCODING_BROTLI);
+
     if(web_enable_gzip) {
         if(strcasestr(v, "gzip"))
             web_client_enable_deflate(w, true);
@@ -101,6 +105,16 @@ static void http_header_accept_encoding(struct web_client *w, const char *v, siz
     }
 }
 
+static void http_header_if_none_match(struct web_client *w, const char *v, size_t len __maybe_unused) {
+    freez(w->if_none_match);
+    w->if_none_match = strdupz(v);
+}
+
+static void http_header_accept(struct web_client *w, const char *v, size_t len __maybe_unused) {
+    freez(w->accept);
+    w->accept = strdupz(v);
+}
+
 static void http_header_x_forwarded_host(struct web_client *w, const char *v, size_t len) {
     char buffer[NI_MAXHOST];
     strncpyz(buffer, v, (len < sizeof(buffer) - 1 ? len : sizeof(buffer) - 1));
@@ -187,6 +201,8 @@ struct {
     { .hash = 0, .key = "X-Auth-Token",          .cb = http_header_x_auth_token },
     { .hash = 0, .key = "Host",                  .cb = http_header_host },
     { .hash = 0, .key = "Accept-Encoding",       .cb = http_header_accept_encoding },
+    { .hash = 0, .key = "If-None-Match",         .cb = http_header_if_none_match },
+    { .hash = 0, .key = "Accept",                .cb = http_header_accept },
     { .hash = 0, .key = "X-Forwarded-Host",      .cb = http_header_x_forwarded_host },
     { .hash = 0, .key = "X-Forwarded-For",       .cb = http_header_x_forwarded_for },
     { .hash = 0, .key = "X-Transaction-Id",      .cb = http_header_x_transaction_id },
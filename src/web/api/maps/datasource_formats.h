@@ -20,6 +20,7 @@ typedef enum {
     DATASOURCE_CSV_JSON_ARRAY,
     DATASOURCE_CSV_MARKDOWN,
     DATASOURCE_JSON2,
+    DATASOURCE_BINARY,
 } DATASOURCE_FORMAT;
 
 DATASOURCE_FORMAT datasource_format_str_to_id(char *name);
@@ -5,6 +5,7 @@
 
 #include "../query.h"
 #include "../rrdr.h"
+#include "../query_kernels.h"
 
 // ----------------------------------------------------------------------------
 // average
@@ -37,6 +38,12 @@ static inline void tg_average_add(RRDR *r, NETDATA_DOUBLE value) {
     g->count++;
 }
 
+static inline void tg_average_add_batch(RRDR *r, const NETDATA_DOUBLE *values, size_t n) {
+    struct tg_average *g = (struct tg_average *)r->time_grouping.data;
+    g->sum += query_kernel_sum(values, n);
+    g->count += n;
+}
+
 static inline NETDATA_DOUBLE tg_average_flush(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct tg_average *g = (struct tg_average *)r->time_grouping.data;
 
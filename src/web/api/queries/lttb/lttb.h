@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_API_QUERIES_LTTB_H
+#define NETDATA_API_QUERIES_LTTB_H
+
+#include "../query.h"
+#include "../rrdr.h"
+
+// ----------------------------------------------------------------------------
+// largest triangle three buckets
+//
+// Each group point returns one of its values: the one forming the largest
+// triangle with the value returned for the previous group point and the
+// average of the group. Spikes and dips form large triangles, so they are
+// returned, while averages would hide them.
+//
+// The query engine flushes each group point before it gives the values of
+// the next one, so the average of the group itself, placed at the middle of
+// the next group, stands in for the average of the next group that LTTB uses.
+// The positions of the values are their indexes, since the points of a
+// query are equally spaced.
+
+struct tg_lttb {
+    size_t series_size;
+    size_t next_pos;
+    NETDATA_DOUBLE *series;
+
+    NETDATA_DOUBLE base_x;              // the position of the first value of this group
+
+    bool has_previous;
+    NETDATA_DOUBLE previous_x;          // the value returned for the previous group
+    NETDATA_DOUBLE previous_y;
+};
+
+static inline void tg_lttb_create(RRDR *r, const char *options __maybe_unused) {
+    long entries = r->view.group;
+    if(entries < 10) entries = 10;
+
+    struct tg_lttb *g = (struct tg_lttb *)onewayalloc_callocz(r->internal.owa, 1, sizeof(struct tg_lttb));
+    g->series = onewayalloc_mallocz(r->internal.owa, entries * sizeof(NETDATA_DOUBLE));
+    g->series_size = (size_t)entries;
+
+    r->time_grouping.data = g;
+}
+
+// resets when switches dimensions
+// so, clear everything to restart
+static inline void tg_lttb_reset(RRDR *r) {
+    struct tg_lttb *g = (struct tg_lttb *)r->time_grouping.data;
+    g->next_pos = 0;
+    g->base_x = 0.0;
+    g->has_previous = false;
+}
+
+static inline void tg_lttb_free(RRDR *r) {
+    struct tg_lttb *g = (struct tg_lttb *)r->time_grouping.data;
+    if(g) onewayalloc_freez(r->internal.owa, g->series);
+
+    onewayalloc_freez(r->internal.owa, r->time_grouping.data);
+    r->time_grouping.data = NULL;
+}
+
+static inline void tg_lttb_add(RRDR *r, NETDATA_DOUBLE value) {
+    struct tg_lttb *g = (struct tg_lttb *)r->time_grouping.data;
+
+    if(unlikely(g->next_pos >= g->series_size)) {
+        g->series = onewayalloc_doublesize( r->internal.owa, g->series, g->series_size * sizeof(NETDATA_DOUBLE));
+        g->series_size *= 2;
+    }
+
+    g->series[g->next_pos++] = value;
+}
+
+static inline NETDATA_DOUBLE tg_lttb_flush(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
+    struct tg_lttb *g = (struct tg_lttb *)r->time_grouping.data;
+
+    size_t entries = g->next_pos;
+    if(unlikely(!entries)) {
+        *rrdr_value_options_ptr |= RRDR_VALUE_EMPTY;
+        return 0.0;
+    }
+
+    size_t selected = 0;
+
+    if(entries > 1) {
+        NETDATA_DOUBLE sum = 0.0;
+        for(size_t i = 0; i < entries ; i++)
+            sum += g->series[i];
+
+        NETDATA_DOUBLE n = (NETDATA_DOUBLE)entries;
+        NETDATA_DOUBLE c_x = g->base_x + n + n / 2.0;
+        NETDATA_DOUBLE c_y = sum / n;
+
+        // without a previous value, the average of the group is mirrored
+        NETDATA_DOUBLE a_x = g->has_previous ? g->previous_x : g->base_x - n / 2.0;
+        NETDATA_DOUBLE a_y = g->has_previous ? g->previous_y : c_y;
+
+        NETDATA_DOUBLE max_area = -1.0;
+        for(size_t i = 0; i < entries ; i++) {
+            // twice the area of the triangle - only the comparison matters
+            NETDATA_DOUBLE area = fabsndd((a_x - c_x) * (g->series[i] - a_y) - (a_x - (g->base_x + (NETDATA_DOUBLE)i)) * (c_y - a_y));
+            if(area > max_area) {
+                max_area = area;
+                selected = i;
+            }
+        }
+    }
+
+    NETDATA_DOUBLE value = g->series[selected];
+
+    g->has_previous = true;
+    g->previous_x = g->base_x + (NETDATA_DOUBLE)selected;
+    g->previous_y = value;
+    g->base_x += (NETDATA_DOUBLE)entries;
+    g->next_pos = 0;
+
+    return value;
+}
+
+#endif //NETDATA_API_QUERIES_LTTB_H
@@ -5,6 +5,7 @@
 
 #include "../query.h"
 #include "../rrdr.h"
+#include "../query_kernels.h"
 
 struct tg_max {
     NETDATA_DOUBLE max;
@@ -37,6 +38,11 @@ static inline void tg_max_add(RRDR *r, NETDATA_DOUBLE value) {
     }
 }
 
+static inline void tg_max_add_batch(RRDR *r, const NETDATA_DOUBLE *values, size_t n) {
+    if(n)
+        tg_max_add(r, query_kernel_max_abs(values, n));
+}
+
 static inline NETDATA_DOUBLE tg_max_flush(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct tg_max *g = (struct tg_max *)r->time_grouping.data;
 
@@ -5,6 +5,7 @@
 
 #include "../query.h"
 #include "../rrdr.h"
+#include "../query_kernels.h"
 
 struct tg_min {
     NETDATA_DOUBLE min;
@@ -37,6 +38,11 @@ static inline void tg_min_add(RRDR *r, NETDATA_DOUBLE value) {
     }
 }
 
+static inline void tg_min_add_batch(RRDR *r, const NETDATA_DOUBLE *values, size_t n) {
+    if(n)
+        tg_min_add(r, query_kernel_min_abs(values, n));
+}
+
 static inline NETDATA_DOUBLE tg_min_flush(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct tg_min *g = (struct tg_min *)r->time_grouping.data;
 
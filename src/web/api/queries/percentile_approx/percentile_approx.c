@@ -0,0 +1,501 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "percentile_approx.h"
+
+// ----------------------------------------------------------------------------
+// DDSketch stores
+//
+// Each store is a dense array of bins, indexed by the logarithmic key of the
+// values, relative to an offset. The array is moved to follow the keys
+// added, and it is doubled when the keys do not fit, up to DDSKETCH_BINS.
+// When the keys span more than that, the lowest bins are collapsed into one,
+// so only the accuracy of the smallest values is lost.
+//
+// The values of a time-frame rarely span more than a few dozens of keys, so
+// most stores never grow beyond their initial allocation.
+
+static inline void ddsketch_store_reset(DDSKETCH_STORE *st) {
+    if(st->count)
+        memset(&st->bins[st->min_key - st->offset], 0, (size_t)(st->max_key - st->min_key + 1) * sizeof(uint64_t));
+
+    st->count = 0;
+    st->offset = 0;
+    st->min_key = 0;
+    st->max_key = 0;
+}
+
+static inline void ddsketch_store_free(DDSKETCH_STORE *st) {
+    freez(st->bins);
+    memset(st, 0, sizeof(*st));
+}
+
+// the bins keep their place relative to the offset
+static void ddsketch_store_grow(DDSKETCH_STORE *st, int32_t size) {
+    st->bins = reallocz(st->bins, (size_t)size * sizeof(uint64_t));
+    memset(&st->bins[st->size], 0, (size_t)(size - st->size) * sizeof(uint64_t));
+    st->size = size;
+}
+
+// moves the bins of [min_key, max_key] to their place for the new offset
+static void ddsketch_store_move(DDSKETCH_STORE *st, int32_t new_offset) {
+    int32_t from = st->min_key - st->offset;
+    int32_t to = st->min_key - new_offset;
+    int32_t len = st->max_key - st->min_key + 1;
+
+    if(from == to)
+        return;
+
+    memmove(&st->bins[to], &st->bins[from], (size_t)len * sizeof(uint64_t));
+
+    // clear the bins left behind
+    if(to > from)
+        memset(&st->bins[from], 0, (size_t)MIN(len, to - from) * sizeof(uint64_t));
+    else {
+        int32_t start = MAX(to + len, from);
+        memset(&st->bins[start], 0, (size_t)(from + len - start) * sizeof(uint64_t));
+    }
+
+    st->offset = new_offset;
+}
+
+static void ddsketch_store_extend(DDSKETCH_STORE *st, int32_t key) {
+    int32_t lo = MIN(key, st->min_key);
+    int32_t hi = MAX(key, st->max_key);
+
+    if(hi - lo >= st->size && st->size < DDSKETCH_BINS) {
+        int32_t size = st->size;
+        while(size <= hi - lo && size < DDSKETCH_BINS)
+            size *= 2;
+
+        ddsketch_store_grow(st, size);
+    }
+
+    if(hi - lo < st->size) {
+        // everything fits, center the keys in the array
+        ddsketch_store_move(st, lo - (st->size - 1 - (hi - lo)) / 2);
+        return;
+    }
+
+    // collapse the lowest keys into the lowest bin we can keep
+    int32_t new_offset = hi - st->size + 1;
+
+    if(new_offset > st->min_key) {
+        uint64_t collapsed = 0;
+        int32_t end = MIN(st->max_key, new_offset - 1);
+        for(int32_t k = st->min_key; k <= end ; k++) {
+            collapsed += st->bins[k - st->offset];
+            st->bins[k - st->offset] = 0;
+        }
+
+        if(st->max_key < new_offset) {
+            // all the bins were collapsed, so the array is empty
+            st->offset = new_offset;
+            st->min_key = st->max_key = new_offset;
+            st->bins[0] = collapsed;
+            return;
+        }
+
+        st->bins[new_offset - st->offset] += collapsed;
+        st->min_key = new_offset;
+    }
+
+    // when the new key is the lowest, it is the one collapsed
+    ddsketch_store_move(st, new_offset);
+}
+
+static void ddsketch_store_add(DDSKETCH_STORE *st, int32_t key, uint64_t n) {
+    if(unlikely(!st->count)) {
+        if(unlikely(!st->bins))
+            ddsketch_store_grow(st, DDSKETCH_INITIAL_BINS);
+
+        st->offset = key - st->size / 2;
+        st->min_key = st->max_key = key;
+    }
+    else if(unlikely(key < st->offset || key >= st->offset + st->size))
+        ddsketch_store_extend(st, key);
+
+    // keys below the array have been collapsed into its first bin
+    if(unlikely(key < st->offset))
+        key = st->offset;
+
+    st->bins[key - st->offset] += n;
+    st->count += n;
+
+    if(key < st->min_key) st->min_key = key;
+    if(key > st->max_key) st->max_key = key;
+}
+
+static void ddsketch_store_merge(DDSKETCH_STORE *dst, const DDSKETCH_STORE *src) {
+    if(!src->count)
+        return;
+
+    // add the edges first, so that dst is extended once to the range of src
+    ddsketch_store_add(dst, src->max_key, src->bins[src->max_key - src->offset]);
+    if(src->min_key == src->max_key)
+        return;
+
+    ddsketch_store_add(dst, src->min_key, src->bins[src->min_key - src->offset]);
+
+    for(int32_t k = src->min_key + 1; k < src->max_key ; k++) {
+        uint64_t n = src->bins[k - src->offset];
+        if(n)
+            ddsketch_store_add(dst, k, n);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// DDSketch
+
+void ddsketch_init(DDSKETCH *s) {
+    s->gamma = (1.0 + DDSKETCH_RELATIVE_ACCURACY) / (1.0 - DDSKETCH_RELATIVE_ACCURACY);
+    s->multiplier = 1.0 / log(s->gamma);
+    s->min_indexable = DBL_MIN * s->gamma;
+
+    memset(&s->positive, 0, sizeof(s->positive));
+    memset(&s->negative, 0, sizeof(s->negative));
+    ddsketch_reset(s);
+}
+
+void ddsketch_free(DDSKETCH *s) {
+    ddsketch_store_free(&s->positive);
+    ddsketch_store_free(&s->negative);
+    ddsketch_reset(s);
+}
+
+void ddsketch_reset(DDSKETCH *s) {
+    ddsketch_store_reset(&s->positive);
+    ddsketch_store_reset(&s->negative);
+    s->zero_count = 0;
+    s->min = NAN;
+    s->max = NAN;
+}
+
+uint64_t ddsketch_count(const DDSKETCH *s) {
+    return s->positive.count + s->negative.count + s->zero_count;
+}
+
+static inline int32_t ddsketch_key(const DDSKETCH *s, NETDATA_DOUBLE abs_value) {
+    return (int32_t)ceil(log(abs_value) * s->multiplier);
+}
+
+// the value representing all the values of a bin, within the relative accuracy of each
+static inline NETDATA_DOUBLE ddsketch_key_value(const DDSKETCH *s, int32_t key) {
+    return 2.0 * exp((NETDATA_DOUBLE)key / s->multiplier) / (s->gamma + 1.0);
+}
+
+static inline void ddsketch_min_max(DDSKETCH *s, NETDATA_DOUBLE min, NETDATA_DOUBLE max) {
+    if(isnan(s->min) || min < s->min) s->min = min;
+    if(isnan(s->max) || max > s->max) s->max = max;
+}
+
+void ddsketch_add(DDSKETCH *s, NETDATA_DOUBLE value) {
+    if(value > s->min_indexable)
+        ddsketch_store_add(&s->positive, ddsketch_key(s, value), 1);
+    else if(value < -s->min_indexable)
+        ddsketch_store_add(&s->negative, ddsketch_key(s, -value), 1);
+    else
+        s->zero_count++;
+
+    ddsketch_min_max(s, value, value);
+}
+
+void ddsketch_merge(DDSKETCH *dst, const DDSKETCH *src) {
+    if(!ddsketch_count(src))
+        return;
+
+    ddsketch_store_merge(&dst->positive, &src->positive);
+    ddsketch_store_merge(&dst->negative, &src->negative);
+    dst->zero_count += src->zero_count;
+    ddsketch_min_max(dst, src->min, src->max);
+}
+
+// ----------------------------------------------------------------------------
+// walking the bins in value order
+
+typedef bool (*ddsketch_walk_cb_t)(NETDATA_DOUBLE value, uint64_t n, void *data);
+
+static inline NETDATA_DOUBLE ddsketch_clamp(const DDSKETCH *s, NETDATA_DOUBLE value) {
+    if(value < s->min) return s->min;
+    if(value > s->max) return s->max;
+    return value;
+}
+
+static bool ddsketch_walk_store(const DDSKETCH *s, const DDSKETCH_STORE *st, bool negative, bool up, ddsketch_walk_cb_t cb, void *data) {
+    if(!st->count)
+        return true;
+
+    // the keys of negative values grow as the values get smaller
+    bool keys_up = (negative) ? !up : up;
+    int32_t first = keys_up ? st->min_key : st->max_key;
+    int32_t last = keys_up ? st->max_key : st->min_key;
+    int32_t step = keys_up ? 1 : -1;
+
+    for(int32_t k = first; ; k += step) {
+        uint64_t n = st->bins[k - st->offset];
+        if(n) {
+            NETDATA_DOUBLE value = ddsketch_key_value(s, k);
+            if(negative) value = -value;
+
+            if(!cb(ddsketch_clamp(s, value), n, data))
+                return false;
+        }
+
+        if(k == last)
+            break;
+    }
+
+    return true;
+}
+
+// calls cb for every bin, from the smallest value to the biggest (up) or the opposite
+static void ddsketch_walk(const DDSKETCH *s, bool up, ddsketch_walk_cb_t cb, void *data) {
+    const DDSKETCH_STORE *first = up ? &s->negative : &s->positive;
+    const DDSKETCH_STORE *last = up ? &s->positive : &s->negative;
+
+    if(!ddsketch_walk_store(s, first, up, up, cb, data))
+        return;
+
+    if(s->zero_count && !cb(0.0, s->zero_count, data))
+        return;
+
+    ddsketch_walk_store(s, last, !up, up, cb, data);
+}
+
+// ----------------------------------------------------------------------------
+// queries
+
+struct ddsketch_rank {
+    NETDATA_DOUBLE rank;
+    uint64_t seen;
+    NETDATA_DOUBLE value;
+};
+
+static bool ddsketch_quantile_cb(NETDATA_DOUBLE value, uint64_t n, void *data) {
+    struct ddsketch_rank *q = data;
+    q->seen += n;
+    q->value = value;
+    return (NETDATA_DOUBLE)q->seen <= q->rank;
+}
+
+NETDATA_DOUBLE ddsketch_quantile(const DDSKETCH *s, NETDATA_DOUBLE q) {
+    uint64_t count = ddsketch_count(s);
+    if(!count)
+        return NAN;
+
+    if(q <= 0.0) return s->min;
+    if(q >= 1.0) return s->max;
+
+    struct ddsketch_rank t = {
+        .rank = q * (NETDATA_DOUBLE)(count - 1),
+        .seen = 0,
+        .value = NAN,
+    };
+    ddsketch_walk(s, true, ddsketch_quantile_cb, &t);
+    return t.value;
+}
+
+struct ddsketch_average {
+    NETDATA_DOUBLE remaining;
+    NETDATA_DOUBLE sum;
+};
+
+static bool ddsketch_average_cb(NETDATA_DOUBLE value, uint64_t n, void *data) {
+    struct ddsketch_average *a = data;
+
+    NETDATA_DOUBLE use = (NETDATA_DOUBLE)n;
+    if(use > a->remaining)
+        use = a->remaining;
+
+    a->sum += value * use;
+    a->remaining -= use;
+    return a->remaining > 0.0;
+}
+
+NETDATA_DOUBLE ddsketch_percentile_average(const DDSKETCH *s, NETDATA_DOUBLE q) {
+    uint64_t count = ddsketch_count(s);
+    if(!count)
+        return NAN;
+
+    if(s->min == s->max)
+        return s->min;
+
+    // like the percentile grouping: we use at least one value, and we
+    // start from the biggest values when the series has negative values
+    NETDATA_DOUBLE values = (NETDATA_DOUBLE)count * q;
+    if(values < 1.0)
+        values = 1.0;
+
+    struct ddsketch_average a = {
+        .remaining = values,
+        .sum = 0.0,
+    };
+    ddsketch_walk(s, s->min >= 0.0, ddsketch_average_cb, &a);
+    return a.sum / values;
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+static uint64_t ddsketch_unittest_seed = 1;
+
+// deterministic, so that failures can be reproduced
+static NETDATA_DOUBLE ddsketch_unittest_random(void) {
+    ddsketch_unittest_seed = ddsketch_unittest_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (NETDATA_DOUBLE)(ddsketch_unittest_seed >> 11) / 9007199254740992.0;
+}
+
+static int ddsketch_unittest_compar(const void *a, const void *b) {
+    NETDATA_DOUBLE x = *(const NETDATA_DOUBLE *)a, y = *(const NETDATA_DOUBLE *)b;
+    return (x > y) - (x < y);
+}
+
+// the value of the sorted series that ddsketch_quantile() approximates
+static NETDATA_DOUBLE ddsketch_unittest_exact_quantile(const NETDATA_DOUBLE *sorted, size_t n, NETDATA_DOUBLE q) {
+    return sorted[(size_t)floor(q * (NETDATA_DOUBLE)(n - 1))];
+}
+
+// the average of the smaller n * q values of a positive sorted series
+static NETDATA_DOUBLE ddsketch_unittest_exact_average(const NETDATA_DOUBLE *sorted, size_t n, NETDATA_DOUBLE q) {
+    NETDATA_DOUBLE values = (NETDATA_DOUBLE)n * q, remaining = values, sum = 0.0;
+    for(size_t i = 0; i < n && remaining > 0.0 ; i++) {
+        NETDATA_DOUBLE use = MIN(1.0, remaining);
+        sum += sorted[i] * use;
+        remaining -= use;
+    }
+    return sum / values;
+}
+
+static int ddsketch_unittest_check(const char *name, NETDATA_DOUBLE q, NETDATA_DOUBLE got, NETDATA_DOUBLE expected) {
+    NETDATA_DOUBLE error = (expected == 0.0) ? fabs(got) : fabs(got - expected) / fabs(expected);
+    bool ok = error <= DDSKETCH_RELATIVE_ACCURACY + 1e-9;
+
+    if(!ok)
+        fprintf(stderr, "DDSKETCH: %s q=%0.2f: expected " NETDATA_DOUBLE_FORMAT ", got " NETDATA_DOUBLE_FORMAT " (error %0.4f%%)\n",
+                name, q, expected, got, error * 100.0);
+
+    return ok ? 0 : 1;
+}
+
+static const NETDATA_DOUBLE ddsketch_unittest_quantiles[] = { 0.0, 0.01, 0.10, 0.25, 0.50, 0.75, 0.90, 0.95, 0.99, 1.0 };
+
+static int ddsketch_unittest_quantiles_check(const char *name, const DDSKETCH *s, NETDATA_DOUBLE *values, size_t n) {
+    int errors = 0;
+
+    if(ddsketch_count(s) != n) {
+        fprintf(stderr, "DDSKETCH: %s: expected %zu values, the sketch has %"PRIu64"\n", name, n, ddsketch_count(s));
+        errors++;
+    }
+
+    qsort(values, n, sizeof(NETDATA_DOUBLE), ddsketch_unittest_compar);
+
+    for(size_t i = 0; i < sizeof(ddsketch_unittest_quantiles) / sizeof(ddsketch_unittest_quantiles[0]) ; i++) {
+        NETDATA_DOUBLE q = ddsketch_unittest_quantiles[i];
+        errors += ddsketch_unittest_check(name, q, ddsketch_quantile(s, q), ddsketch_unittest_exact_quantile(values, n, q));
+    }
+
+    return errors;
+}
+
+#define DDSKETCH_UNITTEST_VALUES 100000
+#define DDSKETCH_UNITTEST_SKETCHES 4
+
+int ddsketch_unittest(void) {
+    int errors = 0;
+    NETDATA_DOUBLE *values = mallocz(DDSKETCH_UNITTEST_VALUES * sizeof(NETDATA_DOUBLE));
+    DDSKETCH s, parts[DDSKETCH_UNITTEST_SKETCHES];
+    ddsketch_init(&s);
+    for(size_t p = 0; p < DDSKETCH_UNITTEST_SKETCHES ; p++)
+        ddsketch_init(&parts[p]);
+
+    // a single positive series, spanning 6 orders of magnitude
+    for(size_t i = 0; i < DDSKETCH_UNITTEST_VALUES ; i++) {
+        values[i] = exp(ddsketch_unittest_random() * 14.0);
+        ddsketch_add(&s, values[i]);
+    }
+    errors += ddsketch_unittest_quantiles_check("positive", &s, values, DDSKETCH_UNITTEST_VALUES);
+
+    NETDATA_DOUBLE percents[] = { 0.5, 0.95, 0.99 };
+    for(size_t i = 0; i < sizeof(percents) / sizeof(percents[0]) ; i++)
+        errors += ddsketch_unittest_check("positive average", percents[i],
+                                          ddsketch_percentile_average(&s, percents[i]),
+                                          ddsketch_unittest_exact_average(values, DDSKETCH_UNITTEST_VALUES, percents[i]));
+
+    // a narrow series should not need more than the initial bins
+    ddsketch_free(&s);
+    for(size_t i = 0; i < DDSKETCH_UNITTEST_VALUES ; i++) {
+        values[i] = 100.0 + ddsketch_unittest_random() * 20.0;
+        ddsketch_add(&s, values[i]);
+    }
+    errors += ddsketch_unittest_quantiles_check("narrow", &s, values, DDSKETCH_UNITTEST_VALUES);
+    if(s.positive.size != DDSKETCH_INITIAL_BINS || s.negative.size != 0) {
+        fprintf(stderr, "DDSKETCH: narrow: expected %d positive and 0 negative bins, got %d and %d\n",
+                DDSKETCH_INITIAL_BINS, (int)s.positive.size, (int)s.negative.size);
+        errors++;
+    }
+
+    // negative, zero and positive values
+    ddsketch_reset(&s);
+    for(size_t i = 0; i < DDSKETCH_UNITTEST_VALUES ; i++) {
+        values[i] = (i % 10 == 0) ? 0.0 : (ddsketch_unittest_random() - 0.5) * 2000.0;
+        ddsketch_add(&s, values[i]);
+    }
+    errors += ddsketch_unittest_quantiles_check("mixed", &s, values, DDSKETCH_UNITTEST_VALUES);
+
+    // sketches of different distributions merged, against the union of their values
+    ddsketch_reset(&s);
+    for(size_t i = 0; i < DDSKETCH_UNITTEST_VALUES ; i++) {
+        size_t p = i % DDSKETCH_UNITTEST_SKETCHES;
+        values[i] = (NETDATA_DOUBLE)(p + 1) * 1000.0 * ddsketch_unittest_random() * (p == 3 ? -1.0 : 1.0);
+        ddsketch_add(&parts[p], values[i]);
+        ddsketch_add(&s, values[i]);
+    }
+
+    DDSKETCH merged;
+    ddsketch_init(&merged);
+    for(size_t p = 0; p < DDSKETCH_UNITTEST_SKETCHES ; p++)
+        ddsketch_merge(&merged, &parts[p]);
+
+    errors += ddsketch_unittest_quantiles_check("merged", &merged, values, DDSKETCH_UNITTEST_VALUES);
+
+    // merging is exact, so the merged sketch is the sketch of all the values
+    for(size_t i = 0; i < sizeof(ddsketch_unittest_quantiles) / sizeof(ddsketch_unittest_quantiles[0]) ; i++) {
+        NETDATA_DOUBLE q = ddsketch_unittest_quantiles[i];
+        if(ddsketch_quantile(&merged, q) != ddsketch_quantile(&s, q)) {
+            fprintf(stderr, "DDSKETCH: merged q=%0.2f differs from the sketch of all the values\n", q);
+            errors++;
+        }
+    }
+
+    // swapping gives the sketch away, and the other one can be reused
+    ddsketch_swap(&merged, &parts[0]);
+    ddsketch_reset(&parts[0]);
+    if(ddsketch_count(&merged) != DDSKETCH_UNITTEST_VALUES / DDSKETCH_UNITTEST_SKETCHES || ddsketch_count(&parts[0])) {
+        fprintf(stderr, "DDSKETCH: swap gave wrong counts\n");
+        errors++;
+    }
+
+    // keys spanning more than the bins collapse the smallest values only
+    ddsketch_reset(&s);
+    for(size_t i = 0; i < DDSKETCH_UNITTEST_VALUES ; i++) {
+        values[i] = pow(10.0, ddsketch_unittest_random() * 200.0 - 100.0);
+        ddsketch_add(&s, values[i]);
+    }
+    if(s.positive.size != DDSKETCH_BINS) {
+        fprintf(stderr, "DDSKETCH: wide: expected %d bins, got %d\n", DDSKETCH_BINS, (int)s.positive.size);
+        errors++;
+    }
+    qsort(values, DDSKETCH_UNITTEST_VALUES, sizeof(NETDATA_DOUBLE), ddsketch_unittest_compar);
+    errors += ddsketch_unittest_check("wide", 0.99, ddsketch_quantile(&s, 0.99),
+                                      ddsketch_unittest_exact_quantile(values, DDSKETCH_UNITTEST_VALUES, 0.99));
+    errors += ddsketch_unittest_check("wide", 1.0, ddsketch_quantile(&s, 1.0),
+                                      ddsketch_unittest_exact_quantile(values, DDSKETCH_UNITTEST_VALUES, 1.0));
+
+    ddsketch_free(&s);
+    ddsketch_free(&merged);
+    for(size_t p = 0; p < DDSKETCH_UNITTEST_SKETCHES ; p++)
+        ddsketch_free(&parts[p]);
+    freez(values);
+
+    fprintf(stderr, "DDSKETCH: %d errors\n", errors);
+    return errors;
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_API_QUERIES_PERCENTILE_APPROX_H
+#define NETDATA_API_QUERIES_PERCENTILE_APPROX_H
+
+#include "../query.h"
+#include "../rrdr.h"
+
+// ----------------------------------------------------------------------------
+// DDSketch - a mergeable quantile sketch with relative error guarantees
+//
+// Values are counted in logarithmic buckets, so that every value returned
+// is within DDSKETCH_RELATIVE_ACCURACY of a value of the series. Sketches
+// built with the same accuracy can be merged, so the sketches of many
+// dimensions can be combined without going back to the data.
+
+#define DDSKETCH_RELATIVE_ACCURACY 0.01
+#define DDSKETCH_INITIAL_BINS 32
+#define DDSKETCH_BINS 2048              // the maximum number of bins per sign
+
+typedef struct ddsketch_store {
+    uint64_t count;
+    int32_t offset;                     // the key of bins[0]
+    int32_t min_key;                    // the range of keys that may have counts
+    int32_t max_key;
+    int32_t size;                       // the bins allocated, doubled up to DDSKETCH_BINS
+    uint64_t *bins;
+} DDSKETCH_STORE;
+
+typedef struct ddsketch {
+    NETDATA_DOUBLE gamma;
+    NETDATA_DOUBLE multiplier;          // 1 / ln(gamma)
+    NETDATA_DOUBLE min_indexable;       // smaller absolute values are counted as zeros
+
+    uint64_t zero_count;
+    NETDATA_DOUBLE min;
+    NETDATA_DOUBLE max;
+
+    DDSKETCH_STORE positive;
+    DDSKETCH_STORE negative;            // keeps the absolute values of negative values
+} DDSKETCH;
+
+void ddsketch_init(DDSKETCH *s);
+void ddsketch_free(DDSKETCH *s);
+void ddsketch_reset(DDSKETCH *s);
+void ddsketch_add(DDSKETCH *s, NETDATA_DOUBLE value);
+void ddsketch_merge(DDSKETCH *dst, const DDSKETCH *src);
+uint64_t ddsketch_count(const DDSKETCH *s);
+
+// exchanges the contents of two sketches, without copying their bins
+static inline void ddsketch_swap(DDSKETCH *a, DDSKETCH *b) {
+    DDSKETCH t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// the value at quantile q (0.0 to 1.0)
+NETDATA_DOUBLE ddsketch_quantile(const DDSKETCH *s, NETDATA_DOUBLE q);
+
+// the average of the values up to quantile q, like the percentile grouping does
+NETDATA_DOUBLE ddsketch_percentile_average(const DDSKETCH *s, NETDATA_DOUBLE q);
+
+int ddsketch_unittest(void);
+
+// ----------------------------------------------------------------------------
+// percentile-approx and median-approx time groupings
+
+struct tg_percentile_approx {
+    NETDATA_DOUBLE percent;
+    DDSKETCH *keep;                     // when set, the next flush gives its sketch to it
+    DDSKETCH sketch;
+};
+
+static inline bool tg_is_percentile_approx(RRDR_TIME_GROUPING group) {
+    return group == RRDR_GROUPING_PERCENTILE_APPROX || group == RRDR_GROUPING_MEDIAN_APPROX;
+}
+
+// the quantile (0.0 to 1.0) requested by the options of the time grouping
+static inline NETDATA_DOUBLE tg_percentile_approx_percent(RRDR_TIME_GROUPING group, const char *options) {
+    NETDATA_DOUBLE percent = 95.0;
+
+    if(group == RRDR_GROUPING_MEDIAN_APPROX)
+        percent = 50.0;
+
+    else if(options && *options) {
+        percent = str2ndd(options, NULL);
+        if(!netdata_double_isnumber(percent)) percent = 0.0;
+        if(percent < 0.0) percent = 0.0;
+        if(percent > 100.0) percent = 100.0;
+    }
+
+    return percent / 100.0;
+}
+
+// the value of a time grouping, calculated from a sketch of its values
+static inline NETDATA_DOUBLE tg_percentile_approx_sketch_value(RRDR_TIME_GROUPING group, NETDATA_DOUBLE percent, const DDSKETCH *s) {
+    if(group == RRDR_GROUPING_MEDIAN_APPROX)
+        return ddsketch_quantile(s, percent);
+
+    return ddsketch_percentile_average(s, percent);
+}
+
+static inline void tg_percentile_approx_create_internal(RRDR *r, const char *options, RRDR_TIME_GROUPING group) {
+    struct tg_percentile_approx *g = (struct tg_percentile_approx *)onewayalloc_callocz(r->internal.owa, 1, sizeof(struct tg_percentile_approx));
+    ddsketch_init(&g->sketch);
+    g->percent = tg_percentile_approx_percent(group, options);
+    r->time_grouping.data = g;
+}
+
+static inline void tg_percentile_approx_create(RRDR *r, const char *options) {
+    tg_percentile_approx_create_internal(r, options, RRDR_GROUPING_PERCENTILE_APPROX);
+}
+
+static inline void tg_median_approx_create(RRDR *r, const char *options __maybe_unused) {
+    tg_percentile_approx_create_internal(r, NULL, RRDR_GROUPING_MEDIAN_APPROX);
+}
+
+// resets when switches dimensions
+// so, clear everything to restart
+static inline void tg_percentile_approx_reset(RRDR *r) {
+    struct tg_percentile_approx *g = (struct tg_percentile_approx *)r->time_grouping.data;
+    ddsketch_reset(&g->sketch);
+}
+
+static inline void tg_percentile_approx_free(RRDR *r) {
+    struct tg_percentile_approx *g = (struct tg_percentile_approx *)r->time_grouping.data;
+    ddsketch_free(&g->sketch);
+    onewayalloc_freez(r->internal.owa, r->time_grouping.data);
+    r->time_grouping.data = NULL;
+}
+
+static inline void tg_percentile_approx_add(RRDR *r, NETDATA_DOUBLE value) {
+    struct tg_percentile_approx *g = (struct tg_percentile_approx *)r->time_grouping.data;
+    ddsketch_add(&g->sketch, value);
+}
+
+// the sketch of the next point is given to keep (and the old sketch of keep
+// is reused by the grouping), so that group-by can merge the sketches of
+// many metrics to find the percentiles of all their values together
+static inline void tg_percentile_approx_keep(RRDR *r, DDSKETCH *keep) {
+    struct tg_percentile_approx *g = (struct tg_percentile_approx *)r->time_grouping.data;
+    g->keep = keep;
+}
+
+static inline NETDATA_DOUBLE tg_percentile_approx_flush_internal(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr, bool quantile) {
+    struct tg_percentile_approx *g = (struct tg_percentile_approx *)r->time_grouping.data;
+
+    NETDATA_DOUBLE value;
+
+    if(unlikely(!ddsketch_count(&g->sketch))) {
+        value = 0.0;
+        *rrdr_value_options_ptr |= RRDR_VALUE_EMPTY;
+    }
+    else {
+        if(quantile)
+            value = ddsketch_quantile(&g->sketch, g->percent);
+        else
+            value = ddsketch_percentile_average(&g->sketch, g->percent);
+
+        if(unlikely(!netdata_double_isnumber(value))) {
+            value = 0.0;
+            *rrdr_value_options_ptr |= RRDR_VALUE_EMPTY;
+        }
+    }
+
+    if(g->keep) {
+        ddsketch_swap(g->keep, &g->sketch);
+        g->keep = NULL;
+    }
+
+    ddsketch_reset(&g->sketch);
+
+    return value;
+}
+
+static inline NETDATA_DOUBLE tg_percentile_approx_flush(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
+    return tg_percentile_approx_flush_internal(r, rrdr_value_options_ptr, false);
+}
+
+static inline NETDATA_DOUBLE tg_median_approx_flush(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
+    return tg_percentile_approx_flush_internal(r, rrdr_value_options_ptr, true);
+}
+
+#endif //NETDATA_API_QUERIES_PERCENTILE_APPROX_H
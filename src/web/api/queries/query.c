@@ -15,10 +15,25 @@
 #include "ses/ses.h"
 #include "des/des.h"
 #include "percentile/percentile.h"
+#include "percentile_approx/percentile_approx.h"
+#include "lttb/lttb.h"
 #include "trimmed_mean/trimmed_mean.h"
+#include "query_threads.h"
 
 #define QUERY_PLAN_MIN_POINTS 10
 #define POINTS_TO_EXPAND_QUERY 5
+#define QUERY_BATCH_POINTS 32
+
+// the values collected before they are given to the batched time grouping kernels
+#define QUERY_GROUP_BATCH_VALUES 64
+
+// queries with at least this many metrics are executed in parallel
+#define QUERY_PARALLEL_MIN_METRICS 50
+
+// the number of metrics a thread takes at once, when executing in parallel
+#define QUERY_PARALLEL_METRICS_PER_STEP 8
+
+time_t query_prefetch_timeout_ms = 5000;
 
 // ----------------------------------------------------------------------------
 
@@ -466,6 +481,42 @@ static struct {
                 .flush = tg_percentile_flush,
                 .tier_query_fetch = TIER_QUERY_FETCH_AVERAGE
         },
+        {.name = "percentile-approx",
+                .hash  = 0,
+                .value = RRDR_GROUPING_PERCENTILE_APPROX,
+                .add_flush = RRDR_GROUPING_PERCENTILE_APPROX,
+                .init  = NULL,
+                .create= tg_percentile_approx_create,
+                .reset = tg_percentile_approx_reset,
+                .free  = tg_percentile_approx_free,
+                .add   = tg_percentile_approx_add,
+                .flush = tg_percentile_approx_flush,
+                .tier_query_fetch = TIER_QUERY_FETCH_AVERAGE
+        },
+        {.name = "median-approx",
+                .hash  = 0,
+                .value = RRDR_GROUPING_MEDIAN_APPROX,
+                .add_flush = RRDR_GROUPING_MEDIAN_APPROX,
+                .init  = NULL,
+                .create= tg_median_approx_create,
+                .reset = tg_percentile_approx_reset,
+                .free  = tg_percentile_approx_free,
+                .add   = tg_percentile_approx_add,
+                .flush = tg_median_approx_flush,
+                .tier_query_fetch = TIER_QUERY_FETCH_AVERAGE
+        },
+        {.name = "lttb",
+                .hash  = 0,
+                .value = RRDR_GROUPING_LTTB,
+                .add_flush = RRDR_GROUPING_LTTB,
+                .init  = NULL,
+                .create= tg_lttb_create,
+                .reset = tg_lttb_reset,
+                .free  = tg_lttb_free,
+                .add   = tg_lttb_add,
+                .flush = tg_lttb_flush,
+                .tier_query_fetch = TIER_QUERY_FETCH_AVERAGE
+        },
         {.name = "min",
                 .hash  = 0,
                 .value = RRDR_GROUPING_MIN,
@@ -742,6 +793,15 @@ static inline void time_grouping_add(RRDR *r, NETDATA_DOUBLE value, const RRDR_T
             tg_percentile_add(r, value);
             break;
 
+        case RRDR_GROUPING_PERCENTILE_APPROX:
+        case RRDR_GROUPING_MEDIAN_APPROX:
+            tg_percentile_approx_add(r, value);
+            break;
+
+        case RRDR_GROUPING_LTTB:
+            tg_lttb_add(r, value);
+            break;
+
         case RRDR_GROUPING_SES:
             tg_ses_add(r, value);
             break;
@@ -792,6 +852,15 @@ static inline NETDATA_DOUBLE time_grouping_flush(RRDR *r, RRDR_VALUE_FLAGS *rrdr
         case RRDR_GROUPING_PERCENTILE:
             return tg_percentile_flush(r, rrdr_value_options_ptr);
 
+        case RRDR_GROUPING_PERCENTILE_APPROX:
+            return tg_percentile_approx_flush(r, rrdr_value_options_ptr);
+
+        case RRDR_GROUPING_MEDIAN_APPROX:
+            return tg_median_approx_flush(r, rrdr_value_options_ptr);
+
+        case RRDR_GROUPING_LTTB:
+            return tg_lttb_flush(r, rrdr_value_options_ptr);
+
         case RRDR_GROUPING_SES:
             return tg_ses_flush(r, rrdr_value_options_ptr);
 
@@ -898,6 +967,9 @@ RRDR_GROUP_BY_FUNCTION group_by_aggregate_function_parse(const char *s) {
     if(strcmp(s, "percentage") == 0)
         return RRDR_GROUP_BY_FUNCTION_PERCENTAGE;
 
+    if(strcmp(s, "merge") == 0)
+        return RRDR_GROUP_BY_FUNCTION_MERGE;
+
     return RRDR_GROUP_BY_FUNCTION_AVERAGE;
 }
 
@@ -918,6 +990,9 @@ const char *group_by_aggregate_function_to_string(RRDR_GROUP_BY_FUNCTION group_b
 
         case RRDR_GROUP_BY_FUNCTION_PERCENTAGE:
             return "percentage";
+
+        case RRDR_GROUP_BY_FUNCTION_MERGE:
+            return "merge";
     }
 }
 
@@ -1061,6 +1136,33 @@ static size_t query_metric_best_tier_for_timeframe(QUERY_METRIC *qm, time_t afte
     return best_tier;
 }
 
+// The anomaly rate of a point of a higher tier is not an approximation: its anomaly_count
+// counts all the anomalous tier 0 points it aggregates. So, when the points of a higher tier
+// align with the points of the query and cover all of it, the anomaly rates it gives are the
+// same as the ones of tier 0, reading a fraction of the points.
+static size_t query_metric_anomaly_rates_tier(QUERY_METRIC *qm, time_t after_wanted, time_t before_wanted, time_t view_update_every) {
+    if(unlikely(storage_tiers < 2 || view_update_every <= 0))
+        return 0;
+
+    for(size_t tier = storage_tiers - 1; tier > 0 ; tier--) {
+        time_t update_every_s = qm->tiers[tier].db_update_every_s;
+
+        if(!qm->tiers[tier].smh || !update_every_s)
+            continue;
+
+        if(view_update_every % update_every_s || after_wanted % update_every_s || before_wanted % update_every_s)
+            continue;
+
+        if(!qm->tiers[tier].db_first_time_s || qm->tiers[tier].db_first_time_s > after_wanted ||
+            qm->tiers[tier].db_last_time_s < before_wanted)
+            continue;
+
+        return tier;
+    }
+
+    return 0;
+}
+
 static size_t rrddim_find_best_tier_for_timeframe(QUERY_TARGET *qt, time_t after_wanted, time_t before_wanted, size_t points_wanted) {
     if(unlikely(storage_tiers < 2))
         return 0;
@@ -1189,6 +1291,13 @@ typedef struct query_engine_ops {
     struct query_metric_tier *tier_ptr;
     struct storage_engine_query_handle *seqh;
 
+    // points fetched from the storage engine, not consumed yet
+    struct {
+        size_t used;
+        size_t len;
+        STORAGE_POINT sp[QUERY_BATCH_POINTS];
+    } batch;
+
     // aggregating points over time
     size_t group_points_non_zero;
     size_t group_points_added;
@@ -1196,6 +1305,12 @@ typedef struct query_engine_ops {
     STORAGE_POINT query_point;          // aggregates min, max, sum, count, anomaly count across the whole query
     RRDR_VALUE_FLAGS group_value_flags;
 
+    // values waiting to be added to the time grouping of the group point
+    struct {
+        size_t used;
+        NETDATA_DOUBLE values[QUERY_GROUP_BATCH_VALUES];
+    } group_values;
+
     // statistics
     size_t db_total_points_read;
     size_t db_points_read_per_tier[RRD_STORAGE_TIERS];
@@ -1268,7 +1383,7 @@ static void query_planer_initialize_plans(QUERY_ENGINE_OPS *ops) {
         ops->plans[p].expanded_after = after;
         ops->plans[p].expanded_before = before;
 
-        ops->r->internal.qt->db.tiers[tier].queries++;
+        __atomic_add_fetch(&ops->r->internal.qt->db.tiers[tier].queries, 1, __ATOMIC_RELAXED);
 
         struct query_metric_tier *tier_ptr = &qm->tiers[tier];
         STORAGE_ENGINE *eng = query_metric_storage_engine(ops->r->internal.qt, qm, tier);
@@ -1318,6 +1433,9 @@ static void query_planer_activate_plan(QUERY_ENGINE_OPS *ops, size_t plan_id, ti
 
     ops->plan_expanded_after = ops->plans[plan_id].expanded_after;
     ops->plan_expanded_before = ops->plans[plan_id].expanded_before;
+
+    // the points of the previous plan are not needed anymore
+    ops->batch.used = ops->batch.len = 0;
 }
 
 static bool query_planer_next_plan(QUERY_ENGINE_OPS *ops, time_t now, time_t last_point_end_time) {
@@ -1351,6 +1469,62 @@ static bool query_planer_next_plan(QUERY_ENGINE_OPS *ops, time_t now, time_t las
     return true;
 }
 
+// ----------------------------------------------------------------------------
+// prefetching the neighboring windows
+//
+// When users pan and zoom a chart, the next query is usually predictable:
+// the window before or after the current one, or a part of the current one
+// at a higher resolution. So, while we execute a query, we ask the storage
+// engine to load the pages of these windows into its cache, with the lowest
+// priority. Whatever is not loaded within the timeout is not loaded at all.
+//
+// Dashboards showing live data query relative windows that move with time,
+// which are already cached, so only absolute windows are prefetched.
+
+static void query_planer_prefetch(QUERY_TARGET *qt, QUERY_METRIC *qm, size_t tier, time_t after, time_t before) {
+    if(!query_metric_is_valid_tier(qm, tier))
+        return;
+
+    struct query_metric_tier *tier_ptr = &qm->tiers[tier];
+
+    if(after < tier_ptr->db_first_time_s)
+        after = tier_ptr->db_first_time_s;
+
+    if(before > tier_ptr->db_last_time_s)
+        before = tier_ptr->db_last_time_s;
+
+    if(after >= before)
+        return;
+
+    STORAGE_ENGINE *eng = query_metric_storage_engine(qt, qm, tier);
+    storage_engine_query_prefetch(eng->seb, tier_ptr->smh, after, before, query_prefetch_timeout_ms * USEC_PER_MS);
+}
+
+static void query_planer_prefetch_neighbors(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before_wanted) {
+    QUERY_TARGET *qt = ops->r->internal.qt;
+    QUERY_METRIC *qm = ops->qm;
+
+    if(!query_prefetch_timeout_ms || qt->window.relative || qt->request.query_source != QUERY_SOURCE_API_DATA)
+        return;
+
+    time_t duration = before_wanted - after_wanted;
+    if(duration <= 0)
+        return;
+
+    size_t first_tier = qm->plan.array[0].tier;
+    size_t last_tier = qm->plan.array[qm->plan.used - 1].tier;
+
+    // panning to the past
+    query_planer_prefetch(qt, qm, first_tier, after_wanted - duration, after_wanted);
+
+    // panning to the future (nothing is prefetched after the latest data)
+    query_planer_prefetch(qt, qm, last_tier, before_wanted, before_wanted + duration);
+
+    // zooming in, around the middle of the window
+    if(first_tier > 0)
+        query_planer_prefetch(qt, qm, first_tier - 1, after_wanted + duration / 4, before_wanted - duration / 4);
+}
+
 static int compare_query_plan_entries_on_start_time(const void *a, const void *b) {
     QUERY_PLAN_ENTRY *p1 = (QUERY_PLAN_ENTRY *)a;
     QUERY_PLAN_ENTRY *p2 = (QUERY_PLAN_ENTRY *)b;
@@ -1371,7 +1545,13 @@ static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
         switch_tiers = false;
     }
     else {
-        selected_tier = query_metric_best_tier_for_timeframe(qm, after_wanted, before_wanted, points_wanted);
+        selected_tier = 0;
+
+        if(ops->r->internal.qt->window.options & RRDR_OPTION_ANOMALY_BIT)
+            selected_tier = query_metric_anomaly_rates_tier(qm, after_wanted, before_wanted, ops->view_update_every);
+
+        if(!selected_tier)
+            selected_tier = query_metric_best_tier_for_timeframe(qm, after_wanted, before_wanted, points_wanted);
 
         if(!query_metric_is_valid_tier(qm, selected_tier))
             return false;
@@ -1481,6 +1661,7 @@ static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
 
     query_planer_initialize_plans(ops);
     query_planer_activate_plan(ops, 0, 0);
+    query_planer_prefetch_neighbors(ops, after_wanted, before_wanted);
 
     return true;
 }
@@ -1489,6 +1670,23 @@ static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
 // ----------------------------------------------------------------------------
 // dimension level query engine
 
+static inline bool query_ops_is_finished(QUERY_ENGINE_OPS *ops) {
+    return ops->batch.used >= ops->batch.len && storage_engine_query_is_finished(ops->seqh);
+}
+
+static inline STORAGE_POINT query_ops_next_point(QUERY_ENGINE_OPS *ops) {
+    if(unlikely(ops->batch.used >= ops->batch.len)) {
+        ops->batch.used = 0;
+        ops->batch.len = storage_engine_query_next_metric_batch(ops->seqh, ops->batch.sp, QUERY_BATCH_POINTS);
+
+        if(unlikely(!ops->batch.len))
+            // the query is finished, but the storage engine still keeps track of time
+            return storage_engine_query_next_metric(ops->seqh);
+    }
+
+    return ops->batch.sp[ops->batch.used++];
+}
+
 #define query_interpolate_point(this_point, last_point, now)      do {  \
     if(likely(                                                          \
             /* the point to interpolate is more than 1s wide */         \
@@ -1507,6 +1705,77 @@ static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
         }                                                               \
 } while(0)
 
+// ----------------------------------------------------------------------------
+// batched time grouping
+//
+// The most common time groupings do not add values one by one. We collect
+// the values of each group point and give them to the vectorized kernels
+// of the time grouping, when the batch gets full or the group point is
+// flushed.
+
+static inline bool time_grouping_is_batched(const RRDR_TIME_GROUPING add_flush) {
+    switch(add_flush) {
+        case RRDR_GROUPING_AVERAGE:
+        case RRDR_GROUPING_MIN:
+        case RRDR_GROUPING_MAX:
+        case RRDR_GROUPING_SUM:
+        case RRDR_GROUPING_STDDEV:
+        case RRDR_GROUPING_CV:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static inline void time_grouping_add_batch(RRDR *r, const NETDATA_DOUBLE *values, size_t n, const RRDR_TIME_GROUPING add_flush) {
+    switch(add_flush) {
+        case RRDR_GROUPING_AVERAGE:
+            tg_average_add_batch(r, values, n);
+            break;
+
+        case RRDR_GROUPING_MIN:
+            tg_min_add_batch(r, values, n);
+            break;
+
+        case RRDR_GROUPING_MAX:
+            tg_max_add_batch(r, values, n);
+            break;
+
+        case RRDR_GROUPING_SUM:
+            tg_sum_add_batch(r, values, n);
+            break;
+
+        case RRDR_GROUPING_STDDEV:
+        case RRDR_GROUPING_CV:
+            tg_stddev_add_batch(r, values, n);
+            break;
+
+        default:
+            for(size_t i = 0; i < n ; i++)
+                time_grouping_add(r, values[i], add_flush);
+            break;
+    }
+}
+
+static inline void query_group_values_flush(RRDR *r, QUERY_ENGINE_OPS *ops, const RRDR_TIME_GROUPING add_flush) {
+    if(ops->group_values.used) {
+        time_grouping_add_batch(r, ops->group_values.values, ops->group_values.used, add_flush);
+        ops->group_values.used = 0;
+    }
+}
+
+static inline void query_group_value_add(RRDR *r, QUERY_ENGINE_OPS *ops, NETDATA_DOUBLE value, const RRDR_TIME_GROUPING add_flush) {
+    if(likely(time_grouping_is_batched(add_flush))) {
+        ops->group_values.values[ops->group_values.used++] = value;
+
+        if(unlikely(ops->group_values.used == QUERY_GROUP_BATCH_VALUES))
+            query_group_values_flush(r, ops, add_flush);
+    }
+    else
+        time_grouping_add(r, value, add_flush);
+}
+
 #define query_add_point_to_group(r, point, ops, add_flush)        do {  \
     if(likely(netdata_double_isnumber((point).value))) {                \
         if(likely(fpclassify((point).value) != FP_ZERO))                \
@@ -1515,7 +1784,7 @@ static bool query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
         if(unlikely((point).sp.flags & SN_FLAG_RESET))                  \
             (ops)->group_value_flags |= RRDR_VALUE_RESET;               \
                                                                         \
-        time_grouping_add(r, (point).value, add_flush);                 \
+        query_group_value_add(r, ops, (point).value, add_flush);        \
                                                                         \
         storage_point_merge_to((ops)->group_point, (point).sp);         \
         if(!(point).added)                                              \
@@ -1636,7 +1905,7 @@ static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_
                 last1_point = new_point;
             }
 
-            if(unlikely(storage_engine_query_is_finished(ops->seqh))) {
+            if(unlikely(query_ops_is_finished(ops))) {
                 query_is_finished_counter++;
 
                 if(count_same_end_time != 0) {
@@ -1659,7 +1928,7 @@ static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_
                 STORAGE_POINT sp;
                 if(likely(storage_point_is_unset(next1_point))) {
                     db_points_read_since_plan_switch++;
-                    sp = storage_engine_query_next_metric(ops->seqh);
+                    sp = query_ops_next_point(ops);
                     ops->db_points_read_per_tier[ops->tier]++;
                     ops->db_total_points_read++;
 
@@ -1685,7 +1954,7 @@ static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_
                     // A. the entire point of the previous plan is to the future of point from the next plan
                     // B. part of the point of the previous plan overlaps with the point from the next plan
 
-                    STORAGE_POINT sp2 = storage_engine_query_next_metric(ops->seqh);
+                    STORAGE_POINT sp2 = query_ops_next_point(ops);
                     ops->db_points_read_per_tier[ops->tier]++;
                     ops->db_total_points_read++;
 
@@ -1902,7 +2171,12 @@ static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_
             // store the specific point options
             *rrdr_value_options_ptr = ops->group_value_flags;
 
+            // give the sketch of this point to group-by
+            if(unlikely(r->sk))
+                tg_percentile_approx_keep(r, &r->sk[rrdr_o_v_index]);
+
             // store the group value
+            query_group_values_flush(r, ops, add_flush);
             NETDATA_DOUBLE group_value = time_grouping_flush(r, rrdr_value_options_ptr, add_flush);
             r->v[rrdr_o_v_index] = group_value;
 
@@ -1956,7 +2230,7 @@ static void rrd2rrdr_query_execute(RRDR *r, size_t dim_id_in_rrdr, QUERY_ENGINE_
     r->stats.result_points_generated += points_added;
     r->stats.db_points_read += ops->db_total_points_read;
     for(size_t tr = 0; tr < storage_tiers ; tr++)
-        qt->db.tiers[tr].points += ops->db_points_read_per_tier[tr];
+        __atomic_add_fetch(&qt->db.tiers[tr].points, ops->db_points_read_per_tier[tr], __ATOMIC_RELAXED);
 }
 
 // ----------------------------------------------------------------------------
@@ -2004,16 +2278,22 @@ void rrdr_fill_tier_gap_from_smaller_tiers(RRDDIM *rd, size_t tier, time_t now_s
         storage_engine_query_init(tmp->seb, tmp->smh, &seqh, after_wanted, before_wanted, STORAGE_PRIORITY_HIGH);
 
         size_t points_read = 0;
+        STORAGE_POINT sps[QUERY_BATCH_POINTS];
 
         while(!storage_engine_query_is_finished(&seqh)) {
 
-            STORAGE_POINT sp = storage_engine_query_next_metric(&seqh);
-            points_read++;
+            size_t points = storage_engine_query_next_metric_batch(&seqh, sps, QUERY_BATCH_POINTS);
+            points_read += points;
 
-            if(sp.end_time_s > latest_time_s) {
-                latest_time_s = sp.end_time_s;
-                store_metric_at_tier(rd, tier, t, sp, sp.end_time_s * USEC_PER_SEC);
+            for(size_t i = 0; i < points ; i++) {
+                if(sps[i].end_time_s > latest_time_s) {
+                    latest_time_s = sps[i].end_time_s;
+                    store_metric_at_tier(rd, tier, t, sps[i], sps[i].end_time_s * USEC_PER_SEC);
+                }
             }
+
+            if(unlikely(!points))
+                break;
         }
 
         storage_engine_query_finalize(&seqh);
@@ -2664,6 +2944,55 @@ struct rrdr_group_by_entry {
     DICTIONARY *dl;
 };
 
+// ----------------------------------------------------------------------------
+// group-by merging the sketches of percentile-approx and median-approx
+//
+// The time grouping gives the sketch of each point to the temporary RRDR of
+// the metric queried, group-by merges it into the sketch of its slot, and
+// finalization calculates the value of each point from the merged sketch.
+// So, the values returned are the percentiles of all the values of the
+// metrics grouped together, not an aggregation of their percentiles.
+
+static bool rrd2rrdr_group_by_merges_sketches(QUERY_TARGET *qt, size_t pass) {
+    if(!tg_is_percentile_approx(qt->window.time_group_method))
+        return false;
+
+    // all the passes before this one must have merged them too
+    for(size_t g = 0; g <= pass ; g++)
+        if(qt->request.group_by[g].aggregation != RRDR_GROUP_BY_FUNCTION_MERGE)
+            return false;
+
+    return true;
+}
+
+static void rrdr_sketches_create(RRDR *r) {
+    r->sk = onewayalloc_mallocz(r->internal.owa, r->n * r->d * sizeof(*r->sk));
+    for(size_t i = 0; i < r->n * r->d ; i++)
+        ddsketch_init(&r->sk[i]);
+}
+
+// the source sketch is not needed after this, so it is given away when it can be
+static inline void rrd2rrdr_group_by_merge_sketch(DDSKETCH *dst, DDSKETCH *src) {
+    if(!ddsketch_count(dst))
+        ddsketch_swap(dst, src);
+    else
+        ddsketch_merge(dst, src);
+}
+
+// sets the value of each point to the value of the time grouping on its sketch
+static void rrdr_sketches_to_values(RRDR *r) {
+    QUERY_TARGET *qt = r->internal.qt;
+    NETDATA_DOUBLE percent = tg_percentile_approx_percent(qt->window.time_group_method, qt->window.time_group_options);
+
+    for(size_t idx = 0; idx < r->n * r->d ; idx++) {
+        if(!ddsketch_count(&r->sk[idx]))
+            continue;
+
+        NETDATA_DOUBLE value = tg_percentile_approx_sketch_value(qt->window.time_group_method, percent, &r->sk[idx]);
+        r->v[idx] = netdata_double_isnumber(value) ? value : 0.0;
+    }
+}
+
 static RRDR *rrd2rrdr_group_by_initialize(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
     RRDR *r_tmp = NULL;
     RRDR_OPTIONS options = qt->window.options;
@@ -2898,6 +3227,9 @@ static RRDR *rrd2rrdr_group_by_initialize(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
         r->gbc = onewayalloc_callocz(owa, r->n * r->d, sizeof(*r->gbc));
         r->dqp = onewayalloc_callocz(owa, r->d, sizeof(STORAGE_POINT));
 
+        if(rrd2rrdr_group_by_merges_sketches(qt, g))
+            rrdr_sketches_create(r);
+
         if(hidden_dimensions && ((group_by & RRDR_GROUP_BY_PERCENTAGE_OF_INSTANCE) || (aggregation_method == RRDR_GROUP_BY_FUNCTION_PERCENTAGE)))
             // this is where we are going to group the hidden dimensions
             r->vh = onewayalloc_mallocz(owa, r->n * r->d * sizeof(*r->vh));
@@ -2968,6 +3300,9 @@ static RRDR *rrd2rrdr_group_by_initialize(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
     rrd2rrdr_set_timestamps(r_tmp);
     r_tmp->group_by.r = first_r;
 
+    if(first_r->sk)
+        rrdr_sketches_create(r_tmp);
+
 cleanup:
     if(!first_r || !last_r || !r_tmp) {
         if(r_tmp) {
@@ -3046,6 +3381,7 @@ static void rrd2rrdr_group_by_add_metric(RRDR *r_dst, size_t d_dst, RRDR *r_tmp,
             case RRDR_GROUP_BY_FUNCTION_AVERAGE:
             case RRDR_GROUP_BY_FUNCTION_SUM:
             case RRDR_GROUP_BY_FUNCTION_PERCENTAGE:
+            case RRDR_GROUP_BY_FUNCTION_MERGE:
                 if(isnan(*cn))
                     *cn = n_tmp;
                 else
@@ -3063,6 +3399,9 @@ static void rrd2rrdr_group_by_add_metric(RRDR *r_dst, size_t d_dst, RRDR *r_tmp,
                 break;
         }
 
+        if(r_dst->sk && r_tmp->sk && !hidden_dimension_on_percentage_of_group)
+            rrd2rrdr_group_by_merge_sketch(&r_dst->sk[idx_dst], &r_tmp->sk[idx_tmp]);
+
         if(!hidden_dimension_on_percentage_of_group) {
             *co &= ~RRDR_VALUE_EMPTY;
             *co |= (o_tmp & (RRDR_VALUE_RESET | RRDR_VALUE_PARTIAL));
@@ -3251,6 +3590,11 @@ static RRDR *rrd2rrdr_group_by_finalize(RRDR *r_tmp) {
     size_t pass = 0;
     while(r) {
         pass++;
+
+        // this pass does not merge the sketches, so it aggregates their values
+        if(last_r->sk && !r->sk)
+            rrdr_sketches_to_values(last_r);
+
         for(size_t d = 0; d < last_r->d ;d++) {
             rrd2rrdr_group_by_add_metric(r, last_r->dgbs[d], last_r, d,
                                          qt->request.group_by[pass].aggregation,
@@ -3281,6 +3625,12 @@ static RRDR *rrd2rrdr_group_by_finalize(RRDR *r_tmp) {
     if(!query_target_aggregatable(qt) && r->partial_data_trimming.expected_after < qt->window.before)
         rrdr2rrdr_group_by_partial_trimming(r);
 
+    // without sketches to merge, merge is average
+    if(r->sk)
+        rrdr_sketches_to_values(r);
+    else if(aggregation == RRDR_GROUP_BY_FUNCTION_MERGE)
+        aggregation = RRDR_GROUP_BY_FUNCTION_AVERAGE;
+
     // apply averaging, remove RRDR_VALUE_EMPTY, find the non-zero dimensions, min and max
     size_t global_min_max_values = 0;
     size_t dimensions_nonzero = 0;
@@ -3406,6 +3756,387 @@ static RRDR *rrd2rrdr_group_by_finalize(RRDR *r_tmp) {
     return r;
 }
 
+// ----------------------------------------------------------------------------
+// query metrics accounting
+
+static void query_metric_queried(QUERY_TARGET *qt, QUERY_METRIC *qm, QUERY_DIMENSION *qd, QUERY_INSTANCE *qi, QUERY_CONTEXT *qc, QUERY_NODE *qn) {
+    qi->metrics.queried++;
+    qc->metrics.queried++;
+    qn->metrics.queried++;
+
+    qd->status |= QUERY_STATUS_QUERIED;
+    qm->status |= RRDR_DIMENSION_QUERIED;
+
+    if(qt->request.version >= 2) {
+        // we need to make the query points positive now
+        // since we will aggregate it across multiple dimensions
+        storage_point_make_positive(qm->query_points);
+        storage_point_merge_to(qi->query_points, qm->query_points);
+        storage_point_merge_to(qc->query_points, qm->query_points);
+        storage_point_merge_to(qn->query_points, qm->query_points);
+        storage_point_merge_to(qt->query_points, qm->query_points);
+    }
+}
+
+static void query_metric_failed(QUERY_METRIC *qm, QUERY_DIMENSION *qd, QUERY_INSTANCE *qi, QUERY_CONTEXT *qc, QUERY_NODE *qn) {
+    qi->metrics.failed++;
+    qc->metrics.failed++;
+    qn->metrics.failed++;
+
+    qd->status |= QUERY_STATUS_FAILED;
+    qm->status |= RRDR_DIMENSION_FAILED;
+}
+
+// ----------------------------------------------------------------------------
+// parallel query execution
+//
+// Queries with many metrics are split across the query threads. The metrics
+// are handed out in small steps from a shared cursor, so that threads that
+// finish early keep taking work from the rest. Each thread queries into its
+// own temporary RRDR and groups the results into its own partial copy of the
+// group-by RRDR, using its own ONEWAYALLOC. The partial results are merged
+// into the group-by RRDR when each thread finishes, before the query is
+// finalized by rrd2rrdr_group_by_finalize().
+
+struct query_parallel {
+    QUERY_TARGET *qt;
+    RRDR *r;                            // the group-by RRDR the partial results are merged to
+    pid_t caller_tid;                   // only the caller checks the interrupt callback
+
+    size_t next;                        // the next metric to be queried
+    bool cancel;
+
+    SPINLOCK spinlock;                  // protects everything below, and the query target statistics
+
+    long dimensions_used;
+    long dimensions_nonzero;
+
+    bool view_set;
+    time_t max_after;
+    time_t min_before;
+    size_t max_rows;
+
+    bool min_max_set;
+    NETDATA_DOUBLE min;
+    NETDATA_DOUBLE max;
+};
+
+static inline void rrd2rrdr_group_by_aggregate_value(NETDATA_DOUBLE *cn, NETDATA_DOUBLE n, RRDR_GROUP_BY_FUNCTION group_by_aggregate_function) {
+    switch(group_by_aggregate_function) {
+        default:
+        case RRDR_GROUP_BY_FUNCTION_AVERAGE:
+        case RRDR_GROUP_BY_FUNCTION_SUM:
+        case RRDR_GROUP_BY_FUNCTION_PERCENTAGE:
+        case RRDR_GROUP_BY_FUNCTION_MERGE:
+            if(isnan(*cn))
+                *cn = n;
+            else
+                *cn += n;
+            break;
+
+        case RRDR_GROUP_BY_FUNCTION_MIN:
+            if(isnan(*cn) || n < *cn)
+                *cn = n;
+            break;
+
+        case RRDR_GROUP_BY_FUNCTION_MAX:
+            if(isnan(*cn) || n > *cn)
+                *cn = n;
+            break;
+    }
+}
+
+static RRDR *rrd2rrdr_group_by_partial_create(ONEWAYALLOC *owa, RRDR *r) {
+    QUERY_TARGET *qt = r->internal.qt;
+
+    RRDR *r_part = rrdr_create(owa, qt, r->d, r->n);
+    if(!r_part)
+        return NULL;
+
+    rrd2rrdr_set_timestamps(r_part);
+    r_part->gbc = onewayalloc_callocz(owa, r->n * r->d, sizeof(*r_part->gbc));
+    r_part->dqp = onewayalloc_callocz(owa, r->d, sizeof(STORAGE_POINT));
+    memset(r_part->od, 0, r->d * sizeof(*r_part->od));
+
+    if(r->vh)
+        r_part->vh = onewayalloc_mallocz(owa, r->n * r->d * sizeof(*r_part->vh));
+
+    if(r->sk)
+        rrdr_sketches_create(r_part);
+
+    for (size_t i = 0; i != r_part->n * r_part->d; i++) {
+        r_part->v[i] = NAN;
+        r_part->ar[i] = 0.0;
+        r_part->o[i] = RRDR_VALUE_EMPTY;
+
+        if(r_part->vh)
+            r_part->vh[i] = NAN;
+    }
+
+    return r_part;
+}
+
+static void rrd2rrdr_group_by_partial_merge(RRDR *r_dst, RRDR *r_part, RRDR_GROUP_BY_FUNCTION group_by_aggregate_function) {
+    for(size_t d = 0; d < r_dst->d ; d++) {
+        r_dst->od[d] |= r_part->od[d];
+        storage_point_merge_to(r_dst->dqp[d], r_part->dqp[d]);
+    }
+
+    for(size_t idx = 0; idx != r_dst->n * r_dst->d ; idx++) {
+        if(r_part->vh && !isnan(r_part->vh[idx]))
+            rrd2rrdr_group_by_aggregate_value(&r_dst->vh[idx], r_part->vh[idx], group_by_aggregate_function);
+
+        if(r_part->o[idx] & RRDR_VALUE_EMPTY)
+            continue;
+
+        rrd2rrdr_group_by_aggregate_value(&r_dst->v[idx], r_part->v[idx], group_by_aggregate_function);
+
+        if(r_part->sk)
+            rrd2rrdr_group_by_merge_sketch(&r_dst->sk[idx], &r_part->sk[idx]);
+
+        r_dst->o[idx] &= ~RRDR_VALUE_EMPTY;
+        r_dst->o[idx] |= (r_part->o[idx] & (RRDR_VALUE_RESET | RRDR_VALUE_PARTIAL));
+        r_dst->ar[idx] += r_part->ar[idx];
+        r_dst->gbc[idx] += r_part->gbc[idx];
+    }
+}
+
+static void rrd2rrdr_query_parallel_worker(void *data) {
+    struct query_parallel *qp = data;
+    QUERY_TARGET *qt = qp->qt;
+    RRDR *r = qp->r;
+    RRDR_GROUP_BY_FUNCTION aggregation = qt->request.group_by[0].aggregation;
+    bool caller = (gettid_cached() == qp->caller_tid);
+
+    ONEWAYALLOC *owa = onewayalloc_create(0);
+    RRDR *r_tmp = rrdr_create(owa, qt, 1, qt->window.points);
+    RRDR *r_part = rrd2rrdr_group_by_partial_create(owa, r);
+    if(!r_tmp || !r_part) {
+        __atomic_store_n(&qp->cancel, true, __ATOMIC_RELAXED);
+        goto cleanup;
+    }
+
+    rrd2rrdr_set_timestamps(r_tmp);
+    rrdr_set_grouping_function(r_tmp, qt->window.time_group_method);
+    r_tmp->time_grouping.create(r_tmp, qt->window.time_group_options);
+
+    if(r->sk)
+        rrdr_sketches_create(r_tmp);
+
+    long dimensions_used = 0, dimensions_nonzero = 0;
+    time_t max_after = 0, min_before = 0;
+    size_t max_rows = 0;
+    size_t last_db_points_read = 0;
+    size_t last_result_points_generated = 0;
+
+    QUERY_ENGINE_OPS *ops[QUERY_PARALLEL_METRICS_PER_STEP];
+
+    while(!__atomic_load_n(&qp->cancel, __ATOMIC_RELAXED)) {
+        size_t start = __atomic_fetch_add(&qp->next, QUERY_PARALLEL_METRICS_PER_STEP, __ATOMIC_RELAXED);
+        if(start >= qt->query.used)
+            break;
+
+        size_t end = start + QUERY_PARALLEL_METRICS_PER_STEP;
+        if(end > qt->query.used)
+            end = qt->query.used;
+
+        // prepare all the metrics of this step, so that their data are loaded in parallel
+        for(size_t d = start; d < end ; d++)
+            ops[d - start] = rrd2rrdr_query_ops_prep(r_tmp, d);
+
+        for(size_t d = start; d < end ; d++) {
+            QUERY_ENGINE_OPS *o = ops[d - start];
+
+            if(__atomic_load_n(&qp->cancel, __ATOMIC_RELAXED)) {
+                if(o) {
+                    query_planer_finalize_remaining_plans(o);
+                    rrd2rrdr_query_ops_release(o);
+                }
+                continue;
+            }
+
+            QUERY_METRIC *qm = query_metric(qt, d);
+            QUERY_DIMENSION *qd = query_dimension(qt, qm->link.query_dimension_id);
+            QUERY_INSTANCE *qi = query_instance(qt, qm->link.query_instance_id);
+            QUERY_CONTEXT *qc = query_context(qt, qm->link.query_context_id);
+            QUERY_NODE *qn = query_node(qt, qm->link.query_node_id);
+
+            if(!o) {
+                spinlock_lock(&qp->spinlock);
+                query_metric_failed(qm, qd, qi, qc, qn);
+                spinlock_unlock(&qp->spinlock);
+                continue;
+            }
+
+            // set the query target dimension options to rrdr
+            r_tmp->od[0] = qm->status;
+
+            // reset the grouping for the new dimension
+            r_tmp->time_grouping.reset(r_tmp);
+
+            usec_t started_ut = now_monotonic_usec();
+            rrd2rrdr_query_execute(r_tmp, 0, o);
+            r_tmp->od[0] |= RRDR_DIMENSION_QUERIED;
+
+            usec_t now_ut = now_monotonic_usec();
+            qm->duration_ut = now_ut - started_ut;
+
+            // the query updates RRDR_DIMENSION_NONZERO
+            qm->status = r_tmp->od[0];
+
+            rrd2rrdr_group_by_add_metric(r_part, qm->grouped_as.first_slot, r_tmp, 0,
+                                         aggregation, &qm->query_points, 0);
+
+            rrd2rrdr_query_ops_release(o);
+
+            spinlock_lock(&qp->spinlock);
+            query_metric_queried(qt, qm, qd, qi, qc, qn);
+            qn->duration_ut += qm->duration_ut;
+            spinlock_unlock(&qp->spinlock);
+
+            global_statistics_rrdr_query_completed(
+                    1,
+                    r_tmp->stats.db_points_read - last_db_points_read,
+                    r_tmp->stats.result_points_generated - last_result_points_generated,
+                    qt->request.query_source);
+
+            last_db_points_read = r_tmp->stats.db_points_read;
+            last_result_points_generated = r_tmp->stats.result_points_generated;
+
+            if(qm->status & RRDR_DIMENSION_NONZERO)
+                dimensions_nonzero++;
+
+            if(unlikely(!dimensions_used)) {
+                max_after = r_tmp->view.after;
+                min_before = r_tmp->view.before;
+                max_rows = r_tmp->rows;
+            }
+            else {
+                if(r_tmp->view.after > max_after) max_after = r_tmp->view.after;
+                if(r_tmp->view.before < min_before) min_before = r_tmp->view.before;
+                if(r_tmp->rows > max_rows) max_rows = r_tmp->rows;
+            }
+
+            dimensions_used++;
+
+            bool cancel = false;
+            if (caller && qt->request.interrupt_callback && qt->request.interrupt_callback(qt->request.interrupt_callback_data)) {
+                cancel = true;
+                nd_log(NDLS_ACCESS, NDLP_NOTICE, "QUERY INTERRUPTED");
+            }
+
+            if (qt->request.timeout_ms && ((NETDATA_DOUBLE)(now_ut - qt->timings.received_ut) / 1000.0) > (NETDATA_DOUBLE)qt->request.timeout_ms) {
+                cancel = true;
+                nd_log(NDLS_ACCESS, NDLP_WARNING, "QUERY CANCELED RUNTIME EXCEEDED %0.2f ms (LIMIT %lld ms)",
+                       (NETDATA_DOUBLE)(now_ut - qt->timings.received_ut) / 1000.0, (long long)qt->request.timeout_ms);
+            }
+
+            if(cancel)
+                __atomic_store_n(&qp->cancel, true, __ATOMIC_RELAXED);
+            else
+                query_progress_done_step(qt->request.transaction, 1);
+        }
+    }
+
+    // free all resources used by the grouping method
+    r_tmp->time_grouping.free(r_tmp);
+
+    // the released ops of this thread have been allocated by our owa
+    rrd2rrdr_query_ops_freeall(r_tmp);
+
+    spinlock_lock(&qp->spinlock);
+
+    if(dimensions_used) {
+        rrd2rrdr_group_by_partial_merge(r, r_part, aggregation);
+
+        r->stats.db_points_read += r_tmp->stats.db_points_read;
+        r->stats.result_points_generated += r_tmp->stats.result_points_generated;
+
+        if(!qp->view_set) {
+            qp->view_set = true;
+            qp->max_after = max_after;
+            qp->min_before = min_before;
+            qp->max_rows = max_rows;
+        }
+        else {
+            if(max_after > qp->max_after) qp->max_after = max_after;
+            if(min_before < qp->min_before) qp->min_before = min_before;
+            if(max_rows > qp->max_rows) qp->max_rows = max_rows;
+        }
+
+        if(!qp->min_max_set) {
+            qp->min_max_set = true;
+            qp->min = r_tmp->view.min;
+            qp->max = r_tmp->view.max;
+        }
+        else {
+            if(r_tmp->view.min < qp->min) qp->min = r_tmp->view.min;
+            if(r_tmp->view.max > qp->max) qp->max = r_tmp->view.max;
+        }
+
+        qp->dimensions_used += dimensions_used;
+        qp->dimensions_nonzero += dimensions_nonzero;
+    }
+
+    spinlock_unlock(&qp->spinlock);
+
+cleanup:
+    if(r_tmp)
+        rrdr_free(owa, r_tmp);
+
+    if(r_part)
+        rrdr_free(owa, r_part);
+
+    onewayalloc_destroy(owa);
+}
+
+// returns true when the query has been executed in parallel
+static bool rrd2rrdr_query_parallel(RRDR *r_tmp, long *dimensions_used, long *dimensions_nonzero) {
+    QUERY_TARGET *qt = r_tmp->internal.qt;
+    RRDR *r = r_tmp->group_by.r;
+
+    // v1 queries are per chart and query directly into the final RRDR
+    if(!r || qt->request.version < 2 || qt->query.used < QUERY_PARALLEL_MIN_METRICS)
+        return false;
+
+    size_t helpers = qt->query.used / QUERY_PARALLEL_MIN_METRICS;
+    if(helpers > query_threads_available())
+        helpers = query_threads_available();
+
+    if(!helpers)
+        return false;
+
+    struct query_parallel qp = {
+        .qt = qt,
+        .r = r,
+        .caller_tid = gettid_cached(),
+        .next = 0,
+        .cancel = false,
+    };
+    spinlock_init(&qp.spinlock);
+
+    query_threads_run(rrd2rrdr_query_parallel_worker, &qp, helpers);
+
+    if(qp.view_set) {
+        r->view.after = qp.max_after;
+        r->view.before = qp.min_before;
+        r->rows = qp.max_rows;
+    }
+
+    if(qp.min_max_set) {
+        r->view.min = qp.min;
+        r->view.max = qp.max;
+    }
+
+    if(qp.cancel)
+        r->view.flags |= RRDR_RESULT_FLAG_CANCEL;
+
+    *dimensions_used = qp.dimensions_used;
+    *dimensions_nonzero = qp.dimensions_nonzero;
+
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 // query entry point
 
@@ -3489,12 +4220,16 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
 
     query_progress_set_finish_line(qt->request.transaction, qt->query.used);
 
+    bool parallel = rrd2rrdr_query_parallel(r_tmp, &dimensions_used, &dimensions_nonzero);
+
     QUERY_ENGINE_OPS **ops = NULL;
-    if(qt->query.used)
+    if(qt->query.used && !parallel)
         ops = onewayalloc_callocz(owa, qt->query.used, sizeof(QUERY_ENGINE_OPS *));
 
     size_t capacity = libuv_worker_threads * 10;
     size_t max_queries_to_prepare = (qt->query.used > (capacity - 1)) ? (capacity - 1) : qt->query.used;
+    if(parallel)
+        max_queries_to_prepare = 0;
     size_t queries_prepared = 0;
     while(queries_prepared < max_queries_to_prepare) {
         // preload another query
@@ -3506,7 +4241,7 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
     usec_t last_ut = now_monotonic_usec();
     usec_t last_qn_ut = last_ut;
 
-    for(size_t d = 0; d < qt->query.used ; d++) {
+    for(size_t d = 0; !parallel && d < qt->query.used ; d++) {
         QUERY_METRIC *qm = query_metric(qt, d);
         QUERY_DIMENSION *qd = query_dimension(qt, qm->link.query_dimension_id);
         QUERY_INSTANCE *qi = query_instance(qt, qm->link.query_instance_id);
@@ -3564,31 +4299,10 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
             rrd2rrdr_query_ops_release(ops[d]); // reuse this ops allocation
             ops[d] = NULL;
 
-            qi->metrics.queried++;
-            qc->metrics.queried++;
-            qn->metrics.queried++;
-
-            qd->status |= QUERY_STATUS_QUERIED;
-            qm->status |= RRDR_DIMENSION_QUERIED;
-
-            if(qt->request.version >= 2) {
-                // we need to make the query points positive now
-                // since we will aggregate it across multiple dimensions
-                storage_point_make_positive(qm->query_points);
-                storage_point_merge_to(qi->query_points, qm->query_points);
-                storage_point_merge_to(qc->query_points, qm->query_points);
-                storage_point_merge_to(qn->query_points, qm->query_points);
-                storage_point_merge_to(qt->query_points, qm->query_points);
-            }
+            query_metric_queried(qt, qm, qd, qi, qc, qn);
         }
         else {
-            qi->metrics.failed++;
-            qc->metrics.failed++;
-            qn->metrics.failed++;
-
-            qd->status |= QUERY_STATUS_FAILED;
-            qm->status |= RRDR_DIMENSION_FAILED;
-
+            query_metric_failed(qm, qd, qi, qc, qn);
             continue;
         }
 
@@ -3717,7 +4431,7 @@ RRDR *rrd2rrdr(ONEWAYALLOC *owa, QUERY_TARGET *qt) {
 #endif
 
     // free the query pipelining ops
-    for(size_t d = 0; d < qt->query.used ; d++) {
+    for(size_t d = 0; ops && d < qt->query.used ; d++) {
         rrd2rrdr_query_ops_release(ops[d]);
         ops[d] = NULL;
     }
@@ -45,6 +45,9 @@ typedef enum rrdr_time_grouping {
     RRDR_GROUPING_SES,
     RRDR_GROUPING_DES,
     RRDR_GROUPING_COUNTIF,
+    RRDR_GROUPING_PERCENTILE_APPROX,
+    RRDR_GROUPING_MEDIAN_APPROX,
+    RRDR_GROUPING_LTTB,
 } RRDR_TIME_GROUPING;
 
 const char *time_grouping_id2txt(RRDR_TIME_GROUPING group);
@@ -88,6 +91,7 @@ typedef enum rrdr_group_by_function {
     RRDR_GROUP_BY_FUNCTION_MAX,
     RRDR_GROUP_BY_FUNCTION_SUM,
     RRDR_GROUP_BY_FUNCTION_PERCENTAGE,
+    RRDR_GROUP_BY_FUNCTION_MERGE,           // merges the sketches of percentile-approx and median-approx
 } RRDR_GROUP_BY_FUNCTION;
 
 RRDR_GROUP_BY_FUNCTION group_by_aggregate_function_parse(const char *s);
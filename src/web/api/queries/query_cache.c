@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "query_cache.h"
+#include "web/api/web_api_v1.h"
+
+// ----------------------------------------------------------------------------
+// query response cache
+//
+// Dashboards viewed by many users at once send the same queries again and
+// again. When a query resolves to exactly the same request and the same time
+// window as a previous one, we respond with the output generated for it,
+// for as long as the window would not have seen any new data (the view
+// update every of the query).
+//
+// The cache is a direct mapped array of slots, indexed by the hash of the
+// fingerprint of the query. Each slot keeps the full fingerprint, so that
+// hash collisions are never served.
+
+#define QUERY_CACHE_MAX_RESPONSE_SIZE (1 * 1024 * 1024)
+
+typedef struct query_cache_entry {
+    SPINLOCK spinlock;
+    uint64_t hash;
+    char *key;
+    time_t expires_s;
+    time_t latest_timestamp;
+    HTTP_CONTENT_TYPE content_type;
+    BUFFER_OPTIONS options;
+    size_t len;
+    char *data;
+} QUERY_CACHE_ENTRY;
+
+static struct {
+    size_t entries;
+    QUERY_CACHE_ENTRY *array;
+} query_cache = {
+    .entries = 0,
+    .array = NULL,
+};
+
+void query_cache_init(size_t entries) {
+    if(!entries || query_cache.array)
+        return;
+
+    query_cache.array = callocz(entries, sizeof(QUERY_CACHE_ENTRY));
+    for(size_t i = 0; i < entries ;i++)
+        spinlock_init(&query_cache.array[i].spinlock);
+
+    query_cache.entries = entries;
+}
+
+#define query_cache_str(s) ((s) ? (s) : "")
+
+static void query_cache_fingerprint(QUERY_TARGET *qt, BUFFER *key) {
+    QUERY_TARGET_REQUEST *qtr = &qt->request;
+
+    buffer_sprintf(key, "v%zu|%s|%s|%p|%p|%p|%p|%p|%s|%s|%s|%s|%s|%s|%s|f%u|o%"PRIu64"|t%zu|r%lld|g%u|%s",
+                   qtr->version,
+                   query_cache_str(qtr->scope_nodes), query_cache_str(qtr->scope_contexts),
+                   qtr->host, qtr->rca, qtr->ria, qtr->rma, qtr->st,
+                   query_cache_str(qtr->nodes), query_cache_str(qtr->contexts),
+                   query_cache_str(qtr->instances), query_cache_str(qtr->dimensions),
+                   query_cache_str(qtr->chart_label_key), query_cache_str(qtr->labels),
+                   query_cache_str(qtr->alerts),
+                   qtr->format, (uint64_t)qtr->options, qtr->tier,
+                   (long long)qtr->resampling_time,
+                   (unsigned)qtr->time_group_method, query_cache_str(qtr->time_group_options));
+
+    for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++) {
+        if(!qtr->group_by[g].group_by)
+            break;
+
+        buffer_sprintf(key, "|G%u:%s:%u",
+                       (unsigned)qtr->group_by[g].group_by,
+                       query_cache_str(qtr->group_by[g].group_by_label),
+                       (unsigned)qtr->group_by[g].aggregation);
+    }
+
+    // the resolved window, and the metrics it matched
+    buffer_sprintf(key, "|W%lld:%lld:%zu:%zu:%zu:%"PRIu64":%zu|M%u:%u:%u:%u",
+                   (long long)qt->window.after, (long long)qt->window.before,
+                   qt->window.points, qt->window.group, qt->window.resampling_group,
+                   (uint64_t)qt->window.options, qt->window.tier,
+                   qt->query.used, qt->instances.used, qt->contexts.used, qt->nodes.used);
+}
+
+static inline QUERY_CACHE_ENTRY *query_cache_slot(uint64_t hash) {
+    return &query_cache.array[hash % query_cache.entries];
+}
+
+bool query_cache_get(QUERY_TARGET *qt, BUFFER *wb, time_t *latest_timestamp) {
+    if(!query_cache.entries)
+        return false;
+
+    CLEAN_BUFFER *key = buffer_create(1024, NULL);
+    query_cache_fingerprint(qt, key);
+    uint64_t hash = XXH3_64bits(buffer_tostring(key), buffer_strlen(key));
+
+    QUERY_CACHE_ENTRY *qce = query_cache_slot(hash);
+    bool found = false;
+
+    spinlock_lock(&qce->spinlock);
+
+    if(qce->data && qce->hash == hash && qce->expires_s > now_realtime_sec() && strcmp(qce->key, buffer_tostring(key)) == 0) {
+        buffer_memcat(wb, qce->data, qce->len);
+        wb->content_type = qce->content_type;
+
+        if(qce->options & WB_CONTENT_CACHEABLE)
+            buffer_cacheable(wb);
+        else if(qce->options & WB_CONTENT_NO_CACHEABLE)
+            buffer_no_cacheable(wb);
+
+        if(latest_timestamp && qce->latest_timestamp)
+            *latest_timestamp = qce->latest_timestamp;
+
+        found = true;
+    }
+
+    spinlock_unlock(&qce->spinlock);
+
+    return found;
+}
+
+void query_cache_set(QUERY_TARGET *qt, BUFFER *wb, size_t offset, time_t latest_timestamp) {
+    if(!query_cache.entries || buffer_strlen(wb) < offset)
+        return;
+
+    size_t len = buffer_strlen(wb) - offset;
+    if(!len || len > QUERY_CACHE_MAX_RESPONSE_SIZE)
+        return;
+
+    CLEAN_BUFFER *key = buffer_create(1024, NULL);
+    query_cache_fingerprint(qt, key);
+    uint64_t hash = XXH3_64bits(buffer_tostring(key), buffer_strlen(key));
+
+    time_t update_every = query_view_update_every(qt);
+    if(update_every < 1)
+        update_every = 1;
+
+    // prepare everything outside the lock
+    char *k = strdupz(buffer_tostring(key));
+    char *data = mallocz(len);
+    memcpy(data, &wb->buffer[offset], len);
+
+    QUERY_CACHE_ENTRY *qce = query_cache_slot(hash);
+
+    spinlock_lock(&qce->spinlock);
+
+    char *old_key = qce->key;
+    char *old_data = qce->data;
+
+    qce->hash = hash;
+    qce->key = k;
+    qce->data = data;
+    qce->len = len;
+    qce->expires_s = now_realtime_sec() + update_every;
+    qce->latest_timestamp = latest_timestamp;
+    qce->content_type = wb->content_type;
+    qce->options = wb->options & (WB_CONTENT_CACHEABLE | WB_CONTENT_NO_CACHEABLE);
+
+    spinlock_unlock(&qce->spinlock);
+
+    freez(old_key);
+    freez(old_data);
+}
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_API_QUERY_CACHE_H
+#define NETDATA_API_QUERY_CACHE_H 1
+
+#include "libnetdata/libnetdata.h"
+
+struct query_target;
+
+// allocates the cache slots - 0 entries disables the cache
+void query_cache_init(size_t entries);
+
+// appends the cached response of this query to wb
+// returns true when the cache had a fresh response for it
+bool query_cache_get(struct query_target *qt, BUFFER *wb, time_t *latest_timestamp);
+
+// saves the response of this query, found in wb after the offset given
+void query_cache_set(struct query_target *qt, BUFFER *wb, size_t offset, time_t latest_timestamp);
+
+#endif //NETDATA_API_QUERY_CACHE_H
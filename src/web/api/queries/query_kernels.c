@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "query_kernels.h"
+
+// ----------------------------------------------------------------------------
+// time grouping kernels
+//
+// Each kernel works on QUERY_KERNEL_LANES independent accumulators, so that
+// the compiler can keep them in vector registers. When the compiler supports
+// it, each kernel is built multiple times for different CPU features (AVX2
+// and the default) and the best one for the running CPU is selected when
+// netdata starts.
+
+#define QUERY_KERNEL_LANES 8
+
+SIMD_CLONES
+NETDATA_DOUBLE query_kernel_sum(const NETDATA_DOUBLE *values, size_t n) {
+    NETDATA_DOUBLE lanes[QUERY_KERNEL_LANES] = { 0 };
+
+    size_t i = 0;
+    for(; i + QUERY_KERNEL_LANES <= n ; i += QUERY_KERNEL_LANES) {
+        for(size_t l = 0; l < QUERY_KERNEL_LANES ; l++)
+            lanes[l] += values[i + l];
+    }
+
+    NETDATA_DOUBLE sum = 0.0;
+    for(size_t l = 0; l < QUERY_KERNEL_LANES ; l++)
+        sum += lanes[l];
+
+    for(; i < n ; i++)
+        sum += values[i];
+
+    return sum;
+}
+
+// finds the index of the value with the smallest (or biggest) absolute value
+// every lane keeps its best absolute value and the index it was found at,
+// so that ties are resolved to the first index, like adding one value at a time
+static inline size_t query_kernel_abs_index(const NETDATA_DOUBLE *values, size_t n, bool min) {
+    NETDATA_DOUBLE best[QUERY_KERNEL_LANES];
+    size_t index[QUERY_KERNEL_LANES];
+
+    for(size_t l = 0; l < QUERY_KERNEL_LANES ; l++) {
+        best[l] = fabsndd(values[0]);
+        index[l] = 0;
+    }
+
+    size_t i = 0;
+    for(; i + QUERY_KERNEL_LANES <= n ; i += QUERY_KERNEL_LANES) {
+        for(size_t l = 0; l < QUERY_KERNEL_LANES ; l++) {
+            NETDATA_DOUBLE a = fabsndd(values[i + l]);
+            bool better = min ? (a < best[l]) : (a > best[l]);
+            best[l] = better ? a : best[l];
+            index[l] = better ? i + l : index[l];
+        }
+    }
+
+    size_t found = 0;
+    NETDATA_DOUBLE found_abs = fabsndd(values[0]);
+    for(size_t l = 0; l < QUERY_KERNEL_LANES ; l++) {
+        bool better = min ? (best[l] < found_abs) : (best[l] > found_abs);
+        if(better || (best[l] == found_abs && index[l] < found)) {
+            found_abs = best[l];
+            found = index[l];
+        }
+    }
+
+    for(; i < n ; i++) {
+        NETDATA_DOUBLE a = fabsndd(values[i]);
+        if(min ? (a < found_abs) : (a > found_abs)) {
+            found_abs = a;
+            found = i;
+        }
+    }
+
+    return found;
+}
+
+SIMD_CLONES
+NETDATA_DOUBLE query_kernel_min_abs(const NETDATA_DOUBLE *values, size_t n) {
+    return values[query_kernel_abs_index(values, n, true)];
+}
+
+SIMD_CLONES
+NETDATA_DOUBLE query_kernel_max_abs(const NETDATA_DOUBLE *values, size_t n) {
+    return values[query_kernel_abs_index(values, n, false)];
+}
+
+// two passes over the values - they are few and in the CPU cache
+SIMD_CLONES
+void query_kernel_mean_m2(const NETDATA_DOUBLE *values, size_t n, NETDATA_DOUBLE *mean, NETDATA_DOUBLE *m2) {
+    NETDATA_DOUBLE avg = query_kernel_sum(values, n) / (NETDATA_DOUBLE)n;
+
+    NETDATA_DOUBLE lanes[QUERY_KERNEL_LANES] = { 0 };
+
+    size_t i = 0;
+    for(; i + QUERY_KERNEL_LANES <= n ; i += QUERY_KERNEL_LANES) {
+        for(size_t l = 0; l < QUERY_KERNEL_LANES ; l++) {
+            NETDATA_DOUBLE d = values[i + l] - avg;
+            lanes[l] += d * d;
+        }
+    }
+
+    NETDATA_DOUBLE sum = 0.0;
+    for(size_t l = 0; l < QUERY_KERNEL_LANES ; l++)
+        sum += lanes[l];
+
+    for(; i < n ; i++) {
+        NETDATA_DOUBLE d = values[i] - avg;
+        sum += d * d;
+    }
+
+    *mean = avg;
+    *m2 = sum;
+}
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_API_QUERY_KERNELS_H
+#define NETDATA_API_QUERY_KERNELS_H 1
+
+#include "libnetdata/libnetdata.h"
+
+// the kernels time groupings use to add many values at once
+// all of them expect values that are numbers (no NaN, no infinity)
+
+// the sum of the values
+NETDATA_DOUBLE query_kernel_sum(const NETDATA_DOUBLE *values, size_t n);
+
+// the value with the smallest / biggest absolute value - the first one, on ties
+// n has to be at least 1
+NETDATA_DOUBLE query_kernel_min_abs(const NETDATA_DOUBLE *values, size_t n);
+NETDATA_DOUBLE query_kernel_max_abs(const NETDATA_DOUBLE *values, size_t n);
+
+// the mean of the values, and the sum of the squared differences from it
+// n has to be at least 1
+void query_kernel_mean_m2(const NETDATA_DOUBLE *values, size_t n, NETDATA_DOUBLE *mean, NETDATA_DOUBLE *m2);
+
+#endif //NETDATA_API_QUERY_KERNELS_H
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "query_threads.h"
+
+// ----------------------------------------------------------------------------
+// query threads
+//
+// A small pool of threads, helping the web server threads execute queries
+// with many metrics. The thread running the query posts one task per helper
+// it wants and works on the query itself. When it runs out of work, it
+// takes back the tasks no helper has picked up yet, and waits only for the
+// helpers that are still running.
+
+#define QUERY_THREADS_MAX 64
+
+typedef enum {
+    QUERY_THREADS_TASK_QUEUED = 0,
+    QUERY_THREADS_TASK_RUNNING,
+    QUERY_THREADS_TASK_DONE,
+} QUERY_THREADS_TASK_STATE;
+
+struct query_threads_task {
+    query_threads_cb_t cb;
+    void *data;
+    QUERY_THREADS_TASK_STATE state;
+    struct query_threads_task *prev, *next;
+};
+
+static struct {
+    size_t threads;
+    bool exit;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                // signals the query threads there are tasks
+    pthread_cond_t done;                // signals the callers that a task finished
+
+    struct query_threads_task *queue;
+} query_threads = {
+    .threads = 0,
+    .exit = false,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .queue = NULL,
+};
+
+static void query_threads_canceller(void *data __maybe_unused) {
+    pthread_mutex_lock(&query_threads.mutex);
+    query_threads.exit = true;
+    pthread_cond_broadcast(&query_threads.cond);
+    pthread_mutex_unlock(&query_threads.mutex);
+}
+
+static void *query_threads_main(void *arg __maybe_unused) {
+    worker_register("QUERY");
+    worker_register_job_name(0, "query");
+
+    nd_thread_register_canceller(query_threads_canceller, NULL);
+
+    pthread_mutex_lock(&query_threads.mutex);
+
+    while(true) {
+        while(!query_threads.queue && !query_threads.exit && !nd_thread_signaled_to_cancel())
+            pthread_cond_wait(&query_threads.cond, &query_threads.mutex);
+
+        if(query_threads.exit || nd_thread_signaled_to_cancel())
+            break;
+
+        struct query_threads_task *t = query_threads.queue;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(query_threads.queue, t, prev, next);
+        t->state = QUERY_THREADS_TASK_RUNNING;
+
+        pthread_mutex_unlock(&query_threads.mutex);
+
+        worker_is_busy(0);
+        t->cb(t->data);
+        worker_is_idle();
+
+        pthread_mutex_lock(&query_threads.mutex);
+        t->state = QUERY_THREADS_TASK_DONE;
+        pthread_cond_broadcast(&query_threads.done);
+    }
+
+    pthread_mutex_unlock(&query_threads.mutex);
+
+    worker_unregister();
+    return NULL;
+}
+
+void query_threads_init(size_t threads) {
+    if(query_threads.threads || !threads)
+        return;
+
+    if(threads > QUERY_THREADS_MAX)
+        threads = QUERY_THREADS_MAX;
+
+    for(size_t i = 0; i < threads ;i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "QUERY[%zu]", i);
+
+        if(nd_thread_create(tag, NETDATA_THREAD_OPTION_DEFAULT, query_threads_main, NULL))
+            query_threads.threads++;
+    }
+
+    netdata_log_info("QUERY: started %zu query threads", query_threads.threads);
+}
+
+size_t query_threads_available(void) {
+    return query_threads.threads;
+}
+
+void query_threads_run(query_threads_cb_t cb, void *data, size_t helpers) {
+    if(helpers > query_threads.threads)
+        helpers = query_threads.threads;
+
+    struct query_threads_task tasks[QUERY_THREADS_MAX];
+
+    if(helpers) {
+        pthread_mutex_lock(&query_threads.mutex);
+        for(size_t i = 0; i < helpers; i++) {
+            tasks[i] = (struct query_threads_task) {
+                .cb = cb,
+                .data = data,
+                .state = QUERY_THREADS_TASK_QUEUED,
+            };
+            DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(query_threads.queue, &tasks[i], prev, next);
+        }
+        pthread_cond_broadcast(&query_threads.cond);
+        pthread_mutex_unlock(&query_threads.mutex);
+    }
+
+    cb(data);
+
+    if(helpers) {
+        pthread_mutex_lock(&query_threads.mutex);
+
+        // take back the tasks nobody picked up
+        for(size_t i = 0; i < helpers; i++) {
+            if(tasks[i].state == QUERY_THREADS_TASK_QUEUED) {
+                DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(query_threads.queue, &tasks[i], prev, next);
+                tasks[i].state = QUERY_THREADS_TASK_DONE;
+            }
+        }
+
+        // wait for the running ones to finish
+        for(size_t i = 0; i < helpers; i++) {
+            while(tasks[i].state != QUERY_THREADS_TASK_DONE)
+                pthread_cond_wait(&query_threads.done, &query_threads.mutex);
+        }
+
+        pthread_mutex_unlock(&query_threads.mutex);
+    }
+}
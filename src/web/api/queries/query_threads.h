@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_API_QUERY_THREADS_H
+#define NETDATA_API_QUERY_THREADS_H 1
+
+#include "libnetdata/libnetdata.h"
+
+typedef void (*query_threads_cb_t)(void *data);
+
+// starts the query threads - 0 threads disables parallel queries
+void query_threads_init(size_t threads);
+
+// the number of threads available to help queries
+size_t query_threads_available(void);
+
+// runs cb(data) on the calling thread and on up to 'helpers' query threads
+// cb has to split the work itself, so that it returns when there is no more
+// work to do; returns when all the threads that started running cb returned
+void query_threads_run(query_threads_cb_t cb, void *data, size_t helpers);
+
+#endif //NETDATA_API_QUERY_THREADS_H
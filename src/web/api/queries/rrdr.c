@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "rrdr.h"
+#include "percentile_approx/percentile_approx.h"
 
 /*
 static void rrdr_dump(RRDR *r)
@@ -83,6 +84,13 @@ inline void rrdr_free(ONEWAYALLOC *owa, RRDR *r) {
     onewayalloc_freez(owa, r->ar);
     onewayalloc_freez(owa, r->gbc);
     onewayalloc_freez(owa, r->dgbc);
+
+    if(r->sk) {
+        for(size_t i = 0; i < r->n * r->d ;i++)
+            ddsketch_free(&r->sk[i]);
+
+        onewayalloc_freez(owa, r->sk);
+    }
     onewayalloc_freez(owa, r->dgbs);
 
     if(r->dl) {
@@ -75,6 +75,7 @@ typedef struct rrdresult {
     RRDR_VALUE_FLAGS *o;      // array n x d options for each value returned
     NETDATA_DOUBLE *ar;       // array n x d of anomaly rates (0 - 100)
     uint32_t *gbc;            // array n x d of group by count - NOT ALLOCATED when RRDR is created
+    struct ddsketch *sk;      // array n x d of sketches, when group by merges them - NOT ALLOCATED when RRDR is created
 
     struct {
         size_t group;         // how many collected values were grouped for each row - NEEDED BY GROUPING FUNCTIONS
@@ -124,6 +125,7 @@ typedef struct rrdresult {
         struct query_target *qt;    // the QUERY_TARGET
         size_t contexts;            // temp needed between json_wrapper_begin2() and json_wrapper_end2()
         size_t queries_count;       // temp needed to know if a query is the first executed
+        size_t flushes;             // the times the output was given to the flush callback of the query
 
 #ifdef NETDATA_INTERNAL_CHECKS
         const char *log;
@@ -150,6 +152,9 @@ RRDR *rrd2rrdr_legacy(
         STORAGE_PRIORITY priority);
 
 RRDR *rrd2rrdr(ONEWAYALLOC *owa, struct query_target *qt);
+
+// how long the prefetches of the neighboring windows of queries may wait to be loaded - 0 disables them
+extern time_t query_prefetch_timeout_ms;
 bool query_target_calculate_window(struct query_target *qt);
 
 #ifdef __cplusplus
@@ -5,6 +5,7 @@
 
 #include "../query.h"
 #include "../rrdr.h"
+#include "../query_kernels.h"
 
 // this implementation comes from:
 // https://www.johndcook.com/blog/standard_deviation/
@@ -50,6 +51,31 @@ static inline void tg_stddev_add(RRDR *r, NETDATA_DOUBLE value) {
     }
 }
 
+// merges the mean and the squared differences of a batch of values
+// into the running ones (Chan et al., the parallel variant of the above)
+static inline void tg_stddev_add_batch(RRDR *r, const NETDATA_DOUBLE *values, size_t n) {
+    struct tg_stddev *g = (struct tg_stddev *)r->time_grouping.data;
+
+    if(!n)
+        return;
+
+    NETDATA_DOUBLE mean, m2;
+    query_kernel_mean_m2(values, n, &mean, &m2);
+
+    if(g->count) {
+        NETDATA_DOUBLE count = (NETDATA_DOUBLE)g->count;
+        NETDATA_DOUBLE total = count + (NETDATA_DOUBLE)n;
+        NETDATA_DOUBLE delta = mean - g->m_oldM;
+
+        mean = g->m_oldM + delta * (NETDATA_DOUBLE)n / total;
+        m2 = g->m_oldS + m2 + delta * delta * count * (NETDATA_DOUBLE)n / total;
+    }
+
+    g->count += (long)n;
+    g->m_oldM = g->m_newM = mean;
+    g->m_oldS = g->m_newS = m2;
+}
+
 static inline NETDATA_DOUBLE tg_stddev_mean(struct tg_stddev *g) {
     return (g->count > 0) ? g->m_newM : 0.0;
 }
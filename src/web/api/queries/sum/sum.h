@@ -5,6 +5,7 @@
 
 #include "../query.h"
 #include "../rrdr.h"
+#include "../query_kernels.h"
 
 struct tg_sum {
     NETDATA_DOUBLE sum;
@@ -34,6 +35,12 @@ static inline void tg_sum_add(RRDR *r, NETDATA_DOUBLE value) {
     g->count++;
 }
 
+static inline void tg_sum_add_batch(RRDR *r, const NETDATA_DOUBLE *values, size_t n) {
+    struct tg_sum *g = (struct tg_sum *)r->time_grouping.data;
+    g->sum += query_kernel_sum(values, n);
+    g->count += n;
+}
+
 static inline NETDATA_DOUBLE tg_sum_flush(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct tg_sum *g = (struct tg_sum *)r->time_grouping.data;
 
@@ -2,8 +2,13 @@
 
 #include "daemon/common.h"
 #include "database/KolmogorovSmirnovDist.h"
+#include "query_threads.h"
+#include "database/contexts/internal.h"
 
 #define MAX_POINTS 10000
+
+// requests with at least this many metrics are executed in parallel
+#define WEIGHTS_PARALLEL_MIN_METRICS 50
 int metric_correlations_version = 1;
 
 typedef struct weights_stats {
@@ -13,6 +18,7 @@ typedef struct weights_stats {
     size_t db_queries;
     size_t db_points_per_tier[RRD_STORAGE_TIERS];
     size_t binary_searches;
+    size_t baseline_cache_hits;
 } WEIGHTS_STATS;
 
 // ----------------------------------------------------------------------------
@@ -65,8 +71,8 @@ struct register_result {
     usec_t duration_ut;
 };
 
-static DICTIONARY *register_result_init() {
-    DICTIONARY *results = dictionary_create_advanced(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_FIXED_SIZE, NULL, sizeof(struct register_result));
+static DICTIONARY *register_result_init(bool parallel) {
+    DICTIONARY *results = dictionary_create_advanced((parallel ? DICT_OPTION_NONE : DICT_OPTION_SINGLE_THREADED) | DICT_OPTION_FIXED_SIZE, NULL, sizeof(struct register_result));
     return results;
 }
 
@@ -123,7 +129,7 @@ static void results_header_to_json(DICTIONARY *results __maybe_unused, BUFFER *w
                                    size_t points, WEIGHTS_METHOD method,
                                    RRDR_TIME_GROUPING group, RRDR_OPTIONS options, uint32_t shifts,
                                    size_t examined_dimensions __maybe_unused, usec_t duration,
-                                   WEIGHTS_STATS *stats) {
+                                   WEIGHTS_STATS *stats, bool partial) {
 
     buffer_json_member_add_time_t(wb, "after", after);
     buffer_json_member_add_time_t(wb, "before", before);
@@ -143,6 +149,7 @@ static void results_header_to_json(DICTIONARY *results __maybe_unused, BUFFER *w
         buffer_json_member_add_uint64(wb, "db_queries", stats->db_queries);
         buffer_json_member_add_uint64(wb, "query_result_points", stats->result_points);
         buffer_json_member_add_uint64(wb, "binary_searches", stats->binary_searches);
+        buffer_json_member_add_uint64(wb, "baseline_cache_hits", stats->baseline_cache_hits);
         buffer_json_member_add_uint64(wb, "db_points_read", stats->db_points);
 
         buffer_json_member_add_array(wb, "db_points_per_tier");
@@ -157,6 +164,9 @@ static void results_header_to_json(DICTIONARY *results __maybe_unused, BUFFER *w
     buffer_json_member_add_string(wb, "group", time_grouping_tostring(group));
     buffer_json_member_add_string(wb, "method", weights_method_to_string(method));
     rrdr_options_to_buffer_json_array(wb, "options", options);
+
+    if(partial)
+        buffer_json_member_add_boolean(wb, "partial", true);
 }
 
 static size_t registered_results_to_json_charts(DICTIONARY *results, BUFFER *wb,
@@ -165,12 +175,12 @@ static size_t registered_results_to_json_charts(DICTIONARY *results, BUFFER *wb,
                                                 size_t points, WEIGHTS_METHOD method,
                                                 RRDR_TIME_GROUPING group, RRDR_OPTIONS options, uint32_t shifts,
                                                 size_t examined_dimensions, usec_t duration,
-                                                WEIGHTS_STATS *stats) {
+                                                WEIGHTS_STATS *stats, bool partial) {
 
     buffer_json_initialize(wb, "\"", "\"", 0, true, (options & RRDR_OPTION_MINIFY) ? BUFFER_JSON_OPTIONS_MINIFY : BUFFER_JSON_OPTIONS_DEFAULT);
 
     results_header_to_json(results, wb, after, before, baseline_after, baseline_before,
-                           points, method, group, options, shifts, examined_dimensions, duration, stats);
+                           points, method, group, options, shifts, examined_dimensions, duration, stats, partial);
 
     buffer_json_member_add_object(wb, "correlated_charts");
 
@@ -217,12 +227,12 @@ static size_t registered_results_to_json_contexts(DICTIONARY *results, BUFFER *w
                                                   size_t points, WEIGHTS_METHOD method,
                                                   RRDR_TIME_GROUPING group, RRDR_OPTIONS options, uint32_t shifts,
                                                   size_t examined_dimensions, usec_t duration,
-                                                  WEIGHTS_STATS *stats) {
+                                                  WEIGHTS_STATS *stats, bool partial) {
 
     buffer_json_initialize(wb, "\"", "\"", 0, true, (options & RRDR_OPTION_MINIFY) ? BUFFER_JSON_OPTIONS_MINIFY : BUFFER_JSON_OPTIONS_DEFAULT);
 
     results_header_to_json(results, wb, after, before, baseline_after, baseline_before,
-                           points, method, group, options, shifts, examined_dimensions, duration, stats);
+                           points, method, group, options, shifts, examined_dimensions, duration, stats, partial);
 
     buffer_json_member_add_object(wb, "contexts");
 
@@ -301,6 +311,13 @@ static size_t registered_results_to_json_contexts(DICTIONARY *results, BUFFER *w
     return total_dimensions;
 }
 
+struct weights_metric {
+    RRDHOST *host;
+    RRDCONTEXT_ACQUIRED *rca;
+    RRDINSTANCE_ACQUIRED *ria;
+    RRDMETRIC_ACQUIRED *rma;
+};
+
 struct query_weights_data {
     QUERY_WEIGHTS_REQUEST *qwr;
 
@@ -319,6 +336,16 @@ struct query_weights_data {
 
     struct query_timings timings;
 
+    struct {
+        bool enabled;                   // the metrics are collected first, and queried in parallel
+        pid_t caller_tid;               // only the caller checks the interrupt callback
+        size_t next;                    // the next metric to be queried
+        size_t used;
+        size_t size;
+        struct weights_metric *array;
+        SPINLOCK spinlock;              // protects the statistics while merging them
+    } parallel;
+
     size_t examined_dimensions;
     bool register_zero;
 
@@ -432,6 +459,9 @@ static void results_header_to_json_v2(DICTIONARY *results __maybe_unused, BUFFER
     buffer_json_member_add_string(wb, "format", (group_by)?"grouped":"full");
     buffer_json_member_add_string(wb, "time_group", time_grouping_tostring(group));
 
+    if(qwd->timed_out)
+        buffer_json_member_add_boolean(wb, "partial", true);
+
     buffer_json_member_add_object(wb, "window");
     buffer_json_member_add_time_t(wb, "after", after);
     buffer_json_member_add_time_t(wb, "before", before);
@@ -455,6 +485,7 @@ static void results_header_to_json_v2(DICTIONARY *results __maybe_unused, BUFFER
         buffer_json_member_add_uint64(wb, "db_queries", stats->db_queries);
         buffer_json_member_add_uint64(wb, "query_result_points", stats->result_points);
         buffer_json_member_add_uint64(wb, "binary_searches", stats->binary_searches);
+        buffer_json_member_add_uint64(wb, "baseline_cache_hits", stats->baseline_cache_hits);
         buffer_json_member_add_uint64(wb, "db_points_read", stats->db_points);
 
         buffer_json_member_add_array(wb, "db_points_per_tier");
@@ -1087,24 +1118,6 @@ static size_t registered_results_to_json_multinode_group_by(
 typedef long int DIFFS_NUMBERS;
 #define DOUBLE_TO_INT_MULTIPLIER 100000
 
-static inline int binary_search_bigger_than(const DIFFS_NUMBERS arr[], int left, int size, DIFFS_NUMBERS K) {
-    // binary search to find the index the smallest index
-    // of the first value in the array that is greater than K
-
-    int right = size;
-    while(left < right) {
-        int middle = (int)(((unsigned int)(left + right)) >> 1);
-
-        if(arr[middle] > K)
-            right = middle;
-
-        else
-            left = middle + 1;
-    }
-
-    return left;
-}
-
 int compare_diffs(const void *left, const void *right) {
     DIFFS_NUMBERS lt = *(DIFFS_NUMBERS *)left;
     DIFFS_NUMBERS rt = *(DIFFS_NUMBERS *)right;
@@ -1127,13 +1140,33 @@ static size_t calculate_pairs_diff(DIFFS_NUMBERS *diffs, NETDATA_DOUBLE *arr, si
     return added;
 }
 
-static double ks_2samp(
-        DIFFS_NUMBERS baseline_diffs[], int base_size,
-        DIFFS_NUMBERS highlight_diffs[], int high_size,
-        uint32_t base_shifts) {
+// advances idx to the index of the first value in the sorted array that is greater than K
+static inline int index_bigger_than(const DIFFS_NUMBERS arr[], int idx, int size, DIFFS_NUMBERS K) {
+    while(idx < size && arr[idx] <= K)
+        idx++;
 
-    qsort(baseline_diffs, base_size, sizeof(DIFFS_NUMBERS), compare_diffs);
-    qsort(highlight_diffs, high_size, sizeof(DIFFS_NUMBERS), compare_diffs);
+    return idx;
+}
+
+#define ks_2samp_delta_min_max() do {           \
+        delta = base_idx - (high_idx << base_shifts); \
+        if(delta < min) {                       \
+            min = delta;                        \
+            base_min_idx = base_idx;            \
+            high_min_idx = high_idx;            \
+        }                                       \
+        else if(delta > max) {                  \
+            max = delta;                        \
+            base_max_idx = base_idx;            \
+            high_max_idx = high_idx;            \
+        }                                       \
+} while(0)
+
+// both arrays have to be sorted
+static double ks_2samp_sorted(
+        const DIFFS_NUMBERS baseline_diffs[], int base_size,
+        const DIFFS_NUMBERS highlight_diffs[], int high_size,
+        uint32_t base_shifts) {
 
     // Now we should be calculating this:
     //
@@ -1144,25 +1177,28 @@ static double ks_2samp(
     //
     // It should look like this:
     //
-    // base_pcent = binary_search_bigger_than(...) / base_size;
-    // high_pcent = binary_search_bigger_than(...) / high_size;
+    // base_pcent = index_bigger_than(...) / base_size;
+    // high_pcent = index_bigger_than(...) / high_size;
     // delta = base_pcent - high_pcent;
     // if(delta < min) min = delta;
     // if(delta > max) max = delta;
     //
     // This would require a lot of multiplications and divisions.
     //
-    // To speed it up, we do the binary search to find the index of each number
-    // but, then we divide the base index by the power of two number (shifts) it
-    // is bigger than high index. So the 2 indexes are now comparable.
+    // To speed it up, we find the index of each number, but then we divide
+    // the base index by the power of two number (shifts) it is bigger than
+    // high index. So the 2 indexes are now comparable.
     // We also keep track of the original indexes with min and max, to properly
     // calculate their percentages once the loops finish.
-
+    //
+    // Since both arrays are sorted and we walk them in order, the indexes
+    // only move forward, so instead of binary searching every number, we
+    // advance the indexes of the previous number. This makes it linear.
 
     // initialize min and max using the first number of baseline_diffs
     DIFFS_NUMBERS K = baseline_diffs[0];
-    int base_idx = binary_search_bigger_than(baseline_diffs, 1, base_size, K);
-    int high_idx = binary_search_bigger_than(highlight_diffs, 0, high_size, K);
+    int base_idx = index_bigger_than(baseline_diffs, 1, base_size, K);
+    int high_idx = index_bigger_than(highlight_diffs, 0, high_size, K);
     int delta = base_idx - (high_idx << base_shifts);
     int min = delta, max = delta;
     int base_min_idx = base_idx;
@@ -1173,39 +1209,19 @@ static double ks_2samp(
     // do the baseline_diffs starting from 1 (we did position 0 above)
     for(int i = 1; i < base_size; i++) {
         K = baseline_diffs[i];
-        base_idx = binary_search_bigger_than(baseline_diffs, i + 1, base_size, K); // starting from i, since data1 is sorted
-        high_idx = binary_search_bigger_than(highlight_diffs, 0, high_size, K);
-
-        delta = base_idx - (high_idx << base_shifts);
-        if(delta < min) {
-            min = delta;
-            base_min_idx = base_idx;
-            high_min_idx = high_idx;
-        }
-        else if(delta > max) {
-            max = delta;
-            base_max_idx = base_idx;
-            high_max_idx = high_idx;
-        }
+        base_idx = index_bigger_than(baseline_diffs, MAX(base_idx, i + 1), base_size, K);
+        high_idx = index_bigger_than(highlight_diffs, high_idx, high_size, K);
+        ks_2samp_delta_min_max();
     }
 
     // do the highlight_diffs starting from 0
+    base_idx = 0;
+    high_idx = 0;
     for(int i = 0; i < high_size; i++) {
         K = highlight_diffs[i];
-        base_idx = binary_search_bigger_than(baseline_diffs, 0, base_size, K);
-        high_idx = binary_search_bigger_than(highlight_diffs, i + 1, high_size, K); // starting from i, since data2 is sorted
-
-        delta = base_idx - (high_idx << base_shifts);
-        if(delta < min) {
-            min = delta;
-            base_min_idx = base_idx;
-            high_min_idx = high_idx;
-        }
-        else if(delta > max) {
-            max = delta;
-            base_max_idx = base_idx;
-            high_max_idx = high_idx;
-        }
+        base_idx = index_bigger_than(baseline_diffs, base_idx, base_size, K);
+        high_idx = index_bigger_than(highlight_diffs, MAX(high_idx, i + 1), high_size, K);
+        ks_2samp_delta_min_max();
     }
 
     // now we have the min, max and their indexes
@@ -1232,27 +1248,180 @@ static double ks_2samp(
     return KSfbar((int)en, d);
 }
 
-static double kstwo(
-    NETDATA_DOUBLE baseline[], int baseline_points,
-    NETDATA_DOUBLE highlight[], int highlight_points,
-    uint32_t base_shifts) {
+static double ks_2samp(
+        DIFFS_NUMBERS baseline_diffs[], int base_size,
+        DIFFS_NUMBERS highlight_diffs[], int high_size,
+        uint32_t base_shifts) {
+
+    qsort(baseline_diffs, base_size, sizeof(DIFFS_NUMBERS), compare_diffs);
+    qsort(highlight_diffs, high_size, sizeof(DIFFS_NUMBERS), compare_diffs);
+
+    return ks_2samp_sorted(baseline_diffs, base_size, highlight_diffs, high_size, base_shifts);
+}
 
+// returns the sorted diffs of the points given, allocated with owa
+static DIFFS_NUMBERS *kstwo_sorted_diffs(ONEWAYALLOC *owa, NETDATA_DOUBLE *points, size_t entries, int *size) {
     // -1 in size, since the calculate_pairs_diffs() returns one less point
-    DIFFS_NUMBERS baseline_diffs[baseline_points - 1];
-    DIFFS_NUMBERS highlight_diffs[highlight_points - 1];
+    DIFFS_NUMBERS *diffs = onewayalloc_mallocz(owa, (entries - 1) * sizeof(DIFFS_NUMBERS));
 
-    int base_size = (int)calculate_pairs_diff(baseline_diffs, baseline, baseline_points);
-    int high_size = (int)calculate_pairs_diff(highlight_diffs, highlight, highlight_points);
+    size_t added = calculate_pairs_diff(diffs, points, entries);
+    if(unlikely(added != entries - 1)) {
+        netdata_log_error("Metric correlations: internal error - calculate_pairs_diff() returns the wrong number of entries");
+        *size = 0;
+        return diffs;
+    }
 
-    if(unlikely(!base_size || !high_size))
-        return NAN;
+    qsort(diffs, added, sizeof(DIFFS_NUMBERS), compare_diffs);
+    *size = (int)added;
+    return diffs;
+}
 
-    if(unlikely(base_size != baseline_points - 1 || high_size != highlight_points - 1)) {
-        netdata_log_error("Metric correlations: internal error - calculate_pairs_diff() returns the wrong number of entries");
-        return NAN;
+// ----------------------------------------------------------------------------
+// KS2 baseline cache
+//
+// The correlation requests of an investigation usually compare different
+// highlighted windows against the same baseline window. So, we keep the
+// sorted diffs of the baseline of each metric for a while, and these
+// requests query and sort only their highlighted window. Every hit extends
+// the life of the entry, so it lives for as long as the investigation is
+// active.
+
+time_t weights_baseline_cache_ttl_s = 600;
+size_t weights_baseline_cache_max_size = 128 * 1024 * 1024;
+
+#define KS2_BASELINE_CACHE_CLEANUP_EVERY_S 60
+
+struct ks2_baseline {
+    time_t expires_s;
+    int size;
+    DIFFS_NUMBERS *diffs;
+    STORAGE_POINT sp;
+};
+
+static struct {
+    SPINLOCK spinlock;                  // protects the creation of the dictionary
+    DICTIONARY *dict;
+    size_t size;                        // the memory used by the diffs
+    time_t last_cleanup_s;
+} ks2_baseline_cache = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .dict = NULL,
+    .size = 0,
+    .last_cleanup_s = 0,
+};
+
+static void ks2_baseline_delete_cb(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused) {
+    struct ks2_baseline *b = value;
+    __atomic_sub_fetch(&ks2_baseline_cache.size, b->size * sizeof(DIFFS_NUMBERS), __ATOMIC_RELAXED);
+    freez(b->diffs);
+}
+
+static bool ks2_baseline_conflict_cb(const DICTIONARY_ITEM *item __maybe_unused, void *old_value __maybe_unused, void *new_value, void *data __maybe_unused) {
+    // another thread added it in the meantime
+    struct ks2_baseline *b = new_value;
+    __atomic_sub_fetch(&ks2_baseline_cache.size, b->size * sizeof(DIFFS_NUMBERS), __ATOMIC_RELAXED);
+    freez(b->diffs);
+    return false;
+}
+
+static DICTIONARY *ks2_baseline_cache_dict(void) {
+    DICTIONARY *dict = __atomic_load_n(&ks2_baseline_cache.dict, __ATOMIC_ACQUIRE);
+    if(likely(dict))
+        return dict;
+
+    spinlock_lock(&ks2_baseline_cache.spinlock);
+    if(!ks2_baseline_cache.dict) {
+        dict = dictionary_create_advanced(DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE, NULL, sizeof(struct ks2_baseline));
+        dictionary_register_delete_callback(dict, ks2_baseline_delete_cb, NULL);
+        dictionary_register_conflict_callback(dict, ks2_baseline_conflict_cb, NULL);
+        __atomic_store_n(&ks2_baseline_cache.dict, dict, __ATOMIC_RELEASE);
     }
+    dict = ks2_baseline_cache.dict;
+    spinlock_unlock(&ks2_baseline_cache.spinlock);
 
-    return ks_2samp(baseline_diffs, base_size, highlight_diffs, high_size, base_shifts);
+    return dict;
+}
+
+static void ks2_baseline_cache_cleanup(void) {
+    DICTIONARY *dict = __atomic_load_n(&ks2_baseline_cache.dict, __ATOMIC_ACQUIRE);
+    if(!dict)
+        return;
+
+    time_t now_s = now_realtime_sec();
+    time_t last_s = __atomic_load_n(&ks2_baseline_cache.last_cleanup_s, __ATOMIC_RELAXED);
+    if(now_s - last_s < KS2_BASELINE_CACHE_CLEANUP_EVERY_S ||
+       !__atomic_compare_exchange_n(&ks2_baseline_cache.last_cleanup_s, &last_s, now_s, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        return;
+
+    struct ks2_baseline *b;
+    dfe_start_write(dict, b) {
+        if(__atomic_load_n(&b->expires_s, __ATOMIC_RELAXED) < now_s)
+            dictionary_del(dict, b_dfe.name);
+    }
+    dfe_done(b);
+
+    dictionary_garbage_collect(dict);
+}
+
+static void ks2_baseline_cache_key(char *dst, size_t dst_size,
+                                   RRDHOST *host, RRDCONTEXT_ACQUIRED *rca, RRDINSTANCE_ACQUIRED *ria,
+                                   RRDMETRIC_ACQUIRED *rma, time_t after, time_t before, size_t points,
+                                   RRDR_OPTIONS options, RRDR_TIME_GROUPING time_group_method,
+                                   const char *time_group_options, size_t tier) {
+    snprintfz(dst, dst_size - 1, "%s|%s|%s|%s|%lld|%lld|%zu|%"PRIx64"|%u|%s|%zu",
+              host->machine_guid, rrdcontext_acquired_id(rca), rrdinstance_acquired_id(ria), rrdmetric_acquired_id(rma),
+              (long long)after, (long long)before, points, (uint64_t)options, (unsigned)time_group_method,
+              time_group_options ? time_group_options : "", tier);
+}
+
+// returns an acquired item, or NULL when the baseline is not cached
+static const DICTIONARY_ITEM *ks2_baseline_cache_get(const char *key) {
+    if(!weights_baseline_cache_ttl_s)
+        return NULL;
+
+    DICTIONARY *dict = __atomic_load_n(&ks2_baseline_cache.dict, __ATOMIC_ACQUIRE);
+    if(!dict)
+        return NULL;
+
+    const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(dict, key);
+    if(!item)
+        return NULL;
+
+    struct ks2_baseline *b = dictionary_acquired_item_value(item);
+    time_t now_s = now_realtime_sec();
+    if(__atomic_load_n(&b->expires_s, __ATOMIC_RELAXED) < now_s) {
+        dictionary_acquired_item_release(dict, item);
+        return NULL;
+    }
+
+    __atomic_store_n(&b->expires_s, now_s + weights_baseline_cache_ttl_s, __ATOMIC_RELAXED);
+    return item;
+}
+
+static void ks2_baseline_cache_release(const DICTIONARY_ITEM *item) {
+    dictionary_acquired_item_release(ks2_baseline_cache.dict, item);
+}
+
+static void ks2_baseline_cache_set(const char *key, const DIFFS_NUMBERS *diffs, int size, STORAGE_POINT *sp) {
+    if(!weights_baseline_cache_ttl_s || size <= 0)
+        return;
+
+    size_t bytes = size * sizeof(DIFFS_NUMBERS);
+    if(__atomic_add_fetch(&ks2_baseline_cache.size, bytes, __ATOMIC_RELAXED) > weights_baseline_cache_max_size) {
+        // the cache is full, until its entries expire
+        __atomic_sub_fetch(&ks2_baseline_cache.size, bytes, __ATOMIC_RELAXED);
+        return;
+    }
+
+    struct ks2_baseline b = {
+        .expires_s = now_realtime_sec() + weights_baseline_cache_ttl_s,
+        .size = size,
+        .diffs = mallocz(bytes),
+        .sp = *sp,
+    };
+    memcpy(b.diffs, diffs, bytes);
+
+    dictionary_set(ks2_baseline_cache_dict(), key, &b, sizeof(b));
 }
 
 NETDATA_DOUBLE *rrd2rrdr_ks2(
@@ -1346,6 +1515,7 @@ static void rrdset_metric_correlations_ks2(
 
     usec_t started_ut = now_monotonic_usec();
     ONEWAYALLOC *owa = onewayalloc_create(16 * 1024);
+    const DICTIONARY_ITEM *cached = NULL;
 
     size_t high_points = 0;
     STORAGE_POINT highlighted_sp;
@@ -1356,39 +1526,74 @@ static void rrdset_metric_correlations_ks2(
     if(!highlight)
         goto cleanup;
 
-    size_t base_points = 0;
+    int high_size = 0;
+    DIFFS_NUMBERS *highlight_diffs = kstwo_sorted_diffs(owa, highlight, high_points, &high_size);
+    if(!high_size)
+        goto cleanup;
+
+    char key[RRD_ID_LENGTH_MAX * 3 + 200];
+    ks2_baseline_cache_key(key, sizeof(key), host, rca, ria, rma, baseline_after, baseline_before,
+                           high_points << shifts, options, time_group_method, time_group_options, tier);
+
+    int base_size = 0;
+    const DIFFS_NUMBERS *baseline_diffs;
     STORAGE_POINT baseline_sp;
-    NETDATA_DOUBLE *baseline = rrd2rrdr_ks2(
-            owa, host, rca, ria, rma, baseline_after, baseline_before, high_points << shifts,
-            options, time_group_method, time_group_options, tier, stats, &base_points, &baseline_sp);
 
-    if(!baseline)
-        goto cleanup;
+    cached = ks2_baseline_cache_get(key);
+    if(cached) {
+        struct ks2_baseline *b = dictionary_acquired_item_value(cached);
+        baseline_diffs = b->diffs;
+        base_size = b->size;
+        baseline_sp = b->sp;
+        stats->baseline_cache_hits++;
+    }
+    else {
+        size_t base_points = 0;
+        NETDATA_DOUBLE *baseline = rrd2rrdr_ks2(
+                owa, host, rca, ria, rma, baseline_after, baseline_before, high_points << shifts,
+                options, time_group_method, time_group_options, tier, stats, &base_points, &baseline_sp);
 
-    stats->binary_searches += 2 * (base_points - 1) + 2 * (high_points - 1);
+        if(!baseline)
+            goto cleanup;
 
-    double prob = kstwo(baseline, (int)base_points, highlight, (int)high_points, shifts);
+        DIFFS_NUMBERS *diffs = kstwo_sorted_diffs(owa, baseline, base_points, &base_size);
+        if(!base_size)
+            goto cleanup;
+
+        // cache it only when all its data have been collected
+        if(baseline_before < now_realtime_sec() - 2 * rrdinstance_acquired_update_every(ria))
+            ks2_baseline_cache_set(key, diffs, base_size, &baseline_sp);
+
+        baseline_diffs = diffs;
+    }
+
+    stats->binary_searches += 2 * base_size + 2 * high_size;
+
+    double prob = ks_2samp_sorted(baseline_diffs, base_size, highlight_diffs, high_size, shifts);
     if(!isnan(prob) && !isinf(prob)) {
 
         // these conditions should never happen, but still let's check
         if(unlikely(prob < 0.0)) {
-            netdata_log_error("Metric correlations: kstwo() returned a negative number: %f", prob);
+            netdata_log_error("Metric correlations: ks_2samp() returned a negative number: %f", prob);
             prob = -prob;
         }
         if(unlikely(prob > 1.0)) {
-            netdata_log_error("Metric correlations: kstwo() returned a number above 1.0: %f", prob);
+            netdata_log_error("Metric correlations: ks_2samp() returned a number above 1.0: %f", prob);
             prob = 1.0;
         }
 
         usec_t ended_ut = now_monotonic_usec();
 
         // to spread the results evenly, 0.0 needs to be the less correlated and 1.0 the most correlated
-        // so, we flip the result of kstwo()
+        // so, we flip the result of ks_2samp()
         register_result(results, host, rca, ria, rma, 1.0 - prob, RESULT_IS_BASE_HIGH_RATIO, &highlighted_sp,
                         &baseline_sp, stats, register_zero, ended_ut - started_ut);
     }
 
 cleanup:
+    if(cached)
+        ks2_baseline_cache_release(cached);
+
     onewayalloc_destroy(owa);
 }
 
@@ -1658,17 +1863,9 @@ static size_t spread_results_evenly(DICTIONARY *results, WEIGHTS_STATS *stats) {
 // ----------------------------------------------------------------------------
 // The main function
 
-static ssize_t weights_for_rrdmetric(void *data, RRDHOST *host, RRDCONTEXT_ACQUIRED *rca, RRDINSTANCE_ACQUIRED *ria, RRDMETRIC_ACQUIRED *rma) {
-    struct query_weights_data *qwd = data;
+static void weights_query_metric(struct query_weights_data *qwd, WEIGHTS_STATS *stats, RRDHOST *host, RRDCONTEXT_ACQUIRED *rca, RRDINSTANCE_ACQUIRED *ria, RRDMETRIC_ACQUIRED *rma) {
     QUERY_WEIGHTS_REQUEST *qwr = qwd->qwr;
 
-    if(qwd->qwr->interrupt_callback && qwd->qwr->interrupt_callback(qwd->qwr->interrupt_callback_data)) {
-        qwd->interrupted = true;
-        return -1;
-    }
-
-    qwd->examined_dimensions++;
-
     switch(qwr->method) {
         case WEIGHTS_METHOD_VALUE:
             rrdset_weights_value(
@@ -1676,18 +1873,17 @@ static ssize_t weights_for_rrdmetric(void *data, RRDHOST *host, RRDCONTEXT_ACQUI
                     qwd->results,
                     qwr->after, qwr->before,
                     qwr->options, qwr->time_group_method, qwr->time_group_options, qwr->tier,
-                    &qwd->stats, qwd->register_zero
+                    stats, qwd->register_zero
             );
             break;
 
         case WEIGHTS_METHOD_ANOMALY_RATE:
-            qwr->options |= RRDR_OPTION_ANOMALY_BIT;
             rrdset_weights_value(
                     host, rca, ria, rma,
                     qwd->results,
                     qwr->after, qwr->before,
                     qwr->options, qwr->time_group_method, qwr->time_group_options, qwr->tier,
-                    &qwd->stats, qwd->register_zero
+                    stats, qwd->register_zero
             );
             break;
 
@@ -1698,7 +1894,7 @@ static ssize_t weights_for_rrdmetric(void *data, RRDHOST *host, RRDCONTEXT_ACQUI
                     qwr->baseline_after, qwr->baseline_before,
                     qwr->after, qwr->before,
                     qwr->options, qwr->time_group_method, qwr->time_group_options, qwr->tier,
-                    &qwd->stats, qwd->register_zero
+                    stats, qwd->register_zero
             );
             break;
 
@@ -1710,22 +1906,154 @@ static ssize_t weights_for_rrdmetric(void *data, RRDHOST *host, RRDCONTEXT_ACQUI
                     qwr->baseline_after, qwr->baseline_before,
                     qwr->after, qwr->before, qwr->points,
                     qwr->options, qwr->time_group_method, qwr->time_group_options, qwr->tier, qwd->shifts,
-                    &qwd->stats, qwd->register_zero
+                    stats, qwd->register_zero
             );
             break;
     }
+}
 
-    qwd->timings.executed_ut = now_monotonic_usec();
-    if(qwd->timings.executed_ut - qwd->timings.received_ut > qwd->timeout_us) {
-        qwd->timed_out = true;
+static inline bool weights_timed_out(struct query_weights_data *qwd, usec_t now_ut) {
+    if(now_ut - qwd->timings.received_ut > qwd->timeout_us) {
+        __atomic_store_n(&qwd->timed_out, true, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    return false;
+}
+
+static inline bool weights_interrupted(struct query_weights_data *qwd) {
+    if(qwd->qwr->interrupt_callback && qwd->qwr->interrupt_callback(qwd->qwr->interrupt_callback_data)) {
+        __atomic_store_n(&qwd->interrupted, true, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    return false;
+}
+
+static ssize_t weights_for_rrdmetric(void *data, RRDHOST *host, RRDCONTEXT_ACQUIRED *rca, RRDINSTANCE_ACQUIRED *ria, RRDMETRIC_ACQUIRED *rma) {
+    struct query_weights_data *qwd = data;
+
+    if(weights_interrupted(qwd))
         return -1;
+
+    if(qwd->parallel.enabled) {
+        // just collect it, it will be queried later
+        // the callers release their references when we return, so we keep our own
+        if(qwd->parallel.used == qwd->parallel.size) {
+            qwd->parallel.size = (qwd->parallel.size) ? qwd->parallel.size * 2 : 1024;
+            qwd->parallel.array = reallocz(qwd->parallel.array, qwd->parallel.size * sizeof(struct weights_metric));
+        }
+
+        qwd->parallel.array[qwd->parallel.used++] = (struct weights_metric) {
+            .host = host,
+            .rca = rrdcontext_acquired_dup(rca),
+            .ria = rrdinstance_acquired_dup(ria),
+            .rma = rrdmetric_acquired_dup(rma),
+        };
+
+        return 1;
     }
 
-    query_progress_done_step(qwr->transaction, 1);
+    qwd->examined_dimensions++;
+
+    weights_query_metric(qwd, &qwd->stats, host, rca, ria, rma);
+
+    qwd->timings.executed_ut = now_monotonic_usec();
+    if(weights_timed_out(qwd, qwd->timings.executed_ut))
+        return -1;
+
+    query_progress_done_step(qwd->qwr->transaction, 1);
 
     return 1;
 }
 
+// ----------------------------------------------------------------------------
+// parallel execution
+//
+// The metrics matched are collected first. Then the web server thread and
+// the query threads take the next metric of the list, one at a time, until
+// the list is done, the request is interrupted, or the timeout expires.
+// The results are registered into the same (thread safe) dictionary, and
+// each thread merges its statistics when it finishes.
+
+static void weights_stats_merge(WEIGHTS_STATS *dst, WEIGHTS_STATS *src) {
+    if(src->max_base_high_ratio > dst->max_base_high_ratio)
+        dst->max_base_high_ratio = src->max_base_high_ratio;
+
+    dst->db_points += src->db_points;
+    dst->result_points += src->result_points;
+    dst->db_queries += src->db_queries;
+    dst->binary_searches += src->binary_searches;
+    dst->baseline_cache_hits += src->baseline_cache_hits;
+
+    for(size_t tier = 0; tier < storage_tiers ; tier++)
+        dst->db_points_per_tier[tier] += src->db_points_per_tier[tier];
+}
+
+static inline bool weights_parallel_should_stop(struct query_weights_data *qwd) {
+    return __atomic_load_n(&qwd->timed_out, __ATOMIC_RELAXED) || __atomic_load_n(&qwd->interrupted, __ATOMIC_RELAXED);
+}
+
+static void weights_parallel_worker(void *data) {
+    struct query_weights_data *qwd = data;
+    bool caller = (gettid_cached() == qwd->parallel.caller_tid);
+
+    WEIGHTS_STATS stats = { 0 };
+    size_t examined = 0;
+
+    while(!weights_parallel_should_stop(qwd)) {
+        if(caller && weights_interrupted(qwd))
+            break;
+
+        size_t i = __atomic_fetch_add(&qwd->parallel.next, 1, __ATOMIC_RELAXED);
+        if(i >= qwd->parallel.used)
+            break;
+
+        struct weights_metric *m = &qwd->parallel.array[i];
+        weights_query_metric(qwd, &stats, m->host, m->rca, m->ria, m->rma);
+        examined++;
+
+        if(weights_timed_out(qwd, now_monotonic_usec()))
+            break;
+
+        query_progress_done_step(qwd->qwr->transaction, 1);
+    }
+
+    spinlock_lock(&qwd->parallel.spinlock);
+    weights_stats_merge(&qwd->stats, &stats);
+    qwd->examined_dimensions += examined;
+    spinlock_unlock(&qwd->parallel.spinlock);
+}
+
+static void weights_parallel_execute(struct query_weights_data *qwd) {
+    if(!qwd->parallel.used)
+        return;
+
+    query_progress_set_finish_line(qwd->qwr->transaction, qwd->parallel.used);
+
+    size_t helpers = qwd->parallel.used / WEIGHTS_PARALLEL_MIN_METRICS;
+    if(helpers > query_threads_available())
+        helpers = query_threads_available();
+
+    query_threads_run(weights_parallel_worker, qwd, helpers);
+
+    qwd->timings.executed_ut = now_monotonic_usec();
+}
+
+static void weights_parallel_release(struct query_weights_data *qwd) {
+    // metrics first, since each one is found via its instance and context
+    for(size_t i = 0; i < qwd->parallel.used ;i++) {
+        struct weights_metric *m = &qwd->parallel.array[i];
+        rrdmetric_release(m->rma);
+        rrdinstance_release(m->ria);
+        rrdcontext_release(m->rca);
+    }
+
+    freez(qwd->parallel.array);
+    qwd->parallel.array = NULL;
+    qwd->parallel.used = qwd->parallel.size = 0;
+}
+
 static ssize_t weights_do_context_callback(void *data, RRDCONTEXT_ACQUIRED *rca, bool queryable_context) {
     if(!queryable_context)
         return false;
@@ -1769,7 +2097,7 @@ ssize_t weights_do_node_callback(void *data, RRDHOST *host, bool queryable) {
 
     ssize_t ret = query_scope_foreach_context(host, qwd->qwr->scope_contexts,
                                 qwd->scope_contexts_sp, qwd->contexts_sp,
-                                weights_do_context_callback, queryable, qwd);
+                                weights_do_context_callback, queryable, qwd, NULL);
 
     return ret;
 }
@@ -1804,7 +2132,7 @@ int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr) {
             .timed_out = false,
             .examined_dimensions = 0,
             .register_zero = true,
-            .results = register_result_init(),
+            .results = NULL,
             .stats = {},
             .shifts = 0,
             .timings = {
@@ -1823,6 +2151,9 @@ int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr) {
         goto cleanup;
     }
 
+    if(qwr->method == WEIGHTS_METHOD_MC_KS2)
+        ks2_baseline_cache_cleanup();
+
     if(qwr->method == WEIGHTS_METHOD_MC_KS2 || qwr->method == WEIGHTS_METHOD_MC_VOLUME) {
         if(!qwr->points) qwr->points = 500;
 
@@ -1892,10 +2223,22 @@ int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr) {
         qwr->options &= ~RRDR_OPTION_NONZERO;
     }
 
+    bool multi_dimensional = !(qwr->host && qwr->version == 1) &&
+                             (qwr->method == WEIGHTS_METHOD_VALUE || qwr->method == WEIGHTS_METHOD_ANOMALY_RATE) &&
+                             (qwd.contexts_sp || qwd.scope_contexts_sp);
+
+    qwd.parallel.enabled = !multi_dimensional && query_threads_available();
+    qwd.parallel.caller_tid = gettid_cached();
+    spinlock_init(&qwd.parallel.spinlock);
+    qwd.results = register_result_init(qwd.parallel.enabled);
+
+    if(qwr->method == WEIGHTS_METHOD_ANOMALY_RATE && !multi_dimensional)
+        qwr->options |= RRDR_OPTION_ANOMALY_BIT;
+
     if(qwr->host && qwr->version == 1)
         weights_do_node_callback(&qwd, qwr->host, true);
     else {
-        if((qwd.qwr->method == WEIGHTS_METHOD_VALUE || qwd.qwr->method == WEIGHTS_METHOD_ANOMALY_RATE) && (qwd.contexts_sp || qwd.scope_contexts_sp)) {
+        if(multi_dimensional) {
             rrdset_weights_multi_dimensional_value(&qwd);
         }
         else {
@@ -1906,12 +2249,16 @@ int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr) {
         }
     }
 
+    if(qwd.parallel.enabled && !qwd.interrupted)
+        weights_parallel_execute(&qwd);
+
     if(!qwd.register_zero) {
         // put it back, to show it in the response
         qwr->options |= RRDR_OPTION_NONZERO;
     }
 
-    if(qwd.timed_out) {
+    // when it timed out, we respond with the results of the metrics examined so far
+    if(qwd.timed_out && !dictionary_entries(qwd.results)) {
         error = "timed out";
         resp = HTTP_RESP_GATEWAY_TIMEOUT;
         goto cleanup;
@@ -1944,7 +2291,7 @@ int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr) {
                             qwr->baseline_after, qwr->baseline_before,
                             qwr->points, qwr->method, qwr->time_group_method, qwr->options, qwd.shifts,
                             qwd.examined_dimensions,
-                            ended_usec - qwd.timings.received_ut, &qwd.stats);
+                            ended_usec - qwd.timings.received_ut, &qwd.stats, qwd.timed_out);
             break;
 
         case WEIGHTS_FORMAT_CONTEXTS:
@@ -1955,7 +2302,7 @@ int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr) {
                             qwr->baseline_after, qwr->baseline_before,
                             qwr->points, qwr->method, qwr->time_group_method, qwr->options, qwd.shifts,
                             qwd.examined_dimensions,
-                            ended_usec - qwd.timings.received_ut, &qwd.stats);
+                            ended_usec - qwd.timings.received_ut, &qwd.stats, qwd.timed_out);
             break;
 
         default:
@@ -2001,6 +2348,7 @@ cleanup:
     simple_pattern_free(qwd.alerts_sp);
 
     register_result_destroy(qwd.results);
+    weights_parallel_release(&qwd);
 
     if(error) {
         buffer_flush(wb);
@@ -19,6 +19,8 @@ typedef enum {
 } WEIGHTS_FORMAT;
 
 extern int metric_correlations_version;
+extern time_t weights_baseline_cache_ttl_s;
+extern size_t weights_baseline_cache_max_size;
 
 typedef bool (*weights_interrupt_callback_t)(void *data);
 
@@ -21,6 +21,7 @@ struct prometheus_output_options {
     { "variables",  PROMETHEUS_OUTPUT_VARIABLES  },
     { "oldunits",   PROMETHEUS_OUTPUT_OLDUNITS   },
     { "hideunits",  PROMETHEUS_OUTPUT_HIDEUNITS  },
+    { "protobuf",   PROMETHEUS_OUTPUT_PROTOBUF   },
     // terminator
     { NULL, PROMETHEUS_OUTPUT_NONE },
 };
@@ -212,6 +213,10 @@ int api_v1_allmetrics(RRDHOST *host, struct web_client *w, char *url) {
     else
         prometheus_prefix = global_exporting_prefix;
 
+    // prometheus asks for the protobuf exposition with its Accept: header
+    if(w->accept && strstr(w->accept, "application/vnd.google.protobuf") && strstr(w->accept, "io.prometheus.client.MetricFamily"))
+        prometheus_output_options |= PROMETHEUS_OUTPUT_PROTOBUF;
+
     while(url) {
         char *value = strsep_skip_consecutive_separators(&url, "&");
         if (!value || !*value) continue;
@@ -275,7 +280,8 @@ int api_v1_allmetrics(RRDHOST *host, struct web_client *w, char *url) {
             return HTTP_RESP_OK;
 
         case ALLMETRICS_PROMETHEUS:
-            w->response.data->content_type = CT_PROMETHEUS;
+            w->response.data->content_type =
+                (prometheus_output_options & PROMETHEUS_OUTPUT_PROTOBUF) ? CT_PROMETHEUS_PROTOBUF : CT_PROMETHEUS;
             rrd_stats_api_v1_charts_allmetrics_prometheus_single_host(
                 host
                 , filter
@@ -288,7 +294,8 @@ int api_v1_allmetrics(RRDHOST *host, struct web_client *w, char *url) {
             return HTTP_RESP_OK;
 
         case ALLMETRICS_PROMETHEUS_ALL_HOSTS:
-            w->response.data->content_type = CT_PROMETHEUS;
+            w->response.data->content_type =
+                (prometheus_output_options & PROMETHEUS_OUTPUT_PROTOBUF) ? CT_PROMETHEUS_PROTOBUF : CT_PROMETHEUS;
             rrd_stats_api_v1_charts_allmetrics_prometheus_all_hosts(
                 host
                 , filter
@@ -862,6 +862,205 @@ static void buffer_svg(BUFFER *wb, const char *label,
     buffer_sprintf(wb, "</svg>");
 }
 
+
+// ----------------------------------------------------------------------------
+// rendered badges cache
+//
+// Pages embedding badges load them again and again, but the value of a badge
+// changes only when its chart collects a new point (or its alert is evaluated
+// again). So, the rendered badges are kept by host and normalized query
+// parameters, until the next point of their chart is due, and clients
+// revalidating their copies get a 304.
+
+#define BADGE_CACHE_MAX_PARAMS 64
+#define BADGE_CACHE_CLEANUP_EVERY_S 60
+
+typedef struct badge_cache_entry {
+    time_t valid_until_s;               // the time the badge has to be rendered again
+    time_t date;                        // the http date and expires of the response
+    time_t expires;
+    BUFFER_OPTIONS options;             // the cacheable / no-cacheable flags of the response
+    int refresh;                        // the Refresh: header, when positive
+    char etag[32];
+    size_t len;
+    char *svg;
+} BADGE_CACHE_ENTRY;
+
+static struct {
+    SPINLOCK spinlock;
+    DICTIONARY *badges;
+    time_t last_cleanup_s;
+} badge_cache = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+};
+
+static void badge_cache_delete_cb(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused) {
+    BADGE_CACHE_ENTRY *e = value;
+    freez(e->svg);
+}
+
+static DICTIONARY *badge_cache_index(void) {
+    DICTIONARY *badges = __atomic_load_n(&badge_cache.badges, __ATOMIC_ACQUIRE);
+    if(likely(badges))
+        return badges;
+
+    spinlock_lock(&badge_cache.spinlock);
+    if(!badge_cache.badges) {
+        badges = dictionary_create_advanced(DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE,
+                                            NULL, sizeof(BADGE_CACHE_ENTRY));
+
+        dictionary_register_delete_callback(badges, badge_cache_delete_cb, NULL);
+        __atomic_store_n(&badge_cache.badges, badges, __ATOMIC_RELEASE);
+    }
+    spinlock_unlock(&badge_cache.spinlock);
+
+    return badge_cache.badges;
+}
+
+static int badge_cache_param_compar(const void *a, const void *b) {
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+// the key is the host and the query parameters sorted, so that the same
+// badge is found, in whatever order its parameters are given
+static bool badge_cache_key(BUFFER *key, RRDHOST *host, const char *url) {
+    buffer_strcat(key, host->machine_guid);
+    buffer_putc(key, '?');
+
+    if(!url || !*url)
+        return true;
+
+    char buf[strlen(url) + 1];
+    strcpy(buf, url);
+
+    const char *params[BADGE_CACHE_MAX_PARAMS];
+    size_t used = 0;
+
+    char *s = buf;
+    while(s) {
+        char *param = strsep_skip_consecutive_separators(&s, "&");
+        if(!param || !*param) continue;
+
+        // the parser ignores the parameters without a value
+        char *eq = strchr(param, '=');
+        if(!eq || !eq[1]) continue;
+
+        if(used >= BADGE_CACHE_MAX_PARAMS)
+            return false;
+
+        params[used++] = param;
+    }
+
+    qsort(params, used, sizeof(const char *), badge_cache_param_compar);
+
+    for(size_t i = 0; i < used ; i++) {
+        if(i) buffer_putc(key, '&');
+        buffer_strcat(key, params[i]);
+    }
+
+    return true;
+}
+
+static bool badge_cache_etag_matches(const char *etag, const char *if_none_match) {
+    if(!if_none_match)
+        return false;
+
+    while(isspace((uint8_t)*if_none_match))
+        if_none_match++;
+
+    return *if_none_match == '*' || strstr(if_none_match, etag);
+}
+
+static int badge_cache_respond(struct web_client *w, const char *etag, int refresh) {
+    if(refresh > 0)
+        buffer_sprintf(w->response.header, "Refresh: %d\r\n", refresh);
+
+    buffer_sprintf(w->response.header, "ETag: %s\r\n", etag);
+
+    if(badge_cache_etag_matches(etag, w->if_none_match)) {
+        buffer_flush(w->response.data);
+        return HTTP_RESP_NOT_MODIFIED;
+    }
+
+    return HTTP_RESP_OK;
+}
+
+// returns -1 when the badge is not in the cache, or it has to be rendered again
+static int badge_cache_get(struct web_client *w, const char *key) {
+    DICTIONARY *badges = badge_cache_index();
+
+    const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(badges, key);
+    if(!item)
+        return -1;
+
+    BADGE_CACHE_ENTRY *e = dictionary_acquired_item_value(item);
+    if(e->valid_until_s <= now_realtime_sec()) {
+        dictionary_acquired_item_release(badges, item);
+        return -1;
+    }
+
+    BUFFER *wb = w->response.data;
+    wb->content_type = CT_IMAGE_SVG_XML;
+    wb->options = (wb->options & ~(WB_CONTENT_CACHEABLE | WB_CONTENT_NO_CACHEABLE)) | e->options;
+    wb->date = e->date;
+    wb->expires = e->expires;
+    buffer_fast_strcat(wb, e->svg, e->len);
+
+    int ret = badge_cache_respond(w, e->etag, e->refresh);
+    dictionary_acquired_item_release(badges, item);
+    return ret;
+}
+
+static void badge_cache_cleanup(DICTIONARY *badges, time_t now_s) {
+    spinlock_lock(&badge_cache.spinlock);
+    bool run = badge_cache.last_cleanup_s + BADGE_CACHE_CLEANUP_EVERY_S <= now_s;
+    if(run)
+        badge_cache.last_cleanup_s = now_s;
+    spinlock_unlock(&badge_cache.spinlock);
+
+    if(!run)
+        return;
+
+    BADGE_CACHE_ENTRY *e;
+    dfe_start_write(badges, e) {
+        if(e->valid_until_s + BADGE_CACHE_CLEANUP_EVERY_S <= now_s)
+            dictionary_del(badges, e_dfe.name);
+    }
+    dfe_done(e);
+}
+
+// the response has been rendered in w->response.data - keep it and answer
+// conditional requests
+static int badge_cache_set(struct web_client *w, const char *key, time_t valid_until_s, int refresh) {
+    BUFFER *wb = w->response.data;
+    DICTIONARY *badges = badge_cache_index();
+    time_t now_s = now_realtime_sec();
+
+    BADGE_CACHE_ENTRY tmp = {
+        .valid_until_s = valid_until_s > now_s ? valid_until_s : now_s + 1,
+        .date = wb->date,
+        .expires = wb->expires,
+        .options = wb->options & (WB_CONTENT_CACHEABLE | WB_CONTENT_NO_CACHEABLE),
+        .refresh = refresh,
+        .len = buffer_strlen(wb),
+        .svg = strndupz(buffer_tostring(wb), buffer_strlen(wb)),
+    };
+    snprintfz(tmp.etag, sizeof(tmp.etag) - 1, "\"%x-%zx\"", simple_hash(tmp.svg), tmp.len);
+
+    // the old version of the badge stays with the clients still sending it
+    dictionary_del(badges, key);
+    const DICTIONARY_ITEM *item = dictionary_set_and_acquire_item(badges, key, &tmp, sizeof(tmp));
+    BADGE_CACHE_ENTRY *e = dictionary_acquired_item_value(item);
+    if(e->svg != tmp.svg)
+        // another thread added it in the meantime
+        freez(tmp.svg);
+    dictionary_acquired_item_release(badges, item);
+
+    badge_cache_cleanup(badges, now_s);
+
+    return badge_cache_respond(w, tmp.etag, refresh);
+}
+
 #define BADGE_URL_ARG_LBL_COLOR "text_color_lbl"
 #define BADGE_URL_ARG_VAL_COLOR "text_color_val"
 
@@ -898,6 +1097,21 @@ int api_v1_badge(RRDHOST *host, struct web_client *w, char *url) {
     RRDCALC *rc = NULL;
     RRDSET *st = NULL;
 
+    // the time the rendered badge has to be rendered again, 0 when it cannot be cached
+    time_t cache_valid_until_s = 0;
+    int refresh = 0;
+
+    CLEAN_BUFFER *cache_key = buffer_create(0, NULL);
+    if(!badge_cache_key(cache_key, host, url))
+        buffer_flush(cache_key);
+    else {
+        ret = badge_cache_get(w, buffer_tostring(cache_key));
+        if(ret != -1)
+            return ret;
+
+        ret = HTTP_RESP_BAD_REQUEST;
+    }
+
     while(url) {
         char *value = strsep_skip_consecutive_separators(&url, "&");
         if(!value || !*value) continue;
@@ -994,7 +1208,6 @@ int api_v1_badge(RRDHOST *host, struct web_client *w, char *url) {
     if(!multiply) multiply = 1;
     if(!divide) divide = 1;
 
-    int refresh = 0;
     if(refresh_str && *refresh_str) {
         if(!strcmp(refresh_str, "auto")) {
             if(rc) refresh = rc->config.update_every;
@@ -1055,7 +1268,6 @@ int api_v1_badge(RRDHOST *host, struct web_client *w, char *url) {
 
     if(rc) {
         if (refresh > 0) {
-            buffer_sprintf(w->response.header, "Refresh: %d\r\n", refresh);
             w->response.data->date = now_realtime_sec();
             w->response.data->expires = w->response.data->date + refresh;
             buffer_cacheable(w->response.data);
@@ -1106,6 +1318,9 @@ int api_v1_badge(RRDHOST *host, struct web_client *w, char *url) {
                 text_color_val_str
         );
         ret = HTTP_RESP_OK;
+
+        // the value of the badge changes when the alert is evaluated again
+        cache_valid_until_s = rc->next_update;
     }
     else {
         time_t latest_timestamp = 0;
@@ -1130,11 +1345,15 @@ int api_v1_badge(RRDHOST *host, struct web_client *w, char *url) {
             n = 0;
             ret = HTTP_RESP_OK;
         }
-        else if (refresh > 0) {
-            buffer_sprintf(w->response.header, "Refresh: %d\r\n", refresh);
-            w->response.data->expires = now_realtime_sec() + refresh;
+        else {
+            if (refresh > 0)
+                w->response.data->expires = now_realtime_sec() + refresh;
+            else
+                buffer_no_cacheable(w->response.data);
+
+            // the value of the badge changes when the chart collects its next point
+            cache_valid_until_s = rrdset_last_entry_s(st) + st->update_every;
         }
-        else buffer_no_cacheable(w->response.data);
 
         // render the badge
         buffer_svg(w->response.data,
@@ -1153,6 +1372,11 @@ int api_v1_badge(RRDHOST *host, struct web_client *w, char *url) {
         );
     }
 
+    if(cache_valid_until_s && buffer_strlen(cache_key))
+        ret = badge_cache_set(w, buffer_tostring(cache_key), cache_valid_until_s, refresh);
+    else if(rc && refresh > 0)
+        buffer_sprintf(w->response.header, "Refresh: %d\r\n", refresh);
+
 cleanup:
     rrdcalc_from_rrdset_release(st, rca);
     buffer_free(dimensions);
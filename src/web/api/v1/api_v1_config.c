@@ -84,6 +84,7 @@ int api_v1_config(RRDHOST *host, struct web_client *w, char *url __maybe_unused)
     int code = rrd_function_run(host, w->response.data, timeout, w->access, cmd,
                                 true, transaction,
                                 NULL, NULL,
+                                NULL, NULL,
                                 web_client_progress_functions_update, w,
                                 web_client_interrupt_callback, w,
                                 w->payload, buffer_tostring(source), false);
@@ -173,6 +173,14 @@ int api_v1_data(RRDHOST *host, struct web_client *w, char *url) {
         .interrupt_callback_data = w,
         .transaction = &w->transaction,
     };
+    // stream the response while it is generated
+    // (google datatable jsonp may have to replace the whole response at the end)
+    if(format != DATASOURCE_DATATABLE_JSONP && web_client_can_stream_response(w)) {
+        qtr.flush_callback = web_client_stream_response_callback;
+        qtr.flush_callback_data = w;
+        qtr.flush_size = web_response_stream_chunk_size;
+    }
+
     qt = query_target_create(&qtr);
 
     if(!qt || !qt->query.used) {
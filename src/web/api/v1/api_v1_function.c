@@ -37,6 +37,7 @@ int api_v1_function(RRDHOST *host, struct web_client *w, char *url) {
     web_client_api_request_vX_source_to_buffer(w, source);
 
     return rrd_function_run(host, wb, timeout, w->access, function, true, transaction,
+                            NULL, NULL,
                             NULL, NULL,
                             web_client_progress_functions_update, w,
                             web_client_interrupt_callback, w, w->payload,
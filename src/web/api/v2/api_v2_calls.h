@@ -8,6 +8,36 @@
 int api_v2_info(RRDHOST *host, struct web_client *w, char *url);
 
 int api_v2_data(RRDHOST *host, struct web_client *w, char *url);
+
+// the parameters of a data query, as given to the data API
+struct api_v2_data_request {
+    char *scope_nodes;
+    char *scope_contexts;
+    char *nodes;
+    char *contexts;
+    char *instances;
+    char *dimensions;
+    char *labels;
+    char *alerts;
+    char *before_str;
+    char *after_str;
+    char *points_str;
+    char *timeout_str;
+    char *resampling_time_str;
+    char *time_group_options;
+    char *tier_str;
+    RRDR_TIME_GROUPING time_group;
+    DATASOURCE_FORMAT format;
+    RRDR_OPTIONS options;
+
+    struct group_by_pass group_by[MAX_QUERY_GROUP_BY_PASSES];
+    size_t group_by_idx, group_by_label_idx, aggregation_idx;
+};
+
+void api_v2_data_request_init(struct api_v2_data_request *r);
+bool api_v2_data_request_set(struct api_v2_data_request *r, const char *name, char *value);
+void api_v2_data_request_to_qtr(struct api_v2_data_request *r, QUERY_TARGET_REQUEST *qtr, usec_t received_ut);
+
 int api_v2_weights(RRDHOST *host, struct web_client *w, char *url);
 
 int api_v2_alert_config(RRDHOST *host, struct web_client *w, char *url);
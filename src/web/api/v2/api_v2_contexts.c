@@ -36,6 +36,8 @@ int api_v2_contexts_internal(RRDHOST *host __maybe_unused, struct web_client *w,
             req.before = str2l(value);
         else if(!strcmp(name, "timeout"))
             req.timeout_ms = str2l(value);
+        else if((mode & (CONTEXTS_V2_CONTEXTS | CONTEXTS_V2_NODES)) && !strcmp(name, "since"))
+            req.since = str2ull(value, NULL);
         else if(mode & (CONTEXTS_V2_ALERTS | CONTEXTS_V2_ALERT_TRANSITIONS)) {
             if (!strcmp(name, "alert"))
                 req.alerts.alert = value;
@@ -66,9 +68,16 @@ int api_v2_contexts_internal(RRDHOST *host __maybe_unused, struct web_client *w,
     if ((mode & CONTEXTS_V2_ALERT_TRANSITIONS) && !req.alerts.last)
         req.alerts.last = 1;
 
+    req.if_none_match = w->if_none_match;
+
     buffer_flush(w->response.data);
     buffer_no_cacheable(w->response.data);
-    return rrdcontext_to_json_v2(w->response.data, &req, mode);
+    int ret = rrdcontext_to_json_v2(w->response.data, &req, mode);
+
+    if(*req.etag && (ret == HTTP_RESP_OK || ret == HTTP_RESP_NOT_MODIFIED))
+        buffer_sprintf(w->response.header, "ETag: %s\r\n", req.etag);
+
+    return ret;
 }
 
 int api_v2_contexts(RRDHOST *host __maybe_unused, struct web_client *w, char *url) {
@@ -17,6 +17,147 @@ __attribute__((constructor)) void initialize_group_by_keys(void) {
     }
 }
 
+void api_v2_data_request_init(struct api_v2_data_request *r) {
+    memset(r, 0, sizeof(*r));
+    r->time_group = RRDR_GROUPING_AVERAGE;
+    r->format = DATASOURCE_JSON2;
+    r->options = RRDR_OPTION_VIRTUAL_POINTS | RRDR_OPTION_JSON_WRAP | RRDR_OPTION_RETURN_JWAR;
+    r->group_by[0] = (struct group_by_pass) {
+        .group_by = RRDR_GROUP_BY_DIMENSION,
+        .group_by_label = NULL,
+        .aggregation = RRDR_GROUP_BY_FUNCTION_AVERAGE,
+    };
+}
+
+// returns false when the parameter is not a data query parameter
+// the value is not copied, it has to be available until the query is executed
+bool api_v2_data_request_set(struct api_v2_data_request *r, const char *name, char *value) {
+    if(!strcmp(name, "scope_nodes")) r->scope_nodes = value;
+    else if(!strcmp(name, "scope_contexts")) r->scope_contexts = value;
+    else if(!strcmp(name, "nodes")) r->nodes = value;
+    else if(!strcmp(name, "contexts")) r->contexts = value;
+    else if(!strcmp(name, "instances")) r->instances = value;
+    else if(!strcmp(name, "dimensions")) r->dimensions = value;
+    else if(!strcmp(name, "labels")) r->labels = value;
+    else if(!strcmp(name, "alerts")) r->alerts = value;
+    else if(!strcmp(name, "after")) r->after_str = value;
+    else if(!strcmp(name, "before")) r->before_str = value;
+    else if(!strcmp(name, "points")) r->points_str = value;
+    else if(!strcmp(name, "timeout")) r->timeout_str = value;
+    else if(!strcmp(name, "group_by")) {
+        r->group_by[r->group_by_idx++].group_by = group_by_parse(value);
+        if(r->group_by_idx >= MAX_QUERY_GROUP_BY_PASSES)
+            r->group_by_idx = MAX_QUERY_GROUP_BY_PASSES - 1;
+    }
+    else if(!strcmp(name, "group_by_label")) {
+        r->group_by[r->group_by_label_idx++].group_by_label = value;
+        if(r->group_by_label_idx >= MAX_QUERY_GROUP_BY_PASSES)
+            r->group_by_label_idx = MAX_QUERY_GROUP_BY_PASSES - 1;
+    }
+    else if(!strcmp(name, "aggregation")) {
+        r->group_by[r->aggregation_idx++].aggregation = group_by_aggregate_function_parse(value);
+        if(r->aggregation_idx >= MAX_QUERY_GROUP_BY_PASSES)
+            r->aggregation_idx = MAX_QUERY_GROUP_BY_PASSES - 1;
+    }
+    else if(!strcmp(name, "format")) r->format = datasource_format_str_to_id(value);
+    else if(!strcmp(name, "options")) r->options |= rrdr_options_parse(value);
+    else if(!strcmp(name, "time_group")) r->time_group = time_grouping_parse(value, RRDR_GROUPING_AVERAGE);
+    else if(!strcmp(name, "time_group_options")) r->time_group_options = value;
+    else if(!strcmp(name, "time_resampling")) r->resampling_time_str = value;
+    else if(!strcmp(name, "tier")) r->tier_str = value;
+    else {
+        for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++) {
+            if(!strcmp(name, group_by_keys[g].group_by)) {
+                r->group_by[g].group_by = group_by_parse(value);
+                return true;
+            }
+            else if(!strcmp(name, group_by_keys[g].group_by_label)) {
+                r->group_by[g].group_by_label = value;
+                return true;
+            }
+            else if(!strcmp(name, group_by_keys[g].aggregation)) {
+                r->group_by[g].aggregation = group_by_aggregate_function_parse(value);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+// prepares the query target request of the parameters given
+// the caller has to set the callbacks and the transaction
+void api_v2_data_request_to_qtr(struct api_v2_data_request *r, QUERY_TARGET_REQUEST *qtr, usec_t received_ut) {
+    struct group_by_pass *group_by = r->group_by;
+    RRDR_OPTIONS options = r->options;
+    size_t tier = 0;
+
+    for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++) {
+        if (group_by[g].group_by_label && *group_by[g].group_by_label)
+            group_by[g].group_by |= RRDR_GROUP_BY_LABEL;
+    }
+
+    if(group_by[0].group_by == RRDR_GROUP_BY_NONE)
+        group_by[0].group_by = RRDR_GROUP_BY_DIMENSION;
+
+    for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++) {
+        if ((group_by[g].group_by & ~(RRDR_GROUP_BY_DIMENSION)) || (options & RRDR_OPTION_PERCENTAGE)) {
+            options |= RRDR_OPTION_ABSOLUTE;
+            break;
+        }
+    }
+
+    if(options & RRDR_OPTION_DEBUG)
+        options &= ~RRDR_OPTION_MINIFY;
+
+    if(r->tier_str && *r->tier_str) {
+        tier = str2ul(r->tier_str);
+        if(tier < storage_tiers)
+            options |= RRDR_OPTION_SELECTED_TIER;
+        else
+            tier = 0;
+    }
+
+    time_t    before = (r->before_str && *r->before_str)?str2l(r->before_str):0;
+    time_t    after  = (r->after_str  && *r->after_str) ?str2l(r->after_str):-600;
+    size_t    points = (r->points_str && *r->points_str)?str2u(r->points_str):0;
+    int       timeout = (r->timeout_str && *r->timeout_str)?str2i(r->timeout_str): 0;
+    time_t    resampling_time = (r->resampling_time_str && *r->resampling_time_str) ? str2l(r->resampling_time_str) : 0;
+
+    *qtr = (QUERY_TARGET_REQUEST) {
+        .version = 2,
+        .scope_nodes = r->scope_nodes,
+        .scope_contexts = r->scope_contexts,
+        .after = after,
+        .before = before,
+        .host = NULL,
+        .st = NULL,
+        .nodes = r->nodes,
+        .contexts = r->contexts,
+        .instances = r->instances,
+        .dimensions = r->dimensions,
+        .alerts = r->alerts,
+        .timeout_ms = timeout,
+        .points = points,
+        .format = r->format,
+        .options = options,
+        .time_group_method = r->time_group,
+        .time_group_options = r->time_group_options,
+        .resampling_time = resampling_time,
+        .tier = tier,
+        .chart_label_key = NULL,
+        .labels = r->labels,
+        .query_source = QUERY_SOURCE_API_DATA,
+        .priority = STORAGE_PRIORITY_NORMAL,
+        .received_ut = received_ut,
+    };
+
+    for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++)
+        qtr->group_by[g] = group_by[g];
+}
+
 int api_v2_data(RRDHOST *host __maybe_unused, struct web_client *w, char *url) {
     usec_t received_ut = now_monotonic_usec();
 
@@ -33,35 +174,8 @@ int api_v2_data(RRDHOST *host __maybe_unused, struct web_client *w, char *url) {
 
     time_t last_timestamp_in_data = 0, google_timestamp = 0;
 
-    char *scope_nodes = NULL;
-    char *scope_contexts = NULL;
-    char *nodes = NULL;
-    char *contexts = NULL;
-    char *instances = NULL;
-    char *dimensions = NULL;
-    char *before_str = NULL;
-    char *after_str = NULL;
-    char *resampling_time_str = NULL;
-    char *points_str = NULL;
-    char *timeout_str = NULL;
-    char *labels = NULL;
-    char *alerts = NULL;
-    char *time_group_options = NULL;
-    char *tier_str = NULL;
-    size_t tier = 0;
-    RRDR_TIME_GROUPING time_group = RRDR_GROUPING_AVERAGE;
-    DATASOURCE_FORMAT format = DATASOURCE_JSON2;
-    RRDR_OPTIONS options = RRDR_OPTION_VIRTUAL_POINTS | RRDR_OPTION_JSON_WRAP | RRDR_OPTION_RETURN_JWAR;
-
-    struct group_by_pass group_by[MAX_QUERY_GROUP_BY_PASSES] = {
-        {
-            .group_by = RRDR_GROUP_BY_DIMENSION,
-            .group_by_label = NULL,
-            .aggregation = RRDR_GROUP_BY_FUNCTION_AVERAGE,
-        },
-    };
-
-    size_t group_by_idx = 0, group_by_label_idx = 0, aggregation_idx = 0;
+    struct api_v2_data_request r;
+    api_v2_data_request_init(&r);
 
     while(url) {
         char *value = strsep_skip_consecutive_separators(&url, "&");
@@ -74,40 +188,7 @@ int api_v2_data(RRDHOST *host __maybe_unused, struct web_client *w, char *url) {
         // name and value are now the parameters
         // they are not null and not empty
 
-        if(!strcmp(name, "scope_nodes")) scope_nodes = value;
-        else if(!strcmp(name, "scope_contexts")) scope_contexts = value;
-        else if(!strcmp(name, "nodes")) nodes = value;
-        else if(!strcmp(name, "contexts")) contexts = value;
-        else if(!strcmp(name, "instances")) instances = value;
-        else if(!strcmp(name, "dimensions")) dimensions = value;
-        else if(!strcmp(name, "labels")) labels = value;
-        else if(!strcmp(name, "alerts")) alerts = value;
-        else if(!strcmp(name, "after")) after_str = value;
-        else if(!strcmp(name, "before")) before_str = value;
-        else if(!strcmp(name, "points")) points_str = value;
-        else if(!strcmp(name, "timeout")) timeout_str = value;
-        else if(!strcmp(name, "group_by")) {
-            group_by[group_by_idx++].group_by = group_by_parse(value);
-            if(group_by_idx >= MAX_QUERY_GROUP_BY_PASSES)
-                group_by_idx = MAX_QUERY_GROUP_BY_PASSES - 1;
-        }
-        else if(!strcmp(name, "group_by_label")) {
-            group_by[group_by_label_idx++].group_by_label = value;
-            if(group_by_label_idx >= MAX_QUERY_GROUP_BY_PASSES)
-                group_by_label_idx = MAX_QUERY_GROUP_BY_PASSES - 1;
-        }
-        else if(!strcmp(name, "aggregation")) {
-            group_by[aggregation_idx++].aggregation = group_by_aggregate_function_parse(value);
-            if(aggregation_idx >= MAX_QUERY_GROUP_BY_PASSES)
-                aggregation_idx = MAX_QUERY_GROUP_BY_PASSES - 1;
-        }
-        else if(!strcmp(name, "format")) format = datasource_format_str_to_id(value);
-        else if(!strcmp(name, "options")) options |= rrdr_options_parse(value);
-        else if(!strcmp(name, "time_group")) time_group = time_grouping_parse(value, RRDR_GROUPING_AVERAGE);
-        else if(!strcmp(name, "time_group_options")) time_group_options = value;
-        else if(!strcmp(name, "time_resampling")) resampling_time_str = value;
-        else if(!strcmp(name, "tier")) tier_str = value;
-        else if(!strcmp(name, "callback")) responseHandler = value;
+        if(!strcmp(name, "callback")) responseHandler = value;
         else if(!strcmp(name, "filename")) outFileName = value;
         else if(!strcmp(name, "tqx")) {
             // parse Google Visualization API options
@@ -132,7 +213,7 @@ int api_v2_data(RRDHOST *host __maybe_unused, struct web_client *w, char *url) {
                 }
                 else if(!strcmp(tqx_name, "out")) {
                     google_out = tqx_value;
-                    format = google_data_format_str_to_id(google_out);
+                    r.format = google_data_format_str_to_id(google_out);
                 }
                 else if(!strcmp(tqx_name, "responseHandler"))
                     responseHandler = tqx_value;
@@ -140,16 +221,8 @@ int api_v2_data(RRDHOST *host __maybe_unused, struct web_client *w, char *url) {
                     outFileName = tqx_value;
             }
         }
-        else {
-            for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++) {
-                if(!strcmp(name, group_by_keys[g].group_by))
-                    group_by[g].group_by = group_by_parse(value);
-                else if(!strcmp(name, group_by_keys[g].group_by_label))
-                    group_by[g].group_by_label = value;
-                else if(!strcmp(name, group_by_keys[g].aggregation))
-                    group_by[g].aggregation = group_by_aggregate_function_parse(value);
-            }
-        }
+        else
+            api_v2_data_request_set(&r, name, value);
     }
 
     // validate the google parameters given
@@ -160,74 +233,23 @@ int api_v2_data(RRDHOST *host __maybe_unused, struct web_client *w, char *url) {
     fix_google_param(responseHandler);
     fix_google_param(outFileName);
 
-    for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++) {
-        if (group_by[g].group_by_label && *group_by[g].group_by_label)
-            group_by[g].group_by |= RRDR_GROUP_BY_LABEL;
-    }
-
-    if(group_by[0].group_by == RRDR_GROUP_BY_NONE)
-        group_by[0].group_by = RRDR_GROUP_BY_DIMENSION;
-
-    for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++) {
-        if ((group_by[g].group_by & ~(RRDR_GROUP_BY_DIMENSION)) || (options & RRDR_OPTION_PERCENTAGE)) {
-            options |= RRDR_OPTION_ABSOLUTE;
-            break;
-        }
+    QUERY_TARGET_REQUEST qtr;
+    api_v2_data_request_to_qtr(&r, &qtr, received_ut);
+    qtr.interrupt_callback = web_client_interrupt_callback;
+    qtr.interrupt_callback_data = w;
+    qtr.transaction = &w->transaction;
+
+    DATASOURCE_FORMAT format = r.format;
+    int timeout = (int)qtr.timeout_ms;
+
+    // stream the response while it is generated
+    // (google datatable jsonp may have to replace the whole response at the end)
+    if(format != DATASOURCE_DATATABLE_JSONP && web_client_can_stream_response(w)) {
+        qtr.flush_callback = web_client_stream_response_callback;
+        qtr.flush_callback_data = w;
+        qtr.flush_size = web_response_stream_chunk_size;
     }
 
-    if(options & RRDR_OPTION_DEBUG)
-        options &= ~RRDR_OPTION_MINIFY;
-
-    if(tier_str && *tier_str) {
-        tier = str2ul(tier_str);
-        if(tier < storage_tiers)
-            options |= RRDR_OPTION_SELECTED_TIER;
-        else
-            tier = 0;
-    }
-
-    time_t    before = (before_str && *before_str)?str2l(before_str):0;
-    time_t    after  = (after_str  && *after_str) ?str2l(after_str):-600;
-    size_t    points = (points_str && *points_str)?str2u(points_str):0;
-    int       timeout = (timeout_str && *timeout_str)?str2i(timeout_str): 0;
-    time_t    resampling_time = (resampling_time_str && *resampling_time_str) ? str2l(resampling_time_str) : 0;
-
-    QUERY_TARGET_REQUEST qtr = {
-        .version = 2,
-        .scope_nodes = scope_nodes,
-        .scope_contexts = scope_contexts,
-        .after = after,
-        .before = before,
-        .host = NULL,
-        .st = NULL,
-        .nodes = nodes,
-        .contexts = contexts,
-        .instances = instances,
-        .dimensions = dimensions,
-        .alerts = alerts,
-        .timeout_ms = timeout,
-        .points = points,
-        .format = format,
-        .options = options,
-        .time_group_method = time_group,
-        .time_group_options = time_group_options,
-        .resampling_time = resampling_time,
-        .tier = tier,
-        .chart_label_key = NULL,
-        .labels = labels,
-        .query_source = QUERY_SOURCE_API_DATA,
-        .priority = STORAGE_PRIORITY_NORMAL,
-        .received_ut = received_ut,
-
-        .interrupt_callback = web_client_interrupt_callback,
-        .interrupt_callback_data = w,
-
-        .transaction = &w->transaction,
-    };
-
-    for(size_t g = 0; g < MAX_QUERY_GROUP_BY_PASSES ;g++)
-        qtr.group_by[g] = group_by[g];
-
     QUERY_TARGET *qt = query_target_create(&qtr);
     ONEWAYALLOC *owa = NULL;
 
@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "api_v3_calls.h"
+#include "../v2/api_v2_calls.h"
+#include "../queries/query_threads.h"
+
+// ----------------------------------------------------------------------------
+// batch data queries
+//
+// Dashboards issue tens of data queries with the same scope of nodes, that
+// differ only in their contexts and grouping. This API accepts all of them
+// in one request: the URL has the parameters shared by all the queries (the
+// nodes of the scope are resolved once, for all of them), and the payload
+// has the parameters of each query, as a JSON object with the same names
+// the data API accepts:
+//
+//   { "queries": [ { "id": "cpu", "contexts": "system.cpu", "group_by": "dimension" }, ... ] }
+//
+// The queries are executed concurrently on the query threads, and the
+// response has the JSON2 response of each query, in the order given.
+
+#define API_BATCH_MAX_QUERIES 200
+
+struct batch_query {
+    const char *id;
+    struct api_v2_data_request r;
+    BUFFER *wb;
+    int ret;
+    bool relative;
+};
+
+struct batch {
+    struct web_client *w;
+    usec_t received_ut;
+
+    const char *scope_nodes;
+    const char *nodes;
+    QUERY_SCOPE_NODES scope;        // the nodes of scope_nodes and nodes, resolved once
+
+    size_t used;
+    size_t next;                    // the next query to be executed, by any thread
+    struct batch_query queries[API_BATCH_MAX_QUERIES];
+};
+
+static void batch_query_execute(struct batch *b, struct batch_query *q) {
+    QUERY_TARGET_REQUEST qtr;
+    api_v2_data_request_to_qtr(&q->r, &qtr, b->received_ut);
+
+    // all of them share the scope of the batch
+    qtr.scope_nodes = b->scope_nodes;
+    qtr.nodes = b->nodes;
+    qtr.scope_resolved = &b->scope;
+    qtr.format = DATASOURCE_JSON2;
+    qtr.interrupt_callback = web_client_interrupt_callback;
+    qtr.interrupt_callback_data = b->w;
+    qtr.transaction = &b->w->transaction;
+
+    q->wb = buffer_create(0, NULL);
+
+    QUERY_TARGET *qt = query_target_create(&qtr);
+    if(!qt) {
+        buffer_strcat(q->wb, "Failed to prepare the query.");
+        q->ret = HTTP_RESP_INTERNAL_SERVER_ERROR;
+        return;
+    }
+
+    time_t last_timestamp_in_data = 0;
+    ONEWAYALLOC *owa = onewayalloc_create(0);
+    q->ret = data_query_execute(owa, q->wb, qt, &last_timestamp_in_data);
+    q->relative = qt->internal.relative;
+
+    query_target_release(qt);
+    onewayalloc_destroy(owa);
+}
+
+static void batch_worker(void *data) {
+    struct batch *b = data;
+
+    size_t i;
+    while((i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED)) < b->used)
+        batch_query_execute(b, &b->queries[i]);
+}
+
+static int batch_parse_payload(struct batch *b, struct api_v2_data_request *shared, struct json_object *jobj) {
+    BUFFER *wb = b->w->response.data;
+
+    struct json_object *queries;
+    if(!json_object_object_get_ex(jobj, "queries", &queries) || !json_object_is_type(queries, json_type_array)) {
+        buffer_strcat(wb, "The payload has to be a JSON object with a 'queries' array.");
+        return HTTP_RESP_BAD_REQUEST;
+    }
+
+    size_t entries = json_object_array_length(queries);
+    if(!entries || entries > API_BATCH_MAX_QUERIES) {
+        buffer_sprintf(wb, "The batch has to have 1 to %d queries.", API_BATCH_MAX_QUERIES);
+        return HTTP_RESP_BAD_REQUEST;
+    }
+
+    for(size_t i = 0; i < entries ; i++) {
+        struct json_object *query = json_object_array_get_idx(queries, i);
+        if(!json_object_is_type(query, json_type_object)) {
+            buffer_sprintf(wb, "Query %zu is not a JSON object.", i);
+            return HTTP_RESP_BAD_REQUEST;
+        }
+
+        struct batch_query *q = &b->queries[b->used++];
+        q->r = *shared;
+        q->r.group_by_idx = q->r.group_by_label_idx = q->r.aggregation_idx = 0;
+
+        json_object_object_foreach(query, name, value) {
+            if(!json_object_is_type(value, json_type_string)) {
+                buffer_sprintf(wb, "The parameter '%s' of query %zu is not a string.", name, i);
+                return HTTP_RESP_BAD_REQUEST;
+            }
+
+            // the json object owns the string, until the batch is done
+            char *v = (char *)json_object_get_string(value);
+
+            if(!strcmp(name, "id"))
+                q->id = v;
+
+            else if(!strcmp(name, "scope_nodes") || !strcmp(name, "nodes")) {
+                buffer_sprintf(wb, "The nodes of query %zu have to be given in the URL, they are shared by all the queries.", i);
+                return HTTP_RESP_BAD_REQUEST;
+            }
+
+            else if(!api_v2_data_request_set(&q->r, name, v)) {
+                buffer_sprintf(wb, "The parameter '%s' of query %zu is not a data query parameter.", name, i);
+                return HTTP_RESP_BAD_REQUEST;
+            }
+        }
+    }
+
+    return HTTP_RESP_OK;
+}
+
+int api_v3_batch(RRDHOST *host __maybe_unused, struct web_client *w, char *url) {
+    usec_t received_ut = now_monotonic_usec();
+    buffer_flush(w->response.data);
+
+    if(w->mode != HTTP_REQUEST_MODE_POST || !w->payload || !buffer_strlen(w->payload)) {
+        buffer_strcat(w->response.data, "The batch API requires a POST with the queries in the payload.");
+        return HTTP_RESP_BAD_REQUEST;
+    }
+
+    struct api_v2_data_request shared;
+    api_v2_data_request_init(&shared);
+
+    while(url) {
+        char *value = strsep_skip_consecutive_separators(&url, "&");
+        if(!value || !*value) continue;
+
+        char *name = strsep_skip_consecutive_separators(&value, "=");
+        if(!name || !*name) continue;
+        if(!value || !*value) continue;
+
+        api_v2_data_request_set(&shared, name, value);
+    }
+
+    CLEAN_JSON_OBJECT *jobj = json_tokener_parse(buffer_tostring(w->payload));
+    if(!jobj) {
+        buffer_strcat(w->response.data, "The payload cannot be parsed as a JSON object.");
+        return HTTP_RESP_BAD_REQUEST;
+    }
+
+    struct batch *b = callocz(1, sizeof(*b));
+    b->w = w;
+    b->received_ut = received_ut;
+    b->scope_nodes = shared.scope_nodes;
+    b->nodes = shared.nodes;
+
+    int ret = batch_parse_payload(b, &shared, jobj);
+    if(ret != HTTP_RESP_OK)
+        goto cleanup;
+
+    int timeout = (shared.timeout_str && *shared.timeout_str) ? str2i(shared.timeout_str) : 0;
+    web_client_timeout_checkpoint_set(w, timeout);
+
+    query_scope_nodes_resolve(&b->scope, b->scope_nodes, b->nodes);
+
+    size_t helpers = b->used - 1;
+    if(helpers > query_threads_available())
+        helpers = query_threads_available();
+
+    query_threads_run(batch_worker, b, helpers);
+
+    query_scope_nodes_release(&b->scope);
+
+    // multiplex the responses
+    BUFFER *wb = w->response.data;
+    bool relative = false;
+
+    buffer_json_initialize(wb, "\"", "\"", 0, true, (shared.options & RRDR_OPTION_MINIFY) ? BUFFER_JSON_OPTIONS_MINIFY : BUFFER_JSON_OPTIONS_DEFAULT);
+    buffer_json_member_add_uint64(wb, "api", 3);
+    buffer_json_member_add_array(wb, "queries");
+    for(size_t i = 0; i < b->used ; i++) {
+        struct batch_query *q = &b->queries[i];
+        relative |= q->relative;
+
+        buffer_json_add_array_item_object(wb);
+        if(q->id)
+            buffer_json_member_add_string(wb, "id", q->id);
+        buffer_json_member_add_int64(wb, "status", q->ret);
+
+        if(q->ret == HTTP_RESP_OK && buffer_strlen(q->wb)) {
+            // the response of the query is a complete JSON object
+            buffer_print_json_comma_newline_spacing(wb);
+            buffer_print_json_key(wb, "result");
+            buffer_fast_strcat(wb, ":", 1);
+            buffer_fast_strcat(wb, buffer_tostring(q->wb), buffer_strlen(q->wb));
+            wb->json.stack[wb->json.depth].count++;
+        }
+        else
+            buffer_json_member_add_string(wb, "error", buffer_tostring(q->wb));
+
+        buffer_json_object_close(wb);
+    }
+    buffer_json_array_close(wb);
+    buffer_json_member_add_uint64(wb, "duration_ut", now_monotonic_usec() - received_ut);
+    buffer_json_finalize(wb);
+
+    if(relative)
+        buffer_no_cacheable(wb);
+    else
+        buffer_cacheable(wb);
+
+    ret = HTTP_RESP_OK;
+
+cleanup:
+    for(size_t i = 0; i < b->used ; i++)
+        buffer_free(b->queries[i].wb);
+
+    freez(b);
+    return ret;
+}
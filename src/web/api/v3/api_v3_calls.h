@@ -7,5 +7,7 @@
 
 int api_v3_settings(RRDHOST *host, struct web_client *w, char *url);
 int api_v3_me(RRDHOST *host, struct web_client *w, char *url);
+int api_v3_live(RRDHOST *host, struct web_client *w, char *url);
+int api_v3_batch(RRDHOST *host, struct web_client *w, char *url);
 
 #endif //NETDATA_API_V3_CALLS_H
@@ -0,0 +1,503 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "api_v3_calls.h"
+
+// ----------------------------------------------------------------------------
+// live data subscriptions, over server-sent events
+//
+// Instead of polling the data API for every chart every second, a client
+// subscribes once to a set of charts, and the server pushes the new values
+// of their dimensions, every time the charts are collected.
+//
+// The values are the ones the collectors have just stored to the database,
+// so nothing is queried: the collector of each chart formats its values once
+// per iteration and appends them to the output buffers of its subscribers.
+// A single thread sends the output buffers of all the subscribers to their
+// sockets, and disconnects the clients that do not consume them fast enough.
+//
+// Charts created after the subscription are not included: the client has to
+// subscribe again to get them.
+
+#define LIVE_MAX_CHARTS_PER_SUBSCRIPTION 1000
+#define LIVE_MAX_PENDING_BYTES (1 * 1024 * 1024)
+#define LIVE_KEEPALIVE_SECONDS 30
+#define LIVE_POLL_TIMEOUT_MS 100
+
+struct live_subscriber {
+    RRDHOST *host;
+    int fd;
+    NETDATA_SSL ssl;
+    char client_ip[INET6_ADDRSTRLEN];
+    char client_port[NI_MAXSERV];
+
+    SPINLOCK spinlock;              // protects out and too_slow
+    BUFFER *out;                    // appended by the collectors
+    bool too_slow;                  // out has grown above LIVE_MAX_PENDING_BYTES
+
+    BUFFER *sending;                // owned by the live thread, never modified while being sent
+    size_t sent;                    // the bytes of sending already sent
+
+    time_t last_sent_s;
+
+    size_t used;
+    RRDSET_ACQUIRED *charts[LIVE_MAX_CHARTS_PER_SUBSCRIPTION];
+
+    struct live_subscriber *prev, *next;
+};
+
+struct rrdset_live {
+    SPINLOCK spinlock;              // protects the subscribers array
+    size_t used;
+    size_t size;
+    struct live_subscriber **subscribers;
+};
+
+static struct {
+    SPINLOCK spinlock;              // protects the list and the thread
+    size_t count;
+    struct live_subscriber *list;
+    ND_THREAD *thread;
+} live = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .count = 0,
+    .list = NULL,
+    .thread = NULL,
+};
+
+// ----------------------------------------------------------------------------
+// the collectors side
+
+static void rrdset_live_add_subscriber(RRDSET *st, struct live_subscriber *s) {
+    struct rrdset_live *l = __atomic_load_n(&st->live, __ATOMIC_ACQUIRE);
+    if(!l) {
+        struct rrdset_live *nl = callocz(1, sizeof(*nl));
+        spinlock_init(&nl->spinlock);
+
+        struct rrdset_live *expected = NULL;
+        if(__atomic_compare_exchange_n(&st->live, &expected, nl, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+            l = nl;
+        else {
+            // another subscriber installed it first
+            freez(nl);
+            l = expected;
+        }
+    }
+
+    spinlock_lock(&l->spinlock);
+    if(l->used == l->size) {
+        l->size = l->size ? l->size * 2 : 2;
+        l->subscribers = reallocz(l->subscribers, l->size * sizeof(*l->subscribers));
+    }
+    l->subscribers[l->used] = s;
+    __atomic_store_n(&l->used, l->used + 1, __ATOMIC_RELEASE);
+    spinlock_unlock(&l->spinlock);
+}
+
+static void rrdset_live_del_subscriber(RRDSET *st, struct live_subscriber *s) {
+    struct rrdset_live *l = __atomic_load_n(&st->live, __ATOMIC_ACQUIRE);
+    if(!l)
+        return;
+
+    spinlock_lock(&l->spinlock);
+    for(size_t i = 0; i < l->used ; i++) {
+        if(l->subscribers[i] == s) {
+            l->subscribers[i] = l->subscribers[l->used - 1];
+            __atomic_store_n(&l->used, l->used - 1, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    spinlock_unlock(&l->spinlock);
+}
+
+static void live_chart_values_to_json(BUFFER *wb, RRDSET *st) {
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_MINIFY);
+    buffer_json_member_add_string(wb, "chart", rrdset_id(st));
+    buffer_json_member_add_time_t(wb, "t", st->last_updated.tv_sec);
+    buffer_json_member_add_object(wb, "v");
+    {
+        RRDDIM *rd;
+        rrddim_foreach_read(rd, st) {
+            if(rrddim_flag_check(rd, RRDDIM_FLAG_OBSOLETE))
+                continue;
+
+            buffer_json_member_add_double(wb, rrddim_id(rd), rd->collector.last_stored_value);
+        }
+        rrddim_foreach_done(rd);
+    }
+    buffer_json_object_close(wb);
+    buffer_json_finalize(wb);
+}
+
+// called by the collector of a chart that has (or had) subscribers, after it stored its values
+void rrdset_live_collected(RRDSET *st) {
+    struct rrdset_live *l = __atomic_load_n(&st->live, __ATOMIC_ACQUIRE);
+    if(!l || !__atomic_load_n(&l->used, __ATOMIC_ACQUIRE))
+        return;
+
+    static __thread BUFFER *wb = NULL;
+    if(unlikely(!wb))
+        wb = buffer_create(1024, NULL);
+
+    buffer_flush(wb);
+    live_chart_values_to_json(wb, st);
+
+    spinlock_lock(&l->spinlock);
+    for(size_t i = 0; i < l->used ; i++) {
+        struct live_subscriber *s = l->subscribers[i];
+
+        spinlock_lock(&s->spinlock);
+        if(buffer_strlen(s->out) + buffer_strlen(wb) > LIVE_MAX_PENDING_BYTES)
+            s->too_slow = true;
+
+        else if(!s->too_slow) {
+            buffer_fast_strcat(s->out, "event: data\ndata: ", 18);
+            buffer_fast_strcat(s->out, buffer_tostring(wb), buffer_strlen(wb));
+            buffer_fast_strcat(s->out, "\n\n", 2);
+        }
+        spinlock_unlock(&s->spinlock);
+    }
+    spinlock_unlock(&l->spinlock);
+}
+
+// called when the chart is deleted - it cannot have subscribers, since they acquire it
+void rrdset_live_free(RRDSET *st) {
+    struct rrdset_live *l = __atomic_exchange_n(&st->live, NULL, __ATOMIC_ACQ_REL);
+    if(!l)
+        return;
+
+    internal_fatal(l->used, "LIVE: chart '%s' is freed while it has subscribers", rrdset_id(st));
+
+    freez(l->subscribers);
+    freez(l);
+}
+
+// ----------------------------------------------------------------------------
+// the live thread, sending the output of the subscribers to their sockets
+
+static void live_subscriber_free(struct live_subscriber *s, const char *reason) {
+    nd_log(NDLS_ACCESS, NDLP_DEBUG,
+           "LIVE: client [%s]:%s disconnected, %s",
+           s->client_ip, s->client_port, reason);
+
+    // the collectors cannot reach it after this
+    for(size_t i = 0; i < s->used ; i++) {
+        rrdset_live_del_subscriber(rrdset_acquired_to_rrdset(s->charts[i]), s);
+        rrdset_acquired_release(s->charts[i]);
+    }
+
+    spinlock_lock(&live.spinlock);
+    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(live.list, s, prev, next);
+    live.count--;
+    spinlock_unlock(&live.spinlock);
+
+    netdata_ssl_close(&s->ssl);
+    close(s->fd);
+
+    buffer_free(s->out);
+    buffer_free(s->sending);
+    freez(s);
+}
+
+// returns false when the client has to be disconnected
+static bool live_subscriber_receive(struct live_subscriber *s) {
+    char buf[1024];
+    ssize_t bytes;
+
+    // clients are not expected to send anything - we read only to find out they closed the connection
+    if(SSL_connection(&s->ssl))
+        bytes = netdata_ssl_read(&s->ssl, buf, sizeof(buf));
+    else
+        bytes = recv(s->fd, buf, sizeof(buf), MSG_DONTWAIT);
+
+    if(bytes > 0)
+        return true;
+
+    if(bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return true;
+
+    return false;
+}
+
+// returns false when the client has to be disconnected
+static bool live_subscriber_send(struct live_subscriber *s, time_t now_s) {
+    if(s->sent == buffer_strlen(s->sending)) {
+        buffer_flush(s->sending);
+        s->sent = 0;
+
+        spinlock_lock(&s->spinlock);
+        if(s->too_slow) {
+            spinlock_unlock(&s->spinlock);
+            return false;
+        }
+
+        if(!buffer_strlen(s->out) && now_s - s->last_sent_s >= LIVE_KEEPALIVE_SECONDS)
+            buffer_fast_strcat(s->out, ": keepalive\n\n", 13);
+
+        BUFFER *t = s->sending;
+        s->sending = s->out;
+        s->out = t;
+        spinlock_unlock(&s->spinlock);
+    }
+
+    while(s->sent < buffer_strlen(s->sending)) {
+        // on ssl connections, a retry has to be made with the same data
+        const char *data = &s->sending->buffer[s->sent];
+        size_t len = buffer_strlen(s->sending) - s->sent;
+        ssize_t bytes;
+
+        if(SSL_connection(&s->ssl))
+            bytes = netdata_ssl_write(&s->ssl, data, len);
+        else
+            bytes = send(s->fd, data, len, MSG_DONTWAIT);
+
+        if(bytes <= 0) {
+            if(bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+                break;
+
+            return false;
+        }
+
+        s->sent += bytes;
+        s->last_sent_s = now_s;
+    }
+
+    return true;
+}
+
+static bool live_subscriber_has_output(struct live_subscriber *s) {
+    if(s->sent < buffer_strlen(s->sending))
+        return true;
+
+    spinlock_lock(&s->spinlock);
+    bool ret = buffer_strlen(s->out) || s->too_slow;
+    spinlock_unlock(&s->spinlock);
+
+    return ret;
+}
+
+static void *live_thread(void *ptr __maybe_unused) {
+    struct pollfd *fds = NULL;
+    struct live_subscriber **subs = NULL;
+    size_t size = 0;
+
+    while(service_running(SERVICE_WEB_SERVER) && !nd_thread_signaled_to_cancel()) {
+        // only this thread removes subscribers, so they are valid after we unlock
+        spinlock_lock(&live.spinlock);
+        if(live.count > size) {
+            size = live.count * 2;
+            fds = reallocz(fds, size * sizeof(*fds));
+            subs = reallocz(subs, size * sizeof(*subs));
+        }
+
+        size_t used = 0;
+        for(struct live_subscriber *s = live.list; s ; s = s->next)
+            subs[used++] = s;
+        spinlock_unlock(&live.spinlock);
+
+        for(size_t i = 0; i < used ; i++) {
+            fds[i].fd = subs[i]->fd;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+
+            if(live_subscriber_has_output(subs[i]))
+                fds[i].events |= POLLOUT;
+        }
+
+        if(!used) {
+            sleep_usec(LIVE_POLL_TIMEOUT_MS * USEC_PER_MS);
+            continue;
+        }
+
+        if(poll(fds, used, LIVE_POLL_TIMEOUT_MS) < 0 && errno != EINTR) {
+            nd_log(NDLS_DAEMON, NDLP_ERR, "LIVE: poll() failed");
+            sleep_usec(LIVE_POLL_TIMEOUT_MS * USEC_PER_MS);
+            continue;
+        }
+
+        time_t now_s = now_monotonic_sec();
+        for(size_t i = 0; i < used ; i++) {
+            struct live_subscriber *s = subs[i];
+
+            if(fds[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+                live_subscriber_free(s, "the connection was closed");
+
+            else if((fds[i].revents & POLLIN) && !live_subscriber_receive(s))
+                live_subscriber_free(s, "the connection was closed");
+
+            else if(rrdhost_flag_check(s->host, RRDHOST_FLAG_ORPHAN | RRDHOST_FLAG_ARCHIVED))
+                live_subscriber_free(s, "the node is not collected any more");
+
+            else if(!live_subscriber_send(s, now_s))
+                live_subscriber_free(s, s->too_slow ? "it does not consume the data fast enough" : "sending failed");
+        }
+    }
+
+    // the web server is stopping, disconnect everyone
+    while(live.list)
+        live_subscriber_free(live.list, "netdata is exiting");
+
+    freez(fds);
+    freez(subs);
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// the api call
+
+static void live_subscriber_charts_to_json(BUFFER *wb, struct live_subscriber *s) {
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_MINIFY);
+    buffer_json_member_add_string(wb, "node", rrdhost_hostname(s->host));
+    buffer_json_member_add_array(wb, "charts");
+    for(size_t i = 0; i < s->used ; i++) {
+        RRDSET *st = rrdset_acquired_to_rrdset(s->charts[i]);
+
+        buffer_json_add_array_item_object(wb);
+        buffer_json_member_add_string(wb, "id", rrdset_id(st));
+        buffer_json_member_add_string(wb, "name", rrdset_name(st));
+        buffer_json_member_add_string(wb, "context", rrdset_context(st));
+        buffer_json_member_add_string(wb, "units", rrdset_units(st));
+        buffer_json_member_add_time_t(wb, "update_every", st->update_every);
+        buffer_json_member_add_array(wb, "dimensions");
+        {
+            RRDDIM *rd;
+            rrddim_foreach_read(rd, st) {
+                if(rrddim_flag_check(rd, RRDDIM_FLAG_OBSOLETE))
+                    continue;
+
+                buffer_json_add_array_item_object(wb);
+                buffer_json_member_add_string(wb, "id", rrddim_id(rd));
+                buffer_json_member_add_string(wb, "name", rrddim_name(rd));
+                buffer_json_object_close(wb);
+            }
+            rrddim_foreach_done(rd);
+        }
+        buffer_json_array_close(wb);
+        buffer_json_object_close(wb);
+    }
+    buffer_json_array_close(wb);
+    buffer_json_finalize(wb);
+}
+
+int api_v3_live(RRDHOST *host, struct web_client *w, char *url) {
+    const char *charts = NULL, *contexts = NULL;
+
+    while(url) {
+        char *value = strsep_skip_consecutive_separators(&url, "&");
+        if(!value || !*value) continue;
+
+        char *name = strsep_skip_consecutive_separators(&value, "=");
+        if(!name || !*name) continue;
+        if(!value || !*value) continue;
+
+        if(!strcmp(name, "charts"))
+            charts = value;
+        else if(!strcmp(name, "contexts"))
+            contexts = value;
+    }
+
+    BUFFER *wb = w->response.data;
+    buffer_flush(wb);
+    wb->content_type = CT_TEXT_PLAIN;
+
+    if(web_server_mode != WEB_SERVER_MODE_STATIC_THREADED || (w->port_acl & HTTP_ACL_H2O) ||
+        web_client_check_conn_cloud(w) || web_client_check_conn_webrtc(w)) {
+        buffer_strcat(wb, "Live subscriptions are supported only on direct connections to the static threaded web server.");
+        return HTTP_RESP_BAD_REQUEST;
+    }
+
+    if(!charts && !contexts) {
+        buffer_strcat(wb, "Please give the charts or the contexts to subscribe to, as simple patterns.");
+        return HTTP_RESP_BAD_REQUEST;
+    }
+
+    SIMPLE_PATTERN *charts_sp = charts ? simple_pattern_create(charts, ",|\t\r\n\f\v", SIMPLE_PATTERN_EXACT, true) : NULL;
+    SIMPLE_PATTERN *contexts_sp = contexts ? simple_pattern_create(contexts, ",|\t\r\n\f\v", SIMPLE_PATTERN_EXACT, true) : NULL;
+
+    struct live_subscriber *s = callocz(1, sizeof(*s));
+    s->host = host;
+
+    RRDSET *st;
+    rrdset_foreach_read(st, host) {
+        if(!rrdset_is_available_for_viewers(st))
+            continue;
+
+        if(charts_sp && !simple_pattern_matches_string(charts_sp, st->id) && !simple_pattern_matches_string(charts_sp, st->name))
+            continue;
+
+        if(contexts_sp && !simple_pattern_matches_string(contexts_sp, st->context))
+            continue;
+
+        if(s->used == LIVE_MAX_CHARTS_PER_SUBSCRIPTION)
+            break;
+
+        s->charts[s->used++] = (RRDSET_ACQUIRED *)dictionary_acquired_item_dup(host->rrdset_root_index, st_dfe.item);
+    }
+    rrdset_foreach_done(st);
+
+    simple_pattern_free(charts_sp);
+    simple_pattern_free(contexts_sp);
+
+    if(!s->used) {
+        freez(s);
+        buffer_strcat(wb, "No charts match the subscription.");
+        return HTTP_RESP_NOT_FOUND;
+    }
+
+    spinlock_init(&s->spinlock);
+    s->out = buffer_create(LIVE_MAX_PENDING_BYTES / 16, NULL);
+    s->sending = buffer_create(LIVE_MAX_PENDING_BYTES / 16, NULL);
+    s->last_sent_s = now_monotonic_sec();
+    strncpyz(s->client_ip, w->client_ip, sizeof(s->client_ip) - 1);
+    strncpyz(s->client_port, w->client_port, sizeof(s->client_port) - 1);
+
+    buffer_sprintf(s->out,
+                   "HTTP/1.1 200 OK\r\n"
+                   "Connection: keep-alive\r\n"
+                   "Server: Netdata Embedded HTTP Server %s\r\n"
+                   "Access-Control-Allow-Origin: %s\r\n"
+                   "Access-Control-Allow-Credentials: true\r\n"
+                   "Content-Type: text/event-stream\r\n"
+                   "Cache-Control: no-cache\r\n"
+                   "\r\n",
+                   NETDATA_VERSION,
+                   w->origin ? w->origin : "*");
+
+    // the first event describes the charts of the subscription
+    BUFFER *tmp = buffer_create(0, NULL);
+    live_subscriber_charts_to_json(tmp, s);
+    buffer_strcat(s->out, "event: charts\ndata: ");
+    buffer_fast_strcat(s->out, buffer_tostring(tmp), buffer_strlen(tmp));
+    buffer_strcat(s->out, "\n\n");
+    buffer_free(tmp);
+
+    // take over the socket of the web client
+    s->fd = w->ifd;
+    s->ssl.conn = w->ssl.conn;
+    s->ssl.state = w->ssl.state;
+    w->ssl = NETDATA_SSL_UNSET_CONNECTION;
+
+    WEB_CLIENT_IS_DEAD(w);
+    web_client_flag_set(w, WEB_CLIENT_FLAG_DONT_CLOSE_SOCKET);
+    buffer_flush(w->response.data);
+
+    sock_setnonblock(s->fd);
+
+    // the collectors start appending to it from now on
+    for(size_t i = 0; i < s->used ; i++)
+        rrdset_live_add_subscriber(rrdset_acquired_to_rrdset(s->charts[i]), s);
+
+    nd_log(NDLS_ACCESS, NDLP_DEBUG,
+           "LIVE: client [%s]:%s subscribed to %zu charts of node '%s'",
+           s->client_ip, s->client_port, s->used, rrdhost_hostname(host));
+
+    // the live thread may free it as soon as it sees it
+    spinlock_lock(&live.spinlock);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(live.list, s, prev, next);
+    live.count++;
+
+    if(!live.thread)
+        live.thread = nd_thread_create("LIVE", NETDATA_THREAD_OPTION_DEFAULT, live_thread, NULL);
+    spinlock_unlock(&live.spinlock);
+
+    return HTTP_RESP_OK;
+}
@@ -72,7 +72,20 @@ int web_client_api_request_vX(RRDHOST *host, struct web_client *w, char *url_pat
             if(*query_string == '?')
                 query_string = &query_string[1];
 
-            return api_commands[i].callback(host, w, query_string);
+            // allocate the response buffer once, instead of growing it while the response is generated
+            size_t response_size = __atomic_load_n(&api_commands[i].response_size, __ATOMIC_RELAXED);
+            if(response_size)
+                buffer_need_bytes(w->response.data, MIN(response_size, NETDATA_WEB_RESPONSE_MAX_PREALLOCATION));
+
+            int ret = api_commands[i].callback(host, w, query_string);
+
+            // follow the biggest of the recent responses, forgetting the old ones slowly
+            size_t len = buffer_strlen(w->response.data);
+            __atomic_store_n(&api_commands[i].response_size,
+                             (len > response_size) ? len : response_size - response_size / 16,
+                             __ATOMIC_RELAXED);
+
+            return ret;
         }
     }
 
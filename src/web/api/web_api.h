@@ -32,6 +32,8 @@ struct web_api_command {
     HTTP_ACCESS access;
     int (*callback)(RRDHOST *host, struct web_client *w, char *url);
     unsigned int allow_subpaths;
+
+    size_t response_size;   // the size of its recent responses, to preallocate the response buffer
 };
 
 struct web_client;
@@ -15,6 +15,24 @@ static struct web_api_command api_commands_v3[] = {
         .callback = api_v2_data,
         .allow_subpaths = 0
     },
+    // live data subscriptions, pushed as server-sent events
+    {
+        .api = "live",
+        .hash = 0,
+        .acl = HTTP_ACL_METRICS,
+        .access = HTTP_ACCESS_ANONYMOUS_DATA,
+        .callback = api_v3_live,
+        .allow_subpaths = 0
+    },
+    // many data queries of the same scope, in one request
+    {
+        .api = "batch",
+        .hash = 0,
+        .acl = HTTP_ACL_METRICS,
+        .access = HTTP_ACCESS_ANONYMOUS_DATA,
+        .callback = api_v3_batch,
+        .allow_subpaths = 0
+    },
     // badges
     {
      .api = "badge.svg",
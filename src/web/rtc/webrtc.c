@@ -12,6 +12,7 @@
 #define WEBRTC_OUR_MAX_MESSAGE_SIZE (5 * 1024 * 1024)
 #define WEBRTC_DEFAULT_REMOTE_MAX_MESSAGE_SIZE (65536)
 #define WEBRTC_COMPRESSED_HEADER_SIZE 200
+#define WEBRTC_REQUEST_ID_MAX 64
 
 static void webrtc_log(rtcLogLevel level, const char *message) {
     switch(level) {
@@ -228,7 +229,7 @@ static bool web_client_stop_callback(struct web_client *w __maybe_unused, void *
     return !webrtc_dc_is_open(chan);
 }
 
-static size_t webrtc_send_in_chunks(WEBRTC_DC *chan, const char *data, size_t size, int code, const char *message_type, HTTP_CONTENT_TYPE content_type, size_t max_message_size, bool binary) {
+static size_t webrtc_send_in_chunks(WEBRTC_DC *chan, const char *request_id, const char *data, size_t size, int code, const char *message_type, HTTP_CONTENT_TYPE content_type, size_t max_message_size, bool binary) {
     size_t sent_bytes = 0;
     size_t chunk = 0;
     size_t total_chunks = size / max_message_size;
@@ -244,13 +245,16 @@ static size_t webrtc_send_in_chunks(WEBRTC_DC *chan, const char *data, size_t si
 
         size_t message_size = MIN(remaining, max_message_size);
 
-        int len = snprintfz(send_buffer, WEBRTC_COMPRESSED_HEADER_SIZE, "%d %s %zu %zu %zu %s\r\n",
+        // the id of the request is appended, so that the clients not using ids parse the header as before
+        int len = snprintfz(send_buffer, WEBRTC_COMPRESSED_HEADER_SIZE, "%d %s %zu %zu %zu %s%s%s\r\n",
                             code,
                             message_type,
                             message_size,
                             chunk,
                             total_chunks,
-                            content_type_id2string(content_type)
+                            content_type_id2string(content_type),
+                            *request_id ? " #" : "",
+                            request_id
         );
 
         internal_fatal((size_t)len != strlen(send_buffer), "WEBRTC compressed header line mismatch");
@@ -299,16 +303,59 @@ static void webrtc_execute_api_request(WEBRTC_DC *chan, const char *request, siz
     w->port_acl = HTTP_ACL_WEBRTC | HTTP_ACL_ALL_FEATURES;
     w->acl = w->port_acl;
 
-    char *path = (char *)request;
-    if(strncmp(request, "POST ", 5) == 0) {
+    // binary messages are not null terminated
+    CLEAN_BUFFER *req = buffer_create(size + 1, NULL);
+    buffer_fast_strcat(req, request, size);
+    char *path = req->buffer;
+
+    // the request may start with an id, given back with every chunk of its response,
+    // so that a client can have many requests in flight on the same data channel
+    char request_id[WEBRTC_REQUEST_ID_MAX + 1] = "";
+    if(*path == '#') {
+        path++;
+        size_t len = 0;
+        while(*path && !isspace((uint8_t)*path)) {
+            if(len < WEBRTC_REQUEST_ID_MAX)
+                request_id[len++] = *path;
+            path++;
+        }
+        request_id[len] = '\0';
+
+        while(isspace((uint8_t)*path))
+            path++;
+    }
+
+    if(strncmp(path, "POST ", 5) == 0) {
         w->mode = HTTP_REQUEST_MODE_POST;
-        path += 10;
+        path += 5;
     }
-    else if(strncmp(request, "GET ", 4) == 0) {
+    else if(strncmp(path, "GET ", 4) == 0) {
         w->mode = HTTP_REQUEST_MODE_GET;
         path += 4;
     }
 
+    // the payload of a POST follows the request line, after an empty line
+    char *payload = strstr(path, "\r\n\r\n");
+    if(payload) {
+        *payload = '\0';
+        payload += 4;
+    }
+    else if((payload = strstr(path, "\n\n"))) {
+        *payload = '\0';
+        payload += 2;
+    }
+    else {
+        char *eol = strpbrk(path, "\r\n");
+        if(eol) *eol = '\0';
+    }
+
+    if(payload && *payload && w->mode == HTTP_REQUEST_MODE_POST) {
+        if(!w->payload)
+            w->payload = buffer_create(strlen(payload) + 1, NULL);
+
+        buffer_strcat(w->payload, payload);
+    }
+
     web_client_timeout_checkpoint_set(w, 0);
     web_client_decode_path_and_query_string(w, path);
     path = (char *)buffer_tostring(w->url_path_decoded);
@@ -340,7 +387,7 @@ static void webrtc_execute_api_request(WEBRTC_DC *chan, const char *request, siz
 
     if(compressed_size > 0) {
         send_plain = false;
-        sent_bytes = webrtc_send_in_chunks(chan, compressed, compressed_size,
+        sent_bytes = webrtc_send_in_chunks(chan, request_id, compressed, compressed_size,
                                            w->response.code, "LZ4", w->response.data->content_type,
                                            max_message_size, true);
     }
@@ -348,7 +395,7 @@ static void webrtc_execute_api_request(WEBRTC_DC *chan, const char *request, siz
 #endif
 
     if(send_plain)
-        sent_bytes = webrtc_send_in_chunks(chan, buffer_tostring(w->response.data), buffer_strlen(w->response.data),
+        sent_bytes = webrtc_send_in_chunks(chan, request_id, buffer_tostring(w->response.data), buffer_strlen(w->response.data),
                               w->response.code, "PLAIN", w->response.data->content_type,
                               max_message_size, false);
 
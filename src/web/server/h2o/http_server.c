@@ -3,6 +3,7 @@
 #include "daemon/common.h"
 #include "streaming/common.h"
 #include "http_server.h"
+#include "web/server/web_client_cache.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -110,6 +111,321 @@ static int ssl_init()
     return 0;
 }
 
+// ----------------------------------------------------------------------------
+// API requests
+//
+// The API requests are executed by a pool of threads, so that a slow query
+// does not block the event loop, and with it all the other requests that are
+// multiplexed on the same HTTP/2 connection. The threads give the responses
+// back to the event loop with an h2o multithread queue, and the event loop
+// sends them to the clients.
+
+#define HTTPD_API_THREADS_MAX 64
+
+struct h2o_api_job;
+
+// allocated in the memory pool of the request, to know when h2o disposes it
+struct h2o_api_job_ref {
+    struct h2o_api_job *job;
+};
+
+typedef struct h2o_api_job {
+    h2o_multithread_message_t message;
+    h2o_req_t *req;                     // NULL when the request has been disposed - event loop only
+    struct h2o_api_job_ref *ref;
+    bool cancelled;                     // the client went away, the query should stop
+    struct web_client *w;
+    struct h2o_api_job *prev, *next;
+} H2O_API_JOB;
+
+static struct {
+    size_t threads;
+    bool exit;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                // signals the api threads there are jobs
+
+    H2O_API_JOB *queue;
+
+    h2o_multithread_queue_t *responses;
+    h2o_multithread_receiver_t receiver;
+} api_jobs = {
+    .threads = 0,
+    .exit = false,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .queue = NULL,
+    .responses = NULL,
+};
+
+static bool h2o_api_job_interrupt_callback(struct web_client *w __maybe_unused, void *data) {
+    H2O_API_JOB *job = data;
+    return __atomic_load_n(&job->cancelled, __ATOMIC_RELAXED);
+}
+
+static void h2o_api_req_disposed(void *ptr) {
+    struct h2o_api_job_ref *ref = ptr;
+
+    if(ref->job) {
+        ref->job->req = NULL;
+        __atomic_store_n(&ref->job->cancelled, true, __ATOMIC_RELAXED);
+    }
+}
+
+static void h2o_api_add_header(h2o_req_t *req, const char *name, size_t name_len, const char *value, size_t value_len) {
+    // HTTP/2 needs lower case header names
+    h2o_iovec_t n = h2o_strdup(&req->pool, name, name_len);
+    h2o_strtolower(n.base, n.len);
+
+    // these are set by h2o, depending on the protocol
+    if(h2o_memis(n.base, n.len, H2O_STRLIT("connection")) ||
+        h2o_memis(n.base, n.len, H2O_STRLIT("keep-alive")) ||
+        h2o_memis(n.base, n.len, H2O_STRLIT("transfer-encoding")) ||
+        h2o_memis(n.base, n.len, H2O_STRLIT("content-length")) ||
+        h2o_memis(n.base, n.len, H2O_STRLIT("server")))
+        return;
+
+    h2o_iovec_t v = h2o_strdup(&req->pool, value, value_len);
+    h2o_add_header_by_str(&req->pool, &req->res.headers, n.base, n.len, 1, NULL, v.base, v.len);
+}
+
+// adds to the response the headers the web server would send, skipping its HTTP/1.1 status line
+static void h2o_api_add_headers(h2o_req_t *req, BUFFER *header) {
+    const char *s = buffer_tostring(header);
+    bool status_line = true;
+
+    while(*s) {
+        const char *eol = strstr(s, "\r\n");
+        size_t line_len = eol ? (size_t)(eol - s) : strlen(s);
+        const char *colon = memchr(s, ':', line_len);
+
+        if(!status_line && colon && colon > s) {
+            const char *value = colon + 1;
+            while(value < s + line_len && isspace((uint8_t)*value))
+                value++;
+
+            h2o_api_add_header(req, s, colon - s, value, s + line_len - value);
+        }
+
+        status_line = false;
+        s += line_len;
+        if(eol)
+            s += 2;
+    }
+}
+
+static void h2o_api_send_response(h2o_req_t *req, struct web_client *w) {
+    static h2o_generator_t generator = { NULL, NULL };
+
+    web_client_build_http_header(w);
+
+    // the body has to live until the whole response has been encrypted and sent,
+    // so we copy it to the memory pool of the request, that is freed with it
+    h2o_iovec_t body = h2o_strdup(&req->pool, buffer_tostring(w->response.data), buffer_strlen(w->response.data));
+
+    req->res.status = w->response.code;
+    req->res.reason = http_response_code2string(w->response.code);
+    req->res.content_length = body.len;
+    h2o_api_add_headers(req, w->response.header_output);
+
+    h2o_start_response(req, &generator);
+    h2o_send(req, &body, 1, H2O_SEND_STATE_FINAL);
+
+    w->statistics.sent_bytes = body.len;
+}
+
+static void h2o_api_job_execute(H2O_API_JOB *job) {
+    struct web_client *w = job->w;
+
+    char *path = (char *)buffer_tostring(w->url_path_decoded);
+    w->response.code = (short)web_client_api_request_with_node_selection(localhost, w, path);
+    web_client_timeout_checkpoint_response_ready(w, NULL);
+}
+
+// runs in the event loop
+static void h2o_api_job_done(H2O_API_JOB *job) {
+    if(job->ref)
+        job->ref->job = NULL;
+
+    if(job->req)
+        h2o_api_send_response(job->req, job->w);
+
+    web_client_log_completed_request(job->w, false);
+    web_client_release_to_cache(job->w);
+    freez(job);
+}
+
+static void h2o_api_on_responses(h2o_multithread_receiver_t *receiver __maybe_unused, h2o_linklist_t *messages) {
+    while(!h2o_linklist_is_empty(messages)) {
+        H2O_API_JOB *job = H2O_STRUCT_FROM_MEMBER(H2O_API_JOB, message.link, messages->next);
+        h2o_linklist_unlink(&job->message.link);
+        h2o_api_job_done(job);
+    }
+}
+
+static void h2o_api_threads_canceller(void *data __maybe_unused) {
+    pthread_mutex_lock(&api_jobs.mutex);
+    api_jobs.exit = true;
+    pthread_cond_broadcast(&api_jobs.cond);
+    pthread_mutex_unlock(&api_jobs.mutex);
+}
+
+static void *h2o_api_thread_main(void *arg __maybe_unused) {
+    worker_register("H2OAPI");
+    worker_register_job_name(0, "request");
+
+    nd_thread_register_canceller(h2o_api_threads_canceller, NULL);
+
+    pthread_mutex_lock(&api_jobs.mutex);
+
+    while(true) {
+        while(!api_jobs.queue && !api_jobs.exit && !nd_thread_signaled_to_cancel())
+            pthread_cond_wait(&api_jobs.cond, &api_jobs.mutex);
+
+        if(api_jobs.exit || nd_thread_signaled_to_cancel())
+            break;
+
+        H2O_API_JOB *job = api_jobs.queue;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(api_jobs.queue, job, prev, next);
+
+        pthread_mutex_unlock(&api_jobs.mutex);
+
+        worker_is_busy(0);
+        h2o_api_job_execute(job);
+        worker_is_idle();
+
+        h2o_multithread_send_message(&api_jobs.receiver, &job->message);
+
+        pthread_mutex_lock(&api_jobs.mutex);
+    }
+
+    pthread_mutex_unlock(&api_jobs.mutex);
+
+    worker_unregister();
+    return NULL;
+}
+
+static void h2o_api_threads_init(h2o_loop_t *loop, size_t threads) {
+    if(threads > HTTPD_API_THREADS_MAX)
+        threads = HTTPD_API_THREADS_MAX;
+
+    if(!threads)
+        return;
+
+    api_jobs.responses = h2o_multithread_create_queue(loop);
+    h2o_multithread_register_receiver(api_jobs.responses, &api_jobs.receiver, h2o_api_on_responses);
+
+    for(size_t i = 0; i < threads ;i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "H2OAPI[%zu]", i);
+
+        if(nd_thread_create(tag, NETDATA_THREAD_OPTION_DEFAULT, h2o_api_thread_main, NULL))
+            api_jobs.threads++;
+    }
+
+    netdata_log_info("HTTPD: started %zu api threads", api_jobs.threads);
+}
+
+static char *h2o_req_header_strdupz(h2o_req_t *req, const h2o_token_t *token) {
+    ssize_t idx = h2o_find_header(&req->headers, token, -1);
+    if(idx == -1)
+        return NULL;
+
+    return iovec_to_cstr(&req->headers.entries[idx].value);
+}
+
+static void h2o_api_client_address(h2o_req_t *req, struct web_client *w) {
+    struct sockaddr_storage ss;
+    socklen_t len = req->conn->callbacks->get_peername(req->conn, (struct sockaddr *)&ss);
+    if(!len)
+        return;
+
+    size_t ip_len = h2o_socket_getnumerichost((struct sockaddr *)&ss, len, w->client_ip);
+    if(ip_len == SIZE_MAX || ip_len >= sizeof(w->client_ip))
+        w->client_ip[0] = '\0';
+    else
+        w->client_ip[ip_len] = '\0';
+
+    int32_t port = h2o_socket_getport((struct sockaddr *)&ss);
+    if(port != -1)
+        snprintfz(w->client_port, sizeof(w->client_port) - 1, "%d", (int)port);
+}
+
+// prepares a web client for the request and executes it on the api threads,
+// or in the event loop when there are no api threads
+static void h2o_api_request(h2o_req_t *req, h2o_iovec_t *path_and_query, HTTP_REQUEST_MODE mode) {
+    struct web_client *w = web_client_get_from_cache();
+    web_client_set_conn_tcp(w);
+    w->mode = mode;
+    w->port_acl = HTTP_ACL_H2O | HTTP_ACL_ALL_FEATURES;
+    w->acl = w->port_acl; // TODO - web_client_update_acl_matches(w) to restrict this based on user configuration
+
+    h2o_api_client_address(req, w);
+    w->origin = h2o_req_header_strdupz(req, H2O_TOKEN_ORIGIN);
+    w->user_agent = h2o_req_header_strdupz(req, H2O_TOKEN_USER_AGENT);
+    w->forwarded_for = h2o_req_header_strdupz(req, H2O_TOKEN_X_FORWARDED_FOR);
+    w->accept = h2o_req_header_strdupz(req, H2O_TOKEN_ACCEPT);
+
+    if(req->entity.base && req->entity.len) {
+        if(!w->payload)
+            w->payload = buffer_create(req->entity.len + 1, NULL);
+
+        buffer_memcat(w->payload, req->entity.base, req->entity.len);
+    }
+
+    w->statistics.received_bytes = path_and_query->len + req->entity.len;
+    web_client_timeout_checkpoint_set(w, 0);
+
+    char *path = iovec_to_cstr(path_and_query);
+    web_client_decode_path_and_query_string(w, path);
+    freez(path);
+
+    H2O_API_JOB *job = callocz(1, sizeof(*job));
+    job->req = req;
+    job->w = w;
+    w->interrupt.callback = h2o_api_job_interrupt_callback;
+    w->interrupt.callback_data = job;
+
+    if(!api_jobs.threads) {
+        h2o_api_job_execute(job);
+        h2o_api_job_done(job);
+        return;
+    }
+
+    job->ref = h2o_mem_alloc_shared(&req->pool, sizeof(*job->ref), h2o_api_req_disposed);
+    job->ref->job = job;
+
+    pthread_mutex_lock(&api_jobs.mutex);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(api_jobs.queue, job, prev, next);
+    pthread_cond_signal(&api_jobs.cond);
+    pthread_mutex_unlock(&api_jobs.mutex);
+}
+
+static int h2o_api_options(h2o_req_t *req) {
+    static h2o_generator_t generator = { NULL, NULL };
+
+    req->res.status = HTTP_RESP_OK;
+    req->res.reason = "OK";
+    req->res.content_length = 0;
+
+    ssize_t idx = h2o_find_header(&req->headers, H2O_TOKEN_ORIGIN, -1);
+    if(idx != -1)
+        h2o_add_header(&req->pool, &req->res.headers, H2O_TOKEN_ACCESS_CONTROL_ALLOW_ORIGIN, NULL,
+                       req->headers.entries[idx].value.base, req->headers.entries[idx].value.len);
+    else
+        h2o_add_header(&req->pool, &req->res.headers, H2O_TOKEN_ACCESS_CONTROL_ALLOW_ORIGIN, NULL, H2O_STRLIT("*"));
+
+    h2o_add_header_by_str(&req->pool, &req->res.headers, H2O_STRLIT("access-control-allow-credentials"), 0, NULL, H2O_STRLIT("true"));
+    h2o_add_header_by_str(&req->pool, &req->res.headers, H2O_STRLIT("access-control-allow-methods"), 0, NULL, H2O_STRLIT("GET, POST, OPTIONS"));
+    h2o_add_header_by_str(&req->pool, &req->res.headers, H2O_STRLIT("access-control-allow-headers"), 0, NULL,
+                          H2O_STRLIT("accept, x-requested-with, origin, content-type, cookie, pragma, cache-control, x-auth-token, x-netdata-auth, x-transaction-id"));
+    h2o_add_header_by_str(&req->pool, &req->res.headers, H2O_STRLIT("access-control-max-age"), 0, NULL, H2O_STRLIT("1209600"));
+
+    h2o_start_response(req, &generator);
+    h2o_send(req, NULL, 0, H2O_SEND_STATE_FINAL);
+    return 0;
+}
+
 // I did not find a way to do wildcard paths to make common handler for urls like:
 // /api/v1/info
 // /host/child/api/v1/info
@@ -118,10 +434,13 @@ static int ssl_init()
 // so we do it "manually" here with uberhandler
 static inline int _netdata_uberhandler(h2o_req_t *req, RRDHOST **host)
 {
-    if (!h2o_memis(req->method.base, req->method.len, H2O_STRLIT("GET")))
+    if (!h2o_memis(req->method.base, req->method.len, H2O_STRLIT("GET")) &&
+        !h2o_memis(req->method.base, req->method.len, H2O_STRLIT("POST")) &&
+        !h2o_memis(req->method.base, req->method.len, H2O_STRLIT("OPTIONS")))
         return -1;
 
-    static h2o_generator_t generator = { NULL, NULL };
+    // the API requests get the path as received, node selection included
+    h2o_iovec_t path_and_query = req->path;
 
     h2o_iovec_t norm_path = req->path_normalized;
 
@@ -209,72 +528,11 @@ static inline int _netdata_uberhandler(h2o_req_t *req, RRDHOST **host)
     if (!api_command.len)
         return 1;
 
-    // TODO - get a web_client from the cache
-    // this (emulating struct web_client) is a hack and will be removed
-    // in future PRs but needs bigger changes in old http_api_v1
-    // we need to make the web_client_api_request_v1 to be web server
-    // agnostic and remove the old webservers dependency creep into the
-    // individual response generators and thus remove the need to "emulate"
-    // the old webserver calling this function here and in ACLK
-    struct web_client w;
-    memset(&w, 0, sizeof(w));
-    w.response.data = buffer_create(NBUF_INITIAL_SIZE_RESP, NULL);
-    w.response.header = buffer_create(NBUF_INITIAL_SIZE_RESP, NULL);
-    w.url_query_string_decoded = buffer_create(NBUF_INITIAL_SIZE_RESP, NULL);
-    w.url_as_received = buffer_create(NBUF_INITIAL_SIZE_RESP, NULL);
-    w.port_acl = HTTP_ACL_H2O | HTTP_ACL_ALL_FEATURES;
-    w.acl = w.port_acl; // TODO - web_client_update_acl_matches(w) to restrict this based on user configuration
-
-    char *path_c_str = iovec_to_cstr(&api_command);
-    char *path_unescaped = url_unescape(path_c_str);
-    buffer_strcat(w.url_as_received, iovec_to_cstr(&norm_path));
-    freez(path_c_str);
-
-    IF_HAS_URL_PARAMS(req) {
-        h2o_iovec_t query_params = URL_PARAMS_IOVEC_INIT_WITH_QUESTIONMARK(req);
-        char *query_c_str = iovec_to_cstr(&query_params);
-        char *query_unescaped = url_unescape(query_c_str);
-        freez(query_c_str);
-        buffer_strcat(w.url_query_string_decoded, query_unescaped);
-        freez(query_unescaped);
-    }
+    if (h2o_memis(req->method.base, req->method.len, H2O_STRLIT("OPTIONS")))
+        return h2o_api_options(req);
 
-//inline int web_client_api_request_v2(RRDHOST *host, struct web_client *w, char *url_path_endpoint) {
-    if (api_version == 3)
-        web_client_api_request_v3(*host, &w, path_unescaped);
-    else if (api_version == 2)
-        web_client_api_request_v2(*host, &w, path_unescaped);
-    else
-        web_client_api_request_v1(*host, &w, path_unescaped);
-    freez(path_unescaped);
-
-    // we move msg body to req->pool managed memory as it has to
-    // live until whole response has been encrypted and sent
-    // when req is finished memory will be freed with the pool
-    h2o_iovec_t body;
-    {
-        BUFFER *wb = w.response.data;
-        body.base = wb->buffer;
-        body.len = wb->len;
-
-        void *managed = h2o_mem_alloc_shared(&req->pool, body.len, NULL);
-        memcpy(managed, body.base, body.len);
-        body.base = managed;
-    }
-
-    req->res.status = HTTP_RESP_OK;
-    req->res.reason = "OK";
-    if (w.response.data->content_type == CT_APPLICATION_JSON)
-        h2o_add_header(&req->pool, &req->res.headers, H2O_TOKEN_CONTENT_TYPE, NULL, CONTENT_JSON_UTF8);
-    else
-        h2o_add_header(&req->pool, &req->res.headers, H2O_TOKEN_CONTENT_TYPE, NULL, CONTENT_TEXT_UTF8);
-    h2o_start_response(req, &generator);
-    h2o_send(req, &body, 1, H2O_SEND_STATE_FINAL);
-
-    buffer_free(w.response.data);
-    buffer_free(w.response.header);
-    buffer_free(w.url_query_string_decoded);
-    buffer_free(w.url_as_received);
+    h2o_api_request(req, &path_and_query,
+                    h2o_memis(req->method.base, req->method.len, H2O_STRLIT("POST")) ? HTTP_REQUEST_MODE_POST : HTTP_REQUEST_MODE_GET);
 
     return 0;
 }
@@ -391,6 +649,8 @@ void *h2o_main(void *ptr) {
 
     h2o_context_init(&ctx, h2o_evloop_create(), &config);
 
+    h2o_api_threads_init(ctx.loop, (size_t)config_get_number(HTTPD_CONFIG_SECTION, "api threads", MIN(get_netdata_cpus(), 6)));
+
     if(ssl_init()) {
         error_report("SSL was requested but could not be properly initialized. Aborting.");
         return NULL;
@@ -16,9 +16,10 @@ long web_client_streaming_rate_t = 0L;
 #define WORKER_JOB_RCV_DATA       6
 #define WORKER_JOB_SND_DATA       7
 #define WORKER_JOB_PROCESS        8
+#define WORKER_JOB_OFFLOADED      9
 
-#if (WORKER_UTILIZATION_MAX_JOB_TYPES < 9)
-#error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES to at least 8
+#if (WORKER_UTILIZATION_MAX_JOB_TYPES < 10)
+#error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES to at least 10
 #endif
 
 /*
@@ -68,6 +69,11 @@ struct web_server_static_threaded_worker {
 
     size_t max_sockets;
 
+    // with SO_REUSEPORT every worker has its own listening sockets,
+    // so that the kernel distributes the new connections among them
+    LISTEN_SOCKETS sockets;
+    LISTEN_SOCKETS *listen_sockets;
+
     volatile size_t connected;
     volatile size_t disconnected;
     volatile size_t receptions;
@@ -76,6 +82,15 @@ struct web_server_static_threaded_worker {
 
     volatile size_t files_read;
     volatile size_t file_reads;
+
+    struct {
+        int pipe[2];                    // the offload threads write to it when requests complete
+        bool registered;                // the read side of the pipe is in our poll
+        size_t running;                 // our requests being executed by the offload threads
+
+        SPINLOCK spinlock;
+        struct web_client *completed;   // the clients of the completed requests
+    } offload;
 };
 
 static long long static_threaded_workers_count = 1;
@@ -159,7 +174,7 @@ static int web_server_file_read_callback(POLLINFO *pi, short int *events) {
         POLLINFO *wpi = pollinfo_from_slot(p, w->pollinfo_slot);  // POLLINFO of the client socket
 
         netdata_log_debug(D_WEB_CLIENT, "%llu: SIGNALING W TO SEND (iFD %d, oFD %d)", w->id, pi->fd, wpi->fd);
-        p->fds[wpi->slot].events |= POLLOUT;
+        poll_set_events(p, wpi->slot, (short int)(p->fds[wpi->slot].events | POLLOUT));
     }
 
     if(unlikely(ret <= 0 || w->ifd == w->ofd)) {
@@ -187,6 +202,344 @@ static int web_server_file_write_callback(POLLINFO *pi, short int *events) {
     return -1;
 }
 
+// ----------------------------------------------------------------------------
+// offloading heavy requests
+//
+// Data queries, weights and functions may run for a long time. Instead of
+// stalling all the clients of a web server thread, they are executed by a
+// pool of threads, with a concurrency limit per request class. When such a
+// request completes, the pool thread gives the client back to the web server
+// thread that owns it and writes to its pipe, so that this thread resumes
+// serving the client.
+
+#define WEB_OFFLOAD_THREADS_MAX 64
+#define WEB_OFFLOAD_QUEUE_MAX 1024
+
+#define WORKER_JOB_OFFLOAD_METRIC_QUEUED 10
+#define WORKER_JOB_OFFLOAD_METRIC_QUEUE_TIME(request_class) (WORKER_JOB_OFFLOAD_METRIC_QUEUED + 1 + (request_class))
+
+#if (WORKER_UTILIZATION_MAX_JOB_TYPES < WORKER_JOB_OFFLOAD_METRIC_QUEUE_TIME(WEB_REQUEST_CLASS_MAX))
+#error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES
+#endif
+
+static struct {
+    size_t threads;
+    bool exit;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                // signals the offload threads there are requests
+
+    size_t queued;                      // all the queued requests
+
+    struct {
+        size_t max_running;
+        size_t running;
+        struct web_client *queue;
+    } classes[WEB_REQUEST_CLASS_MAX];
+} web_offload = {
+    .threads = 0,
+    .exit = false,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .queued = 0,
+};
+
+// runs in the web server thread that owns the client, from web_client_process_request_from_web_server()
+static bool web_server_offload_request(struct web_client *w, WEB_REQUEST_CLASS request_class, void *data) {
+    struct web_server_static_threaded_worker *wt = data;
+
+    if(!web_offload.threads || wt->offload.pipe[PIPE_WRITE] == -1 || request_class >= WEB_REQUEST_CLASS_MAX)
+        return false;
+
+    pthread_mutex_lock(&web_offload.mutex);
+
+    if(web_offload.queued >= WEB_OFFLOAD_QUEUE_MAX) {
+        // the pool is overloaded, execute it here
+        pthread_mutex_unlock(&web_offload.mutex);
+        return false;
+    }
+
+    w->offload.offloaded = true;
+    w->offload.request_class = request_class;
+    w->offload.queued_ut = now_monotonic_usec();
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(web_offload.classes[request_class].queue, w, offload.prev, offload.next);
+    web_offload.queued++;
+
+    // wake them all, because some may not be allowed to run this class
+    pthread_cond_broadcast(&web_offload.cond);
+    pthread_mutex_unlock(&web_offload.mutex);
+
+    wt->offload.running++;
+    return true;
+}
+
+// called with the mutex locked - picks the oldest request of the classes that can run more
+static struct web_client *web_offload_next_request(void) {
+    struct web_client *w = NULL;
+
+    for(size_t c = WEB_REQUEST_CLASS_LIGHT + 1; c < WEB_REQUEST_CLASS_MAX ; c++) {
+        struct web_client *t = web_offload.classes[c].queue;
+
+        if(t && web_offload.classes[c].running < web_offload.classes[c].max_running &&
+            (!w || t->offload.queued_ut < w->offload.queued_ut))
+            w = t;
+    }
+
+    if(w) {
+        WEB_REQUEST_CLASS c = w->offload.request_class;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(web_offload.classes[c].queue, w, offload.prev, offload.next);
+        web_offload.classes[c].running++;
+        web_offload.queued--;
+    }
+
+    return w;
+}
+
+// runs in the offload threads
+static void web_offload_request_completed(struct web_client *w) {
+    struct web_server_static_threaded_worker *wt = w->offload.callback_data;
+
+    spinlock_lock(&wt->offload.spinlock);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(wt->offload.completed, w, offload.prev, offload.next);
+    spinlock_unlock(&wt->offload.spinlock);
+
+    // when the pipe is full, it is readable anyway
+    char c = 0;
+    if(write(wt->offload.pipe[PIPE_WRITE], &c, 1) != 1 && errno != EAGAIN && errno != EWOULDBLOCK)
+        nd_log(NDLS_DAEMON, NDLP_ERR, "WEB OFFLOAD: cannot notify web server thread %d", wt->id);
+}
+
+static void web_offload_threads_canceller(void *data __maybe_unused) {
+    pthread_mutex_lock(&web_offload.mutex);
+    web_offload.exit = true;
+    pthread_cond_broadcast(&web_offload.cond);
+    pthread_mutex_unlock(&web_offload.mutex);
+}
+
+static void *web_offload_thread_main(void *arg __maybe_unused) {
+    worker_register("WEBOFFLOAD");
+    for(size_t c = WEB_REQUEST_CLASS_LIGHT + 1; c < WEB_REQUEST_CLASS_MAX ; c++) {
+        char name[50];
+        worker_register_job_name(c, web_request_class_2str(c));
+
+        snprintfz(name, sizeof(name) - 1, "%s queue time", web_request_class_2str(c));
+        worker_register_job_custom_metric(WORKER_JOB_OFFLOAD_METRIC_QUEUE_TIME(c), name, "milliseconds", WORKER_METRIC_ABSOLUTE);
+    }
+    worker_register_job_custom_metric(WORKER_JOB_OFFLOAD_METRIC_QUEUED, "queued requests", "requests", WORKER_METRIC_ABSOLUTE);
+
+    nd_thread_register_canceller(web_offload_threads_canceller, NULL);
+
+    pthread_mutex_lock(&web_offload.mutex);
+
+    while(true) {
+        struct web_client *w;
+        while(!(w = web_offload_next_request()) && !web_offload.exit && !nd_thread_signaled_to_cancel())
+            pthread_cond_wait(&web_offload.cond, &web_offload.mutex);
+
+        if(!w)
+            break;
+
+        size_t queued = web_offload.queued;
+        pthread_mutex_unlock(&web_offload.mutex);
+
+        WEB_REQUEST_CLASS c = w->offload.request_class;
+        worker_set_metric(WORKER_JOB_OFFLOAD_METRIC_QUEUED, (NETDATA_DOUBLE)queued);
+        worker_set_metric(WORKER_JOB_OFFLOAD_METRIC_QUEUE_TIME(c),
+                          (NETDATA_DOUBLE)(now_monotonic_usec() - w->offload.queued_ut) / (NETDATA_DOUBLE)USEC_PER_MS);
+
+        worker_is_busy(c);
+        web_client_process_offloaded_request(w);
+        worker_is_idle();
+
+        web_offload_request_completed(w);
+
+        pthread_mutex_lock(&web_offload.mutex);
+        web_offload.classes[c].running--;
+
+        // a request of this class may be waiting for this slot
+        if(web_offload.classes[c].queue)
+            pthread_cond_broadcast(&web_offload.cond);
+    }
+
+    pthread_mutex_unlock(&web_offload.mutex);
+
+    worker_unregister();
+    return NULL;
+}
+
+static size_t web_offload_class_limit(const char *name, long long def, size_t threads) {
+    long long n = config_get_number(CONFIG_SECTION_WEB, name, def);
+
+    if(n < 1) n = 1;
+    if(n > (long long)threads) n = (long long)threads;
+    return (size_t)n;
+}
+
+static void web_offload_threads_init(void) {
+    long long threads = (long long)get_netdata_cpus() / 2;
+    if(threads < 1) threads = 1;
+    if(threads > 8) threads = 8;
+
+    threads = config_get_number(CONFIG_SECTION_WEB, "offload threads", threads);
+    if(threads <= 0)
+        return;
+
+    if(threads > WEB_OFFLOAD_THREADS_MAX)
+        threads = WEB_OFFLOAD_THREADS_MAX;
+
+    web_offload.classes[WEB_REQUEST_CLASS_DATA].max_running =
+        web_offload_class_limit("offload max concurrent data queries", threads, threads);
+    web_offload.classes[WEB_REQUEST_CLASS_WEIGHTS].max_running =
+        web_offload_class_limit("offload max concurrent weights queries", (threads + 1) / 2, threads);
+    web_offload.classes[WEB_REQUEST_CLASS_FUNCTION].max_running =
+        web_offload_class_limit("offload max concurrent functions", threads, threads);
+
+    for(long long i = 0; i < threads ;i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "WEBOFFLOAD[%lld]", i);
+
+        if(nd_thread_create(tag, NETDATA_THREAD_OPTION_DEFAULT, web_offload_thread_main, NULL))
+            web_offload.threads++;
+    }
+
+    netdata_log_info("WEB OFFLOAD: started %zu threads", web_offload.threads);
+}
+
+// runs in the web server thread that owns the client
+static void web_server_offload_resume(POLLJOB *p, struct web_client *w) {
+    w->offload.offloaded = false;
+    worker_private->offload.running--;
+
+    if(unlikely(!w->pollinfo_slot)) {
+        // the client disconnected while its request was running
+        netdata_log_debug(D_WEB_CLIENT, "%llu: OFFLOADED REQUEST COMPLETED FOR DISCONNECTED CLIENT (FD %d)", w->id, w->ofd);
+
+        if(!web_client_flag_check(w, WEB_CLIENT_FLAG_DONT_CLOSE_SOCKET) && w->ofd != -1)
+            close(w->ofd);
+
+        web_server_log_connection(w, "DISCONNECTED");
+        web_client_request_done(w);
+        web_client_release_to_cache(w);
+        global_statistics_web_client_disconnected();
+        return;
+    }
+
+    POLLINFO *pi = pollinfo_from_slot(p, w->pollinfo_slot);
+    pi->flags &= ~POLLINFO_FLAG_NO_TIMEOUT;
+
+    if(web_server_check_client_status(w) == -1) {
+        poll_close_fd(pi);
+        return;
+    }
+
+    short int events = 0;
+
+    if(w->ifd == pi->fd && web_client_has_wait_receive(w))
+        events |= POLLIN;
+
+    if(w->ofd == pi->fd && web_client_has_wait_send(w))
+        events |= POLLOUT;
+
+    poll_set_events(p, pi->slot, events);
+}
+
+static void *web_server_offload_add_callback(POLLINFO *pi, short int *events, void *data) {
+    (void)pi;
+
+    *events = POLLIN;
+    return data;
+}
+
+static void web_server_offload_del_callback(POLLINFO *pi) {
+    struct web_server_static_threaded_worker *wt = pi->data;
+    wt->offload.registered = false;
+}
+
+static int web_server_offload_rcv_callback(POLLINFO *pi, short int *events) {
+    struct web_server_static_threaded_worker *wt = pi->data;
+    POLLJOB *p = pi->p;
+
+    worker_is_busy(WORKER_JOB_OFFLOADED);
+
+    char buf[256];
+    while(read(wt->offload.pipe[PIPE_READ], buf, sizeof(buf)) > 0)
+        ;
+
+    spinlock_lock(&wt->offload.spinlock);
+    struct web_client *completed = wt->offload.completed;
+    wt->offload.completed = NULL;
+    spinlock_unlock(&wt->offload.spinlock);
+
+    *events = POLLIN;
+
+    // pi and events are not used below, poll_close_fd() does not reallocate them
+    struct web_client *w, *next;
+    for(w = completed; w ; w = next) {
+        next = w->offload.next;
+        w->offload.prev = w->offload.next = NULL;
+        web_server_offload_resume(p, w);
+    }
+
+    worker_is_idle();
+    return 0;
+}
+
+static int web_server_offload_snd_callback(POLLINFO *pi, short int *events) {
+    (void)pi;
+
+    *events = POLLIN;
+    return 0;
+}
+
+// adds the read side of our pipe to our poll
+// it may reallocate the poll slots, so the caller should not use its pi and events after it
+static void web_server_offload_register(POLLJOB *p) {
+    if(worker_private->offload.registered)
+        return;
+
+    POLLINFO *pi = poll_add_fd(p
+                               , worker_private->offload.pipe[PIPE_READ]
+                               , 0
+                               , HTTP_ACL_NONE
+                               , POLLINFO_FLAG_CLIENT_SOCKET | POLLINFO_FLAG_DONT_CLOSE | POLLINFO_FLAG_NO_TIMEOUT
+                               , "OFFLOAD"
+                               , ""
+                               , ""
+                               , web_server_offload_add_callback
+                               , web_server_offload_del_callback
+                               , web_server_offload_rcv_callback
+                               , web_server_offload_snd_callback
+                               , (void *)worker_private
+    );
+
+    if(pi)
+        worker_private->offload.registered = true;
+    else
+        netdata_log_error("WEB OFFLOAD: failed to add the notification pipe to the poll");
+}
+
+static void web_server_offload_pipe_create(struct web_server_static_threaded_worker *wt) {
+    wt->offload.pipe[PIPE_READ] = wt->offload.pipe[PIPE_WRITE] = -1;
+    spinlock_init(&wt->offload.spinlock);
+
+    if(!web_offload.threads)
+        return;
+
+    int fds[2];
+    if(pipe(fds) == -1) {
+        netdata_log_error("WEB OFFLOAD: cannot create the notification pipe, requests will not be offloaded");
+        return;
+    }
+
+    sock_setnonblock(fds[PIPE_READ]);
+    sock_setnonblock(fds[PIPE_WRITE]);
+    (void)fcntl(fds[PIPE_READ], F_SETFD, FD_CLOEXEC);
+    (void)fcntl(fds[PIPE_WRITE], F_SETFD, FD_CLOEXEC);
+
+    wt->offload.pipe[PIPE_READ] = fds[PIPE_READ];
+    wt->offload.pipe[PIPE_WRITE] = fds[PIPE_WRITE];
+}
+
 // ----------------------------------------------------------------------------
 // web server clients
 
@@ -204,6 +557,8 @@ static void *web_server_add_callback(POLLINFO *pi, short int *events, void *data
 
     netdata_log_debug(D_WEB_CLIENT_ACCESS, "LISTENER on %d: new connection.", pi->fd);
     struct web_client *w = web_client_create_on_fd(pi);
+    w->offload.callback = web_server_offload_request;
+    w->offload.callback_data = worker_private;
 
     if (!strncmp(pi->client_port, "UNIX", 4)) {
         web_client_set_conn_unix(w);
@@ -255,7 +610,12 @@ static void web_server_del_callback(POLLINFO *pi) {
     struct web_client *w = (struct web_client *)pi->data;
 
     w->pollinfo_slot = 0;
-    if(unlikely(w->pollinfo_filecopy_slot)) {
+    if(unlikely(w->offload.offloaded)) {
+        // an offload thread is using it, the client will be freed when its request completes
+        pi->flags |= POLLINFO_FLAG_DONT_CLOSE;
+        netdata_log_debug(D_WEB_CLIENT, "%llu: THE CLIENT WILL BE FREED WHEN ITS OFFLOADED REQUEST COMPLETES ON FD %d", w->id, pi->fd);
+    }
+    else if(unlikely(w->pollinfo_filecopy_slot)) {
         POLLINFO *fpi = pollinfo_from_slot(pi->p, w->pollinfo_filecopy_slot);  // POLLINFO of the client socket
         (void)fpi;
 
@@ -293,6 +653,19 @@ static int web_server_rcv_callback(POLLINFO *pi, short int *events) {
         worker_is_busy(WORKER_JOB_PROCESS);
         web_client_process_request_from_web_server(w);
 
+        if (unlikely(w->offload.offloaded)) {
+            // an offload thread executes it - we wait for it without events and timeouts
+            netdata_log_debug(D_WEB_CLIENT, "%llu: OFFLOADED %s REQUEST ON FD %d", w->id, web_request_class_2str(w->offload.request_class), fd);
+            pi->flags |= POLLINFO_FLAG_NO_TIMEOUT;
+
+            // this may reallocate pi and events
+            POLLJOB *p = pi->p;
+            web_server_offload_register(p);
+
+            ret = 0;
+            goto cleanup;
+        }
+
         if (unlikely(w->mode == HTTP_REQUEST_MODE_STREAM)) {
             web_client_send(w);
         }
@@ -402,6 +775,9 @@ static void socket_listen_main_static_threaded_worker_cleanup(void *pptr) {
             worker_private->sends
     );
 
+    if(worker_private->listen_sockets && worker_private->listen_sockets != &api_sockets)
+        listen_sockets_close(worker_private->listen_sockets);
+
     worker_private->running = 0;
     worker_unregister();
 }
@@ -423,9 +799,15 @@ void *socket_listen_main_static_threaded_worker(void *ptr) {
     worker_register_job_name(WORKER_JOB_RCV_DATA, "receive");
     worker_register_job_name(WORKER_JOB_SND_DATA, "send");
     worker_register_job_name(WORKER_JOB_PROCESS, "process");
+    worker_register_job_name(WORKER_JOB_OFFLOADED, "offloaded");
+
+    web_server_offload_pipe_create(worker_private);
 
     CLEANUP_FUNCTION_REGISTER(socket_listen_main_static_threaded_worker_cleanup) cleanup_ptr = worker_private;
-    poll_events(&api_sockets
+    if(!worker_private->listen_sockets)
+        worker_private->listen_sockets = &api_sockets;
+
+    poll_events(worker_private->listen_sockets
                 , web_server_add_callback
                 , web_server_del_callback
                 , web_server_rcv_callback
@@ -532,11 +914,22 @@ void *socket_listen_main_static_threaded(void *ptr) {
     static_workers_private_data = callocz((size_t)static_threaded_workers_count,
                                           sizeof(struct web_server_static_threaded_worker));
 
+    web_offload_threads_init();
+
     int i;
     for (i = 1; i < static_threaded_workers_count; i++) {
         static_workers_private_data[i].id = i;
         static_workers_private_data[i].max_sockets = max_sockets / static_threaded_workers_count;
 
+        if(api_sockets.reuse_port && listen_sockets_clone(&api_sockets, &static_workers_private_data[i].sockets))
+            static_workers_private_data[i].listen_sockets = &static_workers_private_data[i].sockets;
+        else {
+            if(static_workers_private_data[i].sockets.opened)
+                listen_sockets_close(&static_workers_private_data[i].sockets);
+
+            static_workers_private_data[i].listen_sockets = &api_sockets;
+        }
+
         char tag[50 + 1];
         snprintfz(tag, sizeof(tag) - 1, "WEB[%d]", i+1);
 
@@ -2,6 +2,10 @@
 
 #include "web_client.h"
 
+#if defined(OS_LINUX)
+#include <sys/sendfile.h>
+#endif
+
 // this is an async I/O implementation of the web server request parser
 // it is used by all netdata web servers
 
@@ -9,6 +13,7 @@ int respect_web_browser_do_not_track_policy = 0;
 const char *web_x_frame_options = NULL;
 
 int web_enable_gzip = 1, web_gzip_level = 3, web_gzip_strategy = Z_DEFAULT_STRATEGY;
+size_t web_response_stream_chunk_size = 1024 * 1024;
 
 void web_client_set_conn_tcp(struct web_client *w) {
     web_client_flags_clear_conn(w);
@@ -134,6 +139,20 @@ static inline char *strip_control_characters(char *url) {
     return url;
 }
 
+static void web_client_release_deflate(struct web_client *w) {
+    if(w->response.zinitialized) {
+        deflateEnd(&w->response.zstream);
+        w->response.zsent = 0;
+        w->response.zhave = 0;
+        w->response.zstream.avail_in = 0;
+        w->response.zstream.avail_out = 0;
+        w->response.zstream.total_in = 0;
+        w->response.zstream.total_out = 0;
+        w->response.zinitialized = false;
+        web_client_flag_clear(w, WEB_CLIENT_CHUNKED_TRANSFER);
+    }
+}
+
 static void web_client_reset_allocations(struct web_client *w, bool free_all) {
 
     if(free_all) {
@@ -196,24 +215,29 @@ static void web_client_reset_allocations(struct web_client *w, bool free_all) {
     freez(w->auth_bearer_token);
     w->auth_bearer_token = NULL;
 
-    // if we had enabled compression, release it
-    if(w->response.zinitialized) {
-        deflateEnd(&w->response.zstream);
-        w->response.zsent = 0;
-        w->response.zhave = 0;
-        w->response.zstream.avail_in = 0;
-        w->response.zstream.avail_out = 0;
-        w->response.zstream.total_in = 0;
-        w->response.zstream.total_out = 0;
-        w->response.zinitialized = false;
-        web_client_flag_clear(w, WEB_CLIENT_CHUNKED_TRANSFER);
+    freez(w->if_none_match);
+    w->if_none_match = NULL;
+
+    freez(w->accept);
+    w->accept = NULL;
+
+    if(w->response.sendfile.file) {
+        web_static_file_release(w->response.sendfile.file);
+        w->response.sendfile.file = NULL;
+        w->response.sendfile.fd = -1;
     }
 
+    // if we had enabled compression, release it
+    web_client_release_deflate(w);
+
+    if(web_client_flag_check(w, WEB_CLIENT_FLAG_RESPONSE_STREAMED))
+        web_client_flag_clear(w, WEB_CLIENT_FLAG_RESPONSE_STREAMED | WEB_CLIENT_CHUNKED_TRANSFER);
+
     memset(w->transaction, 0, sizeof(w->transaction));
     memset(&w->auth, 0, sizeof(w->auth));
 
     web_client_reset_permissions(w);
-    web_client_flag_clear(w, WEB_CLIENT_ENCODING_GZIP|WEB_CLIENT_ENCODING_DEFLATE);
+    web_client_flag_clear(w, WEB_CLIENT_ENCODING_GZIP|WEB_CLIENT_ENCODING_DEFLATE|WEB_CLIENT_ENCODING_BROTLI);
     web_client_reset_path_flags(w);
 }
 
@@ -221,7 +245,7 @@ void web_client_log_completed_request(struct web_client *w, bool update_web_stat
     struct timeval tv;
     now_monotonic_high_precision_timeval(&tv);
 
-    size_t size = (w->mode == HTTP_REQUEST_MODE_FILECOPY) ? w->response.rlen : w->response.data->len;
+    size_t size = (w->mode == HTTP_REQUEST_MODE_FILECOPY || w->response.sendfile.file) ? w->response.rlen : w->response.data->len;
     size_t sent = w->response.zoutput ? (size_t)w->response.zstream.total_out : size;
 
     if(update_web_stats)
@@ -470,6 +494,79 @@ static bool find_filename_to_serve(const char *filename, char *dst, size_t dst_l
     return true;
 }
 
+// the kernel copies the file to the socket, when there is no TLS in between
+static inline bool web_client_can_sendfile(struct web_client *w) {
+#if defined(OS_LINUX)
+    return !SSL_connection(&w->ssl);
+#else
+    (void)w;
+    return false;
+#endif
+}
+
+// returns -1 when the file cannot be served from the static files cache
+static int web_client_send_cached_file(struct web_client *w, const char *web_filename, struct stat *statbuf) {
+    // the cloud and webrtc have their own framing of responses
+    if(!web_client_check_conn_tcp(w) && !web_client_check_conn_unix(w))
+        return -1;
+
+    WEB_STATIC_FILE_ACQUIRED *wsfa = web_static_file_acquire(web_filename, statbuf);
+    if(!wsfa)
+        return -1;
+
+    WEB_STATIC_FILE_ENCODING encoding = web_static_file_encoding(
+        wsfa,
+        web_client_flag_check(w, WEB_CLIENT_ENCODING_GZIP),
+        web_client_flag_check(w, WEB_CLIENT_ENCODING_BROTLI));
+
+    // the file is sent as it is cached, it is not compressed again
+    web_client_release_deflate(w);
+    w->response.zoutput = false;
+
+    char etag[WEB_STATIC_FILE_ETAG_MAX + 10];
+    web_static_file_etag(wsfa, encoding, etag, sizeof(etag));
+
+    w->response.data->content_type = contenttype_for_filename(web_filename);
+    w->response.data->date = web_static_file_mtime(wsfa);
+    buffer_cacheable(w->response.data);
+    buffer_sprintf(w->response.header, "ETag: %s\r\nVary: Accept-Encoding\r\n", etag);
+
+    if(w->if_none_match && web_static_file_etag_matches(wsfa, w->if_none_match)) {
+        netdata_log_debug(D_WEB_CLIENT_ACCESS, "%llu: File '%s' has not been modified.", w->id, web_filename);
+        web_static_file_release(wsfa);
+        return HTTP_RESP_NOT_MODIFIED;
+    }
+
+    if(encoding != WEB_STATIC_FILE_IDENTITY)
+        buffer_sprintf(w->response.header, "Content-Encoding: %s\r\n", web_static_file_encoding_2str(encoding));
+
+    netdata_log_debug(D_WEB_CLIENT_ACCESS, "%llu: Sending cached file '%s' (%zu bytes, %s).",
+                      w->id, web_filename, web_static_file_size(wsfa, encoding), web_static_file_encoding_2str(encoding));
+
+    if(web_client_can_sendfile(w)) {
+        w->response.sendfile.file = wsfa;
+        w->response.sendfile.fd = web_static_file_fd(wsfa, encoding);
+        w->response.rlen = web_static_file_size(wsfa, encoding);
+        return HTTP_RESP_OK;
+    }
+
+    buffer_flush(w->response.data);
+    bool ok = web_static_file_read(wsfa, encoding, w->response.data);
+    web_static_file_release(wsfa);
+
+    if(!ok) {
+        buffer_flush(w->response.header);
+        buffer_flush(w->response.data);
+        buffer_no_cacheable(w->response.data);
+        w->response.data->content_type = CT_TEXT_HTML;
+        buffer_strcat(w->response.data, "Cannot read file: ");
+        buffer_strcat_htmlescape(w->response.data, web_filename);
+        return HTTP_RESP_INTERNAL_SERVER_ERROR;
+    }
+
+    return HTTP_RESP_OK;
+}
+
 static int mysendfile(struct web_client *w, char *filename) {
     netdata_log_debug(D_WEB_CLIENT, "%llu: Looking for file '%s/%s'", w->id, netdata_configured_web_dir, filename);
 
@@ -514,6 +611,10 @@ static int mysendfile(struct web_client *w, char *filename) {
     if(is_dir && !web_client_flag_check(w, WEB_CLIENT_FLAG_PATH_HAS_TRAILING_SLASH))
         return append_slash_to_url_and_redirect(w);
 
+    int code = web_client_send_cached_file(w, web_filename, &statbuf);
+    if(code != -1)
+        return code;
+
     // open the file
     w->ifd = open(web_filename, O_NONBLOCK, O_RDONLY | O_CLOEXEC);
     if(w->ifd == -1) {
@@ -940,7 +1041,7 @@ void web_client_build_http_header(struct web_client *w) {
             // we know the content length, put it
             buffer_sprintf(w->response.header_output, "Content-Length: %zu\r\n", w->response.data->len? w->response.data->len: w->response.rlen);
         }
-        else {
+        else if(w->response.code != HTTP_RESP_NOT_MODIFIED) {
             // we don't know the content length, disable keep-alive
             web_client_disable_keepalive(w);
         }
@@ -1016,6 +1117,82 @@ static inline void web_client_send_http_header(struct web_client *w) {
         w->statistics.sent_bytes += bytes;
 }
 
+// ----------------------------------------------------------------------------
+// streaming responses
+//
+// Queries returning many points give their output to us while they generate
+// it, so that it is sent to the client in chunks (chunked transfer encoding)
+// and the whole response is never kept in memory. The first chunk sends the
+// HTTP header, and when the API call returns, the rest of the response is
+// sent as the last chunk.
+//
+// Compressed responses, TLS connections and connections not using a socket
+// (cloud, webrtc) are always buffered.
+
+bool web_client_can_stream_response(struct web_client *w) {
+    return web_response_stream_chunk_size &&
+           !w->response.zoutput &&
+           !SSL_connection(&w->ssl) &&
+           (web_client_check_conn_tcp(w) || web_client_check_conn_unix(w));
+}
+
+static bool web_client_stream_send_all(struct web_client *w, const char *data, size_t len) {
+    while(len && !web_client_check_dead(w)) {
+        ssize_t bytes = web_client_send_data(w, data, len, 0);
+        if(bytes <= 0) {
+            netdata_log_debug(D_WEB_CLIENT, "%llu: Failed to send streamed response to client.", w->id);
+            WEB_CLIENT_IS_DEAD(w);
+            break;
+        }
+
+        w->statistics.sent_bytes += bytes;
+        data += bytes;
+        len -= bytes;
+    }
+
+    return !web_client_check_dead(w);
+}
+
+static bool web_client_stream_send_chunk(struct web_client *w, const char *data, size_t len) {
+    if(!len)
+        return true;
+
+    char header[24];
+    size_t header_len = (size_t)snprintfz(header, sizeof(header), "%zX\r\n", len);
+
+    return web_client_stream_send_all(w, header, header_len) &&
+           web_client_stream_send_all(w, data, len) &&
+           web_client_stream_send_all(w, "\r\n", 2);
+}
+
+bool web_client_stream_response_callback(BUFFER *wb, void *data) {
+    struct web_client *w = data;
+
+    if(wb != w->response.data || web_client_check_dead(w))
+        return false;
+
+    if(!web_client_flag_check(w, WEB_CLIENT_FLAG_RESPONSE_STREAMED)) {
+        w->response.code = HTTP_RESP_OK;
+        web_client_flag_set(w, WEB_CLIENT_FLAG_RESPONSE_STREAMED | WEB_CLIENT_CHUNKED_TRANSFER);
+        web_client_send_http_header(w);
+    }
+
+    web_client_stream_send_chunk(w, buffer_tostring(wb), buffer_strlen(wb));
+
+    // drop the data, even if the client is gone - the json state of the buffer is kept
+    wb->len = 0;
+    wb->buffer[0] = '\0';
+
+    return true;
+}
+
+static void web_client_stream_response_end(struct web_client *w) {
+    if(web_client_stream_send_chunk(w, buffer_tostring(w->response.data), buffer_strlen(w->response.data)))
+        web_client_stream_send_all(w, "0\r\n\r\n", 5);
+
+    buffer_flush(w->response.data);
+}
+
 static inline int web_client_switch_host(RRDHOST *host, struct web_client *w, char *url, bool nodeid, int (*func)(RRDHOST *, struct web_client *, char *)) {
     static uint32_t hash_localhost = 0;
 
@@ -1301,6 +1478,82 @@ static inline int web_client_process_url(RRDHOST *host, struct web_client *w, ch
     return mysendfile(w, filename);
 }
 
+// ----------------------------------------------------------------------------
+// request classes
+
+static struct {
+    const char *endpoint;
+    WEB_REQUEST_CLASS request_class;
+} web_request_classes[] = {
+    { "data",                   WEB_REQUEST_CLASS_DATA },
+    { "badge.svg",              WEB_REQUEST_CLASS_DATA },
+    { "allmetrics",             WEB_REQUEST_CLASS_DATA },
+    { "weights",                WEB_REQUEST_CLASS_WEIGHTS },
+    { "metric_correlations",    WEB_REQUEST_CLASS_WEIGHTS },
+    { "function",               WEB_REQUEST_CLASS_FUNCTION },
+    { "config",                 WEB_REQUEST_CLASS_FUNCTION },
+
+    // terminator
+    { NULL,                     WEB_REQUEST_CLASS_LIGHT },
+};
+
+const char *web_request_class_2str(WEB_REQUEST_CLASS request_class) {
+    switch(request_class) {
+        case WEB_REQUEST_CLASS_DATA:
+            return "data";
+
+        case WEB_REQUEST_CLASS_WEIGHTS:
+            return "weights";
+
+        case WEB_REQUEST_CLASS_FUNCTION:
+            return "function";
+
+        default:
+        case WEB_REQUEST_CLASS_LIGHT:
+            return "light";
+    }
+}
+
+// finds the class of a request, by its API endpoint
+// it follows the paths web_client_process_url() accepts: [/host/X|/node/X][/vN]/api/vN/endpoint
+WEB_REQUEST_CLASS web_client_request_class(const char *decoded_url_path) {
+    char path[FILENAME_MAX + 1];
+    strncpyz(path, decoded_url_path ? decoded_url_path : "", FILENAME_MAX);
+
+    char *s = path;
+    char *tok = strsep_skip_consecutive_separators(&s, "/?");
+
+    if(tok && (strcmp(tok, "host") == 0 || strcmp(tok, "node") == 0)) {
+        strsep_skip_consecutive_separators(&s, "/?");
+        tok = strsep_skip_consecutive_separators(&s, "/?");
+    }
+
+    // dashboard versions
+    while(tok && tok[0] == 'v' && tok[1] >= '0' && tok[1] <= '3' && !tok[2])
+        tok = strsep_skip_consecutive_separators(&s, "/?");
+
+    if(!tok || strcmp(tok, "api") != 0)
+        return WEB_REQUEST_CLASS_LIGHT;
+
+    // the api version
+    tok = strsep_skip_consecutive_separators(&s, "/?");
+    if(!tok || (strcmp(tok, "v1") != 0 && strcmp(tok, "v2") != 0 && strcmp(tok, "v3") != 0))
+        return WEB_REQUEST_CLASS_LIGHT;
+
+    tok = strsep_skip_consecutive_separators(&s, "/?");
+    if(!tok || !*tok)
+        return WEB_REQUEST_CLASS_LIGHT;
+
+    for(size_t i = 0; web_request_classes[i].endpoint ; i++) {
+        if(strcmp(tok, web_request_classes[i].endpoint) == 0)
+            return web_request_classes[i].request_class;
+    }
+
+    return WEB_REQUEST_CLASS_LIGHT;
+}
+
+// ----------------------------------------------------------------------------
+
 static bool web_server_log_transport(BUFFER *wb, void *ptr) {
     struct web_client *w = ptr;
     if(!w)
@@ -1310,6 +1563,71 @@ static bool web_server_log_transport(BUFFER *wb, void *ptr) {
     return true;
 }
 
+static void web_client_response_prepared(struct web_client *w) {
+    // keep track of the processing time
+    web_client_timeout_checkpoint_response_ready(w, NULL);
+
+    w->response.sent = 0;
+
+    bool streamed = web_client_flag_check(w, WEB_CLIENT_FLAG_RESPONSE_STREAMED);
+    if(streamed)
+        web_client_stream_response_end(w);
+    else
+        web_client_send_http_header(w);
+
+    // enable sending immediately if we have data
+    // (streamed responses have been sent - web_client_send() will complete the request)
+    if(w->response.data->len || streamed || w->response.sendfile.file) web_client_enable_wait_send(w);
+    else web_client_disable_wait_send(w);
+
+    switch(w->mode) {
+        case HTTP_REQUEST_MODE_STREAM:
+            netdata_log_debug(D_WEB_CLIENT, "%llu: STREAM done.", w->id);
+            break;
+
+        case HTTP_REQUEST_MODE_OPTIONS:
+            netdata_log_debug(D_WEB_CLIENT,
+                "%llu: Done preparing the OPTIONS response. Sending data (%zu bytes) to client.",
+                w->id, (size_t)w->response.data->len);
+            break;
+
+        case HTTP_REQUEST_MODE_POST:
+        case HTTP_REQUEST_MODE_GET:
+        case HTTP_REQUEST_MODE_PUT:
+        case HTTP_REQUEST_MODE_DELETE:
+            netdata_log_debug(D_WEB_CLIENT,
+                "%llu: Done preparing the response. Sending data (%zu bytes) to client.",
+                w->id, (size_t)w->response.data->len);
+            break;
+
+        case HTTP_REQUEST_MODE_FILECOPY:
+            if(w->response.rlen) {
+                netdata_log_debug(D_WEB_CLIENT, "%llu: Done preparing the response. Will be sending data file of %zu bytes to client.", w->id, w->response.rlen);
+                web_client_enable_wait_receive(w);
+
+                /*
+                // utilize the kernel sendfile() for copying the file to the socket.
+                // this block of code can be commented, without anything missing.
+                // when it is commented, the program will copy the data using async I/O.
+                {
+                    long len = sendfile(w->ofd, w->ifd, NULL, w->response.data->rbytes);
+                    if(len != w->response.data->rbytes)
+                        netdata_log_error("%llu: sendfile() should copy %ld bytes, but copied %ld. Falling back to manual copy.", w->id, w->response.data->rbytes, len);
+                    else
+                        web_client_request_done(w);
+                }
+                */
+            }
+            else
+                netdata_log_debug(D_WEB_CLIENT, "%llu: Done preparing the response. Will be sending an unknown amount of bytes to client.", w->id);
+            break;
+
+        default:
+            fatal("%llu: Unknown client mode %u.", w->id, w->mode);
+            break;
+    }
+}
+
 void web_client_process_request_from_web_server(struct web_client *w) {
     // entry point for web server requests
 
@@ -1419,6 +1737,14 @@ void web_client_process_request_from_web_server(struct web_client *w) {
                         }
                     }
 
+                    if(w->offload.callback) {
+                        WEB_REQUEST_CLASS request_class = web_client_request_class(path);
+                        if(request_class != WEB_REQUEST_CLASS_LIGHT &&
+                            w->offload.callback(w, request_class, w->offload.callback_data))
+                            // web_client_process_offloaded_request() will complete it
+                            return;
+                    }
+
                     w->response.code = (short)web_client_process_url(localhost, w, path);
                     break;
 
@@ -1496,63 +1822,29 @@ void web_client_process_request_from_web_server(struct web_client *w) {
             break;
     }
 
-    // keep track of the processing time
-    web_client_timeout_checkpoint_response_ready(w, NULL);
-
-    w->response.sent = 0;
-
-    web_client_send_http_header(w);
-
-    // enable sending immediately if we have data
-    if(w->response.data->len) web_client_enable_wait_send(w);
-    else web_client_disable_wait_send(w);
-
-    switch(w->mode) {
-        case HTTP_REQUEST_MODE_STREAM:
-            netdata_log_debug(D_WEB_CLIENT, "%llu: STREAM done.", w->id);
-            break;
-
-        case HTTP_REQUEST_MODE_OPTIONS:
-            netdata_log_debug(D_WEB_CLIENT,
-                "%llu: Done preparing the OPTIONS response. Sending data (%zu bytes) to client.",
-                w->id, (size_t)w->response.data->len);
-            break;
+    web_client_response_prepared(w);
+}
 
-        case HTTP_REQUEST_MODE_POST:
-        case HTTP_REQUEST_MODE_GET:
-        case HTTP_REQUEST_MODE_PUT:
-        case HTTP_REQUEST_MODE_DELETE:
-            netdata_log_debug(D_WEB_CLIENT,
-                "%llu: Done preparing the response. Sending data (%zu bytes) to client.",
-                w->id, (size_t)w->response.data->len);
-            break;
+void web_client_process_offloaded_request(struct web_client *w) {
+    // entry point for the requests web_client_process_request_from_web_server() offloaded
 
-        case HTTP_REQUEST_MODE_FILECOPY:
-            if(w->response.rlen) {
-                netdata_log_debug(D_WEB_CLIENT, "%llu: Done preparing the response. Will be sending data file of %zu bytes to client.", w->id, w->response.rlen);
-                web_client_enable_wait_receive(w);
+    ND_LOG_STACK lgs[] = {
+            ND_LOG_FIELD_CB(NDF_SRC_TRANSPORT, web_server_log_transport, w),
+            ND_LOG_FIELD_TXT(NDF_SRC_IP, w->client_ip),
+            ND_LOG_FIELD_TXT(NDF_SRC_PORT, w->client_port),
+            ND_LOG_FIELD_TXT(NDF_REQUEST_METHOD, HTTP_REQUEST_MODE_2str(w->mode)),
+            ND_LOG_FIELD_BFR(NDF_REQUEST, w->url_as_received),
+            ND_LOG_FIELD_U64(NDF_CONNECTION_ID, w->id),
+            ND_LOG_FIELD_UUID(NDF_TRANSACTION_ID, &w->transaction),
+            ND_LOG_FIELD_END(),
+    };
+    ND_LOG_STACK_PUSH(lgs);
 
-                /*
-                // utilize the kernel sendfile() for copying the file to the socket.
-                // this block of code can be commented, without anything missing.
-                // when it is commented, the program will copy the data using async I/O.
-                {
-                    long len = sendfile(w->ofd, w->ifd, NULL, w->response.data->rbytes);
-                    if(len != w->response.data->rbytes)
-                        netdata_log_error("%llu: sendfile() should copy %ld bytes, but copied %ld. Falling back to manual copy.", w->id, w->response.data->rbytes, len);
-                    else
-                        web_client_request_done(w);
-                }
-                */
-            }
-            else
-                netdata_log_debug(D_WEB_CLIENT, "%llu: Done preparing the response. Will be sending an unknown amount of bytes to client.", w->id);
-            break;
+    char path[FILENAME_MAX + 1];
+    strncpyz(path, buffer_tostring(w->url_path_decoded), FILENAME_MAX);
 
-        default:
-            fatal("%llu: Unknown client mode %u.", w->id, w->mode);
-            break;
-    }
+    w->response.code = (short)web_client_process_url(localhost, w, path);
+    web_client_response_prepared(w);
 }
 
 ssize_t web_client_send_chunk_header(struct web_client *w, size_t len)
@@ -1740,7 +2032,48 @@ ssize_t web_client_send_deflate(struct web_client *w)
     return(len);
 }
 
+#if defined(OS_LINUX)
+static ssize_t web_client_send_static_file(struct web_client *w) {
+    if(unlikely(w->response.sent >= w->response.rlen)) {
+        // there is nothing to send
+
+        if(unlikely(!web_client_has_keepalive(w))) {
+            netdata_log_debug(D_WEB_CLIENT, "%llu: Closing (keep-alive is not enabled). %zu bytes sent.", w->id, w->response.sent);
+            WEB_CLIENT_IS_DEAD(w);
+            return 0;
+        }
+
+        web_client_request_done(w);
+        netdata_log_debug(D_WEB_CLIENT, "%llu: Done sending the file. Waiting for next request on the same socket.", w->id);
+        return 0;
+    }
+
+    off_t offset = (off_t)w->response.sent;
+    ssize_t bytes = sendfile(w->ofd, w->response.sendfile.fd, &offset, w->response.rlen - w->response.sent);
+    if(likely(bytes > 0)) {
+        w->statistics.sent_bytes += bytes;
+        w->response.sent += bytes;
+        netdata_log_debug(D_WEB_CLIENT, "%llu: Sent %zd bytes of file.", w->id, bytes);
+    }
+    else if(bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        netdata_log_debug(D_WEB_CLIENT, "%llu: Did not send any bytes of file to the client.", w->id);
+        bytes = 0;
+    }
+    else {
+        netdata_log_debug(D_WEB_CLIENT, "%llu: Failed to send file to client.", w->id);
+        WEB_CLIENT_IS_DEAD(w);
+        bytes = -1;
+    }
+
+    return bytes;
+}
+#endif
+
 ssize_t web_client_send(struct web_client *w) {
+#if defined(OS_LINUX)
+    if(unlikely(w->response.sendfile.file)) return web_client_send_static_file(w);
+#endif
+
     if(likely(w->response.zoutput)) return web_client_send_deflate(w);
 
     ssize_t bytes;
@@ -1975,6 +2308,32 @@ void web_client_reuse_from_cache(struct web_client *w) {
     w->payload = b7;
 }
 
+// the memory of the buffers that grow with the requests and the responses
+size_t web_client_buffers_size(struct web_client *w) {
+    size_t size = 0;
+
+    if(w->response.data)
+        size += w->response.data->size;
+
+    if(w->payload)
+        size += w->payload->size;
+
+    return size;
+}
+
+// give back the memory of big responses and payloads, keeping the rest
+void web_client_trim_buffers(struct web_client *w) {
+    if(w->response.data && w->response.data->size > NETDATA_WEB_RESPONSE_INITIAL_SIZE) {
+        buffer_free(w->response.data);
+        w->response.data = buffer_create(NETDATA_WEB_RESPONSE_INITIAL_SIZE, w->statistics.memory_accounting);
+    }
+
+    if(w->payload && w->payload->size > NETDATA_WEB_REQUEST_INITIAL_SIZE) {
+        buffer_free(w->payload);
+        w->payload = NULL;
+    }
+}
+
 struct web_client *web_client_create(size_t *statistics_memory_accounting) {
     struct web_client *w = (struct web_client *)callocz(1, sizeof(struct web_client));
 
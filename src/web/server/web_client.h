@@ -4,10 +4,12 @@
 #define NETDATA_WEB_CLIENT_H 1
 
 #include "libnetdata/libnetdata.h"
+#include "web_static_files.h"
 
 struct web_client;
 
 extern int web_enable_gzip, web_gzip_level, web_gzip_strategy;
+extern size_t web_response_stream_chunk_size;
 
 #define HTTP_REQ_MAX_HEADER_FETCH_TRIES 100
 
@@ -67,6 +69,10 @@ typedef enum __attribute__((packed)) {
 
     // transient settings
     WEB_CLIENT_FLAG_PROGRESS_TRACKING       = (1 << 25), // flag to avoid redoing progress work
+    WEB_CLIENT_FLAG_RESPONSE_STREAMED       = (1 << 26), // the response is being sent while it is generated
+
+    // compression
+    WEB_CLIENT_ENCODING_BROTLI              = (1 << 27), // the client accepts brotli (used for static files)
 } WEB_CLIENT_FLAGS;
 
 #define WEB_CLIENT_FLAG_PATH_WITH_VERSION (WEB_CLIENT_FLAG_PATH_IS_V0|WEB_CLIENT_FLAG_PATH_IS_V1|WEB_CLIENT_FLAG_PATH_IS_V2|WEB_CLIENT_FLAG_PATH_IS_V3)
@@ -134,6 +140,8 @@ void web_client_set_conn_webrtc(struct web_client *w);
 #define NETDATA_WEB_REQUEST_INITIAL_SIZE 8192
 #define NETDATA_WEB_REQUEST_MAX_SIZE 65536
 #define NETDATA_WEB_DECODED_URL_INITIAL_SIZE 512
+#define NETDATA_WEB_RESPONSE_MAX_PREALLOCATION (16 * 1024 * 1024)
+#define NETDATA_WEB_CLIENT_CACHE_MAX_RETAINED (8 * 1024 * 1024)
 
 #define CLOUD_CLIENT_NAME_LENGTH 64
 
@@ -155,11 +163,30 @@ struct response {
     size_t zsent;                                        // the compressed bytes we have sent to the client
     size_t zhave;                                        // the compressed bytes that we have received from zlib
     Bytef zbuffer[NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE]; // temporary buffer for storing compressed output
+
+    struct {
+        WEB_STATIC_FILE_ACQUIRED *file;                  // the cached static file sent with sendfile()
+        int fd;                                          // rlen bytes of it are sent, sent is the offset
+    } sendfile;
 };
 
 struct web_client;
 typedef bool (*web_client_interrupt_t)(struct web_client *, void *data);
 
+// the classes of requests a web server may execute in other threads
+typedef enum __attribute__((packed)) {
+    WEB_REQUEST_CLASS_LIGHT = 0,        // executed by the web server thread
+    WEB_REQUEST_CLASS_DATA,             // data queries, badges and allmetrics
+    WEB_REQUEST_CLASS_WEIGHTS,          // weights and metric correlations
+    WEB_REQUEST_CLASS_FUNCTION,         // functions and dynamic configuration
+
+    // terminator
+    WEB_REQUEST_CLASS_MAX,
+} WEB_REQUEST_CLASS;
+
+// returns true when it takes the request, to execute it with web_client_process_offloaded_request()
+typedef bool (*web_client_offload_t)(struct web_client *, WEB_REQUEST_CLASS request_class, void *data);
+
 struct web_client {
     unsigned long long id;
     size_t use_count;
@@ -194,6 +221,8 @@ struct web_client {
     char *forwarded_for;                // the X-Forwarded-For: header
     char *origin;                       // the Origin: header
     char *user_agent;                   // the User-Agent: header
+    char *if_none_match;                // the If-None-Match: header
+    char *accept;                       // the Accept: header
 
     BUFFER *payload;                    // when this request is a POST, this has the payload
 
@@ -214,6 +243,18 @@ struct web_client {
         void *callback_data;
     } interrupt;
 
+    struct {                            // A callback to execute the heavy requests in another thread
+        web_client_offload_t callback;
+        void *callback_data;
+
+        // maintained by the web server
+        bool offloaded;                 // the request is being executed by another thread
+        WEB_REQUEST_CLASS request_class;
+        usec_t queued_ut;
+        struct web_client *prev;
+        struct web_client *next;
+    } offload;
+
     struct {
         size_t received_bytes;
         size_t sent_bytes;
@@ -245,11 +286,19 @@ ssize_t web_client_receive(struct web_client *w);
 ssize_t web_client_read_file(struct web_client *w);
 
 void web_client_process_request_from_web_server(struct web_client *w);
+void web_client_process_offloaded_request(struct web_client *w);
+WEB_REQUEST_CLASS web_client_request_class(const char *decoded_url_path);
+const char *web_request_class_2str(WEB_REQUEST_CLASS request_class);
 void web_client_request_done(struct web_client *w);
 
 void web_client_build_http_header(struct web_client *w);
 
+bool web_client_can_stream_response(struct web_client *w);
+bool web_client_stream_response_callback(BUFFER *wb, void *data);
+
 void web_client_reuse_from_cache(struct web_client *w);
+size_t web_client_buffers_size(struct web_client *w);
+void web_client_trim_buffers(struct web_client *w);
 struct web_client *web_client_create(size_t *statistics_memory_accounting);
 void web_client_free(struct web_client *w);
 
@@ -16,6 +16,12 @@
 // The size of the cache is adaptive. It caches the structures of 2x
 // the number of currently connected clients.
 
+// The buffers of the cached structures keep the size they had for their
+// last request, so that the next client does not have to grow them again.
+// Up to NETDATA_WEB_CLIENT_CACHE_MAX_RETAINED bytes of them are retained,
+// and the buffers of the clients cached over it are trimmed back to their
+// initial sizes.
+
 static struct clients_cache {
     struct {
         SPINLOCK spinlock;
@@ -30,6 +36,7 @@ static struct clients_cache {
         SPINLOCK spinlock;
         struct web_client *head;    // the cached structures, available for future clients
         size_t count;               // the number of cached structures
+        size_t retained;            // the memory of the buffers of the cached structures
     } avail;
 } web_clients_cache = {
         .used = {
@@ -43,6 +50,7 @@ static struct clients_cache {
                 .spinlock = NETDATA_SPINLOCK_INITIALIZER,
                 .head = NULL,
                 .count = 0,
+                .retained = 0,
         },
 };
 
@@ -67,6 +75,7 @@ void web_client_cache_destroy(void) {
     }
     web_clients_cache.avail.head = NULL;
     web_clients_cache.avail.count = 0;
+    web_clients_cache.avail.retained = 0;
     spinlock_unlock(&web_clients_cache.avail.spinlock);
 
 // DO NOT FREE THEM IF THEY ARE USED
@@ -91,6 +100,7 @@ struct web_client *web_client_get_from_cache(void) {
         // get it from avail
         DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(web_clients_cache.avail.head, w, cache.prev, cache.next);
         web_clients_cache.avail.count--;
+        web_clients_cache.avail.retained -= web_client_buffers_size(w);
 
         spinlock_unlock(&web_clients_cache.avail.spinlock);
         web_client_reuse_from_cache(w);
@@ -134,6 +144,12 @@ void web_client_release_to_cache(struct web_client *w) {
     ssize_t used_count = (ssize_t)--web_clients_cache.used.count;
     spinlock_unlock(&web_clients_cache.used.spinlock);
 
+    size_t retained = web_client_buffers_size(w);
+    if(__atomic_load_n(&web_clients_cache.avail.retained, __ATOMIC_RELAXED) + retained > NETDATA_WEB_CLIENT_CACHE_MAX_RETAINED) {
+        web_client_trim_buffers(w);
+        retained = web_client_buffers_size(w);
+    }
+
     spinlock_lock(&web_clients_cache.avail.spinlock);
     if(w->use_count > 100 || (used_count > 0 && web_clients_cache.avail.count >= 2 * (size_t)used_count) || (used_count <= 10 && web_clients_cache.avail.count >= 20)) {
         spinlock_unlock(&web_clients_cache.avail.spinlock);
@@ -145,6 +161,7 @@ void web_client_release_to_cache(struct web_client *w) {
         // link it to the avail
         DOUBLE_LINKED_LIST_PREPEND_ITEM_UNSAFE(web_clients_cache.avail.head, w, cache.prev, cache.next);
         web_clients_cache.avail.count++;
+        web_clients_cache.avail.retained += retained;
         spinlock_unlock(&web_clients_cache.avail.spinlock);
     }
 }
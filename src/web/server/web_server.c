@@ -33,7 +33,8 @@ LISTEN_SOCKETS api_sockets = {
 		.config_section  = CONFIG_SECTION_WEB,
 		.default_bind_to = "*",
 		.default_port    = API_LISTEN_PORT,
-		.backlog         = API_LISTEN_BACKLOG
+		.backlog         = API_LISTEN_BACKLOG,
+		.reuse_port      = true
 };
 
 void debug_sockets() {
@@ -58,6 +59,8 @@ void debug_sockets() {
 }
 
 bool api_listen_sockets_setup(void) {
+	api_sockets.reuse_port = config_get_boolean(CONFIG_SECTION_WEB, "listen sockets per thread", api_sockets.reuse_port);
+
 	int socks = listen_sockets_setup(&api_sockets);
 
 	if(!socks)
@@ -0,0 +1,406 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "web_static_files.h"
+#include "daemon/common.h"
+
+#ifdef ENABLE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+bool web_static_files_cache = true;
+int web_static_files_brotli_quality = 9;
+
+// files smaller than this are not worth compressing
+#define WEB_STATIC_FILE_COMPRESS_MIN 1024
+
+// files bigger than this are not compressed in memory
+#define WEB_STATIC_FILE_COMPRESS_MAX (64 * 1024 * 1024)
+
+typedef struct web_static_file {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime_s;
+    long mtime_ns;
+
+    bool compressed;                        // compression has been attempted
+    SPINLOCK spinlock;                      // taken by the thread compressing the file
+
+    char etag[WEB_STATIC_FILE_ETAG_MAX];    // the entity tag, without the encoding and the closing quote
+
+    struct {
+        int fd;
+        size_t size;
+    } variants[WEB_STATIC_FILE_ENCODING_MAX];
+} WEB_STATIC_FILE;
+
+static struct {
+    SPINLOCK spinlock;
+    DICTIONARY *files;
+} web_static_files = {
+    .spinlock = NETDATA_SPINLOCK_INITIALIZER,
+    .files = NULL,
+};
+
+static const char *web_static_file_encodings[WEB_STATIC_FILE_ENCODING_MAX] = {
+    [WEB_STATIC_FILE_IDENTITY] = "identity",
+    [WEB_STATIC_FILE_GZIP] = "gzip",
+    [WEB_STATIC_FILE_BROTLI] = "br",
+};
+
+const char *web_static_file_encoding_2str(WEB_STATIC_FILE_ENCODING encoding) {
+    if(encoding >= WEB_STATIC_FILE_ENCODING_MAX)
+        encoding = WEB_STATIC_FILE_IDENTITY;
+
+    return web_static_file_encodings[encoding];
+}
+
+static inline void web_static_file_stat_mtime(const struct stat *statbuf, time_t *s, long *ns) {
+#ifdef __APPLE__
+    *s = statbuf->st_mtimespec.tv_sec;
+    *ns = statbuf->st_mtimespec.tv_nsec;
+#else
+    *s = statbuf->st_mtim.tv_sec;
+    *ns = statbuf->st_mtim.tv_nsec;
+#endif
+}
+
+static bool web_static_file_is_current(WEB_STATIC_FILE *wsf, const struct stat *statbuf) {
+    time_t s;
+    long ns;
+    web_static_file_stat_mtime(statbuf, &s, &ns);
+
+    return wsf->dev == statbuf->st_dev &&
+           wsf->ino == statbuf->st_ino &&
+           wsf->size == statbuf->st_size &&
+           wsf->mtime_s == s &&
+           wsf->mtime_ns == ns;
+}
+
+// ----------------------------------------------------------------------------
+// compression
+
+static bool web_static_file_pread_all(int fd, char *dst, size_t size) {
+    size_t done = 0;
+    while(done < size) {
+        ssize_t bytes = pread(fd, &dst[done], size - done, (off_t)done);
+        if(bytes <= 0) {
+            if(bytes == -1 && errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        done += (size_t)bytes;
+    }
+
+    return true;
+}
+
+// keeps data in an unlinked file of the cache directory, to be served with sendfile()
+static int web_static_file_store(const char *data, size_t size) {
+    char filename[FILENAME_MAX + 1];
+    snprintfz(filename, FILENAME_MAX, "%s/.web-static-XXXXXX", netdata_configured_cache_dir);
+
+    int fd = mkstemp(filename);
+    if(fd == -1) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "WEB STATIC FILES: cannot create a temporary file in '%s'", netdata_configured_cache_dir);
+        return -1;
+    }
+
+    // it will be deleted when it is closed
+    unlink(filename);
+    sock_setcloexec(fd);
+
+    size_t done = 0;
+    while(done < size) {
+        ssize_t bytes = write(fd, &data[done], size - done);
+        if(bytes <= 0) {
+            if(bytes == -1 && errno == EINTR)
+                continue;
+
+            nd_log(NDLS_DAEMON, NDLP_ERR, "WEB STATIC FILES: cannot write %zu bytes to a temporary file in '%s'",
+                   size, netdata_configured_cache_dir);
+            close(fd);
+            return -1;
+        }
+
+        done += (size_t)bytes;
+    }
+
+    return fd;
+}
+
+static char *web_static_file_gzip(const char *data, size_t size, size_t *compressed_size) {
+    z_stream zs = { 0 };
+
+    // gzip header: windowbits = 15 + 16
+    if(deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return NULL;
+
+    size_t max = deflateBound(&zs, (uLong)size);
+    char *compressed = mallocz(max);
+
+    zs.next_in = (Bytef *)data;
+    zs.avail_in = (uInt)size;
+    zs.next_out = (Bytef *)compressed;
+    zs.avail_out = (uInt)max;
+
+    int rc = deflate(&zs, Z_FINISH);
+    *compressed_size = (size_t)zs.total_out;
+    deflateEnd(&zs);
+
+    if(rc != Z_STREAM_END) {
+        freez(compressed);
+        return NULL;
+    }
+
+    return compressed;
+}
+
+#ifdef ENABLE_BROTLI
+static char *web_static_file_brotli(const char *data, size_t size, size_t *compressed_size) {
+    size_t max = BrotliEncoderMaxCompressedSize(size);
+    if(!max)
+        return NULL;
+
+    char *compressed = mallocz(max);
+    *compressed_size = max;
+
+    if(!BrotliEncoderCompress(web_static_files_brotli_quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC,
+                              size, (const uint8_t *)data, compressed_size, (uint8_t *)compressed)) {
+        freez(compressed);
+        return NULL;
+    }
+
+    return compressed;
+}
+#endif
+
+static void web_static_file_add_variant(WEB_STATIC_FILE *wsf, WEB_STATIC_FILE_ENCODING encoding, char *compressed, size_t compressed_size) {
+    if(!compressed)
+        return;
+
+    // keep it only when it saves at least 10%
+    if(compressed_size < (size_t)wsf->size - (size_t)wsf->size / 10) {
+        int fd = web_static_file_store(compressed, compressed_size);
+        if(fd != -1) {
+            wsf->variants[encoding].fd = fd;
+            wsf->variants[encoding].size = compressed_size;
+        }
+    }
+
+    freez(compressed);
+}
+
+static void web_static_file_compress(WEB_STATIC_FILE *wsf) {
+    size_t size = (size_t)wsf->size;
+    if(size < WEB_STATIC_FILE_COMPRESS_MIN || size > WEB_STATIC_FILE_COMPRESS_MAX)
+        return;
+
+    char *data = mallocz(size);
+    if(web_static_file_pread_all(wsf->variants[WEB_STATIC_FILE_IDENTITY].fd, data, size)) {
+        size_t compressed_size = 0;
+        char *compressed = web_static_file_gzip(data, size, &compressed_size);
+        web_static_file_add_variant(wsf, WEB_STATIC_FILE_GZIP, compressed, compressed_size);
+
+#ifdef ENABLE_BROTLI
+        compressed = web_static_file_brotli(data, size, &compressed_size);
+        web_static_file_add_variant(wsf, WEB_STATIC_FILE_BROTLI, compressed, compressed_size);
+#endif
+    }
+    freez(data);
+}
+
+// ----------------------------------------------------------------------------
+// the index of the files
+
+static void web_static_file_insert_cb(const DICTIONARY_ITEM *item, void *value, void *data __maybe_unused) {
+    WEB_STATIC_FILE *wsf = value;
+    const char *filename = dictionary_acquired_item_name(item);
+
+    spinlock_init(&wsf->spinlock);
+    for(size_t i = 0; i < WEB_STATIC_FILE_ENCODING_MAX ;i++)
+        wsf->variants[i].fd = -1;
+
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return;
+
+    // the file may have been replaced after our caller found it
+    struct stat statbuf;
+    if(fstat(fd, &statbuf) != 0 || !web_static_file_is_current(wsf, &statbuf)) {
+        close(fd);
+        return;
+    }
+
+    wsf->variants[WEB_STATIC_FILE_IDENTITY].fd = fd;
+    wsf->variants[WEB_STATIC_FILE_IDENTITY].size = (size_t)wsf->size;
+
+    snprintfz(wsf->etag, sizeof(wsf->etag) - 1, "\"%llx-%llx-%llx",
+              (unsigned long long)wsf->ino,
+              (unsigned long long)wsf->size,
+              (unsigned long long)wsf->mtime_s * NSEC_PER_SEC + (unsigned long long)wsf->mtime_ns);
+}
+
+static void web_static_file_delete_cb(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused) {
+    WEB_STATIC_FILE *wsf = value;
+
+    for(size_t i = 0; i < WEB_STATIC_FILE_ENCODING_MAX ;i++) {
+        if(wsf->variants[i].fd != -1) {
+            close(wsf->variants[i].fd);
+            wsf->variants[i].fd = -1;
+        }
+    }
+}
+
+static DICTIONARY *web_static_files_index(void) {
+    DICTIONARY *files = __atomic_load_n(&web_static_files.files, __ATOMIC_ACQUIRE);
+    if(likely(files))
+        return files;
+
+    spinlock_lock(&web_static_files.spinlock);
+    if(!web_static_files.files) {
+        files = dictionary_create_advanced(DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE,
+                                           NULL, sizeof(WEB_STATIC_FILE));
+
+        dictionary_register_insert_callback(files, web_static_file_insert_cb, NULL);
+        dictionary_register_delete_callback(files, web_static_file_delete_cb, NULL);
+        __atomic_store_n(&web_static_files.files, files, __ATOMIC_RELEASE);
+    }
+    spinlock_unlock(&web_static_files.spinlock);
+
+    return web_static_files.files;
+}
+
+// ----------------------------------------------------------------------------
+// public API
+
+WEB_STATIC_FILE_ACQUIRED *web_static_file_acquire(const char *filename, const struct stat *statbuf) {
+    if(!web_static_files_cache)
+        return NULL;
+
+    DICTIONARY *files = web_static_files_index();
+
+    const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(files, filename);
+    if(item) {
+        WEB_STATIC_FILE *wsf = dictionary_acquired_item_value(item);
+        if(likely(wsf->variants[WEB_STATIC_FILE_IDENTITY].fd != -1 && web_static_file_is_current(wsf, statbuf)))
+            return (WEB_STATIC_FILE_ACQUIRED *)item;
+
+        // it has changed on disk - the clients still sending it keep the old one
+        dictionary_acquired_item_release(files, item);
+        dictionary_del(files, filename);
+    }
+
+    WEB_STATIC_FILE tmp = {
+        .dev = statbuf->st_dev,
+        .ino = statbuf->st_ino,
+        .size = statbuf->st_size,
+    };
+    web_static_file_stat_mtime(statbuf, &tmp.mtime_s, &tmp.mtime_ns);
+
+    item = dictionary_set_and_acquire_item(files, filename, &tmp, sizeof(tmp));
+    WEB_STATIC_FILE *wsf = dictionary_acquired_item_value(item);
+    if(unlikely(wsf->variants[WEB_STATIC_FILE_IDENTITY].fd == -1 || !web_static_file_is_current(wsf, statbuf))) {
+        // we cannot open it, or another thread added a different version of it
+        dictionary_acquired_item_release(files, item);
+        return NULL;
+    }
+
+    return (WEB_STATIC_FILE_ACQUIRED *)item;
+}
+
+void web_static_file_release(WEB_STATIC_FILE_ACQUIRED *wsfa) {
+    if(!wsfa)
+        return;
+
+    dictionary_acquired_item_release(web_static_files.files, (const DICTIONARY_ITEM *)wsfa);
+}
+
+static inline WEB_STATIC_FILE *web_static_file_get(WEB_STATIC_FILE_ACQUIRED *wsfa) {
+    return dictionary_acquired_item_value((const DICTIONARY_ITEM *)wsfa);
+}
+
+WEB_STATIC_FILE_ENCODING web_static_file_encoding(WEB_STATIC_FILE_ACQUIRED *wsfa, bool gzip, bool brotli) {
+    if(!gzip && !brotli)
+        return WEB_STATIC_FILE_IDENTITY;
+
+    WEB_STATIC_FILE *wsf = web_static_file_get(wsfa);
+
+    if(!__atomic_load_n(&wsf->compressed, __ATOMIC_ACQUIRE) && spinlock_trylock(&wsf->spinlock)) {
+        if(!wsf->compressed) {
+            web_static_file_compress(wsf);
+            __atomic_store_n(&wsf->compressed, true, __ATOMIC_RELEASE);
+        }
+        spinlock_unlock(&wsf->spinlock);
+    }
+
+    // while another thread compresses it, we send it as-is
+    if(!__atomic_load_n(&wsf->compressed, __ATOMIC_ACQUIRE))
+        return WEB_STATIC_FILE_IDENTITY;
+
+    WEB_STATIC_FILE_ENCODING encoding = WEB_STATIC_FILE_IDENTITY;
+
+    if(gzip && wsf->variants[WEB_STATIC_FILE_GZIP].fd != -1)
+        encoding = WEB_STATIC_FILE_GZIP;
+
+    if(brotli && wsf->variants[WEB_STATIC_FILE_BROTLI].fd != -1 &&
+        wsf->variants[WEB_STATIC_FILE_BROTLI].size < wsf->variants[encoding].size)
+        encoding = WEB_STATIC_FILE_BROTLI;
+
+    return encoding;
+}
+
+int web_static_file_fd(WEB_STATIC_FILE_ACQUIRED *wsfa, WEB_STATIC_FILE_ENCODING encoding) {
+    return web_static_file_get(wsfa)->variants[encoding].fd;
+}
+
+size_t web_static_file_size(WEB_STATIC_FILE_ACQUIRED *wsfa, WEB_STATIC_FILE_ENCODING encoding) {
+    return web_static_file_get(wsfa)->variants[encoding].size;
+}
+
+time_t web_static_file_mtime(WEB_STATIC_FILE_ACQUIRED *wsfa) {
+    return web_static_file_get(wsfa)->mtime_s;
+}
+
+bool web_static_file_read(WEB_STATIC_FILE_ACQUIRED *wsfa, WEB_STATIC_FILE_ENCODING encoding, BUFFER *wb) {
+    WEB_STATIC_FILE *wsf = web_static_file_get(wsfa);
+    size_t size = wsf->variants[encoding].size;
+
+    buffer_need_bytes(wb, size + 1);
+    if(!web_static_file_pread_all(wsf->variants[encoding].fd, &wb->buffer[wb->len], size))
+        return false;
+
+    wb->len += size;
+    return true;
+}
+
+void web_static_file_etag(WEB_STATIC_FILE_ACQUIRED *wsfa, WEB_STATIC_FILE_ENCODING encoding, char *dst, size_t dst_size) {
+    WEB_STATIC_FILE *wsf = web_static_file_get(wsfa);
+
+    // each encoding is a different representation, so it needs a different strong entity tag
+    if(encoding == WEB_STATIC_FILE_IDENTITY)
+        snprintfz(dst, dst_size - 1, "%s\"", wsf->etag);
+    else
+        snprintfz(dst, dst_size - 1, "%s-%s\"", wsf->etag, web_static_file_encoding_2str(encoding));
+}
+
+bool web_static_file_etag_matches(WEB_STATIC_FILE_ACQUIRED *wsfa, const char *if_none_match) {
+    WEB_STATIC_FILE *wsf = web_static_file_get(wsfa);
+
+    while(isspace((uint8_t)*if_none_match))
+        if_none_match++;
+
+    if(*if_none_match == '*')
+        return true;
+
+    // any of the encodings of this version of the file matches
+    size_t len = strlen(wsf->etag);
+    for(const char *s = strstr(if_none_match, wsf->etag); s ; s = strstr(&s[len], wsf->etag)) {
+        if(s[len] == '"' || s[len] == '-')
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_WEB_STATIC_FILES_H
+#define NETDATA_WEB_STATIC_FILES_H
+
+#include "libnetdata/libnetdata.h"
+
+// ----------------------------------------------------------------------------
+// static files cache
+//
+// The files of the dashboard are kept open, and the first time a client
+// accepting compression requests them, they are compressed once (gzip and,
+// when available, brotli) into unlinked files in the cache directory. So,
+// all the clients are served with sendfile() from these files, and the
+// files are never compressed again, until they change on disk.
+//
+// Each file has a strong entity tag, made from its inode, size and
+// modification time, so that clients revalidating their copies get a 304
+// without reading anything.
+
+extern bool web_static_files_cache;
+extern int web_static_files_brotli_quality;
+
+typedef enum __attribute__((packed)) {
+    WEB_STATIC_FILE_IDENTITY = 0,
+    WEB_STATIC_FILE_GZIP,
+    WEB_STATIC_FILE_BROTLI,
+
+    // terminator
+    WEB_STATIC_FILE_ENCODING_MAX,
+} WEB_STATIC_FILE_ENCODING;
+
+typedef struct web_static_file_acquired WEB_STATIC_FILE_ACQUIRED;
+
+#define WEB_STATIC_FILE_ETAG_MAX 80
+
+// statbuf is the stat() of filename, as found by the caller
+WEB_STATIC_FILE_ACQUIRED *web_static_file_acquire(const char *filename, const struct stat *statbuf);
+void web_static_file_release(WEB_STATIC_FILE_ACQUIRED *wsfa);
+
+// the smallest encoding of the file the client accepts
+WEB_STATIC_FILE_ENCODING web_static_file_encoding(WEB_STATIC_FILE_ACQUIRED *wsfa, bool gzip, bool brotli);
+const char *web_static_file_encoding_2str(WEB_STATIC_FILE_ENCODING encoding);
+
+int web_static_file_fd(WEB_STATIC_FILE_ACQUIRED *wsfa, WEB_STATIC_FILE_ENCODING encoding);
+size_t web_static_file_size(WEB_STATIC_FILE_ACQUIRED *wsfa, WEB_STATIC_FILE_ENCODING encoding);
+time_t web_static_file_mtime(WEB_STATIC_FILE_ACQUIRED *wsfa);
+bool web_static_file_read(WEB_STATIC_FILE_ACQUIRED *wsfa, WEB_STATIC_FILE_ENCODING encoding, BUFFER *wb);
+
+void web_static_file_etag(WEB_STATIC_FILE_ACQUIRED *wsfa, WEB_STATIC_FILE_ENCODING encoding, char *dst, size_t dst_size);
+bool web_static_file_etag_matches(WEB_STATIC_FILE_ACQUIRED *wsfa, const char *if_none_match);
+
+#endif //NETDATA_WEB_STATIC_FILES_H
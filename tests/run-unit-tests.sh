@@ -25,6 +25,15 @@ c_unit_tests() {
   "$HOME"/netdata/usr/sbin/netdata -W unittest
 }
 
+statsd_benchmark() {
+  echo "Running the statsd benchmark"
+
+  ASAN_OPTIONS=detect_leaks=0 \
+  "$HOME"/netdata/usr/sbin/netdata -W statsdtest=5
+}
+
 install_netdata || exit 1
 
 c_unit_tests || exit 1
+
+statsd_benchmark || exit 1